@@ -0,0 +1,386 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Searches the batch sizes, timeouts, workers and threads of a model
+ * for the setting with the most throughput within a latency SLO and writes it
+ * as a model configuration
+ */
+
+#include <algorithm>    // for max
+#include <chrono>       // for duration
+#include <cstddef>      // for byte, size_t
+#include <cstdint>      // for int32_t, int64_t, uint16_t
+#include <cxxopts.hpp>  // for Options, value, ParseResult
+#include <exception>    // for exception
+#include <filesystem>   // for path, exists
+#include <fstream>      // for ifstream, ofstream
+#include <iomanip>      // for setw
+#include <iostream>     // for cout, cerr
+#include <memory>       // for unique_ptr, make_unique
+#include <optional>     // for optional
+#include <sstream>      // for stringstream
+#include <stdexcept>    // for invalid_argument
+#include <string>       // for string, stoi, getline
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "amdinfer/amdinfer.hpp"
+#include "load_generator.hpp"
+#include "tuner.hpp"
+
+namespace {
+
+const uint16_t kHttpPort = 8998;
+const uint16_t kGrpcPort = 50'051;
+
+std::vector<int32_t> parseList(const std::string& list,
+                               const std::string& name) {
+  std::vector<int32_t> parsed;
+  std::stringstream stream{list};
+  std::string value;
+  while (std::getline(stream, value, ',')) {
+    parsed.push_back(std::stoi(value));
+    if (parsed.back() < 0) {
+      throw std::invalid_argument(name + " must not be negative");
+    }
+  }
+  return parsed;
+}
+
+/**
+ * @brief Make a request for the endpoint from its metadata with zeroed inputs.
+ * Dimensions that the metadata leaves open are set to 1.
+ *
+ * @param client client to get the metadata with
+ * @param endpoint the endpoint
+ * @param data buffers to hold the inputs' data
+ * @return amdinfer::InferenceRequest
+ */
+amdinfer::InferenceRequest makeRequest(
+  const amdinfer::Client* client, const std::string& endpoint,
+  std::vector<std::vector<std::byte>>* data) {
+  const auto metadata = client->modelMetadata(endpoint);
+  amdinfer::InferenceRequest request;
+  for (const auto& input : metadata.getInputs()) {
+    auto shape = input.getShape();
+    size_t size = 1;
+    for (auto& dim : shape) {
+      dim = std::max(dim, int64_t{1});
+      size *= dim;
+    }
+    auto& buffer =
+      data->emplace_back(size * input.getDatatype().size(), std::byte{0});
+    request.addInputTensor(amdinfer::InferenceRequestInput{
+      buffer.data(), shape, input.getDatatype(), input.getName()});
+  }
+  return request;
+}
+
+void printTrial(const amdinfer::Trial& trial, double percentile) {
+  const auto width = 10;
+  const auto print = [](int32_t value) {
+    return value < 0 ? std::string{"-"} : std::to_string(value);
+  };
+  const auto& [batch_size, timeout, instances, threads] = trial.candidate;
+  std::cout << std::setw(width) << print(batch_size) << std::setw(width)
+            << print(timeout) << std::setw(width) << print(instances)
+            << std::setw(width) << print(threads);
+  if (trial.pruned) {
+    std::cout << std::setw(width) << "-" << std::setw(width) << "-"
+              << std::setw(width) << "-"
+              << "  pruned\n";
+    return;
+  }
+  const auto& report = trial.report;
+  const auto latency = percentile <= 50   ? report.p50
+                       : percentile <= 90 ? report.p90
+                       : percentile <= 99 ? report.p99
+                                          : report.p999;
+  std::cout << std::setw(width) << trial.rate << std::setw(width)
+            << report.throughput << std::setw(width) << latency
+            << (trial.rate > 0 ? "" : "  missed the SLO") << "\n";
+}
+
+std::string toJson(const amdinfer::Trial& trial) {
+  const auto& candidate = trial.candidate;
+  std::stringstream json;
+  json << R"({"batch_size":)" << candidate.batch_size << R"(,"timeout_ms":)"
+       << candidate.timeout << R"(,"instances":)" << candidate.instances
+       << R"(,"threads":)" << candidate.threads << R"(,"pruned":)"
+       << (trial.pruned ? "true" : "false") << R"(,"rate":)" << trial.rate
+       << R"(,"report":)" << amdinfer::toJson(trial.report) << "}";
+  return json.str();
+}
+
+/// Get the label of a percentile, such as p99.9
+std::string label(double percentile) {
+  std::stringstream stream;
+  stream << "p" << percentile;
+  return stream.str();
+}
+
+std::string readFile(const std::filesystem::path& path) {
+  std::ifstream file{path};
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string protocol{"native"};
+  std::string address{"127.0.0.1:" + std::to_string(kHttpPort)};
+  bool remote_server = false;
+  std::string repository;
+  std::string model;
+  std::string worker;
+  std::string batch_sizes_str{"1,2,4,8,16"};
+  std::string timeouts_str{"1,2,5,10"};
+  std::string instances_str{"1,2,4"};
+  std::string threads_str;
+  std::string threads_parameter{"threads"};
+  double slo_ms = 100;
+  double percentile = 99;
+  double start_rate = 100;
+  double max_rate = 100'000;
+  int steps = 4;
+  std::string arrival{"poisson"};
+  double duration = 5;
+  double warmup = 1;
+  double drain = 5;
+  uint64_t seed = 0;
+  std::string config;
+  std::string output{"config.toml"};
+  std::string report_path;
+
+  cxxopts::Options options(
+    "autotuner",
+    "Search the batching settings of a model on the AMD Inference Server for "
+    "the most throughput within a latency SLO");
+  // clang-format off
+  options.add_options()
+  ("protocol", "Must be one of 'native', 'http' or 'grpc'",
+    cxxopts::value(protocol))
+  ("address", "Address of the server as host:port if using HTTP or gRPC",
+    cxxopts::value(address))
+  ("remote-server", "Set to use a remote server instead of starting one",
+    cxxopts::value(remote_server))
+  ("repository", "Model repository of the server that's started",
+    cxxopts::value(repository))
+  ("model", "Model in the server's repository to tune",
+    cxxopts::value(model))
+  ("worker", "Worker to tune if no model is given", cxxopts::value(worker))
+  ("batch-sizes", "Comma-separated batch sizes to try",
+    cxxopts::value(batch_sizes_str))
+  ("timeouts", "Comma-separated batching timeouts in ms to try",
+    cxxopts::value(timeouts_str))
+  ("instances", "Comma-separated numbers of workers to try",
+    cxxopts::value(instances_str))
+  ("threads", "Comma-separated threads per worker to try. Not tuned if empty",
+    cxxopts::value(threads_str))
+  ("threads-parameter", "Load-time parameter that sets the threads",
+    cxxopts::value(threads_parameter))
+  ("slo", "Latency in ms that the percentile must meet",
+    cxxopts::value(slo_ms))
+  ("percentile", "Must be one of 50, 90, 99 or 99.9",
+    cxxopts::value(percentile))
+  ("start-rate", "Requests per second to start each search at",
+    cxxopts::value(start_rate))
+  ("max-rate", "Most requests per second to try", cxxopts::value(max_rate))
+  ("steps", "Times to halve the rates after the SLO is missed",
+    cxxopts::value(steps))
+  ("arrival", "Must be one of 'poisson' or 'constant'",
+    cxxopts::value(arrival))
+  ("duration", "Seconds to measure each rate for. Defaults to 5",
+    cxxopts::value(duration))
+  ("warmup", "Seconds to send requests before measuring. Defaults to 1",
+    cxxopts::value(warmup))
+  ("drain", "Seconds to wait for responses after sending. Defaults to 5",
+    cxxopts::value(drain))
+  ("seed", "Seed for the arrival times", cxxopts::value(seed))
+  ("config",
+    "Configuration to write the result into. Defaults to the model's",
+    cxxopts::value(config))
+  ("output", "Path to write the tuned configuration to",
+    cxxopts::value(output))
+  ("report", "Path to write the JSON report of every trial to",
+    cxxopts::value(report_path))
+  ("help", "Print help");
+  // clang-format on
+
+  amdinfer::SearchSpace space;
+  try {
+    auto result = options.parse(argc, argv);
+    if (result.count("help") != 0U) {
+      std::cout << options.help({""}) << "\n";
+      return 0;
+    }
+    space.batch_sizes = parseList(batch_sizes_str, "Batch sizes");
+    space.timeouts = parseList(timeouts_str, "Timeouts");
+    space.instances = parseList(instances_str, "Instances");
+    space.threads = parseList(threads_str, "Threads");
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing options: " << e.what() << "\n";
+    return 1;
+  }
+  if (model.empty() == worker.empty()) {
+    std::cerr << "Exactly one of a model or a worker must be given\n";
+    return 1;
+  }
+  if (arrival != "poisson" && arrival != "constant") {
+    std::cerr << "Arrival must be one of 'poisson' or 'constant'\n";
+    return 1;
+  }
+  if (start_rate <= 0 || max_rate < start_rate) {
+    std::cerr << "The start rate must be positive and at most the max rate\n";
+    return 1;
+  }
+  if (percentile != 50 && percentile != 90 && percentile != 99 &&
+      percentile != 99.9) {
+    std::cerr << "The percentile must be one of 50, 90, 99 or 99.9\n";
+    return 1;
+  }
+  if (config.empty() && !repository.empty() && !model.empty()) {
+    const auto path = std::filesystem::path{repository} / model / "config.toml";
+    if (std::filesystem::exists(path)) {
+      config = path.string();
+    }
+  }
+
+  std::optional<amdinfer::Server> server;
+  if (!remote_server) {
+    server.emplace();
+    if (!repository.empty()) {
+      server.value().setModelRepository(repository, false);
+    }
+  }
+
+  std::unique_ptr<amdinfer::Client> client;
+  if (protocol == "native") {
+    if (remote_server) {
+      std::cerr << "Server must be started locally if using native client\n";
+      return 1;
+    }
+    client = std::make_unique<amdinfer::NativeClient>(&(server.value()));
+#ifdef AMDINFER_ENABLE_HTTP
+  } else if (protocol == "http") {
+    if (!remote_server) {
+      server.value().startHttp(kHttpPort);
+    }
+    client = std::make_unique<amdinfer::HttpClient>("http://" + address);
+#endif
+#ifdef AMDINFER_ENABLE_GRPC
+  } else if (protocol == "grpc") {
+    if (!remote_server) {
+      server.value().startGrpc(kGrpcPort);
+    }
+    client = std::make_unique<amdinfer::GrpcClient>(address);
+#endif
+  } else {
+    std::cerr << "Protocol " << protocol << " is not supported\n";
+    return 1;
+  }
+  amdinfer::waitUntilServerReady(client.get());
+
+  amdinfer::TunerOptions tuner_options;
+  tuner_options.start_rate = start_rate;
+  tuner_options.max_rate = max_rate;
+  tuner_options.steps = steps;
+  tuner_options.slo = std::chrono::duration<double, std::milli>(slo_ms);
+  tuner_options.percentile = percentile;
+  auto& load_options = tuner_options.load;
+  load_options.arrival = arrival == "poisson" ? amdinfer::Arrival::Poisson
+                                              : amdinfer::Arrival::Constant;
+  load_options.duration = std::chrono::duration<double>(duration);
+  load_options.warmup = std::chrono::duration<double>(warmup);
+  load_options.drain = std::chrono::duration<double>(drain);
+  load_options.slo = tuner_options.slo;
+  load_options.seed = seed;
+
+  const auto width = 10;
+  std::cout << std::setw(width) << "batch" << std::setw(width) << "timeout"
+            << std::setw(width) << "workers" << std::setw(width) << "threads"
+            << std::setw(width) << "rate" << std::setw(width) << "thruput"
+            << std::setw(width) << label(percentile)
+            << "\n";
+
+  std::vector<amdinfer::Trial> trials;
+  std::optional<amdinfer::Trial> best;
+  for (const auto& candidate : amdinfer::makeCandidates(space)) {
+    const auto parameters =
+      amdinfer::toParameters(candidate, threads_parameter);
+    std::string endpoint;
+    try {
+      if (model.empty()) {
+        endpoint = client->workerLoad(worker, parameters);
+      } else {
+        client->modelLoad(model, parameters);
+        endpoint = model;
+      }
+      amdinfer::waitUntilModelReady(client.get(), endpoint);
+    } catch (const std::exception& e) {
+      std::cerr << "Skipping a setting that failed to load: " << e.what()
+                << "\n";
+      continue;
+    }
+
+    std::vector<std::vector<std::byte>> data;
+    const auto request = makeRequest(client.get(), endpoint, &data);
+    const amdinfer::Measure measure = [&](double rate) {
+      amdinfer::FuturePoller poller;
+      load_options.rate = rate;
+      return amdinfer::runLoad(
+        load_options, [&](amdinfer::DoneCallback done) {
+          poller.add(client->modelInferAsync(endpoint, request),
+                     std::move(done));
+        });
+    };
+    const auto floor = best.has_value() ? best.value().rate : 0;
+    trials.push_back(
+      amdinfer::searchRate(candidate, tuner_options, floor, measure));
+    printTrial(trials.back(), percentile);
+
+    client->workerUnload(endpoint);
+    amdinfer::waitUntilModelNotReady(client.get(), endpoint);
+    if (trials.back().rate > floor) {
+      best = trials.back();
+    }
+  }
+
+  if (!report_path.empty()) {
+    std::ofstream file{report_path};
+    file << R"({"slo_ms":)" << slo_ms << R"(,"percentile":)" << percentile
+         << R"(,"duration_s":)" << duration << R"(,"trials":[)";
+    for (auto i = 0U; i < trials.size(); ++i) {
+      file << (i == 0 ? "" : ",") << toJson(trials[i]);
+    }
+    file << "]}\n";
+  }
+
+  if (!best.has_value()) {
+    std::cerr << "No setting met the SLO\n";
+    return 1;
+  }
+  std::ofstream file{output};
+  file << "# tuned for " << best.value().rate << " requests/s with a "
+       << label(percentile) << " latency of at most " << slo_ms
+       << " ms\n"
+       << amdinfer::writeConfig(config.empty() ? "" : readFile(config),
+                                best.value().candidate, threads_parameter);
+  std::cout << "Wrote the best setting to " << output << "\n";
+  return 0;
+}
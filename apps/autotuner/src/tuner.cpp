@@ -0,0 +1,229 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the search for the batching settings of a model that give
+ * the most throughput within a latency SLO
+ */
+
+#include "tuner.hpp"
+
+#include <algorithm>    // for find_if, min
+#include <limits>       // for numeric_limits
+#include <ostream>      // for ostream
+#include <set>          // for set
+#include <sstream>      // for istringstream, ostringstream
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+
+namespace amdinfer {
+
+namespace {
+
+/// Runs whose throughput is less than this fraction of the offered rate fell
+/// behind and their latency would keep growing with a longer run
+constexpr auto kKeepUp = 0.9;
+
+/// Use a single unset value for the lists that aren't tuned
+std::vector<int32_t> orUnset(const std::vector<int32_t>& values) {
+  if (values.empty()) {
+    return {-1};
+  }
+  return values;
+}
+
+double getPercentile(const LoadReport& report, double percentile) {
+  if (percentile <= 50) {
+    return report.p50;
+  }
+  if (percentile <= 90) {
+    return report.p90;
+  }
+  if (percentile <= 99) {
+    return report.p99;
+  }
+  return report.p999;
+}
+
+std::string_view trim(std::string_view line) {
+  const auto* const whitespace = " \t\r";
+  const auto start = line.find_first_not_of(whitespace);
+  if (start == std::string_view::npos) {
+    return {};
+  }
+  const auto end = line.find_last_not_of(whitespace);
+  return line.substr(start, end - start + 1);
+}
+
+using Table = std::pair<std::string, std::vector<std::pair<std::string, int>>>;
+
+}  // namespace
+
+std::vector<Candidate> makeCandidates(const SearchSpace& space) {
+  std::vector<Candidate> candidates;
+  for (const auto instances : orUnset(space.instances)) {
+    for (const auto threads : orUnset(space.threads)) {
+      for (const auto batch_size : orUnset(space.batch_sizes)) {
+        const auto timeouts =
+          batch_size == 1 ? std::vector<int32_t>{-1} : orUnset(space.timeouts);
+        for (const auto timeout : timeouts) {
+          candidates.push_back({batch_size, timeout, instances, threads});
+        }
+      }
+    }
+  }
+  return candidates;
+}
+
+ParameterMap toParameters(const Candidate& candidate,
+                          const std::string& threads_parameter) {
+  ParameterMap parameters;
+  if (candidate.batch_size >= 0) {
+    parameters.put("batch_size", candidate.batch_size);
+  }
+  if (candidate.timeout >= 0) {
+    parameters.put("timeout", candidate.timeout);
+  }
+  if (candidate.instances >= 0) {
+    // the workers are fixed so they don't scale during the measurements
+    parameters.put("min_workers", candidate.instances);
+    parameters.put("max_workers", candidate.instances);
+  }
+  if (candidate.threads >= 0) {
+    parameters.put(threads_parameter, candidate.threads);
+  }
+  return parameters;
+}
+
+bool meetsSlo(const LoadReport& report, const TunerOptions& options) {
+  const auto slo =
+    std::chrono::duration<double, std::milli>(options.slo).count();
+  return report.failed == 0 && report.unanswered == 0 &&
+         getPercentile(report, options.percentile) <= slo &&
+         report.throughput >= kKeepUp * report.offered_rate;
+}
+
+Trial searchRate(const Candidate& candidate, const TunerOptions& options,
+                 double floor, const Measure& measure) {
+  Trial trial;
+  trial.candidate = candidate;
+  auto passed = 0.0;
+  auto failed = std::numeric_limits<double>::infinity();
+
+  const auto run = [&](double rate) {
+    auto report = measure(rate);
+    if (!meetsSlo(report, options)) {
+      failed = rate;
+      return false;
+    }
+    passed = rate;
+    trial.rate = rate;
+    trial.report = report;
+    return true;
+  };
+
+  auto rate = std::min(floor > 0 ? floor : options.start_rate, options.max_rate);
+  if (!run(rate) && floor > 0) {
+    trial.pruned = true;
+    return trial;
+  }
+  while (passed == rate && rate < options.max_rate) {
+    rate = std::min(rate * 2, options.max_rate);
+    run(rate);
+  }
+  if (passed >= options.max_rate) {
+    return trial;
+  }
+  for (auto i = 0; i < options.steps; ++i) {
+    run((passed + failed) / 2);
+  }
+  return trial;
+}
+
+std::string writeConfig(const std::string& base, const Candidate& candidate,
+                        const std::string& threads_parameter) {
+  std::vector<Table> tables{{"instance_group", {}},
+                            {"dynamic_batching", {}},
+                            {"parameters", {}}};
+  if (candidate.instances >= 0) {
+    tables[0].second.emplace_back("count", candidate.instances);
+    tables[0].second.emplace_back("max_count", candidate.instances);
+  }
+  if (candidate.batch_size >= 0) {
+    tables[1].second.emplace_back("max_batch_size", candidate.batch_size);
+  }
+  if (candidate.timeout >= 0) {
+    tables[1].second.emplace_back("max_queue_delay_ms", candidate.timeout);
+  }
+  if (candidate.threads >= 0) {
+    tables[2].second.emplace_back(threads_parameter, candidate.threads);
+  }
+
+  const auto find = [&tables](std::string_view name) {
+    return std::find_if(tables.begin(), tables.end(),
+                        [name](const auto& table) {
+                          return table.first == name &&
+                                 !table.second.empty();
+                        });
+  };
+  const auto write = [](std::ostream& stream, const Table& table) {
+    for (const auto& [key, value] : table.second) {
+      stream << key << " = " << value << "\n";
+    }
+  };
+
+  std::istringstream input{base};
+  std::ostringstream output;
+  std::set<std::string> written;
+  auto current = tables.end();
+  std::string line;
+  while (std::getline(input, line)) {
+    const auto trimmed = trim(line);
+    if (!trimmed.empty() && trimmed.front() == '[') {
+      // arrays of tables, such as the inputs, are never tuned
+      const auto end = trimmed.find(']');
+      current = trimmed.substr(0, 2) == "[[" || end == std::string_view::npos
+                  ? tables.end()
+                  : find(trim(trimmed.substr(1, end - 1)));
+      output << line << "\n";
+      if (current != tables.end() && written.insert(current->first).second) {
+        write(output, *current);
+      }
+      continue;
+    }
+    if (current != tables.end()) {
+      // drop the keys that the tuned settings replace
+      const auto key = trim(trimmed.substr(0, trimmed.find('=')));
+      const auto& entries = current->second;
+      if (std::find_if(entries.begin(), entries.end(), [key](const auto& e) {
+            return e.first == key;
+          }) != entries.end()) {
+        continue;
+      }
+    }
+    output << line << "\n";
+  }
+
+  for (const auto& table : tables) {
+    if (!table.second.empty() && written.count(table.first) == 0) {
+      output << (output.tellp() > 0 ? "\n" : "") << "[" << table.first
+             << "]\n";
+      write(output, table);
+    }
+  }
+  return output.str();
+}
+
+}  // namespace amdinfer
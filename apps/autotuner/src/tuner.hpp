@@ -0,0 +1,150 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the search for the batching settings of a model that give the
+ * most throughput within a latency SLO
+ */
+
+#ifndef GUARD_AUTOTUNER_SRC_TUNER
+#define GUARD_AUTOTUNER_SRC_TUNER
+
+#include <chrono>      // for duration, milliseconds
+#include <cstdint>     // for int32_t
+#include <functional>  // for function
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/amdinfer.hpp"
+#include "load_generator.hpp"
+
+namespace amdinfer {
+
+/// One setting of the parameters that are tuned. Negative ones aren't set
+struct Candidate {
+  /// the largest batch to form, passed as "batch_size"
+  int32_t batch_size = -1;
+  /// milliseconds to wait for a batch to fill, passed as "timeout"
+  int32_t timeout = -1;
+  /// workers to start, passed as "min_workers" and "max_workers"
+  int32_t instances = -1;
+  /// threads for each worker, passed as the threads parameter
+  int32_t threads = -1;
+};
+
+/// The values to try for each tuned parameter. Empty lists aren't tuned
+struct SearchSpace {
+  std::vector<int32_t> batch_sizes;
+  std::vector<int32_t> timeouts;
+  std::vector<int32_t> instances;
+  std::vector<int32_t> threads;
+};
+
+/**
+ * @brief Make every combination of the values in the search space. Timeouts
+ * aren't combined with a batch size of one since batches of one never wait
+ *
+ * @param space the values to try
+ * @return std::vector<Candidate>
+ */
+std::vector<Candidate> makeCandidates(const SearchSpace& space);
+
+/**
+ * @brief Get the load-time parameters to load a model with for a candidate
+ *
+ * @param candidate the setting
+ * @param threads_parameter the name of the parameter that sets the threads of
+ * the model's worker, such as "threads" or "intra_op_threads"
+ * @return ParameterMap
+ */
+ParameterMap toParameters(const Candidate& candidate,
+                          const std::string& threads_parameter);
+
+/// Options for measuring the throughput of one candidate
+struct TunerOptions {
+  /// the rate to start the search at, in requests per second
+  double start_rate = 100;
+  /// the highest rate to try
+  double max_rate = 100'000;
+  /// how many times to halve the range of rates after the SLO is missed
+  int steps = 4;
+  /// the latency that the percentile must meet
+  std::chrono::duration<double> slo = std::chrono::milliseconds(100);
+  /// the percentile of the latency that must meet the SLO: 50, 90, 99 or 99.9
+  double percentile = 99;
+  /// the options for each run. Its rate is set by the search
+  LoadOptions load;
+};
+
+/**
+ * @brief Check whether a run met the SLO. Runs fail it if any request failed
+ * or wasn't answered, if the percentile of the latency was over the SLO or if
+ * the server couldn't keep up with the offered rate
+ *
+ * @param report the run
+ * @param options the SLO to check
+ * @return bool
+ */
+bool meetsSlo(const LoadReport& report, const TunerOptions& options);
+
+/// Runs the load at a rate against the candidate that's loaded
+using Measure = std::function<LoadReport(double rate)>;
+
+/// The result of searching the rates of one candidate
+struct Trial {
+  Candidate candidate;
+  /// the highest rate that met the SLO or zero if none did
+  double rate = 0;
+  /// the run at that rate
+  LoadReport report;
+  /// whether the search stopped early because the candidate couldn't beat
+  /// the best one before it
+  bool pruned = false;
+};
+
+/**
+ * @brief Find the highest rate that a candidate serves within the SLO. The
+ * rate is doubled from the start until the SLO is missed and the range between
+ * the last rate that met it and the first that didn't is then halved for the
+ * number of steps in the options. If a floor is given, such as the rate of the
+ * best candidate so far, the search starts there and stops at once if the
+ * candidate misses the SLO at it
+ *
+ * @param candidate the candidate, which must be loaded
+ * @param options options for the search
+ * @param floor the rate that the candidate must beat or zero
+ * @param measure function to run the load at a rate
+ * @return Trial
+ */
+Trial searchRate(const Candidate& candidate, const TunerOptions& options,
+                 double floor, const Measure& measure);
+
+/**
+ * @brief Write the tuned settings into a model configuration in TOML. The
+ * settings that were tuned replace the same keys in the instance_group,
+ * dynamic_batching and parameters tables of the base configuration and the
+ * rest of it is kept as is. Tables that it doesn't have are appended
+ *
+ * @param base the base configuration or empty
+ * @param candidate the tuned settings
+ * @param threads_parameter the name of the parameter that sets the threads
+ * @return std::string
+ */
+std::string writeConfig(const std::string& base, const Candidate& candidate,
+                        const std::string& threads_parameter);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AUTOTUNER_SRC_TUNER
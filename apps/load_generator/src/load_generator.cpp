@@ -0,0 +1,328 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements an open-loop load generator
+ */
+
+#include "load_generator.hpp"
+
+#include <algorithm>  // for max, sort
+#include <array>      // for array
+#include <cassert>    // for assert
+#include <cmath>      // for ceil
+#include <cstdio>     // for snprintf
+#include <deque>      // for deque
+#include <future>     // for future_status
+#include <iterator>   // for back_inserter
+#include <memory>     // for make_shared, shared_ptr
+#include <random>     // for exponential_distribution, mt19937_64
+#include <utility>    // for move
+
+namespace amdinfer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+/// A request that was sent
+struct Record {
+  Record(Clock::time_point scheduled, bool measured, size_t group)
+    : scheduled(scheduled), measured(measured), group(group) {}
+
+  Clock::time_point scheduled;
+  bool measured;
+  /// which report the request counts towards
+  size_t group;
+  // set by the callback, which may run on another thread, before answered
+  bool succeeded = false;
+  Clock::time_point completed;
+  std::atomic<bool> answered = false;
+};
+
+/// The requests of one run. It's shared with the callbacks so responses that
+/// arrive after the run ends have somewhere to go
+struct Records {
+  // a deque doesn't move its elements as it grows
+  std::deque<Record> records;
+  std::atomic<size_t> answered = 0;
+};
+
+/**
+ * @brief Get a percentile of sorted values with the nearest-rank method
+ *
+ * @param sorted the values in increasing order
+ * @param percentile the percentile, from 0 to 1
+ * @return double
+ */
+double getPercentile(const std::vector<double>& sorted, double percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const auto rank = static_cast<size_t>(
+    std::ceil(percentile * static_cast<double>(sorted.size())));
+  return sorted.at(std::max(rank, size_t{1}) - 1);
+}
+
+/**
+ * @brief Send a request at its scheduled time and record it
+ *
+ * @param records the requests of the run
+ * @param scheduled when to send the request
+ * @param measured whether the request is measured
+ * @param group which report the request counts towards
+ * @param send function that sends the request
+ * @return Clock::duration how late the request was sent
+ */
+Clock::duration sendAt(const std::shared_ptr<Records>& records,
+                       Clock::time_point scheduled, bool measured,
+                       size_t group, const Sender& send) {
+  std::this_thread::sleep_until(scheduled);
+  const auto lag = Clock::now() - scheduled;
+
+  auto& record = records->records.emplace_back(scheduled, measured, group);
+  auto done = [records, &record](bool succeeded) {
+    record.succeeded = succeeded;
+    record.completed = Clock::now();
+    record.answered.store(true, std::memory_order_release);
+    records->answered++;
+  };
+  try {
+    send(done);
+  } catch (const std::exception&) {
+    done(false);
+  }
+  return lag;
+}
+
+/// Wait for the responses to the requests that were sent until the drain
+/// ends and return when the wait ended
+Clock::time_point drainRecords(const Records& records,
+                               std::chrono::duration<double> drain) {
+  const auto sent = records.records.size();
+  const auto drain_end =
+    Clock::now() + std::chrono::duration_cast<Clock::duration>(drain);
+  while (records.answered.load() < sent && Clock::now() < drain_end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return Clock::now();
+}
+
+/**
+ * @brief Summarize the measured requests of a group
+ *
+ * @param records the requests of the run
+ * @param group the group to summarize
+ * @param drained when the wait for responses ended
+ * @param slo latency that requests must meet to count towards the goodput
+ * @param seconds how long the measured requests were sent for
+ * @return LoadReport
+ */
+LoadReport summarize(const Records& records, size_t group,
+                     Clock::time_point drained,
+                     std::chrono::duration<double> slo, double seconds) {
+  LoadReport report;
+  std::vector<double> latencies;
+  size_t good = 0;
+  for (const auto& record : records.records) {
+    if (!record.measured || record.group != group) {
+      continue;
+    }
+    report.sent++;
+    // unanswered requests are at least this late
+    auto completed = drained;
+    const auto answered = record.answered.load(std::memory_order_acquire);
+    if (answered) {
+      completed = record.completed;
+      record.succeeded ? report.succeeded++ : report.failed++;
+    } else {
+      report.unanswered++;
+    }
+    const auto latency = completed - record.scheduled;
+    latencies.push_back(Milliseconds(latency).count());
+    if (answered && record.succeeded && latency <= slo) {
+      good++;
+    }
+  }
+
+  report.throughput = static_cast<double>(report.succeeded) / seconds;
+  report.goodput = static_cast<double>(good) / seconds;
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (const auto& latency : latencies) {
+      sum += latency;
+    }
+    report.mean = sum / static_cast<double>(latencies.size());
+    report.p50 = getPercentile(latencies, 0.5);
+    report.p90 = getPercentile(latencies, 0.9);
+    report.p99 = getPercentile(latencies, 0.99);
+    report.p999 = getPercentile(latencies, 0.999);
+    report.max = latencies.back();
+  }
+  return report;
+}
+
+}  // namespace
+
+LoadReport runLoad(const LoadOptions& options, const Sender& send) {
+  std::mt19937_64 generator{options.seed};
+  std::exponential_distribution<double> poisson{options.rate};
+  auto getGap = [&]() {
+    const auto seconds = options.arrival == Arrival::Poisson
+                           ? poisson(generator)
+                           : 1 / options.rate;
+    return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(seconds));
+  };
+
+  auto records = std::make_shared<Records>();
+  const auto start = Clock::now();
+  const auto measure_start =
+    start + std::chrono::duration_cast<Clock::duration>(options.warmup);
+  const auto end =
+    measure_start + std::chrono::duration_cast<Clock::duration>(
+                      options.duration);
+
+  Clock::duration max_lag{0};
+  for (auto scheduled = start + getGap(); scheduled < end;
+       scheduled += getGap()) {
+    max_lag = std::max(max_lag, sendAt(records, scheduled,
+                                       scheduled >= measure_start, 0, send));
+  }
+  const auto drained = drainRecords(*records, options.drain);
+
+  auto report = summarize(*records, 0, drained, options.slo,
+                          options.duration.count());
+  report.offered_rate = options.rate;
+  report.max_lag = Milliseconds(max_lag).count();
+  return report;
+}
+
+std::map<std::string, LoadReport> runReplay(
+  const std::vector<std::chrono::nanoseconds>& times,
+  const std::vector<std::string>& groups, const ReplayOptions& options,
+  const ReplaySender& send) {
+  assert(times.size() == groups.size());
+  std::map<std::string, size_t> indices;
+  std::vector<size_t> group_indices;
+  group_indices.reserve(groups.size());
+  for (const auto& group : groups) {
+    group_indices.push_back(
+      indices.try_emplace(group, indices.size()).first->second);
+  }
+
+  auto records = std::make_shared<Records>();
+  const auto start = Clock::now();
+  Clock::duration max_lag{0};
+  for (auto i = 0U; i < times.size(); ++i) {
+    // the replay starts with the first request instead of the capture
+    const auto offset = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double, std::nano>(
+        static_cast<double>((times[i] - times.front()).count()) /
+        options.speed));
+    max_lag = std::max(
+      max_lag, sendAt(records, start + offset, true, group_indices[i],
+                      [&send, i](DoneCallback done) { send(i, done); }));
+  }
+  const auto sent = Clock::now();
+  const auto drained = drainRecords(*records, options.drain);
+
+  // the requests are counted over the span they were sent in
+  const auto seconds =
+    std::max(std::chrono::duration<double>(sent - start).count(), 1e-9);
+  std::map<std::string, LoadReport> reports;
+  for (const auto& [group, index] : indices) {
+    auto report = summarize(*records, index, drained, options.slo, seconds);
+    report.offered_rate = static_cast<double>(report.sent) / seconds;
+    report.max_lag = Milliseconds(max_lag).count();
+    reports.emplace(group, report);
+  }
+  return reports;
+}
+
+std::string toJson(const LoadReport& report) {
+  auto number = [](double value) {
+    constexpr auto kMaxSize = 32;
+    std::array<char, kMaxSize> buffer{};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    std::snprintf(buffer.data(), buffer.size(), "%.6g", value);
+    return std::string{buffer.data()};
+  };
+
+  return R"({"offered_rate":)" + number(report.offered_rate) +
+         R"(,"sent":)" + std::to_string(report.sent) + R"(,"succeeded":)" +
+         std::to_string(report.succeeded) + R"(,"failed":)" +
+         std::to_string(report.failed) + R"(,"unanswered":)" +
+         std::to_string(report.unanswered) + R"(,"throughput":)" +
+         number(report.throughput) + R"(,"goodput":)" +
+         number(report.goodput) + R"(,"latency_ms":{"mean":)" +
+         number(report.mean) + R"(,"p50":)" + number(report.p50) +
+         R"(,"p90":)" + number(report.p90) + R"(,"p99":)" +
+         number(report.p99) + R"(,"p99.9":)" + number(report.p999) +
+         R"(,"max":)" + number(report.max) + R"(},"max_lag_ms":)" +
+         number(report.max_lag) + "}";
+}
+
+FuturePoller::FuturePoller() : thread_(&FuturePoller::run, this) {}
+
+FuturePoller::~FuturePoller() {
+  stop_.store(true);
+  thread_.join();
+}
+
+void FuturePoller::add(InferenceResponseFuture future, DoneCallback done) {
+  const std::lock_guard lock{mutex_};
+  incoming_.push_back({std::move(future), std::move(done)});
+}
+
+void FuturePoller::run() {
+  std::vector<Pending> pending;
+  while (!stop_.load()) {
+    {
+      const std::lock_guard lock{mutex_};
+      std::move(incoming_.begin(), incoming_.end(),
+                std::back_inserter(pending));
+      incoming_.clear();
+    }
+
+    bool polled = false;
+    for (auto i = 0U; i < pending.size();) {
+      auto& request = pending[i];
+      if (request.future.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+        ++i;
+        continue;
+      }
+      bool succeeded = false;
+      try {
+        succeeded = !request.future.get().isError();
+      } catch (const std::exception&) {
+        succeeded = false;
+      }
+      request.done(succeeded);
+      // the order of the pending requests doesn't matter
+      request = std::move(pending.back());
+      pending.pop_back();
+      polled = true;
+    }
+    if (!polled) {
+      std::this_thread::sleep_for(kPollInterval);
+    }
+  }
+}
+
+}  // namespace amdinfer
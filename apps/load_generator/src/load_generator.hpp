@@ -0,0 +1,190 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines an open-loop load generator that sends requests at a fixed
+ * rate regardless of how quickly they're answered
+ */
+
+#ifndef GUARD_LOAD_GENERATOR_SRC_LOAD_GENERATOR
+#define GUARD_LOAD_GENERATOR_SRC_LOAD_GENERATOR
+
+#include <atomic>      // for atomic
+#include <chrono>      // for duration, milliseconds
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint64_t
+#include <functional>  // for function
+#include <map>         // for map
+#include <mutex>       // for mutex
+#include <string>      // for string
+#include <thread>      // for thread
+#include <vector>      // for vector
+
+#include "amdinfer/amdinfer.hpp"
+
+namespace amdinfer {
+
+/// How the times between requests are chosen
+enum class Arrival {
+  /// the requests are evenly spaced
+  Constant,
+  /// the times between requests are exponentially distributed, as if they
+  /// came from many independent users
+  Poisson,
+};
+
+/// Options for one run of the load generator
+struct LoadOptions {
+  /// requests per second to send
+  double rate = 1;
+  Arrival arrival = Arrival::Poisson;
+  /// how long requests are measured for
+  std::chrono::duration<double> duration{10};
+  /// how long requests are sent before they're measured
+  std::chrono::duration<double> warmup{2};
+  /// how long to wait for responses after the last request is sent
+  std::chrono::duration<double> drain{10};
+  /// requests that succeed within this latency count towards the goodput
+  std::chrono::duration<double> slo = std::chrono::milliseconds(100);
+  /// seed for the arrival times
+  uint64_t seed = 0;
+};
+
+/// Summary of one run of the load generator. Latencies are in milliseconds
+struct LoadReport {
+  double offered_rate = 0;
+  /// number of measured requests that were sent
+  size_t sent = 0;
+  /// number of measured requests that succeeded
+  size_t succeeded = 0;
+  /// number of measured requests that failed
+  size_t failed = 0;
+  /// number of measured requests that weren't answered in time
+  size_t unanswered = 0;
+  /// succeeded requests per second
+  double throughput = 0;
+  /// requests per second that succeeded within the SLO
+  double goodput = 0;
+  double mean = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+  double p999 = 0;
+  double max = 0;
+  /// how far the sender fell behind its schedule at worst. If it's large, the
+  /// load generator itself couldn't keep up with the rate
+  double max_lag = 0;
+};
+
+/// Called with whether the request succeeded once its response arrives. It
+/// may be called from any thread
+using DoneCallback = std::function<void(bool succeeded)>;
+/// Sends one request and arranges for the callback to be called when it's
+/// answered. It must not wait for the response
+using Sender = std::function<void(DoneCallback done)>;
+
+/**
+ * @brief Send requests at the rate in the options and measure their latency.
+ * The latency of each request is measured from when it was scheduled to be
+ * sent rather than when it was sent so delays in sending it, for example
+ * because earlier requests hold up the client, are counted too. Requests that
+ * aren't answered by the end of the drain are counted from when they were
+ * scheduled until the drain ends.
+ *
+ * @param options options for the run
+ * @param send function that sends one request
+ * @return LoadReport
+ */
+LoadReport runLoad(const LoadOptions& options, const Sender& send);
+
+/// Options for replaying a captured trace
+struct ReplayOptions {
+  /// how many times faster than they were captured the requests are sent
+  double speed = 1;
+  /// how long to wait for responses after the last request is sent
+  std::chrono::duration<double> drain{10};
+  /// requests that succeed within this latency count towards the goodput
+  std::chrono::duration<double> slo = std::chrono::milliseconds(100);
+};
+
+/// Sends the request at an index of the trace like a Sender
+using ReplaySender = std::function<void(size_t index, DoneCallback done)>;
+
+/**
+ * @brief Send requests with the times between them that they arrived with
+ * when they were captured, scaled by the speed, and measure their latency the
+ * same way as runLoad. All the requests are measured and each report's rates
+ * are over the time it took to send them.
+ *
+ * @param times when each request arrived, in order, from the start of the
+ * capture
+ * @param groups the group of each request, such as its model, whose requests
+ * are reported together
+ * @param options options for the replay
+ * @param send function that sends one request
+ * @return std::map<std::string, LoadReport> - the report of each group
+ */
+std::map<std::string, LoadReport> runReplay(
+  const std::vector<std::chrono::nanoseconds>& times,
+  const std::vector<std::string>& groups, const ReplayOptions& options,
+  const ReplaySender& send);
+
+/**
+ * @brief Serialize a report as a JSON object
+ *
+ * @param report the report
+ * @return std::string
+ */
+std::string toJson(const LoadReport& report);
+
+/**
+ * @brief The FuturePoller calls the callbacks of requests sent with futures as
+ * soon as each response arrives, in whatever order they arrive in, so a slow
+ * response doesn't delay the measurements of the ones after it. A thread polls
+ * the outstanding futures so the times are accurate to about kPollInterval.
+ */
+class FuturePoller {
+ public:
+  FuturePoller();
+  FuturePoller(FuturePoller const&) = delete;
+  FuturePoller& operator=(const FuturePoller&) = delete;
+  FuturePoller(FuturePoller&& other) = delete;
+  FuturePoller& operator=(FuturePoller&& other) = delete;
+  /// Stop polling. Callbacks of requests that are still outstanding are
+  /// never called
+  ~FuturePoller();
+
+  /// Call the callback when the future is ready
+  void add(InferenceResponseFuture future, DoneCallback done);
+
+  static constexpr std::chrono::microseconds kPollInterval{20};
+
+ private:
+  struct Pending {
+    InferenceResponseFuture future;
+    DoneCallback done;
+  };
+
+  void run();
+
+  std::mutex mutex_;
+  std::vector<Pending> incoming_;
+  std::atomic<bool> stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_LOAD_GENERATOR_SRC_LOAD_GENERATOR
@@ -0,0 +1,410 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Sweeps an endpoint across request rates and reports the latency and
+ * goodput at each rate
+ */
+
+#include <algorithm>    // for max, stable_sort
+#include <chrono>       // for duration
+#include <cstddef>      // for byte, size_t
+#include <cstdint>      // for int64_t, uint16_t
+#include <cxxopts.hpp>  // for Options, value, ParseResult
+#include <fstream>      // for ofstream
+#include <iomanip>      // for setw
+#include <iostream>     // for cout, cerr
+#include <memory>       // for unique_ptr, make_unique
+#include <optional>     // for optional
+#include <set>          // for set
+#include <sstream>      // for stringstream
+#include <stdexcept>    // for invalid_argument
+#include <string>       // for string, stod, getline
+#include <string_view>  // for string_view
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "amdinfer/amdinfer.hpp"
+#include "amdinfer/core/traffic_trace.hpp"
+#include "load_generator.hpp"
+
+#ifdef AMDINFER_ENABLE_HTTP
+#include "amdinfer/clients/websocket.hpp"
+#endif
+
+namespace {
+
+const uint16_t kHttpPort = 8998;
+const uint16_t kGrpcPort = 50'051;
+
+std::vector<double> parseRates(const std::string& rates) {
+  std::vector<double> parsed;
+  std::stringstream stream{rates};
+  std::string rate;
+  while (std::getline(stream, rate, ',')) {
+    parsed.push_back(std::stod(rate));
+    if (parsed.back() <= 0) {
+      throw std::invalid_argument("Rates must be positive");
+    }
+  }
+  if (parsed.empty()) {
+    throw std::invalid_argument("No rates given");
+  }
+  return parsed;
+}
+
+/**
+ * @brief Make a request for the endpoint from its metadata with zeroed inputs.
+ * Dimensions that the metadata leaves open are set to 1.
+ *
+ * @param client client to get the metadata with
+ * @param endpoint the endpoint
+ * @param data buffers to hold the inputs' data
+ * @return amdinfer::InferenceRequest
+ */
+amdinfer::InferenceRequest makeRequest(
+  const amdinfer::Client* client, const std::string& endpoint,
+  std::vector<std::vector<std::byte>>* data) {
+  const auto metadata = client->modelMetadata(endpoint);
+  amdinfer::InferenceRequest request;
+  for (const auto& input : metadata.getInputs()) {
+    auto shape = input.getShape();
+    size_t size = 1;
+    for (auto& dim : shape) {
+      dim = std::max(dim, int64_t{1});
+      size *= dim;
+    }
+    auto& buffer =
+      data->emplace_back(size * input.getDatatype().size(), std::byte{0});
+    request.addInputTensor(amdinfer::InferenceRequestInput{
+      buffer.data(), shape, input.getDatatype(), input.getName()});
+  }
+  return request;
+}
+
+/// Get the name of the endpoint of a version of a model
+std::string getEndpoint(const amdinfer::TraceRecord& record) {
+  return record.version.empty() ? record.model
+                                : record.model + "_" + record.version;
+}
+
+std::vector<amdinfer::TraceRecord> readTrace(const std::string& path) {
+  amdinfer::TraceReader reader{path};
+  std::vector<amdinfer::TraceRecord> records;
+  amdinfer::TraceRecord record;
+  while (reader.read(&record)) {
+    records.push_back(std::move(record));
+  }
+  // requests captured at the same time by different threads may be written
+  // out of order
+  std::stable_sort(records.begin(), records.end(),
+                   [](const auto& lhs, const auto& rhs) {
+                     return lhs.time < rhs.time;
+                   });
+  return records;
+}
+
+void printReport(const amdinfer::LoadReport& report,
+                 const std::string& label = "") {
+  const auto width = 10;
+  std::cout << std::setw(width) << report.offered_rate << std::setw(width)
+            << report.throughput << std::setw(width) << report.goodput
+            << std::setw(width) << report.p50 << std::setw(width)
+            << report.p90 << std::setw(width) << report.p99
+            << std::setw(width) << report.p999 << std::setw(width)
+            << report.failed + report.unanswered;
+  if (!label.empty()) {
+    std::cout << "  " << label;
+  }
+  std::cout << "\n";
+}
+
+/**
+ * @brief Replay a trace against the endpoints it was captured from and report
+ * the latency of each endpoint
+ *
+ * @param client client to send the requests with
+ * @param trace the requests, in the order they arrived
+ * @param speed how many times faster than captured to send them
+ * @param drain seconds to wait for responses after sending
+ * @param slo_ms latency in ms that requests must meet to count towards goodput
+ * @param output path to write the JSON report to or empty
+ * @return int the exit code
+ */
+int replayTrace(const amdinfer::Client* client,
+                std::vector<amdinfer::TraceRecord>* trace, double speed,
+                double drain, double slo_ms, const std::string& output) {
+  std::vector<std::chrono::nanoseconds> times;
+  std::vector<std::string> endpoints;
+  times.reserve(trace->size());
+  endpoints.reserve(trace->size());
+  for (const auto& record : *trace) {
+    times.push_back(record.time);
+    endpoints.push_back(getEndpoint(record));
+  }
+  const std::set<std::string> unique{endpoints.begin(), endpoints.end()};
+  for (const auto& endpoint : unique) {
+    amdinfer::waitUntilModelReady(client, endpoint);
+  }
+
+  amdinfer::FuturePoller poller;
+  const amdinfer::ReplaySender send = [&](size_t index,
+                                          amdinfer::DoneCallback done) {
+    const auto& record = trace->at(index);
+    poller.add(
+      client->modelInferAsync(record.model, record.request, record.version),
+      std::move(done));
+  };
+
+  amdinfer::ReplayOptions replay_options;
+  replay_options.speed = speed;
+  replay_options.drain = std::chrono::duration<double>(drain);
+  replay_options.slo = std::chrono::duration<double, std::milli>(slo_ms);
+  const auto reports = amdinfer::runReplay(times, endpoints, replay_options,
+                                           send);
+
+  const auto width = 10;
+  std::cout << std::setw(width) << "rate" << std::setw(width) << "thruput"
+            << std::setw(width) << "goodput" << std::setw(width) << "p50"
+            << std::setw(width) << "p90" << std::setw(width) << "p99"
+            << std::setw(width) << "p99.9" << std::setw(width) << "errors"
+            << "  endpoint\n";
+  for (const auto& [endpoint, report] : reports) {
+    printReport(report, endpoint);
+  }
+
+  if (!output.empty()) {
+    std::ofstream file{output};
+    file << R"({"speed":)" << speed << R"(,"slo_ms":)" << slo_ms
+         << R"(,"endpoints":{)";
+    bool first = true;
+    for (const auto& [endpoint, report] : reports) {
+      file << (first ? "" : ",") << '"' << endpoint
+           << "\":" << amdinfer::toJson(report);
+      first = false;
+    }
+    file << "}}\n";
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string protocol{"native"};
+  std::string address{"127.0.0.1:" + std::to_string(kHttpPort)};
+  bool remote_server = false;
+  std::string endpoint;
+  std::string worker;
+  std::string rates_str{"10"};
+  std::string arrival{"poisson"};
+  double duration = 10;
+  double warmup = 2;
+  double drain = 10;
+  double slo_ms = 100;
+  uint64_t seed = 0;
+  std::string output;
+  std::string replay;
+  double speed = 1;
+
+  cxxopts::Options options(
+    "load_generator",
+    "Send requests to the AMD Inference Server at fixed rates and report the "
+    "latency percentiles and goodput at each rate");
+  // clang-format off
+  options.add_options()
+  ("protocol", "Must be one of 'native', 'http', 'grpc' or 'websocket'",
+    cxxopts::value(protocol))
+  ("address",
+    "Address of the server as host:port if using HTTP, gRPC or websocket",
+    cxxopts::value(address))
+  ("remote-server", "Set to use a remote server instead of starting one",
+    cxxopts::value(remote_server))
+  ("endpoint", "Endpoint to send requests to. If empty, the worker is loaded",
+    cxxopts::value(endpoint))
+  ("worker", "Name of the worker to load if no endpoint is given",
+    cxxopts::value(worker))
+  ("rates", "Comma-separated requests per second to sweep. Defaults to 10",
+    cxxopts::value(rates_str))
+  ("arrival", "Must be one of 'poisson' or 'constant'",
+    cxxopts::value(arrival))
+  ("duration", "Seconds to measure each rate for. Defaults to 10",
+    cxxopts::value(duration))
+  ("warmup", "Seconds to send requests before measuring. Defaults to 2",
+    cxxopts::value(warmup))
+  ("drain", "Seconds to wait for responses after sending. Defaults to 10",
+    cxxopts::value(drain))
+  ("slo", "Latency in ms that requests must meet to count towards goodput",
+    cxxopts::value(slo_ms))
+  ("seed", "Seed for the arrival times", cxxopts::value(seed))
+  ("replay",
+    "Trace captured by a server to replay instead of sweeping the rates",
+    cxxopts::value(replay))
+  ("speed", "How many times faster than captured to replay the trace",
+    cxxopts::value(speed))
+  ("output", "Path to write the JSON report to", cxxopts::value(output))
+  ("help", "Print help");
+  // clang-format on
+
+  std::vector<double> rates;
+  try {
+    auto result = options.parse(argc, argv);
+    if (result.count("help") != 0U) {
+      std::cout << options.help({""}) << "\n";
+      return 0;
+    }
+    rates = parseRates(rates_str);
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing options: " << e.what() << "\n";
+    return 1;
+  }
+  if (arrival != "poisson" && arrival != "constant") {
+    std::cerr << "Arrival must be one of 'poisson' or 'constant'\n";
+    return 1;
+  }
+  if (replay.empty() && endpoint.empty() && worker.empty()) {
+    std::cerr << "Either an endpoint or a worker must be given\n";
+    return 1;
+  }
+  if (speed <= 0) {
+    std::cerr << "The speed must be positive\n";
+    return 1;
+  }
+  std::vector<amdinfer::TraceRecord> trace;
+  if (!replay.empty()) {
+    try {
+      trace = readTrace(replay);
+    } catch (const amdinfer::runtime_error& e) {
+      std::cerr << "Error reading the trace: " << e.what() << "\n";
+      return 1;
+    }
+    if (trace.empty()) {
+      std::cerr << "The trace has no requests\n";
+      return 1;
+    }
+  }
+
+  std::optional<amdinfer::Server> server;
+  if (!remote_server) {
+    server.emplace();
+  }
+
+  std::unique_ptr<amdinfer::Client> client;
+#ifdef AMDINFER_ENABLE_HTTP
+  amdinfer::WebSocketClient* ws_client = nullptr;
+#endif
+  if (protocol == "native") {
+    if (remote_server) {
+      std::cerr << "Server must be started locally if using native client\n";
+      return 1;
+    }
+    client = std::make_unique<amdinfer::NativeClient>(&(server.value()));
+#ifdef AMDINFER_ENABLE_HTTP
+  } else if (protocol == "http" || protocol == "websocket") {
+    if (!remote_server) {
+      server.value().startHttp(kHttpPort);
+    }
+    if (protocol == "http") {
+      client = std::make_unique<amdinfer::HttpClient>("http://" + address);
+    } else {
+      auto websocket = std::make_unique<amdinfer::WebSocketClient>(
+        "ws://" + address, "http://" + address);
+      ws_client = websocket.get();
+      client = std::move(websocket);
+    }
+#endif
+#ifdef AMDINFER_ENABLE_GRPC
+  } else if (protocol == "grpc") {
+    if (!remote_server) {
+      server.value().startGrpc(kGrpcPort);
+    }
+    client = std::make_unique<amdinfer::GrpcClient>(address);
+#endif
+  } else {
+    std::cerr << "Protocol " << protocol << " is not supported\n";
+    return 1;
+  }
+
+  amdinfer::waitUntilServerReady(client.get());
+  if (!replay.empty()) {
+    return replayTrace(client.get(), &trace, speed, drain, slo_ms, output);
+  }
+  const auto load_worker = endpoint.empty();
+  if (load_worker) {
+    endpoint = client->workerLoad(worker, amdinfer::ParameterMap{});
+  }
+  amdinfer::waitUntilModelReady(client.get(), endpoint);
+
+  std::vector<std::vector<std::byte>> data;
+  auto request = makeRequest(client.get(), endpoint, &data);
+
+  amdinfer::FuturePoller poller;
+  amdinfer::Sender send = [&](amdinfer::DoneCallback done) {
+    poller.add(client->modelInferAsync(endpoint, request), std::move(done));
+  };
+#ifdef AMDINFER_ENABLE_HTTP
+  if (ws_client != nullptr) {
+    send = [&, id = size_t{0}](amdinfer::DoneCallback done) mutable {
+      // websocket responses are matched to requests by their IDs
+      request.setID(std::to_string(id++));
+      ws_client->modelInferWs(
+        endpoint, request,
+        [done = std::move(done)](std::string_view message, bool binary) {
+          done(binary || message.find(R"("error")") == std::string::npos);
+          return true;
+        });
+    };
+  }
+#endif
+
+  amdinfer::LoadOptions load_options;
+  load_options.arrival = arrival == "poisson" ? amdinfer::Arrival::Poisson
+                                              : amdinfer::Arrival::Constant;
+  load_options.duration = std::chrono::duration<double>(duration);
+  load_options.warmup = std::chrono::duration<double>(warmup);
+  load_options.drain = std::chrono::duration<double>(drain);
+  load_options.slo = std::chrono::duration<double, std::milli>(slo_ms);
+  load_options.seed = seed;
+
+  const auto width = 10;
+  std::cout << std::setw(width) << "rate" << std::setw(width) << "thruput"
+            << std::setw(width) << "goodput" << std::setw(width) << "p50"
+            << std::setw(width) << "p90" << std::setw(width) << "p99"
+            << std::setw(width) << "p99.9" << std::setw(width) << "errors"
+            << "\n";
+  std::vector<amdinfer::LoadReport> reports;
+  for (const auto& rate : rates) {
+    load_options.rate = rate;
+    reports.push_back(amdinfer::runLoad(load_options, send));
+    printReport(reports.back());
+  }
+
+  if (!output.empty()) {
+    std::ofstream file{output};
+    file << R"({"protocol":")" << protocol << R"(","endpoint":")" << endpoint
+         << R"(","arrival":")" << arrival << R"(","duration_s":)" << duration
+         << R"(,"warmup_s":)" << warmup << R"(,"slo_ms":)" << slo_ms
+         << R"(,"seed":)" << seed << R"(,"runs":[)";
+    for (auto i = 0U; i < reports.size(); ++i) {
+      file << (i == 0 ? "" : ",") << amdinfer::toJson(reports[i]);
+    }
+    file << "]}\n";
+  }
+
+  if (load_worker) {
+    client->workerUnload(endpoint);
+  }
+  return 0;
+}
@@ -120,12 +120,17 @@ int main(int argc, char* argv[]) {
   // line, if they exist
   int performance_samples = default_performance_samples;
   fs::path input_directory = fs::current_path() / "data";
+  fs::path sample_store;
   fs::path model_path;
   std::string worker;
   std::string protocol{"native"};
   std::string address;
   std::string endpoint;
   bool remote_server = false;
+  int completion_threads = 1;
+  int max_in_flight = 0;
+  // negative to use the scenario's target latency
+  int deadline = -1;
 
   // these must be specified from the command line
   std::string scenario;
@@ -152,6 +157,10 @@ int main(int argc, char* argv[]) {
   ("input-directory",
     "Path to the directory containing input data. Defaults to ./data",
     cxxopts::value(input_directory))
+  ("sample-store",
+    "Path to a store of preprocessed samples to map instead of preprocessing "
+    "the input directory on each run. It's made from the input directory if "
+    "it doesn't exist", cxxopts::value(sample_store))
   ("protocol", "Must be one of 'native', 'http' or 'grpc'",
     cxxopts::value(protocol))
   ("address", "Address to the server if using HTTP or gRPC client",
@@ -164,6 +173,16 @@ int main(int argc, char* argv[]) {
     cxxopts::value(model_path))
   ("worker", "Name of the worker to use if using a local server",
     cxxopts::value(worker))
+  ("completion-threads",
+    "Number of threads reporting responses to loadgen. Defaults to 1",
+    cxxopts::value(completion_threads))
+  ("max-in-flight",
+    "Maximum number of samples sent and not yet completed. Defaults to 0 "
+    "for no limit", cxxopts::value(max_in_flight))
+  ("deadline",
+    "Deadline in ms for each request. Defaults to the target latency in the "
+    "Server and MultiStream scenarios. Set to 0 to disable",
+    cxxopts::value(deadline))
   ("help", "Print help");
   // clang-format on
 
@@ -213,10 +232,16 @@ int main(int argc, char* argv[]) {
     std::string input_directory_str{input_directory};
     setStringFromConfig("input_directory", input_directory_str);
     input_directory = input_directory_str;
+    std::string sample_store_str{sample_store};
+    setStringFromConfig("sample_store", sample_store_str);
+    sample_store = sample_store_str;
     setStringFromConfig("protocol", protocol);
     setStringFromConfig("address", address);
     setBoolFromConfig("remote_server", remote_server);
     setStringFromConfig("endpoint", endpoint);
+    setIntFromConfig("completion_threads", completion_threads);
+    setIntFromConfig("max_in_flight", max_in_flight);
+    setIntFromConfig("deadline", deadline);
 
   } catch (const cxxopts::OptionException& e) {
     std::cout << "Error parsing options: " << e.what() << "\n";
@@ -246,7 +271,10 @@ int main(int argc, char* argv[]) {
   mlperf::LogSettings log_settings;
   log_settings.enable_trace = false;
 
-  if (!fs::exists(input_directory)) {
+  // the input directory isn't needed if the samples are already in a store
+  const bool needs_input =
+    sample_store.empty() || !fs::exists(sample_store);
+  if (needs_input && !fs::exists(input_directory)) {
     std::cerr << "Input directory at " << input_directory
               << " does not exist\n";
     return 1;
@@ -258,19 +286,41 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::cout << "Using input directory " << input_directory << "\n";
-  std::unique_ptr<amdinfer::QuerySampleLibrary> qsl;
+  amdinfer::PreprocessFunc preprocess;
   if (model == "fake") {
-    qsl = std::make_unique<amdinfer::QuerySampleLibrary>(
-      performance_samples, input_directory, preprocessFake);
+    preprocess = preprocessFake;
   } else if (model == "resnet50") {
-    qsl = std::make_unique<amdinfer::QuerySampleLibrary>(
-      performance_samples, input_directory, preprocessResnet50);
+    preprocess = preprocessResnet50;
   } else {
     std::cerr << "Unsupported preprocessing function for " << model << "\n";
     return 1;
   }
 
+  std::unique_ptr<amdinfer::QuerySampleLibrary> qsl;
+  if (sample_store.empty()) {
+    std::cout << "Using input directory " << input_directory << "\n";
+    qsl = std::make_unique<amdinfer::QuerySampleLibrary>(
+      performance_samples, input_directory, preprocess);
+  } else {
+    if (!fs::exists(sample_store)) {
+      std::cout << "Making sample store " << sample_store << " from "
+                << input_directory << "\n";
+      std::vector<fs::path> sources;
+      for (const auto& entry :
+           fs::recursive_directory_iterator(input_directory)) {
+        if (entry.is_regular_file()) {
+          sources.push_back(entry.path());
+        }
+      }
+      std::sort(sources.begin(), sources.end());
+      amdinfer::SampleStore::write(sample_store, sources, preprocess);
+    }
+    std::cout << "Using sample store " << sample_store << "\n";
+    qsl = std::make_unique<amdinfer::QuerySampleLibrary>(
+      performance_samples,
+      std::make_unique<amdinfer::SampleStore>(sample_store));
+  }
+
   std::optional<amdinfer::Server> server;
   std::unique_ptr<amdinfer::Client> client;
   if (!remote_server) {
@@ -323,7 +373,32 @@ int main(int argc, char* argv[]) {
     }
   }
 
-  amdinfer::SystemUnderTest sut(qsl.get(), client.get(), endpoint);
+  amdinfer::SystemUnderTestOptions sut_options;
+  sut_options.completion_threads = std::max(completion_threads, 1);
+  sut_options.max_in_flight = std::max(max_in_flight, 0);
+  sut_options.deadline_ms = deadline;
+  // by default, bound the batching latency by the target latency so the
+  // batchers send partial batches in time. Late requests are rejected by the
+  // batchers so the deadline isn't set when checking accuracy
+  if (deadline < 0) {
+    const auto ns_per_ms = 1'000'000;
+    uint64_t target_ns = 0;
+    if (test_settings.scenario == mlperf::TestScenario::Server) {
+      target_ns = test_settings.server_target_latency_ns;
+    } else if (test_settings.scenario == mlperf::TestScenario::MultiStream) {
+      target_ns = test_settings.multi_stream_expected_latency_ns;
+    }
+    const bool accuracy = test_settings.mode == mlperf::TestMode::AccuracyOnly;
+    sut_options.deadline_ms =
+      accuracy ? 0 : static_cast<int>(target_ns / ns_per_ms);
+  }
+  std::cout << "Using " << sut_options.completion_threads
+            << " completion thread(s), an in-flight limit of "
+            << sut_options.max_in_flight << " and a deadline of "
+            << sut_options.deadline_ms << " ms\n";
+
+  amdinfer::SystemUnderTest sut(qsl.get(), client.get(), endpoint,
+                                sut_options);
 
   mlperf::StartTest(&sut, qsl.get(), test_settings, log_settings);
 
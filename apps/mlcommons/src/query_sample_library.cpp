@@ -39,6 +39,15 @@ QuerySampleLibrary::QuerySampleLibrary(size_t perf_samples,
   }
 }
 
+QuerySampleLibrary::QuerySampleLibrary(size_t perf_samples,
+                                       std::unique_ptr<SampleStore> store)
+  : perf_samples_(perf_samples), store_(std::move(store)) {
+  samples_.reserve(store_->size());
+  for (size_t i = 0; i < store_->size(); ++i) {
+    samples_.emplace_back(store_->getName(i));
+  }
+}
+
 const std::string& QuerySampleLibrary::Name() const { return name_; }
 
 size_t QuerySampleLibrary::TotalSampleCount() { return samples_.size(); }
@@ -47,6 +56,13 @@ size_t QuerySampleLibrary::PerformanceSampleCount() { return perf_samples_; }
 
 void QuerySampleLibrary::LoadSamplesToRam(
   const std::vector<mlperf::QuerySampleIndex>& indices) {
+  if (store_ != nullptr) {
+    for (const auto& index : indices) {
+      samples_[index].request = store_->makeRequest(index);
+    }
+    store_->load(indices);
+    return;
+  }
   for (const auto& index : indices) {
     auto& sample = samples_[index];
     sample.request = pre_process_(sample.filepath, &sample.data);
@@ -56,7 +72,12 @@ void QuerySampleLibrary::LoadSamplesToRam(
 void QuerySampleLibrary::UnloadSamplesFromRam(
   const std::vector<mlperf::QuerySampleIndex>& indices) {
   for (const auto& index : indices) {
-    samples_[index].request = InferenceRequest();
+    auto& sample = samples_[index];
+    sample.request = InferenceRequest();
+    sample.data = std::vector<std::byte>();
+  }
+  if (store_ != nullptr) {
+    store_->unload(indices);
   }
 }
 
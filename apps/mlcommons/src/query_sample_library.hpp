@@ -23,10 +23,11 @@
 #include <query_sample_library.h>
 
 #include <filesystem>
-#include <functional>
+#include <memory>
 #include <string>
 
 #include "amdinfer/amdinfer.hpp"
+#include "sample_store.hpp"
 
 namespace amdinfer {
 
@@ -38,13 +39,18 @@ struct Sample {
   InferenceRequest request;
 };
 
-using PreprocessFunc = std::function<InferenceRequest(
-  const std::filesystem::path&, std::vector<std::byte>*)>;
-
 class QuerySampleLibrary : public mlperf::QuerySampleLibrary {
  public:
   QuerySampleLibrary(size_t perf_samples,
                      const std::filesystem::path& directory, PreprocessFunc f);
+  /**
+   * @brief Construct a QuerySampleLibrary whose samples are already
+   * preprocessed in a store. Loading the samples only faults in their pages
+   *
+   * @param perf_samples number of samples guaranteed to fit in memory
+   * @param store the store of samples
+   */
+  QuerySampleLibrary(size_t perf_samples, std::unique_ptr<SampleStore> store);
 
   /// Get the name for the object
   const std::string& Name() const override;
@@ -80,6 +86,7 @@ class QuerySampleLibrary : public mlperf::QuerySampleLibrary {
   size_t perf_samples_;
   std::vector<Sample> samples_;
   PreprocessFunc pre_process_;
+  std::unique_ptr<SampleStore> store_;
 };
 
 }  // namespace amdinfer
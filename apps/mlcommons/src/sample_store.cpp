@@ -0,0 +1,243 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements a file of preprocessed samples that's memory-mapped so the
+ * samples don't need to be preprocessed or copied for each run
+ */
+
+#include "sample_store.hpp"
+
+#include <fcntl.h>     // for open, O_RDONLY
+#include <sys/mman.h>  // for mmap, munmap, madvise
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for close
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+namespace {
+
+constexpr std::array<char, 8> kMagic{'A', 'M', 'D', 'S', 'A', 'M', 'P', 'L'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kMaxRank = 8;
+// samples are aligned so they can be read with vector instructions
+constexpr size_t kSampleAlignment = 64;
+// the samples start on a page boundary so they can be mapped on their own
+constexpr size_t kDataAlignment = 4096;
+
+struct Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t rank;
+  std::array<char, 8> datatype;
+  uint64_t count;
+  uint64_t sample_size;
+  uint64_t stride;
+  uint64_t data_offset;
+  std::array<int64_t, kMaxRank> shape;
+};
+
+size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+void SampleStore::write(const fs::path& path,
+                        const std::vector<fs::path>& sources,
+                        const PreprocessFunc& preprocess) {
+  if (sources.empty()) {
+    throw invalid_argument("No samples to write to the store");
+  }
+
+  Header header{};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.count = sources.size();
+
+  // the index holds the length of each name followed by the name
+  uint64_t index_size = 0;
+  for (const auto& source : sources) {
+    index_size += sizeof(uint32_t) + source.filename().string().size();
+  }
+  header.data_offset = alignUp(sizeof(Header) + index_size, kDataAlignment);
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw runtime_error("Could not open " + path.string() + " for writing");
+  }
+  file.seekp(static_cast<std::streamoff>(sizeof(Header)));
+  for (const auto& source : sources) {
+    const auto name = source.filename().string();
+    const auto length = static_cast<uint32_t>(name.size());
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(name.data(), static_cast<std::streamsize>(name.size()));
+  }
+
+  std::vector<std::byte> data;
+  std::vector<char> padding;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const auto request = preprocess(sources[i], &data);
+    const auto& inputs = request.getInputs();
+    if (inputs.size() != 1) {
+      throw invalid_argument("Samples in a store must have one input");
+    }
+    const auto& input = inputs.front();
+    const auto& shape = input.getShape();
+    const auto datatype = input.getDatatype();
+    const auto size = input.getSize() * datatype.size();
+
+    if (i == 0) {
+      if (shape.size() > kMaxRank) {
+        throw invalid_argument("Samples in a store can have at most " +
+                               std::to_string(kMaxRank) + " dimensions");
+      }
+      header.rank = static_cast<uint32_t>(shape.size());
+      std::copy(shape.begin(), shape.end(), header.shape.begin());
+      const std::string_view name{datatype.str()};
+      std::copy_n(name.begin(), std::min(name.size(), header.datatype.size()),
+                  header.datatype.begin());
+      header.sample_size = size;
+      header.stride = alignUp(size, kSampleAlignment);
+      padding.resize(header.stride - size);
+      file.seekp(static_cast<std::streamoff>(header.data_offset));
+    } else if (size != header.sample_size ||
+               !std::equal(shape.begin(), shape.end(), header.shape.begin(),
+                           header.shape.begin() + header.rank) ||
+               shape.size() != header.rank) {
+      throw invalid_argument("Sample " + sources[i].string() +
+                             " has a different shape than the first sample");
+    }
+
+    file.write(static_cast<const char*>(input.getData()),
+               static_cast<std::streamsize>(size));
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+  }
+
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!file) {
+    throw runtime_error("Failed to write the store to " + path.string());
+  }
+}
+
+SampleStore::SampleStore(const fs::path& path) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw runtime_error("Could not open the store at " + path.string());
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(Header)) {
+    close(fd);
+    throw invalid_argument(path.string() + " is not a sample store");
+  }
+  mapped_size_ = static_cast<size_t>(info.st_size);
+  // mapped privately and writable so a worker that writes to its inputs gets
+  // its own copy of the page instead of failing or changing the file
+  auto* address = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    throw runtime_error("Could not map the store at " + path.string());
+  }
+  mapping_ = static_cast<std::byte*>(address);
+
+  Header header{};
+  std::memcpy(&header, mapping_, sizeof(header));
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.rank > kMaxRank ||
+      header.data_offset + header.count * header.stride > mapped_size_) {
+    munmap(mapping_, mapped_size_);
+    throw invalid_argument(path.string() + " is not a valid sample store");
+  }
+
+  shape_.assign(header.shape.begin(), header.shape.begin() + header.rank);
+  const std::string datatype{
+    header.datatype.data(),
+    strnlen(header.datatype.data(), header.datatype.size())};
+  datatype_ = DataType(datatype.c_str());
+  sample_size_ = header.sample_size;
+  stride_ = header.stride;
+  data_offset_ = header.data_offset;
+
+  const auto* index = mapping_ + sizeof(Header);
+  names_.reserve(header.count);
+  for (uint64_t i = 0; i < header.count; ++i) {
+    uint32_t length = 0;
+    std::memcpy(&length, index, sizeof(length));
+    index += sizeof(length);
+    names_.emplace_back(reinterpret_cast<const char*>(index), length);
+    index += length;
+  }
+}
+
+SampleStore::~SampleStore() { munmap(mapping_, mapped_size_); }
+
+size_t SampleStore::size() const { return names_.size(); }
+
+const std::string& SampleStore::getName(size_t index) const {
+  return names_.at(index);
+}
+
+std::byte* SampleStore::getData(size_t index) const {
+  return mapping_ + data_offset_ + index * stride_;
+}
+
+InferenceRequest SampleStore::makeRequest(size_t index) const {
+  InferenceRequest request;
+  request.addInputTensor(getData(index), shape_, datatype_);
+  return request;
+}
+
+void SampleStore::load(const std::vector<size_t>& indices) const {
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  for (const auto& index : indices) {
+    auto* data = getData(index);
+    auto* page = data - (reinterpret_cast<uintptr_t>(data) % page_size);
+    madvise(page, static_cast<size_t>(data + stride_ - page), MADV_WILLNEED);
+    // touch each page so the first request doesn't fault it in
+    volatile std::byte sum{};
+    for (size_t offset = 0; offset < sample_size_; offset += page_size) {
+      sum = sum ^ data[offset];
+    }
+  }
+}
+
+void SampleStore::unload(const std::vector<size_t>& indices) const {
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  for (const auto& index : indices) {
+    // only pages that hold no other sample are released
+    auto* start = getData(index);
+    auto* first = reinterpret_cast<std::byte*>(
+      alignUp(reinterpret_cast<uintptr_t>(start), page_size));
+    auto* last = reinterpret_cast<std::byte*>(
+      reinterpret_cast<uintptr_t>(start + stride_) / page_size * page_size);
+    if (first < last) {
+      madvise(first, static_cast<size_t>(last - first), MADV_DONTNEED);
+    }
+  }
+}
+
+}  // namespace amdinfer
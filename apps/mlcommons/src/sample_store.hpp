@@ -0,0 +1,106 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a file of preprocessed samples that's memory-mapped so the
+ * samples don't need to be preprocessed or copied for each run
+ */
+
+#ifndef GUARD_MLCOMMONS_SRC_SAMPLE_STORE
+#define GUARD_MLCOMMONS_SRC_SAMPLE_STORE
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "amdinfer/amdinfer.hpp"
+
+namespace amdinfer {
+
+using PreprocessFunc = std::function<InferenceRequest(
+  const std::filesystem::path&, std::vector<std::byte>*)>;
+
+/**
+ * @brief A SampleStore is a file of preprocessed samples of the same shape and
+ * datatype. The file starts with a header, followed by the name of each
+ * sample's source file as the index and then the samples at a fixed stride,
+ * starting on a page boundary. It's mapped into memory and the requests point
+ * into the mapping so the native client can pass them to the server without
+ * copying them.
+ */
+class SampleStore {
+ public:
+  /**
+   * @brief Preprocess the files and write them to a new store
+   *
+   * @param path path to write the store to
+   * @param sources the files to preprocess in the order to store them
+   * @param preprocess the function to preprocess each file with. Each
+   * preprocessed sample must have one input of the same shape and datatype
+   */
+  static void write(const std::filesystem::path& path,
+                    const std::vector<std::filesystem::path>& sources,
+                    const PreprocessFunc& preprocess);
+
+  /**
+   * @brief Map an existing store into memory
+   *
+   * @param path path to the store
+   */
+  explicit SampleStore(const std::filesystem::path& path);
+  SampleStore(SampleStore const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  SampleStore& operator=(const SampleStore&) = delete;
+  SampleStore(SampleStore&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  SampleStore& operator=(SampleStore&& other) = delete;
+  ~SampleStore();  ///< Destructor
+
+  /// Get the number of samples
+  [[nodiscard]] size_t size() const;
+  /// Get the name of the file a sample was preprocessed from
+  [[nodiscard]] const std::string& getName(size_t index) const;
+  /**
+   * @brief Make a request for a sample whose input points into the mapping.
+   * The store must outlive the request.
+   *
+   * @param index index of the sample
+   * @return InferenceRequest
+   */
+  [[nodiscard]] InferenceRequest makeRequest(size_t index) const;
+  /// Fault in the pages of the samples so using them doesn't wait on the disk
+  void load(const std::vector<size_t>& indices) const;
+  /// Let the system reclaim the pages of the samples
+  void unload(const std::vector<size_t>& indices) const;
+
+ private:
+  [[nodiscard]] std::byte* getData(size_t index) const;
+
+  std::byte* mapping_ = nullptr;
+  size_t mapped_size_ = 0;
+  std::vector<std::string> names_;
+  std::vector<int64_t> shape_;
+  DataType datatype_;
+  size_t sample_size_ = 0;
+  size_t stride_ = 0;
+  size_t data_offset_ = 0;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_MLCOMMONS_SRC_SAMPLE_STORE
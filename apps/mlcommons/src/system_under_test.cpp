@@ -14,68 +14,137 @@
 
 /**
  * @file
- * @brief
+ * @brief Implements the system under test that sends loadgen's queries to the
+ * inference server
  */
 
 #include "system_under_test.hpp"
 
 #include <loadgen.h>
 
-#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <utility>
 
 #include "query_sample_library.hpp"
 
 namespace amdinfer {
 
+// maximum number of responses reported to loadgen in one call
+constexpr size_t kCompletionBatch = 64;
+// how long the completion threads wait for responses before checking if the
+// SUT is stopping
+constexpr auto kCompletionTimeout = std::chrono::milliseconds(100);
+
 const std::string& SystemUnderTest::Name() const { return name_; }
 
 SystemUnderTest::SystemUnderTest(QuerySampleLibrary* qsl, Client* client,
-                                 std::string endpoint)
-  : qsl_(qsl), client_(client), endpoint_(std::move(endpoint)) {
+                                 std::string endpoint,
+                                 const SystemUnderTestOptions& options)
+  : qsl_(qsl),
+    client_(client),
+    endpoint_(std::move(endpoint)),
+    options_(options) {
   waitUntilServerReady(client_);
   waitUntilModelReady(client_, endpoint_);
-  std::thread{&SystemUnderTest::FinishQuery, this}.detach();
-  // std::thread{&SystemUnderTest::FinishQuery, this}.detach();
+  const auto threads = std::max(options_.completion_threads, size_t{1});
+  for (auto i = 0U; i < threads; ++i) {
+    threads_.emplace_back(&SystemUnderTest::complete, this);
+  }
+}
+
+SystemUnderTest::~SystemUnderTest() {
+  running_.store(false);
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void SystemUnderTest::acquire(size_t count) {
+  if (options_.max_in_flight == 0) {
+    return;
+  }
+  // a query larger than the limit is let through alone
+  std::unique_lock lock{in_flight_mutex_};
+  in_flight_cv_.wait(lock, [&]() {
+    return in_flight_ == 0 || in_flight_ + count <= options_.max_in_flight;
+  });
+  in_flight_ += count;
+}
+
+void SystemUnderTest::release(size_t count) {
+  if (options_.max_in_flight == 0) {
+    return;
+  }
+  {
+    std::lock_guard lock{in_flight_mutex_};
+    in_flight_ -= count;
+  }
+  in_flight_cv_.notify_all();
 }
 
 void SystemUnderTest::IssueQuery(
   const std::vector<mlperf::QuerySample>& samples) {
-  for (const auto& sample : samples) {
-    auto& request = qsl_->getSample(sample.index);
-    request.setID(std::to_string(sample.id));
-    auto response = client_->modelInferAsync(endpoint_, request);
-    // std::cout << ": " << sample.id << ": " <<
-    // std::chrono::high_resolution_clock::now().time_since_epoch().count() <<
-    // ": " << std::endl;
-    queue_.enqueue(std::move(response));
+  // send large queries, as in the Offline scenario, in chunks so the limit
+  // applies to them too
+  const auto chunk = options_.max_in_flight == 0 ? samples.size()
+                                                 : options_.max_in_flight;
+  for (size_t i = 0; i < samples.size(); i += chunk) {
+    const auto end = std::min(i + chunk, samples.size());
+    acquire(end - i);
+    for (auto j = i; j < end; ++j) {
+      const auto& sample = samples[j];
+      // copy the request since loadgen may issue the same sample from more
+      // than one thread. The copy shares the sample's data
+      auto request = qsl_->getSample(sample.index);
+      request.setID(std::to_string(sample.id));
+      if (options_.deadline_ms > 0) {
+        auto parameters = request.getParameters();
+        parameters.put("deadline", options_.deadline_ms);
+        request.setParameters(std::move(parameters));
+      }
+      queue_.enqueue(
+        PendingSample{sample.id, client_->modelInferAsync(endpoint_, request)});
+    }
   }
 }
 
-// NOLINTNEXTLINE(readability-identifier-naming)
-[[noreturn]] void SystemUnderTest::FinishQuery() {
-  const int max = 16;  // arbitrary
-  while (true) {
-    std::vector<InferenceResponseFuture> futures;
-    futures.reserve(max);
-    auto returned = queue_.wait_dequeue_bulk(futures.begin(), max);
-    for (auto i = 0U; i < returned; ++i) {
-      auto& future = futures[i];
-
-      auto response = future.get();
+void SystemUnderTest::complete() {
+  std::vector<PendingSample> pending(kCompletionBatch);
+  std::vector<InferenceResponse> responses;
+  std::vector<mlperf::QuerySampleResponse> results;
+  responses.reserve(kCompletionBatch);
+  results.reserve(kCompletionBatch);
+
+  while (running_.load()) {
+    const auto count = queue_.wait_dequeue_bulk_timed(
+      pending.begin(), kCompletionBatch, kCompletionTimeout);
+    for (auto i = 0U; i < count; ++i) {
+      auto& sample = pending[i];
+      auto response = sample.future.get();
+      uintptr_t data = 0;
+      size_t size = 0;
       if (response.isError()) {
-        std::cout << "Error encountered in response. App may hang\n";
-      } else {
-        const auto& outputs = response.getOutputs();
-        assert(outputs.size() == 1);
-        const auto& output = outputs[0];
-        auto data = reinterpret_cast<uintptr_t>(output.getData());
-        mlperf::ResponseId id = std::stoul(response.getID());
-        mlperf::QuerySampleResponse result{id, data, output.getSize()};
-        // std::cout << "::" << id << "::" <<
-        // std::chrono::high_resolution_clock::now().time_since_epoch().count()
-        // << "::" << std::endl;
-        mlperf::QuerySamplesComplete(&result, 1);
+        // report it anyway so loadgen doesn't wait for it forever
+        std::cerr << "Error in response " << sample.id << ": "
+                  << response.getError() << "\n";
+      } else if (const auto& outputs = response.getOutputs();
+                 !outputs.empty()) {
+        const auto& output = outputs.front();
+        data = reinterpret_cast<uintptr_t>(output.getData());
+        size = output.getSize() * output.getDatatype().size();
       }
+      results.push_back({sample.id, data, size});
+      // keep the response alive until loadgen has copied its data
+      responses.push_back(std::move(response));
+    }
+    if (count > 0) {
+      mlperf::QuerySamplesComplete(results.data(), results.size());
+      release(count);
+      results.clear();
+      responses.clear();
     }
   }
 }
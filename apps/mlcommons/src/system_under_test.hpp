@@ -14,47 +14,94 @@
 
 /**
  * @file
- * @brief
+ * @brief Defines the system under test that sends loadgen's queries to the
+ * inference server
  */
 
 #ifndef GUARD_MLCOMMONS_SRC_SYSTEM_UNDER_TEST
 #define GUARD_MLCOMMONS_SRC_SYSTEM_UNDER_TEST
 
 #include <concurrentqueue/blockingconcurrentqueue.h>
+#include <query_sample.h>
 #include <system_under_test.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "amdinfer/amdinfer.hpp"
 
 namespace amdinfer {
 
 class QuerySampleLibrary;
 
+struct SystemUnderTestOptions {
+  /// number of threads that wait for responses and report them to loadgen
+  size_t completion_threads = 1;
+  /// maximum number of samples sent to the server and not yet completed. If
+  /// 0, there's no limit
+  size_t max_in_flight = 0;
+  /// deadline in ms to attach to each request so the batchers send partial
+  /// batches early enough to meet it. If 0, no deadline is set
+  int deadline_ms = 0;
+};
+
 class SystemUnderTest : public mlperf::SystemUnderTest {
  public:
   SystemUnderTest(QuerySampleLibrary* qsl, Client* client,
-                  std::string endpoint);
-
-  // void execBatch(std::vector<mlperf::QuerySample> batch);
-
-  ~SystemUnderTest() noexcept override = default;
+                  std::string endpoint,
+                  const SystemUnderTestOptions& options = {});
+  SystemUnderTest(SystemUnderTest const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  SystemUnderTest& operator=(const SystemUnderTest&) = delete;
+  SystemUnderTest(SystemUnderTest&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  SystemUnderTest& operator=(SystemUnderTest&& other) = delete;
+  ~SystemUnderTest() override;
 
   const std::string& Name() const override;
 
+  /**
+   * @brief Send each sample as a request. If the in-flight limit is reached,
+   * this blocks until earlier samples complete
+   *
+   * @param samples the samples to send
+   */
   void IssueQuery(const std::vector<mlperf::QuerySample>& samples) override;
 
-  [[noreturn]] void FinishQuery();
-
   void FlushQueries() override;
 
   void ReportLatencyResults(
     const std::vector<mlperf::QuerySampleLatency>& latencies_ns) override;
 
  private:
+  struct PendingSample {
+    mlperf::ResponseId id;
+    InferenceResponseFuture future;
+  };
+
+  /// Wait for responses and report them to loadgen in batches until stopped
+  void complete();
+  void acquire(size_t count);
+  void release(size_t count);
+
   std::string name_{"AMD Inference Server"};
   QuerySampleLibrary* qsl_;
   Client* client_;
   std::string endpoint_;
-  moodycamel::BlockingConcurrentQueue<InferenceResponseFuture> queue_;
+  SystemUnderTestOptions options_;
+  moodycamel::BlockingConcurrentQueue<PendingSample> queue_;
+
+  std::mutex in_flight_mutex_;
+  std::condition_variable in_flight_cv_;
+  size_t in_flight_ = 0;
+
+  std::atomic<bool> running_ = true;
+  std::vector<std::thread> threads_;
 };
 
 }  // namespace amdinfer
@@ -69,3 +69,43 @@ function(amdinfer_add_targets targets target_objects base_targets
   set(${targets} ${new_targets} PARENT_SCOPE)
   set(${target_objects} ${new_target_objects} PARENT_SCOPE)
 endfunction()
+
+# Compile a file once for each instruction set that kernels are selected from
+# at runtime with util::selectKernel so one build runs well on every CPU. Each
+# copy defines AMDINFER_ISA as the name of its instruction set, which the file
+# uses as the namespace of its kernels. Only the baseline is compiled for
+# other architectures.
+function(amdinfer_add_isa_targets targets target_objects file)
+  set(isas scalar)
+  if(CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64")
+    list(APPEND isas avx2 avx512)
+  endif()
+  set(flags_scalar "")
+  set(flags_avx2 -mavx2 -mfma -mf16c)
+  set(flags_avx512 ${flags_avx2} -mavx512f -mavx512bw -mavx512dq -mavx512vl)
+
+  set(new_targets "")
+  foreach(isa ${isas})
+    set(target ${file}_${isa})
+    amdinfer_add_object_library(${target} ${file})
+    target_compile_definitions(${target} PRIVATE AMDINFER_ISA=${isa})
+    # code compiled for newer instructions must not be merged into the rest
+    # of the program, which may run on CPUs without them, so these aren't
+    # linked with IPO and are optimized in every build type so the inline
+    # functions they use from headers are inlined instead of shared
+    set_property(TARGET ${target} PROPERTY INTERPROCEDURAL_OPTIMIZATION OFF)
+    target_compile_options(${target} PRIVATE ${flags_${isa}} -O3)
+    list(APPEND new_targets ${target})
+  endforeach()
+
+  set(new_target_objects ${new_targets})
+  list(
+    TRANSFORM new_target_objects
+              REPLACE
+              "^(.+)$"
+              "$<TARGET_OBJECTS:\\1>"
+  )
+
+  set(${targets} ${new_targets} PARENT_SCOPE)
+  set(${target_objects} ${new_target_objects} PARENT_SCOPE)
+endfunction()
@@ -511,8 +511,9 @@ def install_dev_packages(manager: PackageManager, core):
             graphviz \\
             # used to turn absolute symlinks into relative ones
             symlinks \\
-            # used for z compression
+            # used for z and zstd compression
             zlib1g-dev \\
+            libzstd-dev \\
             # used by drogon. It needs the -dev versions to pass Cmake
             libbrotli-dev \\
             libssl-dev \\
@@ -554,8 +555,9 @@ def install_dev_packages(manager: PackageManager, core):
             graphviz \\
             # used to turn absolute symlinks into relative ones
             symlinks \\
-            # used for z compression
+            # used for z and zstd compression
             zlib-devel \\
+            libzstd-devel \\
             # used by drogon. It needs the -dev versions to pass Cmake
             brotli-devel \\
             openssl-devel \\
@@ -85,6 +85,12 @@ def parse_args():
         help="Port to use for gRPC server",
     )
 
+    parser.add_argument(
+        "--server-side",
+        action="store_true",
+        help="Decode, letterbox and postprocess the images on the server",
+    )
+
     parser.add_argument(
         "--endpoint",
         default="",
@@ -29,12 +29,14 @@ struct Array {
 int yolov2_postproc(Array* output_tensors, int nArrays, const float* biases,
                     int net_h, int net_w, int classes, int anchor_cnt,
                     int img_height, int img_width, float conf_thresh,
-                    float iou_thresh, int batch_idx, float** retboxes);
+                    float iou_thresh, int nhwc, int batch_idx,
+                    float** retboxes);
 
 int yolov3_postproc(Array* output_tensors, int nArrays, const float* biases,
                     int net_h, int net_w, int classes, int anchorCnt,
                     int img_height, int img_width, float conf_thresh,
-                    float iou_thresh, int batch_idx, float** retboxes);
+                    float iou_thresh, int nhwc, int batch_idx,
+                    float** retboxes);
 
 void clearBuffer(float* buf);
 
@@ -69,40 +69,6 @@ int YoloPostProc::exec_async(std::vector<vart::TensorBuffer*>& in,
                              std::vector<vart::TensorBuffer*>& out,
                              AKS::NodeParams* nodeParams,
                              AKS::DynamicParamValues* dynParams) {
-  std::vector<unique_ptr<vart::TensorBuffer>> inputLocal;
-  if (_inputLayout == "NHWC") {
-    for (int i = 0; i < in.size(); ++i) {
-      const auto* tensor = in[i]->get_tensor();
-      auto batch = tensor->get_shape()[0];
-      auto height = tensor->get_shape()[1];
-      auto width = tensor->get_shape()[2];
-      auto channel = tensor->get_shape()[3];
-
-      auto input_local = std::make_unique<AKS::AksTensorBuffer>(
-        xir::Tensor::create("local", {batch, channel, height, width},
-                            xir::create_data_type<float>()));
-
-      int sizesksrbv = height * width * channel;
-
-      for (int b = 0; b < batch; ++b) {
-        float* ldata =
-          reinterpret_cast<float*>(input_local->data({b, 0, 0, 0}).first);
-        float* rdata =
-          reinterpret_cast<float*>(in[i]->data({b, 0, 0, 0}).first);
-
-        for (int c = 0; c < channel; ++c) {
-          for (int h = 0; h < height; ++h) {
-            for (int w = 0; w < width; ++w) {
-              ldata[c * height * width + h * width + w] =
-                rdata[h * width * channel + w * channel + c];
-            }
-          }
-        }
-      }
-      inputLocal.push_back(std::move(input_local));
-    }
-  }
-
   // Get original image dimensions
   std::vector<int>& imgShape = dynParams->_intVectorParams.at("img_dims");
   int batchSize = in[0]->get_tensor()->get_shape()[0];
@@ -115,24 +81,16 @@ int YoloPostProc::exec_async(std::vector<vart::TensorBuffer*>& in,
 
     // 2...N inputs are coming from previous kernel (either Caffe or fpga)
     int nArrays = in.size();
+    // the postprocessing reads either layout so outputs are used in place
+    const bool nhwc = _inputLayout == "NHWC";
     std::vector<Array> inputArrays;
-    if (_inputLayout == "NHWC") {
-      for (int i = 0; i < nArrays; ++i) {
-        auto inDD = inputLocal[i].get();
-        auto& shape = inDD->get_tensor()->get_shape();
-        int nelems = shape[1] * shape[2] * shape[3];
-        inputArrays.push_back(
-          {shape[2], shape[3], shape[1],
-           reinterpret_cast<float*>(inDD->data({b, 0, 0, 0}).first)});
-      }
-    } else {
-      for (int i = 0; i < nArrays; ++i) {
-        auto inDD = in[i];
-        auto& shape = inDD->get_tensor()->get_shape();
-        int nelems = shape[1] * shape[2] * shape[3];
-        inputArrays.push_back(
-          {shape[2], shape[3], shape[1],
-           reinterpret_cast<float*>(inDD->data({b, 0, 0, 0}).first)});
+    for (int i = 0; i < nArrays; ++i) {
+      auto& shape = in[i]->get_tensor()->get_shape();
+      auto* data = reinterpret_cast<float*>(in[i]->data({b, 0, 0, 0}).first);
+      if (nhwc) {
+        inputArrays.push_back({shape[1], shape[2], shape[3], data});
+      } else {
+        inputArrays.push_back({shape[2], shape[3], shape[1], data});
       }
     }
 
@@ -141,7 +99,7 @@ int YoloPostProc::exec_async(std::vector<vart::TensorBuffer*>& in,
 
     int nboxes = func(inputArrays.data(), nArrays, _biases.data(), _net_h,
                       _net_w, _num_classes, _anchor_cnt, img_h, img_w,
-                      _conf_thresh, _iou_thresh, b, &boxes);
+                      _conf_thresh, _iou_thresh, nhwc, b, &boxes);
 
     results.emplace_back(nboxes, boxes);
   }
@@ -0,0 +1,193 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the C API for embedding the server in a process. It wraps
+ * the Server and NativeClient classes in opaque handles so applications in
+ * other languages can call it without depending on the C++ ABI. Functions
+ * that can fail return a status and amdinfer_last_error() describes the last
+ * failure on the calling thread.
+ */
+
+#ifndef GUARD_AMDINFER_AMDINFER_H
+#define GUARD_AMDINFER_AMDINFER_H
+
+#include <stdbool.h>  // NOLINT(modernize-deprecated-headers)
+#include <stddef.h>   // NOLINT(modernize-deprecated-headers)
+#include <stdint.h>   // NOLINT(modernize-deprecated-headers)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version of the C API. It changes only if existing functions change
+#define AMDINFER_C_API_VERSION 1
+
+typedef enum amdinfer_status {
+  AMDINFER_OK = 0,
+  /// An argument, such as a null handle or an unknown model, is invalid
+  AMDINFER_INVALID_ARGUMENT = 1,
+  /// The server or the model has no room for the request
+  AMDINFER_RESOURCE_EXHAUSTED = 2,
+  /// Any other failure
+  AMDINFER_ERROR = 3
+} amdinfer_status;
+
+typedef struct amdinfer_server amdinfer_server;
+typedef struct amdinfer_client amdinfer_client;
+typedef struct amdinfer_parameters amdinfer_parameters;
+typedef struct amdinfer_request amdinfer_request;
+typedef struct amdinfer_response amdinfer_response;
+
+/// A view of an output tensor. Its pointers belong to the response
+typedef struct amdinfer_tensor {
+  const char* name;
+  /// KServe name of the datatype, such as "FP32"
+  const char* datatype;
+  const int64_t* shape;
+  size_t dims;
+  const void* data;
+  /// size of the data in bytes
+  size_t size;
+} amdinfer_tensor;
+
+/**
+ * @brief Called with the final response to an asynchronous request. The
+ * response is only valid until the callback returns. The callback runs on the
+ * server's thread that finished the request so it should return quickly.
+ */
+typedef void (*amdinfer_callback)(const amdinfer_response* response,
+                                  void* user_data);
+
+/// Get AMDINFER_C_API_VERSION of the library
+int amdinfer_api_version(void);
+/// Get the description of the last failure on the calling thread
+const char* amdinfer_last_error(void);
+
+/// Start a server in this process. It serves no HTTP or gRPC clients
+amdinfer_status amdinfer_server_create(amdinfer_server** server);
+/// Stop a server. Its clients must be destroyed first
+void amdinfer_server_destroy(amdinfer_server* server);
+/// Set the model repository that model_load loads models from
+amdinfer_status amdinfer_server_set_model_repository(amdinfer_server* server,
+                                                     const char* path,
+                                                     bool load_existing);
+
+/// Make a client that calls a server in this process directly
+amdinfer_status amdinfer_client_create(const amdinfer_server* server,
+                                       amdinfer_client** client);
+void amdinfer_client_destroy(amdinfer_client* client);
+
+amdinfer_status amdinfer_parameters_create(amdinfer_parameters** parameters);
+void amdinfer_parameters_destroy(amdinfer_parameters* parameters);
+amdinfer_status amdinfer_parameters_put_bool(amdinfer_parameters* parameters,
+                                             const char* key, bool value);
+amdinfer_status amdinfer_parameters_put_int32(amdinfer_parameters* parameters,
+                                              const char* key, int32_t value);
+amdinfer_status amdinfer_parameters_put_double(
+  amdinfer_parameters* parameters, const char* key, double value);
+amdinfer_status amdinfer_parameters_put_string(
+  amdinfer_parameters* parameters, const char* key, const char* value);
+
+// In the following, a null or empty version means the default version and
+// null parameters mean no parameters.
+
+/// Load a model from the model repository
+amdinfer_status amdinfer_model_load(const amdinfer_client* client,
+                                    const char* model, const char* version,
+                                    const amdinfer_parameters* parameters);
+amdinfer_status amdinfer_model_unload(const amdinfer_client* client,
+                                      const char* model, const char* version);
+amdinfer_status amdinfer_model_ready(const amdinfer_client* client,
+                                     const char* model, const char* version,
+                                     bool* ready);
+/**
+ * @brief Load a worker and get the endpoint to make requests to. If the
+ * endpoint doesn't fit in the buffer, this fails but the worker stays loaded
+ */
+amdinfer_status amdinfer_worker_load(const amdinfer_client* client,
+                                     const char* worker,
+                                     const amdinfer_parameters* parameters,
+                                     char* endpoint, size_t endpoint_size);
+amdinfer_status amdinfer_worker_unload(const amdinfer_client* client,
+                                       const char* worker);
+
+amdinfer_status amdinfer_request_create(amdinfer_request** request);
+void amdinfer_request_destroy(amdinfer_request* request);
+amdinfer_status amdinfer_request_set_id(amdinfer_request* request,
+                                        const char* id);
+amdinfer_status amdinfer_request_set_parameters(
+  amdinfer_request* request, const amdinfer_parameters* parameters);
+/**
+ * @brief Add an input tensor. The data is the caller's and isn't copied: it
+ * must stay alive and unchanged until the request's response is returned or
+ * passed to the callback.
+ *
+ * @param request the request
+ * @param name name of the input
+ * @param shape shape of the input
+ * @param dims number of dimensions in the shape
+ * @param datatype KServe name of the datatype, such as "FP32"
+ * @param data the input's data
+ * @return amdinfer_status
+ */
+amdinfer_status amdinfer_request_add_input(amdinfer_request* request,
+                                           const char* name,
+                                           const int64_t* shape, size_t dims,
+                                           const char* datatype, void* data);
+/// Request an output by name. By default, all outputs are returned
+amdinfer_status amdinfer_request_add_output(amdinfer_request* request,
+                                            const char* name);
+
+/**
+ * @brief Make an asynchronous inference request. The request can be reused or
+ * destroyed once this returns but its inputs' data can't. If this fails, the
+ * callback isn't called.
+ *
+ * @param client the client
+ * @param model the endpoint to make the request to
+ * @param version the version of the model
+ * @param request the request
+ * @param callback called with the final response
+ * @param user_data passed to the callback
+ * @return amdinfer_status
+ */
+amdinfer_status amdinfer_infer_async(const amdinfer_client* client,
+                                     const char* model, const char* version,
+                                     const amdinfer_request* request,
+                                     amdinfer_callback callback,
+                                     void* user_data);
+/// Make a synchronous inference request. Destroy the response when done
+amdinfer_status amdinfer_infer(const amdinfer_client* client,
+                               const char* model, const char* version,
+                               const amdinfer_request* request,
+                               amdinfer_response** response);
+
+/// Destroy a response returned by amdinfer_infer
+void amdinfer_response_destroy(amdinfer_response* response);
+const char* amdinfer_response_id(const amdinfer_response* response);
+/// Get the reason the request failed or null if it succeeded
+const char* amdinfer_response_error(const amdinfer_response* response);
+size_t amdinfer_response_output_count(const amdinfer_response* response);
+/// Get a view of an output. Its data isn't copied
+amdinfer_status amdinfer_response_output(const amdinfer_response* response,
+                                         size_t index,
+                                         amdinfer_tensor* tensor);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // GUARD_AMDINFER_AMDINFER_H
@@ -18,8 +18,10 @@
 
 // IWYU pragma: begin_exports
 #include "amdinfer/build_options.hpp"
+#include "amdinfer/clients/batching.hpp"
 #include "amdinfer/clients/grpc.hpp"
 #include "amdinfer/clients/http.hpp"
+#include "amdinfer/clients/load_balancing.hpp"
 #include "amdinfer/clients/native.hpp"
 #include "amdinfer/core/data_types.hpp"
 #include "amdinfer/core/exceptions.hpp"
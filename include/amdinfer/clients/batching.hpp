@@ -0,0 +1,132 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a client that merges concurrent inference requests
+ */
+
+#ifndef GUARD_AMDINFER_CLIENTS_BATCHING
+#define GUARD_AMDINFER_CLIENTS_BATCHING
+
+#include <chrono>   // for microseconds
+#include <cstddef>  // for size_t
+#include <memory>   // for unique_ptr
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/clients/client.hpp"  // IWYU pragma: export
+#include "amdinfer/declarations.hpp"    // for InferenceResponseFuture
+
+namespace amdinfer {
+
+class ParameterMap;
+
+/// Options for how a BatchingClient merges requests
+struct ClientBatchingOptions {
+  /// Most samples, counted along the first dimension, in a merged request
+  size_t max_batch_size = 32;
+  /// Longest time to wait for more requests after the first one arrives
+  std::chrono::microseconds timeout{1000};
+};
+
+/**
+ * @brief The BatchingClient wraps another client and merges inference requests
+ * that are made to the same model at about the same time into one request. The
+ * inputs of the merged requests are concatenated along their first dimension,
+ * the merged request is sent with the wrapped client and its outputs are split
+ * back along the first dimension into a response for each request. The split
+ * outputs view the merged response rather than copying it.
+ *
+ * Requests are merged if they have no parameters and their inputs have the
+ * same names, datatypes and shapes after the first dimension. Other requests,
+ * including ones with BYTES inputs, are sent on their own. The model must
+ * return outputs whose first dimension matches that of its inputs.
+ *
+ * @details Usage:
+ *
+ * GrpcClient grpc_client{"127.0.0.1:50051"};
+ * BatchingClient client{&grpc_client};
+ * // requests made from many threads are merged
+ * auto future = client.modelInferAsync("model", request);
+ */
+class BatchingClient : public Client {
+ public:
+  /**
+   * @brief Construct a new BatchingClient object
+   *
+   * @param client the client to send merged requests with. It must outlive
+   * this client
+   * @param options how requests are merged
+   */
+  explicit BatchingClient(const Client* client,
+                          const ClientBatchingOptions& options = {});
+
+  /// Copy constructor
+  BatchingClient(BatchingClient const&) = delete;
+  /// Copy assignment constructor
+  BatchingClient& operator=(const BatchingClient&) = delete;
+  /// Move constructor
+  BatchingClient(BatchingClient&& other) = default;
+  /// Move assignment constructor
+  BatchingClient& operator=(BatchingClient&& other) = default;
+  /**
+   * @brief Destructor. Requests waiting to be merged are sent and their
+   * responses are received before it returns.
+   */
+  ~BatchingClient() override;
+
+  /// Returns the server metadata from the wrapped client
+  [[nodiscard]] ServerMetadata serverMetadata() const override;
+  /// Checks if the server is live with the wrapped client
+  [[nodiscard]] bool serverLive() const override;
+  /// Checks if the server is ready with the wrapped client
+  [[nodiscard]] bool serverReady() const override;
+  /// Gets the models on the server with the wrapped client
+  [[nodiscard]] std::vector<std::string> modelList() const override;
+  /// Loads a worker with the wrapped client
+  [[nodiscard]] std::string workerLoad(
+    const std::string& worker, const ParameterMap& parameters) const override;
+  /// Unloads a worker with the wrapped client
+  void workerUnload(const std::string& worker) const override;
+  /// Checks for hardware on the server with the wrapped client
+  [[nodiscard]] bool hasHardware(const std::string& name,
+                                 int num) const override;
+
+ private:
+  class BatchingClientImpl;
+  std::unique_ptr<BatchingClientImpl> impl_;
+
+  [[nodiscard]] bool modelReadyImpl(const std::string& model,
+                                    const std::string& version) const override;
+  [[nodiscard]] ModelMetadata modelMetadataImpl(
+    const std::string& model, const std::string& version) const override;
+  void modelLoadImpl(const std::string& model, const ParameterMap& parameters,
+                     const std::string& version) const override;
+  void modelUnloadImpl(const std::string& model,
+                       const std::string& version) const override;
+  /// Makes an inference request, which may be merged with others, and waits
+  /// for its response
+  [[nodiscard]] InferenceResponse modelInferImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override;
+  /// Makes an inference request, which may be merged with others
+  [[nodiscard]] InferenceResponseFuture modelInferAsyncImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CLIENTS_BATCHING
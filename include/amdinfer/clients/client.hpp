@@ -21,6 +21,7 @@
 #ifndef GUARD_AMDINFER_CLIENTS_CLIENT
 #define GUARD_AMDINFER_CLIENTS_CLIENT
 
+#include <chrono>   // for microseconds
 #include <cstddef>  // for size_t
 #include <string>   // for string
 #include <vector>   // for vector
@@ -309,10 +310,45 @@ std::vector<InferenceResponse> inferAsyncOrdered(
   const Client* client, const std::string& model,
   const std::vector<InferenceRequest>& requests,
   const std::string& version = "");
+/// Controls how many requests inferAsyncOrderedWindowed keeps in flight
+struct InferWindow {
+  /// Most requests to keep in flight at once
+  size_t max_in_flight = 64;
+  /**
+   * @brief Adapt the window to the server: it starts at one request and grows
+   * by one for each window of responses that come back within the target
+   * latency. It's halved, at most once per window, when a response is slower
+   * than the target or is an error.
+   */
+  bool adaptive = false;
+  /**
+   * @brief With adaptive windows, responses slower than this shrink the window.
+   * If zero, twice the lowest latency seen so far is used
+   */
+  std::chrono::microseconds target_latency{0};
+};
+
+/**
+ * @brief Makes inference requests to the specified model through a sliding
+ * window. Up to the window's size of requests are in flight at once and
+ * another request is sent as each response arrives so the server is neither
+ * flooded nor left idle. The responses are returned in the same order as the
+ * requests.
+ *
+ * @param client a pointer to a client object
+ * @param model the model/worker to make inference requests to
+ * @param requests a vector of requests
+ * @param window the size of the window and how it adapts
+ * @return std::vector<InferenceResponse>
+ */
+std::vector<InferenceResponse> inferAsyncOrderedWindowed(
+  const Client* client, const std::string& model,
+  const std::vector<InferenceRequest>& requests, const InferWindow& window,
+  const std::string& version = "");
 /**
- * @brief Makes inference requests in parallel to the specified model in
- * batches. Each batch of requests are gathered and the responses are added to a
- * vector. Once all the responses are received, the response vector is returned.
+ * @brief Makes inference requests in parallel to the specified model with at
+ * most batch_size requests in flight at once. This is a fixed-size
+ * inferAsyncOrderedWindowed.
  *
  * @param client a pointer to a client object
  * @param model the model/worker to make inference requests to
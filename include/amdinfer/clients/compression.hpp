@@ -0,0 +1,56 @@
+// Copyright 2022 Xilinx, Inc.
+// Copyright 2022 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/**
+ * @file
+ * @brief Defines the options for compressing the payloads of clients
+ */
+
+#ifndef GUARD_AMDINFER_CLIENTS_COMPRESSION
+#define GUARD_AMDINFER_CLIENTS_COMPRESSION
+
+#include <cstddef>  // for size_t
+
+namespace amdinfer {
+
+/// Algorithms that clients can compress payloads with
+enum class CompressionAlgorithm {
+  /// no compression
+  Identity,
+  /// zlib-wrapped deflate
+  Deflate,
+  Gzip,
+  Zstd
+};
+
+/**
+ * @brief Options for compressing inference requests and responses. Clients
+ * that use an algorithm also tell the server that they accept it so large
+ * responses are compressed with it too. It's worth it when bandwidth costs
+ * more than the time spent compressing, e.g. for large tensors sent between
+ * data centers.
+ */
+struct CompressionOptions {
+  /**
+   * @brief Algorithm to compress with. gRPC doesn't support zstd so gRPC
+   * clients use gzip instead
+   */
+  CompressionAlgorithm algorithm = CompressionAlgorithm::Identity;
+  /// Requests smaller than this many bytes aren't worth compressing
+  size_t threshold = 1024;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CLIENTS_COMPRESSION
@@ -21,12 +21,16 @@
 #ifndef GUARD_AMDINFER_CLIENTS_GRPC
 #define GUARD_AMDINFER_CLIENTS_GRPC
 
-#include <memory>  // for shared_ptr, unique_ptr
-#include <string>  // for string
-#include <vector>  // for vector
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t, uint64_t
+#include <memory>   // for shared_ptr, unique_ptr
+#include <string>   // for string
+#include <vector>   // for vector
 
-#include "amdinfer/clients/client.hpp"  // IWYU pragma: export
-#include "amdinfer/declarations.hpp"    // for InferenceResponseFuture
+#include "amdinfer/clients/client.hpp"       // IWYU pragma: export
+#include "amdinfer/clients/compression.hpp"  // IWYU pragma: export
+#include "amdinfer/core/shared_memory.hpp"   // for SharedMemoryStatus
+#include "amdinfer/declarations.hpp"         // for InferenceResponseFuture
 
 namespace grpc {
 class Channel;
@@ -36,6 +40,75 @@ namespace amdinfer {
 
 class ParameterMap;
 
+/**
+ * @brief A bidirectional gRPC stream for making many inference requests to one
+ * model. Requests are sent without waiting for earlier ones to finish and
+ * responses are matched back to their requests by ID as they arrive, in any
+ * order. Requests without an ID are given one. Use
+ * GrpcClient::modelInferStream to open a stream.
+ */
+class GrpcStream {
+ public:
+  /// Copy constructor
+  GrpcStream(GrpcStream const&) = delete;
+  /// Copy assignment constructor
+  GrpcStream& operator=(const GrpcStream&) = delete;
+  /// Move constructor
+  GrpcStream(GrpcStream&& other) noexcept;
+  /// Move assignment constructor
+  GrpcStream& operator=(GrpcStream&& other) noexcept;
+  /// Destructor. Closes the stream if it's still open
+  ~GrpcStream();
+
+  /**
+   * @brief Sends an inference request on the stream. The ID of the request
+   * must not be the same as another request on the stream that's waiting for
+   * its response.
+   *
+   * @param request the request
+   * @return InferenceResponseFuture - raises bad_status if the request failed
+   */
+  [[nodiscard]] InferenceResponseFuture modelInfer(
+    const InferenceRequest& request);
+  /**
+   * @brief Sends an inference request on the stream and runs the callback with
+   * its response. The callback runs on the thread reading the stream so it
+   * should return quickly. Failures are passed to it as error responses.
+   *
+   * @param request the request
+   * @param callback the callback to run with the response
+   */
+  void modelInfer(const InferenceRequest& request, Callback callback);
+  /**
+   * @brief Closes the stream after waiting for the responses to all the
+   * requests sent on it
+   */
+  void close();
+
+ private:
+  friend class GrpcClient;
+  class GrpcStreamImpl;
+  explicit GrpcStream(std::unique_ptr<GrpcStreamImpl> impl);
+
+  std::unique_ptr<GrpcStreamImpl> impl_;
+};
+
+/// Options for how a GrpcClient connects to the server
+struct GrpcClientOptions {
+  /**
+   * @brief Number of channels to spread inference requests over. Each channel
+   * opens its own connection so requests aren't limited by the head-of-line
+   * blocking of a single HTTP/2 connection
+   */
+  int channels = 1;
+  /// Number of threads that finish asynchronous inference requests
+  int threads = 2;
+  /// Reuse the channels of other GrpcClients with the same address and options
+  bool share_channels = true;
+  /// How to compress inference requests and responses
+  CompressionOptions compression;
+};
+
 /**
  * @brief The GrpcClient class implements the Client using gRPC
  *
@@ -52,9 +125,20 @@ class GrpcClient : public Client {
   /**
    * @brief Constructs a new GrpcClient object
    *
-   * @param address Address of the server to connect to
+   * @param address Address of the server to connect to, such as
+   * "127.0.0.1:50051" or "unix:/tmp/amdinfer.sock" for a server's Unix domain
+   * socket
    */
   explicit GrpcClient(const std::string& address);
+  /**
+   * @brief Constructs a new GrpcClient object
+   *
+   * @param address Address of the server to connect to, such as
+   * "127.0.0.1:50051" or "unix:/tmp/amdinfer.sock" for a server's Unix domain
+   * socket
+   * @param options the channels and threads to use
+   */
+  GrpcClient(const std::string& address, const GrpcClientOptions& options);
   /**
    * @brief Constructs a new GrpcClient object
    *
@@ -133,6 +217,97 @@ class GrpcClient : public Client {
   [[nodiscard]] bool hasHardware(const std::string& name,
                                  int num) const override;
 
+  /**
+   * @brief Changes the batch size or timeout of a loaded model without
+   * reloading it. The new values apply from the model's next batch and the
+   * batch size can't be larger than the one it was loaded with
+   *
+   * @param model name of the model to update
+   * @param parameters the new batch_size and/or timeout
+   * @param version version of the model to update
+   */
+  void modelUpdate(const std::string& model, const ParameterMap& parameters,
+                   const std::string& version = "") const;
+
+  /**
+   * @brief Registers a region of a system shared memory object with the server.
+   * Inputs and outputs of later requests can use the region with
+   * useSharedMemory instead of sending their data. The server must be on the
+   * same host
+   *
+   * @param name name of the region
+   * @param key key of the shared memory object, as given to shm_open
+   * @param byte_size size of the region in bytes
+   * @param offset offset of the region in the shared memory object
+   */
+  void registerSystemSharedMemory(const std::string& name,
+                                  const std::string& key, size_t byte_size,
+                                  size_t offset = 0) const;
+  /**
+   * @brief Unregisters a region of system shared memory
+   *
+   * @param name name of the region or empty to unregister all of them
+   */
+  void unregisterSystemSharedMemory(const std::string& name = "") const;
+  /**
+   * @brief Connects an RDMA queue pair to one of the server's. The server
+   * then reads inputs from and writes outputs to regions registered with
+   * registerRdma over it
+   *
+   * @param session name of the session
+   * @param endpoint the serialized RdmaEndpoint of the local queue pair
+   * @return std::string the serialized RdmaEndpoint of the server's queue pair
+   */
+  std::string rdmaConnect(const std::string& session,
+                          const std::string& endpoint) const;
+  /**
+   * @brief Registers a region of local memory registered for RDMA as a shared
+   * memory region of the server. Requests refer to it like to regions of
+   * system shared memory
+   *
+   * @param name name of the region
+   * @param session the connected session that reaches the region
+   * @param address address of the region
+   * @param key remote key of the memory registration
+   * @param byte_size size of the region in bytes
+   */
+  void registerRdma(const std::string& name, const std::string& session,
+                    uint64_t address, uint32_t key, size_t byte_size) const;
+  /**
+   * @brief Gets the status of the registered regions of system shared memory
+   *
+   * @param name name of the region or empty to get all of them
+   * @return std::vector<SharedMemoryStatus>
+   */
+  [[nodiscard]] std::vector<SharedMemoryStatus> systemSharedMemoryStatus(
+    const std::string& name = "") const;
+
+  /**
+   * @brief Opens a bidirectional stream to make inference requests to the given
+   * model/worker with lower overhead per request than making separate calls
+   *
+   * @param model name of the model/worker to request inference to
+   * @param version version of the model. If empty, the server chooses
+   * @return GrpcStream
+   */
+  [[nodiscard]] GrpcStream modelInferStream(
+    const std::string& model, const std::string& version = "") const;
+
+  using Client::modelInferAsync;
+  /**
+   * @brief Makes an asynchronous inference request and runs the callback with
+   * its response. The callback runs on one of the client's threads so it
+   * should return quickly. Failures are passed to it as error responses.
+   *
+   * @param model name of the model/worker to request inference to
+   * @param request the request
+   * @param callback the callback to run with the response
+   * @param version version of the model. If empty, the server chooses
+   */
+  void modelInferAsync(const std::string& model,
+                       const InferenceRequest& request, Callback callback,
+                       const std::string& version = "") const;
+
  private:
   class GrpcClientImpl;
   std::unique_ptr<GrpcClientImpl> impl_;
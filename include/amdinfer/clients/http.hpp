@@ -21,17 +21,36 @@
 #ifndef GUARD_AMDINFER_CLIENTS_HTTP
 #define GUARD_AMDINFER_CLIENTS_HTTP
 
-#include <memory>  // for unique_ptr
-#include <string>  // for string
-#include <vector>  // for vector
+#include <chrono>   // for microseconds
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t
+#include <memory>   // for unique_ptr
+#include <string>   // for string
+#include <vector>   // for vector
 
-#include "amdinfer/clients/client.hpp"  // IWYU pragma: export
-#include "amdinfer/declarations.hpp"    // for StringMap
+#include "amdinfer/clients/client.hpp"       // IWYU pragma: export
+#include "amdinfer/clients/compression.hpp"  // IWYU pragma: export
+#include "amdinfer/core/shared_memory.hpp"   // for SharedMemoryStatus
+#include "amdinfer/declarations.hpp"         // for StringMap
 
 namespace amdinfer {
 
 class ParameterMap;
 
+/// Statistics about one of the connections an HttpClient sends requests on
+struct ConnectionStats {
+  /// Requests sent on the connection that haven't finished
+  int in_flight = 0;
+  /// Moving average of the latency of successful requests
+  std::chrono::microseconds latency{0};
+  /// Requests that have finished on the connection
+  uint64_t requests = 0;
+  /// Requests that failed because of the connection
+  uint64_t failures = 0;
+  /// False if the connection failed or stalled and is waiting to reconnect
+  bool healthy = true;
+};
+
 /**
  * @brief The HttpClient class implements the Client using HTTP REST
  *
@@ -45,6 +64,9 @@ class ParameterMap;
  */
 class HttpClient : public Client {
  public:
+  /// Default max number of connections to the server
+  static constexpr int kDefaultParallelism = 32;
+
   /**
    * @brief Construct a new HttpClient object
    *
@@ -57,10 +79,15 @@ class HttpClient : public Client {
    * @param address Address of the server to connect to
    * @param headers Key-value pairs that should be added to the HTTP headers for
    * all requests
-   * @param parallelism Max number of requests that can be sent in parallel
+   * @param parallelism Max number of connections to the server and so the max
+   * number of requests that can be sent in parallel. The client starts with
+   * one connection and opens more as requests wait on the busy ones
+   * @param compression how to compress the bodies of inference requests and
+   * responses
    */
   HttpClient(const std::string& address, const StringMap& headers,
-             int parallelism);
+             int parallelism = kDefaultParallelism,
+             const CompressionOptions& compression = {});
 
   /// Copy constructor
   HttpClient(HttpClient const&) = delete;
@@ -133,6 +160,55 @@ class HttpClient : public Client {
   [[nodiscard]] bool hasHardware(const std::string& name,
                                  int num) const override;
 
+  /**
+   * @brief Changes the batch size or timeout of a loaded model without
+   * reloading it. The new values apply from the model's next batch and the
+   * batch size can't be larger than the one it was loaded with
+   *
+   * @param model name of the model to update
+   * @param parameters the new batch_size and/or timeout
+   * @param version version of the model to update
+   */
+  void modelUpdate(const std::string& model, const ParameterMap& parameters,
+                   const std::string& version = "") const;
+
+  /**
+   * @brief Registers a region of a system shared memory object with the server.
+   * Inputs and outputs of later requests can use the region with
+   * useSharedMemory instead of sending their data. The server must be on the
+   * same host
+   *
+   * @param name name of the region
+   * @param key key of the shared memory object, as given to shm_open
+   * @param byte_size size of the region in bytes
+   * @param offset offset of the region in the shared memory object
+   */
+  void registerSystemSharedMemory(const std::string& name,
+                                  const std::string& key, size_t byte_size,
+                                  size_t offset = 0) const;
+  /**
+   * @brief Unregisters a region of system shared memory
+   *
+   * @param name name of the region or empty to unregister all of them
+   */
+  void unregisterSystemSharedMemory(const std::string& name = "") const;
+  /**
+   * @brief Gets the status of the registered regions of system shared memory
+   *
+   * @param name name of the region or empty to get all of them
+   * @return std::vector<SharedMemoryStatus>
+   */
+  [[nodiscard]] std::vector<SharedMemoryStatus> systemSharedMemoryStatus(
+    const std::string& name = "") const;
+
+  /**
+   * @brief Get statistics about the client's active connections to the server.
+   * Requests go to the healthy connection with the fewest requests in flight
+   *
+   * @return std::vector<ConnectionStats>
+   */
+  [[nodiscard]] std::vector<ConnectionStats> connectionStats() const;
+
  private:
   class HttpClientImpl;
   std::unique_ptr<HttpClientImpl> impl_;
@@ -0,0 +1,154 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a client that spreads requests over many servers
+ */
+
+#ifndef GUARD_AMDINFER_CLIENTS_LOAD_BALANCING
+#define GUARD_AMDINFER_CLIENTS_LOAD_BALANCING
+
+#include <chrono>   // for milliseconds, microseconds
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t
+#include <memory>   // for unique_ptr
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/clients/client.hpp"  // IWYU pragma: export
+#include "amdinfer/declarations.hpp"    // for InferenceResponseFuture
+
+namespace amdinfer {
+
+class ParameterMap;
+
+/// Options for how a LoadBalancingClient picks and checks its backends
+struct LoadBalancingOptions {
+  /// Time between checks of whether the backends and their models are ready
+  std::chrono::milliseconds health_interval{1000};
+  /**
+   * @brief Send a second copy of a request to another backend if it takes
+   * longer than this percentile of recent latencies, in (0, 1). The first
+   * response to arrive is used. Set to zero to disable hedging
+   */
+  double hedge_percentile = 0;
+  /// Number of latencies to measure before hedging starts
+  size_t hedge_min_samples = 100;
+  /// Time between checks of requests in flight for responses
+  std::chrono::microseconds poll_interval{100};
+};
+
+/// Statistics about one backend of a LoadBalancingClient
+struct BackendStats {
+  /// Requests sent to the backend that haven't finished
+  int in_flight = 0;
+  /// Requests that have finished
+  uint64_t requests = 0;
+  /// Requests that failed to reach the backend
+  uint64_t failures = 0;
+  /// If the backend is used for new requests
+  bool healthy = true;
+};
+
+/**
+ * @brief The LoadBalancingClient spreads requests over a set of clients that
+ * each talk to one server with the same models. Each inference request goes to
+ * the less busy of two randomly chosen backends, counting requests in flight.
+ *
+ * Backends that aren't ready, or whose model isn't ready, are checked
+ * periodically and skipped until they are ready again. A request that fails to
+ * reach its backend is sent to another one once. Optionally, requests that are
+ * slower than most can also be sent to a second backend and whichever response
+ * comes first is used. Since requests may be sent again, the data of their
+ * inputs must stay valid until their response arrives.
+ *
+ * Loading and unloading workers and models applies to all the backends.
+ *
+ * @details Usage:
+ *
+ * HttpClient first{"http://server0:8998"};
+ * HttpClient second{"http://server1:8998"};
+ * LoadBalancingClient client{{&first, &second}};
+ * auto response = client.modelInfer("model", request);
+ */
+class LoadBalancingClient : public Client {
+ public:
+  /**
+   * @brief Construct a new LoadBalancingClient object
+   *
+   * @param backends the clients to send requests with. They must outlive this
+   * client
+   * @param options how the backends are picked and checked
+   */
+  explicit LoadBalancingClient(const std::vector<const Client*>& backends,
+                               const LoadBalancingOptions& options = {});
+
+  /// Copy constructor
+  LoadBalancingClient(LoadBalancingClient const&) = delete;
+  /// Copy assignment constructor
+  LoadBalancingClient& operator=(const LoadBalancingClient&) = delete;
+  /// Move constructor
+  LoadBalancingClient(LoadBalancingClient&& other) = default;
+  /// Move assignment constructor
+  LoadBalancingClient& operator=(LoadBalancingClient&& other) = default;
+  /// Destructor. It waits for the requests in flight to finish
+  ~LoadBalancingClient() override;
+
+  /// Returns the server metadata from a healthy backend
+  [[nodiscard]] ServerMetadata serverMetadata() const override;
+  /// Checks if any backend is live
+  [[nodiscard]] bool serverLive() const override;
+  /// Checks if any backend is ready
+  [[nodiscard]] bool serverReady() const override;
+  /// Gets the models on a healthy backend
+  [[nodiscard]] std::vector<std::string> modelList() const override;
+  /**
+   * @brief Loads a worker on all the backends. The backends are assumed to be
+   * identical so the endpoint from the first one is returned
+   */
+  [[nodiscard]] std::string workerLoad(
+    const std::string& worker, const ParameterMap& parameters) const override;
+  /// Unloads a worker on all the backends
+  void workerUnload(const std::string& worker) const override;
+  /// Checks that all the backends have the hardware
+  [[nodiscard]] bool hasHardware(const std::string& name,
+                                 int num) const override;
+
+  /// Get the statistics of each backend, in the order they were given
+  [[nodiscard]] std::vector<BackendStats> backendStats() const;
+
+ private:
+  class LoadBalancingClientImpl;
+  std::unique_ptr<LoadBalancingClientImpl> impl_;
+
+  [[nodiscard]] bool modelReadyImpl(const std::string& model,
+                                    const std::string& version) const override;
+  [[nodiscard]] ModelMetadata modelMetadataImpl(
+    const std::string& model, const std::string& version) const override;
+  void modelLoadImpl(const std::string& model, const ParameterMap& parameters,
+                     const std::string& version) const override;
+  void modelUnloadImpl(const std::string& model,
+                       const std::string& version) const override;
+  [[nodiscard]] InferenceResponse modelInferImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override;
+  [[nodiscard]] InferenceResponseFuture modelInferAsyncImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CLIENTS_LOAD_BALANCING
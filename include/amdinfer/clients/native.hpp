@@ -127,6 +127,50 @@ class NativeClient : public Client {
   [[nodiscard]] bool hasHardware(const std::string& name,
                                  int num) const override;
 
+  /**
+   * @brief Makes an asynchronous inference request without copying its input
+   * data. The server reads the inputs from the caller's memory so the caller
+   * must keep that memory alive and unchanged until the future is ready.
+   * Requests to models that batch contiguously are still copied into the
+   * batch but this saves the copy made by modelInferAsync.
+   *
+   * @param model name of the model/worker to request inference to
+   * @param request the request
+   * @param version the version of the model
+   * @return InferenceResponseFuture
+   */
+  [[nodiscard]] InferenceResponseFuture modelInferAsyncBorrowed(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version = "") const;
+  /**
+   * @brief Makes an asynchronous inference request without copying its input
+   * data, as above, but calls the callback with the final response instead of
+   * returning a future. The callback runs on the thread that finishes the
+   * request so it should return quickly. If the request can't be made, this
+   * throws and the callback isn't called.
+   *
+   * @param model name of the model/worker to request inference to
+   * @param request the request
+   * @param callback called with the final response
+   * @param version the version of the model
+   */
+  void modelInferAsyncBorrowed(const std::string& model,
+                               const InferenceRequest& request,
+                               Callback callback,
+                               const std::string& version = "") const;
+  /**
+   * @brief Makes a synchronous inference request without copying its input
+   * data. The caller's memory is read directly, as in modelInferAsyncBorrowed.
+   *
+   * @param model name of the model/worker to request inference to
+   * @param request the request
+   * @param version the version of the model
+   * @return InferenceResponse
+   */
+  [[nodiscard]] InferenceResponse modelInferBorrowed(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version = "") const;
+
  private:
   struct NativeClientImpl;
   std::unique_ptr<NativeClientImpl> impl_;
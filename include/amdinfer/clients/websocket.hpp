@@ -21,17 +21,28 @@
 #ifndef GUARD_AMDINFER_CLIENTS_WEBSOCKET
 #define GUARD_AMDINFER_CLIENTS_WEBSOCKET
 
-#include <memory>  // for unique_ptr
-#include <string>  // for string
-#include <vector>  // for vector
+#include <functional>   // for function
+#include <memory>       // for unique_ptr
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
 
-#include "amdinfer/clients/client.hpp"  // IWYU pragma: export
-#include "amdinfer/declarations.hpp"    // for InferenceResponseFuture
+#include "amdinfer/clients/client.hpp"     // IWYU pragma: export
+#include "amdinfer/core/stream_frame.hpp"  // IWYU pragma: export
+#include "amdinfer/declarations.hpp"       // for InferenceResponseFuture
 
 namespace amdinfer {
 
 class ParameterMap;
 
+/**
+ * @brief A callback for the websocket messages sent in response to one
+ * request. It's passed the message and whether it was sent as binary and
+ * returns true once the last message for the request has arrived. It's run on
+ * the client's event loop thread so it should not block
+ */
+using WsCallback = std::function<bool(std::string_view message, bool binary)>;
+
 /**
  * @brief The WebSocketClient class implements the Client using websocket. It
  * reuses the HttpClient for most transactions with the exception of some
@@ -140,15 +151,39 @@ class WebSocketClient : public Client {
    */
   void modelInferWs(const std::string& model,
                     const InferenceRequest& request) const;
+  /**
+   * @brief Makes a websocket inference request to the given model/worker and
+   * passes the messages sent in response to it to the callback as they arrive
+   * instead of queueing them for modelRecv. Many requests may be outstanding
+   * over the same connection at once. Messages are matched to requests by the
+   * "id" of JSON text messages or the key of streams so the request should have
+   * a unique ID or, if it doesn't, a "key" parameter.
+   *
+   * @param model name of the model/worker to request inference to
+   * @param request the request
+   * @param callback the callback to pass the responses to
+   */
+  void modelInferWs(const std::string& model, const InferenceRequest& request,
+                    WsCallback callback) const;
   // TODO(varunsh) const: change to InferenceResponse
   /**
    * @brief Gets one message from the websocket server sent in response to a
    * modelInferWs request. The user should know beforehand how many messages are
    * expected and should call this method the same number of times.
    *
-   * @return std::string a JSON object encoded as a string
+   * @return std::string a JSON object encoded as a string or, for binary
+   * messages, the message's bytes
    */
   [[nodiscard]] std::string modelRecv() const;
+  /**
+   * @brief Gets one message from a streaming worker as a frame. Requests with
+   * the "binary" parameter set to true get binary messages that are parsed as
+   * they are. Otherwise, the JSON text messages are converted so clients can
+   * handle both the same way.
+   *
+   * @return StreamFrame
+   */
+  [[nodiscard]] StreamFrame modelRecvFrame() const;
   /**
    * @brief Closes the websocket connection
    *
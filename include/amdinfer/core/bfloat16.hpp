@@ -0,0 +1,85 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the bfloat16 type
+ */
+
+#ifndef GUARD_AMDINFER_CORE_BFLOAT16
+#define GUARD_AMDINFER_CORE_BFLOAT16
+
+#include <cstdint>  // for uint16_t, uint32_t
+#include <cstring>  // for memcpy
+
+namespace amdinfer {
+
+/**
+ * @brief A 16-bit brain floating point number: the upper half of an IEEE
+ * float, with its 8-bit exponent and 7 bits of the mantissa. It converts
+ * implicitly to and from float so it can be used in arithmetic like fp16.
+ * Conversions from float round to the nearest even value and keep NaNs.
+ */
+// this is kept lower-case for visual consistency with other POD types
+class bf16 {  // NOLINT(readability-identifier-naming)
+ public:
+  constexpr bf16() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
+  bf16(float value) : bits_(fromFloat(value)) {}
+
+  // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
+  operator float() const { return toFloat(bits_); }
+
+  /// Construct a bf16 from its bit pattern
+  static constexpr bf16 fromBits(uint16_t bits) {
+    bf16 value;
+    value.bits_ = bits;
+    return value;
+  }
+  /// Get the bit pattern of the bf16
+  [[nodiscard]] constexpr uint16_t bits() const { return bits_; }
+
+  /// Convert a float to the bit pattern of the nearest bf16
+  static uint16_t fromFloat(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & kAbsMask) > kInfinity) {
+      // keep NaNs quiet so rounding can't turn them into infinity
+      return static_cast<uint16_t>((bits >> kShift) | kQuietBit);
+    }
+    bits += kRoundingBias + ((bits >> kShift) & 1U);
+    return static_cast<uint16_t>(bits >> kShift);
+  }
+
+  /// Convert the bit pattern of a bf16 to a float, which is exact
+  static float toFloat(uint16_t bits) {
+    const auto wide = static_cast<uint32_t>(bits) << kShift;
+    float value = 0;
+    std::memcpy(&value, &wide, sizeof(value));
+    return value;
+  }
+
+ private:
+  static constexpr uint32_t kShift = 16;
+  static constexpr uint32_t kAbsMask = 0x7FFF'FFFF;
+  static constexpr uint32_t kInfinity = 0x7F80'0000;
+  static constexpr uint32_t kRoundingBias = 0x7FFF;
+  static constexpr uint32_t kQuietBit = 0x40;
+
+  uint16_t bits_ = 0;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_BFLOAT16
@@ -0,0 +1,136 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the binary inference protocol that the io_uring server speaks
+ */
+
+#ifndef GUARD_AMDINFER_CORE_BINARY_PROTOCOL
+#define GUARD_AMDINFER_CORE_BINARY_PROTOCOL
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+
+namespace amdinfer {
+
+/// Whether a binary message is a request or a response
+enum class BinaryMessageKind : uint8_t { Request, Response };
+
+/// Size of the fixed prefix of every binary message
+constexpr size_t kBinaryPrefixSize = 20;
+/// Headers larger than this are refused instead of allocated
+constexpr uint32_t kMaxBinaryHeaderSize = uint32_t{16} << 20;
+
+/**
+ * @brief The fixed prefix of a binary message, which tells the reader how much
+ * more to read.
+ *
+ * @details Clients send requests and the server answers each with a response,
+ * in the order the requests finish, over a TCP connection. A message is a
+ * 20-byte prefix, a header with the message's metadata and then the data of
+ * its tensors, one after another in the order of the header, so the data can
+ * be received into and sent from the tensors' memory directly. All integers
+ * are little-endian. Strings are prefixed by their 32-bit size and parameters
+ * are encoded as in traces:
+ *
+ * | Bytes | Field                               |
+ * |-------|-------------------------------------|
+ * | 0-3   | magic "AMDB"                        |
+ * | 4     | version (1)                         |
+ * | 5     | kind: 0 for requests, 1 responses   |
+ * | 6-7   | reserved                            |
+ * | 8-11  | size of the header                  |
+ * | 12-19 | size of the data                    |
+ *
+ * A request's header is the model, version, ID and parameters of the request,
+ * then the number of inputs and each one's name, datatype, rank, dimensions
+ * and parameters, and then the number of requested outputs and their names.
+ * A response's header is its ID, model, error message, if any, and whether
+ * it's the final response to its request, then the number of outputs and
+ * each one's name, datatype, rank and dimensions.
+ */
+struct BinaryPrefix {
+  BinaryMessageKind kind = BinaryMessageKind::Request;
+  uint32_t header_size = 0;
+  uint64_t data_size = 0;
+};
+
+/// A request parsed from its header. Its inputs have no data yet
+struct BinaryRequest {
+  std::string model;
+  std::string version;
+  InferenceRequest request;
+};
+
+/**
+ * @brief Parse the prefix of a binary message
+ *
+ * @param bytes at least the first kBinaryPrefixSize bytes of the message
+ * @return BinaryPrefix
+ * @throws invalid_argument if it isn't a binary message or the header is too
+ * large
+ */
+BinaryPrefix parseBinaryPrefix(std::string_view bytes);
+
+/**
+ * @brief Parse the header of a binary request
+ *
+ * @param header the header, after the prefix
+ * @param data_size the size of the data from the prefix, which must match the
+ * inputs' shapes
+ * @return BinaryRequest
+ * @throws invalid_argument if the header is malformed
+ */
+BinaryRequest parseBinaryRequestHeader(std::string_view header,
+                                       uint64_t data_size);
+
+/**
+ * @brief Serialize a request, including its inputs' data, into a message
+ *
+ * @param model the model to send the request to
+ * @param version the version of the model or empty
+ * @param request the request
+ * @return std::string
+ */
+std::string serializeBinaryRequest(const std::string& model,
+                                   const std::string& version,
+                                   const InferenceRequest& request);
+
+/**
+ * @brief Serialize the prefix and header of a response. The outputs' data
+ * follows it on the wire, unchanged, so it's sent from where it is
+ *
+ * @param response the response
+ * @return std::string
+ */
+std::string serializeBinaryResponseHeader(const InferenceResponse& response);
+
+/**
+ * @brief Parse a whole binary response
+ *
+ * @param message the message
+ * @return InferenceResponse
+ * @throws invalid_argument if the message is malformed
+ */
+InferenceResponse parseBinaryResponse(std::string_view message);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_BINARY_PROTOCOL
@@ -0,0 +1,111 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the accessors for the elements of BYTES tensors
+ */
+
+#ifndef GUARD_AMDINFER_CORE_BYTES_TENSOR
+#define GUARD_AMDINFER_CORE_BYTES_TENSOR
+
+#include <cstddef>      // for size_t, byte
+#include <cstring>      // for memcpy, memset
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+namespace amdinfer {
+
+/**
+ * @brief A read-only view of the elements of a BYTES tensor. The tensor's data
+ * holds its elements back to back, each followed by a null terminator, and its
+ * size is the total number of bytes. The view indexes the elements once, like
+ * Arrow's offsets buffer, so each one can then be read as a string_view
+ * without searching or copying the data.
+ *
+ * @details Element i spans the bytes [offsets()[i], offsets()[i + 1]) of the
+ * data, including its terminator. The last element doesn't need a terminator
+ * and any empty elements at the end are padding and are dropped. The data must
+ * outlive the view.
+ */
+class BytesView {
+ public:
+  /// Index the elements of the size bytes at data
+  BytesView(const void* data, size_t size);
+
+  /// Get the number of elements
+  [[nodiscard]] size_t size() const { return offsets_.size() - 1; }
+  /// Check if there are no elements
+  [[nodiscard]] bool empty() const { return this->size() == 0; }
+  /// Get an element without its terminator
+  [[nodiscard]] std::string_view operator[](size_t index) const;
+  /// Get the number + 1 offsets of the elements into the data
+  [[nodiscard]] const std::vector<size_t>& offsets() const { return offsets_; }
+
+ private:
+  const char* data_;
+  std::vector<size_t> offsets_;
+};
+
+/**
+ * @brief Write strings as the data of a BYTES tensor, each followed by a null
+ * terminator. If they don't fit, the last one is cut short and the rest are
+ * dropped. Any unused bytes are zeroed so they read as padding
+ *
+ * @tparam Range a range of elements convertible to std::string_view
+ * @param elements the strings to write
+ * @param data where to write them
+ * @param size the number of bytes at data
+ * @return size_t the number of bytes used
+ */
+template <typename Range>
+size_t packBytes(const Range& elements, void* data, size_t size) {
+  auto* dest = static_cast<char*>(data);
+  size_t offset = 0;
+  for (const auto& element : elements) {
+    const std::string_view value{element};
+    if (offset + value.size() >= size) {
+      std::memcpy(dest + offset, value.data(), size - offset);
+      return size;
+    }
+    std::memcpy(dest + offset, value.data(), value.size());
+    offset += value.size();
+    dest[offset++] = '\0';
+  }
+  std::memset(dest + offset, 0, size - offset);
+  return offset;
+}
+
+/**
+ * @brief Get strings as the data of a BYTES tensor, each followed by a null
+ * terminator. The data is allocated once for all of them
+ *
+ * @tparam Range a range of elements convertible to std::string_view
+ * @param elements the strings to pack
+ * @return std::vector<std::byte>
+ */
+template <typename Range>
+std::vector<std::byte> packBytes(const Range& elements) {
+  size_t size = 0;
+  for (const auto& element : elements) {
+    size += std::string_view{element}.size() + 1;
+  }
+  std::vector<std::byte> data(size);
+  packBytes(elements, data.data(), size);
+  return data;
+}
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_BYTES_TENSOR
@@ -27,6 +27,7 @@
 #include <string>       // for string
 #include <string_view>  // for string_view
 
+#include "amdinfer/core/bfloat16.hpp"    // IWYU pragma: export
 #include "amdinfer/core/exceptions.hpp"  // for invalid_argument
 #include "half/half.hpp"                 // for half
 
@@ -77,6 +78,7 @@ class DataType {
     Fp64,
     FP64 = Fp64,
     Bytes,
+    Bf16,
     Unknown,
   };
 
@@ -143,6 +145,8 @@ class DataType {
         return sizeof(double);
       case DataType::Bytes:
         return sizeof(std::byte);
+      case DataType::Bf16:
+        return sizeof(bf16);
       default:
         throw invalid_argument("Unknown datatype passed");
     }
@@ -184,6 +188,8 @@ class DataType {
         return "FP64";
       case DataType::Bytes:
         return "BYTES";
+      case DataType::Bf16:
+        return "BF16";
       default:
         throw invalid_argument("Unknown datatype passed");
     }
@@ -231,6 +237,9 @@ class DataType {
       case detail::hash("BYTES"):
       case detail::hash("Bytes"):
         return DataType::Bytes;
+      case detail::hash("BF16"):
+      case detail::hash("Bf16"):
+        return DataType::Bf16;
       default:
         throw invalid_argument("Unknown datatype passed");
     }
@@ -292,6 +301,9 @@ auto switchOverTypes(F f, DataType type, [[maybe_unused]] const Args&... args) {
     case DataType::Bytes: {
       return f.template operator()<char>(args...);
     }
+    case DataType::Bf16: {
+      return f.template operator()<bf16>(args...);
+    }
     default:
       throw invalid_argument("Unknown datatype passed");
   }
@@ -95,6 +95,15 @@ class environment_not_set_error : public runtime_error {
   using runtime_error::runtime_error;
 };
 
+/**
+ * @brief This exception gets thrown if a request is refused because its
+ * endpoint has no room for it
+ *
+ */ // NOLINTNEXTLINE(readability-identifier-naming)
+class resource_exhausted_error : public runtime_error {
+  using runtime_error::runtime_error;
+};
+
 }  // namespace amdinfer
 
 #endif  // GUARD_AMDINFER_CORE_EXCEPTIONS
@@ -20,6 +20,9 @@
 #ifndef GUARD_AMDINFER_CORE_INFERENCE_REQUEST
 #define GUARD_AMDINFER_CORE_INFERENCE_REQUEST
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,6 +33,11 @@
 
 namespace amdinfer {
 
+class CompletionExecutor;
+class RequestUsage;
+class ServerTiming;
+class StreamFlow;
+
 /**
  * @brief Holds an inference request's input data
  */
@@ -48,14 +56,54 @@ class InferenceRequestInput : public InferenceTensor {
    * @param data_type type of the data
    * @param name name to assign
    */
-  InferenceRequestInput(void *data, std::vector<int64_t> shape,
-                        DataType data_type, std::string name = "");
+  InferenceRequestInput(void *data, Shape shape, DataType data_type,
+                        std::string name = "");
 
   /// Set the request's data
   void setData(void *buffer);
   /// Get a pointer to the request's data
   [[nodiscard]] void *getData() const;
 
+  /**
+   * @brief Make the data a strided view. The data pointer stays at the start
+   * of the underlying memory so it can still be released and the view starts
+   * at the offset from it. Setting the data with InferenceRequest's
+   * setInputTensorData makes it dense again.
+   *
+   * @param strides the stride of each dimension in elements or empty if the
+   * data is dense
+   * @param offset the offset of the first element from the data in elements
+   */
+  void setStrides(Strides strides, int64_t offset = 0);
+  /// Get the strides of the data in elements. It's empty if the data is dense
+  [[nodiscard]] const Strides &getStrides() const;
+  /// Get the offset of the first element from the data in elements
+  [[nodiscard]] int64_t getOffset() const;
+  /// Check if the data is dense and in row-major order from the data pointer
+  [[nodiscard]] bool isContiguous() const;
+
+  /**
+   * @brief Narrow a dimension to [start, stop) without copying the data
+   *
+   * @param axis the dimension to narrow
+   * @param start the first index to keep
+   * @param stop one past the last index to keep
+   */
+  void slice(size_t axis, int64_t start, int64_t stop);
+  /**
+   * @brief Permute the dimensions without copying the data
+   *
+   * @param order order[i] is the current dimension that becomes dimension i
+   */
+  void transpose(const std::vector<size_t> &order);
+  /**
+   * @brief Copy the viewed elements to dense, row-major memory. There should
+   * be space for getSize() elements at the destination.
+   *
+   * @param dst where to copy the data
+   */
+  void copyData(void *dst) const;
+
   /**
    * @brief Returns the size of the serialized data
    *
@@ -84,7 +132,11 @@ class InferenceRequestInput : public InferenceTensor {
                                   InferenceRequestInput const &self);
 
  private:
+  [[nodiscard]] Strides getEffectiveStrides() const;
+
   void *data_ = nullptr;
+  Strides strides_;
+  int64_t offset_ = 0;
 };
 
 /**
@@ -103,7 +155,7 @@ class InferenceRequestOutput {
   void *getData() { return this->data_; }
 
   /// Gets the output tensor's name
-  [[nodiscard]] std::string getName() const { return this->name_; }
+  [[nodiscard]] const std::string &getName() const { return this->name_; }
   /// Set the output tensor's name
   void setName(const std::string &name);
 
@@ -134,7 +186,25 @@ class InferenceRequest {
  public:
   // Construct a new InferenceRequest object
   InferenceRequest() = default;
+  /**
+   * @brief Copy the request without its callback. The callback responds to
+   * one client so it's moved between requests, with getCallback, instead. The
+   * copy is cancelled along with the original.
+   */
+  InferenceRequest(const InferenceRequest &other);
+  InferenceRequest &operator=(const InferenceRequest &other);
+  InferenceRequest(InferenceRequest &&other) = default;
+  InferenceRequest &operator=(InferenceRequest &&other) = default;
+  ~InferenceRequest() = default;
 
+  /**
+   * @brief Make the request for the next worker in a chain. It takes over the
+   * callback and keeps the ID, requested outputs and parameters, such as the
+   * image size that a preprocessing worker sets for a postprocessing one, but
+   * not the inputs.
+   *
+   * @return InferenceRequestPtr
+   */
   InferenceRequestPtr propagate();
 
   /**
@@ -171,6 +241,76 @@ class InferenceRequest {
    */
   void runCallbackError(std::string_view error_msg);
 
+  /**
+   * @brief Set the flag that the server raises if the client cancels the
+   * request or disconnects before it's responded to. Batchers drop cancelled
+   * requests and workers skip batches whose requests are all cancelled. Their
+   * callbacks still run with an error, which the server doesn't send.
+   *
+   * @param cancelled the flag
+   */
+  void setCancellation(std::shared_ptr<const std::atomic_bool> cancelled);
+  /// Check if the client has cancelled the request
+  [[nodiscard]] bool isCancelled() const;
+  /// Get the flag raised if the client cancels the request, which may be null
+  [[nodiscard]] std::shared_ptr<const std::atomic_bool> getCancellation()
+    const {
+    return cancelled_;
+  }
+
+  /**
+   * @brief Set where the times the request reaches each stage are recorded.
+   * It's only set if the client asks for them. Copies of the request aren't
+   * timed.
+   *
+   * @param timing the timing
+   */
+  void setServerTiming(std::shared_ptr<ServerTiming> timing);
+  /// Get where the request's stages are timed or nullptr if they aren't
+  [[nodiscard]] ServerTiming *getServerTiming() const {
+    return timing_.get();
+  }
+
+  /**
+   * @brief Set where the CPU time and copies spent on the request are
+   * accounted. It's only set if the server accounts for usage. Copies of the
+   * request aren't accounted but requests propagated from it are
+   *
+   * @param usage the usage
+   */
+  void setUsage(std::shared_ptr<RequestUsage> usage);
+  /// Get where the request's usage is accounted or nullptr if it isn't
+  [[nodiscard]] RequestUsage *getUsage() const { return usage_.get(); }
+
+  /**
+   * @brief Set the flow control of the stream that the request's responses
+   * are sent on. It's only set by transports that stream responses
+   *
+   * @param flow the flow control
+   */
+  void setStreamFlow(std::shared_ptr<StreamFlow> flow);
+  /**
+   * @brief Take a credit to send an optional response, such as a frame of a
+   * video, on the request's stream. Depending on the stream's policy, this
+   * waits for the client to catch up or gives up right away
+   *
+   * @return bool true to send the response, false to drop it
+   */
+  [[nodiscard]] bool acquireStreamCredit() const;
+
+  /**
+   * @brief Set the executor that runs the request's callback on the thread of
+   * the transport that received it. Workers that respond to many requests at
+   * once hand it their responses in one batch.
+   *
+   * @param executor the executor. Null to run the callback where it's called
+   */
+  void setExecutor(std::shared_ptr<CompletionExecutor> executor);
+  /// Get the executor that runs the request's callback, if any
+  [[nodiscard]] const std::shared_ptr<CompletionExecutor> &getExecutor() const {
+    return executor_;
+  }
+
   /**
    * @brief Constructs and adds a new input tensor to this request
    *
@@ -179,8 +319,8 @@ class InferenceRequest {
    * @param data_type the datatype of the data
    * @param name the name of the input tensor
    */
-  void addInputTensor(void *data, const std::vector<int64_t> &shape,
-                      DataType data_type, const std::string &name = "");
+  void addInputTensor(void *data, const Shape &shape, DataType data_type,
+                      const std::string &name = "");
 
   /**
    * @brief Adds a new input tensor to this request
@@ -196,20 +336,69 @@ class InferenceRequest {
    * @param data pointer to assign to its data member
    */
   void setInputTensorData(size_t index, void *data);
+  /**
+   * @brief Set the shape for an input tensor, if it exists
+   *
+   * @param index index for the input tensor
+   * @param shape shape to assign to it
+   */
+  void setInputTensorShape(size_t index, Shape shape);
+  /**
+   * @brief Set the name for an input tensor, if it exists
+   *
+   * @param index index for the input tensor
+   * @param name name to assign to it
+   */
+  void setInputTensorName(size_t index, std::string name);
+  /**
+   * @brief Set the datatype for an input tensor, if it exists
+   *
+   * @param index index for the input tensor
+   * @param datatype datatype to assign to it
+   */
+  void setInputTensorDatatype(size_t index, DataType datatype);
+  /**
+   * @brief Permute the dimensions of an input tensor without copying its data,
+   * if it exists
+   *
+   * @param index index for the input tensor
+   * @param order order[i] is the current dimension that becomes dimension i
+   */
+  void transposeInputTensor(size_t index, const std::vector<size_t> &order);
+  /**
+   * @brief Reorder the input tensors, moving the tensor at index i to
+   * order[i]. The order must be a permutation of the tensors' indices
+   *
+   * @param order the new index of each input tensor
+   */
+  void reorderInputTensors(const std::vector<size_t> &order);
   /**
    * @brief Adds a new output tensor to this request
    *
    * @param output an existing InferenceRequestOutput object
    */
-  void addOutputTensor(const InferenceRequestOutput &output);
+  void addOutputTensor(InferenceRequestOutput output);
+  /**
+   * @brief Reserve space for input and output tensors so adding a known number
+   * of them doesn't grow the vectors one tensor at a time
+   *
+   * @param inputs number of input tensors
+   * @param outputs number of output tensors
+   */
+  void reserveTensors(size_t inputs, size_t outputs);
 
   /// Gets a vector of all the input request objects
-  [[nodiscard]] const std::vector<InferenceRequestInput> &getInputs() const;
+  [[nodiscard]] const std::vector<InferenceRequestInput> &getInputs() const &;
+  /// Moves out the input request objects
+  [[nodiscard]] std::vector<InferenceRequestInput> getInputs() &&;
   /// Get the number of input request objects
   [[nodiscard]] size_t getInputSize() const;
 
   /// Gets a vector of the requested output information
-  [[nodiscard]] const std::vector<InferenceRequestOutput> &getOutputs() const;
+  [[nodiscard]] const std::vector<InferenceRequestOutput> &getOutputs()
+    const &;
+  /// Moves out the requested output information
+  [[nodiscard]] std::vector<InferenceRequestOutput> getOutputs() &&;
 
   /**
    * @brief Gets the ID associated with this request
@@ -247,6 +436,16 @@ class InferenceRequest {
   std::vector<InferenceRequestInput> inputs_;
   std::vector<InferenceRequestOutput> outputs_;
   Callback callback_;
+  // null if the request can't be cancelled
+  std::shared_ptr<const std::atomic_bool> cancelled_;
+  // null unless the client asked for the server timing
+  std::shared_ptr<ServerTiming> timing_;
+  // null unless the server accounts for usage
+  std::shared_ptr<RequestUsage> usage_;
+  // null if the responses aren't flow controlled
+  std::shared_ptr<StreamFlow> flow_;
+  // null if the callback runs wherever it's called
+  std::shared_ptr<CompletionExecutor> executor_;
 
   // TODO(varunsh): do we need this still?
   friend class FakeInferenceRequest;
@@ -20,6 +20,10 @@
 #ifndef GUARD_AMDINFER_CORE_INFERENCE_RESPONSE
 #define GUARD_AMDINFER_CORE_INFERENCE_RESPONSE
 
+#include <cstddef>  // for byte, size_t
+#include <memory>   // for shared_ptr
+#include <vector>   // for vector
+
 #include "amdinfer/build_options.hpp"          // for AMDINFER_ENABLE_TRACING
 #include "amdinfer/core/inference_tensor.hpp"  // for InferenceTensor
 #include "amdinfer/core/parameters.hpp"        // for ParameterMap
@@ -48,6 +52,17 @@ class InferenceResponseOutput : public InferenceTensor {
 
   /// Set the request's data
   void setData(std::vector<std::byte> &&buffer);
+  /**
+   * @brief Set the output's data to a view of memory held by an owner instead
+   * of copying it into the output. The owner, such as the pooled buffer the
+   * data is in, is released when this output and all its copies are destroyed
+   *
+   * @param data pointer to the data
+   * @param size size of the data in bytes
+   * @param owner keeps the data alive while the output views it
+   */
+  void setData(const void *data, size_t size,
+               std::shared_ptr<const void> owner);
   /// Get a pointer to the request's data
   [[nodiscard]] void *getData() const;
 
@@ -79,7 +94,13 @@ class InferenceResponseOutput : public InferenceTensor {
                                   InferenceResponseOutput const &self);
 
  private:
+  [[nodiscard]] size_t dataSize() const;
+
   std::vector<std::byte> data_;
+  // set if the data is viewed instead of held in data_
+  const std::byte *view_ = nullptr;
+  size_t view_size_ = 0;
+  std::shared_ptr<const void> owner_;
 };
 
 /**
@@ -95,13 +116,16 @@ class InferenceResponse {
   explicit InferenceResponse(const std::string &error);
 
   /// Gets a vector of the requested output information
-  [[nodiscard]] std::vector<InferenceResponseOutput> getOutputs() const;
+  [[nodiscard]] const std::vector<InferenceResponseOutput> &getOutputs()
+    const &;
+  /// Moves out the output information
+  [[nodiscard]] std::vector<InferenceResponseOutput> getOutputs() &&;
   /**
    * @brief Adds an output tensor to the response
    *
    * @param output an output tensor
    */
-  void addOutput(const InferenceResponseOutput &output);
+  void addOutput(InferenceResponseOutput output);
 
   /// Gets the ID of the response
   std::string getID() const { return id_; }
@@ -110,12 +134,22 @@ class InferenceResponse {
   /// sets the model name of the response
   void setModel(const std::string &model);
   /// gets the model name of the response
-  std::string getModel();
+  std::string getModel() const;
 
   /// Checks if this is an error response
   bool isError() const;
   /// Gets the error message if it exists. Defaults to an empty string
   std::string getError() const;
+  /**
+   * @brief Marks whether this is the last response to its request. Streaming
+   * requests may get partial responses before their final one. Defaults to
+   * true.
+   *
+   * @param final whether this is the last response
+   */
+  void setFinal(bool final);
+  /// Checks if this is the last response to its request
+  bool isFinal() const;
 
 #ifdef AMDINFER_ENABLE_TRACING
   /**
@@ -141,6 +175,7 @@ class InferenceResponse {
   std::shared_ptr<ParameterMap> parameters_;
   std::vector<InferenceResponseOutput> outputs_;
   std::string error_msg_;
+  bool final_ = true;
 #ifdef AMDINFER_ENABLE_TRACING
   StringMap context_;
 #endif
@@ -28,8 +28,7 @@ namespace amdinfer {
 class InferenceTensor : public Tensor {
  public:
   /// Construct a new InferenceTensor object
-  InferenceTensor(std::string name, std::vector<int64_t> shape,
-                  DataType data_type);
+  InferenceTensor(std::string name, Shape shape, DataType data_type);
   /// Construct a new InferenceTensor object
   explicit InferenceTensor(const Tensor &tensor);
 
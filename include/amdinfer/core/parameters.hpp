@@ -17,14 +17,18 @@
  * @brief Defines the Parameter object and associated containers
  */
 
-#include <cstddef>     // for byte, size_t
-#include <cstdint>     // for int32_t
-#include <functional>  // for less
-#include <map>         // for map
-#include <memory>      // for shared_ptr
-#include <sstream>     // for operator<<, basic_ostream, strin...
-#include <string>      // for string, operator<<, char_traits
-#include <variant>     // for visit, variant
+#include <cstddef>      // for byte, size_t
+#include <cstdint>      // for int32_t
+#include <functional>   // for less
+#include <map>          // for map
+#include <memory>       // for shared_ptr
+#include <sstream>      // for operator<<, basic_ostream, strin...
+#include <stdexcept>    // for out_of_range
+#include <string>       // for string, operator<<, char_traits
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+#include <variant>      // for visit, variant
+#include <vector>       // for vector
 
 #include "amdinfer/core/mixins.hpp"  // for Serializable
 
@@ -42,7 +46,9 @@ using Parameter = std::variant<bool, int32_t, double, std::string>;
  *
  */
 class ParameterMap : public Serializable {
-  using Container = std::map<std::string, Parameter, std::less<>>;
+  // requests usually have a few parameters so a vector sorted by key is faster
+  // to search and much cheaper to copy than a tree of nodes
+  using Container = std::vector<std::pair<std::string, Parameter>>;
   using Iterator = Container::iterator;
   using ConstIterator = Container::const_iterator;
 
@@ -88,9 +94,12 @@ class ParameterMap : public Serializable {
    * @return T
    */
   template <typename T>
-  T get(const std::string &key) const {
-    auto &value = this->parameters_.at(key);
-    return std::get<T>(value);
+  T get(std::string_view key) const {
+    auto found = this->find(key);
+    if (found == this->parameters_.end()) {
+      throw std::out_of_range("Parameter not found");
+    }
+    return std::get<T>(found->second);
   }
 
   /**
@@ -99,7 +108,7 @@ class ParameterMap : public Serializable {
    * @param key name of the parameter to check
    * @return bool
    */
-  bool has(const std::string &key) const;
+  bool has(std::string_view key) const;
 
   /**
    * @brief Rename the key associated with a parameter. If the new key already
@@ -116,7 +125,7 @@ class ParameterMap : public Serializable {
    *
    * @param key name of the parameter to remove
    */
-  void erase(const std::string &key);
+  void erase(std::string_view key);
   /// Gets the number of parameters
   [[nodiscard]] size_t size() const;
   /// Checks if the parameters are empty
@@ -175,7 +184,15 @@ class ParameterMap : public Serializable {
   }
 
  private:
+  /// Get the first parameter whose key is not less than the given key
+  [[nodiscard]] Iterator lowerBound(std::string_view key);
+  [[nodiscard]] ConstIterator lowerBound(std::string_view key) const;
+  /// Get the parameter with the given key or end() if there isn't one
+  [[nodiscard]] ConstIterator find(std::string_view key) const;
+
   Container parameters_;
+
+  friend struct std::less<ParameterMap>;
 };
 
 using ParameterMapPtr = std::shared_ptr<ParameterMap>;
@@ -206,14 +223,13 @@ struct less<amdinfer::ParameterMap> {
                   const amdinfer::ParameterMap &rhs) const {
     auto lhs_size = lhs.size();
     auto rhs_size = rhs.size();
-    auto lhs_map = lhs.data();
-    auto rhs_map = rhs.data();
     if (lhs_size == rhs_size) {
-      for (const auto &[key, lhs_value] : lhs_map) {
-        if (rhs_map.find(key) == rhs_map.end()) {
+      for (const auto &[key, lhs_value] : lhs) {
+        auto rhs_found = rhs.find(key);
+        if (rhs_found == rhs.end()) {
           return true;
         }
-        const auto &rhs_value = rhs_map.at(key);
+        const auto &rhs_value = rhs_found->second;
         if (lhs_value != rhs_value) {
           return lhs_value < rhs_value;
         }
@@ -0,0 +1,183 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the RDMA transport that servers use to read inputs from and
+ * write outputs to the memory of clients on other hosts
+ */
+
+#ifndef GUARD_AMDINFER_CORE_RDMA
+#define GUARD_AMDINFER_CORE_RDMA
+
+#include <array>        // for array
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint8_t, uint16_t, uint32_t, uint64_t
+#include <memory>       // for shared_ptr
+#include <mutex>        // for mutex
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/build_options.hpp"
+
+struct ibv_cq;
+struct ibv_mr;
+struct ibv_qp;
+
+namespace amdinfer {
+
+/// What a queue pair needs to know about its peer to connect to it
+struct RdmaEndpoint {
+  /// local identifier of the port on InfiniBand. Unused on RoCE
+  uint16_t lid = 0;
+  /// number of the queue pair
+  uint32_t qpn = 0;
+  /// first packet sequence number
+  uint32_t psn = 0;
+  /// global identifier of the port, which RoCE routes by
+  std::array<uint8_t, 16> gid{};
+
+  /// Encode the endpoint to send it to the peer
+  [[nodiscard]] std::string serialize() const;
+  /**
+   * @brief Decode an endpoint that a peer sent
+   *
+   * @param bytes the encoded endpoint
+   * @return RdmaEndpoint
+   * @throws invalid_argument if it's malformed
+   */
+  static RdmaEndpoint parse(std::string_view bytes);
+};
+
+#ifdef AMDINFER_ENABLE_RDMA
+
+class RdmaDevice;
+
+/**
+ * @brief Memory registered with this process's RDMA device so the peer of a
+ * session can read and write it. The device is the first one, or the one
+ * named by the AMDINFER_RDMA_DEVICE environment variable. Device memory can
+ * be registered too if the GPU's peer memory driver is loaded, so peers
+ * transfer straight to and from it.
+ */
+class RdmaMemory {
+ public:
+  /**
+   * @brief Register memory
+   *
+   * @param data the memory
+   * @param size its size in bytes
+   * @throws external_error if it can't be registered
+   */
+  RdmaMemory(void* data, size_t size);
+  ~RdmaMemory();
+  RdmaMemory(RdmaMemory const&) = delete;
+  RdmaMemory& operator=(const RdmaMemory&) = delete;
+  RdmaMemory(RdmaMemory&& other) = delete;
+  RdmaMemory& operator=(RdmaMemory&& other) = delete;
+
+  /// Get the address that peers reach the memory at
+  [[nodiscard]] uint64_t address() const;
+  /// Get the key that peers reach the memory with
+  [[nodiscard]] uint32_t key() const;
+
+ private:
+  std::shared_ptr<RdmaDevice> device_;
+  ibv_mr* region_ = nullptr;
+};
+
+/// One transfer between local memory and a peer's registered memory
+struct RdmaTransfer {
+  /// the local memory, which needn't be registered
+  void* local = nullptr;
+  /// address of the memory at the peer
+  uint64_t remote = 0;
+  /// size of the transfer in bytes
+  size_t size = 0;
+};
+
+/**
+ * @brief A reliable connection to a peer's queue pair. The server reads and
+ * writes the peer's memory with one-sided operations so the peer's CPU isn't
+ * involved. Sessions are safe to use from many threads but they transfer one
+ * batch of memory at a time. A session that fails is unusable and the peer
+ * must connect again.
+ */
+class RdmaSession {
+ public:
+  /**
+   * @brief Create a queue pair on this process's RDMA device
+   *
+   * @throws external_error if there's no device or it fails
+   */
+  RdmaSession();
+  ~RdmaSession();
+  RdmaSession(RdmaSession const&) = delete;
+  RdmaSession& operator=(const RdmaSession&) = delete;
+  RdmaSession(RdmaSession&& other) = delete;
+  RdmaSession& operator=(RdmaSession&& other) = delete;
+
+  /// Get the endpoint to send to the peer so it can connect to this session
+  [[nodiscard]] const RdmaEndpoint& getEndpoint() const { return endpoint_; }
+  /**
+   * @brief Connect to the peer's queue pair. Both sides must connect before
+   * memory is transferred
+   *
+   * @param peer the peer's endpoint
+   * @throws external_error if the queue pair can't be connected
+   */
+  void connect(const RdmaEndpoint& peer);
+
+  /**
+   * @brief Copy the peer's memory into local memory and wait for it
+   *
+   * @param transfers what to copy
+   * @param key the key of the peer's memory
+   * @throws external_error if the transfer fails
+   */
+  void read(const std::vector<RdmaTransfer>& transfers, uint32_t key);
+  /**
+   * @brief Copy local memory into the peer's memory and wait for it
+   *
+   * @param transfers what to copy
+   * @param key the key of the peer's memory
+   * @throws external_error if the transfer fails
+   */
+  void write(const std::vector<RdmaTransfer>& transfers, uint32_t key);
+
+ private:
+  void transfer(const std::vector<RdmaTransfer>& transfers, uint32_t key,
+                bool read);
+
+  std::shared_ptr<RdmaDevice> device_;
+  ibv_cq* queue_ = nullptr;
+  ibv_qp* pair_ = nullptr;
+  RdmaEndpoint endpoint_;
+  std::mutex mutex_;
+  bool failed_ = false;
+};
+
+/// A region of a peer's registered memory that requests refer to by name
+struct RdmaRegion {
+  std::shared_ptr<RdmaSession> session;
+  uint64_t address = 0;
+  uint32_t key = 0;
+};
+
+#endif  // AMDINFER_ENABLE_RDMA
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_RDMA
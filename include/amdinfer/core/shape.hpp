@@ -0,0 +1,184 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the shape of a tensor
+ */
+
+#ifndef GUARD_AMDINFER_CORE_SHAPE
+#define GUARD_AMDINFER_CORE_SHAPE
+
+#include <algorithm>         // for copy, equal, fill
+#include <array>             // for array
+#include <cstddef>           // for size_t
+#include <cstdint>           // for int64_t
+#include <initializer_list>  // for initializer_list
+#include <iterator>          // for distance, iterator_traits
+#include <stdexcept>         // for out_of_range
+#include <type_traits>       // for enable_if_t, is_base_of_v
+#include <utility>           // for move, as_const
+#include <vector>            // for vector
+
+namespace amdinfer {
+
+/**
+ * @brief The dimensions of a tensor. Shapes with up to kInlineDims dimensions
+ * are stored in the object itself so creating and copying them doesn't
+ * allocate. It behaves like a std::vector<int64_t> and converts to and from
+ * one.
+ */
+class Shape {
+ public:
+  using value_type = int64_t;
+  using size_type = size_t;
+  using reference = int64_t &;
+  using const_reference = const int64_t &;
+  using iterator = int64_t *;
+  using const_iterator = const int64_t *;
+
+  /// Most dimensions stored without allocating
+  static constexpr size_t kInlineDims = 8;
+
+  Shape() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  Shape(std::initializer_list<int64_t> dims) {
+    this->assign(dims.begin(), dims.end());
+  }
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  Shape(const std::vector<int64_t> &dims) {
+    this->assign(dims.begin(), dims.end());
+  }
+  template <typename Iter,
+            typename = std::enable_if_t<std::is_base_of_v<
+              std::input_iterator_tag,
+              typename std::iterator_traits<Iter>::iterator_category>>>
+  Shape(Iter first, Iter last) {
+    this->assign(first, last);
+  }
+
+  Shape(const Shape &) = default;
+  Shape &operator=(const Shape &) = default;
+  Shape(Shape &&other) noexcept
+    : inline_(other.inline_),
+      heap_(std::move(other.heap_)),
+      size_(other.size_) {
+    other.size_ = 0;
+  }
+  Shape &operator=(Shape &&other) noexcept {
+    inline_ = other.inline_;
+    heap_ = std::move(other.heap_);
+    size_ = other.size_;
+    other.size_ = 0;
+    return *this;
+  }
+  ~Shape() = default;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  operator std::vector<int64_t>() const { return {begin(), end()}; }
+
+  /// Replace the dimensions with the range [first, last)
+  template <typename Iter>
+  void assign(Iter first, Iter last) {
+    const auto size = static_cast<size_t>(std::distance(first, last));
+    if (size > kInlineDims) {
+      heap_.assign(first, last);
+    } else {
+      heap_.clear();
+      std::copy(first, last, inline_.begin());
+    }
+    size_ = size;
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  [[nodiscard]] int64_t *data() {
+    return size_ > kInlineDims ? heap_.data() : inline_.data();
+  }
+  [[nodiscard]] const int64_t *data() const {
+    return size_ > kInlineDims ? heap_.data() : inline_.data();
+  }
+
+  [[nodiscard]] iterator begin() { return data(); }
+  [[nodiscard]] iterator end() { return data() + size_; }
+  [[nodiscard]] const_iterator begin() const { return data(); }
+  [[nodiscard]] const_iterator end() const { return data() + size_; }
+  [[nodiscard]] const_iterator cbegin() const { return begin(); }
+  [[nodiscard]] const_iterator cend() const { return end(); }
+
+  int64_t &operator[](size_t index) { return data()[index]; }
+  const int64_t &operator[](size_t index) const { return data()[index]; }
+  int64_t &at(size_t index) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    return const_cast<int64_t &>(std::as_const(*this).at(index));
+  }
+  [[nodiscard]] const int64_t &at(size_t index) const {
+    if (index >= size_) {
+      throw std::out_of_range("Shape index out of range");
+    }
+    return data()[index];
+  }
+  int64_t &front() { return *begin(); }
+  [[nodiscard]] const int64_t &front() const { return *begin(); }
+  int64_t &back() { return *(end() - 1); }
+  [[nodiscard]] const int64_t &back() const { return *(end() - 1); }
+
+  /// Reserve room for size dimensions
+  void reserve(size_t size) {
+    if (size > kInlineDims) {
+      heap_.reserve(size);
+    }
+  }
+  /// Change the number of dimensions, filling new ones with value
+  void resize(size_t size, int64_t value = 0) {
+    if (size > kInlineDims) {
+      if (size_ <= kInlineDims) {
+        heap_.assign(inline_.begin(), inline_.begin() + size_);
+      }
+      heap_.resize(size, value);
+    } else {
+      if (size_ > kInlineDims) {
+        std::copy(heap_.begin(), heap_.begin() + size, inline_.begin());
+        heap_.clear();
+      } else if (size > size_) {
+        std::fill(inline_.begin() + size_, inline_.begin() + size, value);
+      }
+    }
+    size_ = size;
+  }
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  void push_back(int64_t dim) { this->resize(size_ + 1, dim); }
+  void clear() { this->resize(0); }
+
+  friend bool operator==(const Shape &lhs, const Shape &rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+  friend bool operator!=(const Shape &lhs, const Shape &rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  std::array<int64_t, kInlineDims> inline_{};
+  // only holds the dimensions if there are more than kInlineDims
+  std::vector<int64_t> heap_;
+  size_t size_ = 0;
+};
+
+/// The distance, in elements, between consecutive indices of each dimension
+using Strides = Shape;
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_SHAPE
@@ -0,0 +1,145 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the system shared memory that clients on the same host as
+ * the server can use to pass tensors without sending their data
+ */
+
+#ifndef GUARD_AMDINFER_CORE_SHARED_MEMORY
+#define GUARD_AMDINFER_CORE_SHARED_MEMORY
+
+#include <cstddef>  // for size_t, byte
+#include <string>   // for string
+
+namespace amdinfer {
+
+class InferenceRequestInput;
+class InferenceRequestOutput;
+class ParameterMap;
+
+/// Tensor parameter naming the registered region that holds the tensor
+constexpr auto kSharedMemoryRegion = "shared_memory_region";
+/// Tensor parameter with the offset of the tensor in its region
+constexpr auto kSharedMemoryOffset = "shared_memory_offset";
+/// Tensor parameter with the bytes the tensor has in its region
+constexpr auto kSharedMemoryByteSize = "shared_memory_byte_size";
+
+/// A system shared memory region registered with the server
+struct SharedMemoryStatus {
+  /// The name that requests refer to the region by
+  std::string name;
+  /// The key of the POSIX shared memory object, such as "/input"
+  std::string key;
+  /// Offset of the region in the object
+  size_t offset = 0;
+  /// Size of the region
+  size_t byte_size = 0;
+};
+
+/**
+ * @brief A POSIX shared memory object mapped into this process. A client
+ * creates one, writes its requests' inputs into it and registers it with a
+ * server on the same host, which maps the same object. Requests then refer to
+ * their tensors by the region's name and an offset instead of sending their
+ * data, and outputs can be written into it by the server.
+ */
+class SystemSharedMemory {
+ public:
+  /**
+   * @brief Map a shared memory object, creating it first if asked to. Throws
+   * invalid_argument if it doesn't exist or is smaller than the region and
+   * external_error if it can't be created or mapped
+   *
+   * @param key the key of the object, such as "/input"
+   * @param byte_size size of the region to map
+   * @param offset offset of the region in the object
+   * @param create if true, the object is created with the size of the region
+   * and removed when this is destroyed
+   */
+  SystemSharedMemory(const std::string& key, size_t byte_size,
+                     size_t offset = 0, bool create = true);
+  ~SystemSharedMemory();  ///< Unmap the region and remove a created object
+  SystemSharedMemory(SystemSharedMemory const&) = delete;
+  SystemSharedMemory& operator=(const SystemSharedMemory&) = delete;
+  SystemSharedMemory(SystemSharedMemory&& other) = delete;
+  SystemSharedMemory& operator=(SystemSharedMemory&& other) = delete;
+
+  /// Get a pointer to the start of the region
+  [[nodiscard]] std::byte* data() const { return data_; }
+  /// Get the size of the region
+  [[nodiscard]] size_t size() const { return size_; }
+  /// Get the key of the object
+  [[nodiscard]] const std::string& getKey() const { return key_; }
+
+ private:
+  std::string key_;
+  // mmap() maps from a page boundary so the mapping may start before the data
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  std::byte* data_ = nullptr;
+  size_t size_ = 0;
+  bool created_ = false;
+};
+
+/**
+ * @brief Set an input to be read from a registered region instead of sending
+ * its data. Its shape and datatype must be set first
+ *
+ * @param input the input
+ * @param region the name the region was registered with
+ * @param offset offset of the input's data in the region
+ */
+void useSharedMemory(InferenceRequestInput* input, const std::string& region,
+                     size_t offset = 0);
+/**
+ * @brief Ask for an output to be written to a registered region instead of
+ * being sent in the response. The response's output has no data
+ *
+ * @param output the output
+ * @param region the name the region was registered with
+ * @param byte_size room for the output in the region
+ * @param offset offset of the output in the region
+ */
+void useSharedMemory(InferenceRequestOutput* output, const std::string& region,
+                     size_t byte_size, size_t offset = 0);
+
+/// Check if a tensor's parameters place it in shared memory
+[[nodiscard]] bool isInSharedMemory(const ParameterMap& parameters);
+/**
+ * @brief Get the offset or size of a tensor in shared memory from its
+ * parameters. Throws invalid_argument if it's not a non-negative integer
+ *
+ * @param parameters the tensor's parameters
+ * @param key kSharedMemoryOffset or kSharedMemoryByteSize
+ * @return size_t the value or 0 if it's not set
+ */
+[[nodiscard]] size_t getSharedMemorySize(const ParameterMap& parameters,
+                                         const std::string& key);
+/**
+ * @brief Set the offset or size of a tensor in shared memory in its
+ * parameters. Integer parameters are 32-bit so larger values are stored as
+ * doubles, which hold them exactly up to 2^53
+ *
+ * @param parameters the tensor's parameters
+ * @param key kSharedMemoryOffset or kSharedMemoryByteSize
+ * @param value the value
+ */
+void setSharedMemorySize(ParameterMap* parameters, const std::string& key,
+                         size_t value);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_SHARED_MEMORY
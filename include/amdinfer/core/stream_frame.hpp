@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the binary messages that streaming workers send over
+ * websocket
+ */
+
+#ifndef GUARD_AMDINFER_CORE_STREAM_FRAME
+#define GUARD_AMDINFER_CORE_STREAM_FRAME
+
+#include <cstdint>      // for uint8_t, uint16_t, uint64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+namespace amdinfer {
+
+/// Encoding of the image in a StreamFrame
+enum class StreamFrameFormat : uint8_t {
+  /// no image, e.g. for the first message of a stream with its metadata
+  Empty,
+  /// a JPEG file
+  Jpeg,
+  /// packed 8-bit BGR pixels, row by row
+  Bgr
+};
+
+/**
+ * @brief One message of a video stream. Streaming workers send these as
+ * binary websocket messages if the request has the "binary" parameter set to
+ * true instead of JSON text with the image as a base64 data URL, which saves
+ * the encoding on the server and a third of the size on the wire.
+ *
+ * @details Serialized, a frame is a fixed 24-byte header followed by the key,
+ * the results and the image. All integers are little-endian:
+ *
+ * | Bytes | Field                        |
+ * |-------|------------------------------|
+ * | 0-3   | magic "AMDF"                 |
+ * | 4     | version (1)                  |
+ * | 5     | format                       |
+ * | 6-7   | width                        |
+ * | 8-9   | height                       |
+ * | 10-11 | length of the key            |
+ * | 12-15 | length of the results        |
+ * | 16-23 | index of the frame           |
+ */
+struct StreamFrame {
+  /// the key the client sent with the request
+  std::string key;
+  /// index of the frame in the stream
+  uint64_t index = 0;
+  /// the worker's results for the frame as JSON, e.g. the boxes to draw
+  std::string results;
+  /// how the image is encoded
+  StreamFrameFormat format = StreamFrameFormat::Empty;
+  /// width of the image in pixels. Only set for raw images
+  uint16_t width = 0;
+  /// height of the image in pixels. Only set for raw images
+  uint16_t height = 0;
+  /// the image, encoded according to the format
+  std::string data;
+};
+
+/**
+ * @brief Serialize a frame into a binary message. The image is copied from
+ * the given bytes so it doesn't need to be copied into the frame first
+ *
+ * @param frame the frame. Its data is ignored
+ * @param image the image to send
+ * @return std::string
+ */
+std::string serializeStreamFrame(const StreamFrame& frame,
+                                 std::string_view image);
+
+/// Serialize a frame, including its data, into a binary message
+std::string serializeStreamFrame(const StreamFrame& frame);
+
+/**
+ * @brief Parse a binary message into a frame
+ *
+ * @param message the message
+ * @return StreamFrame
+ * @throws invalid_argument if the message isn't a valid frame
+ */
+StreamFrame parseStreamFrame(std::string_view message);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_STREAM_FRAME
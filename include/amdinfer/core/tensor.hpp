@@ -21,10 +21,10 @@
 #define GUARD_AMDINFER_CORE_TENSOR
 
 #include <string>
-#include <vector>
 
 #include "amdinfer/core/data_types.hpp"
 #include "amdinfer/core/mixins.hpp"
+#include "amdinfer/core/shape.hpp"  // IWYU pragma: export
 
 namespace amdinfer {
 
@@ -33,7 +33,7 @@ namespace amdinfer {
  */
 class Tensor : public Serializable {
  public:
-  Tensor(std::string name, std::vector<int64_t> shape, DataType data_type);
+  Tensor(std::string name, Shape shape, DataType data_type);
 
   /// Get the tensor's name
   [[nodiscard]] const std::string &getName() const &;
@@ -42,10 +42,10 @@ class Tensor : public Serializable {
   void setName(std::string name);
 
   /// Get the tensor's shape
-  [[nodiscard]] const std::vector<int64_t> &getShape() const &;
-  [[nodiscard]] std::vector<int64_t> getShape() &&;
+  [[nodiscard]] const Shape &getShape() const &;
+  [[nodiscard]] Shape getShape() &&;
   /// Sets the tensor's shape
-  void setShape(std::vector<int64_t> shape);
+  void setShape(Shape shape);
 
   /// Get the tensor's datatype
   [[nodiscard]] DataType getDatatype() const;
@@ -80,7 +80,7 @@ class Tensor : public Serializable {
 
  private:
   std::string name_;
-  std::vector<int64_t> shape_;
+  Shape shape_;
   DataType data_type_;
 };
 
@@ -0,0 +1,122 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the binary trace files that servers capture requests to and
+ * that the load generator replays
+ */
+
+#ifndef GUARD_AMDINFER_CORE_TRAFFIC_TRACE
+#define GUARD_AMDINFER_CORE_TRAFFIC_TRACE
+
+#include <chrono>      // for nanoseconds
+#include <cstddef>     // for byte
+#include <filesystem>  // for path
+#include <fstream>     // for ifstream, ofstream
+#include <mutex>       // for mutex
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+
+namespace amdinfer {
+
+/**
+ * @brief One captured request. The request's inputs point into the data so
+ * the record may be moved but not copied without pointing them at the copy.
+ */
+struct TraceRecord {
+  /// when the request arrived, from the start of the capture
+  std::chrono::nanoseconds time{0};
+  /// the model or worker the request was for
+  std::string model;
+  /// the version of the model or empty
+  std::string version;
+  /// the request with its ID, parameters, inputs and requested outputs
+  InferenceRequest request;
+  /// the data of each input. Inputs that were captured without their data
+  /// are zeroed
+  std::vector<std::vector<std::byte>> data;
+  /// true if the data of the inputs was captured
+  bool payload = false;
+};
+
+/**
+ * @brief Writes requests to a trace file. A trace is the magic "AMDT" and a
+ * 32-bit version followed by one record per request, each prefixed by its
+ * size. All integers are little-endian. Records hold the time, model,
+ * version, ID and parameters of the request, the name, datatype, shape and
+ * parameters of each input and, optionally, its data, and the names of the
+ * requested outputs.
+ */
+class TraceWriter {
+ public:
+  /**
+   * @brief Start a trace, replacing the file if it exists
+   *
+   * @param path path to the trace
+   * @param payload if true, the data of the inputs is written too. Otherwise,
+   * only their shapes are
+   * @throws runtime_error if the file can't be opened
+   */
+  TraceWriter(const std::filesystem::path& path, bool payload);
+
+  /**
+   * @brief Add a request to the trace. It's safe to call from many threads
+   *
+   * @param time when the request arrived, from the start of the capture
+   * @param model the model or worker the request is for
+   * @param version the version of the model or empty
+   * @param request the request
+   */
+  void write(std::chrono::nanoseconds time, const std::string& model,
+             const std::string& version, const InferenceRequest& request);
+  /// Write the buffered records to the file
+  void flush();
+
+ private:
+  bool payload_;
+  std::mutex mutex_;
+  std::ofstream file_;
+};
+
+/// Reads the requests of a trace file in the order they were written
+class TraceReader {
+ public:
+  /**
+   * @brief Open a trace
+   *
+   * @param path path to the trace
+   * @throws file_read_error if the file can't be opened
+   * @throws invalid_argument if it isn't a trace
+   */
+  explicit TraceReader(const std::filesystem::path& path);
+
+  /**
+   * @brief Read the next record
+   *
+   * @param record the record to read into
+   * @return bool false if there are no more records
+   * @throws invalid_argument if the record is malformed
+   */
+  bool read(TraceRecord* record);
+
+ private:
+  std::ifstream file_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_TRAFFIC_TRACE
@@ -0,0 +1,169 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a move-only function wrapper with inline storage
+ */
+
+#ifndef GUARD_AMDINFER_CORE_UNIQUE_FUNCTION
+#define GUARD_AMDINFER_CORE_UNIQUE_FUNCTION
+
+#include <cstddef>      // for size_t, max_align_t, nullptr_t
+#include <functional>   // for invoke
+#include <new>          // for launder
+#include <type_traits>  // for decay_t, enable_if_t, is_same_v...
+#include <utility>      // for forward, move
+
+namespace amdinfer {
+
+template <typename Signature, size_t InlineSize = 64>
+class UniqueFunction;
+
+/**
+ * @brief A move-only wrapper for a callable, like std::move_only_function.
+ * Callables that fit in InlineSize bytes are stored in the object itself so
+ * wrapping them doesn't allocate. Since the wrapper can't be copied, it can
+ * hold move-only callables and moving it never copies the callable.
+ *
+ * @tparam R return type of the callable
+ * @tparam Args argument types of the callable
+ * @tparam InlineSize bytes of inline storage for the callable
+ */
+template <typename R, typename... Args, size_t InlineSize>
+class UniqueFunction<R(Args...), InlineSize> {
+ public:
+  UniqueFunction() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  UniqueFunction(std::nullptr_t) {}
+
+  template <typename F, typename = std::enable_if_t<
+                          !std::is_same_v<std::decay_t<F>, UniqueFunction> &&
+                          std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  UniqueFunction(F&& function) {
+    using T = std::decay_t<F>;
+    if constexpr (std::is_pointer_v<T> || std::is_member_pointer_v<T>) {
+      if (function == nullptr) {
+        return;
+      }
+    }
+    if constexpr (storedInline<T>()) {
+      new (&storage_) T(std::forward<F>(function));
+    } else {
+      // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+      new (&storage_) T*(new T(std::forward<F>(function)));
+    }
+    ops_ = &kOps<T>;
+  }
+
+  UniqueFunction(const UniqueFunction&) = delete;
+  UniqueFunction& operator=(const UniqueFunction&) = delete;
+  UniqueFunction(UniqueFunction&& other) noexcept { this->take(other); }
+  UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+    if (this != &other) {
+      this->reset();
+      this->take(other);
+    }
+    return *this;
+  }
+  UniqueFunction& operator=(std::nullptr_t) noexcept {
+    this->reset();
+    return *this;
+  }
+  ~UniqueFunction() { this->reset(); }
+
+  R operator()(Args... args) {
+    return ops_->invoke(&storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+  friend bool operator==(const UniqueFunction& function, std::nullptr_t) {
+    return !function;
+  }
+  friend bool operator!=(const UniqueFunction& function, std::nullptr_t) {
+    return static_cast<bool>(function);
+  }
+
+  /// Check if a callable of type F would be stored without allocating
+  template <typename F>
+  static constexpr bool storedInline() {
+    return sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible_v<F>;
+  }
+
+ private:
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    // move the callable from one storage to another, leaving the source empty
+    void (*relocate)(void* from, void* to) noexcept;
+    void (*destroy)(void* storage) noexcept;
+  };
+
+  template <typename T>
+  static T* target(void* storage) {
+    if constexpr (storedInline<T>()) {
+      return std::launder(static_cast<T*>(storage));
+    } else {
+      return *std::launder(static_cast<T**>(storage));
+    }
+  }
+
+  template <typename T>
+  static constexpr Ops kOps{
+    [](void* storage, Args&&... args) -> R {
+      return static_cast<R>(
+        std::invoke(*target<T>(storage), std::forward<Args>(args)...));
+    },
+    [](void* from, void* to) noexcept {
+      if constexpr (storedInline<T>()) {
+        auto* source = target<T>(from);
+        new (to) T(std::move(*source));
+        source->~T();
+      } else {
+        new (to) T*(target<T>(from));
+      }
+    },
+    [](void* storage) noexcept {
+      if constexpr (storedInline<T>()) {
+        target<T>(storage)->~T();
+      } else {
+        delete target<T>(storage);  // NOLINT(cppcoreguidelines-owning-memory)
+      }
+    }};
+
+  void take(UniqueFunction& other) noexcept {
+    if (other.ops_ != nullptr) {
+      other.ops_->relocate(&other.storage_, &storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+
+  void reset() noexcept {
+    if (ops_ != nullptr) {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  static_assert(InlineSize >= sizeof(void*),
+                "The inline storage must be able to hold a pointer");
+  std::aligned_storage_t<InlineSize, alignof(std::max_align_t)> storage_;
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_UNIQUE_FUNCTION
@@ -16,22 +16,37 @@
 #ifndef GUARD_AMDINFER_DECLARATIONS
 #define GUARD_AMDINFER_DECLARATIONS
 
+#include <cstddef>
 #include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "amdinfer/core/unique_function.hpp"
+
 namespace amdinfer {
 
 class RequestContainer;
-using RequestContainerPtr = std::unique_ptr<RequestContainer>;
+/// Deleter that resets request containers and keeps them for reuse
+struct RequestContainerDeleter {
+  RequestContainerDeleter() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  RequestContainerDeleter(std::default_delete<RequestContainer> /*unused*/) {}
+  void operator()(RequestContainer *container) const;
+};
+using RequestContainerPtr =
+  std::unique_ptr<RequestContainer, RequestContainerDeleter>;
 
 class InferenceRequest;
 class InferenceResponse;
 using InferenceResponsePromisePtr =
   std::shared_ptr<std::promise<InferenceResponse>>;
-using Callback = std::function<void(const InferenceResponse &)>;
+// enough to hold the servers' callbacks inline. The largest is HTTP's, which
+// holds Drogon's callback and the set of outputs to return as binary
+constexpr size_t kCallbackInlineSize = 96;
+using Callback =
+  UniqueFunction<void(const InferenceResponse &), kCallbackInlineSize>;
 
 class Buffer;
 using BufferPtr = std::unique_ptr<Buffer>;
@@ -16,9 +16,12 @@
 #ifndef GUARD_AMDINFER_SERVERS_SERVER
 #define GUARD_AMDINFER_SERVERS_SERVER
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace amdinfer {
 
@@ -41,18 +44,65 @@ class Server {
    * @brief Start the HTTP server
    *
    * @param port port to use for the HTTP server
+   * @param threads number of I/O threads. 0 to pick it from the CPUs they may
+   * use: one per CPU in cpus or one per four CPUs if they aren't pinned
+   * @param cpus Linux CPU list, such as "0-3", to pin the I/O threads to. If
+   * it's set and setWorkerCpus hasn't been called, workers are restricted to
+   * the remaining CPUs. Empty to leave them unpinned
+   * @param decode_threads number of threads that decode inference requests
+   * so large requests don't hold up the I/O threads. They share the CPUs of
+   * the I/O threads. 0 to decode requests on the I/O threads
    */
-  void startHttp(uint16_t port) const;
+  void startHttp(uint16_t port, int threads = 0, const std::string& cpus = "",
+                 int decode_threads = 0) const;
   /// Stop the HTTP server
   void stopHttp() const;
   /**
    * @brief Start the gRPC server
    *
    * @param port port to use for the gRPC server
+   * @param socket path of a Unix domain socket that the gRPC server listens on
+   * as well. Clients on the same host connect to it with the address
+   * "unix:<path>" to skip the TCP stack. Empty for none
    */
-  void startGrpc(uint16_t port) const;
+  void startGrpc(uint16_t port, const std::string& socket = "") const;
   /// Stop the gRPC server
   void stopGrpc() const;
+  /**
+   * @brief Start the io_uring server, which speaks the binary inference
+   * protocol defined in binary_protocol.hpp
+   *
+   * @param port port to use for the io_uring server
+   * @param threads number of threads, each with its own ring. 0 for one per
+   * NUMA node
+   * @param cpus Linux CPU list, such as "0-3", to pin the threads to, one CPU
+   * each. If it's set and setWorkerCpus hasn't been called, workers are
+   * restricted to the remaining CPUs. Empty to leave them unpinned
+   */
+  void startUring(uint16_t port, int threads = 0,
+                  const std::string& cpus = "") const;
+  /// Stop the io_uring server
+  void stopUring() const;
+  /**
+   * @brief Restrict the threads of workers loaded afterwards to a set of CPUs.
+   * Workers loaded with the cpus or numa_node parameters are placed by them
+   * instead.
+   *
+   * @param cpus Linux CPU list, such as "4-31"
+   */
+  void setWorkerCpus(const std::string& cpus) const;
+  /**
+   * @brief Run as one of several shards of a server on one host, as started
+   * by amdinfer-server --processes. The HTTP and gRPC servers share their
+   * ports with the other shards, only the first shard listens on the gRPC
+   * Unix domain socket and the metrics endpoint reports the metrics of all the
+   * shards. Call it before starting them.
+   *
+   * @param directory directory that the shards and their supervisor exchange
+   * metrics in
+   * @param index index of this shard
+   */
+  void enableSharding(const std::filesystem::path& directory, int index);
 
   /**
    * @brief Set the path to the model repository associated with this server
@@ -72,6 +122,105 @@ class Server {
    * platforms.
    */
   void enableRepositoryMonitoring(bool use_polling);
+  /**
+   * @brief Load the models in the model repository when their first request
+   * arrives instead of up front. Requests wait while their model loads. A
+   * model repository must be set with setModelRepository() before calling
+   * this method.
+   *
+   * @param memory_budget bytes that the models may use. The least recently
+   * used models are unloaded to make room for a new one. 0 for no limit
+   * @param idle_timeout seconds after which an unused model is unloaded. 0 to
+   * keep them loaded
+   */
+  void enableLazyLoading(size_t memory_budget, int idle_timeout);
+  /**
+   * @brief Refuse requests at the HTTP and gRPC servers, before they're
+   * decoded, when the server is overloaded. Call it before starting them.
+   *
+   * @param target_latency milliseconds within which requests should be
+   * served. If no request is served in time for 100 ms, requests are queueing
+   * and new ones are refused until one is served in time again. Set it above
+   * the normal latency of the slowest model. 0 to only limit the requests in
+   * flight
+   * @param max_inflight most requests in flight in the server. 0 for no limit
+   */
+  void enableLoadShedding(int target_latency, size_t max_inflight);
+  /**
+   * @brief Limit the rate of requests that each tenant may send to the HTTP
+   * and gRPC servers with a token bucket per tenant. Call it before starting
+   * them.
+   *
+   * @param rate requests per second that each tenant may send
+   * @param burst most requests that a tenant may send at once. If it's less
+   * than 1, it's the rate
+   * @param tenant_key the HTTP header or gRPC metadata key that identifies the
+   * tenant. Requests without it share one bucket
+   */
+  void enableRateLimiting(double rate, double burst,
+                          const std::string& tenant_key);
+  /**
+   * @brief Account for the CPU time and copies that the HTTP and gRPC servers
+   * spend on each request while decoding it, batching it, running it and
+   * encoding its response. They're exported as the
+   * amdinfer_cpu_time_microseconds_total and amdinfer_copied_bytes_total
+   * metrics, labelled with the model and tenant. Reading a thread's CPU time
+   * is a system call so it's off by default. Call it before starting them.
+   *
+   * @param tenant_key the HTTP header or gRPC metadata key that identifies the
+   * tenant. Requests without it aren't labelled with one
+   */
+  void enableUsageAccounting(const std::string& tenant_key);
+  /**
+   * @brief Report the server, and each model, as not ready while its load is
+   * at or above a threshold so load balancers that probe readiness send
+   * traffic elsewhere. The load is the largest of the fraction of the
+   * in-flight limits in use, the queued batches per worker over the depth at
+   * which an endpoint is saturated and 1 while requests are shed for their
+   * latency. It's also reported in the amdinfer-load header of responses.
+   *
+   * @param threshold the load at which they're not ready, such as 1. 0 to
+   * always be ready
+   * @param saturated_batches queued batches per worker that saturate an
+   * endpoint
+   */
+  void enableOverloadReadiness(double threshold, double saturated_batches);
+  /**
+   * @brief Open the libraries of workers in the background so their first
+   * load doesn't have to. Their symbols are bound as they're opened and they
+   * stay open while the server runs. Libraries that can't be opened are
+   * skipped with a warning
+   *
+   * @param workers the workers to preload, such as "migraphx"
+   */
+  void preloadWorkers(const std::vector<std::string>& workers);
+  /**
+   * @brief Record the workers and models loaded through the API afterwards in
+   * a manifest file, which is replaced atomically as they're loaded and
+   * unloaded. A server started after a crash or on a replacement node can
+   * restore them from it. Call it after setting the model repository and the
+   * worker CPUs and before starting the HTTP and gRPC servers.
+   *
+   * @param path path to the manifest
+   * @param restore first load the endpoints recorded in the manifest already,
+   * in parallel where they don't depend on each other. Compiled models are
+   * reused from the artifact cache and endpoints that fail to load are
+   * skipped with a warning
+   */
+  void enableManifest(const std::filesystem::path& path, bool restore);
+  /**
+   * @brief Capture a sample of the inference requests the server gets, with
+   * their arrival times, endpoints, parameters and inputs, to a binary trace
+   * that the load generator can replay. Call it before starting the HTTP and
+   * gRPC servers.
+   *
+   * @param path path to the trace, which is replaced if it exists
+   * @param rate fraction of the requests to capture, between 0 and 1
+   * @param payload capture the data of the inputs too. Otherwise, only their
+   * shapes are captured and they're replayed with zeros
+   */
+  void enableCapture(const std::filesystem::path& path, double rate,
+                     bool payload);
 
   friend class NativeClient;
 
@@ -19,22 +19,119 @@
 
 #include "amdinfer/batching/batch.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
 
 #include "amdinfer/buffers/buffer.hpp"
+#include "amdinfer/core/inference_request.hpp"
+#include "amdinfer/core/request_usage.hpp"
+#include "amdinfer/core/server_timing.hpp"
 #include "amdinfer/observation/tracing.hpp"
+#include "amdinfer/util/object_pool.hpp"
 
 namespace amdinfer {
 
+namespace {
+
+// released batches kept across all the batchers and workers
+constexpr size_t kMaxPooledBatches = 256;
+
+util::ObjectPool<Batch>& batchPool() {
+  // leaked so batches released during static destruction are still safe
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  static auto* pool = new util::ObjectPool<Batch>(kMaxPooledBatches);
+  return *pool;
+}
+
+}  // namespace
+
+void BatchDeleter::operator()(Batch* batch) const {
+  batch->clear();
+  batchPool().release(batch);
+}
+
+BatchPtr Batch::create(size_t capacity) {
+  BatchPtr batch{batchPool().take()};
+  if (batch == nullptr) {
+    batch.reset(new Batch);  // NOLINT(cppcoreguidelines-owning-memory)
+  }
+  batch->reserve(capacity);
+  return batch;
+}
+
+void Batch::reserve(size_t capacity) {
+  requests_.reserve(capacity);
+  request_buffers_.reserve(capacity);
+  models_.reserve(capacity);
+#ifdef AMDINFER_ENABLE_TRACING
+  traces_.reserve(capacity);
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  start_times_.reserve(capacity);
+#endif
+}
+
+void Batch::clear() {
+  requests_.clear();
+  input_buffers_.clear();
+  output_buffers_.clear();
+  request_buffers_.clear();
+  models_.clear();
+  metered_ = 0;
+#ifdef AMDINFER_ENABLE_TRACING
+  traces_.clear();
+  this->endSpan();
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  start_times_.clear();
+  metrics_.reset();
+#endif
+}
+
 void Batch::addRequest(InferenceRequestPtr request) {
+  if (auto* timing = request->getServerTiming(); timing != nullptr) {
+    timing->mark(ServerTiming::Batched);
+  }
+  if (request->getUsage() != nullptr) {
+    metered_++;
+  }
   requests_.push_back(std::move(request));
   // models_.emplace_back();
 }
 
-std::unique_ptr<Batch> Batch::propagate() {
+void Batch::markStage(ServerTiming::Stage stage) const {
+  for (const auto& request : requests_) {
+    if (auto* timing = request->getServerTiming(); timing != nullptr) {
+      timing->mark(stage);
+    }
+  }
+}
+
+void Batch::addUsage(RequestUsage::Stage stage,
+                     const UsageMeter& meter) const {
+  if (metered_ == 0 || requests_.empty()) {
+    return;
+  }
+  const auto size = static_cast<int64_t>(requests_.size());
+  const auto cpu_time = meter.getCpuTime() / size;
+  const auto bytes = meter.getCopiedBytes() / requests_.size();
+  for (const auto& request : requests_) {
+    if (auto* usage = request->getUsage(); usage != nullptr) {
+      usage->add(stage, cpu_time, bytes);
+    }
+  }
+}
+
+BatchPtr Batch::propagate() {
   const auto batch_size = this->size();
-  auto new_batch = std::make_unique<Batch>();
+  auto new_batch = Batch::create(batch_size);
   new_batch->models_.resize(batch_size);
+#ifdef AMDINFER_ENABLE_METRICS
+  new_batch->metrics_ = metrics_;
+#endif
 
   for (auto i = 0U; i < batch_size; ++i) {
     new_batch->setModel(i, this->getModel(i));
@@ -49,6 +146,63 @@ const BufferPtrs& Batch::getInputBuffers() const { return input_buffers_; }
 
 const BufferPtrs& Batch::getOutputBuffers() const { return output_buffers_; }
 
+const std::vector<BufferPtrs>& Batch::getRequestBuffers() const {
+  return request_buffers_;
+}
+
+bool Batch::isScatterGather() const { return !request_buffers_.empty(); }
+
+void Batch::freeInputBuffers() const {
+  for (const auto& buffer : input_buffers_) {
+    buffer->free();
+  }
+  for (const auto& buffers : request_buffers_) {
+    for (const auto& buffer : buffers) {
+      buffer->free();
+    }
+  }
+}
+
+namespace {
+
+struct SharedBuffers {
+  SharedBuffers() = default;
+  SharedBuffers(const SharedBuffers&) = delete;
+  SharedBuffers& operator=(const SharedBuffers&) = delete;
+  SharedBuffers(SharedBuffers&&) = delete;
+  SharedBuffers& operator=(SharedBuffers&&) = delete;
+  ~SharedBuffers() {
+    for (const auto& buffer : buffers) {
+      buffer->free();
+    }
+  }
+
+  BufferPtrs buffers;
+};
+
+}  // namespace
+
+std::shared_ptr<const void> Batch::shareInputBuffers() {
+  auto owner = std::make_shared<SharedBuffers>();
+  owner->buffers = std::move(input_buffers_);
+  input_buffers_.clear();
+  for (auto& buffers : request_buffers_) {
+    for (auto& buffer : buffers) {
+      owner->buffers.push_back(std::move(buffer));
+    }
+    // keep the (now empty) lists so the batch stays scatter-gather
+    buffers.clear();
+  }
+  return owner;
+}
+
+std::shared_ptr<const void> Batch::shareRequestBuffers(size_t index) {
+  auto owner = std::make_shared<SharedBuffers>();
+  owner->buffers = std::move(request_buffers_.at(index));
+  request_buffers_[index].clear();
+  return owner;
+}
+
 const std::vector<InferenceRequestPtr>& Batch::getRequests() const {
   return requests_;
 }
@@ -59,6 +213,12 @@ const InferenceRequestPtr& Batch::getRequest(size_t index) {
 
 bool Batch::empty() const { return requests_.empty(); }
 
+bool Batch::isCancelled() const {
+  return !requests_.empty() &&
+         std::all_of(requests_.begin(), requests_.end(),
+                     [](const auto& request) { return request->isCancelled(); });
+}
+
 size_t Batch::size() const {
   // assert(requests_.size() == models_.size());
 
@@ -74,6 +234,10 @@ void Batch::setBuffers(BufferPtrs inputs, BufferPtrs outputs) {
   output_buffers_ = std::move(outputs);
 }
 
+void Batch::addRequestBuffers(BufferPtrs buffers) {
+  request_buffers_.push_back(std::move(buffers));
+}
+
 const std::string& Batch::getModel(size_t index) const {
   return models_.at(index);
 }
@@ -93,16 +257,35 @@ void Batch::addModel(std::string model) {
 void Batch::addTrace(TracePtr trace) { traces_.push_back(std::move(trace)); }
 
 TracePtr& Batch::getTrace(size_t index) { return traces_.at(index); }
+
+void Batch::startSpan(const std::string& name) {
+  span_ = startBatchSpan(name, traces_);
+}
+
+void Batch::endSpan() {
+  if (span_ != nullptr) {
+    span_->End();
+    span_.reset();
+  }
+}
 #endif
 
 #ifdef AMDINFER_ENABLE_METRICS
-void Batch::addTime(std::chrono::high_resolution_clock::time_point timestamp) {
+void Batch::addTime(util::Timestamp timestamp) {
   start_times_.push_back(timestamp);
 }
 
-std::chrono::high_resolution_clock::time_point Batch::getTime(size_t index) {
-  return start_times_.at(index);
+util::Timestamp Batch::getTime(size_t index) { return start_times_.at(index); }
+
+void Batch::setMetrics(std::shared_ptr<ModelMetrics> metrics) {
+  metrics_ = std::move(metrics);
 }
+
+ModelMetrics* Batch::getMetrics() const { return metrics_.get(); }
+
+void Batch::setStageTime(util::Timestamp timestamp) { stage_time_ = timestamp; }
+
+util::Timestamp Batch::getStageTime() const { return stage_time_; }
 #endif
 
 }  // namespace amdinfer
@@ -20,11 +20,36 @@
 #ifndef GUARD_AMDINFER_BATCHING_BATCH
 #define GUARD_AMDINFER_BATCHING_BATCH
 
+#include <cstddef>  // for size_t
+#include <memory>   // for shared_ptr, unique_ptr
+#include <string>   // for string
+
 #include "amdinfer/build_options.hpp"
+#include "amdinfer/core/request_usage.hpp"  // for RequestUsage, UsageMeter
+#include "amdinfer/core/server_timing.hpp"  // for ServerTiming
 #include "amdinfer/declarations.hpp"
+#include "amdinfer/observation/tracing.hpp"  // for SpanPtr
+#include "amdinfer/util/timestamps.hpp"      // for Timestamp
 
 namespace amdinfer {
 
+class Batch;
+class ModelMetrics;
+
+/**
+ * @brief Deleter for batches that resets them and keeps them for reuse instead
+ * of freeing them. It converts from the default deleter so batches made with
+ * std::make_unique can still be held in a BatchPtr.
+ */
+struct BatchDeleter {
+  BatchDeleter() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  BatchDeleter(std::default_delete<Batch> /*unused*/) {}
+  void operator()(Batch* batch) const;
+};
+
+using BatchPtr = std::unique_ptr<Batch, BatchDeleter>;
+
 /**
  * @brief The Batch is what the batcher produces and pushes to the workers. It
  * represents the requests, the buffers associated with the request and other
@@ -33,16 +58,72 @@ namespace amdinfer {
  */
 class Batch {
  public:
+  /**
+   * @brief Get an empty batch, reusing a released one if there is one. The
+   * batch's lists are reserved to the capacity so adding up to that many
+   * requests to it doesn't allocate.
+   *
+   * @param capacity the number of requests the batch is expected to hold
+   * @return BatchPtr
+   */
+  static BatchPtr create(size_t capacity = 0);
+
   void addRequest(InferenceRequestPtr request);
-  std::unique_ptr<Batch> propagate();
+  /// Mark that the batch's timed requests reached a stage of the server
+  void markStage(ServerTiming::Stage stage) const;
+  /// Check if any of the batch's requests account for their usage
+  [[nodiscard]] bool hasUsage() const { return metered_ > 0; }
+  /**
+   * @brief Split what a meter measured for the whole batch evenly between
+   * its requests and add the shares to the usage of those that account for it
+   *
+   * @param stage the stage to add to
+   * @param meter the meter
+   */
+  void addUsage(RequestUsage::Stage stage, const UsageMeter& meter) const;
+  BatchPtr propagate();
 
   void setBuffers(BufferPtrs inputs, BufferPtrs outputs);
+  /**
+   * @brief Add the input buffers of one request to the batch's scatter-gather
+   * list. This is used instead of setBuffers if the batcher doesn't copy the
+   * requests' inputs into contiguous buffers.
+   *
+   * @param buffers the request's input buffers
+   */
+  void addRequestBuffers(BufferPtrs buffers);
   [[nodiscard]] const InferenceRequestPtr& getRequest(size_t index);
   [[nodiscard]] const std::vector<InferenceRequestPtr>& getRequests() const;
   [[nodiscard]] const std::vector<BufferPtr>& getInputBuffers() const;
   [[nodiscard]] const std::vector<BufferPtr>& getOutputBuffers() const;
+  /// Get the per-request input buffers of a scatter-gather batch
+  [[nodiscard]] const std::vector<BufferPtrs>& getRequestBuffers() const;
+  /// Check if the batch's inputs are per-request instead of contiguous
+  [[nodiscard]] bool isScatterGather() const;
+  /// Return all the batch's input buffers to their memory pool
+  void freeInputBuffers() const;
+  /**
+   * @brief Move the batch's input buffers into a shared owner that returns
+   * them to their memory pool when the last reference to it is dropped. The
+   * batch no longer frees these buffers so responses can view the inputs'
+   * memory until they're serialized instead of copying it.
+   *
+   * @return std::shared_ptr<const void>
+   */
+  std::shared_ptr<const void> shareInputBuffers();
+  /**
+   * @brief Move one request's input buffers of a scatter-gather batch into a
+   * shared owner like shareInputBuffers. This lets requests that outlive their
+   * batch return their memory to the pool independently.
+   *
+   * @param index the request's index in the batch
+   * @return std::shared_ptr<const void>
+   */
+  std::shared_ptr<const void> shareRequestBuffers(size_t index);
 
   [[nodiscard]] bool empty() const;
+  /// Check if the clients of all the batch's requests have cancelled them
+  [[nodiscard]] bool isCancelled() const;
   [[nodiscard]] size_t size() const;
   [[nodiscard]] size_t getInputSize() const;
   [[nodiscard]] size_t getOutputSize() const;
@@ -54,30 +135,55 @@ class Batch {
 #ifdef AMDINFER_ENABLE_TRACING
   void addTrace(TracePtr trace);
   TracePtr& getTrace(size_t index);
+  /**
+   * @brief Start one span for the work done on the whole batch, linked to the
+   * traces of its sampled requests. Nothing is recorded if none are sampled
+   */
+  void startSpan(const std::string& name);
+  /// End the batch's span, if it has one
+  void endSpan();
 #endif
 #ifdef AMDINFER_ENABLE_METRICS
-  void addTime(std::chrono::high_resolution_clock::time_point timestamp);
-  std::chrono::high_resolution_clock::time_point getTime(size_t index);
+  void addTime(util::Timestamp timestamp);
+  util::Timestamp getTime(size_t index);
+  /// Set the metrics of the endpoint whose batcher made the batch
+  void setMetrics(std::shared_ptr<ModelMetrics> metrics);
+  /// Get the metrics of the endpoint whose batcher made the batch, if any
+  [[nodiscard]] ModelMetrics* getMetrics() const;
+  /// Set when the batch entered its current stage of the pipeline
+  void setStageTime(util::Timestamp timestamp);
+  /// Get when the batch entered its current stage of the pipeline
+  [[nodiscard]] util::Timestamp getStageTime() const;
 #endif
 
   [[nodiscard]] auto begin() const { return requests_.begin(); }
   [[nodiscard]] auto end() const { return requests_.end(); }
 
  private:
+  friend BatchDeleter;
+
+  void reserve(size_t capacity);
+  /// Reset the batch to empty, keeping the capacity of its lists
+  void clear();
+
   std::vector<InferenceRequestPtr> requests_;
   std::vector<BufferPtr> input_buffers_;
   std::vector<BufferPtr> output_buffers_;
+  std::vector<BufferPtrs> request_buffers_;
   std::vector<std::string> models_;
+  // the number of requests that account for their usage
+  size_t metered_ = 0;
 #ifdef AMDINFER_ENABLE_TRACING
   std::vector<TracePtr> traces_;
+  SpanPtr span_;
 #endif
 #ifdef AMDINFER_ENABLE_METRICS
-  std::vector<std::chrono::high_resolution_clock::time_point> start_times_;
+  std::vector<util::Timestamp> start_times_;
+  std::shared_ptr<ModelMetrics> metrics_;
+  util::Timestamp stage_time_;
 #endif
 };
 
-using BatchPtr = std::unique_ptr<Batch>;
-
 }  // namespace amdinfer
 
 #endif  // GUARD_AMDINFER_BATCHING_BATCH
@@ -0,0 +1,48 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the view of a batch's tensors passed to batch-native models
+ */
+
+#ifndef GUARD_AMDINFER_BATCHING_BATCH_TENSORS
+#define GUARD_AMDINFER_BATCHING_BATCH_TENSORS
+
+#include <cstddef>  // for size_t
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+
+namespace amdinfer {
+
+/**
+ * @brief One tensor of every request in a batch, stored back to back in one
+ * buffer. Request j's data is the bytes from offsets[j] to offsets[j + 1] so
+ * there is one more offset than there are requests and the last offset is the
+ * size of the data of the whole batch.
+ */
+struct BatchTensor {
+  /// The start of the tensor's data for the whole batch
+  void* data = nullptr;
+  /// The byte offset of each request's data relative to data
+  std::vector<size_t> offsets;
+  DataType datatype;
+};
+
+using BatchTensors = std::vector<BatchTensor>;
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_BATCHING_BATCH_TENSORS
@@ -20,19 +20,169 @@
 
 #include "amdinfer/batching/batcher.hpp"
 
-#include <cassert>  // for assert
-#include <memory>   // for shared_ptr, make_shared
-#include <string>   // for string
-#include <utility>  // for move
-
-#include "amdinfer/buffers/buffer.hpp"          // IWYU pragma: keep
-#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
-#include "amdinfer/core/request_container.hpp"  // for InferenceRequestInput
-#include "amdinfer/core/worker_info.hpp"        // for WorkerInfo
+#include <algorithm>     // for clamp, max, min, sort
+#include <array>         // for array
+#include <cassert>       // for assert
+#include <chrono>        // for duration, duration_cast, milliseconds
+#include <cmath>         // for floor, isfinite
+#include <cstddef>       // for byte, size_t
+#include <cstdint>       // for int32_t, int64_t
+#include <cstring>       // for memcpy
+#include <exception>     // for exception
+#include <limits>        // for numeric_limits
+#include <memory>        // for shared_ptr, make_shared
+#include <mutex>         // for mutex, lock_guard, unique_lock
+#include <optional>      // for optional
+#include <shared_mutex>  // for shared_lock
+#include <string>        // for string
+#include <utility>       // for move
+#include <variant>       // for bad_variant_access
+#include <vector>        // for vector
+
+#include "amdinfer/buffers/buffer.hpp"           // IWYU pragma: keep
+#include "amdinfer/buffers/cpu.hpp"              // for CpuBuffer
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/request_container.hpp"   // for InferenceRequestInput
+#include "amdinfer/core/request_usage.hpp"       // for UsageScope, countCopy
+#include "amdinfer/core/tensor.hpp"              // for Tensor
+#include "amdinfer/core/worker_info.hpp"         // for WorkerInfo
 #include "amdinfer/observation/logging.hpp"  // for Logger, Loggers, Logger...
+#include "amdinfer/observation/metrics.hpp"  // for Metrics, MetricGaugeIDs
+#include "amdinfer/observation/tracing.hpp"  // for Trace
+#include "amdinfer/util/float_convert.hpp"   // for convertDatatype
+#include "amdinfer/util/numa.hpp"            // for bindThreadToCpus
+#include "amdinfer/util/string.hpp"          // for split
+#include "amdinfer/util/timer.hpp"           // for getTime
+#include "amdinfer/util/timestamps.hpp"      // for now
 
 namespace amdinfer {
 
+namespace {
+
+/// Collects the responses to the samples of a request split by the batcher
+struct SplitResponses {
+  InferenceRequestPtr request;
+  size_t samples = 0;
+  std::mutex mutex;
+  /// The stacked outputs, shaped by the first sample to respond
+  std::vector<InferenceResponseOutput> outputs;
+  std::string model;
+  bool shaped = false;
+  size_t pending = 0;
+  bool done = false;
+  /// The samples whose callback hasn't run. Their inputs point into the
+  /// request's so its memory goes back to the pool after the last one
+  size_t unfinished = 0;
+};
+
+/**
+ * @brief Copy one sample's outputs into its place in the stacked outputs. The
+ * first sample to respond sets the names and sizes the others must match.
+ *
+ * @param state the split request
+ * @param index the index of the sample
+ * @param response the sample's response
+ */
+void stackSample(SplitResponses* state, size_t index,
+                 const InferenceResponse& response) {
+  const auto& outputs = response.getOutputs();
+  if (!state->shaped) {
+    state->model = response.getModel();
+    state->outputs.reserve(outputs.size());
+    for (const auto& output : outputs) {
+      InferenceResponseOutput stacked;
+      stacked.setName(output.getName());
+      stacked.setDatatype(output.getDatatype());
+      Shape shape{static_cast<int64_t>(state->samples)};
+      for (const auto dim : output.getShape()) {
+        shape.push_back(dim);
+      }
+      stacked.setShape(std::move(shape));
+      const auto size = output.getSize() * output.getDatatype().size();
+      stacked.setData(std::vector<std::byte>(size * state->samples));
+      state->outputs.push_back(std::move(stacked));
+    }
+    state->shaped = true;
+  }
+
+  if (outputs.size() != state->outputs.size()) {
+    throw invalid_argument("The samples of the request have different outputs");
+  }
+  for (auto k = 0U; k < outputs.size(); ++k) {
+    const auto& output = outputs[k];
+    auto& stacked = state->outputs[k];
+    const auto size = output.getSize() * output.getDatatype().size();
+    if (output.getName() != stacked.getName() ||
+        output.getSize() * state->samples != stacked.getSize()) {
+      throw invalid_argument("The samples of output " + stacked.getName() +
+                             " have different sizes");
+    }
+    std::memcpy(static_cast<std::byte*>(stacked.getData()) + (index * size),
+                output.getData(), size);
+  }
+}
+
+/// The longest "deadline" a request can set, in milliseconds
+constexpr auto kMaxDeadlineMs =
+  static_cast<double>(std::numeric_limits<int32_t>::max());
+
+/**
+ * @brief Get a numeric request parameter. Parameters parsed from JSON hold
+ * non-negative integers as int32_t and other numbers as double
+ *
+ * @param parameters the request's parameters
+ * @param key the parameter to get
+ * @return double
+ */
+double getNumber(const ParameterMap& parameters, const std::string& key) {
+  auto value = 0.0;
+  try {
+    return parameters.get<int32_t>(key);
+  } catch (const std::bad_variant_access&) {
+    try {
+      value = parameters.get<double>(key);
+    } catch (const std::bad_variant_access&) {
+      throw invalid_argument("The '" + key + "' parameter must be a number");
+    }
+  }
+  if (!std::isfinite(value)) {
+    throw invalid_argument("The '" + key + "' parameter must be finite");
+  }
+  return value;
+}
+
+/**
+ * @brief Get the order that transposes a tensor from one layout to another,
+ * where layouts name each dimension with a letter, such as NHWC
+ *
+ * @param from the tensor's layout
+ * @param to the layout to transpose to
+ * @return std::vector<size_t> the dimension of from that becomes each
+ * dimension of to
+ */
+std::vector<size_t> getLayoutOrder(const std::string& from,
+                                   const std::string& to) {
+  if (from.size() != to.size()) {
+    throw invalid_argument("Can't convert the layout " + from + " to " + to);
+  }
+  std::vector<size_t> order;
+  order.reserve(to.size());
+  for (const auto& dim : to) {
+    const auto index = from.find(dim);
+    if (index == std::string::npos || from.find(dim, index + 1) !=
+                                        std::string::npos) {
+      throw invalid_argument("Can't convert the layout " + from + " to " + to);
+    }
+    order.push_back(index);
+  }
+  return order;
+}
+
+}  // namespace
+
 /**
  * @brief The C++ RequestContainer class encapsulates incoming requests from the
  * C++ API to the batcher.
@@ -40,7 +190,7 @@ namespace amdinfer {
  */
 
 Batcher::Batcher(MemoryPool* pool) : pool_(pool) {
-  this->input_queue_ = std::make_shared<BlockingQueue<RequestContainerPtr>>();
+  this->input_queue_ = std::make_shared<RequestQueue>();
   this->output_queue_ = std::make_shared<BatchPtrQueue>();
   this->status_ = BatcherStatus::New;
 #ifdef AMDINFER_ENABLE_LOGGING
@@ -52,44 +202,449 @@ Batcher::Batcher(MemoryPool* pool, ParameterMap* parameters) : Batcher(pool) {
   if (parameters != nullptr) {
     this->parameters_ = *parameters;
   }
+  if (this->parameters_.has("batch_layout")) {
+    const auto layout = this->parameters_.get<std::string>("batch_layout");
+    if (layout == "scatter_gather") {
+      scatter_gather_ = true;
+    } else if (layout != "contiguous") {
+      throw invalid_argument("Unknown batch_layout: " + layout);
+    }
+  }
+  if (this->parameters_.has("timeout")) {
+    timeout_ = this->parameters_.get<int32_t>("timeout");
+  }
+  if (this->parameters_.has("deadline_margin")) {
+    deadline_margin_ = std::chrono::milliseconds(
+      this->parameters_.get<int32_t>("deadline_margin"));
+  }
+  if (this->parameters_.has("spin_us")) {
+    const auto spin = this->parameters_.get<int32_t>("spin_us");
+    if (spin < 0) {
+      throw invalid_argument("spin_us can't be negative");
+    }
+    spin_ = std::chrono::microseconds(spin);
+  }
+  if (this->parameters_.has("batch_datatype")) {
+    const auto datatype = this->parameters_.get<std::string>("batch_datatype");
+    batch_datatype_ = DataType(datatype.c_str());
+    if (batch_datatype_ == DataType::Bytes) {
+      throw invalid_argument("Inputs can't be cast to BYTES");
+    }
+    if (scatter_gather_) {
+      throw invalid_argument(
+        "batch_datatype can't be used with the scatter_gather batch_layout");
+    }
+  }
+  if (this->parameters_.has("input_layout")) {
+    input_layout_ = this->parameters_.get<std::string>("input_layout");
+    // checks that it's a valid layout
+    getLayoutOrder(input_layout_, input_layout_);
+    if (scatter_gather_) {
+      throw invalid_argument(
+        "input_layout can't be used with the scatter_gather batch_layout");
+    }
+  }
+  if (this->parameters_.has("preferred_batch_sizes")) {
+    const auto sizes =
+      this->parameters_.get<std::string>("preferred_batch_sizes");
+    for (const auto& size : util::split(sizes, ",")) {
+      const auto value = std::stoi(size);
+      if (value <= 0) {
+        throw invalid_argument("Preferred batch sizes must be positive");
+      }
+      preferred_batch_sizes_.push_back(static_cast<size_t>(value));
+    }
+    std::sort(preferred_batch_sizes_.begin(), preferred_batch_sizes_.end());
+  }
+  if (this->parameters_.has("priority_levels")) {
+    const auto levels = this->parameters_.get<int32_t>("priority_levels");
+    if (levels < 1 || levels > static_cast<int32_t>(kPriorityLanes)) {
+      throw invalid_argument("priority_levels must be between 1 and " +
+                             std::to_string(kPriorityLanes));
+    }
+    priority_levels_ = static_cast<size_t>(levels);
+  }
+  default_priority_ = std::min(default_priority_, priority_levels_ - 1);
+  if (this->parameters_.has("default_priority")) {
+    const auto priority = this->parameters_.get<int32_t>("default_priority");
+    if (priority < 0 || priority >= static_cast<int32_t>(priority_levels_)) {
+      throw invalid_argument("default_priority must be a priority level");
+    }
+    default_priority_ = static_cast<size_t>(priority);
+  }
 }
 
 Batcher::Batcher(const Batcher& batcher)
   : batch_size_(batcher.batch_size_),
+    next_batch_size_(batcher.getBatchSize()),
+    timeout_(batcher.getTimeout()),
+    scatter_gather_(batcher.scatter_gather_),
+    deadline_margin_(batcher.deadline_margin_),
+    spin_(batcher.spin_),
+    batch_datatype_(batcher.batch_datatype_),
+    input_layout_(batcher.input_layout_),
+    preferred_batch_sizes_(batcher.preferred_batch_sizes_),
+    priority_levels_(batcher.priority_levels_),
+    default_priority_(batcher.default_priority_),
     input_queue_(batcher.input_queue_),
     output_queue_(batcher.output_queue_),
+    doorbell_(batcher.doorbell_),
     model_(batcher.model_),
+    parameters_(batcher.parameters_),
     pool_(batcher.pool_) {
   this->status_ = BatcherStatus::New;
+#ifdef AMDINFER_ENABLE_METRICS
+  this->metrics_ = batcher.metrics_;
+#endif
 #ifdef AMDINFER_ENABLE_LOGGING
   this->logger_ = Logger(Loggers::Server);
 #endif
 }
 
+Batcher::~Batcher() {
+#ifdef AMDINFER_ENABLE_METRICS
+  // batchers made by copying share their queues so they share the watchers
+  if (metrics_ != nullptr) {
+    metrics_->unwatchGauges(input_queue_.get());
+  }
+#endif
+}
+
 void Batcher::start(const std::vector<MemoryAllocators>& allocators) {
+  this->allocators_ = allocators;
+  // casting uses a scratch buffer that only the batcher's thread may use
+  this->direct_ = this->canSendDirect() &&
+                  batch_datatype_ == DataType::Unknown &&
+                  (!this->parameters_.has("direct") ||
+                   this->parameters_.get<bool>("direct"));
   this->status_ = BatcherStatus::Run;
   this->thread_ = std::thread(&Batcher::run, this, allocators);
+  // run on the same CPUs as the worker so batches use its local memory. A
+  // batcher that spins can be given CPUs of its own so it doesn't take them
+  // from the worker
+  if (this->parameters_.has("batcher_cpus")) {
+    util::bindThreadToCpus(
+      this->thread_,
+      util::parseIdList(this->parameters_.get<std::string>("batcher_cpus")));
+  } else if (this->parameters_.has("cpus")) {
+    util::bindThreadToCpus(
+      this->thread_,
+      util::parseIdList(this->parameters_.get<std::string>("cpus")));
+  } else if (this->parameters_.has("numa_node")) {
+    util::bindThreadToNumaNode(this->thread_,
+                               this->parameters_.get<int32_t>("numa_node"));
+  }
 }
 
 void Batcher::setBatchSize(size_t batch_size) {
-  this->batch_size_ = batch_size;
+  next_batch_size_.store(batch_size, std::memory_order_relaxed);
 }
 
 void Batcher::setName(const std::string& name) { this->model_ = name; }
 
+size_t Batcher::getBatchSize() const {
+  return next_batch_size_.load(std::memory_order_relaxed);
+}
+
+void Batcher::setTimeout(int32_t timeout) {
+  timeout_.store(timeout, std::memory_order_relaxed);
+}
+
+int32_t Batcher::getTimeout() const {
+  return timeout_.load(std::memory_order_relaxed);
+}
+
 std::string Batcher::getName() const { return this->model_; }
 
-BlockingQueue<RequestContainerPtr>* Batcher::getInputQueue() {
-  return this->input_queue_.get();
+#ifdef AMDINFER_ENABLE_METRICS
+void Batcher::setMetrics(std::shared_ptr<ModelMetrics> metrics) {
+  static constexpr std::array<MetricGaugeIDs, kPriorityLanes> kLaneGauges{
+    MetricGaugeIDs::QueuesBatcherInputHigh,
+    MetricGaugeIDs::QueuesBatcherInputNormal,
+    MetricGaugeIDs::QueuesBatcherInputLow};
+
+  if (this->metrics_ != nullptr) {
+    this->metrics_->unwatchGauges(input_queue_.get());
+  }
+  this->metrics_ = std::move(metrics);
+  if (this->metrics_ == nullptr) {
+    return;
+  }
+
+  // the queue sizes are read when the metrics are scraped. The watchers keep
+  // the queues alive since they may be read from another thread
+  const auto* owner = input_queue_.get();
+  metrics_->watchGauge(owner, MetricGaugeIDs::QueuesBatcherInput,
+                       [queue = input_queue_]() {
+                         return static_cast<double>(queue->size_approx());
+                       });
+  for (auto i = 0U; i < kPriorityLanes; ++i) {
+    metrics_->watchGauge(owner, kLaneGauges.at(i), [queue = input_queue_, i]() {
+      return static_cast<double>(queue->size_approx(i));
+    });
+  }
+  metrics_->watchGauge(owner, MetricGaugeIDs::QueuesBatcherOutput,
+                       [queue = output_queue_]() {
+                         return static_cast<double>(queue->size_approx());
+                       });
 }
+#endif
+
+RequestQueue* Batcher::getInputQueue() { return this->input_queue_.get(); }
 
 BatchPtrQueue* Batcher::getOutputQueue() { return this->output_queue_.get(); }
 
+void Batcher::setDoorbell(
+  std::shared_ptr<moodycamel::LightweightSemaphore> doorbell) {
+  this->doorbell_ = std::move(doorbell);
+}
+
+bool Batcher::hasDoorbell() const { return this->doorbell_ != nullptr; }
+
+void Batcher::setInline(std::function<void(BatchPtr)> run) {
+  const std::unique_lock lock{inline_mutex_};
+  this->inline_ = std::move(run);
+}
+
+void Batcher::send(BatchPtr batch) const {
+  this->output_queue_->enqueue(std::move(batch));
+  if (doorbell_ != nullptr) {
+    doorbell_->signal();
+  }
+}
+
 void Batcher::enqueue(RequestContainerPtr request) const {
-  this->input_queue_->enqueue(std::move(request));
+  size_t lane = kPriorityLanes - 1;
+  if (request != nullptr) {
+    lane = default_priority_;
+    const auto& parameters = request->request->getParameters();
+    try {
+      if (parameters.has("priority")) {
+        // fractional priorities are rounded down and others clamped
+        const auto priority = std::floor(getNumber(parameters, "priority"));
+        lane = static_cast<size_t>(std::clamp(
+          priority, 0.0, static_cast<double>(priority_levels_ - 1)));
+      }
+      if (parameters.has("deadline")) {
+        const auto deadline_ms = getNumber(parameters, "deadline");
+        if (deadline_ms < 0) {
+          throw invalid_argument("The 'deadline' parameter can't be negative");
+        }
+        // capped so that adding it to the time can't overflow
+        const std::chrono::duration<double, std::milli> timeout{
+          std::min(deadline_ms, kMaxDeadlineMs)};
+        const auto deadline =
+          util::getTime() +
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            timeout);
+        request->deadline = std::min(request->deadline, deadline);
+      }
+    } catch (const invalid_argument& e) {
+      request->request->runCallbackError(e.what());
+      return;
+    }
+    if (!input_layout_.empty() && !this->convertLayouts(*request->request)) {
+      return;
+    }
+    // a batch of one can't be improved by waiting so it's made here. The lane
+    // doesn't matter since nothing is queued behind it in the batcher
+    if (direct_ && this->getBatchSize() == 1) {
+      this->sendDirect(std::move(request));
+      return;
+    }
+  }
+  this->input_queue_->enqueue(std::move(request), lane);
+}
+
+void Batcher::sendDirect(RequestContainerPtr request) const {
+  if (this->rejectExpired(*request)) {
+    return;
+  }
+
+  auto& req = request->request;
+  const auto& inputs = req->getInputs();
+  if (inputs.empty()) {
+    req->runCallbackError("Input size is zero");
+    return;
+  }
+  // the scope ends before the batch is sent since workers may run it inline
+  std::optional<UsageScope> usage;
+  usage.emplace(req->getUsage(), RequestUsage::Batch);
+
+  auto batch = Batch::create(1);
+#ifdef AMDINFER_ENABLE_METRICS
+  batch->setMetrics(metrics_);
+  this->recordIngress(batch.get(), *request);
+#endif
+#ifdef AMDINFER_ENABLE_TRACING
+  auto& trace = request->trace;
+  if (trace != nullptr) {
+    trace->startSpan("direct_batcher");
+  }
+#endif
+
+  if (scatter_gather_) {
+    this->gatherInputs(batch.get(), *req);
+  } else if (allocators_.empty() ||
+             allocators_.front() == MemoryAllocators::Cpu) {
+    this->densify(*req);
+    // the request's memory is already from the pool so the batch takes it
+    BufferPtrs buffers;
+    buffers.reserve(inputs.size());
+    for (const auto& input : inputs) {
+      auto buffer =
+        std::make_unique<CpuBuffer>(input.getData(), MemoryAllocators::Cpu);
+      buffer->setPool(pool_);
+      buffers.push_back(std::move(buffer));
+    }
+    batch->setBuffers(std::move(buffers), {});
+  } else {
+    BufferPtrs buffers;
+    buffers.reserve(inputs.size());
+    for (auto i = 0U; i < inputs.size(); ++i) {
+      const auto& input = inputs[i];
+      auto buffer = pool_->get(allocators_, input, 1);
+      countCopy(input.getSize() * input.getDatatype().size());
+      if (input.isContiguous()) {
+        buffer->write(input.getData(), 0,
+                      input.getSize() * input.getDatatype().size());
+      } else {
+        std::vector<std::byte> dense(input.getSize() *
+                                     input.getDatatype().size());
+        input.copyData(dense.data());
+        buffer->write(dense.data(), 0, dense.size());
+      }
+      pool_->put(MemoryAllocators::Cpu, input.getData());
+      req->setInputTensorData(i, buffer->data(0));
+      buffers.push_back(std::move(buffer));
+    }
+    batch->setBuffers(std::move(buffers), {});
+  }
+
+  batch->addRequest(req);
+  batch->addModel("");
+#ifdef AMDINFER_ENABLE_TRACING
+  if (trace != nullptr) {
+    trace->endSpan();
+  }
+  batch->addTrace(std::move(trace));
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  batch->addTime(request->start_time);
+  this->recordClose(batch.get(), BatchCloseReason::Full, 1);
+#endif
+  batch->markStage(ServerTiming::Dispatched);
+  usage.reset();
+
+#ifdef AMDINFER_ENABLE_METRICS
+  if (metrics_ != nullptr) {
+    metrics_->incrementCounter(MetricCounterIDs::PipelineEgressBatcher);
+  }
+#endif
+
+  const std::shared_lock lock{inline_mutex_};
+  if (inline_) {
+    inline_(std::move(batch));
+  } else {
+    this->send(std::move(batch));
+  }
+}
+
+void Batcher::split(RequestContainerPtr request, size_t samples) const {
+  assert(samples > 0);
+  const auto& original = request->request;
+  this->densify(*original);
+  const auto& inputs = original->getInputs();
+
+  auto state = std::make_shared<SplitResponses>();
+  state->request = original;
+  state->samples = samples;
+  state->pending = samples;
+  state->unfinished = samples;
+
+  // each sample's inputs are views of its slice of the request's inputs that
+  // are lent to the pool so the batchers and workers can put them back like
+  // pooled memory. The request's memory is returned once all samples are done
+  std::vector<InferenceRequestPtr> requests;
+  requests.reserve(samples);
+  for (auto i = 0U; i < samples; ++i) {
+    auto sample = std::make_shared<InferenceRequest>();
+    sample->reserveTensors(inputs.size(), 0);
+    for (const auto& input : inputs) {
+      const auto& shape = input.getShape();
+      Tensor tensor{input.getName(), Shape(shape.begin() + 1, shape.end()),
+                    input.getDatatype()};
+      const auto size = tensor.getSize() * tensor.getDatatype().size();
+      auto* data = static_cast<std::byte*>(input.getData()) + (i * size);
+      pool_->borrow(data);
+      sample->addInputTensor(data, tensor.getShape(), tensor.getDatatype(),
+                             tensor.getName());
+    }
+    requests.push_back(std::move(sample));
+  }
+
+  for (auto i = 0U; i < samples; ++i) {
+    auto& sample = requests[i];
+    sample->setID(original->getID());
+    sample->setParameters(original->getParameters());
+    sample->setCallback([state, i, pool = pool_](
+                          const InferenceResponse& response) {
+      bool failed = response.isError();
+      auto error = response.getError();
+      bool respond = false;
+      bool finished = false;
+      bool release = false;
+      {
+        const std::lock_guard lock{state->mutex};
+        release = --state->unfinished == 0;
+        if (!state->done) {
+          respond = true;
+          if (!failed) {
+            try {
+              stackSample(state.get(), i, response);
+              finished = --state->pending == 0;
+            } catch (const std::exception& e) {
+              failed = true;
+              error = e.what();
+            }
+          }
+          state->done = finished || failed;
+        }
+      }
+
+      if (respond && failed) {
+        state->request->runCallbackError(error);
+      } else if (respond && finished) {
+        InferenceResponse stacked;
+        stacked.setID(state->request->getID());
+        stacked.setModel(state->model);
+        for (auto& output : state->outputs) {
+          stacked.addOutput(std::move(output));
+        }
+        state->request->runCallbackOnce(stacked);
+      }
+      if (release) {
+        for (const auto& input : state->request->getInputs()) {
+          pool->put(MemoryAllocators::Cpu, input.getData());
+        }
+      }
+    });
+
+    auto container = makeRequestContainer();
+    container->request = std::move(sample);
+    container->deadline = request->deadline;
+#ifdef AMDINFER_ENABLE_TRACING
+    container->trace = startTrace(model_);
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+    container->start_time = request->start_time;
+#endif
+    this->enqueue(std::move(container));
+  }
 }
 
 void Batcher::run(const std::vector<MemoryAllocators>& allocators) {
+  this->updateBatchSize();
   this->doRun(allocators);
   this->status_ = BatcherStatus::Inactive;
 }
@@ -105,4 +660,223 @@ void Batcher::end() {
 const Logger& Batcher::getLogger() const { return logger_; }
 #endif
 
+void Batcher::gatherInputs(Batch* batch, InferenceRequest& request) const {
+  this->densify(request);
+  const auto& inputs = request.getInputs();
+  BufferPtrs buffers;
+  buffers.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    auto buffer =
+      std::make_unique<CpuBuffer>(input.getData(), MemoryAllocators::Cpu);
+    buffer->setPool(pool_);
+    buffers.push_back(std::move(buffer));
+  }
+  batch->addRequestBuffers(std::move(buffers));
+}
+
+void Batcher::densify(InferenceRequest& request) const {
+  const auto& inputs = request.getInputs();
+  for (auto i = 0U; i < inputs.size(); ++i) {
+    const auto& input = inputs[i];
+    if (input.isContiguous()) {
+      continue;
+    }
+    auto buffer = pool_->get(MemoryAllocators::Cpu, input, 1);
+    auto* data = buffer->data(0);
+    input.copyData(data);
+    countCopy(input.getSize() * input.getDatatype().size());
+    pool_->put(MemoryAllocators::Cpu, input.getData());
+    request.setInputTensorData(i, data);
+  }
+}
+
+DataType Batcher::getBatchDatatype(const Tensor& input) const {
+  const auto datatype = input.getDatatype();
+  if (batch_datatype_ == DataType::Unknown || datatype == DataType::Bytes) {
+    return datatype;
+  }
+  return batch_datatype_;
+}
+
+void* Batcher::castInput(const InferenceRequestInput& input) {
+  const auto from = input.getDatatype();
+  const auto to = this->getBatchDatatype(input);
+  const auto size = input.getSize();
+  void* data = input.getData();
+  if (!input.isContiguous()) {
+    dense_buffer_.resize(size * from.size());
+    input.copyData(dense_buffer_.data());
+    data = dense_buffer_.data();
+  }
+  if (from == to) {
+    return data;
+  }
+  cast_buffer_.resize(size * to.size());
+  util::convertDatatype(data, from, cast_buffer_.data(), to, size);
+  return cast_buffer_.data();
+}
+
+size_t Batcher::writeInput(Buffer* buffer, const InferenceRequestInput& input,
+                           size_t offset) {
+  const auto from = input.getDatatype();
+  const auto to = this->getBatchDatatype(input);
+  const auto count = input.getSize();
+  const auto size = count * to.size();
+  countCopy(size);
+  if (buffer->getAllocator() != MemoryAllocators::Cpu ||
+      (from == to && input.isContiguous())) {
+    return buffer->write(this->castInput(input), offset, size);
+  }
+
+  // CPU batches are written directly instead of through the scratch buffers
+  auto* dst = buffer->data(offset);
+  if (from == to) {
+    input.copyData(dst);
+  } else if (input.isContiguous()) {
+    util::convertDatatype(input.getData(), from, dst, to, count);
+  } else {
+    dense_buffer_.resize(count * from.size());
+    input.copyData(dense_buffer_.data());
+    util::convertDatatype(dense_buffer_.data(), from, dst, to, count);
+  }
+  return offset + size;
+}
+
+bool Batcher::convertLayouts(InferenceRequest& request) const {
+  const auto& inputs = request.getInputs();
+  try {
+    for (auto i = 0U; i < inputs.size(); ++i) {
+      const auto& parameters = inputs[i].getParameters();
+      if (!parameters.has("layout")) {
+        continue;
+      }
+      const auto layout = parameters.get<std::string>("layout");
+      if (layout == input_layout_) {
+        continue;
+      }
+      const auto order = getLayoutOrder(layout, input_layout_);
+      if (order.size() != inputs[i].getShape().size()) {
+        throw invalid_argument("The layout " + layout + " of input " +
+                               inputs[i].getName() +
+                               " doesn't match its shape");
+      }
+      request.transposeInputTensor(i, order);
+    }
+  } catch (const invalid_argument& e) {
+    request.runCallbackError(e.what());
+    return false;
+  }
+  return true;
+}
+
+void Batcher::updateBatchSize() {
+  batch_size_ = this->getBatchSize();
+}
+
+bool Batcher::dequeue(RequestContainerPtr* request, size_t max,
+                      int64_t timeout_us) {
+  if (next_taken_ == taken_.size()) {
+    max = std::max<size_t>(max, 1);
+    taken_.resize(max);
+    next_taken_ = 0;
+    if (spin_.count() > 0) {
+      auto spin = spin_;
+      if (timeout_us >= 0) {
+        spin = std::min(spin, std::chrono::microseconds(timeout_us));
+      }
+      // the spin counts towards the timeout if nothing arrived
+      if (!util::spinUntilReady(*input_queue_, spin) && timeout_us >= 0) {
+        timeout_us -= spin.count();
+      }
+    }
+    taken_.resize(
+      input_queue_->wait_dequeue_bulk_timed(taken_.data(), max, timeout_us));
+    if (taken_.empty()) {
+      return false;
+    }
+  }
+  *request = std::move(taken_[next_taken_++]);
+  return true;
+}
+
+void Batcher::putBack(RequestContainerPtr request) {
+  assert(next_taken_ > 0);
+  taken_[--next_taken_] = std::move(request);
+}
+
+size_t Batcher::waiting() const {
+  return input_queue_->size_approx() + (taken_.size() - next_taken_);
+}
+
+bool Batcher::rejectExpired(const RequestContainer& request) const {
+  const bool cancelled = request.request->isCancelled();
+  if (!cancelled && request.deadline > util::getTime()) {
+    return false;
+  }
+
+  AMDINFER_LOG_DEBUG(logger_, std::string{cancelled ? "Dropping cancelled"
+                                                    : "Rejecting expired"} +
+                                " request for " + model_);
+  for (const auto& input : request.request->getInputs()) {
+    pool_->put(MemoryAllocators::Cpu, input.getData());
+  }
+  request.request->runCallbackError(cancelled ? "Request cancelled"
+                                              : "Request deadline exceeded");
+#ifdef AMDINFER_ENABLE_METRICS
+  if (metrics_ != nullptr) {
+    metrics_->incrementCounter(cancelled ? MetricCounterIDs::BatcherCancelled
+                                         : MetricCounterIDs::BatcherExpired);
+  }
+#endif
+  return true;
+}
+
+#ifdef AMDINFER_ENABLE_METRICS
+void Batcher::recordIngress(Batch* batch,
+                            const RequestContainer& request) const {
+  const auto now = util::now();
+  if (batch->empty()) {
+    batch->setStageTime(now);
+  }
+  if (metrics_ != nullptr) {
+    metrics_->incrementCounter(MetricCounterIDs::PipelineIngressBatcher);
+    metrics_->observeDuration(MetricHistogramIDs::StageIngress,
+                              now - request.start_time);
+  }
+}
+
+void Batcher::recordClose(Batch* batch, BatchCloseReason reason) const {
+  this->recordClose(batch, reason, batch_size_);
+}
+
+void Batcher::recordClose(Batch* batch, BatchCloseReason reason,
+                          size_t batch_size) const {
+  const auto now = util::now();
+  if (metrics_ != nullptr) {
+    metrics_->observeDuration(MetricHistogramIDs::StageBatcher,
+                              now - batch->getStageTime());
+    const auto size = static_cast<double>(batch->size());
+    metrics_->observeHistogram(MetricHistogramIDs::BatchSize, size);
+    metrics_->observeHistogram(
+      MetricHistogramIDs::BatchFillRatio,
+      size / static_cast<double>(std::max(batch_size, size_t{1})));
+    switch (reason) {
+      case BatchCloseReason::Full:
+        metrics_->incrementCounter(MetricCounterIDs::BatchesFull);
+        break;
+      case BatchCloseReason::Timeout:
+        metrics_->incrementCounter(MetricCounterIDs::BatchesTimeout);
+        break;
+      case BatchCloseReason::Deadline:
+        metrics_->incrementCounter(MetricCounterIDs::BatchesDeadline);
+        break;
+      case BatchCloseReason::Shutdown:
+        metrics_->incrementCounter(MetricCounterIDs::BatchesShutdown);
+        break;
+    }
+  }
+  batch->setStageTime(now);
+}
+#endif
+
 }  // namespace amdinfer
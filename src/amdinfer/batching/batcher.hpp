@@ -21,14 +21,20 @@
 #ifndef GUARD_AMDINFER_BATCHING_BATCHER
 #define GUARD_AMDINFER_BATCHING_BATCHER
 
-#include <cstddef>  // for size_t
-#include <memory>   // for unique_ptr, shared_ptr
-#include <string>   // for string
-#include <thread>   // for thread
-#include <vector>   // for vector
+#include <atomic>        // for atomic
+#include <chrono>        // for milliseconds, microseconds
+#include <cstddef>       // for size_t, byte
+#include <cstdint>       // for int32_t
+#include <functional>    // for function
+#include <memory>        // for unique_ptr, shared_ptr
+#include <shared_mutex>  // for shared_mutex
+#include <string>        // for string
+#include <thread>        // for thread
+#include <vector>        // for vector
 
 #include "amdinfer/batching/batch.hpp"       // for Batch
 #include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"      // for DataType
 #include "amdinfer/core/parameters.hpp"      // for ParameterMap
 #include "amdinfer/declarations.hpp"         // for BufferPtrs, InferenceReq...
 #include "amdinfer/observation/logging.hpp"  // for LoggerPtr
@@ -37,8 +43,11 @@
 
 namespace amdinfer {
 class Buffer;
+class InferenceRequestInput;
+class Tensor;
 class WorkerInfo;
 class MemoryPool;
+class ModelMetrics;
 enum class MemoryAllocators;
 }  // namespace amdinfer
 
@@ -46,7 +55,23 @@ namespace amdinfer {
 
 enum class BatcherStatus { New, Run, Inactive, Dead };
 
+/// Why a batcher sent a batch to the workers
+enum class BatchCloseReason {
+  Full,      ///< it reached the batch size or a preferred one
+  Timeout,   ///< the batcher stopped waiting for more requests
+  Deadline,  ///< waiting longer would miss a request's deadline
+  Shutdown,  ///< the batcher is stopping
+};
+
+/// Number of priority lanes in the batcher's input queue
+constexpr size_t kPriorityLanes = 3;
+/// Lane used for requests that don't set the "priority" parameter
+constexpr size_t kDefaultPriority = 1;
+/// Milliseconds a batcher waits to fill a batch if "timeout" isn't set
+constexpr int32_t kDefaultBatcherTimeout = 100;
+
 using BatchPtrQueue = BlockingQueue<BatchPtr>;
+using RequestQueue = PriorityBlockingQueue<RequestContainerPtr, kPriorityLanes>;
 
 /**
  * @brief The base batcher implementation defines the basic structure of how
@@ -69,8 +94,8 @@ class Batcher {
   Batcher& operator=(const Batcher&) = delete;  ///< Copy assignment constructor
   Batcher(Batcher&& other) = delete;            ///< Move constructor
   Batcher& operator=(Batcher&& other) =
-    delete;                      ///< Move assignment constructor
-  virtual ~Batcher() = default;  ///< Destructor
+    delete;            ///< Move assignment constructor
+  virtual ~Batcher();  ///< Destructor
 
   /**
    * @brief Start the batcher
@@ -79,11 +104,23 @@ class Batcher {
    */
   void start(const std::vector<MemoryAllocators>& allocator);
   /**
-   * @brief Set the batch size for the batcher
+   * @brief Set the batch size for the batcher. It can be changed while the
+   * batcher runs and applies from the next batch
    *
    * @param batch_size target batch size
    */
   void setBatchSize(size_t batch_size);
+  /// Get the target batch size of the batcher
+  [[nodiscard]] size_t getBatchSize() const;
+  /**
+   * @brief Set how long the batcher waits to fill a batch. It can be changed
+   * while the batcher runs and applies from the next batch
+   *
+   * @param timeout the timeout in milliseconds
+   */
+  void setTimeout(int32_t timeout);
+  /// Get how long the batcher waits to fill a batch in milliseconds
+  [[nodiscard]] int32_t getTimeout() const;
   /**
    * @brief Set the name of the batcher (i.e. the batcher's worker group
    * endpoint)
@@ -93,9 +130,39 @@ class Batcher {
   void setName(const std::string& name);
   /// Get the batcher's worker group name
   [[nodiscard]] std::string getName() const;
+#ifdef AMDINFER_ENABLE_METRICS
+  /**
+   * @brief Set the metrics of the batcher's endpoint. Its batches share them
+   * and the sizes of its queues are read from them when they're scraped
+   *
+   * @param metrics the endpoint's metrics
+   */
+  void setMetrics(std::shared_ptr<ModelMetrics> metrics);
+#endif
+
+  /**
+   * @brief Signal a semaphore each time the batcher sends a batch, such as to
+   * wake a Multiplexer that serves the output queues of many batchers. Set it
+   * before the batcher starts
+   *
+   * @param doorbell the semaphore
+   */
+  void setDoorbell(std::shared_ptr<moodycamel::LightweightSemaphore> doorbell);
+  /// Check if the batcher signals a semaphore when it sends a batch
+  [[nodiscard]] bool hasDoorbell() const;
+  /**
+   * @brief Run the batches the batcher sends directly with a function on the
+   * thread that enqueued the request instead of pushing them to the output
+   * queue. This is used for workers that are cheap and safe to run from many
+   * threads at once. Passing an empty function waits for the batches that are
+   * running inline to finish and sends the next ones to the output queue again
+   *
+   * @param run the function to run each batch with
+   */
+  void setInline(std::function<void(BatchPtr)> run);
 
   /// Get the batcher's input queue (used to enqueue new requests)
-  BlockingQueue<RequestContainerPtr>* getInputQueue();
+  RequestQueue* getInputQueue();
   /// Get the batcher's output queue (used to push batches to the worker group)
   BatchPtrQueue* getOutputQueue();
 
@@ -104,11 +171,36 @@ class Batcher {
   BatcherStatus getStatus() const;
 
   /**
-   * @brief Enqueue a new request to the batcher
+   * @brief Enqueue a new request to the batcher. The lane is chosen by the
+   * request's "priority" parameter where 0 is the highest priority. It may be
+   * any number and is rounded down and clamped to the lanes. Requests whose
+   * priority isn't a number fail with an error. A nullptr is enqueued with the
+   * lowest priority so pending requests are handled first.
+   * If the request has a "deadline" parameter, its deadline is set to that many
+   * milliseconds from now. Requests whose deadline is negative or not a number
+   * fail with an error.
+   *
+   * If the batch size is 1, the batcher is started and the "direct" load-time
+   * parameter isn't false, the request is made into a batch on the calling
+   * thread and sent without waking the batcher's thread. Batchers that pad or
+   * order their batches never do this.
    *
    * @param request
    */
   void enqueue(RequestContainerPtr request) const;
+  /**
+   * @brief Enqueue a request whose inputs hold many samples along an extra
+   * leading dimension as one request per sample. The samples are batched like
+   * any other requests so a large request fills many batches that the worker
+   * group runs in parallel. The request's callback is run once with each
+   * output stacked along a new leading dimension or with the first error.
+   * The samples point into the request's inputs instead of copying them and
+   * its memory is returned to the pool when every sample has responded.
+   *
+   * @param request the request. Its inputs must be in CPU memory from the pool
+   * @param samples the size of the leading dimension of every input
+   */
+  void split(RequestContainerPtr request, size_t samples) const;
 
   /// End the batcher
   void end();
@@ -117,14 +209,172 @@ class Batcher {
 #ifdef AMDINFER_ENABLE_LOGGING
   [[nodiscard]] const Logger& getLogger() const;
 #endif
+#ifdef AMDINFER_ENABLE_METRICS
+  /**
+   * @brief Count a request the batcher took and record how long it took to
+   * get here since it arrived. The batch is timed from its first request.
+   *
+   * @param batch the batch the request is added to
+   * @param request the request
+   */
+  void recordIngress(Batch* batch, const RequestContainer& request) const;
+  /**
+   * @brief Record how long the batch took to fill, how full it is and why it
+   * was sent. Call it when the batch is sent to the workers so they can time
+   * how long it waits for them.
+   *
+   * @param batch the batch
+   * @param reason why the batch is sent
+   */
+  void recordClose(Batch* batch, BatchCloseReason reason) const;
+  /**
+   * @brief Record the closing of a batch like recordClose for a batch formed
+   * with the given batch size instead of the one the batcher's thread uses
+   *
+   * @param batch the batch
+   * @param reason why the batch is sent
+   * @param batch_size the batch size the batch was formed for
+   */
+  void recordClose(Batch* batch, BatchCloseReason reason,
+                   size_t batch_size) const;
+#endif
+  /**
+   * @brief Add the request's input tensors to the batch's scatter-gather list
+   * in place. The request's memory is returned to the pool when the worker
+   * frees the batch's input buffers.
+   *
+   * @param batch batch to add the tensors to
+   * @param request request whose tensors are added. Strided inputs are made
+   * dense first
+   */
+  void gatherInputs(Batch* batch, InferenceRequest& request) const;
+  /**
+   * @brief Copy the request's strided inputs to dense memory from the pool,
+   * returning their original memory, for paths that pass inputs in place
+   *
+   * @param request the request
+   */
+  void densify(InferenceRequest& request) const;
+  /**
+   * @brief Get the next request. If none were left from the last call, the
+   * requests that are waiting in the input queue are taken at once, up to max,
+   * so a batch pays for one synchronization with the queue instead of one per
+   * request. If the batcher was loaded with spin_us, it polls the queue for up
+   * to that long before blocking on it.
+   *
+   * @param request the request
+   * @param max the most requests to take from the queue, e.g. the room left in
+   * the batch
+   * @param timeout_us time to wait in microseconds or -1 to wait forever
+   * @return bool true if there's a request
+   */
+  bool dequeue(RequestContainerPtr* request, size_t max,
+               int64_t timeout_us = -1);
+  /**
+   * @brief Return the request that dequeue() returned last so that the next
+   * call returns it again, e.g. if its samples don't fit in the batch
+   *
+   * @param request the request
+   */
+  void putBack(RequestContainerPtr request);
+  /// Get the approximate number of requests waiting for the batcher
+  [[nodiscard]] size_t waiting() const;
+  /**
+   * @brief Check if the request's deadline has passed or its client cancelled
+   * it. Such requests are failed with an error and must not be added to a
+   * batch.
+   *
+   * @param request request to check
+   * @return bool true if the request was rejected
+   */
+  bool rejectExpired(const RequestContainer& request) const;
+  /// Send a finished batch to the worker group
+  void send(BatchPtr batch) const;
+  /**
+   * @brief Get the datatype an input has in the batch. If the "batch_datatype"
+   * parameter is set, inputs are cast to it as they're copied into the batch
+   * so the worker gets the datatype its model expects, e.g. FP16, while
+   * clients send FP32. BYTES inputs are never cast.
+   *
+   * @param input the input
+   * @return DataType
+   */
+  [[nodiscard]] DataType getBatchDatatype(const Tensor& input) const;
+  /**
+   * @brief Get the input's data in its batch datatype. Inputs that are cast
+   * are converted into a scratch buffer that the next call reuses so the data
+   * must be copied into the batch first.
+   *
+   * @param input the input
+   * @return void* the data to copy into the batch
+   */
+  void* castInput(const InferenceRequestInput& input);
+  /**
+   * @brief Write the input into the batch in its batch datatype. Strided
+   * inputs that aren't cast are gathered straight into CPU batch buffers so
+   * their elements are only copied once.
+   *
+   * @param buffer the batch buffer
+   * @param input the input
+   * @param offset where to write in the buffer in bytes
+   * @return size_t the offset after the input
+   */
+  size_t writeInput(Buffer* buffer, const InferenceRequestInput& input,
+                    size_t offset);
+  /**
+   * @brief Transpose the request's inputs that set the "layout" parameter to
+   * the "input_layout" of the endpoint. Only their shapes and strides change
+   * and the data is reordered as it's copied into the batch.
+   *
+   * @param request the request
+   * @return bool false if an input's layout can't be converted, after
+   * responding to the request with an error
+   */
+  bool convertLayouts(InferenceRequest& request) const;
+  /**
+   * @brief Use the batch size last set with setBatchSize. The batcher's thread
+   * calls it between batches so a batch is formed with one batch size
+   */
+  void updateBatchSize();
 
+  // the batch size of the batch being formed. Only the batcher's thread uses it
   size_t batch_size_ = 1;
-  std::shared_ptr<BlockingQueue<RequestContainerPtr>> input_queue_;
+  // the batch size to use from the next batch, which may change while it runs
+  std::atomic<size_t> next_batch_size_ = 1;
+  // milliseconds to wait to fill a batch, which may change while it runs
+  std::atomic<int32_t> timeout_ = kDefaultBatcherTimeout;
+  // if true, pass requests' tensors in place instead of copying them into
+  // contiguous batch buffers
+  bool scatter_gather_ = false;
+  // batches are sent this long before the tightest deadline in them
+  std::chrono::milliseconds deadline_margin_{0};
+  // how long to poll an empty input queue before blocking on it
+  std::chrono::microseconds spin_{0};
+  // if set, inputs are cast to this datatype when they're copied into batches
+  DataType batch_datatype_ = DataType::Unknown;
+  // if set, inputs in other layouts are transposed to it in the batch
+  std::string input_layout_;
+  // sorted batch sizes that are sent as soon as no more requests are waiting
+  // instead of waiting for the batch to fill
+  std::vector<size_t> preferred_batch_sizes_;
+  // requests' priorities are clamped to the lanes below this
+  size_t priority_levels_ = kPriorityLanes;
+  // lane used for requests that don't set the "priority" parameter
+  size_t default_priority_ = kDefaultPriority;
+  std::shared_ptr<RequestQueue> input_queue_;
+  // requests taken from the input queue that dequeue hasn't returned yet
+  std::vector<RequestContainerPtr> taken_;
+  size_t next_taken_ = 0;
   std::shared_ptr<BatchPtrQueue> output_queue_;
+  // signalled for each batch sent, if set
+  std::shared_ptr<moodycamel::LightweightSemaphore> doorbell_;
   std::thread thread_;
   std::string model_;
   ParameterMap parameters_;
   MemoryPool* pool_;
+#ifdef AMDINFER_ENABLE_METRICS
+  std::shared_ptr<ModelMetrics> metrics_;
+#endif
 
  private:
   /**
@@ -134,8 +384,33 @@ class Batcher {
    * @param allocators vector of allocators that may be used to get memory
    */
   virtual void doRun(const std::vector<MemoryAllocators>& allocators) = 0;
+  /**
+   * @brief Check if requests can be sent as batches of one without the
+   * batcher's thread. Batchers whose batches of one differ from the request,
+   * e.g. by padding, or that must see every request in order return false
+   *
+   * @return bool
+   */
+  [[nodiscard]] virtual bool canSendDirect() const { return false; }
+  /**
+   * @brief Make a batch of one request and send it on the calling thread
+   *
+   * @param request the request
+   */
+  void sendDirect(RequestContainerPtr request) const;
 
   BatcherStatus status_;
+  std::vector<std::byte> cast_buffer_;
+  // scratch memory for castInput to make strided inputs dense
+  std::vector<std::byte> dense_buffer_;
+  // the allocators of the worker group, set when the batcher starts
+  std::vector<MemoryAllocators> allocators_;
+  // if true, batches of one are made on the thread that enqueues the request
+  bool direct_ = false;
+  // if set, batches are run with this on the sending thread
+  std::function<void(BatchPtr)> inline_;
+  // held shared while running a batch inline and exclusively to change inline_
+  mutable std::shared_mutex inline_mutex_;
 
 #ifdef AMDINFER_ENABLE_LOGGING
   Logger logger_{Loggers::Server};
@@ -0,0 +1,324 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the bucket batcher
+ */
+
+#include "amdinfer/batching/bucket.hpp"
+
+#include <algorithm>  // for sort, unique, lower_bound, min_element
+#include <chrono>     // for duration_cast, milliseconds
+#include <cstddef>    // for size_t, byte
+#include <cstdint>    // for int32_t, int64_t
+#include <exception>  // for exception
+#include <map>        // for map
+#include <memory>     // for unique_ptr
+#include <sstream>    // for istringstream
+#include <string>     // for string, getline, stoll
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/buffers/buffer.hpp"          // for Buffer
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+#include "amdinfer/core/request_container.hpp"  // for RequestContainer
+#include "amdinfer/core/request_usage.hpp"      // for UsageScope
+#include "amdinfer/declarations.hpp"            // for RequestContainerPtr
+#include "amdinfer/observation/logging.hpp"    // for Logger, AMDINFER_LOG_DEBUG
+#include "amdinfer/observation/metrics.hpp"    // for Metrics, MetricCounterIDs
+#include "amdinfer/observation/profiling.hpp"  // for profileEvent, profileNow
+#include "amdinfer/observation/tracing.hpp"    // for Trace
+#include "amdinfer/util/queue.hpp"             // for PriorityBlockingQueue
+#include "amdinfer/util/thread.hpp"            // for setThreadName
+#include "amdinfer/util/timer.hpp"             // for getTime, TimePoint
+
+namespace amdinfer {
+
+namespace {
+
+std::vector<int64_t> parseBuckets(const std::string& buckets) {
+  std::vector<int64_t> boundaries;
+  std::istringstream stream{buckets};
+  std::string token;
+  while (std::getline(stream, token, ',')) {
+    int64_t boundary = 0;
+    try {
+      boundary = std::stoll(token);
+    } catch (const std::exception&) {
+      throw invalid_argument("Invalid bucket boundary: " + token);
+    }
+    if (boundary <= 0) {
+      throw invalid_argument("Bucket boundaries must be positive: " + token);
+    }
+    boundaries.push_back(boundary);
+  }
+  std::sort(boundaries.begin(), boundaries.end());
+  boundaries.erase(std::unique(boundaries.begin(), boundaries.end()),
+                   boundaries.end());
+  return boundaries;
+}
+
+/// The shapes of all the (padded) inputs of a request identify its bucket
+using BucketKey = std::vector<std::vector<int64_t>>;
+
+struct OpenBatch {
+  BatchPtr batch;
+  std::vector<size_t> offsets;
+  size_t size = 0;
+  util::TimePoint deadline;
+  // if the deadline was moved up to meet a request's deadline
+  bool early = false;
+  ProfileClock::time_point opened;
+};
+
+/**
+ * @brief Write a tensor into a buffer, padding the last dimension of each row
+ * with zeros up to the padded row size
+ *
+ * @param buffer buffer to write into
+ * @param data tensor data
+ * @param offset offset in the buffer to start writing at
+ * @param rows number of rows in the tensor
+ * @param row_bytes size of each row in the tensor in bytes
+ * @param padded_bytes size of each row in the buffer in bytes
+ * @return size_t the new offset
+ */
+size_t writePadded(Buffer* buffer, void* data, size_t offset, size_t rows,
+                   size_t row_bytes, size_t padded_bytes) {
+  if (row_bytes == padded_bytes) {
+    return buffer->write(data, offset, rows * row_bytes);
+  }
+
+  std::vector<std::byte> padding(padded_bytes - row_bytes);
+  auto* src = static_cast<std::byte*>(data);
+  for (auto i = 0U; i < rows; ++i) {
+    offset = buffer->write(src + (i * row_bytes), offset, row_bytes);
+    offset = buffer->write(padding.data(), offset, padding.size());
+  }
+  return offset;
+}
+
+}  // namespace
+
+BucketBatcher::BucketBatcher(MemoryPool* pool) : Batcher(pool) {}
+
+BucketBatcher::BucketBatcher(MemoryPool* pool, ParameterMap* parameters)
+  : Batcher(pool, parameters) {
+  if (this->parameters_.has("buckets")) {
+    buckets_ = parseBuckets(this->parameters_.get<std::string>("buckets"));
+  }
+}
+
+BucketBatcher::BucketBatcher(const BucketBatcher& batcher)
+  : Batcher(batcher), buckets_(batcher.buckets_) {}
+
+const std::vector<int64_t>& BucketBatcher::getBuckets() const {
+  return buckets_;
+}
+
+void BucketBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
+  auto thread_name = "batch" + this->getName();
+  util::setThreadName(thread_name);
+#ifdef AMDINFER_ENABLE_LOGGING
+  [[maybe_unused]] const auto& logger = this->getLogger();
+#endif
+
+  std::map<BucketKey, OpenBatch> open_batches;
+
+  auto dispatch = [&](OpenBatch& open_batch,
+                      [[maybe_unused]] BatchCloseReason reason) {
+    AMDINFER_LOG_DEBUG(logger, "Enqueuing batch for " + this->model_ +
+                                 " of size " +
+                                 std::to_string(open_batch.size));
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordClose(open_batch.batch.get(), reason);
+#endif
+    profileEvent("form batch", "batcher", open_batch.opened);
+    open_batch.batch->markStage(ServerTiming::Dispatched);
+    this->send(std::move(open_batch.batch));
+#ifdef AMDINFER_ENABLE_METRICS
+    if (metrics_ != nullptr) {
+      metrics_->incrementCounter(MetricCounterIDs::PipelineEgressBatcher);
+      metrics_->setGauge(MetricGaugeIDs::BatcherFillRatio,
+                         static_cast<double>(open_batch.size) /
+                           static_cast<double>(this->batch_size_));
+    }
+#endif
+  };
+
+  bool run = true;
+  while (run) {
+    RequestContainerPtr req;
+    bool valid = true;
+    // requests go to different buckets so up to a batch of them is taken
+    if (open_batches.empty()) {
+      // the batch size may be changed while the batcher runs but the open
+      // batches keep the one they were opened with
+      this->updateBatchSize();
+      this->dequeue(&req, this->batch_size_);
+    } else {
+      auto next = std::min_element(
+        open_batches.begin(), open_batches.end(),
+        [](const auto& a, const auto& b) {
+          return a.second.deadline < b.second.deadline;
+        });
+      auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+                         next->second.deadline - util::getTime())
+                         .count();
+      valid = this->dequeue(&req, this->batch_size_,
+                            std::max(remaining, int64_t{0}));
+    }
+
+    if (valid && req == nullptr) {
+      run = false;
+    } else if (valid && !this->rejectExpired(*req)) {
+      auto request = req->request;
+      const UsageScope usage{request->getUsage(), RequestUsage::Batch};
+      const auto& inputs = request->getInputs();
+      auto input_size = inputs.size();
+      if (input_size == 0) {
+        request->runCallbackError("Input size is zero");
+        continue;
+      }
+
+      BucketKey key;
+      key.reserve(input_size);
+      bool fits = true;
+      for (const auto& input : inputs) {
+        auto shape = input.getShape();
+        if (!buckets_.empty() && !shape.empty()) {
+          auto bucket =
+            std::lower_bound(buckets_.begin(), buckets_.end(), shape.back());
+          if (bucket == buckets_.end()) {
+            fits = false;
+            break;
+          }
+          shape.back() = *bucket;
+        }
+        key.push_back(std::move(shape));
+      }
+      if (!fits) {
+        request->runCallbackError("Input exceeds the largest bucket of " +
+                                  std::to_string(buckets_.back()));
+        continue;
+      }
+
+      auto [iter, inserted] = open_batches.try_emplace(key);
+      auto& open_batch = iter->second;
+      if (inserted) {
+        AMDINFER_LOG_DEBUG(logger,
+                           "Got request of a new batch for " + this->model_);
+        open_batch.batch = Batch::create(batch_size_);
+#ifdef AMDINFER_ENABLE_METRICS
+        open_batch.batch->setMetrics(metrics_);
+#endif
+        std::vector<BufferPtr> input_buffers;
+        input_buffers.reserve(input_size);
+        for (auto i = 0U; i < input_size; ++i) {
+          InferenceRequestInput padded = inputs[i];
+          padded.setShape(key[i]);
+          padded.setDatatype(this->getBatchDatatype(padded));
+          input_buffers.push_back(pool_->get(allocators, padded, batch_size_));
+        }
+        open_batch.offsets.resize(input_size);
+        open_batch.batch->setBuffers(std::move(input_buffers), {});
+        // the timeout may be changed while the batcher runs
+        open_batch.deadline =
+          util::getTime() + std::chrono::milliseconds(this->getTimeout());
+        open_batch.opened = profileNow();
+      }
+
+#ifdef AMDINFER_ENABLE_TRACING
+      auto& trace = req->trace;
+      if (trace != nullptr) {
+        trace->startSpan("bucket_batcher");
+      }
+#endif
+
+#ifdef AMDINFER_ENABLE_METRICS
+      this->recordIngress(open_batch.batch.get(), *req);
+#endif
+
+      const auto& input_buffers = open_batch.batch->getInputBuffers();
+      for (auto i = 0U; i < input_size; ++i) {
+        const auto& input = inputs[i];
+        const auto& input_buffer = input_buffers.at(i);
+        auto& offset = open_batch.offsets[i];
+
+        const auto& shape = input.getShape();
+        const auto& padded_shape = key[i];
+        const auto datatype = this->getBatchDatatype(input);
+        auto element_size = datatype.size();
+        size_t row_length = shape.empty() ? 1 : shape.back();
+        size_t padded_length = padded_shape.empty() ? 1 : padded_shape.back();
+        auto rows = row_length == 0 ? 0 : input.getSize() / row_length;
+
+        auto new_offset = writePadded(
+          input_buffer.get(), this->castInput(input), offset, rows,
+          row_length * element_size, padded_length * element_size);
+        pool_->put(MemoryAllocators::Cpu, input.getData());
+        request->setInputTensorData(i, input_buffer->data(offset));
+        request->setInputTensorShape(i, padded_shape);
+        request->setInputTensorDatatype(i, datatype);
+        offset = new_offset;
+      }
+
+      open_batch.batch->addRequest(request);
+      open_batch.size++;
+      if (const auto close_time = req->deadline - deadline_margin_;
+          req->deadline != util::TimePoint::max() &&
+          close_time < open_batch.deadline) {
+        open_batch.deadline = close_time;
+        open_batch.early = true;
+      }
+      open_batch.batch->addModel("");
+#ifdef AMDINFER_ENABLE_TRACING
+      if (trace != nullptr) {
+        trace->endSpan();
+      }
+      open_batch.batch->addTrace(std::move(trace));
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+      open_batch.batch->addTime(req->start_time);
+#endif
+
+      if (open_batch.size == this->batch_size_) {
+        dispatch(open_batch, BatchCloseReason::Full);
+        open_batches.erase(iter);
+      }
+    }
+
+    // send any batches that have timed out or all of them if stopping
+    auto now = util::getTime();
+    for (auto iter = open_batches.begin(); iter != open_batches.end();) {
+      if (!run) {
+        dispatch(iter->second, BatchCloseReason::Shutdown);
+        iter = open_batches.erase(iter);
+      } else if (iter->second.deadline <= now) {
+        dispatch(iter->second, iter->second.early ? BatchCloseReason::Deadline
+                                                  : BatchCloseReason::Timeout);
+        iter = open_batches.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+}
+
+}  // namespace amdinfer
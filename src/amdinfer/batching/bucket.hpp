@@ -0,0 +1,69 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the bucket batcher implementation
+ */
+
+#ifndef GUARD_AMDINFER_BATCHING_BUCKET
+#define GUARD_AMDINFER_BATCHING_BUCKET
+
+#include <cstdint>  // for int64_t
+#include <vector>   // for vector
+
+#include "amdinfer/batching/batcher.hpp"  // IWYU pragma: export
+
+namespace amdinfer {
+enum class MemoryAllocators;
+class MemoryPool;
+}  // namespace amdinfer
+
+namespace amdinfer {
+
+/**
+ * @brief The BucketBatcher batches requests with different input shapes. It
+ * keeps an open batch per shape bucket and each batch is sent on when it's full
+ * or when its timeout expires. If the "buckets" parameter is set to a
+ * comma-separated list of boundaries, the last dimension of each input is
+ * zero-padded up to the nearest boundary and requests that exceed the largest
+ * boundary are rejected. Otherwise, only requests with identical shapes are
+ * batched together.
+ *
+ */
+class BucketBatcher : public Batcher {
+ public:
+  /// Construct a new BucketBatcher object
+  explicit BucketBatcher(MemoryPool* pool);
+  /**
+   * @brief Construct a new BucketBatcher object
+   *
+   * @param pool memory pool to allocate batch buffers from
+   * @param parameters parameters for the batcher
+   */
+  BucketBatcher(MemoryPool* pool, ParameterMap* parameters);
+  BucketBatcher(const BucketBatcher& batcher);  ///< copy constructor
+
+  /// Get the sorted bucket boundaries for the last dimension
+  [[nodiscard]] const std::vector<int64_t>& getBuckets() const;
+
+ private:
+  void doRun(const std::vector<MemoryAllocators>& allocators) override;
+
+  std::vector<int64_t> buckets_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_BATCHING_BUCKET
@@ -20,11 +20,14 @@
 
 #include "amdinfer/batching/hard.hpp"
 
-#include <cstddef>  // for size_t
-#include <memory>   // for unique_ptr, operator==
-#include <string>   // for operator+
-#include <utility>  // for move
-#include <vector>   // for vector
+#include <algorithm>  // for max
+#include <chrono>     // for milliseconds, duration_cast
+#include <cstddef>    // for size_t, byte
+#include <cstdint>    // for int32_t, int64_t
+#include <memory>     // for unique_ptr, operator==
+#include <string>     // for operator+
+#include <utility>    // for move
+#include <vector>     // for vector
 
 #include "amdinfer/buffers/cpu.hpp"             // for CpuBuffer
 #include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_METRICS
@@ -32,12 +35,16 @@
 #include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
 #include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
 #include "amdinfer/core/request_container.hpp"  // for InferenceRequestInput
+#include "amdinfer/core/request_usage.hpp"      // for UsageScope
+#include "amdinfer/core/tensor.hpp"             // for Tensor
 #include "amdinfer/core/worker_info.hpp"        // for WorkerInfo
 #include "amdinfer/declarations.hpp"            // for RequestContainerPtr
 #include "amdinfer/observation/metrics.hpp"     // for Metrics, MetricCounterIDs
+#include "amdinfer/observation/profiling.hpp"   // for profileEvent, profileNow
 #include "amdinfer/observation/tracing.hpp"     // for Trace
 #include "amdinfer/util/queue.hpp"              // for BlockingConcurrentQueue
 #include "amdinfer/util/thread.hpp"             // for setThreadName
+#include "amdinfer/util/timestamps.hpp"         // for Timestamp, now
 
 // IWYU pragma: no_forward_declare amdinfer::Buffer
 
@@ -49,34 +56,79 @@ void HardBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
   RequestContainerPtr req;
   bool run = true;
 
+  // by default, the batcher waits for a full batch however long it takes
+  std::chrono::milliseconds max_wait{-1};
+  if (this->parameters_.has("max_wait")) {
+    max_wait =
+      std::chrono::milliseconds(this->parameters_.get<int32_t>("max_wait"));
+  }
+  // zeros used to pad partial batches
+  std::vector<std::byte> zeros;
+
   while (run) {
-    auto batch = std::make_unique<Batch>();
+    // the batch size may be changed while the batcher runs
+    this->updateBatchSize();
+    auto batch = Batch::create(this->batch_size_);
+#ifdef AMDINFER_ENABLE_METRICS
+    batch->setMetrics(metrics_);
+#endif
     size_t batch_size = 0;
 
     std::vector<size_t> input_offset;
     std::vector<size_t> output_offset;
 
     bool first_request = true;
+    auto opened = ProfileClock::time_point{};
+    [[maybe_unused]] auto reason = BatchCloseReason::Full;
+    util::Timestamp expiry;
 
     do {
-      this->input_queue_->wait_dequeue(req);
+      if (batch->empty() || max_wait.count() < 0) {
+        this->dequeue(&req, this->batch_size_ - batch_size);
+      } else {
+        const auto remaining =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+            expiry - util::now())
+            .count();
+        if (!this->dequeue(&req, this->batch_size_ - batch_size,
+                           std::max(remaining, int64_t{0}))) {
+          reason = BatchCloseReason::Timeout;
+          break;
+        }
+      }
 
       if (req == nullptr) {
         run = false;
         break;
       }
 
+      if (this->rejectExpired(*req)) {
+        continue;
+      }
+      // a request that doesn't fit starts the next batch. One with more
+      // samples than the batch size is sent in a batch of its own
+      if (batch_size > 0 && batch_size + req->samples > this->batch_size_) {
+        this->putBack(std::move(req));
+        break;
+      }
+
 #ifdef AMDINFER_ENABLE_TRACING
       auto& trace = req->trace;
-      trace->startSpan("hard_batcher");
+      if (trace != nullptr) {
+        trace->startSpan("hard_batcher");
+      }
 #endif
 
 #ifdef AMDINFER_ENABLE_METRICS
-      Metrics::getInstance().incrementCounter(
-        MetricCounterIDs::PipelineIngressBatcher);
+      this->recordIngress(batch.get(), *req);
 #endif
+      if (batch->empty()) {
+        opened = profileNow();
+        expiry = util::now() + max_wait;
+      }
 
       auto request = req->request;
+      const UsageScope usage{request->getUsage(), RequestUsage::Batch};
       const auto& inputs = request->getInputs();
       auto input_size = inputs.size();
       if (input_size == 0) {
@@ -84,7 +136,7 @@ void HardBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
         continue;
       }
 
-      if (first_request) {
+      if (first_request && !scatter_gather_) {
         std::vector<BufferPtr> input_buffers;
         input_buffers.reserve(input_size);
         // auto output_sizes = req->getOutputSizes();
@@ -96,7 +148,9 @@ void HardBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
         // output_buffers.reserve(output_sizes.size());
         // std::vector<size_t> output_offset(output_buffers.size(), 0);
         for (const auto& input : inputs) {
-          input_buffers.push_back(pool_->get(allocators, input, batch_size_));
+          const Tensor tensor{input.getName(), input.getShape(),
+                              this->getBatchDatatype(input)};
+          input_buffers.push_back(pool_->get(allocators, tensor, batch_size_));
         }
         // for(const auto& tensor_size : output_sizes) {
         //   output_buffers.push_back(pool_->get(allocators, tensor_size));
@@ -107,38 +161,65 @@ void HardBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
 
       const auto& input_buffers = batch->getInputBuffers();
 
-      auto old_input_offset = input_offset;
-      for (auto i = 0U; i < input_size; ++i) {
-        const auto& input = inputs[i];
-        const auto& input_buffer = input_buffers.at(i);
-        auto& offset = input_offset[i];
-
-        auto new_offset =
-          input_buffer->write(input.getData(), offset,
-                              input.getSize() * input.getDatatype().size());
-        pool_->put(MemoryAllocators::Cpu, input.getData());
-        request->setInputTensorData(i, input_buffer->data(offset));
-        offset = new_offset;
+      if (scatter_gather_) {
+        this->gatherInputs(batch.get(), *request);
+      } else {
+        for (auto i = 0U; i < input_size; ++i) {
+          const auto& input = inputs[i];
+          const auto& input_buffer = input_buffers.at(i);
+          auto& offset = input_offset[i];
+
+          const auto datatype = this->getBatchDatatype(input);
+          auto new_offset =
+            this->writeInput(input_buffer.get(), input, offset);
+          pool_->put(MemoryAllocators::Cpu, input.getData());
+          request->setInputTensorData(i, input_buffer->data(offset));
+          request->setInputTensorDatatype(i, datatype);
+          offset = new_offset;
+        }
       }
 
       batch->addRequest(request);
-      batch_size++;
+      batch_size += req->samples;
       batch->addModel("");
 #ifdef AMDINFER_ENABLE_TRACING
-      trace->endSpan();
+      if (trace != nullptr) {
+        trace->endSpan();
+      }
       batch->addTrace(std::move(trace));
 #endif
 #ifdef AMDINFER_ENABLE_METRICS
       batch->addTime(req->start_time);
 #endif
       first_request = false;
-    } while (batch_size % this->batch_size_ != 0);
+    } while (batch_size < this->batch_size_);
 
     if (!batch->empty()) {
-      this->output_queue_->enqueue(std::move(batch));
+      // a partial batch keeps the full shape. The real requests are left in
+      // place and only the rest of the batch is zeroed so the model doesn't
+      // read stale data. The batch's size is the number of real requests
+      if (batch_size < this->batch_size_ && !scatter_gather_) {
+        const auto& input_buffers = batch->getInputBuffers();
+        for (auto i = 0U; i < input_buffers.size(); ++i) {
+          const auto offset = input_offset[i];
+          const auto padding =
+            offset / batch_size * (this->batch_size_ - batch_size);
+          if (zeros.size() < padding) {
+            zeros.resize(padding);
+          }
+          input_buffers[i]->write(zeros.data(), offset, padding);
+        }
+      }
 #ifdef AMDINFER_ENABLE_METRICS
-      Metrics::getInstance().incrementCounter(
-        MetricCounterIDs::PipelineEgressBatcher);
+      this->recordClose(batch.get(), run ? reason : BatchCloseReason::Shutdown);
+#endif
+      profileEvent("form batch", "batcher", opened);
+      batch->markStage(ServerTiming::Dispatched);
+      this->send(std::move(batch));
+#ifdef AMDINFER_ENABLE_METRICS
+      if (metrics_ != nullptr) {
+        metrics_->incrementCounter(MetricCounterIDs::PipelineEgressBatcher);
+      }
 #endif
     }
   }
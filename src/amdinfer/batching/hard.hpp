@@ -32,9 +32,11 @@ namespace amdinfer {
 
 /**
  * @brief The HardBatcher batches to a multiple of the requested batch size and
- * blocks until a valid batch forms. Note: this batcher is only meant for
- * testing purposes or if the batch size is fixed to be one since it can block
- * indefinitely.
+ * blocks until a valid batch forms. Note: by default, this batcher is only
+ * meant for testing purposes or if the batch size is fixed to be one since it
+ * can block indefinitely. Setting the "max_wait" parameter to a time in
+ * milliseconds bounds the wait: once it passes, the partial batch is sent with
+ * its buffers still sized for a full batch and the unused part zeroed.
  *
  */
 class HardBatcher : public Batcher {
@@ -43,6 +45,7 @@ class HardBatcher : public Batcher {
 
  private:
   void doRun(const std::vector<MemoryAllocators>& allocators) override;
+  [[nodiscard]] bool canSendDirect() const override { return true; }
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,120 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the sequence batcher
+ */
+
+#include "amdinfer/batching/sequence.hpp"
+
+#include <string>   // for operator+
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/request_container.hpp"  // for RequestContainer
+#include "amdinfer/core/request_usage.hpp"      // for UsageScope
+#include "amdinfer/declarations.hpp"            // for RequestContainerPtr
+#include "amdinfer/observation/logging.hpp"     // for AMDINFER_LOG_DEBUG
+#include "amdinfer/observation/metrics.hpp"     // for Metrics, MetricCounterIDs
+#include "amdinfer/observation/profiling.hpp"   // for profileEvent, profileNow
+#include "amdinfer/observation/tracing.hpp"     // for Trace
+#include "amdinfer/util/queue.hpp"              // for BlockingConcurrentQueue
+#include "amdinfer/util/thread.hpp"             // for setThreadName
+
+namespace amdinfer {
+
+void SequenceBatcher::doRun(
+  [[maybe_unused]] const std::vector<MemoryAllocators>& allocators) {
+  auto thread_name = "batch" + this->getName();
+  util::setThreadName(thread_name);
+#ifdef AMDINFER_ENABLE_LOGGING
+  [[maybe_unused]] const auto& logger = this->getLogger();
+#endif
+
+  bool run = true;
+  while (run) {
+    // the batch size may be changed while the batcher runs
+    this->updateBatchSize();
+    RequestContainerPtr req;
+    this->dequeue(&req, this->batch_size_);
+    const auto opened = profileNow();
+    auto batch = Batch::create(this->batch_size_);
+#ifdef AMDINFER_ENABLE_METRICS
+    batch->setMetrics(metrics_);
+#endif
+    // take the requests that are already waiting without blocking for more
+    do {
+      if (req == nullptr) {
+        run = false;
+        break;
+      }
+      if (this->rejectExpired(*req)) {
+        continue;
+      }
+
+      const auto& request = req->request;
+      const UsageScope usage{request->getUsage(), RequestUsage::Batch};
+      if (request->getInputs().empty()) {
+        request->runCallbackError("Input size is zero");
+        continue;
+      }
+
+#ifdef AMDINFER_ENABLE_METRICS
+      this->recordIngress(batch.get(), *req);
+#endif
+
+      // the worker keeps requests across iterations so their inputs are
+      // passed in place instead of being copied into a batch buffer
+      this->gatherInputs(batch.get(), *request);
+      batch->addRequest(request);
+      batch->addModel("");
+#ifdef AMDINFER_ENABLE_TRACING
+      batch->addTrace(std::move(req->trace));
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+      batch->addTime(req->start_time);
+#endif
+    } while (batch->size() < this->batch_size_ &&
+             this->dequeue(&req, this->batch_size_ - batch->size(), 0));
+
+    if (!batch->empty()) {
+      AMDINFER_LOG_DEBUG(logger, "Enqueuing " + std::to_string(batch->size()) +
+                                   " requests for " + this->model_);
+#ifdef AMDINFER_ENABLE_METRICS
+      // the batcher doesn't wait for more requests so partial batches are
+      // counted as timing out immediately
+      auto reason = BatchCloseReason::Full;
+      if (!run) {
+        reason = BatchCloseReason::Shutdown;
+      } else if (batch->size() < this->batch_size_) {
+        reason = BatchCloseReason::Timeout;
+      }
+      this->recordClose(batch.get(), reason);
+#endif
+      profileEvent("form batch", "batcher", opened);
+      batch->markStage(ServerTiming::Dispatched);
+      this->send(std::move(batch));
+#ifdef AMDINFER_ENABLE_METRICS
+      if (metrics_ != nullptr) {
+        metrics_->incrementCounter(MetricCounterIDs::PipelineEgressBatcher);
+      }
+#endif
+    }
+  }
+}
+
+}  // namespace amdinfer
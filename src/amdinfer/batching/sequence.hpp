@@ -0,0 +1,47 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the sequence batcher implementation
+ */
+
+#ifndef GUARD_AMDINFER_BATCHING_SEQUENCE
+#define GUARD_AMDINFER_BATCHING_SEQUENCE
+
+#include "amdinfer/batching/batcher.hpp"  // IWYU pragma: export
+
+namespace amdinfer {
+enum class MemoryAllocators;
+}  // namespace amdinfer
+
+namespace amdinfer {
+
+/**
+ * @brief The SequenceBatcher feeds a SequenceWorker, which forms its batches
+ * itself at every iteration from the sequences it's running. The batcher
+ * doesn't wait to fill batches: whatever requests have arrived are passed on
+ * at once, in place, so the worker can add them to its next iteration.
+ */
+class SequenceBatcher : public Batcher {
+ public:
+  using Batcher::Batcher;
+
+ private:
+  void doRun(const std::vector<MemoryAllocators>& allocators) override;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_BATCHING_SEQUENCE
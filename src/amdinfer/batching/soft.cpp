@@ -20,9 +20,10 @@
 
 #include "amdinfer/batching/soft.hpp"
 
-#include <algorithm>  // for max
+#include <algorithm>  // for max, min, clamp, binary_search
+#include <chrono>     // for duration
 #include <cstddef>    // for size_t
-#include <cstdint>    // for int32_t
+#include <cstdint>    // for int32_t, int64_t
 #include <memory>     // for unique_ptr, allocator
 #include <ratio>      // for ratio
 #include <string>     // for operator+, char_traits
@@ -36,20 +37,79 @@
 #include "amdinfer/core/memory_pool/pool.hpp"
 #include "amdinfer/core/parameters.hpp"         // for ParameterMap
 #include "amdinfer/core/request_container.hpp"  // for InferenceRequestInput
+#include "amdinfer/core/request_usage.hpp"      // for UsageScope
+#include "amdinfer/core/tensor.hpp"             // for Tensor
 #include "amdinfer/core/worker_info.hpp"
-#include "amdinfer/declarations.hpp"         // for RequestContainerPtr
-#include "amdinfer/observation/logging.hpp"  // for Logger, AMDINFER_LOG_DEBUG
-#include "amdinfer/observation/metrics.hpp"  // for Metrics, MetricCounterIDs
-#include "amdinfer/observation/tracing.hpp"  // for Trace
-#include "amdinfer/util/queue.hpp"           // for BlockingConcurrentQueue
-#include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/util/timer.hpp"           // for Timer
+#include "amdinfer/declarations.hpp"           // for RequestContainerPtr
+#include "amdinfer/observation/logging.hpp"    // for Logger, AMDINFER_LOG_DEBUG
+#include "amdinfer/observation/metrics.hpp"    // for Metrics, MetricCounterIDs
+#include "amdinfer/observation/profiling.hpp"  // for profileEvent, profileNow
+#include "amdinfer/observation/tracing.hpp"    // for Trace
+#include "amdinfer/util/queue.hpp"             // for BlockingConcurrentQueue
+#include "amdinfer/util/thread.hpp"            // for setThreadName
+#include "amdinfer/util/timer.hpp"             // for getTime, TimePoint
+#include "amdinfer/util/timestamps.hpp"        // for Timestamp, elapsed, now
 
-// default batcher timeout in milliseconds
-constexpr auto kDefaultTimeout = 100;
+// weight given to the newest sample in the inter-arrival time estimate
+constexpr auto kArrivalSmoothing = 0.125;
+// extra time given to fill a batch over the expected arrival of its requests
+constexpr auto kArrivalSlack = 1.5;
 
 namespace amdinfer {
 
+namespace {
+
+/**
+ * @brief Tracks an exponentially-weighted moving average of the time between
+ * incoming requests and uses it to size the batching window
+ *
+ */
+class ArrivalEstimator {
+ public:
+  /// Record the arrival of a new request
+  void add(util::Timestamp now) {
+    if (has_arrival_) {
+      auto sample =
+        std::chrono::duration<double, std::milli>(now - last_arrival_).count();
+      interarrival_ = interarrival_ < 0
+                        ? sample
+                        : interarrival_ + (kArrivalSmoothing *
+                                           (sample - interarrival_));
+    }
+    last_arrival_ = now;
+    has_arrival_ = true;
+  }
+
+  /**
+   * @brief Get the time to wait for the remaining requests of a batch. If the
+   * next request isn't expected before the latency budget is exceeded, there's
+   * no point waiting for it and the batch is sent immediately.
+   *
+   * @param remaining number of requests needed to fill the batch
+   * @param budget the maximum time to wait in milliseconds
+   * @return int the time to wait in milliseconds
+   */
+  [[nodiscard]] int window(size_t remaining, int budget) const {
+    if (interarrival_ < 0) {
+      return budget;
+    }
+    if (interarrival_ >= budget) {
+      return 0;
+    }
+    auto expected =
+      interarrival_ * static_cast<double>(remaining) * kArrivalSlack;
+    return static_cast<int>(std::min(expected, static_cast<double>(budget)));
+  }
+
+ private:
+  util::Timestamp last_arrival_;
+  bool has_arrival_ = false;
+  // average time between requests in milliseconds. Negative if unknown
+  double interarrival_ = -1;
+};
+
+}  // namespace
+
 void SoftBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
   auto thread_name = "batch" + this->getName();
   util::setThreadName(thread_name);
@@ -59,56 +119,99 @@ void SoftBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
 
   bool run = true;
 
-  auto timeout = kDefaultTimeout;
-  if (this->parameters_.has("timeout")) {
-    timeout = this->parameters_.get<int32_t>("timeout");
+  // with the adaptive policy, the timeout is treated as the upper bound on the
+  // time spent waiting for a batch and the actual wait is based on the recent
+  // arrival rate of requests
+  bool adaptive = false;
+  if (this->parameters_.has("timeout_policy")) {
+    const auto policy = this->parameters_.get<std::string>("timeout_policy");
+    if (policy == "adaptive") {
+      adaptive = true;
+    } else if (policy != "static") {
+      AMDINFER_LOG_WARN(logger, "Unknown timeout_policy " + policy +
+                                  " for " + this->model_ + ", using static");
+    }
   }
+  ArrivalEstimator arrivals;
 
   while (run) {
-    auto batch = std::make_unique<Batch>();
+    // the batch size and timeout may be changed while the batcher runs
+    this->updateBatchSize();
+    const auto timeout = this->getTimeout();
+    auto batch = Batch::create(this->batch_size_);
+#ifdef AMDINFER_ENABLE_METRICS
+    batch->setMetrics(metrics_);
+#endif
     size_t batch_size = 0;
 
     std::vector<size_t> input_offset;
     std::vector<size_t> output_offset;
 
-#ifdef AMDINFER_ENABLE_METRICS
-    Metrics::getInstance().setGauge(
-      MetricGaugeIDs::QueuesBatcherInput,
-      static_cast<double>(input_queue_->size_approx()));
-    Metrics::getInstance().setGauge(
-      MetricGaugeIDs::QueuesBatcherOutput,
-      static_cast<double>(output_queue_->size_approx()));
-#endif
-
     bool first_request = true;
-    util::Timer timer{true};
+    auto opened = ProfileClock::time_point{};
+    auto started = util::now();
+    auto window = timeout;
+    // the batch is sent early if waiting longer would miss a deadline
+    auto close_time = util::TimePoint::max();
+    [[maybe_unused]] auto reason = BatchCloseReason::Full;
 
     do {
       RequestContainerPtr req;
       if (first_request) {
         // wait for the first request
-        this->input_queue_->wait_dequeue(req);
-        timer.add("start");
+        this->dequeue(&req, this->batch_size_);
+        started = util::now();
         AMDINFER_LOG_DEBUG(logger,
                            "Got request of a new batch for " + this->model_);
+        if (adaptive) {
+          arrivals.add(started);
+          window = arrivals.window(this->batch_size_ - 1, timeout);
+        }
       } else {
-        timer.stop();
-
-        auto remaining_time = timeout - timer.count<std::milli, int>();
+        auto remaining_time =
+          window - util::elapsed<std::milli, int>(started);
         // convert duration from milliseconds to microseconds for function
         auto duration = std::max(remaining_time, 0) * std::kilo::num;
-        bool valid = this->input_queue_->wait_dequeue_timed(req, duration);
+        auto timeout_reason = BatchCloseReason::Timeout;
+        if (close_time != util::TimePoint::max()) {
+          auto until_close =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+              close_time - util::getTime())
+              .count();
+          if (until_close < duration) {
+            timeout_reason = BatchCloseReason::Deadline;
+          }
+          duration = std::clamp<int64_t>(until_close, 0, duration);
+        }
+        bool valid =
+          this->dequeue(&req, this->batch_size_ - batch_size, duration);
         if (!valid) {
+          reason = timeout_reason;
           break;
         }
+        if (adaptive && req != nullptr) {
+          arrivals.add(util::now());
+        }
       }
 
       if (req == nullptr) {
         run = false;
+        reason = BatchCloseReason::Shutdown;
+        break;
+      }
+
+      if (this->rejectExpired(*req)) {
+        continue;
+      }
+      // a request that doesn't fit starts the next batch. One with more
+      // samples than the batch size is sent in a batch of its own
+      if (batch_size > 0 && batch_size + req->samples > this->batch_size_) {
+        this->putBack(std::move(req));
         break;
       }
 
       auto request = req->request;
+      const UsageScope usage{request->getUsage(), RequestUsage::Batch};
       const auto& inputs = request->getInputs();
       auto input_size = inputs.size();
       if (input_size == 0) {
@@ -116,7 +219,7 @@ void SoftBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
         continue;
       }
 
-      if (first_request) {
+      if (first_request && !scatter_gather_) {
         std::vector<BufferPtr> input_buffers;
         input_buffers.reserve(input_size);
         // auto output_sizes = req->getOutputSizes();
@@ -128,7 +231,9 @@ void SoftBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
         // output_buffers.reserve(output_sizes.size());
         // std::vector<size_t> output_offset(output_buffers.size(), 0);
         for (const auto& input : inputs) {
-          input_buffers.push_back(pool_->get(allocators, input, batch_size_));
+          const Tensor tensor{input.getName(), input.getShape(),
+                              this->getBatchDatatype(input)};
+          input_buffers.push_back(pool_->get(allocators, tensor, batch_size_));
         }
         // for(const auto& tensor_size : output_sizes) {
         //   output_buffers.push_back(pool_->get(allocators, tensor_size));
@@ -141,49 +246,79 @@ void SoftBatcher::doRun(const std::vector<MemoryAllocators>& allocators) {
 
 #ifdef AMDINFER_ENABLE_TRACING
       auto& trace = req->trace;
-      trace->startSpan("soft_batcher");
+      if (trace != nullptr) {
+        trace->startSpan("soft_batcher");
+      }
 #endif
 
 #ifdef AMDINFER_ENABLE_METRICS
-      Metrics::getInstance().incrementCounter(
-        MetricCounterIDs::PipelineIngressBatcher);
+      this->recordIngress(batch.get(), *req);
 #endif
+      if (batch->empty()) {
+        opened = profileNow();
+      }
 
-      auto old_input_offset = input_offset;
-
-      for (auto i = 0U; i < input_size; ++i) {
-        const auto& input = inputs[i];
-        const auto& input_buffer = input_buffers.at(i);
-        auto& offset = input_offset[i];
+      if (scatter_gather_) {
+        this->gatherInputs(batch.get(), *request);
+      } else {
+        for (auto i = 0U; i < input_size; ++i) {
+          const auto& input = inputs[i];
+          const auto& input_buffer = input_buffers.at(i);
+          auto& offset = input_offset[i];
 
-        auto new_offset =
-          input_buffer->write(input.getData(), offset,
-                              input.getSize() * input.getDatatype().size());
-        pool_->put(MemoryAllocators::Cpu, input.getData());
-        request->setInputTensorData(i, input_buffer->data(offset));
-        offset = new_offset;
+          const auto datatype = this->getBatchDatatype(input);
+          auto new_offset =
+            this->writeInput(input_buffer.get(), input, offset);
+          pool_->put(MemoryAllocators::Cpu, input.getData());
+          request->setInputTensorData(i, input_buffer->data(offset));
+          request->setInputTensorDatatype(i, datatype);
+          offset = new_offset;
+        }
       }
 
       batch->addRequest(request);
-      batch_size++;
+      batch_size += req->samples;
+      if (req->deadline != util::TimePoint::max()) {
+        close_time = std::min(close_time, req->deadline - deadline_margin_);
+      }
       batch->addModel("");
 #ifdef AMDINFER_ENABLE_TRACING
-      trace->endSpan();
+      if (trace != nullptr) {
+        trace->endSpan();
+      }
       batch->addTrace(std::move(trace));
 #endif
 #ifdef AMDINFER_ENABLE_METRICS
       batch->addTime(req->start_time);
 #endif
       first_request = false;
-    } while (batch_size % this->batch_size_ != 0 && run);
+
+      // a batch of a preferred size is sent unless more requests are waiting
+      if (std::binary_search(preferred_batch_sizes_.begin(),
+                             preferred_batch_sizes_.end(), batch_size) &&
+          this->waiting() == 0) {
+        break;
+      }
+    } while (batch_size < this->batch_size_ && run);
 
     if (!batch->empty()) {
       AMDINFER_LOG_DEBUG(logger, "Enqueuing batch for " + this->model_ +
                                    " of size " + std::to_string(batch_size));
-      this->output_queue_->enqueue(std::move(batch));
 #ifdef AMDINFER_ENABLE_METRICS
-      Metrics::getInstance().incrementCounter(
-        MetricCounterIDs::PipelineEgressBatcher);
+      this->recordClose(batch.get(), reason);
+#endif
+      profileEvent("form batch", "batcher", opened);
+      batch->markStage(ServerTiming::Dispatched);
+      this->send(std::move(batch));
+#ifdef AMDINFER_ENABLE_METRICS
+      if (metrics_ != nullptr) {
+        metrics_->incrementCounter(MetricCounterIDs::PipelineEgressBatcher);
+        metrics_->setGauge(MetricGaugeIDs::BatcherTimeout,
+                           static_cast<double>(window));
+        metrics_->setGauge(MetricGaugeIDs::BatcherFillRatio,
+                           static_cast<double>(batch_size) /
+                             static_cast<double>(this->batch_size_));
+      }
 #endif
     }
   }
@@ -42,6 +42,7 @@ class SoftBatcher : public Batcher {
 
  private:
   void doRun(const std::vector<MemoryAllocators>& allocators) override;
+  [[nodiscard]] bool canSendDirect() const override { return true; }
 };
 
 }  // namespace amdinfer
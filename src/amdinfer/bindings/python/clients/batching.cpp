@@ -0,0 +1,65 @@
+// Copyright 2022 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the Python bindings for the batching.hpp header
+ */
+
+#include "amdinfer/clients/batching.hpp"
+
+#include <pybind11/cast.h>      // for arg
+#include <pybind11/chrono.h>    // IWYU pragma: keep
+#include <pybind11/pybind11.h>  // for class_, init
+#include <pybind11/stl.h>       // IWYU pragma: keep
+
+#include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
+#include "amdinfer/core/parameters.hpp"                     // for ParameterMap
+
+namespace py = pybind11;
+
+namespace amdinfer {
+
+void wrapBatchingClient(py::module_ &m) {
+  py::class_<ClientBatchingOptions>(m, "ClientBatchingOptions")
+    .def(py::init<>(), DOCS(ClientBatchingOptions))
+    .def_readwrite("max_batch_size", &ClientBatchingOptions::max_batch_size,
+                   DOCS(ClientBatchingOptions, max_batch_size))
+    .def_readwrite("timeout", &ClientBatchingOptions::timeout,
+                   DOCS(ClientBatchingOptions, timeout));
+
+  py::class_<BatchingClient, amdinfer::Client>(m, "BatchingClient")
+    // keep the wrapped client alive as long as this one
+    .def(py::init<const Client *, const ClientBatchingOptions &>(),
+         py::arg("client"), py::arg("options") = ClientBatchingOptions(),
+         py::keep_alive<1, 2>(), DOCS(BatchingClient, BatchingClient))
+    .def("serverMetadata", &BatchingClient::serverMetadata,
+         ReleaseGil(), DOCS(BatchingClient, serverMetadata))
+    .def("serverLive", &BatchingClient::serverLive,
+         ReleaseGil(), DOCS(BatchingClient, serverLive))
+    .def("serverReady", &BatchingClient::serverReady,
+         ReleaseGil(), DOCS(BatchingClient, serverReady))
+    .def("workerLoad", &BatchingClient::workerLoad, py::arg("model"),
+         py::arg("parameters") = ParameterMap(),
+         ReleaseGil(), DOCS(BatchingClient, workerLoad))
+    .def("workerUnload", &BatchingClient::workerUnload, py::arg("model"),
+         ReleaseGil(), DOCS(BatchingClient, workerUnload))
+    .def("modelList", &BatchingClient::modelList,
+         ReleaseGil(), DOCS(BatchingClient, modelList))
+    .def("hasHardware", &BatchingClient::hasHardware, py::arg("name"),
+         py::arg("num"), ReleaseGil(), DOCS(BatchingClient, hasHardware));
+}
+
+}  // namespace amdinfer
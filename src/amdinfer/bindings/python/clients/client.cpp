@@ -21,10 +21,22 @@
 #include "amdinfer/clients/client.hpp"
 
 #include <pybind11/cast.h>      // for arg
+#include <pybind11/chrono.h>    // IWYU pragma: keep
 #include <pybind11/pybind11.h>  // for module_, sequence, class_, pybind11
 #include <pybind11/stl.h>       // IWYU pragma: keep
 
+#include <chrono>              // for duration, microseconds
+#include <condition_variable>  // for condition_variable
+#include <future>              // for shared_future, future_status
+#include <memory>              // for shared_ptr, make_shared
+#include <mutex>               // for mutex, lock_guard, unique_lock
+#include <thread>              // for thread
+#include <utility>             // for move
+#include <vector>              // for vector
+
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
+#include "amdinfer/clients/compression.hpp"  // for CompressionOptions
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 
@@ -32,41 +44,253 @@ namespace py = pybind11;
 
 namespace amdinfer {
 
+namespace {
+
+/// The response to an inference request made from Python
+class ResponseFuture {
+ public:
+  explicit ResponseFuture(InferenceResponseFuture future)
+    : future_(future.share()) {}
+
+  /// Wait for the response and get it
+  [[nodiscard]] InferenceResponse get() const { return future_.get(); }
+  /// Check if the response has arrived
+  [[nodiscard]] bool ready() const {
+    return future_.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  }
+  /// Wait up to the timeout for the response and check if it has arrived
+  [[nodiscard]] bool wait(double timeout) const {
+    return future_.wait_for(std::chrono::duration<double>(timeout)) ==
+           std::future_status::ready;
+  }
+
+ private:
+  std::shared_future<InferenceResponse> future_;
+};
+
+using ResponseFuturePtr = std::shared_ptr<ResponseFuture>;
+
+/**
+ * @brief Complete an asyncio future with the response. It runs in the thread
+ * of the future's event loop.
+ *
+ * @param future the asyncio future
+ * @param response the response future, which is ready
+ */
+void resolve(const py::object& future, const ResponseFuturePtr& response) {
+  // the awaiting task may have been cancelled
+  if (future.attr("done")().cast<bool>()) {
+    return;
+  }
+  // calling through Python translates C++ exceptions to the matching Python
+  // ones so they can be set on the future
+  const py::cpp_function get{[response]() { return response->get(); }};
+  try {
+    future.attr("set_result")(get());
+  } catch (py::error_already_set& e) {
+    future.attr("set_exception")(e.value());
+  }
+}
+
+/**
+ * @brief Completes asyncio futures when their responses arrive. One thread
+ * polls the responses in flight, without holding the GIL, so awaiting many
+ * responses doesn't need a thread for each one.
+ */
+class ResponseWatcher {
+ public:
+  /// Get the watcher. It's never destroyed since it holds Python objects that
+  /// can't be released once the interpreter has exited
+  static ResponseWatcher& get() {
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    static auto* watcher = new ResponseWatcher;
+    return *watcher;
+  }
+
+  /// Complete the asyncio future on its event loop when the response arrives.
+  /// The GIL must be held
+  void add(ResponseFuturePtr response, py::object loop, py::object future) {
+    if (!resolver_) {
+      resolver_ = py::cpp_function(&resolve);
+    }
+    {
+      const std::lock_guard lock{mutex_};
+      if (!thread_.joinable()) {
+        thread_ = std::thread{&ResponseWatcher::run, this};
+      }
+      pending_.push_back({std::move(response), std::move(loop),
+                          std::move(future)});
+    }
+    ready_.notify_one();
+  }
+
+  /// Stop watching at exit. The GIL must be held
+  void stop() {
+    {
+      const std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    ready_.notify_one();
+    if (thread_.joinable()) {
+      // the thread may be waiting for the GIL
+      const py::gil_scoped_release release;
+      thread_.join();
+    }
+    pending_.clear();
+  }
+
+ private:
+  struct Pending {
+    ResponseFuturePtr response;
+    py::object loop;
+    py::object future;
+  };
+
+  void run() {
+    const auto poll_interval = std::chrono::microseconds(100);
+    std::vector<Pending> done;
+    while (true) {
+      {
+        std::unique_lock lock{mutex_};
+        if (pending_.empty()) {
+          ready_.wait(lock,
+                      [this]() { return !pending_.empty() || stopping_; });
+        } else {
+          ready_.wait_for(lock, poll_interval, [this]() { return stopping_; });
+        }
+        if (stopping_) {
+          return;
+        }
+        // moving Python objects doesn't touch their reference counts so it's
+        // safe without the GIL
+        for (auto it = pending_.begin(); it != pending_.end();) {
+          if (it->response->ready()) {
+            done.push_back(std::move(*it));
+            it = pending_.erase(it);
+          } else {
+            ++it;
+          }
+        }
+      }
+
+      if (!done.empty()) {
+        const py::gil_scoped_acquire gil;
+        for (const auto& pending : done) {
+          try {
+            pending.loop.attr("call_soon_threadsafe")(
+              resolver_, pending.future, pending.response);
+          } catch (py::error_already_set&) {
+            // the event loop was closed so no one is waiting
+          }
+        }
+        done.clear();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::vector<Pending> pending_;
+  bool stopping_ = false;
+  std::thread thread_;
+  py::object resolver_;
+};
+
+}  // namespace
+
 void wrapClient(py::module_& m) {
+  py::class_<ResponseFuture, ResponseFuturePtr>(m, "InferenceResponseFuture")
+    .def("get", &ResponseFuture::get, ReleaseGil(),
+         "Wait for the response and get it")
+    .def("ready", &ResponseFuture::ready,
+         "Check if the response has arrived without waiting")
+    .def("wait", &ResponseFuture::wait, py::arg("timeout"), ReleaseGil(),
+         "Wait up to the timeout, in seconds, and check if the response has "
+         "arrived")
+    .def(
+      "__await__",
+      [](const ResponseFuturePtr& self) {
+        const auto loop =
+          py::module_::import("asyncio").attr("get_running_loop")();
+        auto future = loop.attr("create_future")();
+        ResponseWatcher::get().add(self, loop, future);
+        return future.attr("__await__")();
+      },
+      "Await the response in a coroutine without blocking the event loop");
+  // stop the watcher thread before the interpreter goes away
+  py::module_::import("atexit").attr("register")(
+    py::cpp_function([]() { ResponseWatcher::get().stop(); }));
+
+  py::enum_<CompressionAlgorithm>(m, "CompressionAlgorithm")
+    .value("Identity", CompressionAlgorithm::Identity)
+    .value("Deflate", CompressionAlgorithm::Deflate)
+    .value("Gzip", CompressionAlgorithm::Gzip)
+    .value("Zstd", CompressionAlgorithm::Zstd);
+
+  py::class_<CompressionOptions>(m, "CompressionOptions")
+    .def(py::init<>(), DOCS(CompressionOptions))
+    .def_readwrite("algorithm", &CompressionOptions::algorithm,
+                   DOCS(CompressionOptions, algorithm))
+    .def_readwrite("threshold", &CompressionOptions::threshold,
+                   DOCS(CompressionOptions, threshold));
+
   py::class_<Client>(m, "Client")
     .def("modelReady", &Client::modelReady, py::arg("model"),
-         py::arg("version") = "", DOCS(Client, modelReady))
+         py::arg("version") = "", ReleaseGil(), DOCS(Client, modelReady))
     .def("modelMetadata", &Client::modelMetadata, py::arg("model"),
-         py::arg("version") = "", DOCS(Client, modelMetadata))
+         py::arg("version") = "", ReleaseGil(), DOCS(Client, modelMetadata))
     .def("modelLoad", &Client::modelLoad, py::arg("model"),
          py::arg("parameters") = ParameterMap(), py::arg("version") = "",
-         DOCS(Client, modelLoad))
+         ReleaseGil(), DOCS(Client, modelLoad))
     .def("modelUnload", &Client::modelUnload, py::arg("model"),
-         py::arg("version") = "", DOCS(Client, modelUnload))
+         py::arg("version") = "", ReleaseGil(), DOCS(Client, modelUnload))
     .def("modelInfer", &Client::modelInfer, py::arg("model"),
-         py::arg("request"), py::arg("version") = "", DOCS(Client, modelInfer));
-  // cannot wrap future directly in Python
-  // .def("modelInferAsync", &GrpcClient::modelInferAsync, py::arg("model"),
-  //      py::arg("request"), DOCS(GrpcClient, modelInferAsync))
+         py::arg("request"), py::arg("version") = "", ReleaseGil(),
+         DOCS(Client, modelInfer))
+    // the request and its data are kept alive as long as the future
+    .def(
+      "modelInferAsync",
+      [](const Client& self, const std::string& model,
+         const InferenceRequest& request, const std::string& version) {
+        return std::make_shared<ResponseFuture>(
+          self.modelInferAsync(model, request, version));
+      },
+      py::arg("model"), py::arg("request"), py::arg("version") = "",
+      ReleaseGil(), py::keep_alive<0, 1>(), py::keep_alive<0, 3>(),
+      DOCS(Client, modelInferAsync));
 
   m.def("serverHasExtension", &serverHasExtension, py::arg("client"),
-        py::arg("extension"));
-  m.def("waitUntilServerReady", &waitUntilServerReady, py::arg("client"));
+        py::arg("extension"), ReleaseGil());
+  m.def("waitUntilServerReady", &waitUntilServerReady, py::arg("client"),
+        ReleaseGil());
   m.def("waitUntilModelReady", &waitUntilModelReady, py::arg("client"),
-        py::arg("model"), py::arg("version") = "");
+        py::arg("model"), py::arg("version") = "", ReleaseGil());
   m.def("waitUntilModelNotReady", &waitUntilModelNotReady, py::arg("client"),
-        py::arg("model"), py::arg("version") = "");
+        py::arg("model"), py::arg("version") = "", ReleaseGil());
 
   m.def("inferAsyncOrdered", &inferAsyncOrdered, py::arg("client"),
-        py::arg("model"), py::arg("requests"), py::arg("version") = "");
+        py::arg("model"), py::arg("requests"), py::arg("version") = "",
+        ReleaseGil());
+  py::class_<InferWindow>(m, "InferWindow")
+    .def(py::init<>(), DOCS(InferWindow))
+    .def_readwrite("max_in_flight", &InferWindow::max_in_flight,
+                   DOCS(InferWindow, max_in_flight))
+    .def_readwrite("adaptive", &InferWindow::adaptive,
+                   DOCS(InferWindow, adaptive))
+    .def_readwrite("target_latency", &InferWindow::target_latency,
+                   DOCS(InferWindow, target_latency));
+  m.def("inferAsyncOrderedWindowed", &inferAsyncOrderedWindowed,
+        py::arg("client"), py::arg("model"), py::arg("requests"),
+        py::arg("window"), py::arg("version") = "", ReleaseGil());
   m.def("inferAsyncOrderedBatched", &inferAsyncOrderedBatched,
         py::arg("client"), py::arg("model"), py::arg("requests"),
-        py::arg("batch_sizes"), py::arg("version") = "");
+        py::arg("batch_sizes"), py::arg("version") = "", ReleaseGil());
 
   m.def("loadEnsemble", &loadEnsemble, py::arg("client"), py::arg("models"),
-        py::arg("parameters"));
+        py::arg("parameters"), ReleaseGil());
   m.def("unloadModels", &unloadModels, py::arg("client"), py::arg("models"),
-        py::arg("version") = "");
+        py::arg("version") = "", ReleaseGil());
 }
 
 }  // namespace amdinfer
@@ -30,6 +30,8 @@ class module_;
 namespace amdinfer {
 
 void wrapClient(pybind11::module_ &);
+void wrapBatchingClient(pybind11::module_ &);
+void wrapLoadBalancingClient(pybind11::module_ &);
 void wrapNativeClient(pybind11::module_ &);
 #ifdef AMDINFER_ENABLE_HTTP
 void wrapHttpClient(pybind11::module_ &);
@@ -42,6 +44,8 @@ void wrapGrpcClient(pybind11::module_ &);
 void inline wrapClients(pybind11::module_ &m) {
   wrapClient(m);
   wrapNativeClient(m);
+  wrapBatchingClient(m);
+  wrapLoadBalancingClient(m);
 #ifdef AMDINFER_ENABLE_HTTP
   wrapHttpClient(m);
   wrapWebSocketClient(m);
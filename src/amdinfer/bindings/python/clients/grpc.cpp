@@ -24,6 +24,7 @@
 #include <pybind11/stl.h>       // IWYU pragma: keep
 
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"
@@ -35,20 +36,38 @@ namespace amdinfer {
 class ParameterMap;
 
 void wrapGrpcClient(py::module_ &m) {
+  py::class_<GrpcClientOptions>(m, "GrpcClientOptions")
+    .def(py::init<>(), DOCS(GrpcClientOptions))
+    .def_readwrite("channels", &GrpcClientOptions::channels,
+                   DOCS(GrpcClientOptions, channels))
+    .def_readwrite("threads", &GrpcClientOptions::threads,
+                   DOCS(GrpcClientOptions, threads))
+    .def_readwrite("share_channels", &GrpcClientOptions::share_channels,
+                   DOCS(GrpcClientOptions, share_channels))
+    .def_readwrite("compression", &GrpcClientOptions::compression,
+                   DOCS(GrpcClientOptions, compression));
+
   py::class_<GrpcClient, amdinfer::Client>(m, "GrpcClient")
     .def(py::init<const std::string &>(), py::arg("address"),
          DOCS(GrpcClient, GrpcClient))
+    .def(py::init<const std::string &, const GrpcClientOptions &>(),
+         py::arg("address"), py::arg("options"),
+         DOCS(GrpcClient, GrpcClient, 2))
     .def("serverMetadata", &GrpcClient::serverMetadata,
-         DOCS(GrpcClient, serverMetadata))
-    .def("serverLive", &GrpcClient::serverLive, DOCS(GrpcClient, serverLive))
-    .def("serverReady", &GrpcClient::serverReady, DOCS(GrpcClient, serverReady))
+         ReleaseGil(), DOCS(GrpcClient, serverMetadata))
+    .def("serverLive", &GrpcClient::serverLive, ReleaseGil(),
+         DOCS(GrpcClient, serverLive))
+    .def("serverReady", &GrpcClient::serverReady, ReleaseGil(),
+         DOCS(GrpcClient, serverReady))
     .def("workerLoad", &GrpcClient::workerLoad, py::arg("model"),
-         py::arg("parameters") = ParameterMap(), DOCS(GrpcClient, workerLoad))
+         py::arg("parameters") = ParameterMap(), ReleaseGil(),
+         DOCS(GrpcClient, workerLoad))
     .def("workerUnload", &GrpcClient::workerUnload, py::arg("model"),
-         DOCS(GrpcClient, workerUnload))
-    .def("modelList", &GrpcClient::modelList, DOCS(GrpcClient, modelList))
+         ReleaseGil(), DOCS(GrpcClient, workerUnload))
+    .def("modelList", &GrpcClient::modelList, ReleaseGil(),
+         DOCS(GrpcClient, modelList))
     .def("hasHardware", &GrpcClient::hasHardware, py::arg("name"),
-         py::arg("num"), DOCS(GrpcClient, hasHardware));
+         py::arg("num"), ReleaseGil(), DOCS(GrpcClient, hasHardware));
 }
 
 }  // namespace amdinfer
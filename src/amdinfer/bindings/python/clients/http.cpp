@@ -21,12 +21,14 @@
 #include "amdinfer/clients/http.hpp"
 
 #include <pybind11/cast.h>      // for arg
+#include <pybind11/chrono.h>    // IWYU pragma: keep
 #include <pybind11/pybind11.h>  // for class_, init
 #include <pybind11/stl.h>       // IWYU pragma: keep
 
 #include <unordered_map>  // for unordered_map
 
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"
@@ -40,26 +42,45 @@ class ParameterMap;
 void wrapHttpClient(py::module_ &m) {
   using amdinfer::HttpClient;
 
-  // default number of clients to create for parallelism
-  const int parallelism = 32;
+  py::class_<ConnectionStats>(m, "ConnectionStats")
+    .def(py::init<>(), DOCS(ConnectionStats))
+    .def_readonly("in_flight", &ConnectionStats::in_flight,
+                  DOCS(ConnectionStats, in_flight))
+    .def_readonly("latency", &ConnectionStats::latency,
+                  DOCS(ConnectionStats, latency))
+    .def_readonly("requests", &ConnectionStats::requests,
+                  DOCS(ConnectionStats, requests))
+    .def_readonly("failures", &ConnectionStats::failures,
+                  DOCS(ConnectionStats, failures))
+    .def_readonly("healthy", &ConnectionStats::healthy,
+                  DOCS(ConnectionStats, healthy));
 
   py::class_<HttpClient, amdinfer::Client>(m, "HttpClient")
     .def(py::init<const std::string &,
-                  const std::unordered_map<std::string, std::string>, int>(),
+                  const std::unordered_map<std::string, std::string>, int,
+                  const CompressionOptions &>(),
          py::arg("address"),
          py::arg("headers") = std::unordered_map<std::string, std::string>(),
-         py::arg("parallelism") = parallelism, DOCS(HttpClient, HttpClient))
+         py::arg("parallelism") = HttpClient::kDefaultParallelism,
+         py::arg("compression") = CompressionOptions(),
+         DOCS(HttpClient, HttpClient))
     .def("serverMetadata", &HttpClient::serverMetadata,
-         DOCS(HttpClient, serverMetadata))
-    .def("serverLive", &HttpClient::serverLive, DOCS(HttpClient, serverLive))
-    .def("serverReady", &HttpClient::serverReady, DOCS(HttpClient, serverReady))
+         ReleaseGil(), DOCS(HttpClient, serverMetadata))
+    .def("serverLive", &HttpClient::serverLive, ReleaseGil(),
+         DOCS(HttpClient, serverLive))
+    .def("serverReady", &HttpClient::serverReady, ReleaseGil(),
+         DOCS(HttpClient, serverReady))
     .def("workerLoad", &HttpClient::workerLoad, py::arg("model"),
-         py::arg("parameters") = ParameterMap(), DOCS(HttpClient, workerLoad))
+         py::arg("parameters") = ParameterMap(), ReleaseGil(),
+         DOCS(HttpClient, workerLoad))
     .def("workerUnload", &HttpClient::workerUnload, py::arg("model"),
-         DOCS(HttpClient, workerUnload))
-    .def("modelList", &HttpClient::modelList, DOCS(HttpClient, modelList))
+         ReleaseGil(), DOCS(HttpClient, workerUnload))
+    .def("modelList", &HttpClient::modelList, ReleaseGil(),
+         DOCS(HttpClient, modelList))
     .def("hasHardware", &HttpClient::hasHardware, py::arg("name"),
-         py::arg("num"), DOCS(HttpClient, hasHardware));
+         py::arg("num"), ReleaseGil(), DOCS(HttpClient, hasHardware))
+    .def("connectionStats", &HttpClient::connectionStats,
+         DOCS(HttpClient, connectionStats));
 }
 
 }  // namespace amdinfer
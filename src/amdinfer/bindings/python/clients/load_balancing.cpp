@@ -0,0 +1,86 @@
+// Copyright 2022 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the Python bindings for the load_balancing.hpp header
+ */
+
+#include "amdinfer/clients/load_balancing.hpp"
+
+#include <pybind11/cast.h>      // for arg
+#include <pybind11/chrono.h>    // IWYU pragma: keep
+#include <pybind11/pybind11.h>  // for class_, init
+#include <pybind11/stl.h>       // IWYU pragma: keep
+
+#include <vector>  // for vector
+
+#include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
+#include "amdinfer/core/parameters.hpp"                     // for ParameterMap
+
+namespace py = pybind11;
+
+namespace amdinfer {
+
+void wrapLoadBalancingClient(py::module_ &m) {
+  py::class_<LoadBalancingOptions>(m, "LoadBalancingOptions")
+    .def(py::init<>(), DOCS(LoadBalancingOptions))
+    .def_readwrite("health_interval", &LoadBalancingOptions::health_interval,
+                   DOCS(LoadBalancingOptions, health_interval))
+    .def_readwrite("hedge_percentile", &LoadBalancingOptions::hedge_percentile,
+                   DOCS(LoadBalancingOptions, hedge_percentile))
+    .def_readwrite("hedge_min_samples",
+                   &LoadBalancingOptions::hedge_min_samples,
+                   DOCS(LoadBalancingOptions, hedge_min_samples))
+    .def_readwrite("poll_interval", &LoadBalancingOptions::poll_interval,
+                   DOCS(LoadBalancingOptions, poll_interval));
+
+  py::class_<BackendStats>(m, "BackendStats")
+    .def(py::init<>(), DOCS(BackendStats))
+    .def_readonly("in_flight", &BackendStats::in_flight,
+                  DOCS(BackendStats, in_flight))
+    .def_readonly("requests", &BackendStats::requests,
+                  DOCS(BackendStats, requests))
+    .def_readonly("failures", &BackendStats::failures,
+                  DOCS(BackendStats, failures))
+    .def_readonly("healthy", &BackendStats::healthy,
+                  DOCS(BackendStats, healthy));
+
+  py::class_<LoadBalancingClient, amdinfer::Client>(m, "LoadBalancingClient")
+    // keep the list of backends, and so the backends, alive as long as this
+    .def(py::init<const std::vector<const Client *> &,
+                  const LoadBalancingOptions &>(),
+         py::arg("backends"), py::arg("options") = LoadBalancingOptions(),
+         py::keep_alive<1, 2>(), DOCS(LoadBalancingClient, LoadBalancingClient))
+    .def("serverMetadata", &LoadBalancingClient::serverMetadata,
+         ReleaseGil(), DOCS(LoadBalancingClient, serverMetadata))
+    .def("serverLive", &LoadBalancingClient::serverLive,
+         ReleaseGil(), DOCS(LoadBalancingClient, serverLive))
+    .def("serverReady", &LoadBalancingClient::serverReady,
+         ReleaseGil(), DOCS(LoadBalancingClient, serverReady))
+    .def("workerLoad", &LoadBalancingClient::workerLoad, py::arg("model"),
+         py::arg("parameters") = ParameterMap(),
+         ReleaseGil(), DOCS(LoadBalancingClient, workerLoad))
+    .def("workerUnload", &LoadBalancingClient::workerUnload, py::arg("model"),
+         ReleaseGil(), DOCS(LoadBalancingClient, workerUnload))
+    .def("modelList", &LoadBalancingClient::modelList,
+         ReleaseGil(), DOCS(LoadBalancingClient, modelList))
+    .def("hasHardware", &LoadBalancingClient::hasHardware, py::arg("name"),
+         py::arg("num"), ReleaseGil(), DOCS(LoadBalancingClient, hasHardware))
+    .def("backendStats", &LoadBalancingClient::backendStats,
+         DOCS(LoadBalancingClient, backendStats));
+}
+
+}  // namespace amdinfer
@@ -24,6 +24,7 @@
 #include <pybind11/stl.h>       // IWYU pragma: keep
 
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"
@@ -37,18 +38,20 @@ void wrapNativeClient(py::module_ &m) {
   py::class_<NativeClient, amdinfer::Client>(m, "NativeClient")
     .def(py::init<Server *>(), py::arg("server"))
     .def("serverMetadata", &NativeClient::serverMetadata,
-         DOCS(NativeClient, serverMetadata))
+         ReleaseGil(), DOCS(NativeClient, serverMetadata))
     .def("serverLive", &NativeClient::serverLive,
-         DOCS(NativeClient, serverLive))
+         ReleaseGil(), DOCS(NativeClient, serverLive))
     .def("serverReady", &NativeClient::serverReady,
-         DOCS(NativeClient, serverReady))
+         ReleaseGil(), DOCS(NativeClient, serverReady))
     .def("workerLoad", &NativeClient::workerLoad, py::arg("model"),
-         py::arg("parameters") = ParameterMap(), DOCS(NativeClient, workerLoad))
+         py::arg("parameters") = ParameterMap(), ReleaseGil(),
+         DOCS(NativeClient, workerLoad))
     .def("workerUnload", &NativeClient::workerUnload, py::arg("model"),
-         DOCS(NativeClient, workerUnload))
-    .def("modelList", &NativeClient::modelList, DOCS(NativeClient, modelList))
+         ReleaseGil(), DOCS(NativeClient, workerUnload))
+    .def("modelList", &NativeClient::modelList, ReleaseGil(),
+         DOCS(NativeClient, modelList))
     .def("hasHardware", &NativeClient::hasHardware, py::arg("name"),
-         py::arg("num"), DOCS(NativeClient, hasHardware));
+         py::arg("num"), ReleaseGil(), DOCS(NativeClient, hasHardware));
 }
 
 }  // namespace amdinfer
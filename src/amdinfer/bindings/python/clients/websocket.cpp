@@ -25,9 +25,11 @@
 #include <pybind11/stl.h>       // IWYU pragma: keep
 
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
+#include "amdinfer/bindings/python/helpers/gil.hpp"         // for ReleaseGil
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"
+#include "amdinfer/core/stream_frame.hpp"    // for StreamFrame
 
 namespace py = pybind11;
 
@@ -38,30 +40,53 @@ class ParameterMap;
 void wrapWebSocketClient(py::module_ &m) {
   using amdinfer::WebSocketClient;
 
+  py::enum_<StreamFrameFormat>(m, "StreamFrameFormat")
+    .value("Empty", StreamFrameFormat::Empty)
+    .value("Jpeg", StreamFrameFormat::Jpeg)
+    .value("Bgr", StreamFrameFormat::Bgr);
+
+  py::class_<StreamFrame>(m, "StreamFrame")
+    .def(py::init<>(), DOCS(StreamFrame))
+    .def_readwrite("key", &StreamFrame::key, DOCS(StreamFrame, key))
+    .def_readwrite("index", &StreamFrame::index, DOCS(StreamFrame, index))
+    .def_readwrite("results", &StreamFrame::results,
+                   DOCS(StreamFrame, results))
+    .def_readwrite("format", &StreamFrame::format, DOCS(StreamFrame, format))
+    .def_readwrite("width", &StreamFrame::width, DOCS(StreamFrame, width))
+    .def_readwrite("height", &StreamFrame::height, DOCS(StreamFrame, height))
+    // the image is binary so it's returned as bytes instead of str
+    .def_property(
+      "data", [](const StreamFrame &self) { return py::bytes(self.data); },
+      [](StreamFrame &self, const py::bytes &data) { self.data = data; },
+      DOCS(StreamFrame, data));
+
   py::class_<WebSocketClient, amdinfer::Client>(m, "WebSocketClient")
     .def(py::init<const std::string &, const std::string &>(),
          py::arg("ws_address"), py::arg("http_address"),
          DOCS(WebSocketClient, WebSocketClient))
     .def("serverMetadata", &WebSocketClient::serverMetadata,
-         DOCS(WebSocketClient, serverMetadata))
+         ReleaseGil(), DOCS(WebSocketClient, serverMetadata))
     .def("serverLive", &WebSocketClient::serverLive,
-         DOCS(WebSocketClient, serverLive))
+         ReleaseGil(), DOCS(WebSocketClient, serverLive))
     .def("serverReady", &WebSocketClient::serverReady,
-         DOCS(WebSocketClient, serverReady))
+         ReleaseGil(), DOCS(WebSocketClient, serverReady))
     .def("workerLoad", &WebSocketClient::workerLoad, py::arg("model"),
          py::arg("parameters") = ParameterMap(),
-         DOCS(WebSocketClient, workerLoad))
+         ReleaseGil(), DOCS(WebSocketClient, workerLoad))
     .def("workerUnload", &WebSocketClient::workerUnload, py::arg("model"),
-         DOCS(WebSocketClient, workerUnload))
+         ReleaseGil(), DOCS(WebSocketClient, workerUnload))
     .def("modelInferWs", &WebSocketClient::modelInferWs, py::arg("model"),
-         py::arg("request"), DOCS(WebSocketClient, modelInferWs))
+         py::arg("request"), ReleaseGil(), DOCS(WebSocketClient, modelInferWs))
     .def("modelRecv", &WebSocketClient::modelRecv,
-         DOCS(WebSocketClient, modelRecv))
+         ReleaseGil(), DOCS(WebSocketClient, modelRecv))
+    .def("modelRecvFrame", &WebSocketClient::modelRecvFrame,
+         ReleaseGil(), DOCS(WebSocketClient, modelRecvFrame))
     .def("modelList", &WebSocketClient::modelList,
-         DOCS(WebSocketClient, modelList))
+         ReleaseGil(), DOCS(WebSocketClient, modelList))
     .def("hasHardware", &WebSocketClient::hasHardware, py::arg("name"),
-         py::arg("num"), DOCS(WebSocketClient, hasHardware))
-    .def("close", &WebSocketClient::close, DOCS(WebSocketClient, close));
+         py::arg("num"), ReleaseGil(), DOCS(WebSocketClient, hasHardware))
+    .def("close", &WebSocketClient::close, ReleaseGil(),
+         DOCS(WebSocketClient, close));
 }
 
 }  // namespace amdinfer
@@ -0,0 +1,38 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the conversion between Python lists and the Shape class
+ */
+
+#ifndef GUARD_AMDINFER_BINDINGS_PYTHON_CORE_BIND_SHAPE
+#define GUARD_AMDINFER_BINDINGS_PYTHON_CORE_BIND_SHAPE
+
+#include <pybind11/stl.h>  // for list_caster
+
+#include <cstdint>  // for int64_t
+
+#include "amdinfer/core/shape.hpp"  // for Shape
+
+namespace pybind11::detail {
+
+// shapes are passed to and from Python as lists of ints
+template <>
+struct type_caster<amdinfer::Shape>
+  : list_caster<amdinfer::Shape, int64_t> {};
+
+}  // namespace pybind11::detail
+
+#endif  // GUARD_AMDINFER_BINDINGS_PYTHON_CORE_BIND_SHAPE
@@ -59,6 +59,10 @@ void wrapDataType(py::module_& m) {
       "FP16", [](const py::object& /*self*/) { return DataType("FP16"); })
     .def_property_readonly_static(
       "FLOAT16", [](const py::object& /*self*/) { return DataType("FP16"); })
+    .def_property_readonly_static(
+      "BF16", [](const py::object& /*self*/) { return DataType("BF16"); })
+    .def_property_readonly_static(
+      "BFLOAT16", [](const py::object& /*self*/) { return DataType("BF16"); })
     .def_property_readonly_static(
       "FP32", [](const py::object& /*self*/) { return DataType("FP32"); })
     .def_property_readonly_static(
@@ -93,6 +97,7 @@ void wrapDataType(py::module_& m) {
     .value("INT32", DataType::Int32)
     .value("INT64", DataType::Int64)
     .value("FP16", DataType::Fp16)
+    .value("BF16", DataType::Bf16)
     .value("FP32", DataType::Fp32)
     .value("FLOAT32", DataType::Fp32)
     .value("FP64", DataType::Fp64)
@@ -29,11 +29,14 @@
 #include <cstring>        // for memcpy
 #include <sstream>        // IWYU pragma: keep
 #include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
 
 #include "amdinfer/bindings/python/core/bind_fp16.hpp"
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
 #include "amdinfer/bindings/python/helpers/keep_alive.hpp"  // for keep_alive
+#include "amdinfer/bindings/python/helpers/numpy.hpp"       // for viewArray
 #include "amdinfer/bindings/python/helpers/print.hpp"       // for toString
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
 #include "amdinfer/core/inference_response.hpp"
 
 namespace py = pybind11;
@@ -41,21 +44,45 @@ namespace py = pybind11;
 namespace amdinfer {
 
 template <typename T>
-py::array_t<T> getData(const amdinfer::InferenceRequestInput &self) {
-  auto *data = static_cast<T *>(self.getData());
-  return py::array_t<T>(self.getSize(), data);
-
-  // return py::memoryview::from_memory(data->data(), self.getSize());
+py::array_t<T> getData(const py::object &self) {
+  const auto &input = self.cast<const InferenceRequestInput &>();
+  auto *data = static_cast<T *>(input.getData());
+  // the array views the input's data and keeps the input alive
+  return py::array_t<T>(input.getSize(), data, self);
 }
 
 template <typename T>
-void setData(amdinfer::InferenceRequestInput &self, py::array_t<T> &b) {
-  // NOLINTNEXTLINE(google-readability-casting)
-  self.setData((void *)(b.data()));
+void setData(const py::object &self, const py::object &data) {
+  auto &input = self.cast<InferenceRequestInput &>();
+  auto array = viewArray<T>(self, data);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  input.setData(const_cast<T *>(array.data()));
+}
+
+void setArray(const py::object &self, const py::object &data) {
+  auto &input = self.cast<InferenceRequestInput &>();
+  auto array = py::array::ensure(data, py::array::c_style);
+  if (!array) {
+    throw invalid_argument("The data can't be converted to a NumPy array");
+  }
+  if (!array.is(data)) {
+    py::detail::keep_alive_impl(self, array);
+  }
+
+  std::vector<int64_t> shape(array.shape(), array.shape() + array.ndim());
+  const auto datatype = dataTypeOf(array.dtype());
+  if (datatype == DataType::Bytes) {
+    shape = {static_cast<int64_t>(array.nbytes())};
+  }
+  input.setDatatype(datatype);
+  input.setShape(std::move(shape));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  input.setData(const_cast<void *>(array.data()));
 }
 
 void wrapInferenceRequestInput(py::module_ &m) {
-  py::class_<InferenceRequestInput, InferenceTensor>(m, "InferenceRequestInput")
+  py::class_<InferenceRequestInput, InferenceTensor>(m, "InferenceRequestInput",
+                                                     py::buffer_protocol())
     .def(py::init<>(), DOCS(InferenceRequestInput, InferenceRequestInput))
     .def(py::init<const Tensor &>(),
          DOCS(InferenceRequestInput, InferenceRequestInput, 2),
@@ -63,6 +90,13 @@ void wrapInferenceRequestInput(py::module_ &m) {
     .def(py::init<void *, std::vector<int64_t>, DataType, std::string>(),
          DOCS(InferenceRequestInput, InferenceRequestInput, 3), py::arg("data"),
          py::arg("shape"), py::arg("data_type"), py::arg("data") = "")
+    // np.asarray(input) views the data with its shape and datatype
+    .def_buffer([](const InferenceRequestInput &self) {
+      return tensorBuffer(self, false);
+    })
+    .def("setArray", &setArray, py::arg("array"), KeepAliveAssign(),
+         "Set the data, shape and datatype from a NumPy array. The array is "
+         "used without copying if it's C-contiguous")
     .def("setUint8Data", &setData<uint8_t>, KeepAliveAssign())
     .def("setUint16Data", &setData<uint16_t>, KeepAliveAssign())
     .def("setUint32Data", &setData<uint32_t>, KeepAliveAssign())
@@ -72,6 +106,8 @@ void wrapInferenceRequestInput(py::module_ &m) {
     .def("setInt32Data", &setData<int32_t>, KeepAliveAssign())
     .def("setInt64Data", &setData<int64_t>, KeepAliveAssign())
     .def("setFp16Data", &setData<amdinfer::fp16>, KeepAliveAssign())
+    // NumPy has no bfloat16 so BF16 data is passed as its bits in uint16
+    .def("setBf16Data", &setData<uint16_t>, KeepAliveAssign())
     .def("setFp32Data", &setData<float>, KeepAliveAssign())
     .def("setFp64Data", &setData<double>, KeepAliveAssign())
     .def("setStringData", &setData<unsigned char>, KeepAliveAssign())
@@ -84,6 +120,7 @@ void wrapInferenceRequestInput(py::module_ &m) {
     .def("getInt32Data", &getData<int32_t>, KeepAliveReturn())
     .def("getInt64Data", &getData<int64_t>, KeepAliveReturn())
     .def("getFp16Data", &getData<amdinfer::fp16>, KeepAliveReturn())
+    .def("getBf16Data", &getData<uint16_t>, KeepAliveReturn())
     .def("getFp32Data", &getData<float>, KeepAliveReturn())
     .def("getFp64Data", &getData<double>, KeepAliveReturn())
     .def("getStringData", &getData<char>, KeepAliveReturn())
@@ -116,6 +153,12 @@ void wrapInferenceRequest(py::module_ &m) {
   auto addInputTensor =
     static_cast<void (InferenceRequest::*)(InferenceRequestInput)>(
       &InferenceRequest::addInputTensor);
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  auto getInputs = static_cast<const std::vector<InferenceRequestInput> &(
+    InferenceRequest::*)() const &>(&InferenceRequest::getInputs);
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  auto getOutputs = static_cast<const std::vector<InferenceRequestOutput> &(
+    InferenceRequest::*)() const &>(&InferenceRequest::getOutputs);
   py::class_<InferenceRequest>(m, "InferenceRequest")
     .def(py::init<>(), DOCS(InferenceRequest, InferenceRequest))
     .def("propagate", &InferenceRequest::propagate,
@@ -123,10 +166,10 @@ void wrapInferenceRequest(py::module_ &m) {
     .def_property("id", &InferenceRequest::getID, &InferenceRequest::setID)
     .def_property("parameters", &InferenceRequest::getParameters,
                   &InferenceRequest::setParameters)
-    .def("getOutputs", &InferenceRequest::getOutputs,
+    .def("getOutputs", getOutputs,
          py::return_value_policy::reference_internal,
          DOCS(InferenceRequest, getOutputs))
-    .def("getInputs", &InferenceRequest::getInputs,
+    .def("getInputs", getInputs,
          py::return_value_policy::reference_internal,
          DOCS(InferenceRequest, getInputs))
     .def("getInputSize", &InferenceRequest::getInputSize,
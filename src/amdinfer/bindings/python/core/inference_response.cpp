@@ -29,10 +29,13 @@
 #include <cstring>        // for memcpy
 #include <sstream>        // IWYU pragma: keep
 #include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
 
 #include "amdinfer/bindings/python/core/bind_fp16.hpp"
+#include "amdinfer/bindings/python/core/bind_shape.hpp"  // IWYU pragma: keep
 #include "amdinfer/bindings/python/helpers/docstrings.hpp"  // for DOCS
 #include "amdinfer/bindings/python/helpers/keep_alive.hpp"  // for keep_alive
+#include "amdinfer/bindings/python/helpers/numpy.hpp"  // for tensorBuffer
 #include "amdinfer/bindings/python/helpers/print.hpp"       // for toString
 #include "amdinfer/core/inference_request.hpp"
 
@@ -57,7 +60,9 @@ void wrapInferenceResponse(py::module_ &m) {
 #endif
     .def("getParameters", &InferenceResponse::getParameters,
          DOCS(InferenceResponse, getParameters))
-    .def("getOutputs", &InferenceResponse::getOutputs,
+    .def("getOutputs",
+         static_cast<const std::vector<InferenceResponseOutput> &(
+           InferenceResponse::*)() const &>(&InferenceResponse::getOutputs),
          py::return_value_policy::reference_internal,
          DOCS(InferenceResponse, getOutputs))
     .def("addOutput", &InferenceResponse::addOutput, py::arg("output"),
@@ -75,11 +80,11 @@ void wrapInferenceResponse(py::module_ &m) {
 }
 
 template <typename T>
-py::array_t<T> getData(const amdinfer::InferenceResponseOutput &self) {
-  auto *data = static_cast<T *>(self.getData());
-  return py::array_t<T>(self.getSize(), data);
-
-  // return py::memoryview::from_memory(data->data(), self.getSize());
+py::array_t<T> getData(const py::object &self) {
+  const auto &output = self.cast<const InferenceResponseOutput &>();
+  auto *data = static_cast<T *>(output.getData());
+  // the array views the output's data and keeps the output alive
+  return py::array_t<T>(output.getSize(), data, self);
 }
 
 template <typename T>
@@ -94,12 +99,17 @@ void wrapInferenceResponseOutput(py::module_ &m) {
   // need to use function pointer to disambiguate overloaded function
   // NOLINTNEXTLINE(readability-identifier-naming)
   auto setShape =
-    static_cast<void (InferenceResponseOutput::*)(std::vector<int64_t>)>(
+    static_cast<void (InferenceResponseOutput::*)(Shape)>(
       &InferenceResponseOutput::setShape);
 
   py::class_<InferenceResponseOutput, InferenceTensor>(
-    m, "InferenceResponseOutput")
+    m, "InferenceResponseOutput", py::buffer_protocol())
     .def(py::init<>(), DOCS(InferenceResponseOutput))
+    // np.asarray(output) views the data with its shape and datatype. It's
+    // read-only since the data may be shared with other outputs
+    .def_buffer([](const InferenceResponseOutput &self) {
+      return tensorBuffer(self, true);
+    })
     .def("setUint8Data", &setData<uint8_t>, KeepAliveAssign())
     .def("setUint16Data", &setData<uint16_t>, KeepAliveAssign())
     .def("setUint32Data", &setData<uint32_t>, KeepAliveAssign())
@@ -109,6 +119,8 @@ void wrapInferenceResponseOutput(py::module_ &m) {
     .def("setInt32Data", &setData<int32_t>, KeepAliveAssign())
     .def("setInt64Data", &setData<int64_t>, KeepAliveAssign())
     .def("setFp16Data", &setData<amdinfer::fp16>, KeepAliveAssign())
+    // NumPy has no bfloat16 so BF16 data is passed as its bits in uint16
+    .def("setBf16Data", &setData<uint16_t>, KeepAliveAssign())
     .def("setFp32Data", &setData<float>, KeepAliveAssign())
     .def("setFp64Data", &setData<double>, KeepAliveAssign())
     .def(
@@ -129,6 +141,7 @@ void wrapInferenceResponseOutput(py::module_ &m) {
     .def("getInt32Data", &getData<int32_t>, KeepAliveReturn())
     .def("getInt64Data", &getData<int64_t>, KeepAliveReturn())
     .def("getFp16Data", &getData<amdinfer::fp16>, KeepAliveReturn())
+    .def("getBf16Data", &getData<uint16_t>, KeepAliveReturn())
     .def("getFp32Data", &getData<float>, KeepAliveReturn())
     .def("getFp64Data", &getData<double>, KeepAliveReturn())
     .def("getStringData", &getData<char>, KeepAliveReturn())
@@ -0,0 +1,205 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines helpers to share tensor data with NumPy without copying
+ */
+
+#ifndef GUARD_AMDINFER_BINDINGS_PYTHON_HELPERS_NUMPY
+#define GUARD_AMDINFER_BINDINGS_PYTHON_HELPERS_NUMPY
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <string>
+#include <vector>
+
+#include "amdinfer/core/data_types.hpp"
+#include "amdinfer/core/exceptions.hpp"
+
+namespace amdinfer {
+
+/**
+ * @brief Get the buffer protocol format of a datatype. NumPy has no bfloat16
+ * so BF16 data is shown as its bits in uint16 and BYTES data is shown as uint8
+ *
+ * @param type the datatype
+ * @return std::string
+ */
+inline std::string bufferFormat(DataType type) {
+  switch (type) {
+    case DataType::Bool:
+      return pybind11::format_descriptor<bool>::format();
+    case DataType::Uint8:
+    case DataType::Bytes:
+      return pybind11::format_descriptor<uint8_t>::format();
+    case DataType::Uint16:
+    case DataType::Bf16:
+      return pybind11::format_descriptor<uint16_t>::format();
+    case DataType::Uint32:
+      return pybind11::format_descriptor<uint32_t>::format();
+    case DataType::Uint64:
+      return pybind11::format_descriptor<uint64_t>::format();
+    case DataType::Int8:
+      return pybind11::format_descriptor<int8_t>::format();
+    case DataType::Int16:
+      return pybind11::format_descriptor<int16_t>::format();
+    case DataType::Int32:
+      return pybind11::format_descriptor<int32_t>::format();
+    case DataType::Int64:
+      return pybind11::format_descriptor<int64_t>::format();
+    case DataType::Fp16:
+      // the buffer protocol's half-precision float
+      return "e";
+    case DataType::Fp32:
+      return pybind11::format_descriptor<float>::format();
+    case DataType::Fp64:
+      return pybind11::format_descriptor<double>::format();
+    default:
+      throw invalid_argument("Unsupported datatype: " +
+                             std::string{type.str()});
+  }
+}
+
+/**
+ * @brief Get the datatype of a NumPy dtype
+ *
+ * @param dtype the NumPy dtype
+ * @return DataType
+ */
+inline DataType dataTypeOf(const pybind11::dtype& dtype) {
+  const auto size = dtype.itemsize();
+  switch (dtype.kind()) {
+    case 'b':
+      return DataType::Bool;
+    case 'u':
+      switch (size) {
+        case sizeof(uint8_t):
+          return DataType::Uint8;
+        case sizeof(uint16_t):
+          return DataType::Uint16;
+        case sizeof(uint32_t):
+          return DataType::Uint32;
+        case sizeof(uint64_t):
+          return DataType::Uint64;
+        default:
+          break;
+      }
+      break;
+    case 'i':
+      switch (size) {
+        case sizeof(int8_t):
+          return DataType::Int8;
+        case sizeof(int16_t):
+          return DataType::Int16;
+        case sizeof(int32_t):
+          return DataType::Int32;
+        case sizeof(int64_t):
+          return DataType::Int64;
+        default:
+          break;
+      }
+      break;
+    case 'f':
+      switch (size) {
+        case sizeof(fp16):
+          return DataType::Fp16;
+        case sizeof(float):
+          return DataType::Fp32;
+        case sizeof(double):
+          return DataType::Fp64;
+        default:
+          break;
+      }
+      break;
+    case 'S':
+      return DataType::Bytes;
+    default:
+      break;
+  }
+  throw invalid_argument("Unsupported NumPy dtype: " +
+                         pybind11::str(dtype).cast<std::string>());
+}
+
+/**
+ * @brief Describe a tensor's data as a C-contiguous buffer with its shape so
+ * NumPy can view it without copying. BYTES tensors are shown as flat bytes
+ *
+ * @tparam Tensor type of the tensor
+ * @param tensor the tensor
+ * @param readonly if the buffer may not be written to
+ * @return pybind11::buffer_info
+ */
+template <typename Tensor>
+pybind11::buffer_info tensorBuffer(const Tensor& tensor, bool readonly) {
+  const auto type = tensor.getDatatype();
+  const auto itemsize = static_cast<pybind11::ssize_t>(type.size());
+
+  std::vector<pybind11::ssize_t> shape;
+  if (type == DataType::Bytes) {
+    shape.push_back(static_cast<pybind11::ssize_t>(tensor.getSize()));
+  } else {
+    for (const auto& dim : tensor.getShape()) {
+      shape.push_back(static_cast<pybind11::ssize_t>(dim));
+    }
+  }
+  std::vector<pybind11::ssize_t> strides(shape.size());
+  auto stride = itemsize;
+  for (auto i = shape.size(); i > 0; --i) {
+    strides[i - 1] = stride;
+    stride *= shape[i - 1];
+  }
+
+  return {tensor.getData(),
+          itemsize,
+          bufferFormat(type),
+          static_cast<pybind11::ssize_t>(shape.size()),
+          std::move(shape),
+          std::move(strides),
+          readonly};
+}
+
+/// A C-contiguous NumPy array of the given type
+template <typename T>
+using ContiguousArray =
+  pybind11::array_t<T, pybind11::array::c_style | pybind11::array::forcecast>;
+
+/**
+ * @brief Get Python data as a C-contiguous NumPy array of the given type. It's
+ * not copied if it already is one. Otherwise, it's converted to a new array
+ * that is kept alive as long as the owner since callers only keep the original
+ * data alive.
+ *
+ * @tparam T type of the data
+ * @param owner the object to keep the data alive as long as
+ * @param data the NumPy array or other Python data
+ * @return ContiguousArray<T>
+ */
+template <typename T>
+ContiguousArray<T> viewArray(pybind11::handle owner,
+                             const pybind11::object& data) {
+  auto array = ContiguousArray<T>::ensure(data);
+  if (!array) {
+    throw invalid_argument("The data can't be converted to a NumPy array");
+  }
+  if (!array.is(data)) {
+    pybind11::detail::keep_alive_impl(owner, array);
+  }
+  return array;
+}
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_BINDINGS_PYTHON_HELPERS_NUMPY
@@ -35,16 +35,28 @@ void wrapServer(py::module_ &m) {
   py::class_<Server>(m, "Server")
     .def(py::init<>(), DOCS(Server, Server))
     .def("startHttp", &Server::startHttp, py::arg("port"),
-         DOCS(Server, startHttp))
+         py::arg("threads") = 0, py::arg("cpus") = "",
+         py::arg("decode_threads") = 0, DOCS(Server, startHttp))
     .def("stopHttp", &Server::stopHttp, DOCS(Server, stopHttp))
     .def("startGrpc", &Server::startGrpc, py::arg("port"),
-         DOCS(Server, startGrpc))
+         py::arg("socket") = "", DOCS(Server, startGrpc))
+    .def("setWorkerCpus", &Server::setWorkerCpus, py::arg("cpus"),
+         DOCS(Server, setWorkerCpus))
     .def("stopGrpc", &Server::stopGrpc, DOCS(Server, stopGrpc))
     .def("setModelRepository", &Server::setModelRepository,
          py::arg("repository_path"), py::arg("load_existing"),
          DOCS(Server, setModelRepository))
     .def("enableRepositoryMonitoring", &Server::enableRepositoryMonitoring,
-         py::arg("use_polling"), DOCS(Server, enableRepositoryMonitoring));
+         py::arg("use_polling"), DOCS(Server, enableRepositoryMonitoring))
+    .def("enableLazyLoading", &Server::enableLazyLoading,
+         py::arg("memory_budget"), py::arg("idle_timeout"),
+         DOCS(Server, enableLazyLoading))
+    .def("enableLoadShedding", &Server::enableLoadShedding,
+         py::arg("target_latency"), py::arg("max_inflight"),
+         DOCS(Server, enableLoadShedding))
+    .def("enableRateLimiting", &Server::enableRateLimiting, py::arg("rate"),
+         py::arg("burst"), py::arg("tenant_key"),
+         DOCS(Server, enableRateLimiting));
 }
 
 }  // namespace amdinfer
@@ -35,6 +35,25 @@ from ._amdinfer import *
 sys.setdlopenflags(flags)
 
 
+def float32_to_bfloat16(array):
+    """
+    Convert an array to the bit patterns of the nearest BF16 values, as uint16.
+    NumPy has no bfloat16 type so BF16 tensors hold their bits in uint16
+    arrays.
+    """
+    bits = np.ascontiguousarray(array, dtype=np.float32).view(np.uint32)
+    rounded = (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16
+    quiet = (bits >> 16) | 0x40
+    nan = (bits & 0x7FFFFFFF) > 0x7F800000
+    return np.where(nan, quiet, rounded).astype(np.uint16)
+
+
+def bfloat16_to_float32(array):
+    """Convert the bit patterns of BF16 values in a uint16 array to float32"""
+    bits = np.ascontiguousarray(array, dtype=np.uint16).astype(np.uint32)
+    return (bits << 16).view(np.float32)
+
+
 def _set_data(input_n, image):
     if input_n.datatype == DataType.UINT8:
         input_n.setUint8Data(image)
@@ -54,6 +73,10 @@ def _set_data(input_n, image):
         input_n.setInt64Data(image)
     elif input_n.datatype == DataType.FP16:
         input_n.setFp16Data(image)
+    elif input_n.datatype == DataType.BF16:
+        if image.dtype != np.uint16:
+            image = float32_to_bfloat16(image)
+        input_n.setBf16Data(image)
     elif input_n.datatype == DataType.FP32:
         input_n.setFp32Data(image)
     elif input_n.datatype == DataType.FP64:
@@ -102,9 +125,7 @@ def ImageInferenceRequest(images, modelMetaData=None, asTensor=True):
         if isinstance(image, str):
             if asTensor:
                 read_image = cv2.imread(image)
-                input_n.datatype = getattr(DataType, str(read_image.dtype).upper())
-                input_n.shape = [*read_image.shape]  # Convert tuple to list
-                input_n = _set_data(input_n, read_image.flatten())
+                input_n.setArray(read_image)
             else:
                 input_n.datatype = DataType.BYTES
                 with open(image, "rb") as f:
@@ -112,9 +133,8 @@ def ImageInferenceRequest(images, modelMetaData=None, asTensor=True):
                     input_n = _set_data(input_n, stringToArray(data))
                     input_n.shape = [len(data)]
         elif isinstance(image, np.ndarray):
-            input_n.datatype = getattr(DataType, str(image.dtype).upper())
-            input_n.shape = [*image.shape]  # Convert tuple to list
-            _set_data(input_n, image.flatten())
+            # the array is used without copying if it's C-contiguous
+            input_n.setArray(image)
         else:
             raise TypeError("Unknown type passed to ImageInferenceRequest")
         request.addInputTensor(input_n)
@@ -202,6 +222,8 @@ def _get_data(request_input: InferenceRequestInput):
         return request_input.getInt64Data()
     if datatype == DataType.FP16:
         return request_input.getFp16Data()
+    if datatype == DataType.BF16:
+        return request_input.getBf16Data()
     if datatype == DataType.FP32:
         return request_input.getFp32Data()
     if datatype == DataType.FP64:
@@ -75,18 +75,8 @@ class Buffer {
   template <typename T>
   size_t write(T value, size_t offset) {
     if constexpr (std::is_same_v<std::string, T>) {
-      // not quite sure what the best way to do this is. The commented out code
-      // is other attempts. This works but may be non-optimal.
-      char null_term = '\0';
-      std::copy(value.begin(), value.end(),
-                static_cast<char*>(this->data(offset)));
-      // strcpy(reinterpret_cast<char*>(static_cast<std::byte*>(this->data()) +
-      // this->write_counter_),
-      // value.c_str());
-      std::memcpy(static_cast<std::byte*>(this->data(offset)) + value.length(),
-                  &null_term, 1);
-
-      // this->write_counter_ += value.length() + 1;
+      // BYTES elements are null-terminated so copy the terminator too
+      std::memcpy(this->data(offset), value.c_str(), value.length() + 1);
       return offset + value.length() + 1;
     } else {
       return this->write(&value, offset, sizeof(T));
@@ -0,0 +1,48 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the HipBuffer class
+ */
+
+#include "amdinfer/buffers/hip.hpp"
+
+#include <hip/hip_runtime_api.h>  // for hipMemcpy
+
+#include "amdinfer/core/exceptions.hpp"
+#include "amdinfer/core/memory_pool/pool.hpp"
+
+namespace amdinfer {
+
+HipBuffer::HipBuffer(void* data, MemoryAllocators allocator)
+  : Buffer(allocator), data_(static_cast<std::byte*>(data)) {}
+
+void* HipBuffer::data(size_t offset) { return data_ + offset; }
+
+size_t HipBuffer::write(void* data, size_t offset, size_t size) {
+  if (hipMemcpy(data_ + offset, data, size, hipMemcpyDefault) != hipSuccess) {
+    throw runtime_error("Data could not be copied to the GPU");
+  }
+  return offset + size;
+}
+
+void HipBuffer::free() {
+  const auto* pool = getPool();
+  if (pool != nullptr) {
+    pool->put(getAllocator(), data_);
+  }
+}
+
+}  // namespace amdinfer
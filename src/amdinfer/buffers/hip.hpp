@@ -0,0 +1,72 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the HipBuffer class
+ */
+
+#ifndef GUARD_AMDINFER_BUFFERS_HIP
+#define GUARD_AMDINFER_BUFFERS_HIP
+
+#include <cstddef>  // for size_t, byte
+
+#include "amdinfer/buffers/buffer.hpp"  // IWYU pragma: export
+
+namespace amdinfer {
+
+enum class MemoryAllocators;
+
+/**
+ * @brief HipBuffer wraps memory on an AMD GPU. The data can't be dereferenced
+ * on the host and is written with HIP copies instead.
+ *
+ */
+class HipBuffer : public Buffer {
+ public:
+  /**
+   * @brief Construct a new HipBuffer object
+   *
+   * @param data non-owning pointer to device memory
+   * @param allocator type of memory allocator
+   */
+  HipBuffer(void* data, MemoryAllocators allocator);
+
+  /**
+   * @brief Returns a device pointer to the underlying data
+   *
+   * @return void*
+   */
+  void* data(size_t offset) override;
+
+  /**
+   * @brief Copy data into this buffer. The source may be in host or device
+   * memory.
+   *
+   * @param data pointer to data
+   * @param offset offset to start writing the data
+   * @param size size of the data to write in bytes
+   * @return size_t the offset after the written data
+   */
+  size_t write(void* data, size_t offset, size_t size) override;
+
+  void free() override;
+
+ private:
+  std::byte* data_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_BUFFERS_HIP
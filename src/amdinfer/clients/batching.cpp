@@ -0,0 +1,449 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the client that merges concurrent inference requests
+ */
+
+#include "amdinfer/clients/batching.hpp"
+
+#include <algorithm>           // for equal, min
+#include <condition_variable>  // for condition_variable
+#include <cstdint>             // for int64_t
+#include <cstring>             // for memcpy
+#include <deque>               // for deque
+#include <exception>           // for current_exception, exception_ptr
+#include <future>              // for promise, future
+#include <map>                 // for map
+#include <mutex>               // for mutex, unique_lock, lock_guard
+#include <thread>              // for thread
+#include <utility>             // for move, pair
+
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+
+namespace amdinfer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Number of samples in the request if it can be merged, otherwise zero
+size_t countSamples(const InferenceRequest& request) {
+  const auto& inputs = request.getInputs();
+  if (inputs.empty() || !request.getParameters().empty()) {
+    return 0;
+  }
+  const auto& first = inputs.front().getShape();
+  if (first.empty() || first[0] <= 0) {
+    return 0;
+  }
+  for (const auto& input : inputs) {
+    const auto& shape = input.getShape();
+    if (shape.empty() || shape[0] != first[0] ||
+        input.getDatatype() == DataType::Bytes ||
+        !input.getParameters().empty()) {
+      return 0;
+    }
+  }
+  return static_cast<size_t>(first[0]);
+}
+
+/// Check if two mergeable requests have the same inputs after the first
+/// dimension
+bool compatible(const InferenceRequest& lhs, const InferenceRequest& rhs) {
+  const auto& lhs_inputs = lhs.getInputs();
+  const auto& rhs_inputs = rhs.getInputs();
+  if (lhs_inputs.size() != rhs_inputs.size()) {
+    return false;
+  }
+  for (auto i = 0U; i < lhs_inputs.size(); ++i) {
+    const auto& lhs_input = lhs_inputs[i];
+    const auto& rhs_input = rhs_inputs[i];
+    const auto& lhs_shape = lhs_input.getShape();
+    const auto& rhs_shape = rhs_input.getShape();
+    if (lhs_input.getName() != rhs_input.getName() ||
+        lhs_input.getDatatype() != rhs_input.getDatatype() ||
+        lhs_shape.size() != rhs_shape.size() ||
+        !std::equal(lhs_shape.begin() + 1, lhs_shape.end(),
+                    rhs_shape.begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// A request waiting to be merged
+struct Pending {
+  InferenceRequest request;
+  size_t samples;
+  std::promise<InferenceResponse> promise;
+};
+
+/// Merged requests that were sent and are waiting for their response
+struct Batch {
+  std::vector<Pending> requests;
+  size_t samples = 0;
+  // the merged inputs, kept until the response arrives
+  std::vector<std::vector<std::byte>> inputs;
+  InferenceResponseFuture future;
+};
+
+/**
+ * @brief Split the merged response into a response for each request. Each
+ * output views its rows of the merged output, which is kept alive as long as
+ * any split response is
+ *
+ * @param batch the merged requests
+ * @param merged the merged response
+ */
+void split(Batch* batch, InferenceResponse merged) {
+  if (merged.isError()) {
+    for (auto& pending : batch->requests) {
+      auto response = merged;
+      response.setID(pending.request.getID());
+      pending.promise.set_value(std::move(response));
+    }
+    return;
+  }
+
+  const auto owner = std::make_shared<InferenceResponse>(std::move(merged));
+  const auto& outputs = owner->getOutputs();
+  for (const auto& output : outputs) {
+    const auto& shape = output.getShape();
+    if (shape.empty() || shape[0] != static_cast<int64_t>(batch->samples)) {
+      throw invalid_argument("Output " + output.getName() +
+                             " can't be split between the merged requests");
+    }
+  }
+
+  size_t offset = 0;
+  for (auto& pending : batch->requests) {
+    InferenceResponse response;
+    response.setID(pending.request.getID());
+    response.setModel(owner->getModel());
+    for (const auto& output : outputs) {
+      const auto row_size = output.getSize() / batch->samples *
+                            output.getDatatype().size();
+      auto shape = output.getShape();
+      shape[0] = static_cast<int64_t>(pending.samples);
+
+      InferenceResponseOutput part;
+      part.setName(output.getName());
+      part.setDatatype(output.getDatatype());
+      part.setShape(std::move(shape));
+      part.setData(
+        static_cast<const std::byte*>(output.getData()) + (offset * row_size),
+        pending.samples * row_size, owner);
+      response.addOutput(std::move(part));
+    }
+    offset += pending.samples;
+    pending.promise.set_value(std::move(response));
+  }
+}
+
+}  // namespace
+
+class BatchingClient::BatchingClientImpl {
+ public:
+  BatchingClientImpl(const Client* client, const ClientBatchingOptions& options)
+    : client_(client), options_(options) {
+    if (options_.max_batch_size == 0) {
+      throw invalid_argument("The max batch size must be at least 1");
+    }
+    dispatcher_ = std::thread{&BatchingClientImpl::dispatch, this};
+    collector_ = std::thread{&BatchingClientImpl::collect, this};
+  }
+
+  BatchingClientImpl(BatchingClientImpl const&) = delete;
+  BatchingClientImpl& operator=(const BatchingClientImpl&) = delete;
+  BatchingClientImpl(BatchingClientImpl&& other) = delete;
+  BatchingClientImpl& operator=(BatchingClientImpl&& other) = delete;
+  ~BatchingClientImpl() {
+    {
+      const std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    // the dispatcher sends what's left before the collector stops
+    dispatcher_.join();
+    {
+      const std::lock_guard lock{sent_mutex_};
+      dispatched_ = true;
+    }
+    sent_ready_.notify_all();
+    collector_.join();
+  }
+
+  const Client* getClient() const { return client_; }
+
+  InferenceResponseFuture infer(const std::string& model,
+                                const InferenceRequest& request,
+                                const std::string& version) {
+    const auto samples = countSamples(request);
+    if (samples == 0 || samples >= options_.max_batch_size) {
+      return client_->modelInferAsync(model, request, version);
+    }
+
+    Pending pending{request, samples, {}};
+    auto future = pending.promise.get_future();
+    {
+      const std::lock_guard lock{mutex_};
+      auto& queue = queues_[{model, version}];
+      if (queue.requests.empty()) {
+        queue.deadline = Clock::now() + options_.timeout;
+      }
+      queue.samples += samples;
+      queue.requests.push_back(std::move(pending));
+    }
+    ready_.notify_one();
+    return future;
+  }
+
+ private:
+  using Key = std::pair<std::string, std::string>;
+
+  /// Requests to one model waiting to be merged
+  struct Queue {
+    std::deque<Pending> requests;
+    size_t samples = 0;
+    Clock::time_point deadline;
+  };
+
+  /// Send merged requests when a queue has enough samples or its first request
+  /// has waited long enough
+  void dispatch() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      const auto now = Clock::now();
+      auto wake = Clock::time_point::max();
+      auto found = queues_.end();
+      for (auto it = queues_.begin(); it != queues_.end(); ++it) {
+        const auto& queue = it->second;
+        if (queue.requests.empty()) {
+          continue;
+        }
+        if (stopping_ || queue.samples >= options_.max_batch_size ||
+            queue.deadline <= now) {
+          found = it;
+          break;
+        }
+        wake = std::min(wake, queue.deadline);
+      }
+
+      if (found != queues_.end()) {
+        auto batch = this->take(&found->second);
+        lock.unlock();
+        this->send(found->first, std::move(batch));
+        lock.lock();
+        continue;
+      }
+      if (stopping_) {
+        return;
+      }
+      if (wake == Clock::time_point::max()) {
+        ready_.wait(lock);
+      } else {
+        ready_.wait_until(lock, wake);
+      }
+    }
+  }
+
+  /// Take the requests at the front of the queue that can be merged
+  Batch take(Queue* queue) {
+    Batch batch;
+    auto& requests = queue->requests;
+    while (!requests.empty()) {
+      auto& next = requests.front();
+      if (!batch.requests.empty() &&
+          (batch.samples + next.samples > options_.max_batch_size ||
+           !compatible(batch.requests.front().request, next.request))) {
+        break;
+      }
+      batch.samples += next.samples;
+      batch.requests.push_back(std::move(next));
+      requests.pop_front();
+    }
+    queue->samples -= batch.samples;
+    if (!requests.empty()) {
+      queue->deadline = Clock::now() + options_.timeout;
+    }
+    return batch;
+  }
+
+  void send(const Key& key, Batch batch) {
+    const auto& [model, version] = key;
+    const auto& first = batch.requests.front().request;
+
+    try {
+      InferenceRequest merged;
+      for (const auto& output : first.getOutputs()) {
+        merged.addOutputTensor(output);
+      }
+      const auto& inputs = first.getInputs();
+      batch.inputs.resize(inputs.size());
+      for (auto i = 0U; i < inputs.size(); ++i) {
+        const auto& input = inputs[i];
+        const auto row_size = input.getSize() / batch.requests.front().samples *
+                              input.getDatatype().size();
+        auto& data = batch.inputs[i];
+        data.resize(row_size * batch.samples);
+        size_t offset = 0;
+        for (const auto& pending : batch.requests) {
+          const auto size = row_size * pending.samples;
+          std::memcpy(data.data() + offset,
+                      pending.request.getInputs()[i].getData(), size);
+          offset += size;
+        }
+
+        auto shape = input.getShape();
+        shape[0] = static_cast<int64_t>(batch.samples);
+        merged.addInputTensor(data.data(), shape, input.getDatatype(),
+                              input.getName());
+      }
+      batch.future = client_->modelInferAsync(model, merged, version);
+    } catch (...) {
+      const auto error = std::current_exception();
+      for (auto& pending : batch.requests) {
+        pending.promise.set_exception(error);
+      }
+      return;
+    }
+
+    {
+      const std::lock_guard lock{sent_mutex_};
+      sent_.push_back(std::move(batch));
+    }
+    sent_ready_.notify_one();
+  }
+
+  /// Wait for the responses to the merged requests in the order they were sent
+  /// and split them
+  void collect() {
+    while (true) {
+      Batch batch;
+      {
+        std::unique_lock lock{sent_mutex_};
+        sent_ready_.wait(lock, [this]() { return !sent_.empty() || dispatched_; });
+        if (sent_.empty()) {
+          return;
+        }
+        batch = std::move(sent_.front());
+        sent_.pop_front();
+      }
+
+      try {
+        split(&batch, batch.future.get());
+      } catch (...) {
+        const auto error = std::current_exception();
+        for (auto& pending : batch.requests) {
+          // requests that were answered before the error keep their response
+          try {
+            pending.promise.set_exception(error);
+          } catch (const std::future_error&) {
+          }
+        }
+      }
+    }
+  }
+
+  const Client* client_;
+  ClientBatchingOptions options_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::map<Key, Queue> queues_;
+  bool stopping_ = false;
+  std::thread dispatcher_;
+
+  std::mutex sent_mutex_;
+  std::condition_variable sent_ready_;
+  std::deque<Batch> sent_;
+  bool dispatched_ = false;
+  std::thread collector_;
+};
+
+BatchingClient::BatchingClient(const Client* client,
+                               const ClientBatchingOptions& options)
+  : impl_(std::make_unique<BatchingClientImpl>(client, options)) {}
+
+BatchingClient::~BatchingClient() = default;
+
+ServerMetadata BatchingClient::serverMetadata() const {
+  return impl_->getClient()->serverMetadata();
+}
+
+bool BatchingClient::serverLive() const {
+  return impl_->getClient()->serverLive();
+}
+
+bool BatchingClient::serverReady() const {
+  return impl_->getClient()->serverReady();
+}
+
+std::vector<std::string> BatchingClient::modelList() const {
+  return impl_->getClient()->modelList();
+}
+
+std::string BatchingClient::workerLoad(const std::string& worker,
+                                       const ParameterMap& parameters) const {
+  return impl_->getClient()->workerLoad(worker, parameters);
+}
+
+void BatchingClient::workerUnload(const std::string& worker) const {
+  impl_->getClient()->workerUnload(worker);
+}
+
+bool BatchingClient::hasHardware(const std::string& name, int num) const {
+  return impl_->getClient()->hasHardware(name, num);
+}
+
+bool BatchingClient::modelReadyImpl(const std::string& model,
+                                    const std::string& version) const {
+  return impl_->getClient()->modelReady(model, version);
+}
+
+ModelMetadata BatchingClient::modelMetadataImpl(
+  const std::string& model, const std::string& version) const {
+  return impl_->getClient()->modelMetadata(model, version);
+}
+
+void BatchingClient::modelLoadImpl(const std::string& model,
+                                   const ParameterMap& parameters,
+                                   const std::string& version) const {
+  impl_->getClient()->modelLoad(model, parameters, version);
+}
+
+void BatchingClient::modelUnloadImpl(const std::string& model,
+                                     const std::string& version) const {
+  impl_->getClient()->modelUnload(model, version);
+}
+
+InferenceResponse BatchingClient::modelInferImpl(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  return impl_->infer(model, request, version).get();
+}
+
+InferenceResponseFuture BatchingClient::modelInferAsyncImpl(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  return impl_->infer(model, request, version);
+}
+
+}  // namespace amdinfer
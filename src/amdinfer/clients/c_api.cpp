@@ -0,0 +1,367 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the C API over the server and the native client
+ */
+
+#include "amdinfer/amdinfer.h"
+
+#include <cstring>    // for memcpy
+#include <exception>  // for exception
+#include <optional>   // for optional
+#include <string>     // for string
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/clients/native.hpp"           // for NativeClient
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/servers/server.hpp"           // for Server
+
+// the handles are defined outside the namespace to match the C declarations
+
+struct amdinfer_server {
+  amdinfer::Server server;
+};
+
+struct amdinfer_client {
+  explicit amdinfer_client(const amdinfer::Server* server) : client(server) {}
+  amdinfer::NativeClient client;
+};
+
+struct amdinfer_parameters {
+  amdinfer::ParameterMap parameters;
+};
+
+struct amdinfer_request {
+  amdinfer::InferenceRequest request;
+};
+
+struct amdinfer_response {
+  /// View a response that the caller keeps alive
+  explicit amdinfer_response(const amdinfer::InferenceResponse* response)
+    : response(response),
+      id(response->getID()),
+      error(response->isError() ? response->getError() : "") {}
+  /// Take a response
+  explicit amdinfer_response(amdinfer::InferenceResponse&& response)
+    : owned(std::move(response)),
+      response(&owned.value()),
+      id(this->response->getID()),
+      error(this->response->isError() ? this->response->getError() : "") {}
+
+  std::optional<amdinfer::InferenceResponse> owned;
+  const amdinfer::InferenceResponse* response;
+  // kept so the C strings stay valid
+  std::string id;
+  std::string error;
+};
+
+namespace {
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+thread_local std::string last_error;
+
+/// Run f, turning any exception into a status and the thread's last error
+template <typename F>
+amdinfer_status guard(F f) noexcept {
+  try {
+    f();
+    return AMDINFER_OK;
+  } catch (const amdinfer::invalid_argument& e) {
+    last_error = e.what();
+    return AMDINFER_INVALID_ARGUMENT;
+  } catch (const amdinfer::resource_exhausted_error& e) {
+    last_error = e.what();
+    return AMDINFER_RESOURCE_EXHAUSTED;
+  } catch (const std::exception& e) {
+    last_error = e.what();
+    return AMDINFER_ERROR;
+  } catch (...) {
+    last_error = "Unknown error";
+    return AMDINFER_ERROR;
+  }
+}
+
+template <typename T>
+T* check(T* pointer, const char* name) {
+  if (pointer == nullptr) {
+    throw amdinfer::invalid_argument(std::string{name} + " is null");
+  }
+  return pointer;
+}
+
+/// Get an optional string argument, such as a version, as a string
+std::string optional(const char* value) {
+  return value != nullptr ? value : "";
+}
+
+amdinfer::ParameterMap getParameters(const amdinfer_parameters* parameters) {
+  return parameters != nullptr ? parameters->parameters
+                               : amdinfer::ParameterMap{};
+}
+
+}  // namespace
+
+extern "C" {
+
+int amdinfer_api_version(void) { return AMDINFER_C_API_VERSION; }
+
+const char* amdinfer_last_error(void) { return last_error.c_str(); }
+
+amdinfer_status amdinfer_server_create(amdinfer_server** server) {
+  return guard([&]() { *check(server, "server") = new amdinfer_server; });
+}
+
+void amdinfer_server_destroy(amdinfer_server* server) { delete server; }
+
+amdinfer_status amdinfer_server_set_model_repository(amdinfer_server* server,
+                                                     const char* path,
+                                                     bool load_existing) {
+  return guard([&]() {
+    check(server, "server")
+      ->server.setModelRepository(check(path, "path"), load_existing);
+  });
+}
+
+amdinfer_status amdinfer_client_create(const amdinfer_server* server,
+                                       amdinfer_client** client) {
+  return guard([&]() {
+    const auto* owner = &check(server, "server")->server;
+    *check(client, "client") = new amdinfer_client(owner);
+  });
+}
+
+void amdinfer_client_destroy(amdinfer_client* client) { delete client; }
+
+amdinfer_status amdinfer_parameters_create(amdinfer_parameters** parameters) {
+  return guard(
+    [&]() { *check(parameters, "parameters") = new amdinfer_parameters; });
+}
+
+void amdinfer_parameters_destroy(amdinfer_parameters* parameters) {
+  delete parameters;
+}
+
+amdinfer_status amdinfer_parameters_put_bool(amdinfer_parameters* parameters,
+                                             const char* key, bool value) {
+  return guard([&]() {
+    check(parameters, "parameters")->parameters.put(check(key, "key"), value);
+  });
+}
+
+amdinfer_status amdinfer_parameters_put_int32(amdinfer_parameters* parameters,
+                                              const char* key, int32_t value) {
+  return guard([&]() {
+    check(parameters, "parameters")->parameters.put(check(key, "key"), value);
+  });
+}
+
+amdinfer_status amdinfer_parameters_put_double(
+  amdinfer_parameters* parameters, const char* key, double value) {
+  return guard([&]() {
+    check(parameters, "parameters")->parameters.put(check(key, "key"), value);
+  });
+}
+
+amdinfer_status amdinfer_parameters_put_string(
+  amdinfer_parameters* parameters, const char* key, const char* value) {
+  return guard([&]() {
+    check(parameters, "parameters")
+      ->parameters.put(check(key, "key"), std::string{check(value, "value")});
+  });
+}
+
+amdinfer_status amdinfer_model_load(const amdinfer_client* client,
+                                    const char* model, const char* version,
+                                    const amdinfer_parameters* parameters) {
+  return guard([&]() {
+    check(client, "client")
+      ->client.modelLoad(check(model, "model"), getParameters(parameters),
+                         optional(version));
+  });
+}
+
+amdinfer_status amdinfer_model_unload(const amdinfer_client* client,
+                                      const char* model, const char* version) {
+  return guard([&]() {
+    check(client, "client")
+      ->client.modelUnload(check(model, "model"), optional(version));
+  });
+}
+
+amdinfer_status amdinfer_model_ready(const amdinfer_client* client,
+                                     const char* model, const char* version,
+                                     bool* ready) {
+  return guard([&]() {
+    *check(ready, "ready") = check(client, "client")
+                               ->client.modelReady(check(model, "model"),
+                                                   optional(version));
+  });
+}
+
+amdinfer_status amdinfer_worker_load(const amdinfer_client* client,
+                                     const char* worker,
+                                     const amdinfer_parameters* parameters,
+                                     char* endpoint, size_t endpoint_size) {
+  return guard([&]() {
+    check(endpoint, "endpoint");
+    const auto name = check(client, "client")
+                        ->client.workerLoad(check(worker, "worker"),
+                                            getParameters(parameters));
+    if (name.size() >= endpoint_size) {
+      throw amdinfer::invalid_argument("The endpoint " + name +
+                                       " doesn't fit in the buffer");
+    }
+    std::memcpy(endpoint, name.c_str(), name.size() + 1);
+  });
+}
+
+amdinfer_status amdinfer_worker_unload(const amdinfer_client* client,
+                                       const char* worker) {
+  return guard([&]() {
+    check(client, "client")->client.workerUnload(check(worker, "worker"));
+  });
+}
+
+amdinfer_status amdinfer_request_create(amdinfer_request** request) {
+  return guard([&]() { *check(request, "request") = new amdinfer_request; });
+}
+
+void amdinfer_request_destroy(amdinfer_request* request) { delete request; }
+
+amdinfer_status amdinfer_request_set_id(amdinfer_request* request,
+                                        const char* id) {
+  return guard(
+    [&]() { check(request, "request")->request.setID(check(id, "id")); });
+}
+
+amdinfer_status amdinfer_request_set_parameters(
+  amdinfer_request* request, const amdinfer_parameters* parameters) {
+  return guard([&]() {
+    check(request, "request")
+      ->request.setParameters(getParameters(parameters));
+  });
+}
+
+amdinfer_status amdinfer_request_add_input(amdinfer_request* request,
+                                           const char* name,
+                                           const int64_t* shape, size_t dims,
+                                           const char* datatype, void* data) {
+  return guard([&]() {
+    check(request, "request");
+    if (dims > 0) {
+      check(shape, "shape");
+    }
+    const amdinfer::DataType type{check(datatype, "datatype")};
+    if (type == amdinfer::DataType::Unknown) {
+      throw amdinfer::invalid_argument(std::string{"Unknown datatype "} +
+                                       datatype);
+    }
+    std::vector<int64_t> input_shape{shape, shape + dims};
+    request->request.addInputTensor(check(data, "data"), input_shape, type,
+                                    check(name, "name"));
+  });
+}
+
+amdinfer_status amdinfer_request_add_output(amdinfer_request* request,
+                                            const char* name) {
+  return guard([&]() {
+    amdinfer::InferenceRequestOutput output;
+    output.setName(check(name, "name"));
+    check(request, "request")->request.addOutputTensor(std::move(output));
+  });
+}
+
+amdinfer_status amdinfer_infer_async(const amdinfer_client* client,
+                                     const char* model, const char* version,
+                                     const amdinfer_request* request,
+                                     amdinfer_callback callback,
+                                     void* user_data) {
+  return guard([&]() {
+    check(callback, "callback");
+    check(client, "client")
+      ->client.modelInferAsyncBorrowed(
+        check(model, "model"), check(request, "request")->request,
+        [callback, user_data](const amdinfer::InferenceResponse& response) {
+          const amdinfer_response view{&response};
+          callback(&view, user_data);
+        },
+        optional(version));
+  });
+}
+
+amdinfer_status amdinfer_infer(const amdinfer_client* client,
+                               const char* model, const char* version,
+                               const amdinfer_request* request,
+                               amdinfer_response** response) {
+  return guard([&]() {
+    check(response, "response");
+    auto result = check(client, "client")
+                    ->client.modelInferBorrowed(
+                      check(model, "model"),
+                      check(request, "request")->request, optional(version));
+    *response = new amdinfer_response(std::move(result));
+  });
+}
+
+void amdinfer_response_destroy(amdinfer_response* response) {
+  delete response;
+}
+
+const char* amdinfer_response_id(const amdinfer_response* response) {
+  return response != nullptr ? response->id.c_str() : nullptr;
+}
+
+const char* amdinfer_response_error(const amdinfer_response* response) {
+  if (response == nullptr) {
+    return nullptr;
+  }
+  return response->response->isError() ? response->error.c_str() : nullptr;
+}
+
+size_t amdinfer_response_output_count(const amdinfer_response* response) {
+  if (response == nullptr) {
+    return 0;
+  }
+  return response->response->getOutputs().size();
+}
+
+amdinfer_status amdinfer_response_output(const amdinfer_response* response,
+                                         size_t index,
+                                         amdinfer_tensor* tensor) {
+  return guard([&]() {
+    const auto& outputs = check(response, "response")->response->getOutputs();
+    if (index >= outputs.size()) {
+      throw amdinfer::invalid_argument("Output " + std::to_string(index) +
+                                       " doesn't exist");
+    }
+    const auto& output = outputs[index];
+    const auto& shape = output.getShape();
+    auto* view = check(tensor, "tensor");
+    view->name = output.getName().c_str();
+    view->datatype = output.getDatatype().str();
+    view->shape = shape.data();
+    view->dims = shape.size();
+    view->data = output.getData();
+    view->size = output.getSize() * output.getDatatype().size();
+  });
+}
+
+}  // extern "C"
@@ -15,12 +15,14 @@
 
 #include "amdinfer/clients/client.hpp"
 
-#include <algorithm>      // for copy, copy_backward
-#include <chrono>         // for seconds
+#include <algorithm>      // for max, min
+#include <chrono>         // for seconds, steady_clock
+#include <deque>          // for deque
 #include <future>         // for future
 #include <queue>          // for queue
 #include <thread>         // for sleep_for
 #include <unordered_set>  // for operator!=, unordered_set
+#include <utility>        // for move
 
 #include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOGGING
 #include "amdinfer/core/exceptions.hpp"          // for connection_error
@@ -171,41 +173,132 @@ std::vector<InferenceResponse> inferAsyncOrdered(
   return responses;
 }
 
-std::vector<InferenceResponse> inferAsyncOrderedBatched(
-  const Client* client, const std::string& model,
-  const std::vector<InferenceRequest>& requests, size_t batch_size,
-  const std::string& version) {
-  auto num_requests = requests.size();
-  std::vector<InferenceResponse> responses;
-  responses.reserve(num_requests);
-  auto start_index = 0U;
-  std::queue<InferenceResponseFuture> q;
+namespace {
+
+/// Sizes the window of inferAsyncOrderedWindowed by additive increase and
+/// multiplicative decrease, like TCP congestion control
+class WindowController {
+ public:
+  explicit WindowController(const InferWindow& window)
+    : max_(static_cast<double>(std::max<size_t>(window.max_in_flight, 1))),
+      size_(window.adaptive ? 1.0 : max_),
+      adaptive_(window.adaptive),
+      target_(window.target_latency) {}
 
-  while (start_index + batch_size < num_requests) {
-    for (auto i = start_index; i < batch_size; ++i) {
-      q.push(client->modelInferAsync(model, requests[i], version));
+  [[nodiscard]] size_t size() const { return static_cast<size_t>(size_); }
+
+  /**
+   * @brief Update the window with a response
+   *
+   * @param index index of the request
+   * @param sent number of requests sent so far
+   * @param latency how long the response took
+   * @param error whether the response is an error
+   */
+  void update(size_t index, size_t sent, std::chrono::microseconds latency,
+              bool error) {
+    if (!adaptive_) {
+      return;
+    }
+    if (error || latency > target(latency)) {
+      // requests sent before the last decrease were sized for the old window
+      // so only the first slow response of each window shrinks it
+      if (index >= recovered_) {
+        size_ = std::max(1.0, size_ / 2);
+        recovered_ = sent;
+      }
+    } else {
+      size_ = std::min(max_, size_ + (1.0 / size_));
     }
+  }
 
-    for (auto i = 0U; i < batch_size; ++i) {
-      auto& future = q.front();
-      responses.push_back(future.get());
-      q.pop();
+ private:
+  std::chrono::microseconds target(std::chrono::microseconds latency) {
+    if (target_.count() > 0) {
+      return target_;
+    }
+    if (lowest_.count() == 0 || latency < lowest_) {
+      lowest_ = latency;
     }
-    start_index += batch_size;
+    return 2 * lowest_;
   }
 
-  if (start_index != num_requests) {
-    for (auto i = start_index; i < num_requests; ++i) {
-      q.push(client->modelInferAsync(model, requests[i]));
+  double max_;
+  double size_;
+  bool adaptive_;
+  std::chrono::microseconds target_;
+  std::chrono::microseconds lowest_{0};
+  size_t recovered_ = 0;
+};
+
+}  // namespace
+
+std::vector<InferenceResponse> inferAsyncOrderedWindowed(
+  const Client* client, const std::string& model,
+  const std::vector<InferenceRequest>& requests, const InferWindow& window,
+  const std::string& version) {
+  using Clock = std::chrono::steady_clock;
+
+  struct Pending {
+    size_t index;
+    InferenceResponseFuture future;
+    Clock::time_point start;
+    bool done = false;
+  };
+
+  const auto num_requests = requests.size();
+  std::vector<InferenceResponse> responses(num_requests);
+  std::deque<Pending> pending;
+  WindowController controller{window};
+  size_t sent = 0;
+  size_t in_flight = 0;
+
+  const auto finish = [&](Pending& request) {
+    auto& response = responses[request.index];
+    response = request.future.get();
+    request.done = true;
+    in_flight--;
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - request.start);
+    controller.update(request.index, sent, latency, response.isError());
+  };
+
+  while (sent < num_requests || !pending.empty()) {
+    while (sent < num_requests && in_flight < controller.size()) {
+      const auto start = Clock::now();
+      auto future = client->modelInferAsync(model, requests[sent], version);
+      pending.push_back({sent, std::move(future), start});
+      sent++;
+      in_flight++;
     }
 
-    for (auto i = 0U; i < num_requests - start_index; ++i) {
-      auto& future = q.front();
-      responses.push_back(future.get());
-      q.pop();
+    // the oldest response is needed first to keep the order but any others
+    // that have already arrived free up room in the window too
+    auto& oldest = pending.front();
+    if (!oldest.done) {
+      finish(oldest);
+    }
+    for (auto& request : pending) {
+      const auto no_wait = std::chrono::seconds(0);
+      if (!request.done &&
+          request.future.wait_for(no_wait) == std::future_status::ready) {
+        finish(request);
+      }
+    }
+    while (!pending.empty() && pending.front().done) {
+      pending.pop_front();
     }
   }
   return responses;
 }
 
+std::vector<InferenceResponse> inferAsyncOrderedBatched(
+  const Client* client, const std::string& model,
+  const std::vector<InferenceRequest>& requests, size_t batch_size,
+  const std::string& version) {
+  InferWindow window;
+  window.max_in_flight = batch_size;
+  return inferAsyncOrderedWindowed(client, model, requests, window, version);
+}
+
 }  // namespace amdinfer
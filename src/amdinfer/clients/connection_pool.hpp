@@ -0,0 +1,271 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a pool of client connections that are shared by threads
+ */
+
+#ifndef GUARD_AMDINFER_CLIENTS_CONNECTION_POOL
+#define GUARD_AMDINFER_CLIENTS_CONNECTION_POOL
+
+#include <algorithm>   // for clamp, max
+#include <atomic>      // for atomic, memory_order_relaxed
+#include <chrono>      // for steady_clock, nanoseconds, duration_cast
+#include <cstddef>     // for size_t
+#include <cstdint>     // for int64_t, uint64_t
+#include <functional>  // for function
+#include <limits>      // for numeric_limits
+#include <memory>      // for shared_ptr, atomic_load, atomic_store
+#include <utility>     // for move
+#include <vector>      // for vector
+
+#include "amdinfer/clients/http.hpp"  // for ConnectionStats
+
+namespace amdinfer {
+
+/**
+ * @brief Hands out connections to the threads making requests. Each request
+ * goes to the usable connection with the fewest requests in flight, where a
+ * connection is unusable if its last request failed or if it has requests in
+ * flight but none have finished for a while. Picking a connection only uses
+ * atomics so threads never wait on each other to send.
+ *
+ * All the connections up to the maximum size are made at construction but
+ * only the active ones are used. The pool grows when every active connection
+ * is busy and maintain(), which should be called periodically from one
+ * thread, shrinks it again when the last connection is idle and replaces
+ * unusable connections with new ones.
+ *
+ * @tparam Connection type of the connection
+ */
+template <typename Connection>
+class ConnectionPool {
+  using Clock = std::chrono::steady_clock;
+
+ public:
+  /// Makes the connection for the given slot in the pool
+  using Factory = std::function<std::shared_ptr<Connection>(size_t)>;
+
+  struct Options {
+    /// Connections that are always active
+    size_t min_size = 1;
+    /// Most connections that may be active
+    size_t max_size = 1;
+    /// Grow if the least busy connection has this many requests in flight
+    int grow_threshold = 1;
+    /// A connection with no finished requests in this time is stalled
+    std::chrono::nanoseconds stall_timeout = std::chrono::seconds(10);
+    /// Shrink if the last connection has been idle for this long
+    std::chrono::nanoseconds idle_timeout = std::chrono::seconds(30);
+  };
+
+  /// A connection handed out for one request
+  struct Ticket {
+    std::shared_ptr<Connection> connection;
+    size_t index;
+    uint64_t generation;
+    int64_t start;
+  };
+
+  ConnectionPool(Factory factory, const Options& options)
+    : factory_(std::move(factory)),
+      options_(options),
+      slots_(std::max<size_t>(options.max_size, 1)),
+      size_(std::clamp<size_t>(options.min_size, 1, slots_.size())) {
+    options_.min_size = size_.load();
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      slots_[i].connection = factory_(i);
+    }
+  }
+
+  /**
+   * @brief Get the connection to use for a request. The caller must pass the
+   * ticket back to release() when the request finishes
+   *
+   * @return Ticket
+   */
+  Ticket acquire() {
+    const auto now = this->now();
+    const auto size = size_.load();
+    // start from a rotating position so ties are spread over the connections
+    const auto offset = cursor_.fetch_add(1, std::memory_order_relaxed);
+
+    auto best = slots_.size();
+    auto best_load = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < size && best_load > 0; ++i) {
+      const auto index = (offset + i) % size;
+      const auto& slot = slots_[index];
+      const auto load = slot.in_flight.load(std::memory_order_relaxed);
+      if (load < best_load && usable(slot, now)) {
+        best = index;
+        best_load = load;
+      }
+    }
+
+    if (best_load >= options_.grow_threshold) {
+      auto expected = size;
+      if (size < slots_.size() && size_.compare_exchange_strong(expected,
+                                                                size + 1)) {
+        best = size;
+      } else if (best == slots_.size()) {
+        // nothing is usable so use any connection rather than failing here
+        best = offset % size;
+      }
+    }
+
+    auto& slot = slots_[best];
+    if (slot.in_flight.fetch_add(1) == 0) {
+      slot.last_progress.store(now);
+    }
+    return {std::atomic_load(&slot.connection), best, slot.generation.load(),
+            now};
+  }
+
+  /**
+   * @brief Record that a request has finished
+   *
+   * @param ticket the ticket returned by acquire()
+   * @param ok false if the request failed because of the connection
+   */
+  void release(const Ticket& ticket, bool ok) {
+    auto& slot = slots_[ticket.index];
+    // the connection was replaced while the request was in flight so this
+    // result says nothing about the new one
+    if (slot.generation.load() != ticket.generation) {
+      return;
+    }
+
+    const auto now = this->now();
+    // the count is reset on reconnecting so don't let a racing release take
+    // it below zero
+    auto in_flight = slot.in_flight.load();
+    while (in_flight > 0 &&
+           !slot.in_flight.compare_exchange_weak(in_flight, in_flight - 1)) {
+    }
+    slot.last_progress.store(now);
+    slot.requests.fetch_add(1, std::memory_order_relaxed);
+    if (!ok) {
+      slot.failures.fetch_add(1, std::memory_order_relaxed);
+      slot.healthy.store(false);
+      return;
+    }
+
+    // exponentially weighted average that gives the newest latency 1/8 weight
+    const auto latency = now - ticket.start;
+    const auto weight = 8;
+    auto average = slot.latency.load(std::memory_order_relaxed);
+    const auto update = [&]() {
+      return average == 0 ? latency : average + (latency - average) / weight;
+    };
+    while (!slot.latency.compare_exchange_weak(average, update(),
+                                               std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief Replace unusable connections with new ones and shrink the pool if
+   * it's mostly idle. This should be called periodically from one thread.
+   */
+  void maintain() {
+    const auto now = this->now();
+    auto size = size_.load();
+    for (size_t i = 0; i < size; ++i) {
+      if (!usable(slots_[i], now)) {
+        reconnect(i);
+      }
+    }
+
+    const auto& last = slots_[size - 1];
+    if (size > options_.min_size &&
+        last.in_flight.load(std::memory_order_relaxed) == 0 &&
+        now - last.last_progress.load() > options_.idle_timeout.count() &&
+        size_.compare_exchange_strong(size, size - 1)) {
+      // drop the connection so it's closed while it's inactive
+      reconnect(size - 1);
+    }
+  }
+
+  /// Get the number of active connections
+  [[nodiscard]] size_t size() const { return size_.load(); }
+
+  /// Get the statistics of the active connections
+  [[nodiscard]] std::vector<ConnectionStats> stats() const {
+    const auto now = this->now();
+    const auto size = size_.load();
+    std::vector<ConnectionStats> stats;
+    stats.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      const auto& slot = slots_[i];
+      auto& stat = stats.emplace_back();
+      stat.in_flight = slot.in_flight.load(std::memory_order_relaxed);
+      stat.latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(slot.latency.load(std::memory_order_relaxed)));
+      stat.requests = slot.requests.load(std::memory_order_relaxed);
+      stat.failures = slot.failures.load(std::memory_order_relaxed);
+      stat.healthy = usable(slot, now);
+    }
+    return stats;
+  }
+
+ private:
+  struct Slot {
+    // only accessed with std::atomic_load and std::atomic_store
+    std::shared_ptr<Connection> connection;
+    std::atomic<uint64_t> generation{0};
+    std::atomic<int> in_flight{0};
+    std::atomic<bool> healthy{true};
+    // times are in nanoseconds since the steady clock's epoch
+    std::atomic<int64_t> last_progress{0};
+    std::atomic<int64_t> latency{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+  };
+
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+  }
+
+  bool usable(const Slot& slot, int64_t now) const {
+    if (!slot.healthy.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    return slot.in_flight.load(std::memory_order_relaxed) == 0 ||
+           now - slot.last_progress.load(std::memory_order_relaxed) <=
+             options_.stall_timeout.count();
+  }
+
+  void reconnect(size_t index) {
+    auto& slot = slots_[index];
+    // requests in flight on the old connection still hold it so they finish
+    // but they no longer count against the new one
+    slot.generation.fetch_add(1);
+    std::atomic_store(&slot.connection, factory_(index));
+    slot.in_flight.store(0);
+    slot.last_progress.store(now());
+    slot.healthy.store(true);
+  }
+
+  Factory factory_;
+  Options options_;
+  std::vector<Slot> slots_;
+  std::atomic<size_t> size_;
+  std::atomic<size_t> cursor_{0};
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CLIENTS_CONNECTION_POOL
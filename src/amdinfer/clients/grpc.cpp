@@ -20,13 +20,21 @@
 
 #include "amdinfer/clients/grpc.hpp"
 
+#include <google/protobuf/arena.h>               // for Arena
 #include <google/protobuf/repeated_ptr_field.h>  // for RepeatedPtrField
 #include <grpcpp/grpcpp.h>                       // for Status, ClientContext
 
-#include <future>         // for __forced_unwind, async
+#include <algorithm>      // for max
+#include <atomic>         // for atomic, memory_order_relaxed
+#include <exception>      // for make_exception_ptr, current_exception
+#include <future>         // for promise, future
 #include <memory>         // for unique_ptr, shared_ptr
+#include <mutex>          // for mutex, lock_guard
 #include <string>         // for string
+#include <thread>         // for thread
+#include <unordered_map>  // for unordered_map
 #include <unordered_set>  // for unordered_set
+#include <utility>        // for move
 #include <vector>         // for vector
 
 #include "amdinfer/clients/grpc_internal.hpp"    // for mapParametersToProto
@@ -45,24 +53,271 @@ using grpc::Status;
 
 namespace amdinfer {
 
+namespace {
+
+/**
+ * @brief Get the channels to the address, reusing ones that another GrpcClient
+ * has open with the same number of channels. Each channel uses its own
+ * subchannel pool so it opens a separate connection to the server.
+ */
+std::vector<std::shared_ptr<::grpc::Channel>> getChannels(
+  const std::string& address, int count, bool share) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string,
+                            std::vector<std::weak_ptr<::grpc::Channel>>>
+    cache;
+
+  const auto key = address + "#" + std::to_string(count);
+  std::vector<std::shared_ptr<::grpc::Channel>> channels;
+  channels.reserve(count);
+
+  const std::lock_guard lock{mutex};
+  if (share) {
+    if (auto found = cache.find(key); found != cache.end()) {
+      for (const auto& weak : found->second) {
+        if (auto channel = weak.lock()) {
+          channels.push_back(std::move(channel));
+        }
+      }
+      if (channels.size() == static_cast<size_t>(count)) {
+        return channels;
+      }
+      channels.clear();
+    }
+  }
+
+  for (auto i = 0; i < count; ++i) {
+    ::grpc::ChannelArguments arguments;
+    if (count > 1) {
+      arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    }
+    channels.push_back(::grpc::CreateCustomChannel(
+      address, ::grpc::InsecureChannelCredentials(), arguments));
+  }
+  if (share) {
+    cache[key] = {channels.begin(), channels.end()};
+  }
+  return channels;
+}
+
+/**
+ * @brief Compress the request if it's large enough and ask for the response to
+ * be compressed in the same way
+ *
+ * @param context the context of the call
+ * @param request the request
+ * @param compression how to compress
+ */
+void setCompression(ClientContext* context, const InferenceRequest& request,
+                    const CompressionOptions& compression) {
+  grpc_compression_algorithm algorithm = GRPC_COMPRESS_NONE;
+  switch (compression.algorithm) {
+    case CompressionAlgorithm::Identity:
+      return;
+    case CompressionAlgorithm::Deflate:
+      algorithm = GRPC_COMPRESS_DEFLATE;
+      break;
+    case CompressionAlgorithm::Gzip:
+    case CompressionAlgorithm::Zstd:
+      // gRPC has no zstd so use the closest algorithm it does have
+      algorithm = GRPC_COMPRESS_GZIP;
+      break;
+  }
+  context->AddMetadata(kAcceptCompression,
+                       algorithm == GRPC_COMPRESS_GZIP ? "gzip" : "deflate");
+
+  size_t size = 0;
+  for (const auto& input : request.getInputs()) {
+    size += input.getSize() * input.getDatatype().size();
+  }
+  if (size >= compression.threshold) {
+    context->set_compression_algorithm(algorithm);
+  }
+}
+
+}  // namespace
+
 class GrpcClient::GrpcClientImpl {
  public:
-  explicit GrpcClientImpl(const std::shared_ptr<::grpc::Channel>& channel) {
-    this->stub_ = inference::GRPCInferenceService::NewStub(channel);
+  GrpcClientImpl(
+    const std::vector<std::shared_ptr<::grpc::Channel>>& channels,
+    int threads, const CompressionOptions& compression)
+    : compression_(compression) {
+    stubs_.reserve(channels.size());
+    for (const auto& channel : channels) {
+      stubs_.push_back(inference::GRPCInferenceService::NewStub(channel));
+    }
+
+    const auto queues = std::max(threads, 1);
+    queues_.reserve(queues);
+    threads_.reserve(queues);
+    for (auto i = 0; i < queues; ++i) {
+      auto& queue =
+        queues_.emplace_back(std::make_unique<::grpc::CompletionQueue>());
+      threads_.emplace_back(&GrpcClientImpl::poll, this, queue.get());
+    }
+  }
+
+  GrpcClientImpl(GrpcClientImpl const&) = delete;
+  GrpcClientImpl& operator=(const GrpcClientImpl&) = delete;
+  GrpcClientImpl(GrpcClientImpl&& other) = delete;
+  GrpcClientImpl& operator=(GrpcClientImpl&& other) = delete;
+  ~GrpcClientImpl() {
+    {
+      // requests in flight finish as cancelled so the queues drain quickly
+      const std::lock_guard lock{calls_mutex_};
+      for (auto* call : calls_) {
+        call->context.TryCancel();
+      }
+    }
+    for (auto& queue : queues_) {
+      queue->Shutdown();
+    }
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  /// Get the stub for unary calls, which all use the first channel
+  inference::GRPCInferenceService::Stub* getStub() { return stubs_[0].get(); }
+
+  const CompressionOptions& getCompression() const { return compression_; }
+
+  /// Get the stubs in turn to spread inference requests over the channels
+  inference::GRPCInferenceService::Stub* nextStub() {
+    const auto index = next_stub_.fetch_add(1, std::memory_order_relaxed);
+    return stubs_[index % stubs_.size()].get();
   }
 
-  inference::GRPCInferenceService::Stub* getStub() { return this->stub_.get(); }
+  /// Start an inference request whose response resolves the future
+  InferenceResponseFuture infer(const std::string& model,
+                                const InferenceRequest& request,
+                                const std::string& version) {
+    auto call = std::make_unique<Call>();
+    auto future = call->promise.get_future();
+    this->start(model, request, version, std::move(call));
+    return future;
+  }
+
+  /// Start an inference request and run the callback with its response
+  void infer(const std::string& model, const InferenceRequest& request,
+             const std::string& version, Callback callback) {
+    auto call = std::make_unique<Call>();
+    call->callback = std::move(callback);
+    this->start(model, request, version, std::move(call));
+  }
 
  private:
-  std::unique_ptr<inference::GRPCInferenceService::Stub> stub_;
+  /// An inference request in flight. Its callback is run with the response if
+  /// it has one, otherwise its promise is resolved
+  struct Call {
+    // the messages and everything they allocate are freed with the call
+    google::protobuf::Arena arena;
+    inference::ModelInferResponse* reply = nullptr;
+    ClientContext context;
+    Status status;
+    std::unique_ptr<
+      ::grpc::ClientAsyncResponseReader<inference::ModelInferResponse>>
+      reader;
+    std::promise<InferenceResponse> promise;
+    Callback callback;
+    Observer observer;
+
+    void complete() {
+      try {
+        if (!status.ok()) {
+          throw bad_status(status.error_message());
+        }
+        InferenceResponse response;
+        mapProtoToResponse(*reply, response, observer);
+        if (callback) {
+          callback(response);
+        } else {
+          promise.set_value(std::move(response));
+        }
+      } catch (const std::exception& e) {
+        if (callback) {
+          callback(InferenceResponse{e.what()});
+        } else {
+          promise.set_exception(std::current_exception());
+        }
+      }
+    }
+  };
+
+  void start(const std::string& model, const InferenceRequest& request,
+             const std::string& version, std::unique_ptr<Call> call) {
+    AMDINFER_IF_LOGGING(call->observer.logger = Logger{Loggers::Client});
+
+    auto* grpc_request =
+      google::protobuf::Arena::CreateMessage<inference::ModelInferRequest>(
+        &call->arena);
+    call->reply =
+      google::protobuf::Arena::CreateMessage<inference::ModelInferResponse>(
+        &call->arena);
+    grpc_request->set_model_name(model);
+    grpc_request->set_model_version(version);
+    mapRequestToProto(request, *grpc_request, call->observer);
+    setCompression(&call->context, request, compression_);
+
+    const auto index = next_queue_.fetch_add(1, std::memory_order_relaxed);
+    auto* queue = queues_[index % queues_.size()].get();
+    call->reader =
+      nextStub()->PrepareAsyncModelInfer(&call->context, *grpc_request, queue);
+
+    // the polling thread owns the call from now on and may finish it as soon
+    // as it's started
+    auto* raw = call.release();
+    {
+      const std::lock_guard lock{calls_mutex_};
+      calls_.insert(raw);
+    }
+    raw->reader->StartCall();
+    raw->reader->Finish(raw->reply, &raw->status, raw);
+  }
+
+  void poll(::grpc::CompletionQueue* queue) {
+    void* tag = nullptr;
+    bool ok = false;
+    while (queue->Next(&tag, &ok)) {
+      std::unique_ptr<Call> call{static_cast<Call*>(tag)};
+      {
+        const std::lock_guard lock{calls_mutex_};
+        calls_.erase(call.get());
+      }
+      call->complete();
+    }
+  }
+
+  CompressionOptions compression_;
+  std::vector<std::unique_ptr<inference::GRPCInferenceService::Stub>> stubs_;
+  std::atomic<size_t> next_stub_ = 0;
+
+  std::vector<std::unique_ptr<::grpc::CompletionQueue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_queue_ = 0;
+
+  std::mutex calls_mutex_;
+  std::unordered_set<Call*> calls_;
 };
 
 GrpcClient::GrpcClient(const std::string& address)
-  : GrpcClient(
-      ::grpc::CreateChannel(address, ::grpc::InsecureChannelCredentials())) {}
+  : GrpcClient(address, GrpcClientOptions{}) {}
+
+GrpcClient::GrpcClient(const std::string& address,
+                       const GrpcClientOptions& options) {
+  if (options.channels < 1) {
+    throw invalid_argument("A GrpcClient needs at least one channel");
+  }
+  this->impl_ = std::make_unique<GrpcClient::GrpcClientImpl>(
+    getChannels(address, options.channels, options.share_channels),
+    options.threads, options.compression);
+}
 
 GrpcClient::GrpcClient(const std::shared_ptr<::grpc::Channel>& channel) {
-  this->impl_ = std::make_unique<GrpcClient::GrpcClientImpl>(channel);
+  const GrpcClientOptions options;
+  this->impl_ = std::make_unique<GrpcClient::GrpcClientImpl>(
+    std::vector{channel}, options.threads, options.compression);
 }
 
 GrpcClient::~GrpcClient() = default;
@@ -277,44 +532,402 @@ void GrpcClient::workerUnload(const std::string& worker) const {
   }
 }
 
+void GrpcClient::modelUpdate(const std::string& model,
+                             const ParameterMap& parameters,
+                             const std::string& version) const {
+  inference::ModelUpdateRequest request;
+  inference::ModelUpdateResponse reply;
+
+  ClientContext context;
+
+  request.set_name(model);
+  mapParametersToProto(parameters.data(), request.mutable_parameters());
+  request.set_version(version);
+
+  auto* stub = this->impl_->getStub();
+  Status status = stub->ModelUpdate(&context, request, &reply);
+
+  if (!status.ok()) {
+    throw bad_status(status.error_message());
+  }
+}
+
+void GrpcClient::registerSystemSharedMemory(const std::string& name,
+                                            const std::string& key,
+                                            size_t byte_size,
+                                            size_t offset) const {
+  inference::SystemSharedMemoryRegisterRequest request;
+  inference::SystemSharedMemoryRegisterResponse reply;
+
+  ClientContext context;
+
+  request.set_name(name);
+  request.set_key(key);
+  request.set_offset(offset);
+  request.set_byte_size(byte_size);
+
+  auto* stub = this->impl_->getStub();
+  Status status = stub->SystemSharedMemoryRegister(&context, request, &reply);
+
+  if (!status.ok()) {
+    throw bad_status(status.error_message());
+  }
+}
+
+void GrpcClient::unregisterSystemSharedMemory(const std::string& name) const {
+  inference::SystemSharedMemoryUnregisterRequest request;
+  inference::SystemSharedMemoryUnregisterResponse reply;
+
+  ClientContext context;
+
+  request.set_name(name);
+
+  auto* stub = this->impl_->getStub();
+  Status status = stub->SystemSharedMemoryUnregister(&context, request, &reply);
+
+  if (!status.ok()) {
+    throw bad_status(status.error_message());
+  }
+}
+
+std::string GrpcClient::rdmaConnect(const std::string& session,
+                                    const std::string& endpoint) const {
+  inference::RdmaConnectRequest request;
+  inference::RdmaConnectResponse reply;
+
+  ClientContext context;
+
+  request.set_session(session);
+  request.set_endpoint(endpoint);
+
+  auto* stub = this->impl_->getStub();
+  Status status = stub->RdmaConnect(&context, request, &reply);
+
+  if (!status.ok()) {
+    throw bad_status(status.error_message());
+  }
+  return reply.endpoint();
+}
+
+void GrpcClient::registerRdma(const std::string& name,
+                              const std::string& session, uint64_t address,
+                              uint32_t key, size_t byte_size) const {
+  inference::RdmaRegisterRequest request;
+  inference::RdmaRegisterResponse reply;
+
+  ClientContext context;
+
+  request.set_name(name);
+  request.set_session(session);
+  request.set_address(address);
+  request.set_key(key);
+  request.set_byte_size(byte_size);
+
+  auto* stub = this->impl_->getStub();
+  Status status = stub->RdmaRegister(&context, request, &reply);
+
+  if (!status.ok()) {
+    throw bad_status(status.error_message());
+  }
+}
+
+std::vector<SharedMemoryStatus> GrpcClient::systemSharedMemoryStatus(
+  const std::string& name) const {
+  inference::SystemSharedMemoryStatusRequest request;
+  inference::SystemSharedMemoryStatusResponse reply;
+
+  ClientContext context;
+
+  request.set_name(name);
+
+  auto* stub = this->impl_->getStub();
+  Status status = stub->SystemSharedMemoryStatus(&context, request, &reply);
+
+  if (!status.ok()) {
+    throw bad_status(status.error_message());
+  }
+
+  std::vector<SharedMemoryStatus> statuses;
+  statuses.reserve(reply.regions_size());
+  for (const auto& [_, region] : reply.regions()) {
+    statuses.push_back(
+      {region.name(), region.key(), region.offset(), region.byte_size()});
+  }
+  return statuses;
+}
+
 InferenceResponse runInference(inference::GRPCInferenceService::Stub* stub,
                                const std::string& model,
                                const InferenceRequest& request,
-                               const std::string& version) {
-  inference::ModelInferRequest grpc_request;
-  inference::ModelInferResponse reply;
+                               const std::string& version,
+                               const CompressionOptions& compression) {
+  // the messages and everything they allocate are freed at once at the end
+  google::protobuf::Arena arena;
+  auto* grpc_request =
+    google::protobuf::Arena::CreateMessage<inference::ModelInferRequest>(
+      &arena);
+  auto* reply =
+    google::protobuf::Arena::CreateMessage<inference::ModelInferResponse>(
+      &arena);
 
   ClientContext context;
 
   Observer observer;
   AMDINFER_IF_LOGGING(observer.logger = Logger{Loggers::Client});
 
-  grpc_request.set_model_name(model);
-  grpc_request.set_model_version(version);
-  mapRequestToProto(request, grpc_request, observer);
+  grpc_request->set_model_name(model);
+  grpc_request->set_model_version(version);
+  mapRequestToProto(request, *grpc_request, observer);
+  setCompression(&context, request, compression);
 
-  Status status = stub->ModelInfer(&context, grpc_request, &reply);
+  Status status = stub->ModelInfer(&context, *grpc_request, reply);
 
   if (!status.ok()) {
     throw bad_status(status.error_message());
   }
 
   InferenceResponse response;
-  mapProtoToResponse(reply, response, observer);
+  mapProtoToResponse(*reply, response, observer);
   return response;
 }
 
 InferenceResponseFuture GrpcClient::modelInferAsyncImpl(
   const std::string& model, const InferenceRequest& request,
   const std::string& version) const {
-  return std::async(runInference, this->impl_->getStub(), model, request,
-                    version);
+  return this->impl_->infer(model, request, version);
+}
+
+void GrpcClient::modelInferAsync(const std::string& model,
+                                 const InferenceRequest& request,
+                                 Callback callback,
+                                 const std::string& version) const {
+  this->impl_->infer(model, request, version, std::move(callback));
 }
 
 InferenceResponse GrpcClient::modelInferImpl(const std::string& model,
                                              const InferenceRequest& request,
                                              const std::string& version) const {
-  return runInference(this->impl_->getStub(), model, request, version);
+  return runInference(this->impl_->nextStub(), model, request, version,
+                      this->impl_->getCompression());
+}
+
+class GrpcStream::GrpcStreamImpl {
+ public:
+  GrpcStreamImpl(inference::GRPCInferenceService::Stub* stub,
+                 std::string model, std::string version)
+    : model_(std::move(model)), version_(std::move(version)) {
+    AMDINFER_IF_LOGGING(observer_.logger = Logger{Loggers::Client});
+    stream_ = stub->ModelStreamInfer(&context_);
+    reader_ = std::thread{&GrpcStreamImpl::readResponses, this};
+  }
+
+  GrpcStreamImpl(GrpcStreamImpl const&) = delete;
+  GrpcStreamImpl& operator=(const GrpcStreamImpl&) = delete;
+  GrpcStreamImpl(GrpcStreamImpl&& other) = delete;
+  GrpcStreamImpl& operator=(GrpcStreamImpl&& other) = delete;
+  ~GrpcStreamImpl() { close(); }
+
+  InferenceResponseFuture infer(const InferenceRequest& request) {
+    Pending pending;
+    auto future = pending.promise.get_future();
+    this->send(request, std::move(pending));
+    return future;
+  }
+
+  void infer(const InferenceRequest& request, Callback callback) {
+    Pending pending;
+    pending.callback = std::move(callback);
+    this->send(request, std::move(pending));
+  }
+
+  void close() {
+    {
+      const std::lock_guard lock{write_mutex_};
+      if (closed_) {
+        return;
+      }
+      closed_ = true;
+      stream_->WritesDone();
+    }
+    reader_.join();
+    const auto status = stream_->Finish();
+    if (!status.ok()) {
+      AMDINFER_LOG_WARN(observer_.logger,
+                        "Inference stream ended with an error: " +
+                          status.error_message());
+    }
+  }
+
+ private:
+  /// A request waiting for its response. Its callback is run if it has one,
+  /// otherwise its promise is resolved
+  struct Pending {
+    std::promise<InferenceResponse> promise;
+    Callback callback;
+
+    void resolve(InferenceResponse response) {
+      if (callback) {
+        callback(response);
+      } else {
+        promise.set_value(std::move(response));
+      }
+    }
+
+    void reject(const std::exception_ptr& error) {
+      if (!callback) {
+        promise.set_exception(error);
+        return;
+      }
+      try {
+        std::rethrow_exception(error);
+      } catch (const std::exception& e) {
+        callback(InferenceResponse{e.what()});
+      }
+    }
+  };
+
+  void send(const InferenceRequest& request, Pending pending) {
+    inference::ModelInferRequest grpc_request;
+    grpc_request.set_model_name(model_);
+    grpc_request.set_model_version(version_);
+    mapRequestToProto(request, grpc_request, observer_);
+
+    std::string id = request.getID();
+    {
+      const std::lock_guard lock{mutex_};
+      if (id.empty()) {
+        id = std::to_string(next_id_++);
+        grpc_request.set_id(id);
+      }
+      auto [found, inserted] = pending_.try_emplace(id, std::move(pending));
+      if (!inserted) {
+        throw invalid_argument("A request with the ID " + id +
+                               " is already waiting on the stream");
+      }
+    }
+
+    // writes are serialized separately so reading responses isn't blocked
+    const std::lock_guard lock{write_mutex_};
+    if (closed_ || !stream_->Write(grpc_request)) {
+      const std::lock_guard pending_lock{mutex_};
+      pending_.erase(id);
+      throw bad_status("The inference stream is closed");
+    }
+  }
+
+  /// Pass a partial response to its request's callback, if it has one. The
+  /// request keeps waiting for its final response
+  void respondPartial(const inference::ModelStreamInferResponse& reply) {
+    // only this thread removes requests and references to the others stay
+    // valid as requests are added so the callback can be used after unlocking
+    Callback* callback = nullptr;
+    {
+      const std::lock_guard lock{mutex_};
+      auto found = pending_.find(reply.infer_response().id());
+      if (found == pending_.end() || !found->second.callback) {
+        return;
+      }
+      callback = &found->second.callback;
+    }
+    try {
+      InferenceResponse response;
+      mapProtoToResponse(reply.infer_response(), response, observer_);
+      (*callback)(response);
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_WARN(observer_.logger,
+                        std::string{"Dropped a partial response: "} + e.what());
+    }
+  }
+
+  void readResponses() {
+    inference::ModelStreamInferResponse reply;
+    while (stream_->Read(&reply)) {
+      const auto& parameters = reply.infer_response().parameters();
+      const auto final = parameters.find("final");
+      if (final != parameters.end() && !final->second.bool_param()) {
+        this->respondPartial(reply);
+        continue;
+      }
+
+      Pending pending;
+      {
+        const std::lock_guard lock{mutex_};
+        auto found = pending_.find(reply.infer_response().id());
+        if (found == pending_.end()) {
+          continue;
+        }
+        pending = std::move(found->second);
+        pending_.erase(found);
+      }
+
+      if (!reply.error_message().empty()) {
+        pending.reject(
+          std::make_exception_ptr(bad_status(reply.error_message())));
+        continue;
+      }
+      try {
+        InferenceResponse response;
+        mapProtoToResponse(reply.infer_response(), response, observer_);
+        pending.resolve(std::move(response));
+      } catch (...) {
+        pending.reject(std::current_exception());
+      }
+    }
+
+    std::unordered_map<std::string, Pending> unanswered;
+    {
+      const std::lock_guard lock{mutex_};
+      unanswered.swap(pending_);
+    }
+    for (auto& [id, pending] : unanswered) {
+      pending.reject(std::make_exception_ptr(
+        bad_status("The inference stream ended before request " + id +
+                   " got a response")));
+    }
+  }
+
+  std::string model_;
+  std::string version_;
+  Observer observer_;
+
+  using Stream =
+    ::grpc::ClientReaderWriter<inference::ModelInferRequest,
+                               inference::ModelStreamInferResponse>;
+  ClientContext context_;
+  std::unique_ptr<Stream> stream_;
+  std::thread reader_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, Pending> pending_;
+  size_t next_id_ = 0;
+
+  std::mutex write_mutex_;
+  bool closed_ = false;
+};
+
+GrpcStream::GrpcStream(std::unique_ptr<GrpcStreamImpl> impl)
+  : impl_(std::move(impl)) {}
+
+GrpcStream::GrpcStream(GrpcStream&& other) noexcept = default;
+GrpcStream& GrpcStream::operator=(GrpcStream&& other) noexcept = default;
+GrpcStream::~GrpcStream() = default;
+
+InferenceResponseFuture GrpcStream::modelInfer(
+  const InferenceRequest& request) {
+  return impl_->infer(request);
+}
+
+void GrpcStream::modelInfer(const InferenceRequest& request,
+                            Callback callback) {
+  impl_->infer(request, std::move(callback));
+}
+
+void GrpcStream::close() { impl_->close(); }
+
+GrpcStream GrpcClient::modelInferStream(const std::string& model,
+                                        const std::string& version) const {
+  return GrpcStream{std::make_unique<GrpcStream::GrpcStreamImpl>(
+    this->impl_->getStub(), model, version)};
 }
 
 bool GrpcClient::hasHardware(const std::string& name, int num) const {
@@ -23,22 +23,28 @@
 #include <google/protobuf/repeated_ptr_field.h>  // for RepeatedPtrField
 #include <google/protobuf/stubs/common.h>        // for string
 
-#include <cstddef>  // for size_t
-#include <cstdint>  // for int16_t, int32_t
-#include <cstring>  // for memcpy
-#include <memory>   // for make_shared, shared...
-#include <utility>  // for move
-#include <variant>  // for visit
-#include <vector>   // for vector, _Bit_reference
+#include <algorithm>  // for any_of
+#include <cstddef>    // for size_t, byte
+#include <cstdint>    // for int16_t, int32_t
+#include <cstring>    // for memcpy
+#include <memory>     // for make_shared, shared...
+#include <utility>    // for move
+#include <variant>    // for visit
+#include <vector>     // for vector, _Bit_reference
 
 #include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LO...
+#include "amdinfer/core/bytes_tensor.hpp"        // for BytesView, packBytes
 #include "amdinfer/core/data_types.hpp"          // for DataType, mapTypeToStr
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/model_metadata.hpp"      // for ModelMetadata
 #include "amdinfer/core/request_container.hpp"   // for ParameterMap
+#include "amdinfer/core/request_usage.hpp"       // for countCopy
+#include "amdinfer/core/shared_memory.hpp"       // for isInSharedMemory
 #include "amdinfer/declarations.hpp"             // for InferenceResponseOu...
 #include "amdinfer/observation/observer.hpp"     // for kNumTraceData
+#include "amdinfer/util/float_convert.hpp"       // for convertFp16ToFp32
 #include "amdinfer/util/traits.hpp"              // IWYU pragma: keep
 #include "inference.pb.h"                        // for ModelInferResponse_...
 
@@ -118,10 +124,23 @@ struct AddDataToTensor {
     auto* contents = getTensorContents<T>(tensor);
 
     if constexpr (std::is_same_v<T, char>) {
-      contents->Add(data);
-    } else if constexpr (std::is_same_v<T, fp16>) {
-      for (auto i = 0U; i < size; ++i) {
-        contents->Add(static_cast<float>(data[i]));
+      // send each element as its own string instead of stopping at the first
+      // null terminator
+      const BytesView elements{data, size};
+      contents->Reserve(contents->size() + static_cast<int>(elements.size()));
+      for (auto i = 0U; i < elements.size(); ++i) {
+        const auto element = elements[i];
+        contents->Add()->assign(element.data(), element.size());
+      }
+    } else if constexpr (util::is_any_v<T, fp16, bf16>) {
+      // 16-bit floats are sent as floats so convert the whole tensor at once
+      const auto offset = contents->size();
+      contents->Resize(offset + static_cast<int>(size), 0.0F);
+      auto* floats = contents->mutable_data() + offset;
+      if constexpr (std::is_same_v<T, fp16>) {
+        util::convertFp16ToFp32(data, floats, size);
+      } else {
+        util::convertBf16ToFp32(data, floats, size);
       }
     } else {
       for (auto i = 0U; i < size; ++i) {
@@ -151,6 +170,12 @@ void mapRequestToProto(const InferenceRequest& request,
   mapParametersToProto(params, grpc_parameters);
 
   const auto& inputs = request.getInputs();
+  const auto raw = std::any_of(
+    inputs.begin(), inputs.end(), [](const InferenceRequestInput& input) {
+      const auto& input_parameters = input.getParameters();
+      return input_parameters.has(kRawInput) &&
+             input_parameters.get<bool>(kRawInput);
+    });
   for (const auto& input : inputs) {
     auto* tensor = grpc_request.add_inputs();
 
@@ -166,11 +191,26 @@ void mapRequestToProto(const InferenceRequest& request,
     mapParametersToProto(input.getParameters().data(),
                          tensor->mutable_parameters());
 
-    switchOverTypes(AddDataToTensor(), input.getDatatype(), input.getData(),
-                    input.getSize(), tensor, observer);
+    if (isInSharedMemory(input.getParameters())) {
+      // the server reads the data from the region
+      continue;
+    }
+    if (raw) {
+      grpc_request.add_raw_input_contents()->assign(
+        static_cast<const char*>(input.getData()),
+        input.getSize() * datatype.size());
+    } else {
+      switchOverTypes(AddDataToTensor(), input.getDatatype(), input.getData(),
+                      input.getSize(), tensor, observer);
+    }
   }
 
-  // TODO(varunsh): skipping outputs for now
+  for (const auto& output : request.getOutputs()) {
+    auto* tensor = grpc_request.add_outputs();
+    tensor->set_name(output.getName());
+    mapParametersToProto(output.getParameters().data(),
+                         tensor->mutable_parameters());
+  }
 }
 
 struct SetOutputData {
@@ -182,14 +222,15 @@ struct SetOutputData {
     data.resize(bytes_to_copy);
     const auto* contents = getTensorContents<T>(tensor);
     if constexpr (std::is_same_v<T, char>) {
-      std::memcpy(data.data(), (*contents)->data(), size * sizeof(T));
+      packBytes(tensor->contents().bytes_contents(), data.data(), size);
       output->setData(std::move(data));
     } else {
       if constexpr (std::is_same_v<T, fp16>) {
-        for (auto i = 0U; i < size; ++i) {
-          auto datum = static_cast<fp16>(contents[i]);
-          std::memcpy(&(data[i * sizeof(T)]), &(datum), sizeof(T));
-        }
+        util::convertFp32ToFp16(contents, reinterpret_cast<fp16*>(data.data()),
+                                size);
+      } else if constexpr (std::is_same_v<T, bf16>) {
+        util::convertFp32ToBf16(contents, reinterpret_cast<bf16*>(data.data()),
+                                size);
       } else if constexpr (util::is_any_v<T, int8_t, uint8_t, int16_t,
                                           uint16_t>) {
         for (auto i = 0U; i < size; ++i) {
@@ -210,28 +251,59 @@ void mapProtoToResponse(const inference::ModelInferResponse& reply,
                         InferenceResponse& response, const Observer& observer) {
   response.setModel(reply.model_name());
   response.setID(reply.id());
+  if (const auto& parameters = reply.parameters();
+      parameters.find("final") != parameters.end()) {
+    response.setFinal(parameters.at("final").bool_param());
+  }
+
+  // outputs in shared memory have no raw contents
+  const auto raw = reply.raw_output_contents_size() > 0;
+  auto raw_index = 0;
 
-  for (const auto& tensor : reply.outputs()) {
+  for (auto i = 0; i < reply.outputs_size(); ++i) {
+    const auto& tensor = reply.outputs(i);
     InferenceResponseOutput output;
     output.setName(tensor.name());
     output.setDatatype(DataType(tensor.datatype().c_str()));
-    std::vector<int64_t> shape;
+    Shape shape;
     shape.reserve(tensor.shape_size());
     auto size = 1U;
     for (const auto& index : tensor.shape()) {
       shape.push_back(static_cast<size_t>(index));
       size *= index;
     }
-    output.setShape(shape);
-    // TODO(varunsh): skipping parameters for now
-    switchOverTypes(SetOutputData(), output.getDatatype(), &output, size,
-                    &tensor, observer);
-    response.addOutput(output);
+    output.setShape(std::move(shape));
+    output.setParameters(mapProtoToParameters(tensor.parameters()));
+    if (isInSharedMemory(output.getParameters())) {
+      response.addOutput(std::move(output));
+      continue;
+    }
+    if (raw) {
+      if (raw_index >= reply.raw_output_contents_size()) {
+        throw invalid_argument("Not enough raw output contents for outputs");
+      }
+      const auto& contents = reply.raw_output_contents(raw_index++);
+      if (contents.size() != size * output.getDatatype().size()) {
+        throw invalid_argument("Raw output " + tensor.name() +
+                               " has the wrong size");
+      }
+      std::vector<std::byte> data(contents.size());
+      std::memcpy(data.data(), contents.data(), contents.size());
+      output.setData(std::move(data));
+    } else {
+      switchOverTypes(SetOutputData(), output.getDatatype(), &output, size,
+                      &tensor, observer);
+    }
+    response.addOutput(std::move(output));
+  }
+  if (raw && raw_index != reply.raw_output_contents_size()) {
+    throw invalid_argument(
+      "The number of raw output contents must match the number of outputs");
   }
 }
 
-void mapResponseToProto(InferenceResponse response,
-                        inference::ModelInferResponse& reply) {
+void mapResponseToProto(const InferenceResponse& response,
+                        inference::ModelInferResponse& reply, bool raw) {
   Observer observer;
   AMDINFER_IF_LOGGING(observer.logger = Logger{Loggers::Server});
 
@@ -239,7 +311,10 @@ void mapResponseToProto(InferenceResponse response,
                      "Mapping the InferenceResponse to proto object");
   reply.set_model_name(response.getModel());
   reply.set_id(response.getID());
-  auto outputs = response.getOutputs();
+  if (!response.isFinal()) {
+    (*reply.mutable_parameters())["final"].set_bool_param(false);
+  }
+  const auto& outputs = response.getOutputs();
   for (const InferenceResponseOutput& output : outputs) {
     auto* tensor = reply.add_outputs();
     tensor->set_name(output.getName());
@@ -252,8 +327,21 @@ void mapResponseToProto(InferenceResponse response,
       size *= index;
     }
 
-    switchOverTypes(AddDataToTensor(), output.getDatatype(), output.getData(),
-                    output.getSize(), tensor, observer);
+    const auto& parameters = output.getParameters();
+    if (isInSharedMemory(parameters)) {
+      // the data was written to the region the request designated
+      mapParametersToProto(parameters.data(), tensor->mutable_parameters());
+      continue;
+    }
+    countCopy(output.getSize() * output.getDatatype().size());
+    if (raw) {
+      reply.add_raw_output_contents()->assign(
+        static_cast<const char*>(output.getData()),
+        output.getSize() * output.getDatatype().size());
+    } else {
+      switchOverTypes(AddDataToTensor(), output.getDatatype(),
+                      output.getData(), output.getSize(), tensor, observer);
+    }
   }
 }
 
@@ -44,6 +44,14 @@ class ModelInferRequest;
 
 namespace amdinfer {
 
+/// Input parameter to send the input in raw_input_contents
+constexpr auto kRawInput = "binary_data";
+/// Request parameter to get all the outputs in raw_output_contents
+constexpr auto kRawOutput = "binary_data_output";
+/// Metadata that clients send with the algorithm they accept for compressed
+/// responses
+constexpr auto kAcceptCompression = "amdinfer-accept-compression";
+
 class InferenceRequest;
 class InferenceResponse;
 class ModelMetadata;
@@ -58,11 +66,22 @@ ParameterMap mapProtoToParameters(
 void mapProtoToParameters(
   const google::protobuf::Map<std::string, inference::InferParameter>& params,
   ParameterMap& parameters);
+/**
+ * @brief Map a request to proto. If any input has the kRawInput parameter set
+ * to true, all the inputs are sent as raw bytes in raw_input_contents since
+ * the two forms can't be mixed in one request.
+ */
 void mapRequestToProto(const InferenceRequest& request,
                        inference::ModelInferRequest& grpc_request,
                        const Observer& observer);
-void mapResponseToProto(InferenceResponse response,
-                        inference::ModelInferResponse& reply);
+/**
+ * @brief Map a response to proto. If raw is true, all the outputs are sent as
+ * raw bytes in raw_output_contents instead of the typed contents.
+ */
+void mapResponseToProto(const InferenceResponse& response,
+                        inference::ModelInferResponse& reply,
+                        bool raw = false);
+/// Map a proto response back. Outputs in raw_output_contents are read as well
 void mapProtoToResponse(const inference::ModelInferResponse& reply,
                         InferenceResponse& response, const Observer& observer);
 
@@ -101,7 +120,7 @@ constexpr auto* getTensorContents(Tensor* tensor) {
     } else {
       return tensor->mutable_contents()->mutable_int64_contents();
     }
-  } else if constexpr (util::is_any_v<T, fp16, float>) {
+  } else if constexpr (util::is_any_v<T, fp16, bf16, float>) {
     if constexpr (std::is_const_v<Tensor>) {
       return tensor->contents().fp32_contents().data();
     } else {
@@ -25,18 +25,25 @@
 #include <drogon/HttpResponse.h>          // for HttpResponse
 #include <drogon/HttpTypes.h>             // for k200OK, Get, Post, ReqR...
 #include <json/value.h>                   // for Value, arrayValue, obje...
+#include <json/writer.h>                  // for StreamWriterBuilder
+#include <trantor/net/EventLoop.h>        // for EventLoop, TimerId
 #include <trantor/net/EventLoopThread.h>  // for EventLoopThread
 
 #include <cassert>        // for assert
 #include <future>         // for promise
+#include <limits>         // for numeric_limits
+#include <string>         // for string, to_string
+#include <string_view>    // for string_view
 #include <unordered_set>  // for unordered_set
-#include <utility>        // for tuple_element<>::type
-#include <vector>
+#include <utility>        // for pair, move
+#include <vector>         // for vector
 
+#include "amdinfer/clients/connection_pool.hpp"  // for ConnectionPool
 #include "amdinfer/clients/http_internal.hpp"    // for mapParametersToJson
 #include "amdinfer/core/exceptions.hpp"          // for bad_status
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/util/compression.hpp"         // for compress, decompress
 
 namespace amdinfer {
 
@@ -46,59 +53,126 @@ void addHeaders(const drogon::HttpRequestPtr& req, const StringMap& headers) {
   }
 }
 
+bool connectionOk(drogon::ReqResult result) {
+  // the other results are only errors in the request or the response
+  return result != drogon::ReqResult::NetworkFailure &&
+         result != drogon::ReqResult::BadServerAddress &&
+         result != drogon::ReqResult::Timeout;
+}
+
 class HttpClient::HttpClientImpl {
  public:
-  explicit HttpClientImpl(const std::string& address, StringMap headers,
-                          int parallelism)
-    : headers_(std::move(headers)), num_clients_(parallelism) {
+  using Pool = ConnectionPool<drogon::HttpClient>;
+
+  HttpClientImpl(const std::string& address, StringMap headers,
+                 int parallelism, const CompressionOptions& compression)
+    : headers_(std::move(headers)),
+      compression_(compression),
+      loops_(makeLoops(parallelism)),
+      pool_(std::make_shared<Pool>(
+        [this, address](size_t index) {
+          const auto& loop = loops_[index % loops_.size()];
+          return drogon::HttpClient::newHttpClient(address, loop->getLoop());
+        },
+        makeOptions(parallelism))) {
+    // reconnect and shrink the pool in the background
+    auto* loop = loops_.front()->getLoop();
+    const auto period_s = 1.0;
+    maintenance_ = loop->runEvery(period_s, [this]() { pool_->maintain(); });
+  }
+
+  HttpClientImpl(const HttpClientImpl&) = delete;
+  HttpClientImpl& operator=(const HttpClientImpl&) = delete;
+  HttpClientImpl(HttpClientImpl&&) = delete;
+  HttpClientImpl& operator=(HttpClientImpl&&) = delete;
+  ~HttpClientImpl() {
+    // cancel the timer from its loop so maintain() can't be running while the
+    // pool is destroyed
+    auto* loop = loops_.front()->getLoop();
+    std::promise<void> cancelled;
+    loop->runInLoop([&]() {
+      loop->invalidateTimer(maintenance_);
+      cancelled.set_value();
+    });
+    cancelled.get_future().wait();
+  }
+
+  std::pair<drogon::ReqResult, drogon::HttpResponsePtr> sendRequest(
+    const drogon::HttpRequestPtr& req, double timeout = 0) {
+    auto ticket = pool_->acquire();
+    auto [result, response] = ticket.connection->sendRequest(req, timeout);
+    pool_->release(ticket, connectionOk(result));
+    return {result, response};
+  }
+
+  void sendRequest(const drogon::HttpRequestPtr& req,
+                   drogon::HttpReqCallback&& callback) {
+    auto ticket = pool_->acquire();
+    auto connection = ticket.connection;
+    // the response may arrive after this client is destroyed
+    connection->sendRequest(
+      req, [pool = std::weak_ptr<Pool>(pool_), ticket = std::move(ticket),
+            callback = std::move(callback)](
+             drogon::ReqResult result, const drogon::HttpResponsePtr& response) {
+        if (auto locked = pool.lock()) {
+          locked->release(ticket, connectionOk(result));
+        }
+        callback(result, response);
+      });
+  }
+
+  const StringMap& getHeaders() const { return headers_; }
+  const CompressionOptions& getCompression() const { return compression_; }
+
+  std::vector<ConnectionStats> getStats() const { return pool_->stats(); }
+
+ private:
+  using Loops = std::vector<std::unique_ptr<trantor::EventLoopThread>>;
+
+  static Loops makeLoops(int parallelism) {
     // arbitrarily use ratio of 16:1 between HttpClients and EventLoops
     const auto client_thread_ratio = 16;
     const auto threads = (parallelism / client_thread_ratio) + 1;
 
-    loops_.reserve(threads);
-    clients_.reserve(num_clients_);
+    Loops loops;
+    loops.reserve(threads);
     for (auto i = 0; i < threads; ++i) {
       // need to use unique_ptr because EventLoopThreads are not moveable or
       // copyable and so incompatible with std::vectors
       const auto& loop =
-        loops_.emplace_back(std::make_unique<trantor::EventLoopThread>());
+        loops.emplace_back(std::make_unique<trantor::EventLoopThread>());
       loop->run();
     }
-    for (auto i = 0; i < num_clients_; ++i) {
-      const auto& loop = loops_[i % threads];
-      clients_.emplace_back(
-        drogon::HttpClient::newHttpClient(address, loop->getLoop()));
-    }
+    return loops;
   }
 
-  drogon::HttpClient* getClient() {
-    const auto& client = clients_[counter_];
-    counter_ = (counter_ + 1) % num_clients_;
-    return client.get();
+  static Pool::Options makeOptions(int parallelism) {
+    if (parallelism < 1) {
+      throw invalid_argument("The parallelism must be at least 1");
+    }
+    Pool::Options options;
+    options.min_size = 1;
+    options.max_size = parallelism;
+    // drogon sends one request at a time on a connection so open another one
+    // rather than queue behind a busy connection
+    options.grow_threshold = 1;
+    return options;
   }
 
-  const StringMap& getHeaders() const { return headers_; }
-
-  auto getClientNum() const { return num_clients_; }
-
- private:
   StringMap headers_;
-  int counter_ = 0;
-  int num_clients_;
-  std::vector<std::unique_ptr<trantor::EventLoopThread>> loops_;
-  std::vector<drogon::HttpClientPtr> clients_;
+  CompressionOptions compression_;
+  Loops loops_;
+  std::shared_ptr<Pool> pool_;
+  trantor::TimerId maintenance_ = 0;
 };
 
-HttpClient::HttpClient(const std::string& address) {
-  const auto parallelism = 32;
-  this->impl_ = std::make_unique<HttpClient::HttpClientImpl>(
-    address, StringMap{}, parallelism);
-}
+HttpClient::HttpClient(const std::string& address)
+  : HttpClient(address, StringMap{}, kDefaultParallelism) {}
 
 HttpClient::HttpClient(const std::string& address, const StringMap& headers,
-                       int parallelism) {
-  this->impl_ =
-    std::make_unique<HttpClient::HttpClientImpl>(address, headers, parallelism);
+                       int parallelism, const CompressionOptions& compression) {
+  this->impl_ = std::make_unique<HttpClient::HttpClientImpl>(
+    address, headers, parallelism, compression);
 }
 
 // needed for HttpClientImpl forward declaration in WebSocket client
@@ -149,10 +223,9 @@ drogon::HttpRequestPtr createPostRequest(const Json::Value& json,
 }
 
 ServerMetadata HttpClient::serverMetadata() const {
-  auto* client = this->impl_->getClient();
   auto req = createGetRequest("/v2", impl_->getHeaders());
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   if (response->statusCode() != drogon::k200OK) {
     throw bad_status(response->getJsonError());
@@ -169,12 +242,11 @@ ServerMetadata HttpClient::serverMetadata() const {
 }
 
 bool HttpClient::serverLive() const {
-  auto* client = this->impl_->getClient();
   auto req = createGetRequest("/v2/health/live", impl_->getHeaders());
 
   // arbitrarily setting a 10 second timeout
   const auto timeout_s = 10.0;
-  auto [result, response] = client->sendRequest(req, timeout_s);
+  auto [result, response] = impl_->sendRequest(req, timeout_s);
   if (result != drogon::ReqResult::Ok) {
     return false;
   }
@@ -182,17 +254,15 @@ bool HttpClient::serverLive() const {
 }
 
 bool HttpClient::serverReady() const {
-  auto* client = this->impl_->getClient();
   auto req = createGetRequest("/v2/health/ready", impl_->getHeaders());
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   return response->statusCode() == drogon::k200OK;
 }
 
 bool HttpClient::modelReadyImpl(const std::string& model,
                                 const std::string& version) const {
-  auto* client = this->impl_->getClient();
   drogon::HttpRequestPtr req;
   if (version.empty()) {
     req =
@@ -203,14 +273,13 @@ bool HttpClient::modelReadyImpl(const std::string& model,
       impl_->getHeaders());
   }
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   return response->statusCode() == drogon::k200OK;
 }
 
 ModelMetadata HttpClient::modelMetadataImpl(const std::string& model,
                                             const std::string& version) const {
-  auto* client = this->impl_->getClient();
   drogon::HttpRequestPtr req;
   if (version.empty()) {
     req = createGetRequest("/v2/models/" + model, impl_->getHeaders());
@@ -219,7 +288,7 @@ ModelMetadata HttpClient::modelMetadataImpl(const std::string& model,
                            impl_->getHeaders());
   }
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   auto resp = response->jsonObject();
   return mapJsonToModelMetadata(resp.get());
@@ -228,8 +297,6 @@ ModelMetadata HttpClient::modelMetadataImpl(const std::string& model,
 void HttpClient::modelLoadImpl(const std::string& model,
                                const ParameterMap& parameters,
                                const std::string& version) const {
-  auto* client = this->impl_->getClient();
-
   Json::Value json = Json::objectValue;
   json = mapParametersToJson(parameters);
 
@@ -243,7 +310,7 @@ void HttpClient::modelLoadImpl(const std::string& model,
       impl_->getHeaders());
   }
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   if (response->statusCode() != drogon::k200OK) {
     throw bad_status(std::string(response->body()));
@@ -252,8 +319,6 @@ void HttpClient::modelLoadImpl(const std::string& model,
 
 void HttpClient::modelUnloadImpl(const std::string& model,
                                  const std::string& version) const {
-  auto* client = this->impl_->getClient();
-
   Json::Value json;
   drogon::HttpRequestPtr req;
   if (version.empty()) {
@@ -266,7 +331,7 @@ void HttpClient::modelUnloadImpl(const std::string& model,
       impl_->getHeaders());
   }
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   auto status = response->statusCode();
   if (status != drogon::k200OK) {
@@ -276,15 +341,13 @@ void HttpClient::modelUnloadImpl(const std::string& model,
 
 std::string HttpClient::workerLoad(const std::string& worker,
                                    const ParameterMap& parameters) const {
-  auto* client = this->impl_->getClient();
-
   Json::Value json = Json::objectValue;
   json = mapParametersToJson(parameters);
 
   auto req = createPostRequest(json, "/v2/workers/" + worker + "/load",
                                impl_->getHeaders());
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   if (response->statusCode() != drogon::k200OK) {
     throw bad_status(std::string(response->body()));
@@ -293,13 +356,11 @@ std::string HttpClient::workerLoad(const std::string& worker,
 }
 
 void HttpClient::workerUnload(const std::string& worker) const {
-  auto* client = this->impl_->getClient();
-
   Json::Value json;
   auto req = createPostRequest(json, "/v2/workers/" + worker + "/unload",
                                impl_->getHeaders());
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   auto status = response->statusCode();
   if (status != drogon::k200OK) {
@@ -307,35 +368,124 @@ void HttpClient::workerUnload(const std::string& worker) const {
   }
 }
 
+util::Encoding toEncoding(CompressionAlgorithm algorithm) {
+  switch (algorithm) {
+    case CompressionAlgorithm::Identity:
+      return util::Encoding::Identity;
+    case CompressionAlgorithm::Deflate:
+      return util::Encoding::Deflate;
+    case CompressionAlgorithm::Gzip:
+      return util::Encoding::Gzip;
+    case CompressionAlgorithm::Zstd:
+      return util::Encoding::Zstd;
+  }
+  return util::Encoding::Identity;
+}
+
+/**
+ * @brief Compress the body of a request if it's large enough and ask for the
+ * response to be compressed in the same way
+ *
+ * @param req the request
+ * @param compression how to compress
+ */
+void compressRequest(const drogon::HttpRequestPtr& req,
+                     const CompressionOptions& compression) {
+  const auto encoding = toEncoding(compression.algorithm);
+  if (encoding == util::Encoding::Identity) {
+    return;
+  }
+  const auto name = std::string{util::toString(encoding)};
+  req->addHeader("Accept-Encoding", name);
+
+  const auto body = req->body();
+  if (body.size() < compression.threshold) {
+    return;
+  }
+  auto compressed = util::compress(encoding, body.data(), body.size());
+  if (compressed.size() < body.size()) {
+    req->setBody(std::move(compressed));
+    req->addHeader("Content-Encoding", name);
+  }
+}
+
 auto createInferenceRequest(const std::string& model,
                             const InferenceRequest& request,
                             const std::string& version,
-                            const StringMap& headers) {
+                            const StringMap& headers,
+                            const CompressionOptions& compression) {
   if (request.getInputs().empty()) {
     throw invalid_argument("The request's inputs cannot be empty");
   }
 
-  auto json = mapRequestToJson(request);
-  drogon::HttpRequestPtr req;
-  if (version.empty()) {
-    req = createPostRequest(json, "/v2/models/" + model + "/infer", headers);
-  } else {
-    req = createPostRequest(
-      json, "/v2/models/" + model + "/versions/" + version + "/infer", headers);
+  std::string binary;
+  auto json = mapRequestToJson(request, &binary);
+  std::string path = version.empty()
+                       ? "/v2/models/" + model + "/infer"
+                       : "/v2/models/" + model + "/versions/" + version +
+                           "/infer";
+  if (binary.empty()) {
+    auto req = createPostRequest(json, path, headers);
+    compressRequest(req, compression);
+    return req;
   }
+
+  // use the binary tensor data extension: the body is the JSON header
+  // followed by the raw bytes of the inputs
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  auto body = Json::writeString(builder, json);
+  const auto header_length = body.size();
+  body.append(binary);
+
+  auto req = drogon::HttpRequest::newHttpRequest();
+  req->setMethod(drogon::Post);
+  req->setPath(path);
+  req->setContentTypeCode(drogon::CT_APPLICATION_OCTET_STREAM);
+  req->addHeader(kInferenceHeaderContentLength, std::to_string(header_length));
+  req->setBody(std::move(body));
+  addHeaders(req, headers);
+  compressRequest(req, compression);
   return req;
 }
 
+InferenceResponse parseInferenceResponse(
+  const drogon::HttpResponsePtr& response) {
+  const auto& header_length =
+    response->getHeader(kInferenceHeaderContentLength);
+  const auto encoding =
+    util::parseEncoding(response->getHeader("content-encoding"));
+  if (header_length.empty() && encoding == util::Encoding::Identity) {
+    auto json = response->jsonObject();
+    return mapJsonToResponse(json.get());
+  }
+
+  std::string decompressed;
+  std::string_view body = response->body();
+  if (encoding != util::Encoding::Identity) {
+    decompressed = util::decompress(encoding, body.data(), body.size(),
+                                    std::numeric_limits<size_t>::max());
+    body = decompressed;
+  }
+
+  // without binary data, the whole body is the JSON header
+  std::string_view binary;
+  auto json = parseBinaryBody(
+    body, header_length.empty() ? std::to_string(body.size()) : header_length,
+    &binary);
+  return mapJsonToResponse(json.get(), binary);
+}
+
 InferenceResponseFuture HttpClient::modelInferAsyncImpl(
   const std::string& model, const InferenceRequest& request,
   const std::string& version) const {
   auto req =
-    createInferenceRequest(model, request, version, impl_->getHeaders());
+    createInferenceRequest(model, request, version, impl_->getHeaders(),
+                           impl_->getCompression());
   auto prom = std::make_shared<std::promise<amdinfer::InferenceResponse>>();
   auto fut = prom->get_future();
 
-  auto* client = this->impl_->getClient();
-  client->sendRequest(req, [prom](drogon::ReqResult result,
+  impl_->sendRequest(req, [prom](drogon::ReqResult result,
                                   const drogon::HttpResponsePtr& response) {
     // throwing exceptions asynchronously makes them difficult to process so
     // just return an error object. Unfortunately, there's no way to know which
@@ -351,8 +501,11 @@ InferenceResponseFuture HttpClient::modelInferAsyncImpl(
       error = e.what();
     }
     if (error.empty()) {
-      auto resp = response->jsonObject();
-      prom->set_value(mapJsonToResponse(resp.get()));
+      try {
+        prom->set_value(parseInferenceResponse(response));
+      } catch (const invalid_argument& e) {
+        prom->set_value(InferenceResponse(std::string{e.what()}));
+      }
     } else {
       prom->set_value(InferenceResponse(error));
     }
@@ -365,24 +518,22 @@ InferenceResponse HttpClient::modelInferImpl(const std::string& model,
                                              const InferenceRequest& request,
                                              const std::string& version) const {
   auto req =
-    createInferenceRequest(model, request, version, impl_->getHeaders());
+    createInferenceRequest(model, request, version, impl_->getHeaders(),
+                           impl_->getCompression());
 
-  auto* client = this->impl_->getClient();
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   if (response->statusCode() != drogon::k200OK) {
     throw bad_status(std::string{response->body()});
   }
 
-  auto resp = response->jsonObject();
-  return mapJsonToResponse(resp.get());
+  return parseInferenceResponse(response);
 }
 
 std::vector<std::string> HttpClient::modelList() const {
-  auto* client = this->impl_->getClient();
   auto req = createGetRequest("/v2/models", impl_->getHeaders());
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   if (response->statusCode() != drogon::k200OK) {
     throw bad_status(response->getJsonError());
@@ -398,15 +549,100 @@ std::vector<std::string> HttpClient::modelList() const {
   return models;
 }
 
-bool HttpClient::hasHardware(const std::string& name, int num) const {
-  auto* client = this->impl_->getClient();
+void HttpClient::modelUpdate(const std::string& model,
+                             const ParameterMap& parameters,
+                             const std::string& version) const {
+  auto json = mapParametersToJson(parameters);
+
+  drogon::HttpRequestPtr req;
+  if (version.empty()) {
+    req = createPostRequest(json, "/v2/repository/models/" + model + "/update",
+                            impl_->getHeaders());
+  } else {
+    req = createPostRequest(
+      json,
+      "/v2/repository/models/" + model + "/versions/" + version + "/update",
+      impl_->getHeaders());
+  }
 
+  auto [result, response] = impl_->sendRequest(req);
+  checkError(result);
+  if (response->statusCode() != drogon::k200OK) {
+    throw bad_status(std::string(response->body()));
+  }
+}
+
+void HttpClient::registerSystemSharedMemory(const std::string& name,
+                                            const std::string& key,
+                                            size_t byte_size,
+                                            size_t offset) const {
+  Json::Value json;
+  json["key"] = key;
+  json["offset"] = static_cast<Json::UInt64>(offset);
+  json["byte_size"] = static_cast<Json::UInt64>(byte_size);
+  auto req = createPostRequest(
+    json, "/v2/systemsharedmemory/region/" + name + "/register",
+    impl_->getHeaders());
+
+  auto [result, response] = impl_->sendRequest(req);
+  checkError(result);
+  if (response->statusCode() != drogon::k200OK) {
+    throw bad_status(std::string(response->body()));
+  }
+}
+
+void HttpClient::unregisterSystemSharedMemory(const std::string& name) const {
+  Json::Value json;
+  const auto path = name.empty()
+                      ? std::string{"/v2/systemsharedmemory/unregister"}
+                      : "/v2/systemsharedmemory/region/" + name + "/unregister";
+  auto req = createPostRequest(json, path, impl_->getHeaders());
+
+  auto [result, response] = impl_->sendRequest(req);
+  checkError(result);
+  if (response->statusCode() != drogon::k200OK) {
+    throw bad_status(std::string(response->body()));
+  }
+}
+
+std::vector<SharedMemoryStatus> HttpClient::systemSharedMemoryStatus(
+  const std::string& name) const {
+  const auto path = name.empty()
+                      ? std::string{"/v2/systemsharedmemory/status"}
+                      : "/v2/systemsharedmemory/region/" + name + "/status";
+  auto req = createGetRequest(path, impl_->getHeaders());
+
+  auto [result, response] = impl_->sendRequest(req);
+  checkError(result);
+  if (response->statusCode() != drogon::k200OK) {
+    throw bad_status(std::string(response->body()));
+  }
+  auto json = response->jsonObject();
+  if (json == nullptr) {
+    throw bad_status("Invalid shared memory status from the server");
+  }
+
+  std::vector<SharedMemoryStatus> statuses;
+  statuses.reserve(json->size());
+  for (const auto& region : *json) {
+    statuses.push_back({region["name"].asString(), region["key"].asString(),
+                        region["offset"].asUInt64(),
+                        region["byte_size"].asUInt64()});
+  }
+  return statuses;
+}
+
+std::vector<ConnectionStats> HttpClient::connectionStats() const {
+  return impl_->getStats();
+}
+
+bool HttpClient::hasHardware(const std::string& name, int num) const {
   Json::Value json;
   json["name"] = name;
   json["num"] = num;
   auto req = createPostRequest(json, "/v2/hardware", impl_->getHeaders());
 
-  auto [result, response] = client->sendRequest(req);
+  auto [result, response] = impl_->sendRequest(req);
   checkError(result);
   return response->statusCode() == drogon::k200OK;
 }
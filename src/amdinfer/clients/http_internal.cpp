@@ -32,9 +32,12 @@
 #include <cstddef>      // for size_t, byte
 #include <cstdint>      // for int64_t, int32_t
 #include <cstring>      // for memcpy
+#include <memory>       // for make_shared, unique_ptr
+#include <stdexcept>    // for invalid_argument, out_of_range
+#include <string>       // for string, stoull
 #include <string_view>  // for basic_string_view
 #include <utility>      // for move
-#include <variant>      // for visit
+#include <variant>      // for visit, bad_variant_access
 
 #include "amdinfer/buffers/buffer.hpp"           // for Buffer
 #include "amdinfer/core/data_types.hpp"          // for DataType, mapTypeToStr
@@ -43,6 +46,7 @@
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/model_metadata.hpp"      // for ModelMetadata
 #include "amdinfer/core/request_container.hpp"   // for InferenceRequestOutput
+#include "amdinfer/core/shared_memory.hpp"       // for isInSharedMemory
 #include "amdinfer/observation/logging.hpp"      // for Logger
 #include "amdinfer/util/traits.hpp"              // IWYU pragma: keep
 #include "half/half.hpp"                         // for half
@@ -67,6 +71,51 @@ ParameterMap mapJsonToParameters(Json::Value json) {
   return parameters;
 }
 
+bool isParameterTrue(const ParameterMap &parameters, const std::string &key) {
+  if (!parameters.has(key)) {
+    return false;
+  }
+  try {
+    return parameters.get<bool>(key);
+  } catch (const std::bad_variant_access &) {
+    throw invalid_argument("The '" + key + "' parameter must be a boolean");
+  }
+}
+
+size_t parseHeaderLength(const std::string &header_length, size_t body_size) {
+  size_t length = 0;
+  try {
+    length = std::stoull(header_length);
+  } catch (const std::invalid_argument &) {
+    throw invalid_argument("Invalid " +
+                           std::string{kInferenceHeaderContentLength});
+  } catch (const std::out_of_range &) {
+    throw invalid_argument("Invalid " +
+                           std::string{kInferenceHeaderContentLength});
+  }
+  if (length > body_size) {
+    throw invalid_argument(std::string{kInferenceHeaderContentLength} +
+                           " exceeds the size of the body");
+  }
+  return length;
+}
+
+std::shared_ptr<Json::Value> parseBinaryBody(std::string_view body,
+                                             const std::string &header_length,
+                                             std::string_view *binary) {
+  const auto length = parseHeaderLength(header_length, body.size());
+
+  auto root = std::make_shared<Json::Value>();
+  std::string errors;
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+  if (!reader->parse(body.data(), body.data() + length, root.get(), &errors)) {
+    throw invalid_argument("Failed to interpret the body header as JSON");
+  }
+  *binary = body.substr(length);
+  return root;
+}
+
 // refer to cppreference for std::visit
 // helper type for the visitor #4
 template <class... Ts>
@@ -118,7 +167,8 @@ struct SetOutputData {
   }
 };
 
-InferenceResponse mapJsonToResponse(Json::Value *json) {
+InferenceResponse mapJsonToResponse(Json::Value *json,
+                                    std::string_view binary) {
   InferenceResponse response;
   response.setModel(json->get("model_name", "").asString());
   response.setID(json->get("id", "").asString());
@@ -131,21 +181,41 @@ InferenceResponse mapJsonToResponse(Json::Value *json) {
     output.setDatatype(DataType(json_output["datatype"].asCString()));
 
     auto json_shape = json_output["shape"];
-    std::vector<int64_t> shape;
+    Shape shape;
     shape.reserve(json_shape.size());
     for (const auto &index : json_shape) {
       shape.push_back(index.asUInt());
     }
-    output.setShape(shape);
-    const auto &json_data = json_output["data"];
-    switchOverTypes(SetOutputData(), output.getDatatype(), json_data, &output);
-    response.addOutput(output);
+    output.setShape(std::move(shape));
+    const auto &json_parameters = json_output["parameters"];
+    if (isInSharedMemory(output.getParameters())) {
+      // the server wrote the data to the region the request designated
+      response.addOutput(std::move(output));
+      continue;
+    }
+    if (json_parameters.isMember(kBinaryDataSize)) {
+      const auto size = json_parameters[kBinaryDataSize].asUInt64();
+      if (size > binary.size()) {
+        throw invalid_argument("Not enough binary data for output " +
+                               output.getName());
+      }
+      std::vector<std::byte> data(size);
+      memcpy(data.data(), binary.data(), size);
+      output.setData(std::move(data));
+      binary.remove_prefix(size);
+    } else {
+      const auto &json_data = json_output["data"];
+      switchOverTypes(SetOutputData(), output.getDatatype(), json_data,
+                      &output);
+    }
+    response.addOutput(std::move(output));
   }
 
   return response;
 }
 
-Json::Value mapRequestToJson(const InferenceRequest &request) {
+Json::Value mapRequestToJson(const InferenceRequest &request,
+                             std::string *binary) {
   Json::Value json;
   json["id"] = request.getID();
   const auto &parameters = request.getParameters();
@@ -161,13 +231,36 @@ Json::Value mapRequestToJson(const InferenceRequest &request) {
     for (const auto &index : input.getShape()) {
       json_input["shape"].append(static_cast<Json::UInt64>(index));
     }
-    json_input["data"] = Json::arrayValue;
-    switchOverTypes(SetInputData(), input.getDatatype(), &(json_input["data"]),
-                    input.getData(), input.getSize());
+    if (isInSharedMemory(input.getParameters())) {
+      // the server reads the data from the region
+      json["inputs"].append(json_input);
+      continue;
+    }
+    if (binary != nullptr &&
+        isParameterTrue(input.getParameters(), kBinaryData)) {
+      const auto size = input.getSize() * input.getDatatype().size();
+      json_input["parameters"].removeMember(kBinaryData);
+      json_input["parameters"][kBinaryDataSize] =
+        static_cast<Json::UInt64>(size);
+      binary->append(static_cast<const char *>(input.getData()), size);
+    } else {
+      json_input["data"] = Json::arrayValue;
+      switchOverTypes(SetInputData(), input.getDatatype(),
+                      &(json_input["data"]), input.getData(), input.getSize());
+    }
     json["inputs"].append(json_input);
   }
 
-  // TODO(varunsh): omitting outputs for now
+  const auto &outputs = request.getOutputs();
+  if (!outputs.empty()) {
+    json["outputs"] = Json::arrayValue;
+  }
+  for (const auto &output : outputs) {
+    Json::Value json_output;
+    json_output["name"] = output.getName();
+    json_output["parameters"] = mapParametersToJson(output.getParameters());
+    json["outputs"].append(json_output);
+  }
 
   return json;
 }
@@ -25,12 +25,13 @@
 #include <drogon/HttpResponse.h>  // for HttpResponsePtr
 #include <json/value.h>           // for Value
 
-#include <cstddef>     // for size_t
-#include <exception>   // for invalid_argument
-#include <functional>  // for function
-#include <memory>      // for shared_ptr
-#include <string>      // for string
-#include <vector>      // for vector
+#include <cstddef>      // for size_t
+#include <exception>    // for invalid_argument
+#include <functional>   // for function
+#include <memory>       // for shared_ptr
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
 
 #include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_TRA...
 #include "amdinfer/core/data_types.hpp"      // for fp16
@@ -41,6 +42,16 @@
 
 namespace amdinfer {
 
+/// HTTP header holding the size of the JSON header in a binary tensor body
+constexpr auto kInferenceHeaderContentLength =
+  "Inference-Header-Content-Length";
+/// Tensor parameter holding the number of raw bytes of its data in the body
+constexpr auto kBinaryDataSize = "binary_data_size";
+/// Tensor parameter requesting that its data be sent as raw bytes
+constexpr auto kBinaryData = "binary_data";
+/// Request parameter requesting that all outputs be sent as raw bytes
+constexpr auto kBinaryDataOutput = "binary_data_output";
+
 /**
  * @brief Convert JSON-styled parameters to our objects
  *
@@ -50,8 +61,52 @@ namespace amdinfer {
 ParameterMap mapJsonToParameters(Json::Value json);
 Json::Value mapParametersToJson(const ParameterMap &parameters);
 
-InferenceResponse mapJsonToResponse(Json::Value *json);
-Json::Value mapRequestToJson(const InferenceRequest &request);
+/// Checks if a boolean parameter is present and set to true
+bool isParameterTrue(const ParameterMap &parameters, const std::string &key);
+
+/**
+ * @brief Parse the value of the Inference-Header-Content-Length header
+ *
+ * @param header_length value of the header
+ * @param body_size size of the full body of the HTTP message
+ * @return size_t size of the JSON header at the start of the body
+ */
+size_t parseHeaderLength(const std::string &header_length, size_t body_size);
+
+/**
+ * @brief Parse a body that uses the binary tensor data extension. The first
+ * header_length bytes of the body are JSON and the rest are raw tensor data.
+ *
+ * @param body the full body of the HTTP message
+ * @param header_length value of the Inference-Header-Content-Length header
+ * @param binary [out] set to the raw tensor data following the JSON header
+ * @return std::shared_ptr<Json::Value>
+ */
+std::shared_ptr<Json::Value> parseBinaryBody(std::string_view body,
+                                             const std::string &header_length,
+                                             std::string_view *binary);
+
+/**
+ * @brief Convert a JSON response to our object. Outputs that have the
+ * binary_data_size parameter take their data from the binary section instead
+ *
+ * @param json the JSON response
+ * @param binary raw tensor data following the JSON header, if any
+ * @return InferenceResponse
+ */
+InferenceResponse mapJsonToResponse(Json::Value *json,
+                                    std::string_view binary = {});
+/**
+ * @brief Convert a request to JSON. If binary is not null, inputs that have
+ * the binary_data parameter set are appended to it as raw bytes instead of
+ * being added to the JSON
+ *
+ * @param request the request to convert
+ * @param binary [out] raw tensor data to send after the JSON header
+ * @return Json::Value
+ */
+Json::Value mapRequestToJson(const InferenceRequest &request,
+                             std::string *binary = nullptr);
 
 #ifdef AMDINFER_ENABLE_TRACING
 void propagate(drogon::HttpResponse *resp, const StringMap &context);
@@ -77,6 +132,8 @@ struct SetInputData {
           return data_ptr[index];
         } else if constexpr (util::is_any_v<T, fp16>) {
           return half_float::half_cast<float>(data_ptr[index]);
+        } else if constexpr (std::is_same_v<T, bf16>) {
+          return static_cast<float>(data_ptr[index]);
         } else {
           static_assert(!sizeof(T), "Invalid type to SetInputData");
         }
@@ -101,7 +158,7 @@ constexpr auto jsonValueToType(const Json::Value &datum) {
     return datum.asInt();
   } else if constexpr (std::is_same_v<T, int64_t>) {
     return datum.asInt64();
-  } else if constexpr (util::is_any_v<T, fp16, float>) {
+  } else if constexpr (util::is_any_v<T, fp16, bf16, float>) {
     return datum.asFloat();
   } else if constexpr (std::is_same_v<T, double>) {
     return datum.asDouble();
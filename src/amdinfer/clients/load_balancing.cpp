@@ -0,0 +1,572 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the client that spreads requests over many servers
+ */
+
+#include "amdinfer/clients/load_balancing.hpp"
+
+#include <algorithm>           // for nth_element, min
+#include <atomic>              // for atomic
+#include <condition_variable>  // for condition_variable
+#include <exception>           // for exception_ptr, current_exception
+#include <future>              // for promise, future_status
+#include <limits>              // for numeric_limits
+#include <list>                // for list
+#include <mutex>               // for mutex, lock_guard, unique_lock
+#include <random>              // for minstd_rand, random_device
+#include <set>                 // for set
+#include <thread>              // for thread
+#include <tuple>               // for ignore
+#include <utility>             // for pair, move
+
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+
+namespace amdinfer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Key = std::pair<std::string, std::string>;
+using KeySet = std::set<Key>;
+
+constexpr auto kNone = std::numeric_limits<size_t>::max();
+
+struct Backend {
+  const Client* client = nullptr;
+  std::atomic<int> in_flight{0};
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> failures{0};
+  std::atomic<bool> healthy{true};
+  // the models that weren't ready at the last check. Only accessed with
+  // std::atomic_load and std::atomic_store
+  std::shared_ptr<const KeySet> unready = std::make_shared<const KeySet>();
+};
+
+/// An inference request sent to one backend
+struct Attempt {
+  size_t backend;
+  InferenceResponseFuture future;
+  Clock::time_point start;
+};
+
+/// An inference request made to this client
+struct Call {
+  Key key;
+  InferenceRequest request;
+  std::promise<InferenceResponse> promise;
+  std::vector<Attempt> attempts;
+  Clock::time_point hedge_at = Clock::time_point::max();
+  bool answered = false;
+  bool retried = false;
+};
+
+}  // namespace
+
+class LoadBalancingClient::LoadBalancingClientImpl {
+ public:
+  LoadBalancingClientImpl(const std::vector<const Client*>& clients,
+                          const LoadBalancingOptions& options)
+    : options_(options), backends_(clients.size()), latencies_(kLatencies) {
+    if (clients.empty()) {
+      throw invalid_argument("At least one backend client is needed");
+    }
+    if (options_.hedge_percentile < 0 || options_.hedge_percentile >= 1) {
+      throw invalid_argument("The hedge percentile must be in [0, 1)");
+    }
+    for (auto i = 0U; i < clients.size(); ++i) {
+      backends_[i].client = clients[i];
+    }
+    monitor_ = std::thread{&LoadBalancingClientImpl::monitor, this};
+    checker_ = std::thread{&LoadBalancingClientImpl::check, this};
+  }
+
+  LoadBalancingClientImpl(LoadBalancingClientImpl const&) = delete;
+  LoadBalancingClientImpl& operator=(const LoadBalancingClientImpl&) = delete;
+  LoadBalancingClientImpl(LoadBalancingClientImpl&& other) = delete;
+  LoadBalancingClientImpl& operator=(LoadBalancingClientImpl&& other) = delete;
+  ~LoadBalancingClientImpl() {
+    {
+      const std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    monitor_.join();
+    checker_.join();
+  }
+
+  /**
+   * @brief Pick the less busy of two random backends that can serve requests
+   * to the model
+   *
+   * @param key the model and version, or nullptr for any request
+   * @param exclude a backend not to pick
+   * @param fallback pick unhealthy backends if there are no healthy ones
+   * @return index of the backend or kNone if there are none to pick
+   */
+  size_t pick(const Key* key, size_t exclude, bool fallback) const {
+    thread_local std::minstd_rand engine{std::random_device{}()};
+
+    std::vector<size_t> candidates;
+    candidates.reserve(backends_.size());
+    for (auto i = 0U; i < backends_.size(); ++i) {
+      if (i != exclude && usable(backends_[i], key)) {
+        candidates.push_back(i);
+      }
+    }
+    if (candidates.empty() && fallback) {
+      for (auto i = 0U; i < backends_.size(); ++i) {
+        if (i != exclude) {
+          candidates.push_back(i);
+        }
+      }
+    }
+
+    if (candidates.size() < 2) {
+      return candidates.empty() ? kNone : candidates.front();
+    }
+    std::uniform_int_distribution<size_t> distribution{
+      0, candidates.size() - 1};
+    const auto first = distribution(engine);
+    // pick a second, different candidate
+    auto second = distribution(engine) % (candidates.size() - 1);
+    second += static_cast<size_t>(second >= first);
+    const auto& lhs = backends_[candidates[first]];
+    const auto& rhs = backends_[candidates[second]];
+    return lhs.in_flight.load(std::memory_order_relaxed) <=
+               rhs.in_flight.load(std::memory_order_relaxed)
+             ? candidates[first]
+             : candidates[second];
+  }
+
+  /**
+   * @brief Run a function with a healthy backend, trying the other backends if
+   * it throws
+   *
+   * @param f function that takes a client
+   * @return the result of the function
+   */
+  template <typename F>
+  auto any(F f) const {
+    const auto first = pick(nullptr, kNone, true);
+    std::exception_ptr error;
+    for (auto i = 0U; i < backends_.size(); ++i) {
+      const auto index = (first + i) % backends_.size();
+      auto& backend = backends_[index];
+      try {
+        return f(backend.client);
+      } catch (const std::exception&) {
+        backend.healthy.store(false);
+        error = std::current_exception();
+      }
+    }
+    std::rethrow_exception(error);
+  }
+
+  /// Run a function with every backend
+  template <typename F>
+  void all(F f) const {
+    for (const auto& backend : backends_) {
+      f(backend.client);
+    }
+  }
+
+  InferenceResponseFuture infer(const std::string& model,
+                                const InferenceRequest& request,
+                                const std::string& version) {
+    auto call = std::make_unique<Call>();
+    call->key = {model, version};
+    call->request = request;
+    auto future = call->promise.get_future();
+    this->watch(call->key);
+
+    auto backend = pick(&call->key, kNone, true);
+    if (auto error = send(call.get(), backend)) {
+      call->retried = true;
+      backend = pick(&call->key, backend, true);
+      if (backend != kNone) {
+        error = send(call.get(), backend);
+      }
+      if (error) {
+        call->promise.set_exception(error);
+        return future;
+      }
+    }
+
+    const auto threshold = hedge_threshold_.load(std::memory_order_relaxed);
+    if (threshold > 0) {
+      call->hedge_at =
+        call->attempts.front().start + std::chrono::nanoseconds(threshold);
+    }
+    {
+      const std::lock_guard lock{mutex_};
+      incoming_.push_back(std::move(call));
+    }
+    ready_.notify_all();
+    return future;
+  }
+
+  std::vector<BackendStats> stats() const {
+    std::vector<BackendStats> stats;
+    stats.reserve(backends_.size());
+    for (const auto& backend : backends_) {
+      auto& stat = stats.emplace_back();
+      stat.in_flight = backend.in_flight.load(std::memory_order_relaxed);
+      stat.requests = backend.requests.load(std::memory_order_relaxed);
+      stat.failures = backend.failures.load(std::memory_order_relaxed);
+      stat.healthy = backend.healthy.load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+ private:
+  static constexpr size_t kLatencies = 512;
+  // recompute the hedging threshold after this many new latencies
+  static constexpr size_t kLatencyUpdate = 32;
+
+  static bool usable(const Backend& backend, const Key* key) {
+    if (!backend.healthy.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    return key == nullptr || std::atomic_load(&backend.unready)->count(*key) == 0;
+  }
+
+  /// Add the model to the set checked for readiness
+  void watch(const Key& key) {
+    const std::lock_guard lock{watched_mutex_};
+    if (watched_.count(key) == 0) {
+      watched_.insert(key);
+    }
+  }
+
+  /**
+   * @brief Send the call's request to a backend. If it fails, the backend is
+   * marked as unhealthy
+   *
+   * @return the exception if the request couldn't be sent, otherwise nullptr
+   */
+  std::exception_ptr send(Call* call, size_t index) {
+    auto& backend = backends_[index];
+    backend.in_flight.fetch_add(1);
+    try {
+      const auto& [model, version] = call->key;
+      auto future =
+        backend.client->modelInferAsync(model, call->request, version);
+      call->attempts.push_back({index, std::move(future), Clock::now()});
+      return nullptr;
+    } catch (const std::exception&) {
+      finish(&backend, false);
+      return std::current_exception();
+    }
+  }
+
+  static void finish(Backend* backend, bool ok) {
+    backend->in_flight.fetch_sub(1);
+    backend->requests.fetch_add(1, std::memory_order_relaxed);
+    if (!ok) {
+      backend->failures.fetch_add(1, std::memory_order_relaxed);
+      backend->healthy.store(false);
+    }
+  }
+
+  /// Record a latency and update the threshold for hedging
+  void record(Clock::duration latency) {
+    if (options_.hedge_percentile == 0) {
+      return;
+    }
+    latencies_[recorded_ % kLatencies] =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    ++recorded_;
+    if (recorded_ < options_.hedge_min_samples ||
+        (recorded_ != options_.hedge_min_samples &&
+         recorded_ % kLatencyUpdate != 0)) {
+      return;
+    }
+
+    auto sorted = latencies_;
+    sorted.resize(std::min(recorded_, kLatencies));
+    const auto nth =
+      static_cast<size_t>(options_.hedge_percentile * (sorted.size() - 1));
+    std::nth_element(sorted.begin(), sorted.begin() + nth, sorted.end());
+    hedge_threshold_.store(sorted[nth], std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Check the attempts of a call for responses, retrying or hedging it
+   * if needed
+   *
+   * @return true if the call is done and every attempt has finished
+   */
+  bool poll(Call* call, Clock::time_point now) {
+    auto& attempts = call->attempts;
+    for (auto it = attempts.begin(); it != attempts.end();) {
+      if (it->future.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+        ++it;
+        continue;
+      }
+
+      auto& backend = backends_[it->backend];
+      try {
+        auto response = it->future.get();
+        finish(&backend, true);
+        record(now - it->start);
+        if (!call->answered) {
+          call->answered = true;
+          call->promise.set_value(std::move(response));
+        }
+        it = attempts.erase(it);
+      } catch (const std::exception&) {
+        finish(&backend, false);
+        const auto failed = it->backend;
+        it = attempts.erase(it);
+        if (call->answered || !attempts.empty()) {
+          continue;
+        }
+        auto error = std::current_exception();
+        if (!call->retried) {
+          call->retried = true;
+          const auto index = pick(&call->key, failed, true);
+          if (index != kNone && send(call, index) == nullptr) {
+            // restart the loop to keep the iterator valid
+            return false;
+          }
+        }
+        call->answered = true;
+        call->promise.set_exception(error);
+      }
+    }
+
+    if (!call->answered && now >= call->hedge_at) {
+      call->hedge_at = Clock::time_point::max();
+      const auto index = pick(&call->key, attempts.front().backend, false);
+      if (index != kNone) {
+        // if the hedge can't be sent, the first attempt is still in flight
+        std::ignore = send(call, index);
+      }
+    }
+    return attempts.empty();
+  }
+
+  /// Wait for the responses to the requests in flight
+  void monitor() {
+    std::list<std::unique_ptr<Call>> calls;
+    while (true) {
+      {
+        std::unique_lock lock{mutex_};
+        const auto has_work = [this]() {
+          return !incoming_.empty() || stopping_;
+        };
+        if (calls.empty()) {
+          ready_.wait(lock, has_work);
+        } else {
+          ready_.wait_for(lock, options_.poll_interval, has_work);
+        }
+        calls.splice(calls.end(), incoming_);
+        if (stopping_ && calls.empty()) {
+          return;
+        }
+      }
+
+      const auto now = Clock::now();
+      for (auto it = calls.begin(); it != calls.end();) {
+        if (poll(it->get(), now)) {
+          it = calls.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+  /// Periodically check which backends and models are ready
+  void check() {
+    std::unique_lock lock{mutex_};
+    while (!ready_.wait_for(lock, options_.health_interval,
+                            [this]() { return stopping_; })) {
+      lock.unlock();
+
+      KeySet watched;
+      {
+        const std::lock_guard watched_lock{watched_mutex_};
+        watched = watched_;
+      }
+      for (auto& backend : backends_) {
+        const auto ready = [&](const auto& f) {
+          try {
+            return f();
+          } catch (const std::exception&) {
+            return false;
+          }
+        };
+
+        const auto healthy =
+          ready([&]() { return backend.client->serverReady(); });
+        auto unready = std::make_shared<KeySet>();
+        if (healthy) {
+          for (const auto& key : watched) {
+            if (!ready([&]() {
+                  return backend.client->modelReady(key.first, key.second);
+                })) {
+              unready->insert(key);
+            }
+          }
+        }
+        std::atomic_store(&backend.unready,
+                          std::shared_ptr<const KeySet>(std::move(unready)));
+        backend.healthy.store(healthy);
+      }
+
+      lock.lock();
+    }
+  }
+
+  LoadBalancingOptions options_;
+  mutable std::vector<Backend> backends_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::list<std::unique_ptr<Call>> incoming_;
+  bool stopping_ = false;
+
+  std::mutex watched_mutex_;
+  KeySet watched_;
+
+  // only used by the monitor thread
+  std::vector<int64_t> latencies_;
+  size_t recorded_ = 0;
+  std::atomic<int64_t> hedge_threshold_{0};
+
+  std::thread monitor_;
+  std::thread checker_;
+};
+
+LoadBalancingClient::LoadBalancingClient(
+  const std::vector<const Client*>& backends,
+  const LoadBalancingOptions& options)
+  : impl_(std::make_unique<LoadBalancingClientImpl>(backends, options)) {}
+
+LoadBalancingClient::~LoadBalancingClient() = default;
+
+ServerMetadata LoadBalancingClient::serverMetadata() const {
+  return impl_->any([](const Client* client) {
+    return client->serverMetadata();
+  });
+}
+
+bool LoadBalancingClient::serverLive() const {
+  auto live = false;
+  impl_->all([&](const Client* client) {
+    try {
+      live = live || client->serverLive();
+    } catch (const std::exception&) {
+    }
+  });
+  return live;
+}
+
+bool LoadBalancingClient::serverReady() const {
+  auto ready = false;
+  impl_->all([&](const Client* client) {
+    try {
+      ready = ready || client->serverReady();
+    } catch (const std::exception&) {
+    }
+  });
+  return ready;
+}
+
+std::vector<std::string> LoadBalancingClient::modelList() const {
+  return impl_->any([](const Client* client) { return client->modelList(); });
+}
+
+std::string LoadBalancingClient::workerLoad(
+  const std::string& worker, const ParameterMap& parameters) const {
+  std::string endpoint;
+  impl_->all([&](const Client* client) {
+    auto loaded = client->workerLoad(worker, parameters);
+    if (endpoint.empty()) {
+      endpoint = std::move(loaded);
+    }
+  });
+  return endpoint;
+}
+
+void LoadBalancingClient::workerUnload(const std::string& worker) const {
+  impl_->all([&](const Client* client) { client->workerUnload(worker); });
+}
+
+bool LoadBalancingClient::hasHardware(const std::string& name, int num) const {
+  auto found = true;
+  impl_->all([&](const Client* client) {
+    found = found && client->hasHardware(name, num);
+  });
+  return found;
+}
+
+std::vector<BackendStats> LoadBalancingClient::backendStats() const {
+  return impl_->stats();
+}
+
+bool LoadBalancingClient::modelReadyImpl(const std::string& model,
+                                         const std::string& version) const {
+  auto ready = false;
+  impl_->all([&](const Client* client) {
+    try {
+      ready = ready || client->modelReady(model, version);
+    } catch (const std::exception&) {
+    }
+  });
+  return ready;
+}
+
+ModelMetadata LoadBalancingClient::modelMetadataImpl(
+  const std::string& model, const std::string& version) const {
+  return impl_->any([&](const Client* client) {
+    return client->modelMetadata(model, version);
+  });
+}
+
+void LoadBalancingClient::modelLoadImpl(const std::string& model,
+                                        const ParameterMap& parameters,
+                                        const std::string& version) const {
+  impl_->all([&](const Client* client) {
+    client->modelLoad(model, parameters, version);
+  });
+}
+
+void LoadBalancingClient::modelUnloadImpl(const std::string& model,
+                                          const std::string& version) const {
+  impl_->all(
+    [&](const Client* client) { client->modelUnload(model, version); });
+}
+
+InferenceResponse LoadBalancingClient::modelInferImpl(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  return impl_->infer(model, request, version).get();
+}
+
+InferenceResponseFuture LoadBalancingClient::modelInferAsyncImpl(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  return impl_->infer(model, request, version);
+}
+
+}  // namespace amdinfer
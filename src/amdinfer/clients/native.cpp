@@ -32,6 +32,7 @@
 #include "amdinfer/core/exceptions.hpp"          // for invalid_argument
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
 #include "amdinfer/core/parameters.hpp"          // for ParameterMap
 #include "amdinfer/core/request_container.hpp"   // for RequestContainer
 #include "amdinfer/core/shared_state.hpp"        // for SharedState
@@ -58,7 +59,7 @@ ServerMetadata NativeClient::serverMetadata() const {
   return SharedState::serverMetadata();
 }
 bool NativeClient::serverLive() const { return true; }
-bool NativeClient::serverReady() const { return true; }
+bool NativeClient::serverReady() const { return impl_->state->serverReady(); }
 
 ModelMetadata NativeClient::modelMetadataImpl(
   const std::string& model, const std::string& version) const {
@@ -95,38 +96,69 @@ InferenceRequestPtr getRequest(const InferenceRequest& req,
   return request;
 }
 
+/**
+ * @brief Make a request whose inputs are the caller's memory, borrowed by the
+ * pool so it's released as usual once the request is done with it
+ */
+InferenceRequestPtr borrowRequest(const InferenceRequest& req,
+                                  const MemoryPool* pool) {
+  auto request = std::make_shared<InferenceRequest>(req);
+  for (const auto& input : request->getInputs()) {
+    pool->borrow(input.getData());
+  }
+  return request;
+}
+
+/// End the loans of a borrowed request's inputs if it couldn't be made
+void returnRequest(const InferenceRequest& request, const MemoryPool* pool) {
+  for (const auto& input : request.getInputs()) {
+    pool->put(MemoryAllocators::Cpu, input.getData());
+  }
+}
+
 InferenceResponseFuture setCallback(InferenceRequest* request) {
   auto promise = std::make_shared<std::promise<amdinfer::InferenceResponse>>();
   auto future = promise->get_future();
   Callback callback = [promise](const InferenceResponse& response) {
-    promise->set_value(response);
+    if (response.isFinal()) {
+      promise->set_value(response);
+    }
   };
   request->setCallback(std::move(callback));
   return future;
 }
 
-InferenceResponseFuture NativeClient::modelInferAsyncImpl(
-  const std::string& model, const InferenceRequest& request,
-  const std::string& version) const {
+void enqueue(SharedState* state, const std::string& model,
+             InferenceRequestPtr request, const std::string& version) {
 #ifdef AMDINFER_ENABLE_METRICS
   Metrics::getInstance().incrementCounter(MetricCounterIDs::CppNative);
 #endif
 
 #ifdef AMDINFER_ENABLE_TRACING
   auto trace = startTrace(&(__func__[0]));
-  trace->startSpan("C++ enqueue");
+  if (trace != nullptr) {
+    trace->startSpan("C++ enqueue");
+  }
 #endif
-  auto new_request = getRequest(request, impl_->state->getPool());
-  auto future = setCallback(new_request.get());
-  auto request_container = std::make_unique<RequestContainer>();
-  request_container->request = std::move(new_request);
+  auto request_container = makeRequestContainer();
+  request_container->request = std::move(request);
 
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->endSpan();
+  if (trace != nullptr) {
+    trace->endSpan();
+  }
   request_container->trace = std::move(trace);
 #endif
-  impl_->state->modelInfer(model, std::move(request_container), version);
+  state->modelInfer(model, std::move(request_container), version);
+}
 
+InferenceResponseFuture NativeClient::modelInferAsyncImpl(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  auto* state = impl_->state;
+  auto new_request = getRequest(request, state->getPool());
+  auto future = setCallback(new_request.get());
+  enqueue(state, model, std::move(new_request), version);
   return future;
 }
 
@@ -137,6 +169,48 @@ InferenceResponse NativeClient::modelInferImpl(
   return future.get();
 }
 
+InferenceResponseFuture NativeClient::modelInferAsyncBorrowed(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  auto* state = impl_->state;
+  auto new_request = borrowRequest(request, state->getPool());
+  auto future = setCallback(new_request.get());
+  try {
+    enqueue(state, model, std::move(new_request), version);
+  } catch (const runtime_error&) {
+    returnRequest(request, state->getPool());
+    throw;
+  }
+  return future;
+}
+
+void NativeClient::modelInferAsyncBorrowed(const std::string& model,
+                                           const InferenceRequest& request,
+                                           Callback callback,
+                                           const std::string& version) const {
+  auto* state = impl_->state;
+  auto new_request = borrowRequest(request, state->getPool());
+  new_request->setCallback([callback = std::move(callback)](
+                             const InferenceResponse& response) mutable {
+    if (response.isFinal()) {
+      callback(response);
+    }
+  });
+  try {
+    enqueue(state, model, std::move(new_request), version);
+  } catch (const runtime_error&) {
+    returnRequest(request, state->getPool());
+    throw;
+  }
+}
+
+InferenceResponse NativeClient::modelInferBorrowed(
+  const std::string& model, const InferenceRequest& request,
+  const std::string& version) const {
+  auto future = modelInferAsyncBorrowed(model, request, version);
+  return future.get();
+}
+
 void NativeClient::modelUnloadImpl(const std::string& model,
                                    const std::string& version) const {
   auto model_lower = util::toLower(model);
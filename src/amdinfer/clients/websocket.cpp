@@ -26,19 +26,31 @@
 #include <drogon/HttpTypes.h>                         // for WebSocketMessag...
 #include <drogon/WebSocketClient.h>                   // for WebSocketClientPtr
 #include <drogon/WebSocketConnection.h>               // for WebSocketConnec...
+#include <json/reader.h>                              // for CharReader
 #include <json/value.h>                               // for Value
 #include <json/writer.h>                              // for StreamWriterBui...
 #include <trantor/net/EventLoop.h>                    // for EventLoop
 #include <trantor/net/EventLoopThread.h>              // for EventLoopThread
 
-#include <cassert>  // for assert
-#include <chrono>   // for milliseconds
-#include <thread>   // for sleep_for
+#include <cassert>        // for assert
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint8_t
+#include <future>         // for promise
+#include <memory>         // for unique_ptr, shared_ptr
+#include <mutex>          // for mutex, lock_guard
+#include <string>         // for string
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
 
 #include "amdinfer/clients/http.hpp"             // for HttpClient
 #include "amdinfer/clients/http_internal.hpp"    // for mapRequestToJson
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/stream_frame.hpp"        // for StreamFrame
+#include "amdinfer/util/base64.hpp"              // for base64Decode
 
 namespace amdinfer {
 
@@ -57,26 +69,17 @@ class WebSocketClient::WebSocketClientImpl {
       [&](const std::string& message, const drogon::WebSocketClientPtr& client,
           const drogon::WebSocketMessageType& type) {
         (void)client;
-        std::string message_type = "Unknown";
         switch (type) {
+          case WebSocketMessageType::Binary: {
+            if (!dispatch(message, true)) {
+              queue_.enqueue({message, true});
+            }
+            break;
+          }
           case WebSocketMessageType::Text: {
-            // Json::CharReaderBuilder builder;
-            // Json::CharReader* reader = builder.newCharReader();
-
-            // Json::Value root;
-            // std::string errors;
-
-            // bool parsingSuccessful =
-            //   reader->parse(message.c_str(), message.c_str() +
-            //   message.size(),
-            //                 &root, &errors);
-            // delete reader;
-            // if (!parsingSuccessful) {
-            //   throw std::runtime_error("Unsuccessful?");
-            // }
-            // auto json_ptr = std::make_shared<Json::Value>(std::move(root));
-            // queue_.enqueue(mapJsonToResponse(json_ptr));
-            queue_.enqueue(message);
+            if (!dispatch(message, false)) {
+              queue_.enqueue({message, false});
+            }
             break;
           }
           case WebSocketMessageType::Close: {
@@ -111,39 +114,148 @@ class WebSocketClient::WebSocketClientImpl {
   WebSocketClientImpl& operator=(WebSocketClientImpl&& other) = delete;
 
   void connect() {
+    const std::lock_guard lock{connect_mutex_};
     auto connection = ws_client_->getConnection();
-    if (connection == nullptr || connection->disconnected()) {
-      auto req = drogon::HttpRequest::newHttpRequest();
-      req->setMethod(drogon::Get);
-      req->setPath("/models/infer");
-      ws_client_->connectToServer(
-        req, [](drogon::ReqResult r, const drogon::HttpResponsePtr& /*resp*/,
-                const drogon::WebSocketClientPtr& wsptr) {
-          if (r != drogon::ReqResult::Ok) {
-            wsptr->stop();
-          }
-        });
+    if (connection != nullptr && connection->connected()) {
+      return;
     }
-    while (connection == nullptr || connection->disconnected()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-      connection = ws_client_->getConnection();
+
+    auto req = drogon::HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    req->setPath("/models/infer");
+    // the connection is set before the callback runs so waiting on it is
+    // enough to know if it can be used
+    auto connected = std::make_shared<std::promise<bool>>();
+    auto future = connected->get_future();
+    ws_client_->connectToServer(
+      req, [connected](drogon::ReqResult r,
+                       const drogon::HttpResponsePtr& /*resp*/,
+                       const drogon::WebSocketClientPtr& wsptr) mutable {
+        if (r != drogon::ReqResult::Ok) {
+          wsptr->stop();
+        }
+        if (connected != nullptr) {
+          connected->set_value(r == drogon::ReqResult::Ok);
+          connected.reset();
+        }
+      });
+    if (!future.get()) {
+      throw connection_error("Failed to connect to the websocket server");
     }
   }
 
-  std::string recv() {
-    std::string response;
-    queue_.wait_dequeue(response);
-    return response;
+  /**
+   * @brief Register a callback for the messages sent in response to a request
+   *
+   * @param id the ID that the messages will have
+   * @param callback the callback
+   */
+  void addCallback(const std::string& id, WsCallback callback) {
+    const std::lock_guard lock{callbacks_mutex_};
+    const auto inserted = callbacks_.try_emplace(
+      id, std::make_shared<WsCallback>(std::move(callback)));
+    if (!inserted.second) {
+      throw invalid_argument("A request with the ID " + id +
+                             " is already waiting for responses");
+    }
+  }
+
+  void removeCallback(const std::string& id) {
+    const std::lock_guard lock{callbacks_mutex_};
+    callbacks_.erase(id);
+  }
+
+  /// A message from the server and whether it was sent as binary
+  struct Message {
+    std::string data;
+    bool binary = false;
+  };
+
+  Message recv() {
+    Message message;
+    queue_.wait_dequeue(message);
+    return message;
   }
 
   drogon::WebSocketClient* getWsClient() { return ws_client_.get(); }
   HttpClient* getHttpClient() { return http_client_.get(); }
 
  private:
+  /**
+   * @brief Pass a message to the callback registered for its request, if any.
+   * Messages are only parsed to find their request if there are callbacks
+   *
+   * @param message the message
+   * @param binary if the message was sent as binary
+   * @return bool - true if a callback took the message
+   */
+  bool dispatch(const std::string& message, bool binary) {
+    {
+      const std::lock_guard lock{callbacks_mutex_};
+      if (callbacks_.empty()) {
+        return false;
+      }
+    }
+
+    const auto id = binary ? getStreamKey(message) : getMessageId(message);
+    std::shared_ptr<WsCallback> callback;
+    {
+      const std::lock_guard lock{callbacks_mutex_};
+      auto iter = callbacks_.find(id);
+      if (iter == callbacks_.end()) {
+        return false;
+      }
+      callback = iter->second;
+    }
+
+    // the callback is run without the lock so it can make new requests
+    if ((*callback)(message, binary)) {
+      const std::lock_guard lock{callbacks_mutex_};
+      auto iter = callbacks_.find(id);
+      if (iter != callbacks_.end() && iter->second == callback) {
+        callbacks_.erase(iter);
+      }
+    }
+    return true;
+  }
+
+  /// Get the "id" of a JSON message or the "key" for messages from streams
+  static std::string getMessageId(const std::string& message) {
+    Json::Value json;
+    Json::CharReaderBuilder builder;
+    const std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+    const auto* data = message.data();
+    if (!reader->parse(data, data + message.size(), &json, nullptr) ||
+        !json.isObject()) {
+      return "";
+    }
+    if (json.isMember("id")) {
+      return json["id"].asString();
+    }
+    return json.get("key", "").asString();
+  }
+
+  /// Get the key from the header of a binary StreamFrame without parsing the
+  /// rest of the message
+  static std::string getStreamKey(std::string_view message) {
+    constexpr size_t kHeaderSize = 24;
+    constexpr size_t kKeyLengthOffset = 10;
+    if (message.size() < kHeaderSize || message.substr(0, 4) != "AMDF") {
+      return "";
+    }
+    const auto low = static_cast<uint8_t>(message[kKeyLengthOffset]);
+    const auto high = static_cast<uint8_t>(message[kKeyLengthOffset + 1]);
+    const size_t length = low | (high << 8U);
+    return std::string{message.substr(kHeaderSize, length)};
+  }
+
   trantor::EventLoopThread loop_;
   std::unique_ptr<HttpClient> http_client_;
   drogon::WebSocketClientPtr ws_client_;
-  moodycamel::BlockingConcurrentQueue<std::string> queue_;
+  moodycamel::BlockingConcurrentQueue<Message> queue_;
+  std::mutex connect_mutex_;
+  std::mutex callbacks_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<WsCallback>> callbacks_;
 };
 
 WebSocketClient::WebSocketClient(const std::string& ws_address,
@@ -256,6 +368,66 @@ void WebSocketClient::modelInferWs(const std::string& model,
   connection->send(message);
 }
 
-std::string WebSocketClient::modelRecv() const { return impl_->recv(); }
+void WebSocketClient::modelInferWs(const std::string& model,
+                                   const InferenceRequest& request,
+                                   WsCallback callback) const {
+  auto id = request.getID();
+  if (id.empty()) {
+    const auto& parameters = request.getParameters();
+    if (parameters.has("key")) {
+      id = parameters.get<std::string>("key");
+    } else {
+      throw invalid_argument(
+        "Requests with callbacks must have an ID or a key parameter");
+    }
+  }
+
+  // register the callback first so no responses are missed
+  impl_->addCallback(id, std::move(callback));
+  try {
+    modelInferWs(model, request);
+  } catch (...) {
+    impl_->removeCallback(id);
+    throw;
+  }
+}
+
+std::string WebSocketClient::modelRecv() const { return impl_->recv().data; }
+
+StreamFrame WebSocketClient::modelRecvFrame() const {
+  auto message = impl_->recv();
+  if (message.binary) {
+    return parseStreamFrame(message.data);
+  }
+
+  // convert the JSON text that streams send by default
+  Json::Value json;
+  std::string errors;
+  Json::CharReaderBuilder builder;
+  const std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+  const auto* data = message.data.data();
+  if (!reader->parse(data, data + message.data.size(), &json, &errors)) {
+    throw invalid_argument("Failed to parse the stream message: " + errors);
+  }
+
+  Json::StreamWriterBuilder writer;
+  writer["indentation"] = "";
+
+  StreamFrame frame;
+  frame.key = json["key"].asString();
+  const auto image = json["data"]["img"].asString();
+  const auto labels = Json::writeString(writer, json["data"]["labels"]);
+  constexpr std::string_view kPrefix{"data:image/jpg;base64,"};
+  if (image.compare(0, kPrefix.size(), kPrefix) == 0) {
+    frame.format = StreamFrameFormat::Jpeg;
+    frame.data = util::base64Decode(std::string_view{image}.substr(
+      kPrefix.size()));
+    frame.results = labels;
+  } else {
+    // the first message of a stream has the frame rate instead of an image
+    frame.results = R"({"fps": )" + image + R"(, "metadata": )" + labels + "}";
+  }
+  return frame;
+}
 
 }  // namespace amdinfer
@@ -0,0 +1,160 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the limits on the requests an endpoint takes at once
+ */
+
+#include "amdinfer/core/admission.hpp"
+
+#include <algorithm>    // for max
+#include <cstdint>      // for int32_t
+#include <string>       // for string, to_string
+#include <string_view>  // for string_view
+#include <utility>      // for move
+
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/declarations.hpp"             // for Callback
+
+namespace amdinfer {
+
+namespace {
+
+constexpr size_t kBytesPerMib = 1024 * 1024;
+
+size_t getLimit(const ParameterMap& parameters, std::string_view key) {
+  const auto value = parameters.get<int32_t>(key);
+  if (value < 0) {
+    throw invalid_argument(std::string{key} + " can't be negative");
+  }
+  return static_cast<size_t>(value);
+}
+
+/// Add to a count unless it would go over the limit. A limit of 0 is no limit
+bool tryAdd(std::atomic<size_t>* count, size_t value, size_t limit) {
+  auto current = count->load(std::memory_order_relaxed);
+  do {
+    if (limit != 0 && current + value > limit) {
+      return false;
+    }
+  } while (!count->compare_exchange_weak(current, current + value,
+                                         std::memory_order_relaxed));
+  return true;
+}
+
+}  // namespace
+
+/// Releases its request's share of the limits when it's destroyed
+class AdmissionControl::Ticket {
+ public:
+  Ticket(std::shared_ptr<AdmissionControl> control, size_t bytes)
+    : control_(std::move(control)), bytes_(bytes) {}
+  Ticket(Ticket const&) = delete;
+  Ticket& operator=(const Ticket&) = delete;
+  Ticket(Ticket&& other) = delete;
+  Ticket& operator=(Ticket&& other) = delete;
+  ~Ticket() { control_->release(bytes_); }
+
+ private:
+  std::shared_ptr<AdmissionControl> control_;
+  size_t bytes_;
+};
+
+AdmissionControl::AdmissionControl(const AdmissionOptions& options)
+  : options_(options) {}
+
+std::optional<AdmissionOptions> AdmissionControl::parse(
+  ParameterMap* parameters) {
+  if (!parameters->has("max_inflight") &&
+      !parameters->has("memory_quota_mib")) {
+    return std::nullopt;
+  }
+
+  AdmissionOptions options;
+  if (parameters->has("max_inflight")) {
+    options.max_inflight = getLimit(*parameters, "max_inflight");
+    parameters->erase("max_inflight");
+  }
+  if (parameters->has("memory_quota_mib")) {
+    options.memory_quota =
+      getLimit(*parameters, "memory_quota_mib") * kBytesPerMib;
+    parameters->erase("memory_quota_mib");
+  }
+  return options;
+}
+
+std::shared_ptr<void> AdmissionControl::admit(size_t bytes) {
+  if (!tryAdd(&inflight_, 1, options_.max_inflight)) {
+    throw resource_exhausted_error(
+      "Too many requests in flight, the limit is " +
+      std::to_string(options_.max_inflight));
+  }
+  if (!tryAdd(&bytes_, bytes, options_.memory_quota)) {
+    inflight_.fetch_sub(1, std::memory_order_relaxed);
+    throw resource_exhausted_error(
+      "Not enough memory for a request of " + std::to_string(bytes) +
+      " bytes, the quota is " + std::to_string(options_.memory_quota));
+  }
+  return std::make_shared<Ticket>(shared_from_this(), bytes);
+}
+
+size_t AdmissionControl::getInflight() const {
+  return inflight_.load(std::memory_order_relaxed);
+}
+
+size_t AdmissionControl::getBytes() const {
+  return bytes_.load(std::memory_order_relaxed);
+}
+
+double AdmissionControl::getLoad() const {
+  double load = 0;
+  if (options_.max_inflight != 0) {
+    load = static_cast<double>(this->getInflight()) /
+           static_cast<double>(options_.max_inflight);
+  }
+  if (options_.memory_quota != 0) {
+    load = std::max(load, static_cast<double>(this->getBytes()) /
+                            static_cast<double>(options_.memory_quota));
+  }
+  return load;
+}
+
+void AdmissionControl::release(size_t bytes) {
+  bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+  inflight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void holdTicket(InferenceRequest* request, std::shared_ptr<void> ticket) {
+  if (ticket == nullptr) {
+    return;
+  }
+  auto callback = request->getCallback();
+  if (callback == nullptr) {
+    return;
+  }
+  request->setCallback([ticket = std::move(ticket),
+                        callback = std::move(callback)](
+                         const InferenceResponse& response) mutable {
+    callback(response);
+    if (response.isFinal()) {
+      ticket.reset();
+    }
+  });
+}
+
+}  // namespace amdinfer
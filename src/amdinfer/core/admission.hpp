@@ -0,0 +1,98 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the limits on the requests an endpoint takes at once
+ */
+
+#ifndef GUARD_AMDINFER_CORE_ADMISSION
+#define GUARD_AMDINFER_CORE_ADMISSION
+
+#include <atomic>    // for atomic
+#include <cstddef>   // for size_t
+#include <memory>    // for shared_ptr, enable_shared_from_this
+#include <optional>  // for optional
+
+namespace amdinfer {
+
+class InferenceRequest;
+class ParameterMap;
+
+/// Limits on the requests that an endpoint has in flight at once
+struct AdmissionOptions {
+  /// Most requests in flight. 0 for no limit
+  size_t max_inflight = 0;
+  /// Most bytes of requests in flight. 0 for no limit
+  size_t memory_quota = 0;
+};
+
+/**
+ * @brief Counts the requests that an endpoint has in flight and the bytes they
+ * arrived with so that one client can't take all of the shared memory pool.
+ * Servers admit a request before they decode it or allocate its buffers and a
+ * request that doesn't fit is refused right away instead of being queued.
+ */
+class AdmissionControl
+  : public std::enable_shared_from_this<AdmissionControl> {
+ public:
+  /// Construct a new AdmissionControl object
+  explicit AdmissionControl(const AdmissionOptions& options);
+
+  /**
+   * @brief Get the admission options from the load-time parameters and remove
+   * them from the parameters. Admission control is enabled if the parameters
+   * have "max_inflight" or "memory_quota_mib".
+   *
+   * @param parameters the load-time parameters
+   * @return std::optional<AdmissionOptions> the options if it's enabled
+   */
+  static std::optional<AdmissionOptions> parse(ParameterMap* parameters);
+
+  /**
+   * @brief Admit a request. It stays in flight until the returned ticket is
+   * destroyed. Throws resource_exhausted_error if the request doesn't fit
+   *
+   * @param bytes size of the request as it arrived
+   * @return std::shared_ptr<void> the request's ticket
+   */
+  std::shared_ptr<void> admit(size_t bytes);
+
+  [[nodiscard]] size_t getInflight() const;
+  [[nodiscard]] size_t getBytes() const;
+  /// Get the largest fraction of a limit that's in flight, 1 if one is full
+  [[nodiscard]] double getLoad() const;
+
+ private:
+  class Ticket;
+
+  void release(size_t bytes);
+
+  const AdmissionOptions options_;
+  std::atomic<size_t> inflight_ = 0;
+  std::atomic<size_t> bytes_ = 0;
+};
+
+/**
+ * @brief Keep a request's ticket until its final response is sent or, if it
+ * never is, until the request is destroyed
+ *
+ * @param request the request
+ * @param ticket the ticket from AdmissionControl::admit. Null does nothing
+ */
+void holdTicket(InferenceRequest* request, std::shared_ptr<void> ticket);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_ADMISSION
@@ -0,0 +1,137 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the policy that scales the number of workers in a group
+ */
+
+#include "amdinfer/core/autoscaler.hpp"
+
+#include <cstdint>      // for int32_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <variant>      // for bad_variant_access
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/core/parameters.hpp"  // for ParameterMap
+
+namespace amdinfer {
+
+namespace {
+
+// removing a worker waits this many times longer than adding one
+constexpr size_t kScaleDownPatience = 4;
+
+size_t getCount(const ParameterMap& parameters, std::string_view key) {
+  const auto value = parameters.get<int32_t>(key);
+  if (value < 1) {
+    throw invalid_argument(std::string{key} + " must be at least 1");
+  }
+  return static_cast<size_t>(value);
+}
+
+// numbers from JSON may arrive as integers or doubles
+double getNumber(const ParameterMap& parameters, std::string_view key) {
+  try {
+    return parameters.get<double>(key);
+  } catch (const std::bad_variant_access&) {
+    return parameters.get<int32_t>(key);
+  }
+}
+
+}  // namespace
+
+Autoscaler::Autoscaler(const AutoscalerOptions& options) : options_(options) {}
+
+std::optional<AutoscalerOptions> Autoscaler::parse(ParameterMap* parameters) {
+  if (!parameters->has("min_workers") && !parameters->has("max_workers")) {
+    return std::nullopt;
+  }
+
+  AutoscalerOptions options;
+  if (parameters->has("min_workers")) {
+    options.min_workers = getCount(*parameters, "min_workers");
+  }
+  options.max_workers = options.min_workers;
+  if (parameters->has("max_workers")) {
+    options.max_workers = getCount(*parameters, "max_workers");
+  }
+  if (options.max_workers < options.min_workers) {
+    throw invalid_argument("max_workers can't be less than min_workers");
+  }
+  if (parameters->has("scale_up_depth")) {
+    options.scale_up_depth = getNumber(*parameters, "scale_up_depth");
+    if (options.scale_up_depth <= 0) {
+      throw invalid_argument("scale_up_depth must be positive");
+    }
+  }
+  if (parameters->has("scale_down_busy")) {
+    options.scale_down_busy = getNumber(*parameters, "scale_down_busy");
+  }
+  if (parameters->has("autoscale_patience")) {
+    options.patience = getCount(*parameters, "autoscale_patience");
+  }
+
+  for (const auto* key : {"min_workers", "max_workers", "scale_up_depth",
+                          "scale_down_busy", "autoscale_patience"}) {
+    parameters->erase(key);
+  }
+  return options;
+}
+
+int Autoscaler::update(double depth, double busy, size_t workers) {
+  // get back within the bounds right away, such as after a failed change
+  if (workers < options_.min_workers) {
+    up_samples_ = 0;
+    down_samples_ = 0;
+    return 1;
+  }
+  if (workers > options_.max_workers) {
+    up_samples_ = 0;
+    down_samples_ = 0;
+    return -1;
+  }
+
+  const auto per_worker = depth / static_cast<double>(workers);
+  if (per_worker >= options_.scale_up_depth &&
+      workers < options_.max_workers) {
+    down_samples_ = 0;
+    if (++up_samples_ >= options_.patience) {
+      up_samples_ = 0;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (depth <= 0 && workers > options_.min_workers) {
+    // the busy time of the removed worker moves to the remaining ones
+    const auto remaining = static_cast<double>(workers - 1);
+    const auto projected = busy * static_cast<double>(workers) / remaining;
+    if (projected < options_.scale_down_busy) {
+      up_samples_ = 0;
+      if (++down_samples_ >= kScaleDownPatience * options_.patience) {
+        down_samples_ = 0;
+        return -1;
+      }
+      return 0;
+    }
+  }
+
+  up_samples_ = 0;
+  down_samples_ = 0;
+  return 0;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,91 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the policy that scales the number of workers in a group
+ */
+
+#ifndef GUARD_AMDINFER_CORE_AUTOSCALER
+#define GUARD_AMDINFER_CORE_AUTOSCALER
+
+#include <cstddef>   // for size_t
+#include <optional>  // for optional
+
+namespace amdinfer {
+
+class ParameterMap;
+
+/// Options that bound and tune an Autoscaler
+struct AutoscalerOptions {
+  /// Fewest workers to keep in the group
+  size_t min_workers = 1;
+  /// Most workers to run in the group
+  size_t max_workers = 1;
+  /// Batches waiting per worker at which a worker is added
+  double scale_up_depth = 2.0;
+  /// Fraction of time the workers are busy below which one may be removed
+  double scale_down_busy = 0.5;
+  /// Consecutive samples that must agree before a worker is added
+  size_t patience = 3;
+};
+
+/**
+ * @brief Decides when to add or remove a worker from a group by sampling how
+ * many batches are waiting for it and how busy its workers are. A worker is
+ * added once the waiting batches per worker reach the scale-up depth for
+ * enough consecutive samples. A worker is removed once nothing is waiting and
+ * the remaining workers would stay under the scale-down busy fraction for four
+ * times as many samples, so short lulls don't shrink the group. The samples
+ * are counted again from zero after each change.
+ */
+class Autoscaler {
+ public:
+  /// Construct a new Autoscaler object
+  explicit Autoscaler(const AutoscalerOptions& options);
+
+  /**
+   * @brief Get the autoscaling options from the load-time parameters and
+   * remove them from the parameters. Autoscaling is enabled if the parameters
+   * have "min_workers" or "max_workers".
+   *
+   * @param parameters the load-time parameters
+   * @return std::optional<AutoscalerOptions> the options if it's enabled
+   */
+  static std::optional<AutoscalerOptions> parse(ParameterMap* parameters);
+
+  /**
+   * @brief Add a sample of the group's state and decide how to change it
+   *
+   * @param depth batches waiting for the group
+   * @param busy fraction of the time since the last sample that the workers
+   * were busy, which is 0 for workers that don't report it
+   * @param workers number of workers in the group
+   * @return int 1 to add a worker, -1 to remove one and 0 otherwise
+   */
+  int update(double depth, double busy, size_t workers);
+
+  [[nodiscard]] const AutoscalerOptions& getOptions() const {
+    return options_;
+  }
+
+ private:
+  AutoscalerOptions options_;
+  size_t up_samples_ = 0;
+  size_t down_samples_ = 0;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_AUTOSCALER
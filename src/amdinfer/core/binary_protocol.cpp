@@ -0,0 +1,238 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the binary inference protocol
+ */
+
+#include "amdinfer/core/binary_protocol.hpp"
+
+#include <cstddef>      // for byte
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t, int64_t
+#include <cstring>      // for memcpy
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/util/wire.hpp"        // for WireReader, writeInt
+
+namespace amdinfer {
+
+namespace {
+
+constexpr std::string_view kMagic{"AMDB"};
+constexpr uint8_t kVersion = 1;
+
+void writePrefix(BinaryMessageKind kind, uint64_t data_size,
+                 std::string* message) {
+  const auto header_size = message->size() - kBinaryPrefixSize;
+  message->replace(0, kMagic.size(), kMagic);
+  std::string prefix;
+  util::writeInt(kVersion, &prefix);
+  util::writeInt(static_cast<uint8_t>(kind), &prefix);
+  util::writeInt(uint16_t{0}, &prefix);
+  util::writeInt(static_cast<uint32_t>(header_size), &prefix);
+  util::writeInt(data_size, &prefix);
+  message->replace(kMagic.size(), prefix.size(), prefix);
+}
+
+template <typename Tensor>
+void writeShape(const Tensor& tensor, std::string* out) {
+  util::writeString(tensor.getName(), out);
+  util::writeInt(static_cast<uint8_t>(tensor.getDatatype()), out);
+  const auto& shape = tensor.getShape();
+  util::writeInt(static_cast<uint32_t>(shape.size()), out);
+  for (const auto& dim : shape) {
+    util::writeInt(static_cast<uint64_t>(dim), out);
+  }
+}
+
+template <typename Tensor>
+void readShape(util::WireReader* reader, Tensor* tensor) {
+  tensor->setName(reader->readString());
+  tensor->setDatatype(
+    DataType{static_cast<DataType::Value>(reader->readInt<uint8_t>())});
+  const auto rank = reader->readInt<uint32_t>();
+  std::vector<int64_t> shape;
+  shape.reserve(rank);
+  for (auto i = 0U; i < rank; ++i) {
+    shape.push_back(static_cast<int64_t>(reader->readInt<uint64_t>()));
+  }
+  tensor->setShape(shape);
+}
+
+size_t dataSize(const InferenceTensor& tensor) {
+  return tensor.getSize() * tensor.getDatatype().size();
+}
+
+}  // namespace
+
+BinaryPrefix parseBinaryPrefix(std::string_view bytes) {
+  if (bytes.size() < kBinaryPrefixSize ||
+      bytes.substr(0, kMagic.size()) != kMagic) {
+    throw invalid_argument("The message is not in the binary protocol");
+  }
+  util::WireReader reader{bytes.substr(kMagic.size(), kBinaryPrefixSize),
+                          "message"};
+  const auto version = reader.readInt<uint8_t>();
+  if (version != kVersion) {
+    throw invalid_argument("Unsupported binary protocol version " +
+                           std::to_string(version));
+  }
+  BinaryPrefix prefix;
+  const auto kind = reader.readInt<uint8_t>();
+  if (kind > static_cast<uint8_t>(BinaryMessageKind::Response)) {
+    throw invalid_argument("Unknown kind of binary message");
+  }
+  prefix.kind = static_cast<BinaryMessageKind>(kind);
+  reader.readInt<uint16_t>();
+  prefix.header_size = reader.readInt<uint32_t>();
+  prefix.data_size = reader.readInt<uint64_t>();
+  if (prefix.header_size > kMaxBinaryHeaderSize) {
+    throw invalid_argument("The header of the message is too large");
+  }
+  return prefix;
+}
+
+BinaryRequest parseBinaryRequestHeader(std::string_view header,
+                                       uint64_t data_size) {
+  util::WireReader reader{header, "request header"};
+  BinaryRequest parsed;
+  parsed.model = reader.readString();
+  parsed.version = reader.readString();
+  parsed.request.setID(reader.readString());
+  parsed.request.setParameters(reader.readParameters());
+
+  const auto input_count = reader.readInt<uint32_t>();
+  parsed.request.reserveTensors(input_count, 0);
+  uint64_t expected = 0;
+  for (auto i = 0U; i < input_count; ++i) {
+    InferenceRequestInput input;
+    readShape(&reader, &input);
+    input.setParameters(reader.readParameters());
+    expected += dataSize(input);
+    parsed.request.addInputTensor(std::move(input));
+  }
+  if (expected != data_size) {
+    throw invalid_argument(
+      "The size of the request's data doesn't match its inputs");
+  }
+
+  const auto output_count = reader.readInt<uint32_t>();
+  for (auto i = 0U; i < output_count; ++i) {
+    InferenceRequestOutput output;
+    output.setName(reader.readString());
+    parsed.request.addOutputTensor(std::move(output));
+  }
+  if (!reader.remaining().empty()) {
+    throw invalid_argument("The request header has trailing bytes");
+  }
+  return parsed;
+}
+
+std::string serializeBinaryRequest(const std::string& model,
+                                   const std::string& version,
+                                   const InferenceRequest& request) {
+  std::string message(kBinaryPrefixSize, '\0');
+  util::writeString(model, &message);
+  util::writeString(version, &message);
+  util::writeString(request.getID(), &message);
+  util::writeParameters(request.getParameters(), &message);
+
+  const auto& inputs = request.getInputs();
+  util::writeInt(static_cast<uint32_t>(inputs.size()), &message);
+  uint64_t data_size = 0;
+  for (const auto& input : inputs) {
+    writeShape(input, &message);
+    util::writeParameters(input.getParameters(), &message);
+    data_size += dataSize(input);
+  }
+
+  const auto& outputs = request.getOutputs();
+  util::writeInt(static_cast<uint32_t>(outputs.size()), &message);
+  for (const auto& output : outputs) {
+    util::writeString(output.getName(), &message);
+  }
+
+  writePrefix(BinaryMessageKind::Request, data_size, &message);
+  for (const auto& input : inputs) {
+    const auto size = dataSize(input);
+    const auto offset = message.size();
+    message.resize(offset + size);
+    if (size > 0) {
+      input.copyData(message.data() + offset);
+    }
+  }
+  return message;
+}
+
+std::string serializeBinaryResponseHeader(const InferenceResponse& response) {
+  std::string message(kBinaryPrefixSize, '\0');
+  util::writeString(response.getID(), &message);
+  util::writeString(response.getModel(), &message);
+  util::writeString(response.getError(), &message);
+  util::writeInt(static_cast<uint8_t>(response.isFinal()), &message);
+
+  const auto& outputs = response.getOutputs();
+  util::writeInt(static_cast<uint32_t>(outputs.size()), &message);
+  uint64_t data_size = 0;
+  for (const auto& output : outputs) {
+    writeShape(output, &message);
+    data_size += dataSize(output);
+  }
+
+  writePrefix(BinaryMessageKind::Response, data_size, &message);
+  return message;
+}
+
+InferenceResponse parseBinaryResponse(std::string_view message) {
+  const auto prefix = parseBinaryPrefix(message);
+  if (prefix.kind != BinaryMessageKind::Response) {
+    throw invalid_argument("The message is not a response");
+  }
+  util::WireReader reader{message.substr(kBinaryPrefixSize), "response"};
+  util::WireReader header{reader.take(prefix.header_size), "response header"};
+
+  auto id = header.readString();
+  auto model = header.readString();
+  auto error = header.readString();
+  InferenceResponse response =
+    error.empty() ? InferenceResponse{} : InferenceResponse{error};
+  response.setID(id);
+  response.setModel(model);
+  response.setFinal(header.readInt<uint8_t>() != 0);
+
+  const auto output_count = header.readInt<uint32_t>();
+  for (auto i = 0U; i < output_count; ++i) {
+    InferenceResponseOutput output;
+    readShape(&header, &output);
+    const auto data = reader.take(dataSize(output));
+    std::vector<std::byte> buffer(data.size());
+    if (!data.empty()) {
+      std::memcpy(buffer.data(), data.data(), data.size());
+    }
+    output.setData(std::move(buffer));
+    response.addOutput(std::move(output));
+  }
+  if (!reader.remaining().empty()) {
+    throw invalid_argument("The response has trailing bytes");
+  }
+  return response;
+}
+
+}  // namespace amdinfer
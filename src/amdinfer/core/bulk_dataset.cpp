@@ -0,0 +1,174 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Implements the datasets that bulk jobs read and the columns that they
+ * write their outputs to
+ */
+
+#include "amdinfer/core/bulk_dataset.hpp"
+
+#include <algorithm>  // for sort
+#include <array>      // for array
+#include <cstring>    // for memcpy
+#include <utility>    // for move
+
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+namespace {
+
+void writeOffset(std::ofstream& index, uint64_t offset) {
+  std::array<char, sizeof(offset)> bytes{};
+  for (auto& byte : bytes) {
+    byte = static_cast<char>(offset & 0xFF);
+    offset >>= 8;
+  }
+  index.write(bytes.data(), bytes.size());
+}
+
+}  // namespace
+
+BulkDataset::BulkDataset(const fs::path& path, size_t sample_bytes) {
+  if (!fs::exists(path)) {
+    throw file_not_found_error("Dataset " + path.string() + " does not exist");
+  }
+  if (fs::is_directory(path)) {
+    for (const auto& entry : fs::directory_iterator(path)) {
+      if (entry.is_regular_file()) {
+        files_.push_back(entry.path());
+      }
+    }
+    std::sort(files_.begin(), files_.end());
+    return;
+  }
+
+  if (sample_bytes == 0) {
+    throw invalid_argument("The samples of a tensor file can't be empty");
+  }
+  mapped_ = std::make_unique<util::MappedFile>(path);
+  if (mapped_->size() % sample_bytes != 0) {
+    throw invalid_argument("The size of " + path.string() +
+                           " isn't a multiple of the sample size, " +
+                           std::to_string(sample_bytes) + " bytes");
+  }
+  sample_bytes_ = sample_bytes;
+}
+
+size_t BulkDataset::size() const {
+  return this->images() ? files_.size() : mapped_->size() / sample_bytes_;
+}
+
+size_t BulkDataset::bytes(size_t index) const {
+  if (this->images()) {
+    return static_cast<size_t>(fs::file_size(files_.at(index)));
+  }
+  return sample_bytes_;
+}
+
+const std::byte* BulkDataset::data(size_t index) const {
+  if (this->images()) {
+    return nullptr;
+  }
+  return mapped_->data() + index * sample_bytes_;
+}
+
+void BulkDataset::read(size_t index, std::byte* data) const {
+  if (!this->images()) {
+    std::memcpy(data, this->data(index), sample_bytes_);
+    return;
+  }
+  const auto& path = files_.at(index);
+  std::ifstream file{path, std::ios::binary};
+  const auto size = static_cast<std::streamsize>(fs::file_size(path));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (!file.read(reinterpret_cast<char*>(data), size)) {
+    throw file_read_error("Could not read " + path.string());
+  }
+}
+
+BulkOutputWriter::BulkOutputWriter(fs::path directory)
+  : directory_(std::move(directory)) {
+  fs::create_directories(directory_);
+}
+
+BulkOutputWriter::Column& BulkOutputWriter::getColumn(
+  const std::string& name, DataType datatype,
+  const std::vector<int64_t>& shape) {
+  auto found = columns_.find(name);
+  if (found != columns_.end()) {
+    auto& description = found->second.description;
+    description.fixed = description.fixed && description.shape == shape &&
+                        description.datatype == datatype;
+    return found->second;
+  }
+
+  auto& column = columns_[name];
+  column.description = {name, datatype, shape, true};
+  const auto path = directory_ / name;
+  column.data.open(fs::path{path} += ".bin", std::ios::binary);
+  column.index.open(fs::path{path} += ".index", std::ios::binary);
+  if (!column.data || !column.index) {
+    throw runtime_error("Could not create the output " + path.string());
+  }
+  // the samples before the output first appeared are empty
+  for (size_t i = 0; i <= samples_; ++i) {
+    writeOffset(column.index, 0);
+  }
+  return column;
+}
+
+void BulkOutputWriter::write(const InferenceResponse& response) {
+  if (!response.isError()) {
+    for (const auto& output : response.getOutputs()) {
+      auto& column = this->getColumn(output.getName(), output.getDatatype(),
+                                     output.getShape());
+      const auto size = output.getSize() * output.getDatatype().size();
+      column.data.write(static_cast<const char*>(output.getData()),
+                        static_cast<std::streamsize>(size));
+      column.offset += size;
+    }
+  }
+  samples_++;
+  for (auto& [name, column] : columns_) {
+    writeOffset(column.index, column.offset);
+    if (!column.data || !column.index) {
+      throw runtime_error("Could not write the output " + name);
+    }
+  }
+}
+
+void BulkOutputWriter::flush() {
+  for (auto& [name, column] : columns_) {
+    column.data.flush();
+    column.index.flush();
+  }
+}
+
+std::vector<BulkColumn> BulkOutputWriter::getColumns() const {
+  std::vector<BulkColumn> columns;
+  columns.reserve(columns_.size());
+  for (const auto& [name, column] : columns_) {
+    columns.push_back(column.description);
+  }
+  return columns;
+}
+
+}  // namespace amdinfer
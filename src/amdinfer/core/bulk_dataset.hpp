@@ -0,0 +1,142 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Defines the datasets that bulk jobs read and the columns that they
+ * write their outputs to
+ */
+
+#ifndef GUARD_AMDINFER_CORE_BULK_DATASET
+#define GUARD_AMDINFER_CORE_BULK_DATASET
+
+#include <cstddef>     // for size_t, byte
+#include <cstdint>     // for int64_t, uint64_t
+#include <filesystem>  // for path
+#include <fstream>     // for ofstream
+#include <map>         // for map
+#include <memory>      // for unique_ptr
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+#include "amdinfer/util/filesystem.hpp"  // for MappedFile
+
+namespace amdinfer {
+
+class InferenceResponse;
+
+/**
+ * @brief The samples of a bulk job. A file is a tensor file: the raw data of
+ * fixed-size samples one after another, which is mapped into memory so the
+ * requests read from the page cache. A directory holds encoded images, such
+ * as JPEGs, with one sample per file in the order of their names.
+ */
+class BulkDataset {
+ public:
+  /**
+   * @brief Open a dataset
+   *
+   * @param path path to a tensor file or a directory of images
+   * @param sample_bytes the size of each sample in a tensor file. It's
+   * ignored for directories
+   * @throws file_not_found_error if the path doesn't exist
+   * @throws invalid_argument if a tensor file isn't a whole number of samples
+   */
+  BulkDataset(const std::filesystem::path& path, size_t sample_bytes);
+
+  /// Get the number of samples
+  [[nodiscard]] size_t size() const;
+  /// Check if the samples are encoded images
+  [[nodiscard]] bool images() const { return mapped_ == nullptr; }
+  /// Get the size of a sample in bytes
+  [[nodiscard]] size_t bytes(size_t index) const;
+  /// Get the data of a sample in a tensor file or nullptr for images
+  [[nodiscard]] const std::byte* data(size_t index) const;
+  /**
+   * @brief Read a sample into memory. Throws file_read_error if it can't be
+   * read
+   *
+   * @param index the index of the sample
+   * @param data memory to read the sample's bytes() into
+   */
+  void read(size_t index, std::byte* data) const;
+  /// Get the file names of the images in order
+  [[nodiscard]] const std::vector<std::filesystem::path>& getFiles() const {
+    return files_;
+  }
+
+ private:
+  std::unique_ptr<util::MappedFile> mapped_;
+  size_t sample_bytes_ = 0;
+  std::vector<std::filesystem::path> files_;
+};
+
+/// One output of a bulk job as written by BulkOutputWriter
+struct BulkColumn {
+  std::string name;
+  DataType datatype;
+  /// the shape of the output of each sample if they're all the same
+  std::vector<int64_t> shape;
+  bool fixed = true;
+};
+
+/**
+ * @brief Writes the outputs of a bulk job's samples in order as columns. Each
+ * output has a data file, <name>.bin, with its raw data for each sample one
+ * after another, and an index, <name>.index, of little-endian 64-bit byte
+ * offsets into the data where sample i spans offsets i and i + 1. Samples that
+ * failed or didn't have the output are empty. Outputs whose samples all have
+ * the same shape can also be read as tensor files.
+ */
+class BulkOutputWriter {
+ public:
+  /// Write to a directory, which is created if it doesn't exist
+  explicit BulkOutputWriter(std::filesystem::path directory);
+
+  /**
+   * @brief Write the outputs of the next sample
+   *
+   * @param response the sample's response. Errors are written as empty
+   * samples
+   * @throws runtime_error if the columns can't be written
+   */
+  void write(const InferenceResponse& response);
+  /// Flush the columns to their files
+  void flush();
+  /// Get the outputs written so far
+  [[nodiscard]] std::vector<BulkColumn> getColumns() const;
+  /// Get the number of samples written
+  [[nodiscard]] size_t size() const { return samples_; }
+
+ private:
+  struct Column {
+    BulkColumn description;
+    std::ofstream data;
+    std::ofstream index;
+    uint64_t offset = 0;
+  };
+
+  Column& getColumn(const std::string& name, DataType datatype,
+                    const std::vector<int64_t>& shape);
+
+  std::filesystem::path directory_;
+  std::map<std::string, Column> columns_;
+  size_t samples_ = 0;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_BULK_DATASET
@@ -0,0 +1,402 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Implements the offline jobs that run a dataset through a model in
+ * bulk
+ */
+
+#include "amdinfer/core/bulk_job.hpp"
+
+#include <json/value.h>   // for Value, arrayValue
+#include <json/writer.h>  // for StreamWriterBuilder, writeString
+
+#include <algorithm>           // for any_of
+#include <atomic>              // for atomic_bool
+#include <condition_variable>  // for condition_variable
+#include <fstream>             // for ofstream
+#include <thread>              // for thread
+#include <utility>             // for move
+
+#include "amdinfer/batching/batcher.hpp"         // for kPriorityLanes
+#include "amdinfer/buffers/buffer.hpp"           // for Buffer
+#include "amdinfer/core/bulk_dataset.hpp"        // for BulkDataset, BulkOut...
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/model_metadata.hpp"      // for ModelMetadata
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/request_container.hpp"   // for makeRequestContainer
+#include "amdinfer/core/shared_state.hpp"        // for SharedState
+#include "amdinfer/core/tensor.hpp"              // for Tensor
+#include "amdinfer/observation/logging.hpp"      // for Logger, AMDINFER_LOG...
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+std::string toString(BulkJobState state) {
+  switch (state) {
+    case BulkJobState::Running:
+      return "running";
+    case BulkJobState::Succeeded:
+      return "succeeded";
+    case BulkJobState::Failed:
+      return "failed";
+    default:
+      return "cancelled";
+  }
+}
+
+struct BulkJobs::Job {
+  using Clock = std::chrono::steady_clock;
+
+  std::string id;
+  BulkJobOptions options;
+  std::unique_ptr<BulkDataset> dataset;
+  std::string input_name;
+  Shape shape;
+  DataType datatype = DataType::Fp32;
+  std::thread thread;
+  std::atomic_bool cancelled = false;
+  Clock::time_point start = Clock::now();
+
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  // guarded by the mutex
+  BulkJobState state = BulkJobState::Running;
+  /// responses that arrived before the ones of earlier samples, by sample
+  std::map<size_t, InferenceResponse> responses;
+  size_t received = 0;
+  size_t completed = 0;
+  std::vector<size_t> failed;
+  std::string error;
+  Clock::time_point end;
+
+  [[nodiscard]] BulkJobStatus status() const {
+    const std::lock_guard lock{mutex};
+    BulkJobStatus status;
+    status.id = id;
+    status.model = options.model;
+    status.state = state;
+    status.total = dataset->size();
+    status.completed = completed;
+    status.failed = failed.size();
+    status.elapsed = (state == BulkJobState::Running ? Clock::now() : end) -
+                     start;
+    status.error = error;
+    return status;
+  }
+};
+
+BulkJobs::BulkJobs(SharedState* state) : state_(state) {}
+
+BulkJobs::~BulkJobs() {
+  const std::lock_guard lock{mutex_};
+  for (auto& [id, job] : jobs_) {
+    job->cancelled = true;
+    job->cv.notify_all();
+  }
+  for (auto& [id, job] : jobs_) {
+    if (job->thread.joinable()) {
+      job->thread.join();
+    }
+  }
+}
+
+std::string BulkJobs::submit(BulkJobOptions options) {
+  if (options.inflight == 0) {
+    throw invalid_argument("Bulk jobs need at least one request in flight");
+  }
+  auto job = std::make_shared<Job>();
+  const auto metadata = state_->modelMetadata(options.model, options.version);
+  const auto& inputs = metadata.getInputs();
+  if (!options.input_name.empty()) {
+    job->input_name = options.input_name;
+  } else if (!inputs.empty()) {
+    job->input_name = inputs[0].getName();
+  }
+
+  size_t sample_bytes = 0;
+  if (!fs::is_directory(options.input)) {
+    if (options.shape.empty()) {
+      // take the sample from the metadata of the named or first input
+      for (const auto& input : inputs) {
+        if (input.getName() == job->input_name) {
+          options.shape = input.getShape();
+          options.datatype = input.getDatatype();
+          break;
+        }
+      }
+    }
+    if (options.shape.empty() ||
+        std::any_of(options.shape.begin(), options.shape.end(),
+                    [](auto dim) { return dim <= 0; })) {
+      throw invalid_argument(
+        "The shape of the samples in " + options.input.string() +
+        " isn't known. Set the shape of each sample in the job");
+    }
+    job->shape = options.shape;
+    job->datatype = options.datatype;
+    sample_bytes =
+      Tensor{job->input_name, job->shape, job->datatype}.getSize() *
+      job->datatype.size();
+  } else {
+    // the images are sent encoded, as the image decoding workers take them
+    job->datatype = DataType::Bytes;
+  }
+  job->dataset = std::make_unique<BulkDataset>(options.input, sample_bytes);
+  // create the output directory now so it fails before the job starts
+  fs::create_directories(options.output);
+  job->options = std::move(options);
+
+  const std::lock_guard lock{mutex_};
+  const auto id = next_id_++;
+  job->id = "job-" + std::to_string(id);
+  jobs_.emplace(id, job);
+  job->thread = std::thread{[this, job]() { this->run(job); }};
+  this->prune();
+  return job->id;
+}
+
+BulkJobStatus BulkJobs::status(const std::string& id) const {
+  const std::lock_guard lock{mutex_};
+  for (const auto& [number, job] : jobs_) {
+    if (job->id == id) {
+      return job->status();
+    }
+  }
+  throw invalid_argument("Bulk job " + id + " doesn't exist");
+}
+
+std::vector<BulkJobStatus> BulkJobs::list() const {
+  const std::lock_guard lock{mutex_};
+  std::vector<BulkJobStatus> statuses;
+  statuses.reserve(jobs_.size());
+  for (const auto& [number, job] : jobs_) {
+    statuses.push_back(job->status());
+  }
+  return statuses;
+}
+
+void BulkJobs::cancel(const std::string& id) {
+  const std::lock_guard lock{mutex_};
+  for (const auto& [number, job] : jobs_) {
+    if (job->id == id) {
+      job->cancelled = true;
+      job->cv.notify_all();
+      return;
+    }
+  }
+  throw invalid_argument("Bulk job " + id + " doesn't exist");
+}
+
+void BulkJobs::prune() {
+  size_t finished = 0;
+  for (const auto& [number, job] : jobs_) {
+    const std::lock_guard lock{job->mutex};
+    finished += job->state != BulkJobState::Running ? 1 : 0;
+  }
+  // the map is ordered by ID so the oldest finished jobs come first
+  for (auto it = jobs_.begin();
+       finished > kMaxFinishedJobs && it != jobs_.end();) {
+    auto& job = it->second;
+    bool running = false;
+    {
+      const std::lock_guard lock{job->mutex};
+      running = job->state == BulkJobState::Running;
+    }
+    if (running) {
+      ++it;
+      continue;
+    }
+    // the job's thread is done or about to return
+    job->thread.join();
+    it = jobs_.erase(it);
+    finished--;
+  }
+}
+
+void BulkJobs::run(const std::shared_ptr<Job>& job) {
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+  const auto& options = job->options;
+  const auto* pool = state_->getPool();
+  const auto total = job->dataset->size();
+  // requests for the lowest lane are batched after the online requests. The
+  // batchers clamp it to the number of lanes they're loaded with
+  constexpr auto kBulkPriority = static_cast<int32_t>(kPriorityLanes) - 1;
+
+  const auto send = [&](size_t index) {
+    const auto bytes = job->dataset->bytes(index);
+    void* data = nullptr;
+    Shape shape = job->shape;
+    if (job->dataset->images()) {
+      shape = {static_cast<int64_t>(bytes)};
+      auto buffer = pool->get(MemoryAllocators::Cpu,
+                              Tensor{job->input_name, shape, job->datatype}, 1);
+      data = buffer->data(0);
+      try {
+        job->dataset->read(index, static_cast<std::byte*>(data));
+      } catch (const runtime_error&) {
+        pool->put(MemoryAllocators::Cpu, data);
+        throw;
+      }
+    } else {
+      // the requests read the samples straight from the mapped file
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      data = const_cast<std::byte*>(job->dataset->data(index));
+      pool->borrow(data);
+    }
+
+    auto request = std::make_shared<InferenceRequest>();
+    request->addInputTensor(data, shape, job->datatype, job->input_name);
+    ParameterMap parameters;
+    parameters.put("priority", kBulkPriority);
+    request->setParameters(std::move(parameters));
+    request->setCallback([job, index](const InferenceResponse& response) {
+      if (!response.isFinal()) {
+        return;
+      }
+      const std::lock_guard lock{job->mutex};
+      job->responses.emplace(index, response);
+      job->received++;
+      job->cv.notify_all();
+    });
+
+    auto container = makeRequestContainer();
+    container->request = std::move(request);
+    try {
+      state_->modelInfer(options.model, std::move(container), options.version);
+    } catch (const runtime_error& e) {
+      pool->put(MemoryAllocators::Cpu, data);
+      const std::lock_guard lock{job->mutex};
+      if (job->responses.emplace(index, InferenceResponse{e.what()}).second) {
+        job->received++;
+      }
+    }
+  };
+
+  size_t sent = 0;
+  std::string error;
+  try {
+    BulkOutputWriter writer{options.output};
+    while (writer.size() < sent || (!job->cancelled && sent < total)) {
+      // write the responses that are next in the order of the dataset
+      std::vector<InferenceResponse> ready;
+      const bool cancelled = job->cancelled;
+      {
+        std::unique_lock lock{job->mutex};
+        for (auto next = job->responses.find(writer.size() + ready.size());
+             next != job->responses.end();
+             next = job->responses.find(writer.size() + ready.size())) {
+          ready.push_back(std::move(next->second));
+          job->responses.erase(next);
+        }
+        if (ready.empty()) {
+          const auto can_send = !cancelled && sent < total &&
+                                sent - writer.size() < options.inflight;
+          if (!can_send || state_->getLoad() >= options.max_load) {
+            // wait for a response or, if the server is loaded, for it to
+            // have room again
+            job->cv.wait_for(lock, SharedState::kLoadInterval, [&]() {
+              return job->responses.count(writer.size()) > 0 ||
+                     job->cancelled != cancelled;
+            });
+            continue;
+          }
+        }
+      }
+
+      for (const auto& response : ready) {
+        const auto index = writer.size();
+        writer.write(response);
+        const std::lock_guard lock{job->mutex};
+        job->completed++;
+        if (response.isError()) {
+          job->failed.push_back(index);
+        }
+      }
+      if (ready.empty()) {
+        send(sent);
+        sent++;
+      }
+    }
+    writer.flush();
+
+    // describe the job and its outputs next to them
+    Json::Value manifest;
+    manifest["model"] = options.model;
+    manifest["version"] = options.version;
+    manifest["input"] = options.input.string();
+    manifest["samples"] = Json::UInt64{writer.size()};
+    manifest["outputs"] = Json::arrayValue;
+    for (const auto& column : writer.getColumns()) {
+      Json::Value entry;
+      entry["name"] = column.name;
+      entry["datatype"] = column.datatype.str();
+      if (column.fixed) {
+        entry["shape"] = Json::arrayValue;
+        for (const auto dim : column.shape) {
+          entry["shape"].append(Json::Int64{dim});
+        }
+      }
+      manifest["outputs"].append(entry);
+    }
+    manifest["failed"] = Json::arrayValue;
+    {
+      const std::lock_guard lock{job->mutex};
+      for (const auto index : job->failed) {
+        manifest["failed"].append(Json::UInt64{index});
+      }
+    }
+    if (job->dataset->images()) {
+      manifest["files"] = Json::arrayValue;
+      for (const auto& file : job->dataset->getFiles()) {
+        manifest["files"].append(file.filename().string());
+      }
+    }
+    std::ofstream file{options.output / "manifest.json", std::ios::trunc};
+    file << Json::writeString(Json::StreamWriterBuilder{}, manifest);
+    if (!file.flush()) {
+      throw runtime_error("Could not write the manifest of " + job->id);
+    }
+  } catch (const std::exception& e) {
+    error = e.what();
+    AMDINFER_LOG_WARN(logger, "Bulk job " + job->id + " failed: " + error);
+    // the requests in flight still respond to the job
+    job->cancelled = true;
+    std::unique_lock lock{job->mutex};
+    job->cv.wait(lock, [&]() { return job->received >= sent; });
+  }
+
+  const std::lock_guard lock{job->mutex};
+  job->end = Job::Clock::now();
+  job->responses.clear();
+  if (!error.empty()) {
+    job->state = BulkJobState::Failed;
+    job->error = error;
+  } else if (job->completed < total) {
+    job->state = BulkJobState::Cancelled;
+  } else {
+    job->state = BulkJobState::Succeeded;
+  }
+  AMDINFER_LOG_INFO(logger, "Bulk job " + job->id + " " +
+                              toString(job->state) + " after " +
+                              std::to_string(job->completed) + " samples");
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,147 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Defines the offline jobs that run a dataset through a model in bulk
+ */
+
+#ifndef GUARD_AMDINFER_CORE_BULK_JOB
+#define GUARD_AMDINFER_CORE_BULK_JOB
+
+#include <chrono>      // for nanoseconds
+#include <cstddef>     // for size_t
+#include <cstdint>     // for int64_t, uint64_t
+#include <filesystem>  // for path
+#include <map>         // for map
+#include <memory>      // for shared_ptr
+#include <mutex>       // for mutex
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+
+namespace amdinfer {
+
+class SharedState;
+
+/// What a bulk job runs and where it writes the results. See BulkDataset
+struct BulkJobOptions {
+  std::string model;
+  std::string version;
+  /// a tensor file or a directory of images. See BulkDataset
+  std::filesystem::path input;
+  /// the directory to write the outputs to. See BulkOutputWriter
+  std::filesystem::path output;
+  /// the name of the input tensor or empty for the model's first input
+  std::string input_name;
+  /// the shape of each sample in a tensor file or empty to take it and the
+  /// datatype from the model's metadata
+  std::vector<int64_t> shape;
+  DataType datatype = DataType::Fp32;
+  /// the most requests in flight at once
+  size_t inflight = 256;
+  /// the server's load, as in SharedState::getLoad, at which the job stops
+  /// sending requests until it falls
+  double max_load = 0.5;
+};
+
+enum class BulkJobState {
+  Running,
+  Succeeded,
+  Failed,
+  Cancelled,
+};
+
+/// Get the name of the state, such as "running"
+std::string toString(BulkJobState state);
+
+/// The progress of a bulk job
+struct BulkJobStatus {
+  std::string id;
+  std::string model;
+  BulkJobState state = BulkJobState::Running;
+  /// the number of samples in the dataset
+  size_t total = 0;
+  /// the number of samples whose outputs are written, including failures
+  size_t completed = 0;
+  size_t failed = 0;
+  /// the time since the job started or that it took
+  std::chrono::nanoseconds elapsed{0};
+  /// why the job failed
+  std::string error;
+};
+
+/**
+ * @brief Runs offline jobs that push a dataset through a model at as high a
+ * throughput as the server can spare and write the outputs to files. Each job
+ * streams its samples to the model as single requests at the lowest priority
+ * so the batchers fill whole batches with them while online requests to the
+ * same model are batched first. It keeps up to a window of requests in flight
+ * and stops sending while the server is loaded so online traffic to other
+ * models isn't queued behind it either. Each sample's outputs are written in
+ * the order of the dataset, along with a manifest.json that describes the
+ * job and its outputs once it finishes.
+ */
+class BulkJobs {
+ public:
+  explicit BulkJobs(SharedState* state);
+  BulkJobs(BulkJobs const&) = delete;
+  BulkJobs& operator=(const BulkJobs&) = delete;
+  BulkJobs(BulkJobs&& other) = delete;
+  BulkJobs& operator=(BulkJobs&& other) = delete;
+  /// Cancel the running jobs and wait for them
+  ~BulkJobs();
+
+  /**
+   * @brief Start a job. The dataset is opened and the model checked before it
+   * returns so mistakes are reported to the caller
+   *
+   * @param options what to run
+   * @return std::string the ID of the job
+   * @throws invalid_argument if the model isn't loaded or the options are
+   * invalid
+   */
+  std::string submit(BulkJobOptions options);
+  /// Get the progress of a job. Throws invalid_argument if it doesn't exist
+  [[nodiscard]] BulkJobStatus status(const std::string& id) const;
+  /// Get the progress of the jobs, including the last ones that finished
+  [[nodiscard]] std::vector<BulkJobStatus> list() const;
+  /**
+   * @brief Stop a job from sending more requests. It finishes once the ones in
+   * flight respond. Throws invalid_argument if it doesn't exist
+   */
+  void cancel(const std::string& id);
+
+  /// The most finished jobs whose status is kept
+  static constexpr size_t kMaxFinishedJobs = 64;
+
+ private:
+  struct Job;
+
+  void run(const std::shared_ptr<Job>& job);
+  /// Forget the oldest finished jobs beyond kMaxFinishedJobs
+  void prune();
+
+  SharedState* state_;
+  mutable std::mutex mutex_;
+  // guarded by the mutex
+  std::map<uint64_t, std::shared_ptr<Job>> jobs_;
+  uint64_t next_id_ = 1;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_BULK_JOB
@@ -0,0 +1,56 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the accessors for the elements of BYTES tensors
+ */
+
+#include "amdinfer/core/bytes_tensor.hpp"
+
+#include <cstring>  // for memchr
+
+namespace amdinfer {
+
+BytesView::BytesView(const void* data, size_t size)
+  : data_(static_cast<const char*>(data)) {
+  offsets_.push_back(0);
+  // the elements end where the trailing padding starts
+  auto length = size;
+  while (length > 0 && data_[length - 1] == '\0') {
+    length--;
+  }
+  size_t offset = 0;
+  while (offset < length) {
+    const auto* end = static_cast<const char*>(
+      std::memchr(data_ + offset, '\0', length - offset));
+    offset = end == nullptr ? length : static_cast<size_t>(end - data_) + 1;
+    offsets_.push_back(offset);
+  }
+  // keep the last element's terminator if it has one
+  if (length > 0 && length < size) {
+    offsets_.back()++;
+  }
+}
+
+std::string_view BytesView::operator[](size_t index) const {
+  const auto begin = offsets_[index];
+  auto end = offsets_[index + 1];
+  if (end > begin && data_[end - 1] == '\0') {
+    end--;
+  }
+  return {data_ + begin, end - begin};
+}
+
+}  // namespace amdinfer
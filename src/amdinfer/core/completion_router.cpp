@@ -0,0 +1,72 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the routing of finished responses
+ */
+
+#include "amdinfer/core/completion_router.hpp"
+
+#include <algorithm>  // for find_if
+#include <exception>  // for exception
+#include <utility>    // for move
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/observation/logging.hpp"     // for Logger, AMDINFER_LOG...
+
+namespace amdinfer {
+
+void runCompletions(std::vector<Completion>* completions) {
+  for (auto& [callback, response] : *completions) {
+    try {
+      callback(response);
+    } catch (const std::exception& e) {
+      AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+      AMDINFER_LOG_ERROR(logger, e.what());
+    }
+  }
+}
+
+void CompletionRouter::add(InferenceRequest* request,
+                           InferenceResponse response) {
+  const auto& executor = request->getExecutor();
+  if (executor == nullptr) {
+    request->runCallbackOnce(response);
+    return;
+  }
+
+  // requests are only responded to once
+  auto callback = request->getCallback();
+  if (callback == nullptr) {
+    return;
+  }
+
+  auto group = std::find_if(
+    groups_.begin(), groups_.end(),
+    [&executor](const auto& entry) { return entry.first == executor; });
+  if (group == groups_.end()) {
+    group = groups_.emplace(groups_.end(), executor, std::vector<Completion>{});
+  }
+  group->second.push_back(Completion{std::move(callback), std::move(response)});
+}
+
+void CompletionRouter::flush() {
+  for (auto& [executor, completions] : groups_) {
+    executor->post(std::move(completions));
+  }
+  groups_.clear();
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,101 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the routing of finished responses to the threads of the
+ * transports that own their requests
+ */
+
+#ifndef GUARD_AMDINFER_CORE_COMPLETION_ROUTER
+#define GUARD_AMDINFER_CORE_COMPLETION_ROUTER
+
+#include <memory>   // for shared_ptr
+#include <utility>  // for pair
+#include <vector>   // for vector
+
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/declarations.hpp"             // for Callback
+
+namespace amdinfer {
+
+class InferenceRequest;
+
+/// A request's callback and the response to run it with
+struct Completion {
+  Callback callback;
+  InferenceResponse response;
+};
+
+/**
+ * @brief Run completions, in order. Errors are logged so one callback can't
+ * stop the rest or the thread running them
+ *
+ * @param completions the completions to run
+ */
+void runCompletions(std::vector<Completion>* completions);
+
+/**
+ * @brief Runs completions on the thread that owns a transport, such as an I/O
+ * loop of the HTTP server or a completion queue of the gRPC server, so the
+ * responses are serialized and sent there
+ */
+class CompletionExecutor {
+ public:
+  CompletionExecutor() = default;
+  virtual ~CompletionExecutor() = default;
+  CompletionExecutor(const CompletionExecutor&) = delete;
+  CompletionExecutor& operator=(const CompletionExecutor&) = delete;
+  CompletionExecutor(CompletionExecutor&&) = delete;
+  CompletionExecutor& operator=(CompletionExecutor&&) = delete;
+
+  /**
+   * @brief Run the completions on the executor's thread, with one wakeup for
+   * all of them
+   *
+   * @param completions the completions to run
+   */
+  virtual void post(std::vector<Completion> completions) = 0;
+};
+
+/**
+ * @brief Groups the responses to a batch of requests by the executors of their
+ * requests and hands each group over at once. The transports' threads then
+ * serialize the responses in parallel, with one cross-thread wakeup per batch
+ * per thread. Requests without an executor are responded to right away.
+ */
+class CompletionRouter {
+ public:
+  /**
+   * @brief Respond to a request. The request's callback is taken and run by
+   * its executor once flush() is called
+   *
+   * @param request the request to respond to
+   * @param response the response
+   */
+  void add(InferenceRequest* request, InferenceResponse response);
+
+  /// Hand the responses added since the last flush to their executors
+  void flush();
+
+ private:
+  // a batch's requests come from a few threads so a vector beats a map
+  std::vector<std::pair<std::shared_ptr<CompletionExecutor>,
+                        std::vector<Completion>>>
+    groups_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_COMPLETION_ROUTER
@@ -0,0 +1,264 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the scheduler that shares a device between the endpoints
+ * whose workers run on it
+ */
+
+#include "amdinfer/core/device_scheduler.hpp"
+
+#include <algorithm>      // for find_if, max, min
+#include <limits>         // for numeric_limits
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+
+#include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/exceptions.hpp"      // for invalid_argument
+#include "amdinfer/observation/metrics.hpp"  // for Metrics
+
+namespace amdinfer {
+
+namespace {
+
+#ifdef AMDINFER_ENABLE_METRICS
+void count(MetricCounterIDs id, const std::string& endpoint,
+           const std::string& device, DeviceScheduler::Clock::duration time) {
+  const auto microseconds =
+    std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+  if (microseconds > 0) {
+    Metrics::getInstance().incrementCounter(
+      id, {{"model", endpoint}, {"device", device}},
+      static_cast<size_t>(microseconds));
+  }
+}
+#endif
+
+}  // namespace
+
+/// Ends its endpoint's turn on the device and charges the time to it
+class DeviceScheduler::Turn {
+ public:
+  Turn(std::shared_ptr<DeviceScheduler> scheduler, Client* client)
+    : scheduler_(std::move(scheduler)), client_(client), start_(Clock::now()) {}
+  Turn(Turn const&) = delete;
+  Turn& operator=(const Turn&) = delete;
+  Turn(Turn&& other) = delete;
+  Turn& operator=(Turn&& other) = delete;
+  ~Turn() { scheduler_->release(client_, Clock::now() - start_); }
+
+ private:
+  std::shared_ptr<DeviceScheduler> scheduler_;
+  Client* client_;
+  Clock::time_point start_;
+};
+
+DeviceScheduler::Share::Share(std::shared_ptr<DeviceScheduler> scheduler,
+                              Client* client)
+  : scheduler_(std::move(scheduler)), client_(client) {}
+
+DeviceScheduler::Share::~Share() { scheduler_->leave(client_); }
+
+std::shared_ptr<void> DeviceScheduler::Share::take() {
+  return scheduler_->acquire(client_);
+}
+
+DeviceScheduler::DeviceScheduler(std::string device, Clock::duration quantum)
+  : device_(std::move(device)),
+    quantum_(std::max<int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(quantum).count(),
+      1)) {}
+
+std::shared_ptr<DeviceScheduler> DeviceScheduler::get(
+  const std::string& device) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<DeviceScheduler>>
+    devices;
+
+  const std::lock_guard lock{mutex};
+  auto& scheduler = devices[device];
+  auto shared = scheduler.lock();
+  if (shared == nullptr) {
+    shared = std::make_shared<DeviceScheduler>(device);
+    scheduler = shared;
+  }
+  return shared;
+}
+
+std::shared_ptr<DeviceScheduler::Share> DeviceScheduler::join(
+  const std::string& endpoint, uint32_t weight) {
+  if (weight == 0) {
+    throw invalid_argument("Device weights must be positive");
+  }
+  const std::lock_guard lock{mutex_};
+  auto found = std::find_if(
+    clients_.begin(), clients_.end(),
+    [&endpoint](const auto& client) { return client->endpoint == endpoint; });
+  Client* client = nullptr;
+  if (found == clients_.end()) {
+    client = clients_.emplace_back(std::make_unique<Client>()).get();
+    client->endpoint = endpoint;
+  } else {
+    client = found->get();
+  }
+  client->weight = weight;
+  client->shares++;
+  return std::make_shared<Share>(shared_from_this(), client);
+}
+
+void DeviceScheduler::setSlots(size_t slots) {
+  const std::lock_guard lock{mutex_};
+  slots_ = std::max<size_t>(slots, 1);
+  this->dispatch();
+}
+
+size_t DeviceScheduler::getSlots() const {
+  const std::lock_guard lock{mutex_};
+  return slots_;
+}
+
+std::chrono::nanoseconds DeviceScheduler::getBusyTime(
+  const std::string& endpoint) const {
+  const std::lock_guard lock{mutex_};
+  for (const auto& client : clients_) {
+    if (client->endpoint == endpoint) {
+      return client->busy;
+    }
+  }
+  return std::chrono::nanoseconds{0};
+}
+
+std::shared_ptr<void> DeviceScheduler::acquire(Client* client) {
+  [[maybe_unused]] const auto start = Clock::now();
+  std::unique_lock lock{mutex_};
+  client->waiting++;
+  waiting_++;
+  this->dispatch();
+  granted_cv_.wait(lock, [client]() { return client->granted > 0; });
+  client->granted--;
+#ifdef AMDINFER_ENABLE_METRICS
+  const auto endpoint = client->endpoint;
+  lock.unlock();
+  count(MetricCounterIDs::DeviceWaitTime, endpoint, device_,
+        Clock::now() - start);
+#else
+  lock.unlock();
+#endif
+  return std::make_shared<Turn>(shared_from_this(), client);
+}
+
+void DeviceScheduler::release(Client* client, Clock::duration elapsed) {
+  const auto time =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+  std::unique_lock lock{mutex_};
+  running_--;
+  client->running--;
+  client->deficit -= time.count();
+  client->busy += time;
+#ifdef AMDINFER_ENABLE_METRICS
+  const auto endpoint = client->endpoint;
+#endif
+  if (client->waiting == 0 && client->granted == 0 && client->running == 0) {
+    // the endpoint's next batch may be on its way so it keeps its credit for
+    // this round, but no more, so idle endpoints can't save it up
+    client->deficit =
+      std::min<int64_t>(client->deficit, quantum_ * client->weight);
+    if (client->shares == 0) {
+      this->forget(client);
+    }
+  }
+  this->dispatch();
+  lock.unlock();
+#ifdef AMDINFER_ENABLE_METRICS
+  count(MetricCounterIDs::DeviceBusyTime, endpoint, device_, elapsed);
+#endif
+}
+
+void DeviceScheduler::leave(Client* client) {
+  const std::lock_guard lock{mutex_};
+  client->shares--;
+  if (client->shares == 0 && client->waiting == 0 && client->granted == 0 &&
+      client->running == 0) {
+    this->forget(client);
+  }
+}
+
+void DeviceScheduler::dispatch() {
+  bool granted = false;
+  while (running_ < slots_) {
+    auto* client = this->pick();
+    if (client == nullptr) {
+      break;
+    }
+    client->waiting--;
+    waiting_--;
+    client->granted++;
+    client->running++;
+    running_++;
+    granted = true;
+  }
+  if (granted) {
+    granted_cv_.notify_all();
+  }
+}
+
+DeviceScheduler::Client* DeviceScheduler::pick() {
+  if (waiting_ == 0) {
+    return nullptr;
+  }
+  const auto count = clients_.size();
+  while (true) {
+    // keep serving the current endpoint while it has credit
+    for (auto i = 0U; i < count; ++i) {
+      const auto index = (cursor_ + i) % count;
+      auto* client = clients_[index].get();
+      if (client->waiting > 0 && client->deficit > 0) {
+        cursor_ = index;
+        return client;
+      }
+    }
+    // start a new round, crediting the waiting endpoints with as many quanta
+    // as it takes for one of them to have some credit
+    auto rounds = std::numeric_limits<int64_t>::max();
+    for (const auto& client : clients_) {
+      if (client->waiting > 0) {
+        const auto credit = quantum_ * client->weight;
+        rounds = std::min(rounds, -client->deficit / credit + 1);
+      }
+    }
+    for (auto& client : clients_) {
+      if (client->waiting > 0) {
+        client->deficit += rounds * quantum_ * client->weight;
+      }
+    }
+    cursor_ = (cursor_ + 1) % count;
+  }
+}
+
+void DeviceScheduler::forget(const Client* client) {
+  const auto found = std::find_if(
+    clients_.begin(), clients_.end(),
+    [client](const auto& other) { return other.get() == client; });
+  const auto index = static_cast<size_t>(found - clients_.begin());
+  clients_.erase(found);
+  if (index < cursor_) {
+    cursor_--;
+  }
+  if (cursor_ >= clients_.size()) {
+    cursor_ = 0;
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,162 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the scheduler that shares a device between the endpoints
+ * whose workers run on it
+ */
+
+#ifndef GUARD_AMDINFER_CORE_DEVICE_SCHEDULER
+#define GUARD_AMDINFER_CORE_DEVICE_SCHEDULER
+
+#include <chrono>              // for steady_clock, nanoseconds
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <cstdint>             // for uint32_t, int64_t
+#include <memory>              // for shared_ptr, enable_shared_from_this
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <vector>              // for vector
+
+namespace amdinfer {
+
+/**
+ * @brief Shares a device between the endpoints whose workers run batches on
+ * it. Each worker takes a turn on the device before it runs a batch and the
+ * scheduler hands out turns by deficit round-robin: each endpoint has a weight
+ * and, in each round, the endpoints that are waiting are credited with a
+ * quantum of device time in proportion to it. An endpoint is given turns while
+ * it has credit and the time of each turn is charged to it when it ends, so
+ * under contention the endpoints get the device's time in proportion to their
+ * weights no matter how many batches they send or how long they take. Idle
+ * endpoints can't save up more than a round's credit and still owe what they
+ * overspent.
+ */
+class DeviceScheduler : public std::enable_shared_from_this<DeviceScheduler> {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  class Share;
+
+  /**
+   * @brief Construct a new DeviceScheduler object
+   *
+   * @param device the name of the device, used to label its metrics
+   * @param quantum the device time credited to an endpoint with a weight of 1
+   * in each round
+   */
+  explicit DeviceScheduler(std::string device,
+                           Clock::duration quantum = kDefaultQuantum);
+
+  /**
+   * @brief Get the scheduler of a device. It's made for the device's first
+   * endpoint and dropped once no endpoint holds it.
+   *
+   * @param device the name of the device
+   * @return std::shared_ptr<DeviceScheduler>
+   */
+  static std::shared_ptr<DeviceScheduler> get(const std::string& device);
+
+  /**
+   * @brief Add an endpoint to the schedule. The workers of an endpoint may
+   * join with the same name and they share its turns. The endpoint leaves the
+   * schedule once all of its shares are dropped
+   *
+   * @param endpoint the name of the endpoint
+   * @param weight the endpoint's weight, which must be positive. It replaces
+   * the weight of the endpoint's other shares
+   * @return std::shared_ptr<Share>
+   */
+  std::shared_ptr<Share> join(const std::string& endpoint, uint32_t weight);
+
+  /// Set the most turns that may be taken at once. It's 1 by default
+  void setSlots(size_t slots);
+  [[nodiscard]] size_t getSlots() const;
+  /// Get the device time that an endpoint's turns have taken
+  [[nodiscard]] std::chrono::nanoseconds getBusyTime(
+    const std::string& endpoint) const;
+
+  static constexpr Clock::duration kDefaultQuantum =
+    std::chrono::milliseconds(1);
+
+ private:
+  class Turn;
+
+  struct Client {
+    std::string endpoint;
+    uint32_t weight = 1;
+    /// device time the endpoint may still use this round, in nanoseconds
+    int64_t deficit = 0;
+    size_t shares = 0;
+    size_t waiting = 0;
+    /// turns given to the endpoint that its waiting workers haven't taken
+    size_t granted = 0;
+    size_t running = 0;
+    std::chrono::nanoseconds busy{0};
+  };
+
+  std::shared_ptr<void> acquire(Client* client);
+  void release(Client* client, Clock::duration elapsed);
+  void leave(Client* client);
+  /// Give turns to the waiting endpoints while there are free slots
+  void dispatch();
+  /// Pick the endpoint for the next turn or nullptr if none are waiting
+  Client* pick();
+  /// Forget an endpoint that has no shares and no turns in flight
+  void forget(const Client* client);
+
+  const std::string device_;
+  const int64_t quantum_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable granted_cv_;
+  // guarded by the mutex
+  std::vector<std::unique_ptr<Client>> clients_;
+  /// index of the endpoint that's being served this round
+  size_t cursor_ = 0;
+  size_t slots_ = 1;
+  size_t running_ = 0;
+  size_t waiting_ = 0;
+};
+
+/**
+ * @brief An endpoint's share of a device. The endpoint's workers take turns on
+ * the device through it
+ */
+class DeviceScheduler::Share {
+ public:
+  Share(std::shared_ptr<DeviceScheduler> scheduler, Client* client);
+  ~Share();
+  Share(Share const&) = delete;
+  Share& operator=(const Share&) = delete;
+  Share(Share&& other) = delete;
+  Share& operator=(Share&& other) = delete;
+
+  /**
+   * @brief Block until it's the endpoint's turn on the device. The turn lasts
+   * until the returned pointer is dropped, which may be on another thread
+   *
+   * @return std::shared_ptr<void> the turn
+   */
+  [[nodiscard]] std::shared_ptr<void> take();
+
+ private:
+  std::shared_ptr<DeviceScheduler> scheduler_;
+  Client* client_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_DEVICE_SCHEDULER
@@ -19,23 +19,110 @@
 
 #include "amdinfer/core/endpoints.hpp"
 
-#include <cassert>  // for assert
+#include <algorithm>  // for max
+#include <cassert>    // for assert
+#include <chrono>     // for steady_clock, duration
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int32_t
+#include <exception>  // for exception
+#include <memory>     // for shared_ptr, atomic_load, atomic_store
+#include <optional>   // for optional, nullopt
 #include <regex>
+#include <thread>       // for sleep_for, yield
 #include <type_traits>  // for __decay_and_strip<>::__type
 
 #include "amdinfer/batching/batcher.hpp"         // for Batcher
 #include "amdinfer/build_options.hpp"            // for kMaxModelNameSize
+#include "amdinfer/core/ensemble.hpp"            // for Ensemble
 #include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"          // for ParameterMap
 #include "amdinfer/core/request_container.hpp"   // for RequestContainer
 #include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
 #include "amdinfer/core/worker_info.hpp"         // for WorkerInfo
+#include "amdinfer/util/numa.hpp"                // for bindThreadToCpus
 #include "amdinfer/util/string.hpp"              // for startsWith
 #include "amdinfer/util/thread.hpp"              // for setThreadName
 
 namespace amdinfer {
 
-Endpoints::Endpoints() {
+namespace {
+
+/// How often the manager samples the autoscaled endpoints
+constexpr auto kAutoscaleInterval = std::chrono::seconds(1);
+/**
+ * How long an endpoint's queues must stay empty after a swap before it's
+ * unloaded. A partial batch waits in the batcher for up to its timeout so this
+ * is longer than the default timeout
+ */
+constexpr auto kDrainQuiet = std::chrono::milliseconds(200);
+/// The longest an endpoint is given to drain after a swap
+constexpr auto kDrainTimeout = std::chrono::seconds(30);
+/// How often a draining endpoint's queues are checked
+constexpr auto kDrainInterval = std::chrono::milliseconds(10);
+/// How many autoscaled endpoints can add a worker at once
+constexpr auto kScaleUpThreads = 2;
+
+/**
+ * @brief Wait for the manager thread to finish a command, rethrowing the error
+ * if it failed
+ *
+ * @param request the command. Its return value is a string
+ */
+void wait(const UpdateCommand& request) {
+  while (static_cast<std::string*>(request.retval)->empty() &&
+         request.eptr == nullptr) {
+    std::this_thread::yield();
+  }
+  if (request.eptr != nullptr) {
+    std::rethrow_exception(request.eptr);
+  }
+}
+
+/**
+ * @brief Wait until a worker group's batcher and workers have had no queued
+ * requests or batches for the quiet period
+ *
+ * @param worker the worker group
+ * @param quiet how long the queues must stay empty
+ * @return bool false if it didn't drain before the drain timeout
+ */
+bool drain(WorkerInfo* worker, std::chrono::milliseconds quiet) {
+  auto* batcher = worker->getBatcher();
+  const auto start = std::chrono::steady_clock::now();
+  auto empty_since = start;
+  while (true) {
+    const auto now = std::chrono::steady_clock::now();
+    if (batcher->getInputQueue()->size_approx() > 0 ||
+        batcher->getOutputQueue()->size_approx() > 0) {
+      empty_since = now;
+    } else if (now - empty_since >= quiet) {
+      return true;
+    }
+    if (now - start >= kDrainTimeout) {
+      return false;
+    }
+    std::this_thread::sleep_for(kDrainInterval);
+  }
+}
+
+/// Remove the aliases that point at an endpoint
+void eraseAliases(std::unordered_map<std::string, std::string>* aliases,
+                  const std::string& endpoint) {
+  for (auto it = aliases->begin(); it != aliases->end();) {
+    if (it->second == endpoint) {
+      it = aliases->erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace
+
+Endpoints::Endpoints()
+  : table_(std::make_shared<const Table>()), scalers_(kScaleUpThreads) {
   update_thread_ = std::thread(&Endpoints::updateManager, this, &update_queue_);
 }
 
@@ -44,116 +131,263 @@ Endpoints::~Endpoints() { this->shutdown(); }
 std::string Endpoints::load(const std::string& worker,
                             const std::string& version,
                             ParameterMap parameters) {
-  std::shared_ptr<amdinfer::UpdateCommand> request;
+  LoadRequest load;
+  load.parameters = &parameters;
   std::string retval;
   retval.reserve(kMaxModelNameSize);
-  retval = "";
   const auto& versioned_endpoint = getVersionedEndpoint(worker, version);
-  request = std::make_shared<UpdateCommand>(
-    UpdateCommandType::Load, versioned_endpoint, &parameters, &retval);
+  auto request = std::make_shared<UpdateCommand>(
+    UpdateCommandType::Load, versioned_endpoint, &load, &retval);
   update_queue_.enqueue(request);
-
-  while (static_cast<std::string*>(request->retval)->empty() &&
-         request->eptr == nullptr) {
-    std::this_thread::yield();
+  wait(*request);
+  if (!load.create) {
+    return retval;
   }
-  if (request->eptr != nullptr) {
-    std::rethrow_exception(request->eptr);
+  return this->start(retval, &load);
+}
+
+std::string Endpoints::start(const std::string& endpoint,
+                             LoadRequest* request) {
+  // the manager reserved the endpoint for the workers. Starting them reads and
+  // compiles the model so it's done here to not hold up the manager
+  auto* parameters = request->parameters;
+  const bool created = request->worker == nullptr;
+  try {
+    if (created) {
+      request->worker = std::make_shared<WorkerInfo>(
+        endpoint, request->name, parameters, &pool_, request->next,
+        std::move(request->next_allocators), request->next_batcher);
+    } else if (request->add) {
+      request->worker->addAndStartWorker(request->name, parameters, &pool_);
+    }
+    while (request->worker->getGroupSize() < request->min_workers) {
+      request->worker->addAndStartWorker(request->name, parameters, &pool_);
+    }
+  } catch (...) {
+    request->eptr = std::current_exception();
+    if (created && request->worker != nullptr) {
+      request->worker->shutdown();
+      request->worker.reset();
+    }
   }
-  auto endpoint = *(static_cast<std::string*>(request->retval));
-  return endpoint;
+
+  std::string committed;
+  committed.reserve(kMaxModelNameSize);
+  auto commit = std::make_shared<UpdateCommand>(UpdateCommandType::Commit,
+                                                endpoint, request, &committed);
+  update_queue_.enqueue(commit);
+  wait(*commit);
+  return committed;
+}
+
+std::string Endpoints::loadEnsemble(const std::string& ensemble,
+                                    const std::string& version,
+                                    const ModelConfig& config,
+                                    std::vector<std::string> endpoints) {
+  std::shared_ptr<const Ensemble> object =
+    std::make_shared<Ensemble>(getVersionedEndpoint(ensemble, version), config,
+                               std::move(endpoints), this, &pool_);
+  std::string retval;
+  retval.reserve(kMaxModelNameSize);
+  auto request = std::make_shared<UpdateCommand>(
+    UpdateCommandType::LoadEnsemble, object->getName(), &object, &retval);
+  update_queue_.enqueue(request);
+  wait(*request);
+  return retval;
 }
 
 void Endpoints::unload(const std::string& endpoint,
                        const std::string& version) {
   const auto& versioned_endpoint = getVersionedEndpoint(endpoint, version);
-  if (this->exists(versioned_endpoint)) {
+  // endpoints that are loading are unloaded once they're loaded
+  if (this->exists(versioned_endpoint) || this->loading(versioned_endpoint)) {
     auto request = std::make_shared<UpdateCommand>(UpdateCommandType::Unload,
                                                    versioned_endpoint);
     update_queue_.enqueue(request);
   }
 }
 
-// TODO(varunsh): race condition if workers are shutting down
-void Endpoints::infer(const std::string& endpoint,
-                      std::unique_ptr<RequestContainer> request,
-                      const std::string& version) const {
-  auto versioned_endpoint = getVersionedEndpoint(endpoint, version);
-  WorkerInfo* worker = this->unsafeGet(versioned_endpoint);
-  if (worker == nullptr) {
-    throw invalid_argument("Worker " + versioned_endpoint + " not found");
+void Endpoints::swap(const std::string& model, const std::string& endpoint) {
+  SwapRequest swapping;
+  swapping.endpoint = endpoint;
+  std::string retval;
+  retval.reserve(kMaxModelNameSize);
+  auto request = std::make_shared<UpdateCommand>(UpdateCommandType::Swap,
+                                                 model, &swapping, &retval);
+  update_queue_.enqueue(request);
+  wait(*request);
+  if (swapping.previous.empty()) {
+    return;
   }
-  const auto* batcher = worker->getBatcher();
-  batcher->enqueue(std::move(request));
+
+  // readers that looked up the previous endpoint just before the swap may
+  // still be adding requests to it so it's unloaded once it stays empty
+  if (swapping.previous_worker == nullptr) {
+    std::this_thread::sleep_for(swapping.quiet);
+  } else if (!drain(swapping.previous_worker.get(), swapping.quiet)) {
+    AMDINFER_LOG_WARN(logger_, swapping.previous +
+                                 " didn't drain in time and is unloaded with "
+                                 "requests still queued");
+  }
+  swapping.previous_worker.reset();
+  this->unload(swapping.previous, "");
+  AMDINFER_LOG_INFO(logger_, "Swapped " + model + " from " + swapping.previous +
+                               " to " + endpoint);
 }
 
-bool Endpoints::exists(const std::string& endpoint) {
-  int retval = -1;
-  auto request = std::make_shared<UpdateCommand>(UpdateCommandType::Exists,
-                                                 endpoint, nullptr, &retval);
+void Endpoints::update(const std::string& endpoint,
+                       const ParameterMap& parameters) {
+  auto changes = parameters;
+  auto request = std::make_shared<UpdateCommand>(UpdateCommandType::Update,
+                                                 endpoint, &changes);
   update_queue_.enqueue(request);
+  wait(*request);
+}
 
-  while (retval == -1 && request->eptr == nullptr) {
-    std::this_thread::yield();
+bool Endpoints::isUpdatable(const std::string& key) {
+  // the batchers read their timeout for each batch
+  return key == "timeout";
+}
+
+void Endpoints::infer(const std::string& endpoint, RequestContainerPtr request,
+                      const std::string& version) const {
+  // the snapshot keeps the worker alive even if it's unloaded meanwhile
+  const auto table = this->snapshot();
+  const auto& entry = find(*table, getVersionedEndpoint(endpoint, version));
+  auto* inference_request = request->request.get();
+  const auto samples = entry.bindings->bind(inference_request);
+
+  if (entry.ensemble != nullptr) {
+    entry.ensemble->infer(std::move(request));
+    return;
+  }
+
+  if (entry.cache != nullptr || entry.flight != nullptr) {
+    const auto key = ResponseCache::key(*inference_request);
+    if (entry.cache != nullptr) {
+      if (auto response = entry.cache->lookup(key); response.has_value()) {
+        // skip batching and inference entirely
+        response->setID(inference_request->getID());
+        inference_request->runCallbackOnce(*response);
+        return;
+      }
+    }
+    if (entry.flight != nullptr && entry.flight->join(key, inference_request)) {
+      // an identical request in flight responds to this one too
+      return;
+    }
+    auto callback = inference_request->getCallback();
+    if (callback != nullptr || entry.flight != nullptr) {
+      inference_request->setCallback(
+        [cache = entry.cache, flight = entry.flight, key,
+         callback = std::move(callback)](
+          const InferenceResponse& response) mutable {
+          if (cache != nullptr) {
+            cache->insert(key, response);
+          }
+          if (callback != nullptr) {
+            callback(response);
+          }
+          if (flight != nullptr) {
+            flight->land(key, response);
+          }
+        });
+    }
   }
-  if (request->eptr != nullptr) {
-    std::rethrow_exception(request->eptr);
+
+  const auto* batcher = entry.worker->getBatcher();
+  if (samples > 1) {
+    batcher->split(std::move(request), samples);
+    return;
   }
-  return retval != 0;
+  request->samples = entry.bindings->unboundSamples(*inference_request);
+  batcher->enqueue(std::move(request));
 }
 
-bool Endpoints::ready(const std::string& endpoint, const std::string& version) {
-  std::shared_ptr<amdinfer::UpdateCommand> request;
-  int ready = -1;
-  auto versioned_endpoint = getVersionedEndpoint(endpoint, version);
-  request = std::make_shared<UpdateCommand>(
-    UpdateCommandType::Ready, versioned_endpoint, nullptr, &ready);
-  update_queue_.enqueue(request);
-  while (ready == -1 && request->eptr == nullptr) {
-    std::this_thread::yield();
+std::shared_ptr<void> Endpoints::admit(const std::string& endpoint,
+                                       const std::string& version,
+                                       size_t bytes) const {
+  const auto table = this->snapshot();
+  const auto found = table->find(getVersionedEndpoint(endpoint, version));
+  if (found == table->end() || found->second.admission == nullptr) {
+    return nullptr;
   }
-  if (request->eptr != nullptr) {
-    std::rethrow_exception(request->eptr);
+  return found->second.admission->admit(bytes);
+}
+
+bool Endpoints::exists(const std::string& endpoint) const {
+  const auto table = this->snapshot();
+  const auto found = table->find(endpoint);
+  return found != table->end() && !found->second.loading;
+}
+
+bool Endpoints::loading(const std::string& endpoint) const {
+  const auto table = this->snapshot();
+  const auto found = table->find(endpoint);
+  return found != table->end() && found->second.loading;
+}
+
+bool Endpoints::ready(const std::string& endpoint,
+                      const std::string& version) const {
+  const auto table = this->snapshot();
+  const auto versioned_endpoint = getVersionedEndpoint(endpoint, version);
+  if (auto found = table->find(versioned_endpoint);
+      found != table->end() && found->second.loading) {
+    return false;
   }
-  return ready != 0;
+  return find(*table, versioned_endpoint).metadata->isReady();
 }
 
-std::vector<std::string> Endpoints::list() {
-  std::shared_ptr<amdinfer::UpdateCommand> request;
-  std::vector<std::string> endpoints;
-  bool retval = false;
-  request = std::make_shared<UpdateCommand>(UpdateCommandType::List, "",
-                                            &endpoints, &retval);
-  update_queue_.enqueue(request);
-  while (!retval && request->eptr == nullptr) {
-    std::this_thread::yield();
+double Endpoints::getLoad(const std::string& endpoint,
+                          const std::string& version,
+                          double saturated_batches) const {
+  const auto table = this->snapshot();
+  return getEntryLoad(find(*table, getVersionedEndpoint(endpoint, version)),
+                      saturated_batches);
+}
+
+double Endpoints::getLoad(double saturated_batches) const {
+  const auto table = this->snapshot();
+  double load = 0;
+  for (const auto& [endpoint, entry] : *table) {
+    if (!util::startsWith(endpoint, "responder")) {
+      load = std::max(load, getEntryLoad(entry, saturated_batches));
+    }
   }
-  if (request->eptr != nullptr) {
-    std::rethrow_exception(request->eptr);
+  return load;
+}
+
+std::vector<std::string> Endpoints::list() const {
+  const auto table = this->snapshot();
+  std::vector<std::string> endpoints;
+  endpoints.reserve(table->size());
+  for (const auto& [endpoint, entry] : *table) {
+    if (!entry.loading && !util::startsWith(endpoint, "responder")) {
+      endpoints.push_back(endpoint);
+    }
   }
   return endpoints;
 }
 
 ModelMetadata Endpoints::metadata(const std::string& endpoint,
-                                  const std::string& version) {
-  std::shared_ptr<amdinfer::UpdateCommand> request;
-  ModelMetadata metadata{"", ""};
-  bool retval = false;
-  auto versioned_endpoint = getVersionedEndpoint(endpoint, version);
-  request = std::make_shared<UpdateCommand>(
-    UpdateCommandType::Metadata, versioned_endpoint, &metadata, &retval);
-  update_queue_.enqueue(request);
-  while (!retval && request->eptr == nullptr) {
-    std::this_thread::yield();
-  }
-  if (request->eptr != nullptr) {
-    std::rethrow_exception(request->eptr);
-  }
-  return metadata;
+                                  const std::string& version) const {
+  const auto table = this->snapshot();
+  return *find(*table, getVersionedEndpoint(endpoint, version)).metadata;
+}
+
+std::shared_ptr<const ModelMetadata> Endpoints::publishedMetadata(
+  const std::string& endpoint, const std::string& version) const {
+  const auto table = this->snapshot();
+  return find(*table, getVersionedEndpoint(endpoint, version)).metadata;
 }
 
 const MemoryPool* Endpoints::getPool() const { return &pool_; }
 
+void Endpoints::setWorkerCpus(const std::vector<int>& cpus) {
+  util::bindThreadToCpus(update_thread_, cpus);
+  scalers_.setCpus(cpus);
+}
+
 // TODO(varunsh): if multiple commands sent post-shutdown, they will linger
 // in the queue and may cause problems
 void Endpoints::shutdown() {
@@ -169,62 +403,105 @@ void Endpoints::updateManager(UpdateCommandQueue* input_queue) {
   util::setThreadName("manager");
   std::shared_ptr<UpdateCommand> request;
   bool run = true;
+  auto next_sample = std::chrono::steady_clock::now() + kAutoscaleInterval;
   while (run) {
-    input_queue->wait_dequeue(request);
+    if (autoscalers_.empty()) {
+      input_queue->wait_dequeue(request);
+    } else {
+      // sample on schedule even if commands keep arriving
+      const auto now = std::chrono::steady_clock::now();
+      if (now >= next_sample) {
+        this->unsafeAutoscale();
+        next_sample = now + kAutoscaleInterval;
+        continue;
+      }
+      if (!input_queue->wait_dequeue_timed(request, next_sample - now)) {
+        continue;
+      }
+    }
     AMDINFER_LOG_DEBUG(logger_,
                        "Got request in Manager update thread with ID " +
                          std::to_string(static_cast<int>(request->cmd)));
     switch (request->cmd) {
       case UpdateCommandType::Load:
         try {
-          auto* parameters = static_cast<ParameterMap*>(request->object);
-          auto endpoint = this->unsafeLoad(request->key, parameters);
-          static_cast<std::string*>(request->retval)
-            ->assign(std::string{endpoint});
+          auto endpoint = this->unsafeLoad(request);
+          if (endpoint.has_value()) {
+            // publish before returning so the caller sees its endpoint
+            this->publish();
+            static_cast<std::string*>(request->retval)->assign(*endpoint);
+          }
         } catch (...) {
+          this->publish();
           request->eptr = std::current_exception();
         }
         break;
-      case UpdateCommandType::Unload:
-        this->unsafeUnload(request->key);
-        break;
-      case UpdateCommandType::Exists:
+      case UpdateCommandType::Commit:
         try {
-          *static_cast<int*>(request->retval) =
-            static_cast<int>(this->unsafeExists(request->key));
+          auto* load = static_cast<LoadRequest*>(request->object);
+          auto endpoint = this->unsafeCommit(request->key, load);
+          this->publish();
+          static_cast<std::string*>(request->retval)->assign(endpoint);
         } catch (...) {
+          this->publish();
           request->eptr = std::current_exception();
         }
+        this->resume(request->key);
         break;
-      case UpdateCommandType::Ready:
+      case UpdateCommandType::LoadEnsemble:
         try {
-          auto metadata = this->unsafeMetadata(request->key);
-          *static_cast<int*>(request->retval) =
-            static_cast<int>(metadata.isReady());
+          auto ensemble =
+            *static_cast<std::shared_ptr<const Ensemble>*>(request->object);
+          auto endpoint = this->unsafeLoadEnsemble(std::move(ensemble));
+          this->publish();
+          static_cast<std::string*>(request->retval)
+            ->assign(std::string{endpoint});
         } catch (...) {
           request->eptr = std::current_exception();
         }
         break;
-      case UpdateCommandType::List:
+      case UpdateCommandType::Swap:
         try {
-          auto* list = static_cast<std::vector<std::string>*>(request->object);
-          this->unsafeList(list);
-          *static_cast<bool*>(request->retval) = true;
+          auto* swap = static_cast<SwapRequest*>(request->object);
+          this->unsafeSwap(request->key, swap);
+          this->publish();
+          static_cast<std::string*>(request->retval)->assign(swap->endpoint);
         } catch (...) {
           request->eptr = std::current_exception();
         }
         break;
-      case UpdateCommandType::Metadata:
+      case UpdateCommandType::Update:
+        // an endpoint whose workers are being started is updated after them
+        if (auto found = creating_.find(request->key);
+            found != creating_.end()) {
+          found->second.push_back(request);
+          break;
+        }
         try {
-          auto* metadata = static_cast<ModelMetadata*>(request->object);
-          *metadata = this->unsafeMetadata(request->key);
-          *static_cast<bool*>(request->retval) = true;
+          this->unsafeUpdate(request->key,
+                             *static_cast<ParameterMap*>(request->object));
         } catch (...) {
           request->eptr = std::current_exception();
         }
         break;
+      case UpdateCommandType::Unload:
+        // an endpoint whose workers are being started is unloaded after them
+        if (auto found = creating_.find(request->key);
+            found != creating_.end()) {
+          found->second.push_back(request);
+          break;
+        }
+        this->unsafeUnload(request->key);
+        this->publish();
+        break;
       case UpdateCommandType::Shutdown:
+        // let the workers being created finish so they're shut down too
+        if (!creating_.empty()) {
+          creating_.begin()->second.push_back(request);
+          break;
+        }
         this->unsafeShutdown();
+        this->publish();
         run = false;
         break;
     }
@@ -233,15 +510,60 @@ void Endpoints::updateManager(UpdateCommandQueue* input_queue) {
 }
 
 // TODO(varunsh): clarify nomenclature here with worker/model/versioned_model
-std::string Endpoints::unsafeLoad(const std::string& worker,
-                                  ParameterMap* parameters) {
-  bool share = true;
-  if (parameters->has("share")) {
-    share = parameters->get<bool>("share");
-    parameters->erase("share");
+std::optional<std::string> Endpoints::unsafeLoad(
+  const std::shared_ptr<UpdateCommand>& request) {
+  auto* load = static_cast<LoadRequest*>(request->object);
+  auto* parameters = load->parameters;
+  const auto& worker = request->key;
+
+  // a load that waited for another is run again with its options already
+  // taken out of the parameters
+  if (!load->options.has_value()) {
+    LoadOptions options;
+    if (parameters->has("share")) {
+      options.share = parameters->get<bool>("share");
+      parameters->erase("share");
+    }
+    // the cache isn't part of the endpoint's identity so it's not kept in the
+    // parameters that distinguish endpoints
+    if (parameters->has("response_cache_size")) {
+      const auto size = parameters->get<int32_t>("response_cache_size");
+      if (size < 0) {
+        throw invalid_argument("The response cache size can't be negative");
+      }
+      options.cache_size = static_cast<size_t>(size);
+      parameters->erase("response_cache_size");
+    }
+    if (parameters->has("single_flight")) {
+      options.single_flight = parameters->get<bool>("single_flight");
+      parameters->erase("single_flight");
+    }
+    // and neither are autoscaling and the admission limits
+    options.autoscaling = Autoscaler::parse(parameters);
+    options.admission = AdmissionControl::parse(parameters);
+    load->options = options;
+  }
+  const auto& options = load->options.value();
+  // the first load to ask for autoscaling starts its minimum of workers
+  if (options.autoscaling.has_value()) {
+    load->min_workers = options.autoscaling->min_workers;
+  }
+
+  // wait for the next endpoint if it's still being created
+  if (parameters->has("next")) {
+    const auto next = parameters->get<std::string>("next");
+    if (auto found = creating_.find(next); found != creating_.end()) {
+      found->second.push_back(request);
+      return std::nullopt;
+    }
   }
 
   auto endpoint = this->insertWorker(worker, *parameters);
+  // and for this endpoint if another load is creating it
+  if (auto found = creating_.find(endpoint); found != creating_.end()) {
+    found->second.push_back(request);
+    return std::nullopt;
+  }
   auto* worker_info = this->unsafeGet(endpoint);
 
   std::string worker_name = endpoint;
@@ -254,32 +576,69 @@ std::string Endpoints::unsafeLoad(const std::string& worker,
   // if the worker doesn't exist yet, we need to create it
   try {
     if (worker_info == nullptr) {
-      BatchPtrQueue* next = nullptr;
-      std::vector<MemoryAllocators> next_allocators;
       if (parameters->has("next")) {
         auto next_endpoint = parameters->get<std::string>("next");
-        const auto* next_info = this->unsafeGet(next_endpoint);
+        auto* next_info = this->unsafeGet(next_endpoint);
         if (next_info == nullptr) {
           throw invalid_argument("No next endpoint found at: " + next_endpoint);
         }
-        next = next_info->getInputQueue();
-        next_allocators = next_info->getAllocators();
+        load->next = next_info->getInputQueue();
+        load->next_allocators = next_info->getAllocators();
+        load->next_batcher = next_info->getBatcher();
       } else if (worker != "responder") {
         const auto* next_info = this->unsafeGet("responder");
-        next = next_info->getInputQueue();
-        next_allocators = next_info->getAllocators();
+        load->next = next_info->getInputQueue();
+        load->next_allocators = next_info->getAllocators();
       } else {
         // worker being loaded is the responder so we don't do anything
       }
 
-      auto new_worker = std::make_unique<WorkerInfo>(
-        worker_name, parameters, &pool_, next, next_allocators);
-      this->workers_.try_emplace(endpoint, std::move(new_worker));
-      // if the worker exists but the share parameter is false, we need to add
-      // one
-    } else if (!share) {
-      worker_info->addAndStartWorker(worker_name, parameters, &pool_);
+      // the caller creates the worker and commits it. Until then, other
+      // loads of this endpoint wait for it
+      load->create = true;
+      load->name = worker_name;
+      creating_.try_emplace(endpoint);
+      return endpoint;
+    }
+    // if the worker exists but the share parameter is false, we need to add
+    // one. The caller adds it, and any more it needs to start autoscaling,
+    // like it creates new ones
+    if (autoscalers_.find(endpoint) != autoscalers_.end()) {
+      load->min_workers = 0;
+    }
+    if (!options.share || worker_info->getGroupSize() < load->min_workers) {
+      load->create = true;
+      load->name = worker_name;
+      load->add = !options.share;
+      load->worker = workers_.at(endpoint);
+      creating_.try_emplace(endpoint);
+      return endpoint;
+    }
+    this->unsafeConfigure(endpoint, options, parameters);
+  } catch (...) {
+    // undo the load if the worker creation fails
+    this->unsafeUnload(endpoint);
+    throw;
+  }
+  return endpoint;
+}
+
+std::string Endpoints::unsafeCommit(const std::string& endpoint,
+                                    LoadRequest* request) {
+  // the autoscaler tries again later if it can't add a worker
+  if (request->autoscaled) {
+    if (request->eptr != nullptr) {
+      std::rethrow_exception(request->eptr);
     }
+    return endpoint;
+  }
+  try {
+    if (request->eptr != nullptr) {
+      std::rethrow_exception(request->eptr);
+    }
+    this->workers_.try_emplace(endpoint, std::move(request->worker));
+    this->unsafeConfigure(endpoint, request->options.value(),
+                          request->parameters);
   } catch (...) {
     // undo the load if the worker creation fails
     this->unsafeUnload(endpoint);
@@ -288,20 +647,209 @@ std::string Endpoints::unsafeLoad(const std::string& worker,
   return endpoint;
 }
 
+void Endpoints::unsafeConfigure(const std::string& endpoint,
+                                const LoadOptions& options,
+                                ParameterMap* parameters) {
+  // the first load to ask for autoscaling sets its bounds
+  const auto& autoscaling = options.autoscaling;
+  if (autoscaling.has_value() &&
+      autoscalers_.find(endpoint) == autoscalers_.end()) {
+    auto* worker_info = this->unsafeGet(endpoint);
+    // the load already started its minimum of workers
+    autoscalers_.try_emplace(
+      endpoint,
+      Scaling{Autoscaler{*autoscaling}, *parameters, worker_info->getBusyTime(),
+              std::chrono::steady_clock::now()});
+  }
+
+  // the first load to ask for a cache sets its size
+  if (options.cache_size > 0 && caches_.find(endpoint) == caches_.end()) {
+    caches_.try_emplace(endpoint,
+                        std::make_shared<ResponseCache>(options.cache_size));
+  }
+  if (options.single_flight && flights_.find(endpoint) == flights_.end()) {
+    flights_.try_emplace(endpoint, std::make_shared<SingleFlight>());
+  }
+
+  // and the first to ask for admission limits sets them
+  if (options.admission.has_value() &&
+      admissions_.find(endpoint) == admissions_.end()) {
+    admissions_.try_emplace(
+      endpoint, std::make_shared<AdmissionControl>(*options.admission));
+  }
+}
+
+void Endpoints::resume(const std::string& endpoint) {
+  auto found = creating_.find(endpoint);
+  if (found == creating_.end()) {
+    return;
+  }
+  auto waiting = std::move(found->second);
+  creating_.erase(found);
+  for (auto& request : waiting) {
+    update_queue_.enqueue(std::move(request));
+  }
+}
+
+std::string Endpoints::unsafeLoadEnsemble(
+  std::shared_ptr<const Ensemble> ensemble) {
+  const auto& endpoint = ensemble->getName();
+  // loading the same ensemble again shares it like its models' endpoints
+  if (ensembles_.find(endpoint) != ensembles_.end()) {
+    return endpoint;
+  }
+  if (workers_.find(endpoint) != workers_.end()) {
+    throw invalid_argument("The ensemble " + endpoint +
+                           " can't have the name of one of its models");
+  }
+  for (const auto& model : ensemble->getEndpoints()) {
+    if (this->unsafeGet(model) == nullptr) {
+      throw invalid_argument("No endpoint found at: " + model);
+    }
+  }
+  auto name = endpoint;
+  ensembles_.try_emplace(name, std::move(ensemble));
+  return name;
+}
+
+void Endpoints::unsafeSwap(const std::string& model, SwapRequest* request) {
+  const auto& endpoint = request->endpoint;
+  if (this->unsafeGet(endpoint) == nullptr &&
+      ensembles_.find(endpoint) == ensembles_.end()) {
+    throw invalid_argument("No endpoint found at: " + endpoint);
+  }
+
+  std::string previous;
+  if (auto found = aliases_.find(model); found != aliases_.end()) {
+    previous = found->second;
+  } else if (this->unsafeGet(model) != nullptr ||
+             ensembles_.find(model) != ensembles_.end()) {
+    previous = model;
+  }
+
+  if (model == endpoint) {
+    aliases_.erase(model);
+  } else {
+    aliases_.insert_or_assign(model, endpoint);
+  }
+  if (previous == endpoint) {
+    return;
+  }
+
+  request->previous = previous;
+  if (auto found = workers_.find(previous); found != workers_.end()) {
+    request->previous_worker = found->second;
+  }
+  request->quiet = kDrainQuiet;
+  if (auto found = worker_parameters_.find(previous);
+      found != worker_parameters_.end() && found->second.has("timeout")) {
+    const auto timeout = found->second.get<int32_t>("timeout");
+    request->quiet =
+      std::max(request->quiet, std::chrono::milliseconds(2 * timeout));
+  }
+}
+
+void Endpoints::unsafeUpdate(const std::string& model,
+                             const ParameterMap& parameters) {
+  // a swapped model is served by the endpoint it's an alias of
+  const auto found_alias = aliases_.find(model);
+  const auto& endpoint =
+    found_alias != aliases_.end() ? found_alias->second : model;
+  auto* worker_info = this->unsafeGet(endpoint);
+  if (worker_info == nullptr || creating_.find(endpoint) != creating_.end()) {
+    throw invalid_argument("No endpoint found at: " + endpoint);
+  }
+
+  // the batch size is checked against the workers' so set it first, before
+  // anything else changes. The workers keep the batch size they were loaded
+  // with, which bounds the batchers', so it's not part of the identity and a
+  // new batch size in the model's config still reloads it
+  if (parameters.has("batch_size")) {
+    worker_info->setBatcherBatchSize(parameters.get<int32_t>("batch_size"));
+  }
+
+  auto identity = worker_parameters_.at(endpoint);
+  for (const auto& [key, value] : parameters) {
+    if (!isUpdatable(key)) {
+      continue;
+    }
+    if (key == "timeout") {
+      worker_info->setBatcherTimeout(parameters.get<int32_t>(key));
+    }
+    identity.put(key, value);
+  }
+
+  // keep the endpoint's identity in step with its workers so loads with the
+  // new parameters find it and the ones with the old parameters don't
+  auto hyphen_pos = endpoint.find('-');
+  auto worker =
+    hyphen_pos != std::string::npos ? endpoint.substr(0, hyphen_pos) : endpoint;
+  auto& map = worker_endpoints_.at(worker);
+  if (map.find(identity) != map.end()) {
+    // another endpoint already has these parameters so this one keeps its own
+    return;
+  }
+  for (auto iterator = map.begin(); iterator != map.end(); ++iterator) {
+    if (iterator->second == endpoint) {
+      map.erase(iterator);
+      break;
+    }
+  }
+  map.try_emplace(identity, endpoint);
+  worker_parameters_.insert_or_assign(endpoint, identity);
+  if (auto found = autoscalers_.find(endpoint); found != autoscalers_.end()) {
+    for (const auto& [key, value] : parameters) {
+      if (isUpdatable(key)) {
+        found->second.parameters.put(key, value);
+      }
+    }
+  }
+}
+
 void Endpoints::unsafeUnload(const std::string& endpoint) {
+  // unloading a swapped model's name unloads the endpoint serving it, unless
+  // an endpoint of that name is still draining
+  if (auto found = aliases_.find(endpoint);
+      found != aliases_.end() && this->unsafeGet(endpoint) == nullptr &&
+      ensembles_.find(endpoint) == ensembles_.end()) {
+    const auto target = found->second;
+    aliases_.erase(found);
+    this->unsafeUnload(target);
+    return;
+  }
+
+  if (auto found = ensembles_.find(endpoint); found != ensembles_.end()) {
+    const auto models = found->second->getEndpoints();
+    ensembles_.erase(found);
+    eraseAliases(&aliases_, endpoint);
+    for (const auto& model : models) {
+      this->unsafeUnload(model);
+    }
+    return;
+  }
+
   auto hyphen_pos = endpoint.find('-');
   auto worker =
     hyphen_pos != std::string::npos ? endpoint.substr(0, hyphen_pos) : endpoint;
 
   auto* worker_info = this->unsafeGet(endpoint);
   if (worker_info != nullptr) {
-    worker_info->unload();
+    // the group's size belongs to its autoscaler so it's unloaded as a whole
+    if (autoscalers_.erase(endpoint) > 0) {
+      worker_info->shutdown();
+    } else {
+      worker_info->unload();
+    }
   }
 
   // if it's a brand-new worker that failed or the last worker being unloaded,
   // clean up our parameters and endpoint metadata
   if (worker_info == nullptr || worker_info->getGroupSize() == 0) {
     this->workers_.erase(endpoint);
+    this->caches_.erase(endpoint);
+    this->flights_.erase(endpoint);
+    this->admissions_.erase(endpoint);
+    eraseAliases(&aliases_, endpoint);
 
     if (worker_endpoints_.find(worker) != worker_endpoints_.end()) {
       auto& map = worker_endpoints_.at(worker);
@@ -318,10 +866,6 @@ void Endpoints::unsafeUnload(const std::string& endpoint) {
   }
 }
 
-bool Endpoints::unsafeExists(const std::string& endpoint) const {
-  return workers_.find(endpoint) != workers_.end();
-}
-
 WorkerInfo* Endpoints::unsafeGet(const std::string& endpoint) const {
   if (auto iterator = workers_.find(endpoint); iterator != workers_.end()) {
     return iterator->second.get();
@@ -329,36 +873,200 @@ WorkerInfo* Endpoints::unsafeGet(const std::string& endpoint) const {
   return nullptr;
 }
 
-void Endpoints::unsafeList(std::vector<std::string>* list) const {
-  assert(list != nullptr);
-  assert(list->empty());
-  list->reserve(workers_.size());
-  for (const auto& [worker, _] : workers_) {
-    if (!util::startsWith(worker, "responder")) {
-      list->push_back(worker);
-    }
-  }
-}
-
-// FIXME(varunsh): potential race condition if the worker is being deleted
-ModelMetadata Endpoints::unsafeMetadata(const std::string& endpoint) const {
-  const auto* worker = this->unsafeGet(endpoint);
-  if (worker == nullptr) {
-    throw invalid_argument("Worker " + endpoint + " not found");
-  }
-  return worker->getMetadata();
-}
-
 void Endpoints::unsafeShutdown() {
   for (auto const& worker_info : this->workers_) {
     worker_info.second->shutdown();
   }
   this->workers_.clear();
+  this->caches_.clear();
+  this->flights_.clear();
+  this->admissions_.clear();
+  this->ensembles_.clear();
+  this->aliases_.clear();
+  this->autoscalers_.clear();
   this->worker_endpoints_.clear();
   this->worker_indices_.clear();
   this->worker_parameters_.clear();
 }
 
+void Endpoints::unsafeAutoscale() {
+  const auto now = std::chrono::steady_clock::now();
+  for (auto& [endpoint, scaling] : autoscalers_) {
+    auto* worker_info = this->unsafeGet(endpoint);
+    // endpoints that are adding workers are sampled once they're done
+    if (worker_info == nullptr || creating_.find(endpoint) != creating_.end()) {
+      continue;
+    }
+    const auto workers = worker_info->getGroupSize();
+
+    // requests that are still being batched count as the batches they'll fill
+    auto* batcher = worker_info->getBatcher();
+    const auto batch_size = std::max(worker_info->getBatchSize(), size_t{1});
+    const auto depth =
+      static_cast<double>(batcher->getOutputQueue()->size_approx()) +
+      (static_cast<double>(batcher->getInputQueue()->size_approx()) /
+       static_cast<double>(batch_size));
+
+    const std::chrono::duration<double> elapsed = now - scaling.sampled;
+    const std::chrono::duration<double> busy_time =
+      worker_info->getBusyTime() - scaling.busy;
+    double busy = 0;
+    if (elapsed.count() > 0 && workers > 0) {
+      busy = busy_time.count() /
+             (elapsed.count() * static_cast<double>(workers));
+    }
+
+    try {
+      const auto action = scaling.autoscaler.update(depth, busy, workers);
+      if (action > 0) {
+        // the group isn't touched here again until the worker is added
+        scaling.busy = worker_info->getBusyTime();
+        scaling.sampled = now;
+        this->unsafeScaleUp(endpoint, scaling.parameters);
+        continue;
+      }
+      if (action < 0) {
+        worker_info->unload();
+        AMDINFER_LOG_INFO(logger_,
+                          "Autoscaled " + endpoint + " to " +
+                            std::to_string(worker_info->getGroupSize()) +
+                            " workers");
+      }
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_WARN(logger_, "Failed to autoscale " + endpoint + ": " +
+                                   std::string{e.what()});
+    }
+
+    // removed workers take their busy time with them so restart the sample
+    scaling.busy = worker_info->getBusyTime();
+    scaling.sampled = now;
+  }
+}
+
+void Endpoints::unsafeScaleUp(const std::string& endpoint,
+                              ParameterMap parameters) {
+  // commands for the endpoint wait for the worker like they do for a load
+  creating_.try_emplace(endpoint);
+  scalers_.push([this, endpoint, worker = workers_.at(endpoint),
+                 parameters = std::move(parameters)](int) mutable {
+    LoadRequest load;
+    load.parameters = &parameters;
+    load.options = LoadOptions{};
+    load.create = true;
+    load.name = parameters.get<std::string>("worker");
+    load.add = true;
+    load.autoscaled = true;
+    load.worker = worker;
+    try {
+      this->start(endpoint, &load);
+      AMDINFER_LOG_INFO(logger_, "Autoscaled " + endpoint + " to " +
+                                   std::to_string(worker->getGroupSize()) +
+                                   " workers");
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_WARN(logger_, "Failed to autoscale " + endpoint + ": " +
+                                   std::string{e.what()});
+    }
+  });
+}
+
+void Endpoints::publish() {
+  auto table = std::make_shared<Table>();
+  table->reserve(workers_.size());
+  const auto previous = this->snapshot();
+  for (const auto& [endpoint, worker] : workers_) {
+    // an endpoint that's adding workers keeps its entry as they're started
+    if (creating_.find(endpoint) != creating_.end()) {
+      if (auto found = previous->find(endpoint); found != previous->end()) {
+        table->try_emplace(endpoint, found->second);
+      }
+      continue;
+    }
+    if (worker->getGroupSize() > 0) {
+      auto metadata =
+        std::make_shared<const ModelMetadata>(worker->getMetadata());
+      auto bindings =
+        std::make_shared<const TensorBindings>(metadata->getInputs());
+      std::shared_ptr<ResponseCache> cache;
+      if (auto found = caches_.find(endpoint); found != caches_.end()) {
+        cache = found->second;
+      }
+      std::shared_ptr<SingleFlight> flight;
+      if (auto found = flights_.find(endpoint); found != flights_.end()) {
+        flight = found->second;
+      }
+      std::shared_ptr<AdmissionControl> admission;
+      if (auto found = admissions_.find(endpoint); found != admissions_.end()) {
+        admission = found->second;
+      }
+      table->try_emplace(endpoint,
+                         Entry{worker, std::move(metadata), std::move(bindings),
+                               std::move(cache), std::move(flight),
+                               std::move(admission), nullptr});
+    }
+  }
+  for (const auto& [endpoint, _] : creating_) {
+    if (workers_.find(endpoint) == workers_.end()) {
+      Entry entry;
+      entry.loading = true;
+      table->try_emplace(endpoint, std::move(entry));
+    }
+  }
+  for (const auto& [endpoint, ensemble] : ensembles_) {
+    auto metadata =
+      std::make_shared<const ModelMetadata>(ensemble->getMetadata());
+    auto bindings =
+      std::make_shared<const TensorBindings>(metadata->getInputs());
+    table->try_emplace(endpoint,
+                       Entry{nullptr, std::move(metadata), std::move(bindings),
+                             nullptr, nullptr, nullptr, ensemble});
+  }
+  // a swapped model's name serves its new endpoint, even while an endpoint of
+  // that name drains
+  for (const auto& [model, endpoint] : aliases_) {
+    if (auto found = table->find(endpoint); found != table->end()) {
+      auto entry = found->second;
+      table->insert_or_assign(model, std::move(entry));
+    }
+  }
+  std::atomic_store(&table_, std::shared_ptr<const Table>{std::move(table)});
+}
+
+std::shared_ptr<const Endpoints::Table> Endpoints::snapshot() const {
+  return std::atomic_load(&table_);
+}
+
+const Endpoints::Entry& Endpoints::find(const Table& table,
+                                        const std::string& endpoint) {
+  if (auto iterator = table.find(endpoint); iterator != table.end()) {
+    if (iterator->second.loading) {
+      throw invalid_argument("Worker " + endpoint + " is still loading");
+    }
+    return iterator->second;
+  }
+  throw invalid_argument("Worker " + endpoint + " not found");
+}
+
+double Endpoints::getEntryLoad(const Entry& entry, double saturated_batches) {
+  double load = 0;
+  if (entry.admission != nullptr) {
+    load = entry.admission->getLoad();
+  }
+  if (entry.worker == nullptr || saturated_batches <= 0) {
+    return load;
+  }
+  // requests that are still being batched count as the batches they'll fill
+  auto* worker_info = entry.worker.get();
+  auto* batcher = worker_info->getBatcher();
+  const auto batch_size = std::max(worker_info->getBatchSize(), size_t{1});
+  const auto depth =
+    static_cast<double>(batcher->getOutputQueue()->size_approx()) +
+    (static_cast<double>(batcher->getInputQueue()->size_approx()) /
+     static_cast<double>(batch_size));
+  const auto workers =
+    static_cast<double>(std::max(worker_info->getGroupSize(), size_t{1}));
+  return std::max(load, depth / (workers * saturated_batches));
+}
+
 std::string Endpoints::insertWorker(const std::string& worker,
                                     const ParameterMap& parameters) {
   if (worker_endpoints_.find(worker) == worker_endpoints_.end()) {
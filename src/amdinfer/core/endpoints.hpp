@@ -20,25 +20,37 @@
 #ifndef GUARD_AMDINFER_CORE_ENDPOINTS
 #define GUARD_AMDINFER_CORE_ENDPOINTS
 
+#include <chrono>         // for nanoseconds, steady_clock
+#include <cstddef>        // for size_t
 #include <exception>      // for exception_ptr
 #include <map>            // for map
 #include <memory>         // for allocator, uniq...
+#include <optional>       // for optional
 #include <string>         // for string
 #include <thread>         // for thread
 #include <unordered_map>  // for unordered_map
 #include <utility>        // for move
 #include <vector>         // for vector
 
+#include "amdinfer/batching/batcher.hpp"       // for Batcher, BatchPtrQueue
+#include "amdinfer/core/admission.hpp"         // for AdmissionControl
 #include "amdinfer/build_options.hpp"          // for AMDINFER_ENABLE...
+#include "amdinfer/core/autoscaler.hpp"        // for Autoscaler
 #include "amdinfer/core/memory_pool/pool.hpp"  // for MemoryPool
 #include "amdinfer/core/model_metadata.hpp"    // for ModelMetadata
 #include "amdinfer/core/parameters.hpp"        // for ParameterMap
+#include "amdinfer/core/response_cache.hpp"    // for ResponseCache
+#include "amdinfer/core/single_flight.hpp"     // for SingleFlight
+#include "amdinfer/core/tensor_bindings.hpp"   // for TensorBindings
+#include "amdinfer/declarations.hpp"           // for RequestContainerPtr
 #include "amdinfer/observation/logging.hpp"    // for Logger, Loggers
+#include "amdinfer/util/ctpl.hpp"              // for ThreadPool
 #include "amdinfer/util/queue.hpp"             // for BlockingQueue
 
 namespace amdinfer {
 
-class RequestContainer;
+class Ensemble;
+class ModelConfig;
 class WorkerInfo;
 
 /**
@@ -47,11 +59,14 @@ class WorkerInfo;
  */
 enum class UpdateCommandType {
   Load,
+  /// Add a worker that a Load left to its caller to create
+  Commit,
+  LoadEnsemble,
+  /// Point a model's name at another of its endpoints
+  Swap,
+  /// Change the parameters of an endpoint that can change while it runs
+  Update,
   Unload,
-  Exists,
-  Ready,
-  List,
-  Metadata,
   Shutdown,
 };
 
@@ -86,24 +101,125 @@ class Endpoints {
   Endpoints();
   ~Endpoints();
 
+  /**
+   * @brief Load a worker and wait until it's ready. A new worker is created on
+   * the calling thread, not the manager's, so loads from many threads run in
+   * parallel while the manager still adds them to the endpoints one by one.
+   * Loads of an endpoint that's still being created wait for it. Until its
+   * first workers are created, the endpoint is loading: it's not ready and
+   * requests to it are refused but the other endpoints aren't held up.
+   *
+   * @param worker the worker to load
+   * @param version the version of the worker
+   * @param parameters load-time parameters for the worker
+   * @return std::string the endpoint of the worker
+   */
   std::string load(const std::string& worker, const std::string& version,
                    ParameterMap parameters);
+  /**
+   * @brief Load an ensemble whose models form a DAG. Its models must already
+   * be loaded. Requests to the ensemble are scheduled across the models'
+   * endpoints and unloading it unloads them.
+   *
+   * @param ensemble the name of the ensemble
+   * @param version the version of the ensemble
+   * @param config the configuration of the ensemble's models
+   * @param endpoints the endpoint each model of the config was loaded at
+   * @return std::string the endpoint of the ensemble
+   */
+  std::string loadEnsemble(const std::string& ensemble,
+                           const std::string& version,
+                           const ModelConfig& config,
+                           std::vector<std::string> endpoints);
   void unload(const std::string& endpoint, const std::string& version);
+  /**
+   * @brief Atomically point requests for a model's name, i.e. without a
+   * version, at another loaded endpoint such as a new version of the model.
+   * The endpoint that served the name before stops getting new requests, its
+   * queued requests are drained and then it's unloaded. Requests are never
+   * refused in between. Returns once the old endpoint is unloaded.
+   *
+   * @param model the name of the model
+   * @param endpoint the endpoint to serve the model's name, such as the
+   * versioned endpoint of a new version
+   */
+  void swap(const std::string& model, const std::string& endpoint);
+  /**
+   * @brief Change load-time parameters of a loaded endpoint that take effect
+   * without reloading it. Parameters that can't be updated are ignored. The
+   * endpoint keeps its name and later loads with the new parameters share it.
+   * The batchers' batch_size can also be changed, up to the batch size the
+   * workers were loaded with, and applies from the next batch. Throws
+   * invalid_argument if the endpoint isn't loaded or the batch size is
+   * invalid.
+   *
+   * @param endpoint the endpoint
+   * @param parameters the new values of the parameters to change
+   */
+  void update(const std::string& endpoint, const ParameterMap& parameters);
+  /// Check if a load-time parameter can be changed with update()
+  static bool isUpdatable(const std::string& key);
 
-  void infer(const std::string& endpoint,
-             std::unique_ptr<RequestContainer> request,
+  void infer(const std::string& endpoint, RequestContainerPtr request,
              const std::string& version) const;
+  /**
+   * @brief Admit a request to an endpoint loaded with admission limits before
+   * it's decoded. Throws resource_exhausted_error if the endpoint has no room
+   * for it. Requests to other endpoints, including ones that aren't loaded,
+   * are always admitted.
+   *
+   * @param endpoint the endpoint
+   * @param version the version of the endpoint
+   * @param bytes size of the request as it arrived
+   * @return std::shared_ptr<void> a ticket to hold with holdTicket or null if
+   * the endpoint has no limits
+   */
+  std::shared_ptr<void> admit(const std::string& endpoint,
+                              const std::string& version, size_t bytes) const;
 
-  bool exists(const std::string& endpoint);
-  // WorkerInfo* get(const std::string& endpoint);
-  bool ready(const std::string& endpoint, const std::string& version);
+  /// Check if an endpoint is loaded. Endpoints that are still loading aren't
+  bool exists(const std::string& endpoint) const;
+  /// Check if an endpoint's first workers are still being created
+  bool loading(const std::string& endpoint) const;
+  bool ready(const std::string& endpoint, const std::string& version) const;
+  /**
+   * @brief Get how saturated an endpoint is. It's the larger of the fraction
+   * of its admission limits in flight and its queued batches per worker over
+   * the depth at which it's saturated, so 1 or more means it's saturated.
+   * Ensembles report 0 as their models are endpoints of their own.
+   *
+   * @param endpoint the endpoint
+   * @param version the version of the endpoint
+   * @param saturated_batches queued batches per worker that saturate it
+   * @return double
+   */
+  double getLoad(const std::string& endpoint, const std::string& version,
+                 double saturated_batches) const;
+  /// Get the load of the most saturated endpoint. See getLoad
+  double getLoad(double saturated_batches) const;
 
-  std::vector<std::string> list();
+  std::vector<std::string> list() const;
   ModelMetadata metadata(const std::string& endpoint,
-                         const std::string& version);
+                         const std::string& version) const;
+  /**
+   * @brief Get the metadata published for an endpoint without copying it. The
+   * object is replaced, not modified, when the endpoint changes so values
+   * derived from it can be cached with MetadataCache.
+   */
+  std::shared_ptr<const ModelMetadata> publishedMetadata(
+    const std::string& endpoint, const std::string& version) const;
 
   const MemoryPool* getPool() const;
 
+  /**
+   * @brief Restrict the workers and batchers started afterwards to a set of
+   * CPUs unless they're loaded with the cpus or numa_node parameters. They
+   * inherit it from the thread that starts them.
+   *
+   * @param cpus the CPUs they may run on
+   */
+  void setWorkerCpus(const std::vector<int>& cpus);
+
   void shutdown();
 
  private:
@@ -115,11 +231,118 @@ class Endpoints {
   // endpoint -> parameters
   std::unordered_map<std::string, ParameterMap> worker_parameters_;
   // endpoint -> Worker_Info*
-  std::unordered_map<std::string, std::unique_ptr<WorkerInfo>> workers_;
+  std::unordered_map<std::string, std::shared_ptr<WorkerInfo>> workers_;
+  // endpoint -> ResponseCache* for endpoints loaded with a cache
+  std::unordered_map<std::string, std::shared_ptr<ResponseCache>> caches_;
+  // endpoint -> SingleFlight* for endpoints that coalesce identical requests
+  std::unordered_map<std::string, std::shared_ptr<SingleFlight>> flights_;
+  // endpoint -> AdmissionControl* for endpoints loaded with admission limits
+  std::unordered_map<std::string, std::shared_ptr<AdmissionControl>>
+    admissions_;
+  // endpoint -> Ensemble* for ensembles whose models form a DAG
+  std::unordered_map<std::string, std::shared_ptr<const Ensemble>> ensembles_;
+  // model -> endpoint for models whose name was swapped to another endpoint
+  std::unordered_map<std::string, std::string> aliases_;
+
+  /// An endpoint whose number of workers is set by an autoscaler
+  struct Scaling {
+    Autoscaler autoscaler;
+    /// Used to start the workers that are added
+    ParameterMap parameters;
+    /// The busy time of the group when it was last sampled
+    std::chrono::nanoseconds busy;
+    std::chrono::steady_clock::time_point sampled;
+  };
+  // endpoint -> Scaling for endpoints loaded with autoscaling
+  std::unordered_map<std::string, Scaling> autoscalers_;
+
+  /// The options of a load that aren't part of the endpoint's identity
+  struct LoadOptions {
+    bool share = true;
+    size_t cache_size = 0;
+    bool single_flight = false;
+    std::optional<AutoscalerOptions> autoscaling;
+    std::optional<AdmissionOptions> admission;
+  };
+  /**
+   * @brief What the manager thread and the caller of a load share. The object
+   * of a Load command points to one. If the worker is new, the manager
+   * reserves its endpoint and sets the worker's arguments here for the caller
+   * to create it and send it back with a Commit command.
+   */
+  struct LoadRequest {
+    ParameterMap* parameters = nullptr;
+    /// Taken out of the parameters the first time the manager sees the load
+    std::optional<LoadOptions> options;
+
+    // set by the manager if the caller must create the worker or add to it
+    bool create = false;
+    std::string name;
+    /// Add a worker to the existing group, which is set as the worker
+    bool add = false;
+    /// Add workers until the group has at least this many
+    size_t min_workers = 0;
+    /// Set for scale-ups by the autoscaler, which aren't undone if they fail
+    bool autoscaled = false;
+    BatchPtrQueue* next = nullptr;
+    std::vector<MemoryAllocators> next_allocators;
+    const Batcher* next_batcher = nullptr;
+
+    // set by the caller after creating it, unless the worker exists
+    std::shared_ptr<WorkerInfo> worker;
+    std::exception_ptr eptr = nullptr;
+  };
+  /**
+   * @brief endpoint -> commands waiting for the endpoint's worker to be
+   * created or added to. They're queued again once it's committed.
+   */
+  std::unordered_map<std::string, std::vector<std::shared_ptr<UpdateCommand>>>
+    creating_;
+
+  /// What the manager thread and the caller of a swap share
+  struct SwapRequest {
+    std::string endpoint;
+
+    // set by the manager to the endpoint that served the model before
+    std::string previous;
+    /// Null if the previous endpoint is an ensemble
+    std::shared_ptr<WorkerInfo> previous_worker;
+    /// How long its queues must stay empty to be drained
+    std::chrono::milliseconds quiet{0};
+  };
+
+  /// What readers see of a loaded endpoint
+  struct Entry {
+    /// Null if the endpoint is an ensemble
+    std::shared_ptr<WorkerInfo> worker;
+    std::shared_ptr<const ModelMetadata> metadata;
+    /// Made from the metadata to bind incoming requests to the model
+    std::shared_ptr<const TensorBindings> bindings;
+    /// Null unless the endpoint was loaded with a response cache
+    std::shared_ptr<ResponseCache> cache;
+    /// Null unless the endpoint was loaded with single-flight coalescing
+    std::shared_ptr<SingleFlight> flight;
+    /// Null unless the endpoint was loaded with admission limits
+    std::shared_ptr<AdmissionControl> admission;
+    /// Null unless the endpoint is an ensemble
+    std::shared_ptr<const Ensemble> ensemble;
+    /// Set while the endpoint's first workers are created. Nothing else is
+    bool loading = false;
+  };
+  using Table = std::unordered_map<std::string, Entry>;
+  /**
+   * @brief An immutable snapshot of the endpoints for readers. The manager
+   * thread publishes a new one after each change so lookups don't go through
+   * the update queue. Readers that hold an old snapshot keep its workers
+   * alive until they're done with them. Always access it atomically.
+   */
+  std::shared_ptr<const Table> table_;
   /// A queue used to sequentially order changes to the Manager state
   UpdateCommandQueue update_queue_;
   std::thread update_thread_;
   MemoryPool pool_;
+  /// Adds the workers of autoscaled endpoints off the manager thread
+  util::ThreadPool scalers_;
 #ifdef AMDINFER_ENABLE_LOGGING
   Logger logger_{Loggers::Server};
 #endif
@@ -136,17 +359,54 @@ class Endpoints {
   std::string insertWorker(const std::string& worker,
                            const ParameterMap& parameters);
 
-  std::string unsafeLoad(const std::string& worker, ParameterMap* parameters);
+  /**
+   * @brief Load a worker. If the worker is new, its endpoint is reserved and
+   * the request is set for the caller to create it. If it's being created by
+   * another load, the command waits for it and nothing is returned.
+   *
+   * @param request the Load command
+   * @return std::optional<std::string> the endpoint, if the command is done
+   */
+  std::optional<std::string> unsafeLoad(
+    const std::shared_ptr<UpdateCommand>& request);
+  /**
+   * @brief Create or add to the workers that the manager left to a load on the
+   * calling thread and commit them
+   *
+   * @param endpoint the endpoint the manager reserved
+   * @param request the load
+   * @return std::string the endpoint
+   */
+  std::string start(const std::string& endpoint, LoadRequest* request);
+  /// Add the worker that the caller of a load created
+  std::string unsafeCommit(const std::string& endpoint, LoadRequest* request);
+  /// Apply the options of a load to its endpoint after its worker exists
+  void unsafeConfigure(const std::string& endpoint, const LoadOptions& options,
+                       ParameterMap* parameters);
+  /// Queue the commands that were waiting for an endpoint to be created
+  void resume(const std::string& endpoint);
+  std::string unsafeLoadEnsemble(std::shared_ptr<const Ensemble> ensemble);
+  void unsafeSwap(const std::string& model, SwapRequest* request);
+  void unsafeUpdate(const std::string& model,
+                    const ParameterMap& parameters);
   void unsafeUnload(const std::string& endpoint);
 
-  bool unsafeExists(const std::string& endpoint) const;
   WorkerInfo* unsafeGet(const std::string& endpoint) const;
-  // bool unsafeReady(const std::string& endpoint) const;
-
-  void unsafeList(std::vector<std::string>* list) const;
-  ModelMetadata unsafeMetadata(const std::string& endpoint) const;
 
   void unsafeShutdown();
+
+  /// Sample the autoscaled endpoints and add or remove workers from them
+  void unsafeAutoscale();
+  /// Add a worker to an autoscaled endpoint in the background
+  void unsafeScaleUp(const std::string& endpoint, ParameterMap parameters);
+
+  /// Publish a new snapshot of the endpoints. Only the manager thread calls it
+  void publish();
+  /// Get the current snapshot of the endpoints
+  std::shared_ptr<const Table> snapshot() const;
+  /// Look up a loaded endpoint in a snapshot, throwing if it's not there
+  static const Entry& find(const Table& table, const std::string& endpoint);
+  static double getEntryLoad(const Entry& entry, double saturated_batches);
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,293 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the scheduler for ensembles whose models form a DAG
+ */
+
+#include "amdinfer/core/ensemble.hpp"
+
+#include <algorithm>      // for find_if, any_of
+#include <cassert>        // for assert
+#include <exception>      // for exception
+#include <mutex>          // for mutex, lock_guard
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+
+#include "amdinfer/buffers/buffer.hpp"           // for Buffer
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_TRACING
+#include "amdinfer/core/endpoints.hpp"           // for Endpoints
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/model_config.hpp"        // for ModelConfig
+#include "amdinfer/core/request_container.hpp"   // for RequestContainer
+#include "amdinfer/observation/tracing.hpp"      // for startTrace
+
+namespace amdinfer {
+
+/// The state of one request as it runs through the ensemble
+struct Ensemble::Run {
+  RequestContainerPtr request;
+  std::mutex mutex;
+  /// The outputs consumed by other models by ID
+  std::unordered_map<std::string, InferenceResponseOutput> tensors;
+  /// The number of models each model is still waiting on
+  std::vector<size_t> waiting;
+  /// The number of models that haven't responded
+  size_t pending = 0;
+  /// Collects the outputs sent to the client
+  InferenceResponse response;
+  bool done = false;
+};
+
+Ensemble::Ensemble(std::string name, const ModelConfig& config,
+                   std::vector<std::string> endpoints, const Endpoints* server,
+                   const MemoryPool* pool)
+  : name_(std::move(name)),
+    endpoints_(std::move(endpoints)),
+    stages_(config.size()),
+    server_(server),
+    pool_(pool) {
+  assert(endpoints_.size() == config.size());
+
+  // output ID -> the models consuming it
+  std::unordered_map<std::string, size_t> consumers;
+  for (auto i = 0U; i < config.size(); ++i) {
+    const auto& parents = config.getParents(i);
+    auto& stage = stages_[i];
+    stage.parents = parents.size();
+    for (auto parent : parents) {
+      stages_[parent].children.push_back(i);
+    }
+
+    for (const auto& input : config.getConfig(i).inputs) {
+      const auto& id = input.id();
+      const auto produced =
+        std::any_of(parents.begin(), parents.end(), [&](size_t parent) {
+          const auto& outputs = config.getConfig(parent).outputs;
+          return std::any_of(
+            outputs.begin(), outputs.end(),
+            [&](const ModelConfigTensor& output) { return output.id() == id; });
+        });
+      if (produced) {
+        consumers[id]++;
+        stage.inputs.push_back({input.getName(), id, 0});
+        continue;
+      }
+
+      // models taking the same client input share the ensemble's input
+      const auto& input_name = input.getName();
+      auto found =
+        std::find_if(inputs_.begin(), inputs_.end(), [&](const Tensor& tensor) {
+          return tensor.getName() == input_name;
+        });
+      if (found == inputs_.end()) {
+        inputs_.emplace_back(input_name, input.getShape(),
+                             input.getDatatype());
+        found = inputs_.end() - 1;
+      }
+      stage.inputs.push_back(
+        {input_name, "", static_cast<size_t>(found - inputs_.begin())});
+    }
+  }
+
+  for (auto i = 0U; i < config.size(); ++i) {
+    for (const auto& output : config.getConfig(i).outputs) {
+      if (consumers.find(output.id()) != consumers.end()) {
+        stages_[i].outputs.emplace_back(output.getName(), output.id());
+      } else {
+        stages_[i].outputs.emplace_back(output.getName(), "");
+        outputs_.emplace_back(output.getName(), output.getShape(),
+                              output.getDatatype());
+      }
+    }
+  }
+}
+
+const std::string& Ensemble::getName() const { return name_; }
+
+const std::vector<std::string>& Ensemble::getEndpoints() const {
+  return endpoints_;
+}
+
+ModelMetadata Ensemble::getMetadata() const {
+  ModelMetadata metadata{name_, "ensemble"};
+  for (const auto& input : inputs_) {
+    metadata.addInputTensor(input);
+  }
+  for (const auto& output : outputs_) {
+    metadata.addOutputTensor(output);
+  }
+  metadata.setReady(true);
+  return metadata;
+}
+
+void Ensemble::infer(RequestContainerPtr request) const {
+  if (request->request->getInputs().size() < inputs_.size()) {
+    throw invalid_argument("The ensemble " + name_ + " needs " +
+                           std::to_string(inputs_.size()) + " inputs");
+  }
+
+  auto run = std::make_shared<Run>();
+  run->request = std::move(request);
+  run->pending = stages_.size();
+  run->waiting.reserve(stages_.size());
+  for (const auto& stage : stages_) {
+    run->waiting.push_back(stage.parents);
+  }
+
+  for (auto i = 0U; i < stages_.size(); ++i) {
+    if (stages_[i].parents == 0) {
+      this->launch(run, i);
+    }
+  }
+}
+
+void Ensemble::launch(const std::shared_ptr<Run>& run, size_t stage) const {
+  const auto& client = *run->request->request;
+  auto request = std::make_shared<InferenceRequest>();
+  try {
+    std::lock_guard lock{run->mutex};
+    if (run->done) {
+      return;
+    }
+    // each model gets its own copy because its batcher returns the memory of
+    // its requests to the pool
+    const auto& inputs = client.getInputs();
+    request->reserveTensors(stages_[stage].inputs.size(), 0);
+    for (const auto& source : stages_[stage].inputs) {
+      if (source.id.empty()) {
+        const auto& input = inputs[source.input];
+        auto buffer = pool_->get({MemoryAllocators::Cpu}, input, 1);
+        buffer->write(input.getData(), 0,
+                      input.getSize() * input.getDatatype().size());
+        request->addInputTensor(buffer->data(0), input.getShape(),
+                                input.getDatatype(), source.name);
+      } else {
+        const auto& output = run->tensors.at(source.id);
+        auto buffer = pool_->get({MemoryAllocators::Cpu}, output, 1);
+        buffer->write(output.getData(), 0,
+                      output.getSize() * output.getDatatype().size());
+        request->addInputTensor(buffer->data(0), output.getShape(),
+                                output.getDatatype(), source.name);
+      }
+    }
+  } catch (const std::exception& e) {
+    for (const auto& input : request->getInputs()) {
+      pool_->put(MemoryAllocators::Cpu, input.getData());
+    }
+    this->fail(run, "Failed to prepare the request for " + endpoints_[stage] +
+                      ": " + e.what());
+    return;
+  }
+
+  request->setID(client.getID());
+  request->setParameters(client.getParameters());
+  request->setCallback(
+    [self = this->shared_from_this(), run,
+     stage](const InferenceResponse& response) {
+      self->complete(run, stage, response);
+    });
+
+  auto container = makeRequestContainer();
+  container->request = std::move(request);
+  container->deadline = run->request->deadline;
+#ifdef AMDINFER_ENABLE_TRACING
+  container->trace = startTrace(endpoints_[stage]);
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  container->start_time = run->request->start_time;
+#endif
+  try {
+    server_->infer(endpoints_[stage], std::move(container), "");
+  } catch (const std::exception& e) {
+    this->fail(run, e.what());
+  }
+}
+
+void Ensemble::complete(const std::shared_ptr<Run>& run, size_t stage,
+                        const InferenceResponse& response) const {
+  if (response.isError()) {
+    this->fail(run, response.getError());
+    return;
+  }
+
+  std::vector<size_t> ready;
+  bool finished = false;
+  {
+    std::lock_guard lock{run->mutex};
+    if (run->done) {
+      return;
+    }
+    const auto& outputs = stages_[stage].outputs;
+    for (const auto& output : response.getOutputs()) {
+      auto found =
+        std::find_if(outputs.begin(), outputs.end(), [&](const auto& pair) {
+          return pair.first == output.getName();
+        });
+      if (found == outputs.end()) {
+        continue;
+      }
+      if (found->second.empty()) {
+        run->response.addOutput(output);
+      } else {
+        run->tensors.insert_or_assign(found->second, output);
+      }
+    }
+    for (auto child : stages_[stage].children) {
+      if (--run->waiting[child] == 0) {
+        ready.push_back(child);
+      }
+    }
+    finished = --run->pending == 0;
+    run->done = finished;
+  }
+
+  for (auto child : ready) {
+    this->launch(run, child);
+  }
+
+  if (finished) {
+    auto& client = *run->request->request;
+    run->response.setID(client.getID());
+    run->response.setModel(name_);
+    client.runCallbackOnce(run->response);
+    this->release(*run);
+  }
+}
+
+void Ensemble::fail(const std::shared_ptr<Run>& run,
+                    const std::string& error) const {
+  {
+    std::lock_guard lock{run->mutex};
+    if (run->done) {
+      return;
+    }
+    run->done = true;
+  }
+  run->request->request->runCallbackError("Ensemble " + name_ +
+                                          " failed: " + error);
+  this->release(*run);
+}
+
+void Ensemble::release(const Run& run) const {
+  for (const auto& input : run.request->request->getInputs()) {
+    pool_->put(MemoryAllocators::Cpu, input.getData());
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,126 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the scheduler for ensembles whose models form a DAG
+ */
+
+#ifndef GUARD_AMDINFER_CORE_ENSEMBLE
+#define GUARD_AMDINFER_CORE_ENSEMBLE
+
+#include <cstddef>  // for size_t
+#include <memory>   // for enable_shared_from_this, shared_ptr
+#include <string>   // for string
+#include <utility>  // for pair
+#include <vector>   // for vector
+
+#include "amdinfer/core/model_metadata.hpp"  // for ModelMetadata
+#include "amdinfer/core/tensor.hpp"          // for Tensor
+#include "amdinfer/declarations.hpp"         // for RequestContainerPtr
+
+namespace amdinfer {
+
+class Endpoints;
+class InferenceResponse;
+class MemoryPool;
+class ModelConfig;
+
+/**
+ * @brief Runs requests through an ensemble whose models form a DAG. Each model
+ * is loaded as its own endpoint so it batches its requests independently. A
+ * model is sent its part of a request once every model it depends on has
+ * responded so independent branches run in parallel and branches are joined
+ * per request before the models that consume them.
+ */
+class Ensemble : public std::enable_shared_from_this<Ensemble> {
+ public:
+  /**
+   * @brief Construct a new Ensemble object
+   *
+   * @param name the endpoint of the ensemble
+   * @param config the configuration of the ensemble's models
+   * @param endpoints the endpoint each model of the config was loaded at
+   * @param server the endpoints to send the models' requests to
+   * @param pool the memory pool to copy the models' inputs into
+   */
+  Ensemble(std::string name, const ModelConfig& config,
+           std::vector<std::string> endpoints, const Endpoints* server,
+           const MemoryPool* pool);
+
+  [[nodiscard]] const std::string& getName() const;
+  /// Get the endpoints of the ensemble's models
+  [[nodiscard]] const std::vector<std::string>& getEndpoints() const;
+  /**
+   * @brief Get the metadata of the ensemble. Its inputs are the models' inputs
+   * that come from the client and its outputs are the models' outputs that no
+   * model consumes.
+   *
+   * @return ModelMetadata
+   */
+  [[nodiscard]] ModelMetadata getMetadata() const;
+
+  /**
+   * @brief Start running a request through the ensemble. Its inputs must be
+   * bound to the ensemble's inputs. The request's callback is run once when
+   * every model has responded or when the first one fails.
+   *
+   * @param request the request
+   */
+  void infer(RequestContainerPtr request) const;
+
+ private:
+  /// Where one input of a model comes from
+  struct Source {
+    std::string name;
+    /// The ID of the output it consumes or empty if it comes from the client
+    std::string id;
+    /// The index of the ensemble's input if it comes from the client
+    size_t input;
+  };
+
+  struct Stage {
+    std::vector<Source> inputs;
+    /// The IDs of the outputs by name. Outputs sent to the client have no ID
+    std::vector<std::pair<std::string, std::string>> outputs;
+    /// The models that consume this model's outputs
+    std::vector<size_t> children;
+    /// The number of models this model consumes outputs from
+    size_t parents = 0;
+  };
+
+  struct Run;
+
+  /// Send one model its request, failing the run if it can't be sent
+  void launch(const std::shared_ptr<Run>& run, size_t stage) const;
+  /// Handle one model's response and launch the models that were waiting on it
+  void complete(const std::shared_ptr<Run>& run, size_t stage,
+                const InferenceResponse& response) const;
+  /// Respond to the client with an error if nothing has responded yet
+  void fail(const std::shared_ptr<Run>& run, const std::string& error) const;
+  /// Return the client's input memory to the pool
+  void release(const Run& run) const;
+
+  std::string name_;
+  std::vector<std::string> endpoints_;
+  std::vector<Stage> stages_;
+  std::vector<Tensor> inputs_;
+  std::vector<Tensor> outputs_;
+  const Endpoints* server_;
+  const MemoryPool* pool_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_ENSEMBLE
@@ -19,17 +19,50 @@
 
 #include "amdinfer/core/inference_request.hpp"
 
+#include <cassert>  // for assert
+#include <cstring>  // for memcpy
+
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/stream_flow.hpp"         // for StreamFlow
 #include "amdinfer/util/containers.hpp"          // for containerProduct
 #include "amdinfer/util/memory.hpp"              // for copy
 
 namespace amdinfer {
 
+InferenceRequest::InferenceRequest(const InferenceRequest &other)
+  : id_(other.id_),
+    parameters_(other.parameters_),
+    inputs_(other.inputs_),
+    outputs_(other.outputs_),
+    cancelled_(other.cancelled_) {}
+
+InferenceRequest &InferenceRequest::operator=(const InferenceRequest &other) {
+  if (this != &other) {
+    id_ = other.id_;
+    parameters_ = other.parameters_;
+    inputs_ = other.inputs_;
+    outputs_ = other.outputs_;
+    callback_ = nullptr;
+    timing_ = nullptr;
+    usage_ = nullptr;
+    flow_ = nullptr;
+    executor_ = nullptr;
+    cancelled_ = other.cancelled_;
+  }
+  return *this;
+}
+
 InferenceRequestPtr InferenceRequest::propagate() {
   auto new_request = std::make_shared<InferenceRequest>();
   new_request->setCallback(this->getCallback());
+  new_request->setExecutor(executor_);
   new_request->setID(this->getID());
-  const auto outputs = this->getOutputs();
+  new_request->setCancellation(cancelled_);
+  new_request->setStreamFlow(flow_);
+  new_request->setUsage(usage_);
+  new_request->setParameters(parameters_);
+  const auto &outputs = this->getOutputs();
   for (const auto &output : outputs) {
     new_request->addOutputTensor(output);
   }
@@ -44,9 +77,10 @@ void InferenceRequest::setCallback(Callback &&callback) {
 Callback InferenceRequest::getCallback() { return std::move(callback_); }
 
 void InferenceRequest::runCallbackOnce(const InferenceResponse &response) {
-  if (this->callback_ != nullptr) {
-    (this->callback_)(response);
-    this->callback_ = nullptr;
+  // moving the callback out clears it, even if running it throws
+  auto callback = std::move(this->callback_);
+  if (callback != nullptr) {
+    callback(response);
   }
 }
 
@@ -58,8 +92,37 @@ void InferenceRequest::runCallbackError(std::string_view error_msg) {
   this->runCallback(InferenceResponse(std::string{error_msg}));
 }
 
-void InferenceRequest::addInputTensor(void *data,
-                                      const std::vector<int64_t> &shape,
+void InferenceRequest::setCancellation(
+  std::shared_ptr<const std::atomic_bool> cancelled) {
+  cancelled_ = std::move(cancelled);
+}
+
+bool InferenceRequest::isCancelled() const {
+  return cancelled_ != nullptr && cancelled_->load(std::memory_order_relaxed);
+}
+
+void InferenceRequest::setStreamFlow(std::shared_ptr<StreamFlow> flow) {
+  flow_ = std::move(flow);
+}
+
+bool InferenceRequest::acquireStreamCredit() const {
+  return flow_ == nullptr || flow_->acquire();
+}
+
+void InferenceRequest::setServerTiming(std::shared_ptr<ServerTiming> timing) {
+  timing_ = std::move(timing);
+}
+
+void InferenceRequest::setUsage(std::shared_ptr<RequestUsage> usage) {
+  usage_ = std::move(usage);
+}
+
+void InferenceRequest::setExecutor(
+  std::shared_ptr<CompletionExecutor> executor) {
+  executor_ = std::move(executor);
+}
+
+void InferenceRequest::addInputTensor(void *data, const Shape &shape,
                                       DataType data_type,
                                       const std::string &name) {
   this->inputs_.emplace_back(data, shape, data_type, name);
@@ -73,26 +136,80 @@ void InferenceRequest::setInputTensorData(size_t index, void *data) {
   if (index < inputs_.size()) {
     auto &input = inputs_.at(index);
     input.setData(data);
+    // new data is always dense
+    input.setStrides({});
+  }
+}
+
+void InferenceRequest::setInputTensorShape(size_t index, Shape shape) {
+  if (index < inputs_.size()) {
+    auto &input = inputs_.at(index);
+    input.setShape(std::move(shape));
+  }
+}
+
+void InferenceRequest::setInputTensorName(size_t index, std::string name) {
+  if (index < inputs_.size()) {
+    auto &input = inputs_.at(index);
+    input.setName(std::move(name));
+  }
+}
+
+void InferenceRequest::setInputTensorDatatype(size_t index,
+                                              DataType datatype) {
+  if (index < inputs_.size()) {
+    auto &input = inputs_.at(index);
+    input.setDatatype(datatype);
+  }
+}
+
+void InferenceRequest::transposeInputTensor(
+  size_t index, const std::vector<size_t> &order) {
+  if (index < inputs_.size()) {
+    auto &input = inputs_.at(index);
+    input.transpose(order);
+  }
+}
+
+void InferenceRequest::reorderInputTensors(const std::vector<size_t> &order) {
+  assert(order.size() == inputs_.size());
+  std::vector<InferenceRequestInput> inputs(inputs_.size());
+  for (auto i = 0U; i < order.size(); ++i) {
+    inputs.at(order[i]) = std::move(inputs_[i]);
   }
+  inputs_ = std::move(inputs);
 }
 
-const std::vector<InferenceRequestInput> &InferenceRequest::getInputs() const {
+const std::vector<InferenceRequestInput> &InferenceRequest::getInputs()
+  const & {
   return this->inputs_;
 }
 
+std::vector<InferenceRequestInput> InferenceRequest::getInputs() && {
+  return std::move(this->inputs_);
+}
+
 size_t InferenceRequest::getInputSize() const { return this->inputs_.size(); }
 
 const std::vector<InferenceRequestOutput> &InferenceRequest::getOutputs()
-  const {
+  const & {
   return this->outputs_;
 }
 
-void InferenceRequest::addOutputTensor(const InferenceRequestOutput &output) {
-  this->outputs_.push_back(output);
+std::vector<InferenceRequestOutput> InferenceRequest::getOutputs() && {
+  return std::move(this->outputs_);
+}
+
+void InferenceRequest::addOutputTensor(InferenceRequestOutput output) {
+  this->outputs_.push_back(std::move(output));
+}
+
+void InferenceRequest::reserveTensors(size_t inputs, size_t outputs) {
+  this->inputs_.reserve(inputs);
+  this->outputs_.reserve(outputs);
 }
 
-InferenceRequestInput::InferenceRequestInput(void *data,
-                                             std::vector<int64_t> shape,
+InferenceRequestInput::InferenceRequestInput(void *data, Shape shape,
                                              DataType data_type,
                                              std::string name)
   : InferenceTensor(std::move(name), std::move(shape), data_type),
@@ -108,6 +225,139 @@ void InferenceRequestInput::setData(void *buffer) { this->data_ = buffer; }
 
 void *InferenceRequestInput::getData() const { return this->data_; }
 
+void InferenceRequestInput::setStrides(Strides strides, int64_t offset) {
+  if (!strides.empty() && strides.size() != this->getShape().size()) {
+    throw invalid_argument("The strides must have one entry per dimension");
+  }
+  if (offset < 0) {
+    throw invalid_argument("The offset of the data can't be negative");
+  }
+  strides_ = std::move(strides);
+  offset_ = offset;
+}
+
+const Strides &InferenceRequestInput::getStrides() const {
+  return this->strides_;
+}
+
+int64_t InferenceRequestInput::getOffset() const { return this->offset_; }
+
+bool InferenceRequestInput::isContiguous() const {
+  if (offset_ != 0) {
+    return false;
+  }
+  if (strides_.empty()) {
+    return true;
+  }
+  const auto &shape = this->getShape();
+  int64_t expected = 1;
+  for (auto i = shape.size(); i > 0; --i) {
+    // the stride of a dimension with one index is never used
+    if (shape[i - 1] != 1 && strides_[i - 1] != expected) {
+      return false;
+    }
+    expected *= shape[i - 1];
+  }
+  return true;
+}
+
+Strides InferenceRequestInput::getEffectiveStrides() const {
+  if (!strides_.empty()) {
+    return strides_;
+  }
+  const auto &shape = this->getShape();
+  std::vector<int64_t> strides(shape.size());
+  int64_t stride = 1;
+  for (auto i = shape.size(); i > 0; --i) {
+    strides[i - 1] = stride;
+    stride *= shape[i - 1];
+  }
+  return strides;
+}
+
+void InferenceRequestInput::slice(size_t axis, int64_t start, int64_t stop) {
+  Shape shape = this->getShape();
+  if (axis >= shape.size()) {
+    throw invalid_argument("Can't slice axis " + std::to_string(axis) +
+                           " of a tensor with " +
+                           std::to_string(shape.size()) + " dimensions");
+  }
+  if (start < 0 || start > stop || stop > shape[axis]) {
+    throw invalid_argument("The slice [" + std::to_string(start) + ", " +
+                           std::to_string(stop) + ") is out of bounds");
+  }
+  auto strides = this->getEffectiveStrides();
+  offset_ += start * strides[axis];
+  shape[axis] = stop - start;
+  this->setShape(std::move(shape));
+  strides_ = std::move(strides);
+}
+
+void InferenceRequestInput::transpose(const std::vector<size_t> &order) {
+  const auto &shape = this->getShape();
+  const auto rank = shape.size();
+  if (order.size() != rank) {
+    throw invalid_argument("The order must have one entry per dimension");
+  }
+  std::vector<bool> seen(rank, false);
+  const auto strides = this->getEffectiveStrides();
+  std::vector<int64_t> new_shape(rank);
+  std::vector<int64_t> new_strides(rank);
+  for (auto i = 0U; i < rank; ++i) {
+    const auto dim = order[i];
+    if (dim >= rank || seen[dim]) {
+      throw invalid_argument("The order isn't a permutation of the dimensions");
+    }
+    seen[dim] = true;
+    new_shape[i] = shape[dim];
+    new_strides[i] = strides[dim];
+  }
+  this->setShape(new_shape);
+  strides_ = new_strides;
+}
+
+void InferenceRequestInput::copyData(void *dst) const {
+  const auto element_size = this->getDatatype().size();
+  const auto size = this->getSize();
+  const auto *src = static_cast<const std::byte *>(data_);
+  auto *dst_bytes = static_cast<std::byte *>(dst);
+  if (this->isContiguous()) {
+    std::memcpy(dst_bytes, src, size * element_size);
+    return;
+  }
+  if (size == 0) {
+    return;
+  }
+
+  // the innermost dimensions that are dense are copied as one block
+  const auto &shape = this->getShape();
+  const auto strides = this->getEffectiveStrides();
+  auto outer = shape.size();
+  int64_t block = 1;
+  while (outer > 0 &&
+         (strides[outer - 1] == block || shape[outer - 1] == 1)) {
+    block *= shape[outer - 1];
+    --outer;
+  }
+  const auto block_size = static_cast<size_t>(block) * element_size;
+
+  std::vector<int64_t> index(outer, 0);
+  auto offset = offset_;
+  for (size_t copied = 0; copied < size; copied += block) {
+    std::memcpy(dst_bytes, src + offset * element_size, block_size);
+    dst_bytes += block_size;
+    for (auto i = outer; i > 0; --i) {
+      const auto dim = i - 1;
+      offset += strides[dim];
+      if (++index[dim] < shape[dim]) {
+        break;
+      }
+      offset -= strides[dim] * shape[dim];
+      index[dim] = 0;
+    }
+  }
+}
+
 struct InferenceRequestInputSizes {
   size_t data;
 };
@@ -126,7 +376,8 @@ std::byte *InferenceRequestInput::serialize(std::byte *data_out) const {
   InferenceRequestInputSizes metadata{this->getSize() *
                                       this->getDatatype().size()};
   data = util::copy(metadata, data, sizeof(InferenceRequestInputSizes));
-  data = util::copy(data_, data, metadata.data);
+  this->copyData(data);
+  data += metadata.data;
   assert(data_out + this->serializeSize() == data);
   return data;
 }
@@ -137,6 +388,9 @@ const std::byte *InferenceRequestInput::deserialize(const std::byte *data_in) {
   const auto metadata =
     *reinterpret_cast<const InferenceRequestInputSizes *>(data_in);
   data_in += sizeof(InferenceRequestInputSizes);
+  // the serialized data is always dense
+  strides_ = {};
+  offset_ = 0;
 
   return util::copy(data_in, static_cast<std::byte *>(data_), metadata.data);
 }
@@ -37,20 +37,29 @@ void InferenceResponse::setModel(const std::string &model) {
   this->model_ = model;
 }
 
-std::string InferenceResponse::getModel() { return this->model_; }
+std::string InferenceResponse::getModel() const { return this->model_; }
 
 bool InferenceResponse::isError() const { return !this->error_msg_.empty(); }
 
 std::string InferenceResponse::getError() const { return this->error_msg_; }
 
-void InferenceResponse::addOutput(const InferenceResponseOutput &output) {
-  this->outputs_.push_back(output);
+void InferenceResponse::setFinal(bool final) { this->final_ = final; }
+
+bool InferenceResponse::isFinal() const { return this->final_; }
+
+void InferenceResponse::addOutput(InferenceResponseOutput output) {
+  this->outputs_.push_back(std::move(output));
 }
 
-std::vector<InferenceResponseOutput> InferenceResponse::getOutputs() const {
+const std::vector<InferenceResponseOutput> &InferenceResponse::getOutputs()
+  const & {
   return this->outputs_;
 }
 
+std::vector<InferenceResponseOutput> InferenceResponse::getOutputs() && {
+  return std::move(this->outputs_);
+}
+
 #ifdef AMDINFER_ENABLE_TRACING
 void InferenceResponse::setContext(StringMap &&context) {
   this->context_ = std::move(context);
@@ -80,12 +89,31 @@ InferenceResponseOutput::InferenceResponseOutput()
 
 void InferenceResponseOutput::setData(std::vector<std::byte> &&buffer) {
   data_ = std::move(buffer);
+  view_ = nullptr;
+  view_size_ = 0;
+  owner_.reset();
+}
+
+void InferenceResponseOutput::setData(const void *data, size_t size,
+                                      std::shared_ptr<const void> owner) {
+  data_.clear();
+  view_ = static_cast<const std::byte *>(data);
+  view_size_ = size;
+  owner_ = std::move(owner);
 }
 
 void *InferenceResponseOutput::getData() const {
+  if (view_ != nullptr) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    return const_cast<std::byte *>(view_);
+  }
   return (void *)data_.data();  // NOLINT(google-readability-casting)
 }
 
+size_t InferenceResponseOutput::dataSize() const {
+  return view_ != nullptr ? view_size_ : data_.size();
+}
+
 struct InferenceResponseOutputSizes {
   size_t data;
 };
@@ -93,7 +121,7 @@ struct InferenceResponseOutputSizes {
 size_t InferenceResponseOutput::serializeSize() const {
   auto size = InferenceTensor::serializeSize();
   size += sizeof(InferenceResponseOutputSizes);
-  size += data_.size();
+  size += dataSize();
   return size;
 }
 
@@ -101,9 +129,9 @@ std::byte *InferenceResponseOutput::serialize(std::byte *data_out) const {
   auto *data = data_out;
   data = InferenceTensor::serialize(data);
 
-  InferenceResponseOutputSizes metadata{data_.size()};
+  InferenceResponseOutputSizes metadata{dataSize()};
   data = util::copy(metadata, data, sizeof(InferenceResponseOutputSizes));
-  data = util::copy(data_.data(), data, metadata.data);
+  data = util::copy(getData(), data, metadata.data);
   assert(data_out + this->serializeSize() == data);
   return data;
 }
@@ -116,8 +144,9 @@ const std::byte *InferenceResponseOutput::deserialize(
     *reinterpret_cast<const InferenceResponseOutputSizes *>(data_in);
   data_in += sizeof(InferenceResponseOutputSizes);
 
-  data_.resize(metadata.data);
-  return util::copy(data_in, data_.data(), metadata.data);
+  std::vector<std::byte> buffer(data_in, data_in + metadata.data);
+  setData(std::move(buffer));
+  return data_in + metadata.data;
 }
 
 std::ostream &operator<<(std::ostream &os,
@@ -0,0 +1,312 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements loading the models of a repository on their first request
+ */
+
+#include "amdinfer/core/lazy_loader.hpp"
+
+#include <algorithm>     // for sort, max
+#include <cstdint>       // for int32_t
+#include <exception>     // for exception
+#include <system_error>  // for error_code
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/endpoints.hpp"           // for Endpoints
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/model_config.hpp"        // for ModelConfig
+#include "amdinfer/core/model_repository.hpp"    // for parseModel
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/request_container.hpp"   // for RequestContainer
+#include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
+#include "amdinfer/observation/logging.hpp"      // for Logger, AMDINFER_LOG...
+#include "amdinfer/observation/metrics.hpp"      // for Metrics
+#include "amdinfer/util/thread.hpp"              // for setThreadName
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+namespace {
+
+/// How often the loader looks for idle models
+constexpr auto kIdleInterval = std::chrono::seconds(1);
+constexpr size_t kBytesPerMib = 1024 * 1024;
+
+/// Get the size of a file or of all the files in a directory
+size_t getSize(const fs::path& path) {
+  std::error_code error;
+  if (!fs::is_directory(path, error)) {
+    const auto size = fs::file_size(path, error);
+    return error ? 0 : static_cast<size_t>(size);
+  }
+  size_t size = 0;
+  for (const auto& entry : fs::recursive_directory_iterator(path, error)) {
+    if (entry.is_regular_file(error)) {
+      size += static_cast<size_t>(entry.file_size(error));
+    }
+  }
+  return size;
+}
+
+#ifdef AMDINFER_ENABLE_METRICS
+void count(MetricCounterIDs id, const std::string& model,
+           const std::string& version) {
+  Metrics::getInstance().incrementCounter(
+    id, {{"model", model}, {"version", version}});
+}
+#endif
+
+}  // namespace
+
+LazyLoader::LazyLoader(fs::path repository, Endpoints* endpoints,
+                       size_t memory_budget, std::chrono::seconds idle_timeout)
+  : repository_(std::move(repository)),
+    endpoints_(endpoints),
+    memory_budget_(memory_budget),
+    idle_timeout_(idle_timeout) {
+  thread_ = std::thread{&LazyLoader::run, this};
+}
+
+LazyLoader::~LazyLoader() {
+  queue_.enqueue(nullptr);
+  thread_.join();
+
+  // requests for models that were queued behind the null model never load
+  for (const auto& [_, model] : models_) {
+    this->release(model.get(), "The server stopped before " + model->endpoint +
+                                 " was loaded");
+  }
+}
+
+bool LazyLoader::infer(const std::string& model, const std::string& version,
+                       RequestContainerPtr* request) {
+  auto* state = this->find(model, version);
+  if (state == nullptr) {
+    return false;
+  }
+  state->last_used.store(Clock::now().time_since_epoch().count(),
+                         std::memory_order_relaxed);
+  if (endpoints_->exists(state->endpoint)) {
+    return false;
+  }
+
+  const std::lock_guard lock{state->mutex};
+  // the model may have been loaded since it was checked
+  if (endpoints_->exists(state->endpoint)) {
+    return false;
+  }
+  state->waiting.push_back(std::move(*request));
+  if (!state->loading) {
+    state->loading = true;
+    queue_.enqueue(state);
+  }
+  return true;
+}
+
+LazyLoader::Model* LazyLoader::find(const std::string& model,
+                                    const std::string& version) {
+  auto endpoint = getVersionedEndpoint(model, version);
+  {
+    const std::shared_lock lock{models_mutex_};
+    if (auto found = models_.find(endpoint); found != models_.end()) {
+      return found->second.get();
+    }
+  }
+
+  // only models in the repository can be loaded
+  if (model.empty() || model.find('/') != std::string::npos || model == "." ||
+      model == "..") {
+    return nullptr;
+  }
+  std::error_code error;
+  if (!fs::is_directory(repository_ / model, error)) {
+    return nullptr;
+  }
+
+  const std::unique_lock lock{models_mutex_};
+  auto [iterator, _] = models_.try_emplace(endpoint, nullptr);
+  if (iterator->second == nullptr) {
+    iterator->second =
+      std::make_unique<Model>(model, version, std::move(endpoint));
+  }
+  return iterator->second.get();
+}
+
+void LazyLoader::run() {
+  util::setThreadName("lazyLoader");
+  const auto timeout =
+    std::chrono::duration_cast<std::chrono::microseconds>(kIdleInterval);
+  auto next_check = Clock::now() + kIdleInterval;
+  while (true) {
+    Model* model = nullptr;
+    if (queue_.wait_dequeue_timed(model, timeout.count())) {
+      if (model == nullptr) {
+        break;
+      }
+      this->load(model);
+    }
+    if (const auto now = Clock::now(); now >= next_check) {
+      this->unloadIdle();
+      next_check = now + kIdleInterval;
+    }
+  }
+}
+
+void LazyLoader::load(Model* model) {
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+  std::string error;
+  try {
+    auto config = parseModel(repository_, model->name, model->version);
+    const auto memory = getMemory(&config);
+    this->makeRoom(memory, model);
+
+    const auto start = Clock::now();
+    loadModelConfig(model->name, model->version, config, ParameterMap{},
+                    endpoints_);
+    model->loaded = true;
+    model->memory = memory;
+
+    [[maybe_unused]] const auto elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                            start);
+    AMDINFER_LOG_INFO(logger, "Loaded " + model->endpoint + " on demand in " +
+                                std::to_string(elapsed.count()) + " ms");
+#ifdef AMDINFER_ENABLE_METRICS
+    count(MetricCounterIDs::LazyColdStarts, model->name, model->version);
+#endif
+  } catch (const std::exception& e) {
+    error = "Failed to load " + model->endpoint + ": " + e.what();
+    AMDINFER_LOG_WARN(logger, error);
+  }
+  this->release(model, error);
+}
+
+size_t LazyLoader::getMemory(ModelConfig* config) {
+  size_t memory = 0;
+  for (auto& [_, parameters] : *config) {
+    if (parameters.has("memory_mib")) {
+      const auto mib = parameters.get<int32_t>("memory_mib");
+      memory += static_cast<size_t>(std::max(mib, 0)) * kBytesPerMib;
+      parameters.erase("memory_mib");
+    } else if (parameters.has("model")) {
+      memory += getSize(parameters.get<std::string>("model"));
+    }
+  }
+  return memory;
+}
+
+void LazyLoader::makeRoom(size_t memory, const Model* loading) {
+  if (memory_budget_ == 0) {
+    return;
+  }
+
+  std::vector<Model*> loaded;
+  size_t used = 0;
+  {
+    const std::shared_lock lock{models_mutex_};
+    for (const auto& [_, model] : models_) {
+      // models that were unloaded by other means don't count
+      if (model->loaded && !endpoints_->exists(model->endpoint)) {
+        model->loaded = false;
+      }
+      if (model->loaded && model.get() != loading) {
+        loaded.push_back(model.get());
+        used += model->memory;
+      }
+    }
+  }
+
+  std::sort(loaded.begin(), loaded.end(), [](const Model* a, const Model* b) {
+    return a->last_used.load(std::memory_order_relaxed) <
+           b->last_used.load(std::memory_order_relaxed);
+  });
+  for (auto* model : loaded) {
+    if (used + memory <= memory_budget_) {
+      break;
+    }
+    used -= model->memory;
+    this->evict(model, "to make room for " + loading->endpoint);
+  }
+
+  if (used + memory > memory_budget_) {
+    AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+    AMDINFER_LOG_WARN(logger, loading->endpoint +
+                                " doesn't fit in the memory budget and is "
+                                "loaded anyway");
+  }
+}
+
+void LazyLoader::unloadIdle() {
+  if (idle_timeout_.count() == 0) {
+    return;
+  }
+
+  const auto idle_since = (Clock::now() - idle_timeout_).time_since_epoch();
+  std::vector<Model*> idle;
+  {
+    const std::shared_lock lock{models_mutex_};
+    for (const auto& [_, model] : models_) {
+      if (model->loaded &&
+          model->last_used.load(std::memory_order_relaxed) <
+            idle_since.count()) {
+        idle.push_back(model.get());
+      }
+    }
+  }
+  for (auto* model : idle) {
+    this->evict(model, "after being idle");
+  }
+}
+
+void LazyLoader::evict(Model* model,
+                       [[maybe_unused]] const std::string& reason) {
+  model->loaded = false;
+  if (!endpoints_->exists(model->endpoint)) {
+    return;
+  }
+  endpoints_->unload(model->name, model->version);
+
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+  AMDINFER_LOG_INFO(logger, "Unloaded " + model->endpoint + " " + reason);
+#ifdef AMDINFER_ENABLE_METRICS
+  count(MetricCounterIDs::LazyEvictions, model->name, model->version);
+#endif
+}
+
+void LazyLoader::release(Model* model, const std::string& error) {
+  std::vector<RequestContainerPtr> waiting;
+  {
+    const std::lock_guard lock{model->mutex};
+    waiting.swap(model->waiting);
+    model->loading = false;
+  }
+
+  for (auto& request : waiting) {
+    auto inference_request = request->request;
+    if (!error.empty()) {
+      inference_request->runCallbackError(error);
+      continue;
+    }
+    try {
+      endpoints_->infer(model->name, std::move(request), model->version);
+    } catch (const std::exception& e) {
+      inference_request->runCallbackError(e.what());
+    }
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,156 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines loading the models of a repository on their first request
+ */
+
+#ifndef GUARD_AMDINFER_CORE_LAZY_LOADER
+#define GUARD_AMDINFER_CORE_LAZY_LOADER
+
+#include <atomic>         // for atomic
+#include <chrono>         // for steady_clock, seconds
+#include <cstddef>        // for size_t
+#include <filesystem>     // for path
+#include <memory>         // for unique_ptr
+#include <mutex>          // for mutex
+#include <shared_mutex>   // for shared_mutex
+#include <string>         // for string
+#include <thread>         // for thread
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+#include <vector>         // for vector
+
+#include "amdinfer/declarations.hpp"  // for RequestContainerPtr
+#include "amdinfer/util/queue.hpp"    // for BlockingQueue
+
+namespace amdinfer {
+
+class Endpoints;
+class ModelConfig;
+
+/**
+ * @brief Loads the models of a repository when their first request arrives
+ * instead of when the server starts. Requests that arrive while their model
+ * is loading wait for it. If a memory budget is set, the least recently used
+ * models are unloaded to make room for a model before it's loaded and models
+ * that are idle for longer than the idle timeout are unloaded as well.
+ *
+ * A model's memory is the sum of the memory_mib parameter of its models in
+ * its configuration or, if it's not set, the size of its model files. Models
+ * are loaded one at a time by the loader's own thread.
+ */
+class LazyLoader {
+ public:
+  /**
+   * @brief Construct a new LazyLoader object
+   *
+   * @param repository path to the model repository
+   * @param endpoints the endpoints to load the models into
+   * @param memory_budget bytes that the models may use. 0 for no limit
+   * @param idle_timeout time after which an unused model is unloaded. 0 to
+   * keep them loaded
+   */
+  LazyLoader(std::filesystem::path repository, Endpoints* endpoints,
+             size_t memory_budget, std::chrono::seconds idle_timeout);
+  LazyLoader(LazyLoader const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  LazyLoader& operator=(const LazyLoader&) = delete;
+  LazyLoader(LazyLoader&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  LazyLoader& operator=(LazyLoader&& other) = delete;
+  /// Destructor. Requests still waiting for their model fail
+  ~LazyLoader();
+
+  /**
+   * @brief Take a request for a model in the repository that isn't loaded.
+   * The request waits until the model is loaded and is then sent to it.
+   * Requests for loaded models only mark the model as used and are left to
+   * the caller.
+   *
+   * @param model the name of the model
+   * @param version the version of the model
+   * @param request the request. It's moved from if it's taken
+   * @return bool true if the request was taken
+   */
+  bool infer(const std::string& model, const std::string& version,
+             RequestContainerPtr* request);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Model {
+    Model(std::string name, std::string version, std::string endpoint)
+      : name(std::move(name)),
+        version(std::move(version)),
+        endpoint(std::move(endpoint)) {}
+
+    const std::string name;
+    const std::string version;
+    const std::string endpoint;
+    /// When the model was last asked for, as a count of Clock's ticks
+    std::atomic<Clock::rep> last_used = 0;
+
+    std::mutex mutex;
+    /// Guarded by the mutex
+    bool loading = false;
+    /// Requests waiting for the model to load, guarded by the mutex
+    std::vector<RequestContainerPtr> waiting;
+
+    // only used by the loader's thread
+    bool loaded = false;
+    size_t memory = 0;
+  };
+
+  /// Get the model, adding it if it's in the repository, or null
+  Model* find(const std::string& model, const std::string& version);
+  /// Load the models that are asked for until a null model is queued
+  void run();
+  void load(Model* model);
+  /**
+   * @brief Get the memory that a model needs. The memory_mib parameters are
+   * removed from the configuration so they're not passed to the workers
+   */
+  static size_t getMemory(ModelConfig* config);
+  /// Unload the least recently used models until the memory fits the budget
+  void makeRoom(size_t memory, const Model* loading);
+  /// Unload the models that are unused for longer than the idle timeout
+  void unloadIdle();
+  void evict(Model* model, const std::string& reason);
+  /**
+   * @brief Send the requests waiting for a model to it or, if loading it
+   * failed, respond to them with the error
+   *
+   * @param model the model
+   * @param error the error or empty if the model loaded
+   */
+  void release(Model* model, const std::string& error);
+
+  std::filesystem::path repository_;
+  Endpoints* endpoints_;
+  size_t memory_budget_;
+  std::chrono::seconds idle_timeout_;
+
+  /// endpoint -> Model for the models that have been asked for
+  std::unordered_map<std::string, std::unique_ptr<Model>> models_;
+  mutable std::shared_mutex models_mutex_;
+  /// Models to load. A null model stops the thread
+  BlockingQueue<Model*> queue_;
+  std::thread thread_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_LAZY_LOADER
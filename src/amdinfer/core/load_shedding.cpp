@@ -0,0 +1,158 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the shedding and rate limiting of requests at the servers
+ */
+
+#include "amdinfer/core/load_shedding.hpp"
+
+#include <algorithm>  // for max, min
+#include <string>     // for string, to_string
+#include <utility>    // for move
+
+#include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/exceptions.hpp"      // for resource_exhausted_error
+#include "amdinfer/observation/metrics.hpp"  // for Metrics
+
+namespace amdinfer {
+
+namespace {
+
+/// Most tenants whose buckets are kept before full ones are forgotten
+constexpr size_t kMaxTenants = 1 << 16;
+
+#ifdef AMDINFER_ENABLE_METRICS
+void count(MetricCounterIDs id) { Metrics::getInstance().incrementCounter(id); }
+#endif
+
+}  // namespace
+
+/// Releases its request from the shedder and reports its latency
+class LoadShedder::Ticket {
+ public:
+  Ticket(std::shared_ptr<LoadShedder> shedder, Clock::time_point start)
+    : shedder_(std::move(shedder)), start_(start) {}
+  Ticket(Ticket const&) = delete;
+  Ticket& operator=(const Ticket&) = delete;
+  Ticket(Ticket&& other) = delete;
+  Ticket& operator=(Ticket&& other) = delete;
+  ~Ticket() {
+    const auto now = Clock::now();
+    shedder_->inflight_.fetch_sub(1, std::memory_order_relaxed);
+    shedder_->observe(now - start_, now);
+  }
+
+ private:
+  std::shared_ptr<LoadShedder> shedder_;
+  Clock::time_point start_;
+};
+
+LoadShedder::LoadShedder(std::chrono::milliseconds target, size_t max_inflight,
+                         std::chrono::milliseconds interval)
+  : target_(target), max_inflight_(max_inflight), interval_(interval) {}
+
+std::shared_ptr<void> LoadShedder::admit(Clock::time_point now) {
+  const auto inflight = inflight_.fetch_add(1, std::memory_order_relaxed);
+  if (max_inflight_ != 0 && inflight >= max_inflight_) {
+    inflight_.fetch_sub(1, std::memory_order_relaxed);
+#ifdef AMDINFER_ENABLE_METRICS
+    count(MetricCounterIDs::RequestsShedOverload);
+#endif
+    throw resource_exhausted_error(
+      "The server is overloaded, too many requests are in flight");
+  }
+  if (target_.count() != 0 && this->isShedding(now)) {
+    inflight_.fetch_sub(1, std::memory_order_relaxed);
+#ifdef AMDINFER_ENABLE_METRICS
+    count(MetricCounterIDs::RequestsShedOverload);
+#endif
+    throw resource_exhausted_error(
+      "The server is overloaded, requests are queueing");
+  }
+  return std::make_shared<Ticket>(shared_from_this(), now);
+}
+
+void LoadShedder::observe(Clock::duration latency, Clock::time_point now) {
+  if (target_.count() == 0) {
+    return;
+  }
+  const std::lock_guard lock{mutex_};
+  if (latency < target_) {
+    first_above_ = Clock::time_point{};
+    shed_until_ = Clock::time_point{};
+  } else if (first_above_ == Clock::time_point{}) {
+    first_above_ = now + interval_;
+  } else if (now >= first_above_) {
+    shed_until_ = now + interval_;
+  }
+}
+
+size_t LoadShedder::getInflight() const {
+  return inflight_.load(std::memory_order_relaxed);
+}
+
+bool LoadShedder::isShedding(Clock::time_point now) const {
+  const std::lock_guard lock{mutex_};
+  return now < shed_until_;
+}
+
+double LoadShedder::getLoad(Clock::time_point now) const {
+  if (target_.count() != 0 && this->isShedding(now)) {
+    return 1;
+  }
+  if (max_inflight_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(this->getInflight()) /
+         static_cast<double>(max_inflight_);
+}
+
+RateLimiter::RateLimiter(double rate, double burst)
+  : rate_(rate), burst_(burst < 1 ? std::max(rate, 1.0) : burst) {}
+
+void RateLimiter::take(const std::string& tenant, Clock::time_point now) {
+  const std::lock_guard lock{mutex_};
+  if (buckets_.size() >= kMaxTenants) {
+    // buckets that have refilled are the same as new ones
+    for (auto it = buckets_.begin(); it != buckets_.end();) {
+      const std::chrono::duration<double> elapsed = now - it->second.updated;
+      if (it->second.tokens + elapsed.count() * rate_ >= burst_) {
+        it = buckets_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  auto [iterator, inserted] = buckets_.try_emplace(tenant, Bucket{burst_, now});
+  auto& bucket = iterator->second;
+  if (!inserted) {
+    const std::chrono::duration<double> elapsed = now - bucket.updated;
+    bucket.tokens = std::min(burst_, bucket.tokens + elapsed.count() * rate_);
+    bucket.updated = now;
+  }
+  if (bucket.tokens < 1) {
+#ifdef AMDINFER_ENABLE_METRICS
+    count(MetricCounterIDs::RequestsShedRateLimit);
+#endif
+    throw resource_exhausted_error("Too many requests from tenant '" + tenant +
+                                   "', the limit is " +
+                                   std::to_string(rate_) + " per second");
+  }
+  bucket.tokens -= 1;
+}
+
+}  // namespace amdinfer
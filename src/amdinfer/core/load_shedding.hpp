@@ -0,0 +1,147 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the shedding and rate limiting of requests at the servers
+ */
+
+#ifndef GUARD_AMDINFER_CORE_LOAD_SHEDDING
+#define GUARD_AMDINFER_CORE_LOAD_SHEDDING
+
+#include <atomic>         // for atomic
+#include <chrono>         // for steady_clock, milliseconds
+#include <cstddef>        // for size_t
+#include <memory>         // for shared_ptr, enable_shared_from_this
+#include <mutex>          // for mutex
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+
+namespace amdinfer {
+
+/**
+ * @brief Sheds requests at the servers when the server is overloaded so the
+ * requests it takes are still served quickly instead of every request waiting
+ * in ever longer queues. It watches the latency of the requests it admits in
+ * the style of CoDel: if no request is served within the target for a whole
+ * interval, there's a standing queue rather than a burst and it refuses new
+ * requests until one is served within the target again or, if none finish,
+ * for an interval after the last slow one. Independently, it refuses requests
+ * while the server has the most requests in flight that it allows.
+ */
+class LoadShedder : public std::enable_shared_from_this<LoadShedder> {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Construct a new LoadShedder object
+   *
+   * @param target latency above which requests are queueing. 0 to only limit
+   * the requests in flight
+   * @param max_inflight most requests in flight. 0 for no limit
+   * @param interval how long the latency must stay above the target before
+   * requests are shed
+   */
+  LoadShedder(std::chrono::milliseconds target, size_t max_inflight,
+              std::chrono::milliseconds interval = kDefaultInterval);
+
+  /**
+   * @brief Admit a request. Its latency is observed when the returned ticket
+   * is destroyed. Throws resource_exhausted_error if it's shed
+   *
+   * @param now the time the request arrived
+   * @return std::shared_ptr<void> the request's ticket
+   */
+  std::shared_ptr<void> admit(Clock::time_point now = Clock::now());
+  /**
+   * @brief Observe the latency of a request
+   *
+   * @param latency time from when it was admitted to its final response
+   * @param now the time of its final response
+   */
+  void observe(Clock::duration latency, Clock::time_point now = Clock::now());
+
+  [[nodiscard]] size_t getInflight() const;
+  /// Check if the shedder is refusing requests for their latency
+  [[nodiscard]] bool isShedding(Clock::time_point now = Clock::now()) const;
+  /**
+   * @brief Get the fraction of the requests in flight that may be, or 1 if
+   * requests are shed for their latency
+   *
+   * @param now the current time
+   * @return double
+   */
+  [[nodiscard]] double getLoad(Clock::time_point now = Clock::now()) const;
+
+  static constexpr std::chrono::milliseconds kDefaultInterval{100};
+
+ private:
+  class Ticket;
+
+  const Clock::duration target_;
+  const size_t max_inflight_;
+  const Clock::duration interval_;
+  std::atomic<size_t> inflight_ = 0;
+
+  mutable std::mutex mutex_;
+  // guarded by the mutex
+  /// When the latency will have been above the target for an interval
+  Clock::time_point first_above_;
+  /// When to stop shedding if no more slow requests are observed
+  Clock::time_point shed_until_;
+};
+
+/**
+ * @brief Limits the rate of requests from each tenant with a token bucket per
+ * tenant. A tenant's bucket holds up to the burst size of tokens and is
+ * refilled at the rate. Each request takes one token and is refused if there's
+ * none.
+ */
+class RateLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Construct a new RateLimiter object
+   *
+   * @param rate requests per second that each tenant may send
+   * @param burst most requests that a tenant may send at once. If it's less
+   * than 1, it's the rate
+   */
+  RateLimiter(double rate, double burst);
+
+  /**
+   * @brief Take a token for a request from a tenant. Throws
+   * resource_exhausted_error if the tenant has none
+   *
+   * @param tenant the tenant. Requests without one share the empty tenant
+   * @param now the time the request arrived
+   */
+  void take(const std::string& tenant, Clock::time_point now = Clock::now());
+
+ private:
+  struct Bucket {
+    double tokens;
+    Clock::time_point updated;
+  };
+
+  const double rate_;
+  const double burst_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, Bucket> buckets_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_LOAD_SHEDDING
@@ -0,0 +1,281 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the manifest of loaded endpoints
+ */
+
+#include "amdinfer/core/manifest.hpp"
+
+#include <json/reader.h>  // for CharReaderBuilder, parseFromStream
+#include <json/value.h>   // for Value, ValueType
+#include <json/writer.h>  // for StreamWriterBuilder, writeString
+
+#include <algorithm>      // for max, find_if, remove_if
+#include <cstdint>        // for int32_t
+#include <fstream>        // for ifstream, ofstream
+#include <mutex>          // for lock_guard
+#include <sstream>        // for stringstream
+#include <system_error>   // for error_code
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+#include <variant>        // for visit
+
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
+#include "amdinfer/observation/logging.hpp"      // for AMDINFER_LOG_WARN
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+namespace {
+
+// bumped if the format changes so older servers don't misread newer manifests
+constexpr auto kManifestVersion = 1;
+
+Json::Value serializeParameters(const ParameterMap& parameters) {
+  Json::Value json = Json::objectValue;
+  for (const auto& [key, value] : parameters) {
+    std::visit([&json, &key = key](const auto& arg) { json[key] = arg; },
+               value);
+  }
+  return json;
+}
+
+ParameterMap parseParameters(const Json::Value& json) {
+  ParameterMap parameters;
+  if (!json.isObject()) {
+    return parameters;
+  }
+  for (const auto& key : json.getMemberNames()) {
+    const auto& value = json[key];
+    // integral doubles report isInt() too so the stored type is checked
+    switch (value.type()) {
+      case Json::booleanValue:
+        parameters.put(key, value.asBool());
+        break;
+      case Json::intValue:
+      case Json::uintValue:
+        parameters.put(key, static_cast<int32_t>(value.asInt()));
+        break;
+      case Json::realValue:
+        parameters.put(key, value.asDouble());
+        break;
+      case Json::stringValue:
+        parameters.put(key, value.asString());
+        break;
+      default:
+        throw invalid_argument("Unsupported type of manifest parameter " +
+                               key);
+    }
+  }
+  return parameters;
+}
+
+}  // namespace
+
+std::string serializeManifest(const std::vector<ManifestEntry>& entries) {
+  Json::Value json;
+  json["version"] = kManifestVersion;
+  auto& endpoints = json["endpoints"] = Json::arrayValue;
+  for (const auto& entry : entries) {
+    Json::Value value;
+    value["kind"] = entry.kind == ManifestKind::Model ? "model" : "worker";
+    value["name"] = entry.name;
+    value["version"] = entry.version;
+    value["endpoint"] = entry.endpoint;
+    value["parameters"] = serializeParameters(entry.parameters);
+    endpoints.append(std::move(value));
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "  ";
+  return Json::writeString(builder, json);
+}
+
+std::vector<ManifestEntry> parseManifest(const std::string& text) {
+  Json::CharReaderBuilder builder;
+  Json::Value json;
+  std::string errors;
+  std::stringstream stream{text};
+  if (!Json::parseFromStream(builder, stream, &json, &errors)) {
+    throw invalid_argument("The manifest isn't valid JSON: " + errors);
+  }
+  if (!json.isObject() || json["version"].asInt() != kManifestVersion) {
+    throw invalid_argument("Unsupported manifest version");
+  }
+
+  std::vector<ManifestEntry> entries;
+  const auto& endpoints = json["endpoints"];
+  entries.reserve(endpoints.size());
+  for (const auto& value : endpoints) {
+    ManifestEntry entry;
+    const auto kind = value["kind"].asString();
+    if (kind == "model") {
+      entry.kind = ManifestKind::Model;
+    } else if (kind != "worker") {
+      throw invalid_argument("Unknown kind of manifest entry: " + kind);
+    }
+    entry.name = value["name"].asString();
+    entry.version = value["version"].asString();
+    entry.endpoint = value["endpoint"].asString();
+    entry.parameters = parseParameters(value["parameters"]);
+    if (entry.name.empty()) {
+      throw invalid_argument("A manifest entry has no name");
+    }
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
+
+std::vector<ManifestEntry> readManifest(const fs::path& path) {
+  if (!fs::exists(path)) {
+    return {};
+  }
+  std::ifstream file{path};
+  if (!file) {
+    throw file_read_error("Couldn't read the manifest " + path.string());
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  return parseManifest(text.str());
+}
+
+std::vector<std::vector<size_t>> getRestoreStages(
+  const std::vector<ManifestEntry>& entries) {
+  std::vector<size_t> stages(entries.size(), 0);
+  // the last entries seen with each name and at each endpoint
+  std::unordered_map<std::string, size_t> names;
+  std::unordered_map<std::string, size_t> endpoints;
+  size_t count = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto& entry = entries[i];
+    auto& stage = stages[i];
+    if (const auto found = names.find(entry.name); found != names.end()) {
+      stage = std::max(stage, stages[found->second] + 1);
+    }
+    if (entry.parameters.has("next")) {
+      const auto next = entry.parameters.get<std::string>("next");
+      if (const auto found = endpoints.find(next); found != endpoints.end()) {
+        stage = std::max(stage, stages[found->second] + 1);
+      }
+    }
+    names.insert_or_assign(entry.name, i);
+    endpoints.insert_or_assign(entry.endpoint, i);
+    count = std::max(count, stage + 1);
+  }
+
+  std::vector<std::vector<size_t>> groups(count);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    groups[stages[i]].push_back(i);
+  }
+  return groups;
+}
+
+Manifest::Manifest(fs::path path) : path_(std::move(path)) {}
+
+void Manifest::add(ManifestEntry entry) {
+  std::lock_guard lock{mutex_};
+  const auto found =
+    std::find_if(entries_.begin(), entries_.end(), [&](const auto& other) {
+      return other.kind == entry.kind && other.endpoint == entry.endpoint;
+    });
+  if (found != entries_.end()) {
+    return;
+  }
+  // the other versions are unloaded when a model is swapped to a new one
+  if (entry.kind == ManifestKind::Model && entry.parameters.has("swap") &&
+      entry.parameters.get<bool>("swap")) {
+    entries_.erase(
+      std::remove_if(entries_.begin(), entries_.end(),
+                     [&](const auto& other) {
+                       return other.kind == ManifestKind::Model &&
+                              other.name == entry.name;
+                     }),
+      entries_.end());
+  }
+  entries_.push_back(std::move(entry));
+  this->unsafeSave();
+}
+
+void Manifest::removeWorker(const std::string& endpoint) {
+  std::lock_guard lock{mutex_};
+  const auto size = entries_.size();
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [&](const auto& entry) {
+                                  return entry.kind == ManifestKind::Worker &&
+                                         entry.endpoint == endpoint;
+                                }),
+                 entries_.end());
+  if (entries_.size() != size) {
+    this->unsafeSave();
+  }
+}
+
+void Manifest::removeModel(const std::string& model,
+                           const std::string& version) {
+  const auto endpoint = getVersionedEndpoint(model, version);
+  std::lock_guard lock{mutex_};
+  const auto size = entries_.size();
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [&](const auto& entry) {
+                                  return entry.kind == ManifestKind::Model &&
+                                         entry.endpoint == endpoint;
+                                }),
+                 entries_.end());
+  if (entries_.size() != size) {
+    this->unsafeSave();
+  }
+}
+
+void Manifest::save() const {
+  std::lock_guard lock{mutex_};
+  this->unsafeSave();
+}
+
+std::vector<ManifestEntry> Manifest::getEntries() const {
+  std::lock_guard lock{mutex_};
+  return entries_;
+}
+
+void Manifest::unsafeSave() const {
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+  // it's written next to the manifest and renamed over it so readers only
+  // ever see a complete manifest
+  auto temporary = path_;
+  temporary += ".tmp";
+  std::error_code error;
+  if (path_.has_parent_path()) {
+    fs::create_directories(path_.parent_path(), error);
+  }
+  {
+    std::ofstream file{temporary, std::ios::trunc};
+    file << serializeManifest(entries_);
+    if (!file.flush()) {
+      AMDINFER_LOG_WARN(logger,
+                        "Couldn't write the manifest " + temporary.string());
+      return;
+    }
+  }
+  fs::rename(temporary, path_, error);
+  if (error) {
+    AMDINFER_LOG_WARN(logger, "Couldn't replace the manifest " +
+                                path_.string() + ": " + error.message());
+    fs::remove(temporary, error);
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,117 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the manifest of loaded endpoints that a server restores after
+ * it restarts
+ */
+
+#ifndef GUARD_AMDINFER_CORE_MANIFEST
+#define GUARD_AMDINFER_CORE_MANIFEST
+
+#include <cstddef>     // for size_t
+#include <filesystem>  // for path
+#include <mutex>       // for mutex
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/parameters.hpp"  // for ParameterMap
+
+namespace amdinfer {
+
+/// What loaded an endpoint in a manifest
+enum class ManifestKind {
+  Worker,  ///< workerLoad
+  Model,   ///< modelLoad
+};
+
+/// One loaded endpoint in a manifest
+struct ManifestEntry {
+  ManifestKind kind = ManifestKind::Worker;
+  /// the worker or the model that's loaded
+  std::string name;
+  /// the version of a model or empty
+  std::string version;
+  /// the parameters it was loaded with
+  ParameterMap parameters;
+  /// the endpoint it was loaded at
+  std::string endpoint;
+};
+
+/// Serialize the entries of a manifest to JSON
+std::string serializeManifest(const std::vector<ManifestEntry>& entries);
+/// Parse the entries of a manifest. Throws invalid_argument if it's malformed
+std::vector<ManifestEntry> parseManifest(const std::string& text);
+/**
+ * @brief Read the entries of a manifest from a file
+ *
+ * @param path path to the manifest
+ * @return std::vector<ManifestEntry> - empty if the file doesn't exist
+ */
+std::vector<ManifestEntry> readManifest(const std::filesystem::path& path);
+
+/**
+ * @brief Group the entries of a manifest into stages whose entries can be
+ * loaded at the same time. An entry is loaded after the entry that its "next"
+ * parameter names and after the earlier entries of the same worker so repeated
+ * loads of a worker get the same endpoints as before.
+ *
+ * @param entries the entries in the order they were loaded
+ * @return std::vector<std::vector<size_t>> - the indices of the entries of
+ * each stage, in order
+ */
+std::vector<std::vector<size_t>> getRestoreStages(
+  const std::vector<ManifestEntry>& entries);
+
+/**
+ * @brief Records the endpoints loaded through the API in a file as they're
+ * loaded and unloaded. The file is replaced atomically so a crash leaves the
+ * last complete manifest behind for the next server to restore.
+ */
+class Manifest {
+ public:
+  /// Record to a file. Nothing is written until the first change or save()
+  explicit Manifest(std::filesystem::path path);
+
+  /**
+   * @brief Record a loaded endpoint. Loading an endpoint that's recorded
+   * already doesn't change it and swapping a model to a version replaces the
+   * model's other versions
+   *
+   * @param entry the endpoint that was loaded
+   */
+  void add(ManifestEntry entry);
+  /// Forget an endpoint loaded by workerLoad
+  void removeWorker(const std::string& endpoint);
+  /// Forget a model loaded by modelLoad
+  void removeModel(const std::string& model, const std::string& version);
+
+  /// Write the manifest to its file, logging a warning if it can't
+  void save() const;
+
+  /// Get the recorded entries in the order they were loaded
+  [[nodiscard]] std::vector<ManifestEntry> getEntries() const;
+
+ private:
+  void unsafeSave() const;
+
+  std::filesystem::path path_;
+  mutable std::mutex mutex_;
+  std::vector<ManifestEntry> entries_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_MANIFEST
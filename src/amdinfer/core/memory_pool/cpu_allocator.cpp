@@ -19,111 +19,469 @@
 
 #include "amdinfer/core/memory_pool/cpu_allocator.hpp"
 
+#include <sys/mman.h>  // for mmap, madvise, munmap
+#include <unistd.h>    // for sysconf
+
+#include "amdinfer/build_options.hpp"
+
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+#include <hip/hip_runtime_api.h>  // for hipHostRegister, hipHostUnregister
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
-#include <iostream>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "amdinfer/buffers/cpu.hpp"
 #include "amdinfer/core/exceptions.hpp"
 #include "amdinfer/core/inference_request.hpp"
+#include "amdinfer/observation/metrics.hpp"
+#include "amdinfer/util/numa.hpp"
 
 namespace amdinfer {
 
-CpuAllocator::CpuAllocator(size_t block_size, size_t max_allocate)
-  : max_allocate_(max_allocate), block_size_(block_size) {}
+namespace {
 
-BufferPtr CpuAllocator::get(const Tensor& tensor, size_t batch_size) {
-  auto size = tensor.getSize() * tensor.getDatatype().size() * batch_size;
+// maximum number of chunks of one order held in a thread cache
+constexpr size_t kCacheCapacity = 32;
+// maximum number of chunks of one order held in the depot
+constexpr size_t kDepotCapacity = 8 * kCacheCapacity;
+// number of cache accesses to accumulate before updating the metrics
+constexpr size_t kCacheMetricsInterval = 256;
 
-  const std::lock_guard lock{mutex_};
-  auto best = headers_.end();
-  const auto end = headers_.end();
-  for (auto it = headers_.begin(); it != end; it++) {
-    // if this block can hold this data and it's smaller than our current best
-    if (it->free && it->size >= size &&
-        (best == end || it->size < best->size)) {
-      best = it;
-    }
-  }
-
-  if (best != end) {
-    if (best->size == size) {
-      best->free = false;
-      // std::cout << "Matched " << size << " bytes\n";
-      return std::make_unique<CpuBuffer>(best->address, MemoryAllocators::Cpu);
-    }
-    const auto& new_block =
-      headers_.emplace(best, best->address, size, false, best->block_id);
-    assert(end == headers_.end());
-    best->size -= size;
-    best->address += size;
-    // std::cout << "Partitioned " << size << " bytes\n";
-    return std::make_unique<CpuBuffer>(new_block->address,
-                                       MemoryAllocators::Cpu);
-  }
-
-  auto size_to_allocate = std::max(size, block_size_);
-  if (allocated_ + size_to_allocate > max_allocate_) {
-    throw runtime_error("Too much requested");
+/// Get the smallest order such that 2^order >= size
+size_t getOrder(size_t size) {
+  size_t order = 0;
+  while ((size_t{1} << order) < size) {
+    order++;
   }
-  auto& new_block = data_.emplace_back(size_to_allocate);
-  allocated_ += size_to_allocate;
+  return order;
+}
+
+/// Get the index of the lowest set bit in a non-zero mask
+size_t lowestBit(uint64_t mask) {
+  assert(mask != 0);
+  return static_cast<size_t>(__builtin_ctzll(mask));
+}
 
-  auto* retval = new_block.data();
-  block_id_++;
+size_t getAllocatorId() {
+  static std::atomic<size_t> next_id = 0;
+  return next_id++;
+}
 
-  headers_.emplace_back(retval, size, false, block_id_);
-  assert(end == headers_.end());
-  if (size < block_size_) {
-    headers_.emplace_back(retval + size, block_size_ - size, true, block_id_);
-    assert(end == headers_.end());
-    // foo.next = std::prev(end);
+}  // namespace
+
+CpuAllocator::CpuAllocator(size_t block_size, size_t max_allocate,
+                           CpuMemoryOptions options)
+  : id_(getAllocatorId()),
+    max_allocate_(max_allocate),
+    block_order_(getOrder(block_size)),
+    options_(options),
+    kind_(options.pinned ? MemoryAllocators::CpuPinned
+                         : MemoryAllocators::Cpu) {
+#ifndef AMDINFER_ENABLE_MIGRAPHX
+  if (options.pinned) {
+    throw invalid_argument("Pinned memory needs a build with MIGraphX");
+  }
+#endif
+  // no initial capacity so orders that are never cached cost nothing
+  for (auto order = 0U; order < block_order_; ++order) {
+    depot_.emplace_back(0);
   }
+}
 
-  // std::cout << "Allocated " << size << " bytes\n";
-  return std::make_unique<CpuBuffer>(retval, MemoryAllocators::Cpu);
+CpuAllocator::~CpuAllocator() {
+  // free the thread caches now. Threads drop their references to them the
+  // next time they make a cache for any allocator
+  {
+    const std::lock_guard lock{caches_mutex_};
+    caches_.clear();
+  }
+  for (const auto& block : blocks_) {
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+    if (options_.pinned) {
+      hipHostUnregister(block.data);
+    }
+#endif
+    munmap(block.data, block.mapped_size);
+  }
 }
 
-void CpuAllocator::put(const void* address) {
+CpuAllocator::Block CpuAllocator::mapBlock(size_t order) const {
+  const auto size = size_t{1} << order;
+  const auto page_size = options_.page_size == 0
+                           ? static_cast<size_t>(sysconf(_SC_PAGESIZE))
+                           : options_.page_size;
+  const auto mapped_size = (size + page_size - 1) / page_size * page_size;
+
+  const auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* address = MAP_FAILED;
+  if (options_.page_size != 0) {
+    // use explicit huge pages if they're reserved, otherwise fall back to
+    // regular pages that may be promoted to transparent huge pages
+    const auto page_order = static_cast<int>(getOrder(page_size));
+    address =
+      mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+           flags | MAP_HUGETLB | (page_order << MAP_HUGE_SHIFT), -1, 0);
+  }
+  if (address == MAP_FAILED) {
+    address = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (address == MAP_FAILED) {
+      throw runtime_error("Memory could not be mapped");
+    }
+    if (options_.page_size != 0) {
+      madvise(address, mapped_size, MADV_HUGEPAGE);
+    }
+  }
+
+  // the pages aren't touched yet so binding here places all of them
+  util::bindMemoryToNumaNode(address, mapped_size, options_.numa_node);
+
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+  if (options_.pinned &&
+      hipHostRegister(address, mapped_size, hipHostRegisterDefault) !=
+        hipSuccess) {
+    munmap(address, mapped_size);
+    throw runtime_error("Memory could not be pinned");
+  }
+#endif
+  return {static_cast<std::byte*>(address), mapped_size, order};
+}
+
+CpuAllocator::ThreadCache& CpuAllocator::getThreadCache() {
+  struct CacheRef {
+    // only used while the allocator, which owns the cache, is alive
+    ThreadCache* cache;
+    std::weak_ptr<ThreadCache> owner;
+  };
+  // allocator IDs are never reused so entries of destroyed allocators are
+  // never looked up again
+  thread_local std::unordered_map<size_t, CacheRef> caches;
+  if (auto found = caches.find(id_); found != caches.end()) {
+    return *found->second.cache;
+  }
+
+  // drop the entries of the allocators destroyed since the last cache was made
+  for (auto it = caches.begin(); it != caches.end();) {
+    it = it->second.owner.expired() ? caches.erase(it) : std::next(it);
+  }
+  auto cache = std::make_shared<ThreadCache>();
+  {
+    const std::lock_guard lock{caches_mutex_};
+    caches_.push_back(cache);
+  }
+  caches.try_emplace(id_, CacheRef{cache.get(), cache});
+  return *cache;
+}
+
+void CpuAllocator::recordCacheAccess(ThreadCache& cache, bool hit) const {
+  hit ? cache.hits++ : cache.misses++;
+#ifdef AMDINFER_ENABLE_METRICS
+  if (cache.hits + cache.misses >= kCacheMetricsInterval) {
+    auto& metrics = Metrics::getInstance();
+    metrics.incrementCounter(MetricCounterIDs::MemoryCacheHits, cache.hits);
+    metrics.incrementCounter(MetricCounterIDs::MemoryCacheMisses,
+                             cache.misses);
+    cache.hits = 0;
+    cache.misses = 0;
+  }
+#endif
+}
+
+void CpuAllocator::uncache(const std::byte* address) {
+  const std::shared_lock lock{allocations_mutex_};
+  allocations_.find(address)->second.cached = false;
+}
+
+void CpuAllocator::spill(size_t order, const std::vector<std::byte*>& chunks) {
+  auto& depot = depot_.at(order);
+  if (depot.size_approx() + chunks.size() <= kDepotCapacity &&
+      depot.enqueue_bulk(chunks.begin(), chunks.size())) {
+    return;
+  }
+  release(chunks);
+}
+
+void CpuAllocator::drainCaches() {
+  std::vector<std::byte*> chunks;
+  {
+    const std::lock_guard lock{caches_mutex_};
+    for (auto& cache : caches_) {
+      const std::lock_guard cache_lock{cache->mutex};
+      for (auto& cached : cache->chunks) {
+        chunks.insert(chunks.end(), cached.begin(), cached.end());
+        cached.clear();
+      }
+    }
+  }
+  std::array<std::byte*, kCacheCapacity> taken{};
+  for (auto& depot : depot_) {
+    while (const auto count = depot.try_dequeue_bulk(taken.begin(),
+                                                     taken.size())) {
+      chunks.insert(chunks.end(), taken.begin(), taken.begin() + count);
+    }
+  }
+  release(chunks);
+}
+
+void CpuAllocator::addFree(std::byte* address, size_t order, Block* block) {
+  free_.at(order).try_emplace(address, block);
+  free_orders_ |= uint64_t{1} << order;
+}
+
+void CpuAllocator::removeFree(std::byte* address, size_t order) {
+  auto& free_list = free_.at(order);
+  free_list.erase(address);
+  if (free_list.empty()) {
+    free_orders_ &= ~(uint64_t{1} << order);
+  }
+}
+
+std::byte* CpuAllocator::allocate(size_t order) {
   const std::lock_guard lock{mutex_};
-  const auto end = headers_.end();
-  auto found = headers_.end();
-  for (auto it = headers_.begin(); it != end; it++) {
-    if (it->address == address) {
-      found = it;
-      break;
+
+  // find the smallest free chunk that can hold this data
+  const auto candidates = free_orders_ & ~((uint64_t{1} << order) - 1);
+  std::byte* address = nullptr;
+  Block* block = nullptr;
+  size_t found_order = 0;
+  if (candidates != 0) {
+    found_order = lowestBit(candidates);
+    std::tie(address, block) = *free_.at(found_order).begin();
+    removeFree(address, found_order);
+  } else {
+    found_order = std::max(order, block_order_);
+    auto size_to_allocate = size_t{1} << found_order;
+    if (allocated_ + size_to_allocate > max_allocate_) {
+      throw runtime_error("Too much requested");
     }
+    block = &blocks_.emplace_back(mapBlock(found_order));
+    allocated_ += size_to_allocate;
+    address = block->data;
   }
+  assert(block != nullptr);
 
-  if (found == end) {
-    throw runtime_error("Address not found");
+  // split the chunk in half until it's the right size, freeing the upper halves
+  while (found_order > order) {
+    found_order--;
+    addFree(address + (size_t{1} << found_order), found_order, block);
   }
 
-  // if the previous is free and from the same block, merge the two
-  if (found != std::begin(headers_)) {
-    auto prev = std::prev(found);
-    if (prev->block_id == found->block_id && prev->free) {
-      prev->size += found->size;
-      headers_.erase(found);
-      found = prev;
+  used_ += size_t{1} << order;
+  const std::lock_guard allocations_lock{allocations_mutex_};
+  allocations_.try_emplace(address, block, order);
+  return address;
+}
+
+void CpuAllocator::release(const std::vector<std::byte*>& addresses) {
+  if (addresses.empty()) {
+    return;
+  }
+
+  const std::lock_guard lock{mutex_};
+  const std::lock_guard allocations_lock{allocations_mutex_};
+  for (auto* address : addresses) {
+    auto found = allocations_.find(address);
+    assert(found != allocations_.end());
+    auto* block = found->second.block;
+    auto order = found->second.order;
+    allocations_.erase(found);
+    used_ -= size_t{1} << order;
+
+    // merge the chunk with its buddy as long as the buddy is also free
+    auto* base = block->data;
+    auto offset = static_cast<size_t>(address - base);
+    while (order < block->order) {
+      auto buddy = offset ^ (size_t{1} << order);
+      const auto& free_list = free_.at(order);
+      if (free_list.find(base + buddy) == free_list.end()) {
+        break;
+      }
+      removeFree(base + buddy, order);
+      offset &= ~(size_t{1} << order);
+      order++;
     }
+    addFree(base + offset, order, block);
   }
+}
 
-  // if the next is free and from the same block, merge the two
-  if (found != std::prev(std::end(headers_))) {
-    auto next = std::next(found);
-    if (next->block_id == found->block_id && next->free) {
-      next->size += found->size;
-      next->address = found->address;
-      headers_.erase(found);
-    } else {
-      found->free = true;
+BufferPtr CpuAllocator::get(const Tensor& tensor, size_t batch_size) {
+  auto size = tensor.getSize() * tensor.getDatatype().size() * batch_size;
+  const auto order = getOrder(size);
+  if (order >= kMaxOrder) {
+    failures_++;
+    throw runtime_error("Too much requested");
+  }
+
+  if (order < block_order_) {
+    auto& cache = getThreadCache();
+    std::byte* address = nullptr;
+    {
+      const std::lock_guard lock{cache.mutex};
+      auto& cached = cache.chunks.at(order);
+      if (cached.empty()) {
+        // refill the whole cache from the chunks other threads put
+        cached.resize(kCacheCapacity);
+        cached.resize(
+          depot_.at(order).try_dequeue_bulk(cached.begin(), kCacheCapacity));
+      }
+      const bool hit = !cached.empty();
+      recordCacheAccess(cache, hit);
+      if (hit) {
+        address = cached.back();
+        cached.pop_back();
+      }
+    }
+    if (address != nullptr) {
+      uncache(address);
+      return std::make_unique<CpuBuffer>(address, kind_);
+    }
+  }
+
+  std::byte* address = nullptr;
+  try {
+    address = allocate(order);
+  } catch (const runtime_error&) {
+    // the memory may be held in the thread caches so try again without them
+    drainCaches();
+    try {
+      address = allocate(order);
+    } catch (const runtime_error&) {
+      failures_++;
+      throw;
     }
-  } else {
-    found->free = true;
   }
+  return std::make_unique<CpuBuffer>(address, kind_);
+}
+
+void CpuAllocator::reserve(const Tensor& tensor, size_t batch_size,
+                           size_t count) {
+  auto size = tensor.getSize() * tensor.getDatatype().size() * batch_size;
+  const auto order = getOrder(size);
+  if (order >= kMaxOrder) {
+    failures_++;
+    throw runtime_error("Too much requested");
+  }
+
+  std::vector<std::byte*> chunks;
+  chunks.reserve(count);
+  try {
+    for (auto i = 0U; i < count; ++i) {
+      auto* address = allocate(order);
+      // fault in the pages now instead of on the first request
+      std::memset(address, 0, size_t{1} << order);
+      chunks.push_back(address);
+    }
+  } catch (const runtime_error&) {
+    failures_++;
+    release(chunks);
+    throw;
+  }
+  release(chunks);
+}
 
-  // std::cout << "Freed memory\n";
+MemoryStats CpuAllocator::getStats(bool with_blocks) {
+  MemoryStats stats;
+  {
+    const std::lock_guard lock{caches_mutex_};
+    for (auto& cache : caches_) {
+      const std::lock_guard cache_lock{cache->mutex};
+      for (auto order = 0U; order < kMaxOrder; ++order) {
+        stats.cached += cache->chunks.at(order).size() << order;
+      }
+    }
+  }
+  for (auto order = 0U; order < depot_.size(); ++order) {
+    stats.cached += depot_[order].size_approx() << order;
+  }
+
+  const std::lock_guard lock{mutex_};
+  stats.reserved = allocated_;
+  stats.used = used_;
+  stats.failures = failures_.load();
+
+  std::unordered_map<const Block*, MemoryBlock*> blocks;
+  if (with_blocks) {
+    stats.blocks.reserve(blocks_.size());
+    for (const auto& block : blocks_) {
+      auto& entry = stats.blocks.emplace_back();
+      entry.address = reinterpret_cast<uintptr_t>(block.data);
+      entry.size = size_t{1} << block.order;
+      blocks.try_emplace(&block, &entry);
+    }
+  }
+  for (auto order = 0U; order < kMaxOrder; ++order) {
+    const auto& free_list = free_.at(order);
+    if (free_list.empty()) {
+      continue;
+    }
+    stats.free_chunks += free_list.size();
+    stats.largest_free = size_t{1} << order;
+    for (const auto& [address, block] : free_list) {
+      if (auto found = blocks.find(block); found != blocks.end()) {
+        found->second->free.push_back(
+          {static_cast<size_t>(address - block->data), size_t{1} << order});
+      }
+    }
+  }
+  for (auto& block : stats.blocks) {
+    std::sort(block.free.begin(), block.free.end(),
+              [](const auto& lhs, const auto& rhs) {
+                return lhs.offset < rhs.offset;
+              });
+  }
+  return stats;
+}
+
+bool CpuAllocator::contains(const void* address) {
+  const std::shared_lock lock{allocations_mutex_};
+  return allocations_.find(address) != allocations_.end();
+}
+
+void CpuAllocator::put(const void* address) {
+  size_t order = 0;
+  {
+    const std::shared_lock lock{allocations_mutex_};
+    auto found = allocations_.find(address);
+    if (found == allocations_.end()) {
+      throw runtime_error("Address not found");
+    }
+    if (found->second.cached.exchange(true)) {
+      throw runtime_error("Address already freed");
+    }
+    order = found->second.order;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  auto* chunk = static_cast<std::byte*>(const_cast<void*>(address));
+  if (order >= block_order_) {
+    release({chunk});
+    return;
+  }
+
+  std::vector<std::byte*> overflow;
+  {
+    auto& cache = getThreadCache();
+    const std::lock_guard lock{cache.mutex};
+    auto& cached = cache.chunks.at(order);
+    cached.push_back(chunk);
+    // move half the cache at once so it doesn't overflow on the next put
+    if (cached.size() > kCacheCapacity) {
+      auto half = cached.begin() + kCacheCapacity / 2;
+      overflow.assign(cached.begin(), half);
+      cached.erase(cached.begin(), half);
+    }
+  }
+  if (!overflow.empty()) {
+    spill(order, overflow);
+  }
 }
 
 }  // namespace amdinfer
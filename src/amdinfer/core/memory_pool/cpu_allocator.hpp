@@ -20,34 +20,154 @@
 #ifndef GUARD_AMDINFER_CORE_MEMORY_POOL_CPU_ALLOCATOR
 #define GUARD_AMDINFER_CORE_MEMORY_POOL_CPU_ALLOCATOR
 
+#include <concurrentqueue/concurrentqueue.h>
+
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "amdinfer/core/memory_pool/memory_allocator.hpp"
 
 namespace amdinfer {
 
-struct MemoryHeader;
+/// Options for how the CpuAllocator maps its blocks
+struct CpuMemoryOptions {
+  /// Size of the pages to back the blocks with, e.g. 2 MiB or 1 GiB for huge
+  /// pages. If 0, the system's default page size is used
+  size_t page_size = 0;
+  /// NUMA node to bind the blocks to. If negative, the blocks are not bound
+  int numa_node = -1;
+  /// Page-lock the blocks so GPUs can DMA from them directly. This needs HIP,
+  /// which is available in builds with MIGraphX
+  bool pinned = false;
+};
 
+/**
+ * @brief The CpuAllocator is a buddy allocator over blocks of CPU memory.
+ * Chunks are sized in powers of two and a chunk and its buddy are merged when
+ * both are free so get and put run in constant time. Chunks smaller than a
+ * block are cached per thread when they're freed so they can be reused without
+ * going through the shared allocator. Chunks are often freed by a different
+ * thread than the one that got them, e.g. a request's memory is got on ingress
+ * and put after its batch runs, so a full cache moves half its chunks to a
+ * lock-free depot shared by the threads and a thread whose cache is empty
+ * refills it from there.
+ *
+ */
 class CpuAllocator : public MemoryAllocator {
  public:
-  explicit CpuAllocator(size_t block_size, size_t max_allocated = -1);
+  /**
+   * @brief Construct a new CpuAllocator object
+   *
+   * @param block_size minimum size of the blocks allocated from the system.
+   * It's rounded up to a power of two.
+   * @param max_allocated maximum number of bytes to allocate from the system
+   * @param options options for how the blocks are mapped
+   */
+  explicit CpuAllocator(size_t block_size, size_t max_allocated = -1,
+                        CpuMemoryOptions options = {});
+  ~CpuAllocator() override;
+  CpuAllocator(CpuAllocator const&) = delete;
+  CpuAllocator& operator=(const CpuAllocator&) = delete;
+  CpuAllocator(CpuAllocator&& other) = delete;
+  CpuAllocator& operator=(CpuAllocator&& other) = delete;
 
   [[nodiscard]] BufferPtr get(const Tensor& tensor, size_t batch_size) override;
   void put(const void* address) override;
-
-  // void free(const void* address);
+  [[nodiscard]] MemoryStats getStats(bool with_blocks) override;
+  /// Check if an address was allocated by this allocator
+  [[nodiscard]] bool contains(const void* address);
+  /**
+   * @brief Allocate and touch memory for count allocations of this size and
+   * return it to the pool. Later allocations of this size then use memory that
+   * is already mapped and faulted in.
+   *
+   * @param tensor tensor to reserve memory for
+   * @param batch_size batch size of each allocation
+   * @param count number of allocations to reserve
+   */
+  void reserve(const Tensor& tensor, size_t batch_size, size_t count);
 
  private:
+  static constexpr size_t kMaxOrder = 64;
+
+  struct Block {
+    std::byte* data;
+    size_t mapped_size;
+    size_t order;
+  };
+
+  struct Allocation {
+    Allocation(Block* block, size_t order) : block(block), order(order) {}
+    Block* block;
+    size_t order;
+    // set while the chunk is free in a thread cache or the depot so putting
+    // it again is caught instead of handing it out twice
+    std::atomic_bool cached = false;
+  };
+
+  /// Chunks freed by one thread, by order
+  struct ThreadCache {
+    // only contended if the caches are drained
+    std::mutex mutex;
+    std::array<std::vector<std::byte*>, kMaxOrder> chunks;
+    // cache hits and misses not yet reported to the metrics
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  ThreadCache& getThreadCache();
+  void recordCacheAccess(ThreadCache& cache, bool hit) const;
+  /// Clear the mark of a chunk that's taken from a cache
+  void uncache(const std::byte* address);
+  /// Move chunks from a full thread cache to the depot or, if it's full too,
+  /// return them to the shared allocator
+  void spill(size_t order, const std::vector<std::byte*>& chunks);
+  /// Return all the chunks in the thread caches and the depot to the shared
+  /// allocator
+  void drainCaches();
+
+  /// Map a new block of memory of the given order
+  Block mapBlock(size_t order) const;
+  std::byte* allocate(size_t order);
+  void release(const std::vector<std::byte*>& addresses);
+  void addFree(std::byte* address, size_t order, Block* block);
+  void removeFree(std::byte* address, size_t order);
+
+  // unique ID used to find this allocator's thread caches
+  const size_t id_;
   size_t allocated_ = 0;
+  // bytes in allocated chunks
+  size_t used_ = 0;
+  std::atomic<size_t> failures_ = 0;
   size_t max_allocate_;
-  size_t block_size_;
-  size_t block_id_ = 0;
+  size_t block_order_;
+  CpuMemoryOptions options_;
+  // the kind of memory this allocator provides to the buffers
+  MemoryAllocators kind_;
   std::mutex mutex_;
-  std::list<MemoryHeader> headers_;
-  std::list<std::vector<std::byte>> data_;
+  std::list<Block> blocks_;
+  // free chunks and their blocks by order and a bitmask of the orders that
+  // have free chunks
+  std::array<std::unordered_map<std::byte*, Block*>, kMaxOrder> free_;
+  uint64_t free_orders_ = 0;
+  // allocated chunks, including cached ones
+  std::shared_mutex allocations_mutex_;
+  std::unordered_map<const void*, Allocation> allocations_;
+  // the thread caches of this allocator. Threads only hold weak references
+  // to them so they're freed with the allocator
+  std::mutex caches_mutex_;
+  std::vector<std::shared_ptr<ThreadCache>> caches_;
+  // chunks moved out of full thread caches, by order, for any thread to take
+  std::deque<moodycamel::ConcurrentQueue<std::byte*>> depot_;
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,159 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the HipAllocator class
+ */
+
+#include "amdinfer/core/memory_pool/hip_allocator.hpp"
+
+#include <hip/hip_runtime_api.h>  // for hipMalloc, hipFree, hipGetDevice
+
+#include <algorithm>
+
+#include "amdinfer/buffers/hip.hpp"
+#include "amdinfer/core/exceptions.hpp"
+#include "amdinfer/core/inference_request.hpp"
+
+namespace amdinfer {
+
+namespace {
+
+/// Get the smallest order such that 2^order >= size
+size_t getOrder(size_t size) {
+  size_t order = 0;
+  while ((size_t{1} << order) < size) {
+    order++;
+  }
+  return order;
+}
+
+}  // namespace
+
+HipAllocator::HipAllocator(size_t max_allocate) : max_allocate_(max_allocate) {}
+
+HipAllocator::~HipAllocator() {
+  releaseFree();
+  for (const auto& [address, allocation] : allocations_) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    hipFree(const_cast<void*>(address));
+  }
+}
+
+void HipAllocator::releaseFree() {
+  for (auto& [device, orders] : free_) {
+    for (auto order = 0U; order < kMaxOrder; ++order) {
+      auto& cached = orders.at(order);
+      for (auto* address : cached) {
+        hipFree(address);
+        allocated_ -= size_t{1} << order;
+      }
+      cached.clear();
+    }
+  }
+}
+
+BufferPtr HipAllocator::get(const Tensor& tensor, size_t batch_size) {
+  auto size = tensor.getSize() * tensor.getDatatype().size() * batch_size;
+  const auto order = getOrder(size);
+  if (order >= kMaxOrder) {
+    failures_++;
+    throw runtime_error("Too much requested");
+  }
+
+  int device = 0;
+  if (hipGetDevice(&device) != hipSuccess) {
+    throw runtime_error("No HIP device found");
+  }
+
+  const std::lock_guard lock{mutex_};
+  void* address = nullptr;
+  if (auto& cached = free_[device].at(order); !cached.empty()) {
+    address = cached.back();
+    cached.pop_back();
+  } else {
+    const auto size_to_allocate = size_t{1} << order;
+    // memory cached for other sizes may be needed to fit this allocation
+    if (allocated_ + size_to_allocate > max_allocate_) {
+      releaseFree();
+    }
+    if (allocated_ + size_to_allocate > max_allocate_) {
+      failures_++;
+      throw runtime_error("Too much requested");
+    }
+    if (hipMalloc(&address, size_to_allocate) != hipSuccess) {
+      releaseFree();
+      if (hipMalloc(&address, size_to_allocate) != hipSuccess) {
+        failures_++;
+        throw runtime_error("Too much requested");
+      }
+    }
+    allocated_ += size_to_allocate;
+  }
+
+  used_ += size_t{1} << order;
+  allocations_.try_emplace(address, Allocation{device, order});
+  return std::make_unique<HipBuffer>(address, MemoryAllocators::HipDevice);
+}
+
+void HipAllocator::put(const void* address) {
+  const std::lock_guard lock{mutex_};
+  auto found = allocations_.find(address);
+  if (found == allocations_.end()) {
+    throw runtime_error("Address not found");
+  }
+  const auto [device, order] = found->second;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  free_[device].at(order).push_back(const_cast<void*>(address));
+  allocations_.erase(found);
+  used_ -= size_t{1} << order;
+}
+
+MemoryStats HipAllocator::getStats(bool with_blocks) {
+  MemoryStats stats;
+  const std::lock_guard lock{mutex_};
+  stats.reserved = allocated_;
+  stats.used = used_;
+  stats.failures = failures_.load();
+
+  // each allocation is its own block and freed ones are free in whole
+  for (const auto& [device, orders] : free_) {
+    for (auto order = 0U; order < kMaxOrder; ++order) {
+      const auto& cached = orders.at(order);
+      const auto size = size_t{1} << order;
+      stats.free_chunks += cached.size();
+      if (!cached.empty()) {
+        stats.largest_free = std::max(stats.largest_free, size);
+      }
+      if (with_blocks) {
+        for (auto* address : cached) {
+          stats.blocks.push_back({reinterpret_cast<uintptr_t>(address), size,
+                                  device, {{0, size}}});
+        }
+      }
+    }
+  }
+  if (with_blocks) {
+    for (const auto& [address, allocation] : allocations_) {
+      stats.blocks.push_back({reinterpret_cast<uintptr_t>(address),
+                              size_t{1} << allocation.order,
+                              allocation.device,
+                              {}});
+    }
+  }
+  return stats;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,92 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the HipAllocator class
+ */
+
+#ifndef GUARD_AMDINFER_CORE_MEMORY_POOL_HIP_ALLOCATOR
+#define GUARD_AMDINFER_CORE_MEMORY_POOL_HIP_ALLOCATOR
+
+#include "amdinfer/build_options.hpp"
+
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "amdinfer/core/memory_pool/memory_allocator.hpp"
+
+namespace amdinfer {
+
+/**
+ * @brief The HipAllocator provides GPU device memory. Allocations are rounded
+ * up to a power of two and freed allocations are kept for reuse because
+ * hipMalloc and hipFree synchronize the device. Memory is allocated on the
+ * calling thread's current device and freed allocations are only reused on the
+ * device they came from.
+ *
+ */
+class HipAllocator : public MemoryAllocator {
+ public:
+  /**
+   * @brief Construct a new HipAllocator object
+   *
+   * @param max_allocated maximum number of bytes to allocate from the device
+   */
+  explicit HipAllocator(size_t max_allocated = -1);
+  ~HipAllocator() override;
+  HipAllocator(HipAllocator const&) = delete;
+  HipAllocator& operator=(const HipAllocator&) = delete;
+  HipAllocator(HipAllocator&& other) = delete;
+  HipAllocator& operator=(HipAllocator&& other) = delete;
+
+  [[nodiscard]] BufferPtr get(const Tensor& tensor, size_t batch_size) override;
+  void put(const void* address) override;
+  [[nodiscard]] MemoryStats getStats(bool with_blocks) override;
+
+ private:
+  static constexpr size_t kMaxOrder = 64;
+
+  /// Free the cached allocations back to the device. The mutex must be held
+  void releaseFree();
+
+  struct Allocation {
+    int device;
+    size_t order;
+  };
+
+  size_t allocated_ = 0;
+  // bytes in the allocations in use
+  size_t used_ = 0;
+  std::atomic<size_t> failures_ = 0;
+  size_t max_allocate_;
+  std::mutex mutex_;
+  // freed allocations by device and order
+  std::map<int, std::array<std::vector<void*>, kMaxOrder>> free_;
+  // devices and orders of the allocations in use
+  std::unordered_map<const void*, Allocation> allocations_;
+};
+
+}  // namespace amdinfer
+
+#endif
+
+#endif  // GUARD_AMDINFER_CORE_MEMORY_POOL_HIP_ALLOCATOR
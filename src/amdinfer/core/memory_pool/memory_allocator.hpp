@@ -21,13 +21,15 @@
 #define GUARD_AMDINFER_CORE_MEMORY_POOL_MEMORY_ALLOCATOR
 
 #include <cstddef>  // for size_t
+#include <cstdint>  // for uintptr_t
+#include <vector>   // for vector
 
 #include "amdinfer/core/tensor.hpp"
 #include "amdinfer/declarations.hpp"
 
 namespace amdinfer {
 
-enum class MemoryAllocators { Cpu, VartTensor };
+enum class MemoryAllocators { Cpu, CpuPinned, HipDevice, VartTensor };
 
 struct MemoryHeader {
   std::byte* address;
@@ -39,6 +41,54 @@ struct MemoryHeader {
     : address(address), free(free), size(size), block_id(block_id) {}
 };
 
+/// A free range of memory in a block, relative to the start of the block
+struct MemoryChunk {
+  size_t offset;
+  size_t size;
+};
+
+/// A block of memory that an allocator got from the system or a device
+struct MemoryBlock {
+  uintptr_t address;
+  size_t size;
+  /// device the block is on or -1 if it's in CPU memory
+  int device = -1;
+  /// free chunks in the block. A block with none is fully in use
+  std::vector<MemoryChunk> free;
+};
+
+/// A snapshot of how much of an allocator's memory is in use
+struct MemoryStats {
+  /// bytes allocated from the system or a device
+  size_t reserved = 0;
+  /// bytes handed out to buffers, including ones cached for reuse by a thread
+  size_t used = 0;
+  /// bytes handed out but cached by a thread after being freed
+  size_t cached = 0;
+  /// number of free chunks
+  size_t free_chunks = 0;
+  /// bytes in the largest free chunk
+  size_t largest_free = 0;
+  /// number of allocations that failed since the allocator was made
+  size_t failures = 0;
+  /// the blocks, if they were asked for
+  std::vector<MemoryBlock> blocks;
+
+  /**
+   * @brief Get how fragmented the free memory is: 0 if the largest free chunk
+   * holds all of it, approaching 1 as it's split into many small chunks
+   *
+   * @return double
+   */
+  [[nodiscard]] double fragmentation() const {
+    const auto free = reserved - used;
+    if (free == 0) {
+      return 0;
+    }
+    return 1 - (static_cast<double>(largest_free) / static_cast<double>(free));
+  }
+};
+
 class MemoryAllocator {
  public:
   virtual ~MemoryAllocator() = default;
@@ -47,6 +97,13 @@ class MemoryAllocator {
   [[nodiscard]] virtual BufferPtr get(const Tensor& tensor,
                                       size_t batch_size) = 0;
   virtual void put(const void* address) = 0;
+  /**
+   * @brief Get a snapshot of the allocator's memory
+   *
+   * @param with_blocks if true, also list the blocks and their free chunks
+   * @return MemoryStats
+   */
+  [[nodiscard]] virtual MemoryStats getStats(bool with_blocks) = 0;
 };
 
 }  // namespace amdinfer
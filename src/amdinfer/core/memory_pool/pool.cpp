@@ -19,24 +19,113 @@
 
 #include "amdinfer/core/memory_pool/pool.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <string>
+#include <utility>
 
 #include "amdinfer/buffers/cpu.hpp"
 #include "amdinfer/core/exceptions.hpp"
 #include "amdinfer/core/memory_pool/cpu_allocator.hpp"
+#include "amdinfer/core/memory_pool/hip_allocator.hpp"
 #include "amdinfer/core/memory_pool/vart_tensor_allocator.hpp"
+#include "amdinfer/observation/metrics.hpp"
+#include "amdinfer/util/numa.hpp"
 
 namespace amdinfer {
 
 const size_t kDefaultCpuBlockSize = 1'048'576;  // arbitrarily 1MiB
 
-MemoryPool::MemoryPool() {
-  allocators_.try_emplace(MemoryAllocators::Cpu,
-                          std::make_unique<CpuAllocator>(kDefaultCpuBlockSize));
+namespace {
+
+std::string getName(MemoryAllocators allocator) {
+  switch (allocator) {
+    case MemoryAllocators::Cpu:
+      return "cpu";
+    case MemoryAllocators::CpuPinned:
+      return "cpu_pinned";
+    case MemoryAllocators::HipDevice:
+      return "hip_device";
+    case MemoryAllocators::VartTensor:
+      return "vart_tensor";
+    default:
+      return "unknown";
+  }
+}
+
+#ifdef AMDINFER_ENABLE_METRICS
+/// Set the memory pool's metrics from snapshots of its allocators
+class MemoryPoolMetrics {
+ public:
+  explicit MemoryPoolMetrics(const MemoryPool* pool) : pool_(pool) {}
+
+  void operator()(Metrics* metrics) {
+    for (const auto& [allocator, node, stats] : pool_->getStats()) {
+      const MetricLabels labels{{"allocator", allocator},
+                                {"node", std::to_string(node)}};
+      metrics->setGauge(MetricGaugeIDs::MemoryReserved, labels,
+                        static_cast<double>(stats.reserved));
+      metrics->setGauge(MetricGaugeIDs::MemoryUsed, labels,
+                        static_cast<double>(stats.used));
+      metrics->setGauge(MetricGaugeIDs::MemoryCached, labels,
+                        static_cast<double>(stats.cached));
+      metrics->setGauge(MetricGaugeIDs::MemoryFreeChunks, labels,
+                        static_cast<double>(stats.free_chunks));
+      metrics->setGauge(MetricGaugeIDs::MemoryLargestFree, labels,
+                        static_cast<double>(stats.largest_free));
+      metrics->setGauge(MetricGaugeIDs::MemoryFragmentation, labels,
+                        stats.fragmentation());
+      // the allocators count their failures so only the new ones are added
+      auto& reported = failures_[labels];
+      metrics->incrementCounter(MetricCounterIDs::MemoryAllocationFailures,
+                                labels, stats.failures - reported);
+      reported = stats.failures;
+    }
+  }
+
+ private:
+  const MemoryPool* pool_;
+  std::map<MetricLabels, size_t> failures_;
+};
+#endif
+
+}  // namespace
+
+MemoryPool::MemoryPool(const CpuMemoryOptions& options) {
+  const auto nodes = options.numa_node < 0 ? util::getNumaNodes()
+                                           : std::vector{options.numa_node};
+  for (const auto& node : nodes) {
+    auto arena_options = options;
+    // only bind the arenas if there's more than one node to choose from
+    if (nodes.size() > 1) {
+      arena_options.numa_node = node;
+    }
+    cpu_arenas_.try_emplace(
+      node, std::make_unique<CpuAllocator>(kDefaultCpuBlockSize, -1,
+                                           arena_options));
+  }
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+  auto pinned_options = options;
+  pinned_options.pinned = true;
+  allocators_.try_emplace(
+    MemoryAllocators::CpuPinned,
+    std::make_unique<CpuAllocator>(kDefaultCpuBlockSize, -1, pinned_options));
+  allocators_.try_emplace(MemoryAllocators::HipDevice,
+                          std::make_unique<HipAllocator>());
+#endif
 #ifdef AMDINFER_ENABLE_VITIS
   allocators_.try_emplace(MemoryAllocators::VartTensor,
                           std::make_unique<VartTensorAllocator>());
 #endif
+#ifdef AMDINFER_ENABLE_METRICS
+  Metrics::getInstance().watchMetrics(this, MemoryPoolMetrics{this});
+#endif
+}
+
+MemoryPool::~MemoryPool() {
+#ifdef AMDINFER_ENABLE_METRICS
+  Metrics::getInstance().unwatchMetrics(this);
+#endif
 }
 
 std::unique_ptr<Buffer> MemoryPool::get(
@@ -45,9 +134,7 @@ std::unique_ptr<Buffer> MemoryPool::get(
   assert(!allocators.empty());
   for (const auto& allocator : allocators) {
     try {
-      auto buffer = allocators_.at(allocator)->get(tensor, batch_size);
-      buffer->setPool(this);
-      return buffer;
+      return get(allocator, tensor, batch_size);
     } catch (const runtime_error&) {
       continue;
     }
@@ -55,8 +142,205 @@ std::unique_ptr<Buffer> MemoryPool::get(
   throw runtime_error("Memory could not be allocated");
 }
 
+std::unique_ptr<Buffer> MemoryPool::get(MemoryAllocators allocator,
+                                        const Tensor& tensor,
+                                        size_t batch_size) const {
+  if (allocator == MemoryAllocators::Cpu &&
+      slab_count_.load(std::memory_order_acquire) > 0) {
+    const auto size =
+      tensor.getSize() * tensor.getDatatype().size() * batch_size;
+    const std::shared_lock lock{slabs_mutex_};
+    for (const auto& slabs : slabs_) {
+      if (!slabs.open) {
+        continue;
+      }
+      if (auto* slot = slabs.allocator->take(size); slot != nullptr) {
+        auto buffer = std::make_unique<CpuBuffer>(slot, MemoryAllocators::Cpu);
+        buffer->setPool(this);
+        return buffer;
+      }
+    }
+  }
+  auto buffer = allocator == MemoryAllocators::Cpu
+                  ? getCpuArena()->get(tensor, batch_size)
+                  : allocators_.at(allocator)->get(tensor, batch_size);
+  buffer->setPool(this);
+  return buffer;
+}
+
 void MemoryPool::put(MemoryAllocators allocator, void* memory) const {
-  allocators_.at(allocator)->put(memory);
+  if (allocator != MemoryAllocators::Cpu) {
+    allocators_.at(allocator)->put(memory);
+    return;
+  }
+
+  if (borrowed_count_.load(std::memory_order_acquire) > 0) {
+    const std::lock_guard lock{borrowed_mutex_};
+    if (auto found = borrowed_.find(memory); found != borrowed_.end()) {
+      borrowed_.erase(found);
+      borrowed_count_.fetch_sub(1, std::memory_order_release);
+      return;
+    }
+  }
+  if (slab_count_.load(std::memory_order_acquire) > 0 &&
+      this->putSlot(memory)) {
+    return;
+  }
+
+  // memory is usually freed on the node it was allocated on
+  auto* arena = getCpuArena();
+  if (!arena->contains(memory)) {
+    for (const auto& [node, other] : cpu_arenas_) {
+      if (other->contains(memory)) {
+        arena = other.get();
+        break;
+      }
+    }
+  }
+  arena->put(memory);
+}
+
+void MemoryPool::borrow(const void* memory) const {
+  const std::lock_guard lock{borrowed_mutex_};
+  borrowed_.insert(memory);
+  borrowed_count_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<void> MemoryPool::addSlabs(std::vector<size_t> sizes,
+                                           size_t count) const {
+  // like the arenas, the slabs are local to the node that adds them
+  const auto node = cpu_arenas_.size() > 1 ? util::getNumaNode() : -1;
+  auto allocator =
+    std::make_unique<SlabAllocator>(std::move(sizes), count, node);
+  auto* handle = allocator.get();
+  {
+    const std::lock_guard lock{slabs_mutex_};
+    slabs_.push_back({std::move(allocator), true});
+    slab_count_.store(slabs_.size(), std::memory_order_release);
+  }
+  return {handle, [this](const void* slabs) { this->closeSlabs(slabs); }};
+}
+
+bool MemoryPool::putSlot(void* memory) const {
+  bool retire = false;
+  {
+    const std::shared_lock lock{slabs_mutex_};
+    auto found =
+      std::find_if(slabs_.begin(), slabs_.end(), [memory](const Slabs& slabs) {
+        return slabs.allocator->contains(memory);
+      });
+    if (found == slabs_.end()) {
+      return false;
+    }
+    found->allocator->put(memory);
+    retire = !found->open && !found->allocator->inUse();
+  }
+  if (retire) {
+    this->retireSlabs();
+  }
+  return true;
+}
+
+void MemoryPool::closeSlabs(const void* handle) const {
+  {
+    const std::lock_guard lock{slabs_mutex_};
+    for (auto& slabs : slabs_) {
+      if (slabs.allocator.get() == handle) {
+        slabs.open = false;
+      }
+    }
+  }
+  this->retireSlabs();
+}
+
+void MemoryPool::retireSlabs() const {
+  const std::lock_guard lock{slabs_mutex_};
+  slabs_.erase(std::remove_if(slabs_.begin(), slabs_.end(),
+                              [](const Slabs& slabs) {
+                                return !slabs.open &&
+                                       !slabs.allocator->inUse();
+                              }),
+               slabs_.end());
+  slab_count_.store(slabs_.size(), std::memory_order_release);
+}
+
+void MemoryPool::reserve(const MemoryReservation& reservation) const {
+  assert(!reservation.allocators.empty());
+  const auto& [allocators, tensor, batch_size, count] = reservation;
+  for (const auto& allocator : allocators) {
+    MemoryAllocator* pool = allocator == MemoryAllocators::Cpu
+                              ? getCpuArena()
+                              : allocators_.at(allocator).get();
+    try {
+      // CPU memory is reserved directly so it isn't held in this thread's
+      // cache
+      if (auto* cpu_pool = dynamic_cast<CpuAllocator*>(pool);
+          cpu_pool != nullptr) {
+        cpu_pool->reserve(tensor, batch_size, count);
+        return;
+      }
+
+      // other allocators keep freed memory so getting and putting it is enough
+      std::vector<BufferPtr> buffers;
+      buffers.reserve(count);
+      auto free_buffers = [&buffers]() {
+        for (const auto& buffer : buffers) {
+          buffer->free();
+        }
+      };
+      try {
+        for (auto i = 0U; i < count; ++i) {
+          auto& buffer = buffers.emplace_back(pool->get(tensor, batch_size));
+          buffer->setPool(this);
+        }
+      } catch (const runtime_error&) {
+        free_buffers();
+        throw;
+      }
+      free_buffers();
+      return;
+    } catch (const runtime_error&) {
+      continue;
+    }
+  }
+  throw runtime_error("Memory could not be reserved");
+}
+
+std::vector<MemoryPoolStats> MemoryPool::getStats(bool with_blocks) const {
+  std::vector<MemoryPoolStats> stats;
+  for (const auto& [node, arena] : cpu_arenas_) {
+    stats.push_back({getName(MemoryAllocators::Cpu), node,
+                     arena->getStats(with_blocks)});
+  }
+  for (const auto& [kind, allocator] : allocators_) {
+    stats.push_back({getName(kind), -1, allocator->getStats(with_blocks)});
+  }
+  // the slabs are reported together as they come and go with the endpoints.
+  // Running out of slots isn't a failure as the arenas are used instead
+  const std::shared_lock lock{slabs_mutex_};
+  if (!slabs_.empty()) {
+    MemoryPoolStats total{"cpu_slab", -1, {}};
+    for (const auto& slabs : slabs_) {
+      const auto slab_stats = slabs.allocator->getStats(with_blocks);
+      total.stats.reserved += slab_stats.reserved;
+      total.stats.used += slab_stats.used;
+      total.stats.free_chunks += slab_stats.free_chunks;
+      total.stats.largest_free =
+        std::max(total.stats.largest_free, slab_stats.largest_free);
+    }
+    stats.push_back(std::move(total));
+  }
+  return stats;
+}
+
+CpuAllocator* MemoryPool::getCpuArena() const {
+  if (cpu_arenas_.size() > 1) {
+    if (auto found = cpu_arenas_.find(util::getNumaNode());
+        found != cpu_arenas_.end()) {
+      return found->second.get();
+    }
+  }
+  return cpu_arenas_.begin()->second.get();
 }
 
 }  // namespace amdinfer
@@ -20,28 +20,146 @@
 #ifndef GUARD_AMDINFER_CORE_MEMORY_POOL_POOL
 #define GUARD_AMDINFER_CORE_MEMORY_POOL_POOL
 
+#include <atomic>
 #include <cstddef>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "amdinfer/build_options.hpp"
+#include "amdinfer/core/memory_pool/cpu_allocator.hpp"
 #include "amdinfer/core/memory_pool/memory_allocator.hpp"
+#include "amdinfer/core/memory_pool/slab_allocator.hpp"
 #include "amdinfer/declarations.hpp"
 
 namespace amdinfer {
 
+/// Memory that a worker needs in steady state, reserved when it's loaded
+struct MemoryReservation {
+  /// allocators to reserve from in order of preference
+  std::vector<MemoryAllocators> allocators;
+  /// tensor to reserve memory for
+  Tensor tensor;
+  /// batch size of each allocation
+  size_t batch_size;
+  /// number of allocations to reserve
+  size_t count;
+};
+
+/// A snapshot of one of the pool's allocators
+struct MemoryPoolStats {
+  /// name of the allocator: cpu, cpu_pinned, cpu_slab, hip_device or
+  /// vart_tensor
+  std::string allocator;
+  /// NUMA node of a CPU arena or -1 for the other allocators
+  int numa_node;
+  MemoryStats stats;
+};
+
+/**
+ * @brief The MemoryPool holds the memory allocators. CPU memory is split into
+ * one arena per NUMA node and allocated from the arena local to the calling
+ * thread.
+ *
+ */
 class MemoryPool {
  public:
-  MemoryPool();
+  /**
+   * @brief Construct a new MemoryPool object
+   *
+   * @param options options for the CPU arenas. If a NUMA node is set, a single
+   * arena bound to that node is used.
+   */
+  explicit MemoryPool(const CpuMemoryOptions& options = {});
+  MemoryPool(MemoryPool const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  MemoryPool& operator=(const MemoryPool&) = delete;
+  MemoryPool(MemoryPool&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  MemoryPool& operator=(MemoryPool&& other) = delete;
+  ~MemoryPool();  ///< Destructor
 
   std::unique_ptr<Buffer> get(const std::vector<MemoryAllocators>& allocators,
                               const Tensor& tensor, size_t batch_size) const;
+  /// Get memory from one allocator without building a list of allocators
+  std::unique_ptr<Buffer> get(MemoryAllocators allocator, const Tensor& tensor,
+                              size_t batch_size) const;
   void put(MemoryAllocators allocator, void* memory) const;
+  /**
+   * @brief Reserve memory in the first allocator that can provide it so later
+   * allocations of the same size don't need to allocate from the system
+   *
+   * @param reservation the memory to reserve
+   */
+  void reserve(const MemoryReservation& reservation) const;
+  /**
+   * @brief Borrow CPU memory owned outside the pool so it can be passed along
+   * where pooled CPU memory is expected without copying it. Putting it back
+   * to the pool ends the loan instead of freeing it. The owner must keep the
+   * memory alive until then.
+   *
+   * @param memory the memory to borrow
+   */
+  void borrow(const void* memory) const;
+  /**
+   * @brief Add slabs of fixed-size slots of CPU memory for sizes that are
+   * allocated often, such as an endpoint's tensors. CPU memory of these sizes
+   * comes from the slabs while they have free slots and from the arenas
+   * otherwise. The slabs stop handing out memory once the returned handle is
+   * dropped and they're freed once their slots are all put back.
+   *
+   * @param sizes sizes of the slots in bytes
+   * @param count number of slots of each size
+   * @return std::shared_ptr<void> the handle
+   */
+  [[nodiscard]] std::shared_ptr<void> addSlabs(std::vector<size_t> sizes,
+                                               size_t count) const;
+  /**
+   * @brief Get a snapshot of each of the pool's allocators. With the blocks,
+   * it shows how the memory is split up, which helps to size the blocks and
+   * the limits of the allocators.
+   *
+   * @param with_blocks if true, also list the blocks and their free chunks
+   * @return std::vector<MemoryPoolStats>
+   */
+  [[nodiscard]] std::vector<MemoryPoolStats> getStats(
+    bool with_blocks = false) const;
 
  private:
+  /// Get the CPU arena local to the calling thread
+  CpuAllocator* getCpuArena() const;
+  /// Put memory back to the slabs, returning false if it's not from them
+  bool putSlot(void* memory) const;
+  /// Stop the slabs with a handle from handing out memory
+  void closeSlabs(const void* handle) const;
+  /// Free the closed slabs whose slots are all put back
+  void retireSlabs() const;
+
+  // CPU arenas by NUMA node
+  std::map<int, std::unique_ptr<CpuAllocator>> cpu_arenas_;
   std::unordered_map<MemoryAllocators, std::unique_ptr<MemoryAllocator>>
     allocators_;
+
+  // CPU memory borrowed from outside the pool. The count lets put() skip the
+  // lock when nothing is borrowed
+  mutable std::mutex borrowed_mutex_;
+  mutable std::unordered_multiset<const void*> borrowed_;
+  mutable std::atomic<size_t> borrowed_count_{0};
+
+  struct Slabs {
+    std::unique_ptr<SlabAllocator> allocator;
+    bool open;
+  };
+  // slabs added for sizes that are allocated often. The count lets get() and
+  // put() skip the lock when there are none
+  mutable std::shared_mutex slabs_mutex_;
+  mutable std::vector<Slabs> slabs_;
+  mutable std::atomic<size_t> slab_count_{0};
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,187 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the allocator of fixed-size slots of CPU memory for sizes
+ * that are known up front
+ */
+
+#include "amdinfer/core/memory_pool/slab_allocator.hpp"
+
+#include <sys/mman.h>  // for mmap, munmap
+#include <unistd.h>    // for sysconf
+
+#include <algorithm>  // for sort, unique, max
+#include <cstring>    // for memset
+#include <limits>     // for numeric_limits
+
+#include "amdinfer/buffers/cpu.hpp"      // for CpuBuffer
+#include "amdinfer/core/exceptions.hpp"  // for runtime_error
+#include "amdinfer/core/tensor.hpp"      // for Tensor
+#include "amdinfer/util/numa.hpp"        // for bindMemoryToNumaNode
+
+namespace amdinfer {
+
+namespace {
+
+/// Slots start on cache lines so neighbouring slots don't share one
+constexpr size_t kSlotAlignment = 64;
+/// Marks the end of a list of free slots
+constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+constexpr auto kTagShift = 32U;
+
+/// Make a new head for a list of free slots from the old one
+uint64_t makeHead(uint64_t old, uint32_t index) {
+  return (((old >> kTagShift) + 1) << kTagShift) | index;
+}
+
+}  // namespace
+
+SlabAllocator::SlabAllocator(std::vector<size_t> sizes, size_t count,
+                             int numa_node)
+  : count_(count) {
+  if (count >= kEmpty) {
+    throw invalid_argument("Too many slots requested");
+  }
+  std::sort(sizes.begin(), sizes.end());
+  sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+  sizes.erase(std::remove(sizes.begin(), sizes.end(), 0), sizes.end());
+
+  size_t total = 0;
+  for (const auto& size : sizes) {
+    auto& slab = slabs_.emplace_back(std::make_unique<Slab>());
+    slab->size = size;
+    slab->stride =
+      (size + kSlotAlignment - 1) / kSlotAlignment * kSlotAlignment;
+    total += slab->stride * count;
+  }
+  if (total == 0) {
+    return;
+  }
+
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  mapped_size_ = (total + page_size - 1) / page_size * page_size;
+  void* address = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (address == MAP_FAILED) {
+    throw runtime_error("Memory could not be mapped");
+  }
+  data_ = static_cast<std::byte*>(address);
+  util::bindMemoryToNumaNode(data_, mapped_size_, numa_node);
+  // touch the pages so the first requests don't fault them in
+  std::memset(data_, 0, total);
+
+  auto* data = data_;
+  for (auto& slab : slabs_) {
+    slab->data = data;
+    data += slab->stride * count;
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    slab->next = std::make_unique<std::atomic<uint32_t>[]>(count);
+    for (auto i = 0U; i < count; ++i) {
+      slab->next[i].store(i + 1 < count ? i + 1 : kEmpty,
+                          std::memory_order_relaxed);
+    }
+    slab->head.store(count > 0 ? 0 : kEmpty, std::memory_order_release);
+  }
+}
+
+SlabAllocator::~SlabAllocator() {
+  if (data_ != nullptr) {
+    munmap(data_, mapped_size_);
+  }
+}
+
+BufferPtr SlabAllocator::get(const Tensor& tensor, size_t batch_size) {
+  const auto size = tensor.getSize() * tensor.getDatatype().size() * batch_size;
+  auto* slot = this->take(size);
+  if (slot == nullptr) {
+    throw runtime_error("No free slot of this size");
+  }
+  return std::make_unique<CpuBuffer>(slot, MemoryAllocators::Cpu);
+}
+
+std::byte* SlabAllocator::take(size_t size) {
+  for (const auto& slab : slabs_) {
+    if (slab->size != size) {
+      continue;
+    }
+    auto head = slab->head.load(std::memory_order_acquire);
+    while (true) {
+      const auto index = static_cast<uint32_t>(head);
+      if (index == kEmpty) {
+        failures_++;
+        return nullptr;
+      }
+      const auto next = slab->next[index].load(std::memory_order_relaxed);
+      if (slab->head.compare_exchange_weak(head, makeHead(head, next),
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+        used_slots_.fetch_add(1, std::memory_order_relaxed);
+        used_bytes_.fetch_add(size, std::memory_order_relaxed);
+        return slab->data + (index * slab->stride);
+      }
+    }
+  }
+  return nullptr;
+}
+
+void SlabAllocator::put(const void* address) {
+  const auto* slot = static_cast<const std::byte*>(address);
+  for (const auto& slab : slabs_) {
+    if (slot < slab->data || slot >= slab->data + (slab->stride * count_)) {
+      continue;
+    }
+    const auto index = static_cast<uint32_t>(
+      static_cast<size_t>(slot - slab->data) / slab->stride);
+    auto head = slab->head.load(std::memory_order_relaxed);
+    do {
+      slab->next[index].store(static_cast<uint32_t>(head),
+                              std::memory_order_relaxed);
+    } while (!slab->head.compare_exchange_weak(head, makeHead(head, index),
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+    used_slots_.fetch_sub(1, std::memory_order_release);
+    used_bytes_.fetch_sub(slab->size, std::memory_order_relaxed);
+    return;
+  }
+  throw runtime_error("Address not found");
+}
+
+MemoryStats SlabAllocator::getStats([[maybe_unused]] bool with_blocks) {
+  MemoryStats stats;
+  stats.reserved = mapped_size_;
+  stats.used = used_bytes_.load(std::memory_order_relaxed);
+  stats.free_chunks =
+    slabs_.size() * count_ - used_slots_.load(std::memory_order_relaxed);
+  for (const auto& slab : slabs_) {
+    if (static_cast<uint32_t>(slab->head.load(std::memory_order_relaxed)) !=
+        kEmpty) {
+      stats.largest_free = std::max(stats.largest_free, slab->size);
+    }
+  }
+  stats.failures = failures_.load();
+  return stats;
+}
+
+bool SlabAllocator::contains(const void* address) const {
+  const auto* slot = static_cast<const std::byte*>(address);
+  return data_ != nullptr && slot >= data_ && slot < data_ + mapped_size_;
+}
+
+bool SlabAllocator::inUse() const {
+  return used_slots_.load(std::memory_order_acquire) > 0;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,106 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the allocator of fixed-size slots of CPU memory for sizes
+ * that are known up front
+ */
+
+#ifndef GUARD_AMDINFER_CORE_MEMORY_POOL_SLAB_ALLOCATOR
+#define GUARD_AMDINFER_CORE_MEMORY_POOL_SLAB_ALLOCATOR
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "amdinfer/core/memory_pool/memory_allocator.hpp"
+
+namespace amdinfer {
+
+/**
+ * @brief The SlabAllocator hands out fixed-size slots of CPU memory for a set
+ * of sizes known up front, such as an endpoint's tensors at its batch sizes.
+ * Each size has a slab of slots with a lock-free list of the free ones so get
+ * and put run in constant time without locks or rounding sizes up. It only
+ * has the sizes it was made with so callers fall back to another allocator
+ * for other sizes or when all the slots of a size are in use.
+ */
+class SlabAllocator : public MemoryAllocator {
+ public:
+  /**
+   * @brief Construct a new SlabAllocator object. Its memory is mapped at once
+   *
+   * @param sizes sizes of the slots in bytes. Repeated and zero sizes are
+   * skipped
+   * @param count number of slots of each size
+   * @param numa_node NUMA node to bind the memory to. If negative, the memory
+   * is not bound
+   */
+  SlabAllocator(std::vector<size_t> sizes, size_t count, int numa_node = -1);
+  ~SlabAllocator() override;
+  SlabAllocator(SlabAllocator const&) = delete;
+  SlabAllocator& operator=(const SlabAllocator&) = delete;
+  SlabAllocator(SlabAllocator&& other) = delete;
+  SlabAllocator& operator=(SlabAllocator&& other) = delete;
+
+  /// Get a slot, throwing runtime_error if there's no free slot of this size
+  [[nodiscard]] BufferPtr get(const Tensor& tensor, size_t batch_size) override;
+  void put(const void* address) override;
+  /// The slots aren't listed as free chunks of the blocks
+  [[nodiscard]] MemoryStats getStats(bool with_blocks) override;
+
+  /**
+   * @brief Take a free slot of a size
+   *
+   * @param size the size in bytes
+   * @return std::byte* the slot or nullptr if there's no free slot of the size
+   */
+  [[nodiscard]] std::byte* take(size_t size);
+  /// Check if an address is one of the allocator's slots
+  [[nodiscard]] bool contains(const void* address) const;
+  /// Check if any slot is in use
+  [[nodiscard]] bool inUse() const;
+
+ private:
+  /// The slots of one size
+  struct Slab {
+    size_t size;
+    /// distance between slots, which keeps them aligned
+    size_t stride;
+    std::byte* data;
+    /// index of the free slot after each free slot
+    std::unique_ptr<std::atomic<uint32_t>[]> next;
+    /**
+     * @brief Index of the first free slot in the low half and a tag in the
+     * high half that changes with each update so a slot that's taken and put
+     * back between a thread's read and its update doesn't look unchanged
+     */
+    std::atomic<uint64_t> head;
+  };
+
+  std::byte* data_ = nullptr;
+  size_t mapped_size_ = 0;
+  size_t count_;
+  std::vector<std::unique_ptr<Slab>> slabs_;
+  std::atomic<size_t> used_slots_ = 0;
+  std::atomic<size_t> used_bytes_ = 0;
+  std::atomic<size_t> failures_ = 0;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_MEMORY_POOL_SLAB_ALLOCATOR
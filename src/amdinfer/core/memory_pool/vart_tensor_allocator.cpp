@@ -19,8 +19,9 @@
 
 #include "amdinfer/core/memory_pool/vart_tensor_allocator.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <iostream>
+#include <iterator>
 #include <vector>
 #include <xir/util/data_type.hpp>  // for DataType
 
@@ -31,33 +32,49 @@
 
 namespace amdinfer {
 
-VartTensorAllocator::VartTensorAllocator(size_t max_allocate)
-  : max_allocate_(max_allocate) {}
+VartTensorAllocator::VartTensorAllocator(size_t max_allocate, size_t max_free)
+  : max_allocate_(max_allocate), max_free_(max_free) {}
+
+void VartTensorAllocator::evict(size_t size) {
+  auto it = free_.begin();
+  while (allocated_ + size > max_allocate_ && it != free_.end()) {
+    auto& entries = it->second;
+    while (allocated_ + size > max_allocate_ && !entries.empty()) {
+      allocated_ -= entries.back()->size;
+      entries_.erase(entries.back());
+      entries.pop_back();
+    }
+    it = entries.empty() ? free_.erase(it) : std::next(it);
+  }
+}
 
 BufferPtr VartTensorAllocator::get(const Tensor& tensor, size_t batch_size) {
   const auto& name = tensor.getName();
   const auto& shape = tensor.getShape();
   const auto datatype = tensor.getDatatype();
+  VartTensorKey key{name, shape, datatype, batch_size};
 
   const std::lock_guard lock{mutex_};
-  auto found = headers_.end();
-  const auto end = headers_.end();
-  for (auto it = headers_.begin(); it != end; it++) {
-    if (it->free && it->name == name && it->shape == shape &&
-        it->datatype == datatype && it->batch_size == batch_size) {
-      found = it;
-      break;
+  if (auto found = free_.find(key); found != free_.end()) {
+    auto& entries = found->second;
+    auto entry = entries.back();
+    entries.pop_back();
+    if (entries.empty()) {
+      free_.erase(found);
     }
-  }
-
-  if (found != end) {
-    found->free = false;
-    return std::make_unique<VartTensorBuffer>(found->address,
+    auto* address = reinterpret_cast<std::byte*>(&(entry->buffer));
+    used_.try_emplace(address, entry);
+    return std::make_unique<VartTensorBuffer>(address,
                                               MemoryAllocators::VartTensor);
   }
 
   auto size_to_allocate = tensor.getSize() * datatype.size() * batch_size;
   if (allocated_ + size_to_allocate > max_allocate_) {
+    // free buffers for other tensors may be taking up the space
+    evict(size_to_allocate);
+  }
+  if (allocated_ + size_to_allocate > max_allocate_) {
+    failures_++;
     throw runtime_error("Too much requested");
   }
 
@@ -68,31 +85,63 @@ BufferPtr VartTensorAllocator::get(const Tensor& tensor, size_t batch_size) {
   for (const auto& index : shape) {
     xir_shape.push_back(static_cast<int>(index));
   }
-  tensors_.emplace_back(xir::Tensor::create(name, xir_shape, xir_type));
-  buffers_.emplace_back(tensors_.back().get());
-
+  entries_.emplace_back(xir::Tensor::create(name, xir_shape, xir_type),
+                        std::move(key), size_to_allocate);
   allocated_ += size_to_allocate;
 
-  auto* retval = reinterpret_cast<std::byte*>(&(buffers_.back()));
-
-  headers_.emplace_back(retval, false, name, shape, datatype, batch_size);
-
-  return std::make_unique<VartTensorBuffer>(retval,
+  auto* address = reinterpret_cast<std::byte*>(&(entries_.back().buffer));
+  used_.try_emplace(address, std::prev(entries_.end()));
+  return std::make_unique<VartTensorBuffer>(address,
                                             MemoryAllocators::VartTensor);
 }
 
 void VartTensorAllocator::put(const void* address) {
   const std::lock_guard lock{mutex_};
-  const auto end = headers_.end();
-  for (auto it = headers_.begin(); it != end; it++) {
-    if (it->address == address) {
-      it->free = true;
-      // std::cout << "Freed memory\n";
+  auto found = used_.find(address);
+  if (found == used_.end()) {
+    throw runtime_error("Address not found");
+  }
+  auto entry = found->second;
+  used_.erase(found);
+
+  if (max_free_ > 0) {
+    if (auto& entries = free_[entry->key]; entries.size() < max_free_) {
+      entries.push_back(entry);
       return;
     }
   }
+  // the free list is full so this buffer isn't kept
+  allocated_ -= entry->size;
+  entries_.erase(entry);
+}
 
-  throw runtime_error("Address not found");
+MemoryStats VartTensorAllocator::getStats(bool with_blocks) {
+  MemoryStats stats;
+  const std::lock_guard lock{mutex_};
+  stats.reserved = allocated_;
+  stats.failures = failures_;
+
+  // each buffer is its own block and free buffers are free in whole
+  for (const auto& [key, entries] : free_) {
+    for (const auto& entry : entries) {
+      stats.free_chunks++;
+      stats.largest_free = std::max(stats.largest_free, entry->size);
+    }
+  }
+  for (const auto& [address, entry] : used_) {
+    stats.used += entry->size;
+  }
+  if (with_blocks) {
+    for (const auto& entry : entries_) {
+      const auto* address = &(entry.buffer);
+      MemoryBlock block{reinterpret_cast<uintptr_t>(address), entry.size};
+      if (used_.find(address) == used_.end()) {
+        block.free.push_back({0, entry.size});
+      }
+      stats.blocks.push_back(std::move(block));
+    }
+  }
+  return stats;
 }
 
 }  // namespace amdinfer
@@ -26,7 +26,12 @@
 
 #include <cstddef>
 #include <list>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vart/experimental/runner_helper.hpp>  // for CpuFlatTensorBufferOwned
 #include <vector>
 #include <xir/tensor/tensor.hpp>  // for Tensor
@@ -36,43 +41,63 @@
 
 namespace amdinfer {
 
-struct VartTensorHeader {
-  std::byte* address;
-  bool free;
-
-  std::string name;
-  std::vector<int64_t> shape;
-  DataType datatype;
-  size_t batch_size;
-
-  VartTensorHeader(std::byte* address, bool free, const std::string& name,
-                   const std::vector<int64_t>& shape, DataType datatype,
-                   size_t batch_size)
-    : address(address),
-      free(free),
-      name(name),
-      shape(shape),
-      datatype(datatype),
-      batch_size(batch_size) {}
+/// Tensor buffers can only be reused for tensors with the same key
+using VartTensorKey =
+  std::tuple<std::string, std::vector<int64_t>, DataType, size_t>;
+
+/// A tensor buffer and the tensor that describes it
+struct VartTensorEntry {
+  VartTensorEntry(std::unique_ptr<xir::Tensor> tensor, VartTensorKey key,
+                  size_t size)
+    : tensor(std::move(tensor)),
+      buffer(this->tensor.get()),
+      key(std::move(key)),
+      size(size) {}
+
+  std::unique_ptr<xir::Tensor> tensor;
+  vart::CpuFlatTensorBufferOwned buffer;
+  VartTensorKey key;
+  size_t size;
 };
 
+/**
+ * @brief The VartTensorAllocator provides VART tensor buffers. Freed buffers
+ * are kept in free lists by tensor so they can be reused without creating new
+ * buffers. The free lists are bounded and buffers beyond the bound are
+ * destroyed.
+ *
+ */
 class VartTensorAllocator : public MemoryAllocator {
  public:
-  explicit VartTensorAllocator(size_t max_allocated = -1);
+  /**
+   * @brief Construct a new VartTensorAllocator object
+   *
+   * @param max_allocated maximum number of bytes to allocate
+   * @param max_free maximum number of free buffers to keep for each tensor
+   */
+  explicit VartTensorAllocator(size_t max_allocated = -1,
+                               size_t max_free = kDefaultMaxFree);
 
   [[nodiscard]] BufferPtr get(const Tensor& tensor, size_t batch_size) override;
   void put(const void* address) override;
-
-  // void free(const void* address);
+  [[nodiscard]] MemoryStats getStats(bool with_blocks) override;
 
  private:
+  using Entry = std::list<VartTensorEntry>::iterator;
+  static constexpr size_t kDefaultMaxFree = 16;
+
+  /// Destroy free buffers until the new allocation fits. The mutex must be held
+  void evict(size_t size);
+
   size_t allocated_ = 0;
+  size_t failures_ = 0;
   size_t max_allocate_;
+  size_t max_free_;
   std::mutex mutex_;
 
-  std::list<VartTensorHeader> headers_;
-  std::list<std::unique_ptr<xir::Tensor>> tensors_;
-  std::list<vart::CpuFlatTensorBufferOwned> buffers_;
+  std::list<VartTensorEntry> entries_;
+  std::map<VartTensorKey, std::vector<Entry>> free_;
+  std::unordered_map<const void*, Entry> used_;
 };
 
 }  // namespace amdinfer
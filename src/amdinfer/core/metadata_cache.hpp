@@ -0,0 +1,91 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a cache for values derived from published model metadata
+ */
+
+#ifndef GUARD_AMDINFER_CORE_METADATA_CACHE
+#define GUARD_AMDINFER_CORE_METADATA_CACHE
+
+#include <memory>         // for shared_ptr, weak_ptr
+#include <mutex>          // for unique_lock
+#include <shared_mutex>   // for shared_mutex, shared_lock
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+
+#include "amdinfer/core/model_metadata.hpp"  // for ModelMetadata
+
+namespace amdinfer {
+
+/**
+ * @brief Caches a value made from the metadata of each endpoint, such as the
+ * serialized response to a metadata request. The endpoints publish new
+ * metadata objects only when workers are loaded or unloaded so a value is
+ * made once per published metadata and reused until the metadata changes.
+ *
+ * @tparam T type of the cached value
+ */
+template <typename T>
+class MetadataCache {
+ public:
+  /**
+   * @brief Get the cached value for an endpoint's metadata, making it first
+   * if it's not cached or was made from older metadata
+   *
+   * @param endpoint the endpoint the metadata is for
+   * @param metadata the endpoint's current metadata
+   * @param make called with the metadata to make the value if needed
+   * @return std::shared_ptr<const T>
+   */
+  template <typename F>
+  std::shared_ptr<const T> get(
+    const std::string& endpoint,
+    const std::shared_ptr<const ModelMetadata>& metadata, F&& make) {
+    {
+      const std::shared_lock lock{mutex_};
+      if (auto found = items_.find(endpoint);
+          found != items_.end() && sameOwner(found->second.source, metadata)) {
+        return found->second.value;
+      }
+    }
+
+    auto value = std::make_shared<const T>(make(*metadata));
+    const std::unique_lock lock{mutex_};
+    items_.insert_or_assign(endpoint, Item{metadata, value});
+    return value;
+  }
+
+ private:
+  struct Item {
+    std::weak_ptr<const ModelMetadata> source;
+    std::shared_ptr<const T> value;
+  };
+
+  // the weak pointer keeps the control block alive so its address can't be
+  // reused by newer metadata, even after the old metadata is freed
+  static bool sameOwner(const std::weak_ptr<const ModelMetadata>& a,
+                        const std::shared_ptr<const ModelMetadata>& b) {
+    return !a.owner_before(b) && !b.owner_before(a);
+  }
+
+  std::shared_mutex mutex_;
+  std::unordered_map<std::string, Item> items_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_METADATA_CACHE
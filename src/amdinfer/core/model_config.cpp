@@ -21,7 +21,14 @@
 
 #include <toml++/toml.h>
 
+#include <algorithm>  // for find, find_if
+#include <array>      // for array
+#include <cstdint>    // for int32_t, int64_t
 #include <filesystem>
+#include <limits>  // for numeric_limits
+#include <string>       // for string, to_string
+#include <string_view>  // for string_view
+#include <unordered_map>
 
 #include "amdinfer/core/exceptions.hpp"
 #include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
@@ -50,6 +57,257 @@ std::string extractString(const toml::table& table, const std::string& key,
 ModelConfigTensor extractModelConfigTensor(const toml::table& table);
 ModelConfigData extractConfig(const toml::table& table, bool is_ensemble);
 
+namespace {
+
+enum class SettingType {
+  Integer,
+  /// A list of integers, or a string of them like "0-3,8", that is passed
+  /// to the workers as a string
+  List,
+};
+
+/// A setting in a section of the configuration and the parameter it sets
+struct Setting {
+  const char* section;
+  const char* key;
+  const char* parameter;
+  SettingType type;
+};
+
+// The settings that every backend applies the same way. Their parameters are
+// read by the server, the batchers and the Worker base class rather than by
+// the backends themselves
+const std::array kSettings{
+  Setting{"instance_group", "count", "min_workers", SettingType::Integer},
+  Setting{"instance_group", "max_count", "max_workers", SettingType::Integer},
+  Setting{"instance_group", "devices", "devices", SettingType::List},
+  Setting{"instance_group", "cpus", "cpus", SettingType::List},
+  Setting{"instance_group", "numa_node", "numa_node", SettingType::Integer},
+  Setting{"dynamic_batching", "max_batch_size", "batch_size",
+          SettingType::Integer},
+  Setting{"dynamic_batching", "preferred_batch_sizes", "preferred_batch_sizes",
+          SettingType::List},
+  Setting{"dynamic_batching", "max_queue_delay_ms", "timeout",
+          SettingType::Integer},
+  Setting{"dynamic_batching", "priority_levels", "priority_levels",
+          SettingType::Integer},
+  Setting{"dynamic_batching", "default_priority", "default_priority",
+          SettingType::Integer},
+  Setting{"memory", "reserve_batches", "reserve_batches",
+          SettingType::Integer},
+  Setting{"memory", "memory_mib", "memory_mib", SettingType::Integer},
+  Setting{"memory", "slab_slots", "slab_slots", SettingType::Integer},
+};
+
+int32_t toInt32(int64_t value, const std::string& key) {
+  if (value < std::numeric_limits<int32_t>::min() ||
+      value > std::numeric_limits<int32_t>::max()) {
+    throw invalid_argument(key + " is out of range");
+  }
+  return static_cast<int32_t>(value);
+}
+
+template <typename Container>
+std::string joinList(const Container& values) {
+  std::string list;
+  for (const auto& value : values) {
+    if (!list.empty()) {
+      list += ",";
+    }
+    list += std::to_string(value);
+  }
+  return list;
+}
+
+/// Add the free-form parameters of the configuration
+void extractFreeParameters(const toml::table& table, ParameterMap* parameters) {
+  const auto* node = table.get("parameters");
+  if (node == nullptr) {
+    return;
+  }
+  const auto* free_parameters = node->as_table();
+  if (free_parameters == nullptr) {
+    throw invalid_argument("parameters must be a table");
+  }
+  for (const auto& [toml_key, value] : *free_parameters) {
+    const std::string key{toml_key.str()};
+    if (value.is_boolean()) {
+      parameters->put(key, value.value<bool>().value());
+    } else if (value.is_integer()) {
+      parameters->put(key, toInt32(value.value<int64_t>().value(), key));
+    } else if (value.is_floating_point()) {
+      parameters->put(key, value.value<double>().value());
+    } else if (value.is_string()) {
+      parameters->put(key, value.value<std::string>().value());
+    } else {
+      throw invalid_argument("The parameter " + key +
+                             " must be a boolean, integer, float or string");
+    }
+  }
+}
+
+/// Add the parameters set by the sections of the configuration
+void extractSections(const toml::table& table, ParameterMap* parameters) {
+  for (const auto* section_name :
+       {"instance_group", "dynamic_batching", "memory"}) {
+    const auto* node = table.get(section_name);
+    if (node == nullptr) {
+      continue;
+    }
+    const auto* section = node->as_table();
+    if (section == nullptr) {
+      throw invalid_argument(std::string{section_name} + " must be a table");
+    }
+
+    for (const auto& [toml_key, value] : *section) {
+      const std::string key{toml_key.str()};
+      const auto setting = std::find_if(
+        kSettings.begin(), kSettings.end(), [&](const Setting& setting) {
+          return setting.section == std::string_view{section_name} &&
+                 setting.key == key;
+        });
+      if (setting == kSettings.end()) {
+        throw invalid_argument("Unknown setting " + key + " in " +
+                               section_name);
+      }
+
+      const auto name = std::string{section_name} + "." + key;
+      if (setting->type == SettingType::Integer) {
+        if (!value.is_integer()) {
+          throw invalid_argument(name + " must be an integer");
+        }
+        parameters->put(setting->parameter,
+                        toInt32(value.value<int64_t>().value(), name));
+      } else if (value.is_string()) {
+        parameters->put(setting->parameter,
+                        value.value<std::string>().value());
+      } else if (value.is_array() && value.is_homogeneous<int64_t>()) {
+        std::vector<int64_t> list;
+        for (const auto& element : *value.as_array()) {
+          list.push_back(element.value<int64_t>().value());
+        }
+        parameters->put(setting->parameter, joinList(list));
+      } else {
+        throw invalid_argument(name + " must be a list of integers");
+      }
+    }
+  }
+}
+
+/// Add the parameters set by the sections of a protobuf configuration
+void extractSections(const inference::Config& config,
+                     ParameterMap* parameters) {
+  if (config.has_instance_group()) {
+    const auto& group = config.instance_group();
+    if (group.has_count()) {
+      parameters->put("min_workers", group.count());
+    }
+    if (group.has_max_count()) {
+      parameters->put("max_workers", group.max_count());
+    }
+    if (!group.devices().empty()) {
+      parameters->put("devices", joinList(group.devices()));
+    }
+    if (group.has_cpus()) {
+      parameters->put("cpus", group.cpus());
+    }
+    if (group.has_numa_node()) {
+      parameters->put("numa_node", group.numa_node());
+    }
+  }
+  if (config.has_dynamic_batching()) {
+    const auto& batching = config.dynamic_batching();
+    if (batching.has_max_batch_size()) {
+      parameters->put("batch_size", batching.max_batch_size());
+    }
+    if (!batching.preferred_batch_sizes().empty()) {
+      parameters->put("preferred_batch_sizes",
+                      joinList(batching.preferred_batch_sizes()));
+    }
+    if (batching.has_max_queue_delay_ms()) {
+      parameters->put("timeout", batching.max_queue_delay_ms());
+    }
+    if (batching.has_priority_levels()) {
+      parameters->put("priority_levels", batching.priority_levels());
+    }
+    if (batching.has_default_priority()) {
+      parameters->put("default_priority", batching.default_priority());
+    }
+  }
+  if (config.has_memory()) {
+    const auto& memory = config.memory();
+    if (memory.has_reserve_batches()) {
+      parameters->put("reserve_batches", memory.reserve_batches());
+    }
+    if (memory.has_memory_mib()) {
+      parameters->put("memory_mib", memory.memory_mib());
+    }
+    if (memory.has_slab_slots()) {
+      parameters->put("slab_slots", memory.slab_slots());
+    }
+  }
+}
+
+/**
+ * @brief Translate the generic parameters to the names a worker uses. The
+ * MIGraphX worker calls its batch size "batch" and compiles a program for
+ * each batch size it can run so the preferred batch sizes are compiled too
+ *
+ * @param parameters the model's parameters
+ */
+void adaptToWorker(ParameterMap* parameters) {
+  if (!parameters->has("worker") ||
+      parameters->get<std::string>("worker") != "migraphx") {
+    return;
+  }
+  if (parameters->has("batch_size") && !parameters->has("batch")) {
+    parameters->put("batch", parameters->get<int32_t>("batch_size"));
+    parameters->erase("batch_size");
+  }
+  if (parameters->has("preferred_batch_sizes") &&
+      parameters->has("batch") && !parameters->has("batch_sizes")) {
+    parameters->put(
+      "batch_sizes", parameters->get<std::string>("preferred_batch_sizes") +
+                       "," + std::to_string(parameters->get<int32_t>("batch")));
+  }
+}
+
+}  // namespace
+
+// TODO(varunsh): get rid of this duplicate code with the one in grpc_internal
+void mapProtoToParameters2(
+  const google::protobuf::Map<std::string, inference::InferParameter2>& params,
+  ParameterMap* parameters) {
+  using ParameterType = inference::InferParameter2::ParameterChoiceCase;
+  for (const auto& [key, value] : params) {
+    auto type = value.parameter_choice_case();
+    switch (type) {
+      case ParameterType::kBoolParam: {
+        parameters->put(key, value.bool_param());
+        break;
+      }
+      case ParameterType::kInt64Param: {
+        // TODO(varunsh): parameters should switch to uint64?
+        parameters->put(key, static_cast<int>(value.int64_param()));
+        break;
+      }
+      case ParameterType::kDoubleParam: {
+        parameters->put(key, value.double_param());
+        break;
+      }
+      case ParameterType::kStringParam: {
+        parameters->put(key, value.string_param());
+        break;
+      }
+      default: {
+        // if not set
+        break;
+      }
+    }
+  }
+}
+
+
 // if we're not explicitly handling the types, use this to catch the failure at
 // compile time
 template <class...>
@@ -121,7 +379,12 @@ ModelConfigData extractConfig(const toml::table& table, bool is_ensemble) {
   auto inputs = extractArray<ModelConfigTensor>(table, "inputs");
   auto outputs = extractArray<ModelConfigTensor>(table, "outputs");
 
-  return {name, platform, id, inputs, outputs};
+  // the sections take precedence over the free-form parameters
+  ParameterMap parameters;
+  extractFreeParameters(table, &parameters);
+  extractSections(table, &parameters);
+
+  return {name, platform, id, inputs, outputs, parameters};
 }
 
 ModelConfigTensor::ModelConfigTensor(std::string name,
@@ -133,7 +396,80 @@ const std::string& ModelConfigTensor::id() const& { return id_; }
 
 std::string ModelConfigTensor::id() && { return std::move(id_); }
 
+void ModelConfig::createGraph() {
+  parents_.assign(configs_.size(), {});
+  if (configs_.size() <= 1) {
+    return;
+  }
+
+  // output ID -> the model that produces it
+  std::unordered_map<std::string, size_t> producers;
+  for (auto i = 0U; i < configs_.size(); ++i) {
+    for (const auto& output : configs_[i].outputs) {
+      const auto& id = output.id();
+      if (!id.empty() && !producers.try_emplace(id, i).second) {
+        throw invalid_argument("The output ID " + id +
+                               " is used by more than one model");
+      }
+    }
+  }
+
+  // inputs with IDs that no model produces come from the client
+  bool has_client_inputs = false;
+  for (auto i = 0U; i < configs_.size(); ++i) {
+    auto& parents = parents_[i];
+    for (const auto& input : configs_[i].inputs) {
+      const auto producer = producers.find(input.id());
+      if (producer == producers.end()) {
+        has_client_inputs |= i > 0;
+        continue;
+      }
+      if (producer->second == i) {
+        throw invalid_argument("Model " + configs_[i].name +
+                               " consumes its own output " + input.id());
+      }
+      if (std::find(parents.begin(), parents.end(), producer->second) ==
+          parents.end()) {
+        parents.push_back(producer->second);
+      }
+    }
+  }
+
+  // remove the models without parents until none are left to find cycles
+  std::vector<size_t> waiting(configs_.size());
+  std::vector<size_t> ready;
+  for (auto i = 0U; i < configs_.size(); ++i) {
+    waiting[i] = parents_[i].size();
+    if (waiting[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  size_t visited = 0;
+  while (!ready.empty()) {
+    const auto model = ready.back();
+    ready.pop_back();
+    visited++;
+    for (auto i = 0U; i < configs_.size(); ++i) {
+      const auto& parents = parents_[i];
+      if (std::find(parents.begin(), parents.end(), model) != parents.end() &&
+          --waiting[i] == 0) {
+        ready.push_back(i);
+      }
+    }
+  }
+  if (visited != configs_.size()) {
+    throw invalid_argument("The models of the ensemble form a cycle");
+  }
+
+  chain_ = !has_client_inputs && parents_.front().empty();
+  for (auto i = 1U; i < configs_.size() && chain_; ++i) {
+    chain_ = parents_[i].size() == 1 && parents_[i].front() == i - 1;
+  }
+}
+
 void ModelConfig::createModels() {
+  this->createGraph();
+
   for (const auto& config : configs_) {
     models_.emplace_back(config.name, ParameterMap{});
     auto& parameters = std::get<1>(models_.back());
@@ -174,9 +510,21 @@ void ModelConfig::createModels() {
     } else {
       throw invalid_argument("Unknown platform: " + config.platform);
     }
+
+    // the configuration's parameters can override the ones derived from its
+    // platform, such as to pick another worker
+    for (const auto& [key, value] : config.parameters) {
+      parameters.put(key, value);
+    }
+    adaptToWorker(&parameters);
   }
 
-  // assuming a static chain for now so define it in reverse order
+  // only chains are wired from worker to worker. Each model of a DAG responds
+  // to the Ensemble scheduling it
+  if (!chain_) {
+    return;
+  }
+  // define the chain in reverse order
   for (auto i = models_.size() - 1; i-- > 0;) {
     const auto& model = std::get<0>(models_.at(i + 1));
     auto& parameters = std::get<1>(models_.at(i));
@@ -238,8 +586,12 @@ ModelConfig::ModelConfig(const inference::Config& config,
     outputs.emplace_back(name, shape, datatype, id);
   }
 
+  ParameterMap parameters;
+  mapProtoToParameters2(config.parameters(), &parameters);
+  extractSections(config, &parameters);
+
   configs_.emplace_back(getVersionedEndpoint(model_name, version), platform, id,
-                        inputs, outputs);
+                        inputs, outputs, parameters);
 
   this->createModels();
 }
@@ -260,6 +612,16 @@ void ModelConfig::setModelFiles(const std::filesystem::path& base_path) {
 
 size_t ModelConfig::size() const { return configs_.size(); }
 
+const ModelConfigData& ModelConfig::getConfig(size_t index) const {
+  return configs_.at(index);
+}
+
+const std::vector<size_t>& ModelConfig::getParents(size_t index) const {
+  return parents_.at(index);
+}
+
+bool ModelConfig::isChain() const { return chain_; }
+
 std::pair<std::string, ParameterMap> ModelConfig::get(size_t index) {
   return models_.at(index);
 }
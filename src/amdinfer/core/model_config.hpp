@@ -55,18 +55,27 @@ class ModelConfigTensor : public Tensor {
 struct ModelConfigData {
   ModelConfigData(std::string name, std::string platform, std::string id,
                   std::vector<ModelConfigTensor> inputs,
-                  std::vector<ModelConfigTensor> outputs)
+                  std::vector<ModelConfigTensor> outputs,
+                  ParameterMap parameters = {})
     : name(std::move(name)),
       platform(std::move(platform)),
       id(std::move(id)),
       inputs(std::move(inputs)),
-      outputs(std::move(outputs)) {}
+      outputs(std::move(outputs)),
+      parameters(std::move(parameters)) {}
 
   std::string name;
   std::string platform;
   std::string id;
   std::vector<ModelConfigTensor> inputs;
   std::vector<ModelConfigTensor> outputs;
+  /**
+   * @brief The load-time parameters set by the configuration: its free-form
+   * parameters and its instance_group, dynamic_batching and memory sections,
+   * which are translated to the parameters that the server applies the same
+   * way for every backend
+   */
+  ParameterMap parameters;
 };
 
 class ModelConfig {
@@ -81,6 +90,25 @@ class ModelConfig {
   ModelConfig(const inference::Config& config, const std::string& version);
 
   std::pair<std::string, ParameterMap> get(size_t index);
+  /// Get the configuration of the model at the index
+  [[nodiscard]] const ModelConfigData& getConfig(size_t index) const;
+  /**
+   * @brief Get the models whose outputs feed the model at the index. These
+   * are found by matching the IDs of the model's inputs to the IDs of the
+   * other models' outputs
+   *
+   * @param index the index of the model
+   * @return const std::vector<size_t>& the indices of the models it depends on
+   */
+  [[nodiscard]] const std::vector<size_t>& getParents(size_t index) const;
+  /**
+   * @brief Check if the models form a chain, where each model only consumes
+   * the outputs of the one before it. Chains are wired directly from worker
+   * to worker. Other ensembles are scheduled as a DAG by an Ensemble
+   *
+   * @return bool
+   */
+  [[nodiscard]] bool isChain() const;
   void setModelFiles(const std::filesystem::path& base_path);
 
   size_t size() const;
@@ -114,8 +142,13 @@ class ModelConfig {
  private:
   std::vector<ModelConfigData> configs_;
   Container models_;
+  // model -> models whose outputs it consumes
+  std::vector<std::vector<size_t>> parents_;
+  bool chain_ = true;
 
   void createModels();
+  /// Connect the models' inputs to their outputs and check they form a DAG
+  void createGraph();
 };
 
 }  // namespace amdinfer
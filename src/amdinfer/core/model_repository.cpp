@@ -21,57 +21,146 @@
 #include <google/protobuf/text_format.h>               // for TextFormat
 #include <toml++/toml.h>
 
-#include <chrono>      // for milliseconds
-#include <filesystem>  // for path, operator/
-#include <thread>      // for sleep_for
-
-#include "amdinfer/core/endpoints.hpp"       // for Endpoints
-#include "amdinfer/core/exceptions.hpp"      // for runtime_error
-#include "amdinfer/core/model_config.hpp"    // for ModelConfig
-#include "amdinfer/core/parameters.hpp"      // for ParameterMap
-#include "amdinfer/observation/logging.hpp"  // for AMDINFER_LOG_D...
-#include "amdinfer/util/filesystem.hpp"      // for findFile
-#include "amdinfer/util/string.hpp"          // for endsWith
-#include "model_config.hpp"                  // for ModelConfig
-#include "model_config.pb.h"                 // for Config, InferP...
+#include <algorithm>     // for min, all_of, equal, find, max_...
+#include <cctype>        // for isdigit
+#include <chrono>        // for steady_clock, seconds
+#include <exception>     // for exception
+#include <filesystem>    // for path, operator/, weakly_canonical
+#include <future>        // for future
+#include <optional>      // for optional, nullopt
+#include <system_error>  // for error_code
+#include <thread>        // for thread
+#include <utility>       // for move
+#include <vector>        // for vector
+
+#include "amdinfer/build_options.hpp"            // for kMaxLoadThreads
+#include "amdinfer/core/endpoints.hpp"           // for Endpoints
+#include "amdinfer/core/exceptions.hpp"          // for runtime_error
+#include "amdinfer/core/model_config.hpp"        // for ModelConfig
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
+#include "amdinfer/observation/logging.hpp"      // for AMDINFER_LOG_D...
+#include "amdinfer/util/ctpl.hpp"                // for ThreadPool
+#include "amdinfer/util/filesystem.hpp"          // for findFile
+#include "amdinfer/util/string.hpp"              // for endsWith
+#include "amdinfer/util/thread.hpp"              // for setThreadName
+#include "model_config.hpp"                      // for ModelConfig
+#include "model_config.pb.h"                     // for Config, InferP...
 
 namespace fs = std::filesystem;
 
 namespace amdinfer {
 
-// TODO(varunsh): get rid of this duplicate code with the one in grpc_internal
-void mapProtoToParameters2(
-  const google::protobuf::Map<std::string, inference::InferParameter2>& params,
-  ParameterMap* parameters) {
-  using ParameterType = inference::InferParameter2::ParameterChoiceCase;
-  for (const auto& [key, value] : params) {
-    auto type = value.parameter_choice_case();
-    switch (type) {
-      case ParameterType::kBoolParam: {
-        parameters->put(key, value.bool_param());
-        break;
-      }
-      case ParameterType::kInt64Param: {
-        // TODO(varunsh): parameters should switch to uint64?
-        parameters->put(key, static_cast<int>(value.int64_param()));
-        break;
-      }
-      case ParameterType::kDoubleParam: {
-        parameters->put(key, value.double_param());
-        break;
+namespace {
+
+/// How long a model's directory must be quiet before its changes are applied
+constexpr auto kQuietPeriod = std::chrono::seconds(1);
+/// Writing this file in a model's directory applies its changes right away
+constexpr auto kReadyMarker = ".ready";
+/// The version that models loaded from the repository's directory use
+constexpr auto kLoadedVersion = "1";
+
+bool isConfigFile(const std::string& filename) {
+  return filename == "config.pbtxt" || util::endsWith(filename, "toml");
+}
+
+bool isVersion(const std::string& filename) {
+  return !filename.empty() &&
+         std::all_of(filename.begin(), filename.end(),
+                     [](char c) { return std::isdigit(c) != 0; });
+}
+
+/**
+ * @brief Get the components of a path relative to the repository, such as
+ * "model", "1" and "model.onnx". It's empty if the path isn't in a model's
+ * directory
+ */
+std::vector<std::string> getComponents(const fs::path& repository,
+                                       const fs::path& path) {
+  auto relative =
+    path.lexically_normal().lexically_relative(repository.lexically_normal());
+  if (relative.empty() || *relative.begin() == "..") {
+    // the watcher may report the paths in another form than the repository's
+    std::error_code error;
+    relative = fs::weakly_canonical(path, error)
+                 .lexically_relative(fs::weakly_canonical(repository, error));
+  }
+
+  std::vector<std::string> components;
+  for (const auto& component : relative) {
+    if (!component.empty() && component != ".") {
+      components.push_back(component.string());
+    }
+  }
+  if (!components.empty() && components.front() == "..") {
+    return {};
+  }
+  return components;
+}
+
+bool sameTensors(const std::vector<ModelConfigTensor>& lhs,
+                 const std::vector<ModelConfigTensor>& rhs) {
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                    [](const auto& left, const auto& right) {
+                      return left.id() == right.id() &&
+                             left.getName() == right.getName() &&
+                             left.getShape() == right.getShape() &&
+                             left.getDatatype() == right.getDatatype();
+                    });
+}
+
+/**
+ * @brief Get the parameters of each model that changed between two
+ * configurations if Endpoints::update can apply all of them.
+ *
+ * @param before the configuration that the models were loaded with
+ * @param after the new configuration
+ * @return std::optional<std::vector<ParameterMap>> the changed parameters of
+ * each model or nothing if the models must be reloaded
+ */
+std::optional<std::vector<ParameterMap>> diffConfigs(const ModelConfig& before,
+                                                     const ModelConfig& after) {
+  if (before.size() != after.size() || before.isChain() != after.isChain()) {
+    return std::nullopt;
+  }
+
+  std::vector<ParameterMap> updates(after.size());
+  for (auto i = 0U; i < after.size(); ++i) {
+    const auto& old_model = before.getConfig(i);
+    const auto& new_model = after.getConfig(i);
+    if (old_model.name != new_model.name ||
+        old_model.platform != new_model.platform ||
+        old_model.id != new_model.id ||
+        !sameTensors(old_model.inputs, new_model.inputs) ||
+        !sameTensors(old_model.outputs, new_model.outputs) ||
+        before.getParents(i) != after.getParents(i)) {
+      return std::nullopt;
+    }
+
+    const auto& old_parameters = (before.begin() + i)->second;
+    const auto& new_parameters = (after.begin() + i)->second;
+    for (const auto& [key, value] : old_parameters) {
+      if (!new_parameters.has(key)) {
+        return std::nullopt;
       }
-      case ParameterType::kStringParam: {
-        parameters->put(key, value.string_param());
-        break;
+    }
+    for (const auto& parameter : new_parameters) {
+      const auto found = std::find(old_parameters.begin(),
+                                   old_parameters.end(), parameter);
+      if (found != old_parameters.end()) {
+        continue;
       }
-      default: {
-        // if not set
-        break;
+      if (!Endpoints::isUpdatable(parameter.first)) {
+        return std::nullopt;
       }
+      updates[i].put(parameter.first, parameter.second);
     }
   }
+  return updates;
 }
 
+}  // namespace
+
 fs::path findConfigFile(const fs::path& model_path, const std::string& model) {
   std::array extensions{".toml", ".pbtxt"};
   for (const auto* extension : extensions) {
@@ -140,29 +229,109 @@ ModelConfig parseModel(const fs::path& repository, const std::string& model,
   return config;
 }
 
-void loadModel(const fs::path& repository, const fs::path& model_name,
+std::vector<std::string> loadModelConfig(const std::string& model,
+                                         const std::string& version,
+                                         const ModelConfig& config,
+                                         const ParameterMap& parameters,
+                                         Endpoints* endpoints) {
+  std::vector<std::string> loaded(config.size());
+  auto index = config.size();
+  for (auto it = config.crbegin(); it != config.crend(); ++it) {
+    const auto& [model_name, model_parameters] = *it;
+    // merge the runtime provided parameters with those from the model file
+    ParameterMap updated_parameters = model_parameters;
+    for (const auto& [key, value] : parameters) {
+      updated_parameters.put(key, value);
+    }
+    // the config will add the versioned model name already
+    loaded[--index] = endpoints->load(model_name, "", updated_parameters);
+  }
+
+  if (!config.isChain()) {
+    try {
+      endpoints->loadEnsemble(model, version, config, loaded);
+    } catch (...) {
+      for (const auto& endpoint : loaded) {
+        endpoints->unload(endpoint, "");
+      }
+      throw;
+    }
+  }
+  return loaded;
+}
+
+RepositoryModel loadModel(const fs::path& repository,
+                          const std::string& model_name, Endpoints* endpoints) {
+  auto config = std::make_shared<const ModelConfig>(
+    parseModel(repository, model_name, ""));
+  auto loaded =
+    loadModelConfig(model_name, "", *config, ParameterMap{}, endpoints);
+  return {std::move(config), std::move(loaded)};
+}
+
+void swapModel(const fs::path& repository, const std::string& model,
+               const std::string& version, const ParameterMap& parameters,
                Endpoints* endpoints) {
-  auto config = parseModel(repository, model_name, "");
-  for (const auto& [model, parameters] : config) {
-    endpoints->load(model, "", parameters);
+  if (version.empty()) {
+    throw invalid_argument("A model can only be swapped to a version");
+  }
+  auto config = parseModel(repository, model, version);
+  loadModelConfig(model, version, config, parameters, endpoints);
+
+  // requests to a chain go to its first model
+  const auto endpoint = config.isChain() ? config.get(0).first
+                                         : getVersionedEndpoint(model, version);
+  try {
+    endpoints->swap(model, endpoint);
+  } catch (...) {
+    endpoints->unload(model, version);
+    throw;
   }
 }
 
 void ModelRepository::setRepository(const fs::path& repository_path,
                                     bool load_existing) {
   repository_ = repository_path;
-  if (fs::exists(repository_path) && load_existing) {
-    AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
-    for (const auto& path : fs::directory_iterator(repository_)) {
-      if (path.is_directory()) {
-        auto model_name = path.path().filename();
+  if (!fs::exists(repository_path) || !load_existing) {
+    return;
+  }
+
+  std::vector<fs::path> models;
+  for (const auto& path : fs::directory_iterator(repository_)) {
+    if (path.is_directory()) {
+      models.push_back(path.path().filename());
+    }
+  }
+  if (models.empty()) {
+    return;
+  }
+
+  // the models don't depend on each other so they're loaded in parallel. Each
+  // model's own chain or ensemble is still loaded in order by loadModel
+  const auto threads =
+    std::min({models.size(), static_cast<size_t>(kMaxLoadThreads),
+              static_cast<size_t>(std::max(std::thread::hardware_concurrency(),
+                                           1U))});
+  util::ThreadPool pool{static_cast<int>(threads)};
+  std::vector<std::future<std::optional<RepositoryModel>>> loads;
+  loads.reserve(models.size());
+  for (const auto& model_name : models) {
+    loads.push_back(
+      pool.push([this, model_name](int) -> std::optional<RepositoryModel> {
+        AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
         try {
-          loadModel(repository_, model_name, endpoints_);
+          return loadModel(repository_, model_name.string(), endpoints_);
         } catch (const amdinfer::runtime_error& e) {
           AMDINFER_LOG_INFO(
             logger, "Error loading " + model_name.string() + ": " + e.what());
         }
-      }
+        return std::nullopt;
+      }));
+  }
+  // they're remembered so monitoring can tell what changes in them later
+  for (auto i = 0U; i < models.size(); ++i) {
+    if (auto loaded = loads[i].get(); loaded.has_value()) {
+      loaded_.try_emplace(models[i].string(), std::move(*loaded));
     }
   }
 }
@@ -173,37 +342,49 @@ std::string ModelRepository::getRepository() const {
 
 void ModelRepository::enableMonitoring(bool use_polling) {
   file_watcher_ = std::make_unique<efsw::FileWatcher>(use_polling);
-  listener_ =
-    std::make_unique<amdinfer::UpdateListener>(repository_, endpoints_);
+  listener_ = std::make_unique<amdinfer::UpdateListener>(
+    repository_, endpoints_, std::move(loaded_));
 
   file_watcher_->addWatch(repository_.string(), listener_.get(), true);
   file_watcher_->watch();
 }
 
+void ModelRepository::enableLazyLoading(size_t memory_budget,
+                                        std::chrono::seconds idle_timeout) {
+  lazy_loader_ = std::make_unique<LazyLoader>(repository_, endpoints_,
+                                              memory_budget, idle_timeout);
+}
+
+bool ModelRepository::infer(const std::string& model,
+                            const std::string& version,
+                            RequestContainerPtr* request) {
+  return lazy_loader_ != nullptr &&
+         lazy_loader_->infer(model, version, request);
+}
+
+UpdateListener::UpdateListener(
+  fs::path repository, Endpoints* endpoints,
+  std::unordered_map<std::string, RepositoryModel> models)
+  : repository_(std::move(repository)),
+    endpoints_(endpoints),
+    models_(std::move(models)) {
+  thread_ = std::thread{&UpdateListener::run, this};
+}
+
+UpdateListener::~UpdateListener() {
+  {
+    const std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  changed_.notify_one();
+  thread_.join();
+}
+
 void UpdateListener::handleFileAction(
   [[maybe_unused]] efsw::WatchID watch_id, const std::string& dir,
   const std::string& filename, efsw::Action action,
   [[maybe_unused]] std::string old_filename) {
   AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
-  // arbitrary delay to make sure filesystem has settled
-  const std::chrono::milliseconds delay{100};
-  if (filename == "config.pbtxt" || util::endsWith(filename, "toml")) {
-    if (action == efsw::Actions::Add) {
-      std::this_thread::sleep_for(delay);
-      auto model_name = fs::path(dir).parent_path().filename();
-      try {
-        loadModel(repository_, model_name, endpoints_);
-      } catch (const runtime_error&) {
-        AMDINFER_LOG_INFO(logger, "Error loading " + model_name.string());
-      }
-    } else if (action == efsw::Actions::Delete) {
-      // arbitrary delay to make sure filesystem has settled
-      std::this_thread::sleep_for(delay);
-      auto model = fs::path(dir).parent_path().filename();
-      endpoints_->unload(model.string(), "");
-    }
-  }
-
   switch (action) {
     case efsw::Actions::Add:
       AMDINFER_LOG_DEBUG(
@@ -225,6 +406,184 @@ void UpdateListener::handleFileAction(
     default:
       AMDINFER_LOG_ERROR(logger, "Should never happen");
   }
+
+  // the path's components in the repository are the model, then usually its
+  // version and the version's files
+  const auto path = fs::path(dir) / filename;
+  const auto components = getComponents(repository_, path);
+  if (components.empty()) {
+    return;
+  }
+  const auto& model = components.front();
+
+  {
+    const std::lock_guard lock{mutex_};
+    auto& pending = pending_[model];
+    pending.last = std::chrono::steady_clock::now();
+    if (filename == kReadyMarker) {
+      pending.ready = pending.ready || action != efsw::Actions::Delete;
+    } else if (components.size() == 1 || isConfigFile(filename)) {
+      // adding or removing the model's directory changes its configuration
+      pending.config = true;
+    } else if (components.size() == 2 && isVersion(filename) &&
+               (action == efsw::Actions::Add ||
+                action == efsw::Actions::Moved) &&
+               fs::is_directory(path)) {
+      // a new version directory should be moved into place with its files
+      // already in it
+      pending.versions.push_back(filename);
+    } else if (!isVersion(components[1]) || components[1] == kLoadedVersion) {
+      // the files of other versions don't change the loaded one
+      pending.files = true;
+    }
+  }
+  changed_.notify_one();
+}
+
+void UpdateListener::run() {
+  util::setThreadName("repository");
+  std::unique_lock lock{mutex_};
+  while (!stop_) {
+    const auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+    std::vector<std::pair<std::string, Pending>> complete;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      const auto quiet = it->second.last + kQuietPeriod;
+      if (it->second.ready || quiet <= now) {
+        complete.emplace_back(it->first, std::move(it->second));
+        it = pending_.erase(it);
+      } else {
+        next = std::min(next, quiet);
+        ++it;
+      }
+    }
+
+    if (complete.empty()) {
+      if (next == std::chrono::steady_clock::time_point::max()) {
+        changed_.wait(lock);
+      } else {
+        changed_.wait_until(lock, next);
+      }
+      continue;
+    }
+
+    lock.unlock();
+    for (const auto& [model, pending] : complete) {
+      AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+      try {
+        this->process(model, pending);
+      } catch (const std::exception& e) {
+        AMDINFER_LOG_INFO(logger, "Error updating " + model + ": " + e.what());
+      }
+    }
+    lock.lock();
+  }
+}
+
+void UpdateListener::process(const std::string& model,
+                             const Pending& pending) {
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+  auto recorded = models_.find(model);
+  const bool loaded =
+    recorded == models_.end()
+      ? endpoints_->exists(model)
+      : std::all_of(recorded->second.endpoints.begin(),
+                    recorded->second.endpoints.end(),
+                    [this](const auto& endpoint) {
+                      return endpoints_->exists(endpoint);
+                    });
+
+  // a new version replaces the version serving a loaded model. The model's
+  // endpoints now belong to the swap so they're no longer tracked here
+  if (!pending.versions.empty() && loaded) {
+    const auto version = *std::max_element(
+      pending.versions.begin(), pending.versions.end(),
+      [](const auto& lhs, const auto& rhs) {
+        return lhs.size() != rhs.size() ? lhs.size() < rhs.size() : lhs < rhs;
+      });
+    swapModel(repository_, model, version, ParameterMap{}, endpoints_);
+    models_.erase(model);
+    AMDINFER_LOG_INFO(logger, "Swapped " + model + " to version " + version);
+    return;
+  }
+  if (!pending.config && !pending.files) {
+    return;
+  }
+
+  // the new configuration is parsed before anything is changed so a model
+  // with a broken one keeps running as it was
+  std::shared_ptr<const ModelConfig> config;
+  try {
+    config =
+      std::make_shared<const ModelConfig>(parseModel(repository_, model, ""));
+  } catch (const file_not_found_error&) {
+    if (loaded) {
+      this->unload(model);
+      AMDINFER_LOG_INFO(logger, "Unloaded " + model);
+    }
+    models_.erase(model);
+    return;
+  }
+
+  if (!loaded) {
+    models_.erase(model);
+    auto endpoints =
+      loadModelConfig(model, "", *config, ParameterMap{}, endpoints_);
+    models_.try_emplace(model, RepositoryModel{config, std::move(endpoints)});
+    AMDINFER_LOG_INFO(logger, "Loaded " + model);
+    return;
+  }
+  // models loaded some other way, such as by a swap or by a request to load
+  // them, are left alone
+  if (recorded == models_.end()) {
+    return;
+  }
+
+  auto& current = recorded->second;
+  if (!pending.files) {
+    if (auto updates = diffConfigs(*current.config, *config);
+        updates.has_value()) {
+      bool updated = false;
+      for (auto i = 0U; i < updates->size(); ++i) {
+        if (!(*updates)[i].empty()) {
+          endpoints_->update(current.endpoints[i], (*updates)[i]);
+          updated = true;
+        }
+      }
+      current.config = config;
+      if (updated) {
+        AMDINFER_LOG_INFO(logger, "Updated " + model + " in place");
+      }
+      return;
+    }
+  }
+
+  // anything else needs the model to be reloaded. If the new version fails
+  // to load, the old one is loaded again
+  this->unload(model);
+  try {
+    current.endpoints =
+      loadModelConfig(model, "", *config, ParameterMap{}, endpoints_);
+    current.config = config;
+    AMDINFER_LOG_INFO(logger, "Reloaded " + model);
+  } catch (const runtime_error& e) {
+    AMDINFER_LOG_INFO(logger, "Error reloading " + model + ", restoring it: " +
+                                e.what());
+    current.endpoints = loadModelConfig(model, "", *current.config,
+                                        ParameterMap{}, endpoints_);
+  }
+}
+
+void UpdateListener::unload(const std::string& model) {
+  auto recorded = models_.find(model);
+  // unloading an ensemble unloads its models too
+  if (recorded == models_.end() || !recorded->second.config->isChain()) {
+    endpoints_->unload(model, "");
+    return;
+  }
+  for (const auto& endpoint : recorded->second.endpoints) {
+    endpoints_->unload(endpoint, "");
+  }
 }
 
 void ModelRepository::setEndpoints(Endpoints* endpoints) {
@@ -16,10 +16,20 @@
 #ifndef GUARD_AMDINFER_CORE_MODEL_REPOSITORY
 #define GUARD_AMDINFER_CORE_MODEL_REPOSITORY
 
-#include <efsw/efsw.hpp>  // for FileWatcher, Action, FileWatchListener, Wat...
-#include <filesystem>     // for path
-#include <memory>         // for unique_ptr
-#include <string>         // for string
+#include <chrono>              // for seconds, steady_clock
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <efsw/efsw.hpp>       // for FileWatcher, Action, FileWatchListener
+#include <filesystem>          // for path
+#include <memory>              // for unique_ptr, shared_ptr
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <thread>              // for thread
+#include <unordered_map>       // for unordered_map
+#include <vector>              // for vector
+
+#include "amdinfer/core/lazy_loader.hpp"  // for LazyLoader
+#include "amdinfer/declarations.hpp"      // for RequestContainerPtr
 
 namespace amdinfer {
 
@@ -27,22 +37,115 @@ class Endpoints;
 class ParameterMap;
 class ModelConfig;
 
+/// A model loaded from the repository and what it was loaded with
+struct RepositoryModel {
+  std::shared_ptr<const ModelConfig> config;
+  /// The endpoint of each of the config's models
+  std::vector<std::string> endpoints;
+};
+
+/**
+ * @brief Watches the repository for changes. The events are collected per
+ * model and a model is only processed once its directory has been quiet for a
+ * while or a ".ready" marker file is written in it, so a model that's copied
+ * in file by file is loaded once it's complete. A changed configuration is
+ * compared to the one the model was loaded with and only what changed is
+ * applied: parameters that Endpoints::update can change are updated in place
+ * and the model is only reloaded for other changes. If the new configuration
+ * can't be parsed, the model keeps running as it was.
+ */
 class UpdateListener : public efsw::FileWatchListener {
  public:
-  UpdateListener(const std::filesystem::path& repository, Endpoints* endpoints)
-    : repository_(repository), endpoints_(endpoints) {}
+  /**
+   * @brief Construct a new UpdateListener object
+   *
+   * @param repository path to the model repository
+   * @param endpoints the endpoints to load the models into
+   * @param models model -> what it was loaded with for the models that are
+   * already loaded from the repository
+   */
+  UpdateListener(std::filesystem::path repository, Endpoints* endpoints,
+                 std::unordered_map<std::string, RepositoryModel> models);
+  ~UpdateListener() override;
+  UpdateListener(UpdateListener const&) = delete;
+  UpdateListener& operator=(const UpdateListener&) = delete;
+  UpdateListener(UpdateListener&& other) = delete;
+  UpdateListener& operator=(UpdateListener&& other) = delete;
+
   void handleFileAction(efsw::WatchID watch_id, const std::string& dir,
                         const std::string& filename, efsw::Action action,
                         std::string old_filename) override;
 
  private:
+  /// The changes seen in a model's directory since it was last processed
+  struct Pending {
+    std::chrono::steady_clock::time_point last;
+    bool config = false;
+    /// Other files of the version loaded from the directory changed
+    bool files = false;
+    /// The marker was written so the model doesn't wait to be quiet
+    bool ready = false;
+    /// New version directories
+    std::vector<std::string> versions;
+  };
+
+  /// Process the models whose changes are complete until it's stopped
+  void run();
+  void process(const std::string& model, const Pending& pending);
+  /// Unload a model, along with all the endpoints it was loaded at
+  void unload(const std::string& model);
+
   std::filesystem::path repository_;
   Endpoints* endpoints_;
+  /// model -> what it was loaded with. Only used by the listener's thread
+  std::unordered_map<std::string, RepositoryModel> models_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  /// model -> its changes, guarded by the mutex
+  std::unordered_map<std::string, Pending> pending_;
+  /// Guarded by the mutex
+  bool stop_ = false;
+  std::thread thread_;
 };
 
 ModelConfig parseModel(const std::filesystem::path& repository,
                        const std::string& model, const std::string& version);
 
+/**
+ * @brief Load the models of a parsed configuration. Chains are loaded from the
+ * last model to the first so each model's next endpoint exists. If the models
+ * form a DAG instead, they're loaded together with an ensemble at the model's
+ * name that schedules requests across them.
+ *
+ * @param model the name of the model
+ * @param version the version of the model
+ * @param config the parsed configuration of the model
+ * @param parameters load-time parameters that override those in the config
+ * @param endpoints the endpoints to load the models into
+ * @return std::vector<std::string> the endpoint of each of the config's models
+ */
+std::vector<std::string> loadModelConfig(const std::string& model,
+                                         const std::string& version,
+                                         const ModelConfig& config,
+                                         const ParameterMap& parameters,
+                                         Endpoints* endpoints);
+
+/**
+ * @brief Load a version of a model and atomically swap the model's name to it.
+ * The version that served the name before is drained and unloaded, so requests
+ * to the name are never refused in between. See Endpoints::swap
+ *
+ * @param repository path to the model repository
+ * @param model the name of the model
+ * @param version the version to load and swap to
+ * @param parameters load-time parameters that override those in the config
+ * @param endpoints the endpoints to load the version into
+ */
+void swapModel(const std::filesystem::path& repository,
+               const std::string& model, const std::string& version,
+               const ParameterMap& parameters, Endpoints* endpoints);
+
 class ModelRepository {
  public:
   void setRepository(const std::filesystem::path& repository_path,
@@ -50,12 +153,37 @@ class ModelRepository {
   std::string getRepository() const;
   void setEndpoints(Endpoints* endpoints);
   void enableMonitoring(bool use_polling);
+  /**
+   * @brief Load the repository's models on their first request. See
+   * LazyLoader
+   *
+   * @param memory_budget bytes that the models may use. 0 for no limit
+   * @param idle_timeout time after which an unused model is unloaded. 0 to
+   * keep them loaded
+   */
+  void enableLazyLoading(size_t memory_budget,
+                         std::chrono::seconds idle_timeout);
+  /**
+   * @brief Take a request for a model that isn't loaded if lazy loading is
+   * enabled. The model is loaded and the request is sent to it afterwards.
+   *
+   * @param model the name of the model
+   * @param version the version of the model
+   * @param request the request. It's moved from if it's taken
+   * @return bool true if the request was taken
+   */
+  bool infer(const std::string& model, const std::string& version,
+             RequestContainerPtr* request);
 
  private:
   std::filesystem::path repository_;
   Endpoints* endpoints_;
-  std::unique_ptr<efsw::FileWatcher> file_watcher_;
+  /// model -> what it was loaded with for the models loaded at startup
+  std::unordered_map<std::string, RepositoryModel> loaded_;
+  // the watcher is destroyed first so it stops calling the listener
   std::unique_ptr<UpdateListener> listener_;
+  std::unique_ptr<efsw::FileWatcher> file_watcher_;
+  std::unique_ptr<LazyLoader> lazy_loader_;
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,147 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the multiplexer that runs the batches of many workers
+ */
+
+#include "amdinfer/core/multiplexer.hpp"
+
+#include <algorithm>      // for any_of, remove_if
+#include <exception>      // for exception
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+
+#include "amdinfer/core/exceptions.hpp"      // for invalid_argument
+#include "amdinfer/observation/logging.hpp"  // for Logger, AMDINFER_LOG_ERROR
+#include "amdinfer/util/thread.hpp"          // for setThreadName
+#include "amdinfer/workers/worker.hpp"       // for Worker
+
+namespace amdinfer {
+
+Multiplexer::Multiplexer(std::string group)
+  : group_(std::move(group)),
+    doorbell_(std::make_shared<moodycamel::LightweightSemaphore>()) {
+  thread_ = std::thread{&Multiplexer::run, this};
+}
+
+Multiplexer::~Multiplexer() {
+  {
+    const std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  doorbell_->signal();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<Multiplexer> Multiplexer::get(const std::string& group) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<Multiplexer>> groups;
+
+  const std::lock_guard lock{mutex};
+  auto& multiplexer = groups[group];
+  auto shared = multiplexer.lock();
+  if (shared == nullptr) {
+    shared = std::make_shared<Multiplexer>(group);
+    multiplexer = shared;
+  }
+  return shared;
+}
+
+std::shared_ptr<moodycamel::LightweightSemaphore> Multiplexer::getDoorbell()
+  const {
+  return doorbell_;
+}
+
+void Multiplexer::add(workers::Worker* worker, BatchPtrQueue* queue,
+                      const MemoryPool* pool) {
+  if (!worker->isMultiplexable()) {
+    throw invalid_argument(worker->getName() + " can't be multiplexed");
+  }
+  {
+    const std::lock_guard lock{mutex_};
+    members_.push_back(Member{worker, queue, pool});
+  }
+  // batches may have been queued before it joined
+  doorbell_->signal();
+}
+
+void Multiplexer::remove(const workers::Worker* worker) {
+  const auto is_worker = [worker](const Member& member) {
+    return member.worker == worker;
+  };
+  std::unique_lock lock{mutex_};
+  for (auto& member : members_) {
+    if (is_worker(member)) {
+      member.leaving = true;
+    }
+  }
+  doorbell_->signal();
+  removed_.wait(lock, [&]() {
+    return std::none_of(members_.begin(), members_.end(), is_worker);
+  });
+}
+
+void Multiplexer::run() {
+  util::setThreadName("mux" + group_);
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
+  const auto timeout_us =
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      kMultiplexerPollInterval)
+      .count();
+
+  std::vector<Member> members;
+  while (true) {
+    {
+      const std::lock_guard lock{mutex_};
+      // members that are leaving go once their queued batches have run
+      const auto left = std::remove_if(
+        members_.begin(), members_.end(), [](const Member& member) {
+          return member.leaving && member.queue->size_approx() == 0;
+        });
+      if (left != members_.end()) {
+        members_.erase(left, members_.end());
+        removed_.notify_all();
+      }
+      if (stop_) {
+        return;
+      }
+      members.assign(members_.begin(), members_.end());
+    }
+
+    // a batch from each member in turn so a busy one can't starve the others
+    bool ran = false;
+    for (const auto& member : members) {
+      BatchPtr batch;
+      if (!member.queue->try_dequeue(batch) || batch == nullptr) {
+        continue;
+      }
+      ran = true;
+      try {
+        member.worker->runBatch(std::move(batch), member.pool);
+      } catch (const std::exception& e) {
+        AMDINFER_LOG_ERROR(logger, member.worker->getName() +
+                                     " failed to run a batch: " + e.what());
+      }
+    }
+    if (!ran) {
+      doorbell_->wait(timeout_us);
+    }
+  }
+}
+
+}  // namespace amdinfer
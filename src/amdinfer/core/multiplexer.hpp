@@ -0,0 +1,119 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the multiplexer that runs the batches of many workers on one
+ * thread
+ */
+
+#ifndef GUARD_AMDINFER_CORE_MULTIPLEXER
+#define GUARD_AMDINFER_CORE_MULTIPLEXER
+
+#include <chrono>              // for milliseconds
+#include <condition_variable>  // for condition_variable
+#include <memory>              // for shared_ptr
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <thread>              // for thread
+#include <vector>              // for vector
+
+#include "amdinfer/batching/batcher.hpp"  // for BatchPtrQueue
+#include "amdinfer/util/queue.hpp"        // for LightweightSemaphore
+
+namespace amdinfer {
+
+class MemoryPool;
+
+namespace workers {
+class Worker;
+}  // namespace workers
+
+/// How long the multiplexer waits for a batch before checking its members
+constexpr auto kMultiplexerPollInterval = std::chrono::milliseconds(100);
+
+/**
+ * @brief Runs the batches of the workers of many endpoints on one thread
+ * instead of a thread per worker. This suits a long tail of small models whose
+ * threads would mostly sleep. The workers are loaded with the same "multiplex"
+ * load-time parameter and their batchers ring the multiplexer's doorbell when
+ * they send a batch. It takes a batch from each member in turn so a busy model
+ * can't starve the others and runs them one at a time on its device.
+ */
+class Multiplexer {
+ public:
+  /**
+   * @brief Construct a new Multiplexer object and start its thread
+   *
+   * @param group the name of the multiplexer's group
+   */
+  explicit Multiplexer(std::string group);
+  ~Multiplexer();
+  Multiplexer(Multiplexer const&) = delete;
+  Multiplexer& operator=(const Multiplexer&) = delete;
+  Multiplexer(Multiplexer&& other) = delete;
+  Multiplexer& operator=(Multiplexer&& other) = delete;
+
+  /**
+   * @brief Get the multiplexer of a group. It's made for the group's first
+   * member and stops once no endpoint holds it.
+   *
+   * @param group the name of the group
+   * @return std::shared_ptr<Multiplexer>
+   */
+  static std::shared_ptr<Multiplexer> get(const std::string& group);
+
+  /// Get the semaphore that the members' batchers signal for each batch
+  [[nodiscard]] std::shared_ptr<moodycamel::LightweightSemaphore> getDoorbell()
+    const;
+
+  /**
+   * @brief Start running the batches of a worker
+   *
+   * @param worker the worker. It must be multiplexable
+   * @param queue the queue that its batchers send batches to
+   * @param pool the memory pool
+   */
+  void add(workers::Worker* worker, BatchPtrQueue* queue,
+           const MemoryPool* pool);
+  /**
+   * @brief Stop running the batches of a worker. It returns once the batches
+   * already queued for the worker are run.
+   *
+   * @param worker the worker
+   */
+  void remove(const workers::Worker* worker);
+
+ private:
+  struct Member {
+    workers::Worker* worker;
+    BatchPtrQueue* queue;
+    const MemoryPool* pool;
+    bool leaving = false;
+  };
+
+  void run();
+
+  const std::string group_;
+  std::shared_ptr<moodycamel::LightweightSemaphore> doorbell_;
+  std::mutex mutex_;
+  std::condition_variable removed_;
+  std::vector<Member> members_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_MULTIPLEXER
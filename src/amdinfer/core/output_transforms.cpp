@@ -0,0 +1,238 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the reductions that requests can ask for on their outputs
+ */
+
+#include "amdinfer/core/output_transforms.hpp"
+
+#include <algorithm>    // for find_if, min, transform
+#include <cctype>       // for toupper
+#include <cstdint>      // for int32_t, int64_t
+#include <cstring>      // for memcpy
+#include <type_traits>  // for is_same_v
+#include <utility>      // for move
+#include <variant>      // for bad_variant_access
+
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/pre_post/get_top_k.hpp"       // for getTopK
+#include "amdinfer/util/float_convert.hpp"       // for convertDatatype
+
+namespace amdinfer {
+
+namespace {
+
+/// Get the indices of the k largest values of each row in the data's type
+struct GetTopK {
+  template <typename T>
+  void operator()(const void* data, size_t rows, size_t size, size_t k,
+                  int32_t* indices) const {
+    if constexpr (std::is_same_v<T, char>) {
+      throw invalid_argument("BYTES outputs can't be reduced");
+    } else {
+      pre_post::getTopK(static_cast<const T*>(data), rows, size, k, indices);
+    }
+  }
+};
+
+OutputTransform getTransform(const InferenceRequestOutput& output) {
+  const auto& parameters = output.getParameters();
+  OutputTransform transform;
+  transform.name = output.getName();
+  try {
+    if (parameters.has(kOutputTopK)) {
+      const auto k = parameters.get<int32_t>(kOutputTopK);
+      if (k < 1) {
+        throw invalid_argument("'top_k' of output " + transform.name +
+                               " must be positive");
+      }
+      transform.top_k = static_cast<size_t>(k);
+    }
+    if (parameters.has(kOutputArgmax)) {
+      transform.argmax = parameters.get<bool>(kOutputArgmax);
+    }
+    if (parameters.has(kOutputCast)) {
+      auto datatype = parameters.get<std::string>(kOutputCast);
+      std::transform(datatype.begin(), datatype.end(), datatype.begin(),
+                     [](unsigned char c) { return std::toupper(c); });
+      transform.cast = DataType(datatype.c_str());
+    }
+  } catch (const std::bad_variant_access&) {
+    throw invalid_argument("'top_k' must be an integer, 'argmax' a boolean "
+                           "and 'cast' a string in output " +
+                           transform.name);
+  }
+
+  if (transform.argmax && transform.top_k > 0) {
+    throw invalid_argument("Output " + transform.name +
+                           " can't use both 'top_k' and 'argmax'");
+  }
+  if (transform.argmax && transform.cast != DataType::Unknown) {
+    throw invalid_argument("The index from 'argmax' of output " +
+                           transform.name + " can't be cast");
+  }
+  if (transform.cast == DataType::Bytes) {
+    throw invalid_argument("Output " + transform.name +
+                           " can't be cast to BYTES");
+  }
+  return transform;
+}
+
+/// Make an output from its values, casting them if the transform asks
+InferenceResponseOutput makeOutput(const std::string& name, Shape shape,
+                                   DataType datatype, const void* data,
+                                   size_t count, DataType cast) {
+  InferenceResponseOutput output;
+  output.setName(name);
+  output.setShape(std::move(shape));
+  const auto to = cast == DataType::Unknown ? datatype : cast;
+  output.setDatatype(to);
+  std::vector<std::byte> buffer(count * to.size());
+  if (to == datatype) {
+    std::memcpy(buffer.data(), data, buffer.size());
+  } else {
+    util::convertDatatype(data, datatype, buffer.data(), to, count);
+  }
+  output.setData(std::move(buffer));
+  return output;
+}
+
+/// Add the transformed output, and its indices if it has any, to a response
+void transformOutput(const InferenceResponseOutput& output,
+                     const OutputTransform& transform,
+                     InferenceResponse* response) {
+  const auto& name = output.getName();
+  const auto datatype = output.getDatatype();
+  if (datatype == DataType::Bytes) {
+    throw invalid_argument("Output " + name + " is BYTES and can't be reduced");
+  }
+  const auto count = output.getSize();
+  if (!transform.argmax && transform.top_k == 0) {
+    response->addOutput(makeOutput(name, output.getShape(), datatype,
+                                   output.getData(), count, transform.cast));
+    return;
+  }
+
+  const auto& shape = output.getShape();
+  const auto size =
+    shape.empty() ? count : static_cast<size_t>(std::max(shape.back(), int64_t{0}));
+  if (size == 0) {
+    throw invalid_argument("Output " + name + " is empty and can't be reduced");
+  }
+  const auto rows = count / size;
+  const auto k = transform.argmax ? 1 : std::min(transform.top_k, size);
+  Shape outer;
+  if (!shape.empty()) {
+    outer.assign(shape.begin(), shape.end() - 1);
+  }
+
+  std::vector<int32_t> indices(rows * k);
+  switchOverTypes(GetTopK(), datatype, output.getData(), rows, size, k,
+                  indices.data());
+
+  if (transform.argmax) {
+    if (outer.empty()) {
+      outer.push_back(1);
+    }
+    response->addOutput(makeOutput(name, std::move(outer), DataType::Int32,
+                                   indices.data(), indices.size(),
+                                   DataType::Unknown));
+    return;
+  }
+
+  // gather the values of the indices by their size so any datatype works
+  const auto bytes = datatype.size();
+  const auto* data = static_cast<const std::byte*>(output.getData());
+  std::vector<std::byte> values(indices.size() * bytes);
+  for (auto row = 0U; row < rows; ++row) {
+    for (auto i = 0U; i < k; ++i) {
+      const auto index = row * k + i;
+      std::memcpy(values.data() + index * bytes,
+                  data + (row * size + indices[index]) * bytes, bytes);
+    }
+  }
+  outer.push_back(static_cast<int64_t>(k));
+  response->addOutput(makeOutput(name, outer, datatype, values.data(),
+                                 indices.size(), transform.cast));
+  response->addOutput(makeOutput(name + "_indices", std::move(outer),
+                                 DataType::Int32, indices.data(),
+                                 indices.size(), DataType::Unknown));
+}
+
+}  // namespace
+
+std::vector<OutputTransform> getOutputTransforms(
+  const InferenceRequest& request) {
+  std::vector<OutputTransform> transforms;
+  for (const auto& output : request.getOutputs()) {
+    const auto& parameters = output.getParameters();
+    if (parameters.has(kOutputTopK) || parameters.has(kOutputArgmax) ||
+        parameters.has(kOutputCast)) {
+      transforms.push_back(getTransform(output));
+    }
+  }
+  return transforms;
+}
+
+InferenceResponse transformOutputs(
+  const InferenceResponse& response,
+  const std::vector<OutputTransform>& transforms) {
+  auto transformed = response;
+  auto outputs = std::move(transformed).getOutputs();
+  for (auto& output : outputs) {
+    const auto transform = std::find_if(
+      transforms.begin(), transforms.end(),
+      [&output](const auto& t) { return t.name == output.getName(); });
+    if (transform == transforms.end()) {
+      transformed.addOutput(std::move(output));
+    } else {
+      transformOutput(output, *transform, &transformed);
+    }
+  }
+  return transformed;
+}
+
+void holdOutputTransforms(InferenceRequest* request) {
+  auto transforms = getOutputTransforms(*request);
+  if (transforms.empty()) {
+    return;
+  }
+  auto callback = request->getCallback();
+  if (callback == nullptr) {
+    return;
+  }
+  request->setCallback([transforms = std::move(transforms),
+                        callback = std::move(callback)](
+                         const InferenceResponse& response) mutable {
+    if (response.isError()) {
+      callback(response);
+      return;
+    }
+    InferenceResponse transformed;
+    try {
+      transformed = transformOutputs(response, transforms);
+    } catch (const invalid_argument& e) {
+      callback(InferenceResponse{e.what()});
+      return;
+    }
+    callback(transformed);
+  });
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,94 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the reductions that requests can ask for on their outputs
+ */
+
+#ifndef GUARD_AMDINFER_CORE_OUTPUT_TRANSFORMS
+#define GUARD_AMDINFER_CORE_OUTPUT_TRANSFORMS
+
+#include <cstddef>  // for size_t
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+
+namespace amdinfer {
+
+class InferenceRequest;
+class InferenceResponse;
+
+/// Output parameter to send only the k largest values of the last dimension
+constexpr auto kOutputTopK = "top_k";
+/// Output parameter to send only the index of the largest value
+constexpr auto kOutputArgmax = "argmax";
+/// Output parameter to send the values in another datatype, such as "FP16"
+constexpr auto kOutputCast = "cast";
+
+/**
+ * @brief How to reduce a requested output before it's sent. The reductions
+ * work along the output's last dimension, e.g. the classes of a batch of
+ * scores.
+ */
+struct OutputTransform {
+  /// Name of the output
+  std::string name;
+  /// Number of largest values to keep along the last dimension or 0 for all.
+  /// Their indices are sent as an INT32 output named "<name>_indices"
+  size_t top_k = 0;
+  /// If true, the output is replaced by the INT32 index of its largest value
+  bool argmax = false;
+  /// Datatype to cast the values to or Unknown to keep theirs
+  DataType cast = DataType::Unknown;
+};
+
+/**
+ * @brief Get the transforms that a request's outputs ask for with their
+ * "top_k", "argmax" and "cast" parameters. Throws invalid_argument if a
+ * parameter has the wrong type or they can't be combined
+ *
+ * @param request the request
+ * @return std::vector<OutputTransform> one per output that asks for any
+ */
+std::vector<OutputTransform> getOutputTransforms(
+  const InferenceRequest& request);
+
+/**
+ * @brief Apply transforms to the outputs of a response. Outputs without a
+ * transform are kept as they are. Throws invalid_argument if an output can't
+ * be transformed, e.g. if it's BYTES
+ *
+ * @param response the response
+ * @param transforms the transforms
+ * @return InferenceResponse
+ */
+InferenceResponse transformOutputs(
+  const InferenceResponse& response,
+  const std::vector<OutputTransform>& transforms);
+
+/**
+ * @brief Transform the outputs of a request's responses as its outputs ask
+ * before they're sent so the reductions are done on the server instead of the
+ * client getting the full tensors. Call it after the request's callback is
+ * set. Responses whose outputs can't be transformed become errors
+ *
+ * @param request the request
+ */
+void holdOutputTransforms(InferenceRequest* request);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_OUTPUT_TRANSFORMS
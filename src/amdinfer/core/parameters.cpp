@@ -19,6 +19,7 @@
 
 #include "amdinfer/core/parameters.hpp"
 
+#include <algorithm>    // for lower_bound
 #include <cassert>      // for assert
 #include <cstdint>      // for int32_t
 #include <cstring>      // for size_t, memcpy
@@ -44,9 +45,11 @@ ParameterMap::ParameterMap(const std::vector<std::string> &keys,
 }
 
 void ParameterMap::put(const std::string &key, const Parameter &value) {
-  auto [iter, emplaced] = this->parameters_.try_emplace(key, value);
-  if (!emplaced) {
+  auto iter = this->lowerBound(key);
+  if (iter != this->parameters_.end() && iter->first == key) {
     iter->second = value;
+  } else {
+    this->parameters_.emplace(iter, key, value);
   }
 }
 
@@ -54,20 +57,28 @@ void ParameterMap::put(const std::string &key, const char *value) {
   put(key, std::string{value});
 }
 
-void ParameterMap::erase(const std::string &key) {
-  if (this->parameters_.find(key) != this->parameters_.end()) {
-    this->parameters_.erase(key);
+void ParameterMap::erase(std::string_view key) {
+  if (auto found = this->lowerBound(key);
+      found != this->parameters_.end() && found->first == key) {
+    this->parameters_.erase(found);
   }
 }
 
-bool ParameterMap::has(const std::string &key) const {
-  return this->parameters_.find(key) != this->parameters_.end();
+bool ParameterMap::has(std::string_view key) const {
+  return this->find(key) != this->parameters_.end();
 }
 
 void ParameterMap::rename(const std::string &key, const std::string &new_key) {
-  auto node = parameters_.extract(key);
-  node.key() = new_key;
-  parameters_.insert(std::move(node));
+  auto found = this->lowerBound(key);
+  if (found == this->parameters_.end() || found->first != key) {
+    return;
+  }
+  auto value = std::move(found->second);
+  this->parameters_.erase(found);
+  auto iter = this->lowerBound(new_key);
+  if (iter == this->parameters_.end() || iter->first != new_key) {
+    this->parameters_.emplace(iter, new_key, std::move(value));
+  }
 }
 
 size_t ParameterMap::size() const { return parameters_.size(); }
@@ -91,7 +102,32 @@ ParameterMap::ConstIterator ParameterMap::cend() const {
 }
 
 std::map<std::string, Parameter, std::less<>> ParameterMap::data() const {
-  return parameters_;
+  return {parameters_.begin(), parameters_.end()};
+}
+
+ParameterMap::Iterator ParameterMap::lowerBound(std::string_view key) {
+  return std::lower_bound(
+    parameters_.begin(), parameters_.end(), key,
+    [](const auto &parameter, std::string_view k) {
+      return parameter.first < k;
+    });
+}
+
+ParameterMap::ConstIterator ParameterMap::lowerBound(
+  std::string_view key) const {
+  return std::lower_bound(
+    parameters_.begin(), parameters_.end(), key,
+    [](const auto &parameter, std::string_view k) {
+      return parameter.first < k;
+    });
+}
+
+ParameterMap::ConstIterator ParameterMap::find(std::string_view key) const {
+  auto found = this->lowerBound(key);
+  if (found != parameters_.end() && found->first == key) {
+    return found;
+  }
+  return parameters_.end();
 }
 
 size_t ParameterMap::serializeSize() const {
@@ -173,6 +209,7 @@ const std::byte *ParameterMap::deserialize(const std::byte *data_in) {
   data_in += sizeof(size_t);
   std::vector<std::tuple<size_t, size_t, size_t>> params;
   params.reserve(size);
+  parameters_.reserve(size);
   for (auto i = 0U; i < size; i++) {
     auto index = std::to_integer<size_t>(*data_in);
     data_in += sizeof(size_t);
@@ -202,7 +239,12 @@ const std::byte *ParameterMap::deserialize(const std::byte *data_in) {
         }
       },
       param);
-    parameters_.try_emplace(key, param);
+    // the parameters are serialized in key order so they stay sorted
+    if (parameters_.empty() || parameters_.back().first < key) {
+      parameters_.emplace_back(std::move(key), std::move(param));
+    } else if (!has(key)) {
+      put(key, param);
+    }
   }
   return data_in;
 }
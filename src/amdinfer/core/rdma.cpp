@@ -0,0 +1,399 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the RDMA transport
+ */
+
+#include "amdinfer/core/rdma.hpp"
+
+#include <cstdint>      // for uint8_t, uint16_t, uint32_t, uint64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/util/wire.hpp"        // for WireReader, writeInt
+
+#ifdef AMDINFER_ENABLE_RDMA
+#include <infiniband/verbs.h>  // for ibv_reg_mr, ibv_post_send, ...
+
+#include <algorithm>  // for min
+#include <cerrno>     // for errno
+#include <cstdlib>    // for getenv
+#include <cstring>    // for strerror, memcpy
+#include <exception>  // for exception
+#include <random>     // for random_device
+#endif
+
+namespace amdinfer {
+
+std::string RdmaEndpoint::serialize() const {
+  std::string bytes;
+  util::writeInt(lid, &bytes);
+  util::writeInt(qpn, &bytes);
+  util::writeInt(psn, &bytes);
+  bytes.append(gid.begin(), gid.end());
+  return bytes;
+}
+
+RdmaEndpoint RdmaEndpoint::parse(std::string_view bytes) {
+  util::WireReader reader{bytes, "RDMA endpoint"};
+  RdmaEndpoint endpoint;
+  endpoint.lid = reader.readInt<uint16_t>();
+  endpoint.qpn = reader.readInt<uint32_t>();
+  endpoint.psn = reader.readInt<uint32_t>();
+  const auto gid = reader.take(endpoint.gid.size());
+  for (auto i = 0U; i < gid.size(); ++i) {
+    endpoint.gid.at(i) = static_cast<uint8_t>(gid[i]);
+  }
+  if (!reader.remaining().empty()) {
+    throw invalid_argument("The RDMA endpoint has trailing bytes");
+  }
+  return endpoint;
+}
+
+#ifdef AMDINFER_ENABLE_RDMA
+
+namespace {
+
+// work requests posted before waiting for them
+constexpr int kQueueDepth = 128;
+// larger transfers are split so they stay under any port's message size
+constexpr size_t kMaxMessageSize = size_t{1} << 30;
+// outstanding reads, which devices bound to a small number
+constexpr uint8_t kMaxReads = 16;
+constexpr auto kAccess =
+  IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE;
+
+int getEnvInt(const char* name, int fallback) {
+  const auto* value = std::getenv(name);
+  if (value == nullptr) {
+    return fallback;
+  }
+  try {
+    return std::stoi(value);
+  } catch (const std::exception&) {
+    throw invalid_argument(std::string{name} + " must be an integer");
+  }
+}
+
+[[noreturn]] void fail(const std::string& what) {
+  throw external_error(what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+/// The RDMA device of this process and the port that sessions use
+class RdmaDevice {
+ public:
+  RdmaDevice() {
+    port_ = static_cast<uint8_t>(getEnvInt("AMDINFER_RDMA_PORT", 1));
+    gid_index_ = getEnvInt("AMDINFER_RDMA_GID_INDEX", 0);
+
+    int count = 0;
+    auto** devices = ibv_get_device_list(&count);
+    if (devices == nullptr) {
+      fail("Couldn't list the RDMA devices");
+    }
+    const auto* wanted = std::getenv("AMDINFER_RDMA_DEVICE");
+    ibv_device* device = nullptr;
+    for (auto i = 0; i < count && device == nullptr; ++i) {
+      if (wanted == nullptr ||
+          std::string_view{ibv_get_device_name(devices[i])} == wanted) {
+        device = devices[i];
+      }
+    }
+    if (device == nullptr) {
+      ibv_free_device_list(devices);
+      throw external_error(wanted == nullptr
+                             ? std::string{"No RDMA devices found"}
+                             : "RDMA device " + std::string{wanted} +
+                                 " not found");
+    }
+    context_ = ibv_open_device(device);
+    ibv_free_device_list(devices);
+    if (context_ == nullptr) {
+      fail("Couldn't open the RDMA device");
+    }
+
+    domain_ = ibv_alloc_pd(context_);
+    ibv_device_attr attributes{};
+    if (domain_ == nullptr ||
+        ibv_query_device(context_, &attributes) != 0 ||
+        ibv_query_port(context_, port_, &port_attributes_) != 0 ||
+        ibv_query_gid(context_, port_, gid_index_, &gid_) != 0) {
+      const auto saved = errno;
+      this->close();
+      errno = saved;
+      fail("Couldn't set up the RDMA device");
+    }
+    reads_ = static_cast<uint8_t>(
+      std::min({static_cast<int>(kMaxReads), attributes.max_qp_rd_atom,
+                attributes.max_qp_init_rd_atom}));
+
+    // with on-demand paging, one registration covers all of the memory so
+    // transfers needn't register theirs
+    implicit_ = ibv_reg_mr(domain_, nullptr, SIZE_MAX,
+                           IBV_ACCESS_ON_DEMAND | IBV_ACCESS_LOCAL_WRITE);
+  }
+
+  ~RdmaDevice() { this->close(); }
+  RdmaDevice(RdmaDevice const&) = delete;
+  RdmaDevice& operator=(const RdmaDevice&) = delete;
+  RdmaDevice(RdmaDevice&& other) = delete;
+  RdmaDevice& operator=(RdmaDevice&& other) = delete;
+
+  [[nodiscard]] ibv_context* context() const { return context_; }
+  [[nodiscard]] ibv_pd* domain() const { return domain_; }
+  [[nodiscard]] uint8_t port() const { return port_; }
+  [[nodiscard]] int gidIndex() const { return gid_index_; }
+  [[nodiscard]] const ibv_gid& gid() const { return gid_; }
+  [[nodiscard]] const ibv_port_attr& portAttributes() const {
+    return port_attributes_;
+  }
+  [[nodiscard]] uint8_t reads() const { return reads_; }
+  /// Get the registration covering all memory or null if there isn't one
+  [[nodiscard]] ibv_mr* implicit() const { return implicit_; }
+
+ private:
+  void close() {
+    if (implicit_ != nullptr) {
+      ibv_dereg_mr(implicit_);
+    }
+    if (domain_ != nullptr) {
+      ibv_dealloc_pd(domain_);
+    }
+    if (context_ != nullptr) {
+      ibv_close_device(context_);
+    }
+  }
+
+  ibv_context* context_ = nullptr;
+  ibv_pd* domain_ = nullptr;
+  ibv_mr* implicit_ = nullptr;
+  ibv_port_attr port_attributes_{};
+  ibv_gid gid_{};
+  uint8_t port_ = 1;
+  int gid_index_ = 0;
+  uint8_t reads_ = 1;
+};
+
+namespace {
+
+/// Get this process's device, opening it if nothing holds it
+std::shared_ptr<RdmaDevice> getDevice() {
+  static std::mutex mutex;
+  static std::weak_ptr<RdmaDevice> opened;
+  const std::lock_guard lock{mutex};
+  auto device = opened.lock();
+  if (device == nullptr) {
+    device = std::make_shared<RdmaDevice>();
+    opened = device;
+  }
+  return device;
+}
+
+}  // namespace
+
+RdmaMemory::RdmaMemory(void* data, size_t size) : device_(getDevice()) {
+  region_ = ibv_reg_mr(device_->domain(), data, size, kAccess);
+  if (region_ == nullptr) {
+    fail("Couldn't register memory for RDMA");
+  }
+}
+
+RdmaMemory::~RdmaMemory() { ibv_dereg_mr(region_); }
+
+uint64_t RdmaMemory::address() const {
+  return reinterpret_cast<uint64_t>(region_->addr);
+}
+
+uint32_t RdmaMemory::key() const { return region_->rkey; }
+
+RdmaSession::RdmaSession() : device_(getDevice()) {
+  queue_ = ibv_create_cq(device_->context(), kQueueDepth, nullptr, nullptr, 0);
+  if (queue_ == nullptr) {
+    fail("Couldn't create an RDMA completion queue");
+  }
+  ibv_qp_init_attr init{};
+  init.send_cq = queue_;
+  init.recv_cq = queue_;
+  init.qp_type = IBV_QPT_RC;
+  init.cap.max_send_wr = kQueueDepth;
+  init.cap.max_recv_wr = 1;
+  init.cap.max_send_sge = 1;
+  init.cap.max_recv_sge = 1;
+  pair_ = ibv_create_qp(device_->domain(), &init);
+  if (pair_ == nullptr) {
+    const auto saved = errno;
+    ibv_destroy_cq(queue_);
+    errno = saved;
+    fail("Couldn't create an RDMA queue pair");
+  }
+
+  ibv_qp_attr attributes{};
+  attributes.qp_state = IBV_QPS_INIT;
+  attributes.pkey_index = 0;
+  attributes.port_num = device_->port();
+  attributes.qp_access_flags = kAccess;
+  if (ibv_modify_qp(pair_, &attributes,
+                    IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT |
+                      IBV_QP_ACCESS_FLAGS) != 0) {
+    const auto saved = errno;
+    ibv_destroy_qp(pair_);
+    ibv_destroy_cq(queue_);
+    errno = saved;
+    fail("Couldn't initialize an RDMA queue pair");
+  }
+
+  constexpr uint32_t kPsnMask = 0xFFFFFF;
+  endpoint_.lid = device_->portAttributes().lid;
+  endpoint_.qpn = pair_->qp_num;
+  endpoint_.psn = std::random_device{}() & kPsnMask;
+  std::memcpy(endpoint_.gid.data(), device_->gid().raw, endpoint_.gid.size());
+}
+
+RdmaSession::~RdmaSession() {
+  ibv_destroy_qp(pair_);
+  ibv_destroy_cq(queue_);
+}
+
+void RdmaSession::connect(const RdmaEndpoint& peer) {
+  const std::lock_guard lock{mutex_};
+  ibv_qp_attr attributes{};
+  attributes.qp_state = IBV_QPS_RTR;
+  attributes.path_mtu = device_->portAttributes().active_mtu;
+  attributes.dest_qp_num = peer.qpn;
+  attributes.rq_psn = peer.psn;
+  attributes.max_dest_rd_atomic = device_->reads();
+  constexpr uint8_t kMinRnrTimer = 12;
+  attributes.min_rnr_timer = kMinRnrTimer;
+  attributes.ah_attr.dlid = peer.lid;
+  attributes.ah_attr.port_num = device_->port();
+  // RoCE routes by the GID while InfiniBand subnets may use the LID alone
+  const ibv_gid empty{};
+  if (std::memcmp(peer.gid.data(), empty.raw, peer.gid.size()) != 0) {
+    constexpr uint8_t kHopLimit = 64;
+    attributes.ah_attr.is_global = 1;
+    std::memcpy(attributes.ah_attr.grh.dgid.raw, peer.gid.data(),
+                peer.gid.size());
+    attributes.ah_attr.grh.sgid_index =
+      static_cast<uint8_t>(device_->gidIndex());
+    attributes.ah_attr.grh.hop_limit = kHopLimit;
+  }
+  if (ibv_modify_qp(pair_, &attributes,
+                    IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU |
+                      IBV_QP_DEST_QPN | IBV_QP_RQ_PSN |
+                      IBV_QP_MAX_DEST_RD_ATOMIC | IBV_QP_MIN_RNR_TIMER) != 0) {
+    fail("Couldn't connect the RDMA queue pair to its peer");
+  }
+
+  constexpr uint8_t kTimeout = 14;
+  constexpr uint8_t kRetries = 7;
+  attributes = {};
+  attributes.qp_state = IBV_QPS_RTS;
+  attributes.timeout = kTimeout;
+  attributes.retry_cnt = kRetries;
+  attributes.rnr_retry = kRetries;
+  attributes.sq_psn = endpoint_.psn;
+  attributes.max_rd_atomic = device_->reads();
+  if (ibv_modify_qp(pair_, &attributes,
+                    IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT |
+                      IBV_QP_RNR_RETRY | IBV_QP_SQ_PSN |
+                      IBV_QP_MAX_QP_RD_ATOMIC) != 0) {
+    fail("Couldn't make the RDMA queue pair ready to send");
+  }
+}
+
+void RdmaSession::read(const std::vector<RdmaTransfer>& transfers,
+                       uint32_t key) {
+  this->transfer(transfers, key, true);
+}
+
+void RdmaSession::write(const std::vector<RdmaTransfer>& transfers,
+                        uint32_t key) {
+  this->transfer(transfers, key, false);
+}
+
+void RdmaSession::transfer(const std::vector<RdmaTransfer>& transfers,
+                           uint32_t key, bool read) {
+  // local memory is registered for the transfer unless all of it already is
+  std::vector<std::unique_ptr<ibv_mr, int (*)(ibv_mr*)>> registrations;
+  std::vector<ibv_sge> pieces;
+  std::vector<uint64_t> remotes;
+  for (const auto& transfer : transfers) {
+    if (transfer.size == 0) {
+      continue;
+    }
+    auto* region = device_->implicit();
+    if (region == nullptr) {
+      region = ibv_reg_mr(device_->domain(), transfer.local, transfer.size,
+                          IBV_ACCESS_LOCAL_WRITE);
+      if (region == nullptr) {
+        fail("Couldn't register memory for an RDMA transfer");
+      }
+      registrations.emplace_back(region, ibv_dereg_mr);
+    }
+    for (size_t offset = 0; offset < transfer.size;
+         offset += kMaxMessageSize) {
+      const auto size = std::min(kMaxMessageSize, transfer.size - offset);
+      pieces.push_back({reinterpret_cast<uint64_t>(transfer.local) + offset,
+                        static_cast<uint32_t>(size), region->lkey});
+      remotes.push_back(transfer.remote + offset);
+    }
+  }
+
+  const std::lock_guard lock{mutex_};
+  if (failed_) {
+    throw external_error("The RDMA session failed and must be reconnected");
+  }
+  std::vector<ibv_send_wr> requests(
+    std::min(pieces.size(), static_cast<size_t>(kQueueDepth)));
+  for (size_t first = 0; first < pieces.size(); first += requests.size()) {
+    const auto count = std::min(requests.size(), pieces.size() - first);
+    for (auto i = 0U; i < count; ++i) {
+      auto& request = requests[i];
+      request = {};
+      request.sg_list = &pieces[first + i];
+      request.num_sge = 1;
+      request.opcode = read ? IBV_WR_RDMA_READ : IBV_WR_RDMA_WRITE;
+      request.wr.rdma.remote_addr = remotes[first + i];
+      request.wr.rdma.rkey = key;
+      request.next = i + 1 < count ? &requests[i + 1] : nullptr;
+    }
+    // only the last request completes. Failed requests always do
+    requests[count - 1].send_flags = IBV_SEND_SIGNALED;
+
+    ibv_send_wr* bad = nullptr;
+    if (ibv_post_send(pair_, requests.data(), &bad) != 0) {
+      failed_ = true;
+      fail("Couldn't post an RDMA transfer");
+    }
+    ibv_wc completion{};
+    int polled = 0;
+    while ((polled = ibv_poll_cq(queue_, 1, &completion)) == 0) {
+    }
+    if (polled < 0 || completion.status != IBV_WC_SUCCESS) {
+      failed_ = true;
+      throw external_error(
+        std::string{"RDMA transfer failed: "} +
+        (polled < 0 ? "couldn't poll" : ibv_wc_status_str(completion.status)));
+    }
+  }
+}
+
+#endif  // AMDINFER_ENABLE_RDMA
+
+}  // namespace amdinfer
@@ -22,21 +22,74 @@
 #ifndef GUARD_AMDINFER_CORE_REQUEST_CONTAINER_INTERNAL
 #define GUARD_AMDINFER_CORE_REQUEST_CONTAINER_INTERNAL
 
+#include <chrono>   // for system_clock
+#include <cstddef>  // for size_t
+
 #include "amdinfer/build_options.hpp"
 #include "amdinfer/declarations.hpp"
+#include "amdinfer/util/object_pool.hpp"  // for ObjectPool
+#include "amdinfer/util/timestamps.hpp"   // for Timestamp, now
 
 namespace amdinfer {
 
 struct RequestContainer {
   InferenceRequestPtr request;
+  // time after which the request is rejected instead of being batched
+  std::chrono::system_clock::time_point deadline =
+    std::chrono::system_clock::time_point::max();
+  // samples the request counts as in a batch. Requests to endpoints that bind
+  // their inputs are split into single samples but the rest are kept whole and
+  // sent alone if they have more samples than the batch size
+  size_t samples = 1;
 #ifdef AMDINFER_ENABLE_TRACING
   TracePtr trace;
 #endif
 #ifdef AMDINFER_ENABLE_METRICS
-  std::chrono::_V2::system_clock::time_point start_time;
+  // when the server got the request, on the steady clock
+  util::Timestamp start_time;
 #endif
 };
 
+namespace detail {
+
+// released containers kept across all the servers and batchers
+constexpr size_t kMaxPooledRequestContainers = 1024;
+
+inline util::ObjectPool<RequestContainer>& requestContainerPool() {
+  // leaked so containers released during static destruction are still safe
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  static auto* pool =
+    new util::ObjectPool<RequestContainer>(kMaxPooledRequestContainers);
+  return *pool;
+}
+
+}  // namespace detail
+
+inline void RequestContainerDeleter::operator()(
+  RequestContainer* container) const {
+  *container = RequestContainer{};
+  detail::requestContainerPool().release(container);
+}
+
+/**
+ * @brief Get an empty request container, reusing a released one if there is
+ * one
+ *
+ * @return RequestContainerPtr
+ */
+inline RequestContainerPtr makeRequestContainer() {
+  RequestContainerPtr container{detail::requestContainerPool().take()};
+  if (container == nullptr) {
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    container.reset(new RequestContainer);
+  }
+#ifdef AMDINFER_ENABLE_METRICS
+  // servers that see the request earlier overwrite this with their own time
+  container->start_time = util::now();
+#endif
+  return container;
+}
+
 }  // namespace amdinfer
 
 #endif  // GUARD_AMDINFER_CORE_REQUEST_CONTAINER_INTERNAL
@@ -0,0 +1,127 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the CPU time and copies that the server spends on each
+ * request
+ */
+
+#include "amdinfer/core/request_usage.hpp"
+
+#include <time.h>  // for clock_gettime, CLOCK_THREAD_CPUTIME_ID
+
+#include <utility>  // for move
+
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/observation/metrics.hpp"     // for Metrics
+
+namespace amdinfer {
+
+std::chrono::nanoseconds getThreadCpuTime() {
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds(time.tv_sec) +
+         std::chrono::nanoseconds(time.tv_nsec);
+}
+
+UsageMeter::UsageMeter(bool enabled) : enabled_(enabled) {
+  if (enabled_) {
+    cpu_time_ = getThreadCpuTime();
+    copied_bytes_ = detail::copied_bytes;
+  }
+}
+
+std::chrono::nanoseconds UsageMeter::getCpuTime() const {
+  if (!enabled_) {
+    return std::chrono::nanoseconds{0};
+  }
+  return getThreadCpuTime() - cpu_time_;
+}
+
+uint64_t UsageMeter::getCopiedBytes() const {
+  if (!enabled_) {
+    return 0;
+  }
+  return detail::copied_bytes - copied_bytes_;
+}
+
+RequestUsage::RequestUsage(std::string model, std::string tenant)
+  : model_(std::move(model)), tenant_(std::move(tenant)) {}
+
+RequestUsage::~RequestUsage() {
+#ifdef AMDINFER_ENABLE_METRICS
+  constexpr std::array kCpuTime{
+    MetricCounterIDs::CpuTimeDecode, MetricCounterIDs::CpuTimeBatch,
+    MetricCounterIDs::CpuTimeCompute, MetricCounterIDs::CpuTimeEncode};
+  constexpr std::array kCopiedBytes{
+    MetricCounterIDs::CopiedBytesDecode, MetricCounterIDs::CopiedBytesBatch,
+    MetricCounterIDs::CopiedBytesCompute, MetricCounterIDs::CopiedBytesEncode};
+  static_assert(kCpuTime.size() == Count && kCopiedBytes.size() == Count);
+
+  MetricLabels labels{{"model", model_}};
+  if (!tenant_.empty()) {
+    labels.emplace("tenant", tenant_);
+  }
+  auto& metrics = Metrics::getInstance();
+  for (auto i = 0U; i < Count; ++i) {
+    const auto stage = static_cast<Stage>(i);
+    // rounded so short stages aren't all counted as nothing
+    const auto microseconds = (this->getCpuTime(stage).count() + 500) / 1000;
+    if (microseconds > 0) {
+      metrics.incrementCounter(kCpuTime.at(i), labels,
+                               static_cast<size_t>(microseconds));
+    }
+    if (const auto bytes = this->getCopiedBytes(stage); bytes > 0) {
+      metrics.incrementCounter(kCopiedBytes.at(i), labels, bytes);
+    }
+  }
+#endif
+}
+
+void RequestUsage::add(Stage stage, std::chrono::nanoseconds cpu_time,
+                       uint64_t bytes) {
+  cpu_time_.at(stage).fetch_add(cpu_time.count(), std::memory_order_relaxed);
+  copied_bytes_.at(stage).fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RequestUsage::add(Stage stage, const UsageMeter& meter) {
+  this->add(stage, meter.getCpuTime(), meter.getCopiedBytes());
+}
+
+std::chrono::nanoseconds RequestUsage::getCpuTime(Stage stage) const {
+  return std::chrono::nanoseconds{
+    cpu_time_.at(stage).load(std::memory_order_relaxed)};
+}
+
+uint64_t RequestUsage::getCopiedBytes(Stage stage) const {
+  return copied_bytes_.at(stage).load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<RequestUsage> startRequestUsage(InferenceRequest* request,
+                                                const UsageMeter& decoded,
+                                                std::string model,
+                                                std::string tenant) {
+  if (!decoded.enabled()) {
+    return nullptr;
+  }
+  auto usage =
+    std::make_shared<RequestUsage>(std::move(model), std::move(tenant));
+  usage->add(RequestUsage::Decode, decoded);
+  request->setUsage(usage);
+  return usage;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,169 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the CPU time and copies that the server spends on each
+ * request
+ */
+
+#ifndef GUARD_AMDINFER_CORE_REQUEST_USAGE
+#define GUARD_AMDINFER_CORE_REQUEST_USAGE
+
+#include <array>    // for array
+#include <atomic>   // for atomic
+#include <chrono>   // for nanoseconds
+#include <cstddef>  // for size_t
+#include <cstdint>  // for int64_t, uint64_t
+#include <memory>   // for shared_ptr
+#include <string>   // for string
+
+namespace amdinfer {
+
+class InferenceRequest;
+
+namespace detail {
+// bytes that each thread has copied. It only grows so meters take differences
+inline thread_local uint64_t copied_bytes = 0;
+}  // namespace detail
+
+/**
+ * @brief Count bytes that the calling thread copied on behalf of a request.
+ * It's cheap enough to call on every copy whether or not usage is measured
+ *
+ * @param bytes the number of bytes copied
+ */
+inline void countCopy(size_t bytes) { detail::copied_bytes += bytes; }
+
+/// Get the CPU time that the calling thread has used
+std::chrono::nanoseconds getThreadCpuTime();
+
+/**
+ * @brief Measures the CPU time that the calling thread uses, and the bytes it
+ * copies, from when the meter is made. Reading the thread's CPU clock is a
+ * system call so disabled meters don't read it.
+ */
+class UsageMeter {
+ public:
+  /**
+   * @brief Start measuring
+   *
+   * @param enabled false to measure nothing
+   */
+  explicit UsageMeter(bool enabled = true);
+
+  /// Check if the meter is measuring
+  [[nodiscard]] bool enabled() const { return enabled_; }
+  /// Get the CPU time that the thread used since the meter was made
+  [[nodiscard]] std::chrono::nanoseconds getCpuTime() const;
+  /// Get the bytes that the thread copied since the meter was made
+  [[nodiscard]] uint64_t getCopiedBytes() const;
+
+ private:
+  bool enabled_;
+  std::chrono::nanoseconds cpu_time_{0};
+  uint64_t copied_bytes_ = 0;
+};
+
+/**
+ * @brief The CPU time and bytes copied that the server spent on one request
+ * in each stage. It's labelled with the request's endpoint and tenant and
+ * added to the metrics when the last reference to it is dropped, after the
+ * response is serialized. Stages are added to by whichever thread has the
+ * request at the time, including workers that split a batch's time between
+ * its requests, so the totals are atomic.
+ */
+class RequestUsage {
+ public:
+  enum Stage {
+    Decode,   ///< parsing the request and copying its inputs
+    Batch,    ///< adding the request to a batch
+    Compute,  ///< the request's share of running its batch
+    Encode,   ///< serializing the response
+    Count
+  };
+
+  /**
+   * @brief Construct a new RequestUsage object
+   *
+   * @param model the endpoint that the request was sent to
+   * @param tenant the request's tenant or empty if it has none
+   */
+  RequestUsage(std::string model, std::string tenant);
+  ~RequestUsage();
+  RequestUsage(RequestUsage const&) = delete;
+  RequestUsage& operator=(const RequestUsage&) = delete;
+  RequestUsage(RequestUsage&& other) = delete;
+  RequestUsage& operator=(RequestUsage&& other) = delete;
+
+  /// Add CPU time and copied bytes to a stage
+  void add(Stage stage, std::chrono::nanoseconds cpu_time, uint64_t bytes);
+  /// Add what a meter measured to a stage
+  void add(Stage stage, const UsageMeter& meter);
+
+  /// Get the CPU time spent in a stage
+  [[nodiscard]] std::chrono::nanoseconds getCpuTime(Stage stage) const;
+  /// Get the bytes copied in a stage
+  [[nodiscard]] uint64_t getCopiedBytes(Stage stage) const;
+
+ private:
+  std::string model_;
+  std::string tenant_;
+  std::array<std::atomic<int64_t>, Count> cpu_time_{};
+  std::array<std::atomic<uint64_t>, Count> copied_bytes_{};
+};
+
+/**
+ * @brief Adds the CPU time and copies of the calling thread to a stage of a
+ * request's usage until it goes out of scope. It does nothing if the usage is
+ * null.
+ */
+class UsageScope {
+ public:
+  UsageScope(RequestUsage* usage, RequestUsage::Stage stage)
+    : usage_(usage), stage_(stage), meter_(usage != nullptr) {}
+  ~UsageScope() {
+    if (usage_ != nullptr) {
+      usage_->add(stage_, meter_);
+    }
+  }
+  UsageScope(UsageScope const&) = delete;
+  UsageScope& operator=(const UsageScope&) = delete;
+  UsageScope(UsageScope&& other) = delete;
+  UsageScope& operator=(UsageScope&& other) = delete;
+
+ private:
+  RequestUsage* usage_;
+  RequestUsage::Stage stage_;
+  UsageMeter meter_;
+};
+
+/**
+ * @brief Start accounting for a request's usage if the meter that measured
+ * its decoding is enabled
+ *
+ * @param request the request
+ * @param decoded the meter started before the request was decoded
+ * @param model the endpoint that the request was sent to
+ * @param tenant the request's tenant or empty if it has none
+ * @return std::shared_ptr<RequestUsage> the usage or nullptr
+ */
+std::shared_ptr<RequestUsage> startRequestUsage(InferenceRequest* request,
+                                                const UsageMeter& decoded,
+                                                std::string model,
+                                                std::string tenant);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_REQUEST_USAGE
@@ -0,0 +1,193 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the cache of inference responses
+ */
+
+#include "amdinfer/core/response_cache.hpp"
+
+#include <cstddef>      // for byte
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <type_traits>  // for decay_t, is_same_v
+#include <utility>      // for move
+#include <variant>      // for visit
+#include <vector>       // for vector
+
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+#include "amdinfer/observation/metrics.hpp"     // for Metrics, MetricCount...
+#include "amdinfer/util/hash.hpp"               // for Hasher
+
+namespace amdinfer {
+
+namespace {
+
+// bookkeeping cost of an item on top of its output data
+constexpr size_t kItemOverhead =
+  sizeof(InferenceResponse) + (4 * sizeof(void*));
+
+void hashParameters(const ParameterMap& parameters, util::Hasher* hasher) {
+  hasher->update(parameters.size());
+  for (const auto& [key, value] : parameters) {
+    hasher->update(key);
+    hasher->update(value.index());
+    std::visit(
+      [hasher](const auto& arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+          hasher->update(std::string_view{arg});
+        } else {
+          hasher->update(arg);
+        }
+      },
+      value);
+  }
+}
+
+size_t dataSize(const InferenceResponseOutput& output) {
+  return output.getSize() * output.getDatatype().size();
+}
+
+}  // namespace
+
+ResponseCache::ResponseCache(size_t budget) : budget_(budget) {}
+
+uint64_t ResponseCache::key(const InferenceRequest& request) {
+  util::Hasher hasher;
+  const auto& inputs = request.getInputs();
+  hasher.update(inputs.size());
+  for (const auto& input : inputs) {
+    hasher.update(input.getName());
+    hasher.update(static_cast<DataType::Value>(input.getDatatype()));
+    const auto& shape = input.getShape();
+    hasher.update(shape.size());
+    hasher.update(shape.data(), shape.size() * sizeof(int64_t));
+    hashParameters(input.getParameters(), &hasher);
+    const auto size = input.getSize() * input.getDatatype().size();
+    hasher.update(size);
+    hasher.update(input.getData(), size);
+  }
+
+  const auto& outputs = request.getOutputs();
+  hasher.update(outputs.size());
+  for (const auto& output : outputs) {
+    hasher.update(output.getName());
+  }
+
+  hashParameters(request.getParameters(), &hasher);
+  return hasher.digest();
+}
+
+std::optional<InferenceResponse> ResponseCache::lookup(uint64_t key) {
+  std::shared_ptr<const InferenceResponse> cached;
+  {
+    const std::lock_guard lock{mutex_};
+    if (auto found = index_.find(key); found != index_.end()) {
+      items_.splice(items_.begin(), items_, found->second);
+      cached = found->second->response;
+    }
+  }
+
+  if (cached == nullptr) {
+#ifdef AMDINFER_ENABLE_METRICS
+    Metrics::getInstance().incrementCounter(
+      MetricCounterIDs::ResponseCacheMisses);
+#endif
+    return std::nullopt;
+  }
+#ifdef AMDINFER_ENABLE_METRICS
+  Metrics::getInstance().incrementCounter(MetricCounterIDs::ResponseCacheHits);
+#endif
+
+  // the outputs view the cached data and keep it alive even if it's evicted
+  InferenceResponse response;
+  response.setModel(cached->getModel());
+  for (const auto& output : cached->getOutputs()) {
+    InferenceResponseOutput view;
+    view.setName(output.getName());
+    view.setDatatype(output.getDatatype());
+    view.setShape(output.getShape());
+    view.setParameters(output.getParameters());
+    view.setData(output.getData(), dataSize(output), cached);
+    response.addOutput(std::move(view));
+  }
+  return response;
+}
+
+void ResponseCache::insert(uint64_t key, const InferenceResponse& response) {
+  if (response.isError()) {
+    return;
+  }
+
+  size_t bytes = kItemOverhead + response.getModel().size();
+  for (const auto& output : response.getOutputs()) {
+    bytes += sizeof(InferenceResponseOutput) + output.getName().size() +
+             (output.getShape().size() * sizeof(int64_t)) + dataSize(output);
+  }
+  if (bytes > budget_) {
+    return;
+  }
+
+  // copy the data so the cache doesn't hold on to the memory it was viewing,
+  // which may be a pooled buffer
+  auto cached = std::make_shared<InferenceResponse>();
+  cached->setModel(response.getModel());
+  for (const auto& output : response.getOutputs()) {
+    InferenceResponseOutput copy;
+    copy.setName(output.getName());
+    copy.setDatatype(output.getDatatype());
+    copy.setShape(output.getShape());
+    copy.setParameters(output.getParameters());
+    const auto* data = static_cast<const std::byte*>(output.getData());
+    copy.setData(std::vector<std::byte>{data, data + dataSize(output)});
+    cached->addOutput(std::move(copy));
+  }
+
+  [[maybe_unused]] size_t evictions = 0;
+  {
+    const std::lock_guard lock{mutex_};
+    if (index_.find(key) != index_.end()) {
+      // a concurrent identical request already cached it
+      return;
+    }
+    while (size_ + bytes > budget_) {
+      const auto& oldest = items_.back();
+      size_ -= oldest.bytes;
+      index_.erase(oldest.key);
+      items_.pop_back();
+      evictions++;
+    }
+    items_.push_front(Item{key, std::move(cached), bytes});
+    index_.try_emplace(key, items_.begin());
+    size_ += bytes;
+  }
+
+#ifdef AMDINFER_ENABLE_METRICS
+  if (evictions > 0) {
+    Metrics::getInstance().incrementCounter(
+      MetricCounterIDs::ResponseCacheEvictions, evictions);
+  }
+#endif
+}
+
+size_t ResponseCache::size() const {
+  const std::lock_guard lock{mutex_};
+  return size_;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,95 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a cache of inference responses for repeated requests
+ */
+
+#ifndef GUARD_AMDINFER_CORE_RESPONSE_CACHE
+#define GUARD_AMDINFER_CORE_RESPONSE_CACHE
+
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint64_t
+#include <list>           // for list
+#include <memory>         // for shared_ptr
+#include <mutex>          // for mutex
+#include <optional>       // for optional
+#include <unordered_map>  // for unordered_map
+
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+
+namespace amdinfer {
+
+class InferenceRequest;
+
+/**
+ * @brief Caches the responses of one endpoint, keyed by a hash of the request
+ * inputs, the requested outputs and the request parameters. Entries are
+ * evicted in least-recently-used order to keep the cached output data within
+ * a memory budget. Each endpoint version has its own cache so a new version
+ * never sees responses from an old one.
+ */
+class ResponseCache {
+ public:
+  /**
+   * @brief Construct a new ResponseCache object
+   *
+   * @param budget most bytes of response data to keep cached
+   */
+  explicit ResponseCache(size_t budget);
+
+  /// Get the key that identifies identical requests
+  static uint64_t key(const InferenceRequest& request);
+
+  /**
+   * @brief Look up a cached response. The returned response's outputs view the
+   * cached data so a hit doesn't copy it.
+   *
+   * @param key the request's key
+   * @return std::optional<InferenceResponse> the response if it's cached
+   */
+  std::optional<InferenceResponse> lookup(uint64_t key);
+
+  /**
+   * @brief Cache a copy of a response, evicting older ones to make room. Error
+   * responses and those larger than the budget aren't cached.
+   *
+   * @param key the request's key
+   * @param response the response to cache
+   */
+  void insert(uint64_t key, const InferenceResponse& response);
+
+  /// Get the bytes currently cached
+  [[nodiscard]] size_t size() const;
+
+ private:
+  struct Item {
+    uint64_t key;
+    std::shared_ptr<const InferenceResponse> response;
+    size_t bytes;
+  };
+  using List = std::list<Item>;
+
+  const size_t budget_;
+  mutable std::mutex mutex_;
+  size_t size_ = 0;
+  /// Most recently used items first
+  List items_;
+  std::unordered_map<uint64_t, List::iterator> index_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_RESPONSE_CACHE
@@ -0,0 +1,92 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the times that a request spends in each stage of the
+ * server
+ */
+
+#include "amdinfer/core/server_timing.hpp"
+
+#include <array>    // for array
+#include <chrono>   // for duration, duration_cast
+#include <cstdio>   // for snprintf
+#include <ratio>    // for milli
+#include <utility>  // for move
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+
+namespace amdinfer {
+
+namespace {
+
+/// Add a stage's duration in milliseconds to a Server-Timing value
+void addStage(std::string* value, const char* name,
+              std::chrono::nanoseconds duration) {
+  const auto milliseconds =
+    std::chrono::duration<double, std::milli>(duration).count();
+  // enough for the name and any duration
+  constexpr size_t kSize = 64;
+  std::array<char, kSize> entry{};
+  std::snprintf(entry.data(), entry.size(), "%s%s;dur=%.3f",
+                value->empty() ? "" : ", ", name, milliseconds);
+  value->append(entry.data());
+}
+
+}  // namespace
+
+std::string ServerTiming::str() const {
+  const auto has = [this](Stage stage) {
+    return times_.get(stage) != util::Timestamp{};
+  };
+  const auto between = [this](Stage from, Stage to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      times_.get(to) - times_.get(from));
+  };
+
+  std::string value;
+  if (has(Received) && has(Decoded)) {
+    addStage(&value, "decode", between(Received, Decoded));
+  }
+  if (has(Decoded) && has(Batched) && has(Dispatched) && has(Started)) {
+    addStage(&value, "queue",
+             between(Decoded, Batched) + between(Dispatched, Started));
+    addStage(&value, "batch", between(Batched, Dispatched));
+  }
+  if (has(Started) && has(Responded)) {
+    addStage(&value, "compute", between(Started, Responded));
+  }
+  if (has(Responded) && has(Serialized)) {
+    addStage(&value, "serialize", between(Responded, Serialized));
+  }
+  return value;
+}
+
+std::shared_ptr<ServerTiming> startServerTiming(InferenceRequest* request,
+                                                util::Timestamp received) {
+  const auto& parameters = request->getParameters();
+  if (!parameters.has(kServerTiming) ||
+      !parameters.get<bool>(kServerTiming)) {
+    return nullptr;
+  }
+  auto timing = std::make_shared<ServerTiming>();
+  timing->mark(ServerTiming::Received, received);
+  timing->mark(ServerTiming::Decoded);
+  request->setServerTiming(timing);
+  return timing;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,90 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the times that a request spends in each stage of the server
+ */
+
+#ifndef GUARD_AMDINFER_CORE_SERVER_TIMING
+#define GUARD_AMDINFER_CORE_SERVER_TIMING
+
+#include <memory>       // for shared_ptr
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "amdinfer/util/timestamps.hpp"  // for Timestamps, Timestamp
+
+namespace amdinfer {
+
+class InferenceRequest;
+
+/// Request parameter that asks for the times spent in each stage
+constexpr std::string_view kServerTiming = "server_timing";
+/// HTTP header and gRPC trailing metadata key of the times
+constexpr std::string_view kServerTimingHeader = "server-timing";
+
+/**
+ * @brief The times at which a request reached each stage of the server. It's
+ * only kept for requests that ask for it with the "server_timing" parameter so
+ * other requests don't pay for it. Each stage is marked by the one thread that
+ * has the request at the time so it needs no locking.
+ */
+class ServerTiming {
+ public:
+  enum Stage {
+    Received,    ///< the server got the request
+    Decoded,     ///< the request was decoded and sent to its endpoint
+    Batched,     ///< the batcher added the request to a batch
+    Dispatched,  ///< the batcher sent the batch to the workers
+    Started,     ///< a worker took the batch
+    Responded,   ///< the worker ran the request's callback
+    Serialized,  ///< the server serialized the response
+    Count
+  };
+
+  /// Mark that the request reached a stage now
+  void mark(Stage stage) { times_.mark(stage); }
+  /// Mark that the request reached a stage at a time
+  void mark(Stage stage, util::Timestamp time) { times_.mark(stage, time); }
+
+  /**
+   * @brief Get the durations of the stages in the Server-Timing format, e.g.
+   * "decode;dur=0.1, queue;dur=0.2, batch;dur=4.1, compute;dur=2.5,
+   * serialize;dur=0.3" in milliseconds. The time spent waiting in the
+   * batcher's queue and for a worker are both queueing. Stages that the
+   * request skipped, such as batching for cached responses, are left out.
+   *
+   * @return std::string
+   */
+  [[nodiscard]] std::string str() const;
+
+ private:
+  util::Timestamps<Stage> times_;
+};
+
+/**
+ * @brief Start timing a request if it asks for it with the "server_timing"
+ * parameter
+ *
+ * @param request the request
+ * @param received when the server got the request
+ * @return std::shared_ptr<ServerTiming> the timing or nullptr
+ */
+std::shared_ptr<ServerTiming> startServerTiming(InferenceRequest* request,
+                                                util::Timestamp received);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_SERVER_TIMING
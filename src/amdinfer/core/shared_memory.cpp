@@ -0,0 +1,162 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the system shared memory that clients on the same host as
+ * the server can use to pass tensors without sending their data
+ */
+
+#include "amdinfer/core/shared_memory.hpp"
+
+#include <fcntl.h>     // for O_CREAT, O_RDWR, O_EXCL
+#include <sys/mman.h>  // for mmap, munmap, shm_open, shm_unlink
+#include <sys/stat.h>  // for fstat, struct stat
+#include <unistd.h>    // for close, ftruncate, sysconf
+
+#include <cerrno>   // for errno
+#include <cmath>    // for floor
+#include <cstdint>  // for int32_t
+#include <cstring>  // for strerror
+#include <limits>   // for numeric_limits
+#include <utility>  // for move
+#include <variant>  // for get_if
+
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequestInput
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+
+namespace amdinfer {
+
+SystemSharedMemory::SystemSharedMemory(const std::string& key,
+                                       size_t byte_size, size_t offset,
+                                       bool create)
+  : key_(key), size_(byte_size), created_(create) {
+  if (byte_size == 0) {
+    throw invalid_argument("Shared memory region " + key + " can't be empty");
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+  const int file_descriptor = create
+                                ? shm_open(key.c_str(), O_CREAT | O_RDWR, 0600)
+                                : shm_open(key.c_str(), O_RDWR, 0);
+  if (file_descriptor < 0) {
+    const std::string error = std::strerror(errno);
+    if (create) {
+      throw external_error("Could not create shared memory " + key + ": " +
+                           error);
+    }
+    throw invalid_argument("Could not open shared memory " + key + ": " +
+                           error);
+  }
+
+  if (create) {
+    if (ftruncate(file_descriptor, static_cast<off_t>(offset + byte_size)) !=
+        0) {
+      const std::string error = std::strerror(errno);
+      close(file_descriptor);
+      shm_unlink(key.c_str());
+      throw external_error("Could not size shared memory " + key + ": " +
+                           error);
+    }
+  } else {
+    struct stat status {};
+    if (fstat(file_descriptor, &status) != 0 ||
+        static_cast<size_t>(status.st_size) < offset + byte_size) {
+      close(file_descriptor);
+      throw invalid_argument("Shared memory " + key + " is smaller than " +
+                             std::to_string(offset + byte_size) + " bytes");
+    }
+  }
+
+  // mappings start at a page boundary so the start of the region is rounded
+  // down to one
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const auto mapping_offset = offset - (offset % page_size);
+  mapping_size_ = byte_size + (offset - mapping_offset);
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  file_descriptor, static_cast<off_t>(mapping_offset));
+  // the mapping stays valid after the descriptor is closed
+  close(file_descriptor);
+  if (mapping_ == MAP_FAILED) {
+    const std::string error = std::strerror(errno);
+    if (create) {
+      shm_unlink(key.c_str());
+    }
+    throw external_error("Could not map shared memory " + key + ": " + error);
+  }
+  data_ = static_cast<std::byte*>(mapping_) + (offset - mapping_offset);
+}
+
+SystemSharedMemory::~SystemSharedMemory() {
+  munmap(mapping_, mapping_size_);
+  if (created_) {
+    shm_unlink(key_.c_str());
+  }
+}
+
+void useSharedMemory(InferenceRequestInput* input, const std::string& region,
+                     size_t offset) {
+  auto parameters = input->getParameters();
+  parameters.put(kSharedMemoryRegion, region);
+  setSharedMemorySize(&parameters, kSharedMemoryOffset, offset);
+  setSharedMemorySize(&parameters, kSharedMemoryByteSize,
+                      input->getSize() * input->getDatatype().size());
+  input->setParameters(std::move(parameters));
+  input->setData(nullptr);
+}
+
+void useSharedMemory(InferenceRequestOutput* output, const std::string& region,
+                     size_t byte_size, size_t offset) {
+  auto parameters = output->getParameters();
+  parameters.put(kSharedMemoryRegion, region);
+  setSharedMemorySize(&parameters, kSharedMemoryOffset, offset);
+  setSharedMemorySize(&parameters, kSharedMemoryByteSize, byte_size);
+  output->setParameters(std::move(parameters));
+}
+
+bool isInSharedMemory(const ParameterMap& parameters) {
+  return parameters.has(kSharedMemoryRegion);
+}
+
+size_t getSharedMemorySize(const ParameterMap& parameters,
+                           const std::string& key) {
+  for (const auto& [name, value] : parameters) {
+    if (name != key) {
+      continue;
+    }
+    if (const auto* integer = std::get_if<int32_t>(&value);
+        integer != nullptr && *integer >= 0) {
+      return static_cast<size_t>(*integer);
+    }
+    // values too large for 32 bits are sent as doubles
+    if (const auto* number = std::get_if<double>(&value);
+        number != nullptr && *number >= 0 && *number == std::floor(*number)) {
+      return static_cast<size_t>(*number);
+    }
+    throw invalid_argument("'" + key + "' must be a non-negative integer");
+  }
+  return 0;
+}
+
+void setSharedMemorySize(ParameterMap* parameters, const std::string& key,
+                         size_t value) {
+  if (value <= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    parameters->put(key, static_cast<int32_t>(value));
+  } else {
+    parameters->put(key, static_cast<double>(value));
+  }
+}
+
+}  // namespace amdinfer
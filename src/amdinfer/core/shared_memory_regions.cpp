@@ -0,0 +1,357 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the system shared memory regions registered with the
+ * server
+ */
+
+#include "amdinfer/core/shared_memory_regions.hpp"
+
+#include <algorithm>  // for find_if
+#include <cstring>    // for memcpy
+#include <mutex>      // for unique_lock, shared_lock
+#include <string>     // for string
+#include <utility>    // for move, pair
+#include <variant>    // for bad_variant_access
+#include <vector>     // for vector
+
+#include "amdinfer/buffers/buffer.hpp"           // for Buffer
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/rdma.hpp"                // for RdmaSession
+
+namespace amdinfer {
+
+namespace {
+
+std::string getRegion(const ParameterMap& parameters) {
+  try {
+    return parameters.get<std::string>(kSharedMemoryRegion);
+  } catch (const std::bad_variant_access&) {
+    throw invalid_argument("'shared_memory_region' must be a string");
+  }
+}
+
+/// Copy the data of an output to its region
+void place(const SharedMemoryTensors::Output& target, void* data,
+           size_t bytes) {
+#ifdef AMDINFER_ENABLE_RDMA
+  if (target.rdma != nullptr) {
+    target.rdma->session->write({{data, target.address, bytes}},
+                                target.rdma->key);
+    return;
+  }
+#endif
+  std::memcpy(target.data.get(), data, bytes);
+}
+
+/// Write the outputs that are in shared memory to their regions
+InferenceResponse writeOutputs(
+  const InferenceResponse& response,
+  const std::vector<SharedMemoryTensors::Output>& targets) {
+  auto written = response;
+  auto outputs = std::move(written).getOutputs();
+  for (auto& output : outputs) {
+    const auto target =
+      std::find_if(targets.begin(), targets.end(), [&output](const auto& t) {
+        return t.name == output.getName();
+      });
+    if (target == targets.end()) {
+      written.addOutput(std::move(output));
+      continue;
+    }
+
+    const auto bytes = output.getSize() * output.getDatatype().size();
+    if (bytes > target->byte_size) {
+      return InferenceResponse{"Output " + output.getName() + " has " +
+                               std::to_string(bytes) + " bytes but only " +
+                               std::to_string(target->byte_size) +
+                               " fit in its shared memory region"};
+    }
+    try {
+      place(*target, output.getData(), bytes);
+    } catch (const external_error& e) {
+      return InferenceResponse{e.what()};
+    }
+
+    // the response only says where the output was written
+    InferenceResponseOutput placeholder;
+    placeholder.setName(output.getName());
+    placeholder.setDatatype(output.getDatatype());
+    placeholder.setShape(output.getShape());
+    ParameterMap parameters;
+    parameters.put(kSharedMemoryRegion, target->region);
+    setSharedMemorySize(&parameters, kSharedMemoryOffset, target->offset);
+    setSharedMemorySize(&parameters, kSharedMemoryByteSize, bytes);
+    placeholder.setParameters(std::move(parameters));
+    written.addOutput(std::move(placeholder));
+  }
+  return written;
+}
+
+}  // namespace
+
+void SharedMemoryRegions::add(const std::string& name, const std::string& key,
+                              size_t offset, size_t byte_size) {
+  if (name.empty()) {
+    throw invalid_argument("A shared memory region needs a name");
+  }
+  {
+    const std::shared_lock lock{mutex_};
+    if (regions_.find(name) != regions_.end()) {
+      throw invalid_argument("Shared memory region " + name +
+                             " is already registered");
+    }
+  }
+
+  // the object is mapped outside the lock since it's a system call
+  Region region;
+  region.status = {name, key, offset, byte_size};
+  region.memory =
+    std::make_shared<SystemSharedMemory>(key, byte_size, offset, false);
+  const std::unique_lock lock{mutex_};
+  const auto [_, added] = regions_.try_emplace(name, std::move(region));
+  if (!added) {
+    throw invalid_argument("Shared memory region " + name +
+                           " is already registered");
+  }
+}
+
+std::string SharedMemoryRegions::connectRdma(
+  [[maybe_unused]] const std::string& session,
+  [[maybe_unused]] const std::string& endpoint) {
+#ifdef AMDINFER_ENABLE_RDMA
+  if (session.empty()) {
+    throw invalid_argument("An RDMA session needs a name");
+  }
+  const auto peer = RdmaEndpoint::parse(endpoint);
+  // regions registered over an earlier session with this name keep using it
+  auto connected = std::make_shared<RdmaSession>();
+  connected->connect(peer);
+  auto local = connected->getEndpoint().serialize();
+  const std::unique_lock lock{mutex_};
+  sessions_[session] = std::move(connected);
+  return local;
+#else
+  throw external_error("RDMA is not enabled in this server");
+#endif
+}
+
+void SharedMemoryRegions::addRdma([[maybe_unused]] const std::string& name,
+                                  [[maybe_unused]] const std::string& session,
+                                  [[maybe_unused]] uint64_t address,
+                                  [[maybe_unused]] uint32_t key,
+                                  [[maybe_unused]] size_t byte_size) {
+#ifdef AMDINFER_ENABLE_RDMA
+  if (name.empty()) {
+    throw invalid_argument("A shared memory region needs a name");
+  }
+  const std::unique_lock lock{mutex_};
+  auto found = sessions_.find(session);
+  if (found == sessions_.end()) {
+    throw invalid_argument("RDMA session " + session + " is not connected");
+  }
+  Region region;
+  region.status = {name, "rdma:" + session, 0, byte_size};
+  region.rdma =
+    std::make_shared<RdmaRegion>(RdmaRegion{found->second, address, key});
+  const auto [_, added] = regions_.try_emplace(name, std::move(region));
+  if (!added) {
+    throw invalid_argument("Shared memory region " + name +
+                           " is already registered");
+  }
+#else
+  throw external_error("RDMA is not enabled in this server");
+#endif
+}
+
+void SharedMemoryRegions::remove(const std::string& name) {
+  const std::unique_lock lock{mutex_};
+  if (name.empty()) {
+    regions_.clear();
+    return;
+  }
+  if (regions_.erase(name) == 0) {
+    throw invalid_argument("Shared memory region " + name +
+                           " is not registered");
+  }
+}
+
+std::vector<SharedMemoryStatus> SharedMemoryRegions::status(
+  const std::string& name) const {
+  const std::shared_lock lock{mutex_};
+  std::vector<SharedMemoryStatus> statuses;
+  if (name.empty()) {
+    statuses.reserve(regions_.size());
+    for (const auto& [_, region] : regions_) {
+      statuses.push_back(region.status);
+    }
+    return statuses;
+  }
+  auto found = regions_.find(name);
+  if (found == regions_.end()) {
+    throw invalid_argument("Shared memory region " + name +
+                           " is not registered");
+  }
+  statuses.push_back(found->second.status);
+  return statuses;
+}
+
+SharedMemoryTensors SharedMemoryRegions::map(InferenceRequest* request,
+                                             const MemoryPool* pool) const {
+  SharedMemoryTensors tensors;
+  std::vector<size_t> indices;
+#ifdef AMDINFER_ENABLE_RDMA
+  // inputs in a peer's memory are read once all the regions are found
+  std::vector<std::pair<size_t, Location>> reads;
+#endif
+  const auto& inputs = request->getInputs();
+  for (auto i = 0U; i < inputs.size(); ++i) {
+    const auto& input = inputs[i];
+    const auto& parameters = input.getParameters();
+    if (!isInSharedMemory(parameters)) {
+      continue;
+    }
+    const auto bytes = input.getSize() * input.getDatatype().size();
+    if (parameters.has(kSharedMemoryByteSize) &&
+        getSharedMemorySize(parameters, kSharedMemoryByteSize) != bytes) {
+      throw invalid_argument("'shared_memory_byte_size' of input " +
+                             input.getName() +
+                             " does not match its shape and datatype");
+    }
+    auto location =
+      this->get(getRegion(parameters),
+                getSharedMemorySize(parameters, kSharedMemoryOffset), bytes);
+#ifdef AMDINFER_ENABLE_RDMA
+    if (location.rdma != nullptr) {
+      reads.emplace_back(i, std::move(location));
+      continue;
+    }
+#endif
+    tensors.inputs.push_back(std::move(location.data));
+    indices.push_back(i);
+  }
+
+  for (const auto& output : request->getOutputs()) {
+    const auto& parameters = output.getParameters();
+    if (!isInSharedMemory(parameters)) {
+      continue;
+    }
+    SharedMemoryTensors::Output target;
+    target.name = output.getName();
+    target.region = getRegion(parameters);
+    target.offset = getSharedMemorySize(parameters, kSharedMemoryOffset);
+    target.byte_size = getSharedMemorySize(parameters, kSharedMemoryByteSize);
+    if (target.byte_size == 0) {
+      throw invalid_argument("Output " + target.name +
+                             " needs 'shared_memory_byte_size'");
+    }
+    auto location = this->get(target.region, target.offset, target.byte_size);
+    target.data = std::move(location.data);
+#ifdef AMDINFER_ENABLE_RDMA
+    target.rdma = std::move(location.rdma);
+    target.address = location.address;
+#endif
+    tensors.outputs.push_back(std::move(target));
+  }
+
+#ifdef AMDINFER_ENABLE_RDMA
+  // the inputs are read into memory from the pool, which is put back as usual
+  std::vector<void*> buffers;
+  try {
+    for (const auto& [index, location] : reads) {
+      const auto& input = inputs[index];
+      auto buffer = pool->get({MemoryAllocators::Cpu}, input, 1);
+      auto* data = buffers.emplace_back(buffer->data(0));
+      const auto bytes = input.getSize() * input.getDatatype().size();
+      location.rdma->session->read({{data, location.address, bytes}},
+                                   location.rdma->key);
+    }
+  } catch (...) {
+    for (auto* buffer : buffers) {
+      pool->put(MemoryAllocators::Cpu, buffer);
+    }
+    throw;
+  }
+#endif
+
+  // the request is only changed once all of its regions are found
+  for (auto i = 0U; i < indices.size(); ++i) {
+    auto* data = tensors.inputs[i].get();
+    pool->borrow(data);
+    request->setInputTensorData(indices[i], data);
+  }
+#ifdef AMDINFER_ENABLE_RDMA
+  for (auto i = 0U; i < reads.size(); ++i) {
+    request->setInputTensorData(reads[i].first, buffers[i]);
+  }
+#endif
+  return tensors;
+}
+
+SharedMemoryRegions::Location SharedMemoryRegions::get(const std::string& name,
+                                                       size_t offset,
+                                                       size_t byte_size) const {
+  const std::shared_lock lock{mutex_};
+  auto found = regions_.find(name);
+  if (found == regions_.end()) {
+    throw invalid_argument("Shared memory region " + name +
+                           " is not registered");
+  }
+  const auto& region = found->second;
+  if (offset > region.status.byte_size ||
+      byte_size > region.status.byte_size - offset) {
+    throw invalid_argument("A tensor of " + std::to_string(byte_size) +
+                           " bytes at offset " + std::to_string(offset) +
+                           " doesn't fit in shared memory region " + name);
+  }
+  Location location;
+#ifdef AMDINFER_ENABLE_RDMA
+  if (region.rdma != nullptr) {
+    location.rdma = region.rdma;
+    location.address = region.rdma->address + offset;
+    return location;
+  }
+#endif
+  // shares ownership of the mapping so it outlives unregistering the region
+  location.data = {region.memory, region.memory->data() + offset};
+  return location;
+}
+
+void holdSharedMemory(InferenceRequest* request, SharedMemoryTensors tensors) {
+  if (tensors.empty()) {
+    return;
+  }
+  auto callback = request->getCallback();
+  if (callback == nullptr) {
+    return;
+  }
+  request->setCallback([tensors = std::move(tensors),
+                        callback = std::move(callback)](
+                         const InferenceResponse& response) mutable {
+    if (tensors.outputs.empty() || response.isError()) {
+      callback(response);
+      return;
+    }
+    callback(writeOutputs(response, tensors.outputs));
+  });
+}
+
+}  // namespace amdinfer
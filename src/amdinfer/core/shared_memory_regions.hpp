@@ -0,0 +1,185 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the system shared memory regions registered with the server
+ */
+
+#ifndef GUARD_AMDINFER_CORE_SHARED_MEMORY_REGIONS
+#define GUARD_AMDINFER_CORE_SHARED_MEMORY_REGIONS
+
+#include <cstddef>        // for size_t, byte
+#include <cstdint>        // for uint32_t, uint64_t
+#include <memory>         // for shared_ptr
+#include <shared_mutex>   // for shared_mutex
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "amdinfer/core/rdma.hpp"           // for RdmaRegion
+#include "amdinfer/core/shared_memory.hpp"  // for SharedMemoryStatus
+
+namespace amdinfer {
+
+class InferenceRequest;
+class MemoryPool;
+
+/// The tensors of a request that are in shared memory
+struct SharedMemoryTensors {
+  /// An output to write to a region
+  struct Output {
+    std::string name;
+    std::string region;
+    size_t offset = 0;
+    size_t byte_size = 0;
+    std::shared_ptr<std::byte> data;
+#ifdef AMDINFER_ENABLE_RDMA
+    /// set instead of data if the region is in a peer's memory
+    std::shared_ptr<RdmaRegion> rdma;
+    uint64_t address = 0;
+#endif
+  };
+
+  /// Keeps the regions of the inputs mapped while the request uses them
+  std::vector<std::shared_ptr<std::byte>> inputs;
+  std::vector<Output> outputs;
+
+  [[nodiscard]] bool empty() const { return inputs.empty() && outputs.empty(); }
+};
+
+/**
+ * @brief The system shared memory regions that clients registered with the
+ * server. Requests from clients on the same host refer to their tensors by a
+ * region's name and an offset instead of sending their data, which the
+ * batchers read straight from the mapped region. A region stays mapped while
+ * requests use it even if it's unregistered in the meantime.
+ *
+ * Clients on other hosts can register regions of their own memory, which the
+ * server reads inputs from and writes outputs to over RDMA, if it's enabled.
+ * Requests refer to these regions in the same way.
+ */
+class SharedMemoryRegions {
+ public:
+  /**
+   * @brief Map a region of a shared memory object that a client created.
+   * Throws invalid_argument if the name is taken or the object can't be
+   * mapped
+   *
+   * @param name the name that requests refer to the region by
+   * @param key the key of the object, such as "/input"
+   * @param offset offset of the region in the object
+   * @param byte_size size of the region
+   */
+  void add(const std::string& name, const std::string& key, size_t offset,
+           size_t byte_size);
+  /**
+   * @brief Connect an RDMA session to a client's queue pair, replacing any
+   * session with the same name. Throws external_error if RDMA isn't
+   * available and invalid_argument if the endpoint is malformed
+   *
+   * @param session the name that the client's regions refer to the session by
+   * @param endpoint the client's encoded RdmaEndpoint
+   * @return std::string the server's encoded RdmaEndpoint for the client to
+   * connect to
+   */
+  std::string connectRdma(const std::string& session,
+                          const std::string& endpoint);
+  /**
+   * @brief Register a region of a client's memory that's reached over an RDMA
+   * session. Throws invalid_argument if the name is taken or the session
+   * isn't connected
+   *
+   * @param name the name that requests refer to the region by
+   * @param session the name of the session
+   * @param address address of the region in the client
+   * @param key the key the client registered the region's memory with
+   * @param byte_size size of the region
+   */
+  void addRdma(const std::string& name, const std::string& session,
+               uint64_t address, uint32_t key, size_t byte_size);
+  /**
+   * @brief Unregister a region. Throws invalid_argument if it's not registered
+   *
+   * @param name the name of the region or empty to unregister all of them
+   */
+  void remove(const std::string& name);
+  /**
+   * @brief Get the status of a region. Throws invalid_argument if it's not
+   * registered
+   *
+   * @param name the name of the region or empty to get all of them
+   * @return std::vector<SharedMemoryStatus>
+   */
+  [[nodiscard]] std::vector<SharedMemoryStatus> status(
+    const std::string& name) const;
+
+  /**
+   * @brief Point the inputs of a request that name a region at their data in
+   * it and find the regions of its outputs. The inputs' memory is borrowed
+   * from the pool like raw gRPC inputs so it's put back as usual. Throws
+   * invalid_argument if a region isn't registered or a tensor doesn't fit in
+   * it, in which case the request is unchanged.
+   *
+   * @param request the request
+   * @param pool the memory pool that the request's inputs are put back to
+   * @return SharedMemoryTensors the tensors to pass to holdSharedMemory
+   */
+  SharedMemoryTensors map(InferenceRequest* request,
+                          const MemoryPool* pool) const;
+
+ private:
+  struct Region {
+    SharedMemoryStatus status;
+    std::shared_ptr<SystemSharedMemory> memory;
+#ifdef AMDINFER_ENABLE_RDMA
+    std::shared_ptr<RdmaRegion> rdma;
+#endif
+  };
+
+  /// Where a tensor is in a region
+  struct Location {
+    /// bytes in a mapped region that keep it mapped while they're held
+    std::shared_ptr<std::byte> data;
+#ifdef AMDINFER_ENABLE_RDMA
+    /// set instead of data if the region is in a peer's memory
+    std::shared_ptr<RdmaRegion> rdma;
+    uint64_t address = 0;
+#endif
+  };
+
+  /// Find a tensor in a region
+  Location get(const std::string& name, size_t offset, size_t byte_size) const;
+
+  std::unordered_map<std::string, Region> regions_;
+#ifdef AMDINFER_ENABLE_RDMA
+  std::unordered_map<std::string, std::shared_ptr<RdmaSession>> sessions_;
+#endif
+  mutable std::shared_mutex mutex_;
+};
+
+/**
+ * @brief Write the outputs of a request that are in shared memory to their
+ * regions instead of sending their data in the responses and keep the regions
+ * mapped until the request is done. Call it after the request's callback is
+ * set
+ *
+ * @param request the request
+ * @param tensors the tensors that SharedMemoryRegions::map found
+ */
+void holdSharedMemory(InferenceRequest* request, SharedMemoryTensors tensors);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_SHARED_MEMORY_REGIONS
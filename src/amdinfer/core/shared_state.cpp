@@ -22,22 +22,35 @@
 #include <json/reader.h>  // for CharReaderBuilder, Char...
 #include <json/value.h>   // for Value
 
+#include <algorithm>      // for max, min
+#include <array>          // for array
 #include <cassert>        // for assert
+#include <chrono>         // for steady_clock, duration_cast
+#include <cstdio>         // for snprintf
 #include <filesystem>     // for path
+#include <future>         // for future
 #include <iostream>       // for operator<<, basic_ostream
 #include <string>         // for string, operator+, stoi
+#include <thread>         // for thread
 #include <unordered_map>  // for operator==, unordered_m...
 #include <unordered_set>  // for unordered_set
 #include <utility>        // for move, pair
+#include <vector>         // for vector
 
 #include "amdinfer/build_options.hpp"          // for AMDINFER_ENABLE_VITIS
 #include "amdinfer/core/endpoints.hpp"         // for Endpoints
 #include "amdinfer/core/exceptions.hpp"        // for external_error, invalid...
+#include "amdinfer/core/manifest.hpp"          // for Manifest, ManifestEntry
 #include "amdinfer/core/model_config.hpp"      // for ModelConfig
 #include "amdinfer/core/model_repository.hpp"  // for ModelRepository
+#include "amdinfer/core/output_transforms.hpp"  // for holdOutputTransforms
 #include "amdinfer/core/parameters.hpp"        // for ParameterMap
-#include "amdinfer/core/request_container.hpp"  // for ServerMetadata, ModelMe...
+#include "amdinfer/core/request_container.hpp"   // for ServerMetadata, Model...
+#include "amdinfer/core/traffic_trace.hpp"       // for TraceWriter
+#include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
+#include "amdinfer/observation/logging.hpp"  // for AMDINFER_LOG_INFO
 #include "amdinfer/observation/observer.hpp"
+#include "amdinfer/util/ctpl.hpp"    // for ThreadPool
 #include "amdinfer/util/string.hpp"  // for isLower
 #include "amdinfer/version.hpp"      // for kAmdinferVersion
 
@@ -68,6 +81,9 @@ ServerMetadata SharedState::serverMetadata() {
 #endif
 #ifdef AMDINFER_ENABLE_MIGRAPHX
   metadata.extensions.emplace("migraphx");
+#endif
+#ifdef AMDINFER_ENABLE_ONNXRUNTIME
+  metadata.extensions.emplace("onnxruntime");
 #endif
   return metadata;
 }
@@ -77,23 +93,36 @@ void SharedState::modelLoad(const std::string& model,
                             const ParameterMap& parameters) {
   assert(util::isLower(model));
 
-  auto model_config = parseModel(repository_.getRepository(), model, version);
-  const auto end = model_config.crend();
-  for (auto it = model_config.crbegin(); it != end; ++it) {
-    const auto& [model_name, model_parameters] = *it;
-    // merge the runtime provided parameters with those from the model file
-    ParameterMap updated_parameters = model_parameters;
-    for (const auto& [key, value] : parameters) {
-      updated_parameters.put(key, value);
-    }
-    // the config will add the versioned model name already
-    endpoints_.load(model_name, "", updated_parameters);
+  // load the version alongside the one serving the model and swap to it
+  if (parameters.has("swap") && parameters.get<bool>("swap")) {
+    auto updated_parameters = parameters;
+    updated_parameters.erase("swap");
+    swapModel(repository_.getRepository(), model, version, updated_parameters,
+              &endpoints_);
+  } else {
+    auto model_config =
+      parseModel(repository_.getRepository(), model, version);
+    loadModelConfig(model, version, model_config, parameters, &endpoints_);
+  }
+
+  if (manifest_ != nullptr) {
+    manifest_->add({ManifestKind::Model, model, version, parameters,
+                    getVersionedEndpoint(model, version)});
   }
 }
 
 void SharedState::modelUnload(const std::string& model,
                               const std::string& version) {
   endpoints_.unload(model, version);
+  if (manifest_ != nullptr) {
+    manifest_->removeModel(model, version);
+  }
+}
+
+void SharedState::modelUpdate(const std::string& model,
+                              const std::string& version,
+                              const ParameterMap& parameters) {
+  endpoints_.update(getVersionedEndpoint(model, version), parameters);
 }
 
 std::string SharedState::workerLoad(const std::string& worker,
@@ -102,23 +131,94 @@ std::string SharedState::workerLoad(const std::string& worker,
 
   auto updated_parameters = parameters;
   updated_parameters.put("worker", worker);
-  return endpoints_.load(worker, "", updated_parameters);
+  auto endpoint = endpoints_.load(worker, "", updated_parameters);
+  if (manifest_ != nullptr) {
+    manifest_->add({ManifestKind::Worker, worker, "", parameters, endpoint});
+  }
+  return endpoint;
 }
 
 void SharedState::workerUnload(const std::string& worker) {
   assert(util::isLower(worker));
   endpoints_.unload(worker, "");
+  if (manifest_ != nullptr) {
+    manifest_->removeWorker(worker);
+  }
 }
 
 void SharedState::modelInfer(const std::string& model,
-                             std::unique_ptr<RequestContainer> request,
+                             RequestContainerPtr request,
                              const std::string& version) {
+  if (capture_ != nullptr) {
+    this->capture(model, version, *request->request);
+  }
+  // the outputs are reduced before anything else the servers do to responses
+  holdOutputTransforms(request->request.get());
+  if (repository_.infer(model, version, &request)) {
+    return;
+  }
   endpoints_.infer(model, std::move(request), version);
 }
 
+std::shared_ptr<void> SharedState::modelAdmit(const std::string& model,
+                                              const std::string& version,
+                                              size_t bytes) {
+  return endpoints_.admit(model, version, bytes);
+}
+
+std::shared_ptr<void> SharedState::admit(const std::string& tenant) {
+  if (limiter_ != nullptr) {
+    limiter_->take(tenant);
+  }
+  if (shedder_ != nullptr) {
+    return shedder_->admit();
+  }
+  return nullptr;
+}
+
+const std::string& SharedState::getTenantKey() const { return tenant_key_; }
+
 bool SharedState::modelReady(const std::string& model,
                              const std::string& version) {
-  return endpoints_.ready(model, version);
+  if (!endpoints_.ready(model, version)) {
+    return false;
+  }
+  return ready_threshold_ <= 0 ||
+         endpoints_.getLoad(model, version, saturated_batches_) <
+           ready_threshold_;
+}
+
+double SharedState::getLoad() const {
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  const auto now_ns =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  auto sampled = load_sampled_.load(std::memory_order_relaxed);
+  const auto interval =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(kLoadInterval);
+  // one caller per interval samples it again and the others use its sample
+  if (now_ns - sampled < interval.count() ||
+      !load_sampled_.compare_exchange_strong(sampled, now_ns,
+                                             std::memory_order_relaxed)) {
+    return load_.load(std::memory_order_relaxed);
+  }
+  auto load = endpoints_.getLoad(saturated_batches_);
+  if (shedder_ != nullptr) {
+    load = std::max(load, shedder_->getLoad());
+  }
+  load_.store(load, std::memory_order_relaxed);
+  return load;
+}
+
+std::string SharedState::formatLoad() const {
+  constexpr size_t kSize = 32;
+  std::array<char, kSize> buffer{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+  std::snprintf(buffer.data(), buffer.size(), "%.3f", this->getLoad());
+  return std::string{buffer.data()};
+}
+
+bool SharedState::serverReady() const {
+  return ready_threshold_ <= 0 || this->getLoad() < ready_threshold_;
 }
 
 std::vector<std::string> SharedState::modelList() { return endpoints_.list(); }
@@ -128,6 +228,11 @@ ModelMetadata SharedState::modelMetadata(const std::string& model,
   return endpoints_.metadata(model, version);
 }
 
+std::shared_ptr<const ModelMetadata> SharedState::publishedMetadata(
+  const std::string& model, const std::string& version) const {
+  return endpoints_.publishedMetadata(model, version);
+}
+
 Kernels SharedState::getHardware() {
   Kernels kernels;
 
@@ -203,6 +308,8 @@ bool SharedState::hasHardware(const std::string& name, int num) {
 
 const MemoryPool* SharedState::getPool() const { return endpoints_.getPool(); }
 
+SharedMemoryRegions* SharedState::getSharedMemory() { return &shared_memory_; }
+
 void SharedState::setRepository(const fs::path& repository_path,
                                 bool load_existing) {
   repository_.setEndpoints(&endpoints_);
@@ -213,4 +320,148 @@ void SharedState::enableRepositoryMonitoring(bool use_polling) {
   repository_.enableMonitoring(use_polling);
 }
 
+void SharedState::enableLazyLoading(size_t memory_budget,
+                                    std::chrono::seconds idle_timeout) {
+  repository_.enableLazyLoading(memory_budget, idle_timeout);
+}
+
+void SharedState::enableLoadShedding(std::chrono::milliseconds target,
+                                     size_t max_inflight) {
+  shedder_ = std::make_shared<LoadShedder>(target, max_inflight);
+}
+
+void SharedState::enableOverloadReadiness(double threshold,
+                                          double saturated_batches) {
+  ready_threshold_ = threshold;
+  saturated_batches_ = saturated_batches;
+}
+
+void SharedState::enableRateLimiting(double rate, double burst,
+                                     std::string tenant_key) {
+  limiter_ = std::make_unique<RateLimiter>(rate, burst);
+  tenant_key_ = std::move(tenant_key);
+}
+
+void SharedState::enableUsageAccounting(std::string tenant_key) {
+  usage_ = true;
+  tenant_key_ = std::move(tenant_key);
+}
+
+void SharedState::setShard(int index, fs::path directory) {
+  shard_index_ = index;
+  shard_directory_ = std::move(directory);
+}
+
+int SharedState::getShardIndex() const { return shard_index_; }
+
+const fs::path& SharedState::getShardDirectory() const {
+  return shard_directory_;
+}
+
+void SharedState::setWorkerCpus(const std::vector<int>& cpus) {
+  endpoints_.setWorkerCpus(cpus);
+}
+
+void SharedState::enableManifest(const fs::path& path, bool restore) {
+  std::vector<ManifestEntry> entries;
+  if (restore) {
+    entries = readManifest(path);
+  }
+  // the restored endpoints are recorded again as they're loaded so the ones
+  // that fail to load are dropped
+  manifest_ = std::make_unique<Manifest>(path);
+  this->restore(entries);
+  manifest_->save();
+}
+
+void SharedState::enableCapture(const fs::path& path, double rate,
+                                bool payload) {
+  capture_rate_ = rate;
+  capture_start_ = std::chrono::steady_clock::now();
+  capture_ = std::make_unique<TraceWriter>(path, payload);
+}
+
+void SharedState::capture(const std::string& model, const std::string& version,
+                          const InferenceRequest& request) {
+  // every request whose count crosses a multiple of 1 / rate is sampled so the
+  // sampled requests are spread evenly without a random number per request
+  const auto count = captured_.fetch_add(1, std::memory_order_relaxed);
+  const auto before = static_cast<uint64_t>(static_cast<double>(count) *
+                                            capture_rate_);
+  const auto after = static_cast<uint64_t>(static_cast<double>(count + 1) *
+                                           capture_rate_);
+  if (before == after) {
+    return;
+  }
+  const auto time = std::chrono::steady_clock::now() - capture_start_;
+  capture_->write(std::chrono::duration_cast<std::chrono::nanoseconds>(time),
+                  model, version, request);
+}
+
+void SharedState::restore(const std::vector<ManifestEntry>& entries) {
+  if (entries.empty()) {
+    return;
+  }
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+  const auto start = std::chrono::steady_clock::now();
+
+  // endpoints may be named differently this time, such as if an earlier load
+  // failed, so the next endpoints of chains are looked up as they're restored
+  std::unordered_set<std::string> recorded;
+  for (const auto& entry : entries) {
+    recorded.insert(entry.endpoint);
+  }
+  std::unordered_map<std::string, std::string> restored;
+
+  // artifacts that the workers compiled before come from the artifact cache
+  // so each load mostly reads files and warms up, which run well in parallel
+  const auto threads = std::min(
+    {entries.size(), static_cast<size_t>(kMaxLoadThreads),
+     static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1U))});
+  util::ThreadPool pool{static_cast<int>(threads)};
+  for (const auto& stage : getRestoreStages(entries)) {
+    std::vector<std::pair<size_t, std::future<std::string>>> loads;
+    loads.reserve(stage.size());
+    for (const auto index : stage) {
+      const auto& entry = entries[index];
+      auto parameters = entry.parameters;
+      if (parameters.has("next")) {
+        const auto next = parameters.get<std::string>("next");
+        if (const auto found = restored.find(next); found != restored.end()) {
+          parameters.put("next", found->second);
+        } else if (recorded.find(next) != recorded.end()) {
+          AMDINFER_LOG_WARN(logger, "Not restoring " + entry.endpoint +
+                                      " because " + next + " failed to load");
+          continue;
+        }
+      }
+      loads.emplace_back(
+        index, pool.push([this, &entry, parameters](int) -> std::string {
+          if (entry.kind == ManifestKind::Worker) {
+            return this->workerLoad(entry.name, parameters);
+          }
+          this->modelLoad(entry.name, entry.version, parameters);
+          return getVersionedEndpoint(entry.name, entry.version);
+        }));
+    }
+    for (auto& [index, load] : loads) {
+      const auto& endpoint = entries[index].endpoint;
+      try {
+        restored.try_emplace(endpoint, load.get());
+      } catch (const amdinfer::runtime_error& e) {
+        AMDINFER_LOG_WARN(logger,
+                          "Couldn't restore " + endpoint + ": " + e.what());
+      }
+    }
+  }
+
+  [[maybe_unused]] const auto elapsed =
+    std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  AMDINFER_LOG_INFO(logger, "Restored " + std::to_string(restored.size()) +
+                              " of " + std::to_string(entries.size()) +
+                              " endpoints in " +
+                              std::to_string(elapsed.count()) + " ms");
+}
+
 }  // namespace amdinfer
@@ -20,27 +20,43 @@
 #ifndef GUARD_AMDINFER_CORE_SHARED_STATE
 #define GUARD_AMDINFER_CORE_SHARED_STATE
 
-#include <filesystem>  // for path
-#include <memory>      // for unique_ptr
-#include <string>      // for string
-#include <vector>      // for vector
+#include <atomic>       // for atomic
+#include <chrono>       // for seconds, milliseconds
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int64_t
+#include <filesystem>   // for path
+#include <memory>       // for unique_ptr, shared_ptr
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
 
-#include "amdinfer/core/endpoints.hpp"         // for Endpoints
-#include "amdinfer/core/model_metadata.hpp"    // for ModelMetadata
-#include "amdinfer/core/model_repository.hpp"  // for ModelRepository
-#include "amdinfer/core/server_metadata.hpp"   // for ServerMetadata
-#include "amdinfer/declarations.hpp"           // for Kernels
+#include "amdinfer/core/bulk_job.hpp"               // for BulkJobs
+#include "amdinfer/core/endpoints.hpp"              // for Endpoints
+#include "amdinfer/core/load_shedding.hpp"          // for LoadShedder, RateL...
+#include "amdinfer/core/manifest.hpp"               // for Manifest
+#include "amdinfer/core/model_metadata.hpp"         // for ModelMetadata
+#include "amdinfer/core/model_repository.hpp"       // for ModelRepository
+#include "amdinfer/core/server_metadata.hpp"        // for ServerMetadata
+#include "amdinfer/core/shared_memory_regions.hpp"  // for SharedMemoryRegions
+#include "amdinfer/core/traffic_trace.hpp"          // for TraceWriter
+#include "amdinfer/declarations.hpp"                // for Kernels
 
 namespace amdinfer {
 
 class RequestContainer;
 class ParameterMap;
 
+/// The response header or trailing metadata key that reports the server's load
+constexpr std::string_view kLoadHeader = "amdinfer-load";
+
 class SharedState {
  public:
   void modelLoad(const std::string& model, const std::string& version,
                  const ParameterMap& parameters);
   void modelUnload(const std::string& model, const std::string& version);
+  /// Change the batch size or timeout of a loaded model. See Endpoints
+  void modelUpdate(const std::string& model, const std::string& version,
+                   const ParameterMap& parameters);
   std::string workerLoad(const std::string& worker,
                          const ParameterMap& parameters);
   void workerUnload(const std::string& worker);
@@ -50,23 +66,143 @@ class SharedState {
   bool modelReady(const std::string& model, const std::string& version = "");
   ModelMetadata modelMetadata(const std::string& model,
                               const std::string& version = "");
+  /// Get the metadata of a model as published by its endpoint. See Endpoints
+  std::shared_ptr<const ModelMetadata> publishedMetadata(
+    const std::string& model, const std::string& version = "") const;
 
-  void modelInfer(const std::string& model,
-                  std::unique_ptr<RequestContainer> request,
+  void modelInfer(const std::string& model, RequestContainerPtr request,
                   const std::string& version = "");
+  /// Admit a request to a model before it's decoded. See Endpoints
+  std::shared_ptr<void> modelAdmit(const std::string& model,
+                                   const std::string& version, size_t bytes);
+  /**
+   * @brief Admit a request to the server, before anything else is done with
+   * it, if load shedding or rate limiting are enabled. Throws
+   * resource_exhausted_error if it's refused
+   *
+   * @param tenant the value of the request's tenant header or metadata
+   * @return std::shared_ptr<void> a ticket to hold with holdTicket or null
+   */
+  std::shared_ptr<void> admit(const std::string& tenant);
+  /**
+   * @brief Get the header that identifies tenants or empty if neither rate
+   * limiting nor usage accounting are enabled
+   */
+  const std::string& getTenantKey() const;
+  /// Check if the servers account for the CPU time and copies of requests
+  bool accountsUsage() const { return usage_; }
+
+  /**
+   * @brief Get the load of the server, the larger of the load shedder's and
+   * the most saturated endpoint's, so 1 or more means it's saturated. It's
+   * sampled at most once per kLoadInterval so it's cheap enough to report on
+   * every response
+   *
+   * @return double
+   */
+  double getLoad() const;
+  /// Get the load formatted for the kLoadHeader header, such as "0.250"
+  std::string formatLoad() const;
+  /// Check if the server is ready. See enableOverloadReadiness
+  bool serverReady() const;
+  /**
+   * @brief Report the server and each model as not ready while its load is
+   * at or above a threshold so load balancers send their requests elsewhere
+   *
+   * @param threshold the load at which they're not ready
+   * @param saturated_batches queued batches per worker that saturate an
+   * endpoint
+   */
+  void enableOverloadReadiness(double threshold, double saturated_batches);
+
+  static constexpr std::chrono::milliseconds kLoadInterval{10};
+  /// Queued batches per worker that saturate an endpoint by default
+  static constexpr double kSaturatedBatches = 4;
 
   static Kernels getHardware();
   static bool hasHardware(const std::string& name, int num);
 
   const MemoryPool* getPool() const;
+  /// Get the system shared memory regions that clients have registered
+  SharedMemoryRegions* getSharedMemory();
 
   void setRepository(const std::filesystem::path& repository_path,
                      bool load_existing);
   void enableRepositoryMonitoring(bool use_polling);
+  void enableLazyLoading(size_t memory_budget,
+                         std::chrono::seconds idle_timeout);
+  void enableLoadShedding(std::chrono::milliseconds target,
+                          size_t max_inflight);
+  void enableRateLimiting(double rate, double burst, std::string tenant_key);
+  /**
+   * @brief Account for the CPU time and copies that the servers spend on each
+   * request. See RequestUsage
+   *
+   * @param tenant_key the header that identifies the tenants to label the
+   * usage with
+   */
+  void enableUsageAccounting(std::string tenant_key);
+  /// Restrict workers loaded afterwards to a set of CPUs. See Endpoints
+  void setWorkerCpus(const std::vector<int>& cpus);
+  /// Run as one of several shards of a server. See Supervisor
+  void setShard(int index, std::filesystem::path directory);
+  /// Get the index of this shard or -1 if the server isn't sharded
+  int getShardIndex() const;
+  /// Get the directory the shards share or empty if the server isn't sharded
+  const std::filesystem::path& getShardDirectory() const;
+  /**
+   * @brief Record the workers and models loaded afterwards in a manifest. See
+   * Manifest
+   *
+   * @param path path to the manifest
+   * @param restore first load the endpoints recorded in the manifest already
+   */
+  void enableManifest(const std::filesystem::path& path, bool restore);
+  /**
+   * @brief Write a sample of the inference requests to a trace as they
+   * arrive. See TraceWriter
+   *
+   * @param path path to the trace
+   * @param rate fraction of the requests to write, between 0 and 1
+   * @param payload write the data of the inputs too instead of only their
+   * shapes
+   */
+  void enableCapture(const std::filesystem::path& path, double rate,
+                     bool payload);
+  /// Get the offline jobs that run datasets through models. See BulkJobs
+  BulkJobs* getJobs() { return &jobs_; }
 
  private:
+  /// Add the request to the trace if it's sampled
+  void capture(const std::string& model, const std::string& version,
+               const InferenceRequest& request);
+
+  /// Load the entries of a manifest, in parallel where they're independent
+  void restore(const std::vector<ManifestEntry>& entries);
+
   Endpoints endpoints_;
   ModelRepository repository_;
+  SharedMemoryRegions shared_memory_;
+  // set before the servers start
+  std::shared_ptr<LoadShedder> shedder_;
+  std::unique_ptr<RateLimiter> limiter_;
+  std::string tenant_key_;
+  bool usage_ = false;
+  int shard_index_ = -1;
+  std::filesystem::path shard_directory_;
+  std::unique_ptr<Manifest> manifest_;
+  double ready_threshold_ = 0;
+  double saturated_batches_ = kSaturatedBatches;
+  // the last sample of the load and when it was taken, in nanoseconds
+  mutable std::atomic<double> load_ = 0;
+  mutable std::atomic<int64_t> load_sampled_ = 0;
+  std::unique_ptr<TraceWriter> capture_;
+  double capture_rate_ = 1;
+  std::chrono::steady_clock::time_point capture_start_;
+  // number of requests that have arrived since the capture started
+  std::atomic<uint64_t> captured_ = 0;
+  // last so the jobs are stopped before the endpoints they send to
+  BulkJobs jobs_{this};
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,77 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the coalescing of identical requests
+ */
+
+#include "amdinfer/core/single_flight.hpp"
+
+#include <utility>  // for move
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/observation/metrics.hpp"      // for Metrics, MetricCount...
+
+namespace amdinfer {
+
+bool SingleFlight::join(uint64_t key, InferenceRequest* request) {
+  {
+    const std::lock_guard lock{mutex_};
+    auto [found, inserted] = flights_.try_emplace(key);
+    if (inserted) {
+      return false;
+    }
+    found->second.push_back(
+      Follower{request->getID(), request->getCallback()});
+  }
+
+#ifdef AMDINFER_ENABLE_METRICS
+  Metrics::getInstance().incrementCounter(MetricCounterIDs::RequestsCoalesced);
+#endif
+  return true;
+}
+
+void SingleFlight::land(uint64_t key, const InferenceResponse& response) {
+  std::vector<Follower> followers;
+  {
+    const std::lock_guard lock{mutex_};
+    auto found = flights_.find(key);
+    if (found == flights_.end()) {
+      return;
+    }
+    followers = std::move(found->second);
+    flights_.erase(found);
+  }
+
+  // the leader's response still views its data while its callback runs so
+  // the copies can view it too
+  for (auto& follower : followers) {
+    if (follower.callback == nullptr) {
+      continue;
+    }
+    auto copy = response;
+    copy.setID(follower.id);
+    follower.callback(copy);
+  }
+}
+
+size_t SingleFlight::size() const {
+  const std::lock_guard lock{mutex_};
+  return flights_.size();
+}
+
+}  // namespace amdinfer
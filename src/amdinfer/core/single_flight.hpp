@@ -0,0 +1,83 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the coalescing of identical requests that are in flight at
+ * the same time
+ */
+
+#ifndef GUARD_AMDINFER_CORE_SINGLE_FLIGHT
+#define GUARD_AMDINFER_CORE_SINGLE_FLIGHT
+
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint64_t
+#include <mutex>          // for mutex
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "amdinfer/declarations.hpp"  // for Callback
+
+namespace amdinfer {
+
+class InferenceRequest;
+class InferenceResponse;
+
+/**
+ * @brief Coalesces identical requests to one endpoint while they're in flight.
+ * The first request with a key leads a flight and is batched and run as usual.
+ * Identical requests that arrive before it responds follow it instead of
+ * taking a slot in a batch and get a copy of its response, including its
+ * errors.
+ */
+class SingleFlight {
+ public:
+  /**
+   * @brief Join the flight of a request. If an identical request is in
+   * flight, this one follows it: its callback is taken to respond to with the
+   * leader's response. Otherwise, it leads a new flight and land() must be
+   * called with its response.
+   *
+   * @param key the request's key from ResponseCache::key
+   * @param request the request
+   * @return bool - true if the request follows another and needs nothing more
+   */
+  bool join(uint64_t key, InferenceRequest* request);
+
+  /**
+   * @brief End the flight of a key and respond to its followers with copies of
+   * the leader's response
+   *
+   * @param key the key of the flight
+   * @param response the leader's response
+   */
+  void land(uint64_t key, const InferenceResponse& response);
+
+  /// Get the number of flights in progress
+  [[nodiscard]] size_t size() const;
+
+ private:
+  struct Follower {
+    std::string id;
+    Callback callback;
+  };
+
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, std::vector<Follower>> flights_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_SINGLE_FLIGHT
@@ -0,0 +1,87 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the flow control of streams of responses
+ */
+
+#include "amdinfer/core/stream_flow.hpp"
+
+#include <algorithm>  // for max, min
+
+namespace amdinfer {
+
+std::optional<StreamFlowPolicy> parseStreamFlowPolicy(
+  std::string_view policy) {
+  if (policy == "block") {
+    return StreamFlowPolicy::Block;
+  }
+  if (policy == "drop") {
+    return StreamFlowPolicy::Drop;
+  }
+  return std::nullopt;
+}
+
+StreamFlow::StreamFlow(size_t credits, StreamFlowPolicy policy)
+  : credits_(std::max<size_t>(credits, 1)), policy_(policy) {}
+
+bool StreamFlow::acquire() {
+  std::unique_lock lock{mutex_};
+  auto available = [this] {
+    return closed_ || reserved_ + queued_ < credits_;
+  };
+  if (policy_ == StreamFlowPolicy::Block) {
+    cv_.wait(lock, available);
+  }
+  if (closed_ || !available()) {
+    dropped_++;
+    return false;
+  }
+  reserved_++;
+  return true;
+}
+
+void StreamFlow::queue() {
+  const std::lock_guard lock{mutex_};
+  queued_++;
+  // the response may not have taken a credit, in which case it holds back
+  // one that has until that one's queued
+  if (reserved_ > 0) {
+    reserved_--;
+  }
+}
+
+void StreamFlow::release(size_t count) {
+  {
+    const std::lock_guard lock{mutex_};
+    queued_ -= std::min(count, queued_);
+  }
+  cv_.notify_all();
+}
+
+void StreamFlow::close() {
+  {
+    const std::lock_guard lock{mutex_};
+    closed_ = true;
+  }
+  cv_.notify_all();
+}
+
+size_t StreamFlow::getDropped() const {
+  const std::lock_guard lock{mutex_};
+  return dropped_;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,109 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the flow control of streams of responses
+ */
+
+#ifndef GUARD_AMDINFER_CORE_STREAM_FLOW
+#define GUARD_AMDINFER_CORE_STREAM_FLOW
+
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <mutex>               // for mutex
+#include <optional>            // for optional
+#include <string_view>         // for string_view
+
+namespace amdinfer {
+
+/// The most responses of a gRPC stream waiting to be written by default
+constexpr size_t kDefaultStreamCredits = 64;
+/// gRPC metadata key of the most responses of a stream that may be waiting
+constexpr std::string_view kStreamCreditsKey = "amdinfer-stream-credits";
+/// gRPC metadata key of the flow control policy of a stream
+constexpr std::string_view kStreamPolicyKey = "amdinfer-stream-policy";
+
+/// What a worker does with a response when its stream has no credits
+enum class StreamFlowPolicy {
+  Block,  ///< wait for the client to catch up
+  Drop,   ///< drop the response, such as a frame of a video
+};
+
+/**
+ * @brief Parse a policy from "block" or "drop"
+ *
+ * @param policy the policy
+ * @return std::optional<StreamFlowPolicy> the policy or nullopt if unknown
+ */
+std::optional<StreamFlowPolicy> parseStreamFlowPolicy(std::string_view policy);
+
+/**
+ * @brief Credit-based flow control of one stream of responses, such as the
+ * frames that a streaming worker sends over a websocket. Workers take a credit
+ * before sending each optional response and the transport returns it once the
+ * response has left the server, so a client that reads slowly holds back the
+ * workers feeding it instead of growing the transport's write queue without
+ * bound. Responses that the transport queues without a credit, like errors
+ * and final responses, use up the credits of those being sent so the window
+ * counts every response that's waiting.
+ */
+class StreamFlow {
+ public:
+  /**
+   * @brief Construct a new flow
+   *
+   * @param credits the most responses that may be waiting at once
+   * @param policy what workers do when there are no credits
+   */
+  StreamFlow(size_t credits, StreamFlowPolicy policy);
+
+  /**
+   * @brief Take a credit to send a response. With the block policy, this
+   * waits until there's one
+   *
+   * @return bool true to send the response, false to drop it because there's
+   * no credit or the stream is closed
+   */
+  [[nodiscard]] bool acquire();
+  /// Count a response that the transport queued to write
+  void queue();
+  /**
+   * @brief Return credits once the transport has written responses
+   *
+   * @param count the number of responses
+   */
+  void release(size_t count = 1);
+  /// Stop taking credits for good because the client is gone
+  void close();
+
+  /// Get the number of responses dropped so far
+  [[nodiscard]] size_t getDropped() const;
+
+ private:
+  const size_t credits_;
+  const StreamFlowPolicy policy_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  // credits taken by workers for responses the transport hasn't queued yet
+  size_t reserved_ = 0;
+  // responses queued by the transport and not written yet
+  size_t queued_ = 0;
+  size_t dropped_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_STREAM_FLOW
@@ -0,0 +1,124 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the serialization of StreamFrames
+ */
+
+#include "amdinfer/core/stream_frame.hpp"
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint8_t, uint16_t, uint32_t, uint64_t
+#include <limits>       // for numeric_limits
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+
+namespace amdinfer {
+
+namespace {
+
+constexpr std::string_view kMagic{"AMDF"};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 24;
+
+template <typename T>
+void writeInt(T value, std::string* out) {
+  for (auto i = 0U; i < sizeof(T); ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+template <typename T>
+T readInt(const char* data) {
+  T value = 0;
+  for (auto i = 0U; i < sizeof(T); ++i) {
+    value |= static_cast<T>(static_cast<uint8_t>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+std::string serializeStreamFrame(const StreamFrame& frame,
+                                 std::string_view image) {
+  if (frame.key.size() > std::numeric_limits<uint16_t>::max() ||
+      frame.results.size() > std::numeric_limits<uint32_t>::max()) {
+    throw invalid_argument("The key or results of the frame are too long");
+  }
+
+  std::string message;
+  message.reserve(kHeaderSize + frame.key.size() + frame.results.size() +
+                  image.size());
+  message.append(kMagic);
+  writeInt(kVersion, &message);
+  writeInt(static_cast<uint8_t>(frame.format), &message);
+  writeInt(frame.width, &message);
+  writeInt(frame.height, &message);
+  writeInt(static_cast<uint16_t>(frame.key.size()), &message);
+  writeInt(static_cast<uint32_t>(frame.results.size()), &message);
+  writeInt(frame.index, &message);
+  message.append(frame.key);
+  message.append(frame.results);
+  message.append(image);
+  return message;
+}
+
+std::string serializeStreamFrame(const StreamFrame& frame) {
+  return serializeStreamFrame(frame, frame.data);
+}
+
+StreamFrame parseStreamFrame(std::string_view message) {
+  if (message.size() < kHeaderSize || message.substr(0, 4) != kMagic) {
+    throw invalid_argument("The message is not a stream frame");
+  }
+  const auto* header = message.data();
+  if (static_cast<uint8_t>(header[4]) != kVersion) {
+    throw invalid_argument("Unsupported stream frame version " +
+                           std::to_string(static_cast<uint8_t>(header[4])));
+  }
+  const auto format = static_cast<uint8_t>(header[5]);
+  if (format > static_cast<uint8_t>(StreamFrameFormat::Bgr)) {
+    throw invalid_argument("Unknown stream frame format " +
+                           std::to_string(format));
+  }
+
+  StreamFrame frame;
+  frame.format = static_cast<StreamFrameFormat>(format);
+  frame.width = readInt<uint16_t>(header + 6);
+  frame.height = readInt<uint16_t>(header + 8);
+  const size_t key_size = readInt<uint16_t>(header + 10);
+  const size_t results_size = readInt<uint32_t>(header + 12);
+  frame.index = readInt<uint64_t>(header + 16);
+
+  auto body = message.substr(kHeaderSize);
+  if (body.size() < key_size + results_size) {
+    throw invalid_argument("The stream frame is truncated");
+  }
+  frame.key = body.substr(0, key_size);
+  frame.results = body.substr(key_size, results_size);
+  frame.data = body.substr(key_size + results_size);
+
+  const auto channels = 3;
+  if (frame.format == StreamFrameFormat::Bgr &&
+      frame.data.size() !=
+        static_cast<size_t>(frame.width) * frame.height * channels) {
+    throw invalid_argument("The size of the raw image doesn't match its shape");
+  }
+  return frame;
+}
+
+}  // namespace amdinfer
@@ -26,7 +26,7 @@
 
 namespace amdinfer {
 
-Tensor::Tensor(std::string name, std::vector<int64_t> shape, DataType data_type)
+Tensor::Tensor(std::string name, Shape shape, DataType data_type)
   : name_(std::move(name)), shape_(std::move(shape)), data_type_(data_type) {}
 
 const std::string &Tensor::getName() const & { return this->name_; }
@@ -35,11 +35,11 @@ std::string Tensor::getName() && { return std::move(this->name_); }
 
 void Tensor::setName(std::string name) { name_ = std::move(name); }
 
-const std::vector<int64_t> &Tensor::getShape() const & { return shape_; }
+const Shape &Tensor::getShape() const & { return shape_; }
 
-std::vector<int64_t> Tensor::getShape() && { return std::move(shape_); }
+Shape Tensor::getShape() && { return std::move(shape_); }
 
-void Tensor::setShape(std::vector<int64_t> shape) { shape_ = std::move(shape); }
+void Tensor::setShape(Shape shape) { shape_ = std::move(shape); }
 
 [[nodiscard]] DataType Tensor::getDatatype() const { return this->data_type_; }
 
@@ -0,0 +1,161 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the table that binds request inputs to a model's inputs
+ */
+
+#include "amdinfer/core/tensor_bindings.hpp"
+
+#include <algorithm>  // for min, none_of
+#include <cstdint>    // for int64_t
+#include <string>     // for operator+, to_string
+#include <vector>     // for vector
+
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+
+namespace amdinfer {
+
+TensorBindings::TensorBindings(const std::vector<Tensor>& tensors) {
+  bindings_.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    const auto& shape = tensor.getShape();
+    const bool known =
+      !shape.empty() && std::none_of(shape.begin(), shape.end(),
+                                     [](int64_t dim) { return dim <= 0; });
+    const auto bytes = known ? tensor.getSize() * tensor.getDatatype().size()
+                             : size_t{0};
+    bindings_.push_back(
+      {tensor.getName(), tensor.getDatatype(), shape, bytes});
+  }
+}
+
+bool TensorBindings::empty() const { return bindings_.empty(); }
+
+size_t TensorBindings::size() const { return bindings_.size(); }
+
+const TensorBinding& TensorBindings::operator[](size_t index) const {
+  return bindings_[index];
+}
+
+size_t TensorBindings::find(std::string_view name) const {
+  // models have few inputs so a linear search is the fastest
+  for (auto i = 0U; i < bindings_.size(); ++i) {
+    if (bindings_[i].name == name) {
+      return i;
+    }
+  }
+  return bindings_.size();
+}
+
+size_t TensorBindings::samples(const InferenceRequest& request) const {
+  const auto& inputs = request.getInputs();
+  const auto count = std::min(inputs.size(), bindings_.size());
+  int64_t samples = 1;
+  for (auto i = 0U; i < count; ++i) {
+    const auto& shape = inputs[i].getShape();
+    const auto& model_shape = bindings_[i].shape;
+    if (model_shape.empty() || shape.size() != model_shape.size() + 1) {
+      return 1;
+    }
+    if (i == 0) {
+      samples = shape[0];
+    } else if (shape[0] != samples) {
+      return 1;
+    }
+    for (auto j = 0U; j < model_shape.size(); ++j) {
+      if (model_shape[j] > 0 && shape[j + 1] != model_shape[j]) {
+        return 1;
+      }
+    }
+  }
+  return samples > 1 ? static_cast<size_t>(samples) : 1;
+}
+
+size_t TensorBindings::unboundSamples(const InferenceRequest& request) const {
+  const auto& inputs = request.getInputs();
+  if (!bindings_.empty() || inputs.empty() || inputs[0].getShape().empty()) {
+    return 1;
+  }
+  const auto samples = inputs[0].getShape()[0];
+  return samples > 1 ? static_cast<size_t>(samples) : 1;
+}
+
+size_t TensorBindings::bind(InferenceRequest* request) const {
+  if (bindings_.empty()) {
+    return 1;
+  }
+
+  const auto& inputs = request->getInputs();
+  // requests usually send the model's inputs by name and in order
+  bool named = inputs.size() <= bindings_.size();
+  bool ordered = named;
+  for (auto i = 0U; named && i < inputs.size(); ++i) {
+    const auto index = this->find(inputs[i].getName());
+    named = index != bindings_.size();
+    ordered = ordered && index == i;
+  }
+
+  if (named) {
+    if (inputs.size() < bindings_.size()) {
+      for (const auto& binding : bindings_) {
+        if (std::none_of(inputs.begin(), inputs.end(), [&](const auto& input) {
+              return input.getName() == binding.name;
+            })) {
+          throw invalid_argument("Request is missing input " + binding.name);
+        }
+      }
+    }
+    if (!ordered) {
+      std::vector<size_t> order;
+      order.reserve(inputs.size());
+      std::vector<bool> seen(inputs.size());
+      for (const auto& input : inputs) {
+        const auto index = this->find(input.getName());
+        if (seen[index]) {
+          throw invalid_argument("Request has input " + input.getName() +
+                                 " more than once");
+        }
+        seen[index] = true;
+        order.push_back(index);
+      }
+      request->reorderInputTensors(order);
+    }
+  } else {
+    const auto count = std::min(inputs.size(), bindings_.size());
+    for (auto i = 0U; i < count; ++i) {
+      if (inputs[i].getName() != bindings_[i].name) {
+        request->setInputTensorName(i, bindings_[i].name);
+      }
+    }
+  }
+
+  const auto samples = this->samples(*request);
+  const auto count = std::min(inputs.size(), bindings_.size());
+  for (auto i = 0U; i < count; ++i) {
+    const auto& binding = bindings_[i];
+    const auto bytes =
+      inputs[i].getSize() * inputs[i].getDatatype().size() / samples;
+    if (binding.bytes != 0 && bytes > binding.bytes) {
+      throw invalid_argument("Input " + binding.name + " has " +
+                             std::to_string(bytes) + " bytes but the model " +
+                             "takes at most " + std::to_string(binding.bytes));
+    }
+  }
+  return samples;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,107 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the table that binds request inputs to a model's inputs
+ */
+
+#ifndef GUARD_AMDINFER_CORE_TENSOR_BINDINGS
+#define GUARD_AMDINFER_CORE_TENSOR_BINDINGS
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+#include "amdinfer/core/tensor.hpp"      // for Tensor
+
+namespace amdinfer {
+
+class InferenceRequest;
+
+/// What a model expects of one of its input tensors
+struct TensorBinding {
+  std::string name;
+  DataType datatype;
+  std::vector<int64_t> shape;
+  /// Size of the tensor in bytes or zero if the shape isn't fully known
+  size_t bytes;
+};
+
+/**
+ * @brief The input tensors of a model, in the model's order, made once from
+ * its metadata when it's loaded. Requests are bound to the table when they
+ * arrive so that their input i is the model's input i and workers can index
+ * their inputs by position instead of looking them up by name.
+ */
+class TensorBindings {
+ public:
+  TensorBindings() = default;
+  /**
+   * @brief Construct a new TensorBindings object
+   *
+   * @param tensors the model's input tensors, in order
+   */
+  explicit TensorBindings(const std::vector<Tensor>& tensors);
+
+  [[nodiscard]] bool empty() const;
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] const TensorBinding& operator[](size_t index) const;
+
+  /// Get the index of the named input or size() if there's no such input
+  [[nodiscard]] size_t find(std::string_view name) const;
+
+  /**
+   * @brief Bind a request's inputs to the model's inputs. If the request uses
+   * the names of all the model's inputs, its inputs are put in the model's
+   * order. Otherwise, they're bound by position and renamed to the model's
+   * names. Inputs past the model's last input are left as they are.
+   *
+   * A request may hold many samples if every bound input has one more
+   * dimension than the model's input and they all have the same size in it.
+   *
+   * @param request the request to bind
+   * @return size_t the number of samples along the request's extra leading
+   * dimension or 1 if it doesn't have one
+   * @throws invalid_argument if a named input is missing or a sample of an
+   * input is larger than the model's input
+   */
+  size_t bind(InferenceRequest* request) const;
+
+  /**
+   * @brief Get the number of samples a request counts as in a batch if it's
+   * kept whole. Without the model's inputs, requests can't be split and their
+   * first input's leading dimension may or may not be a batch dimension. Its
+   * size is only used to size batches so a request with more samples than the
+   * batch size is sent in a batch of its own rather than rejected. With the
+   * model's inputs, bind() counts the samples and they're split instead.
+   *
+   * @param request the request
+   * @return size_t 1 if the model's inputs are known
+   */
+  [[nodiscard]] size_t unboundSamples(const InferenceRequest& request) const;
+
+ private:
+  /// Get the number of samples in the request's leading dimension
+  [[nodiscard]] size_t samples(const InferenceRequest& request) const;
+
+  std::vector<TensorBinding> bindings_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_TENSOR_BINDINGS
@@ -0,0 +1,199 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements reading and writing trace files
+ */
+
+#include "amdinfer/core/traffic_trace.hpp"
+
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t, int64_t
+#include <cstring>      // for memcpy
+#include <string_view>  // for string_view
+#include <utility>      // for move
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/util/wire.hpp"        // for WireReader, writeInt
+
+namespace amdinfer {
+
+namespace {
+
+constexpr std::string_view kMagic{"AMDT"};
+constexpr uint32_t kVersion = 1;
+// records larger than this are assumed to be corrupt instead of allocated
+constexpr uint64_t kMaxRecordSize = uint64_t{1} << 32;
+
+}  // namespace
+
+TraceWriter::TraceWriter(const std::filesystem::path& path, bool payload)
+  : payload_(payload), file_(path, std::ios::binary | std::ios::trunc) {
+  if (!file_) {
+    throw runtime_error("Couldn't open the trace " + path.string());
+  }
+  std::string header{kMagic};
+  util::writeInt(kVersion, &header);
+  file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+void TraceWriter::write(std::chrono::nanoseconds time, const std::string& model,
+                        const std::string& version,
+                        const InferenceRequest& request) {
+  // the record is built before taking the lock so writers only wait on the
+  // copy into the file's buffer
+  std::string record;
+  util::writeInt(static_cast<uint64_t>(time.count()), &record);
+  util::writeString(model, &record);
+  util::writeString(version, &record);
+  util::writeString(request.getID(), &record);
+  util::writeParameters(request.getParameters(), &record);
+  util::writeInt(static_cast<uint8_t>(payload_), &record);
+
+  const auto& inputs = request.getInputs();
+  util::writeInt(static_cast<uint32_t>(inputs.size()), &record);
+  for (const auto& input : inputs) {
+    util::writeString(input.getName(), &record);
+    util::writeInt(static_cast<uint8_t>(input.getDatatype()), &record);
+    const auto& shape = input.getShape();
+    util::writeInt(static_cast<uint32_t>(shape.size()), &record);
+    for (const auto& dim : shape) {
+      util::writeInt(static_cast<uint64_t>(dim), &record);
+    }
+    util::writeParameters(input.getParameters(), &record);
+    if (payload_) {
+      const auto size = input.getSize() * input.getDatatype().size();
+      util::writeInt(static_cast<uint64_t>(size), &record);
+      const auto offset = record.size();
+      record.resize(offset + size);
+      if (size > 0) {
+        input.copyData(record.data() + offset);
+      }
+    }
+  }
+
+  const auto& outputs = request.getOutputs();
+  util::writeInt(static_cast<uint32_t>(outputs.size()), &record);
+  for (const auto& output : outputs) {
+    util::writeString(output.getName(), &record);
+  }
+
+  std::string size;
+  util::writeInt(static_cast<uint64_t>(record.size()), &size);
+  const std::lock_guard lock{mutex_};
+  file_.write(size.data(), static_cast<std::streamsize>(size.size()));
+  file_.write(record.data(), static_cast<std::streamsize>(record.size()));
+}
+
+void TraceWriter::flush() {
+  const std::lock_guard lock{mutex_};
+  file_.flush();
+}
+
+TraceReader::TraceReader(const std::filesystem::path& path)
+  : file_(path, std::ios::binary) {
+  if (!file_) {
+    throw file_read_error("Couldn't open the trace " + path.string());
+  }
+  std::string header(kMagic.size() + sizeof(kVersion), '\0');
+  file_.read(header.data(), static_cast<std::streamsize>(header.size()));
+  if (!file_ || std::string_view{header}.substr(0, kMagic.size()) != kMagic) {
+    throw invalid_argument(path.string() + " is not a trace");
+  }
+  util::WireReader reader{std::string_view{header}.substr(kMagic.size()),
+                          "trace"};
+  const auto version = reader.readInt<uint32_t>();
+  if (version != kVersion) {
+    throw invalid_argument("Unsupported trace version " +
+                           std::to_string(version));
+  }
+}
+
+bool TraceReader::read(TraceRecord* record) {
+  std::string size_bytes(sizeof(uint64_t), '\0');
+  file_.read(size_bytes.data(),
+             static_cast<std::streamsize>(size_bytes.size()));
+  if (file_.gcount() == 0) {
+    return false;
+  }
+  if (file_.gcount() != static_cast<std::streamsize>(size_bytes.size())) {
+    throw invalid_argument("The trace record is truncated");
+  }
+  const auto size =
+    util::WireReader{size_bytes, "trace record"}.readInt<uint64_t>();
+  if (size > kMaxRecordSize) {
+    throw invalid_argument("The trace record is corrupt");
+  }
+  std::string bytes(size, '\0');
+  file_.read(bytes.data(), static_cast<std::streamsize>(size));
+  if (static_cast<uint64_t>(file_.gcount()) != size) {
+    throw invalid_argument("The trace record is truncated");
+  }
+
+  util::WireReader reader{bytes, "trace record"};
+  TraceRecord parsed;
+  parsed.time = std::chrono::nanoseconds(reader.readInt<uint64_t>());
+  parsed.model = reader.readString();
+  parsed.version = reader.readString();
+  parsed.request.setID(reader.readString());
+  parsed.request.setParameters(reader.readParameters());
+  parsed.payload = reader.readInt<uint8_t>() != 0;
+
+  const auto input_count = reader.readInt<uint32_t>();
+  parsed.data.reserve(input_count);
+  parsed.request.reserveTensors(input_count, 0);
+  for (auto i = 0U; i < input_count; ++i) {
+    auto name = reader.readString();
+    const DataType datatype{
+      static_cast<DataType::Value>(reader.readInt<uint8_t>())};
+    const auto rank = reader.readInt<uint32_t>();
+    std::vector<int64_t> shape;
+    shape.reserve(rank);
+    for (auto j = 0U; j < rank; ++j) {
+      shape.push_back(static_cast<int64_t>(reader.readInt<uint64_t>()));
+    }
+    auto parameters = reader.readParameters();
+
+    InferenceRequestInput input{nullptr, shape, datatype, std::move(name)};
+    input.setParameters(std::move(parameters));
+    const auto expected = input.getSize() * datatype.size();
+    auto& data = parsed.data.emplace_back();
+    if (parsed.payload) {
+      const auto data_size = reader.readInt<uint64_t>();
+      if (data_size != expected) {
+        throw invalid_argument("The size of input " + input.getName() +
+                               " doesn't match its shape");
+      }
+      const auto payload = reader.take(data_size);
+      data.resize(data_size);
+      std::memcpy(data.data(), payload.data(), data_size);
+    } else {
+      data.resize(expected, std::byte{0});
+    }
+    input.setData(data.data());
+    parsed.request.addInputTensor(std::move(input));
+  }
+
+  const auto output_count = reader.readInt<uint32_t>();
+  for (auto i = 0U; i < output_count; ++i) {
+    InferenceRequestOutput output;
+    output.setName(reader.readString());
+    parsed.request.addOutputTensor(std::move(output));
+  }
+
+  *record = std::move(parsed);
+  return true;
+}
+
+}  // namespace amdinfer
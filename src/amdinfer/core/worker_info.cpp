@@ -21,56 +21,58 @@
 
 #include "amdinfer/core/worker_info.hpp"
 
-#include <dlfcn.h>  // for dlerror, dlopen, dlsym, RTL...
+#include <dlfcn.h>  // for dlerror, dlsym
 
-#include <cctype>       // for toupper
+#include <algorithm>    // for any_of, max
+#include <array>        // for array
+#include <chrono>       // for nanoseconds
 #include <climits>      // for UINT_MAX
 #include <cstdint>      // for int32_t
 #include <exception>    // for exception
+#include <iomanip>      // for setprecision
+#include <memory>       // for make_shared
+#include <sstream>      // for ostringstream
 #include <string>       // for string, operator+, basic_st...
 #include <type_traits>  // for remove_reference<>::type
-#include <utility>      // for pair, move, make_pair
+#include <utility>      // for pair, move, make_pair, exchange
 
 #include "amdinfer/batching/batcher.hpp"  // for Batcher, BatcherStatus, Bat...
+#include "amdinfer/core/device_scheduler.hpp"  // for DeviceScheduler
 #include "amdinfer/core/exceptions.hpp"   // for invalid_argument, external_...
-#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
-#include "amdinfer/core/parameters.hpp"         // for ParameterMap
-#include "amdinfer/core/request_container.hpp"  // for ModelMetadata
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/multiplexer.hpp"         // for Multiplexer
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/request_container.hpp"   // for ModelMetadata
+#include "amdinfer/core/versioned_endpoint.hpp"  // for splitVersionedEndpoint
+#include "amdinfer/core/worker_libraries.hpp"    // for WorkerLibraries
+#include "amdinfer/observation/logging.hpp"      // for AMDINFER_LOG_INFO
+#include "amdinfer/observation/metrics.hpp"      // for ModelMetrics
+#include "amdinfer/util/numa.hpp"                // for bindThreadToCpus
+#include "amdinfer/util/string.hpp"              // for split
 #include "amdinfer/workers/worker.hpp"  // for Worker, WorkerStatus, Worke...
 
 namespace amdinfer {
 
-void* getHandle(const std::string& name) {
-  // multiple workers with different configurations may exist. Remove the config
-  // tag that starts with "-" in the name prior to loading the .so
-  auto lib_name = name;
-  lib_name[0] = static_cast<char>(std::toupper(lib_name[0]));
-  if (auto hyphen_pos = name.find('-'); hyphen_pos != std::string::npos) {
-    lib_name.erase(hyphen_pos);
+using LoadClock = std::chrono::steady_clock;
+
+#ifdef AMDINFER_ENABLE_METRICS
+// the gauge of each phase, in the order of LoadPhase
+constexpr std::array kLoadGauges{
+  MetricGaugeIDs::LoadOpen,         MetricGaugeIDs::LoadInit,
+  MetricGaugeIDs::LoadReadModel,    MetricGaugeIDs::LoadCompile,
+  MetricGaugeIDs::LoadCreateRunner, MetricGaugeIDs::LoadAcquire,
+  MetricGaugeIDs::LoadReserve,      MetricGaugeIDs::LoadWarmup,
+  MetricGaugeIDs::LoadStart};
+static_assert(kLoadGauges.size() == static_cast<size_t>(LoadPhase::Count));
+#endif
+
+/// Add up the time of all the phases
+std::chrono::nanoseconds getTotal(const LoadTimes& times) {
+  std::chrono::nanoseconds total{0};
+  for (const auto& time : times) {
+    total += time;
   }
-  std::string library =
-    std::string("libworker") + lib_name + std::string(".so");
-
-  // reset errors
-  dlerror();
-
-  /*
-  Open the needed object. The dlopen flags used here:
-    - RTLD_LOCAL: the symbols are not made available to other loaded libs
-    - RTLD_LAZY: resolve symbols as needed. We only need one anyway
-  Adding RTLD_DEEPBIND here creates problems:
-    - Cannot use std::cout in the library
-      (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=42679)
-    - std::regex gives a segfault
-  There are many SO posts reporting problems related to issues with DEEPBIND
-  The motivation to add DEEPBIND is to isolate the loaded workers. For example,
-  if the library is using a different version of a library that we are already
-  using, it can link to the wrong version. Another option for isolating the
-  workers is dlmopen but that also should not be used here due to its own set of
-  issues (https://sourceware.org/bugzilla/show_bug.cgi?id=24776).
-  */
-  void* handle = dlopen(library.c_str(), RTLD_LOCAL | RTLD_LAZY);
-  return handle;
+  return total;
 }
 
 /**
@@ -107,12 +109,26 @@ workers::Worker* getWorker(void* handle) {
   return worker;
 }
 
-WorkerInfo::WorkerInfo(const std::string& name, ParameterMap* parameters,
+WorkerInfo::WorkerInfo([[maybe_unused]] const std::string& endpoint,
+                       const std::string& name, ParameterMap* parameters,
                        MemoryPool* pool, BatchPtrQueue* next,
-                       std::vector<MemoryAllocators> next_allocators)
-  : next_(next), next_allocators_(std::move(next_allocators)) {
-  handle_ = getHandle(name);
+                       std::vector<MemoryAllocators> next_allocators,
+                       const Batcher* next_batcher)
+  : next_(next),
+    pool_(pool),
+    next_allocators_(std::move(next_allocators)),
+    next_batcher_(next_batcher) {
+#ifdef AMDINFER_ENABLE_METRICS
+  const auto [model, version] = splitVersionedEndpoint(endpoint);
+  metrics_ = std::make_shared<ModelMetrics>(model, version, name);
+#endif
+  const auto start = LoadClock::now();
+  handle_ = WorkerLibraries::getInstance().open(name);
+  open_time_ = LoadClock::now() - start;
   this->addAndStartWorker(name, parameters, pool);
+  if (parameters->has("slab_slots")) {
+    this->addSlabs(parameters->get<int32_t>("slab_slots"), pool);
+  }
 }
 
 WorkerInfo::~WorkerInfo() {
@@ -120,30 +136,152 @@ WorkerInfo::~WorkerInfo() {
   for (const auto& [thread_id, worker] : workers_) {
     delete worker;  // NOLINT(cppcoreguidelines-owning-memory)
   }
-  dlclose(handle_);
-  handle_ = nullptr;
+  // the library is closed once no endpoint uses it
+  handle_.reset();
 }
 
 void WorkerInfo::addAndStartWorker(const std::string& name,
                                    ParameterMap* parameters, MemoryPool* pool) {
-  auto* worker = getWorker(handle_);
-  worker->init(parameters);
-
-  std::vector<MemoryAllocators> allocators = worker->getAllocators();
-  ;
+  LoadTimes times{};
+  times.at(static_cast<size_t>(LoadPhase::Open)) =
+    std::exchange(open_time_, std::chrono::nanoseconds{0});
+
+  if (!parameters->has("devices")) {
+    this->startWorker(name, parameters, pool, &times);
+    loads_.push_back(1);
+    load_times_ = times;
+    this->reportLoadTimes(name);
+    return;
+  }
 
+  const auto devices =
+    util::split(parameters->get<std::string>("devices"), ",");
+  if (devices.empty()) {
+    throw invalid_argument("devices must list at least one device");
+  }
+  size_t started = 0;
   try {
-    worker->acquire(parameters);
-  } catch (const std::exception& e) {
-    throw external_error(e.what());
+    for (const auto& device : devices) {
+      auto device_parameters = *parameters;
+      device_parameters.erase("devices");
+      device_parameters.put("device", std::stoi(device));
+      this->startWorker(name, &device_parameters, pool, &times);
+      started++;
+    }
   } catch (...) {
-    throw runtime_error("Unknown error occurred");
+    for (auto i = 0U; i < started; ++i) {
+      this->unloadWorker();
+    }
+    throw;
+  }
+  loads_.push_back(started);
+  load_times_ = times;
+  this->reportLoadTimes(name);
+}
+
+void WorkerInfo::startWorker(const std::string& name, ParameterMap* parameters,
+                             MemoryPool* pool, LoadTimes* times) {
+  auto* worker = getWorker(handle_.get());
+  if (parameters->has("multiplex")) {
+    // the multiplexer has no thread per worker to tell the workers apart by
+    if (!worker->isMultiplexable() || !this->workers_.empty()) {
+      delete worker;  // NOLINT(cppcoreguidelines-owning-memory)
+      throw invalid_argument(
+        "Multiplexed endpoints must have one worker of a type that supports "
+        "it");
+    }
+    this->multiplexer_ =
+      Multiplexer::get(parameters->get<std::string>("multiplex"));
+  }
+  // the workers of endpoints with a weight take turns on their device with
+  // the other endpoints that have one
+  if (parameters->has("device_weight")) {
+    const auto weight = parameters->get<int32_t>("device_weight");
+    if (weight < 1) {
+      delete worker;  // NOLINT(cppcoreguidelines-owning-memory)
+      throw invalid_argument("device_weight must be positive");
+    }
+    const auto device =
+      parameters->has("device")
+        ? std::to_string(parameters->get<int32_t>("device"))
+        : std::string{"0"};
+    auto scheduler = DeviceScheduler::get(device);
+    if (parameters->has("device_slots")) {
+      scheduler->setSlots(static_cast<size_t>(
+        std::max(parameters->get<int32_t>("device_slots"), 1)));
+    }
+    worker->setDeviceShare(
+      scheduler->join(name, static_cast<uint32_t>(weight)));
+  }
+  // time a step of the load, less the phases the worker timed itself in it
+  const auto timed = [&](LoadPhase phase, const auto& step) {
+    const auto reported = getTotal(worker->getLoadTimes());
+    const auto start = LoadClock::now();
+    step();
+    const auto elapsed = LoadClock::now() - start;
+    times->at(static_cast<size_t>(phase)) +=
+      elapsed - (getTotal(worker->getLoadTimes()) - reported);
+  };
+
+  timed(LoadPhase::Init, [&]() { worker->init(parameters); });
+
+  std::vector<MemoryAllocators> allocators = worker->getAllocators();
+
+  timed(LoadPhase::Acquire, [&]() {
+    try {
+      worker->acquire(parameters);
+    } catch (const std::exception& e) {
+      throw external_error(e.what());
+    } catch (...) {
+      throw runtime_error("Unknown error occurred");
+    }
+  });
+  for (auto i = 0U; i < times->size(); ++i) {
+    times->at(i) += worker->getLoadTimes().at(i);
   }
 
   this->batch_size_ = worker->getBatchSize();
   worker->setNext(next_);
-  worker->setNextAllocators(next_allocators_);
+#ifdef AMDINFER_ENABLE_METRICS
+  worker->setMetrics(metrics_.get());
+#endif
+  // batches that fit the next worker are handed to it in place. Larger ones
+  // are split up in host memory and batched again for it, as are the batches
+  // for a multiplexed worker so its batcher wakes its multiplexer
+  if (next_batcher_ != nullptr &&
+      (this->batch_size_ > next_batcher_->getBatchSize() ||
+       next_batcher_->hasDoorbell())) {
+    worker->setNextBatcher(next_batcher_);
+    worker->setNextAllocators({MemoryAllocators::Cpu});
+  } else {
+    worker->setNextAllocators(next_allocators_);
+  }
 
+  // reserve the worker's steady-state memory so the first requests after the
+  // load don't pay for growing the pool. This is best-effort
+  timed(LoadPhase::Reserve, [&]() {
+    for (const auto& reservation : worker->getReservations()) {
+      try {
+        pool->reserve(reservation);
+      } catch (const runtime_error&) {
+        continue;
+      }
+    }
+  });
+
+  // warm up after the reservation so the warm-up batches use reserved memory
+  timed(LoadPhase::Warmup, [&]() {
+    try {
+      worker->warmup(pool);
+    } catch (const std::exception& e) {
+      worker->release();
+      worker->destroy();
+      delete worker;  // NOLINT(cppcoreguidelines-owning-memory)
+      throw external_error(std::string{"Warm-up failed: "} + e.what());
+    }
+  });
+
+  const auto start = LoadClock::now();
   if (this->batchers_.empty()) {
     int32_t batcher_count = 1;
     if (parameters->has("batchers")) {
@@ -154,6 +292,12 @@ void WorkerInfo::addAndStartWorker(const std::string& name,
     for (const auto& batcher : this->batchers_) {
       batcher->setName(name);
       batcher->setBatchSize(this->batch_size_);
+      if (this->multiplexer_ != nullptr) {
+        batcher->setDoorbell(this->multiplexer_->getDoorbell());
+      }
+#ifdef AMDINFER_ENABLE_METRICS
+      batcher->setMetrics(metrics_);
+#endif
     }
   }
 
@@ -162,13 +306,56 @@ void WorkerInfo::addAndStartWorker(const std::string& name,
       batcher->start(allocators);
     }
   }
+  if (this->multiplexer_ != nullptr) {
+    this->multiplexer_->add(worker, this->batchers_[0]->getOutputQueue(), pool);
+    // there's no thread so its ID is the default one
+    this->workers_.insert(std::make_pair(std::thread::id{}, worker));
+    times->at(static_cast<size_t>(LoadPhase::Start)) +=
+      LoadClock::now() - start;
+    return;
+  }
+
   std::thread thread{&workers::Worker::run, worker,
                      this->batchers_[0]->getOutputQueue(), pool};
 
+  if (parameters->has("cpus")) {
+    util::bindThreadToCpus(
+      thread, util::parseIdList(parameters->get<std::string>("cpus")));
+  } else if (parameters->has("numa_node")) {
+    util::bindThreadToNumaNode(thread, parameters->get<int32_t>("numa_node"));
+  }
+
   auto thread_id = thread.get_id();
 
   this->worker_threads_.insert(std::make_pair(thread_id, std::move(thread)));
   this->workers_.insert(std::make_pair(thread_id, worker));
+  this->setInline();
+  times->at(static_cast<size_t>(LoadPhase::Start)) += LoadClock::now() - start;
+}
+
+void WorkerInfo::reportLoadTimes([[maybe_unused]] const std::string& name)
+  const {
+#ifdef AMDINFER_ENABLE_LOGGING
+  Logger logger{Loggers::Server};
+  std::ostringstream message;
+  message << std::fixed << std::setprecision(1) << "Loaded " << name << " in "
+          << std::chrono::duration<double, std::milli>(getTotal(load_times_))
+               .count()
+          << " ms:";
+  for (auto i = 0U; i < load_times_.size(); ++i) {
+    message << " " << getLoadPhaseName(static_cast<LoadPhase>(i)) << " "
+            << std::chrono::duration<double, std::milli>(load_times_.at(i))
+                 .count()
+            << " ms";
+  }
+  AMDINFER_LOG_INFO(logger, message.str());
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  for (auto i = 0U; i < load_times_.size(); ++i) {
+    metrics_->setGauge(kLoadGauges.at(i),
+                       std::chrono::duration<double>(load_times_.at(i)).count());
+  }
+#endif
 }
 
 Batcher* WorkerInfo::getBatcher() { return this->batchers_[0].get(); }
@@ -193,7 +380,50 @@ void WorkerInfo::joinAll() {
 }
 
 void WorkerInfo::unload() {
-  this->batchers_[0]->getOutputQueue()->enqueue(nullptr);
+  if (loads_.empty()) {
+    return;
+  }
+  const auto workers = loads_.back();
+  loads_.pop_back();
+  for (auto i = 0U; i < workers; ++i) {
+    this->unloadWorker();
+  }
+}
+
+void WorkerInfo::setInline() {
+  // with many workers, running inline on one of them would bypass the others
+  workers::Worker* worker = nullptr;
+  if (this->workers_.size() == 1 && this->multiplexer_ == nullptr) {
+    worker = this->workers_.begin()->second;
+  }
+  for (const auto& batcher : this->batchers_) {
+    if (worker != nullptr && worker->isInlineSafe()) {
+      batcher->setInline([worker, pool = pool_](BatchPtr batch) {
+        try {
+          worker->runBatch(std::move(batch), pool);
+        } catch (const std::exception& e) {
+          AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
+          AMDINFER_LOG_ERROR(logger, worker->getName() +
+                                       " failed to run a batch: " + e.what());
+        }
+      });
+    } else {
+      batcher->setInline(nullptr);
+    }
+  }
+}
+
+void WorkerInfo::unloadWorker() {
+  // wait for the batches running inline on the worker that may be unloaded
+  for (const auto& batcher : this->batchers_) {
+    batcher->setInline(nullptr);
+  }
+  if (this->multiplexer_ != nullptr) {
+    // the multiplexer runs the batches already queued for the worker first
+    this->multiplexer_->remove(this->workers_.begin()->second);
+  } else {
+    this->batchers_[0]->getOutputQueue()->enqueue(nullptr);
+  }
 
   bool last_worker = this->workers_.size() == 1;
   if (last_worker) {
@@ -215,7 +445,7 @@ void WorkerInfo::unload() {
   }
 
   std::thread::id id;
-  bool found = false;
+  bool found = this->multiplexer_ != nullptr;
   while (!found) {
     for (const auto& [thread_id, worker] : this->workers_) {
       if (worker->getStatus() == workers::WorkerStatus::Inactive) {
@@ -232,15 +462,66 @@ void WorkerInfo::unload() {
 
   if (last_worker) {
     delete worker;  // NOLINT(cppcoreguidelines-owning-memory)
+    this->multiplexer_.reset();
   }
   this->workers_.erase(id);
+  this->setInline();
+}
+
+void WorkerInfo::addSlabs(int32_t slots, const MemoryPool* pool) {
+  if (slots <= 0) {
+    return;
+  }
+  // requests' tensors are allocated as they arrive and the batches' tensors
+  // for full batches. Tensors whose shapes vary aren't known in advance
+  const auto metadata = this->getMetadata();
+  std::vector<size_t> sizes;
+  for (const auto* tensors : {&metadata.getInputs(), &metadata.getOutputs()}) {
+    for (const auto& tensor : *tensors) {
+      const auto& shape = tensor.getShape();
+      if (std::any_of(shape.begin(), shape.end(),
+                      [](auto dim) { return dim <= 0; })) {
+        continue;
+      }
+      const auto size = tensor.getSize() * tensor.getDatatype().size();
+      sizes.push_back(size);
+      sizes.push_back(size * this->batch_size_);
+    }
+  }
+  if (!sizes.empty()) {
+    slabs_ = pool->addSlabs(std::move(sizes), static_cast<size_t>(slots));
+  }
 }
 
 size_t WorkerInfo::getGroupSize() const { return this->workers_.size(); }
 
+std::chrono::nanoseconds WorkerInfo::getBusyTime() const {
+  std::chrono::nanoseconds busy{0};
+  for (const auto& [thread_id, worker] : workers_) {
+    busy += worker->getBusyTime();
+  }
+  return busy;
+}
+
+void WorkerInfo::setBatcherTimeout(int32_t timeout) {
+  for (const auto& batcher : batchers_) {
+    batcher->setTimeout(timeout);
+  }
+}
+
+void WorkerInfo::setBatcherBatchSize(int32_t batch_size) {
+  // the workers' buffers are only sized for their own batch size
+  if (batch_size < 1 || static_cast<size_t>(batch_size) > this->batch_size_) {
+    throw invalid_argument("The batch size must be between 1 and " +
+                           std::to_string(this->batch_size_));
+  }
+  for (const auto& batcher : batchers_) {
+    batcher->setBatchSize(static_cast<size_t>(batch_size));
+  }
+}
+
 void WorkerInfo::shutdown() {
-  auto workers = this->getGroupSize();
-  for (auto i = 0U; i < workers; i++) {
+  while (!loads_.empty()) {
     this->unload();
   }
 }
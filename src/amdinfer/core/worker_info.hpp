@@ -22,22 +22,27 @@
 #ifndef GUARD_AMDINFER_CORE_WORKER_INFO
 #define GUARD_AMDINFER_CORE_WORKER_INFO
 
+#include <chrono>   // for nanoseconds
 #include <cstddef>  // for size_t
+#include <cstdint>  // for int32_t
 #include <map>      // for map
-#include <memory>   // for unique_ptr
+#include <memory>   // for unique_ptr, shared_ptr
 #include <string>   // for string
 #include <thread>   // for thread, thread::id
 #include <vector>   // for vector
 
-#include "amdinfer/batching/batcher.hpp"  // for BatchPtrQueue
-#include "amdinfer/declarations.hpp"      // for BufferPtr
-#include "amdinfer/util/queue.hpp"        // for BufferPtrsQueuePtr
+#include "amdinfer/batching/batcher.hpp"        // for BatchPtrQueue
+#include "amdinfer/declarations.hpp"            // for BufferPtr
+#include "amdinfer/observation/load_times.hpp"  // for LoadTimes
+#include "amdinfer/util/queue.hpp"              // for BufferPtrsQueuePtr
 
 namespace amdinfer {
 class Batcher;
 class ParameterMap;
 class ModelMetadata;
+class ModelMetrics;
 class MemoryPool;
+class Multiplexer;
 namespace workers {
 class Worker;
 }  // namespace workers
@@ -51,10 +56,24 @@ namespace amdinfer {
  */
 class WorkerInfo {
  public:
-  /// Construct a new WorkerInfo object
-  WorkerInfo(const std::string& name, ParameterMap* parameters,
-             MemoryPool* pool, BatchPtrQueue* next,
-             std::vector<MemoryAllocators> next_allocators);
+  /**
+   * @brief Construct a new WorkerInfo object
+   *
+   * @param endpoint the endpoint the worker group serves. Its metrics are
+   * labelled with it
+   * @param name the worker to load
+   * @param parameters the load-time parameters
+   * @param pool the memory pool
+   * @param next the queue the workers send their finished batches to
+   * @param next_allocators the allocators to use for the finished batches
+   * @param next_batcher the batcher of the next endpoint in a chain or nullptr.
+   * If its batch size is smaller than the workers', their finished batches are
+   * batched again by it instead of being sent to the next queue
+   */
+  WorkerInfo(const std::string& endpoint, const std::string& name,
+             ParameterMap* parameters, MemoryPool* pool, BatchPtrQueue* next,
+             std::vector<MemoryAllocators> next_allocators,
+             const Batcher* next_batcher = nullptr);
   ~WorkerInfo();                           ///> Destroy a WorkerInfo object
   WorkerInfo(WorkerInfo const&) = delete;  ///< Copy constructor
   /// Copy assignment constructor
@@ -81,7 +100,10 @@ class WorkerInfo {
 
   /**
    * @brief Start a new worker in the group with the given parameters. The name
-   * is used to uniquely identify a particular worker to dynamically load.
+   * is used to uniquely identify a particular worker to dynamically load. If
+   * the parameters have a comma-separated list of "devices", one worker is
+   * started for each device with its "device" parameter set. If any of them
+   * fails to start, the others are unloaded.
    *
    * @param name
    * @param parameters pointer to parameters. Should not be nullptr
@@ -89,7 +111,7 @@ class WorkerInfo {
   void addAndStartWorker(const std::string& name, ParameterMap* parameters,
                          MemoryPool* pool);
 
-  /// unload one worker from this worker group
+  /// unload the workers started by the last load from this worker group
   void unload();
   /// unload all workers from this worker group
   void shutdown();
@@ -97,21 +119,81 @@ class WorkerInfo {
   /// get the number of workers in the group
   [[nodiscard]] size_t getGroupSize() const;
 
+  /// get the total time the workers in the group have spent running batches
+  [[nodiscard]] std::chrono::nanoseconds getBusyTime() const;
+
+  /**
+   * @brief Get the time the last call to addAndStartWorker() spent in each
+   * phase, summed over the workers it started. Opening the worker's library
+   * is counted in the first load only
+   *
+   * @return const LoadTimes&
+   */
+  [[nodiscard]] const LoadTimes& getLoadTimes() const {
+    return this->load_times_;
+  }
+
   /// get the batch size of the worker group
   [[nodiscard]] auto getBatchSize() const { return this->batch_size_; }
+  /// set how long the group's batchers wait to fill a batch, in milliseconds
+  void setBatcherTimeout(int32_t timeout);
+  /**
+   * @brief Set how many requests the group's batchers put in a batch. Throws
+   * invalid_argument if it's less than one or more than the workers' batch size
+   *
+   * @param batch_size the batch size
+   */
+  void setBatcherBatchSize(int32_t batch_size);
 
   std::vector<MemoryAllocators> getAllocators() const;
 
   ModelMetadata getMetadata() const;
 
  private:
+  /// Start one worker in the group and add the time of each phase to times
+  void startWorker(const std::string& name, ParameterMap* parameters,
+                   MemoryPool* pool, LoadTimes* times);
+  /// Log the time of each phase of the last load and publish it as metrics
+  void reportLoadTimes(const std::string& name) const;
+  /// Unload one worker from the group
+  void unloadWorker();
+  /**
+   * @brief Add slabs to the pool for the sizes of the group's tensors, one at
+   * a time and in full batches, so they don't fragment the shared memory
+   *
+   * @param slots number of slots of each size
+   * @param pool the memory pool
+   */
+  void addSlabs(int32_t slots, const MemoryPool* pool);
+  /**
+   * @brief Let the batchers run batches of one inline on the group's worker if
+   * it's the only one, it has its own thread and it's inline-safe
+   */
+  void setInline();
+
+#ifdef AMDINFER_ENABLE_METRICS
+  std::shared_ptr<ModelMetrics> metrics_;
+#endif
   std::map<std::thread::id, std::thread> worker_threads_;
-  void* handle_ = nullptr;
+  /// The worker's library, shared with the other endpoints of the worker
+  std::shared_ptr<void> handle_;
   std::map<std::thread::id, workers::Worker*> workers_;
   std::vector<std::unique_ptr<Batcher>> batchers_;
   size_t batch_size_ = 1;
   BatchPtrQueue* next_;
+  // the pool the workers run their batches with
+  const MemoryPool* pool_;
   std::vector<MemoryAllocators> next_allocators_;
+  const Batcher* next_batcher_;
+  // slabs for the group's tensors if it was loaded with "slab_slots"
+  std::shared_ptr<void> slabs_;
+  // runs the worker's batches if it was loaded with "multiplex"
+  std::shared_ptr<Multiplexer> multiplexer_;
+  // number of workers started by each load, in order
+  std::vector<size_t> loads_;
+  // time spent opening the library, until it's added to the first load
+  std::chrono::nanoseconds open_time_{0};
+  LoadTimes load_times_{};
 
   friend class Manager;
 };
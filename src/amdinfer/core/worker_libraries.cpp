@@ -0,0 +1,140 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Implements the cache of the workers' shared libraries
+ */
+
+#include "amdinfer/core/worker_libraries.hpp"
+
+#include <dlfcn.h>  // for dlopen, dlclose, dlerror, RTLD_LAZY, RTLD_NOW
+
+#include <cctype>   // for toupper
+#include <chrono>   // for steady_clock, duration
+#include <utility>  // for move
+
+#include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/exceptions.hpp"      // for file_not_found_error
+#include "amdinfer/observation/logging.hpp"  // for Logger, AMDINFER_LOG_INFO
+#include "amdinfer/observation/metrics.hpp"  // for Metrics, MetricGaugeIDs
+#include "amdinfer/util/thread.hpp"          // for setThreadName
+
+namespace amdinfer {
+
+namespace {
+
+std::string getLibrary(const std::string& name) {
+  // multiple workers with different configurations may exist. Remove the config
+  // tag that starts with "-" in the name prior to loading the .so
+  auto lib_name = name;
+  if (auto hyphen_pos = name.find('-'); hyphen_pos != std::string::npos) {
+    lib_name.erase(hyphen_pos);
+  }
+  if (!lib_name.empty()) {
+    lib_name[0] = static_cast<char>(std::toupper(lib_name[0]));
+  }
+  return std::string("libworker") + lib_name + std::string(".so");
+}
+
+void* openLibrary(const std::string& library, int binding) {
+  // reset errors
+  dlerror();
+
+  /*
+  Open the needed object. The dlopen flags used here:
+    - RTLD_LOCAL: the symbols are not made available to other loaded libs
+    - binding: RTLD_LAZY to resolve symbols as needed or RTLD_NOW to resolve
+      them all while opening
+  Adding RTLD_DEEPBIND here creates problems:
+    - Cannot use std::cout in the library
+      (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=42679)
+    - std::regex gives a segfault
+  There are many SO posts reporting problems related to issues with DEEPBIND
+  The motivation to add DEEPBIND is to isolate the loaded workers. For example,
+  if the library is using a different version of a library that we are already
+  using, it can link to the wrong version. Another option for isolating the
+  workers is dlmopen but that also should not be used here due to its own set of
+  issues (https://sourceware.org/bugzilla/show_bug.cgi?id=24776).
+  */
+  return dlopen(library.c_str(), RTLD_LOCAL | binding);
+}
+
+}  // namespace
+
+WorkerLibraries::~WorkerLibraries() { this->wait(); }
+
+std::shared_ptr<void> WorkerLibraries::open(const std::string& name) {
+  const auto library = getLibrary(name);
+  const std::lock_guard lock{mutex_};
+  if (auto found = handles_.find(library); found != handles_.end()) {
+    if (auto handle = found->second.lock(); handle != nullptr) {
+      return handle;
+    }
+  }
+
+  // if the library was preloaded, this only adds a reference to it
+  void* handle = openLibrary(library, RTLD_LAZY);
+  if (handle == nullptr) {
+    const char* error = dlerror();
+    throw file_not_found_error(error != nullptr ? error
+                                                : "Could not open " + library);
+  }
+  std::shared_ptr<void> shared{handle, [](void* ptr) { dlclose(ptr); }};
+  handles_.insert_or_assign(library, shared);
+  return shared;
+}
+
+void WorkerLibraries::preload(std::vector<std::string> workers) {
+  const std::lock_guard lock{mutex_};
+  threads_.emplace_back([workers = std::move(workers)]() {
+    util::setThreadName("preload");
+    AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+    for (const auto& worker : workers) {
+      const auto library = getLibrary(worker);
+      const auto start = std::chrono::steady_clock::now();
+      // the handle is never closed so the library stays loaded with its
+      // symbols bound and later opens of it reuse it
+      if (openLibrary(library, RTLD_NOW) == nullptr) {
+        [[maybe_unused]] const char* error = dlerror();
+        AMDINFER_LOG_WARN(logger, "Failed to preload " + library + ": " +
+                                    (error != nullptr ? error : ""));
+        continue;
+      }
+      [[maybe_unused]] const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+      AMDINFER_LOG_INFO(logger, "Preloaded " + library + " in " +
+                                  std::to_string(elapsed.count() * 1000) +
+                                  " ms");
+#ifdef AMDINFER_ENABLE_METRICS
+      Metrics::getInstance().setGauge(MetricGaugeIDs::LibraryLoad,
+                                      {{"worker", worker}}, elapsed.count());
+#endif
+    }
+  });
+}
+
+void WorkerLibraries::wait() {
+  std::vector<std::thread> threads;
+  {
+    const std::lock_guard lock{mutex_};
+    threads.swap(threads_);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,91 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Defines the cache of the workers' shared libraries
+ */
+
+#ifndef GUARD_AMDINFER_CORE_WORKER_LIBRARIES
+#define GUARD_AMDINFER_CORE_WORKER_LIBRARIES
+
+#include <memory>         // for shared_ptr, weak_ptr
+#include <mutex>          // for mutex
+#include <string>         // for string
+#include <thread>         // for thread
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+namespace amdinfer {
+
+/**
+ * @brief Opens the workers' libworker*.so libraries. Endpoints of the same
+ * worker share one handle so the library is opened once while any of them is
+ * loaded. Libraries can also be preloaded as the server starts so that the
+ * dynamic linking and static initialization of heavy backends don't delay the
+ * first load of their workers.
+ */
+class WorkerLibraries {
+ public:
+  /// Get the singleton WorkerLibraries instance
+  static WorkerLibraries& getInstance() {
+    // Guaranteed to be destroyed. Instantiated on first use.
+    static WorkerLibraries instance;
+    return instance;
+  }
+  WorkerLibraries(WorkerLibraries const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  WorkerLibraries& operator=(const WorkerLibraries&) = delete;
+  WorkerLibraries(WorkerLibraries&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  WorkerLibraries& operator=(WorkerLibraries&& other) = delete;
+
+  /**
+   * @brief Get the library of a worker, opening it if no endpoint has it open.
+   * It's closed when the last handle is released unless it was preloaded.
+   * Throws file_not_found_error if it can't be opened
+   *
+   * @param name the worker, such as "migraphx" or an endpoint like
+   * "migraphx-0"
+   * @return std::shared_ptr<void> the handle from dlopen
+   */
+  std::shared_ptr<void> open(const std::string& name);
+
+  /**
+   * @brief Open the libraries of workers on a background thread with all
+   * their symbols bound immediately. Preloaded libraries stay open until the
+   * process exits. The time to open each one is logged and reported in the
+   * amdinfer_worker_library_load_seconds metric. Libraries that can't be
+   * opened are skipped with a warning
+   *
+   * @param workers the workers, such as "migraphx" or "ptzendnn"
+   */
+  void preload(std::vector<std::string> workers);
+  /// Wait until the libraries being preloaded are open
+  void wait();
+
+ private:
+  WorkerLibraries() = default;
+  ~WorkerLibraries();
+
+  std::mutex mutex_;
+  /// library -> handle shared by the workers that use it
+  std::unordered_map<std::string, std::weak_ptr<void>> handles_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_CORE_WORKER_LIBRARIES
@@ -19,16 +19,25 @@
  * the amdinfer-server executable
  */
 
+#include <unistd.h>  // for getpid
+
 #include <csignal>      // for signal, SIGINT, SIGTERM
+#include <cstddef>      // for size_t
 #include <cstdint>      // for uint16_t
-#include <cstdlib>      // for exit
+#include <cstdlib>      // for exit, setenv
 #include <cxxopts.hpp>  // for value, OptionAdder, Options
+#include <filesystem>   // for path, temp_directory_path
 #include <iostream>     // for operator<<, basic_ostream
 #include <string>       // for string, allocator, char_...
+#include <vector>       // for vector
 
 #include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_HTTP
+#include "amdinfer/core/exceptions.hpp"      // for runtime_error
 #include "amdinfer/observation/logging.hpp"  // for AMDINFER_LOG_INFO, Logger
+#include "amdinfer/observation/tracing.hpp"  // for setTraceSampling
 #include "amdinfer/servers/server.hpp"       // for Server
+#include "amdinfer/servers/supervisor.hpp"   // for Supervisor, getShare
+#include "amdinfer/util/numa.hpp"            // for parseIdList, formatIdList
 
 volatile bool usr_interrupt = false;
 
@@ -64,14 +73,50 @@ int main(int argc, char* argv[]) {
 
 #ifdef AMDINFER_ENABLE_HTTP
   uint16_t http_port = kDefaultHttpPort;
+  int http_threads = 0;
+  std::string http_cpus;
+  int http_decode_threads = 0;
 #endif
 #ifdef AMDINFER_ENABLE_GRPC
   uint16_t grpc_port = kDefaultGrpcPort;
+  std::string grpc_socket;
+#endif
+#ifdef AMDINFER_ENABLE_IO_URING
+  uint16_t uring_port = kDefaultUringPort;
+  int uring_threads = 0;
+  std::string uring_cpus;
 #endif
   std::string model_repository = "/mnt/models";
   bool repository_monitoring = false;
   bool use_polling_watcher = false;
   bool repository_load_existing = false;
+  bool lazy_loading = false;
+  size_t memory_budget = 0;
+  int idle_timeout = 0;
+  std::vector<std::string> preload_workers;
+  int target_latency = 0;
+  size_t max_inflight = 0;
+  double rate_limit = 0;
+  double rate_limit_burst = 0;
+  std::string tenant_header = "x-tenant-id";
+  double ready_load = 0;
+  // queued batches per worker that saturate an endpoint
+  const double default_saturated_batches = 4;
+  double saturated_batches = default_saturated_batches;
+  std::string worker_cpus;
+  int processes = 1;
+  std::string process_gpus;
+  std::string manifest;
+  bool restore = false;
+  std::string capture;
+  double capture_rate = 1;
+  bool capture_shapes = false;
+#ifdef AMDINFER_ENABLE_TRACING
+  double trace_sampling = 1;
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  bool usage_metrics = false;
+#endif
 
   try {
     cxxopts::Options options("amdinfer-server", "Inference in the cloud");
@@ -87,11 +132,99 @@ int main(int argc, char* argv[]) {
       cxxopts::value(repository_monitoring))
     ("use-polling-watcher", "Use polling to monitor model-repository directory",
       cxxopts::value(use_polling_watcher))
+    ("lazy-loading",
+      "Load the models in the model repository on their first request",
+      cxxopts::value(lazy_loading))
+    ("memory-budget",
+      "Memory in MiB that lazily loaded models may use before the least recently used are unloaded. 0 for no limit",
+      cxxopts::value(memory_budget))
+    ("idle-timeout",
+      "Seconds after which an unused lazily loaded model is unloaded. 0 to keep them loaded",
+      cxxopts::value(idle_timeout))
+    ("preload-workers",
+      "Comma-separated workers whose libraries are opened in the background as the server starts, such as migraphx,ptzendnn",
+      cxxopts::value(preload_workers))
+    ("target-latency",
+      "Milliseconds within which requests should be served. If none are for 100 ms, new requests are refused until one is. 0 to disable",
+      cxxopts::value(target_latency))
+    ("max-inflight",
+      "Most requests in flight in the server before new ones are refused. 0 for no limit",
+      cxxopts::value(max_inflight))
+    ("rate-limit",
+      "Requests per second that each tenant may send. 0 for no limit",
+      cxxopts::value(rate_limit))
+    ("rate-limit-burst",
+      "Most requests that a tenant may send at once. Defaults to the rate limit",
+      cxxopts::value(rate_limit_burst))
+    ("tenant-header",
+      "HTTP header or gRPC metadata key that identifies the tenant of a request",
+      cxxopts::value(tenant_header))
+    ("ready-load",
+      "Load at which the server and its models report that they're not ready, such as 1, so load balancers send traffic elsewhere. 0 to always be ready",
+      cxxopts::value(ready_load))
+    ("saturated-batches",
+      "Queued batches per worker at which an endpoint's load is 1",
+      cxxopts::value(saturated_batches))
+    ("worker-cpus",
+      "CPUs that workers loaded without the cpus or numa_node parameters run on, such as 4-31",
+      cxxopts::value(worker_cpus))
+    ("processes",
+      "Number of server processes that share the ports, each with an equal share of the CPUs, and of http-cpus, worker-cpus and process-gpus if they're set",
+      cxxopts::value(processes))
+    ("process-gpus",
+      "GPUs to share between the server processes, such as 0-7. Each process only sees its share",
+      cxxopts::value(process_gpus))
+    ("manifest",
+      "File that the workers and models loaded through the API are recorded in so a restarted server can restore them",
+      cxxopts::value(manifest))
+    ("restore",
+      "Load the workers and models recorded in the manifest as the server starts, before it accepts requests",
+      cxxopts::value(restore))
+    ("capture",
+      "File to capture a sample of the inference requests to with their timing so the load generator can replay them",
+      cxxopts::value(capture))
+    ("capture-rate", "Fraction of the inference requests to capture",
+      cxxopts::value(capture_rate))
+    ("capture-shapes",
+      "Capture only the shapes of the inputs instead of their data",
+      cxxopts::value(capture_shapes))
 #ifdef AMDINFER_ENABLE_HTTP
     ("http-port", "Port to use for HTTP server", cxxopts::value(http_port))
+    ("http-threads",
+      "Number of HTTP I/O threads. 0 for one per CPU in http-cpus or one per four CPUs otherwise",
+      cxxopts::value(http_threads))
+    ("http-cpus",
+      "CPUs to pin the HTTP I/O threads to, such as 0-3. Unless worker-cpus is set, workers get the other CPUs",
+      cxxopts::value(http_cpus))
+    ("http-decode-threads",
+      "Number of threads that decode HTTP inference requests off the I/O threads. 0 to decode them on the I/O threads",
+      cxxopts::value(http_decode_threads))
 #endif
 #ifdef AMDINFER_ENABLE_GRPC
     ("grpc-port", "Port to use for gRPC server", cxxopts::value(grpc_port))
+    ("grpc-socket",
+      "Path of a Unix domain socket that the gRPC server listens on as well for local clients",
+      cxxopts::value(grpc_socket))
+#endif
+#ifdef AMDINFER_ENABLE_IO_URING
+    ("uring-port",
+      "Port to use for the io_uring server, which speaks the binary protocol",
+      cxxopts::value(uring_port))
+    ("uring-threads",
+      "Number of io_uring server threads, each with its own ring. 0 for one per NUMA node",
+      cxxopts::value(uring_threads))
+    ("uring-cpus",
+      "CPUs to pin the io_uring server threads to, one each, such as 0-3. Unless worker-cpus is set, workers get the other CPUs",
+      cxxopts::value(uring_cpus))
+#endif
+#ifdef AMDINFER_ENABLE_TRACING
+    ("trace-sampling", "Fraction of requests to trace, between 0 and 1",
+      cxxopts::value(trace_sampling))
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+    ("usage-metrics",
+      "Export the CPU time and copies spent on requests in each stage, by model and the tenant in tenant-header",
+      cxxopts::value(usage_metrics))
 #endif
     ("help", "Print help");
     // clang-format on
@@ -102,12 +235,78 @@ int main(int argc, char* argv[]) {
       std::cout << options.help({""}) << "\n";
       exit(0);
     }
+    if (restore && manifest.empty()) {
+      std::cout << "Error parsing options: restore needs a manifest\n";
+      exit(1);
+    }
   } catch (const cxxopts::OptionException& e) {
     std::cout << "Error parsing options: " << e.what() << "\n";
     exit(1);
   }
 
+  // each shard is a full server process. They're forked before any threads
+  // are started
+  int shard = -1;
+  std::filesystem::path shard_directory;
+  if (processes > 1) {
+    shard_directory = std::filesystem::temp_directory_path() /
+                      ("amdinfer-" + std::to_string(getpid()));
+    std::filesystem::create_directories(shard_directory);
+    try {
+      amdinfer::Supervisor supervisor{processes, shard_directory};
+      shard = supervisor.run();
+    } catch (const amdinfer::runtime_error& e) {
+      std::cout << e.what() << "\n";
+      std::filesystem::remove_all(shard_directory);
+      return 1;
+    }
+    if (shard < 0) {
+      std::filesystem::remove_all(shard_directory);
+      return 0;
+    }
+
+    auto share = [shard, processes](const std::string& list) {
+      return amdinfer::util::formatIdList(amdinfer::getShare(
+        amdinfer::util::parseIdList(list), shard, processes));
+    };
+    // threads started afterwards inherit the CPUs
+    amdinfer::util::bindThreadToCpus(
+      amdinfer::getShare(amdinfer::util::getThreadCpus(), shard, processes));
+    if (!worker_cpus.empty()) {
+      worker_cpus = share(worker_cpus);
+    }
+#ifdef AMDINFER_ENABLE_HTTP
+    if (!http_cpus.empty()) {
+      http_cpus = share(http_cpus);
+    }
+#endif
+#ifdef AMDINFER_ENABLE_IO_URING
+    if (!uring_cpus.empty()) {
+      uring_cpus = share(uring_cpus);
+    }
+#endif
+    if (!process_gpus.empty()) {
+      setenv("HIP_VISIBLE_DEVICES", share(process_gpus).c_str(), 1);
+    }
+    // each shard loads its own endpoints
+    if (!manifest.empty()) {
+      manifest += "." + std::to_string(shard);
+    }
+    if (!capture.empty()) {
+      capture += "." + std::to_string(shard);
+    }
+  }
+
   amdinfer::Server server;
+  if (shard >= 0) {
+    server.enableSharding(shard_directory, shard);
+  }
+  if (!preload_workers.empty()) {
+    server.preloadWorkers(preload_workers);
+  }
+#ifdef AMDINFER_ENABLE_TRACING
+  amdinfer::setTraceSampling(trace_sampling);
+#endif
 
   AMDINFER_IF_LOGGING(amdinfer::Logger logger{amdinfer::Loggers::Server};)
 
@@ -124,14 +323,62 @@ int main(int argc, char* argv[]) {
     server.enableRepositoryMonitoring(use_polling_watcher);
   }
 
+  if (lazy_loading) {
+    const size_t bytes_per_mib = 1024 * 1024;
+    server.enableLazyLoading(memory_budget * bytes_per_mib, idle_timeout);
+    AMDINFER_LOG_INFO(logger, "Loading models on their first request");
+  }
+
+  if (target_latency > 0 || max_inflight > 0) {
+    server.enableLoadShedding(target_latency, max_inflight);
+  }
+  if (rate_limit > 0) {
+    server.enableRateLimiting(rate_limit, rate_limit_burst, tenant_header);
+  }
+#ifdef AMDINFER_ENABLE_METRICS
+  if (usage_metrics) {
+    server.enableUsageAccounting(tenant_header);
+  }
+#endif
+  if (ready_load > 0 || saturated_batches != default_saturated_batches) {
+    server.enableOverloadReadiness(ready_load, saturated_batches);
+  }
+  if (!worker_cpus.empty()) {
+    server.setWorkerCpus(worker_cpus);
+  }
+  if (!manifest.empty()) {
+    try {
+      server.enableManifest(manifest, restore);
+    } catch (const amdinfer::runtime_error& e) {
+      std::cout << "Error restoring the manifest: " << e.what() << "\n";
+      return 1;
+    }
+  }
+  if (!capture.empty()) {
+    try {
+      server.enableCapture(capture, capture_rate, !capture_shapes);
+    } catch (const amdinfer::runtime_error& e) {
+      std::cout << "Error starting the capture: " << e.what() << "\n";
+      return 1;
+    }
+  }
+
 #ifdef AMDINFER_ENABLE_GRPC
   std::cout << "gRPC server starting at port " << grpc_port << "\n";
-  server.startGrpc(grpc_port);
+  if (!grpc_socket.empty()) {
+    std::cout << "gRPC server listening on unix:" << grpc_socket << "\n";
+  }
+  server.startGrpc(grpc_port, grpc_socket);
+#endif
+
+#ifdef AMDINFER_ENABLE_IO_URING
+  std::cout << "io_uring server starting at port " << uring_port << "\n";
+  server.startUring(uring_port, uring_threads, uring_cpus);
 #endif
 
 #ifdef AMDINFER_ENABLE_HTTP
   std::cout << "HTTP server starting at port " << http_port << std::endl;
-  server.startHttp(http_port);
+  server.startHttp(http_port, http_threads, http_cpus, http_decode_threads);
 #endif
 
   // wait until right signal occurs to terminate the server
@@ -21,6 +21,7 @@
 #include <opencv2/imgcodecs.hpp>  // for imdecode, imencode, IMRE...
 
 #include "amdinfer/batching/batch.hpp"
+#include "amdinfer/batching/batch_tensors.hpp"
 #include "amdinfer/buffers/vector.hpp"
 #include "amdinfer/core/inference_request.hpp"
 #include "amdinfer/core/inference_response.hpp"
@@ -43,35 +44,38 @@ std::vector<amdinfer::Tensor> getInputs() {
 
 std::vector<amdinfer::Tensor> getOutputs() { return {}; }
 
-amdinfer::BatchPtr run(amdinfer::Batch* batch) {
+amdinfer::BatchPtr runBatch(amdinfer::Batch* batch,
+                            const amdinfer::BatchTensors& inputs) {
   amdinfer::Logger logger{amdinfer::Loggers::Server};
 
   auto new_batch = batch->propagate();
   const auto batch_size = batch->size();
 
   std::vector<cv::Mat> decoded_images;
-  size_t max_decoded_size = 0;
+  // the offset of each decoded image in the output buffer
+  std::vector<size_t> offsets{0};
   const auto channels = 3;  // assuming 3 channels
+  const auto& input = inputs.at(0);
+  const auto* input_data = static_cast<const char*>(input.data);
   for (unsigned int j = 0; j < batch_size; j++) {
     const auto& req = batch->getRequest(j);
 #ifdef AMDINFER_ENABLE_TRACING
     const auto& trace = batch->getTrace(j);
-    trace->startSpan("base64_decode");
+    if (trace != nullptr) {
+      trace->startSpan("base64_decode");
+    }
 #endif
-    const auto& inputs = req->getInputs();
     if (inputs.size() != 1) {
       req->runCallbackError("Only one input tensor should be present");
       continue;
     }
-    const auto& input = inputs.at(0);
-    const auto& input_shape = input.getShape();
-    auto input_size = amdinfer::util::containerProduct(input_shape);
+    const auto input_size = input.offsets[j + 1] - input.offsets[j];
 
     auto new_request = req->propagate();
 
-    const auto* input_data = static_cast<char*>(input.getData());
-    auto decoded_str = amdinfer::util::base64Decode(input_data, input_size);
-    std::vector<char> data(decoded_str.begin(), decoded_str.end());
+    std::vector<char> data(amdinfer::util::base64DecodedMaxLength(input_size));
+    data.resize(amdinfer::util::base64Decode(input_data + input.offsets[j],
+                                             input_size, data.data()));
     cv::Mat img;
     try {
       img = cv::imdecode(data, cv::IMREAD_UNCHANGED);
@@ -89,9 +93,7 @@ amdinfer::BatchPtr run(amdinfer::Batch* batch) {
     }
 
     const size_t decoded_size = img.rows * img.cols * channels;
-    if (decoded_size > max_decoded_size) {
-      max_decoded_size = decoded_size;
-    }
+    offsets.push_back(offsets.back() + decoded_size);
 
     std::vector<int64_t> shape{static_cast<int64_t>(img.rows),
                                static_cast<int64_t>(img.cols), 3};
@@ -103,24 +105,24 @@ amdinfer::BatchPtr run(amdinfer::Batch* batch) {
     new_batch->addRequest(new_request);
 
 #ifdef AMDINFER_ENABLE_TRACING
-    trace->endSpan();
+    if (trace != nullptr) {
+      trace->endSpan();
+    }
 #endif
   }
 
-  const auto data_size = amdinfer::DataType("Uint8").size();
+  // the decoded images are packed back to back like the batcher packs inputs
   std::vector<amdinfer::BufferPtr> input_buffers;
-  input_buffers.emplace_back(std::make_unique<amdinfer::VectorBuffer>(
-    max_decoded_size * batch_size * data_size));
+  input_buffers.emplace_back(
+    std::make_unique<amdinfer::VectorBuffer>(offsets.back()));
 
-  for (auto j = 0U; j < batch_size; j++) {
-    auto* data_ptr =
-      input_buffers.at(0)->data(j * max_decoded_size * data_size);
+  for (auto j = 0U; j < new_batch->size(); j++) {
+    auto* data_ptr = input_buffers.at(0)->data(offsets[j]);
     const auto& req = new_batch->getRequest(j);
-    req->setInputTensorData(j, data_ptr);
+    req->setInputTensorData(0, data_ptr);
     const auto& data = decoded_images.at(j);
-    const auto decoded_size = data.rows * data.cols * channels;
     amdinfer::util::copy(data.data, static_cast<std::byte*>(data_ptr),
-                         decoded_size);
+                         offsets[j + 1] - offsets[j]);
   }
 
   new_batch->setBuffers(std::move(input_buffers), {});
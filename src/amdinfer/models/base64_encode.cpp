@@ -21,6 +21,7 @@
 #include <opencv2/imgcodecs.hpp>  // for imdecode, imencode, IMRE...
 
 #include "amdinfer/batching/batch.hpp"
+#include "amdinfer/batching/batch_tensors.hpp"
 #include "amdinfer/buffers/vector.hpp"
 #include "amdinfer/core/inference_request.hpp"
 #include "amdinfer/core/inference_response.hpp"
@@ -43,41 +44,43 @@ std::vector<amdinfer::Tensor> getInputs() {
 
 std::vector<amdinfer::Tensor> getOutputs() { return {}; }
 
-amdinfer::BatchPtr run(amdinfer::Batch* batch) {
+amdinfer::BatchPtr runBatch(amdinfer::Batch* batch,
+                            const amdinfer::BatchTensors& inputs) {
   AMDINFER_IF_LOGGING(amdinfer::Logger logger{amdinfer::Loggers::Server});
 
   auto new_batch = batch->propagate();
   const auto batch_size = batch->size();
 
   std::vector<std::string> encoded_images;
-  size_t max_encoded_size = 0;
+  // the offset of each encoded image in the output buffer
+  std::vector<size_t> offsets{0};
+  const auto& input = inputs.at(0);
+  auto* input_data = static_cast<std::byte*>(input.data);
   for (unsigned int j = 0; j < batch_size; j++) {
     const auto& req = batch->getRequest(j);
 #ifdef AMDINFER_ENABLE_TRACING
     const auto& trace = batch->getTrace(j);
-    trace->startSpan("base64_encode");
+    if (trace != nullptr) {
+      trace->startSpan("base64_encode");
+    }
 #endif
-    const auto& inputs = req->getInputs();
     if (inputs.size() != 1) {
       req->runCallbackError("Only one input tensor should be present");
       continue;
     }
-    const auto& input = inputs.at(0);
-    auto input_shape = input.getShape();
+    const auto& input_shape = req->getInputs()[0].getShape();
 
     auto new_request = req->propagate();
 
-    auto img =
-      cv::Mat{static_cast<int>(input_shape[0]),
-              static_cast<int>(input_shape[1]), CV_8UC3, input.getData()};
+    auto img = cv::Mat{static_cast<int>(input_shape[0]),
+                       static_cast<int>(input_shape[1]), CV_8UC3,
+                       input_data + input.offsets[j]};
     std::vector<unsigned char> buf;
     cv::imencode(".jpg", img, buf);
     const auto* enc_msg = reinterpret_cast<const char*>(buf.data());
     auto encoded = amdinfer::util::base64Encode(enc_msg, buf.size());
     const auto encoded_size = encoded.size();
-    if (encoded_size > max_encoded_size) {
-      max_encoded_size = encoded_size;
-    }
+    offsets.push_back(offsets.back() + encoded_size);
 
     new_request->addInputTensor(nullptr, {static_cast<int64_t>(encoded_size)},
                                 amdinfer::DataType::Bytes, "output");
@@ -86,20 +89,21 @@ amdinfer::BatchPtr run(amdinfer::Batch* batch) {
     new_batch->addRequest(new_request);
 
 #ifdef AMDINFER_ENABLE_TRACING
-    trace->endSpan();
+    if (trace != nullptr) {
+      trace->endSpan();
+    }
 #endif
   }
 
-  const auto data_size = amdinfer::DataType("Uint8").size();
+  // the encoded images are packed back to back like the batcher packs inputs
   std::vector<amdinfer::BufferPtr> input_buffers;
-  input_buffers.emplace_back(std::make_unique<amdinfer::VectorBuffer>(
-    max_encoded_size * batch_size * data_size));
+  input_buffers.emplace_back(
+    std::make_unique<amdinfer::VectorBuffer>(offsets.back()));
 
-  for (auto j = 0U; j < batch_size; j++) {
-    auto* data_ptr =
-      input_buffers.at(0)->data(j * max_encoded_size * data_size);
+  for (auto j = 0U; j < new_batch->size(); j++) {
+    auto* data_ptr = input_buffers.at(0)->data(offsets[j]);
     const auto& req = new_batch->getRequest(j);
-    req->setInputTensorData(j, data_ptr);
+    req->setInputTensorData(0, data_ptr);
     const auto& data = encoded_images.at(j);
     amdinfer::util::copy(data.data(), static_cast<std::byte*>(data_ptr),
                          data.size());
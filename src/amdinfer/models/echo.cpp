@@ -17,7 +17,13 @@
  * @brief Implements the echo model
  */
 
+#include <algorithm>  // for min
+#include <cstddef>    // for byte
+#include <cstdint>    // for uint32_t
+#include <cstring>    // for memcpy
+
 #include "amdinfer/batching/batch.hpp"
+#include "amdinfer/batching/batch_tensors.hpp"
 #include "amdinfer/core/inference_request.hpp"
 #include "amdinfer/core/inference_response.hpp"
 #include "amdinfer/core/parameters.hpp"
@@ -43,35 +49,33 @@ std::vector<amdinfer::Tensor> getOutputs() {
   return output_tensors;
 }
 
-void run(amdinfer::Batch* batch, amdinfer::Batch* new_batch) {
-  amdinfer::Logger logger{amdinfer::Loggers::Server};
-
+void runBatch(amdinfer::Batch* batch, const amdinfer::BatchTensors& inputs,
+              const amdinfer::BatchTensors& outputs,
+              amdinfer::Batch* new_batch) {
   const auto batch_size = batch->size();
-  for (unsigned int j = 0; j < batch_size; j++) {
-    const auto& req = batch->getRequest(j);
-    const auto& new_request = new_batch->getRequest(j);
-
-    const auto& inputs = req->getInputs();
-    const auto inputs_size = inputs.size();
-
-    const auto& new_inputs = new_request->getInputs();
-    for (auto i = 0U; i < inputs_size; ++i) {
-      auto* input_buffer = inputs[i].getData();
+  const auto tensors = std::min(inputs.size(), outputs.size());
+  for (auto i = 0U; i < tensors; ++i) {
+    const auto& input = inputs[i];
+    const auto* input_data = static_cast<const std::byte*>(input.data);
+    auto* output_data = static_cast<uint32_t*>(outputs[i].data);
 
-      uint32_t value = *static_cast<uint32_t*>(input_buffer);
-
-      try {
-        value++;
-      } catch (const std::exception& e) {
-        AMDINFER_LOG_ERROR(logger, e.what());
-        new_request->runCallbackError("Something went wrong");
-        continue;
+    // each request contributes one value. If they're packed back to back, the
+    // whole batch is incremented in one loop
+    if (input.offsets.back() == batch_size * sizeof(uint32_t)) {
+      const auto* values = static_cast<const uint32_t*>(input.data);
+      for (auto j = 0U; j < batch_size; ++j) {
+        output_data[j] = values[j] + 1;
+      }
+    } else {
+      for (auto j = 0U; j < batch_size; ++j) {
+        uint32_t value = 0;
+        std::memcpy(&value, input_data + input.offsets[j], sizeof(value));
+        output_data[j] = value + 1;
       }
-
-      amdinfer::util::copy(value,
-                           static_cast<std::byte*>(new_inputs.at(i).getData()));
     }
+  }
 
+  for (auto j = 0U; j < batch_size; ++j) {
     new_batch->setModel(j, "echo");
   }
 }
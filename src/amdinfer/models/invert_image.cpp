@@ -21,6 +21,7 @@
 #include <opencv2/imgcodecs.hpp>  // for imdecode, imencode, IMRE...
 
 #include "amdinfer/batching/batch.hpp"
+#include "amdinfer/batching/batch_tensors.hpp"
 #include "amdinfer/buffers/vector.hpp"
 #include "amdinfer/core/inference_request.hpp"
 #include "amdinfer/core/inference_response.hpp"
@@ -65,45 +66,43 @@ std::vector<amdinfer::Tensor> getInputs() {
 
 std::vector<amdinfer::Tensor> getOutputs() { return {}; }
 
-// Support up to Full HD
-const auto kMaxImageHeight = 1080;
-const auto kMaxImageWidth = 1920;
-const auto kMaxImageChannels = 3;
-const auto kMaxImageSize = kMaxImageHeight * kMaxImageWidth * kMaxImageChannels;
-
-amdinfer::BatchPtr run(amdinfer::Batch* batch) {
-  amdinfer::Logger logger{amdinfer::Loggers::Server};
-
+amdinfer::BatchPtr runBatch(amdinfer::Batch* batch,
+                            const amdinfer::BatchTensors& inputs) {
   auto new_batch = batch->propagate();
   const auto batch_size = batch->size();
-  const auto data_size = amdinfer::DataType("Uint8").size();
+  const auto& input = inputs.at(0);
+  const auto size = input.offsets.back();
 
+#ifdef AMDINFER_ENABLE_TRACING
+  for (auto j = 0U; j < batch_size; j++) {
+    if (const auto& trace = batch->getTrace(j); trace != nullptr) {
+      trace->startSpan("invert_image");
+    }
+  }
+#endif
+
+  // the inversion is the same for every pixel so the images of the whole batch
+  // are inverted together into one buffer with the same layout as the input
   std::vector<amdinfer::BufferPtr> input_buffers;
-  input_buffers.emplace_back(std::make_unique<amdinfer::VectorBuffer>(
-    kMaxImageSize * batch_size * data_size));
+  input_buffers.emplace_back(std::make_unique<amdinfer::VectorBuffer>(size));
+  auto* output_data = static_cast<std::byte*>(input_buffers.at(0)->data(0));
+  invert<uint8_t*, false>(input.data, output_data, size);
 
   for (unsigned int j = 0; j < batch_size; j++) {
     const auto& req = batch->getRequest(j);
-#ifdef AMDINFER_ENABLE_TRACING
-    const auto& trace = batch->getTrace(j);
-    trace->startSpan("invert_image");
-#endif
-    const auto& inputs = req->getInputs();
-    auto input_shape = inputs[0].getShape();
-
-    auto input_size = amdinfer::util::containerProduct(input_shape);
+    const auto& input_shape = req->getInputs()[0].getShape();
 
     auto new_request = req->propagate();
-    auto* data_ptr = input_buffers.at(0)->data(j * kMaxImageSize * data_size);
-    new_request->addInputTensor(data_ptr, input_shape,
+    new_request->addInputTensor(output_data + input.offsets[j], input_shape,
                                 amdinfer::DataType::Uint8, "output");
-    invert<uint8_t*, false>(inputs[0].getData(), data_ptr, input_size);
 
     new_batch->addRequest(new_request);
     new_batch->setModel(j, "invert_image");
 
 #ifdef AMDINFER_ENABLE_TRACING
-    trace->endSpan();
+    if (const auto& trace = batch->getTrace(j); trace != nullptr) {
+      trace->endSpan();
+    }
 #endif
   }
 
@@ -0,0 +1,85 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the phases of loading a worker that are timed separately
+ */
+
+#ifndef GUARD_AMDINFER_OBSERVATION_LOAD_TIMES
+#define GUARD_AMDINFER_OBSERVATION_LOAD_TIMES
+
+#include <array>    // for array
+#include <chrono>   // for nanoseconds
+#include <cstddef>  // for size_t
+
+namespace amdinfer {
+
+/// The phases of loading a worker, in the order they happen
+enum class LoadPhase {
+  /// opening the worker's libworker*.so
+  Open,
+  /// the rest of Worker::init
+  Init,
+  /// reading the model file
+  ReadModel,
+  /// compiling the model's graph or deserializing a compiled one
+  Compile,
+  /// creating the runners, sessions or streams that run the model
+  CreateRunner,
+  /// the rest of Worker::acquire
+  Acquire,
+  /// reserving the worker's memory in the pool
+  Reserve,
+  /// running the warm-up batches
+  Warmup,
+  /// starting the batchers and the worker's thread
+  Start,
+  /// the number of phases
+  Count,
+};
+
+/// Time spent in each phase of loading a worker, indexed by LoadPhase
+using LoadTimes =
+  std::array<std::chrono::nanoseconds, static_cast<size_t>(LoadPhase::Count)>;
+
+/// Get the name of a phase as it's labelled in the metrics and logs
+constexpr const char* getLoadPhaseName(LoadPhase phase) {
+  switch (phase) {
+    case LoadPhase::Open:
+      return "open";
+    case LoadPhase::Init:
+      return "init";
+    case LoadPhase::ReadModel:
+      return "read_model";
+    case LoadPhase::Compile:
+      return "compile";
+    case LoadPhase::CreateRunner:
+      return "create_runner";
+    case LoadPhase::Acquire:
+      return "acquire";
+    case LoadPhase::Reserve:
+      return "reserve";
+    case LoadPhase::Warmup:
+      return "warmup";
+    case LoadPhase::Start:
+      return "start";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_OBSERVATION_LOAD_TIMES
@@ -20,16 +20,19 @@
 
 #include "amdinfer/observation/logging.hpp"
 
+#include <spdlog/async.h>                     // for thread_pool, async_logger
 #include <spdlog/sinks/basic_file_sink.h>     // for basic_file_sink_mt, bas...
 #include <spdlog/sinks/stdout_color_sinks.h>  // for ansicolor_stdout_sink
 #include <spdlog/spdlog.h>
 
-#include <cassert>   // for assert
-#include <cstdlib>   // for getenv
-#include <iterator>  // for begin, end
-#include <memory>    // for allocator, make_shared
-#include <string>    // for string, operator+, char...
-#include <vector>    // for vector
+#include <algorithm>  // for min
+#include <cassert>    // for assert
+#include <cstdlib>    // for getenv
+#include <iterator>   // for begin, end
+#include <memory>     // for allocator, make_shared
+#include <mutex>      // for mutex, lock_guard
+#include <string>     // for string, operator+, char...
+#include <vector>     // for vector
 
 #include "amdinfer/core/exceptions.hpp"
 
@@ -63,12 +66,16 @@ void initLogger(const LogOptions& options) {
   assert(options.console_enable || options.file_enable);
 
   std::vector<spdlog::sink_ptr> sinks;
+  // the logger drops messages below the lowest level of its sinks so they are
+  // never formatted
+  auto level = spdlog::level::off;
 
   if (options.console_enable) {
     auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     console_sink->set_level(getLevel(options.console_level));
     console_sink->set_pattern("[amdinfer] [%^%l%$] %v");
     sinks.push_back(console_sink);
+    level = std::min(level, getLevel(options.console_level));
   }
 
   if (options.file_enable) {
@@ -77,11 +84,27 @@ void initLogger(const LogOptions& options) {
       std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_file, true);
     file_sink->set_level(getLevel(options.file_level));
     sinks.push_back(file_sink);
+    level = std::min(level, getLevel(options.file_level));
   }
 
-  logger = std::make_shared<spdlog::logger>(options.logger_name,
-                                            std::begin(sinks), std::end(sinks));
-  logger->set_level(spdlog::level::trace);
+  if (options.async_enable) {
+    // all the loggers share one background thread. If its queue is full, the
+    // oldest messages are dropped rather than blocking the caller
+    static std::mutex mutex;
+    std::lock_guard lock{mutex};
+    auto pool = spdlog::thread_pool();
+    if (pool == nullptr) {
+      spdlog::init_thread_pool(options.async_queue_size, 1);
+      pool = spdlog::thread_pool();
+    }
+    logger = std::make_shared<spdlog::async_logger>(
+      options.logger_name, std::begin(sinks), std::end(sinks), pool,
+      spdlog::async_overflow_policy::overrun_oldest);
+  } else {
+    logger = std::make_shared<spdlog::logger>(
+      options.logger_name, std::begin(sinks), std::end(sinks));
+  }
+  logger->set_level(level);
   logger->flush_on(spdlog::level::info);
   spdlog::register_logger(logger);
 }
@@ -21,14 +21,20 @@
 #ifndef GUARD_AMDINFER_OBSERVATION_LOGGING
 #define GUARD_AMDINFER_OBSERVATION_LOGGING
 
-#include <memory>  // for shared_ptr
-#include <string>  // for string
+#include <cstddef>  // for size_t
+#include <memory>   // for shared_ptr
+#include <string>   // for string
 
 #include "amdinfer/build_options.hpp"
 
 #ifdef AMDINFER_ENABLE_LOGGING
 
-#ifndef NDEBUG
+// Messages below this level are removed at compile-time. It can be set with
+// the AMDINFER_LOG_LEVEL CMake option and otherwise depends on the build type
+#if defined(AMDINFER_LOG_LEVEL)
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define SPDLOG_ACTIVE_LEVEL AMDINFER_LOG_LEVEL
+#elif !defined(NDEBUG)
 // used for debug builds
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
@@ -40,27 +46,66 @@
 
 #include <spdlog/spdlog.h>
 
+// The message is only evaluated if the logger's level allows it so building
+// strings for filtered messages costs nothing at run-time
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define AMDINFER_LOG(logger, level, message)               \
+  do {                                                     \
+    auto* amdinfer_logger = (logger).get();                \
+    if (amdinfer_logger->should_log(level)) {              \
+      SPDLOG_LOGGER_CALL(amdinfer_logger, level, message); \
+    }                                                      \
+  } while (false)
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define AMDINFER_LOG_TRACE(logger, message) \
-  SPDLOG_LOGGER_TRACE((logger).get(), message)
+  AMDINFER_LOG(logger, spdlog::level::trace, message)
+#else
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define AMDINFER_LOG_TRACE(logger, message) (void)0
+#endif
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define AMDINFER_LOG_DEBUG(logger, message) \
-  SPDLOG_LOGGER_DEBUG((logger).get(), message)
+  AMDINFER_LOG(logger, spdlog::level::debug, message)
+#else
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define AMDINFER_LOG_DEBUG(logger, message) (void)0
+#endif
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define AMDINFER_LOG_INFO(logger, message) \
-  SPDLOG_LOGGER_INFO((logger).get(), message)
+  AMDINFER_LOG(logger, spdlog::level::info, message)
+#else
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define AMDINFER_LOG_INFO(logger, message) (void)0
+#endif
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define AMDINFER_LOG_WARN(logger, message) \
-  SPDLOG_LOGGER_WARN((logger).get(), message)
+  AMDINFER_LOG(logger, spdlog::level::warn, message)
+#else
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define AMDINFER_LOG_WARN(logger, message) (void)0
+#endif
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define AMDINFER_LOG_ERROR(logger, message) \
-  SPDLOG_LOGGER_ERROR((logger).get(), message)
+  AMDINFER_LOG(logger, spdlog::level::err, message)
+#else
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define AMDINFER_LOG_ERROR(logger, message) (void)0
+#endif
 
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define AMDINFER_IF_LOGGING(args) args
 
 namespace amdinfer {
 
+/// Number of messages buffered for asynchronous logging by default
+constexpr size_t kDefaultLogQueueSize = 8192;
+
 enum class Loggers { Server, Client, Test };
 
 enum class LogLevel {
@@ -84,6 +129,12 @@ struct LogOptions {
   // console logging
   bool console_enable;
   LogLevel console_level;
+
+  // asynchronous logging
+  /// Write messages from a background thread so callers never wait on I/O
+  bool async_enable = true;
+  /// Messages held for the background thread. If full, the oldest are dropped
+  size_t async_queue_size = kDefaultLogQueueSize;
 };
 
 class Logger {
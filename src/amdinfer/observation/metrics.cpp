@@ -21,57 +21,49 @@
 #include "amdinfer/observation/metrics.hpp"
 
 #include <prometheus/collectable.h>      // for Collectable
-#include <prometheus/counter.h>          // for Builder, Counter, BuildCounter
 #include <prometheus/family.h>           // for Family
 #include <prometheus/gauge.h>            // for Gauge, BuildGauge
 #include <prometheus/metric_family.h>    // for MetricFamily
+#include <prometheus/metric_type.h>      // for MetricType
 #include <prometheus/serializer.h>       // for Serializer
 #include <prometheus/summary.h>          // for CKMSQuantiles, CKMSQuantiles...
 #include <prometheus/text_serializer.h>  // for TextSerializer
 
-#include <iterator>  // for move_iterator, make_move_ite...
-#include <memory>    // for weak_ptr, allocator, shared_ptr
-#include <ratio>     // for micro
-#include <string>    // for string
-#include <vector>    // for vector
+#include <algorithm>  // for lower_bound, find
+#include <array>      // for array
+#include <iterator>   // for move_iterator, make_move_ite...
+#include <limits>     // for numeric_limits
+#include <memory>     // for weak_ptr, allocator, shared_ptr
+#include <ratio>      // for micro
+#include <string>     // for string
+#include <utility>    // for move
+#include <vector>     // for vector
 
 #include "amdinfer/util/timer.hpp"  // for Timer
 
 namespace amdinfer {
 
-CounterFamily::CounterFamily(
-  const std::string& name, const std::string& help,
-  prometheus::Registry* registry,
-  const std::unordered_map<MetricCounterIDs,
-                           std::map<std::string, std::string>>& labels)
-  : family_(
-      prometheus::BuildCounter().Name(name).Help(help).Register(*registry)) {
-  for (const auto& [id, label] : labels) {
-    counters_.emplace(id, family_.Add(label));
-  }
-}
+namespace {
 
-void CounterFamily::increment(MetricCounterIDs id) {
-  if (this->counters_.find(id) != this->counters_.end()) {
-    auto& counter = this->counters_.at(id);
-    counter.Increment();
-  }
+/// Merge extra labels into the labels of a metric
+MetricLabels merge(MetricLabels labels, const MetricLabels& extra) {
+  labels.insert(extra.begin(), extra.end());
+  return labels;
 }
 
-void CounterFamily::increment(MetricCounterIDs id, size_t increment) {
-  if (this->counters_.find(id) != this->counters_.end()) {
-    auto& counter = this->counters_.at(id);
-    counter.Increment(static_cast<double>(increment));
-  }
-}
+}  // namespace
 
 GaugeFamily::GaugeFamily(
   const std::string& name, const std::string& help,
   prometheus::Registry* registry,
-  const std::unordered_map<MetricGaugeIDs, std::map<std::string, std::string>>&
-    labels)
+  const std::unordered_map<MetricGaugeIDs, MetricLabels>& labels,
+  bool per_model)
   : family_(
-      prometheus::BuildGauge().Name(name).Help(help).Register(*registry)) {
+      prometheus::BuildGauge().Name(name).Help(help).Register(*registry)),
+    labels_(labels) {
+  if (per_model) {
+    return;
+  }
   for (const auto& [id, label] : labels) {
     gauges_.emplace(id, family_.Add(label));
   }
@@ -84,6 +76,13 @@ void GaugeFamily::set(MetricGaugeIDs id, double value) {
   }
 }
 
+prometheus::Gauge* GaugeFamily::add(MetricGaugeIDs id,
+                                    const MetricLabels& labels) {
+  return &family_.Add(merge(labels_.at(id), labels));
+}
+
+void GaugeFamily::remove(prometheus::Gauge* gauge) { family_.Remove(gauge); }
+
 SummaryFamily::SummaryFamily(
   const std::string& name, const std::string& help,
   prometheus::Registry* registry,
@@ -103,6 +102,326 @@ void SummaryFamily::observe(MetricSummaryIDs id, double value) {
   }
 }
 
+std::vector<double> exponentialBuckets(double start, double factor,
+                                       size_t count) {
+  std::vector<double> bounds;
+  bounds.reserve(count);
+  auto bound = start;
+  for (auto i = 0U; i < count; ++i) {
+    bounds.push_back(bound);
+    bound *= factor;
+  }
+  return bounds;
+}
+
+std::vector<double> linearBuckets(double start, double width, size_t count) {
+  std::vector<double> bounds;
+  bounds.reserve(count);
+  for (auto i = 0U; i < count; ++i) {
+    bounds.push_back(start + (width * i));
+  }
+  return bounds;
+}
+
+namespace {
+
+/// Get the shard that the calling thread records observations into
+size_t getShard() {
+  static std::atomic<size_t> next_shard = 0;
+  thread_local const size_t shard = next_shard++ % kHistogramShards;
+  return shard;
+}
+
+}  // namespace
+
+Histogram::Histogram(const std::vector<double>* bounds) : bounds_(bounds) {
+  for (auto& shard : shards_) {
+    shard.counts =
+      std::make_unique<std::atomic<uint64_t>[]>(bounds_->size() + 1);
+  }
+}
+
+void Histogram::observe(double value) {
+  // buckets hold the values less than or equal to their bound
+  const auto bucket = static_cast<size_t>(
+    std::lower_bound(bounds_->begin(), bounds_->end(), value) -
+    bounds_->begin());
+  auto& shard = shards_[getShard()];
+  shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+  auto sum = shard.sum.load(std::memory_order_relaxed);
+  while (!shard.sum.compare_exchange_weak(sum, sum + value,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+prometheus::ClientMetric::Histogram Histogram::collect() const {
+  const auto buckets = bounds_->size() + 1;
+  std::vector<uint64_t> counts(buckets);
+  prometheus::ClientMetric::Histogram histogram;
+  for (const auto& shard : shards_) {
+    for (auto i = 0U; i < buckets; ++i) {
+      counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+    }
+    histogram.sample_sum += shard.sum.load(std::memory_order_relaxed);
+  }
+
+  histogram.bucket.reserve(buckets);
+  uint64_t cumulative_count = 0;
+  for (auto i = 0U; i < buckets; ++i) {
+    cumulative_count += counts[i];
+    auto& bucket = histogram.bucket.emplace_back();
+    bucket.cumulative_count = cumulative_count;
+    bucket.upper_bound = i < bounds_->size()
+                           ? (*bounds_)[i]
+                           : std::numeric_limits<double>::infinity();
+  }
+  histogram.sample_count = cumulative_count;
+  return histogram;
+}
+
+HistogramFamily::HistogramFamily(
+  std::string name, std::string help,
+  const std::unordered_map<MetricHistogramIDs, MetricLabels>& labels,
+  std::vector<double> bounds, bool per_model)
+  : name_(std::move(name)),
+    help_(std::move(help)),
+    bounds_(std::move(bounds)),
+    labels_(labels) {
+  if (per_model) {
+    return;
+  }
+  for (const auto& [id, label] : labels) {
+    defaults_.emplace(id, this->add(id, {}));
+  }
+}
+
+void HistogramFamily::observe(MetricHistogramIDs id, double value) {
+  if (auto iter = defaults_.find(id); iter != defaults_.end()) {
+    iter->second->observe(value);
+  }
+}
+
+Histogram* HistogramFamily::add(MetricHistogramIDs id,
+                                const MetricLabels& labels) {
+  auto merged = merge(labels_.at(id), labels);
+  std::lock_guard lock{mutex_};
+  auto [iter, inserted] = histograms_.try_emplace(std::move(merged));
+  if (inserted) {
+    iter->second = std::make_unique<Histogram>(&bounds_);
+  }
+  return iter->second.get();
+}
+
+void HistogramFamily::remove(const Histogram* histogram) {
+  std::lock_guard lock{mutex_};
+  for (auto iter = histograms_.begin(); iter != histograms_.end(); ++iter) {
+    if (iter->second.get() == histogram) {
+      histograms_.erase(iter);
+      return;
+    }
+  }
+}
+
+prometheus::MetricFamily HistogramFamily::collect() const {
+  prometheus::MetricFamily family;
+  family.name = name_;
+  family.help = help_;
+  family.type = prometheus::MetricType::Histogram;
+
+  std::lock_guard lock{mutex_};
+  family.metric.reserve(histograms_.size());
+  for (const auto& [labels, histogram] : histograms_) {
+    auto& metric = family.metric.emplace_back();
+    for (const auto& [name, value] : labels) {
+      metric.label.push_back({name, value});
+    }
+    metric.histogram = histogram->collect();
+  }
+  return family;
+}
+
+void Counter::increment(uint64_t increment) {
+  shards_[getShard()].value.fetch_add(increment, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const {
+  uint64_t value = 0;
+  for (const auto& shard : shards_) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+CounterFamily::CounterFamily(
+  std::string name, std::string help,
+  const std::unordered_map<MetricCounterIDs, MetricLabels>& labels,
+  bool per_model)
+  : name_(std::move(name)), help_(std::move(help)), labels_(labels) {
+  if (per_model) {
+    return;
+  }
+  for (const auto& [id, label] : labels) {
+    defaults_.emplace(id, this->add(id, {}));
+  }
+}
+
+void CounterFamily::increment(MetricCounterIDs id, size_t increment) {
+  if (auto iter = defaults_.find(id); iter != defaults_.end()) {
+    iter->second->increment(increment);
+  }
+}
+
+Counter* CounterFamily::add(MetricCounterIDs id, const MetricLabels& labels) {
+  auto merged = merge(labels_.at(id), labels);
+  std::lock_guard lock{mutex_};
+  auto [iter, inserted] = counters_.try_emplace(std::move(merged));
+  if (inserted) {
+    iter->second = std::make_unique<Counter>();
+  }
+  return iter->second.get();
+}
+
+void CounterFamily::remove(const Counter* counter) {
+  std::lock_guard lock{mutex_};
+  for (auto iter = counters_.begin(); iter != counters_.end(); ++iter) {
+    if (iter->second.get() == counter) {
+      counters_.erase(iter);
+      return;
+    }
+  }
+}
+
+prometheus::MetricFamily CounterFamily::collect() const {
+  prometheus::MetricFamily family;
+  family.name = name_;
+  family.help = help_;
+  family.type = prometheus::MetricType::Counter;
+
+  std::lock_guard lock{mutex_};
+  family.metric.reserve(counters_.size());
+  for (const auto& [labels, counter] : counters_) {
+    auto& metric = family.metric.emplace_back();
+    for (const auto& [name, value] : labels) {
+      metric.label.push_back({name, value});
+    }
+    metric.counter.value = static_cast<double>(counter->value());
+  }
+  return family;
+}
+
+// the metrics that are tracked for each model
+constexpr std::array kModelCounters{
+  MetricCounterIDs::PipelineIngressBatcher,
+  MetricCounterIDs::PipelineIngressWorker,
+  MetricCounterIDs::PipelineEgressBatcher,
+  MetricCounterIDs::PipelineEgressWorker,
+  MetricCounterIDs::BatcherExpired,
+  MetricCounterIDs::BatcherCancelled,
+  MetricCounterIDs::WorkerCancelled,
+  MetricCounterIDs::BatchesFull,
+  MetricCounterIDs::BatchesTimeout,
+  MetricCounterIDs::BatchesDeadline,
+  MetricCounterIDs::BatchesShutdown,
+  MetricCounterIDs::WorkerBusyTime,
+  MetricCounterIDs::WorkerIdleTime};
+constexpr std::array kModelGauges{MetricGaugeIDs::QueuesBatcherInput,
+                                  MetricGaugeIDs::QueuesBatcherInputHigh,
+                                  MetricGaugeIDs::QueuesBatcherInputNormal,
+                                  MetricGaugeIDs::QueuesBatcherInputLow,
+                                  MetricGaugeIDs::QueuesBatcherOutput,
+                                  MetricGaugeIDs::BatcherTimeout,
+                                  MetricGaugeIDs::BatcherFillRatio,
+                                  MetricGaugeIDs::XmodelJobs,
+                                  MetricGaugeIDs::XmodelUtilization,
+                                  MetricGaugeIDs::WorkersBusy,
+                                  MetricGaugeIDs::GpuBusy,
+                                  MetricGaugeIDs::GpuMemoryUsed,
+                                  MetricGaugeIDs::LoadOpen,
+                                  MetricGaugeIDs::LoadInit,
+                                  MetricGaugeIDs::LoadReadModel,
+                                  MetricGaugeIDs::LoadCompile,
+                                  MetricGaugeIDs::LoadCreateRunner,
+                                  MetricGaugeIDs::LoadAcquire,
+                                  MetricGaugeIDs::LoadReserve,
+                                  MetricGaugeIDs::LoadWarmup,
+                                  MetricGaugeIDs::LoadStart};
+constexpr std::array kModelHistograms{MetricHistogramIDs::RequestLatency,
+                                      MetricHistogramIDs::StageIngress,
+                                      MetricHistogramIDs::StageBatcher,
+                                      MetricHistogramIDs::StageQueue,
+                                      MetricHistogramIDs::StageCompute,
+                                      MetricHistogramIDs::StageRespond,
+                                      MetricHistogramIDs::BatchSize,
+                                      MetricHistogramIDs::BatchFillRatio,
+                                      MetricHistogramIDs::BatchPadding};
+
+ModelMetrics::ModelMetrics(const std::string& model,
+                           const std::string& version,
+                           const std::string& worker)
+  : labels_({{"model", model}, {"version", version}, {"worker", worker}}) {
+  Metrics::getInstance().addModel(this);
+}
+
+ModelMetrics::~ModelMetrics() { Metrics::getInstance().removeModel(this); }
+
+void ModelMetrics::incrementCounter(MetricCounterIDs id, size_t increment) {
+  if (auto* counter = counters_[static_cast<size_t>(id)]; counter != nullptr) {
+    counter->increment(increment);
+  }
+}
+
+void ModelMetrics::setGauge(MetricGaugeIDs id, double value) {
+  if (auto* gauge = gauges_[static_cast<size_t>(id)]; gauge != nullptr) {
+    gauge->Set(value);
+  }
+}
+
+void ModelMetrics::watchGauge(const void* owner, MetricGaugeIDs id,
+                              std::function<double()> read) {
+  std::lock_guard lock{watchers_mutex_};
+  for (auto& watcher : watchers_) {
+    if (watcher.owner == owner && watcher.id == id) {
+      watcher.read = std::move(read);
+      return;
+    }
+  }
+  watchers_.push_back({owner, id, std::move(read)});
+}
+
+void ModelMetrics::unwatchGauges(const void* owner) {
+  std::lock_guard lock{watchers_mutex_};
+  watchers_.erase(std::remove_if(watchers_.begin(), watchers_.end(),
+                                 [owner](const auto& watcher) {
+                                   return watcher.owner == owner;
+                                 }),
+                  watchers_.end());
+}
+
+void ModelMetrics::readGauges() {
+  std::array<double, static_cast<size_t>(MetricGaugeIDs::Count)> values{};
+  std::array<bool, static_cast<size_t>(MetricGaugeIDs::Count)> watched{};
+  {
+    std::lock_guard lock{watchers_mutex_};
+    for (const auto& watcher : watchers_) {
+      const auto index = static_cast<size_t>(watcher.id);
+      values.at(index) += watcher.read();
+      watched.at(index) = true;
+    }
+  }
+  for (auto i = 0U; i < values.size(); ++i) {
+    if (watched.at(i)) {
+      this->setGauge(static_cast<MetricGaugeIDs>(i), values.at(i));
+    }
+  }
+}
+
+void ModelMetrics::observeHistogram(MetricHistogramIDs id, double value) {
+  if (auto* histogram = histograms_[static_cast<size_t>(id)];
+      histogram != nullptr) {
+    histogram->observe(value);
+  }
+}
+
 // the arguments are percentile and error
 // NOLINTNEXTLINE(cert-err58-cpp)
 const prometheus::detail::CKMSQuantiles::Quantile kPercentile50{0.5, 0.05};
@@ -111,109 +430,504 @@ const prometheus::detail::CKMSQuantiles::Quantile kPercentile90{0.9, 0.01};
 // NOLINTNEXTLINE(cert-err58-cpp)
 const prometheus::detail::CKMSQuantiles::Quantile kPercentile99{0.99, 0.001};
 
+// request latencies are bucketed from 50 us to about 26 s and waits in the
+// thread pool from 1 us to about 0.5 s
+constexpr double kBucketFactor = 2;
+constexpr double kLatencyStart = 50;
+constexpr size_t kLatencyBuckets = 20;
+constexpr double kQueueWaitStart = 1;
+constexpr size_t kQueueWaitBuckets = 20;
+// stages are bucketed from 5 us to about 10 s
+constexpr double kStageStart = 5;
+constexpr size_t kStageBuckets = 22;
+// batch sizes and padding are bucketed in powers of two up to 4096 samples
+// and fill ratios in tenths
+constexpr size_t kBatchSizeBuckets = 13;
+constexpr double kFillRatioWidth = 0.1;
+constexpr size_t kFillRatioBuckets = 10;
+
 Metrics::Metrics()
   : ingress_requests_total_(
       "amdinfer_requests_ingress_total",
-      "Number of incoming requests to amdinfer-server", registry_.get(),
+      "Number of incoming requests to amdinfer-server",
       {{MetricCounterIDs::CppNative, {{"api", "cpp"}, {"method", "native"}}},
        {MetricCounterIDs::RestGet, {{"api", "rest"}, {"method", "GET"}}},
        {MetricCounterIDs::RestPost, {{"api", "rest"}, {"method", "POST"}}}}),
     pipeline_ingress_total_(
       "amdinfer_pipeline_ingress_total",
       "Number of incoming requests at different pipeline stages",
-      registry_.get(),
       {{MetricCounterIDs::PipelineIngressBatcher, {{"stage", "batcher"}}},
-       {MetricCounterIDs::PipelineIngressWorker, {{"stage", "worker"}}}}),
+       {MetricCounterIDs::PipelineIngressWorker, {{"stage", "worker"}}}},
+      true),
     pipeline_egress_total_(
       "amdinfer_pipeline_egress_total",
       "Number of outgoing requests at different pipeline stages",
-      registry_.get(),
       {{MetricCounterIDs::PipelineEgressBatcher, {{"stage", "batcher"}}},
-       {MetricCounterIDs::PipelineEgressWorker, {{"stage", "worker"}}}}),
+       {MetricCounterIDs::PipelineEgressWorker, {{"stage", "worker"}}}},
+      true),
+    batcher_expired_total_(
+      "amdinfer_batcher_expired_total",
+      "Number of requests rejected by the batcher after their deadline passed",
+      {{MetricCounterIDs::BatcherExpired, {}}}, true),
+    cancelled_total_(
+      "amdinfer_cancelled_total",
+      "Number of requests dropped after their client cancelled them",
+      {{MetricCounterIDs::BatcherCancelled, {{"stage", "batcher"}}},
+       {MetricCounterIDs::WorkerCancelled, {{"stage", "worker"}}}},
+      true),
+    batches_total_(
+      "amdinfer_batches_total",
+      "Number of batches sent by the batcher by why they were sent",
+      {{MetricCounterIDs::BatchesFull, {{"reason", "full"}}},
+       {MetricCounterIDs::BatchesTimeout, {{"reason", "timeout"}}},
+       {MetricCounterIDs::BatchesDeadline, {{"reason", "deadline"}}},
+       {MetricCounterIDs::BatchesShutdown, {{"reason", "shutdown"}}}},
+      true),
+    worker_time_total_(
+      "amdinfer_worker_time_microseconds_total",
+      "Time the workers spent running batches and waiting for them",
+      {{MetricCounterIDs::WorkerBusyTime, {{"state", "busy"}}},
+       {MetricCounterIDs::WorkerIdleTime, {{"state", "idle"}}}},
+      true),
+    memory_cache_total_(
+      "amdinfer_memory_cache_total",
+      "Number of allocations served with and without the thread caches",
+      {{MetricCounterIDs::MemoryCacheHits, {{"result", "hit"}}},
+       {MetricCounterIDs::MemoryCacheMisses, {{"result", "miss"}}}}),
+    response_cache_total_(
+      "amdinfer_response_cache_total",
+      "Number of requests served from and added to the response caches",
+      {{MetricCounterIDs::ResponseCacheHits, {{"result", "hit"}}},
+       {MetricCounterIDs::ResponseCacheMisses, {{"result", "miss"}}},
+       {MetricCounterIDs::ResponseCacheEvictions, {{"result", "eviction"}}}}),
     bytes_transferred_("exposer_transferred_bytes_total",
-                       "Transferred bytes to metrics services", registry_.get(),
+                       "Transferred bytes to metrics services",
                        {{MetricCounterIDs::TransferredBytes, {}}}),
-    num_scrapes_("exposer_scrapes_total",
-                 "Number of times metrics were scraped", registry_.get(),
+    num_scrapes_("exposer_scrapes_total", "Number of times metrics were scraped",
                  {{MetricCounterIDs::MetricScrapes, {}}}),
+    thread_pool_steals_(
+      "amdinfer_thread_pool_steals_total",
+      "Number of functions a thread pool thread took from another's queue",
+      {{MetricCounterIDs::ThreadPoolSteals, {}}}),
+    memory_failures_total_(
+      "amdinfer_memory_allocation_failures_total",
+      "Number of allocations that the memory pool's allocators failed",
+      {{MetricCounterIDs::MemoryAllocationFailures, {}}}, true),
+    lazy_loading_total_(
+      "amdinfer_lazy_loading_total",
+      "Number of models loaded by their first request and unloaded to make "
+      "room for others",
+      {{MetricCounterIDs::LazyColdStarts, {{"event", "cold_start"}}},
+       {MetricCounterIDs::LazyEvictions, {{"event", "eviction"}}}},
+      true),
+    requests_shed_total_(
+      "amdinfer_requests_shed_total",
+      "Number of requests refused by the servers to shed load",
+      {{MetricCounterIDs::RequestsShedOverload, {{"reason", "overload"}}},
+       {MetricCounterIDs::RequestsShedRateLimit, {{"reason", "rate_limit"}}}}),
+    requests_coalesced_total_(
+      "amdinfer_requests_coalesced_total",
+      "Number of requests answered by an identical request in flight",
+      {{MetricCounterIDs::RequestsCoalesced, {}}}),
+    trace_spans_dropped_total_(
+      "amdinfer_trace_spans_dropped_total",
+      "Number of trace spans dropped because the export queue was full",
+      {{MetricCounterIDs::TraceSpansDropped, {}}}),
+    cpu_time_total_(
+      "amdinfer_cpu_time_microseconds_total",
+      "CPU time the server spent on requests in each stage",
+      {{MetricCounterIDs::CpuTimeDecode, {{"stage", "decode"}}},
+       {MetricCounterIDs::CpuTimeBatch, {{"stage", "batch"}}},
+       {MetricCounterIDs::CpuTimeCompute, {{"stage", "compute"}}},
+       {MetricCounterIDs::CpuTimeEncode, {{"stage", "encode"}}}},
+      true),
+    copied_bytes_total_(
+      "amdinfer_copied_bytes_total",
+      "Bytes the server copied for requests in each stage",
+      {{MetricCounterIDs::CopiedBytesDecode, {{"stage", "decode"}}},
+       {MetricCounterIDs::CopiedBytesBatch, {{"stage", "batch"}}},
+       {MetricCounterIDs::CopiedBytesCompute, {{"stage", "compute"}}},
+       {MetricCounterIDs::CopiedBytesEncode, {{"stage", "encode"}}}},
+      true),
+    device_time_total_(
+      "amdinfer_device_time_microseconds_total",
+      "Time endpoints used their shared devices and waited for their turns",
+      {{MetricCounterIDs::DeviceBusyTime, {{"state", "busy"}}},
+       {MetricCounterIDs::DeviceWaitTime, {{"state", "waiting"}}}},
+      true),
     queue_sizes_total_("amdinfer_queue_sizes_total",
                        "Number of elements in the queues in amdinfer-server",
                        registry_.get(),
                        {{MetricGaugeIDs::QueuesBatcherInput,
                          {{"direction", "input"}, {"stage", "batcher"}}},
+                        {MetricGaugeIDs::QueuesBatcherInputHigh,
+                         {{"direction", "input"},
+                          {"stage", "batcher"},
+                          {"priority", "high"}}},
+                        {MetricGaugeIDs::QueuesBatcherInputNormal,
+                         {{"direction", "input"},
+                          {"stage", "batcher"},
+                          {"priority", "normal"}}},
+                        {MetricGaugeIDs::QueuesBatcherInputLow,
+                         {{"direction", "input"},
+                          {"stage", "batcher"},
+                          {"priority", "low"}}},
                         {MetricGaugeIDs::QueuesBatcherOutput,
                          {{"direction", "output"}, {"stage", "batcher"}}},
                         {MetricGaugeIDs::QueuesBufferInput,
                          {{"direction", "input"}, {"stage", "buffer"}}},
                         {MetricGaugeIDs::QueuesBufferOutput,
-                         {{"direction", "output"}, {"stage", "buffer"}}}}),
+                         {{"direction", "output"}, {"stage", "buffer"}}}},
+                       true),
+    batcher_timeout_("amdinfer_batcher_timeout_milliseconds",
+                     "Time the batcher waited to fill the last batch",
+                     registry_.get(), {{MetricGaugeIDs::BatcherTimeout, {}}},
+                     true),
+    batcher_fill_ratio_(
+      "amdinfer_batcher_fill_ratio",
+      "Fraction of the batch size filled by the batcher in the last batch",
+      registry_.get(), {{MetricGaugeIDs::BatcherFillRatio, {}}}, true),
+    xmodel_jobs_("amdinfer_xmodel_jobs",
+                 "Number of jobs in flight on the XModel runners",
+                 registry_.get(), {{MetricGaugeIDs::XmodelJobs, {}}}, true),
+    xmodel_utilization_(
+      "amdinfer_xmodel_utilization",
+      "Fraction of the last second an XModel runner had a job in flight",
+      registry_.get(), {{MetricGaugeIDs::XmodelUtilization, {}}}, true),
+    workers_busy_(
+      "amdinfer_workers_busy",
+      "Number of workers running batches, averaged since the last scrape",
+      registry_.get(), {{MetricGaugeIDs::WorkersBusy, {}}}, true),
+    gpu_busy_("amdinfer_gpu_busy",
+              "Fraction of time the workers' GPUs were busy, summed over them",
+              registry_.get(), {{MetricGaugeIDs::GpuBusy, {}}}, true),
+    gpu_memory_used_("amdinfer_gpu_memory_used_bytes",
+                     "Memory used on the workers' GPUs, summed over them",
+                     registry_.get(), {{MetricGaugeIDs::GpuMemoryUsed, {}}},
+                     true),
+    memory_bytes_(
+      "amdinfer_memory_bytes", "Bytes of memory in the memory pool's allocators",
+      registry_.get(),
+      {{MetricGaugeIDs::MemoryReserved, {{"state", "reserved"}}},
+       {MetricGaugeIDs::MemoryUsed, {{"state", "used"}}},
+       {MetricGaugeIDs::MemoryCached, {{"state", "cached"}}}},
+      true),
+    memory_free_chunks_("amdinfer_memory_free_chunks",
+                        "Number of free chunks in the memory pool's allocators",
+                        registry_.get(),
+                        {{MetricGaugeIDs::MemoryFreeChunks, {}}}, true),
+    memory_largest_free_(
+      "amdinfer_memory_largest_free_bytes",
+      "Bytes in the largest free chunk of the memory pool's allocators",
+      registry_.get(), {{MetricGaugeIDs::MemoryLargestFree, {}}}, true),
+    memory_fragmentation_(
+      "amdinfer_memory_fragmentation",
+      "One minus the largest free chunk's share of the free memory",
+      registry_.get(), {{MetricGaugeIDs::MemoryFragmentation, {}}}, true),
+    load_time_(
+      "amdinfer_model_load_seconds",
+      "Time the last load of the model spent in each phase, in seconds",
+      registry_.get(),
+      {{MetricGaugeIDs::LoadOpen, {{"phase", "open"}}},
+       {MetricGaugeIDs::LoadInit, {{"phase", "init"}}},
+       {MetricGaugeIDs::LoadReadModel, {{"phase", "read_model"}}},
+       {MetricGaugeIDs::LoadCompile, {{"phase", "compile"}}},
+       {MetricGaugeIDs::LoadCreateRunner, {{"phase", "create_runner"}}},
+       {MetricGaugeIDs::LoadAcquire, {{"phase", "acquire"}}},
+       {MetricGaugeIDs::LoadReserve, {{"phase", "reserve"}}},
+       {MetricGaugeIDs::LoadWarmup, {{"phase", "warmup"}}},
+       {MetricGaugeIDs::LoadStart, {{"phase", "start"}}}},
+      true),
+    library_load_time_(
+      "amdinfer_worker_library_load_seconds",
+      "Time spent preloading each worker's library, in seconds",
+      registry_.get(), {{MetricGaugeIDs::LibraryLoad, {}}}, true),
     metric_latency_("exposer_request_latencies",
                     "Latencies of serving scrape requests, in microseconds",
                     registry_.get(),
                     {{MetricSummaryIDs::MetricLatency,
                       prometheus::Summary::Quantiles{
                         kPercentile50, kPercentile90, kPercentile99}}}),
-    request_latency_("amdinfer_request_latency",
-                     "Latencies of serving requests, in microseconds",
-                     registry_.get(),
-                     {{MetricSummaryIDs::RequestLatency,
-                       prometheus::Summary::Quantiles{
-                         kPercentile50, kPercentile90, kPercentile99}}}) {
+    request_latency_(
+      "amdinfer_request_latency",
+      "Latencies of serving requests, in microseconds",
+      {{MetricHistogramIDs::RequestLatency, {}}},
+      exponentialBuckets(kLatencyStart, kBucketFactor, kLatencyBuckets), true),
+    thread_pool_queue_wait_(
+      "amdinfer_thread_pool_queue_wait",
+      "Time functions waited in the thread pool queues, in microseconds",
+      {{MetricHistogramIDs::ThreadPoolQueueWait, {}}},
+      exponentialBuckets(kQueueWaitStart, kBucketFactor, kQueueWaitBuckets)),
+    stage_latency_(
+      "amdinfer_stage_latency",
+      "Time requests spent in each stage of the pipeline, in microseconds",
+      {{MetricHistogramIDs::StageIngress, {{"stage", "ingress"}}},
+       {MetricHistogramIDs::StageBatcher, {{"stage", "batcher"}}},
+       {MetricHistogramIDs::StageQueue, {{"stage", "queue"}}},
+       {MetricHistogramIDs::StageCompute, {{"stage", "compute"}}},
+       {MetricHistogramIDs::StageRespond, {{"stage", "respond"}}}},
+      exponentialBuckets(kStageStart, kBucketFactor, kStageBuckets), true),
+    batch_size_("amdinfer_batch_size",
+                "Number of requests in the batches sent by the batcher",
+                {{MetricHistogramIDs::BatchSize, {}}},
+                exponentialBuckets(1, kBucketFactor, kBatchSizeBuckets), true),
+    batch_fill_ratio_(
+      "amdinfer_batch_fill_ratio",
+      "Fraction of the batch size filled in the batches sent by the batcher",
+      {{MetricHistogramIDs::BatchFillRatio, {}}},
+      linearBuckets(kFillRatioWidth, kFillRatioWidth, kFillRatioBuckets),
+      true),
+    batch_padding_(
+      "amdinfer_batch_padding",
+      "Number of unused samples a worker ran to fill a compiled batch size",
+      {{MetricHistogramIDs::BatchPadding, {}}},
+      exponentialBuckets(1, kBucketFactor, kBatchSizeBuckets), true) {
   std::lock_guard lock{this->collectables_mutex_};
   collectables_.push_back(this->registry_);
 
   this->serializer_ = std::make_unique<prometheus::TextSerializer>();
 }
 
-void Metrics::incrementCounter(MetricCounterIDs id, size_t increment) {
+CounterFamily* Metrics::getFamily(MetricCounterIDs id) {
   switch (id) {
     case MetricCounterIDs::RestGet:
     case MetricCounterIDs::RestPost:
     case MetricCounterIDs::CppNative:
-      this->ingress_requests_total_.increment(id);
-      break;
+      return &this->ingress_requests_total_;
     case MetricCounterIDs::PipelineIngressBatcher:
     case MetricCounterIDs::PipelineIngressWorker:
-      this->pipeline_ingress_total_.increment(id);
-      break;
+      return &this->pipeline_ingress_total_;
     case MetricCounterIDs::PipelineEgressBatcher:
     case MetricCounterIDs::PipelineEgressWorker:
-      this->pipeline_egress_total_.increment(id);
-      break;
+      return &this->pipeline_egress_total_;
+    case MetricCounterIDs::BatcherExpired:
+      return &this->batcher_expired_total_;
+    case MetricCounterIDs::BatcherCancelled:
+    case MetricCounterIDs::WorkerCancelled:
+      return &this->cancelled_total_;
+    case MetricCounterIDs::BatchesFull:
+    case MetricCounterIDs::BatchesTimeout:
+    case MetricCounterIDs::BatchesDeadline:
+    case MetricCounterIDs::BatchesShutdown:
+      return &this->batches_total_;
+    case MetricCounterIDs::WorkerBusyTime:
+    case MetricCounterIDs::WorkerIdleTime:
+      return &this->worker_time_total_;
+    case MetricCounterIDs::MemoryCacheHits:
+    case MetricCounterIDs::MemoryCacheMisses:
+      return &this->memory_cache_total_;
+    case MetricCounterIDs::ResponseCacheHits:
+    case MetricCounterIDs::ResponseCacheMisses:
+    case MetricCounterIDs::ResponseCacheEvictions:
+      return &this->response_cache_total_;
     case MetricCounterIDs::TransferredBytes:
-      this->bytes_transferred_.increment(id, increment);
-      break;
+      return &this->bytes_transferred_;
     case MetricCounterIDs::MetricScrapes:
-      this->num_scrapes_.increment(id);
-      break;
+      return &this->num_scrapes_;
+    case MetricCounterIDs::ThreadPoolSteals:
+      return &this->thread_pool_steals_;
+    case MetricCounterIDs::MemoryAllocationFailures:
+      return &this->memory_failures_total_;
+    case MetricCounterIDs::LazyColdStarts:
+    case MetricCounterIDs::LazyEvictions:
+      return &this->lazy_loading_total_;
+    case MetricCounterIDs::RequestsShedOverload:
+    case MetricCounterIDs::RequestsShedRateLimit:
+      return &this->requests_shed_total_;
+    case MetricCounterIDs::RequestsCoalesced:
+      return &this->requests_coalesced_total_;
+    case MetricCounterIDs::TraceSpansDropped:
+      return &this->trace_spans_dropped_total_;
+    case MetricCounterIDs::CpuTimeDecode:
+    case MetricCounterIDs::CpuTimeBatch:
+    case MetricCounterIDs::CpuTimeCompute:
+    case MetricCounterIDs::CpuTimeEncode:
+      return &this->cpu_time_total_;
+    case MetricCounterIDs::CopiedBytesDecode:
+    case MetricCounterIDs::CopiedBytesBatch:
+    case MetricCounterIDs::CopiedBytesCompute:
+    case MetricCounterIDs::CopiedBytesEncode:
+      return &this->copied_bytes_total_;
+    case MetricCounterIDs::DeviceBusyTime:
+    case MetricCounterIDs::DeviceWaitTime:
+      return &this->device_time_total_;
     default:
-      break;
+      return nullptr;
   }
 }
 
-void Metrics::setGauge(MetricGaugeIDs id, double value) {
+GaugeFamily* Metrics::getFamily(MetricGaugeIDs id) {
   switch (id) {
     case MetricGaugeIDs::QueuesBatcherInput:
+    case MetricGaugeIDs::QueuesBatcherInputHigh:
+    case MetricGaugeIDs::QueuesBatcherInputNormal:
+    case MetricGaugeIDs::QueuesBatcherInputLow:
     case MetricGaugeIDs::QueuesBatcherOutput:
     case MetricGaugeIDs::QueuesBufferInput:
     case MetricGaugeIDs::QueuesBufferOutput:
-      this->queue_sizes_total_.set(id, value);
-      break;
+      return &this->queue_sizes_total_;
+    case MetricGaugeIDs::BatcherTimeout:
+      return &this->batcher_timeout_;
+    case MetricGaugeIDs::BatcherFillRatio:
+      return &this->batcher_fill_ratio_;
+    case MetricGaugeIDs::XmodelJobs:
+      return &this->xmodel_jobs_;
+    case MetricGaugeIDs::XmodelUtilization:
+      return &this->xmodel_utilization_;
+    case MetricGaugeIDs::WorkersBusy:
+      return &this->workers_busy_;
+    case MetricGaugeIDs::GpuBusy:
+      return &this->gpu_busy_;
+    case MetricGaugeIDs::GpuMemoryUsed:
+      return &this->gpu_memory_used_;
+    case MetricGaugeIDs::MemoryReserved:
+    case MetricGaugeIDs::MemoryUsed:
+    case MetricGaugeIDs::MemoryCached:
+      return &this->memory_bytes_;
+    case MetricGaugeIDs::MemoryFreeChunks:
+      return &this->memory_free_chunks_;
+    case MetricGaugeIDs::MemoryLargestFree:
+      return &this->memory_largest_free_;
+    case MetricGaugeIDs::MemoryFragmentation:
+      return &this->memory_fragmentation_;
+    case MetricGaugeIDs::LoadOpen:
+    case MetricGaugeIDs::LoadInit:
+    case MetricGaugeIDs::LoadReadModel:
+    case MetricGaugeIDs::LoadCompile:
+    case MetricGaugeIDs::LoadCreateRunner:
+    case MetricGaugeIDs::LoadAcquire:
+    case MetricGaugeIDs::LoadReserve:
+    case MetricGaugeIDs::LoadWarmup:
+    case MetricGaugeIDs::LoadStart:
+      return &this->load_time_;
+    case MetricGaugeIDs::LibraryLoad:
+      return &this->library_load_time_;
     default:
-      break;
+      return nullptr;
   }
 }
 
-void Metrics::observeSummary(MetricSummaryIDs id, double value) {
+SummaryFamily* Metrics::getFamily(MetricSummaryIDs id) {
   switch (id) {
     case MetricSummaryIDs::MetricLatency:
-      this->metric_latency_.observe(id, value);
-      break;
-    case MetricSummaryIDs::RequestLatency:
-      this->request_latency_.observe(id, value);
-      break;
+      return &this->metric_latency_;
+    default:
+      return nullptr;
+  }
+}
+
+HistogramFamily* Metrics::getFamily(MetricHistogramIDs id) {
+  switch (id) {
+    case MetricHistogramIDs::RequestLatency:
+      return &this->request_latency_;
+    case MetricHistogramIDs::ThreadPoolQueueWait:
+      return &this->thread_pool_queue_wait_;
+    case MetricHistogramIDs::StageIngress:
+    case MetricHistogramIDs::StageBatcher:
+    case MetricHistogramIDs::StageQueue:
+    case MetricHistogramIDs::StageCompute:
+    case MetricHistogramIDs::StageRespond:
+      return &this->stage_latency_;
+    case MetricHistogramIDs::BatchSize:
+      return &this->batch_size_;
+    case MetricHistogramIDs::BatchFillRatio:
+      return &this->batch_fill_ratio_;
+    case MetricHistogramIDs::BatchPadding:
+      return &this->batch_padding_;
     default:
-      break;
+      return nullptr;
+  }
+}
+
+void Metrics::incrementCounter(MetricCounterIDs id, size_t increment) {
+  if (auto* family = this->getFamily(id); family != nullptr) {
+    family->increment(id, increment);
+  }
+}
+
+void Metrics::incrementCounter(MetricCounterIDs id, const MetricLabels& labels,
+                               size_t increment) {
+  if (auto* family = this->getFamily(id); family != nullptr) {
+    family->add(id, labels)->increment(increment);
+  }
+}
+
+void Metrics::setGauge(MetricGaugeIDs id, double value) {
+  if (auto* family = this->getFamily(id); family != nullptr) {
+    family->set(id, value);
+  }
+}
+
+void Metrics::setGauge(MetricGaugeIDs id, const MetricLabels& labels,
+                       double value) {
+  if (auto* family = this->getFamily(id); family != nullptr) {
+    family->add(id, labels)->Set(value);
+  }
+}
+
+void Metrics::watchMetrics(const void* owner,
+                           std::function<void(Metrics*)> read) {
+  std::lock_guard lock{watchers_mutex_};
+  watchers_.emplace_back(owner, std::move(read));
+}
+
+void Metrics::unwatchMetrics(const void* owner) {
+  std::lock_guard lock{watchers_mutex_};
+  watchers_.erase(std::remove_if(watchers_.begin(), watchers_.end(),
+                                 [owner](const auto& watcher) {
+                                   return watcher.first == owner;
+                                 }),
+                  watchers_.end());
+}
+
+void Metrics::observeSummary(MetricSummaryIDs id, double value) {
+  if (auto* family = this->getFamily(id); family != nullptr) {
+    family->observe(id, value);
+  }
+}
+
+void Metrics::observeHistogram(MetricHistogramIDs id, double value) {
+  if (auto* family = this->getFamily(id); family != nullptr) {
+    family->observe(id, value);
+  }
+}
+
+void Metrics::addModel(ModelMetrics* metrics) {
+  const auto& labels = metrics->labels_;
+  std::lock_guard lock{models_mutex_};
+  model_metrics_.push_back(metrics);
+  models_[labels]++;
+  // adding a series that exists returns it
+  for (const auto& id : kModelCounters) {
+    metrics->counters_[static_cast<size_t>(id)] =
+      this->getFamily(id)->add(id, labels);
+  }
+  for (const auto& id : kModelGauges) {
+    metrics->gauges_[static_cast<size_t>(id)] =
+      this->getFamily(id)->add(id, labels);
+  }
+  for (const auto& id : kModelHistograms) {
+    metrics->histograms_[static_cast<size_t>(id)] =
+      this->getFamily(id)->add(id, labels);
+  }
+}
+
+void Metrics::removeModel(const ModelMetrics* metrics) {
+  std::lock_guard lock{models_mutex_};
+  model_metrics_.erase(
+    std::find(model_metrics_.begin(), model_metrics_.end(), metrics));
+  if (--models_[metrics->labels_] > 0) {
+    return;
+  }
+  models_.erase(metrics->labels_);
+  for (const auto& id : kModelCounters) {
+    this->getFamily(id)->remove(metrics->counters_[static_cast<size_t>(id)]);
+  }
+  for (const auto& id : kModelGauges) {
+    this->getFamily(id)->remove(metrics->gauges_[static_cast<size_t>(id)]);
+  }
+  for (const auto& id : kModelHistograms) {
+    this->getFamily(id)->remove(metrics->histograms_[static_cast<size_t>(id)]);
   }
 }
 
@@ -222,6 +936,19 @@ std::string Metrics::getMetrics() {
 
   std::vector<prometheus::MetricFamily> metrics;
 
+  {
+    std::lock_guard lock{models_mutex_};
+    for (auto* model : model_metrics_) {
+      model->readGauges();
+    }
+  }
+  {
+    std::lock_guard lock{watchers_mutex_};
+    for (const auto& [owner, read] : watchers_) {
+      read(this);
+    }
+  }
+
   {
     std::lock_guard<std::mutex> lock{this->collectables_mutex_};
 
@@ -236,6 +963,23 @@ std::string Metrics::getMetrics() {
                      std::make_move_iterator(my_metrics.end()));
     }
   }
+  for (const auto* family :
+       {&ingress_requests_total_, &pipeline_ingress_total_,
+        &pipeline_egress_total_, &batcher_expired_total_, &cancelled_total_,
+        &batches_total_, &worker_time_total_, &memory_cache_total_,
+        &response_cache_total_, &bytes_transferred_, &num_scrapes_,
+        &thread_pool_steals_, &memory_failures_total_, &lazy_loading_total_,
+        &requests_shed_total_, &requests_coalesced_total_,
+        &trace_spans_dropped_total_, &cpu_time_total_,
+        &copied_bytes_total_, &device_time_total_}) {
+    metrics.push_back(family->collect());
+  }
+  metrics.push_back(request_latency_.collect());
+  metrics.push_back(thread_pool_queue_wait_.collect());
+  metrics.push_back(stage_latency_.collect());
+  metrics.push_back(batch_size_.collect());
+  metrics.push_back(batch_fill_ratio_.collect());
+  metrics.push_back(batch_padding_.collect());
 
   std::string response = serializer_->Serialize(metrics);
   auto body_size = response.length();
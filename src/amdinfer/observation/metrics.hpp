@@ -21,16 +21,24 @@
 #ifndef GUARD_AMDINFER_OBSERVATION_METRICS
 #define GUARD_AMDINFER_OBSERVATION_METRICS
 
-#include <prometheus/registry.h>    // for Registry
-#include <prometheus/serializer.h>  // for Serializer
-#include <prometheus/summary.h>     // for Summary, BuildSummary, Summa...
+#include <prometheus/client_metric.h>  // for ClientMetric
+#include <prometheus/metric_family.h>  // for MetricFamily
+#include <prometheus/registry.h>       // for Registry
+#include <prometheus/serializer.h>     // for Serializer
+#include <prometheus/summary.h>        // for Summary, BuildSummary, Summa...
 
+#include <array>          // for array
+#include <atomic>         // for atomic
+#include <chrono>         // for duration
 #include <cstddef>        // for size_t
+#include <cstdint>        // for uint64_t
+#include <functional>     // for function
 #include <map>            // for map
 #include <memory>         // for weak_ptr, shared_ptr, uni...
 #include <mutex>          // for mutex
 #include <string>         // for string
 #include <unordered_map>  // for unordered_map
+#include <utility>        // for pair
 #include <vector>         // for vector
 
 #include "amdinfer/build_options.hpp"  // for AMDINFER_ENABLE_METRICS
@@ -39,7 +47,6 @@
 
 namespace prometheus {
 class Collectable;
-class Counter;
 class Gauge;
 template <class T>
 class Family;
@@ -56,55 +63,104 @@ enum class MetricCounterIDs {
   PipelineIngressWorker,
   PipelineEgressBatcher,
   PipelineEgressWorker,
+  BatcherExpired,
+  BatcherCancelled,
+  WorkerCancelled,
+  BatchesFull,
+  BatchesTimeout,
+  BatchesDeadline,
+  BatchesShutdown,
+  WorkerBusyTime,
+  WorkerIdleTime,
+  MemoryCacheHits,
+  MemoryCacheMisses,
+  ResponseCacheHits,
+  ResponseCacheMisses,
+  ResponseCacheEvictions,
   TransferredBytes,
   MetricScrapes,
+  ThreadPoolSteals,
+  MemoryAllocationFailures,
+  LazyColdStarts,
+  LazyEvictions,
+  RequestsShedOverload,
+  RequestsShedRateLimit,
+  RequestsCoalesced,
+  TraceSpansDropped,
+  CpuTimeDecode,
+  CpuTimeBatch,
+  CpuTimeCompute,
+  CpuTimeEncode,
+  CopiedBytesDecode,
+  CopiedBytesBatch,
+  CopiedBytesCompute,
+  CopiedBytesEncode,
+  DeviceBusyTime,
+  DeviceWaitTime,
+  /// the number of counters
+  Count,
 };
 
 /// Defines the IDs of the tracked gauges
 enum class MetricGaugeIDs {
   QueuesBatcherInput,
+  QueuesBatcherInputHigh,
+  QueuesBatcherInputNormal,
+  QueuesBatcherInputLow,
   QueuesBatcherOutput,
   QueuesBufferInput,
   QueuesBufferOutput,
+  BatcherTimeout,
+  BatcherFillRatio,
+  XmodelJobs,
+  XmodelUtilization,
+  WorkersBusy,
+  GpuBusy,
+  GpuMemoryUsed,
+  MemoryReserved,
+  MemoryUsed,
+  MemoryCached,
+  MemoryFreeChunks,
+  MemoryLargestFree,
+  MemoryFragmentation,
+  LoadOpen,
+  LoadInit,
+  LoadReadModel,
+  LoadCompile,
+  LoadCreateRunner,
+  LoadAcquire,
+  LoadReserve,
+  LoadWarmup,
+  LoadStart,
+  LibraryLoad,
+  /// the number of gauges
+  Count,
 };
 
 /// Defines the IDs of the tracked summaries
 enum class MetricSummaryIDs {
   MetricLatency,
-  RequestLatency,
 };
 
-/**
- * @brief The CounterFamily class stores the tracked counters and
- * provides methods to increment them using an ID.
- *
- */
-class CounterFamily {
- public:
-  /**
-   * @brief Construct a new CounterFamily object
-   *
-   * @param name name of the counter
-   * @param help help message for the counter
-   * @param registry
-   * @param labels map of IDs to counter labels
-   */
-  CounterFamily(
-    const std::string& name, const std::string& help,
-    prometheus::Registry* registry,
-    const std::unordered_map<MetricCounterIDs,
-                             std::map<std::string, std::string>>& labels);
-
-  /// Increment the named counter by 1
-  void increment(MetricCounterIDs id);
-  /// Increment the named counter by increment
-  void increment(MetricCounterIDs id, size_t increment);
-
- private:
-  prometheus::Family<prometheus::Counter>& family_;
-  std::unordered_map<MetricCounterIDs, prometheus::Counter&> counters_;
+/// Defines the IDs of the tracked histograms
+enum class MetricHistogramIDs {
+  RequestLatency,
+  ThreadPoolQueueWait,
+  StageIngress,
+  StageBatcher,
+  StageQueue,
+  StageCompute,
+  StageRespond,
+  BatchSize,
+  BatchFillRatio,
+  BatchPadding,
+  /// the number of histograms
+  Count,
 };
 
+/// Labels that tell apart the series of a metric
+using MetricLabels = std::map<std::string, std::string>;
+
 /**
  * @brief The GaugeFamily class stores the tracked gauges and
  * provides methods to set them using an ID.
@@ -119,17 +175,25 @@ class GaugeFamily {
    * @param help help message for the gauge
    * @param registry
    * @param labels map of IDs to gauge labels
+   * @param per_model if true, the gauges are only added for each model with
+   * add() and the labels are the ones they all share
    */
   GaugeFamily(const std::string& name, const std::string& help,
               prometheus::Registry* registry,
-              const std::unordered_map<
-                MetricGaugeIDs, std::map<std::string, std::string>>& labels);
+              const std::unordered_map<MetricGaugeIDs, MetricLabels>& labels,
+              bool per_model = false);
 
   /// Set the named gauge to a particular value
   void set(MetricGaugeIDs id, double value);
 
+  /// Add a gauge for the ID with extra labels
+  prometheus::Gauge* add(MetricGaugeIDs id, const MetricLabels& labels);
+  /// Remove a gauge made by add()
+  void remove(prometheus::Gauge* gauge);
+
  private:
   prometheus::Family<prometheus::Gauge>& family_;
+  std::unordered_map<MetricGaugeIDs, MetricLabels> labels_;
   std::unordered_map<MetricGaugeIDs, prometheus::Gauge&> gauges_;
 };
 
@@ -162,6 +226,257 @@ class SummaryFamily {
   std::unordered_map<MetricSummaryIDs, prometheus::Summary&> summaries_;
 };
 
+/// Number of shards each histogram records observations into
+constexpr size_t kHistogramShards = 8;
+/// Number of shards each counter is incremented in
+constexpr size_t kCounterShards = 8;
+/// Size of a cache line, used to keep shards on separate cache lines
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * @brief The Counter counts events. Like the Histogram, each thread increments
+ * one of a few shards on separate cache lines with a relaxed atomic so
+ * counting from many threads doesn't contend and the shards are only summed
+ * when the counter is collected.
+ */
+class Counter {
+ public:
+  /// Increment the counter
+  void increment(uint64_t increment = 1);
+  /// Sum the shards
+  [[nodiscard]] uint64_t value() const;
+
+ private:
+  struct alignas(kCacheLineSize) Shard {
+    std::atomic<uint64_t> value = 0;
+  };
+
+  std::array<Shard, kCounterShards> shards_;
+};
+
+/**
+ * @brief The CounterFamily stores the tracked counters of one metric and
+ * provides methods to increment them using an ID. Its series are collected by
+ * Metrics along with the metrics in the Prometheus registry.
+ */
+class CounterFamily {
+ public:
+  /**
+   * @brief Construct a new CounterFamily object
+   *
+   * @param name name of the counter
+   * @param help help message for the counter
+   * @param labels map of IDs to counter labels
+   * @param per_model if true, the counters are only added for each model with
+   * add() and the labels are the ones they all share
+   */
+  CounterFamily(
+    std::string name, std::string help,
+    const std::unordered_map<MetricCounterIDs, MetricLabels>& labels,
+    bool per_model = false);
+
+  /// Increment the named counter by increment
+  void increment(MetricCounterIDs id, size_t increment = 1);
+
+  /**
+   * @brief Add a counter for the ID with extra labels. Adding labels that
+   * exist returns the existing counter
+   */
+  Counter* add(MetricCounterIDs id, const MetricLabels& labels);
+  /// Remove a counter made by add()
+  void remove(const Counter* counter);
+
+  /// Get the family and all its series in the Prometheus format
+  [[nodiscard]] prometheus::MetricFamily collect() const;
+
+ private:
+  std::string name_;
+  std::string help_;
+  std::unordered_map<MetricCounterIDs, MetricLabels> labels_;
+  std::unordered_map<MetricCounterIDs, Counter*> defaults_;
+  mutable std::mutex mutex_;
+  std::map<MetricLabels, std::unique_ptr<Counter>> counters_;
+};
+
+/**
+ * @brief Get exponentially growing bucket bounds for a histogram
+ *
+ * @param start the first bound
+ * @param factor the ratio between consecutive bounds
+ * @param count the number of bounds
+ * @return std::vector<double>
+ */
+std::vector<double> exponentialBuckets(double start, double factor,
+                                       size_t count);
+
+/**
+ * @brief Get evenly spaced bucket bounds for a histogram
+ *
+ * @param start the first bound
+ * @param width the difference between consecutive bounds
+ * @param count the number of bounds
+ * @return std::vector<double>
+ */
+std::vector<double> linearBuckets(double start, double width, size_t count);
+
+/**
+ * @brief The Histogram counts observations in fixed buckets. Unlike a
+ * Prometheus summary, recording doesn't take a lock or maintain quantiles:
+ * each thread adds to one of a few shards with relaxed atomics and the shards
+ * are only summed when the histogram is collected. Histograms can also be
+ * aggregated across servers to compute percentiles in PromQL.
+ */
+class Histogram {
+ public:
+  /**
+   * @brief Construct a new Histogram object
+   *
+   * @param bounds upper bounds of the buckets, in increasing order. Values
+   * larger than the last bound are counted in a +Inf bucket
+   */
+  explicit Histogram(const std::vector<double>* bounds);
+
+  /// Record one value
+  void observe(double value);
+  /// Sum the shards into a Prometheus histogram
+  [[nodiscard]] prometheus::ClientMetric::Histogram collect() const;
+
+ private:
+  struct alignas(kCacheLineSize) Shard {
+    // one count per bucket, including the +Inf bucket
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<double> sum = 0;
+  };
+
+  const std::vector<double>* bounds_;
+  std::array<Shard, kHistogramShards> shards_;
+};
+
+/**
+ * @brief The HistogramFamily stores the tracked histograms of one metric and
+ * provides methods to record events in them using an ID. Its series are
+ * collected by Metrics along with the metrics in the Prometheus registry.
+ */
+class HistogramFamily {
+ public:
+  /**
+   * @brief Construct a new HistogramFamily object
+   *
+   * @param name name of the histogram
+   * @param help help message of the histogram
+   * @param labels map of IDs to histogram labels
+   * @param bounds upper bounds of the buckets, in increasing order
+   * @param per_model if true, the histograms are only added for each model
+   * with add() and the labels are the ones they all share
+   */
+  HistogramFamily(
+    std::string name, std::string help,
+    const std::unordered_map<MetricHistogramIDs, MetricLabels>& labels,
+    std::vector<double> bounds, bool per_model = false);
+
+  /// Record an event for a particular histogram
+  void observe(MetricHistogramIDs id, double value);
+
+  /**
+   * @brief Add a histogram for the ID with extra labels. Adding labels that
+   * exist returns the existing histogram
+   */
+  Histogram* add(MetricHistogramIDs id, const MetricLabels& labels);
+  /// Remove a histogram made by add()
+  void remove(const Histogram* histogram);
+
+  /// Get the family and all its series in the Prometheus format
+  [[nodiscard]] prometheus::MetricFamily collect() const;
+
+ private:
+  std::string name_;
+  std::string help_;
+  std::vector<double> bounds_;
+  std::unordered_map<MetricHistogramIDs, MetricLabels> labels_;
+  std::unordered_map<MetricHistogramIDs, Histogram*> defaults_;
+  mutable std::mutex mutex_;
+  std::map<MetricLabels, std::unique_ptr<Histogram>> histograms_;
+};
+
+/**
+ * @brief The ModelMetrics class holds the metrics of one endpoint, labelled
+ * with its model, version and worker. The labelled series are made once when
+ * the endpoint is loaded so updating them doesn't look anything up and they're
+ * removed when it's unloaded. Metrics that aren't tracked per model are
+ * ignored.
+ */
+class ModelMetrics {
+ public:
+  /**
+   * @brief Construct a new ModelMetrics object
+   *
+   * @param model name of the model
+   * @param version version of the model. It's empty if it has none
+   * @param worker name of the worker that serves the endpoint
+   */
+  ModelMetrics(const std::string& model, const std::string& version,
+               const std::string& worker);
+  ModelMetrics(ModelMetrics const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  ModelMetrics& operator=(const ModelMetrics&) = delete;
+  ModelMetrics(ModelMetrics&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  ModelMetrics& operator=(ModelMetrics&& other) = delete;
+  ~ModelMetrics();  ///< Destructor
+
+  /// Increment one named counter
+  void incrementCounter(MetricCounterIDs id, size_t increment = 1);
+  /// Set one named gauge
+  void setGauge(MetricGaugeIDs id, double value);
+  /**
+   * @brief Compute a gauge when the metrics are scraped instead of setting it
+   * whenever it changes. A gauge with many watchers is set to the sum of what
+   * they read. Watching a gauge again with the same owner replaces the
+   * watcher.
+   *
+   * @param owner what the watcher belongs to, to remove it with
+   * unwatchGauges()
+   * @param id gauge to compute
+   * @param read function that reads the gauge's value. It's called from the
+   * thread that scrapes the metrics
+   */
+  void watchGauge(const void* owner, MetricGaugeIDs id,
+                  std::function<double()> read);
+  /// Remove the gauge watchers added by the owner
+  void unwatchGauges(const void* owner);
+  /// Record one event in a histogram
+  void observeHistogram(MetricHistogramIDs id, double value);
+  /// Record a duration in a histogram, in microseconds
+  template <typename Rep, typename Period>
+  void observeDuration(MetricHistogramIDs id,
+                       std::chrono::duration<Rep, Period> duration) {
+    this->observeHistogram(
+      id, std::chrono::duration<double, std::micro>(duration).count());
+  }
+
+ private:
+  friend class Metrics;
+
+  struct GaugeWatcher {
+    const void* owner;
+    MetricGaugeIDs id;
+    std::function<double()> read;
+  };
+
+  /// Set the watched gauges to what their watchers read
+  void readGauges();
+
+  MetricLabels labels_;
+  std::array<Counter*, static_cast<size_t>(MetricCounterIDs::Count)>
+    counters_{};
+  std::array<prometheus::Gauge*, static_cast<size_t>(MetricGaugeIDs::Count)>
+    gauges_{};
+  std::array<Histogram*, static_cast<size_t>(MetricHistogramIDs::Count)>
+    histograms_{};
+  std::mutex watchers_mutex_;
+  std::vector<GaugeWatcher> watchers_;
+};
+
 /**
  * @brief The Metrics class exposes thread-safe methods for clients to update
  * metrics when events of interest occur. It also defines the body of the
@@ -194,6 +509,16 @@ class Metrics {
    * @param id counter to increment
    */
   void incrementCounter(MetricCounterIDs id, size_t increment = 1);
+  /**
+   * @brief Increment the series of a named counter with extra labels, adding
+   * it if it doesn't exist
+   *
+   * @param id counter to increment
+   * @param labels labels of the series
+   * @param increment amount to increment by
+   */
+  void incrementCounter(MetricCounterIDs id, const MetricLabels& labels,
+                        size_t increment = 1);
 
   /**
    * @brief Set one named gauge
@@ -202,6 +527,28 @@ class Metrics {
    * @param value value to set the gauge to
    */
   void setGauge(MetricGaugeIDs id, double value);
+  /**
+   * @brief Set the series of a named gauge with extra labels, adding it if it
+   * doesn't exist
+   *
+   * @param id gauge to set
+   * @param labels labels of the series
+   * @param value value to set the gauge to
+   */
+  void setGauge(MetricGaugeIDs id, const MetricLabels& labels, double value);
+  /**
+   * @brief Update metrics when they're scraped instead of whenever they
+   * change. Unlike the watchers of a ModelMetrics, the watcher sets the
+   * metrics itself so it can label their series
+   *
+   * @param owner what the watcher belongs to, to remove it with
+   * unwatchMetrics()
+   * @param read function that updates the metrics. It's called from the
+   * thread that scrapes the metrics
+   */
+  void watchMetrics(const void* owner, std::function<void(Metrics*)> read);
+  /// Remove the watchers added by the owner
+  void unwatchMetrics(const void* owner);
 
   /**
    * @brief Record one event in a summary
@@ -211,26 +558,95 @@ class Metrics {
    */
   void observeSummary(MetricSummaryIDs id, double value);
 
+  /**
+   * @brief Record one event in a histogram
+   *
+   * @param id histogram to make the observation
+   * @param value value to record
+   */
+  void observeHistogram(MetricHistogramIDs id, double value);
+
  private:
+  friend class ModelMetrics;
+
   /// Construct a new Metrics object
   Metrics();
   /// Destroy the Metrics object
   ~Metrics() = default;
 
+  /// Get the family of a counter
+  CounterFamily* getFamily(MetricCounterIDs id);
+  /// Get the family of a gauge
+  GaugeFamily* getFamily(MetricGaugeIDs id);
+  /// Get the family of a summary
+  SummaryFamily* getFamily(MetricSummaryIDs id);
+  /// Get the family of a histogram
+  HistogramFamily* getFamily(MetricHistogramIDs id);
+
+  /// Add the series of a model's metrics
+  void addModel(ModelMetrics* metrics);
+  /**
+   * @brief Remove the series of a model's metrics. Series with the same labels
+   * are shared so they're only removed once no model uses them
+   */
+  void removeModel(const ModelMetrics* metrics);
+
   std::shared_ptr<prometheus::Registry> registry_ =
     std::make_shared<prometheus::Registry>();
   std::unique_ptr<prometheus::Serializer> serializer_;
   std::vector<std::weak_ptr<prometheus::Collectable>> collectables_;
   std::mutex collectables_mutex_;
+  // number of models that share the series with the labels
+  std::map<MetricLabels, int> models_;
+  // the models whose watched gauges are read when the metrics are scraped
+  std::vector<ModelMetrics*> model_metrics_;
+  std::mutex models_mutex_;
+  // owners and watchers that update metrics when they're scraped
+  std::vector<std::pair<const void*, std::function<void(Metrics*)>>>
+    watchers_;
+  std::mutex watchers_mutex_;
 
   CounterFamily ingress_requests_total_;
   CounterFamily pipeline_ingress_total_;
   CounterFamily pipeline_egress_total_;
+  CounterFamily batcher_expired_total_;
+  CounterFamily cancelled_total_;
+  CounterFamily batches_total_;
+  CounterFamily worker_time_total_;
+  CounterFamily memory_cache_total_;
+  CounterFamily response_cache_total_;
   CounterFamily bytes_transferred_;
   CounterFamily num_scrapes_;
+  CounterFamily thread_pool_steals_;
+  CounterFamily memory_failures_total_;
+  CounterFamily lazy_loading_total_;
+  CounterFamily requests_shed_total_;
+  CounterFamily requests_coalesced_total_;
+  CounterFamily trace_spans_dropped_total_;
+  CounterFamily cpu_time_total_;
+  CounterFamily copied_bytes_total_;
+  CounterFamily device_time_total_;
   GaugeFamily queue_sizes_total_;
+  GaugeFamily batcher_timeout_;
+  GaugeFamily batcher_fill_ratio_;
+  GaugeFamily xmodel_jobs_;
+  GaugeFamily xmodel_utilization_;
+  GaugeFamily workers_busy_;
+  GaugeFamily gpu_busy_;
+  GaugeFamily gpu_memory_used_;
+  GaugeFamily memory_bytes_;
+  GaugeFamily memory_free_chunks_;
+  GaugeFamily memory_largest_free_;
+  GaugeFamily memory_fragmentation_;
+  GaugeFamily load_time_;
+  GaugeFamily library_load_time_;
   SummaryFamily metric_latency_;
-  SummaryFamily request_latency_;
+  HistogramFamily request_latency_;
+  HistogramFamily thread_pool_queue_wait_;
+  HistogramFamily stage_latency_;
+  HistogramFamily batch_size_;
+  HistogramFamily batch_fill_ratio_;
+  HistogramFamily batch_padding_;
 };
 
 }  // namespace amdinfer
@@ -0,0 +1,216 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements on-demand profiling of the server's threads
+ */
+
+#include "amdinfer/observation/profiling.hpp"
+
+#include <algorithm>  // for max, min, remove_if
+#include <array>      // for array
+#include <cstdio>     // for snprintf
+#include <memory>     // for shared_ptr, make_shared
+#include <mutex>      // for mutex, lock_guard
+#include <string>     // for string, to_string
+#include <thread>     // for yield
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/util/thread.hpp"      // for getThreadName
+
+namespace amdinfer {
+
+namespace detail {
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<bool> profiling_enabled = false;
+}  // namespace detail
+
+namespace {
+
+struct ProfileEvent {
+  const char* name;
+  const char* category;
+  ProfileClock::time_point start;
+  ProfileClock::time_point end;
+};
+
+/**
+ * @brief The events recorded by one thread. Only the thread writes to it and
+ * it sets busy while it does so the profiler can wait for it to finish when
+ * profiling stops.
+ */
+struct ThreadEvents {
+  ThreadEvents(int id, std::string name)
+    : id(id), name(std::move(name)), events(kProfileEventsPerThread) {}
+
+  int id;
+  std::string name;
+  std::vector<ProfileEvent> events;
+  // number of events recorded since profiling started. The newest ones wrap
+  // around the ring buffer and replace the oldest
+  size_t count = 0;
+  std::atomic<bool> busy = false;
+};
+
+using ThreadEventsPtr = std::shared_ptr<ThreadEvents>;
+
+class Profiler {
+ public:
+  void start() {
+    std::lock_guard lock{mutex_};
+    if (profiling()) {
+      throw invalid_argument("Profiling is already running");
+    }
+    // forget threads that have exited since the last profile
+    auto exited = [](const auto& thread) { return thread.use_count() == 1; };
+    threads_.erase(std::remove_if(threads_.begin(), threads_.end(), exited),
+                   threads_.end());
+    for (const auto& thread : threads_) {
+      thread->count = 0;
+    }
+    start_ = ProfileClock::now();
+    detail::profiling_enabled.store(true);
+  }
+
+  std::string stop() {
+    std::lock_guard lock{mutex_};
+    if (!detail::profiling_enabled.exchange(false)) {
+      throw invalid_argument("Profiling is not running");
+    }
+    // a thread may have checked that profiling is on just before it stopped
+    for (const auto& thread : threads_) {
+      while (thread->busy.load()) {
+        std::this_thread::yield();
+      }
+    }
+    return this->serialize(ProfileClock::now());
+  }
+
+  ThreadEventsPtr addThread() {
+    std::lock_guard lock{mutex_};
+    auto thread =
+      std::make_shared<ThreadEvents>(next_id_++, util::getThreadName());
+    threads_.push_back(thread);
+    return thread;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<ThreadEventsPtr> threads_;
+  ProfileClock::time_point start_;
+  int next_id_ = 1;
+
+  /**
+   * @brief Serialize the events in the Chrome trace format with times in
+   * microseconds since profiling started
+   *
+   * @param stop when profiling stopped
+   * @return std::string
+   */
+  [[nodiscard]] std::string serialize(ProfileClock::time_point stop) const {
+    std::string json = R"({"displayTimeUnit":"ms","traceEvents":[)";
+    bool first = true;
+    auto append = [&](const std::string& event) {
+      if (!first) {
+        json += ",";
+      }
+      json += event;
+      first = false;
+    };
+    auto micros = [](ProfileClock::duration duration) {
+      constexpr auto kMaxSize = 32;
+      std::array<char, kMaxSize> buffer{};
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+      std::snprintf(
+        buffer.data(), buffer.size(), "%.3f",
+        std::chrono::duration<double, std::micro>(duration).count());
+      return std::string{buffer.data()};
+    };
+
+    for (const auto& thread : threads_) {
+      if (thread->count == 0) {
+        continue;
+      }
+      const auto tid = std::to_string(thread->id);
+      append(R"({"name":"thread_name","ph":"M","pid":1,"tid":)" + tid +
+             R"(,"args":{"name":")" + escape(thread->name) + R"("}})");
+
+      const auto size = std::min(thread->count, kProfileEventsPerThread);
+      const auto oldest = thread->count - size;
+      for (auto i = oldest; i < thread->count; ++i) {
+        const auto& event = thread->events[i % kProfileEventsPerThread];
+        const auto start = std::max(event.start, start_);
+        const auto end = std::min(std::max(event.end, start), stop);
+        append(R"({"name":")" + escape(event.name) + R"(","cat":")" +
+               escape(event.category) + R"(","ph":"X","pid":1,"tid":)" +
+               tid + R"(,"ts":)" + micros(start - start_) + R"(,"dur":)" +
+               micros(end - start) + "}");
+      }
+    }
+    json += "]}";
+    return json;
+  }
+
+  static std::string escape(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const auto c : str) {
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+        escaped += c;
+      } else if (static_cast<unsigned char>(c) >= ' ') {
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
+};
+
+Profiler& getProfiler() {
+  static Profiler profiler;
+  return profiler;
+}
+
+}  // namespace
+
+void startProfiling() { getProfiler().start(); }
+
+std::string stopProfiling() { return getProfiler().stop(); }
+
+void profileEvent(const char* name, const char* category,
+                  ProfileClock::time_point start,
+                  ProfileClock::time_point end) {
+  thread_local ThreadEventsPtr thread = nullptr;
+  if (!profiling()) {
+    return;
+  }
+  if (thread == nullptr) {
+    thread = getProfiler().addThread();
+  }
+
+  // busy has to be set before checking if profiling is still on so the
+  // profiler either sees this thread as busy or this thread sees it stopped
+  thread->busy.store(true);
+  if (detail::profiling_enabled.load()) {
+    thread->events[thread->count % kProfileEventsPerThread] = {name, category,
+                                                               start, end};
+    ++thread->count;
+  }
+  thread->busy.store(false, std::memory_order_release);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,138 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines on-demand profiling of the server's threads
+ */
+
+#ifndef GUARD_AMDINFER_OBSERVATION_PROFILING
+#define GUARD_AMDINFER_OBSERVATION_PROFILING
+
+#include <atomic>   // for atomic, memory_order_relaxed
+#include <chrono>   // for steady_clock
+#include <cstddef>  // for size_t
+#include <string>   // for string
+
+namespace amdinfer {
+
+using ProfileClock = std::chrono::steady_clock;
+
+/// Number of events each thread keeps while profiling. Older ones are dropped
+constexpr size_t kProfileEventsPerThread = 16384;
+
+namespace detail {
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+extern std::atomic<bool> profiling_enabled;
+}  // namespace detail
+
+/// Check if profiling is on. It's cheap enough to call on the hot path
+inline bool profiling() {
+  return detail::profiling_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get the current time if profiling is on and a default time otherwise
+ * so timing events costs nothing when profiling is off
+ *
+ * @return ProfileClock::time_point
+ */
+inline ProfileClock::time_point profileNow() {
+  return profiling() ? ProfileClock::now() : ProfileClock::time_point{};
+}
+
+/**
+ * @brief Start recording events from all threads. Each thread records into
+ * its own ring buffer so recording never takes a lock
+ *
+ * @throws invalid_argument if profiling is already on
+ */
+void startProfiling();
+
+/**
+ * @brief Stop recording events and return them as a Chrome trace in JSON. It
+ * can be opened with Perfetto (https://ui.perfetto.dev) or chrome://tracing
+ *
+ * @return std::string
+ */
+std::string stopProfiling();
+
+/**
+ * @brief Record an event on the calling thread if profiling is on. The name
+ * and category aren't copied so they must be string literals
+ *
+ * @param name name of the event
+ * @param category group the event belongs to
+ * @param start when the event started
+ * @param end when the event ended
+ */
+void profileEvent(const char* name, const char* category,
+                  ProfileClock::time_point start, ProfileClock::time_point end);
+
+/**
+ * @brief Record an event on the calling thread that ends now if profiling is
+ * on. Events that started before profiling did are cut to when it started
+ *
+ * @param name name of the event
+ * @param category group the event belongs to
+ * @param start when the event started
+ */
+inline void profileEvent(const char* name, const char* category,
+                         ProfileClock::time_point start) {
+  if (profiling()) {
+    profileEvent(name, category, start, ProfileClock::now());
+  }
+}
+
+/**
+ * @brief Records an event on the calling thread that lasts for the lifetime of
+ * this object if profiling was on when it was created
+ */
+class ProfileScope {
+ public:
+  /**
+   * @brief Construct a new ProfileScope object
+   *
+   * @param name name of the event. It must be a string literal
+   * @param category group the event belongs to. It must be a string literal
+   */
+  ProfileScope(const char* name, const char* category)
+    : name_(name), category_(category), enabled_(profiling()) {
+    if (enabled_) {
+      start_ = ProfileClock::now();
+    }
+  }
+  ProfileScope(ProfileScope const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  ProfileScope& operator=(const ProfileScope&) = delete;
+  ProfileScope(ProfileScope&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  ProfileScope& operator=(ProfileScope&& other) = delete;
+  /// Destructor
+  ~ProfileScope() {
+    if (enabled_) {
+      profileEvent(name_, category_, start_, ProfileClock::now());
+    }
+  }
+
+ private:
+  const char* name_;
+  const char* category_;
+  bool enabled_;
+  ProfileClock::time_point start_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_OBSERVATION_PROFILING
@@ -25,7 +25,11 @@
 #include <opentelemetry/context/runtime_context.h>
 #include <opentelemetry/exporters/ostream/span_exporter.h>
 #include <opentelemetry/exporters/otlp/otlp_http_exporter.h>
+#include <opentelemetry/nostd/span.h>
+#include <opentelemetry/sdk/common/exporter_utils.h>
 #include <opentelemetry/sdk/resource/resource.h>
+#include <opentelemetry/sdk/trace/batch_span_processor.h>
+#include <opentelemetry/sdk/trace/batch_span_processor_options.h>
 #include <opentelemetry/sdk/trace/exporter.h>
 #include <opentelemetry/sdk/trace/processor.h>
 #include <opentelemetry/sdk/trace/recordable.h>
@@ -41,14 +45,23 @@
 #include <opentelemetry/trace/tracer.h>
 #include <opentelemetry/trace/tracer_provider.h>
 
+#include <algorithm>  // for min
+#include <atomic>     // for atomic
 #include <chrono>
+#include <cstddef>  // for size_t
 #include <cstdint>
+#include <cstdlib>  // for getenv
 #include <ext/alloc_traits.h>
 #include <map>
+#include <random>     // for minstd_rand, uniform_real_distribution
+#include <stdexcept>  // for logic_error
 #include <string>
 #include <unordered_map>
-#include <utility>  // for move
+#include <utility>  // for move, pair
 #include <variant>  // for get
+#include <vector>   // for vector
+
+#include "amdinfer/observation/metrics.hpp"  // for Metrics
 
 #ifdef AMDINFER_ENABLE_TRACING
 
@@ -89,12 +102,132 @@ class HttpTextMapCarrier
   StringMap headers_;
 };
 
-void startTracer(std::unique_ptr<trace_sdk::SpanExporter> exporter) {
-  auto processor =
-    std::make_unique<trace_sdk::SimpleSpanProcessor>(std::move(exporter));
+namespace {
+
+// time that stopping the tracer may spend exporting the remaining spans
+constexpr std::chrono::seconds kFlushTimeout{1};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<size_t> dropped_spans = 0;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::shared_ptr<trace_sdk::TracerProvider> tracer_provider;
+
+void countDroppedSpan() {
+  dropped_spans.fetch_add(1, std::memory_order_relaxed);
+#ifdef AMDINFER_ENABLE_METRICS
+  Metrics::getInstance().incrementCounter(MetricCounterIDs::TraceSpansDropped);
+#endif
+}
+
+size_t readEnv(const char* name, size_t fallback) {
+  const auto* value = std::getenv(name);
+  if (value == nullptr) {
+    return fallback;
+  }
+  try {
+    const auto parsed = std::stoll(value);
+    return parsed > 0 ? static_cast<size_t>(parsed) : fallback;
+  } catch (const std::logic_error&) {
+    return fallback;
+  }
+}
+
+/**
+ * @brief Counts the spans that leave the batch processor's queue for export so
+ * its size is known
+ */
+class CountingExporter : public trace_sdk::SpanExporter {
+ public:
+  CountingExporter(std::unique_ptr<trace_sdk::SpanExporter> exporter,
+                   std::shared_ptr<std::atomic<size_t>> queued)
+    : exporter_(std::move(exporter)), queued_(std::move(queued)) {}
+
+  std::unique_ptr<trace_sdk::Recordable> MakeRecordable() noexcept override {
+    return exporter_->MakeRecordable();
+  }
+
+  opentelemetry::sdk::common::ExportResult Export(
+    const nostd::span<std::unique_ptr<trace_sdk::Recordable>>& spans) noexcept
+    override {
+    queued_->fetch_sub(spans.size(), std::memory_order_relaxed);
+    return exporter_->Export(spans);
+  }
+
+  bool Shutdown(std::chrono::microseconds timeout) noexcept override {
+    return exporter_->Shutdown(timeout);
+  }
+
+ private:
+  std::unique_ptr<trace_sdk::SpanExporter> exporter_;
+  std::shared_ptr<std::atomic<size_t>> queued_;
+};
+
+/**
+ * @brief Queues ended spans for a background thread to export in batches. The
+ * queue is bounded and spans that end while it's full are dropped and counted
+ * so tracing never blocks the threads that end spans.
+ */
+class BoundedSpanProcessor : public trace_sdk::SpanProcessor {
+ public:
+  BoundedSpanProcessor(std::unique_ptr<trace_sdk::SpanExporter> exporter,
+                       const TraceExportOptions& options)
+    : queued_(std::make_shared<std::atomic<size_t>>(0)),
+      max_queue_size_(options.max_queue_size),
+      processor_(std::make_unique<CountingExporter>(std::move(exporter),
+                                                    queued_),
+                 getBatchOptions(options)) {}
+
+  std::unique_ptr<trace_sdk::Recordable> MakeRecordable() noexcept override {
+    return processor_.MakeRecordable();
+  }
+
+  void OnStart(trace_sdk::Recordable& span,
+               const trace_api::SpanContext& parent) noexcept override {
+    processor_.OnStart(span, parent);
+  }
+
+  void OnEnd(std::unique_ptr<trace_sdk::Recordable>&& span) noexcept override {
+    // spans are counted out as they're exported so this can only overestimate
+    // the batch processor's queue, which then never drops spans silently
+    if (queued_->fetch_add(1, std::memory_order_relaxed) >= max_queue_size_) {
+      queued_->fetch_sub(1, std::memory_order_relaxed);
+      countDroppedSpan();
+      return;
+    }
+    processor_.OnEnd(std::move(span));
+  }
+
+  bool ForceFlush(std::chrono::microseconds timeout) noexcept override {
+    return processor_.ForceFlush(timeout);
+  }
+
+  bool Shutdown(std::chrono::microseconds timeout) noexcept override {
+    return processor_.Shutdown(timeout);
+  }
+
+ private:
+  static trace_sdk::BatchSpanProcessorOptions getBatchOptions(
+    const TraceExportOptions& options) {
+    trace_sdk::BatchSpanProcessorOptions batch_options;
+    batch_options.max_queue_size = options.max_queue_size;
+    batch_options.schedule_delay_millis = options.flush_interval;
+    batch_options.max_export_batch_size =
+      std::min(options.max_batch_size, options.max_queue_size);
+    return batch_options;
+  }
+
+  std::shared_ptr<std::atomic<size_t>> queued_;
+  size_t max_queue_size_;
+  trace_sdk::BatchSpanProcessor processor_;
+};
+
+}  // namespace
+
+void startTracer(std::unique_ptr<trace_sdk::SpanProcessor> processor) {
   auto provider = std::make_shared<trace_sdk::TracerProvider>(
     std::move(processor), opentelemetry::sdk::resource::Resource::Create(
                             {{"service.name", "amdinfer"}}));
+  tracer_provider = provider;
 
   auto propagator =
     std::make_shared<opentelemetry::trace::propagation::HttpTraceContext>();
@@ -106,18 +239,40 @@ void startTracer(std::unique_ptr<trace_sdk::SpanExporter> exporter) {
     SetGlobalPropagator(propagator);
 }
 
+TraceExportOptions getTraceExportOptions() {
+  TraceExportOptions options;
+  options.max_queue_size =
+    readEnv("OTEL_BSP_MAX_QUEUE_SIZE", options.max_queue_size);
+  options.flush_interval = std::chrono::milliseconds{
+    readEnv("OTEL_BSP_SCHEDULE_DELAY",
+            static_cast<size_t>(options.flush_interval.count()))};
+  options.max_batch_size =
+    readEnv("OTEL_BSP_MAX_EXPORT_BATCH_SIZE", options.max_batch_size);
+  return options;
+}
+
 void startOStreamTracer(std::ostream& os) {
   auto exporter =
     std::make_unique<opentelemetry::exporter::trace::OStreamSpanExporter>(os);
 
-  startTracer(std::move(exporter));
+  startTracer(
+    std::make_unique<trace_sdk::SimpleSpanProcessor>(std::move(exporter)));
 }
 
-void startOtlpTracer() {
+void startOStreamTracer(std::ostream& os, const TraceExportOptions& options) {
+  auto exporter =
+    std::make_unique<opentelemetry::exporter::trace::OStreamSpanExporter>(os);
+
+  startTracer(
+    std::make_unique<BoundedSpanProcessor>(std::move(exporter), options));
+}
+
+void startOtlpTracer(const TraceExportOptions& options) {
   auto exporter =
     std::make_unique<opentelemetry::exporter::otlp::OtlpHttpExporter>();
 
-  startTracer(std::move(exporter));
+  startTracer(
+    std::make_unique<BoundedSpanProcessor>(std::move(exporter), options));
 }
 
 nostd::shared_ptr<trace_api::Tracer> getTracer() {
@@ -126,10 +281,41 @@ nostd::shared_ptr<trace_api::Tracer> getTracer() {
 }
 
 void stopTracer() {
+  if (tracer_provider != nullptr) {
+    tracer_provider->ForceFlush(kFlushTimeout);
+  }
   auto tracer = getTracer();
   tracer->Close(std::chrono::milliseconds(1));
 }
 
+namespace {
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<double> sampling_ratio = 1;
+
+/// Decide if a new trace is recorded
+bool sample() {
+  const auto ratio = sampling_ratio.load(std::memory_order_relaxed);
+  if (ratio >= 1) {
+    return true;
+  }
+  if (ratio <= 0) {
+    return false;
+  }
+  thread_local std::minstd_rand engine{std::random_device{}()};
+  return std::uniform_real_distribution<double>{0, 1}(engine) < ratio;
+}
+
+}  // namespace
+
+size_t getDroppedSpans() {
+  return dropped_spans.load(std::memory_order_relaxed);
+}
+
+void setTraceSampling(double ratio) {
+  sampling_ratio.store(ratio, std::memory_order_relaxed);
+}
+
 Trace::Trace(const std::string& name,
              const opentelemetry::v1::trace::StartSpanOptions& options) {
   auto tracer = getTracer();
@@ -198,7 +384,14 @@ void Trace::endTrace() {
   }
 }
 
+trace_api::SpanContext Trace::getContext() const {
+  return this->spans_.top()->GetContext();
+}
+
 TracePtr startTrace(const std::string& name) {
+  if (!sample()) {
+    return nullptr;
+  }
   return std::make_unique<Trace>(name);
 }
 
@@ -214,9 +407,31 @@ TracePtr startTrace(const std::string& name, const StringMap& http_headers) {
   options.kind = trace_api::SpanKind::kServer;
   options.parent = trace_api::GetSpan(new_context)->GetContext();
 
+  // follow the caller's decision if it sent a trace
+  const auto& parent = std::get<trace_api::SpanContext>(options.parent);
+  if (parent.IsValid() ? !parent.IsSampled() : !sample()) {
+    return nullptr;
+  }
   return std::make_unique<Trace>(name, options);
 }
 
+SpanPtr startBatchSpan(const std::string& name,
+                       const std::vector<TracePtr>& traces) {
+  using Attributes = std::map<std::string, std::string>;
+  std::vector<std::pair<trace_api::SpanContext, Attributes>> links;
+  for (const auto& trace : traces) {
+    if (trace != nullptr) {
+      links.emplace_back(trace->getContext(), Attributes{});
+    }
+  }
+  if (links.empty()) {
+    return nullptr;
+  }
+
+  auto tracer = getTracer();
+  return tracer->StartSpan(name, Attributes{}, links);
+}
+
 }  // namespace amdinfer
 
 #endif
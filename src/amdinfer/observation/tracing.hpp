@@ -21,9 +21,13 @@
 #ifndef GUARD_AMDINFER_OBSERVATION_TRACING
 #define GUARD_AMDINFER_OBSERVATION_TRACING
 
+#include <chrono>    // for milliseconds
+#include <cstddef>   // for size_t
 #include <iostream>  // for cout
 #include <memory>    // for shared_ptr, uniqu...
 #include <stack>     // for stack
+#include <string>    // for string
+#include <vector>    // for vector
 
 #include "amdinfer/build_options.hpp"    // for AMDINFER_ENABLE_TR...
 #include "amdinfer/core/parameters.hpp"  // for ParameterMap
@@ -43,18 +47,56 @@
 #include <opentelemetry/nostd/shared_ptr.h>
 #include <opentelemetry/std/string_view.h>          // for string_view
 #include <opentelemetry/trace/span.h>               // for span
+#include <opentelemetry/trace/span_context.h>       // for SpanContext
 #include <opentelemetry/trace/span_startoptions.h>  // for StartSpanOptions
 
 namespace amdinfer {
 
 // only initialize one exporter
 
-/// initialize tracing globally using ostream exporter
+/// Options to export spans in batches, off the threads that end them
+struct TraceExportOptions {
+  /// most spans waiting to be exported. Spans that end while it's full are
+  /// dropped and counted
+  size_t max_queue_size = 2048;
+  /// time between exports
+  std::chrono::milliseconds flush_interval{5000};
+  /// most spans in one export
+  size_t max_batch_size = 512;
+};
+
+/**
+ * @brief Get the default options to export spans, with any set by the
+ * OTEL_BSP_MAX_QUEUE_SIZE, OTEL_BSP_SCHEDULE_DELAY (in milliseconds) and
+ * OTEL_BSP_MAX_EXPORT_BATCH_SIZE environment variables
+ *
+ * @return TraceExportOptions
+ */
+TraceExportOptions getTraceExportOptions();
+
+/// initialize tracing globally using ostream exporter, exporting each span as
+/// it ends
 void startOStreamTracer(std::ostream& os = std::cout);
-/// initialize tracing globally using OTLP exporter
-void startOtlpTracer();
-/// clean up the tracing prior to shutdown
+/// initialize tracing globally using ostream exporter, exporting in batches
+void startOStreamTracer(std::ostream& os, const TraceExportOptions& options);
+/// initialize tracing globally using OTLP exporter, exporting in batches
+void startOtlpTracer(
+  const TraceExportOptions& options = getTraceExportOptions());
+/// clean up the tracing prior to shutdown, exporting the remaining spans
 void stopTracer();
+/// Get the number of spans dropped because the export queue was full
+size_t getDroppedSpans();
+/**
+ * @brief Set the fraction of new traces that are recorded. The decision is
+ * made when the trace starts and requests that aren't sampled have no trace.
+ * Requests that continue a trace from their headers follow the caller's
+ * decision instead. By default, all traces are recorded.
+ *
+ * @param ratio fraction of traces to record, in [0, 1]
+ */
+void setTraceSampling(double ratio);
+
+using SpanPtr = std::shared_ptr<opentelemetry::trace::Span>;
 
 /**
  * @brief The Trace object abstracts the details of how tracing is implemented.
@@ -91,12 +133,20 @@ class Trace final {
   /// Ends the trace
   void endTrace();
 
+  /// Get the context of the active span in the trace
+  [[nodiscard]] opentelemetry::trace::SpanContext getContext() const;
+
  private:
-  std::stack<std::shared_ptr<opentelemetry::trace::Span>> spans_;
+  std::stack<SpanPtr> spans_;
   // std::unique_ptr<opentelemetry::trace::Scope> scope_;
 };
 
-/// Start a trace with the given name
+/**
+ * @brief Start a trace with the given name
+ *
+ * @param name name of the trace
+ * @return TracePtr. It's null if the trace isn't sampled
+ */
 TracePtr startTrace(const std::string& name);
 
 /**
@@ -104,10 +154,22 @@ TracePtr startTrace(const std::string& name);
  *
  * @param name name of the trace
  * @param http_headers headers from HTTP request to extract context from
- * @return TracePtr
+ * @return TracePtr. It's null if the trace isn't sampled
  */
 TracePtr startTrace(const std::string& name, const StringMap& http_headers);
 
+/**
+ * @brief Start one span for work done on a batch of requests. Rather than
+ * adding a span to each request's trace, the span links to the active span of
+ * each sampled request. End it with End()
+ *
+ * @param name name of the span
+ * @param traces traces of the requests in the batch. Null traces are skipped
+ * @return SpanPtr. It's null if none of the requests are sampled
+ */
+SpanPtr startBatchSpan(const std::string& name,
+                       const std::vector<TracePtr>& traces);
+
 }  // namespace amdinfer
 
 #endif
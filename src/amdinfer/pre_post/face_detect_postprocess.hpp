@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Decodes the outputs of DenseBox face detection models into boxes
+ */
+
+#ifndef GUARD_AMDINFER_PRE_POST_FACE_DETECT_POSTPROCESS
+#define GUARD_AMDINFER_PRE_POST_FACE_DETECT_POSTPROCESS
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t
+#include <vector>   // for vector
+
+#include "amdinfer/pre_post/yolo_postprocess.hpp"  // for YoloBoxes, logit
+#include "amdinfer/util/vector_kernels.hpp"        // for selectMargins
+
+namespace amdinfer::pre_post {
+
+struct FaceDetectOptions {
+  /// faces with a lower probability are dropped
+  float conf_threshold = 0.7F;
+  /// faces that overlap a better face by at least this much are dropped
+  float iou_threshold = 0.3F;
+  /// pixels of the network input between the cells of the outputs
+  int step = 4;
+  /// factor for the offsets of the boxes
+  float box_scale = 1.0F;
+  /// layout of both outputs, which have 2 and 4 channels
+  YoloLayout layout = YoloLayout::NHWC;
+};
+
+/**
+ * @brief Decode the outputs of a DenseBox face detection model for one image
+ * into candidate faces. The model outputs the background and face logits of
+ * each cell of a grid and the offsets of the left, top, right and bottom of a
+ * box from the cell in pixels. The face probability is the softmax of the two
+ * logits, which is the sigmoid of their difference, so the cells are filtered
+ * by comparing the difference to the threshold in logit space a vector at a
+ * time and only the few cells that pass are decoded.
+ *
+ * @param scores the logits for one image
+ * @param offsets the offsets of the boxes for one image
+ * @param height height of the outputs' grid
+ * @param width width of the outputs' grid
+ * @param options options
+ * @param cells buffer for the indices of the cells that pass. Its memory is
+ * reused when it's passed again, such as for each image of a batch
+ * @param boxes the boxes to add to, with corners normalized to the size of
+ * the network input
+ */
+inline void decodeFaceDetect(const float* scores, const float* offsets,
+                             int height, int width,
+                             const FaceDetectOptions& options,
+                             std::vector<uint32_t>* cells, YoloBoxes* boxes) {
+  constexpr auto kScores = 2;
+  constexpr auto kOffsets = 4;
+  const auto size = static_cast<size_t>(height) * width;
+  const bool nchw = options.layout == YoloLayout::NCHW;
+  const size_t channel_stride = nchw ? size : 1;
+  const size_t score_stride = nchw ? 1 : kScores;
+  const size_t offset_stride = nchw ? 1 : kOffsets;
+
+  cells->resize(size);
+  const auto count = util::selectMargins(
+    scores + channel_stride, scores, size, score_stride,
+    detail::logit(options.conf_threshold), cells->data());
+
+  const auto net_width = static_cast<float>(width * options.step);
+  const auto net_height = static_cast<float>(height * options.step);
+  const auto scale = options.box_scale;
+  const auto columns = static_cast<uint32_t>(width);
+  const auto step = static_cast<uint32_t>(options.step);
+  for (size_t i = 0; i < count; ++i) {
+    const auto cell = (*cells)[i];
+    const auto* score = scores + cell * score_stride;
+    const auto* offset = offsets + cell * offset_stride;
+    const auto x = static_cast<float>(cell % columns * step);
+    const auto y = static_cast<float>(cell / columns * step);
+    boxes->addCorners((offset[0] * scale + x) / net_width,
+                      (offset[channel_stride] * scale + y) / net_height,
+                      (offset[2 * channel_stride] * scale + x) / net_width,
+                      (offset[3 * channel_stride] * scale + y) / net_height,
+                      detail::sigmoid(score[channel_stride] - score[0]), 0);
+  }
+}
+
+}  // namespace amdinfer::pre_post
+
+#endif  // GUARD_AMDINFER_PRE_POST_FACE_DETECT_POSTPROCESS
@@ -16,33 +16,77 @@
 #ifndef GUARD_AMDINFER_PRE_POST_GET_TOP_K
 #define GUARD_AMDINFER_PRE_POST_GET_TOP_K
 
-#include <queue>
-#include <vector>
+#include <algorithm>  // for min, max, push_heap, pop_heap, sort_heap
+#include <cstddef>    // for size_t
+#include <utility>    // for pair
+#include <vector>     // for vector
 
 namespace amdinfer::pre_post {
 
+/**
+ * @brief Get the indices of the k largest values of each row of a batch, from
+ * largest to smallest. Softmax preserves the order so this can run on the
+ * logits directly. Each row is scanned once while keeping the top k seen so
+ * far in a min-heap. Most values are smaller than the heap's minimum so the
+ * scan costs one well-predicted comparison per value.
+ *
+ * @tparam T the expected type of the data
+ * @param data pointer to the data, one row after another
+ * @param batch number of rows
+ * @param size number of elements in each row
+ * @param k number of top elements to get from each row. It's limited to size
+ * @param indices pointer to store min(k, size) indices for each row
+ */
+template <typename T>
+void getTopK(const T* data, size_t batch, size_t size, size_t k,
+             int* indices) {
+  k = std::min(k, size);
+  if (k == 0) {
+    return;
+  }
+  // ties are broken in favor of the lower index
+  using Entry = std::pair<T, int>;
+  auto greater = [](const Entry& a, const Entry& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  };
+  std::vector<Entry> heap;
+  heap.reserve(k);
+  for (size_t row = 0; row < batch; ++row) {
+    const auto* values = data + row * size;
+    heap.clear();
+    for (size_t i = 0; i < k; ++i) {
+      heap.emplace_back(values[i], static_cast<int>(i));
+      std::push_heap(heap.begin(), heap.end(), greater);
+    }
+    for (size_t i = k; i < size; ++i) {
+      if (values[i] > heap.front().first) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        heap.back() = {values[i], static_cast<int>(i)};
+        std::push_heap(heap.begin(), heap.end(), greater);
+      }
+    }
+    std::sort_heap(heap.begin(), heap.end(), greater);
+    auto* out = indices + row * k;
+    for (size_t i = 0; i < k; ++i) {
+      out[i] = heap[i].second;
+    }
+  }
+}
+
 /**
  * @brief After running softmax, get the labels associated with the top k values
  *
+ * @tparam T the expected type of the data
  * @param d pointer to the data
  * @param size number of elements in the data
  * @param k number of top elements to return
  * @return std::vector<int>
  */
-inline std::vector<int> getTopK(const double* d, size_t size, int k) {
-  std::priority_queue<std::pair<float, int>> q;
-
-  for (auto i = 0U; i < size; ++i) {
-    q.push(std::pair<float, int>(d[i], i));
-  }
-
-  std::vector<int> top_k_index;
-  top_k_index.reserve(k);
-  for (auto i = 0; i < k; ++i) {
-    const auto& [prob, index] = q.top();
-    top_k_index.push_back(index);
-    q.pop();
-  }
+template <typename T>
+std::vector<int> getTopK(const T* d, size_t size, int k) {
+  std::vector<int> top_k_index(
+    std::min(static_cast<size_t>(std::max(k, 0)), size));
+  getTopK(d, 1, size, top_k_index.size(), top_k_index.data());
   return top_k_index;
 }
 
@@ -16,14 +16,17 @@
 #ifndef GUARD_AMDINFER_PRE_POST_IMAGE_PREPROCESS
 #define GUARD_AMDINFER_PRE_POST_IMAGE_PREPROCESS
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <opencv2/core.hpp>       // for Mat, Vec3b, MatSize, Vec, CV_8SC3
 #include <opencv2/imgcodecs.hpp>  // for imread
 #include <opencv2/imgproc.hpp>    // for resize
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "amdinfer/pre_post/center_crop.hpp"
@@ -51,6 +54,8 @@ struct ImagePreprocessOptions {
 
   bool resize = true;
   ResizeAlgorithm resize_algorithm = ResizeAlgorithm::Simple;
+  // value of the 8-bit pixels around a letterboxed image
+  int pad_value = 128;
 
   bool convert_color = false;
   // this should be cv::ColorConversionCodes but we can't bind it to Python
@@ -69,6 +74,36 @@ struct ImagePreprocessOptions {
   bool assign = false;
 };
 
+/**
+ * @brief Resize an image to fit the output size while keeping its aspect ratio
+ * and center it with padding around it. The size it's resized to matches the
+ * one that correctLetterbox in yolo_postprocess.hpp maps boxes back from.
+ *
+ * @param img the decoded image
+ * @param height the output height
+ * @param width the output width
+ * @param pad_value the value of the padding pixels
+ * @return cv::Mat
+ */
+inline cv::Mat letterbox(const cv::Mat& img, int height, int width,
+                         int pad_value) {
+  auto new_width = width;
+  auto new_height = height;
+  if (static_cast<float>(width) / img.cols <
+      static_cast<float>(height) / img.rows) {
+    new_height = std::max((img.rows * width) / img.cols, 1);
+  } else {
+    new_width = std::max((img.cols * height) / img.rows, 1);
+  }
+  cv::Mat padded{height, width, img.type(), cv::Scalar::all(pad_value)};
+  const cv::Rect area{(width - new_width) / 2, (height - new_height) / 2,
+                      new_width, new_height};
+  // resizing into the area writes the image in place in the padded one
+  auto roi = padded(area);
+  cv::resize(img, roi, area.size(), 0, 0, cv::INTER_LINEAR);
+  return padded;
+}
+
 namespace detail {
 
 template <typename T, typename F>
@@ -109,8 +144,232 @@ void normalize(const cv::Mat& img, ImageOrder order, T* output, const T* mean,
   }
 }
 
+/**
+ * @brief Preprocess an image step by step with OpenCV. This handles all the
+ * options and is the reference for the fused path.
+ *
+ * @param img the decoded image
+ * @param options the preprocessing options
+ * @param output the buffer to write the image to
+ */
+template <typename T>
+void preprocessReference(cv::Mat img,
+                         const ImagePreprocessOptions<T, 3>& options,
+                         T* output) {
+  constexpr auto kChannels = 3;
+  if (options.convert_color) {
+    cv::cvtColor(img, img, options.color_code);
+  }
+
+  if (options.resize) {
+    switch (options.resize_algorithm) {
+      case ResizeAlgorithm::Simple:
+        cv::resize(img, img, cv::Size(options.width, options.height), 0, 0,
+                   cv::INTER_LINEAR);
+        break;
+      case ResizeAlgorithm::CenterCrop:
+        img = centerCrop(img, options.height, options.width);
+        break;
+      case ResizeAlgorithm::LetterBoxCrop:
+        img = letterbox(img, options.height, options.width, options.pad_value);
+        break;
+      default:
+        throw std::invalid_argument("Unknown resize algorithm");
+    }
+  }
+
+  if (options.convert_type) {
+    img.convertTo(img, options.type, options.convert_scale);
+  }
+  img = img.isContinuous() ? img : img.clone();
+
+  if (options.normalize) {
+    normalize<T, kChannels>(img, options.order, output, options.mean.data(),
+                            options.std.data());
+  }
+
+  if (options.assign) {
+    const auto size = img.size[0] * img.size[1] * options.channels;
+    std::copy(img.data, img.data + size, output);
+  }
+}
+
+/**
+ * @brief Check if the fused path can preprocess an image with these options.
+ * It handles normalizing 8-bit images to float with an optional swap of the
+ * red and blue channels and a simple resize.
+ *
+ * @param img the decoded image
+ * @param options the preprocessing options
+ * @return bool
+ */
+inline bool canFuse(const cv::Mat& img,
+                    const ImagePreprocessOptions<float, 3>& options) {
+  const auto swaps_channels = options.color_code == cv::COLOR_BGR2RGB ||
+                              options.color_code == cv::COLOR_RGB2BGR;
+  return img.type() == CV_8UC3 && options.normalize && !options.assign &&
+         options.convert_type && options.type == CV_32FC3 &&
+         (!options.convert_color || swaps_channels) &&
+         (!options.resize ||
+          options.resize_algorithm == ResizeAlgorithm::Simple);
+}
+
+/**
+ * @brief Preprocess an image in one pass: the color conversion, bilinear
+ * resize, type conversion, normalization and layout change are applied
+ * together for each output row so the intermediate images are never stored.
+ * The inner loops run over contiguous rows so the compiler vectorizes them.
+ * The results differ from the reference by the rounding of the resized 8-bit
+ * pixels, at most half a pixel level before normalization.
+ *
+ * @param img the decoded image. It must pass canFuse
+ * @param options the preprocessing options
+ * @param output the buffer to write the image to
+ */
+inline void preprocessFused(const cv::Mat& img,
+                            const ImagePreprocessOptions<float, 3>& options,
+                            float* output) {
+  constexpr auto kChannels = 3;
+  const auto src_height = img.rows;
+  const auto src_width = img.cols;
+  const auto height = options.resize ? options.height : src_height;
+  const auto width = options.resize ? options.width : src_width;
+  const auto swap = options.convert_color;
+
+  // (pixel * scale - mean) * std is applied as pixel * a + b
+  std::array<float, kChannels> a;
+  std::array<float, kChannels> b;
+  for (auto c = 0; c < kChannels; ++c) {
+    a[c] = static_cast<float>(options.convert_scale) * options.std[c];
+    b[c] = -options.mean[c] * options.std[c];
+  }
+
+  // source pixels and weights for each output pixel, matching the pixel
+  // centers used by cv::resize
+  const auto map = [](int dst, int dst_size, int src_size, int* first,
+                      int* second, float* weight) {
+    const auto ratio =
+      static_cast<float>(src_size) / static_cast<float>(dst_size);
+    const auto position = (static_cast<float>(dst) + 0.5F) * ratio - 0.5F;
+    auto index = static_cast<int>(std::floor(position));
+    auto fraction = position - static_cast<float>(index);
+    if (index < 0) {
+      index = 0;
+      fraction = 0;
+    }
+    if (index >= src_size - 1) {
+      index = src_size - 1;
+      fraction = 0;
+    }
+    *first = index;
+    *second = std::min(index + 1, src_size - 1);
+    *weight = fraction;
+  };
+
+  std::vector<int> x0(width);
+  std::vector<int> x1(width);
+  std::vector<float> fx(width);
+  for (auto x = 0; x < width; ++x) {
+    map(x, width, src_width, &x0[x], &x1[x], &fx[x]);
+  }
+
+  // the horizontally interpolated source rows in planar layout. Consecutive
+  // output rows mostly use the same source rows so they're kept between rows
+  std::vector<float> rows(2 * kChannels * width);
+  std::array<float*, 2> row{rows.data(), rows.data() + kChannels * width};
+  std::array<int, 2> cached{-1, -1};
+  const auto interpolate = [&](int y, float* dst) {
+    const auto* src = img.ptr<uint8_t>(y);
+    for (auto c = 0; c < kChannels; ++c) {
+      const auto channel = swap ? kChannels - 1 - c : c;
+      auto* plane = dst + c * width;
+      for (auto x = 0; x < width; ++x) {
+        const auto left = static_cast<float>(src[x0[x] * kChannels + channel]);
+        const auto right =
+          static_cast<float>(src[x1[x] * kChannels + channel]);
+        plane[x] = left + fx[x] * (right - left);
+      }
+    }
+  };
+
+  const auto plane_size = static_cast<size_t>(height) * width;
+  for (auto y = 0; y < height; ++y) {
+    int y0 = 0;
+    int y1 = 0;
+    float fy = 0;
+    map(y, height, src_height, &y0, &y1, &fy);
+    if (cached[0] != y0) {
+      // moving down the image, the old bottom row is usually the new top row
+      if (cached[1] == y0) {
+        std::swap(row[0], row[1]);
+        std::swap(cached[0], cached[1]);
+      } else {
+        interpolate(y0, row[0]);
+        cached[0] = y0;
+      }
+    }
+    if (cached[1] != y1) {
+      interpolate(y1, row[1]);
+      cached[1] = y1;
+    }
+
+    for (auto c = 0; c < kChannels; ++c) {
+      const auto* top = row[0] + c * width;
+      const auto* bottom = row[1] + c * width;
+      const auto scale = a[c];
+      const auto offset = b[c];
+      if (options.order == ImageOrder::NCHW) {
+        auto* dst = output + c * plane_size + static_cast<size_t>(y) * width;
+        for (auto x = 0; x < width; ++x) {
+          const auto value = top[x] + fy * (bottom[x] - top[x]);
+          dst[x] = value * scale + offset;
+        }
+      } else {
+        auto* dst = output + static_cast<size_t>(y) * width * kChannels + c;
+        for (auto x = 0; x < width; ++x) {
+          const auto value = top[x] + fy * (bottom[x] - top[x]);
+          dst[x * kChannels] = value * scale + offset;
+        }
+      }
+    }
+  }
+}
+
 }  // namespace detail
 
+/**
+ * @brief Preprocess a decoded image into a caller-provided buffer. Options
+ * that normalize an 8-bit image to float use a fused path that doesn't make
+ * intermediate images. Otherwise, the image goes through OpenCV step by step.
+ *
+ * @param img the decoded image
+ * @param options the preprocessing options
+ * @param output the buffer to write the image to. It must hold height * width
+ * * channels values if resizing or the image's size otherwise
+ */
+template <typename T>
+void imagePreprocess(const cv::Mat& img,
+                     const ImagePreprocessOptions<T, 3>& options, T* output) {
+  assert(options.channels == 3);
+  if (options.resize &&
+      options.resize_algorithm == ResizeAlgorithm::LetterBoxCrop) {
+    // the letterbox is resized by OpenCV in 8 bits and the rest is fused
+    auto padded = options;
+    padded.resize = false;
+    imagePreprocess(
+      letterbox(img, options.height, options.width, options.pad_value), padded,
+      output);
+    return;
+  }
+  if constexpr (std::is_same_v<T, float>) {
+    if (detail::canFuse(img, options)) {
+      detail::preprocessFused(img, options, output);
+      return;
+    }
+  }
+  detail::preprocessReference(img, options, output);
+}
+
 template <typename T>
 std::vector<std::vector<T>> imagePreprocess(
   const std::vector<std::string>& paths,
@@ -122,52 +381,20 @@ std::vector<std::vector<T>> imagePreprocess(
   const auto& width = options.width;
   const auto& channels = options.channels;
 
-  constexpr auto kChannels = 3;
-  assert(channels == kChannels);
-
-  auto index = 0;
   for (const auto& path : paths) {
     auto img = cv::imread(path);
     if (img.empty()) {
       throw std::invalid_argument(std::string("Unable to load image ") + path);
     }
-    if (options.convert_color) {
-      cv::cvtColor(img, img, options.color_code);
-    }
 
+    auto size = channels;
     if (options.resize) {
-      switch (options.resize_algorithm) {
-        case ResizeAlgorithm::Simple:
-          cv::resize(img, img, cv::Size(width, height), cv::INTER_LINEAR);
-          break;
-        case ResizeAlgorithm::CenterCrop:
-          img = centerCrop(img, height, width);
-          break;
-        default:
-          throw std::invalid_argument("Unknown resize algorithm");
-      }
-    }
-
-    if (options.convert_type) {
-      img.convertTo(img, options.type, options.convert_scale);
-    }
-    img = img.isContinuous() ? img : img.clone();
-
-    auto size = img.size[0] * img.size[1] * channels;
-    outputs.emplace_back();
-    auto& output = outputs[index++];
-    output.resize(size);
-
-    if (options.normalize) {
-      const auto* mean = options.mean.data();
-      const auto* std = options.std.data();
-      detail::normalize<T, kChannels>(img, options.order, output.data(), mean,
-                                      std);
-    }
-
-    if (options.assign) {
-      output.assign(img.data, img.data + size);
+      size *= height * width;
+    } else {
+      size *= img.rows * img.cols;
     }
+    auto& output = outputs.emplace_back(size);
+    imagePreprocess(img, options, output.data());
   }
   return outputs;
 }
@@ -19,12 +19,12 @@
 #include <vector>
 
 #include "amdinfer/pre_post/get_top_k.hpp"
-#include "amdinfer/pre_post/softmax.hpp"
 
 namespace amdinfer::pre_post {
 
 /**
- * @brief Perform postprocessing of the data
+ * @brief Perform postprocessing of the data. Softmax preserves the order of
+ * the values so the top k are taken from the data directly.
  *
  * @tparam T the expected type of the data
  * @param output output from the server
@@ -33,11 +33,7 @@ namespace amdinfer::pre_post {
  */
 template <typename T>
 std::vector<int> resnet50Postprocess(const T* data, size_t size, int k) {
-  std::vector<double> softmax;
-  softmax.resize(size, 0);
-
-  calcSoftmax(data, size, softmax.data());
-  return getTopK(softmax.data(), size, k);
+  return getTopK(data, size, k);
 }
 
 }  // namespace amdinfer::pre_post
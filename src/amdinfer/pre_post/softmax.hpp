@@ -16,10 +16,108 @@
 #ifndef GUARD_AMDINFER_PRE_POST_SOFTMAX
 #define GUARD_AMDINFER_PRE_POST_SOFTMAX
 
-#include <cstddef>
+#include <algorithm>  // for max, max_element
+#include <array>      // for array
+#include <cmath>      // for exp
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int32_t
+#include <cstring>    // for memcpy
 
 namespace amdinfer::pre_post {
 
+namespace detail {
+
+// partial results are kept per lane so the loops vectorize without fast-math
+constexpr size_t kSoftmaxLanes = 16;
+
+/**
+ * @brief Replace each value x with an approximation of exp(x - max) in single
+ * precision. The argument is split into n * ln(2) + r so exp(x) = 2^n * exp(r),
+ * where exp(r) is a polynomial and 2^n is built from the exponent bits. The
+ * relative error is about 2e-7 and the loop is branch-free so it vectorizes.
+ *
+ * @param data pointer to the values
+ * @param size number of values
+ * @param max the maximum of the values. Arguments below -87 are clamped so the
+ * results stay normal floats
+ */
+inline void expShifted(float* data, size_t size, float max) {
+  constexpr float kMin = -87.0F;
+  constexpr float kLog2e = 1.44269504F;
+  // ln(2) split in two so n * ln(2) is exact in the first part
+  constexpr float kLn2Hi = 0.693359375F;
+  constexpr float kLn2Lo = -2.12194440e-4F;
+  // adding 1.5 * 2^23 rounds to the nearest integer in the low mantissa bits
+  constexpr float kRound = 12582912.0F;
+  constexpr int32_t kRoundBits = 0x4B400000;
+  constexpr int32_t kBias = 127;
+  constexpr int32_t kMantissaBits = 23;
+
+  // the arguments are clamped in their own loop because a clamp in the same
+  // loop is turned into a branch that stops it from vectorizing
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = std::max(data[i] - max, kMin);
+  }
+  for (size_t i = 0; i < size; ++i) {
+    const float x = data[i];
+    const float shifted = x * kLog2e + kRound;
+    const float n = shifted - kRound;
+    int32_t n_bits;
+    std::memcpy(&n_bits, &shifted, sizeof(n_bits));
+    const float r = (x - n * kLn2Hi) - n * kLn2Lo;
+
+    float p = 1.0F / 720;
+    p = p * r + 1.0F / 120;
+    p = p * r + 1.0F / 24;
+    p = p * r + 1.0F / 6;
+    p = p * r + 0.5F;
+    p = p * r + 1.0F;
+    p = p * r + 1.0F;
+
+    const int32_t scale_bits = (n_bits - kRoundBits + kBias) << kMantissaBits;
+    float scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    data[i] = p * scale;
+  }
+}
+
+/// Get the maximum of the values
+inline float getMax(const float* data, size_t size) {
+  std::array<float, kSoftmaxLanes> lanes;
+  lanes.fill(data[0]);
+  size_t i = 0;
+  for (; i + kSoftmaxLanes <= size; i += kSoftmaxLanes) {
+    for (size_t j = 0; j < kSoftmaxLanes; ++j) {
+      lanes[j] = std::max(lanes[j], data[i + j]);
+    }
+  }
+  for (; i < size; ++i) {
+    lanes[0] = std::max(lanes[0], data[i]);
+  }
+  return *std::max_element(lanes.begin(), lanes.end());
+}
+
+/// Get the sum of the values
+inline float getSum(const float* data, size_t size) {
+  std::array<float, kSoftmaxLanes> lanes{};
+  size_t i = 0;
+  for (; i + kSoftmaxLanes <= size; i += kSoftmaxLanes) {
+    for (size_t j = 0; j < kSoftmaxLanes; ++j) {
+      lanes[j] += data[i + j];
+    }
+  }
+  for (; i < size; ++i) {
+    lanes[0] += data[i];
+  }
+  float sum = 0;
+  for (auto lane : lanes) {
+    sum += lane;
+  }
+  return sum;
+}
+
+}  // namespace detail
+
 /**
  * @brief Calculate softmax of the data
  *
@@ -49,6 +147,39 @@ void calcSoftmax(const T* data, size_t size, double* result) {
   }
 }
 
+/**
+ * @brief Calculate softmax of each row of a batch in single precision. The
+ * maximum of each row is subtracted before the exponent so large values don't
+ * overflow and the exponent is approximated so the loops vectorize. It's much
+ * faster than calcSoftmax for large heads, such as 1000 or 21k classes.
+ *
+ * @tparam T the expected type of the data
+ * @param data pointer to the raw data, one row after another
+ * @param batch number of rows
+ * @param size number of elements in each row
+ * @param result pointer to store the computed results. It may alias data if T
+ * is float
+ */
+template <typename T>
+void calcSoftmax(const T* data, size_t batch, size_t size, float* result) {
+  if (size == 0) {
+    return;
+  }
+  for (size_t row = 0; row < batch; ++row) {
+    const auto* in = data + row * size;
+    auto* out = result + row * size;
+    for (size_t i = 0; i < size; ++i) {
+      out[i] = static_cast<float>(in[i]);
+    }
+    const auto max = detail::getMax(out, size);
+    detail::expShifted(out, size, max);
+    const auto inverse = 1.0F / detail::getSum(out, size);
+    for (size_t i = 0; i < size; ++i) {
+      out[i] *= inverse;
+    }
+  }
+}
+
 }  // namespace amdinfer::pre_post
 
 #endif  // GUARD_AMDINFER_PRE_POST_SOFTMAX
@@ -0,0 +1,392 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the WordPiece and BPE tokenizers of text models
+ */
+
+#ifndef GUARD_AMDINFER_PRE_POST_TOKENIZE
+#define GUARD_AMDINFER_PRE_POST_TOKENIZE
+
+#include <algorithm>      // for min
+#include <cctype>         // for isspace, ispunct, tolower
+#include <cstddef>        // for size_t, ptrdiff_t
+#include <cstdint>        // for int32_t
+#include <limits>         // for numeric_limits
+#include <string>         // for string
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
+#include <vector>         // for vector
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+
+namespace amdinfer::pre_post {
+
+/**
+ * @brief Maps the tokens of a vocabulary file with one token per line to their
+ * line numbers. The tokens are viewed in the file's text, which must outlive
+ * the vocabulary, so a memory-mapped file is indexed without copying it.
+ */
+class Vocabulary {
+ public:
+  Vocabulary() = default;
+  /// Index the lines of the text
+  explicit Vocabulary(std::string_view text) {
+    int32_t id = 0;
+    forEachLine(text, [this, &id](std::string_view line) {
+      // with duplicates, the first one is used
+      ids_.try_emplace(line, id++);
+    });
+    size_ = id;
+  }
+
+  /// Get the ID of a token or -1 if it's not in the vocabulary
+  [[nodiscard]] int32_t find(std::string_view token) const {
+    const auto it = ids_.find(token);
+    return it == ids_.end() ? -1 : it->second;
+  }
+  /// Get the ID of a token, throwing invalid_argument if it's missing
+  [[nodiscard]] int32_t at(std::string_view token) const {
+    const auto id = this->find(token);
+    if (id < 0) {
+      throw invalid_argument("The vocabulary has no token " +
+                             std::string{token});
+    }
+    return id;
+  }
+  /// Get the number of lines in the vocabulary
+  [[nodiscard]] int32_t size() const { return size_; }
+
+  /**
+   * @brief Call a function with each line of text, without the line ending.
+   * The text may or may not end with a line ending
+   *
+   * @tparam F a callable taking a std::string_view
+   * @param text the text to split up
+   * @param f the function to call
+   */
+  template <typename F>
+  static void forEachLine(std::string_view text, F f) {
+    while (!text.empty()) {
+      const auto end = text.find('\n');
+      auto line = text.substr(0, end);
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      f(line);
+      if (end == std::string_view::npos) {
+        break;
+      }
+      text.remove_prefix(end + 1);
+    }
+  }
+
+ private:
+  std::unordered_map<std::string_view, int32_t> ids_;
+  int32_t size_ = 0;
+};
+
+/**
+ * @brief Split text into words on whitespace. Each ASCII punctuation character
+ * is split off as its own word if split_punctuation is set. Other bytes,
+ * including all non-ASCII UTF-8 characters, are kept as parts of words.
+ *
+ * @param text the text to split
+ * @param split_punctuation split off punctuation characters
+ * @param words set to views of the words in text
+ */
+inline void splitWords(std::string_view text, bool split_punctuation,
+                       std::vector<std::string_view>* words) {
+  words->clear();
+  size_t start = 0;
+  auto add = [&](size_t end) {
+    if (end > start) {
+      words->push_back(text.substr(start, end - start));
+    }
+  };
+  for (size_t i = 0; i < text.size(); ++i) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c < 0x80 && std::isspace(c) != 0) {
+      add(i);
+      start = i + 1;
+    } else if (split_punctuation && c < 0x80 && std::ispunct(c) != 0) {
+      add(i);
+      words->push_back(text.substr(i, 1));
+      start = i + 1;
+    }
+  }
+  add(text.size());
+}
+
+/// Get the length in bytes of the UTF-8 character that starts with a byte
+inline size_t getCharLength(char first) {
+  const auto c = static_cast<unsigned char>(first);
+  if (c >= 0xF0) {
+    return 4;
+  }
+  if (c >= 0xE0) {
+    return 3;
+  }
+  if (c >= 0xC0) {
+    return 2;
+  }
+  return 1;
+}
+
+/**
+ * @brief The base class of the tokenizers. Tokenizers are immutable after
+ * they're created so threads can share one, with each thread keeping its own
+ * scratch space in a Tokenizer::State.
+ */
+class Tokenizer {
+ public:
+  /// The scratch space of one thread
+  struct State {
+    std::string text;
+    std::vector<std::string_view> words;
+    std::string token;
+    std::string pair;
+    std::vector<std::string_view> symbols;
+  };
+
+  Tokenizer() = default;
+  virtual ~Tokenizer() = default;
+  Tokenizer(const Tokenizer&) = delete;
+  Tokenizer& operator=(const Tokenizer&) = delete;
+  Tokenizer(Tokenizer&&) = delete;
+  Tokenizer& operator=(Tokenizer&&) = delete;
+
+  /**
+   * @brief Tokenize text and append the IDs of its tokens
+   *
+   * @param text the text to tokenize
+   * @param state scratch space of the calling thread
+   * @param ids the IDs are appended to this
+   */
+  virtual void encode(std::string_view text, State* state,
+                      std::vector<int32_t>* ids) const = 0;
+
+  /// Get the ID of unknown tokens
+  [[nodiscard]] int32_t getUnknownId() const { return unknown_id_; }
+
+ protected:
+  /// Lower-case the ASCII characters of text into the state if lower is set
+  static std::string_view normalize(std::string_view text, bool lower,
+                                    State* state) {
+    if (!lower) {
+      return text;
+    }
+    state->text.assign(text);
+    for (auto& c : state->text) {
+      const auto u = static_cast<unsigned char>(c);
+      if (u < 0x80) {
+        c = static_cast<char>(std::tolower(u));
+      }
+    }
+    return state->text;
+  }
+
+  int32_t unknown_id_ = -1;
+};
+
+/**
+ * @brief The WordPiece tokenizer of BERT. Text is split into words on
+ * whitespace and punctuation and each word is split into the longest tokens in
+ * the vocabulary from the start, with tokens after the first marked by a
+ * prefix. Words that can't be split up into known tokens become one unknown
+ * token.
+ */
+class WordPieceTokenizer : public Tokenizer {
+ public:
+  /**
+   * @brief Construct a new WordPiece tokenizer
+   *
+   * @param vocabulary the vocabulary
+   * @param unknown the token of words that can't be tokenized
+   * @param lower lower-case ASCII characters before tokenizing
+   * @param prefix the prefix of tokens that continue a word
+   * @param max_length longer words, in bytes, become unknown tokens
+   */
+  WordPieceTokenizer(const Vocabulary* vocabulary, std::string_view unknown,
+                     bool lower, std::string prefix = "##",
+                     size_t max_length = kMaxWordLength)
+    : vocabulary_(vocabulary),
+      lower_(lower),
+      prefix_(std::move(prefix)),
+      max_length_(max_length) {
+    unknown_id_ = vocabulary_->at(unknown);
+  }
+
+  void encode(std::string_view text, State* state,
+              std::vector<int32_t>* ids) const override {
+    splitWords(normalize(text, lower_, state), true, &state->words);
+    for (const auto& word : state->words) {
+      this->encodeWord(word, state, ids);
+    }
+  }
+
+ private:
+  void encodeWord(std::string_view word, State* state,
+                  std::vector<int32_t>* ids) const {
+    if (word.size() > max_length_) {
+      ids->push_back(unknown_id_);
+      return;
+    }
+    const auto count = ids->size();
+    auto& token = state->token;
+    size_t start = 0;
+    while (start < word.size()) {
+      // try the longest piece first, cutting it at character boundaries
+      auto end = word.size();
+      int32_t id = -1;
+      while (end > start) {
+        token.clear();
+        if (start > 0) {
+          token += prefix_;
+        }
+        token.append(word.data() + start, end - start);
+        id = vocabulary_->find(token);
+        if (id >= 0) {
+          break;
+        }
+        do {
+          --end;
+        } while (end > start && (static_cast<unsigned char>(word[end]) &
+                                 0xC0) == 0x80);
+      }
+      if (id < 0) {
+        ids->resize(count);
+        ids->push_back(unknown_id_);
+        return;
+      }
+      ids->push_back(id);
+      start = end;
+    }
+  }
+
+  static constexpr size_t kMaxWordLength = 100;
+
+  const Vocabulary* vocabulary_;
+  bool lower_;
+  std::string prefix_;
+  size_t max_length_;
+};
+
+/**
+ * @brief The byte-pair encoding (BPE) tokenizer. Text is split into words on
+ * whitespace and each word starts as its UTF-8 characters, with a suffix
+ * added to the last one. Then, adjacent symbols are merged in the order of
+ * the merges until none of the merges apply and each symbol is looked up in the
+ * vocabulary.
+ */
+class BpeTokenizer : public Tokenizer {
+ public:
+  /**
+   * @brief Construct a new BPE tokenizer
+   *
+   * @param vocabulary the vocabulary
+   * @param merges the text of the merges, one pair of symbols separated by a
+   * space per line in priority order. It must outlive the tokenizer. Lines
+   * starting with "#" are skipped
+   * @param unknown the token of symbols that aren't in the vocabulary
+   * @param lower lower-case ASCII characters before tokenizing
+   * @param suffix the suffix of the last symbol of each word
+   */
+  BpeTokenizer(const Vocabulary* vocabulary, std::string_view merges,
+               std::string_view unknown, bool lower, std::string suffix = "")
+    : vocabulary_(vocabulary), lower_(lower), suffix_(std::move(suffix)) {
+    unknown_id_ = vocabulary_->at(unknown);
+    int32_t rank = 0;
+    Vocabulary::forEachLine(merges, [this, &rank](std::string_view line) {
+      if (line.empty() || line.front() == '#') {
+        return;
+      }
+      if (line.find(' ') == std::string_view::npos) {
+        throw invalid_argument(
+          "Merges must be two symbols separated by a space: " +
+          std::string{line});
+      }
+      ranks_.try_emplace(line, rank++);
+    });
+  }
+
+  void encode(std::string_view text, State* state,
+              std::vector<int32_t>* ids) const override {
+    splitWords(normalize(text, lower_, state), false, &state->words);
+    for (const auto& word : state->words) {
+      this->encodeWord(word, state, ids);
+    }
+  }
+
+ private:
+  void encodeWord(std::string_view word, State* state,
+                  std::vector<int32_t>* ids) const {
+    // symbols are views of the word, which has the suffix added
+    auto& text = state->token;
+    text.assign(word);
+    text += suffix_;
+    const std::string_view whole{text};
+    auto& symbols = state->symbols;
+    symbols.clear();
+    for (size_t i = 0; i < word.size();) {
+      auto length = std::min(getCharLength(word[i]), word.size() - i);
+      // the suffix is part of the last character
+      if (i + length == word.size()) {
+        length += suffix_.size();
+      }
+      symbols.push_back(whole.substr(i, length));
+      i += length;
+    }
+
+    auto& pair = state->pair;
+    while (symbols.size() > 1) {
+      auto best = std::numeric_limits<int32_t>::max();
+      size_t index = 0;
+      for (size_t i = 0; i + 1 < symbols.size(); ++i) {
+        pair.assign(symbols[i]);
+        pair += ' ';
+        pair.append(symbols[i + 1]);
+        const auto it = ranks_.find(pair);
+        if (it != ranks_.end() && it->second < best) {
+          best = it->second;
+          index = i;
+        }
+      }
+      if (best == std::numeric_limits<int32_t>::max()) {
+        break;
+      }
+      // adjacent symbols are next to each other in the word
+      symbols[index] = whole.substr(
+        symbols[index].data() - whole.data(),
+        symbols[index].size() + symbols[index + 1].size());
+      symbols.erase(symbols.begin() + static_cast<ptrdiff_t>(index) + 1);
+    }
+
+    for (const auto& symbol : symbols) {
+      const auto id = vocabulary_->find(symbol);
+      ids->push_back(id < 0 ? unknown_id_ : id);
+    }
+  }
+
+  const Vocabulary* vocabulary_;
+  bool lower_;
+  std::string suffix_;
+  std::unordered_map<std::string_view, int32_t> ranks_;
+};
+
+}  // namespace amdinfer::pre_post
+
+#endif  // GUARD_AMDINFER_PRE_POST_TOKENIZE
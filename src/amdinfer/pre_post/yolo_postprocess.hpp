@@ -0,0 +1,340 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Decodes the outputs of YOLO detection models into boxes and filters
+ * them with non-maximum suppression
+ */
+
+#ifndef GUARD_AMDINFER_PRE_POST_YOLO_POSTPROCESS
+#define GUARD_AMDINFER_PRE_POST_YOLO_POSTPROCESS
+
+#include <algorithm>  // for max, min, stable_sort
+#include <cmath>      // for exp, log
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int32_t, uint8_t
+#include <limits>     // for numeric_limits
+#include <numeric>    // for iota
+#include <vector>     // for vector
+
+#include "amdinfer/pre_post/softmax.hpp"  // for calcSoftmax
+
+namespace amdinfer::pre_post {
+
+/// Layout of each output of the model
+enum class YoloLayout {
+  /// [anchors * (5 + classes), height, width]
+  NCHW,
+  /// [height, width, anchors, 5 + classes]
+  NHWC
+};
+
+/// How the objectness and class scores in the outputs are turned into
+/// probabilities
+enum class YoloScores {
+  /// sigmoid of each score, as in YOLOv3
+  Sigmoid,
+  /// sigmoid of the objectness and softmax of the classes, as in YOLOv2
+  Softmax,
+  /// the scores are already probabilities, as in some exported YOLOv4 models
+  Probabilities
+};
+
+struct YoloOptions {
+  int classes = 80;
+  /// number of anchors for each cell of each output
+  int anchors = 3;
+  /// width and height of each anchor in pixels of the network input. Each
+  /// output has anchors pairs and the outputs are in order of decreasing
+  /// grid size
+  std::vector<float> biases;
+  int net_height = 416;
+  int net_width = 416;
+  /// boxes with a lower class probability are dropped
+  float conf_threshold = 0.5F;
+  /// boxes of the same class that overlap a better box by at least this much
+  /// are dropped
+  float iou_threshold = 0.45F;
+  YoloScores scores = YoloScores::Sigmoid;
+  /// factor for the sigmoid of the box centers of each output, as in YOLOv4.
+  /// Defaults to 1 if empty
+  std::vector<float> scale_xy;
+  YoloLayout layout = YoloLayout::NCHW;
+};
+
+/**
+ * @brief Candidate boxes stored as one array per field so the overlaps of one
+ * box with all the others are computed in vectorized loops. The corners are
+ * normalized to the size of the network input.
+ */
+struct YoloBoxes {
+  std::vector<float> x1;
+  std::vector<float> y1;
+  std::vector<float> x2;
+  std::vector<float> y2;
+  std::vector<float> score;
+  std::vector<int32_t> label;
+
+  [[nodiscard]] size_t size() const { return score.size(); }
+
+  void add(float center_x, float center_y, float width, float height,
+           float probability, int32_t klass) {
+    x1.push_back(center_x - width / 2);
+    y1.push_back(center_y - height / 2);
+    x2.push_back(center_x + width / 2);
+    y2.push_back(center_y + height / 2);
+    score.push_back(probability);
+    label.push_back(klass);
+  }
+
+  void addCorners(float left, float top, float right, float bottom,
+                  float probability, int32_t klass) {
+    x1.push_back(left);
+    y1.push_back(top);
+    x2.push_back(right);
+    y2.push_back(bottom);
+    score.push_back(probability);
+    label.push_back(klass);
+  }
+
+  void clear() {
+    for (auto* field : {&x1, &y1, &x2, &y2, &score}) {
+      field->clear();
+    }
+    label.clear();
+  }
+};
+
+namespace detail {
+
+inline float sigmoid(float x) { return 1.0F / (1.0F + std::exp(-x)); }
+
+/// Get the score whose sigmoid is the probability so thresholds are compared
+/// to the raw scores without evaluating the sigmoid
+inline float logit(float probability) {
+  if (probability <= 0) {
+    return -std::numeric_limits<float>::infinity();
+  }
+  if (probability >= 1) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return std::log(probability / (1 - probability));
+}
+
+}  // namespace detail
+
+/**
+ * @brief Decode one output of a YOLO model into candidate boxes. Cells are
+ * first filtered by their objectness in a branch-free pass over the raw
+ * scores, compared to the threshold in logit space, so only the few cells
+ * that may hold an object are decoded. Each class whose probability exceeds
+ * the threshold adds a box.
+ *
+ * @param data the output for one image
+ * @param height height of the output's grid
+ * @param width width of the output's grid
+ * @param output index of the output among the model's outputs in order of
+ * decreasing grid size, which selects its anchors
+ * @param options options
+ * @param boxes the boxes to add to
+ */
+inline void decodeYolo(const float* data, int height, int width, size_t output,
+                       const YoloOptions& options, YoloBoxes* boxes) {
+  const auto cells = static_cast<size_t>(height) * width;
+  const auto attributes = static_cast<size_t>(5 + options.classes);
+  const bool nchw = options.layout == YoloLayout::NCHW;
+  const auto attribute_stride = nchw ? cells : 1;
+  const auto cell_stride =
+    nchw ? 1 : attributes * static_cast<size_t>(options.anchors);
+  const auto anchor_stride = attributes * attribute_stride;
+
+  const bool activated = options.scores == YoloScores::Probabilities;
+  const auto conf = options.conf_threshold;
+  const auto threshold = activated ? conf : detail::logit(conf);
+  const auto scale_xy =
+    output < options.scale_xy.size() ? options.scale_xy[output] : 1.0F;
+
+  std::vector<uint8_t> mask(cells);
+  std::vector<float> classes(options.classes);
+  for (auto anchor = 0; anchor < options.anchors; ++anchor) {
+    const auto* values = data + anchor * anchor_stride;
+    const auto* objectness = values + 4 * attribute_stride;
+    for (size_t cell = 0; cell < cells; ++cell) {
+      mask[cell] = objectness[cell * cell_stride] >= threshold;
+    }
+
+    const auto bias = 2 * (output * options.anchors + anchor);
+    const auto anchor_width = options.biases.at(bias) / options.net_width;
+    const auto anchor_height = options.biases.at(bias + 1) / options.net_height;
+    for (size_t cell = 0; cell < cells; ++cell) {
+      if (mask[cell] == 0) {
+        continue;
+      }
+      const auto* box = values + cell * cell_stride;
+      const auto obj = activated ? box[4 * attribute_stride]
+                                 : detail::sigmoid(box[4 * attribute_stride]);
+
+      // a class passes if obj * p > conf so its score is compared to the
+      // threshold for p
+      const auto class_threshold =
+        activated ? conf / obj : detail::logit(conf / obj);
+      const auto* scores = box + 5 * attribute_stride;
+      if (options.scores == YoloScores::Softmax) {
+        for (auto i = 0; i < options.classes; ++i) {
+          classes[i] = scores[i * attribute_stride];
+        }
+        calcSoftmax(classes.data(), 1, classes.size(), classes.data());
+      }
+
+      const auto row = static_cast<int>(cell / width);
+      const auto column = static_cast<int>(cell % width);
+      const auto offset = (scale_xy - 1) / 2;
+      const auto center_x =
+        (column + detail::sigmoid(box[0]) * scale_xy - offset) / width;
+      const auto center_y =
+        (row + detail::sigmoid(box[attribute_stride]) * scale_xy - offset) /
+        height;
+      const auto box_width = std::exp(box[2 * attribute_stride]) * anchor_width;
+      const auto box_height =
+        std::exp(box[3 * attribute_stride]) * anchor_height;
+
+      for (auto i = 0; i < options.classes; ++i) {
+        float probability = 0;
+        if (options.scores == YoloScores::Softmax) {
+          probability = obj * classes[i];
+        } else {
+          const auto score = scores[i * attribute_stride];
+          if (score <= class_threshold) {
+            continue;
+          }
+          probability = obj * (activated ? score : detail::sigmoid(score));
+        }
+        if (probability > conf) {
+          boxes->add(center_x, center_y, box_width, box_height, probability,
+                     i);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Map boxes from a network input that the image was letterboxed into,
+ * keeping its aspect ratio, back to normalized coordinates of the image
+ *
+ * @param boxes the boxes
+ * @param image_height height of the image
+ * @param image_width width of the image
+ * @param net_height height of the network input
+ * @param net_width width of the network input
+ */
+inline void correctLetterbox(YoloBoxes* boxes, int image_height,
+                             int image_width, int net_height, int net_width) {
+  int new_width = net_width;
+  int new_height = net_height;
+  if (static_cast<float>(net_width) / image_width <
+      static_cast<float>(net_height) / image_height) {
+    new_height = (image_height * net_width) / image_width;
+  } else {
+    new_width = (image_width * net_height) / image_height;
+  }
+  const auto scale_x = static_cast<float>(net_width) / new_width;
+  const auto scale_y = static_cast<float>(net_height) / new_height;
+  const auto offset_x = (net_width - new_width) / 2.0F / net_width;
+  const auto offset_y = (net_height - new_height) / 2.0F / net_height;
+
+  const auto size = boxes->size();
+  for (auto* field : {&boxes->x1, &boxes->x2}) {
+    auto* x = field->data();
+    for (size_t i = 0; i < size; ++i) {
+      x[i] = (x[i] - offset_x) * scale_x;
+    }
+  }
+  for (auto* field : {&boxes->y1, &boxes->y2}) {
+    auto* y = field->data();
+    for (size_t i = 0; i < size; ++i) {
+      y[i] = (y[i] - offset_y) * scale_y;
+    }
+  }
+}
+
+/**
+ * @brief Filter the boxes with non-maximum suppression of each class. The
+ * boxes are sorted by score once and each kept box marks the later boxes of
+ * its class that it overlaps in a branch-free loop over all of them, which
+ * vectorizes, instead of comparing pairs one at a time.
+ *
+ * @param boxes the boxes
+ * @param iou_threshold boxes that overlap a better box of the same class by
+ * at least this intersection over union are dropped
+ * @return std::vector<size_t> the indices of the kept boxes, from the best
+ */
+inline std::vector<size_t> nonMaximumSuppression(const YoloBoxes& boxes,
+                                                 float iou_threshold) {
+  const auto size = boxes.size();
+  std::vector<size_t> order(size);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return boxes.score[a] > boxes.score[b];
+  });
+
+  std::vector<float> x1(size);
+  std::vector<float> y1(size);
+  std::vector<float> x2(size);
+  std::vector<float> y2(size);
+  std::vector<float> area(size);
+  std::vector<int32_t> label(size);
+  for (size_t i = 0; i < size; ++i) {
+    const auto index = order[i];
+    x1[i] = boxes.x1[index];
+    y1[i] = boxes.y1[index];
+    x2[i] = boxes.x2[index];
+    y2[i] = boxes.y2[index];
+    area[i] = (x2[i] - x1[i]) * (y2[i] - y1[i]);
+    label[i] = boxes.label[index];
+  }
+
+  std::vector<int32_t> suppressed(size, 0);
+  std::vector<size_t> kept;
+  for (size_t i = 0; i < size; ++i) {
+    if (suppressed[i] != 0) {
+      continue;
+    }
+    kept.push_back(order[i]);
+    const auto box_x1 = x1[i];
+    const auto box_y1 = y1[i];
+    const auto box_x2 = x2[i];
+    const auto box_y2 = y2[i];
+    const auto box_area = area[i];
+    const auto box_label = label[i];
+    for (size_t j = i + 1; j < size; ++j) {
+      const auto width =
+        std::max(std::min(box_x2, x2[j]) - std::max(box_x1, x1[j]), 0.0F);
+      const auto height =
+        std::max(std::min(box_y2, y2[j]) - std::max(box_y1, y1[j]), 0.0F);
+      const auto intersection = width * height;
+      const auto union_area = box_area + area[j] - intersection;
+      // iou >= threshold without dividing
+      const auto overlaps = intersection >= iou_threshold * union_area;
+      suppressed[j] |= static_cast<int32_t>(overlaps) &
+                       static_cast<int32_t>(label[j] == box_label);
+    }
+  }
+  return kept;
+}
+
+}  // namespace amdinfer::pre_post
+
+#endif  // GUARD_AMDINFER_PRE_POST_YOLO_POSTPROCESS
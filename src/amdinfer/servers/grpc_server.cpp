@@ -20,39 +20,63 @@
 
 #include "amdinfer/servers/grpc_server.hpp"
 
+#include <google/protobuf/arena.h>               // for Arena, ArenaOptions
 #include <google/protobuf/repeated_ptr_field.h>  // for RepeatedPtrField
+#include <grpc/grpc.h>                           // for GRPC_ARG_ALLOW_REU...
 #include <grpc/support/log.h>                    // for GPR_ASSERT, GPR_UNL...
+#include <grpc/support/time.h>                   // for gpr_now
+#include <grpcpp/alarm.h>                        // for Alarm
 #include <grpcpp/grpcpp.h>                       // for ServerCompletionQueue
 
+#include <array>          // for array
+#include <charconv>       // for from_chars
+#include <atomic>         // for atomic_bool
 #include <cassert>        // for assert
 #include <cstddef>        // for size_t, byte
 #include <cstdint>        // for uint64_t, int16_t
 #include <cstring>        // for memcpy
+#include <deque>          // for deque
 #include <exception>      // for exception
 #include <memory>         // for unique_ptr, shared_ptr
+#include <mutex>          // for mutex, lock_guard
+#include <optional>       // for optional
 #include <string>         // for allocator, string
+#include <string_view>    // for string_view
+#include <system_error>   // for errc
 #include <thread>         // for thread, yield
 #include <unordered_set>  // for unordered_set
 #include <utility>        // for move
 #include <vector>         // for vector
 
-#include "amdinfer/buffers/buffer.hpp"           // for Buffer
-#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOG...
-#include "amdinfer/clients/grpc_internal.hpp"    // for mapProtoToParameters
-#include "amdinfer/core/data_types.hpp"          // for DataType, DataType:...
-#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
-#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
-#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
-#include "amdinfer/core/parameters.hpp"          // for ParameterMap
-#include "amdinfer/core/request_container.hpp"   // for RequestContainer
-#include "amdinfer/core/shared_state.hpp"        // for SharedState
-#include "amdinfer/declarations.hpp"             // for BufferRawPtrs, Infe...
-#include "amdinfer/observation/observer.hpp"     // for Logger, Loggers
-#include "amdinfer/util/containers.hpp"          // for containerProduct
-#include "amdinfer/util/string.hpp"              // for toLower
-#include "amdinfer/util/traits.hpp"              // IWYU pragma: keep
-#include "inference.grpc.pb.h"                   // for GRPCInferenceServic...
-#include "inference.pb.h"                        // for InferTensorContents
+#include "amdinfer/buffers/buffer.hpp"              // for Buffer
+#include "amdinfer/build_options.hpp"               // for AMDINFER_ENABLE_LO...
+#include "amdinfer/clients/grpc_internal.hpp"       // for mapProtoToParameters
+#include "amdinfer/core/admission.hpp"              // for holdTicket
+#include "amdinfer/core/bytes_tensor.hpp"           // for packBytes
+#include "amdinfer/core/completion_router.hpp"      // for CompletionExecutor
+#include "amdinfer/core/data_types.hpp"             // for DataType, DataType...
+#include "amdinfer/core/exceptions.hpp"             // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"      // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"     // for InferenceResponse
+#include "amdinfer/core/metadata_cache.hpp"         // for MetadataCache
+#include "amdinfer/core/parameters.hpp"             // for ParameterMap
+#include "amdinfer/core/request_container.hpp"      // for RequestContainer
+#include "amdinfer/core/request_usage.hpp"          // for RequestUsage
+#include "amdinfer/core/server_timing.hpp"          // for ServerTiming
+#include "amdinfer/core/shared_memory.hpp"          // for isInSharedMemory
+#include "amdinfer/core/shared_memory_regions.hpp"  // for holdSharedMemory
+#include "amdinfer/core/shared_state.hpp"           // for SharedState
+#include "amdinfer/core/stream_flow.hpp"            // for StreamFlow
+#include "amdinfer/declarations.hpp"                // for BufferRawPtrs, Inf...
+#include "amdinfer/observation/observer.hpp"        // for Logger, Loggers
+#include "amdinfer/util/containers.hpp"             // for containerProduct
+#include "amdinfer/util/float_convert.hpp"          // for convertFp32ToFp16
+#include "amdinfer/util/numa.hpp"                   // for getNumaNodes
+#include "amdinfer/util/string.hpp"                 // for toLower
+#include "amdinfer/util/timestamps.hpp"             // for now
+#include "amdinfer/util/traits.hpp"                 // IWYU pragma: keep
+#include "inference.grpc.pb.h"                      // for GRPCInferenceServi...
+#include "inference.pb.h"                           // for InferTensorContents
 
 namespace amdinfer {
 class CallDataModelInfer;
@@ -61,6 +85,7 @@ class CallDataModelLoad;
 class CallDataWorkerLoad;
 class CallDataModelReady;
 class CallDataModelUnload;
+class CallDataModelUpdate;
 class CallDataWorkerUnload;
 class CallDataServerLive;
 class CallDataServerMetadata;
@@ -90,8 +115,83 @@ using AsyncService = inference::GRPCInferenceService::AsyncService;
 class CallDataBase {
  public:
   virtual void proceed() = 0;
+  /**
+   * @brief Handle an event that completed unsuccessfully
+   *
+   * @return bool - true if the event was handled and serving should continue
+   */
+  virtual bool fail() { return false; }
 };
 
+/// Runs a batch of completions when its alarm fires on a completion queue
+class CompletionAlarm : public CallDataBase {
+ public:
+  explicit CompletionAlarm(std::vector<Completion> completions)
+    : completions_(std::move(completions)) {}
+
+  void set(::grpc::CompletionQueue* cq) {
+    alarm_.Set(cq, gpr_now(GPR_CLOCK_MONOTONIC), this);
+  }
+
+  void proceed() override {
+    runCompletions(&completions_);
+    delete this;
+  }
+
+  // the alarm fails if the queue is shutting down but the responses are owed
+  bool fail() override {
+    this->proceed();
+    return true;
+  }
+
+ private:
+  ::grpc::Alarm alarm_;
+  std::vector<Completion> completions_;
+};
+
+/// Runs completions on the thread that serves a completion queue
+class CqExecutor : public CompletionExecutor {
+ public:
+  explicit CqExecutor(::grpc::ServerCompletionQueue* cq) : cq_(cq) {}
+
+  void post(std::vector<Completion> completions) override {
+    std::unique_lock lock{mutex_};
+    if (!open_) {
+      lock.unlock();
+      runCompletions(&completions);
+      return;
+    }
+    auto* alarm = new CompletionAlarm(std::move(completions));
+    alarm->set(cq_);
+  }
+
+  /// Stop using the queue. Nothing may be added to a queue that's shut down
+  void close() {
+    const std::lock_guard lock{mutex_};
+    open_ = false;
+  }
+
+ private:
+  ::grpc::ServerCompletionQueue* cq_;
+  std::mutex mutex_;
+  bool open_ = true;
+};
+
+// the executor of the completion queue served by this thread, if any
+thread_local std::shared_ptr<CqExecutor> cq_executor;
+
+// size of the first block of each CallData's arena
+constexpr size_t kArenaBlockSize = 4096;
+// smaller responses aren't worth compressing
+constexpr size_t kMinCompressedSize = 1024;
+
+google::protobuf::ArenaOptions arenaOptions(char* block, size_t size) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = size;
+  return options;
+}
+
 template <typename RequestType, typename ReplyType>
 class CallData : public CallDataBase {
  public:
@@ -99,15 +199,30 @@ class CallData : public CallDataBase {
   // server) and the completion queue "cq" used for asynchronous communication
   // with the gRPC runtime.
   CallData(AsyncService* service, ::grpc::ServerCompletionQueue* cq)
-    : service_(service), cq_(cq), status_(Create) {}
+    : service_(service),
+      cq_(cq),
+      arena_(arenaOptions(arena_block_.data(), arena_block_.size())),
+      status_(Create) {
+    ctx_.emplace();
+    createMessages();
+  }
 
   virtual ~CallData() = default;
 
+  /// Reuse a finished CallData to wait for a new request
+  void restart() {
+    reset();
+    proceed();
+  }
+
   void proceed() override {
     if (status_ == Create) {
       // Make this instance progress to the Process state.
       status_ = Process;
 
+      if (this->watchesCancellation()) {
+        this->watchCancellation();
+      }
       waitForRequest();
     } else if (status_ == Process) {
       addNewCallData();
@@ -120,11 +235,25 @@ class CallData : public CallDataBase {
       std::this_thread::yield();
     } else {
       assert(status_ == Finish);
-      // Once in the Finish state, deallocate ourselves (CallData).
-      delete this;
+      // the context is still used until gRPC says the RPC is done
+      if (done_pending_) {
+        finished_ = true;
+        return;
+      }
+      // Once in the Finish state, recycle or deallocate ourselves (CallData).
+      release();
     }
   }
 
+  bool fail() override {
+    // finishing an RPC that the client cancelled fails but it's still over
+    if (status_ == Finish) {
+      proceed();
+      return true;
+    }
+    return false;
+  }
+
   virtual void finish(const ::grpc::Status& status) = 0;
 
  protected:
@@ -135,6 +264,27 @@ class CallData : public CallDataBase {
   virtual void waitForRequest() = 0;
   virtual void handleRequest() noexcept = 0;
 
+  /// Called once the RPC is done. By default, the CallData deletes itself
+  virtual void release() { delete this; }
+  /**
+   * @brief Check if the RPC's cancellation is tracked in cancelled_. It costs
+   * one more event per RPC so it's off by default
+   */
+  [[nodiscard]] virtual bool watchesCancellation() const { return false; }
+  /**
+   * @brief Prepare a finished CallData to serve another request. All the
+   * memory of the last RPC's messages is freed at once by resetting the arena,
+   * except for its first block, which is kept for the next RPC. The context
+   * is remade since gRPC doesn't allow reusing it.
+   */
+  virtual void reset() {
+    ctx_.emplace();
+    arena_.Reset();
+    createMessages();
+    status_ = Create;
+    finished_ = false;
+  }
+
   // The means of communication with the gRPC runtime for an asynchronous
   // server.
   AsyncService* service_;
@@ -143,16 +293,71 @@ class CallData : public CallDataBase {
   // Context for the rpc, allowing to tweak aspects of it such as the use
   // of compression, authentication, as well as to send metadata back to the
   // client.
-  ::grpc::ServerContext ctx_;
+  std::optional<::grpc::ServerContext> ctx_;
 
+  // The first block of the arena. Messages of small RPCs fit in it entirely
+  std::array<char, kArenaBlockSize> arena_block_;
+  // Holds the messages and everything they allocate
+  google::protobuf::Arena arena_;
   // What we get from the client.
-  RequestType request_;
+  RequestType* request_ = nullptr;
   // What we send back to the client.
-  ReplyType reply_;
+  ReplyType* reply_ = nullptr;
 
   // Let's implement a tiny state machine with the following states.
   enum CallStatus { Create, Process, Wait, Finish };
   CallStatus status_;  // The current serving state.
+
+  // raised if the client cancels the RPC, if it's watched
+  std::shared_ptr<std::atomic_bool> cancelled_;
+
+ private:
+  /// The tag gRPC returns once the RPC is done, whether it finished or not
+  class DoneTag final : public CallDataBase {
+   public:
+    explicit DoneTag(CallData* call_data) : call_data_(call_data) {}
+    void proceed() override { call_data_->done(); }
+    bool fail() override {
+      call_data_->done();
+      return true;
+    }
+
+   private:
+    CallData* call_data_;
+  };
+
+  /// Ask gRPC to return the done tag. It must be done before the RPC starts
+  void watchCancellation() {
+    // requests of an earlier RPC may still hold the last flag
+    if (cancelled_ == nullptr || cancelled_.use_count() > 1) {
+      cancelled_ = std::make_shared<std::atomic_bool>(false);
+    } else {
+      cancelled_->store(false);
+    }
+    done_pending_ = true;
+    ctx_->AsyncNotifyWhenDone(&done_tag_);
+  }
+
+  void done() {
+    done_pending_ = false;
+    if (ctx_->IsCancelled()) {
+      cancelled_->store(true);
+    }
+    if (finished_) {
+      release();
+    }
+  }
+
+  void createMessages() {
+    request_ = google::protobuf::Arena::CreateMessage<RequestType>(&arena_);
+    reply_ = google::protobuf::Arena::CreateMessage<ReplyType>(&arena_);
+  }
+
+  DoneTag done_tag_{this};
+  // the done tag hasn't been returned yet
+  bool done_pending_ = false;
+  // the RPC finished and waits for the done tag to be released
+  bool finished_ = false;
 };
 
 template <typename RequestType, typename ReplyType>
@@ -162,19 +367,28 @@ class CallDataUnary : public CallData<RequestType, ReplyType> {
   // server) and the completion queue "cq" used for asynchronous communication
   // with the gRPC runtime.
   CallDataUnary(AsyncService* service, ::grpc::ServerCompletionQueue* cq)
-    : CallData<RequestType, ReplyType>(service, cq), responder_(&this->ctx_) {}
+    : CallData<RequestType, ReplyType>(service, cq) {
+    responder_.emplace(&*this->ctx_);
+  }
 
   void finish(const ::grpc::Status& status) override {
     // And we are done! Let the gRPC runtime know we've finished, using the
     // memory address of this instance as the uniquely identifying tag for
     // the event.
     this->status_ = this->Finish;
-    responder_.Finish(this->reply_, status, this);
+    responder_->Finish(*this->reply_, status, this);
   }
 
  protected:
+  void reset() override {
+    // the responder refers to the context so it's remade along with it
+    responder_.reset();
+    CallData<RequestType, ReplyType>::reset();
+    responder_.emplace(&*this->ctx_);
+  }
+
   // The means to get back to the client.
-  ::grpc::ServerAsyncResponseWriter<ReplyType> responder_;
+  std::optional<::grpc::ServerAsyncResponseWriter<ReplyType>> responder_;
 };
 
 template <typename RequestType, typename ReplyType>
@@ -184,7 +398,9 @@ class CallDataServerStream : public CallData<RequestType, ReplyType> {
   // server) and the completion queue "cq" used for asynchronous communication
   // with the gRPC runtime.
   CallDataServerStream(AsyncService* service, ::grpc::ServerCompletionQueue* cq)
-    : CallData<RequestType, ReplyType>(service, cq), responder_(&this->ctx_) {}
+    : CallData<RequestType, ReplyType>(service, cq) {
+    responder_.emplace(&*this->ctx_);
+  }
 
   void write(const ReplyType& response) { responder_->Write(response, this); }
 
@@ -193,12 +409,19 @@ class CallDataServerStream : public CallData<RequestType, ReplyType> {
     // memory address of this instance as the uniquely identifying tag for
     // the event.
     this->status_ = this->Finish;
-    responder_.Finish(this->reply_, status, this);
+    responder_->Finish(*this->reply_, status, this);
   }
 
  protected:
+  void reset() override {
+    // the responder refers to the context so it's remade along with it
+    responder_.reset();
+    CallData<RequestType, ReplyType>::reset();
+    responder_.emplace(&*this->ctx_);
+  }
+
   // The means to get back to the client.
-  ::grpc::ServerAsyncWriter<ReplyType> responder_;
+  std::optional<::grpc::ServerAsyncWriter<ReplyType>> responder_;
 };
 
 struct WriteData {
@@ -207,16 +430,24 @@ struct WriteData {
                   [[maybe_unused]] const Observer& observer) const {
     auto* contents = getTensorContents<T>(tensor);
     if constexpr (std::is_same_v<T, char>) {
-      // gRPC stores char as a string so contents is a string**. Copy over the
-      // actual char* data from the string
-      auto* dest = static_cast<std::byte*>(buffer->data(offset));
-      std::memcpy(dest, (*contents)->data(), size * sizeof(T));
+      // gRPC stores each element as its own string so join them into the
+      // buffer with null terminators
+      packBytes(tensor->contents().bytes_contents(), buffer->data(offset),
+                size);
     } else if constexpr (util::is_any_v<T, bool, uint32_t, uint64_t, int32_t,
                                         int64_t, float, double>) {
       auto* dest = static_cast<std::byte*>(buffer->data(offset));
       std::memcpy(dest, contents, size * sizeof(T));
-    } else if constexpr (util::is_any_v<T, uint8_t, uint16_t, int8_t, int16_t,
-                                        fp16>) {
+    } else if constexpr (util::is_any_v<T, fp16, bf16>) {
+      // 16-bit floats are sent as floats so convert the whole tensor at once
+      auto* dest = buffer->data(offset);
+      if constexpr (std::is_same_v<T, fp16>) {
+        util::convertFp32ToFp16(contents, static_cast<fp16*>(dest), size);
+      } else {
+        util::convertFp32ToBf16(contents, static_cast<bf16*>(dest), size);
+      }
+    } else if constexpr (util::is_any_v<T, uint8_t, uint16_t, int8_t,
+                                        int16_t>) {
       for (size_t i = 0; i < size; i++) {
 #ifdef AMDINFER_ENABLE_LOGGING
         if (const auto min_size = size > kNumTraceData ? kNumTraceData : size;
@@ -234,6 +465,48 @@ struct WriteData {
   }
 };
 
+/**
+ * @brief Recycles finished CallData objects of one type instead of deleting
+ * them so new RPCs don't allocate. Each completion queue is served by one
+ * thread and its RPCs finish on that thread so the free lists are per thread
+ * and need no locking.
+ *
+ * @tparam T the CallData type
+ */
+template <typename T>
+class CallDataPool {
+ public:
+  static T* get(AsyncService* service, ServerCompletionQueue* cq,
+                SharedState* state) {
+    auto& free_list = freeList();
+    if (free_list.empty()) {
+      return new T(service, cq, state);
+    }
+    auto* call_data = free_list.back().release();
+    free_list.pop_back();
+    call_data->restart();
+    return call_data;
+  }
+
+  static void put(T* call_data) {
+    auto& free_list = freeList();
+    if (free_list.size() >= kMaxFree) {
+      delete call_data;
+      return;
+    }
+    free_list.emplace_back(call_data);
+  }
+
+ private:
+  // enough to absorb a burst of concurrent RPCs of one type on a queue
+  static constexpr size_t kMaxFree = 64;
+
+  static std::vector<std::unique_ptr<T>>& freeList() {
+    thread_local std::vector<std::unique_ptr<T>> free_list;
+    return free_list;
+  }
+};
+
 #ifdef AMDINFER_ENABLE_LOGGING
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define CALLDATA_IMPL(endpoint, type)                                      \
@@ -253,11 +526,14 @@ struct WriteData {
                                                                            \
    protected:                                                              \
     void addNewCallData() override {                                       \
-      new CallData##endpoint(service_, cq_, state_);                       \
+      CallDataPool<CallData##endpoint>::get(service_, cq_, state_);        \
+    }                                                                      \
+    void release() override {                                              \
+      CallDataPool<CallData##endpoint>::put(this);                         \
     }                                                                      \
     void waitForRequest() override {                                       \
-      service_->Request##endpoint(&ctx_, &request_, &responder_, cq_, cq_, \
-                                  this);                                   \
+      service_->Request##endpoint(&*ctx_, request_, &*responder_, cq_,    \
+                                  cq_, this);                              \
     }                                                                      \
     void handleRequest() noexcept override
 #else
@@ -277,11 +553,14 @@ struct WriteData {
                                                                            \
    protected:                                                              \
     void addNewCallData() override {                                       \
-      new CallData##endpoint(service_, cq_, state_);                       \
+      CallDataPool<CallData##endpoint>::get(service_, cq_, state_);        \
+    }                                                                      \
+    void release() override {                                              \
+      CallDataPool<CallData##endpoint>::put(this);                         \
     }                                                                      \
     void waitForRequest() override {                                       \
-      service_->Request##endpoint(&ctx_, &request_, &responder_, cq_, cq_, \
-                                  this);                                   \
+      service_->Request##endpoint(&*ctx_, request_, &*responder_, cq_,    \
+                                  cq_, this);                              \
     }                                                                      \
     void handleRequest() noexcept override
 #endif
@@ -295,15 +574,51 @@ CALLDATA_IMPL(ModelInfer, Unary);
 
 public:
 const inference::ModelInferRequest& getRequest() const {
-  return this->request_;
+  return *this->request_;
 }
 
-inference::ModelInferResponse& getReply() { return this->reply_; }
+inference::ModelInferResponse& getReply() { return *this->reply_; }
+
+/// Add metadata to send to the client after the reply
+void addTrailingMetadata(std::string_view key, const std::string& value) {
+  this->ctx_->AddTrailingMetadata(std::string{key}, value);
+}
+
+/// Get the flag that's raised if the client cancels the RPC
+std::shared_ptr<const std::atomic_bool> getCancellation() const {
+  return this->cancelled_;
+}
+
+/// Compress a large reply if the client accepts compressed responses
+void compressReply() {
+  const auto& metadata = this->ctx_->client_metadata();
+  const auto found = metadata.find(kAcceptCompression);
+  if (found == metadata.end() ||
+      this->reply_->ByteSizeLong() < kMinCompressedSize) {
+    return;
+  }
+  const std::string_view name{found->second.data(), found->second.size()};
+  if (name == "gzip") {
+    this->ctx_->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  } else if (name == "deflate") {
+    this->ctx_->set_compression_algorithm(GRPC_COMPRESS_DEFLATE);
+  }
+}
+
+protected:
+// inference is worth skipping if the client is gone
+bool watchesCancellation() const override { return true; }
 CALLDATA_IMPL_END
 
+/**
+ * @brief Make an input from a proto tensor. If raw is not null, it holds the
+ * raw bytes of the input owned by the proto request. Rather than copying them,
+ * the input aliases them and they're borrowed by the pool so putting the input
+ * back works as usual. The proto request outlives the InferenceRequest.
+ */
 InferenceRequestInput getInput(
   const inference::ModelInferRequest_InferInputTensor& req,
-  const MemoryPool* pool) {
+  const MemoryPool* pool, const std::string* raw) {
   Observer observer;
   AMDINFER_IF_LOGGING(observer.logger = Logger{Loggers::Server});
 
@@ -313,17 +628,38 @@ InferenceRequestInput getInput(
   InferenceRequestInput input;
   input.setName(req.name());
 
-  std::vector<int64_t> shape_vector;
+  Shape shape_vector;
   shape_vector.reserve(req.shape_size());
   for (const auto& index : req.shape()) {
     shape_vector.push_back(static_cast<size_t>(index));
   }
-  input.setShape(shape_vector);
+  input.setShape(std::move(shape_vector));
   input.setDatatype(DataType(req.datatype().c_str()));
 
   input.setParameters(mapProtoToParameters(req.parameters()));
 
   auto size = input.getSize();
+  if (isInSharedMemory(input.getParameters())) {
+    // the data is read from the region once the request is made
+    if (raw != nullptr || req.has_contents()) {
+      throw invalid_argument("Input " + req.name() +
+                             " in shared memory cannot also have data");
+    }
+    input.setData(nullptr);
+    return input;
+  }
+  if (raw != nullptr) {
+    if (raw->size() != size * input.getDatatype().size()) {
+      throw invalid_argument("Raw input " + req.name() + " has " +
+                             std::to_string(raw->size()) + " bytes, expected " +
+                             std::to_string(size * input.getDatatype().size()));
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    input.setData(const_cast<char*>(raw->data()));
+    pool->borrow(raw->data());
+    return input;
+  }
+
   auto buffer = pool->get({MemoryAllocators::Cpu}, input, 1);
   input.setData(buffer->data(0));
   // auto* dest = static_cast<std::byte*>(input_buffer->data(offset));
@@ -334,6 +670,7 @@ InferenceRequestInput getInput(
 
   switchOverTypes(WriteData(), input.getDatatype(), buffer.get(), &req, 0, size,
                   observer);
+  countCopy(size * input.getDatatype().size());
 
   return input;
 }
@@ -347,19 +684,58 @@ InferenceRequestOutput getOutput(
   return output;
 }
 
-void setCallback(InferenceRequest* request, CallDataModelInfer* calldata) {
-  Callback callback = [calldata](const InferenceResponse& response) {
+/// Return the memory of a request's inputs if it never reached a batcher
+void releaseInputs(const InferenceRequest* request, const MemoryPool* pool) {
+  if (request == nullptr) {
+    return;
+  }
+  for (const auto& input : request->getInputs()) {
+    // inputs in shared memory have no data until they're mapped
+    if (input.getData() != nullptr) {
+      pool->put(MemoryAllocators::Cpu, input.getData());
+    }
+  }
+}
+
+/// Raw outputs are sent if the request had raw inputs or asked for them
+bool useRawOutputs(const inference::ModelInferRequest& request) {
+  if (request.raw_input_contents_size() > 0) {
+    return true;
+  }
+  const auto& parameters = request.parameters();
+  const auto found = parameters.find(kRawOutput);
+  return found != parameters.end() && found->second.bool_param();
+}
+
+void setCallback(InferenceRequest* request, CallDataModelInfer* calldata,
+                 std::shared_ptr<ServerTiming> timing,
+                 std::shared_ptr<RequestUsage> usage,
+                 const SharedState* state) {
+  Callback callback = [calldata, timing = std::move(timing),
+                       usage = std::move(usage),
+                       state](const InferenceResponse& response) {
+    if (timing != nullptr) {
+      timing->mark(ServerTiming::Responded);
+    }
+    const UsageScope encoding{usage.get(), RequestUsage::Encode};
     if (response.isError()) {
       calldata->finish(
         ::grpc::Status(StatusCode::UNKNOWN, response.getError()));
       return;
     }
     try {
-      mapResponseToProto(response, calldata->getReply());
+      mapResponseToProto(response, calldata->getReply(),
+                         useRawOutputs(calldata->getRequest()));
     } catch (const invalid_argument& e) {
       calldata->finish(::grpc::Status(StatusCode::UNKNOWN, e.what()));
       return;
     }
+    calldata->compressReply();
+    if (timing != nullptr) {
+      timing->mark(ServerTiming::Serialized);
+      calldata->addTrailingMetadata(kServerTimingHeader, timing->str());
+    }
+    calldata->addTrailingMetadata(kLoadHeader, state->formatLoad());
 
     // #ifdef AMDINFER_ENABLE_TRACING
     //   const auto &context = response.getContext();
@@ -370,6 +746,20 @@ void setCallback(InferenceRequest* request, CallDataModelInfer* calldata) {
   request->setCallback(std::move(callback));
 }
 
+/// Get the value of the metadata that identifies the client's tenant
+std::string getTenant(const ::grpc::ServerContext& context,
+                      const std::string& key) {
+  if (key.empty()) {
+    return "";
+  }
+  const auto& metadata = context.client_metadata();
+  const auto found = metadata.find(key);
+  if (found == metadata.end()) {
+    return "";
+  }
+  return {found->second.data(), found->second.size()};
+}
+
 InferenceRequestPtr getRequest(const inference::ModelInferRequest& grpc_request,
                                const MemoryPool* pool) {
   [[maybe_unused]] Observer observer;
@@ -385,9 +775,33 @@ InferenceRequestPtr getRequest(const inference::ModelInferRequest& grpc_request,
   request->setParameters(mapProtoToParameters(grpc_request.parameters()));
 
   request->setCallback(nullptr);
+  request->reserveTensors(grpc_request.inputs_size(),
+                          grpc_request.outputs_size());
 
-  for (const auto& input : grpc_request.inputs()) {
-    request->addInputTensor(getInput(input, pool));
+  // inputs in shared memory have no raw contents
+  const auto raw_inputs = grpc_request.raw_input_contents_size();
+  auto raw_index = 0;
+  try {
+    for (const auto& input : grpc_request.inputs()) {
+      const std::string* raw = nullptr;
+      const auto& parameters = input.parameters();
+      if (raw_inputs != 0 &&
+          parameters.find(kSharedMemoryRegion) == parameters.end()) {
+        if (raw_index == raw_inputs) {
+          throw invalid_argument("Not enough raw input contents for inputs");
+        }
+        raw = &grpc_request.raw_input_contents(raw_index++);
+      }
+      request->addInputTensor(getInput(input, pool, raw));
+    }
+    if (raw_index != raw_inputs) {
+      throw invalid_argument(
+        "The number of raw input contents must match the number of inputs");
+    }
+  } catch (...) {
+    // return the memory of the inputs that were already made
+    releaseInputs(request.get(), pool);
+    throw;
   }
 
   if (grpc_request.outputs_size() != 0) {
@@ -407,60 +821,50 @@ InferenceRequestPtr getRequest(const inference::ModelInferRequest& grpc_request,
 //   }
 // CALLDATA_IMPL_END
 
-void grpcUnaryCallback(CallDataModelInfer* calldata,
-                       const InferenceResponse& response) {
-  if (response.isError()) {
-    calldata->finish(::grpc::Status(StatusCode::UNKNOWN, response.getError()));
-    return;
-  }
-  try {
-    mapResponseToProto(response, calldata->getReply());
-  } catch (const invalid_argument& e) {
-    calldata->finish(::grpc::Status(StatusCode::UNKNOWN, e.what()));
-    return;
-  }
-
-  // #ifdef AMDINFER_ENABLE_TRACING
-  //   const auto &context = response.getContext();
-  //   propagate(resp.get(), context);
-  // #endif
-  calldata->finish(::grpc::Status::OK);
-}
-
 CALLDATA_IMPL(ServerLive, Unary) {
-  reply_.set_live(true);
+  reply_->set_live(true);
   finish(::grpc::Status::OK);
 }
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(ServerReady, Unary) {
-  reply_.set_ready(true);
+  reply_->set_ready(state_->serverReady());
+  this->ctx_->AddTrailingMetadata(std::string{kLoadHeader},
+                                  state_->formatLoad());
   finish(::grpc::Status::OK);
 }
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(ModelReady, Unary) {
-  const auto& model = request_.name();
-  const auto& version = request_.version();
+  const auto& model = request_->name();
+  const auto& version = request_->version();
   try {
-    reply_.set_ready(state_->modelReady(model, version));
+    reply_->set_ready(state_->modelReady(model, version));
     finish(::grpc::Status::OK);
   } catch (const invalid_argument& e) {
-    reply_.set_ready(false);
+    reply_->set_ready(false);
     finish(::grpc::Status(StatusCode::NOT_FOUND, e.what()));
   } catch (const std::exception& e) {
-    reply_.set_ready(false);
+    reply_->set_ready(false);
     finish(::grpc::Status(StatusCode::UNKNOWN, e.what()));
   }
 }
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(ModelMetadata, Unary) {
-  const auto& model = request_.name();
-  const auto& version = request_.version();
+  const auto& model = request_->name();
+  const auto& version = request_->version();
   try {
-    auto metadata = state_->modelMetadata(model, version);
-    mapModelMetadataToProto(metadata, reply_);
+    // the response is built once per published metadata and copied after
+    static MetadataCache<inference::ModelMetadataResponse> cache;
+    auto metadata = state_->publishedMetadata(model, version);
+    auto cached = cache.get(model + ":" + version, metadata,
+                            [](const ModelMetadata& data) {
+                              inference::ModelMetadataResponse response;
+                              mapModelMetadataToProto(data, response);
+                              return response;
+                            });
+    reply_->CopyFrom(*cached);
     finish(::grpc::Status::OK);
   } catch (const invalid_argument& e) {
     finish(::grpc::Status(StatusCode::NOT_FOUND, e.what()));
@@ -472,10 +876,10 @@ CALLDATA_IMPL_END
 
 CALLDATA_IMPL(ServerMetadata, Unary) {
   auto metadata = SharedState::serverMetadata();
-  reply_.set_name(metadata.name);
-  reply_.set_version(metadata.version);
+  reply_->set_name(metadata.name);
+  reply_->set_version(metadata.version);
   for (const auto& extension : metadata.extensions) {
-    reply_.add_extensions(extension);
+    reply_->add_extensions(extension);
   }
   finish(::grpc::Status::OK);
 }
@@ -484,17 +888,17 @@ CALLDATA_IMPL_END
 CALLDATA_IMPL(ModelList, Unary) {
   auto models = state_->modelList();
   for (const auto& model : models) {
-    reply_.add_models(model);
+    reply_->add_models(model);
   }
   finish(::grpc::Status::OK);
 }
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(ModelLoad, Unary) {
-  auto parameters = mapProtoToParameters(request_.parameters());
+  auto parameters = mapProtoToParameters(request_->parameters());
 
-  auto* model = request_.mutable_name();
-  const auto& version = request_.version();
+  auto* model = request_->mutable_name();
+  const auto& version = request_->version();
   util::toLower(model);
   try {
     state_->modelLoad(*model, version, parameters);
@@ -512,23 +916,44 @@ CALLDATA_IMPL(ModelLoad, Unary) {
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(ModelUnload, Unary) {
-  auto* model = request_.mutable_name();
+  auto* model = request_->mutable_name();
   util::toLower(model);
-  const std::string& version = request_.version();
+  const std::string& version = request_->version();
   state_->modelUnload(*model, version);
   finish(::grpc::Status::OK);
 }
 CALLDATA_IMPL_END
 
+CALLDATA_IMPL(ModelUpdate, Unary) {
+  auto parameters = mapProtoToParameters(request_->parameters());
+
+  auto* model = request_->mutable_name();
+  const auto& version = request_->version();
+  util::toLower(model);
+  try {
+    state_->modelUpdate(*model, version, parameters);
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::INVALID_ARGUMENT, e.what()));
+    return;
+  } catch (const std::exception& e) {
+    finish(::grpc::Status(StatusCode::UNKNOWN, e.what()));
+    return;
+  }
+
+  finish(::grpc::Status::OK);
+}
+CALLDATA_IMPL_END
+
 CALLDATA_IMPL(WorkerLoad, Unary) {
-  auto parameters = mapProtoToParameters(request_.parameters());
+  auto parameters = mapProtoToParameters(request_->parameters());
 
-  auto* model = request_.mutable_name();
+  auto* model = request_->mutable_name();
   util::toLower(model);
 
   try {
     auto endpoint = state_->workerLoad(*model, parameters);
-    reply_.set_endpoint(endpoint);
+    reply_->set_endpoint(endpoint);
     finish(::grpc::Status::OK);
   } catch (const runtime_error& e) {
     AMDINFER_LOG_ERROR(logger_, e.what());
@@ -541,7 +966,7 @@ CALLDATA_IMPL(WorkerLoad, Unary) {
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(WorkerUnload, Unary) {
-  auto* worker = request_.mutable_name();
+  auto* worker = request_->mutable_name();
   util::toLower(worker);
   state_->workerUnload(*worker);
   finish(::grpc::Status::OK);
@@ -549,53 +974,398 @@ CALLDATA_IMPL(WorkerUnload, Unary) {
 CALLDATA_IMPL_END
 
 CALLDATA_IMPL(HasHardware, Unary) {
-  auto found = SharedState::hasHardware(request_.name(), request_.num());
-  reply_.set_found(found);
+  auto found = SharedState::hasHardware(request_->name(), request_->num());
+  reply_->set_found(found);
   finish(::grpc::Status::OK);
 }
 CALLDATA_IMPL_END
 
+CALLDATA_IMPL(SystemSharedMemoryStatus, Unary) {
+  try {
+    auto* regions = reply_->mutable_regions();
+    for (const auto& status :
+         state_->getSharedMemory()->status(request_->name())) {
+      auto& region = (*regions)[status.name];
+      region.set_name(status.name);
+      region.set_key(status.key);
+      region.set_offset(status.offset);
+      region.set_byte_size(status.byte_size);
+    }
+    finish(::grpc::Status::OK);
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::NOT_FOUND, e.what()));
+  }
+}
+CALLDATA_IMPL_END
+
+CALLDATA_IMPL(SystemSharedMemoryRegister, Unary) {
+  try {
+    state_->getSharedMemory()->add(request_->name(), request_->key(),
+                                   request_->offset(), request_->byte_size());
+    finish(::grpc::Status::OK);
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::INVALID_ARGUMENT, e.what()));
+  } catch (const std::exception& e) {
+    AMDINFER_LOG_ERROR(logger_, e.what());
+    finish(::grpc::Status(StatusCode::UNKNOWN, e.what()));
+  }
+}
+CALLDATA_IMPL_END
+
+CALLDATA_IMPL(SystemSharedMemoryUnregister, Unary) {
+  try {
+    state_->getSharedMemory()->remove(request_->name());
+    finish(::grpc::Status::OK);
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::NOT_FOUND, e.what()));
+  }
+}
+CALLDATA_IMPL_END
+
+CALLDATA_IMPL(RdmaConnect, Unary) {
+  try {
+    reply_->set_endpoint(state_->getSharedMemory()->connectRdma(
+      request_->session(), request_->endpoint()));
+    finish(::grpc::Status::OK);
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::INVALID_ARGUMENT, e.what()));
+  } catch (const std::exception& e) {
+    AMDINFER_LOG_ERROR(logger_, e.what());
+    finish(::grpc::Status(StatusCode::UNAVAILABLE, e.what()));
+  }
+}
+CALLDATA_IMPL_END
+
+CALLDATA_IMPL(RdmaRegister, Unary) {
+  try {
+    state_->getSharedMemory()->addRdma(request_->name(), request_->session(),
+                                       request_->address(), request_->key(),
+                                       request_->byte_size());
+    finish(::grpc::Status::OK);
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::INVALID_ARGUMENT, e.what()));
+  } catch (const std::exception& e) {
+    AMDINFER_LOG_ERROR(logger_, e.what());
+    finish(::grpc::Status(StatusCode::UNAVAILABLE, e.what()));
+  }
+}
+CALLDATA_IMPL_END
+
+class CallDataModelStreamInfer;
+
+/// Tags one kind of event on a stream to forward it to the stream's handler
+class StreamTag final : public CallDataBase {
+ public:
+  using Handler = void (CallDataModelStreamInfer::*)(bool);
+
+  StreamTag(CallDataModelStreamInfer* stream, Handler handler)
+    : stream_(stream), handler_(handler) {}
+
+  void proceed() override;
+  bool fail() override;
+
+ private:
+  CallDataModelStreamInfer* stream_;
+  Handler handler_;
+};
+
+/**
+ * @brief Serves the bidirectional ModelStreamInfer RPC. Each request read from
+ * the stream is sent for inference right away and its response is written
+ * back when it finishes, so responses may be out of order. gRPC allows only
+ * one outstanding write so responses are queued until it's their turn. The
+ * stream finishes once the client is done writing and all responses are
+ * sent. Streaming workers take a credit for each frame they send and the
+ * credit is returned once the frame is written, so at most a window of
+ * responses waits here. The client sets the window and whether workers wait
+ * for credits or drop frames with the amdinfer-stream-credits and
+ * amdinfer-stream-policy metadata.
+ */
+class CallDataModelStreamInfer {
+ public:
+  CallDataModelStreamInfer(AsyncService* service, ServerCompletionQueue* cq,
+                           SharedState* state)
+    : service_(service), cq_(cq), state_(state), stream_(&ctx_) {
+    service_->RequestModelStreamInfer(&ctx_, &stream_, cq_, cq_,
+                                      &connect_tag_);
+  }
+
+  void onConnect(bool ok) {
+    if (!ok) {
+      // the server is shutting down
+      delete this;
+      return;
+    }
+    new CallDataModelStreamInfer(service_, cq_, state_);
+    flow_ = makeFlow();
+    read();
+  }
+
+  void onRead(bool ok) {
+    if (!ok) {
+      // the client is done sending requests
+      const std::lock_guard lock{mutex_};
+      reading_ = false;
+      finishIfDone();
+      return;
+    }
+    infer(std::move(request_));
+    read();
+  }
+
+  void onWrite(bool ok) {
+    const std::lock_guard lock{mutex_};
+    writes_.pop_front();
+    writing_ = false;
+    flow_->release();
+    if (!ok) {
+      // the client is gone so the remaining responses are dropped
+      broken_ = true;
+      writes_.clear();
+      flow_->close();
+    } else if (!writes_.empty()) {
+      write();
+    }
+    finishIfDone();
+  }
+
+  void onFinish([[maybe_unused]] bool ok) {
+    {
+      // wait for the thread that finished the stream to release the lock
+      const std::lock_guard lock{mutex_};
+    }
+    delete this;
+  }
+
+ private:
+  /// Make the stream's flow control from the client's metadata
+  std::shared_ptr<StreamFlow> makeFlow() const {
+    const auto& metadata = ctx_.client_metadata();
+    auto credits = kDefaultStreamCredits;
+    if (auto found = metadata.find(std::string{kStreamCreditsKey});
+        found != metadata.end()) {
+      const auto& value = found->second;
+      if (size_t parsed = 0;
+          std::from_chars(value.data(), value.data() + value.size(), parsed)
+              .ec == std::errc{} &&
+          parsed > 0) {
+        credits = parsed;
+      }
+    }
+    auto policy = StreamFlowPolicy::Block;
+    if (auto found = metadata.find(std::string{kStreamPolicyKey});
+        found != metadata.end()) {
+      policy =
+        parseStreamFlowPolicy({found->second.data(), found->second.size()})
+          .value_or(policy);
+    }
+    return std::make_shared<StreamFlow>(credits, policy);
+  }
+
+  void read() {
+    request_ = std::make_shared<inference::ModelInferRequest>();
+    stream_.Read(request_.get(), &read_tag_);
+  }
+
+  void infer(std::shared_ptr<inference::ModelInferRequest> proto) {
+    {
+      const std::lock_guard lock{mutex_};
+      pending_++;
+    }
+
+    InferenceRequestPtr request;
+    try {
+      auto tenant = getTenant(ctx_, state_->getTenantKey());
+      auto server_ticket = state_->admit(tenant);
+      auto ticket = state_->modelAdmit(
+        proto->model_name(), proto->model_version(), proto->ByteSizeLong());
+      const UsageMeter decoding{state_->accountsUsage()};
+      request = amdinfer::getRequest(*proto, state_->getPool());
+      auto shared_memory =
+        state_->getSharedMemory()->map(request.get(), state_->getPool());
+      auto usage = startRequestUsage(request.get(), decoding,
+                                     proto->model_name(), std::move(tenant));
+      // the proto is kept alive with the request since raw inputs alias it
+      request->setCallback(
+        [this, proto, usage](const InferenceResponse& response) {
+          const UsageScope encoding{usage.get(), RequestUsage::Encode};
+          respond(*proto, response);
+        });
+      request->setExecutor(cq_executor);
+      request->setStreamFlow(flow_);
+      holdSharedMemory(request.get(), std::move(shared_memory));
+      holdTicket(request.get(), std::move(ticket));
+      holdTicket(request.get(), std::move(server_ticket));
+      auto request_container = makeRequestContainer();
+      request_container->request = request;
+      request_container->deadline = ctx_.deadline();
+      state_->modelInfer(proto->model_name(), std::move(request_container),
+                         proto->model_version());
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger_, e.what());
+      releaseInputs(request.get(), state_->getPool());
+      respond(*proto, InferenceResponse{e.what()});
+    }
+  }
+
+  void respond(const inference::ModelInferRequest& request,
+               const InferenceResponse& response) {
+    inference::ModelStreamInferResponse reply;
+    if (response.isError()) {
+      reply.set_error_message(response.getError());
+    } else {
+      try {
+        mapResponseToProto(response, *reply.mutable_infer_response(),
+                           useRawOutputs(request));
+      } catch (const invalid_argument& e) {
+        reply.Clear();
+        reply.set_error_message(e.what());
+      }
+    }
+    // the ID is how clients match responses to requests
+    reply.mutable_infer_response()->set_id(request.id());
+
+    const std::lock_guard lock{mutex_};
+    // partial responses from sequence workers are followed by a final one
+    if (response.isFinal()) {
+      pending_--;
+    }
+    if (!broken_) {
+      flow_->queue();
+      writes_.push_back(std::move(reply));
+      if (!writing_) {
+        write();
+      }
+    }
+    finishIfDone();
+  }
+
+  /// Write the next queued response. The lock must be held
+  void write() {
+    writing_ = true;
+    stream_.Write(writes_.front(), &write_tag_);
+  }
+
+  /// Finish the stream if there's nothing left to do. The lock must be held
+  void finishIfDone() {
+    if (!reading_ && !writing_ && pending_ == 0 && !finishing_) {
+      finishing_ = true;
+      stream_.Finish(::grpc::Status::OK, &finish_tag_);
+    }
+  }
+
+  AsyncService* service_;
+  ServerCompletionQueue* cq_;
+  SharedState* state_;
+  ::grpc::ServerContext ctx_;
+  ::grpc::ServerAsyncReaderWriter<inference::ModelStreamInferResponse,
+                                  inference::ModelInferRequest>
+    stream_;
+  AMDINFER_IF_LOGGING(Logger logger_{Loggers::Server};)
+
+  StreamTag connect_tag_{this, &CallDataModelStreamInfer::onConnect};
+  StreamTag read_tag_{this, &CallDataModelStreamInfer::onRead};
+  StreamTag write_tag_{this, &CallDataModelStreamInfer::onWrite};
+  StreamTag finish_tag_{this, &CallDataModelStreamInfer::onFinish};
+
+  // the request being read from the stream
+  std::shared_ptr<inference::ModelInferRequest> request_;
+  std::shared_ptr<StreamFlow> flow_;
+
+  std::mutex mutex_;
+  std::deque<inference::ModelStreamInferResponse> writes_;
+  bool reading_ = true;
+  bool writing_ = false;
+  bool broken_ = false;
+  bool finishing_ = false;
+  size_t pending_ = 0;
+};
+
+void StreamTag::proceed() { (stream_->*handler_)(true); }
+
+bool StreamTag::fail() {
+  (stream_->*handler_)(false);
+  return true;
+}
+
 void CallDataModelInfer::handleRequest() noexcept {
-  const auto& model = request_.model_name();
-  const auto& version = request_.model_version();
+  const auto& model = request_->model_name();
+  const auto& version = request_->model_version();
 #ifdef AMDINFER_ENABLE_TRACING
   auto trace = startTrace(&(__func__[0]));
-  trace->setAttribute("model", model);
-  trace->startSpan("request_handler");
+  if (trace != nullptr) {
+    trace->setAttribute("model", model);
+    trace->startSpan("request_handler");
+  }
 #endif
 
+  const auto received = util::now();
+  InferenceRequestPtr request;
   try {
-    auto request = amdinfer::getRequest(request_, state_->getPool());
-    setCallback(request.get(), this);
-    auto request_container = std::make_unique<RequestContainer>();
+    // refuse the request before its buffers are allocated if the server or its
+    // endpoint has no room for it
+    auto tenant = getTenant(*ctx_, state_->getTenantKey());
+    auto server_ticket = state_->admit(tenant);
+    auto ticket = state_->modelAdmit(model, version, request_->ByteSizeLong());
+    const UsageMeter decoding{state_->accountsUsage()};
+    request = amdinfer::getRequest(*request_, state_->getPool());
+    auto shared_memory =
+      state_->getSharedMemory()->map(request.get(), state_->getPool());
+    setCallback(request.get(), this, startServerTiming(request.get(), received),
+                startRequestUsage(request.get(), decoding, model,
+                                  std::move(tenant)),
+                state_);
+    request->setExecutor(cq_executor);
+    request->setCancellation(getCancellation());
+    // outputs in shared memory are written before the reply is made
+    holdSharedMemory(request.get(), std::move(shared_memory));
+    holdTicket(request.get(), std::move(ticket));
+    holdTicket(request.get(), std::move(server_ticket));
+    auto request_container = makeRequestContainer();
     request_container->request = request;
+    // requests without a deadline have the maximum time point set
+    request_container->deadline = ctx_->deadline();
 #ifdef AMDINFER_ENABLE_TRACING
-    trace->endSpan();
+    if (trace != nullptr) {
+      trace->endSpan();
+    }
     request_container->trace = std::move(trace);
 #endif
     state_->modelInfer(model, std::move(request_container), version);
+  } catch (const resource_exhausted_error& e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    finish(::grpc::Status(StatusCode::RESOURCE_EXHAUSTED, e.what()));
   } catch (const invalid_argument& e) {
     AMDINFER_LOG_INFO(logger_, e.what());
+    releaseInputs(request.get(), state_->getPool());
     finish(::grpc::Status(StatusCode::NOT_FOUND, e.what()));
   } catch (const std::exception& e) {
     AMDINFER_LOG_ERROR(logger_, e.what());
+    releaseInputs(request.get(), state_->getPool());
     finish(::grpc::Status(StatusCode::UNKNOWN, e.what()));
   }
 }
 
 class GrpcServer final {
  public:
-  /// Get the singleton GrpcServer instance
-  static GrpcServer& getInstance() { return create("", -1, nullptr); }
-
   // using this singleton approach here because the start() method is state-
   // independent. The HTTP server is already global like this
-  static GrpcServer& create(const std::string& address, const int cq_count,
-                            SharedState* state) {
-    static GrpcServer server(address, cq_count, state);
-    return server;
+  static void create(const std::vector<std::string>& addresses,
+                     const int cq_count, SharedState* state) {
+    auto& server = getInstance();
+    if (server == nullptr) {
+      server.reset(new GrpcServer(addresses, cq_count, state));
+    }
   }
 
+  /// Shut down the running server, if any, so it can be started again
+  static void destroy() { getInstance().reset(); }
+
   GrpcServer(GrpcServer const&) = delete;  ///< Copy constructor
   GrpcServer& operator=(const GrpcServer&) =
     delete;                                 ///< Copy assignment constructor
@@ -605,6 +1375,9 @@ class GrpcServer final {
 
   ~GrpcServer() {
     server_->Shutdown();
+    for (const auto& executor : executors_) {
+      executor->close();
+    }
     // Always shutdown the completion queues after the server.
     for (const auto& cq : cq_) {
       cq->Shutdown();
@@ -622,13 +1395,26 @@ class GrpcServer final {
   }
 
  private:
-  GrpcServer(const std::string& address, const int cq_count, SharedState* state)
+  static std::unique_ptr<GrpcServer>& getInstance() {
+    static std::unique_ptr<GrpcServer> server;
+    return server;
+  }
+
+  GrpcServer(const std::vector<std::string>& addresses, const int cq_count,
+             SharedState* state)
     : state_(state) {
     ServerBuilder builder;
     builder.SetMaxReceiveMessageSize(kMaxGrpcMessageSize);
     builder.SetMaxSendMessageSize(kMaxGrpcMessageSize);
-    // Listen on the given address without any authentication mechanism.
-    builder.AddListeningPort(address, ::grpc::InsecureServerCredentials());
+    // shards of a server share the port and the kernel spreads connections
+    // over them
+    if (state->getShardIndex() >= 0) {
+      builder.AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 1);
+    }
+    // Listen on the given addresses without any authentication mechanism.
+    for (const auto& address : addresses) {
+      builder.AddListeningPort(address, ::grpc::InsecureServerCredentials());
+    }
     // Register "service_" as the instance through which we'll communicate
     // with clients. In this case it corresponds to an *asynchronous* service.
     builder.RegisterService(&service_);
@@ -636,19 +1422,24 @@ class GrpcServer final {
     // communication with the gRPC runtime.
     for (auto i = 0; i < cq_count; i++) {
       cq_.push_back(builder.AddCompletionQueue());
+      executors_.push_back(std::make_shared<CqExecutor>(cq_.back().get()));
     }
     // Finally assemble the server.
     server_ = builder.BuildAndStart();
 
-    // Start threads to handle incoming RPCs
+    // Start threads to handle incoming RPCs. They're spread over the NUMA
+    // nodes so requests are parsed into memory local to their node's arena
+    const auto nodes = util::getNumaNodes();
     for (auto i = 0; i < cq_count; i++) {
-      threads_.emplace_back(&GrpcServer::handleRpcs, this, i);
+      auto& thread = threads_.emplace_back(&GrpcServer::handleRpcs, this, i);
+      util::bindThreadToNumaNode(thread, nodes.at(i % nodes.size()));
     }
   }
 
   // This can be run in multiple threads if needed.
   void handleRpcs(int index) {
     const auto& my_cq = cq_.at(index);
+    cq_executor = executors_.at(index);
 
     // Spawn a new CallData instance to serve new clients.
     new CallDataServerLive(&service_, my_cq.get(), state_);
@@ -659,11 +1450,17 @@ class GrpcServer final {
     new CallDataModelReady(&service_, my_cq.get(), state_);
     new CallDataModelLoad(&service_, my_cq.get(), state_);
     new CallDataModelUnload(&service_, my_cq.get(), state_);
+    new CallDataModelUpdate(&service_, my_cq.get(), state_);
     new CallDataWorkerLoad(&service_, my_cq.get(), state_);
     new CallDataWorkerUnload(&service_, my_cq.get(), state_);
     new CallDataModelInfer(&service_, my_cq.get(), state_);
     new CallDataHasHardware(&service_, my_cq.get(), state_);
-    // new CallDataStreamModelInfer(&service_, my_cq.get());
+    new CallDataSystemSharedMemoryStatus(&service_, my_cq.get(), state_);
+    new CallDataSystemSharedMemoryRegister(&service_, my_cq.get(), state_);
+    new CallDataSystemSharedMemoryUnregister(&service_, my_cq.get(), state_);
+    new CallDataRdmaConnect(&service_, my_cq.get(), state_);
+    new CallDataRdmaRegister(&service_, my_cq.get(), state_);
+    new CallDataModelStreamInfer(&service_, my_cq.get(), state_);
     void* tag = nullptr;  // uniquely identifies a request.
     bool ok = false;
     while (true) {
@@ -678,31 +1475,47 @@ class GrpcServer final {
       // The return value of Next should always be checked. This return value
       // tells us whether there is any kind of event or cq_ is shutting down.
       auto event_received = my_cq->Next(&tag, &ok);
-      if (GPR_UNLIKELY(!(ok && event_received))) {
+      if (GPR_UNLIKELY(!event_received)) {
         break;
       }
-      static_cast<CallDataBase*>(tag)->proceed();
+      auto* call_data = static_cast<CallDataBase*>(tag);
+      if (GPR_UNLIKELY(!ok)) {
+        // streams see failed events in normal use e.g. when a client is done
+        if (call_data->fail()) {
+          continue;
+        }
+        break;
+      }
+      call_data->proceed();
     }
   }
 
   std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> cq_;
   inference::GRPCInferenceService::AsyncService service_;
   std::unique_ptr<::grpc::Server> server_;
+  std::vector<std::shared_ptr<CqExecutor>> executors_;
   std::vector<std::thread> threads_;
   SharedState* state_;
 };
 
 namespace grpc {
 
-void start(SharedState* state, int port) {
-  const std::string address = "0.0.0.0:" + std::to_string(port);
-  GrpcServer::create(address, 1, state);
+void start(SharedState* state, int port, const std::string& socket) {
+  std::vector<std::string> addresses{"0.0.0.0:" + std::to_string(port)};
+  // local clients skip the TCP stack on a Unix domain socket. gRPC removes a
+  // stale socket file left by an earlier server before binding so only the
+  // first shard of a sharded server listens on it
+  if (!socket.empty() && state->getShardIndex() <= 0) {
+    addresses.push_back("unix:" + socket);
+  }
+  // one completion queue and thread per NUMA node
+  const auto cq_count = static_cast<int>(util::getNumaNodes().size());
+  GrpcServer::create(addresses, cq_count, state);
 }
 
 void stop() {
-  // the GrpcServer's destructor is called automatically
-  // auto& foo = GrpcServer::getInstance();
-  // foo.~GrpcServer();
+  // shutting down the server also removes its Unix domain socket file
+  GrpcServer::destroy();
 }
 
 }  // namespace grpc
@@ -21,6 +21,8 @@
 #ifndef GUARD_AMDINFER_SERVERS_GRPC_SERVER
 #define GUARD_AMDINFER_SERVERS_GRPC_SERVER
 
+#include <string>  // for string
+
 #include "amdinfer/build_options.hpp"
 
 #ifdef AMDINFER_ENABLE_GRPC
@@ -31,7 +33,15 @@ class SharedState;
 
 namespace amdinfer::grpc {
 
-void start(SharedState* state, int port);
+/**
+ * @brief Start the gRPC server
+ *
+ * @param state the server's state
+ * @param port TCP port to listen on
+ * @param socket path of a Unix domain socket to listen on as well. Empty for
+ * none
+ */
+void start(SharedState* state, int port, const std::string& socket);
 void stop();
 
 }  // namespace amdinfer::grpc
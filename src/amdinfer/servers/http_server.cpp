@@ -22,32 +22,61 @@
 
 #include <drogon/HttpAppFramework.h>  // for HttpAppFramework, app
 #include <drogon/HttpRequest.h>       // for HttpRequestPtr, Htt...
+#include <json/reader.h>              // for CharReader, CharReaderBuilder
 #include <json/value.h>               // for Value, arrayValue
+#include <json/writer.h>              // for StreamWriterBuilder
+#include <trantor/net/EventLoop.h>    // for EventLoop
 #include <trantor/utils/Logger.h>     // for Logger, Logger::Warn
 
+#include <algorithm>      // for clamp
+#include <array>          // for array
 #include <chrono>         // for high_resolution_clock
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uintptr_t
+#include <cstdio>         // for snprintf
+#include <cstring>        // for memcpy
+#include <exception>      // for exception
+#include <fstream>        // for ifstream
+#include <functional>     // for function
+#include <iterator>       // for istreambuf_iterator
 #include <memory>         // for shared_ptr, __share...
+#include <mutex>          // for mutex, lock_guard
 #include <string>         // for allocator, operator+
+#include <string_view>    // for string_view
 #include <unordered_set>  // for unordered_set
 #include <utility>        // for move
 #include <vector>         // for vector
 
-#include "amdinfer/buffers/buffer.hpp"            // for BufferPtr
-#include "amdinfer/build_options.hpp"             // for AMDINFER_ENABLE_TRACING
-#include "amdinfer/clients/http_internal.hpp"     // for propagate, errorHtt...
-#include "amdinfer/core/exceptions.hpp"           // for runtime_error, inva...
-#include "amdinfer/core/inference_request.hpp"    // for InferenceRequest
-#include "amdinfer/core/inference_response.hpp"   // for InferenceResponse
-#include "amdinfer/core/parameters.hpp"           // for ParameterMap
-#include "amdinfer/core/request_container.hpp"    // for ParameterMap
-#include "amdinfer/core/shared_state.hpp"         // for SharedState
-#include "amdinfer/observation/logging.hpp"       // for Logger, AMDINFER_LOG...
-#include "amdinfer/observation/metrics.hpp"       // for Metrics, MetricCoun...
-#include "amdinfer/observation/tracing.hpp"       // for startTrace, Trace
-#include "amdinfer/servers/websocket_server.hpp"  // for WebsocketServer
-#include "amdinfer/util/compression.hpp"          // for zDecompress
-#include "amdinfer/util/containers.hpp"           // for containerProduct
-#include "amdinfer/util/string.hpp"               // for toLower
+#include "amdinfer/buffers/buffer.hpp"              // for BufferPtr
+#include "amdinfer/build_options.hpp"               // for AMDINFER_ENABLE_TR...
+#include "amdinfer/clients/http_internal.hpp"       // for propagate, errorHt...
+#include "amdinfer/core/admission.hpp"              // for holdTicket
+#include "amdinfer/core/bulk_job.hpp"               // for BulkJobs, BulkJob...
+#include "amdinfer/core/completion_router.hpp"      // for CompletionExecutor
+#include "amdinfer/core/exceptions.hpp"             // for runtime_error, inv...
+#include "amdinfer/core/memory_pool/pool.hpp"       // for MemoryPool
+#include "amdinfer/core/inference_request.hpp"      // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"     // for InferenceResponse
+#include "amdinfer/core/metadata_cache.hpp"         // for MetadataCache
+#include "amdinfer/core/parameters.hpp"             // for ParameterMap
+#include "amdinfer/core/request_container.hpp"      // for ParameterMap
+#include "amdinfer/core/request_usage.hpp"          // for RequestUsage
+#include "amdinfer/core/server_timing.hpp"          // for ServerTiming
+#include "amdinfer/core/shared_memory_regions.hpp"  // for holdSharedMemory
+#include "amdinfer/core/shared_state.hpp"           // for SharedState
+#include "amdinfer/observation/logging.hpp"         // for Logger, AMDINFER_L...
+#include "amdinfer/observation/metrics.hpp"         // for Metrics, MetricCou...
+#include "amdinfer/observation/profiling.hpp"       // for startProfiling, st...
+#include "amdinfer/observation/tracing.hpp"         // for startTrace, Trace
+#include "amdinfer/servers/json_request.hpp"        // for parseJsonRequests
+#include "amdinfer/servers/json_response.hpp"       // for serializeJsonResponse
+#include "amdinfer/servers/supervisor.hpp"          // for getMergedMetricsPath
+#include "amdinfer/servers/websocket_server.hpp"    // for WebsocketServer
+#include "amdinfer/util/compression.hpp"            // for decompress, compress
+#include "amdinfer/util/containers.hpp"             // for containerProduct
+#include "amdinfer/util/numa.hpp"                   // for bindThreadToCpus
+#include "amdinfer/util/string.hpp"                 // for toLower
+#include "amdinfer/util/timestamps.hpp"             // for now
 
 using drogon::HttpRequestPtr;
 using drogon::HttpResponse;
@@ -56,10 +85,133 @@ using drogon::HttpStatusCode;
 
 namespace amdinfer {
 
+namespace {
+
+// smaller responses aren't worth compressing
+constexpr size_t kMinCompressedSize = 1024;
+
+// profiles last this long if the request doesn't say
+constexpr auto kDefaultProfileDuration = std::chrono::seconds(5);
+// longer profiles would mostly be lost as the threads' ring buffers wrap
+constexpr auto kMaxProfileDuration = std::chrono::seconds(60);
+
+/**
+ * @brief Parse the duration of a profile, which is a number of seconds or
+ * milliseconds with an optional "s" or "ms" suffix
+ *
+ * @param duration the duration
+ * @return std::chrono::milliseconds
+ */
+std::chrono::milliseconds parseProfileDuration(const std::string &duration) {
+  if (duration.empty()) {
+    return kDefaultProfileDuration;
+  }
+
+  size_t end = 0;
+  double value = 0;
+  try {
+    value = std::stod(duration, &end);
+  } catch (const std::exception &) {
+    end = 0;
+  }
+  const auto unit = duration.substr(end);
+  const auto valid_unit = unit.empty() || unit == "s" || unit == "ms";
+  if (end == 0 || value <= 0 || !valid_unit) {
+    throw invalid_argument("Invalid profile duration: " + duration);
+  }
+
+  const auto milliseconds = unit == "ms" ? value : value * std::milli::den;
+  const auto max_milliseconds =
+    std::chrono::duration<double, std::milli>(kMaxProfileDuration).count();
+  if (milliseconds > max_milliseconds) {
+    throw invalid_argument("Profiles can last at most " +
+                           std::to_string(kMaxProfileDuration.count()) + "s");
+  }
+  return std::chrono::milliseconds(static_cast<int64_t>(milliseconds));
+}
+
+/**
+ * @brief Compress the body of a response with the best encoding that the
+ * client accepts in its Accept-Encoding header
+ *
+ * @param req the request
+ * @param resp the response
+ */
+void compressResponse(const drogon::HttpRequest &req,
+                      drogon::HttpResponse *resp) {
+  const auto &body = resp->body();
+  if (body.size() < kMinCompressedSize ||
+      !resp->getHeader("content-encoding").empty()) {
+    return;
+  }
+  const auto encoding =
+    util::negotiateEncoding(req.getHeader("accept-encoding"));
+  if (encoding == util::Encoding::Identity) {
+    return;
+  }
+  auto compressed = util::compress(encoding, body.data(), body.size());
+  if (compressed.size() >= body.size()) {
+    return;
+  }
+  resp->setBody(std::move(compressed));
+  resp->addHeader("Content-Encoding", std::string{util::toString(encoding)});
+  resp->addHeader("Vary", "Accept-Encoding");
+}
+
+int getDefaultThreads(const std::vector<int> &cpus) {
+  // CPUs set aside for I/O get a thread each. Otherwise, the I/O threads share
+  // the CPUs with the workers so they get a fraction of them
+  if (!cpus.empty()) {
+    return static_cast<int>(cpus.size());
+  }
+  const int cpus_per_thread = 4;
+  const auto available = static_cast<int>(util::getThreadCpus().size());
+  return std::clamp(available / cpus_per_thread, 1, kDefaultDrogonThreads);
+}
+
+/// Runs completions on one of Drogon's I/O loops
+class LoopExecutor : public CompletionExecutor {
+ public:
+  explicit LoopExecutor(trantor::EventLoop *loop) : loop_(loop) {}
+
+  void post(std::vector<Completion> completions) override {
+    // the loop only takes copyable functions
+    auto shared =
+      std::make_shared<std::vector<Completion>>(std::move(completions));
+    loop_->queueInLoop([shared]() { runCompletions(shared.get()); });
+  }
+
+ private:
+  trantor::EventLoop *loop_;
+};
+
+/// Get the executor of the calling thread's I/O loop or null if it has none
+std::shared_ptr<CompletionExecutor> getLoopExecutor() {
+  thread_local std::shared_ptr<CompletionExecutor> executor;
+  if (executor == nullptr) {
+    auto *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (loop != nullptr) {
+      executor = std::make_shared<LoopExecutor>(loop);
+    }
+  }
+  return executor;
+}
+
+}  // namespace
+
 namespace http {
 
-void start(SharedState *state, uint16_t port) {
-  auto controller = std::make_shared<HttpServer>(state);
+void start(SharedState *state, uint16_t port, int threads,
+           const std::vector<int> &cpus, int decode_threads) {
+  if (threads <= 0) {
+    threads = getDefaultThreads(cpus);
+  }
+  // drogon's I/O threads are started by run() so they inherit the set
+  if (!cpus.empty()) {
+    util::bindThreadToCpus(cpus);
+  }
+
+  auto controller = std::make_shared<HttpServer>(state, decode_threads, cpus);
   auto ws_controller = std::make_shared<WebsocketServer>(state);
 
   auto &app = drogon::app();
@@ -72,12 +224,18 @@ void start(SharedState *state, uint16_t port) {
   app.setLogLevel(trantor::Logger::kFatal).setLogPath(".");
 #endif
 
+  // shards of a server share the port and the kernel spreads connections
+  // over them
+  if (state->getShardIndex() >= 0) {
+    app.enableReusePort();
+  }
+
   app.addListener("0.0.0.0", port)
-    .setThreadNum(kDefaultDrogonThreads)
+    .setThreadNum(static_cast<size_t>(threads))
     .registerPostHandlingAdvice([](const drogon::HttpRequestPtr &req,
                                    const drogon::HttpResponsePtr &resp) {
-      (void)req;  // suppress unused variable warning
       resp->addHeader("Access-Control-Allow-Origin", "*");
+      compressResponse(*req, resp.get());
     })
     .setClientMaxBodySize(kMaxClientBodySize)
     .disableSigtermHandling()
@@ -89,69 +247,64 @@ void stop() { drogon::app().quit(); }
 
 }  // namespace http
 
-std::shared_ptr<Json::Value> parseJson(const drogon::HttpRequest *req) {
-#ifdef AMDINFER_ENABLE_LOGGING
-  Logger logger{Loggers::Server};
-#endif
-
-  // attempt to get the JSON object directly first
-  const auto &json_obj = req->getJsonObject();
-  if (json_obj != nullptr) {
-    return json_obj;
+/**
+ * @brief Get the body of a request, decompressed according to its
+ * Content-Encoding header. Bodies without the header that start like a
+ * supported compressed format are also decompressed for older clients.
+ *
+ * @param req the request
+ * @param storage holds the decompressed body, if any
+ * @return std::string_view the body
+ */
+std::string_view decodeBody(const drogon::HttpRequest *req,
+                            std::string *storage) {
+  std::string_view body = req->body();
+  auto encoding = util::parseEncoding(req->getHeader("content-encoding"));
+  if (encoding == util::Encoding::Identity) {
+    encoding = util::sniffEncoding(body.data(), body.size());
+    if (encoding == util::Encoding::Identity) {
+      return body;
+    }
   }
+  *storage =
+    util::decompress(encoding, body.data(), body.size(), kMaxClientBodySize);
+  return *storage;
+}
 
-  AMDINFER_LOG_DEBUG(logger, "Failed to get JSON data directly");
+std::shared_ptr<Json::Value> parseJson(const drogon::HttpRequest *req) {
+  std::string storage;
+  const auto body = decodeBody(req, &storage);
+
+  // an uncompressed body may have been parsed already
+  if (storage.empty()) {
+    const auto &json_obj = req->getJsonObject();
+    if (json_obj != nullptr) {
+      return json_obj;
+    }
+  }
 
-  // if it's not valid, then we need to attempt to parse the body
   auto root = std::make_shared<Json::Value>();
-
   std::string errors;
   Json::CharReaderBuilder builder;
-  Json::CharReader *reader = builder.newCharReader();
-  auto body = req->getBody();
-  bool success =
-    reader->parse(body.data(), body.data() + body.size(), root.get(), &errors);
-  if (success) {
-    return root;
-  }
-
-  AMDINFER_LOG_DEBUG(logger, "Failed to interpret body as JSON data");
-
-  // if it's still not valid, attempt to uncompress the body and convert to JSON
-  auto body_decompress = util::zDecompress(body.data(), body.length());
-  success = reader->parse(body_decompress.data(),
-                          body_decompress.data() + body_decompress.size(),
-                          root.get(), &errors);
-  if (success) {
+  std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+  if (reader->parse(body.data(), body.data() + body.size(), root.get(),
+                    &errors)) {
     return root;
   }
 
   throw invalid_argument("Failed to interpret request body as JSON");
 }
 
-Json::Value parseResponse(InferenceResponse response) {
-  Json::Value ret;
-  ret["model_name"] = response.getModel();
-  ret["outputs"] = Json::arrayValue;
-  ret["id"] = response.getID();
-  auto outputs = response.getOutputs();
-  for (const InferenceResponseOutput &output : outputs) {
-    Json::Value json_output;
-    json_output["name"] = output.getName();
-    json_output["parameters"] = Json::objectValue;
-    json_output["data"] = Json::arrayValue;
-    json_output["shape"] = Json::arrayValue;
-    json_output["datatype"] = output.getDatatype().str();
-    const auto &shape = output.getShape();
-    for (const auto &index : shape) {
-      json_output["shape"].append(static_cast<Json::UInt>(index));
+BinaryOutputs getBinaryOutputs(const InferenceRequest &request) {
+  BinaryOutputs binary_outputs;
+  binary_outputs.all =
+    isParameterTrue(request.getParameters(), kBinaryDataOutput);
+  for (const auto &output : request.getOutputs()) {
+    if (isParameterTrue(output.getParameters(), kBinaryData)) {
+      binary_outputs.names.insert(output.getName());
     }
-
-    switchOverTypes(SetInputData(), output.getDatatype(),
-                    &(json_output["data"]), output.getData(), output.getSize());
-    ret["outputs"].append(json_output);
   }
-  return ret;
+  return binary_outputs;
 }
 
 struct WriteData {
@@ -175,10 +328,30 @@ drogon::HttpResponsePtr errorHttpResponse(const std::string &error,
   return resp;
 }
 
-HttpServer::HttpServer(SharedState *state) : state_(state) {
+HttpServer::HttpServer(SharedState *state, int decode_threads,
+                       const std::vector<int> &cpus)
+  : state_(state) {
+  if (decode_threads > 0) {
+    decoders_ = std::make_unique<util::ThreadPool>(decode_threads, cpus);
+  }
   AMDINFER_LOG_DEBUG(logger_, "Constructed HttpServer");
 }
 
+void HttpServer::decode(std::function<void()> task) const {
+  if (decoders_ == nullptr) {
+    task();
+    return;
+  }
+  decoders_->push([this, task = std::move(task)](int) {
+    // the task's future is dropped so its errors are logged here
+    try {
+      task();
+    } catch (const std::exception &e) {
+      AMDINFER_LOG_ERROR(logger_, e.what());
+    }
+  });
+}
+
 #ifdef AMDINFER_ENABLE_HTTP
 
 void HttpServer::getServerLive(const HttpRequestPtr &req,
@@ -197,8 +370,9 @@ void HttpServer::getServerLive(const HttpRequestPtr &req,
 
   auto resp = HttpResponse::newHttpResponse();
 #ifdef AMDINFER_ENABLE_TRACING
-  auto context = trace->propagate();
-  propagate(resp.get(), context);
+  if (trace != nullptr) {
+    propagate(resp.get(), trace->propagate());
+  }
 #endif
   callback(resp);
 }
@@ -211,10 +385,13 @@ void HttpServer::getServerReady(const HttpRequestPtr &req,
 #endif
   (void)req;  // suppress unused variable warning
 
-  // for now, assuming that server is always ready (assumes that user has loaded
-  // all the required models).
-
+  // the server is ready unless it's saturated with overload readiness. It
+  // doesn't know which models the user needs loaded
   auto resp = HttpResponse::newHttpResponse();
+  if (!state_->serverReady()) {
+    resp->setStatusCode(HttpStatusCode::k503ServiceUnavailable);
+  }
+  resp->addHeader(std::string{kLoadHeader}, state_->formatLoad());
   callback(resp);
 }
 
@@ -278,18 +455,26 @@ void getModelMetadata(DrogonCallback &&callback, SharedState *state,
   Metrics::getInstance().incrementCounter(MetricCounterIDs::RestGet);
 #endif
 
-  Json::Value ret;
-  bool error = false;
+  // the body is serialized once per published metadata and reused after
+  static MetadataCache<std::string> cache;
+
+  HttpResponsePtr resp;
   try {
-    auto metadata = state->modelMetadata(endpoint, version);
-    ret = modelMetadataToJson(metadata);
+    auto metadata = state->publishedMetadata(endpoint, version);
+    auto body = cache.get(endpoint + ":" + version, metadata,
+                          [](const ModelMetadata &data) {
+                            Json::StreamWriterBuilder builder;
+                            builder["indentation"] = "";
+                            return Json::writeString(
+                              builder, modelMetadataToJson(data));
+                          });
+    resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+    resp->setBody(*body);
   } catch (const runtime_error &e) {
+    Json::Value ret;
     ret["error"] = e.what();
-    error = true;
-  }
-
-  auto resp = HttpResponse::newHttpJsonResponse(ret);
-  if (error) {
+    resp = HttpResponse::newHttpJsonResponse(ret);
     resp->setStatusCode(HttpStatusCode::k400BadRequest);
   }
   callback(resp);
@@ -348,8 +533,8 @@ void HttpServer::hasHardware(const HttpRequestPtr &req,
   callback(resp);
 }
 
-InferenceRequestInput getInput(const Json::Value &json,
-                               const MemoryPool *pool) {
+InferenceRequestInput getInput(const Json::Value &json, const MemoryPool *pool,
+                               std::string_view *binary) {
   InferenceRequestInput input;
 
   input.setData(nullptr);
@@ -362,7 +547,7 @@ InferenceRequestInput getInput(const Json::Value &json,
     throw invalid_argument("No 'shape' key present in request input");
   }
   auto shape = json.get("shape", Json::arrayValue);
-  std::vector<int64_t> shape_vector;
+  Shape shape_vector;
   shape_vector.reserve(shape.size());
   for (auto const &i : shape) {
     if (!i.isUInt64()) {
@@ -370,7 +555,7 @@ InferenceRequestInput getInput(const Json::Value &json,
     }
     shape_vector.push_back(i.asUInt64());
   }
-  input.setShape(shape_vector);
+  input.setShape(std::move(shape_vector));
 
   if (!json.isMember("datatype")) {
     throw invalid_argument("No 'datatype' key present in request input");
@@ -384,6 +569,25 @@ InferenceRequestInput getInput(const Json::Value &json,
   }
 
   auto buffer = pool->get({MemoryAllocators::Cpu}, input, 1);
+  const auto &json_parameters = json["parameters"];
+  if (json_parameters.isMember(kBinaryDataSize)) {
+    // the raw bytes for this input follow the JSON header in the body so copy
+    // them directly into the buffer
+    const auto size = json_parameters[kBinaryDataSize].asUInt64();
+    if (size != input.getSize() * input.getDatatype().size()) {
+      throw invalid_argument("'binary_data_size' of input " + input.getName() +
+                             " does not match its shape and datatype");
+    }
+    if (size > binary->size()) {
+      throw invalid_argument("Not enough binary data for input " +
+                             input.getName());
+    }
+    input.setData(buffer->data(0));
+    std::memcpy(buffer->data(0), binary->data(), size);
+    binary->remove_prefix(size);
+    return input;
+  }
+
   if (!json.isMember("data")) {
     throw invalid_argument("No 'data' key present in request input");
   }
@@ -413,21 +617,50 @@ InferenceRequestOutput getOutput(const Json::Value &json) {
   return output;
 }
 
-void setCallback(InferenceRequest *request, DrogonCallback &&drogon_callback) {
-  Callback callback = [callback = std::move(drogon_callback)](
-                        const InferenceResponse &response) {
+void setCallback(InferenceRequest *request, DrogonCallback &&drogon_callback,
+                 std::shared_ptr<ServerTiming> timing,
+                 std::shared_ptr<RequestUsage> usage,
+                 const SharedState *state) {
+  Callback callback = [callback = std::move(drogon_callback),
+                       binary_outputs = getBinaryOutputs(*request),
+                       timing = std::move(timing), usage = std::move(usage),
+                       state](const InferenceResponse &response) {
+    // HTTP requests only get the final response
+    if (!response.isFinal()) {
+      return;
+    }
+    if (timing != nullptr) {
+      timing->mark(ServerTiming::Responded);
+    }
+    const UsageScope encoding{usage.get(), RequestUsage::Encode};
     drogon::HttpResponsePtr resp;
     if (response.isError()) {
       resp =
         errorHttpResponse(response.getError(), HttpStatusCode::k400BadRequest);
     } else {
       try {
-        Json::Value ret = parseResponse(response);
-        resp = drogon::HttpResponse::newHttpJsonResponse(ret);
+        size_t header_length = 0;
+        auto body =
+          serializeJsonResponse(response, binary_outputs, &header_length);
+        countCopy(body.size());
+        resp = drogon::HttpResponse::newHttpResponse();
+        if (binary_outputs.empty()) {
+          resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+        } else {
+          resp->setContentTypeCode(drogon::CT_APPLICATION_OCTET_STREAM);
+          resp->addHeader(kInferenceHeaderContentLength,
+                          std::to_string(header_length));
+        }
+        resp->setBody(std::move(body));
       } catch (const invalid_argument &e) {
         resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
       }
     }
+    if (timing != nullptr) {
+      timing->mark(ServerTiming::Serialized);
+      resp->addHeader(std::string{kServerTimingHeader}, timing->str());
+    }
+    resp->addHeader(std::string{kLoadHeader}, state->formatLoad());
 #ifdef AMDINFER_ENABLE_TRACING
     const auto &context = response.getContext();
     propagate(resp.get(), context);
@@ -438,7 +671,8 @@ void setCallback(InferenceRequest *request, DrogonCallback &&drogon_callback) {
 }
 
 InferenceRequestPtr getRequest(const std::shared_ptr<Json::Value> &json,
-                               const MemoryPool *pool) {
+                               const MemoryPool *pool,
+                               std::string_view binary) {
   auto request = std::make_shared<InferenceRequest>();
 
   if (json->isMember("id")) {
@@ -462,17 +696,22 @@ InferenceRequestPtr getRequest(const std::shared_ptr<Json::Value> &json,
   request->setCallback(nullptr);
 
   const auto input_num = inputs.size();
+  request->reserveTensors(input_num, 0);
   for (auto i = 0U; i < input_num; ++i) {
     const auto &input = inputs[i];
     if (!input.isObject()) {
       throw invalid_argument("At least one element in 'inputs' is not an obj");
     }
-    request->addInputTensor(getInput(input, pool));
+    request->addInputTensor(getInput(input, pool, &binary));
+  }
+  if (!binary.empty()) {
+    throw invalid_argument("Binary data in the request is not used by inputs");
   }
 
   if (json->isMember("outputs")) {
     auto outputs = json->get("outputs", Json::arrayValue);
     const auto output_num = outputs.size();
+    request->reserveTensors(input_num, output_num);
     for (auto i = 0U; i < output_num; ++i) {
       const auto &json_output = outputs[i];
 
@@ -483,41 +722,91 @@ InferenceRequestPtr getRequest(const std::shared_ptr<Json::Value> &json,
   return request;
 }
 
+/**
+ * @brief Get the JSON of an inference request's body. With the binary tensor
+ * data extension, the body is a JSON header followed by the raw bytes of the
+ * inputs, which are returned separately.
+ *
+ * @param req the request
+ * @param storage holds the decompressed body, if any
+ * @param binary [out] the raw bytes of the inputs, if any
+ * @return std::string_view the JSON
+ */
+std::string_view splitBody(const drogon::HttpRequest *req,
+                           std::string *storage, std::string_view *binary) {
+  std::string_view json = decodeBody(req, storage);
+  const auto &header_length = req->getHeader(kInferenceHeaderContentLength);
+  if (!header_length.empty()) {
+    const auto length = parseHeaderLength(header_length, json.size());
+    *binary = json.substr(length);
+    json = json.substr(0, length);
+  }
+  return json;
+}
+
 void modelInfer(const HttpRequestPtr &req, DrogonCallback &&callback,
                 SharedState *state, const std::string &endpoint,
-                const std::string &version) {
+                const std::string &version, util::Timestamp received,
+                std::shared_ptr<CompletionExecutor> executor) {
 #ifdef AMDINFER_ENABLE_TRACING
   const auto &drogon_headers = req->getHeaders();
   StringMap headers{drogon_headers.begin(), drogon_headers.end()};
   auto trace = startTrace(&(__func__[0]), headers);
-  trace->setAttribute("model", model);
+  if (trace != nullptr) {
+    trace->setAttribute("model", endpoint);
+  }
 #endif
 
   AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
   AMDINFER_LOG_INFO(logger, "Received modelInfer request for " + endpoint);
 #ifdef AMDINFER_ENABLE_METRICS
-  auto now = std::chrono::high_resolution_clock::now();
   Metrics::getInstance().incrementCounter(MetricCounterIDs::RestPost);
 #endif
 
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->startSpan("request_handler");
+  if (trace != nullptr) {
+    trace->startSpan("request_handler");
+  }
 #endif
 
-  auto json = req->getJsonObject();
   try {
-    auto request = getRequest(json, state->getPool());
-    setCallback(request.get(), std::move(callback));
-    auto request_container = std::make_unique<RequestContainer>();
+    // refuse the request before any decoding or allocation if the server or
+    // its endpoint has no room for it
+    auto tenant = req->getHeader(state->getTenantKey());
+    auto server_ticket = state->admit(tenant);
+    auto ticket = state->modelAdmit(endpoint, version, req->body().size());
+    const UsageMeter decoding{state->accountsUsage()};
+    std::string body;
+    std::string_view binary;
+    const auto json = splitBody(req.get(), &body, &binary);
+    auto request = parseJsonRequest(json, state->getPool(), binary);
+    auto shared_memory =
+      state->getSharedMemory()->map(request.get(), state->getPool());
+    setCallback(request.get(), std::move(callback),
+                startServerTiming(request.get(), received),
+                startRequestUsage(request.get(), decoding, endpoint,
+                                  std::move(tenant)),
+                state);
+    request->setExecutor(std::move(executor));
+    // outputs in shared memory are written before the response is serialized
+    holdSharedMemory(request.get(), std::move(shared_memory));
+    holdTicket(request.get(), std::move(ticket));
+    holdTicket(request.get(), std::move(server_ticket));
+    auto request_container = makeRequestContainer();
     request_container->request = request;
 #ifdef AMDINFER_ENABLE_METRICS
-    request_container->start_time = now;
+    request_container->start_time = received;
 #endif
 #ifdef AMDINFER_ENABLE_TRACING
-    trace->endSpan();
+    if (trace != nullptr) {
+      trace->endSpan();
+    }
     request_container->trace = std::move(trace);
 #endif
     state->modelInfer(endpoint, std::move(request_container), version);
+  } catch (const resource_exhausted_error &e) {
+    AMDINFER_LOG_INFO(logger, e.what());
+    callback(errorHttpResponse(e.what(), HttpStatusCode::k429TooManyRequests));
   } catch (const invalid_argument &e) {
     AMDINFER_LOG_INFO(logger, e.what());
     auto resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
@@ -533,14 +822,190 @@ void modelInfer(const HttpRequestPtr &req, DrogonCallback &&callback,
 void HttpServer::modelInfer(const HttpRequestPtr &req,
                             DrogonCallback &&callback,
                             const std::string &model) const {
-  amdinfer::modelInfer(req, std::move(callback), state_, model, "");
+  // the time waiting for a decode thread counts towards the request's latency
+  this->decode([this, req, callback = std::move(callback), model,
+                received = util::now(),
+                executor = getLoopExecutor()]() mutable {
+    amdinfer::modelInfer(req, std::move(callback), state_, model, "",
+                         received, std::move(executor));
+  });
 }
 
 void HttpServer::modelInferVersion(const HttpRequestPtr &req,
                                    DrogonCallback &&callback,
                                    const std::string &model,
                                    const std::string &version) const {
-  amdinfer::modelInfer(req, std::move(callback), state_, model, version);
+  this->decode([this, req, callback = std::move(callback), model, version,
+                received = util::now(),
+                executor = getLoopExecutor()]() mutable {
+    amdinfer::modelInfer(req, std::move(callback), state_, model, version,
+                         received, std::move(executor));
+  });
+}
+
+namespace {
+
+/**
+ * @brief Collects the responses to the requests of a modelInferBatch call and
+ * responds to the client with all of them, in the order of the requests, once
+ * the last one finishes
+ */
+class BatchResponse {
+ public:
+  BatchResponse(DrogonCallback &&callback, size_t size)
+    : callback_(std::move(callback)), responses_(size), remaining_(size) {}
+
+  /// Set the serialized response to the request at an index
+  void set(size_t index, std::string response) {
+    {
+      std::lock_guard lock{mutex_};
+      responses_.at(index) = std::move(response);
+      if (--remaining_ > 0) {
+        return;
+      }
+    }
+    // the last response is set so nothing else touches the responses
+    this->respond();
+  }
+
+  /// Set an error as the response to the request at an index
+  void setError(size_t index, const std::string &id, const std::string &error) {
+    Json::Value json;
+    json["id"] = id;
+    json["error"] = error;
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    this->set(index, Json::writeString(builder, json));
+  }
+
+ private:
+  void respond() {
+    constexpr std::string_view kStart = R"({"responses":[)";
+    constexpr std::string_view kEnd = "]}";
+
+    size_t size = kStart.size() + kEnd.size() + responses_.size();
+    for (const auto &response : responses_) {
+      size += response.size();
+    }
+    std::string body;
+    body.reserve(size);
+    body.append(kStart);
+    for (size_t i = 0; i < responses_.size(); ++i) {
+      if (i > 0) {
+        body.push_back(',');
+      }
+      body.append(responses_[i]);
+    }
+    body.append(kEnd);
+
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+    resp->setBody(std::move(body));
+    callback_(resp);
+  }
+
+  std::mutex mutex_;
+  DrogonCallback callback_;
+  std::vector<std::string> responses_;
+  size_t remaining_;
+};
+
+void setCallback(InferenceRequest *request,
+                 std::shared_ptr<BatchResponse> batch, size_t index) {
+  Callback callback = [batch = std::move(batch), index,
+                       id = request->getID()](
+                        const InferenceResponse &response) {
+    if (!response.isFinal()) {
+      return;
+    }
+    if (response.isError()) {
+      batch->setError(index, id, response.getError());
+      return;
+    }
+    try {
+      // the responses share one JSON body so there's no room for raw outputs
+      size_t header_length = 0;
+      batch->set(index,
+                 serializeJsonResponse(response, BinaryOutputs{},
+                                       &header_length));
+    } catch (const invalid_argument &e) {
+      batch->setError(index, id, e.what());
+    }
+  };
+  request->setCallback(std::move(callback));
+}
+
+}  // namespace
+
+void HttpServer::modelInferBatch(const HttpRequestPtr &req,
+                                 DrogonCallback &&callback) const {
+  this->decode([this, req, callback = std::move(callback),
+                received = util::now(),
+                executor = getLoopExecutor()]() mutable {
+    this->runInferBatch(req, std::move(callback), received, executor);
+  });
+}
+
+void HttpServer::runInferBatch(
+  const HttpRequestPtr &req, DrogonCallback &&callback,
+  [[maybe_unused]] util::Timestamp received,
+  const std::shared_ptr<CompletionExecutor> &executor) const {
+  AMDINFER_LOG_INFO(logger_, "Received modelInferBatch request");
+#ifdef AMDINFER_ENABLE_METRICS
+  Metrics::getInstance().incrementCounter(MetricCounterIDs::RestPost);
+#endif
+
+  std::shared_ptr<void> server_ticket;
+  std::vector<ModelRequest> requests;
+  try {
+    // the whole call counts once against the server's limits
+    server_ticket = state_->admit(req->getHeader(state_->getTenantKey()));
+    std::string body;
+    std::string_view binary;
+    const auto json = splitBody(req.get(), &body, &binary);
+    requests = parseJsonRequests(json, state_->getPool(), binary);
+  } catch (const resource_exhausted_error &e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    callback(errorHttpResponse(e.what(), HttpStatusCode::k429TooManyRequests));
+    return;
+  } catch (const invalid_argument &e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    callback(errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest));
+    return;
+  }
+
+  if (requests.empty()) {
+    Json::Value ret;
+    ret["responses"] = Json::arrayValue;
+    callback(HttpResponse::newHttpJsonResponse(ret));
+    return;
+  }
+
+  auto batch =
+    std::make_shared<BatchResponse>(std::move(callback), requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto &[model, version, request, bytes] = requests[i];
+    setCallback(request.get(), batch, i);
+    request->setExecutor(executor);
+    // each request is admitted, run and fails on its own
+    try {
+      auto ticket = state_->modelAdmit(model, version, bytes);
+      auto shared_memory =
+        state_->getSharedMemory()->map(request.get(), state_->getPool());
+      holdSharedMemory(request.get(), std::move(shared_memory));
+      holdTicket(request.get(), std::move(ticket));
+      holdTicket(request.get(), server_ticket);
+      auto request_container = makeRequestContainer();
+      request_container->request = request;
+#ifdef AMDINFER_ENABLE_METRICS
+      request_container->start_time = received;
+#endif
+      state_->modelInfer(model, std::move(request_container), version);
+    } catch (const runtime_error &e) {
+      AMDINFER_LOG_INFO(logger_, e.what());
+      request->runCallbackError(e.what());
+    }
+  }
 }
 
 void modelLoad(const HttpRequestPtr &req, DrogonCallback &&callback,
@@ -551,7 +1016,9 @@ void modelLoad(const HttpRequestPtr &req, DrogonCallback &&callback,
   const auto &drogon_headers = req->getHeaders();
   StringMap headers{drogon_headers.begin(), drogon_headers.end()};
   auto trace = startTrace(&(__func__[0]), headers);
-  trace->setAttribute("model", model_lower);
+  if (trace != nullptr) {
+    trace->setAttribute("model", model_lower);
+  }
 #endif
   AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
   AMDINFER_LOG_INFO(logger, "Received modelLoad request for " + model_lower);
@@ -562,7 +1029,9 @@ void modelLoad(const HttpRequestPtr &req, DrogonCallback &&callback,
     parameters = mapJsonToParameters(*json);
   }
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->setAttributes(parameters);
+  if (trace != nullptr) {
+    trace->setAttributes(parameters);
+  }
 #endif
 
   try {
@@ -571,16 +1040,18 @@ void modelLoad(const HttpRequestPtr &req, DrogonCallback &&callback,
     AMDINFER_LOG_ERROR(logger, e.what());
     auto resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
 #ifdef AMDINFER_ENABLE_TRACING
-    auto context = trace->propagate();
-    propagate(resp.get(), context);
+    if (trace != nullptr) {
+      propagate(resp.get(), trace->propagate());
+    }
 #endif
     callback(resp);
   }
 
   auto resp = HttpResponse::newHttpResponse();
 #ifdef AMDINFER_ENABLE_TRACING
-  auto context = trace->propagate();
-  propagate(resp.get(), context);
+  if (trace != nullptr) {
+    propagate(resp.get(), trace->propagate());
+  }
 #endif
   callback(resp);
 }
@@ -611,15 +1082,18 @@ void modelUnload([[maybe_unused]] const HttpRequestPtr &req,
   auto endpoint_lower = util::toLower(endpoint);
 
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->setAttribute("model", endpoint_lower);
+  if (trace != nullptr) {
+    trace->setAttribute("model", endpoint_lower);
+  }
 #endif
 
   state->modelUnload(endpoint_lower, version);
 
   auto resp = HttpResponse::newHttpResponse();
 #ifdef AMDINFER_ENABLE_TRACING
-  auto context = trace->propagate();
-  propagate(resp.get(), context);
+  if (trace != nullptr) {
+    propagate(resp.get(), trace->propagate());
+  }
 #endif
   callback(resp);
 }
@@ -637,6 +1111,56 @@ void HttpServer::modelUnloadVersion(const HttpRequestPtr &req,
   amdinfer::modelUnload(req, std::move(callback), state_, model, version);
 }
 
+void modelUpdate(const HttpRequestPtr &req, DrogonCallback &&callback,
+                 SharedState *state, const std::string &model,
+                 const std::string &version) {
+  auto model_lower = util::toLower(model);
+#ifdef AMDINFER_ENABLE_TRACING
+  const auto &drogon_headers = req->getHeaders();
+  StringMap headers{drogon_headers.begin(), drogon_headers.end()};
+  auto trace = startTrace(&(__func__[0]), headers);
+  if (trace != nullptr) {
+    trace->setAttribute("model", model_lower);
+  }
+#endif
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
+  AMDINFER_LOG_INFO(logger, "Received modelUpdate request for " + model_lower);
+
+  auto json = req->getJsonObject();
+  ParameterMap parameters;
+  if (json != nullptr) {
+    parameters = mapJsonToParameters(*json);
+  }
+
+  HttpResponsePtr resp;
+  try {
+    state->modelUpdate(model_lower, version, parameters);
+    resp = HttpResponse::newHttpResponse();
+  } catch (const runtime_error &e) {
+    AMDINFER_LOG_ERROR(logger, e.what());
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
+  }
+#ifdef AMDINFER_ENABLE_TRACING
+  if (trace != nullptr) {
+    propagate(resp.get(), trace->propagate());
+  }
+#endif
+  callback(resp);
+}
+
+void HttpServer::modelUpdate(const HttpRequestPtr &req,
+                             DrogonCallback &&callback,
+                             const std::string &model) const {
+  amdinfer::modelUpdate(req, std::move(callback), state_, model, "");
+}
+
+void HttpServer::modelUpdateVersion(const HttpRequestPtr &req,
+                                    DrogonCallback &&callback,
+                                    const std::string &model,
+                                    const std::string &version) const {
+  amdinfer::modelUpdate(req, std::move(callback), state_, model, version);
+}
+
 void HttpServer::workerLoad(const HttpRequestPtr &req,
                             DrogonCallback &&callback,
                             const std::string &worker) const {
@@ -656,12 +1180,16 @@ void HttpServer::workerLoad(const HttpRequestPtr &req,
   auto worker_lower = util::toLower(worker);
 
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->setAttribute("model", worker_lower);
+  if (trace != nullptr) {
+    trace->setAttribute("model", worker_lower);
+  }
 #endif
   AMDINFER_LOG_INFO(logger_, "Received load request is for " + worker_lower);
 
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->setAttributes(parameters);
+  if (trace != nullptr) {
+    trace->setAttributes(parameters);
+  }
 #endif
   HttpResponsePtr resp;
   try {
@@ -674,8 +1202,9 @@ void HttpServer::workerLoad(const HttpRequestPtr &req,
   }
 
 #ifdef AMDINFER_ENABLE_TRACING
-  auto context = trace->propagate();
-  propagate(resp.get(), context);
+  if (trace != nullptr) {
+    propagate(resp.get(), trace->propagate());
+  }
 #endif
   callback(resp);
 }
@@ -694,19 +1223,308 @@ void HttpServer::workerUnload([[maybe_unused]] const HttpRequestPtr &req,
   AMDINFER_LOG_INFO(logger_, "Received unload request is for " + worker_lower);
 
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->setAttribute("model", worker_lower);
+  if (trace != nullptr) {
+    trace->setAttribute("model", worker_lower);
+  }
 #endif
 
   state_->workerUnload(worker_lower);
 
   auto resp = HttpResponse::newHttpResponse();
 #ifdef AMDINFER_ENABLE_TRACING
-  auto context = trace->propagate();
-  propagate(resp.get(), context);
+  if (trace != nullptr) {
+    propagate(resp.get(), trace->propagate());
+  }
 #endif
   callback(resp);
 }
 
+void HttpServer::systemSharedMemoryRegister(const HttpRequestPtr &req,
+                                            DrogonCallback &&callback,
+                                            const std::string &region) const {
+  AMDINFER_LOG_INFO(logger_,
+                    "Received shared memory register request for " + region);
+
+  auto json = req->getJsonObject();
+  HttpResponsePtr resp;
+  try {
+    if (json == nullptr || !json->isMember("key") ||
+        !json->isMember("byte_size")) {
+      throw invalid_argument(
+        "Registering a region needs a 'key' and a 'byte_size'");
+    }
+    const auto key = (*json)["key"].asString();
+    const auto offset = json->get("offset", 0).asUInt64();
+    const auto byte_size = (*json)["byte_size"].asUInt64();
+    state_->getSharedMemory()->add(region, key, offset, byte_size);
+    resp = HttpResponse::newHttpResponse();
+  } catch (const Json::LogicError &) {
+    resp = errorHttpResponse("Invalid shared memory region",
+                             HttpStatusCode::k400BadRequest);
+  } catch (const runtime_error &e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
+  }
+  callback(resp);
+}
+
+void systemSharedMemoryUnregister(DrogonCallback &&callback,
+                                  SharedState *state,
+                                  const std::string &region) {
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
+  AMDINFER_LOG_INFO(logger, "Received shared memory unregister request");
+
+  HttpResponsePtr resp;
+  try {
+    state->getSharedMemory()->remove(region);
+    resp = HttpResponse::newHttpResponse();
+  } catch (const invalid_argument &e) {
+    AMDINFER_LOG_INFO(logger, e.what());
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
+  }
+  callback(resp);
+}
+
+void HttpServer::systemSharedMemoryUnregister(
+  [[maybe_unused]] const HttpRequestPtr &req, DrogonCallback &&callback,
+  const std::string &region) const {
+  amdinfer::systemSharedMemoryUnregister(std::move(callback), state_, region);
+}
+
+void HttpServer::systemSharedMemoryUnregisterAll(
+  [[maybe_unused]] const HttpRequestPtr &req, DrogonCallback &&callback) const {
+  amdinfer::systemSharedMemoryUnregister(std::move(callback), state_, "");
+}
+
+void systemSharedMemoryStatus(DrogonCallback &&callback, SharedState *state,
+                              const std::string &region) {
+  AMDINFER_IF_LOGGING(Logger logger{Loggers::Server});
+  AMDINFER_LOG_INFO(logger, "Received shared memory status request");
+
+  HttpResponsePtr resp;
+  try {
+    Json::Value json = Json::arrayValue;
+    for (const auto &status : state->getSharedMemory()->status(region)) {
+      Json::Value entry;
+      entry["name"] = status.name;
+      entry["key"] = status.key;
+      entry["offset"] = Json::UInt64{status.offset};
+      entry["byte_size"] = Json::UInt64{status.byte_size};
+      json.append(entry);
+    }
+    resp = HttpResponse::newHttpJsonResponse(json);
+  } catch (const invalid_argument &e) {
+    AMDINFER_LOG_INFO(logger, e.what());
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
+  }
+  callback(resp);
+}
+
+void HttpServer::systemSharedMemoryStatus(
+  [[maybe_unused]] const HttpRequestPtr &req, DrogonCallback &&callback,
+  const std::string &region) const {
+  amdinfer::systemSharedMemoryStatus(std::move(callback), state_, region);
+}
+
+void HttpServer::systemSharedMemoryStatusAll(
+  [[maybe_unused]] const HttpRequestPtr &req, DrogonCallback &&callback) const {
+  amdinfer::systemSharedMemoryStatus(std::move(callback), state_, "");
+}
+
+void HttpServer::profile(const HttpRequestPtr &req,
+                         DrogonCallback &&callback) const {
+  AMDINFER_LOG_INFO(logger_, "Received profile request");
+
+  std::chrono::milliseconds duration;
+  try {
+    duration = parseProfileDuration(req->getParameter("duration"));
+    startProfiling();
+  } catch (const invalid_argument &e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    callback(errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest));
+    return;
+  }
+
+  // respond later from the event loop instead of blocking one of its threads
+  auto *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+  loop->runAfter(std::chrono::duration<double>(duration).count(),
+                 [callback = std::move(callback)]() {
+                   auto resp = HttpResponse::newHttpResponse();
+                   resp->setBody(stopProfiling());
+                   resp->setContentTypeCode(
+                     drogon::ContentType::CT_APPLICATION_JSON);
+                   callback(resp);
+                 });
+}
+
+void HttpServer::memory(const HttpRequestPtr &req,
+                        DrogonCallback &&callback) const {
+  AMDINFER_LOG_INFO(logger_, "Received memory request");
+  (void)req;  // suppress unused variable warning
+
+  auto hex = [](uintptr_t address) {
+    constexpr auto kMaxSize = 2 + (2 * sizeof(uintptr_t)) + 1;
+    std::array<char, kMaxSize> buffer{};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    std::snprintf(buffer.data(), buffer.size(), "0x%zx",
+                  static_cast<size_t>(address));
+    return std::string{buffer.data()};
+  };
+
+  Json::Value json;
+  json["allocators"] = Json::arrayValue;
+  for (const auto &[allocator, node, stats] :
+       state_->getPool()->getStats(true)) {
+    Json::Value entry;
+    entry["allocator"] = allocator;
+    entry["node"] = node;
+    entry["reserved"] = Json::UInt64{stats.reserved};
+    entry["used"] = Json::UInt64{stats.used};
+    entry["cached"] = Json::UInt64{stats.cached};
+    entry["free_chunks"] = Json::UInt64{stats.free_chunks};
+    entry["largest_free"] = Json::UInt64{stats.largest_free};
+    entry["fragmentation"] = stats.fragmentation();
+    entry["failures"] = Json::UInt64{stats.failures};
+    entry["blocks"] = Json::arrayValue;
+    for (const auto &block : stats.blocks) {
+      Json::Value json_block;
+      json_block["address"] = hex(block.address);
+      json_block["size"] = Json::UInt64{block.size};
+      json_block["device"] = block.device;
+      json_block["free"] = Json::arrayValue;
+      for (const auto &chunk : block.free) {
+        Json::Value json_chunk;
+        json_chunk["offset"] = Json::UInt64{chunk.offset};
+        json_chunk["size"] = Json::UInt64{chunk.size};
+        json_block["free"].append(json_chunk);
+      }
+      entry["blocks"].append(json_block);
+    }
+    json["allocators"].append(entry);
+  }
+
+  auto resp = HttpResponse::newHttpJsonResponse(json);
+  callback(resp);
+}
+
+void HttpServer::getLoad(const HttpRequestPtr &req,
+                         DrogonCallback &&callback) const {
+  // balancers may poll it often so it's only logged at the debug level
+  AMDINFER_LOG_DEBUG(logger_, "Received getLoad request");
+  (void)req;  // suppress unused variable warning
+
+  Json::Value json;
+  json["load"] = state_->getLoad();
+  json["ready"] = state_->serverReady();
+  auto resp = HttpResponse::newHttpJsonResponse(json);
+  resp->addHeader(std::string{kLoadHeader}, state_->formatLoad());
+  callback(resp);
+}
+
+Json::Value serializeJobStatus(const BulkJobStatus &status) {
+  Json::Value json;
+  json["id"] = status.id;
+  json["model"] = status.model;
+  json["state"] = toString(status.state);
+  json["total"] = Json::UInt64{status.total};
+  json["completed"] = Json::UInt64{status.completed};
+  json["failed"] = Json::UInt64{status.failed};
+  const auto seconds =
+    std::chrono::duration_cast<std::chrono::duration<double>>(status.elapsed)
+      .count();
+  json["elapsed_seconds"] = seconds;
+  json["samples_per_second"] =
+    seconds > 0 ? static_cast<double>(status.completed) / seconds : 0.0;
+  if (!status.error.empty()) {
+    json["error"] = status.error;
+  }
+  return json;
+}
+
+void HttpServer::jobSubmit(const HttpRequestPtr &req,
+                           DrogonCallback &&callback) const {
+  AMDINFER_LOG_INFO(logger_, "Received job submit request");
+
+  auto json = req->getJsonObject();
+  HttpResponsePtr resp;
+  try {
+    if (json == nullptr || !json->isMember("model") ||
+        !json->isMember("input") || !json->isMember("output")) {
+      throw invalid_argument("Jobs need a 'model', an 'input' and an 'output'");
+    }
+    BulkJobOptions options;
+    options.model = util::toLower((*json)["model"].asString());
+    options.version = json->get("version", "").asString();
+    options.input = (*json)["input"].asString();
+    options.output = (*json)["output"].asString();
+    options.input_name = json->get("input_name", "").asString();
+    for (const auto &dim : json->get("shape", Json::arrayValue)) {
+      options.shape.push_back(dim.asInt64());
+    }
+    if (json->isMember("datatype")) {
+      options.datatype = DataType((*json)["datatype"].asCString());
+    }
+    options.inflight =
+      json->get("inflight", Json::UInt64{options.inflight}).asUInt64();
+    options.max_load = json->get("max_load", options.max_load).asDouble();
+
+    Json::Value ret;
+    ret["id"] = state_->getJobs()->submit(std::move(options));
+    resp = HttpResponse::newHttpJsonResponse(ret);
+  } catch (const Json::LogicError &) {
+    resp = errorHttpResponse("Invalid job", HttpStatusCode::k400BadRequest);
+  } catch (const runtime_error &e) {
+    AMDINFER_LOG_INFO(logger_, e.what());
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k400BadRequest);
+  }
+  callback(resp);
+}
+
+void HttpServer::jobList(const HttpRequestPtr &req,
+                         DrogonCallback &&callback) const {
+  AMDINFER_LOG_DEBUG(logger_, "Received job list request");
+  (void)req;  // suppress unused variable warning
+
+  Json::Value json = Json::arrayValue;
+  for (const auto &status : state_->getJobs()->list()) {
+    json.append(serializeJobStatus(status));
+  }
+  callback(HttpResponse::newHttpJsonResponse(json));
+}
+
+void HttpServer::jobStatus(const HttpRequestPtr &req,
+                           DrogonCallback &&callback,
+                           const std::string &id) const {
+  // jobs are polled for their progress so it's only logged at the debug level
+  AMDINFER_LOG_DEBUG(logger_, "Received job status request for " + id);
+  (void)req;  // suppress unused variable warning
+
+  HttpResponsePtr resp;
+  try {
+    resp = HttpResponse::newHttpJsonResponse(
+      serializeJobStatus(state_->getJobs()->status(id)));
+  } catch (const invalid_argument &e) {
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k404NotFound);
+  }
+  callback(resp);
+}
+
+void HttpServer::jobCancel(const HttpRequestPtr &req,
+                           DrogonCallback &&callback,
+                           const std::string &id) const {
+  AMDINFER_LOG_INFO(logger_, "Received job cancel request for " + id);
+  (void)req;  // suppress unused variable warning
+
+  HttpResponsePtr resp;
+  try {
+    state_->getJobs()->cancel(id);
+    resp = HttpResponse::newHttpResponse();
+  } catch (const invalid_argument &e) {
+    resp = errorHttpResponse(e.what(), HttpStatusCode::k404NotFound);
+  }
+  callback(resp);
+}
+
 #endif  // AMDINFER_ENABLE_HTTP
 
 #ifdef AMDINFER_ENABLE_METRICS
@@ -714,7 +1532,16 @@ void HttpServer::metrics(const HttpRequestPtr &req,
                          DrogonCallback &&callback) const {
   (void)req;  // suppress unused variable warning
   AMDINFER_LOG_INFO(logger_, "Received metrics request");
-  std::string body = Metrics::getInstance().getMetrics();
+  std::string body;
+  // report the metrics of all the shards, once their supervisor has merged them
+  if (const auto &directory = state_->getShardDirectory(); !directory.empty()) {
+    std::ifstream file{getMergedMetricsPath(directory)};
+    body.assign(std::istreambuf_iterator<char>{file},
+                std::istreambuf_iterator<char>{});
+  }
+  if (body.empty()) {
+    body = Metrics::getInstance().getMetrics();
+  }
   auto resp = drogon::HttpResponse::newHttpResponse();
   resp->setBody(body);
   resp->setContentTypeCode(drogon::ContentType::CT_TEXT_PLAIN);
@@ -21,13 +21,18 @@
 #ifndef GUARD_AMDINFER_SERVERS_HTTP_SERVER
 #define GUARD_AMDINFER_SERVERS_HTTP_SERVER
 
-#include <cstdint>     // for uint16_t
-#include <functional>  // for function
-#include <string>      // for allocator, string
-
-#include "amdinfer/build_options.hpp"  // for AMDINFER_ENABLE_HTTP, PROT...
+#include <cstdint>      // for uint16_t
+#include <functional>   // for function
+#include <memory>       // for unique_ptr
+#include <string>       // for allocator, string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_HTTP, ...
 #include "amdinfer/core/request_container.hpp"  // for InferenceRequestBuilder
 #include "amdinfer/observation/logging.hpp"     // for LoggerPtr
+#include "amdinfer/util/ctpl.hpp"                // for ThreadPool
+#include "amdinfer/util/timestamps.hpp"          // for Timestamp
 
 #ifdef AMDINFER_ENABLE_HTTP
 #include <drogon/HttpController.h>  // for ADD_METHOD_TO, HttpContro...
@@ -38,13 +43,25 @@
 
 namespace amdinfer {
 
+class CompletionExecutor;
+
 class SharedState;
 class MemoryPool;
 
 #ifdef AMDINFER_ENABLE_HTTP
 
+/**
+ * @brief Construct a request from its JSON representation
+ *
+ * @param json the JSON request
+ * @param pool the memory pool to allocate input buffers from
+ * @param binary raw input data following the JSON header if the request uses
+ * the binary tensor data extension
+ * @return InferenceRequestPtr
+ */
 InferenceRequestPtr getRequest(const std::shared_ptr<Json::Value> &json,
-                               const MemoryPool *pool);
+                               const MemoryPool *pool,
+                               std::string_view binary = {});
 
 using DrogonCallback = std::function<void(const drogon::HttpResponsePtr &)>;
 
@@ -55,8 +72,17 @@ using DrogonCallback = std::function<void(const drogon::HttpResponsePtr &)>;
  */
 class HttpServer : public drogon::HttpController<HttpServer, false> {
  public:
-  /// Constructor
-  explicit HttpServer(SharedState *state);
+  /**
+   * @brief Construct a new HttpServer object
+   *
+   * @param state the server's shared state
+   * @param decode_threads number of threads that decode inference requests.
+   * If it's zero, they're decoded on the I/O thread that received them
+   * @param cpus the CPUs the decode threads are restricted to. Empty to leave
+   * them unpinned
+   */
+  HttpServer(SharedState *state, int decode_threads,
+             const std::vector<int> &cpus);
 
   METHOD_LIST_BEGIN
 
@@ -85,6 +111,8 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
   ADD_METHOD_TO(HttpServer::modelInferVersion,
                 "v2/models/{model}/versions/{version}/infer", drogon::Post,
                 drogon::Options);
+  ADD_METHOD_TO(HttpServer::modelInferBatch, "v2/infer", drogon::Post,
+                drogon::Options);
   ADD_METHOD_TO(HttpServer::modelLoad, "v2/repository/models/{model}/load",
                 drogon::Post, drogon::Options);
   ADD_METHOD_TO(HttpServer::modelLoadVersion,
@@ -95,10 +123,36 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
   ADD_METHOD_TO(HttpServer::modelUnloadVersion,
                 "v2/repository/models/{model}/versions/{version}/unload",
                 drogon::Post, drogon::Options);
+  ADD_METHOD_TO(HttpServer::modelUpdate, "v2/repository/models/{model}/update",
+                drogon::Post, drogon::Options);
+  ADD_METHOD_TO(HttpServer::modelUpdateVersion,
+                "v2/repository/models/{model}/versions/{version}/update",
+                drogon::Post, drogon::Options);
   ADD_METHOD_TO(HttpServer::workerLoad, "v2/workers/{worker}/load",
                 drogon::Post, drogon::Options);
   ADD_METHOD_TO(HttpServer::workerUnload, "v2/workers/{worker}/unload",
                 drogon::Post, drogon::Options);
+  ADD_METHOD_TO(HttpServer::systemSharedMemoryRegister,
+                "v2/systemsharedmemory/region/{region}/register", drogon::Post,
+                drogon::Options);
+  ADD_METHOD_TO(HttpServer::systemSharedMemoryUnregister,
+                "v2/systemsharedmemory/region/{region}/unregister",
+                drogon::Post, drogon::Options);
+  ADD_METHOD_TO(HttpServer::systemSharedMemoryUnregisterAll,
+                "v2/systemsharedmemory/unregister", drogon::Post,
+                drogon::Options);
+  ADD_METHOD_TO(HttpServer::systemSharedMemoryStatus,
+                "v2/systemsharedmemory/region/{region}/status", drogon::Get,
+                drogon::Options);
+  ADD_METHOD_TO(HttpServer::systemSharedMemoryStatusAll,
+                "v2/systemsharedmemory/status", drogon::Get, drogon::Options);
+  ADD_METHOD_TO(HttpServer::profile, "v2/profile", drogon::Post);
+  ADD_METHOD_TO(HttpServer::memory, "v2/memory", drogon::Get);
+  ADD_METHOD_TO(HttpServer::getLoad, "v2/load", drogon::Get);
+  ADD_METHOD_TO(HttpServer::jobSubmit, "v2/jobs", drogon::Post);
+  ADD_METHOD_TO(HttpServer::jobList, "v2/jobs", drogon::Get);
+  ADD_METHOD_TO(HttpServer::jobStatus, "v2/jobs/{id}", drogon::Get);
+  ADD_METHOD_TO(HttpServer::jobCancel, "v2/jobs/{id}/cancel", drogon::Post);
 #ifdef AMDINFER_ENABLE_METRICS
   ADD_METHOD_TO(HttpServer::metrics, "metrics", drogon::Get);
 #endif
@@ -115,7 +169,9 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
                      DrogonCallback &&callback) const;
 
   /**
-   * @brief Returns 200 if all models are ready for inferencing
+   * @brief Returns 200 if all models are ready for inferencing. With overload
+   * readiness, it returns 503 while the server is saturated. The response
+   * reports the server's load in the amdinfer-load header
    *
    * @param req the REST request object
    * @param callback the callback function to respond to the client
@@ -217,6 +273,18 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
                          DrogonCallback &&callback, const std::string &model,
                          const std::string &version) const;
 
+  /**
+   * @brief Handles many inference requests in one call. The requests may be
+   * for different models and are batched as if they'd been sent separately.
+   * The response has the responses to all the requests, in order, once they
+   * have all finished.
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void modelInferBatch(const drogon::HttpRequestPtr &req,
+                       DrogonCallback &&callback) const;
+
   /**
    * @brief Loads and starts a model
    *
@@ -261,6 +329,28 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
                           DrogonCallback &&callback, const std::string &model,
                           const std::string &version) const;
 
+  /**
+   * @brief Changes the batch size or timeout of a loaded model
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param model name of the model to update
+   */
+  void modelUpdate(const drogon::HttpRequestPtr &req, DrogonCallback &&callback,
+                   const std::string &model) const;
+
+  /**
+   * @brief Changes the batch size or timeout of a loaded model
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param model name of the model to update
+   * @param version version of the model to update
+   */
+  void modelUpdateVersion(const drogon::HttpRequestPtr &req,
+                          DrogonCallback &&callback, const std::string &model,
+                          const std::string &version) const;
+
   /**
    * @brief Loads and starts a worker
    *
@@ -281,6 +371,134 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
   void workerUnload(const drogon::HttpRequestPtr &req,
                     DrogonCallback &&callback, std::string const &worker) const;
 
+  /**
+   * @brief Registers a system shared memory region that inputs and outputs can
+   * use. The body has the region's "key" and "byte_size" and an optional
+   * "offset" into the shared memory object
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param region name of the region to register
+   */
+  void systemSharedMemoryRegister(const drogon::HttpRequestPtr &req,
+                                  DrogonCallback &&callback,
+                                  const std::string &region) const;
+
+  /**
+   * @brief Unregisters a system shared memory region
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param region name of the region to unregister
+   */
+  void systemSharedMemoryUnregister(const drogon::HttpRequestPtr &req,
+                                    DrogonCallback &&callback,
+                                    const std::string &region) const;
+
+  /**
+   * @brief Unregisters all the system shared memory regions
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void systemSharedMemoryUnregisterAll(const drogon::HttpRequestPtr &req,
+                                       DrogonCallback &&callback) const;
+
+  /**
+   * @brief Returns the status of a system shared memory region
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param region name of the region
+   */
+  void systemSharedMemoryStatus(const drogon::HttpRequestPtr &req,
+                                DrogonCallback &&callback,
+                                const std::string &region) const;
+
+  /**
+   * @brief Returns the status of all the system shared memory regions
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void systemSharedMemoryStatusAll(const drogon::HttpRequestPtr &req,
+                                   DrogonCallback &&callback) const;
+
+  /**
+   * @brief Profiles the server's threads for the duration given by the
+   * "duration" query parameter (e.g. 5s or 500ms) and responds with the events
+   * as a Chrome trace
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void profile(const drogon::HttpRequestPtr &req,
+               DrogonCallback &&callback) const;
+
+  /**
+   * @brief Returns the usage of the memory pool's allocators with their blocks
+   * and free chunks
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void memory(const drogon::HttpRequestPtr &req,
+              DrogonCallback &&callback) const;
+
+  /**
+   * @brief Returns the server's load and whether it's ready so load balancers
+   * can weigh the servers they route to. See SharedState::getLoad
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void getLoad(const drogon::HttpRequestPtr &req,
+               DrogonCallback &&callback) const;
+
+  /**
+   * @brief Starts an offline job that runs a dataset through a model and
+   * writes the outputs to files. The body is a JSON object with the "model",
+   * "input" and "output" and, optionally, the "version", "input_name",
+   * "shape", "datatype", "inflight" and "max_load" of BulkJobOptions. Returns
+   * the job's "id"
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void jobSubmit(const drogon::HttpRequestPtr &req,
+                 DrogonCallback &&callback) const;
+
+  /**
+   * @brief Returns the progress of the running jobs and the last ones that
+   * finished
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   */
+  void jobList(const drogon::HttpRequestPtr &req,
+               DrogonCallback &&callback) const;
+
+  /**
+   * @brief Returns the progress of a job
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param id the ID of the job
+   */
+  void jobStatus(const drogon::HttpRequestPtr &req, DrogonCallback &&callback,
+                 const std::string &id) const;
+
+  /**
+   * @brief Cancels a job. It stops sending requests and finishes once the
+   * ones in flight respond
+   *
+   * @param req the REST request object
+   * @param callback the callback function to respond to the client
+   * @param id the ID of the job
+   */
+  void jobCancel(const drogon::HttpRequestPtr &req, DrogonCallback &&callback,
+                 const std::string &id) const;
+
 #ifdef AMDINFER_ENABLE_METRICS
   /**
    * @brief Returns the raw collected metric data
@@ -292,7 +510,23 @@ class HttpServer : public drogon::HttpController<HttpServer, false> {
                DrogonCallback &&callback) const;
 #endif
  private:
+  /**
+   * @brief Run a task that decodes a request on a decode thread, if there are
+   * any, so large requests don't hold up the other connections on the I/O
+   * thread. Drogon sends the response on the connection's I/O thread
+   *
+   * @param task the task to run
+   */
+  void decode(std::function<void()> task) const;
+
+  /// Decode and run the requests of a modelInferBatch call
+  void runInferBatch(
+    const drogon::HttpRequestPtr &req, DrogonCallback &&callback,
+    util::Timestamp received,
+    const std::shared_ptr<CompletionExecutor> &executor) const;
+
   SharedState *state_;
+  std::unique_ptr<util::ThreadPool> decoders_;
 #ifdef AMDINFER_ENABLE_LOGGING
   Logger logger_{Loggers::Server};
 #endif
@@ -306,8 +540,17 @@ namespace http {
  * @brief Start the HTTP REST server
  *
  * @param port the port to use for the server
+ * @param threads number of I/O threads. If it's zero, there's one per CPU in
+ * cpus or, if cpus is empty, one per four CPUs that the server may use, up to
+ * kDefaultDrogonThreads
+ * @param cpus the CPUs the I/O threads are restricted to. Empty to leave them
+ * unpinned
+ * @param decode_threads number of threads that decode inference requests off
+ * the I/O threads. They share the CPUs of the I/O threads. If it's zero,
+ * requests are decoded on the I/O threads
  */
-void start(SharedState *state, uint16_t port);
+void start(SharedState *state, uint16_t port, int threads,
+           const std::vector<int> &cpus, int decode_threads);
 
 /// Stop the REST server
 void stop();
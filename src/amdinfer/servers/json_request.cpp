@@ -0,0 +1,776 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the fast parser for JSON inference requests
+ */
+
+#include "amdinfer/servers/json_request.hpp"
+
+#include <charconv>      // for from_chars
+#include <cstddef>       // for size_t, byte
+#include <cstdint>       // for uint64_t, int64_t, int32_t
+#include <cstdlib>       // for strtod
+#include <cstring>       // for memcpy
+#include <limits>        // for numeric_limits
+#include <memory>        // for make_shared
+#include <string>        // for string
+#include <system_error>  // for errc
+#include <type_traits>   // for is_same_v, is_integral_v
+#include <utility>       // for move
+#include <variant>       // for bad_variant_access
+#include <vector>        // for vector
+
+#include "amdinfer/buffers/buffer.hpp"          // for Buffer
+#include "amdinfer/clients/http_internal.hpp"   // for kBinaryDataSize
+#include "amdinfer/core/data_types.hpp"         // for DataType, switchOver...
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+#include "amdinfer/core/request_container.hpp"  // for InferenceRequestOutput
+#include "amdinfer/core/request_usage.hpp"      // for countCopy
+#include "amdinfer/core/shared_memory.hpp"      // for isInSharedMemory
+#include "amdinfer/util/float_convert.hpp"      // for convertFp32ToFp16
+#include "amdinfer/util/traits.hpp"             // for is_any_v
+
+namespace amdinfer {
+
+namespace {
+
+/// A number from the JSON, kept in the most precise form it was written in
+struct JsonNumber {
+  enum class Kind { Unsigned, Signed, Real };
+
+  Kind kind = Kind::Unsigned;
+  uint64_t unsigned_value = 0;
+  int64_t signed_value = 0;
+  double real_value = 0;
+
+  template <typename T>
+  [[nodiscard]] T as() const {
+    if constexpr (std::is_same_v<T, bool>) {
+      switch (kind) {
+        case Kind::Unsigned:
+          return unsigned_value != 0;
+        case Kind::Signed:
+          return signed_value != 0;
+        default:
+          return real_value != 0;
+      }
+    } else if constexpr (std::is_integral_v<T>) {
+      switch (kind) {
+        case Kind::Unsigned:
+          if (unsigned_value >
+              static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+            throw invalid_argument(
+              "Could not convert some data to the provided data type");
+          }
+          return static_cast<T>(unsigned_value);
+        case Kind::Signed:
+          if (signed_value <
+              static_cast<int64_t>(std::numeric_limits<T>::lowest())) {
+            throw invalid_argument(
+              "Could not convert some data to the provided data type");
+          }
+          return static_cast<T>(signed_value);
+        default:
+          if (!(real_value >=
+                  static_cast<double>(std::numeric_limits<T>::lowest()) &&
+                real_value <=
+                  static_cast<double>(std::numeric_limits<T>::max()))) {
+            throw invalid_argument(
+              "Could not convert some data to the provided data type");
+          }
+          return static_cast<T>(real_value);
+      }
+    } else {
+      double value = real_value;
+      if (kind == Kind::Unsigned) {
+        value = static_cast<double>(unsigned_value);
+      } else if (kind == Kind::Signed) {
+        value = static_cast<double>(signed_value);
+      }
+      if constexpr (std::is_same_v<T, fp16>) {
+        return fp16{static_cast<float>(value)};
+      } else {
+        return static_cast<T>(value);
+      }
+    }
+  }
+};
+
+/**
+ * @brief An on-demand cursor over a JSON document. Values are parsed as the
+ * caller asks for them so no intermediate representation is built.
+ */
+class JsonCursor {
+ public:
+  explicit JsonCursor(std::string_view json) : json_(json) {}
+
+  /// Get the next non-whitespace character without consuming it
+  char peek() {
+    skipWhitespace();
+    if (index_ >= json_.size()) {
+      throw invalid_argument("Unexpected end of JSON in request");
+    }
+    return json_[index_];
+  }
+
+  /// Consume the next non-whitespace character if it matches
+  bool consume(char c) {
+    if (peek() == c) {
+      index_++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c)) {
+      throw invalid_argument(std::string{"Expected '"} + c +
+                             "' in JSON request");
+    }
+  }
+
+  void expectEnd() {
+    skipWhitespace();
+    if (index_ != json_.size()) {
+      throw invalid_argument("Unexpected characters after the JSON request");
+    }
+  }
+
+  [[nodiscard]] size_t position() const { return index_; }
+  [[nodiscard]] std::string_view since(size_t start) const {
+    return json_.substr(start, index_ - start);
+  }
+
+  /// Call f(key) for each member of an object. f must consume the value.
+  template <typename F>
+  void forEachMember(F f) {
+    expect('{');
+    if (consume('}')) {
+      return;
+    }
+    do {
+      std::string scratch;
+      auto key = parseString(&scratch);
+      expect(':');
+      f(key);
+    } while (consume(','));
+    expect('}');
+  }
+
+  /// Call f() for each element of an array. f must consume the element.
+  template <typename F>
+  void forEachElement(F f) {
+    expect('[');
+    if (consume(']')) {
+      return;
+    }
+    do {
+      f();
+    } while (consume(','));
+    expect(']');
+  }
+
+  /**
+   * @brief Parse a string. If it has no escapes, the returned view points into
+   * the JSON directly. Otherwise, it's decoded into scratch.
+   */
+  std::string_view parseString(std::string *scratch) {
+    expect('"');
+    const auto start = index_;
+    while (index_ < json_.size()) {
+      const auto c = json_[index_];
+      if (c == '"') {
+        return json_.substr(start, index_++ - start);
+      }
+      if (c == '\\') {
+        scratch->assign(json_.data() + start, index_ - start);
+        return parseEscapedString(scratch);
+      }
+      index_++;
+    }
+    throw invalid_argument("Unterminated string in JSON request");
+  }
+
+  JsonNumber parseNumber() {
+    skipWhitespace();
+    const auto start = index_;
+    bool integer = true;
+    if (index_ < json_.size() && json_[index_] == '-') {
+      index_++;
+    }
+    while (index_ < json_.size()) {
+      const auto c = json_[index_];
+      if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+        integer = false;
+      } else if (c < '0' || c > '9') {
+        break;
+      }
+      index_++;
+    }
+    const auto token = since(start);
+    if (token.empty() || token == "-") {
+      throw invalid_argument("Expected a number in JSON request");
+    }
+
+    JsonNumber number;
+    const auto *begin = token.data();
+    const auto *end = token.data() + token.size();
+    if (integer) {
+      if (token[0] == '-') {
+        number.kind = JsonNumber::Kind::Signed;
+        auto [ptr, ec] = std::from_chars(begin, end, number.signed_value);
+        if (ec == std::errc() && ptr == end) {
+          return number;
+        }
+      } else {
+        number.kind = JsonNumber::Kind::Unsigned;
+        auto [ptr, ec] = std::from_chars(begin, end, number.unsigned_value);
+        if (ec == std::errc() && ptr == end) {
+          return number;
+        }
+      }
+    }
+
+    // floating-point std::from_chars isn't available in all supported
+    // compilers so copy the token to get a null-terminated string for strtod
+    const std::string str{token};
+    char *parsed_end = nullptr;
+    number.kind = JsonNumber::Kind::Real;
+    number.real_value = std::strtod(str.c_str(), &parsed_end);
+    if (parsed_end != str.c_str() + str.size()) {
+      throw invalid_argument("Invalid number in JSON request");
+    }
+    return number;
+  }
+
+  bool parseBool() {
+    if (matchLiteral("true")) {
+      return true;
+    }
+    if (matchLiteral("false")) {
+      return false;
+    }
+    throw invalid_argument("Expected a boolean in JSON request");
+  }
+
+  /// Skip over the next value of any type
+  void skipValue() {
+    switch (peek()) {
+      case '{':
+        forEachMember([this](std::string_view) { skipValue(); });
+        break;
+      case '[':
+        forEachElement([this]() { skipValue(); });
+        break;
+      case '"': {
+        std::string scratch;
+        parseString(&scratch);
+        break;
+      }
+      case 't':
+      case 'f':
+        parseBool();
+        break;
+      case 'n':
+        if (!matchLiteral("null")) {
+          throw invalid_argument("Invalid value in JSON request");
+        }
+        break;
+      default:
+        parseNumber();
+    }
+  }
+
+ private:
+  void skipWhitespace() {
+    while (index_ < json_.size()) {
+      const auto c = json_[index_];
+      if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+        break;
+      }
+      index_++;
+    }
+  }
+
+  bool matchLiteral(std::string_view literal) {
+    skipWhitespace();
+    if (json_.substr(index_, literal.size()) == literal) {
+      index_ += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  uint32_t parseHex() {
+    if (index_ + 4 > json_.size()) {
+      throw invalid_argument("Invalid unicode escape in JSON request");
+    }
+    uint32_t value = 0;
+    const auto *begin = json_.data() + index_;
+    auto [ptr, ec] = std::from_chars(begin, begin + 4, value, 16);
+    if (ec != std::errc() || ptr != begin + 4) {
+      throw invalid_argument("Invalid unicode escape in JSON request");
+    }
+    index_ += 4;
+    return value;
+  }
+
+  static void appendUtf8(std::string *str, uint32_t code_point) {
+    // NOLINTBEGIN(readability-magic-numbers)
+    if (code_point < 0x80) {
+      str->push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+      str->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+      str->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+      str->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+      str->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+      str->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+      str->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+      str->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+      str->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+      str->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    // NOLINTEND(readability-magic-numbers)
+  }
+
+  std::string_view parseEscapedString(std::string *str) {
+    while (index_ < json_.size()) {
+      const auto c = json_[index_++];
+      if (c == '"') {
+        return *str;
+      }
+      if (c != '\\') {
+        str->push_back(c);
+        continue;
+      }
+      if (index_ >= json_.size()) {
+        break;
+      }
+      switch (json_[index_++]) {
+        case '"':
+          str->push_back('"');
+          break;
+        case '\\':
+          str->push_back('\\');
+          break;
+        case '/':
+          str->push_back('/');
+          break;
+        case 'b':
+          str->push_back('\b');
+          break;
+        case 'f':
+          str->push_back('\f');
+          break;
+        case 'n':
+          str->push_back('\n');
+          break;
+        case 'r':
+          str->push_back('\r');
+          break;
+        case 't':
+          str->push_back('\t');
+          break;
+        case 'u': {
+          // NOLINTBEGIN(readability-magic-numbers)
+          auto code_point = parseHex();
+          if (code_point >= 0xD800 && code_point < 0xDC00 &&
+              matchLiteral("\\u")) {
+            const auto low = parseHex();
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          }
+          // NOLINTEND(readability-magic-numbers)
+          appendUtf8(str, code_point);
+          break;
+        }
+        default:
+          throw invalid_argument("Invalid escape in JSON request");
+      }
+    }
+    throw invalid_argument("Unterminated string in JSON request");
+  }
+
+  std::string_view json_;
+  size_t index_ = 0;
+};
+
+ParameterMap parseParameters(JsonCursor *cursor) {
+  ParameterMap parameters;
+  cursor->forEachMember([&](std::string_view key_view) {
+    const std::string key{key_view};
+    switch (cursor->peek()) {
+      case '"': {
+        std::string scratch;
+        parameters.put(key, std::string{cursor->parseString(&scratch)});
+        break;
+      }
+      case 't':
+      case 'f':
+        parameters.put(key, cursor->parseBool());
+        break;
+      case '{':
+      case '[':
+      case 'n':
+        throw invalid_argument("Unknown parameter type, skipping");
+      default: {
+        // match the JSON path: non-negative integers are ints, others doubles
+        const auto number = cursor->parseNumber();
+        if (number.kind == JsonNumber::Kind::Unsigned &&
+            number.unsigned_value <=
+              static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+          parameters.put(key, static_cast<int32_t>(number.unsigned_value));
+        } else {
+          parameters.put(key, number.as<double>());
+        }
+      }
+    }
+  });
+  return parameters;
+}
+
+/// Decodes the elements of a data array into a typed buffer
+struct DecodeData {
+  template <typename T>
+  void operator()(JsonCursor *cursor, std::byte *data, size_t size) const {
+    if constexpr (std::is_same_v<T, char>) {
+      auto *dst = reinterpret_cast<char *>(data);
+      size_t offset = 0;
+      // strings with escapes are unescaped into one scratch string that's
+      // reused for all the elements
+      std::string scratch;
+      cursor->forEachElement([&]() {
+        const auto str = cursor->parseString(&scratch);
+        if (offset + str.size() > size) {
+          throw invalid_argument("Input data is larger than its shape");
+        }
+        std::memcpy(dst + offset, str.data(), str.size());
+        offset += str.size();
+        // match Buffer::write by null-terminating strings if there's space
+        if (offset < size) {
+          dst[offset++] = '\0';
+        }
+      });
+      // zero the rest so BytesView reads it as padding and not as elements
+      std::memset(dst + offset, 0, size - offset);
+    } else if constexpr (util::is_any_v<T, fp16, bf16>) {
+      // parse floats and convert them together instead of one at a time
+      std::vector<float> floats(size);
+      size_t count = 0;
+      decode<float>(cursor, floats.data(), size, &count);
+      if (count != size) {
+        throw invalid_argument("Input data does not match its shape");
+      }
+      if constexpr (std::is_same_v<T, fp16>) {
+        util::convertFp32ToFp16(floats.data(), reinterpret_cast<fp16 *>(data),
+                                size);
+      } else {
+        util::convertFp32ToBf16(floats.data(), reinterpret_cast<bf16 *>(data),
+                                size);
+      }
+    } else {
+      auto *dst = reinterpret_cast<T *>(data);
+      size_t count = 0;
+      decode<T>(cursor, dst, size, &count);
+      if (count != size) {
+        throw invalid_argument("Input data does not match its shape");
+      }
+    }
+  }
+
+ private:
+  // nested arrays are flattened in row-major order
+  template <typename T>
+  static void decode(JsonCursor *cursor, T *dst, size_t size, size_t *count) {
+    cursor->forEachElement([&]() {
+      const auto c = cursor->peek();
+      if (c == '[') {
+        decode<T>(cursor, dst, size, count);
+        return;
+      }
+      if (*count >= size) {
+        throw invalid_argument("Input data does not match its shape");
+      }
+      JsonNumber number;
+      if (c == 't' || c == 'f') {
+        number.unsigned_value = cursor->parseBool() ? 1 : 0;
+      } else {
+        number = cursor->parseNumber();
+      }
+      dst[(*count)++] = number.as<T>();
+    });
+  }
+};
+
+void decodeData(JsonCursor *cursor, Buffer *buffer,
+                const InferenceRequestInput &input) {
+  switchOverTypes(DecodeData(), input.getDatatype(), cursor,
+                  static_cast<std::byte *>(buffer->data(0)), input.getSize());
+}
+
+size_t getBinaryDataSize(const ParameterMap &parameters) {
+  try {
+    return static_cast<size_t>(parameters.get<int32_t>(kBinaryDataSize));
+  } catch (const std::bad_variant_access &) {
+    throw invalid_argument("'binary_data_size' must be a non-negative int");
+  }
+}
+
+InferenceRequestInput parseInput(JsonCursor *cursor, const MemoryPool *pool,
+                                 std::string_view *binary) {
+  InferenceRequestInput input;
+  input.setData(nullptr);
+
+  bool has_name = false;
+  bool has_shape = false;
+  bool has_datatype = false;
+  bool has_data = false;
+  // the data is decoded in place if the shape and datatype come first
+  // (the usual order). Otherwise, it's decoded after the whole input is read
+  std::string_view deferred_data;
+  BufferPtr buffer;
+
+  const auto allocate = [&]() {
+    if (buffer == nullptr) {
+      buffer = pool->get({MemoryAllocators::Cpu}, input, 1);
+      input.setData(buffer->data(0));
+    }
+  };
+
+  cursor->forEachMember([&](std::string_view key) {
+    if (key == "name") {
+      std::string scratch;
+      input.setName(std::string{cursor->parseString(&scratch)});
+      has_name = true;
+    } else if (key == "shape") {
+      Shape shape;
+      cursor->forEachElement([&]() {
+        const auto number = cursor->parseNumber();
+        if (number.kind != JsonNumber::Kind::Unsigned) {
+          throw invalid_argument(
+            "'shape' must be specified by uint64 elements");
+        }
+        shape.push_back(static_cast<int64_t>(number.unsigned_value));
+      });
+      input.setShape(std::move(shape));
+      has_shape = true;
+    } else if (key == "datatype") {
+      std::string scratch;
+      const std::string datatype{cursor->parseString(&scratch)};
+      input.setDatatype(DataType(datatype.c_str()));
+      has_datatype = true;
+    } else if (key == "parameters") {
+      input.setParameters(parseParameters(cursor));
+    } else if (key == "data") {
+      has_data = true;
+      if (has_shape && has_datatype) {
+        allocate();
+        decodeData(cursor, buffer.get(), input);
+      } else {
+        const auto start = cursor->position();
+        cursor->skipValue();
+        deferred_data = cursor->since(start);
+      }
+    } else {
+      cursor->skipValue();
+    }
+  });
+
+  if (!has_name) {
+    throw invalid_argument("No 'name' key present in request input");
+  }
+  if (!has_shape) {
+    throw invalid_argument("No 'shape' key present in request input");
+  }
+  if (!has_datatype) {
+    throw invalid_argument("No 'datatype' key present in request input");
+  }
+
+  const auto &parameters = input.getParameters();
+  if (isInSharedMemory(parameters)) {
+    // the data is read from the region once the request is parsed
+    if (has_data || parameters.has(kBinaryDataSize)) {
+      throw invalid_argument("Input " + input.getName() +
+                             " in shared memory cannot also have data");
+    }
+    return input;
+  }
+  if (parameters.has(kBinaryDataSize)) {
+    const auto size = getBinaryDataSize(parameters);
+    if (size != input.getSize() * input.getDatatype().size()) {
+      throw invalid_argument("'binary_data_size' of input " + input.getName() +
+                             " does not match its shape and datatype");
+    }
+    if (size > binary->size()) {
+      throw invalid_argument("Not enough binary data for input " +
+                             input.getName());
+    }
+    allocate();
+    std::memcpy(buffer->data(0), binary->data(), size);
+    countCopy(size);
+    binary->remove_prefix(size);
+    return input;
+  }
+
+  if (!has_data) {
+    throw invalid_argument("No 'data' key present in request input");
+  }
+  if (!deferred_data.empty()) {
+    allocate();
+    JsonCursor data_cursor{deferred_data};
+    decodeData(&data_cursor, buffer.get(), input);
+    countCopy(input.getSize() * input.getDatatype().size());
+  }
+  return input;
+}
+
+InferenceRequestOutput parseOutput(JsonCursor *cursor) {
+  InferenceRequestOutput output;
+  output.setData(nullptr);
+  cursor->forEachMember([&](std::string_view key) {
+    if (key == "name") {
+      std::string scratch;
+      output.setName(std::string{cursor->parseString(&scratch)});
+    } else if (key == "parameters") {
+      output.setParameters(parseParameters(cursor));
+    } else {
+      cursor->skipValue();
+    }
+  });
+  return output;
+}
+
+/**
+ * @brief Parse one inference request object. If model isn't null, the
+ * request's "model_name" and "model_version" keys are parsed into it too.
+ *
+ * @param cursor cursor at the start of the request object
+ * @param pool the memory pool to allocate input buffers from
+ * @param binary raw input data that's left. The data of the request's inputs
+ * is removed from its start
+ * @param model [out] the request's model
+ * @return InferenceRequestPtr
+ */
+InferenceRequestPtr parseRequest(JsonCursor *cursor, const MemoryPool *pool,
+                                 std::string_view *binary,
+                                 ModelRequest *model) {
+  auto request = std::make_shared<InferenceRequest>();
+  request->setID("");
+  request->setCallback(nullptr);
+
+  bool has_inputs = false;
+  cursor->forEachMember([&](std::string_view key) {
+    if (key == "id") {
+      std::string scratch;
+      request->setID(cursor->parseString(&scratch));
+    } else if (key == "parameters") {
+      request->setParameters(parseParameters(cursor));
+    } else if (key == "inputs") {
+      if (cursor->peek() != '[') {
+        throw invalid_argument("'inputs' is not an array");
+      }
+      cursor->forEachElement([&]() {
+        if (cursor->peek() != '{') {
+          throw invalid_argument(
+            "At least one element in 'inputs' is not an obj");
+        }
+        request->addInputTensor(parseInput(cursor, pool, binary));
+      });
+      has_inputs = true;
+    } else if (key == "outputs") {
+      cursor->forEachElement(
+        [&]() { request->addOutputTensor(parseOutput(cursor)); });
+    } else if (model != nullptr && key == "model_name") {
+      std::string scratch;
+      model->model = cursor->parseString(&scratch);
+    } else if (model != nullptr && key == "model_version") {
+      std::string scratch;
+      model->version = cursor->parseString(&scratch);
+    } else {
+      cursor->skipValue();
+    }
+  });
+
+  if (!has_inputs) {
+    throw invalid_argument("No 'inputs' key present in request");
+  }
+  return request;
+}
+
+}  // namespace
+
+InferenceRequestPtr parseJsonRequest(std::string_view json,
+                                     const MemoryPool *pool,
+                                     std::string_view binary) {
+  JsonCursor cursor{json};
+  auto request = parseRequest(&cursor, pool, &binary, nullptr);
+  cursor.expectEnd();
+
+  if (!binary.empty()) {
+    throw invalid_argument("Binary data in the request is not used by inputs");
+  }
+  return request;
+}
+
+std::vector<ModelRequest> parseJsonRequests(std::string_view json,
+                                            const MemoryPool *pool,
+                                            std::string_view binary) {
+  std::vector<ModelRequest> requests;
+
+  JsonCursor cursor{json};
+  bool has_requests = false;
+  cursor.forEachMember([&](std::string_view key) {
+    if (key != "requests") {
+      cursor.skipValue();
+      return;
+    }
+    if (cursor.peek() != '[') {
+      throw invalid_argument("'requests' is not an array");
+    }
+    cursor.forEachElement([&]() {
+      if (cursor.peek() != '{') {
+        throw invalid_argument(
+          "At least one element in 'requests' is not an obj");
+      }
+      const auto start = cursor.position();
+      const auto binary_size = binary.size();
+      auto &model = requests.emplace_back();
+      model.request = parseRequest(&cursor, pool, &binary, &model);
+      if (model.model.empty()) {
+        throw invalid_argument("No 'model_name' key present in request");
+      }
+      model.bytes =
+        cursor.since(start).size() + (binary_size - binary.size());
+    });
+    has_requests = true;
+  });
+  cursor.expectEnd();
+
+  if (!has_requests) {
+    throw invalid_argument("No 'requests' key present in request");
+  }
+  if (!binary.empty()) {
+    throw invalid_argument("Binary data in the request is not used by inputs");
+  }
+  return requests;
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,80 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the fast parser for JSON inference requests
+ */
+
+#ifndef GUARD_AMDINFER_SERVERS_JSON_REQUEST
+#define GUARD_AMDINFER_SERVERS_JSON_REQUEST
+
+#include <cstddef>      // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/declarations.hpp"  // for InferenceRequestPtr
+
+namespace amdinfer {
+
+class MemoryPool;
+
+/**
+ * @brief Parse a KServe JSON inference request directly into a request object.
+ *
+ * @details Unlike going through a Json::Value, this parser makes a single pass
+ * over the body without building a DOM. The elements of each input's data
+ * array are decoded straight into a buffer from the pool based on the input's
+ * datatype and shape. If the data array comes before the datatype or shape in
+ * an input, it is skipped and decoded once the input has been read.
+ *
+ * @param json the JSON body of the request
+ * @param pool the memory pool to allocate input buffers from
+ * @param binary raw input data following the JSON header if the request uses
+ * the binary tensor data extension
+ * @return InferenceRequestPtr
+ */
+InferenceRequestPtr parseJsonRequest(std::string_view json,
+                                     const MemoryPool *pool,
+                                     std::string_view binary = {});
+
+/// One of the requests in a body of many requests and the model it's for
+struct ModelRequest {
+  std::string model;
+  std::string version;
+  InferenceRequestPtr request;
+  /// size of the request in the body, including its binary data
+  size_t bytes = 0;
+};
+
+/**
+ * @brief Parse a JSON body of many inference requests, which may be for
+ * different models. The body is an object whose "requests" key is an array of
+ * KServe inference requests, each with a "model_name" key and optionally a
+ * "model_version" key. With the binary tensor data extension, the raw data of
+ * the inputs of all the requests follows the JSON in order.
+ *
+ * @param json the JSON body of the requests
+ * @param pool the memory pool to allocate input buffers from
+ * @param binary raw input data following the JSON header
+ * @return std::vector<ModelRequest>
+ */
+std::vector<ModelRequest> parseJsonRequests(std::string_view json,
+                                            const MemoryPool *pool,
+                                            std::string_view binary = {});
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_SERVERS_JSON_REQUEST
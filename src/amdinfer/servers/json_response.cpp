@@ -0,0 +1,310 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the serializer for JSON inference responses
+ */
+
+#include "amdinfer/servers/json_response.hpp"
+
+#include <array>        // for array
+#include <charconv>     // for to_chars
+#include <cmath>        // for isfinite, isnan
+#include <cstdint>      // for int64_t
+#include <cstdio>       // for snprintf
+#include <cstring>      // for memcpy
+#include <limits>       // for numeric_limits
+#include <string_view>  // for string_view
+#include <type_traits>  // for is_same_v, is_integral_v
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "amdinfer/clients/http_internal.hpp"    // for kBinaryDataSize
+#include "amdinfer/core/data_types.hpp"          // for DataType, switchOver...
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/shared_memory.hpp"       // for isInSharedMemory
+#include "amdinfer/util/float_convert.hpp"       // for convertFp16ToFp32
+#include "amdinfer/util/traits.hpp"              // for is_any_v
+
+namespace amdinfer {
+
+namespace {
+
+/// Upper bound on the characters needed to format one element of a type
+template <typename T>
+constexpr size_t maxChars() {
+  if constexpr (std::is_same_v<T, bool>) {
+    return sizeof("false");
+  } else if constexpr (std::is_integral_v<T>) {
+    // digits10 is one less than the most digits a value can have
+    return std::numeric_limits<T>::digits10 + 3;
+  } else if constexpr (std::is_same_v<T, double>) {
+    return 32;  // NOLINT(readability-magic-numbers)
+  } else {
+    // floats and fp16 and bf16, which are formatted as floats
+    return 24;  // NOLINT(readability-magic-numbers)
+  }
+}
+
+/**
+ * @brief Format a value at first. There must be at least maxChars<T>() bytes
+ * available.
+ *
+ * @return char* the end of the formatted value
+ */
+template <typename T>
+char *format(char *first, char *last, T value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    const std::string_view str = value ? "true" : "false";
+    std::memcpy(first, str.data(), str.size());
+    return first + str.size();
+  } else if constexpr (std::is_integral_v<T>) {
+    return std::to_chars(first, last, value).ptr;
+  } else if constexpr (util::is_any_v<T, fp16, bf16>) {
+    return format(first, last, static_cast<float>(value));
+  } else {
+    // match jsoncpp's handling of non-finite values since JSON has none
+    std::string_view special;
+    if (std::isnan(value)) {
+      special = "null";
+    } else if (!std::isfinite(value)) {
+      special = value > 0 ? "1e+9999" : "-1e+9999";
+    }
+    if (!special.empty()) {
+      std::memcpy(first, special.data(), special.size());
+      return first + special.size();
+    }
+#ifdef __cpp_lib_to_chars
+    // gives the shortest representation that round-trips
+    return std::to_chars(first, last, value).ptr;
+#else
+    const auto written =
+      std::snprintf(first, static_cast<size_t>(last - first), "%.*g",
+                    std::numeric_limits<T>::max_digits10, value);
+    return first + written;
+#endif
+  }
+}
+
+class JsonWriter {
+ public:
+  explicit JsonWriter(size_t capacity) { out_.reserve(capacity); }
+
+  void raw(std::string_view str) { out_.append(str); }
+
+  void string(std::string_view str) {
+    out_.push_back('"');
+    for (const auto c : str) {
+      switch (c) {
+        case '"':
+          out_.append("\\\"");
+          break;
+        case '\\':
+          out_.append("\\\\");
+          break;
+        case '\b':
+          out_.append("\\b");
+          break;
+        case '\f':
+          out_.append("\\f");
+          break;
+        case '\n':
+          out_.append("\\n");
+          break;
+        case '\r':
+          out_.append("\\r");
+          break;
+        case '\t':
+          out_.append("\\t");
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < ' ') {
+            std::array<char, sizeof("\\u0000")> escaped{};
+            std::snprintf(escaped.data(), escaped.size(), "\\u%04x",
+                          static_cast<unsigned int>(c));
+            out_.append(escaped.data(), escaped.size() - 1);
+          } else {
+            out_.push_back(c);
+          }
+      }
+    }
+    out_.push_back('"');
+  }
+
+  template <typename T>
+  void number(T value) {
+    std::array<char, maxChars<T>()> buffer{};
+    auto *end = format(buffer.data(), buffer.data() + buffer.size(), value);
+    out_.append(buffer.data(), end);
+  }
+
+  /// Write a flat array, formatting the elements in place in the output
+  template <typename T>
+  void array(const T *data, size_t count) {
+    const auto start = out_.size();
+    out_.resize(start + 2 + (count * (maxChars<T>() + 1)));
+    auto *ptr = out_.data() + start;
+    auto *last = out_.data() + out_.size();
+    *ptr++ = '[';
+    for (auto i = 0U; i < count; ++i) {
+      if (i != 0) {
+        *ptr++ = ',';
+      }
+      ptr = format(ptr, last, data[i]);
+    }
+    *ptr++ = ']';
+    out_.resize(ptr - out_.data());
+  }
+
+  [[nodiscard]] size_t size() const { return out_.size(); }
+  std::string take() { return std::move(out_); }
+
+ private:
+  std::string out_;
+};
+
+// a character that must be escaped is written as \u00XX
+constexpr size_t kMaxEscapedChars = 6;
+
+struct EstimateSize {
+  template <typename T>
+  size_t operator()(size_t count) const {
+    if constexpr (std::is_same_v<T, char>) {
+      // worst case: every character is escaped
+      return (count * kMaxEscapedChars) + 4;
+    } else {
+      return (count * (maxChars<T>() + 1)) + 2;
+    }
+  }
+};
+
+struct WriteData {
+  template <typename T>
+  void operator()(JsonWriter *writer, const void *data, size_t count) const {
+    if constexpr (std::is_same_v<T, char>) {
+      writer->raw("[");
+      writer->string({static_cast<const char *>(data), count});
+      writer->raw("]");
+    } else if constexpr (util::is_any_v<T, fp16, bf16>) {
+      // convert the whole output to floats first instead of one at a time
+      std::vector<float> floats(count);
+      if constexpr (std::is_same_v<T, fp16>) {
+        util::convertFp16ToFp32(static_cast<const fp16 *>(data), floats.data(),
+                                count);
+      } else {
+        util::convertBf16ToFp32(static_cast<const bf16 *>(data), floats.data(),
+                                count);
+      }
+      writer->array(floats.data(), count);
+    } else {
+      writer->array(static_cast<const T *>(data), count);
+    }
+  }
+};
+
+// space for the keys and punctuation that surround the values
+constexpr size_t kResponseOverhead = 64;
+constexpr size_t kOutputOverhead = 128;
+
+}  // namespace
+
+std::string serializeJsonResponse(const InferenceResponse &response,
+                                  const BinaryOutputs &binary_outputs,
+                                  size_t *header_length) {
+  const auto &outputs = response.getOutputs();
+  const auto model = response.getModel();
+  const auto id = response.getID();
+
+  size_t json_size =
+    kResponseOverhead + ((model.size() + id.size()) * kMaxEscapedChars);
+  size_t binary_size = 0;
+  for (const auto &output : outputs) {
+    json_size += kOutputOverhead +
+                 (output.getName().size() * kMaxEscapedChars) +
+                 (output.getShape().size() * (maxChars<int64_t>() + 1));
+    if (isInSharedMemory(output.getParameters())) {
+      const auto &parameters = output.getParameters();
+      json_size +=
+        parameters.get<std::string>(kSharedMemoryRegion).size() *
+        kMaxEscapedChars;
+    } else if (binary_outputs.contains(output.getName())) {
+      binary_size += output.getSize() * output.getDatatype().size();
+    } else {
+      json_size += switchOverTypes(EstimateSize(), output.getDatatype(),
+                                   output.getSize());
+    }
+  }
+
+  JsonWriter writer{json_size + binary_size};
+  writer.raw(R"({"model_name":)");
+  writer.string(model);
+  writer.raw(R"(,"id":)");
+  writer.string(id);
+  writer.raw(R"(,"outputs":[)");
+  for (auto i = 0U; i < outputs.size(); ++i) {
+    const auto &output = outputs[i];
+    if (i != 0) {
+      writer.raw(",");
+    }
+    writer.raw(R"({"name":)");
+    writer.string(output.getName());
+    writer.raw(R"(,"datatype":)");
+    writer.string(output.getDatatype().str());
+    writer.raw(R"(,"shape":)");
+    const auto &shape = output.getShape();
+    writer.array(shape.data(), shape.size());
+    if (isInSharedMemory(output.getParameters())) {
+      // the data was written to the region the request designated
+      const auto &parameters = output.getParameters();
+      writer.raw(R"(,"parameters":{")");
+      writer.raw(kSharedMemoryRegion);
+      writer.raw(R"(":)");
+      writer.string(parameters.get<std::string>(kSharedMemoryRegion));
+      writer.raw(R"(,")");
+      writer.raw(kSharedMemoryOffset);
+      writer.raw(R"(":)");
+      writer.number(getSharedMemorySize(parameters, kSharedMemoryOffset));
+      writer.raw(R"(,")");
+      writer.raw(kSharedMemoryByteSize);
+      writer.raw(R"(":)");
+      writer.number(getSharedMemorySize(parameters, kSharedMemoryByteSize));
+      writer.raw("}}");
+    } else if (binary_outputs.contains(output.getName())) {
+      writer.raw(R"(,"parameters":{")");
+      writer.raw(kBinaryDataSize);
+      writer.raw(R"(":)");
+      writer.number(output.getSize() * output.getDatatype().size());
+      writer.raw("}}");
+    } else {
+      writer.raw(R"(,"parameters":{},"data":)");
+      switchOverTypes(WriteData(), output.getDatatype(), &writer,
+                      output.getData(), output.getSize());
+      writer.raw("}");
+    }
+  }
+  writer.raw("]}");
+  *header_length = writer.size();
+
+  for (const auto &output : outputs) {
+    if (binary_outputs.contains(output.getName()) &&
+        !isInSharedMemory(output.getParameters())) {
+      writer.raw({static_cast<const char *>(output.getData()),
+                  output.getSize() * output.getDatatype().size()});
+    }
+  }
+  return writer.take();
+}
+
+}  // namespace amdinfer
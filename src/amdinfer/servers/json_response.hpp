@@ -0,0 +1,63 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the serializer for JSON inference responses
+ */
+
+#ifndef GUARD_AMDINFER_SERVERS_JSON_RESPONSE
+#define GUARD_AMDINFER_SERVERS_JSON_RESPONSE
+
+#include <cstddef>        // for size_t
+#include <string>         // for string
+#include <unordered_set>  // for unordered_set
+
+namespace amdinfer {
+
+class InferenceResponse;
+
+/// Tracks which outputs of a request should be returned as raw bytes
+struct BinaryOutputs {
+  bool all = false;
+  std::unordered_set<std::string> names;
+
+  [[nodiscard]] bool empty() const { return !all && names.empty(); }
+  [[nodiscard]] bool contains(const std::string &name) const {
+    return all || names.find(name) != names.end();
+  }
+};
+
+/**
+ * @brief Serialize a KServe inference response to a JSON body.
+ *
+ * @details The JSON is written directly to the returned string instead of
+ * building a Json::Value first. The string is sized up front from the outputs
+ * so it's not reallocated while the data is formatted. Outputs selected by
+ * binary_outputs don't have their data in the JSON. Instead, their raw bytes
+ * are appended after the JSON, in order, as in the binary tensor data
+ * extension.
+ *
+ * @param response the response to serialize
+ * @param binary_outputs the outputs to send as raw bytes
+ * @param header_length [out] the size of the JSON at the start of the body
+ * @return std::string
+ */
+std::string serializeJsonResponse(const InferenceResponse &response,
+                                  const BinaryOutputs &binary_outputs,
+                                  size_t *header_length);
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_SERVERS_JSON_RESPONSE
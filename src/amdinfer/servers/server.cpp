@@ -15,18 +15,29 @@
 
 #include "amdinfer/servers/server.hpp"
 
-#include <cstdlib>  // for getenv
-#include <string>   // for operator+, string
-#include <thread>   // for thread
+#include <chrono>         // for seconds
+#include <memory>         // for make_unique
+#include <cstdlib>        // for getenv
+#include <string>         // for operator+, string
+#include <thread>         // for thread
+#include <unordered_set>  // for unordered_set
+#include <utility>        // for move
+#include <vector>         // for vector
 
 #include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_HTTP
-#include "amdinfer/core/exceptions.hpp"          // for environment_not_set_e...
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument, env...
 #include "amdinfer/core/shared_state.hpp"        // for SharedState
+#include "amdinfer/core/worker_libraries.hpp"    // for WorkerLibraries
 #include "amdinfer/observation/logging.hpp"      // for initLogger, getLogDir...
+#include "amdinfer/observation/metrics.hpp"      // for Metrics
 #include "amdinfer/observation/tracing.hpp"      // for startOtlpTracer, st...
 #include "amdinfer/servers/grpc_server.hpp"      // for start, stop
 #include "amdinfer/servers/http_server.hpp"      // for stop, start
 #include "amdinfer/servers/server_internal.hpp"  // for ServerImpl
+#include "amdinfer/servers/supervisor.hpp"       // for MetricsPublisher
+#include "amdinfer/servers/uring_server.hpp"     // for start, stop
+#include "amdinfer/util/numa.hpp"                // for parseIdList, getThr...
+#include "amdinfer/util/string.hpp"              // for toLower
 
 #ifdef AMDINFER_ENABLE_AKS
 #include <aks/AksSysManagerExt.h>  // for SysManagerExt
@@ -83,17 +94,53 @@ Server::Server() {
 #endif
 }
 
+namespace {
+
+/// Keep the workers off the CPUs set aside for I/O unless they're already set
+[[maybe_unused]] void reserveIoCpus(const std::vector<int>& cpus,
+                                    bool worker_cpus_set, SharedState* state) {
+  if (cpus.empty() || worker_cpus_set) {
+    return;
+  }
+  std::vector<int> worker_cpus;
+  const std::unordered_set<int> reserved{cpus.begin(), cpus.end()};
+  for (auto cpu : util::getThreadCpus()) {
+    if (reserved.count(cpu) == 0) {
+      worker_cpus.push_back(cpu);
+    }
+  }
+  if (!worker_cpus.empty()) {
+    state->setWorkerCpus(worker_cpus);
+  }
+}
+
+}  // namespace
+
 Server::~Server() {
+  // let the libraries being preloaded finish opening
+  WorkerLibraries::getInstance().wait();
   impl_->state.workerUnload("responder");
   stopHttp();
   stopGrpc();
+  stopUring();
+  impl_->metrics_publisher.reset();
   terminate();
 }
 
-void Server::startHttp([[maybe_unused]] uint16_t port) const {
+void Server::startHttp([[maybe_unused]] uint16_t port,
+                       [[maybe_unused]] int threads,
+                       [[maybe_unused]] const std::string& cpus,
+                       [[maybe_unused]] int decode_threads) const {
 #ifdef AMDINFER_ENABLE_HTTP
   if (!impl_->http_started) {
-    impl_->http_thread = std::thread{http::start, &(impl_->state), port};
+    auto io_cpus = util::parseIdList(cpus);
+    if (!cpus.empty() && io_cpus.empty()) {
+      throw invalid_argument("Invalid CPU list for the HTTP server: " + cpus);
+    }
+    reserveIoCpus(io_cpus, impl_->worker_cpus_set, &(impl_->state));
+    impl_->http_thread =
+      std::thread{http::start, &(impl_->state), port, threads,
+                  std::move(io_cpus), decode_threads};
     impl_->http_started = true;
   }
 #endif
@@ -111,10 +158,58 @@ void Server::stopHttp() const {
 #endif
 }
 
-void Server::startGrpc([[maybe_unused]] uint16_t port) const {
+void Server::startUring([[maybe_unused]] uint16_t port,
+                        [[maybe_unused]] int threads,
+                        [[maybe_unused]] const std::string& cpus) const {
+#ifdef AMDINFER_ENABLE_IO_URING
+  if (!impl_->uring_started) {
+    auto io_cpus = util::parseIdList(cpus);
+    if (!cpus.empty() && io_cpus.empty()) {
+      throw invalid_argument("Invalid CPU list for the io_uring server: " +
+                             cpus);
+    }
+    reserveIoCpus(io_cpus, impl_->worker_cpus_set, &(impl_->state));
+    uring::start(&(impl_->state), port, threads, io_cpus);
+    impl_->uring_started = true;
+  }
+#endif
+}
+
+void Server::stopUring() const {
+#ifdef AMDINFER_ENABLE_IO_URING
+  if (impl_->uring_started) {
+    uring::stop();
+    impl_->uring_started = false;
+  }
+#endif
+}
+
+void Server::setWorkerCpus(const std::string& cpus) const {
+  auto worker_cpus = util::parseIdList(cpus);
+  if (worker_cpus.empty()) {
+    throw invalid_argument("Invalid CPU list for the workers: " + cpus);
+  }
+  impl_->state.setWorkerCpus(worker_cpus);
+  impl_->worker_cpus_set = true;
+}
+
+void Server::enableSharding(const fs::path& directory, int index) {
+  if (index < 0) {
+    throw invalid_argument("The shard index can't be negative");
+  }
+  impl_->state.setShard(index, directory);
+#ifdef AMDINFER_ENABLE_METRICS
+  impl_->metrics_publisher = std::make_unique<MetricsPublisher>(
+    getShardMetricsPath(directory, index),
+    []() { return Metrics::getInstance().getMetrics(); });
+#endif
+}
+
+void Server::startGrpc([[maybe_unused]] uint16_t port,
+                       [[maybe_unused]] const std::string& socket) const {
 #ifdef AMDINFER_ENABLE_GRPC
   if (!impl_->grpc_started) {
-    grpc::start(&(impl_->state), port);
+    grpc::start(&(impl_->state), port, socket);
     impl_->grpc_started = true;
   }
 #endif
@@ -138,4 +233,59 @@ void Server::enableRepositoryMonitoring(bool use_polling) {
   impl_->state.enableRepositoryMonitoring(use_polling);
 }
 
+void Server::enableLazyLoading(size_t memory_budget, int idle_timeout) {
+  if (idle_timeout < 0) {
+    throw invalid_argument("The idle timeout can't be negative");
+  }
+  impl_->state.enableLazyLoading(memory_budget,
+                                 std::chrono::seconds{idle_timeout});
+}
+
+void Server::enableLoadShedding(int target_latency, size_t max_inflight) {
+  if (target_latency < 0) {
+    throw invalid_argument("The target latency can't be negative");
+  }
+  impl_->state.enableLoadShedding(std::chrono::milliseconds{target_latency},
+                                  max_inflight);
+}
+
+void Server::enableRateLimiting(double rate, double burst,
+                                const std::string& tenant_key) {
+  if (rate <= 0) {
+    throw invalid_argument("The rate limit must be positive");
+  }
+  // HTTP headers are case-insensitive and gRPC metadata keys are lower-case
+  impl_->state.enableRateLimiting(rate, burst, util::toLower(tenant_key));
+}
+
+void Server::enableUsageAccounting(const std::string& tenant_key) {
+  impl_->state.enableUsageAccounting(util::toLower(tenant_key));
+}
+
+void Server::enableOverloadReadiness(double threshold,
+                                     double saturated_batches) {
+  if (threshold < 0) {
+    throw invalid_argument("The readiness threshold can't be negative");
+  }
+  if (saturated_batches <= 0) {
+    throw invalid_argument("The saturated queue depth must be positive");
+  }
+  impl_->state.enableOverloadReadiness(threshold, saturated_batches);
+}
+
+void Server::preloadWorkers(const std::vector<std::string>& workers) {
+  WorkerLibraries::getInstance().preload(workers);
+}
+
+void Server::enableManifest(const fs::path& path, bool restore) {
+  impl_->state.enableManifest(path, restore);
+}
+
+void Server::enableCapture(const fs::path& path, double rate, bool payload) {
+  if (rate <= 0 || rate > 1) {
+    throw invalid_argument("The capture rate must be in (0, 1]");
+  }
+  impl_->state.enableCapture(path, rate, payload);
+}
+
 }  // namespace amdinfer
@@ -16,12 +16,14 @@
 #ifndef GUARD_AMDINFER_SERVERS_SERVER_INTERNAL
 #define GUARD_AMDINFER_SERVERS_SERVER_INTERNAL
 
+#include <memory>
 #include <thread>
 
 #include "amdinfer/build_options.hpp"
 #include "amdinfer/core/model_repository.hpp"
 #include "amdinfer/core/shared_state.hpp"
 #include "amdinfer/servers/server.hpp"
+#include "amdinfer/servers/supervisor.hpp"
 
 namespace amdinfer {
 
@@ -33,7 +35,12 @@ struct Server::ServerImpl {
 #ifdef AMDINFER_ENABLE_GRPC
   bool grpc_started = false;
 #endif
+#ifdef AMDINFER_ENABLE_IO_URING
+  bool uring_started = false;
+#endif
+  bool worker_cpus_set = false;
   SharedState state;
+  std::unique_ptr<MetricsPublisher> metrics_publisher;
 };
 
 }  // namespace amdinfer
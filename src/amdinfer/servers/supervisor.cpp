@@ -0,0 +1,371 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the supervisor that runs several server processes on one
+ * host
+ */
+
+#include "amdinfer/servers/supervisor.hpp"
+
+#include <sys/wait.h>  // for waitpid, WNOHANG
+#include <unistd.h>    // for fork
+
+#include <algorithm>      // for find, min
+#include <cmath>          // for isnan, isinf
+#include <csignal>        // for sigset_t, sigtimedwait, kill, SIGCHLD
+#include <cstddef>        // for ptrdiff_t
+#include <cstdlib>        // for strtod
+#include <ctime>          // for timespec
+#include <exception>      // for exception
+#include <fstream>        // for ifstream, ofstream
+#include <iostream>       // for cout
+#include <iterator>       // for distance
+#include <limits>         // for numeric_limits
+#include <locale>         // for locale
+#include <optional>       // for optional
+#include <sstream>        // for istringstream, ostringstream
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move, pair
+
+#include "amdinfer/core/exceptions.hpp"      // for invalid_argument, runt...
+#include "amdinfer/observation/logging.hpp"  // for Logger, AMDINFER_LOG_...
+#include "amdinfer/util/artifact_cache.hpp"  // for publishArtifact
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+namespace {
+
+// shards that exit sooner than this after starting are assumed to be broken
+// and aren't restarted
+constexpr auto kMinUptime = std::chrono::seconds{10};
+constexpr auto kPublishInterval = std::chrono::seconds{1};
+
+std::string readFile(const fs::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// the file is replaced at once so readers never see part of it
+void writeFile(const fs::path& path, const std::string& contents) {
+  const auto temporary = util::getTemporaryPath(path);
+  {
+    std::ofstream file{temporary, std::ios::binary};
+    file << contents;
+  }
+  util::publishArtifact(temporary, path);
+}
+
+// find the brace that closes the labels of a sample, skipping quoted values
+size_t findLabelsEnd(std::string_view line, size_t open) {
+  bool quoted = false;
+  for (auto i = open + 1; i < line.size(); ++i) {
+    if (quoted && line[i] == '\\') {
+      ++i;
+    } else if (line[i] == '"') {
+      quoted = !quoted;
+    } else if (!quoted && line[i] == '}') {
+      return i + 1;
+    }
+  }
+  return std::string_view::npos;
+}
+
+std::string formatValue(double value) {
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+  std::ostringstream stream;
+  stream.imbue(std::locale::classic());
+  stream.precision(std::numeric_limits<double>::max_digits10 - 1);
+  stream << value;
+  return stream.str();
+}
+
+struct Family {
+  std::string help;
+  std::string type;
+  std::vector<std::pair<std::string, double>> samples;
+  std::unordered_map<std::string, size_t> index;
+
+  void add(const std::string& key, double value) {
+    auto [entry, added] = index.try_emplace(key, samples.size());
+    if (added) {
+      samples.emplace_back(key, value);
+      return;
+    }
+    auto& sample = samples[entry->second].second;
+    if (key.find("quantile=\"") != std::string::npos) {
+      // summaries with no observations have NaN quantiles
+      if (std::isnan(sample) || value > sample) {
+        sample = value;
+      }
+    } else {
+      sample += value;
+    }
+  }
+};
+
+}  // namespace
+
+std::vector<int> getShare(const std::vector<int>& ids, int index, int count) {
+  if (ids.empty() || count <= 0) {
+    return {};
+  }
+  const auto shards = static_cast<size_t>(count);
+  const auto shard = static_cast<size_t>(index);
+  if (ids.size() < shards) {
+    return {ids[shard % ids.size()]};
+  }
+  const auto size = ids.size() / shards;
+  const auto extra = ids.size() % shards;
+  const auto begin = shard * size + std::min(shard, extra);
+  const auto length = size + (shard < extra ? 1 : 0);
+  const auto first = ids.begin() + static_cast<std::ptrdiff_t>(begin);
+  return {first, first + static_cast<std::ptrdiff_t>(length)};
+}
+
+fs::path getShardMetricsPath(const fs::path& dir, int index) {
+  return dir / ("shard-" + std::to_string(index) + ".prom");
+}
+
+fs::path getMergedMetricsPath(const fs::path& dir) {
+  return dir / "metrics.prom";
+}
+
+std::string mergeMetrics(const std::vector<std::string>& texts) {
+  std::vector<Family> families;
+  std::unordered_map<std::string, size_t> names;
+  auto get_family = [&](const std::string& name) {
+    auto [entry, added] = names.try_emplace(name, families.size());
+    if (added) {
+      families.emplace_back();
+    }
+    return entry->second;
+  };
+
+  for (const auto& text : texts) {
+    std::istringstream stream{text};
+    std::string line;
+    // samples belong to the family declared last
+    std::optional<size_t> current;
+    while (std::getline(stream, line)) {
+      if (line.empty()) {
+        continue;
+      }
+      if (line[0] == '#') {
+        std::istringstream fields{line};
+        std::string hash;
+        std::string keyword;
+        std::string name;
+        fields >> hash >> keyword >> name;
+        if (keyword == "HELP" || keyword == "TYPE") {
+          current = get_family(name);
+          auto& declaration = keyword == "HELP" ? families[*current].help
+                                                : families[*current].type;
+          if (declaration.empty()) {
+            declaration = line;
+          }
+        }
+        continue;
+      }
+
+      auto end = line.find_first_of(" {");
+      if (end != std::string::npos && line[end] == '{') {
+        end = findLabelsEnd(line, end);
+      }
+      if (end == std::string::npos) {
+        continue;
+      }
+      const auto* value_begin = line.c_str() + end;
+      char* value_end = nullptr;
+      const auto value = std::strtod(value_begin, &value_end);
+      if (value_end == value_begin) {
+        continue;
+      }
+      // any timestamp is dropped since the samples are combined
+      auto key = line.substr(0, end);
+      if (!current.has_value()) {
+        current = get_family(key.substr(0, key.find('{')));
+      }
+      families[*current].add(key, value);
+    }
+  }
+
+  std::string merged;
+  for (const auto& family : families) {
+    for (const auto* declaration : {&family.help, &family.type}) {
+      if (!declaration->empty()) {
+        merged += *declaration + "\n";
+      }
+    }
+    for (const auto& [key, value] : family.samples) {
+      merged += key + " " + formatValue(value) + "\n";
+    }
+  }
+  return merged;
+}
+
+MetricsPublisher::MetricsPublisher(fs::path path,
+                                   std::function<std::string()> read)
+  : path_(std::move(path)),
+    read_(std::move(read)),
+    thread_(&MetricsPublisher::run, this) {}
+
+MetricsPublisher::~MetricsPublisher() {
+  {
+    const std::lock_guard lock{mutex_};
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+void MetricsPublisher::run() {
+  std::unique_lock lock{mutex_};
+  while (!stopping_) {
+    lock.unlock();
+    try {
+      writeFile(path_, read_());
+    } catch (const std::exception& e) {
+      AMDINFER_IF_LOGGING(Logger logger{Loggers::Server};)
+      AMDINFER_LOG_WARN(logger, e.what());
+    }
+    lock.lock();
+    cv_.wait_for(lock, kPublishInterval, [this]() { return stopping_; });
+  }
+}
+
+Supervisor::Supervisor(int count, fs::path directory)
+  : count_(count),
+    directory_(std::move(directory)),
+    pids_(count > 0 ? count : 0, -1),
+    starts_(pids_.size()) {
+  if (count <= 0) {
+    throw invalid_argument("The number of shards must be positive");
+  }
+}
+
+int Supervisor::run() {
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGCHLD);
+  // exited shards are waited for with the other signals
+  sigprocmask(SIG_BLOCK, &signals, nullptr);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+
+  for (auto i = 0; i < count_; ++i) {
+    if (start(i)) {
+      return i;
+    }
+  }
+
+  const timespec tick{std::chrono::seconds{kPublishInterval}.count(), 0};
+  while (true) {
+    const auto signal = sigtimedwait(&signals, nullptr, &tick);
+    if (signal == SIGINT || signal == SIGTERM) {
+      stop();
+      return -1;
+    }
+    if (signal == SIGCHLD) {
+      if (auto index = reap(); index >= 0) {
+        return index;
+      }
+    }
+    publishMetrics();
+  }
+}
+
+bool Supervisor::start(int index) {
+  // the shard would print whatever is still buffered again
+  std::cout.flush();
+  const auto pid = fork();
+  if (pid < 0) {
+    stop();
+    throw runtime_error("Could not start shard " + std::to_string(index));
+  }
+  if (pid == 0) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+    return true;
+  }
+  pids_[index] = pid;
+  starts_[index] = std::chrono::steady_clock::now();
+  std::cout << "Started shard " << index << " with PID " << pid << "\n";
+  return false;
+}
+
+int Supervisor::reap() {
+  pid_t pid = 0;
+  int status = 0;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    auto shard = std::find(pids_.begin(), pids_.end(), pid);
+    if (shard == pids_.end()) {
+      continue;
+    }
+    const auto index = static_cast<int>(std::distance(pids_.begin(), shard));
+    *shard = -1;
+    if (std::chrono::steady_clock::now() - starts_[index] < kMinUptime) {
+      stop();
+      throw runtime_error("Shard " + std::to_string(index) +
+                          " exited right after starting");
+    }
+    std::cout << "Shard " << index << " exited. Restarting it\n";
+    if (start(index)) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+void Supervisor::stop() {
+  for (const auto pid : pids_) {
+    if (pid > 0) {
+      kill(pid, SIGTERM);
+    }
+  }
+  for (auto& pid : pids_) {
+    if (pid > 0) {
+      waitpid(pid, nullptr, 0);
+      pid = -1;
+    }
+  }
+}
+
+void Supervisor::publishMetrics() const {
+  std::vector<std::string> texts;
+  for (auto i = 0; i < count_; ++i) {
+    const auto path = getShardMetricsPath(directory_, i);
+    if (fs::exists(path)) {
+      texts.push_back(readFile(path));
+    }
+  }
+  if (!texts.empty()) {
+    writeFile(getMergedMetricsPath(directory_), mergeMetrics(texts));
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,140 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the supervisor that runs several server processes on one host
+ * as shards that share the same ports
+ */
+
+#ifndef GUARD_AMDINFER_SERVERS_SUPERVISOR
+#define GUARD_AMDINFER_SERVERS_SUPERVISOR
+
+#include <sys/types.h>  // for pid_t
+
+#include <chrono>              // for steady_clock
+#include <condition_variable>  // for condition_variable
+#include <filesystem>          // for path
+#include <functional>          // for function
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <thread>              // for thread
+#include <vector>              // for vector
+
+namespace amdinfer {
+
+/**
+ * @brief Get the share of a list of IDs, such as CPUs or GPUs, that a shard
+ * owns. The IDs are split into contiguous slices that differ in size by one at
+ * most. If there are fewer IDs than shards, they're handed out round-robin
+ *
+ * @param ids the IDs to split
+ * @param index index of the shard
+ * @param count number of shards
+ * @return std::vector<int>
+ */
+std::vector<int> getShare(const std::vector<int>& ids, int index, int count);
+
+/// Get the path that a shard publishes its metrics to
+std::filesystem::path getShardMetricsPath(const std::filesystem::path& dir,
+                                          int index);
+/// Get the path that the supervisor publishes the merged metrics to
+std::filesystem::path getMergedMetricsPath(const std::filesystem::path& dir);
+
+/**
+ * @brief Merge metrics in the Prometheus text format from several shards so
+ * they read as one server's. Samples with the same name and labels are added
+ * up, except for the quantiles of summaries, which can't be added so the
+ * highest one is kept
+ *
+ * @param texts the metrics of each shard
+ * @return std::string
+ */
+std::string mergeMetrics(const std::vector<std::string>& texts);
+
+/**
+ * @brief Periodically publishes a shard's metrics for the supervisor to merge
+ */
+class MetricsPublisher {
+ public:
+  /**
+   * @brief Start publishing metrics
+   *
+   * @param path path to publish the metrics to
+   * @param read gets the metrics in the Prometheus text format
+   */
+  MetricsPublisher(std::filesystem::path path,
+                   std::function<std::string()> read);
+  ~MetricsPublisher();
+  MetricsPublisher(const MetricsPublisher&) = delete;
+  MetricsPublisher& operator=(const MetricsPublisher&) = delete;
+  MetricsPublisher(MetricsPublisher&&) = delete;
+  MetricsPublisher& operator=(MetricsPublisher&&) = delete;
+
+ private:
+  void run();
+
+  std::filesystem::path path_;
+  std::function<std::string()> read_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+/**
+ * @brief Runs several server processes, or shards, on one host. Each shard is
+ * a full server that owns a share of the host's CPUs and devices and listens
+ * on the same ports as the others with SO_REUSEPORT so the kernel spreads
+ * connections over them. The supervisor restarts shards that exit, merges
+ * their metrics and stops them when it's interrupted.
+ */
+class Supervisor {
+ public:
+  /**
+   * @brief Construct a new Supervisor object
+   *
+   * @param count number of shards to run
+   * @param directory directory that the shards and the supervisor exchange
+   * metrics in
+   */
+  Supervisor(int count, std::filesystem::path directory);
+
+  /**
+   * @brief Fork the shards and supervise them until SIGINT or SIGTERM is
+   * received. It must be called while the process has a single thread, with
+   * SIGINT and SIGTERM blocked. It returns in each shard, with the shard's
+   * index, and in the supervisor once the shards have stopped, with -1.
+   *
+   * @return int
+   */
+  int run();
+
+ private:
+  // returns true in the new shard
+  bool start(int index);
+  // returns the index of a restarted shard or -1
+  int reap();
+  void stop();
+  void publishMetrics() const;
+
+  int count_;
+  std::filesystem::path directory_;
+  std::vector<pid_t> pids_;
+  std::vector<std::chrono::steady_clock::time_point> starts_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_AMDINFER_SERVERS_SUPERVISOR
@@ -0,0 +1,756 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the io_uring server for the binary inference protocol.
+ * Each thread owns a ring that accepts, reads and writes its connections
+ * without a system call per operation. Inputs are received straight into
+ * their pooled buffers and outputs are sent from wherever they are.
+ */
+
+#include "amdinfer/servers/uring_server.hpp"
+
+#include <liburing.h>     // for io_uring_get_sqe, io_uring_prep_recv, ...
+#include <netinet/in.h>   // for sockaddr_in, htons, INADDR_ANY, IPPROTO_TCP
+#include <netinet/tcp.h>  // for TCP_NODELAY
+#include <sys/eventfd.h>  // for eventfd, EFD_CLOEXEC
+#include <sys/socket.h>   // for socket, bind, listen, setsockopt, shutdown
+#include <sys/uio.h>      // for iovec
+#include <unistd.h>       // for close, write
+
+#include <algorithm>      // for min
+#include <atomic>         // for atomic_bool
+#include <cerrno>         // for errno
+#include <climits>        // for IOV_MAX
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint64_t
+#include <cstring>        // for memcpy, memmove, strerror
+#include <deque>          // for deque
+#include <exception>      // for exception
+#include <memory>         // for shared_ptr, unique_ptr, weak_ptr
+#include <mutex>          // for mutex, lock_guard
+#include <string>         // for string
+#include <string_view>    // for string_view
+#include <thread>         // for thread
+#include <unordered_map>  // for unordered_map
+#include <unordered_set>  // for unordered_set
+#include <utility>        // for move, exchange
+#include <vector>         // for vector
+
+#include "amdinfer/buffers/buffer.hpp"           // for Buffer
+#include "amdinfer/core/admission.hpp"           // for holdTicket
+#include "amdinfer/core/binary_protocol.hpp"     // for parseBinaryPrefix
+#include "amdinfer/core/completion_router.hpp"   // for CompletionExecutor
+#include "amdinfer/core/exceptions.hpp"          // for runtime_error
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"     // for MemoryPool
+#include "amdinfer/core/request_container.hpp"   // for makeRequestContainer
+#include "amdinfer/core/shared_state.hpp"        // for SharedState
+#include "amdinfer/observation/logging.hpp"      // for Logger, AMDINFER_LOG...
+#include "amdinfer/util/numa.hpp"                // for getNumaNodes
+#include "amdinfer/util/thread.hpp"              // for setThreadName
+
+namespace amdinfer {
+
+namespace {
+
+// entries in each ring's submission queue
+constexpr unsigned kQueueDepth = 512;
+// initial size of each connection's read buffer. It grows to fit larger
+// headers
+constexpr size_t kReadSize = 64 * 1024;
+// smaller responses are copied by the kernel faster than their pages can be
+// pinned for a zero-copy send
+constexpr size_t kZeroCopySize = 16 * 1024;
+constexpr int kBacklog = 1024;
+
+std::string errorString(int error) { return std::strerror(error); }
+
+/// Return the memory of a request's inputs if it never reached a batcher
+void releaseInputs(const InferenceRequest* request, const MemoryPool* pool) {
+  if (request == nullptr) {
+    return;
+  }
+  for (const auto& input : request->getInputs()) {
+    if (input.getData() != nullptr) {
+      pool->put(MemoryAllocators::Cpu, input.getData());
+    }
+  }
+}
+
+/// The tenant of a binary request is the parameter named by the tenant key
+std::string getTenant(const InferenceRequest& request, const std::string& key) {
+  const auto& parameters = request.getParameters();
+  if (key.empty() || !parameters.has(key)) {
+    return "";
+  }
+  return parameters.get<std::string>(key);
+}
+
+/**
+ * @brief Mark the first bytes of the parts as done, dropping the parts that
+ * are finished
+ *
+ * @param parts the parts, none of which are empty
+ * @param next index of the first part that isn't done
+ * @param done number of bytes done
+ * @return bool true if all the parts are done
+ */
+bool advance(std::vector<iovec>* parts, size_t* next, size_t done) {
+  while (*next < parts->size() && done >= (*parts)[*next].iov_len) {
+    done -= (*parts)[*next].iov_len;
+    ++*next;
+  }
+  if (*next < parts->size()) {
+    auto& part = (*parts)[*next];
+    part.iov_base = static_cast<char*>(part.iov_base) + done;
+    part.iov_len -= done;
+  }
+  return *next == parts->size();
+}
+
+/// Point a message at the parts that aren't done yet
+void prepare(std::vector<iovec>* parts, size_t next, msghdr* message) {
+  *message = {};
+  message->msg_iov = parts->data() + next;
+  message->msg_iovlen = std::min(parts->size() - next, size_t{IOV_MAX});
+}
+
+/// A response being sent. It keeps the data of the outputs alive until then
+struct Outgoing {
+  std::string header;
+  InferenceResponse response;
+  std::vector<iovec> parts;
+  size_t next = 0;
+  msghdr message{};
+};
+
+using OutgoingPtr = std::shared_ptr<Outgoing>;
+
+struct Connection {
+  explicit Connection(int fd) : fd(fd), buffer(kReadSize, '\0') {}
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+  Connection(Connection&&) = delete;
+  Connection& operator=(Connection&&) = delete;
+  // the socket is closed once no operations use it
+  ~Connection() { ::close(fd); }
+
+  int fd;
+  // bytes read but not parsed yet are between begin and end
+  std::string buffer;
+  size_t begin = 0;
+  size_t end = 0;
+  // bytes of the data of a refused request still to be skipped
+  uint64_t discard = 0;
+
+  // the request whose data is being received into its inputs
+  InferenceRequestPtr request;
+  std::string model;
+  std::string version;
+  std::vector<iovec> payload;
+  size_t next = 0;
+  msghdr message{};
+
+  // responses waiting to be sent. The front one is being sent
+  std::deque<OutgoingPtr> outbox;
+  bool sending = false;
+  bool closed = false;
+};
+
+using ConnectionPtr = std::shared_ptr<Connection>;
+
+enum class OperationType { Accept, Read, Payload, Send, Wake };
+
+/// The state of a submitted operation, identified by its address
+struct Operation {
+  OperationType type;
+  ConnectionPtr connection;
+  OutgoingPtr outgoing;
+};
+
+/**
+ * @brief Runs completions on the thread that serves a ring. Once the ring
+ * stops, its connections are gone so their responses are dropped.
+ */
+class RingExecutor : public CompletionExecutor {
+ public:
+  explicit RingExecutor(int event) : event_(event) {}
+
+  void post(std::vector<Completion> completions) override {
+    const std::lock_guard lock{mutex_};
+    if (!open_) {
+      return;
+    }
+    const auto wake = inbox_.empty();
+    inbox_.insert(inbox_.end(), std::make_move_iterator(completions.begin()),
+                  std::make_move_iterator(completions.end()));
+    // the ring closes its eventfd after closing this executor so it's
+    // written while holding the lock
+    if (wake) {
+      const uint64_t one = 1;
+      [[maybe_unused]] auto written = ::write(event_, &one, sizeof(one));
+    }
+  }
+
+  std::vector<Completion> take() {
+    const std::lock_guard lock{mutex_};
+    return std::exchange(inbox_, {});
+  }
+
+  std::vector<Completion> close() {
+    const std::lock_guard lock{mutex_};
+    open_ = false;
+    return std::exchange(inbox_, {});
+  }
+
+ private:
+  int event_;
+  std::mutex mutex_;
+  std::vector<Completion> inbox_;
+  bool open_ = true;
+};
+
+class Ring {
+ public:
+  Ring(SharedState* state, int port) : state_(state) {
+    io_uring_params params{};
+    // completions are only reaped by this ring's thread so the kernel needn't
+    // interrupt it to run them
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    auto error = io_uring_queue_init_params(kQueueDepth, &ring_, &params);
+    if (error == -EINVAL) {
+      params = {};
+      error = io_uring_queue_init_params(kQueueDepth, &ring_, &params);
+    }
+    if (error < 0) {
+      throw runtime_error("Couldn't create an io_uring: " +
+                          errorString(-error));
+    }
+    ring_ready_ = true;
+
+    auto* probe = io_uring_get_probe_ring(&ring_);
+    if (probe != nullptr) {
+      zero_copy_ = io_uring_opcode_supported(probe, IORING_OP_SENDMSG_ZC) != 0;
+      io_uring_free_probe(probe);
+    }
+
+    event_ = ::eventfd(0, EFD_CLOEXEC);
+    listener_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (event_ < 0 || listener_ < 0) {
+      const auto saved = errno;
+      this->closeAll();
+      throw runtime_error("Couldn't create the io_uring server's sockets: " +
+                          errorString(saved));
+    }
+    // every ring listens on the port and the kernel spreads connections over
+    // them
+    const int on = 1;
+    ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::setsockopt(listener_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (::bind(listener_, reinterpret_cast<sockaddr*>(&address),
+               sizeof(address)) < 0 ||
+        ::listen(listener_, kBacklog) < 0) {
+      const auto saved = errno;
+      this->closeAll();
+      throw runtime_error("Couldn't listen on port " + std::to_string(port) +
+                          ": " + errorString(saved));
+    }
+    executor_ = std::make_shared<RingExecutor>(event_);
+  }
+
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+  Ring(Ring&&) = delete;
+  Ring& operator=(Ring&&) = delete;
+
+  ~Ring() { this->closeAll(); }
+
+  void run() {
+    util::setThreadName("uring");
+    this->submitAccept();
+    this->submitWake();
+    while (running_) {
+      io_uring_submit_and_wait(&ring_, 1);
+      unsigned head = 0;
+      unsigned count = 0;
+      io_uring_cqe* cqe = nullptr;
+      io_uring_for_each_cqe(&ring_, head, cqe) {
+        auto* operation = static_cast<Operation*>(io_uring_cqe_get_data(cqe));
+        this->complete(operation, cqe->res, cqe->flags);
+        // multishot and zero-copy operations have more completions to come
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+          operations_.erase(operation);
+        }
+        count++;
+      }
+      io_uring_cq_advance(&ring_, count);
+    }
+  }
+
+  void stop() {
+    stopping_ = true;
+    const uint64_t one = 1;
+    [[maybe_unused]] auto written = ::write(event_, &one, sizeof(one));
+  }
+
+ private:
+  void closeAll() {
+    if (ring_ready_) {
+      io_uring_queue_exit(&ring_);
+      ring_ready_ = false;
+    }
+    // operations the ring didn't finish hold the last of their connections
+    operations_.clear();
+    connections_.clear();
+    if (listener_ >= 0) {
+      ::close(listener_);
+      listener_ = -1;
+    }
+    if (event_ >= 0) {
+      ::close(event_);
+      event_ = -1;
+    }
+  }
+
+  io_uring_sqe* getSqe() {
+    auto* sqe = io_uring_get_sqe(&ring_);
+    while (sqe == nullptr) {
+      io_uring_submit(&ring_);
+      sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+  }
+
+  void submit(io_uring_sqe* sqe, OperationType type, ConnectionPtr connection,
+              OutgoingPtr outgoing = nullptr) {
+    auto operation = std::make_unique<Operation>(
+      Operation{type, std::move(connection), std::move(outgoing)});
+    io_uring_sqe_set_data(sqe, operation.get());
+    auto* key = operation.get();
+    operations_.emplace(key, std::move(operation));
+  }
+
+  void submitAccept() {
+    auto* sqe = this->getSqe();
+    io_uring_prep_multishot_accept(sqe, listener_, nullptr, nullptr,
+                                   SOCK_CLOEXEC);
+    this->submit(sqe, OperationType::Accept, nullptr);
+  }
+
+  void submitWake() {
+    auto* sqe = this->getSqe();
+    io_uring_prep_read(sqe, event_, &wake_, sizeof(wake_), 0);
+    this->submit(sqe, OperationType::Wake, nullptr);
+  }
+
+  void submitRead(const ConnectionPtr& connection) {
+    auto& buffer = connection->buffer;
+    auto* sqe = this->getSqe();
+    io_uring_prep_recv(sqe, connection->fd, buffer.data() + connection->end,
+                       buffer.size() - connection->end, 0);
+    this->submit(sqe, OperationType::Read, connection);
+  }
+
+  void submitPayload(const ConnectionPtr& connection) {
+    prepare(&connection->payload, connection->next, &connection->message);
+    auto* sqe = this->getSqe();
+    io_uring_prep_recvmsg(sqe, connection->fd, &connection->message,
+                          MSG_WAITALL);
+    this->submit(sqe, OperationType::Payload, connection);
+  }
+
+  void submitSend(const ConnectionPtr& connection) {
+    auto outgoing = connection->outbox.front();
+    prepare(&outgoing->parts, outgoing->next, &outgoing->message);
+    size_t size = 0;
+    for (auto i = outgoing->next; i < outgoing->parts.size(); ++i) {
+      size += outgoing->parts[i].iov_len;
+    }
+    auto* sqe = this->getSqe();
+    if (zero_copy_ && size >= kZeroCopySize) {
+      io_uring_prep_sendmsg_zc(sqe, connection->fd, &outgoing->message,
+                               MSG_NOSIGNAL);
+    } else {
+      io_uring_prep_sendmsg(sqe, connection->fd, &outgoing->message,
+                            MSG_NOSIGNAL);
+    }
+    connection->sending = true;
+    this->submit(sqe, OperationType::Send, connection, std::move(outgoing));
+  }
+
+  void complete(const Operation* operation, int result, unsigned flags) {
+    switch (operation->type) {
+      case OperationType::Accept:
+        this->accepted(result, flags);
+        break;
+      case OperationType::Wake:
+        this->woken();
+        break;
+      case OperationType::Read:
+        this->read(operation->connection, result);
+        break;
+      case OperationType::Payload:
+        this->received(operation->connection, result);
+        break;
+      case OperationType::Send:
+        // the notification of a zero-copy send only releases its buffers
+        if ((flags & IORING_CQE_F_NOTIF) == 0) {
+          this->sent(operation->connection, operation->outgoing.get(), result);
+        }
+        break;
+    }
+  }
+
+  void accepted(int fd, unsigned flags) {
+    if (fd >= 0) {
+      const int on = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      auto connection = std::make_shared<Connection>(fd);
+      connections_.insert(connection);
+      this->submitRead(connection);
+    } else if (!stopping_) {
+      AMDINFER_LOG_WARN(logger_, "Couldn't accept a connection: " +
+                                   errorString(-fd));
+    }
+    if ((flags & IORING_CQE_F_MORE) == 0 && !stopping_) {
+      this->submitAccept();
+    }
+  }
+
+  void woken() {
+    if (stopping_) {
+      this->shutdown();
+      return;
+    }
+    auto completions = executor_->take();
+    runCompletions(&completions);
+    this->submitWake();
+  }
+
+  void shutdown() {
+    // destroying dropped completions may release connections
+    auto dropped = executor_->close();
+    dropped.clear();
+    auto connections = connections_;
+    for (const auto& connection : connections) {
+      this->close(connection);
+    }
+    ::shutdown(listener_, SHUT_RDWR);
+    running_ = false;
+  }
+
+  void close(const ConnectionPtr& connection) {
+    if (connection->closed) {
+      return;
+    }
+    connection->closed = true;
+    releaseInputs(connection->request.get(), state_->getPool());
+    connection->request.reset();
+    connection->outbox.clear();
+    // pending operations on the socket fail and let go of the connection
+    ::shutdown(connection->fd, SHUT_RDWR);
+    connections_.erase(connection);
+  }
+
+  void read(const ConnectionPtr& connection, int result) {
+    if (connection->closed) {
+      return;
+    }
+    if (result <= 0) {
+      this->close(connection);
+      return;
+    }
+    connection->end += static_cast<size_t>(result);
+    this->parse(connection);
+  }
+
+  void received(const ConnectionPtr& connection, int result) {
+    if (connection->closed) {
+      return;
+    }
+    if (result <= 0) {
+      this->close(connection);
+      return;
+    }
+    if (!advance(&connection->payload, &connection->next,
+                 static_cast<size_t>(result))) {
+      this->submitPayload(connection);
+      return;
+    }
+    this->dispatch(connection);
+    this->parse(connection);
+  }
+
+  void sent(const ConnectionPtr& connection, Outgoing* outgoing, int result) {
+    if (connection->closed) {
+      return;
+    }
+    if (result < 0) {
+      this->close(connection);
+      return;
+    }
+    if (advance(&outgoing->parts, &outgoing->next,
+                static_cast<size_t>(result))) {
+      connection->outbox.pop_front();
+    }
+    connection->sending = false;
+    if (!connection->outbox.empty()) {
+      this->submitSend(connection);
+    }
+  }
+
+  /// Start the requests that have been read and then read more
+  void parse(const ConnectionPtr& connection) {
+    auto& buffer = connection->buffer;
+    try {
+      while (connection->request == nullptr) {
+        const auto available = connection->end - connection->begin;
+        if (connection->discard > 0) {
+          const auto skipped =
+            std::min<uint64_t>(connection->discard, available);
+          connection->begin += skipped;
+          connection->discard -= skipped;
+          if (connection->discard > 0) {
+            break;
+          }
+          continue;
+        }
+        if (available < kBinaryPrefixSize) {
+          break;
+        }
+        const std::string_view bytes{buffer.data() + connection->begin,
+                                     available};
+        const auto prefix = parseBinaryPrefix(bytes);
+        if (prefix.kind != BinaryMessageKind::Request) {
+          throw invalid_argument("Only requests may be sent to the server");
+        }
+        const auto size = kBinaryPrefixSize + prefix.header_size;
+        if (available < size) {
+          if (buffer.size() < size) {
+            buffer.resize(size);
+          }
+          break;
+        }
+        connection->begin += size;
+        this->start(connection,
+                    bytes.substr(kBinaryPrefixSize, prefix.header_size),
+                    prefix.data_size);
+      }
+    } catch (const invalid_argument& e) {
+      // there's no way to find the next message after a malformed prefix
+      AMDINFER_LOG_INFO(logger_, e.what());
+      this->close(connection);
+      return;
+    }
+
+    if (connection->request != nullptr) {
+      this->submitPayload(connection);
+      return;
+    }
+    // keep the unparsed bytes at the start of the buffer
+    const auto unparsed = connection->end - connection->begin;
+    std::memmove(buffer.data(), buffer.data() + connection->begin, unparsed);
+    connection->begin = 0;
+    connection->end = unparsed;
+    this->submitRead(connection);
+  }
+
+  /// Admit a request from its header and receive its data into its inputs
+  void start(const ConnectionPtr& connection, std::string_view header,
+             uint64_t data_size) {
+    const auto* pool = state_->getPool();
+    InferenceRequestPtr request;
+    std::string id;
+    try {
+      auto parsed = parseBinaryRequestHeader(header, data_size);
+      id = parsed.request.getID();
+      auto server_ticket =
+        state_->admit(getTenant(parsed.request, state_->getTenantKey()));
+      auto ticket = state_->modelAdmit(parsed.model, parsed.version,
+                                       header.size() + data_size);
+      request = std::make_shared<InferenceRequest>(std::move(parsed.request));
+      connection->payload.clear();
+      connection->next = 0;
+      const auto& inputs = request->getInputs();
+      for (auto i = 0U; i < inputs.size(); ++i) {
+        auto buffer = pool->get({MemoryAllocators::Cpu}, inputs[i], 1);
+        auto* data = buffer->data(0);
+        request->setInputTensorData(i, data);
+        const auto size = inputs[i].getSize() * inputs[i].getDatatype().size();
+        if (size > 0) {
+          connection->payload.push_back({data, size});
+        }
+      }
+      std::weak_ptr<Connection> weak = connection;
+      request->setCallback([this, weak](const InferenceResponse& response) {
+        if (auto connection = weak.lock()) {
+          this->respond(connection, response);
+        }
+      });
+      request->setExecutor(executor_);
+      holdTicket(request.get(), std::move(ticket));
+      holdTicket(request.get(), std::move(server_ticket));
+      connection->model = std::move(parsed.model);
+      connection->version = std::move(parsed.version);
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger_, e.what());
+      releaseInputs(request.get(), pool);
+      connection->discard = data_size;
+      InferenceResponse response{e.what()};
+      response.setID(id);
+      this->respond(connection, response);
+      return;
+    }
+
+    // the data that was read with the header is copied and the rest is
+    // received in place
+    const auto* buffered = connection->buffer.data() + connection->begin;
+    auto available = std::min<uint64_t>(connection->end - connection->begin,
+                                         data_size);
+    connection->begin += available;
+    auto& payload = connection->payload;
+    while (available > 0) {
+      auto& part = payload[connection->next];
+      const auto size = std::min<uint64_t>(part.iov_len, available);
+      std::memcpy(part.iov_base, buffered, size);
+      buffered += size;
+      available -= size;
+      advance(&payload, &connection->next, size);
+    }
+    connection->request = std::move(request);
+    if (connection->next == payload.size()) {
+      this->dispatch(connection);
+    }
+  }
+
+  void dispatch(const ConnectionPtr& connection) {
+    auto request = std::move(connection->request);
+    connection->payload.clear();
+    connection->next = 0;
+    try {
+      auto request_container = makeRequestContainer();
+      request_container->request = request;
+      state_->modelInfer(connection->model, std::move(request_container),
+                         connection->version);
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger_, e.what());
+      releaseInputs(request.get(), state_->getPool());
+      InferenceResponse response{e.what()};
+      response.setID(request->getID());
+      this->respond(connection, response);
+    }
+  }
+
+  void respond(const ConnectionPtr& connection,
+               const InferenceResponse& response) {
+    if (connection->closed) {
+      return;
+    }
+    auto outgoing = std::make_shared<Outgoing>();
+    outgoing->header = serializeBinaryResponseHeader(response);
+    // outputs that view pooled memory share it instead of copying it
+    outgoing->response = response;
+    auto& parts = outgoing->parts;
+    parts.push_back({outgoing->header.data(), outgoing->header.size()});
+    for (const auto& output : outgoing->response.getOutputs()) {
+      const auto size = output.getSize() * output.getDatatype().size();
+      if (size > 0) {
+        parts.push_back({output.getData(), size});
+      }
+    }
+    connection->outbox.push_back(std::move(outgoing));
+    if (!connection->sending) {
+      this->submitSend(connection);
+    }
+  }
+
+  SharedState* state_;
+  io_uring ring_{};
+  bool ring_ready_ = false;
+  int listener_ = -1;
+  int event_ = -1;
+  uint64_t wake_ = 0;
+  bool zero_copy_ = false;
+  bool running_ = true;
+  std::atomic_bool stopping_{false};
+  std::shared_ptr<RingExecutor> executor_;
+  std::unordered_map<Operation*, std::unique_ptr<Operation>> operations_;
+  std::unordered_set<ConnectionPtr> connections_;
+  AMDINFER_IF_LOGGING(Logger logger_{Loggers::Server};)
+};
+
+class UringServer {
+ public:
+  UringServer(SharedState* state, int port, int threads,
+              const std::vector<int>& cpus) {
+    const auto nodes = util::getNumaNodes();
+    if (threads <= 0) {
+      threads = static_cast<int>(nodes.size());
+    }
+    for (auto i = 0; i < threads; ++i) {
+      rings_.push_back(std::make_unique<Ring>(state, port));
+    }
+    for (auto i = 0; i < threads; ++i) {
+      auto& thread = threads_.emplace_back(&Ring::run, rings_.at(i).get());
+      if (cpus.empty()) {
+        util::bindThreadToNumaNode(thread, nodes.at(i % nodes.size()));
+      } else {
+        util::bindThreadToCpus(thread, {cpus.at(i % cpus.size())});
+      }
+    }
+  }
+
+  UringServer(const UringServer&) = delete;
+  UringServer& operator=(const UringServer&) = delete;
+  UringServer(UringServer&&) = delete;
+  UringServer& operator=(UringServer&&) = delete;
+
+  ~UringServer() {
+    for (auto& ring : rings_) {
+      ring->stop();
+    }
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+ private:
+  std::vector<std::unique_ptr<Ring>> rings_;
+  std::vector<std::thread> threads_;
+};
+
+std::unique_ptr<UringServer> server;
+
+}  // namespace
+
+namespace uring {
+
+void start(SharedState* state, int port, int threads,
+           const std::vector<int>& cpus) {
+  server = std::make_unique<UringServer>(state, port, threads, cpus);
+}
+
+void stop() { server.reset(); }
+
+}  // namespace uring
+
+}  // namespace amdinfer
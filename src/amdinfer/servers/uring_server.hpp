@@ -0,0 +1,54 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the io_uring server for the binary inference protocol
+ */
+
+#ifndef GUARD_AMDINFER_SERVERS_URING_SERVER
+#define GUARD_AMDINFER_SERVERS_URING_SERVER
+
+#include <vector>  // for vector
+
+#include "amdinfer/build_options.hpp"
+
+#ifdef AMDINFER_ENABLE_IO_URING
+
+namespace amdinfer {
+class SharedState;
+}
+
+namespace amdinfer::uring {
+
+/**
+ * @brief Start the io_uring server. Each thread has its own ring and listening
+ * socket on the port and the kernel spreads connections over them
+ *
+ * @param state the server's state
+ * @param port TCP port to listen on
+ * @param threads number of threads to serve connections on. If zero, there's
+ * one per NUMA node
+ * @param cpus CPUs to pin the threads to, one each in turn. If empty, they're
+ * spread over the NUMA nodes instead
+ */
+void start(SharedState* state, int port, int threads,
+           const std::vector<int>& cpus);
+void stop();
+
+}  // namespace amdinfer::uring
+
+#endif  // AMDINFER_ENABLE_IO_URING
+
+#endif  // GUARD_AMDINFER_SERVERS_URING_SERVER
@@ -18,19 +18,26 @@
 #include <json/reader.h>  // for CharReader, CharReaderBui...
 #include <json/value.h>   // for Value, arrayValue
 
-#include <algorithm>  // for transform
-#include <cctype>     // for tolower
-#include <memory>     // for allocator, shared_ptr
-#include <string>     // for string, operator+, char_t...
-#include <utility>    // for move
-
-#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
-#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
-#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
-#include "amdinfer/core/request_container.hpp"   // for ParameterMapPtr
-#include "amdinfer/core/shared_state.hpp"        // for SharedState
-#include "amdinfer/observation/tracing.hpp"      // for startSpan, Span
-#include "amdinfer/servers/http_server.hpp"      // for RequestBuilder
+#include <algorithm>     // for transform
+#include <cctype>        // for tolower
+#include <charconv>      // for from_chars
+#include <cstddef>       // for size_t
+#include <memory>        // for allocator, shared_ptr, make_shared
+#include <string>        // for string, operator+, char_t...
+#include <string_view>   // for string_view
+#include <system_error>  // for errc
+#include <utility>       // for move
+
+#include "amdinfer/core/exceptions.hpp"            // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"     // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"    // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"            // for ParameterMap
+#include "amdinfer/core/request_container.hpp"     // for ParameterMapPtr
+#include "amdinfer/core/shared_state.hpp"          // for SharedState
+#include "amdinfer/core/stream_flow.hpp"           // for StreamFlow
+#include "amdinfer/observation/tracing.hpp"        // for startSpan, Span
+#include "amdinfer/servers/http_server.hpp"        // for RequestBuilder
+#include "amdinfer/servers/websocket_session.hpp"  // for WebsocketSession
 
 using drogon::HttpRequestPtr;
 using drogon::WebSocketConnectionPtr;
@@ -38,23 +45,21 @@ using drogon::WebSocketMessageType;
 
 namespace amdinfer::http {
 
-void setCallback(InferenceRequest *request,
-                 drogon::WebSocketConnectionPtr conn) {
-  Callback callback = [conn =
-                         std::move(conn)](const InferenceResponse &response) {
-    if (response.isError()) {
-      conn->send(response.getError());
-    } else {
-      auto outputs = response.getOutputs();
-      const auto *msg = static_cast<char *>(outputs[0].getData());
-      if (conn->connected()) {
-        conn->send(msg, outputs[0].getSize());
-      }
-    }
-  };
-  request->setCallback(std::move(callback));
+namespace {
+
+/// Parse a positive count from a query parameter or return 0
+size_t parseCount(const std::string &parameter) {
+  size_t value = 0;
+  if (std::from_chars(parameter.data(), parameter.data() + parameter.size(),
+                      value)
+        .ec != std::errc{}) {
+    return 0;
+  }
+  return value;
 }
 
+}  // namespace
+
 WebsocketServer::WebsocketServer(SharedState *state) : state_(state) {
   AMDINFER_LOG_INFO(logger_, "Constructed WebsocketServer");
 }
@@ -64,7 +69,9 @@ void WebsocketServer::handleNewMessage(const WebSocketConnectionPtr &conn,
                                        const WebSocketMessageType &type) {
 #ifdef AMDINFER_ENABLE_TRACING
   auto trace = startTrace(&(__func__[0]));
-  trace->startSpan("websocket_handler");
+  if (trace != nullptr) {
+    trace->startSpan("websocket_handler");
+  }
 #endif
 
   if (type == WebSocketMessageType::Close) {
@@ -88,6 +95,16 @@ void WebsocketServer::handleNewMessage(const WebSocketConnectionPtr &conn,
     return;
   }
 
+  // clients with flow control return credits in messages of their own
+  auto session = conn->getContext<WebsocketSession>();
+  if (json->isMember("credits") && !json->isMember("model")) {
+    if (const auto &credits = (*json)["credits"];
+        credits.isUInt() && credits.asUInt() > 0) {
+      session->grant(credits.asUInt());
+    }
+    return;
+  }
+
   std::string model;
   if (json->isMember("model")) {
     model = json->get("model", "").asString();
@@ -101,35 +118,66 @@ void WebsocketServer::handleNewMessage(const WebSocketConnectionPtr &conn,
                  [](unsigned char c) { return std::tolower(c); });
 
   auto request = getRequest(json, state_->getPool());
-  setCallback(request.get(), conn);
-  auto request_container = std::make_unique<RequestContainer>();
+  auto request_container = makeRequestContainer();
   request_container->request = request;
 #ifdef AMDINFER_ENABLE_TRACING
-  trace->endSpan();
+  if (trace != nullptr) {
+    trace->endSpan();
+  }
   request_container->trace = std::move(trace);
 #endif
 
-  try {
-    state_->modelInfer(model, std::move(request_container));
-  } catch (const runtime_error &e) {
-    AMDINFER_LOG_INFO(logger_, e.what());
-    conn->shutdown(drogon::CloseCode::kInvalidMessage, e.what());
-    return;
-  }
+  // the session decides when the request runs and sends its responses
+  session->submit(std::move(request_container),
+                  [this, model](RequestContainerPtr container) {
+                    try {
+                      state_->modelInfer(model, std::move(container));
+                    } catch (const runtime_error &e) {
+                      AMDINFER_LOG_INFO(logger_, e.what());
+                      throw;
+                    }
+                  });
 }
 
 void WebsocketServer::handleConnectionClosed(
   const WebSocketConnectionPtr &conn) {
   AMDINFER_LOG_INFO(logger_, "Websocket closed");
-  // (void)conn;  // suppress unused variable warning
+  // the requests still running for this connection have no one to respond to
+  if (auto session = conn->getContext<WebsocketSession>(); session != nullptr) {
+    session->close();
+  }
   conn->shutdown();
 }
 
 void WebsocketServer::handleNewConnection(const HttpRequestPtr &req,
                                           const WebSocketConnectionPtr &conn) {
   AMDINFER_LOG_INFO(logger_, "New websocket connection");
-  (void)conn;  // suppress unused variable warning
-  (void)req;   // suppress unused variable warning
+  // clients may change how many of their requests run at once with the
+  // "window" query parameter
+  size_t window = kDefaultStreamWindow;
+  if (auto value = parseCount(req->getParameter("window")); value > 0) {
+    window = value;
+  }
+  // and opt into flow control by giving their first credits with "credits"
+  // and, optionally, the policy with "policy"
+  std::shared_ptr<StreamFlow> flow;
+  if (auto credits = parseCount(req->getParameter("credits")); credits > 0) {
+    flow = std::make_shared<StreamFlow>(
+      credits, parseStreamFlowPolicy(req->getParameter("policy"))
+                 .value_or(StreamFlowPolicy::Block));
+  }
+
+  // the session doesn't keep the connection alive
+  std::weak_ptr<drogon::WebSocketConnection> weak_conn = conn;
+  auto send = [weak_conn](std::string_view message, bool binary) {
+    if (auto conn = weak_conn.lock(); conn != nullptr && conn->connected()) {
+      conn->send(message.data(), message.size(),
+                 binary ? WebSocketMessageType::Binary
+                        : WebSocketMessageType::Text);
+    }
+  };
+  conn->setContext(
+    std::make_shared<WebsocketSession>(send, window, std::move(flow)));
 }
 
 }  // namespace amdinfer::http
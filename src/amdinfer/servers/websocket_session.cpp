@@ -0,0 +1,195 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the state the websocket server keeps for each connection
+ */
+
+#include "amdinfer/servers/websocket_session.hpp"
+
+#include <algorithm>  // for max
+#include <optional>   // for optional, nullopt
+
+#include "amdinfer/core/exceptions.hpp"          // for runtime_error
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/request_container.hpp"   // for RequestContainer
+#include "amdinfer/core/stream_flow.hpp"         // for StreamFlow
+
+namespace amdinfer::http {
+
+namespace {
+
+std::string makeSessionId() {
+  static std::atomic<uint64_t> count{0};
+  return "websocket_" + std::to_string(count++);
+}
+
+/// Get the message to send for a response, if it has one
+std::optional<std::pair<std::string, bool>> getMessage(
+  const InferenceResponse &response) {
+  if (response.isError()) {
+    return std::make_pair(response.getError(), false);
+  }
+  const auto &outputs = response.getOutputs();
+  if (outputs.empty()) {
+    return std::nullopt;
+  }
+  const auto &output = outputs[0];
+  // streaming workers mark outputs that hold binary frames instead of JSON
+  // text
+  const auto &parameters = output.getParameters();
+  const bool binary =
+    parameters.has("binary") && parameters.get<bool>("binary");
+  return std::make_pair(
+    std::string{static_cast<const char *>(output.getData()), output.getSize()},
+    binary);
+}
+
+}  // namespace
+
+WebsocketSession::WebsocketSession(Send send, size_t window,
+                                   std::shared_ptr<StreamFlow> flow)
+  : id_(makeSessionId()),
+    send_(std::move(send)),
+    window_(std::max<size_t>(window, 1)),
+    flow_(std::move(flow)),
+    cancelled_(std::make_shared<std::atomic_bool>(false)) {}
+
+void WebsocketSession::submit(RequestContainerPtr request, Dispatch dispatch) {
+  const auto &inference_request = request->request;
+  std::unique_lock lock{mutex_};
+  if (auto parameters = inference_request->getParameters();
+      !parameters.has("sequence_id")) {
+    parameters.put("sequence_id", id_);
+    if (starting_) {
+      parameters.put("sequence_start", true);
+    }
+    // the next request restarts the sequence if the client ended it
+    starting_ =
+      parameters.has("sequence_end") && parameters.get<bool>("sequence_end");
+    inference_request->setParameters(std::move(parameters));
+  }
+
+  const auto index = next_++;
+  pending_.try_emplace(index);
+  inference_request->setCancellation(cancelled_);
+  inference_request->setStreamFlow(flow_);
+  inference_request->setCallback(
+    [self = shared_from_this(), index](const InferenceResponse &response) {
+      self->respond(index, response);
+    });
+
+  Waiting waiting{std::move(request), std::move(dispatch)};
+  if (inflight_ >= window_) {
+    waiting_.emplace_back(index, std::move(waiting));
+    return;
+  }
+  inflight_++;
+  lock.unlock();
+  this->dispatch(std::move(waiting));
+}
+
+void WebsocketSession::grant(size_t credits) {
+  if (flow_ != nullptr) {
+    flow_->release(credits);
+  }
+}
+
+void WebsocketSession::close() {
+  cancelled_->store(true);
+  // workers waiting for credits give up on the stream
+  if (flow_ != nullptr) {
+    flow_->close();
+  }
+  std::deque<std::pair<uint64_t, Waiting>> waiting;
+  {
+    std::lock_guard lock{mutex_};
+    waiting.swap(waiting_);
+    inflight_ += waiting.size();
+  }
+  // the batchers drop cancelled requests and return their memory
+  for (auto &[index, request] : waiting) {
+    this->dispatch(std::move(request));
+  }
+}
+
+void WebsocketSession::dispatch(Waiting waiting) {
+  auto &[container, dispatch] = waiting;
+  auto request = container->request;
+  try {
+    dispatch(std::move(container));
+  } catch (const runtime_error &e) {
+    request->runCallbackError(e.what());
+  }
+}
+
+void WebsocketSession::respond(uint64_t index,
+                               const InferenceResponse &response) {
+  auto message = getMessage(response);
+  std::vector<std::pair<uint64_t, Waiting>> ready;
+  {
+    std::lock_guard lock{mutex_};
+    auto found = pending_.find(index);
+    if (found == pending_.end()) {
+      // streaming workers keep responding after their first final response
+      // and their later messages go out as they come
+      if (message.has_value()) {
+        this->send(message->first, message->second);
+      }
+      return;
+    }
+    if (message.has_value()) {
+      found->second.messages.push_back(std::move(*message));
+    }
+    found->second.done |= response.isFinal();
+    this->flush();
+
+    while (inflight_ < window_ && !waiting_.empty()) {
+      ready.push_back(std::move(waiting_.front()));
+      waiting_.pop_front();
+      inflight_++;
+    }
+  }
+  for (auto &[next, waiting] : ready) {
+    this->dispatch(std::move(waiting));
+  }
+}
+
+void WebsocketSession::flush() {
+  // messages are sent while holding the lock so they go out in order
+  while (!pending_.empty()) {
+    auto &head = pending_.begin()->second;
+    for (const auto &[message, binary] : head.messages) {
+      this->send(message, binary);
+    }
+    head.messages.clear();
+    if (!head.done) {
+      return;
+    }
+    pending_.erase(pending_.begin());
+    inflight_--;
+  }
+}
+
+void WebsocketSession::send(std::string_view message, bool binary) {
+  if (flow_ != nullptr) {
+    flow_->queue();
+  }
+  send_(message, binary);
+}
+
+}  // namespace amdinfer::http
@@ -0,0 +1,145 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the state the websocket server keeps for each connection
+ */
+
+#ifndef GUARD_AMDINFER_SERVERS_WEBSOCKET_SESSION
+#define GUARD_AMDINFER_SERVERS_WEBSOCKET_SESSION
+
+#include <atomic>       // for atomic_bool
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <deque>        // for deque
+#include <functional>   // for function
+#include <map>          // for map
+#include <memory>       // for shared_ptr, enable_shared_from_this
+#include <mutex>        // for mutex
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include "amdinfer/declarations.hpp"  // for RequestContainerPtr
+
+namespace amdinfer {
+class InferenceResponse;
+class StreamFlow;
+}  // namespace amdinfer
+
+namespace amdinfer::http {
+
+/// The most requests of a connection that are in the server at once by default
+constexpr size_t kDefaultStreamWindow = 4;
+
+/**
+ * @brief The state of one websocket connection. The requests that a client
+ * sends over a connection, such as the frames of a video, form a stream:
+ *
+ *  - They're one sequence so sequence workers keep the stream's state between
+ *    its requests and run them all on the same instance. Requests that set
+ *    their own "sequence_id" are left alone.
+ *  - At most a window of them are in the server at once and the rest wait in
+ *    the session. A client sending frames faster than they're served then
+ *    can't crowd the other streams out of the shared batcher queues and the
+ *    streams get their turns at frame granularity.
+ *  - Their responses are sent in the order the requests arrived.
+ *  - If the client opts into flow control, each message sent uses up one of
+ *    its credits and the client grants more as it consumes them. Streaming
+ *    workers wait for credits or drop frames, depending on the policy, so a
+ *    slow client doesn't pile frames up in the connection's buffer.
+ */
+class WebsocketSession : public std::enable_shared_from_this<WebsocketSession> {
+ public:
+  /// Sends a message to the client as binary or text
+  using Send = std::function<void(std::string_view message, bool binary)>;
+  /// Passes a request on to its model. It throws if the model refuses it
+  using Dispatch = std::function<void(RequestContainerPtr request)>;
+
+  /**
+   * @brief Construct a new session
+   *
+   * @param send sends messages to the client
+   * @param window the most requests that may be in the server at once
+   * @param flow the flow control of the messages or null if there's none
+   */
+  explicit WebsocketSession(Send send, size_t window = kDefaultStreamWindow,
+                            std::shared_ptr<StreamFlow> flow = nullptr);
+
+  /// Get the ID of the session's sequence
+  [[nodiscard]] const std::string &getId() const { return id_; }
+  /// Get the flag that's raised when the connection closes
+  [[nodiscard]] std::shared_ptr<const std::atomic_bool> getCancellation()
+    const {
+    return cancelled_;
+  }
+
+  /**
+   * @brief Add a request to the stream. It's dispatched now if the window has
+   * room or once an earlier request is done. A request that's refused is sent
+   * its error as a text message in its turn.
+   *
+   * @param request the request. Its callback is replaced
+   * @param dispatch passes the request on to its model
+   */
+  void submit(RequestContainerPtr request, Dispatch dispatch);
+
+  /**
+   * @brief Return credits that the client granted after consuming messages.
+   * It's ignored without flow control
+   *
+   * @param credits the number of credits
+   */
+  void grant(size_t credits);
+
+  /// Cancel the stream's requests once the client is gone
+  void close();
+
+ private:
+  /// The messages of a request waiting for earlier requests to be sent
+  struct Pending {
+    std::vector<std::pair<std::string, bool>> messages;
+    bool done = false;
+  };
+  using Waiting = std::pair<RequestContainerPtr, Dispatch>;
+
+  void respond(uint64_t index, const InferenceResponse &response);
+  void flush();
+  void send(std::string_view message, bool binary);
+  void dispatch(Waiting waiting);
+
+  std::string id_;
+  Send send_;
+  size_t window_;
+  std::shared_ptr<StreamFlow> flow_;
+  std::shared_ptr<std::atomic_bool> cancelled_;
+
+  std::mutex mutex_;
+  // index of the next request to submit
+  uint64_t next_ = 0;
+  // true if the next request starts the session's sequence
+  bool starting_ = true;
+  // number of dispatched requests that aren't done
+  size_t inflight_ = 0;
+  // the requests that aren't done or aren't sent yet, by index
+  std::map<uint64_t, Pending> pending_;
+  // the requests waiting for room in the window, by index
+  std::deque<std::pair<uint64_t, Waiting>> waiting_;
+};
+
+}  // namespace amdinfer::http
+
+#endif  // GUARD_AMDINFER_SERVERS_WEBSOCKET_SESSION
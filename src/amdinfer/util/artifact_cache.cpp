@@ -0,0 +1,148 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the cache of compiled models that the workers share
+ */
+
+#include "amdinfer/util/artifact_cache.hpp"
+
+#include <array>         // for array
+#include <cstdint>       // for uint64_t
+#include <cstdio>        // for snprintf
+#include <cstdlib>       // for getenv
+#include <fstream>       // for ifstream
+#include <random>        // for mt19937_64, random_device
+#include <system_error>  // for error_code
+#include <utility>       // for move
+
+#include "amdinfer/core/exceptions.hpp"  // for file_read_error
+
+namespace fs = std::filesystem;
+
+namespace amdinfer::util {
+
+namespace {
+
+std::string toHex(uint64_t value) {
+  // 16 digits and the null terminator
+  std::array<char, 17> digits{};
+  std::snprintf(digits.data(), digits.size(), "%016llx",
+                // NOLINTNEXTLINE(google-runtime-int)
+                static_cast<unsigned long long>(value));
+  return digits.data();
+}
+
+}  // namespace
+
+fs::path getArtifactCacheDirectory() {
+  if (const auto* cache = std::getenv("AMDINFER_ARTIFACT_CACHE");
+      cache != nullptr) {
+    return cache;
+  }
+  const auto* home = std::getenv("HOME");
+  fs::path dir = home != nullptr ? fs::path{home} / ".amdinfer" : ".";
+  return dir / "cache";
+}
+
+std::string getCpuTarget() {
+#if defined(__x86_64__)
+  std::string target = "x86_64";
+  __builtin_cpu_init();
+  // __builtin_cpu_supports only takes literals
+  if (__builtin_cpu_supports("avx")) {
+    target += " avx";
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    target += " avx2";
+  }
+  if (__builtin_cpu_supports("fma")) {
+    target += " fma";
+  }
+  if (__builtin_cpu_supports("avx512f")) {
+    target += " avx512f";
+  }
+  if (__builtin_cpu_supports("avx512bw")) {
+    target += " avx512bw";
+  }
+  if (__builtin_cpu_supports("avx512vl")) {
+    target += " avx512vl";
+  }
+  if (__builtin_cpu_supports("avx512vnni")) {
+    target += " avx512vnni";
+  }
+  return target;
+#elif defined(__aarch64__)
+  return "aarch64";
+#else
+  return "unknown";
+#endif
+}
+
+ArtifactKey::ArtifactKey(std::string backend) : backend_(std::move(backend)) {
+  hasher_.update(std::string_view{backend_});
+}
+
+void ArtifactKey::addFile(const fs::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file.good()) {
+    throw file_read_error("Could not read " + path.string());
+  }
+
+  const size_t block_size = 1 << 20;
+  std::string buffer(block_size, '\0');
+  while (file.read(buffer.data(), block_size) || file.gcount() > 0) {
+    hasher_.update(buffer.data(), static_cast<size_t>(file.gcount()));
+  }
+  if (file.bad()) {
+    throw file_read_error("Could not read " + path.string());
+  }
+}
+
+void ArtifactKey::add(std::string_view name, std::string_view value) {
+  hasher_.update(name);
+  hasher_.update(value);
+}
+
+std::string ArtifactKey::str() const { return toHex(hasher_.digest()); }
+
+fs::path ArtifactKey::getPath(const fs::path& directory,
+                              std::string_view extension) const {
+  auto dir = directory / backend_;
+  std::error_code error;
+  fs::create_directories(dir, error);
+  return dir / (this->str() + std::string{extension});
+}
+
+fs::path getTemporaryPath(const fs::path& path) {
+  thread_local std::mt19937_64 engine{std::random_device{}()};
+  auto temporary = path;
+  temporary += "." + toHex(engine()) + ".tmp";
+  return temporary;
+}
+
+bool publishArtifact(const fs::path& temporary, const fs::path& path) {
+  // renaming within a directory is atomic so readers see the old file or the
+  // whole new one
+  std::error_code error;
+  fs::rename(temporary, path, error);
+  if (error) {
+    fs::remove(temporary, error);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace amdinfer::util
@@ -0,0 +1,105 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the cache of compiled models that the workers share
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_ARTIFACT_CACHE
+#define GUARD_AMDINFER_UTIL_ARTIFACT_CACHE
+
+#include <filesystem>   // for path
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "amdinfer/util/hash.hpp"  // for Hasher
+
+namespace amdinfer::util {
+
+/**
+ * @brief Get the default directory of the compiled artifact cache. It's
+ * AMDINFER_ARTIFACT_CACHE if it's set and ~/.amdinfer/cache otherwise
+ *
+ * @return std::filesystem::path
+ */
+std::filesystem::path getArtifactCacheDirectory();
+
+/**
+ * @brief Get a description of the host CPU's instruction sets that CPU
+ * backends may compile for, such as "x86_64 avx avx2 fma avx512f". Models
+ * optimized on one host can only be reused on hosts with the same target
+ *
+ * @return std::string
+ */
+std::string getCpuTarget();
+
+/**
+ * @brief Identifies a compiled artifact by everything it's compiled from: the
+ * bytes of the model files, the version of the backend, the target it's
+ * compiled for and the options it's compiled with. Artifacts with the same key
+ * are interchangeable so a cached one can be used instead of compiling.
+ */
+class ArtifactKey {
+ public:
+  /// Start a key for an artifact of a backend, such as "migraphx"
+  explicit ArtifactKey(std::string backend);
+
+  /// Add the contents of a file. Throws file_read_error if it can't be read
+  void addFile(const std::filesystem::path& path);
+  /// Add a named value, such as the backend's version or a compile option
+  void add(std::string_view name, std::string_view value);
+
+  /// Get the key as a string of hexadecimal digits
+  [[nodiscard]] std::string str() const;
+  /**
+   * @brief Get the path to the artifact in a cache. Each backend's artifacts
+   * are in their own subdirectory, which is created if needed
+   *
+   * @param directory the cache's directory
+   * @param extension the artifact's extension, such as ".mxr"
+   * @return std::filesystem::path
+   */
+  [[nodiscard]] std::filesystem::path getPath(
+    const std::filesystem::path& directory, std::string_view extension) const;
+
+ private:
+  std::string backend_;
+  Hasher hasher_;
+};
+
+/**
+ * @brief Get a unique path next to an artifact to write it to before it's
+ * moved into place with publishArtifact so that no one reads it half-written
+ *
+ * @param path path to the artifact
+ * @return std::filesystem::path
+ */
+std::filesystem::path getTemporaryPath(const std::filesystem::path& path);
+
+/**
+ * @brief Move a written artifact into place in the cache. If other workers are
+ * compiling the same artifact, the last one replaces the others' identical
+ * copies. The temporary file is removed if it can't be moved
+ *
+ * @param temporary the path it was written to
+ * @param path path to the artifact
+ * @return bool true if the artifact was moved into place
+ */
+bool publishArtifact(const std::filesystem::path& temporary,
+                     const std::filesystem::path& path);
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_ARTIFACT_CACHE
@@ -20,68 +20,160 @@
 
 #include "amdinfer/util/base64.hpp"
 
-#include <stdexcept>
-
-// this define is needed for compilation but its value isn't used here
-// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
-#define BUFFERSIZE 4096
-#include <b64/decode.h>
-#include <b64/encode.h>
+#include <array>    // for array
+#include <cstdint>  // for uint8_t, uint16_t, uint32_t
+#include <cstring>  // for memcpy
 
 namespace amdinfer::util {
 
-constexpr size_t minDecodeLength(size_t length) { return (length * 3 + 3) / 4; }
+namespace {
 
-std::string base64Decode(std::string in) {
-  return base64Decode(in.data(), in.length());
+constexpr std::string_view kAlphabet =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+// marks characters that aren't in the alphabet in the decoding table
+constexpr uint8_t kInvalid = 0x80;
+
+/**
+ * @brief Make a table of the two characters that encode each 12-bit value so
+ * three bytes are encoded with two lookups instead of four
+ *
+ * @return constexpr std::array<std::array<char, 2>, 4096>
+ */
+constexpr std::array<std::array<char, 2>, 4096> makeEncodePairs() {
+  std::array<std::array<char, 2>, 4096> pairs{};
+  for (auto i = 0U; i < pairs.size(); ++i) {
+    pairs[i] = {kAlphabet[i >> 6], kAlphabet[i & 0x3F]};
+  }
+  return pairs;
 }
 
-std::string base64Decode(const char* in, size_t in_length) {
-  std::string s;
-  s.resize(minDecodeLength(in_length));
+constexpr std::array<uint8_t, 256> makeDecodeTable() {
+  std::array<uint8_t, 256> table{};
+  for (auto& value : table) {
+    value = kInvalid;
+  }
+  for (auto i = 0U; i < kAlphabet.size(); ++i) {
+    table[static_cast<uint8_t>(kAlphabet[i])] = i;
+  }
+  return table;
+}
 
-  base64::base64_decodestate state;
-  base64::base64_init_decodestate(&state);
-  int out_length = base64::base64_decode_block(in, in_length, s.data(), &state);
+constexpr auto kEncodePairs = makeEncodePairs();
+constexpr auto kDecodeTable = makeDecodeTable();
 
-  if (out_length < 0) {
-    throw std::length_error("Base64 decoded string failed");
+/// Write the three bytes of a group of 24 bits
+void writeTriple(uint32_t bits, char* out) {
+  out[0] = static_cast<char>(bits >> 16);
+  out[1] = static_cast<char>(bits >> 8);
+  out[2] = static_cast<char>(bits);
+}
+
+}  // namespace
+
+size_t base64Decode(const char* in, size_t in_length, char* out) {
+  const auto* data = reinterpret_cast<const uint8_t*>(in);
+  char* start = out;
+
+  // whole groups of four valid characters are decoded without branching on
+  // each character. The first group with padding or any other character
+  // outside of the alphabet ends the fast path
+  size_t i = 0;
+  for (; i + 4 <= in_length; i += 4) {
+    const uint32_t a = kDecodeTable[data[i]];
+    const uint32_t b = kDecodeTable[data[i + 1]];
+    const uint32_t c = kDecodeTable[data[i + 2]];
+    const uint32_t d = kDecodeTable[data[i + 3]];
+    if (((a | b | c | d) & kInvalid) != 0) {
+      break;
+    }
+    writeTriple(a << 18 | b << 12 | c << 6 | d, out);
+    out += 3;
   }
 
-  s.resize(out_length);
+  // the rest is decoded one character at a time, skipping invalid ones
+  uint32_t bits = 0;
+  auto count = 0;
+  for (; i < in_length; ++i) {
+    const uint32_t value = kDecodeTable[data[i]];
+    if ((value & kInvalid) != 0) {
+      continue;
+    }
+    bits = bits << 6 | value;
+    if (++count == 4) {
+      writeTriple(bits, out);
+      out += 3;
+      bits = 0;
+      count = 0;
+    }
+  }
+  // a partial group of two or three characters encodes one or two bytes
+  if (count >= 2) {
+    bits <<= 6 * (4 - count);
+    *out++ = static_cast<char>(bits >> 16);
+    if (count == 3) {
+      *out++ = static_cast<char>(bits >> 8);
+    }
+  }
+
+  return out - start;
+}
+
+std::string base64Decode(std::string_view in) {
+  return base64Decode(in.data(), in.length());
+}
+
+std::string base64Decode(const char* in, size_t in_length) {
+  std::string s;
+  s.resize(base64DecodedMaxLength(in_length));
+  s.resize(base64Decode(in, in_length, s.data()));
   return s;
 }
 
-/**
- * @brief Compute the minimum space needed for a base64-encoded string. Base64
- * produces 4 output bytes for every 3 input bytes.
- *
- * @param length length of the string to encode
- * @return constexpr size_t
- */
-constexpr size_t minEncodeLength(size_t length) {
-  return (((4 * length / 3) + 3) & ~3);
+size_t base64Encode(const char* in, size_t in_length, char* out) {
+  const auto* data = reinterpret_cast<const uint8_t*>(in);
+  char* start = out;
+
+  size_t i = 0;
+  for (; i + 3 <= in_length; i += 3) {
+    const uint32_t bits = static_cast<uint32_t>(data[i]) << 16 |
+                          static_cast<uint32_t>(data[i + 1]) << 8 | data[i + 2];
+    std::memcpy(out, kEncodePairs[bits >> 12].data(), 2);
+    std::memcpy(out + 2, kEncodePairs[bits & 0xFFF].data(), 2);
+    out += 4;
+  }
+
+  const auto remaining = in_length - i;
+  if (remaining > 0) {
+    uint32_t bits = static_cast<uint32_t>(data[i]) << 16;
+    if (remaining == 2) {
+      bits |= static_cast<uint32_t>(data[i + 1]) << 8;
+    }
+    out[0] = kAlphabet[bits >> 18];
+    out[1] = kAlphabet[(bits >> 12) & 0x3F];
+    out[2] = remaining == 2 ? kAlphabet[(bits >> 6) & 0x3F] : '=';
+    out[3] = '=';
+    out += 4;
+  }
+
+  return out - start;
 }
 
-std::string base64Encode(std::string in) {
+std::string base64Encode(std::string_view in) {
   return base64Encode(in.data(), in.length());
 }
 
 std::string base64Encode(const char* in, size_t in_length) {
   std::string s;
-  s.resize(minEncodeLength(in_length));
-
-  base64::base64_encodestate state;
-  base64::base64_init_encodestate(&state);
-  int code_length =
-    base64::base64_encode_block(in, in_length, s.data(), &state);
-  code_length += base64::base64_encode_blockend(s.data() + code_length, &state);
-
-  if (code_length < 0) {
-    throw std::length_error("Base64 encoding string failed");
-  }
+  s.resize(base64EncodedLength(in_length));
+  base64Encode(in, in_length, s.data());
+  return s;
+}
 
-  s.resize(code_length);
+std::string base64Encode(std::string_view in, std::string_view prefix) {
+  std::string s;
+  s.resize(prefix.size() + base64EncodedLength(in.size()));
+  prefix.copy(s.data(), prefix.size());
+  base64Encode(in.data(), in.size(), s.data() + prefix.size());
   return s;
 }
 
@@ -21,27 +21,73 @@
 #ifndef GUARD_AMDINFER_UTIL_BASE64
 #define GUARD_AMDINFER_UTIL_BASE64
 
-#include <cstddef>  // for size_t
-#include <string>   // for string
+#include <cstddef>      // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
 
 namespace amdinfer::util {
 
+/**
+ * @brief Get the length of the base64 encoding of some data, including padding
+ *
+ * @param length length of the data to encode
+ * @return size_t
+ */
+constexpr size_t base64EncodedLength(size_t length) {
+  return (length + 2) / 3 * 4;
+}
+
+/**
+ * @brief Get an upper bound on the length of the data decoded from a base64
+ * string
+ *
+ * @param length length of the encoded string
+ * @return size_t
+ */
+constexpr size_t base64DecodedMaxLength(size_t length) {
+  return (length + 3) / 4 * 3;
+}
+
+/**
+ * @brief Decodes a base64-encoded string into a caller-provided buffer.
+ * Characters outside of the base64 alphabet, such as padding and line breaks,
+ * are skipped.
+ *
+ * @param in char* to the encoded string
+ * @param in_length length of the encoded string
+ * @param out buffer with room for at least base64DecodedMaxLength(in_length)
+ * bytes
+ * @return size_t number of decoded bytes written
+ */
+size_t base64Decode(const char* in, size_t in_length, char* out);
+
 /**
  * @brief Decodes a base64-encoded string and returns it
  *
  * @param in the encoded string
  * @return std::string decoded string
  */
-std::string base64Decode(std::string in);
+std::string base64Decode(std::string_view in);
 
 /**
  * @brief Decodes a base64-encoded string and returns it
  *
  * @param in char* to the encoded string
- * @param in_len length of the encoded string
+ * @param in_length length of the encoded string
  * @return std::string decoded string
  */
-std::string base64Decode(const char* in, size_t in_len);
+std::string base64Decode(const char* in, size_t in_length);
+
+/**
+ * @brief Encodes data with base64 into a caller-provided buffer
+ *
+ * @param in char* to the data
+ * @param in_length length of the data
+ * @param out buffer with room for at least base64EncodedLength(in_length)
+ * bytes
+ * @return size_t number of encoded bytes written
+ */
+size_t base64Encode(const char* in, size_t in_length, char* out);
 
 /**
  * @brief Encodes a string with base64 and returns it
@@ -49,7 +95,7 @@ std::string base64Decode(const char* in, size_t in_len);
  * @param in string to encode
  * @return std::string encoded string
  */
-std::string base64Encode(std::string in);
+std::string base64Encode(std::string_view in);
 
 /**
  * @brief Encodes a string with base64 and returns it
@@ -59,6 +105,17 @@ std::string base64Encode(std::string in);
  * @return std::string encoded string
  */
 std::string base64Encode(const char* in, size_t in_len);
+
+/**
+ * @brief Encodes a string with base64 and returns it after a prefix, such as
+ * "data:image/jpg;base64,", without building intermediate strings
+ *
+ * @param in string to encode
+ * @param prefix string to put before the encoded string
+ * @return std::string prefix followed by the encoded string
+ */
+std::string base64Encode(std::string_view in, std::string_view prefix);
+
 }  // namespace amdinfer::util
 
 #endif  // GUARD_AMDINFER_UTIL_BASE64
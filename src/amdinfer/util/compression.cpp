@@ -16,40 +16,314 @@
 #include "amdinfer/util/compression.hpp"
 
 #include <zlib.h>  // for z_stream, inflate, inflateEnd, Z_OK, Z_NO_FLUSH
+#include <zstd.h>  // for ZSTD_decompressStream, ZSTD_compress
 
-#include <array>    // for array
-#include <cstring>  // for memset
+#include <algorithm>  // for min
+#include <array>      // for array
+#include <cstdint>    // for uint8_t, uint32_t
+#include <limits>     // for numeric_limits
+#include <memory>     // for unique_ptr
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/util/string.hpp"      // for split, toLower
 
 namespace amdinfer::util {
 
-std::string zDecompress(const char *str, int len) {
-  const auto chunk_size = 32'768;
+namespace {
 
-  // z_stream is zlib's control structure. Initialize to zero/null
-  z_stream zs;
-  memset(&zs, 0, sizeof(zs));
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-  zs.next_in = const_cast<Bytef *>(reinterpret_cast<const Bytef *>(str));
-  zs.avail_in = len;
-  inflateInit(&zs);
+constexpr auto kChunkSize = 32'768;
+// zlib detects zlib and gzip headers with this window size
+constexpr auto kAutoWindowBits = 15 + 32;
+constexpr auto kGzipWindowBits = 15 + 16;
+constexpr auto kZlibWindowBits = 15;
+constexpr auto kMemLevel = 8;
+// fast levels because responses are compressed on the request path
+constexpr auto kZlibLevel = 1;
+constexpr auto kZstdLevel = 1;
+
+std::string_view trim(std::string_view str) {
+  const auto* whitespace = " \t";
+  const auto begin = str.find_first_not_of(whitespace);
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  const auto end = str.find_last_not_of(whitespace);
+  return str.substr(begin, end - begin + 1);
+}
+
+/// Tracks the decompressed size and passes chunks to the sink
+class LimitedSink {
+ public:
+  LimitedSink(size_t max_size, const DecompressSink &sink)
+    : max_size_(max_size), sink_(sink) {}
+
+  void operator()(const char *data, size_t length) {
+    if (length > max_size_ - size_) {
+      throw invalid_argument("Decompressed body is larger than " +
+                             std::to_string(max_size_) + " bytes");
+    }
+    size_ += length;
+    if (length > 0) {
+      sink_(data, length);
+    }
+  }
+
+ private:
+  size_t max_size_;
+  size_t size_ = 0;
+  const DecompressSink &sink_;
+};
+
+void inflateChunks(const char *data, size_t length, LimitedSink &sink) {
+  z_stream zs{};
+  if (inflateInit2(&zs, kAutoWindowBits) != Z_OK) {
+    throw runtime_error("Failed to initialize zlib");
+  }
+  std::unique_ptr<z_stream, decltype(&inflateEnd)> guard{&zs, inflateEnd};
 
-  int ret = Z_OK;
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init, hicpp-member-init)
-  std::array<char, chunk_size> out_buffer;
-  std::string out_string;
-  do {
+  std::array<char, kChunkSize> out_buffer;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  zs.next_in = const_cast<Bytef *>(reinterpret_cast<const Bytef *>(data));
+  size_t remaining = length;
+  int ret = Z_OK;
+  while (ret != Z_STREAM_END) {
+    if (zs.avail_in == 0) {
+      if (remaining == 0) {
+        throw invalid_argument("Compressed body is truncated");
+      }
+      zs.avail_in = static_cast<uInt>(
+        std::min<size_t>(remaining, std::numeric_limits<uInt>::max()));
+      remaining -= zs.avail_in;
+    }
     zs.next_out = reinterpret_cast<Bytef *>(out_buffer.data());
     zs.avail_out = out_buffer.size();
     ret = inflate(&zs, Z_NO_FLUSH);
-    if (out_string.size() < zs.total_out) {
-      out_string.append(out_buffer.data(), zs.total_out - out_string.size());
+    if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+      throw invalid_argument("Failed to decompress body");
+    }
+    sink(out_buffer.data(), out_buffer.size() - zs.avail_out);
+  }
+}
+
+void zstdChunks(const char *data, size_t length, LimitedSink &sink) {
+  std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context{
+    ZSTD_createDCtx(), ZSTD_freeDCtx};
+  if (context == nullptr) {
+    throw runtime_error("Failed to initialize zstd");
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init, hicpp-member-init)
+  std::array<char, kChunkSize> out_buffer;
+  ZSTD_inBuffer input{data, length, 0};
+  size_t ret = 1;
+  // a return of zero means a frame is complete and flushed
+  while (input.pos < input.size || ret != 0) {
+    ZSTD_outBuffer output{out_buffer.data(), out_buffer.size(), 0};
+    ret = ZSTD_decompressStream(context.get(), &output, &input);
+    if (ZSTD_isError(ret) != 0) {
+      throw invalid_argument(std::string{"Failed to decompress body: "} +
+                             ZSTD_getErrorName(ret));
+    }
+    if (ret != 0 && input.pos == input.size && output.pos < output.size) {
+      throw invalid_argument("Compressed body is truncated");
     }
-  } while (ret == Z_OK);
-  inflateEnd(&zs);
-  if (ret == Z_STREAM_END) {
-    return out_string;
+    sink(out_buffer.data(), output.pos);
+  }
+}
+
+/// Get the decompressed size recorded in the data, if any
+size_t getSizeHint(Encoding encoding, const char *data, size_t length) {
+  if (encoding == Encoding::Gzip && length >= 4) {
+    // the gzip trailer ends with the size modulo 2^32 in little-endian
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data + length - 4);
+    return static_cast<uint32_t>(bytes[0]) |
+           static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 |
+           static_cast<uint32_t>(bytes[3]) << 24;
+  }
+  if (encoding == Encoding::Zstd) {
+    const auto size = ZSTD_getFrameContentSize(data, length);
+    if (size != ZSTD_CONTENTSIZE_UNKNOWN && size != ZSTD_CONTENTSIZE_ERROR) {
+      return size;
+    }
+  }
+  return 0;
+}
+
+std::string deflateData(const char *data, size_t length, int window_bits) {
+  z_stream zs{};
+  if (deflateInit2(&zs, kZlibLevel, Z_DEFLATED, window_bits, kMemLevel,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw runtime_error("Failed to initialize zlib");
+  }
+  std::unique_ptr<z_stream, decltype(&deflateEnd)> guard{&zs, deflateEnd};
+
+  std::string out;
+  out.resize(deflateBound(&zs, length));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  zs.next_in = const_cast<Bytef *>(reinterpret_cast<const Bytef *>(data));
+  zs.avail_in = length;
+  zs.next_out = reinterpret_cast<Bytef *>(out.data());
+  zs.avail_out = out.size();
+  if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+    throw runtime_error("Failed to compress data");
+  }
+  out.resize(zs.total_out);
+  return out;
+}
+
+}  // namespace
+
+Encoding parseEncoding(std::string_view header) {
+  const auto name = toLower(std::string{trim(header)});
+  if (name.empty() || name == "identity") {
+    return Encoding::Identity;
+  }
+  if (name == "gzip" || name == "x-gzip") {
+    return Encoding::Gzip;
+  }
+  if (name == "deflate") {
+    return Encoding::Deflate;
+  }
+  if (name == "zstd") {
+    return Encoding::Zstd;
+  }
+  throw invalid_argument("Unsupported Content-Encoding: " + name);
+}
+
+Encoding negotiateEncoding(std::string_view header) {
+  bool gzip = false;
+  bool deflate = false;
+  bool zstd = false;
+  for (const auto &item : split(header, ",")) {
+    const auto parameters = split(item, ";");
+    if (parameters.empty()) {
+      continue;
+    }
+    const auto name = toLower(std::string{trim(parameters[0])});
+    // q=0 means the encoding is not acceptable
+    bool acceptable = true;
+    for (auto i = 1U; i < parameters.size(); ++i) {
+      const auto parameter = trim(parameters[i]);
+      if (parameter.substr(0, 2) == "q=") {
+        const auto q = parameter.substr(2);
+        acceptable = q.find_first_not_of("0.") != std::string_view::npos;
+      }
+    }
+    if (!acceptable) {
+      continue;
+    }
+    const bool any = name == "*";
+    gzip |= any || name == "gzip" || name == "x-gzip";
+    deflate |= any || name == "deflate";
+    zstd |= any || name == "zstd";
+  }
+
+  if (zstd) {
+    return Encoding::Zstd;
+  }
+  if (gzip) {
+    return Encoding::Gzip;
+  }
+  if (deflate) {
+    return Encoding::Deflate;
+  }
+  return Encoding::Identity;
+}
+
+std::string_view toString(Encoding encoding) {
+  switch (encoding) {
+    case Encoding::Identity:
+      return "identity";
+    case Encoding::Deflate:
+      return "deflate";
+    case Encoding::Gzip:
+      return "gzip";
+    case Encoding::Zstd:
+      return "zstd";
+  }
+  return "identity";
+}
+
+Encoding sniffEncoding(const char *data, size_t length) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+  if (length >= 2 && bytes[0] == 0x1F && bytes[1] == 0x8B) {
+    return Encoding::Gzip;
+  }
+  if (length >= 4 && bytes[0] == 0x28 && bytes[1] == 0xB5 &&
+      bytes[2] == 0x2F && bytes[3] == 0xFD) {
+    return Encoding::Zstd;
+  }
+  // a zlib header uses deflate with a window of at most 32K and is a
+  // multiple of 31
+  constexpr auto kZlibCheck = 31;
+  if (length >= 2 && (bytes[0] & 0x8F) == 0x08 &&
+      ((bytes[0] << 8) | bytes[1]) % kZlibCheck == 0) {
+    return Encoding::Deflate;
+  }
+  return Encoding::Identity;
+}
+
+void decompress(Encoding encoding, const char *data, size_t length,
+                size_t max_size, const DecompressSink &sink) {
+  LimitedSink limited{max_size, sink};
+  switch (encoding) {
+    case Encoding::Identity:
+      limited(data, length);
+      break;
+    case Encoding::Deflate:
+    case Encoding::Gzip:
+      inflateChunks(data, length, limited);
+      break;
+    case Encoding::Zstd:
+      zstdChunks(data, length, limited);
+      break;
+  }
+}
+
+std::string decompress(Encoding encoding, const char *data, size_t length,
+                       size_t max_size) {
+  std::string out;
+  out.reserve(std::min(getSizeHint(encoding, data, length), max_size));
+  decompress(encoding, data, length, max_size,
+             [&out](const char *chunk, size_t chunk_length) {
+               out.append(chunk, chunk_length);
+             });
+  return out;
+}
+
+std::string compress(Encoding encoding, const char *data, size_t length) {
+  switch (encoding) {
+    case Encoding::Identity:
+      return {data, length};
+    case Encoding::Deflate:
+      return deflateData(data, length, kZlibWindowBits);
+    case Encoding::Gzip:
+      return deflateData(data, length, kGzipWindowBits);
+    case Encoding::Zstd: {
+      std::string out;
+      out.resize(ZSTD_compressBound(length));
+      const auto size =
+        ZSTD_compress(out.data(), out.size(), data, length, kZstdLevel);
+      if (ZSTD_isError(size) != 0) {
+        throw runtime_error(std::string{"Failed to compress data: "} +
+                            ZSTD_getErrorName(size));
+      }
+      out.resize(size);
+      return out;
+    }
+  }
+  return {data, length};
+}
+
+std::string zDecompress(const char *str, int len) {
+  try {
+    return decompress(Encoding::Deflate, str, len,
+                      std::numeric_limits<size_t>::max());
+  } catch (const invalid_argument &) {
+    return "";
   }
-  return "";
 }
 
 }  // namespace amdinfer::util
@@ -16,16 +16,106 @@
 #ifndef GUARD_AMDINFER_HELPERS_COMPRESSION
 #define GUARD_AMDINFER_HELPERS_COMPRESSION
 
-#include <string>
+#include <cstddef>      // for size_t
+#include <functional>   // for function
+#include <string>       // for string
+#include <string_view>  // for string_view
 
 namespace amdinfer::util {
 
+/// Content codings used for HTTP bodies
+enum class Encoding {
+  Identity,
+  /// zlib-wrapped deflate
+  Deflate,
+  Gzip,
+  Zstd
+};
+
+/// Called with each chunk of decompressed data
+using DecompressSink = std::function<void(const char *data, size_t length)>;
+
+/**
+ * @brief Get the encoding named by a Content-Encoding header. An empty header
+ * is the identity encoding.
+ *
+ * @param header value of the header
+ * @return Encoding
+ * @throws invalid_argument if the encoding isn't supported
+ */
+Encoding parseEncoding(std::string_view header);
+
+/**
+ * @brief Choose the encoding for a response from the client's Accept-Encoding
+ * header, preferring zstd, then gzip and then deflate
+ *
+ * @param header value of the header
+ * @return Encoding the identity encoding if none are accepted
+ */
+Encoding negotiateEncoding(std::string_view header);
+
+/**
+ * @brief Get the name of the encoding as used in HTTP headers
+ *
+ * @param encoding the encoding
+ * @return std::string_view
+ */
+std::string_view toString(Encoding encoding);
+
+/**
+ * @brief Guess the encoding of data that may be compressed without a header
+ * from the magic bytes at its start
+ *
+ * @param data the data
+ * @param length length of the data
+ * @return Encoding the identity encoding if it doesn't look compressed
+ */
+Encoding sniffEncoding(const char *data, size_t length);
+
+/**
+ * @brief Decompress data in fixed-size chunks that are passed to the sink as
+ * they're produced so no copy of the whole output is needed
+ *
+ * @param encoding encoding of the data
+ * @param data the compressed data
+ * @param length length of the compressed data
+ * @param max_size the decompressed data may not be larger than this
+ * @param sink called with each decompressed chunk
+ * @throws invalid_argument if the data is corrupt or too large
+ */
+void decompress(Encoding encoding, const char *data, size_t length,
+                size_t max_size, const DecompressSink &sink);
+
+/**
+ * @brief Decompress data into a string. The string is sized up front from the
+ * size recorded in gzip and zstd data so it's only allocated once.
+ *
+ * @param encoding encoding of the data
+ * @param data the compressed data
+ * @param length length of the compressed data
+ * @param max_size the decompressed data may not be larger than this
+ * @return std::string the decompressed data
+ * @throws invalid_argument if the data is corrupt or too large
+ */
+std::string decompress(Encoding encoding, const char *data, size_t length,
+                       size_t max_size);
+
+/**
+ * @brief Compress data with a fast compression level suited to responses
+ *
+ * @param encoding the encoding to use
+ * @param data the data
+ * @param length length of the data
+ * @return std::string the compressed data
+ */
+std::string compress(Encoding encoding, const char *data, size_t length);
+
 /**
  * @brief Inflate a deflated (i.e. compressed) argument with zlib
  *
  * @param str the deflated string as a char*
  * @param len length of the deflated string
- * @return std::string the inflated string
+ * @return std::string the inflated string or an empty string if it's invalid
  */
 std::string zDecompress(const char *str, int len);
 
@@ -0,0 +1,94 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the detection of the CPU's vector instructions
+ */
+
+#include "amdinfer/util/cpu_features.hpp"
+
+#include <algorithm>  // for min
+#include <cstdlib>    // for getenv
+#include <string>     // for string
+
+namespace amdinfer::util {
+
+namespace {
+
+CpuFeatures detectCpuFeatures() {
+  CpuFeatures features;
+#ifdef __x86_64__
+  // the checks include whether the OS saves the vector registers
+  __builtin_cpu_init();
+  // __builtin_cpu_supports only takes literals
+  features.avx = __builtin_cpu_supports("avx") != 0;
+  features.avx2 = __builtin_cpu_supports("avx2") != 0;
+  features.fma = __builtin_cpu_supports("fma") != 0;
+  features.f16c = __builtin_cpu_supports("f16c") != 0;
+  features.avx512f = __builtin_cpu_supports("avx512f") != 0;
+  features.avx512bw = __builtin_cpu_supports("avx512bw") != 0;
+  features.avx512dq = __builtin_cpu_supports("avx512dq") != 0;
+  features.avx512vl = __builtin_cpu_supports("avx512vl") != 0;
+  features.avx512vnni = __builtin_cpu_supports("avx512vnni") != 0;
+#endif
+  return features;
+}
+
+CpuIsa detectCpuIsa() {
+  const auto& features = getCpuFeatures();
+  auto isa = CpuIsa::Scalar;
+  if (features.avx2 && features.fma && features.f16c) {
+    isa = CpuIsa::Avx2;
+    if (features.avx512f && features.avx512bw && features.avx512dq &&
+        features.avx512vl) {
+      isa = CpuIsa::Avx512;
+    }
+  }
+
+  if (const auto* cap = std::getenv("AMDINFER_CPU_ISA"); cap != nullptr) {
+    const std::string value{cap};
+    for (const auto other : {CpuIsa::Scalar, CpuIsa::Avx2, CpuIsa::Avx512}) {
+      if (value == toString(other)) {
+        isa = std::min(isa, other);
+      }
+    }
+  }
+  return isa;
+}
+
+}  // namespace
+
+const CpuFeatures& getCpuFeatures() {
+  static const auto features = detectCpuFeatures();
+  return features;
+}
+
+CpuIsa getCpuIsa() {
+  static const auto isa = detectCpuIsa();
+  return isa;
+}
+
+std::string toString(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::Avx2:
+      return "avx2";
+    case CpuIsa::Avx512:
+      return "avx512";
+    default:
+      return "scalar";
+  }
+}
+
+}  // namespace amdinfer::util
@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the detection of the CPU's vector instructions and the
+ * selection of kernels compiled for them
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_CPU_FEATURES
+#define GUARD_AMDINFER_UTIL_CPU_FEATURES
+
+#include <string>  // for string
+
+namespace amdinfer::util {
+
+/// The vector instructions that the CPU supports, detected once at startup
+struct CpuFeatures {
+  bool avx = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool f16c = false;
+  bool avx512f = false;
+  bool avx512bw = false;
+  bool avx512dq = false;
+  bool avx512vl = false;
+  bool avx512vnni = false;
+};
+
+/**
+ * @brief The instruction sets that kernels are compiled for, in increasing
+ * order. Each one includes the ones before it
+ */
+enum class CpuIsa {
+  Scalar,  ///< the baseline that every x86-64 or other CPU runs
+  Avx2,    ///< AVX2, FMA and F16C, such as on Zen 2 and 3
+  Avx512,  ///< AVX-512 F, BW, DQ and VL as well, such as on Zen 4
+};
+
+/// Get the vector instructions that the CPU supports
+const CpuFeatures& getCpuFeatures();
+
+/**
+ * @brief Get the best instruction set that the CPU supports. Setting the
+ * AMDINFER_CPU_ISA environment variable to scalar, avx2 or avx512 caps it,
+ * such as to compare kernels or rule one out
+ *
+ * @return CpuIsa
+ */
+CpuIsa getCpuIsa();
+
+std::string toString(CpuIsa isa);
+
+/**
+ * @brief The variants of a kernel for each instruction set. Variants that
+ * aren't compiled are left null and the best one that's compiled and that the
+ * CPU supports is used
+ *
+ * @tparam Kernel a function pointer
+ */
+template <typename Kernel>
+struct IsaKernels {
+  Kernel scalar;
+  Kernel avx2 = nullptr;
+  Kernel avx512 = nullptr;
+};
+
+/**
+ * @brief Select a kernel for an instruction set. Callers keep the result in a
+ * function-local static so it's selected once
+ *
+ * @tparam Kernel a function pointer
+ * @param kernels the variants of the kernel
+ * @param isa the best instruction set to use
+ * @return Kernel
+ */
+template <typename Kernel>
+Kernel selectKernel(const IsaKernels<Kernel>& kernels,
+                    CpuIsa isa = getCpuIsa()) {
+  if (isa >= CpuIsa::Avx512 && kernels.avx512 != nullptr) {
+    return kernels.avx512;
+  }
+  if (isa >= CpuIsa::Avx2 && kernels.avx2 != nullptr) {
+    return kernels.avx2;
+  }
+  return kernels.scalar;
+}
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_CPU_FEATURES
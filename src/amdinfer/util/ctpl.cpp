@@ -17,20 +17,33 @@
 #include "amdinfer/util/ctpl.hpp"
 
 #include <algorithm>           // for max
+#include <chrono>              // for steady_clock, duration
 #include <ext/alloc_traits.h>  // for __alloc_traits<>::value_type
+#include <utility>             // for move
 
-#include "amdinfer/util/thread.hpp"  // for setThreadName
+#include "amdinfer/build_options.hpp"        // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/observation/metrics.hpp"  // for Metrics, MetricCounterIDs
+#include "amdinfer/util/numa.hpp"            // for bindThreadToCpus
+#include "amdinfer/util/thread.hpp"          // for setThreadName
 
 namespace amdinfer::util {
 
-constexpr auto kThreadPoolLength = 100;
+namespace {
 
-ThreadPool::ThreadPool() : ThreadPool(0, kThreadPoolLength) {}
+// the pool and queue of the calling thread if it's in a pool
+thread_local const ThreadPool *t_pool = nullptr;
+thread_local size_t t_queue = 0;
 
-ThreadPool::ThreadPool(int thread_num)
-  : ThreadPool(thread_num, kThreadPoolLength) {}
+}  // namespace
 
-ThreadPool::ThreadPool(int thread_num, int queue_size) : q_(queue_size) {
+ThreadPool::ThreadPool() : ThreadPool(0) {}
+
+ThreadPool::ThreadPool(int thread_num) : ThreadPool(thread_num, {}) {}
+
+ThreadPool::ThreadPool(int thread_num, std::vector<int> cpus)
+  : cpus_(std::move(cpus)) {
+  // functions pushed before there are threads wait in the first queue
+  queues_.push_back(std::make_unique<Queue>());
   if (thread_num > 0) {
     this->resize(thread_num);
   }
@@ -55,54 +68,71 @@ void ThreadPool::resize(int thread_num) {
     auto old_thread_num = static_cast<int>(threads_.size());
     if (old_thread_num <=
         thread_num) {  // if the number of threads is increased
+      {
+        const std::unique_lock lock{queues_mutex_};
+        while (static_cast<int>(queues_.size()) < thread_num) {
+          queues_.push_back(std::make_unique<Queue>());
+        }
+      }
       threads_.resize(thread_num);
       flags_.resize(thread_num);
 
       for (int i = old_thread_num; i < thread_num; ++i) {
         flags_[i] = std::make_shared<std::atomic<bool>>(false);
         this->setThread(i);
+        this->pinThread(i);
       }
     } else {  // the number of threads is decreased
       for (int i = old_thread_num - 1; i >= thread_num; --i) {
         *flags_[i] = true;  // this thread will finish
-        threads_[i]->detach();
+        retired_.push_back(std::move(threads_[i]));
       }
       {
-        // stop the detached threads that were waiting
+        // stop the removed threads that were waiting
         std::unique_lock lock(mutex_);
         cv_.notify_all();
       }
-      // safe to delete because the threads are detached
+      // the removed threads are joined when the pool stops
       threads_.resize(thread_num);
       flags_.resize(
         thread_num);  // safe to delete because the threads have copies of
                       // shared_ptr of the flags, not originals
     }
+    size_ = thread_num;
+  }
+}
+
+void ThreadPool::setCpus(std::vector<int> cpus) {
+  cpus_ = std::move(cpus);
+  for (int i = 0, n = this->getSize(); i < n; ++i) {
+    this->pinThread(i);
+  }
+}
+
+void ThreadPool::pinThread(int i) {
+  if (!cpus_.empty()) {
+    const auto cpu = cpus_[static_cast<size_t>(i) % cpus_.size()];
+    util::bindThreadToCpus(*threads_[i], {cpu});
   }
 }
 
 // empty the queue
 void ThreadPool::clearQueue() {
-  std::function<void(int id)> *f_new = nullptr;
-  while (q_.try_dequeue(f_new)) {
-    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-    delete f_new;  // empty the queue
+  const std::shared_lock queues_lock{queues_mutex_};
+  for (const auto &queue : queues_) {
+    const std::lock_guard lock{queue->mutex};
+    pending_ -= queue->entries.size();
+    queue->entries.clear();
   }
 }
 
 // pops a functional wrapper to the original function
 std::function<void(int)> ThreadPool::pop() {
-  std::function<void(int id)> *f_new = nullptr;
-  q_.try_dequeue(f_new);
-  // at return, delete the function even if an exception occurred
-  std::unique_ptr<std::function<void(int id)>> func;
-  func.reset(f_new);
-
-  std::function<void(int)> f;
-  if (f_new != nullptr) {
-    f = *f_new;
+  Entry entry;
+  if (this->take(0, &entry)) {
+    return std::move(entry.task);
   }
-  return f;
+  return {};
 }
 
 // wait for all computing threads to finish and stop all threads
@@ -134,11 +164,89 @@ void ThreadPool::stop(bool wait) {
       thread->join();
     }
   }
+  for (const auto &thread : retired_) {
+    thread->join();
+  }
+  retired_.clear();
   // if there were no threads in the pool but some functors in the queue, the
-  // functors are not deleted by the threads therefore delete them here
+  // functors are not run by the threads therefore delete them here
   this->clearQueue();
   threads_.clear();
   flags_.clear();
+  size_ = 0;
+}
+
+void ThreadPool::pushBulk(std::vector<Task> tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+  const auto queued = std::chrono::steady_clock::now();
+  {
+    const std::shared_lock queues_lock{queues_mutex_};
+    for (auto &task : tasks) {
+      auto &queue = *queues_[this->nextQueue()];
+      const std::lock_guard lock{queue.mutex};
+      pending_++;
+      queue.entries.push_back(Entry{std::move(task), queued});
+    }
+  }
+
+  std::unique_lock lock(mutex_);
+  cv_.notify_all();
+}
+
+size_t ThreadPool::nextQueue() {
+  if (t_pool == this) {
+    return t_queue;
+  }
+  const auto size = static_cast<size_t>(std::max(size_.load(), 1));
+  return next_++ % size;
+}
+
+void ThreadPool::enqueue(Task task) {
+  {
+    const std::shared_lock queues_lock{queues_mutex_};
+    auto &queue = *queues_[this->nextQueue()];
+    const std::lock_guard lock{queue.mutex};
+    // counted first so a thread that takes it never sees it missing
+    pending_++;
+    queue.entries.push_back(
+      Entry{std::move(task), std::chrono::steady_clock::now()});
+  }
+
+  std::unique_lock lock(mutex_);
+  cv_.notify_one();
+}
+
+bool ThreadPool::take(size_t i, Entry *entry) {
+  if (pending_ == 0) {
+    return false;
+  }
+
+  const std::shared_lock queues_lock{queues_mutex_};
+  const auto count = queues_.size();
+  for (auto j = 0U; j < count; ++j) {
+    auto &queue = *queues_[(i + j) % count];
+    const std::lock_guard lock{queue.mutex};
+    if (queue.entries.empty()) {
+      continue;
+    }
+    // run our own functions in order but steal from the other end
+    if (j == 0) {
+      *entry = std::move(queue.entries.front());
+      queue.entries.pop_front();
+    } else {
+      *entry = std::move(queue.entries.back());
+      queue.entries.pop_back();
+#ifdef AMDINFER_ENABLE_METRICS
+      Metrics::getInstance().incrementCounter(
+        MetricCounterIDs::ThreadPoolSteals);
+#endif
+    }
+    pending_--;
+    return true;
+  }
+  return false;
 }
 
 void ThreadPool::setThread(int i) {
@@ -146,33 +254,38 @@ void ThreadPool::setThread(int i) {
     flags_[i]);  // a copy of the shared ptr to the flag
   auto f = [this, i, flag /* a copy of the shared ptr to the flag */]() {
     amdinfer::util::setThreadName("ctplPool");
+    t_pool = this;
+    t_queue = static_cast<size_t>(i);
     const std::atomic<bool> &flag_ref = *flag;
-    std::function<void(int id)> *f_new = nullptr;
-    bool is_pop = q_.try_dequeue(f_new);
+    Entry entry;
     while (true) {
-      while (is_pop) {  // if there is anything in the queue
-        // at return, delete the function even if an exception occurred
-        std::unique_ptr<std::function<void(int id)>> func(f_new);
-        (*f_new)(i);
-
-        // the thread is wanted to stop, return even if queue is not empty yet
-        if (flag_ref) {
-          return;
-        }
-        is_pop = q_.try_dequeue(f_new);
+      // threads that are being removed stop taking new functions
+      while (!flag_ref && this->take(t_queue, &entry)) {
+#ifdef AMDINFER_ENABLE_METRICS
+        const std::chrono::duration<double, std::micro> waited =
+          std::chrono::steady_clock::now() - entry.queued;
+        Metrics::getInstance().observeHistogram(
+          MetricHistogramIDs::ThreadPoolQueueWait, waited.count());
+#endif
+        // move it out so its captures are released once it's run
+        auto task = std::move(entry.task);
+        task(i);
+      }
+      // the thread is wanted to stop, return even if queue is not empty yet
+      if (flag_ref) {
+        return;
       }
 
-      // the queue is empty here, wait for the next command
+      // the queues are empty here, wait for the next command
       std::unique_lock lock(mutex_);
       ++waiting_;
-      cv_.wait(lock, [this, &f_new, &is_pop, &flag_ref]() {
-        is_pop = q_.try_dequeue(f_new);
-        return is_pop || done_ || flag_ref;
+      cv_.wait(lock, [this, &flag_ref]() {
+        return pending_ > 0 || done_ || flag_ref;
       });
       --waiting_;
 
-      // if the queue is empty and done_ == true or *flag then return
-      if (!is_pop) {
+      // if the queues are empty and done_ == true or *flag then return
+      if (flag_ref || (done_ && pending_ == 0)) {
         return;
       }
     }
@@ -17,14 +17,16 @@
 #ifndef GUARD_AMDINFER_UTIL_CTPL
 #define GUARD_AMDINFER_UTIL_CTPL
 
-#include <concurrentqueue/concurrentqueue.h>  // for ConcurrentQueue
-
 #include <atomic>              // for atomic
+#include <chrono>              // for steady_clock
 #include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <deque>               // for deque
 #include <functional>          // for function, _1, bind
 #include <future>              // for future, packaged_task
 #include <memory>              // for make_shared, shared_ptr
 #include <mutex>               // for mutex
+#include <shared_mutex>        // for shared_mutex
 #include <thread>              // for thread
 #include <utility>             // for forward
 #include <vector>              // for vector
@@ -40,12 +42,21 @@ namespace amdinfer::util {
  * @brief The thread pool is configured with a number of threads and accepts
  * lambdas as functions to run in one of the threads in the pool.
  *
+ * Each thread has its own queue of functions. Functions pushed from outside
+ * the pool are spread over the queues in turn and functions pushed from a
+ * thread in the pool go to its own queue. Threads run their own functions in
+ * order and take the newest functions from the other queues when theirs is
+ * empty, so a thread that's stuck on a long function doesn't hold up the rest
+ * of its queue.
  */
 class ThreadPool {
  public:
+  using Task = std::function<void(int id)>;
+
   ThreadPool();
   explicit ThreadPool(int thread_num);
-  ThreadPool(int thread_num, int queue_size);
+  /// Construct a pool whose threads are pinned to the CPUs, one CPU each
+  ThreadPool(int thread_num, std::vector<int> cpus);
 
   ThreadPool(const ThreadPool &) = delete;
   ThreadPool(ThreadPool &&) = delete;
@@ -67,6 +78,15 @@ class ThreadPool {
   // also with this->stop() nThreads must be >= 0
   void resize(int thread_num);
 
+  /**
+   * @brief Pin the threads to CPUs, giving thread i the CPU at index i modulo
+   * the number of CPUs. Threads added later are pinned too. An empty list
+   * leaves new threads unpinned.
+   *
+   * @param cpus the CPUs to use
+   */
+  void setCpus(std::vector<int> cpus);
+
   // empty the queue
   void clearQueue();
 
@@ -79,23 +99,22 @@ class ThreadPool {
   // queue is cleared without running the functions
   void stop(bool wait = false);
 
+  /**
+   * @brief Push several functions at once. They're spread over the threads'
+   * queues and the idle threads are woken once for all of them. Unlike push,
+   * no futures are made so the functions should report their own results.
+   *
+   * @param tasks the functions to run
+   */
+  void pushBulk(std::vector<Task> tasks);
+
   template <typename F, typename... Rest>
   auto push(F &&f, Rest &&...rest) -> std::future<decltype(f(0, rest...))> {
     auto pck =
       std::make_shared<std::packaged_task<decltype(f(0, rest...))(int)>>(
         std::bind(std::forward<F>(f), std::placeholders::_1,
                   std::forward<Rest>(rest)...));
-
-    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-    auto *f_new =
-      new std::function<void(int id)>([pck](int id) { (*pck)(id); });
-    q_.enqueue(f_new);
-
-    // tidy thinks this may leak f_new. Should refactor to use smart pointers
-    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
-    std::unique_lock lock(mutex_);
-    cv_.notify_one();
-
+    this->enqueue([pck](int id) { (*pck)(id); });
     return pck->get_future();
   }
 
@@ -106,29 +125,48 @@ class ThreadPool {
   auto push(F &&f) -> std::future<decltype(f(0))> {
     auto pck = std::make_shared<std::packaged_task<decltype(f(0))(int)>>(
       std::forward<F>(f));
-
-    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-    auto *f_new =
-      new std::function<void(int id)>([pck](int id) { (*pck)(id); });
-    q_.enqueue(f_new);
-
-    // tidy thinks this may leak f_new. Should refactor to use smart pointers
-    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
-    std::unique_lock lock(mutex_);
-    cv_.notify_one();
-
+    this->enqueue([pck](int id) { (*pck)(id); });
     return pck->get_future();
   }
 
  private:
+  struct Entry {
+    Task task;
+    /// When the function was queued to measure how long it waited
+    std::chrono::steady_clock::time_point queued;
+  };
+  /// One thread's functions
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Entry> entries;
+  };
+
+  /// Get the queue to push to from the calling thread
+  size_t nextQueue();
+  void enqueue(Task task);
+  /// Take the next function from a thread's queue or steal one from another
+  bool take(size_t i, Entry *entry);
   void setThread(int i);
+  void pinThread(int i);
 
   std::vector<std::unique_ptr<std::thread>> threads_;
+  /// Threads removed by resize that may still be finishing their function
+  std::vector<std::unique_ptr<std::thread>> retired_;
   std::vector<std::shared_ptr<std::atomic<bool>>> flags_;
-  mutable moodycamel::ConcurrentQueue<std::function<void(int id)> *> q_;
+  /**
+   * @brief The threads' queues. A queue is kept after its thread is removed so
+   * its functions can still be stolen. Adding queues takes the lock uniquely
+   * and everything else takes it shared.
+   */
+  std::vector<std::unique_ptr<Queue>> queues_;
+  mutable std::shared_mutex queues_mutex_;
+  std::vector<int> cpus_;
   std::atomic<bool> done_ = false;
   std::atomic<bool> stop_ = false;
   std::atomic<int> waiting_ = 0;  // how many threads are waiting
+  std::atomic<int> size_ = 0;     // how many threads are running
+  std::atomic<size_t> pending_ = 0;
+  std::atomic<size_t> next_ = 0;
 
   std::mutex mutex_;
   std::condition_variable cv_;
@@ -14,7 +14,13 @@
 
 #include "amdinfer/util/filesystem.hpp"
 
+#include <fcntl.h>     // for open, O_RDONLY, O_CLOEXEC
+#include <sys/mman.h>  // for mmap, madvise, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for close
+
 #include <fstream>
+#include <utility>
 
 #include "amdinfer/core/exceptions.hpp"
 
@@ -58,4 +64,55 @@ std::string readFile(const std::string& path) {
   return out;
 }
 
+MappedFile::MappedFile(const fs::path& path) {
+  if (!fs::exists(path)) {
+    throw file_not_found_error("File " + path.string() + " does not exist");
+  }
+  const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw file_read_error("Could not open " + path.string());
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0) {
+    close(fd);
+    throw file_read_error("Could not get the size of " + path.string());
+  }
+  size_ = static_cast<size_t>(status.st_size);
+
+  // empty files can't be mapped
+  if (size_ > 0) {
+    auto* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      close(fd);
+      throw file_read_error("Could not map " + path.string());
+    }
+    // the parsers read models from start to end
+    madvise(address, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<std::byte*>(address);
+  }
+  // the mapping stays valid after the file is closed
+  close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
 }  // namespace amdinfer::util
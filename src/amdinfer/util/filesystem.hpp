@@ -15,10 +15,44 @@
 #ifndef GUARD_AMDINFER_UTIL_FILESYSTEM
 #define GUARD_AMDINFER_UTIL_FILESYSTEM
 
+#include <cstddef>
 #include <filesystem>
+#include <string>
 
 namespace amdinfer::util {
 
+/**
+ * @brief Maps a file into memory read-only. Backends that parse models from a
+ * buffer read them straight from the page cache, which processes loading the
+ * same model share, instead of copying them through a stream into the heap.
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Map the file. Throws file_not_found_error if it doesn't exist and
+   * file_read_error if it can't be mapped
+   *
+   * @param path path to the file
+   */
+  explicit MappedFile(const std::filesystem::path& path);
+  MappedFile(MappedFile const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;  ///< Move constructor
+  /// Move assignment constructor
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  ~MappedFile();  ///< Destructor
+
+  /// Get the file's contents
+  [[nodiscard]] const std::byte* data() const { return data_; }
+  /// Get the file's size in bytes
+  [[nodiscard]] size_t size() const { return size_; }
+
+ private:
+  std::byte* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 /**
  * @brief Get the path to the file in a directory with the given extension. If
  * there is more than one file in the directory that matches, only the first one
@@ -0,0 +1,245 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements bulk conversions between floating point formats. The
+ * kernels using F16C and AVX-512 BF16 are compiled for those instructions
+ * with target attributes and picked at runtime so the library still runs on
+ * CPUs without them.
+ */
+
+#include "amdinfer/util/float_convert.hpp"
+
+#include <cstdint>  // for uint16_t, uint32_t
+#include <cstring>  // for memcpy
+#include <string>   // for string
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+
+#ifdef __x86_64__
+#include <immintrin.h>  // for _mm256_cvtps_ph, _mm512_cvtneps_pbh, ...
+#define AMDINFER_F16C_KERNELS
+// the AVX-512 BF16 intrinsics and their CPU feature check are newer
+#if (defined(__clang__) && __clang_major__ >= 16) || \
+  (!defined(__clang__) && __GNUC__ >= 10)
+#define AMDINFER_AVX512_BF16_KERNELS
+#endif
+#endif
+
+namespace amdinfer::util {
+
+namespace {
+
+constexpr uint32_t kBf16Shift = 16;
+
+void fp32ToFp16Scalar(const float* src, fp16* dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = fp16{src[i]};
+  }
+}
+
+void fp16ToFp32Scalar(const fp16* src, float* dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+// written without branches so the compiler vectorizes it
+void fp32ToBf16Scalar(const float* src, bf16* dst, size_t count) {
+  const uint32_t abs_mask = 0x7FFF'FFFF;
+  const uint32_t infinity = 0x7F80'0000;
+  const uint32_t rounding_bias = 0x7FFF;
+  const uint32_t quiet_bit = 0x40;
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &src[i], sizeof(bits));
+    const auto rounded =
+      (bits + rounding_bias + ((bits >> kBf16Shift) & 1U)) >> kBf16Shift;
+    const auto quiet = (bits >> kBf16Shift) | quiet_bit;
+    const auto nan = (bits & abs_mask) > infinity;
+    dst[i] = bf16::fromBits(static_cast<uint16_t>(nan ? quiet : rounded));
+  }
+}
+
+void bf16ToFp32Scalar(const bf16* src, float* dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = bf16::toFloat(src[i].bits());
+  }
+}
+
+#ifdef AMDINFER_F16C_KERNELS
+
+constexpr size_t kF16cWidth = 8;
+constexpr int kRoundToNearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+__attribute__((target("avx,f16c"))) void fp32ToFp16F16c(const float* src,
+                                                         fp16* dst,
+                                                         size_t count) {
+  size_t i = 0;
+  for (; i + kF16cWidth <= count; i += kF16cWidth) {
+    const auto converted =
+      _mm256_cvtps_ph(_mm256_loadu_ps(src + i), kRoundToNearest);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), converted);
+  }
+  // convert the rest with the same instruction so the rounding matches
+  for (; i < count; ++i) {
+    const auto converted =
+      _mm_cvtps_ph(_mm_set_ss(src[i]), kRoundToNearest);
+    const auto bits = static_cast<uint16_t>(_mm_extract_epi16(converted, 0));
+    std::memcpy(static_cast<void*>(dst + i), &bits, sizeof(bits));
+  }
+}
+
+__attribute__((target("avx,f16c"))) void fp16ToFp32F16c(const fp16* src,
+                                                         float* dst,
+                                                         size_t count) {
+  size_t i = 0;
+  for (; i + kF16cWidth <= count; i += kF16cWidth) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+  }
+  for (; i < count; ++i) {
+    uint16_t bits = 0;
+    std::memcpy(&bits, src + i, sizeof(bits));
+    dst[i] = _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(bits)));
+  }
+}
+
+#endif
+
+#ifdef AMDINFER_AVX512_BF16_KERNELS
+
+constexpr size_t kAvx512Width = 16;
+
+__attribute__((target("avx512f,avx512bf16"))) void fp32ToBf16Avx512(
+  const float* src, bf16* dst, size_t count) {
+  size_t i = 0;
+  for (; i + kAvx512Width <= count; i += kAvx512Width) {
+    const auto converted = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+    std::memcpy(static_cast<void*>(dst + i), &converted, sizeof(converted));
+  }
+  // the rest is converted in a zero-padded vector so the rounding matches
+  if (i < count) {
+    const auto mask = static_cast<__mmask16>((1U << (count - i)) - 1);
+    const auto converted = _mm512_cvtneps_pbh(_mm512_maskz_loadu_ps(mask, src + i));
+    std::memcpy(static_cast<void*>(dst + i), &converted, (count - i) * sizeof(bf16));
+  }
+}
+
+#endif
+
+using Fp32ToFp16 = void (*)(const float*, fp16*, size_t);
+using Fp16ToFp32 = void (*)(const fp16*, float*, size_t);
+using Fp32ToBf16 = void (*)(const float*, bf16*, size_t);
+
+Fp32ToFp16 selectFp32ToFp16() {
+  __builtin_cpu_init();
+#ifdef AMDINFER_F16C_KERNELS
+  if (__builtin_cpu_supports("f16c")) {
+    return fp32ToFp16F16c;
+  }
+#endif
+  return fp32ToFp16Scalar;
+}
+
+Fp16ToFp32 selectFp16ToFp32() {
+  __builtin_cpu_init();
+#ifdef AMDINFER_F16C_KERNELS
+  if (__builtin_cpu_supports("f16c")) {
+    return fp16ToFp32F16c;
+  }
+#endif
+  return fp16ToFp32Scalar;
+}
+
+Fp32ToBf16 selectFp32ToBf16() {
+  __builtin_cpu_init();
+#ifdef AMDINFER_AVX512_BF16_KERNELS
+  if (__builtin_cpu_supports("avx512bf16")) {
+    return fp32ToBf16Avx512;
+  }
+#endif
+  return fp32ToBf16Scalar;
+}
+
+struct CastTo {
+  template <typename To, typename From>
+  void operator()(const From* src, void* dst, size_t count) const {
+    auto* out = static_cast<To*>(dst);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = static_cast<To>(src[i]);
+    }
+  }
+};
+
+struct CastFrom {
+  template <typename From>
+  void operator()(const void* src, DataType to, void* dst, size_t count) const {
+    switchOverTypes(CastTo(), to, static_cast<const From*>(src), dst, count);
+  }
+};
+
+}  // namespace
+
+void convertFp32ToFp16(const float* src, fp16* dst, size_t count) {
+  static const auto kernel = selectFp32ToFp16();
+  kernel(src, dst, count);
+}
+
+void convertFp16ToFp32(const fp16* src, float* dst, size_t count) {
+  static const auto kernel = selectFp16ToFp32();
+  kernel(src, dst, count);
+}
+
+void convertFp32ToBf16(const float* src, bf16* dst, size_t count) {
+  static const auto kernel = selectFp32ToBf16();
+  kernel(src, dst, count);
+}
+
+void convertBf16ToFp32(const bf16* src, float* dst, size_t count) {
+  bf16ToFp32Scalar(src, dst, count);
+}
+
+void convertDatatype(const void* src, DataType from, void* dst, DataType to,
+                     size_t count) {
+  if (from == to) {
+    std::memcpy(dst, src, count * from.size());
+    return;
+  }
+  if (from == DataType::Bytes || to == DataType::Bytes) {
+    throw invalid_argument(std::string{"Cannot convert "} + from.str() +
+                           " to " + to.str());
+  }
+
+  if (from == DataType::Fp32 && to == DataType::Fp16) {
+    convertFp32ToFp16(static_cast<const float*>(src), static_cast<fp16*>(dst),
+                      count);
+  } else if (from == DataType::Fp16 && to == DataType::Fp32) {
+    convertFp16ToFp32(static_cast<const fp16*>(src), static_cast<float*>(dst),
+                      count);
+  } else if (from == DataType::Fp32 && to == DataType::Bf16) {
+    convertFp32ToBf16(static_cast<const float*>(src), static_cast<bf16*>(dst),
+                      count);
+  } else if (from == DataType::Bf16 && to == DataType::Fp32) {
+    convertBf16ToFp32(static_cast<const bf16*>(src), static_cast<float*>(dst),
+                      count);
+  } else {
+    switchOverTypes(CastFrom(), from, src, to, dst, count);
+  }
+}
+
+}  // namespace amdinfer::util
@@ -0,0 +1,75 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines bulk conversions between floating point formats and other
+ * datatypes
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_FLOAT_CONVERT
+#define GUARD_AMDINFER_UTIL_FLOAT_CONVERT
+
+#include <cstddef>  // for size_t
+
+#include "amdinfer/core/data_types.hpp"  // for DataType, fp16, bf16
+
+namespace amdinfer::util {
+
+/**
+ * @brief Convert floats to fp16, rounding to the nearest even value. On CPUs
+ * with F16C, eight values are converted per instruction.
+ *
+ * @param src the floats
+ * @param dst room for count fp16 values
+ * @param count number of values to convert
+ */
+void convertFp32ToFp16(const float* src, fp16* dst, size_t count);
+
+/// Convert fp16 values to floats, which is exact. Uses F16C if available
+void convertFp16ToFp32(const fp16* src, float* dst, size_t count);
+
+/**
+ * @brief Convert floats to bf16, rounding to the nearest even value. On CPUs
+ * with AVX-512 BF16, sixteen values are converted per instruction and
+ * denormal floats are flushed to zero, as the instruction does.
+ *
+ * @param src the floats
+ * @param dst room for count bf16 values
+ * @param count number of values to convert
+ */
+void convertFp32ToBf16(const float* src, bf16* dst, size_t count);
+
+/// Convert bf16 values to floats, which is exact
+void convertBf16ToFp32(const bf16* src, float* dst, size_t count);
+
+/**
+ * @brief Convert values from one datatype to another. Conversions between
+ * FP32 and FP16 or BF16 use the bulk conversions above and the others convert
+ * each value with a static_cast.
+ *
+ * @param src the values to convert
+ * @param from the datatype of the values
+ * @param dst room for count values of the new datatype. It may not overlap
+ * the source
+ * @param to the datatype to convert to
+ * @param count number of values to convert
+ * @throws invalid_argument if either datatype is BYTES and they differ
+ */
+void convertDatatype(const void* src, DataType from, void* dst, DataType to,
+                     size_t count);
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_FLOAT_CONVERT
@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a fast, non-cryptographic hash for byte buffers
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_HASH
+#define GUARD_AMDINFER_UTIL_HASH
+
+#include <array>        // for array
+#include <cstddef>      // for size_t, byte
+#include <cstdint>      // for uint64_t
+#include <cstring>      // for memcpy
+#include <string_view>  // for string_view
+#include <type_traits>  // for enable_if_t, is_trivially_...
+
+namespace amdinfer::util {
+
+/**
+ * @brief Incrementally hashes bytes into a 64-bit digest. It consumes 16 bytes
+ * per step with a 64x64->128-bit multiply so hashing tensor data runs near
+ * memory bandwidth. It's not suitable where an adversary picks the input.
+ * Feeding the same sequence of updates always gives the same digest.
+ */
+class Hasher {
+ public:
+  /// Hash size bytes starting at data
+  void update(const void* data, size_t size) {
+    const auto* bytes = static_cast<const std::byte*>(data);
+    length_ += size;
+    while (size >= kBlockSize) {
+      state_ = mix(load(bytes) ^ kPrime0,
+                   load(bytes + sizeof(uint64_t)) ^ state_);
+      bytes += kBlockSize;
+      size -= kBlockSize;
+    }
+    if (size > 0) {
+      std::array<std::byte, kBlockSize> tail{};
+      std::memcpy(tail.data(), bytes, size);
+      state_ = mix(load(tail.data()) ^ kPrime1,
+                   load(tail.data() + sizeof(uint64_t)) ^ state_);
+    }
+  }
+
+  /// Hash a string's characters and its length to separate adjacent strings
+  void update(std::string_view str) {
+    this->update(static_cast<uint64_t>(str.size()));
+    this->update(str.data(), str.size());
+  }
+
+  /// Hash the object representation of a trivially copyable value
+  template <typename T,
+            typename = std::enable_if_t<std::is_trivially_copyable_v<T>>>
+  void update(const T& value) {
+    this->update(&value, sizeof(T));
+  }
+
+  /// Get the digest of everything hashed so far
+  [[nodiscard]] uint64_t digest() const {
+    return mix(state_ ^ kPrime1, length_ ^ kPrime0);
+  }
+
+ private:
+  static constexpr size_t kBlockSize = 2 * sizeof(uint64_t);
+  static constexpr uint64_t kPrime0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t kPrime1 = 0xe7037ed1a0b428dbULL;
+
+  static uint64_t load(const std::byte* bytes) {
+    uint64_t value = 0;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+
+  /// Fold the high and low halves of the full product together
+  static uint64_t mix(uint64_t a, uint64_t b) {
+    // NOLINTNEXTLINE(google-runtime-int)
+    const auto product = static_cast<unsigned __int128>(a) * b;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    return static_cast<uint64_t>(product) ^
+           static_cast<uint64_t>(product >> 64);
+  }
+
+  uint64_t state_ = kPrime0;
+  uint64_t length_ = 0;
+};
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_HASH
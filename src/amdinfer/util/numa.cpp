@@ -0,0 +1,186 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements helpers to place threads and memory on NUMA nodes
+ */
+
+#include "amdinfer/util/numa.hpp"
+
+#ifdef __linux__
+#include <linux/mempolicy.h>  // for MPOL_BIND
+#include <pthread.h>          // for pthread_setaffinity_np, pthread_self
+#include <sched.h>            // for cpu_set_t, CPU_SET, CPU_ZERO, CPU_ISSET
+#include <sys/syscall.h>      // for SYS_getcpu, SYS_mbind
+#include <unistd.h>           // for syscall
+#endif
+
+#include <climits>    // for CHAR_BIT
+#include <fstream>    // for ifstream
+#include <sstream>    // for istringstream
+#include <stdexcept>  // for logic_error
+
+namespace amdinfer::util {
+
+namespace {
+
+std::string readFirstLine(const std::string& path) {
+  std::ifstream file{path};
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+#ifdef __linux__
+void setAffinity(pthread_t thread, const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto& cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+#endif
+
+}  // namespace
+
+std::vector<int> parseIdList(const std::string& list) {
+  std::vector<int> ids;
+  std::istringstream stream{list};
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    const auto dash = range.find('-');
+    try {
+      const auto first = std::stoi(range.substr(0, dash));
+      const auto last =
+        dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (auto id = first; id <= last; ++id) {
+        ids.push_back(id);
+      }
+    } catch (const std::logic_error&) {
+      // skip malformed ranges
+      continue;
+    }
+  }
+  return ids;
+}
+
+std::string formatIdList(const std::vector<int>& ids) {
+  std::string list;
+  for (size_t i = 0; i < ids.size();) {
+    // extend the range while the IDs are consecutive
+    auto last = i;
+    while (last + 1 < ids.size() && ids[last + 1] == ids[last] + 1) {
+      last++;
+    }
+    if (!list.empty()) {
+      list += ",";
+    }
+    list += std::to_string(ids[i]);
+    if (last > i) {
+      list += "-" + std::to_string(ids[last]);
+    }
+    i = last + 1;
+  }
+  return list;
+}
+
+std::vector<int> getNumaNodes() {
+  auto nodes = parseIdList(readFirstLine("/sys/devices/system/node/online"));
+  if (nodes.empty()) {
+    nodes.push_back(0);
+  }
+  return nodes;
+}
+
+int getNumaNode() {
+#ifdef __linux__
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return 0;
+}
+
+void bindThreadToNumaNode(std::thread& thread, int node) {
+  bindThreadToCpus(thread, getNumaNodeCpus(node));
+}
+
+std::vector<int> getNumaNodeCpus(int node) {
+  return parseIdList(readFirstLine("/sys/devices/system/node/node" +
+                                   std::to_string(node) + "/cpulist"));
+}
+
+void bindThreadToCpus([[maybe_unused]] std::thread& thread,
+                      [[maybe_unused]] const std::vector<int>& cpus) {
+#ifdef __linux__
+  setAffinity(thread.native_handle(), cpus);
+#endif
+}
+
+void bindThreadToCpus([[maybe_unused]] const std::vector<int>& cpus) {
+#ifdef __linux__
+  setAffinity(pthread_self(), cpus);
+#endif
+}
+
+std::vector<int> getThreadCpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+    for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+void bindMemoryToNumaNode([[maybe_unused]] void* address,
+                          [[maybe_unused]] size_t size,
+                          [[maybe_unused]] int node) {
+#ifdef __linux__
+  if (node < 0) {
+    return;
+  }
+  const auto bits_per_word = sizeof(unsigned long) * CHAR_BIT;
+  std::vector<unsigned long> mask(static_cast<size_t>(node) / bits_per_word +
+                                  1);
+  mask.at(static_cast<size_t>(node) / bits_per_word) |=
+    1UL << (static_cast<size_t>(node) % bits_per_word);
+  // the kernel ignores the last bit of the mask so add one to its size
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+  syscall(SYS_mbind, address, size, MPOL_BIND, mask.data(),
+          mask.size() * bits_per_word + 1, 0);
+#endif
+}
+
+}  // namespace amdinfer::util
@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines helpers to place threads and memory on NUMA nodes
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_NUMA
+#define GUARD_AMDINFER_UTIL_NUMA
+
+#include <cstddef>  // for size_t
+#include <string>   // for string
+#include <thread>   // for thread
+#include <vector>   // for vector
+
+namespace amdinfer::util {
+
+/**
+ * @brief Parse a Linux CPU or node list (e.g. "0-3,8,10-11") into IDs
+ *
+ * @param list the list to parse
+ * @return std::vector<int>
+ */
+std::vector<int> parseIdList(const std::string& list);
+
+/**
+ * @brief Format IDs as a Linux CPU or node list, the inverse of parseIdList
+ *
+ * @param ids the IDs to format, in ascending order
+ * @return std::string
+ */
+std::string formatIdList(const std::vector<int>& ids);
+
+/**
+ * @brief Get the online NUMA nodes. If they can't be read, the machine is
+ * assumed to have a single node 0.
+ *
+ * @return std::vector<int>
+ */
+std::vector<int> getNumaNodes();
+
+/// Get the NUMA node the calling thread is running on or 0 if it's unknown
+int getNumaNode();
+
+/**
+ * @brief Restrict a thread to the CPUs of a NUMA node. Like setThreadName, it
+ * silently fails if this isn't possible.
+ *
+ * @param thread the thread to bind
+ * @param node the NUMA node to bind it to
+ */
+void bindThreadToNumaNode(std::thread& thread, int node);
+
+/// Get the CPUs of a NUMA node or an empty list if they can't be read
+std::vector<int> getNumaNodeCpus(int node);
+
+/**
+ * @brief Restrict a thread to a set of CPUs. Like setThreadName, it silently
+ * fails if this isn't possible.
+ *
+ * @param thread the thread to bind
+ * @param cpus the CPUs it may run on
+ */
+void bindThreadToCpus(std::thread& thread, const std::vector<int>& cpus);
+
+/**
+ * @brief Restrict the calling thread to a set of CPUs. Threads it starts
+ * afterwards inherit the set. This silently fails if it isn't possible.
+ *
+ * @param cpus the CPUs it may run on
+ */
+void bindThreadToCpus(const std::vector<int>& cpus);
+
+/// Get the CPUs the calling thread may run on or an empty list if it's unknown
+std::vector<int> getThreadCpus();
+
+/**
+ * @brief Bind memory to a NUMA node. It only affects pages that haven't been
+ * touched yet so it should be called right after mapping the memory. This
+ * silently fails if it isn't possible.
+ *
+ * @param address start of the memory. It must be page-aligned
+ * @param size size of the memory in bytes
+ * @param node the NUMA node to bind it to
+ */
+void bindMemoryToNumaNode(void* address, size_t size, int node);
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_NUMA
@@ -0,0 +1,79 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a pool of released objects for reuse
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_OBJECT_POOL
+#define GUARD_AMDINFER_UTIL_OBJECT_POOL
+
+#include <concurrentqueue/concurrentqueue.h>  // for ConcurrentQueue
+
+#include <cstddef>  // for size_t
+
+namespace amdinfer::util {
+
+/**
+ * @brief Keeps released objects so they can be reused instead of allocated
+ * again. Objects are often made and released on different threads (e.g. a
+ * batch is made by a batcher and released by a worker) so any thread may take
+ * or release objects.
+ *
+ * @tparam T type of the objects. They must be allocated with new
+ */
+template <typename T>
+class ObjectPool {
+ public:
+  /**
+   * @brief Construct a new ObjectPool object
+   *
+   * @param capacity the most released objects to keep. Objects released to a
+   * full pool are deleted
+   */
+  explicit ObjectPool(size_t capacity) : capacity_(capacity) {}
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+  ObjectPool(ObjectPool&&) = delete;
+  ObjectPool& operator=(ObjectPool&&) = delete;
+  ~ObjectPool() {
+    T* object = nullptr;
+    while (free_.try_dequeue(object)) {
+      delete object;  // NOLINT(cppcoreguidelines-owning-memory)
+    }
+  }
+
+  /// Take a released object or return nullptr if there isn't one
+  T* take() {
+    T* object = nullptr;
+    free_.try_dequeue(object);
+    return object;
+  }
+
+  /// Keep an object to reuse later. The caller must have reset it already
+  void release(T* object) {
+    if (free_.size_approx() >= capacity_ || !free_.enqueue(object)) {
+      delete object;  // NOLINT(cppcoreguidelines-owning-memory)
+    }
+  }
+
+ private:
+  size_t capacity_;
+  moodycamel::ConcurrentQueue<T*> free_;
+};
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_OBJECT_POOL
@@ -17,12 +17,24 @@
 #define GUARD_AMDINFER_UTIL_QUEUE
 
 #include <concurrentqueue/blockingconcurrentqueue.h>  // IWYU pragma: export
+#include <concurrentqueue/concurrentqueue.h>          // for ConcurrentQueue
+#include <concurrentqueue/lightweightsemaphore.h>     // for LightweightSem...
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "amdinfer/declarations.hpp"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>  // for _mm_pause
+#endif
+
 namespace amdinfer {
 
 template <class T>
@@ -33,6 +45,207 @@ using BufferPtrsQueuePtr = std::unique_ptr<BufferPtrsQueue>;
 
 using InferenceRequestPtrQueue = BlockingQueue<InferenceRequestPtr>;
 
+/// Number of times a lane may be passed over before it's served
+constexpr uint32_t kDefaultStarvationLimit = 8;
+
+/**
+ * @brief A blocking queue with multiple priority lanes. Items are dequeued from
+ * the highest priority (lowest index) non-empty lane first. To prevent lower
+ * priority lanes from starving under sustained load, a non-empty lane that has
+ * been passed over too many times is served ahead of the higher lanes once.
+ *
+ * @tparam T type of the items in the queue
+ * @tparam Lanes number of priority lanes
+ */
+template <typename T, size_t Lanes>
+class PriorityBlockingQueue {
+  static_assert(Lanes > 0, "The queue must have at least one lane");
+
+ public:
+  explicit PriorityBlockingQueue(
+    uint32_t starvation_limit = kDefaultStarvationLimit)
+    : starvation_limit_(starvation_limit) {}
+
+  /**
+   * @brief Enqueue an item in a lane. Out-of-range lanes are clamped to the
+   * lowest priority lane.
+   *
+   * @param item item to enqueue
+   * @param lane priority lane to use
+   */
+  void enqueue(T item, size_t lane) {
+    lane = lane < Lanes ? lane : Lanes - 1;
+    lanes_[lane].enqueue(std::move(item));
+    items_.signal();
+  }
+
+  /// Block until an item is available and dequeue it
+  void wait_dequeue(T& item) {
+    items_.wait();
+    this->dequeueAvailable(item);
+  }
+
+  /**
+   * @brief Block until an item is available or the timeout expires
+   *
+   * @param item the dequeued item, if any
+   * @param timeout_us time to wait in microseconds
+   * @return bool true if an item was dequeued
+   */
+  bool wait_dequeue_timed(T& item, int64_t timeout_us) {
+    if (!items_.wait(timeout_us)) {
+      return false;
+    }
+    this->dequeueAvailable(item);
+    return true;
+  }
+
+  /**
+   * @brief Block until an item is available or the timeout expires and then
+   * dequeue up to max items at once. Starved lanes are served first and then
+   * the lanes in priority order, as with wait_dequeue, but the waiting and the
+   * dequeueing from each lane are done once for all the items.
+   *
+   * @param items where to move the dequeued items. It must have room for max
+   * @param max the most items to dequeue
+   * @param timeout_us time to wait in microseconds or -1 to wait forever
+   * @return size_t the number of items dequeued
+   */
+  size_t wait_dequeue_bulk_timed(T* items, size_t max, int64_t timeout_us) {
+    using Count = std::make_signed_t<size_t>;
+    const auto count =
+      timeout_us < 0 ? items_.waitMany(static_cast<Count>(max))
+                     : items_.waitMany(static_cast<Count>(max), timeout_us);
+    const auto claimed = static_cast<size_t>(count);
+    size_t taken = 0;
+    while (taken < claimed) {
+      taken += this->dequeueAvailable(items + taken, claimed - taken);
+    }
+    return claimed;
+  }
+
+  /// Get the approximate number of items across all lanes
+  [[nodiscard]] size_t size_approx() const {
+    size_t size = 0;
+    for (const auto& lane : lanes_) {
+      size += lane.size_approx();
+    }
+    return size;
+  }
+
+  /// Get the approximate number of items in one lane
+  [[nodiscard]] size_t size_approx(size_t lane) const {
+    return lanes_.at(lane).size_approx();
+  }
+
+ private:
+  // the caller must have already claimed an item from the semaphore so at least
+  // one lane holds an item for it, though it may not be visible immediately
+  void dequeueAvailable(T& item) {
+    while (true) {
+      for (auto lane = Lanes - 1; lane > 0; --lane) {
+        if (skipped_[lane] >= starvation_limit_ &&
+            lanes_[lane].try_dequeue(item)) {
+          skipped_[lane] = 0;
+          return;
+        }
+      }
+      for (auto lane = 0U; lane < Lanes; ++lane) {
+        if (lanes_[lane].try_dequeue(item)) {
+          skipped_[lane] = 0;
+          for (auto lower = lane + 1; lower < Lanes; ++lower) {
+            if (lanes_[lower].size_approx() > 0) {
+              skipped_[lower]++;
+            }
+          }
+          return;
+        }
+      }
+    }
+  }
+
+  // dequeue up to count claimed items, one from each starved lane and then
+  // lane by lane in priority order. It may return fewer if some aren't visible
+  // yet
+  size_t dequeueAvailable(T* items, size_t count) {
+    size_t taken = 0;
+    for (auto lane = Lanes - 1; lane > 0 && taken < count; --lane) {
+      if (skipped_[lane] >= starvation_limit_ &&
+          lanes_[lane].try_dequeue(items[taken])) {
+        skipped_[lane] = 0;
+        taken++;
+      }
+    }
+    for (auto lane = 0U; lane < Lanes && taken < count; ++lane) {
+      const auto dequeued =
+        lanes_[lane].try_dequeue_bulk(items + taken, count - taken);
+      if (dequeued == 0) {
+        continue;
+      }
+      taken += dequeued;
+      skipped_[lane] = 0;
+      for (auto lower = lane + 1; lower < Lanes; ++lower) {
+        if (lanes_[lower].size_approx() > 0) {
+          skipped_[lower]++;
+        }
+      }
+    }
+    return taken;
+  }
+
+  const uint32_t starvation_limit_;
+  std::array<moodycamel::ConcurrentQueue<T>, Lanes> lanes_;
+  std::array<std::atomic_uint32_t, Lanes> skipped_{};
+  moodycamel::LightweightSemaphore items_;
+};
+
+namespace util {
+
+/// Hint to the CPU that the calling thread is spinning
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Spin until a queue has an item or a time passes. Blocking on an empty
+ * queue parks the thread in the kernel and waking it again costs a system call
+ * and a trip through the scheduler, which threads on their own cores can skip
+ * by polling for a short time first. Callers still make their usual blocking
+ * call afterwards, which returns at once if an item arrived and parks the
+ * thread otherwise.
+ *
+ * @tparam Queue a queue with size_approx()
+ * @param queue the queue to poll
+ * @param spin how long to spin. If zero, this returns at once
+ * @return bool true if the queue has an item
+ */
+template <typename Queue>
+bool spinUntilReady(const Queue& queue, std::chrono::nanoseconds spin) {
+  if (spin.count() <= 0) {
+    return queue.size_approx() > 0;
+  }
+  // reading the clock is slower than polling so only check it now and then
+  constexpr auto kPollsPerCheck = 64;
+  const auto deadline = std::chrono::steady_clock::now() + spin;
+  while (true) {
+    for (auto i = 0; i < kPollsPerCheck; ++i) {
+      if (queue.size_approx() > 0) {
+        return true;
+      }
+      cpuRelax();
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+  }
+}
+
+}  // namespace util
+
 }  // namespace amdinfer
 
 #endif  // GUARD_AMDINFER_UTIL_QUEUE
@@ -0,0 +1,80 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements a scheduler that runs continuations on one thread
+ */
+
+#include "amdinfer/util/scheduler.hpp"
+
+#include <utility>  // for move
+
+namespace amdinfer::util {
+
+void Scheduler::post(Task task) {
+  {
+    const std::lock_guard lock{mutex_};
+    posted_.push_back(std::move(task));
+  }
+  posted_cv_.notify_one();
+}
+
+void Scheduler::await(Ready ready, Task then) {
+  waiting_.emplace_back(std::move(ready), std::move(then));
+}
+
+size_t Scheduler::poll() {
+  // the tasks are moved out first since they may post or await more
+  running_.clear();
+  {
+    const std::lock_guard lock{mutex_};
+    running_.swap(posted_);
+  }
+  // the awaits that are still waiting are kept in order at the front
+  auto kept = waiting_.begin();
+  for (auto it = waiting_.begin(); it != waiting_.end(); ++it) {
+    if (it->first()) {
+      running_.push_back(std::move(it->second));
+      continue;
+    }
+    if (kept != it) {
+      *kept = std::move(*it);
+    }
+    ++kept;
+  }
+  waiting_.erase(kept, waiting_.end());
+
+  auto tasks = std::move(running_);
+  for (auto& task : tasks) {
+    task();
+  }
+  const auto count = tasks.size();
+  // keep the capacity for the next poll
+  tasks.clear();
+  running_ = std::move(tasks);
+  return count;
+}
+
+void Scheduler::wait(std::chrono::microseconds timeout) {
+  std::unique_lock lock{mutex_};
+  posted_cv_.wait_for(lock, timeout, [this]() { return !posted_.empty(); });
+}
+
+bool Scheduler::idle() {
+  const std::lock_guard lock{mutex_};
+  return posted_.empty() && waiting_.empty();
+}
+
+}  // namespace amdinfer::util
@@ -0,0 +1,122 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a scheduler that runs continuations on one thread
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_SCHEDULER
+#define GUARD_AMDINFER_UTIL_SCHEDULER
+
+#include <chrono>              // for microseconds
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <functional>          // for function
+#include <future>              // for shared_future, future_status
+#include <memory>              // for make_shared
+#include <mutex>               // for mutex
+#include <utility>             // for move, pair
+#include <vector>              // for vector
+
+namespace amdinfer::util {
+
+/**
+ * @brief The Scheduler runs tasks on the one thread that polls it. Work that
+ * waits on something, such as a device or a queue, awaits a check that it's
+ * done and the scheduler runs its continuation once the check passes. The
+ * polling thread can then keep many waits in flight instead of blocking on
+ * each of them in turn.
+ *
+ * Only post() may be called from other threads. The others are called from the
+ * polling thread, including from the tasks the scheduler runs.
+ */
+class Scheduler {
+ public:
+  using Task = std::function<void()>;
+  /// Returns true once the awaited work is done. It must not block
+  using Ready = std::function<bool()>;
+
+  /// Run a task on the polling thread at its next poll
+  void post(Task task);
+  /**
+   * @brief Run a continuation once a check passes. The check is made at each
+   * poll until it does
+   *
+   * @param ready the check
+   * @param then the continuation
+   */
+  void await(Ready ready, Task then);
+  /**
+   * @brief Run a continuation once a future is ready. The continuation can get
+   * the result from the future without blocking
+   *
+   * @param future the future
+   * @param then the continuation
+   */
+  template <typename T>
+  void await(std::shared_future<T> future, Task then) {
+    this->await(
+      [future = std::move(future)]() {
+        return future.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+      },
+      std::move(then));
+  }
+  /**
+   * @brief Run a continuation with the next item of a queue once there is one.
+   * The queue must have a non-blocking try_dequeue, such as BlockingQueue
+   *
+   * @param queue the queue
+   * @param then the continuation that gets the item
+   */
+  template <typename T, typename Queue>
+  void awaitDequeue(Queue* queue, std::function<void(T)> then) {
+    auto item = std::make_shared<T>();
+    this->await([queue, item]() { return queue->try_dequeue(*item); },
+                [item, then = std::move(then)]() { then(std::move(*item)); });
+  }
+
+  /**
+   * @brief Run the posted tasks and the continuations whose checks pass. The
+   * tasks these add are run at the next poll
+   *
+   * @return size_t the number of tasks and continuations run
+   */
+  size_t poll();
+  /**
+   * @brief Block until a task is posted or the timeout passes. Pending awaits
+   * don't wake it so the polling thread uses it to pace its checks
+   *
+   * @param timeout the longest time to block
+   */
+  void wait(std::chrono::microseconds timeout);
+  /// Check if no tasks or awaits are pending
+  [[nodiscard]] bool idle();
+  /// Get the number of awaits whose checks haven't passed yet
+  [[nodiscard]] size_t waiting() const { return waiting_.size(); }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable posted_cv_;
+  // guarded by the mutex since other threads post
+  std::vector<Task> posted_;
+  // only the polling thread uses these
+  std::vector<std::pair<Ready, Task>> waiting_;
+  std::vector<Task> running_;
+};
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_SCHEDULER
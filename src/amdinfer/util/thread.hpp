@@ -16,6 +16,7 @@
 #ifndef GUARD_AMDINFER_HELPERS_THREAD
 #define GUARD_AMDINFER_HELPERS_THREAD
 
+#include <array>
 #include <string>
 
 #ifdef __linux__
@@ -43,6 +44,20 @@ inline void setThreadName(const std::string& name) {
   util::setThreadName(name.c_str());
 }
 
+/// Get the calling thread's name or an empty string if it can't be read
+inline std::string getThreadName() {
+#ifdef __linux__
+  // names are at most 16 bytes including the null terminator
+  constexpr auto kMaxNameSize = 16;
+  std::array<char, kMaxNameSize> name{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+  if (prctl(PR_GET_NAME, name.data()) == 0) {
+    return name.data();
+  }
+#endif
+  return "";
+}
+
 }  // namespace amdinfer::util
 
 #endif  // GUARD_AMDINFER_HELPERS_THREAD
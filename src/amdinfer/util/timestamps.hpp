@@ -0,0 +1,100 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines cheap monotonic timestamps for latency accounting on the hot
+ * path
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_TIMESTAMPS
+#define GUARD_AMDINFER_UTIL_TIMESTAMPS
+
+#include <array>    // for array
+#include <chrono>   // for steady_clock, duration, duration_cast
+#include <cstddef>  // for size_t
+#include <ratio>    // for ratio
+
+namespace amdinfer::util {
+
+/**
+ * @brief The clock used to time requests and batches. Unlike the system
+ * clock, it never jumps and on Linux it's read from the vDSO, typically from
+ * the TSC, without a system call.
+ */
+using SteadyClock = std::chrono::steady_clock;
+using Timestamp = SteadyClock::time_point;
+
+/// Get the current time of the steady clock
+inline Timestamp now() { return SteadyClock::now(); }
+
+/**
+ * @brief Get the time between two timestamps
+ *
+ * @tparam U the ratio to convert the time e.g. std::micro for microseconds
+ * @tparam T the type to return the time as
+ * @param start the start time
+ * @param stop the stop time, which is now by default
+ * @return T the duration between the start and stop time in the right units
+ */
+template <typename U = std::ratio<1, 1>, typename T = double>
+T elapsed(Timestamp start, Timestamp stop = now()) {
+  return std::chrono::duration_cast<std::chrono::duration<T, U>>(stop - start)
+    .count();
+}
+
+/**
+ * @brief A fixed set of timestamps indexed by an enum, for timing stages
+ * without the allocations and lookups of labeled times. The enum's values must
+ * count up from zero and end with Count.
+ *
+ * @tparam Event the enum of the timestamps
+ */
+template <typename Event>
+class Timestamps {
+ public:
+  /// Mark that the event happened now
+  void mark(Event event) { times_[index(event)] = now(); }
+  /// Mark that the event happened at a time
+  void mark(Event event, Timestamp time) { times_[index(event)] = time; }
+  /// Get the time of an event
+  [[nodiscard]] Timestamp get(Event event) const {
+    return times_[index(event)];
+  }
+
+  /**
+   * @brief Return the duration between two events
+   *
+   * @tparam U the ratio to convert the time e.g. std::micro for microseconds
+   * @tparam T the type to return the time as
+   * @param start the start event
+   * @param stop the stop event
+   * @return T the duration between the events in the right units
+   */
+  template <typename U = std::ratio<1, 1>, typename T = double>
+  [[nodiscard]] T count(Event start, Event stop) const {
+    return elapsed<U, T>(get(start), get(stop));
+  }
+
+ private:
+  static constexpr size_t index(Event event) {
+    return static_cast<size_t>(event);
+  }
+
+  std::array<Timestamp, index(Event::Count)> times_{};
+};
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_TIMESTAMPS
@@ -0,0 +1,80 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Implements the selection of the vector kernels for the CPU
+ */
+
+#include "amdinfer/util/vector_kernels.hpp"
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t
+
+#include "amdinfer/util/cpu_features.hpp"  // for selectKernel, IsaKernels
+
+namespace amdinfer::util {
+
+// the kernels are defined in vector_kernels_isa.cpp, which is compiled once
+// for each instruction set with the name of the set as their namespace
+namespace scalar {
+void softmax(const float* data, size_t rows, size_t size, float* result);
+size_t selectMargins(const float* positive, const float* negative,
+                     size_t count, size_t stride, float margin,
+                     uint32_t* indices);
+}  // namespace scalar
+
+#ifdef __x86_64__
+namespace avx2 {
+void softmax(const float* data, size_t rows, size_t size, float* result);
+size_t selectMargins(const float* positive, const float* negative,
+                     size_t count, size_t stride, float margin,
+                     uint32_t* indices);
+}  // namespace avx2
+
+namespace avx512 {
+void softmax(const float* data, size_t rows, size_t size, float* result);
+size_t selectMargins(const float* positive, const float* negative,
+                     size_t count, size_t stride, float margin,
+                     uint32_t* indices);
+}  // namespace avx512
+#endif
+
+void softmax(const float* data, size_t rows, size_t size, float* result) {
+#ifdef __x86_64__
+  static const auto kernel =
+    selectKernel<decltype(&scalar::softmax)>({scalar::softmax, avx2::softmax,
+                                              avx512::softmax});
+#else
+  static const auto kernel =
+    selectKernel<decltype(&scalar::softmax)>({scalar::softmax});
+#endif
+  kernel(data, rows, size, result);
+}
+
+size_t selectMargins(const float* positive, const float* negative,
+                     size_t count, size_t stride, float margin,
+                     uint32_t* indices) {
+#ifdef __x86_64__
+  static const auto kernel = selectKernel<decltype(&scalar::selectMargins)>(
+    {scalar::selectMargins, avx2::selectMargins, avx512::selectMargins});
+#else
+  static const auto kernel =
+    selectKernel<decltype(&scalar::selectMargins)>({scalar::selectMargins});
+#endif
+  return kernel(positive, negative, count, stride, margin, indices);
+}
+
+}  // namespace amdinfer::util
@@ -0,0 +1,65 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Defines vector kernels that are compiled for each instruction set and
+ * selected for the CPU at runtime
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_VECTOR_KERNELS
+#define GUARD_AMDINFER_UTIL_VECTOR_KERNELS
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t
+
+namespace amdinfer::util {
+
+/**
+ * @brief Calculate softmax of each row of a batch in single precision with the
+ * best instruction set that the CPU supports. It gives the same results as
+ * pre_post::calcSoftmax for float data up to rounding.
+ *
+ * @param data pointer to the data, one row after another
+ * @param rows number of rows
+ * @param size number of elements in each row
+ * @param result pointer to store the computed results. It may alias data
+ */
+void softmax(const float* data, size_t rows, size_t size, float* result);
+
+/**
+ * @brief Find the elements whose score exceeds another score by more than a
+ * margin with the best instruction set that the CPU supports, such as the
+ * cells of a detector's output whose foreground logit beats the background's
+ * by enough for its probability to pass a threshold. The scores are compared
+ * a vector at a time and only the indices of the few that pass are written.
+ *
+ * @param positive pointer to the score of the first element
+ * @param negative pointer to the score that it's compared with
+ * @param count number of elements
+ * @param stride distance between the scores of consecutive elements, such as
+ * the number of channels of an interleaved map
+ * @param margin the difference that the scores must exceed
+ * @param indices pointer to store the indices of the elements that pass, in
+ * order. It must have room for count indices
+ * @return size_t the number of elements that pass
+ */
+size_t selectMargins(const float* positive, const float* negative,
+                     size_t count, size_t stride, float margin,
+                     uint32_t* indices);
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_VECTOR_KERNELS
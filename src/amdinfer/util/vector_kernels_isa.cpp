@@ -0,0 +1,126 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/**
+ * @file
+ * @brief Implements the vector kernels for one instruction set. It's compiled
+ * once for each set with AMDINFER_ISA defined as its name and the flags that
+ * enable it so the compiler vectorizes the loops with its instructions.
+ *
+ * These copies only run on CPUs that support their instructions but inline
+ * functions that aren't inlined, such as from headers, are shared with the
+ * rest of the program by the linker, which may keep any copy. So the kernels
+ * are flattened to inline everything that they call and their own helpers go
+ * in the anonymous namespace.
+ */
+
+#ifndef AMDINFER_ISA
+#error "AMDINFER_ISA must be defined as the instruction set to compile for"
+#endif
+
+#include <algorithm>  // for min
+#include <cstddef>    // for size_t
+#include <cstdint>    // for uint8_t, uint32_t
+
+#include "amdinfer/pre_post/softmax.hpp"  // for getMax, expShifted, getSum
+
+namespace amdinfer::util::AMDINFER_ISA {
+
+namespace {
+
+/// Elements compared before the ones that pass are written out
+constexpr size_t kMarginBlock = 64;
+
+/**
+ * @brief Compare the scores of each block in a loop that vectorizes and write
+ * out the indices of the blocks that have any passing elements without
+ * branches. Most blocks of a detector's output have none so they're skipped
+ * after the comparisons. A stride of zero means the stride is only known at
+ * runtime
+ */
+template <size_t Stride>
+size_t selectBlocks(const float* positive, const float* negative, size_t count,
+                    size_t stride, float margin, uint32_t* indices) {
+  if constexpr (Stride != 0) {
+    stride = Stride;
+  }
+  uint8_t mask[kMarginBlock];
+  size_t found = 0;
+  for (size_t start = 0; start < count; start += kMarginBlock) {
+    const auto size = std::min(kMarginBlock, count - start);
+    const auto* lhs = positive + start * stride;
+    const auto* rhs = negative + start * stride;
+    uint8_t any = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const auto difference = lhs[i * stride] - rhs[i * stride];
+      mask[i] = static_cast<uint8_t>(difference > margin);
+      any |= mask[i];
+    }
+    if (any == 0) {
+      continue;
+    }
+    // found never passes start + i so this stays within the indices
+    for (size_t i = 0; i < size; ++i) {
+      indices[found] = static_cast<uint32_t>(start + i);
+      found += mask[i];
+    }
+  }
+  return found;
+}
+
+}  // namespace
+
+[[gnu::flatten]] void softmax(const float* data, size_t rows, size_t size,
+                              float* result) {
+  if (size == 0) {
+    return;
+  }
+  for (size_t row = 0; row < rows; ++row) {
+    const auto* in = data + row * size;
+    auto* out = result + row * size;
+    if (out != in) {
+      for (size_t i = 0; i < size; ++i) {
+        out[i] = in[i];
+      }
+    }
+    const auto max = pre_post::detail::getMax(out, size);
+    pre_post::detail::expShifted(out, size, max);
+    const auto inverse = 1.0F / pre_post::detail::getSum(out, size);
+    for (size_t i = 0; i < size; ++i) {
+      out[i] *= inverse;
+    }
+  }
+}
+
+[[gnu::flatten]] size_t selectMargins(const float* positive,
+                                     const float* negative, size_t count,
+                                     size_t stride, float margin,
+                                     uint32_t* indices) {
+  // the common strides of planar and interleaved maps are compiled separately
+  // so their loads vectorize without gathers
+  switch (stride) {
+    case 1:
+      return selectBlocks<1>(positive, negative, count, stride, margin,
+                             indices);
+    case 2:
+      return selectBlocks<2>(positive, negative, count, stride, margin,
+                             indices);
+    default:
+      return selectBlocks<0>(positive, negative, count, stride, margin,
+                             indices);
+  }
+}
+
+}  // namespace amdinfer::util::AMDINFER_ISA
@@ -0,0 +1,159 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the little-endian encoding shared by the binary formats, such
+ * as traces and the binary inference protocol
+ */
+
+#ifndef GUARD_AMDINFER_UTIL_WIRE
+#define GUARD_AMDINFER_UTIL_WIRE
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t, int32_t
+#include <cstring>      // for memcpy
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <type_traits>  // for is_same_v, decay_t
+#include <utility>      // for move
+#include <variant>      // for visit
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/core/parameters.hpp"  // for ParameterMap
+
+namespace amdinfer::util {
+
+/// Append an integer to the output in little-endian order
+template <typename T>
+void writeInt(T value, std::string* out) {
+  for (auto i = 0U; i < sizeof(T); ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+/// Append a string prefixed by its 32-bit size to the output
+inline void writeString(std::string_view value, std::string* out) {
+  writeInt(static_cast<uint32_t>(value.size()), out);
+  out->append(value);
+}
+
+/**
+ * @brief Append parameters to the output as their count followed by the key,
+ * the index of the type in the parameter variant and the value of each
+ *
+ * @param parameters the parameters
+ * @param out the output
+ */
+inline void writeParameters(const ParameterMap& parameters, std::string* out) {
+  writeInt(static_cast<uint32_t>(parameters.size()), out);
+  for (const auto& [key, value] : parameters) {
+    writeString(key, out);
+    writeInt(static_cast<uint8_t>(value.index()), out);
+    std::visit(
+      [out](const auto& arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+          writeString(arg, out);
+        } else if constexpr (std::is_same_v<T, double>) {
+          uint64_t bits = 0;
+          std::memcpy(&bits, &arg, sizeof(bits));
+          writeInt(bits, out);
+        } else {
+          writeInt(static_cast<uint32_t>(arg), out);
+        }
+      },
+      value);
+  }
+}
+
+/// Reads the fields of an encoded message, checking that they're in bounds
+class WireReader {
+ public:
+  /**
+   * @brief Construct a new WireReader object
+   *
+   * @param bytes the encoded message
+   * @param name what the message is, used in errors
+   */
+  WireReader(std::string_view bytes, std::string name)
+    : bytes_(bytes), name_(std::move(name)) {}
+
+  template <typename T>
+  T readInt() {
+    const auto bytes = this->take(sizeof(T));
+    T value = 0;
+    for (auto i = 0U; i < sizeof(T); ++i) {
+      value |= static_cast<T>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+    }
+    return value;
+  }
+
+  std::string readString() {
+    const auto size = this->readInt<uint32_t>();
+    return std::string{this->take(size)};
+  }
+
+  ParameterMap readParameters() {
+    ParameterMap parameters;
+    const auto count = this->readInt<uint32_t>();
+    for (auto i = 0U; i < count; ++i) {
+      auto key = this->readString();
+      const auto type = this->readInt<uint8_t>();
+      switch (type) {
+        case 0:
+          parameters.put(key, this->readInt<uint32_t>() != 0);
+          break;
+        case 1:
+          parameters.put(key,
+                         static_cast<int32_t>(this->readInt<uint32_t>()));
+          break;
+        case 2: {
+          const auto bits = this->readInt<uint64_t>();
+          double value = 0;
+          std::memcpy(&value, &bits, sizeof(value));
+          parameters.put(key, value);
+          break;
+        }
+        case 3:
+          parameters.put(key, this->readString());
+          break;
+        default:
+          throw invalid_argument("Unknown type of parameter in the " + name_);
+      }
+    }
+    return parameters;
+  }
+
+  /// Take the next size bytes of the message
+  std::string_view take(size_t size) {
+    if (size > bytes_.size()) {
+      throw invalid_argument("The " + name_ + " is truncated");
+    }
+    auto bytes = bytes_.substr(0, size);
+    bytes_.remove_prefix(size);
+    return bytes;
+  }
+
+  /// Get the bytes that haven't been read yet
+  [[nodiscard]] std::string_view remaining() const { return bytes_; }
+
+ private:
+  std::string_view bytes_;
+  std::string name_;
+};
+
+}  // namespace amdinfer::util
+
+#endif  // GUARD_AMDINFER_UTIL_WIRE
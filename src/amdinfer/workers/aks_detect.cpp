@@ -56,22 +56,19 @@
 #include "amdinfer/util/parse_env.hpp"       // for autoExpandEnvironmentVa...
 #include "amdinfer/util/thread.hpp"          // for setThreadName
 #include "amdinfer/util/timer.hpp"           // for Timer
-#include "amdinfer/workers/worker.hpp"       // for Worker, kNumBufferAuto
-
-namespace AKS {  // NOLINT(readability-identifier-naming)
-class AIGraph;
-}  // namespace AKS
+#include "amdinfer/workers/worker.hpp"       // for MultiThreadedWorker
 
 namespace amdinfer::workers {
 
 /**
- * @brief The Resnet50 worker accepts a 224x224 image and returns an array of
- * classification IDs
+ * @brief The AksDetect worker runs a detection graph on batches of 1920x1080
+ * images and returns the boxes found in each. Each of its threads keeps one
+ * AKS job in flight and waits for its results.
  *
  */
-class AksDetect : public SingleThreadedWorker {
+class AksDetect : public MultiThreadedWorker {
  public:
-  using SingleThreadedWorker::SingleThreadedWorker;
+  using MultiThreadedWorker::MultiThreadedWorker;
   [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
 
  private:
@@ -82,8 +79,9 @@ class AksDetect : public SingleThreadedWorker {
   void doDestroy() override;
 
   AKS::SysManagerExt* sys_manager_ = nullptr;
-  std::string graph_name_;
-  AKS::AIGraph* graph_ = nullptr;
+  AksGraphs graphs_;
+  // number of jobs in flight, one per thread
+  int32_t jobs_ = kDefaultAksJobs;
 };
 
 std::vector<MemoryAllocators> AksDetect::getAllocators() const {
@@ -101,14 +99,11 @@ void AksDetect::doInit(ParameterMap* parameters) {
   }
   this->batch_size_ = batch_size;
 
-  std::string graph_name;
-  if (parameters->has("aks_graph_name")) {
-    graph_name = parameters->get<std::string>("aks_graph_name");
-  } else {
+  if (!parameters->has("aks_graph_name")) {
     throw invalid_argument(
       "aks_graph_name must be specified in the parameters");
   }
-  this->graph_name_ = graph_name;
+  jobs_ = getAksJobs(*parameters);
 }
 
 constexpr auto kImageWidth = 1920;
@@ -133,14 +128,17 @@ void AksDetect::doAcquire(ParameterMap* parameters) {
     throw;
   }
 
-  this->graph_ = this->sys_manager_->getGraph(this->graph_name_);
+  graphs_.load(this->sys_manager_, *parameters);
+  // the threads block on their jobs' results so they don't need CPUs of their
+  // own
+  this->createThreadPool(jobs_);
 
   this->metadata_.addInputTensor("input",
                                  {static_cast<int64_t>(batch_size_),
                                   kImageHeight, kImageWidth, kImageChannels},
                                  DataType::Int8);
   this->metadata_.addOutputTensor("output", {0, 6}, DataType::FP32);
-  this->metadata_.setName(this->graph_name_);
+  this->metadata_.setName(graphs_.name());
 }
 
 BatchPtr AksDetect::doRun(Batch* batch, const MemoryPool* pool) {
@@ -156,13 +154,13 @@ BatchPtr AksDetect::doRun(Batch* batch, const MemoryPool* pool) {
   for (unsigned int j = 0; j < batch_size; j++) {
     const auto& req = batch->getRequest(static_cast<int>(j));
 
-    auto inputs = req->getInputs();
+    const auto& inputs = req->getInputs();
 
     uint64_t input_size = 0;
-    for (auto& input : inputs) {
+    for (const auto& input : inputs) {
       auto* input_buffer = input.getData();
 
-      auto input_shape = input.getShape();
+      const auto& input_shape = input.getShape();
 
       input_size = util::containerProduct(input_shape);
 
@@ -171,7 +169,7 @@ BatchPtr AksDetect::doRun(Batch* batch, const MemoryPool* pool) {
         tensor_shape.insert(tensor_shape.end(), input_shape.begin(),
                             input_shape.end());
         v.emplace_back(std::make_unique<AKS::AksTensorBuffer>(
-          xir::Tensor::create(this->graph_name_, tensor_shape,
+          xir::Tensor::create(graphs_.name(), tensor_shape,
                               xir::create_data_type<unsigned char>())));
       }
       /// Copy input to AKS Buffers: Find a better way to share buffers
@@ -183,7 +181,7 @@ BatchPtr AksDetect::doRun(Batch* batch, const MemoryPool* pool) {
   }
 
   std::future<std::vector<std::unique_ptr<vart::TensorBuffer>>> future =
-    this->sys_manager_->enqueueJob(this->graph_, "", std::move(v), nullptr);
+    this->sys_manager_->enqueueJob(graphs_.next(), "", std::move(v), nullptr);
 
   auto aks_output = future.get();
 
@@ -239,7 +237,7 @@ BatchPtr AksDetect::doRun(Batch* batch, const MemoryPool* pool) {
 
     new_batch->addRequest(new_request);
 
-    new_batch->setModel(i, graph_name_);
+    new_batch->setModel(i, graphs_.name());
   }
 
   new_batch->setBuffers(std::move(input_buffers), {});
@@ -247,7 +245,7 @@ BatchPtr AksDetect::doRun(Batch* batch, const MemoryPool* pool) {
   return new_batch;
 }
 
-void AksDetect::doRelease() {}
+void AksDetect::doRelease() { this->destroyThreadPool(); }
 void AksDetect::doDestroy() {}
 
 }  // namespace amdinfer::workers
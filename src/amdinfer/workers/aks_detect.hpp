@@ -20,8 +20,94 @@
 #ifndef GUARD_AMDINFER_WORKERS_AKS_DETECT
 #define GUARD_AMDINFER_WORKERS_AKS_DETECT
 
+#include <aks/AksSysManagerExt.h>  // for SysManagerExt
+
+#include <atomic>   // for atomic
+#include <cstddef>  // for size_t
+#include <cstdint>  // for int32_t
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/core/parameters.hpp"  // for ParameterMap
+#include "amdinfer/util/string.hpp"      // for split
+
+namespace AKS {  // NOLINT(readability-identifier-naming)
+class AIGraph;
+}  // namespace AKS
+
 namespace amdinfer::workers {
 
+/// AKS jobs a worker keeps in flight by default: enough to keep the
+/// pre-processing, DPU and post-processing stages of a graph busy while the
+/// next job is filled
+constexpr auto kDefaultAksJobs = 4;
+
+/**
+ * @brief Get the number of AKS jobs a worker keeps in flight from the "jobs"
+ * load-time parameter
+ *
+ * @param parameters the worker's load-time parameters
+ * @return int32_t
+ */
+inline int32_t getAksJobs(const ParameterMap& parameters) {
+  auto jobs = kDefaultAksJobs;
+  if (parameters.has("jobs")) {
+    jobs = parameters.get<int32_t>("jobs");
+  }
+  if (jobs < 1) {
+    throw invalid_argument("jobs must be at least 1");
+  }
+  return jobs;
+}
+
+/**
+ * @brief The instances of an AKS graph that a worker runs its jobs on. AKS
+ * runs the jobs of one graph through each of its kernels in turn so loading
+ * the same pipeline under several names and spreading the jobs over them lets
+ * more jobs run at once.
+ */
+class AksGraphs {
+ public:
+  /**
+   * @brief Get the graphs named by the "aks_graph_name" load-time parameter,
+   * which is a comma-separated list of the names of the instances. The graphs
+   * must already be loaded
+   *
+   * @param sys_manager the AKS manager that loaded the graphs
+   * @param parameters the worker's load-time parameters
+   */
+  void load(AKS::SysManagerExt* sys_manager, const ParameterMap& parameters) {
+    if (!parameters.has("aks_graph_name")) {
+      throw invalid_argument(
+        "aks_graph_name must be specified in the parameters");
+    }
+    names_ = util::split(parameters.get<std::string>("aks_graph_name"), ",");
+    graphs_.clear();
+    for (const auto& name : names_) {
+      auto* graph = sys_manager->getGraph(name);
+      if (graph == nullptr) {
+        throw invalid_argument("AKS graph " + name + " is not loaded");
+      }
+      graphs_.push_back(graph);
+    }
+  }
+
+  /// Get the graph to run the next job on. It's safe to call from any thread
+  [[nodiscard]] AKS::AIGraph* next() {
+    return graphs_[next_.fetch_add(1, std::memory_order_relaxed) %
+                   graphs_.size()];
+  }
+
+  /// Get the name of the first instance, which names the model
+  [[nodiscard]] const std::string& name() const { return names_.front(); }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<AKS::AIGraph*> graphs_;
+  std::atomic<size_t> next_ = 0;
+};
+
 struct DetectResponse {
   float class_id;
   float score;
@@ -22,16 +22,12 @@
 #include <aks/AksTensorBuffer.h>   // for AksTensorBuffer
 
 #include <algorithm>               // for copy, max, copy_backward
-#include <chrono>                  // for seconds
 #include <cstdint>                 // for int32_t, uint8_t
 #include <cstring>                 // for size_t, memcpy
 #include <ext/alloc_traits.h>      // for __alloc_traits<>::value...
-#include <future>                  // for future, future_status
+#include <future>                  // for future
 #include <memory>                  // for allocator, unique_ptr
 #include <opencv2/core.hpp>        // for Mat, MatSize, Size, Mat...
-#include <opencv2/imgcodecs.hpp>   // for imencode
-#include <opencv2/videoio.hpp>     // for VideoCapture, VideoCapt...
-#include <queue>                   // for queue
 #include <string>                  // for string, operator+, to_s...
 #include <thread>                  // for thread
 #include <utility>                 // for move, pair
@@ -42,6 +38,7 @@
 
 #include "amdinfer/batching/batcher.hpp"  // for BatchPtr, Batch, BatchP...
 #include "amdinfer/build_options.hpp"     // for AMDINFER_ENABLE_TRACING
+#include "amdinfer/core/bytes_tensor.hpp"  // for BytesView
 #include "amdinfer/core/data_types.hpp"   // for DataType, DataType::Bytes
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
@@ -49,29 +46,30 @@
 #include "amdinfer/declarations.hpp"         // for BufferPtrs, InferenceRe...
 #include "amdinfer/observation/logging.hpp"  // for Logger
 #include "amdinfer/observation/tracing.hpp"  // for Trace
-#include "amdinfer/util/base64.hpp"          // for base64_encode
 #include "amdinfer/util/parse_env.hpp"       // for autoExpandEnvironmentVa...
+#include "amdinfer/util/queue.hpp"           // for BlockingQueue
 #include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/workers/aks_detect.hpp"   // for DetectResponse
-#include "amdinfer/workers/worker.hpp"       // for Worker, kNumBufferAuto
-
-namespace AKS {  // NOLINT(readability-identifier-naming)
-class AIGraph;
-}  // namespace AKS
+#include "amdinfer/workers/aks_detect.hpp"    // for DetectResponse
+#include "amdinfer/workers/video_stream.hpp"  // for VideoStream
+#include "amdinfer/workers/worker.hpp"        // for Worker, kNumBufferAuto
 
 namespace amdinfer {
 
-std::string constructMessage(const std::string& key, const std::string& data,
-                             const std::string& labels) {
-  return R"({"key": ")" + key + R"(", "data": {"img": ")" + data +
-         R"(", "labels": )" + labels + "}}";
-}
-
 namespace workers {
 
+/// A batch of frames enqueued in AKS
+struct AksStreamJob {
+  std::future<std::vector<std::unique_ptr<vart::TensorBuffer>>> future;
+  // the encoded frames to send with the boxes
+  std::vector<std::string> frames;
+  cv::Size size;
+};
+
 /**
  * @brief The AksDetectStream worker is a streaming (over WebSocket) worker that
- * runs a detection-based model on a video with AKS.
+ * runs a detection-based model on a video with AKS. Each video keeps a number
+ * of jobs in flight and a completion thread sends the boxes of each job as
+ * soon as it's done.
  *
  */
 class AksDetectStream : public SingleThreadedWorker {
@@ -86,21 +84,31 @@ class AksDetectStream : public SingleThreadedWorker {
   void doRelease() override;
   void doDestroy() override;
 
+  /// Stream one video to the client
+  void stream(InferenceRequest* req, const InferenceRequestInput* input,
+              Trace* trace) const;
+
+  VideoStreamOptions options_;
   AKS::SysManagerExt* sys_manager_ = nullptr;
-  AKS::AIGraph* graph_ = nullptr;
+  // mutable so streams can take the next graph from their const method
+  mutable AksGraphs graphs_;
+  // number of jobs each video keeps in flight
+  int32_t jobs_ = kDefaultAksJobs;
 };
 
 std::vector<MemoryAllocators> AksDetectStream::getAllocators() const {
   return {MemoryAllocators::Cpu};
 }
 
-void AksDetectStream::doInit([[maybe_unused]] ParameterMap* parameters) {
+void AksDetectStream::doInit(ParameterMap* parameters) {
   constexpr auto kBatchSize = 4;
+  options_ = getVideoStreamOptions(*parameters);
 
   /// Get AKS System Manager instance
   this->sys_manager_ = AKS::SysManagerExt::getGlobal();
 
   this->batch_size_ = kBatchSize;
+  jobs_ = getAksJobs(*parameters);
 }
 
 constexpr auto kImageWidth = 1920;
@@ -116,15 +124,7 @@ void AksDetectStream::doAcquire(ParameterMap* parameters) {
   }
   util::autoExpandEnvironmentVariables(path);
   this->sys_manager_->loadGraphs(path);
-
-  std::string graph_name;
-  if (parameters->has("aks_graph_name")) {
-    graph_name = parameters->get<std::string>("aks_graph_name");
-  } else {
-    throw invalid_argument(
-      "aks_graph_name must be specified in the parameters");
-  }
-  this->graph_ = this->sys_manager_->getGraph(graph_name);
+  graphs_.load(this->sys_manager_, *parameters);
 
   this->metadata_.addInputTensor("input",
                                  {static_cast<int64_t>(batch_size_),
@@ -132,219 +132,187 @@ void AksDetectStream::doAcquire(ParameterMap* parameters) {
                                  DataType::Int8);
   // TODO(varunsh): what should we return here?
   this->metadata_.addOutputTensor("output", {0}, DataType::Uint32);
-  this->metadata_.setName(graph_name);
+  this->metadata_.setName(graphs_.name());
 }
 BatchPtr AksDetectStream::doRun(Batch* batch,
                                 [[maybe_unused]] const MemoryPool* pool) {
+  // each video is decoded in its own pipeline so the videos of a batch are
+  // streamed concurrently
+  std::vector<std::thread> streams;
+  for (unsigned int k = 0; k < batch->size(); k++) {
+    const auto& req = batch->getRequest(static_cast<int>(k));
+    Trace* trace = nullptr;
+#ifdef AMDINFER_ENABLE_TRACING
+    trace = batch->getTrace(k).get();
+#endif
+    for (const auto& input : req->getInputs()) {
+      streams.emplace_back(&AksDetectStream::stream, this, req.get(), &input,
+                           trace);
+    }
+  }
+  for (auto& stream : streams) {
+    stream.join();
+  }
+
+  // okay because ensembles disabled for this worker
+  return nullptr;
+}
+
+void AksDetectStream::stream(InferenceRequest* req,
+                             const InferenceRequestInput* input,
+                             [[maybe_unused]] Trace* trace) const {
 #ifdef AMDINFER_ENABLE_LOGGING
   const auto& logger = this->getLogger();
 #endif
+  util::setThreadName("AksDetectStream");
+  auto key = req->getParameters().get<std::string>("key");
+
+  // the first element is the path or URL of the video
+  const BytesView elements{input->getData(), input->getSize()};
+  std::string data{elements.empty() ? std::string_view{} : elements[0]};
+
+  auto options = options_;
+  try {
+    options.encoding = getFrameEncoding(req->getParameters());
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger, e.what());
+    req->runCallbackError(e.what());
+    return;
+  }
+  const auto encoding = options.encoding;
+  VideoStream video{data, std::move(options)};
+  if (!video.isOpened()) {
+    const char* error = "Cannot open video file";
+    AMDINFER_LOG_ERROR(logger, error);
+    req->runCallbackError(error);
+    return;
+  }
 
-  for (unsigned int k = 0; k < batch->size(); k++) {
-    const auto& req = batch->getRequest(static_cast<int>(k));
-    auto inputs = req->getInputs();
-    auto outputs = req->getOutputs();
-    auto key = req->getParameters().get<std::string>("key");
-    for (auto& input : inputs) {
-      auto* input_buffer = input.getData();
-
-      const auto* idata = static_cast<char*>(input_buffer);
-      std::string data{idata, input.getSize()};
-
-      cv::VideoCapture cap(data);  // open the video file
-      if (!cap.isOpened()) {       // check if we succeeded
-        const char* error = "Cannot open video file";
-        AMDINFER_LOG_ERROR(logger, error);
-        req->runCallbackError(error);
-        continue;
-      }
-
-      InferenceResponse resp;
-      resp.setID(req->getID());
-      resp.setModel("aks_detect_stream");
+  // contains the number of frames in the video;
+  auto count = video.count();
+  if (input->getParameters().has("count")) {
+    auto requested_count = input->getParameters().get<int32_t>("count");
+    count = std::min(count, static_cast<size_t>(requested_count));
+  }
 
-      // contains the number of frames in the video;
-      auto count = static_cast<size_t>(
-        cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_COUNT));
-      if (input.getParameters().has("count")) {
-        auto requested_count = input.getParameters().get<int32_t>("count");
-        count = std::min(count, static_cast<size_t>(requested_count));
+  std::string metadata = "[" + std::to_string(video.width()) + "," +
+                         std::to_string(video.height()) + "]";
+  const std::string model = "aks_detect_stream";
+  sendMessage(req, model, "key",
+              makeMetadataMessage(key, encoding, video.fps(), metadata),
+              encoding);
+
+  // round to nearest multiple of batch size
+  video.start(count - (count % this->batch_size_));
+
+  // the boxes of each job are sent by the completion thread in order as soon
+  // as the job is done. A job without a future ends it
+  BlockingQueue<AksStreamJob> jobs;
+  moodycamel::LightweightSemaphore slots{jobs_};
+  std::thread completion{[&]() {
+    util::setThreadName("AksDetectStream");
+    uint64_t index = 0;
+    AksStreamJob job;
+    while (true) {
+      jobs.wait_dequeue(job);
+      if (!job.future.valid()) {
+        break;
       }
-      double fps = cap.get(cv::VideoCaptureProperties::CAP_PROP_FPS);
-      auto video_width =
-        cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_WIDTH);
-      auto video_height =
-        cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_HEIGHT);
-
-      InferenceResponseOutput output;
-      output.setName("key");
-      output.setDatatype(DataType::Bytes);
-      std::string metadata = "[" + std::to_string(video_width) + "," +
-                             std::to_string(video_height) + "]";
-      auto message = constructMessage(key, std::to_string(fps), metadata);
-      std::vector<std::byte> buffer;
-      buffer.resize(message.size());
-      memcpy(buffer.data(), message.data(), message.size());
-      output.setData(std::move(buffer));
-      output.setShape({static_cast<int64_t>(message.size())});
-      resp.addOutput(output);
-      req->runCallback(resp);
-
-      // round to nearest multiple of batch size
-      auto count_adjusted = count - (count % this->batch_size_);
-      std::queue<std::future<std::vector<std::unique_ptr<vart::TensorBuffer>>>>
-        futures;
-      std::queue<std::string> frames;
-      for (unsigned int frame_num = 0; frame_num < count_adjusted;
-           frame_num += this->batch_size_) {
-        std::vector<std::unique_ptr<vart::TensorBuffer>> v;
-        v.reserve(1);
+      auto out_data_descriptor = job.future.get();
+      AMDINFER_LOG_INFO(logger, "Got future with key " + key);
+      auto* top_k_data =
+        reinterpret_cast<float*>(out_data_descriptor[0]->data().first);
+      auto shape = out_data_descriptor[0]->get_tensor()->get_shape();
+      std::vector<std::string> labels(this->batch_size_, "[");
+      for (int i = 0; i < shape[0] * shape[1]; i += kAksDetectResponseSize) {
+        auto batch_id = static_cast<int>(top_k_data[i]);
+        const auto* detect_response =
+          reinterpret_cast<DetectResponse*>(&(top_k_data[i + 1]));
+
+        labels[batch_id].append(R"({"fill": false, "box": [)");
+        labels[batch_id].append(std::to_string(detect_response->x) + ",");
+        labels[batch_id].append(std::to_string(detect_response->y) + ",");
+        labels[batch_id].append(std::to_string(detect_response->w) + ",");
+        labels[batch_id].append(std::to_string(detect_response->h));
+        labels[batch_id].append(R"(], "label": ")");
+        labels[batch_id].append(std::to_string(detect_response->class_id) +
+                                "\"},");
+      }
+      // a batch cut short by the end of the video has fewer frames than the
+      // batch size
+      for (auto j = 0U; j < job.frames.size(); j++) {
+        if (labels[j].size() > 1) {
+          labels[j].pop_back();  // trim trailing comma
+        }
+        labels[j] += "]";
+        auto message = makeFrameMessage(key, index++, encoding, job.frames[j],
+                                        job.size, labels[j]);
+        sendFrame(req, model, message, encoding);
+      }
+      slots.signal();
+    }
+  }};
+
+  bool finished = false;
+  while (!finished) {
+    std::vector<std::unique_ptr<vart::TensorBuffer>> v;
+    v.reserve(1);
+    AksStreamJob job;
+    job.frames.reserve(this->batch_size_);
 
+    // wait for a job to finish if there are too many in flight
+    slots.wait();
 #ifdef AMDINFER_ENABLE_TRACING
-        const auto& trace = batch->getTrace(k);
-        trace->startSpan("enqueue_batch");
+    if (trace != nullptr) {
+      trace->startSpan("enqueue_batch");
+    }
 #endif
 
-        for (size_t i = 0; i < this->batch_size_; i++) {
-          cv::Mat frame;
-          cap >> frame;  // get the next frame from video
-          if (frame.empty()) {
-            i--;
-            continue;
-          }
-          if (i == 0) {
-            v.emplace_back(
-              std::make_unique<AKS::AksTensorBuffer>(xir::Tensor::create(
-                "AksDetect-stream",
-                {static_cast<int>(this->batch_size_), frame.size().height,
-                 frame.size().width, kImageChannels},
-                xir::create_data_type<unsigned char>())));
-          }
-          // cv::resize(frame, frame, cv::Size(kImageWidth, kImageHeight));
-          auto input_size = frame.step[0] * frame.rows;
-          memcpy(
-            reinterpret_cast<uint8_t*>(v[0]->data().first) + (i * input_size),
-            frame.data, input_size);
-
-          std::vector<unsigned char> buf;
-          cv::imencode(".jpg", frame, buf);
-          const auto* enc_msg = reinterpret_cast<const char*>(buf.data());
-          std::string encoded = util::base64Encode(enc_msg, buf.size());
-          frames.push("data:image/jpg;base64," + encoded);
-        }
-        AMDINFER_LOG_INFO(logger, "Enqueuing in " + key);
-        futures.push(this->sys_manager_->enqueueJob(this->graph_, "",
-                                                    std::move(v), nullptr));
+    size_t frames_in_batch = 0;
+    for (; frames_in_batch < this->batch_size_; frames_in_batch++) {
+      auto* frame = video.next();
+      if (frame == nullptr) {
+        finished = true;
+        break;
+      }
+      const auto& image = frame->image;
+      if (frames_in_batch == 0) {
+        v.emplace_back(
+          std::make_unique<AKS::AksTensorBuffer>(xir::Tensor::create(
+            "AksDetect-stream",
+            {static_cast<int>(this->batch_size_), image.size().height,
+             image.size().width, kImageChannels},
+            xir::create_data_type<unsigned char>())));
+      }
+      auto input_size = image.step[0] * image.rows;
+      memcpy(reinterpret_cast<uint8_t*>(v[0]->data().first) +
+               (frames_in_batch * input_size),
+             image.data, input_size);
+      job.size = image.size();
+      job.frames.push_back(std::move(frame->encoded));
+      video.release(frame);
+    }
+    if (frames_in_batch == 0) {
 #ifdef AMDINFER_ENABLE_TRACING
+      if (trace != nullptr) {
         trace->endSpan();
-#endif
-        auto status = futures.front().wait_for(std::chrono::seconds(0));
-        if (status == std::future_status::ready) {
-          std::vector<std::unique_ptr<vart::TensorBuffer>> out_data_descriptor =
-            futures.front().get();
-          futures.pop();
-          auto* top_k_data =
-            reinterpret_cast<float*>(out_data_descriptor[0]->data().first);
-          auto shape = out_data_descriptor[0]->get_tensor()->get_shape();
-          std::vector<std::string> labels;
-          labels.reserve(this->batch_size_);
-          for (unsigned int j = 0; j < this->batch_size_; j++) {
-            labels.emplace_back("[");
-          }
-          for (int i = 0; i < shape[0] * shape[1];
-               i += kAksDetectResponseSize) {
-            auto batch_id = static_cast<int>(top_k_data[i]);
-            const auto* detect_response =
-              reinterpret_cast<DetectResponse*>(&(top_k_data[i + 1]));
-
-            labels[batch_id].append(R"({"fill": false, "box": [)");
-            labels[batch_id].append(std::to_string(detect_response->x) + ",");
-            labels[batch_id].append(std::to_string(detect_response->y) + ",");
-            labels[batch_id].append(std::to_string(detect_response->w) + ",");
-            labels[batch_id].append(std::to_string(detect_response->h));
-            labels[batch_id].append(R"(], "label": ")");
-            labels[batch_id].append(std::to_string(detect_response->class_id) +
-                                    "\"},");
-          }
-          for (unsigned int j = 0; j < this->batch_size_; j++) {
-            if (labels[j].size() > 1) {
-              labels[j].pop_back();  // trim trailing comma
-            }
-            labels[j] += "]";
-            InferenceResponse resp;
-            resp.setID(req->getID());
-            resp.setModel("invert_video");
-
-            InferenceResponseOutput output;
-            output.setName("image");
-            output.setDatatype(DataType::Bytes);
-            auto message = constructMessage(key, frames.front(), labels[j]);
-            std::vector<std::byte> buffer;
-            buffer.resize(message.size());
-            memcpy(buffer.data(), message.data(), message.size());
-            output.setData(std::move(buffer));
-            output.setShape({static_cast<int64_t>(message.size())});
-            resp.addOutput(output);
-            req->runCallback(resp);
-            frames.pop();
-          }
-        }
-      }
-      while (!futures.empty()) {
-        std::vector<std::unique_ptr<vart::TensorBuffer>> out_data_descriptor =
-          futures.front().get();
-        AMDINFER_LOG_INFO(logger, "Got future with key " + key);
-        futures.pop();
-        auto* top_k_data =
-          reinterpret_cast<float*>(out_data_descriptor[0]->data().first);
-        auto shape = out_data_descriptor[0]->get_tensor()->get_shape();
-        std::vector<std::string> labels;
-        labels.reserve(this->batch_size_);
-        for (unsigned int j = 0; j < this->batch_size_; j++) {
-          labels.emplace_back("[");
-        }
-        for (int i = 0; i < shape[0] * shape[1]; i += kAksDetectResponseSize) {
-          auto batch_id = static_cast<int>(top_k_data[i]);
-          const auto* detect_response =
-            reinterpret_cast<DetectResponse*>(&(top_k_data[i + 1]));
-
-          labels[batch_id].append(R"({"fill": false, "box": [)");
-          labels[batch_id].append(std::to_string(detect_response->x) + ",");
-          labels[batch_id].append(std::to_string(detect_response->y) + ",");
-          labels[batch_id].append(std::to_string(detect_response->w) + ",");
-          labels[batch_id].append(std::to_string(detect_response->h));
-          labels[batch_id].append(R"(], "label": ")");
-          labels[batch_id].append(std::to_string(detect_response->class_id) +
-                                  "\"},");
-        }
-        for (unsigned int j = 0; j < this->batch_size_; j++) {
-          if (labels[j].size() > 1) {
-            labels[j].pop_back();  // trim trailing comma
-          }
-          labels[j] += "]";
-          InferenceResponse resp;
-          resp.setID(req->getID());
-          resp.setModel("invert_video");
-
-          InferenceResponseOutput output;
-          output.setName("image");
-          output.setDatatype(DataType::Bytes);
-          auto message = constructMessage(key, frames.front(), labels[j]);
-          std::vector<std::byte> buffer;
-          buffer.resize(message.size());
-          memcpy(buffer.data(), message.data(), message.size());
-          output.setData(std::move(buffer));
-          output.setShape({static_cast<int64_t>(message.size())});
-          resp.addOutput(output);
-          req->runCallback(resp);
-          frames.pop();
-        }
       }
+#endif
+      break;
     }
-  }
 
-  // okay because ensembles disabled for this worker
-  return nullptr;
+    AMDINFER_LOG_INFO(logger, "Enqueuing in " + key);
+    job.future =
+      this->sys_manager_->enqueueJob(graphs_.next(), "", std::move(v), nullptr);
+    jobs.enqueue(std::move(job));
+#ifdef AMDINFER_ENABLE_TRACING
+    if (trace != nullptr) {
+      trace->endSpan();
+    }
+#endif
+  }
+  jobs.enqueue(AksStreamJob{});
+  completion.join();
 }
 
 void AksDetectStream::doRelease() {}
@@ -31,8 +31,10 @@
 #include <utility>  // for move
 #include <vector>   // for vector
 
-#include "amdinfer/batching/soft.hpp"    // for SoftBatcher
-#include "amdinfer/build_options.hpp"    // for AMDINFER_ENABLE_TRACING
+#include "amdinfer/batching/batch_tensors.hpp"  // for BatchTensors
+#include "amdinfer/batching/soft.hpp"           // for SoftBatcher
+#include "amdinfer/buffers/vector.hpp"          // for VectorBuffer
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_TRACING
 #include "amdinfer/core/data_types.hpp"  // for DataType, DataType::Uint32
 #include "amdinfer/core/inference_request.hpp"  // for InferenceRequest, Infe...
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
@@ -42,6 +44,7 @@
 #include "amdinfer/observation/metrics.hpp"  // for Metrics
 #include "amdinfer/observation/tracing.hpp"  // for startFollowSpan, SpanPtr
 #include "amdinfer/util/containers.hpp"      // for containerSum
+#include "amdinfer/util/memory.hpp"          // for copy
 #include "amdinfer/util/queue.hpp"           // for BufferPtrsQueue
 #include "amdinfer/util/string.hpp"          // for endsWith
 #include "amdinfer/util/thread.hpp"          // for setThreadName
@@ -62,7 +65,8 @@ void* openModel(const std::string& so_path) {
   /*
   Open the needed object. The dlopen flags used here:
     - RTLD_LOCAL: the symbols are not made available to other loaded libs
-    - RTLD_LAZY: resolve symbols as needed. We only need one anyway
+    - RTLD_NOW: resolve all the symbols while loading the model so the
+      first request doesn't pay for it
   Adding RTLD_DEEPBIND here creates problems:
     - Cannot use std::cout in the library
       (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=42679)
@@ -74,7 +78,7 @@ void* openModel(const std::string& so_path) {
   workers is dlmopen but that also should not be used here due to its own set of
   issues (https://sourceware.org/bugzilla/show_bug.cgi?id=24776).
   */
-  void* handle = dlopen(so_path.c_str(), RTLD_LOCAL | RTLD_LAZY);
+  void* handle = dlopen(so_path.c_str(), RTLD_LOCAL | RTLD_NOW);
   if (handle == nullptr) {
     const char* error_str = dlerror();
     throw file_not_found_error(error_str);
@@ -93,10 +97,81 @@ void* getFunction(void* handle, const std::string& function) {
   return fptr;
 }
 
+namespace {
+
+/// Look up an optional function, returning nullptr if it's not exported
+void* findFunction(void* handle, const std::string& function) {
+  // reset errors
+  dlerror();
+  return dlsym(handle, function.c_str());
+}
+
+size_t getBytes(const InferenceRequestInput& input) {
+  return input.getSize() * input.getDatatype().size();
+}
+
+/**
+ * @brief Describe the batch's inputs as contiguous tensors. The batcher
+ * usually packs them already but scatter-gather batches are copied into
+ * packed buffers first, which must outlive the returned tensors.
+ *
+ * @param batch the batch to describe
+ * @param packed the buffers holding the copies of scatter-gather inputs
+ * @return BatchTensors
+ */
+BatchTensors getInputTensors(Batch* batch, BufferPtrs* packed) {
+  const auto& requests = batch->getRequests();
+  const auto tensors = requests.front()->getInputs().size();
+  const auto scatter_gather = batch->isScatterGather();
+
+  BatchTensors batch_tensors(tensors);
+  for (auto i = 0U; i < tensors; ++i) {
+    auto& batch_tensor = batch_tensors[i];
+    batch_tensor.datatype = requests.front()->getInputs()[i].getDatatype();
+    batch_tensor.offsets.reserve(requests.size() + 1);
+
+    if (!scatter_gather) {
+      const auto& buffer = batch->getInputBuffers()[i];
+      auto* base = static_cast<std::byte*>(buffer->data(0));
+      for (const auto& request : requests) {
+        const auto* data =
+          static_cast<std::byte*>(request->getInputs()[i].getData());
+        batch_tensor.offsets.push_back(static_cast<size_t>(data - base));
+      }
+      const auto& last = requests.back()->getInputs()[i];
+      batch_tensor.offsets.push_back(batch_tensor.offsets.back() +
+                                     getBytes(last));
+      batch_tensor.data = base;
+      continue;
+    }
+
+    size_t size = 0;
+    batch_tensor.offsets.push_back(0);
+    for (const auto& request : requests) {
+      size += getBytes(request->getInputs()[i]);
+      batch_tensor.offsets.push_back(size);
+    }
+    auto buffer = std::make_unique<VectorBuffer>(size);
+    auto* data = static_cast<std::byte*>(buffer->data(0));
+    for (const auto& request : requests) {
+      const auto& input = request->getInputs()[i];
+      data = util::copy(input.getData(), data, getBytes(input));
+    }
+    batch_tensor.data = buffer->data(0);
+    packed->push_back(std::move(buffer));
+  }
+  return batch_tensors;
+}
+
+}  // namespace
+
 namespace workers {
 
 /**
- * @brief The CPlusPlus worker can run a compiled C++ "model".
+ * @brief The CPlusPlus worker can run a compiled C++ "model". A model exports
+ * either "run", which is given the batch and handles its requests one by one,
+ * or "runBatch", which is also given the batch's tensors as contiguous buffers
+ * so it can process the whole batch at once.
  *
  */
 class CPlusPlus : public SingleThreadedWorker {
@@ -111,7 +186,17 @@ class CPlusPlus : public SingleThreadedWorker {
   void doRelease() override;
   void doDestroy() override;
 
+  // the entry points of models with known and unknown output shapes
+  using Run = void (*)(Batch*, Batch*);
+  using RunDynamic = BatchPtr (*)(Batch*);
+  using RunBatch = void (*)(Batch*, const BatchTensors&, const BatchTensors&,
+                            Batch*);
+  using RunBatchDynamic = BatchPtr (*)(Batch*, const BatchTensors&);
+
   void* handle_ = nullptr;
+  // the model's "runBatch" if it exports it, otherwise its "run"
+  void* run_ = nullptr;
+  bool batch_native_ = false;
   std::vector<Tensor> input_tensors_;
   std::vector<Tensor> output_tensors_;
 
@@ -168,9 +253,21 @@ void CPlusPlus::doAcquire([[maybe_unused]] ParameterMap* parameters) {
   for (const auto& tensor : output_tensors_) {
     metadata_.addOutputTensor(tensor);
   }
+
+  run_ = findFunction(handle_, "runBatch");
+  batch_native_ = run_ != nullptr;
+  if (!batch_native_) {
+    run_ = getFunction(handle_, "run");
+  }
 }
 
 BatchPtr CPlusPlus::doRun(Batch* batch, const MemoryPool* pool) {
+  BufferPtrs packed;
+  BatchTensors inputs;
+  if (batch_native_) {
+    inputs = getInputTensors(batch, &packed);
+  }
+
   BatchPtr new_batch;
   if (!(input_tensors_.empty() || output_tensors_.empty())) {
     new_batch = batch->propagate();
@@ -193,19 +290,31 @@ BatchPtr CPlusPlus::doRun(Batch* batch, const MemoryPool* pool) {
       }
       new_batch->addRequest(new_request);
     }
-    new_batch->setBuffers(std::move(input_buffers), {});
-
-    auto* run_ptr = getFunction(handle_, "run");
-    auto* runModel =
-      reinterpret_cast<void (*)(amdinfer::Batch*, amdinfer::Batch*)>(run_ptr);
 
-    runModel(batch, new_batch.get());
+    if (batch_native_) {
+      BatchTensors outputs;
+      outputs.reserve(output_tensors_.size());
+      for (auto i = 0U; i < output_tensors_.size(); ++i) {
+        const auto& tensor = output_tensors_[i];
+        const auto bytes = tensor.getSize() * tensor.getDatatype().size();
+        auto& output = outputs.emplace_back(
+          BatchTensor{input_buffers[i]->data(0), {}, tensor.getDatatype()});
+        output.offsets.reserve(batch_size + 1);
+        for (auto j = 0U; j <= batch_size; ++j) {
+          output.offsets.push_back(j * bytes);
+        }
+      }
+      new_batch->setBuffers(std::move(input_buffers), {});
+      reinterpret_cast<RunBatch>(run_)(batch, inputs, outputs,
+                                       new_batch.get());
+    } else {
+      new_batch->setBuffers(std::move(input_buffers), {});
+      reinterpret_cast<Run>(run_)(batch, new_batch.get());
+    }
+  } else if (batch_native_) {
+    new_batch = reinterpret_cast<RunBatchDynamic>(run_)(batch, inputs);
   } else {
-    auto* run_ptr = getFunction(handle_, "run");
-    auto* runModel =
-      reinterpret_cast<amdinfer::BatchPtr (*)(amdinfer::Batch*)>(run_ptr);
-
-    new_batch = runModel(batch);
+    new_batch = reinterpret_cast<RunDynamic>(run_)(batch);
   }
 
   return new_batch;
@@ -0,0 +1,318 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the FaceDetectPostprocess worker
+ */
+
+#include <algorithm>  // for min, max
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int32_t, int64_t, uint32_t
+#include <exception>  // for exception
+#include <memory>     // for allocator
+#include <string>     // for string
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/declarations.hpp"             // for BufferPtr
+#include "amdinfer/observation/logging.hpp"      // for Logger
+#include "amdinfer/pre_post/face_detect_postprocess.hpp"  // for decodeFace...
+#include "amdinfer/workers/worker.hpp"           // for MultiThreadedWorker
+
+namespace amdinfer::workers {
+
+namespace {
+
+// each box is x1, y1, x2, y2 and score
+constexpr auto kBoxSize = 5;
+
+/// The grid and channels of one of the model's outputs
+struct Output {
+  const float* data = nullptr;
+  int64_t channels = 0;
+  int64_t height = 0;
+  int64_t width = 0;
+};
+
+Output getOutput(const InferenceRequestInput& input, bool nchw) {
+  if (input.getDatatype() != DataType::Fp32) {
+    throw invalid_argument("FaceDetectPostprocess takes FP32 input tensors");
+  }
+  // a leading batch dimension of one is allowed
+  const auto& shape = input.getShape();
+  const auto dims = shape.size();
+  if (dims < 3) {
+    throw invalid_argument("FaceDetectPostprocess inputs must have a grid");
+  }
+  Output output;
+  output.data = static_cast<const float*>(input.getData());
+  output.channels = nchw ? shape[dims - 3] : shape[dims - 1];
+  output.height = nchw ? shape[dims - 2] : shape[dims - 3];
+  output.width = nchw ? shape[dims - 1] : shape[dims - 2];
+  if (input.getSize() !=
+      static_cast<size_t>(output.channels * output.height * output.width)) {
+    throw invalid_argument(
+      "FaceDetectPostprocess inputs must hold one image each");
+  }
+  return output;
+}
+
+}  // namespace
+
+/**
+ * @brief The FaceDetectPostprocess worker turns the outputs of a DenseBox
+ * face detection model, such as the Vitis AI or MIGraphX face detection
+ * models, into the boxes of the detected faces. It's meant to be chained after
+ * the model with the "next" load-time parameter so each batch of the model's
+ * outputs is decoded on the server and clients receive a few boxes per image
+ * instead of the dense maps.
+ *
+ */
+class FaceDetectPostprocess : public MultiThreadedWorker {
+ public:
+  using MultiThreadedWorker::MultiThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// Get the tensors of one request's outputs
+  [[nodiscard]] std::vector<Tensor> getOutputTensors() const;
+
+  /**
+   * @brief Detect the faces in one request's outputs. The buffers are reused
+   * for each request of a batch
+   */
+  size_t detect(const InferenceRequest& request, std::vector<uint32_t>* cells,
+                pre_post::YoloBoxes* candidates, float* boxes) const;
+
+  pre_post::FaceDetectOptions options_;
+  // at most this many boxes are returned per request
+  size_t max_boxes_ = 256;
+  int32_t threads_ = 1;
+  // CPUs the worker is pinned to
+  std::vector<int> cpus_;
+};
+
+std::vector<MemoryAllocators> FaceDetectPostprocess::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> FaceDetectPostprocess::getReservations()
+  const {
+  // the shapes of the model's outputs aren't known until they arrive so only
+  // the outputs are reserved
+  return this->reserveBatches({}, this->getOutputTensors());
+}
+
+std::vector<Tensor> FaceDetectPostprocess::getOutputTensors() const {
+  return {Tensor{"boxes",
+                 {static_cast<int64_t>(max_boxes_), kBoxSize},
+                 DataType::Fp32}};
+}
+
+void FaceDetectPostprocess::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+  constexpr auto kMaxBoxes = 256;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  if (parameters->has("conf_threshold")) {
+    options_.conf_threshold =
+      static_cast<float>(parameters->get<double>("conf_threshold"));
+  }
+  if (parameters->has("iou_threshold")) {
+    options_.iou_threshold =
+      static_cast<float>(parameters->get<double>("iou_threshold"));
+  }
+  if (parameters->has("step")) {
+    options_.step = parameters->get<int32_t>("step");
+  }
+  if (options_.step < 1) {
+    throw invalid_argument("step must be positive");
+  }
+  if (parameters->has("box_scale")) {
+    options_.box_scale =
+      static_cast<float>(parameters->get<double>("box_scale"));
+  }
+  if (parameters->has("layout")) {
+    const auto layout = parameters->get<std::string>("layout");
+    if (layout == "NCHW") {
+      options_.layout = pre_post::YoloLayout::NCHW;
+    } else if (layout == "NHWC") {
+      options_.layout = pre_post::YoloLayout::NHWC;
+    } else {
+      throw invalid_argument("Unknown layout: " + layout);
+    }
+  }
+
+  auto max_boxes = kMaxBoxes;
+  if (parameters->has("max_boxes")) {
+    max_boxes = parameters->get<int32_t>("max_boxes");
+  }
+  if (max_boxes < 1) {
+    throw invalid_argument("max_boxes must be positive");
+  }
+  max_boxes_ = static_cast<size_t>(max_boxes);
+
+  if (parameters->has("threads")) {
+    threads_ = parameters->get<int32_t>("threads");
+  }
+  if (threads_ < 1) {
+    throw invalid_argument("There must be at least one thread");
+  }
+  cpus_ = getPinnedCpus(*parameters);
+}
+
+void FaceDetectPostprocess::doAcquire(
+  [[maybe_unused]] ParameterMap* parameters) {
+  this->metadata_.addInputTensor(Tensor{"scores", {-1}, DataType::Fp32});
+  this->metadata_.addInputTensor(Tensor{"offsets", {-1}, DataType::Fp32});
+  for (const auto& tensor : this->getOutputTensors()) {
+    this->metadata_.addOutputTensor(tensor);
+  }
+  this->metadata_.setName("FaceDetectPostprocess");
+
+  this->createThreadPool(threads_, cpus_);
+}
+
+size_t FaceDetectPostprocess::detect(const InferenceRequest& request,
+                                     std::vector<uint32_t>* cells,
+                                     pre_post::YoloBoxes* candidates,
+                                     float* boxes) const {
+  const auto& inputs = request.getInputs();
+  if (inputs.size() != 2) {
+    throw invalid_argument(
+      "FaceDetectPostprocess expects 2 input tensors but got " +
+      std::to_string(inputs.size()));
+  }
+
+  // the outputs are told apart by their channels since models name and order
+  // them differently
+  const bool nchw = options_.layout == pre_post::YoloLayout::NCHW;
+  auto scores = getOutput(inputs[0], nchw);
+  auto offsets = getOutput(inputs[1], nchw);
+  if (scores.channels == 4) {
+    std::swap(scores, offsets);
+  }
+  if (scores.channels != 2 || offsets.channels != 4) {
+    throw invalid_argument(
+      "FaceDetectPostprocess expects outputs with 2 and 4 channels");
+  }
+  if (scores.height != offsets.height || scores.width != offsets.width) {
+    throw invalid_argument(
+      "FaceDetectPostprocess expects outputs with the same grid");
+  }
+
+  candidates->clear();
+  pre_post::decodeFaceDetect(scores.data, offsets.data,
+                             static_cast<int>(scores.height),
+                             static_cast<int>(scores.width), options_, cells,
+                             candidates);
+
+  const auto kept =
+    pre_post::nonMaximumSuppression(*candidates, options_.iou_threshold);
+  const auto count = std::min(kept.size(), max_boxes_);
+  for (auto i = 0U; i < count; ++i) {
+    const auto index = kept[i];
+    auto* box = boxes + i * kBoxSize;
+    box[0] = std::max(candidates->x1[index], 0.0F);
+    box[1] = std::max(candidates->y1[index], 0.0F);
+    box[2] = std::min(candidates->x2[index], 1.0F);
+    box[3] = std::min(candidates->y2[index], 1.0F);
+    box[4] = candidates->score[index];
+  }
+  return count;
+}
+
+BatchPtr FaceDetectPostprocess::doRun(Batch* batch, const MemoryPool* pool) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  const auto batch_size = batch->size();
+  const auto tensors = this->getOutputTensors();
+
+  std::vector<BufferPtr> input_buffers;
+  input_buffers.push_back(pool->get(next_allocators_, tensors[0], batch_size));
+  auto* boxes = static_cast<float*>(input_buffers[0]->data(0));
+  const auto stride = max_boxes_ * kBoxSize;
+
+  // the scratch buffers grow to the most faces in the batch and are reused
+  // for each image instead of being allocated for each one
+  std::vector<uint32_t> cells;
+  pre_post::YoloBoxes candidates;
+
+  auto new_batch = batch->propagate();
+  for (auto j = 0U; j < batch_size; ++j) {
+    const auto& request = batch->getRequest(j);
+    auto* request_boxes = boxes + j * stride;
+    size_t count = 0;
+    bool failed = false;
+    try {
+      count = this->detect(*request, &cells, &candidates, request_boxes);
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger, e.what());
+      request->runCallbackError(e.what());
+      failed = true;
+    }
+
+    auto new_request = request->propagate();
+    if (failed) {
+      // the slot stays in the batch to keep it aligned with the requests so
+      // later stages run it without responding again
+      new_request->setCallback([](const InferenceResponse&) {});
+    }
+    new_request->addInputTensor(InferenceRequestInput{
+      request_boxes, {static_cast<int64_t>(count), kBoxSize}, DataType::Fp32,
+      tensors[0].getName()});
+    new_batch->addRequest(new_request);
+    new_batch->setModel(j, "FaceDetectPostprocess");
+  }
+  new_batch->setBuffers(std::move(input_buffers), {});
+
+  return new_batch;
+}
+
+void FaceDetectPostprocess::doRelease() { this->destroyThreadPool(); }
+
+void FaceDetectPostprocess::doDestroy() {}
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::FaceDetectPostprocess("FaceDetectPostprocess",
+                                                      "CPU", true);
+}
+}  // extern C
@@ -0,0 +1,377 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the ImageDecode worker
+ */
+
+#include <algorithm>              // for fill_n
+#include <array>                  // for array
+#include <cstddef>                // for size_t
+#include <cstdint>                // for int32_t, uint8_t, int64_t
+#include <exception>              // for exception
+#include <memory>                 // for allocator
+#include <opencv2/core.hpp>       // for Mat, CV_8U, CV_32FC3
+#include <opencv2/imgcodecs.hpp>  // for imdecode, IMREAD_REDUCED_COLOR_2
+#include <opencv2/imgproc.hpp>    // for COLOR_BGR2RGB
+#include <string>                 // for string, stof
+#include <utility>                // for move, pair
+#include <vector>                 // for vector
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/declarations.hpp"             // for BufferPtr
+#include "amdinfer/observation/logging.hpp"      // for Logger
+#include "amdinfer/pre_post/image_preprocess.hpp"  // for imagePreprocess
+#include "amdinfer/util/string.hpp"                // for split
+#include "amdinfer/workers/worker.hpp"  // for MultiThreadedWorker
+
+namespace amdinfer::workers {
+
+namespace {
+
+constexpr auto kChannels = 3;
+
+/**
+ * @brief Read the size of a JPEG image from its frame header without decoding
+ * it
+ *
+ * @param data the encoded image
+ * @param size the size of the encoded image in bytes
+ * @param height set to the image's height
+ * @param width set to the image's width
+ * @return bool - false if the data isn't a JPEG image or it has no frame
+ */
+bool getJpegSize(const uint8_t* data, size_t size, int* height, int* width) {
+  constexpr uint8_t kMarker = 0xFF;
+  constexpr uint8_t kStartOfImage = 0xD8;
+  if (size < 4 || data[0] != kMarker || data[1] != kStartOfImage) {
+    return false;
+  }
+  size_t offset = 2;
+  while (offset + 4 <= size) {
+    if (data[offset] != kMarker) {
+      return false;
+    }
+    const auto marker = data[offset + 1];
+    // markers without a payload
+    if (marker == kStartOfImage || (marker >= 0xD0 && marker <= 0xD7) ||
+        marker == 0x01 || marker == kMarker) {
+      offset += marker == kMarker ? 1 : 2;
+      continue;
+    }
+    const auto length =
+      static_cast<size_t>(data[offset + 2] << 8 | data[offset + 3]);
+    // start of frame markers, skipping DHT, JPG and DAC which share the range
+    const auto frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                       marker != 0xC8 && marker != 0xCC;
+    if (frame) {
+      if (offset + 9 > size) {
+        return false;
+      }
+      *height = data[offset + 5] << 8 | data[offset + 6];
+      *width = data[offset + 7] << 8 | data[offset + 8];
+      return true;
+    }
+    offset += 2 + length;
+  }
+  return false;
+}
+
+/**
+ * @brief Get the flags to decode an image with. JPEG images that are at least
+ * twice the output size in both dimensions are scaled down by libjpeg while
+ * decoding, which skips most of the inverse DCT work.
+ *
+ * @param data the encoded image
+ * @param size the size of the encoded image in bytes
+ * @param height the output height
+ * @param width the output width
+ * @return int
+ */
+int getDecodeFlags(const uint8_t* data, size_t size, int height, int width) {
+  int image_height = 0;
+  int image_width = 0;
+  if (!getJpegSize(data, size, &image_height, &image_width)) {
+    return cv::IMREAD_COLOR;
+  }
+  const std::array<std::pair<int, int>, 3> reductions{
+    std::pair{8, cv::IMREAD_REDUCED_COLOR_8},
+    std::pair{4, cv::IMREAD_REDUCED_COLOR_4},
+    std::pair{2, cv::IMREAD_REDUCED_COLOR_2}};
+  for (const auto& [factor, flag] : reductions) {
+    // libjpeg rounds the scaled size up
+    if ((image_height + factor - 1) / factor >= height &&
+        (image_width + factor - 1) / factor >= width) {
+      return flag;
+    }
+  }
+  return cv::IMREAD_COLOR;
+}
+
+/// Parse a comma-separated list of one value per channel
+std::array<float, kChannels> parseChannels(const std::string& values,
+                                           const std::string& name) {
+  const auto items = util::split(values, ",");
+  if (items.size() != kChannels) {
+    throw invalid_argument(name + " must have " + std::to_string(kChannels) +
+                           " comma-separated values");
+  }
+  std::array<float, kChannels> parsed;
+  try {
+    for (auto i = 0; i < kChannels; ++i) {
+      parsed[i] = std::stof(items[i]);
+    }
+  } catch (const std::exception&) {
+    throw invalid_argument(name + " must be a list of numbers");
+  }
+  return parsed;
+}
+
+}  // namespace
+
+/**
+ * @brief The ImageDecode worker decodes encoded images, such as JPEG and PNG
+ * files, sent as BYTES tensors and preprocesses them into float tensors for a
+ * model. It's meant to be chained in front of the model with the "next"
+ * load-time parameter so clients send the much smaller encoded images instead
+ * of preprocessed tensors. The images are written straight into the pooled
+ * buffers of the next worker's batch. Letterboxed images carry their size to
+ * a YoloPostprocess worker at the end of the chain.
+ *
+ */
+class ImageDecode : public MultiThreadedWorker {
+ public:
+  using MultiThreadedWorker::MultiThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// Get the tensor of one preprocessed image
+  [[nodiscard]] Tensor getOutputTensor() const;
+
+  pre_post::ImagePreprocessOptions<float, kChannels> options_;
+  int32_t threads_ = 1;
+  // CPUs the worker is pinned to
+  std::vector<int> cpus_;
+};
+
+std::vector<MemoryAllocators> ImageDecode::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> ImageDecode::getReservations() const {
+  // the encoded images vary in size so only the outputs are reserved
+  return this->reserveBatches({}, {this->getOutputTensor()});
+}
+
+Tensor ImageDecode::getOutputTensor() const {
+  std::vector<int64_t> shape{options_.height, options_.width, kChannels};
+  if (options_.order == pre_post::ImageOrder::NCHW) {
+    shape = {kChannels, options_.height, options_.width};
+  }
+  return {"output", shape, DataType::Fp32};
+}
+
+void ImageDecode::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  auto& options = options_;
+  if (parameters->has("height")) {
+    options.height = parameters->get<int32_t>("height");
+  }
+  if (parameters->has("width")) {
+    options.width = parameters->get<int32_t>("width");
+  }
+  if (options.height <= 0 || options.width <= 0) {
+    throw invalid_argument("The height and width must be positive");
+  }
+
+  std::string order = "NCHW";
+  if (parameters->has("order")) {
+    order = parameters->get<std::string>("order");
+  }
+  if (order == "NCHW") {
+    options.order = pre_post::ImageOrder::NCHW;
+  } else if (order == "NHWC") {
+    options.order = pre_post::ImageOrder::NHWC;
+  } else {
+    throw invalid_argument("Unknown order " + order + ". Use NCHW or NHWC");
+  }
+
+  // OpenCV decodes images as BGR
+  std::string color = "RGB";
+  if (parameters->has("color")) {
+    color = parameters->get<std::string>("color");
+  }
+  if (color != "RGB" && color != "BGR") {
+    throw invalid_argument("Unknown color " + color + ". Use RGB or BGR");
+  }
+  options.convert_color = color == "RGB";
+  options.color_code = cv::COLOR_BGR2RGB;
+
+  std::string resize = "simple";
+  if (parameters->has("resize")) {
+    resize = parameters->get<std::string>("resize");
+  }
+  if (resize == "simple") {
+    options.resize_algorithm = pre_post::ResizeAlgorithm::Simple;
+  } else if (resize == "letterbox") {
+    options.resize_algorithm = pre_post::ResizeAlgorithm::LetterBoxCrop;
+  } else {
+    throw invalid_argument("Unknown resize " + resize +
+                           ". Use simple or letterbox");
+  }
+  if (parameters->has("pad")) {
+    options.pad_value = parameters->get<int32_t>("pad");
+  }
+
+  options.convert_type = true;
+  options.type = CV_32FC3;
+  options.convert_scale = 1.0 / 255;
+  if (parameters->has("scale")) {
+    options.convert_scale = parameters->get<double>("scale");
+  }
+
+  options.normalize = true;
+  options.mean = {0, 0, 0};
+  if (parameters->has("mean")) {
+    options.mean = parseChannels(parameters->get<std::string>("mean"), "mean");
+  }
+  // the options multiply by the inverse of the standard deviation
+  std::array<float, kChannels> std{1, 1, 1};
+  if (parameters->has("std")) {
+    std = parseChannels(parameters->get<std::string>("std"), "std");
+  }
+  for (auto i = 0; i < kChannels; ++i) {
+    if (std[i] == 0) {
+      throw invalid_argument("std can't be zero");
+    }
+    options.std[i] = 1 / std[i];
+  }
+
+  if (parameters->has("threads")) {
+    threads_ = parameters->get<int32_t>("threads");
+  }
+  if (threads_ < 1) {
+    throw invalid_argument("There must be at least one thread");
+  }
+  cpus_ = getPinnedCpus(*parameters);
+}
+
+void ImageDecode::doAcquire([[maybe_unused]] ParameterMap* parameters) {
+  this->metadata_.addInputTensor(Tensor{"input", {-1}, DataType::Bytes});
+  this->metadata_.addOutputTensor(this->getOutputTensor());
+  this->metadata_.setName("ImageDecode");
+
+  this->createThreadPool(threads_, cpus_);
+}
+
+BatchPtr ImageDecode::doRun(Batch* batch, const MemoryPool* pool) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  const auto batch_size = batch->size();
+  const auto tensor = this->getOutputTensor();
+  const auto image_size = tensor.getSize();
+
+  std::vector<BufferPtr> input_buffers;
+  input_buffers.push_back(pool->get(next_allocators_, tensor, batch_size));
+  auto* images = static_cast<float*>(input_buffers[0]->data(0));
+
+  auto new_batch = batch->propagate();
+  for (auto j = 0U; j < batch_size; ++j) {
+    const auto& request = batch->getRequest(j);
+    auto new_request = request->propagate();
+    auto* image = images + j * image_size;
+
+    try {
+      const auto& inputs = request->getInputs();
+      if (inputs.size() != 1 || inputs[0].getDatatype() != DataType::Bytes) {
+        throw invalid_argument("ImageDecode takes one BYTES input tensor");
+      }
+      const auto& input = inputs[0];
+      const auto* data = static_cast<const uint8_t*>(input.getData());
+      const auto size = input.getSize();
+
+      // the image is only viewed in place, not copied
+      const cv::Mat encoded{1, static_cast<int>(size), CV_8U,
+                            const_cast<uint8_t*>(data)};
+      const auto flags =
+        getDecodeFlags(data, size, options_.height, options_.width);
+      const auto img = cv::imdecode(encoded, flags);
+      if (img.empty()) {
+        throw invalid_argument("Failed to decode the image");
+      }
+      pre_post::imagePreprocess(img, options_, image);
+      if (options_.resize_algorithm ==
+          pre_post::ResizeAlgorithm::LetterBoxCrop) {
+        // so a YoloPostprocess worker later in the chain can map its boxes
+        // back from the letterbox to the image
+        auto parameters = request->getParameters();
+        parameters.put("image_height", img.rows);
+        parameters.put("image_width", img.cols);
+        new_request->setParameters(std::move(parameters));
+      }
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger, e.what());
+      std::fill_n(image, image_size, 0.0F);
+      new_request->runCallbackError(e.what());
+      // the slot stays in the batch to keep it aligned with the requests so
+      // later stages run it without responding again
+      new_request->setCallback([](const InferenceResponse&) {});
+    }
+
+    new_request->addInputTensor(InferenceRequestInput{
+      image, tensor.getShape(), DataType::Fp32, tensor.getName()});
+    new_batch->addRequest(new_request);
+    new_batch->setModel(j, "ImageDecode");
+  }
+  new_batch->setBuffers(std::move(input_buffers), {});
+
+  return new_batch;
+}
+
+void ImageDecode::doRelease() { this->destroyThreadPool(); }
+
+void ImageDecode::doDestroy() {}
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::ImageDecode("ImageDecode", "CPU", true);
+}
+}  // extern C
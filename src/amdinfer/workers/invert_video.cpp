@@ -18,42 +18,38 @@
  * @brief Implements the InvertVideo worker
  */
 
-#include <cstddef>                // for size_t
-#include <cstdint>                // for int32_t
-#include <memory>                 // for allocator, unique_ptr
-#include <opencv2/core.hpp>       // for bitwise_not, Mat
-#include <opencv2/imgcodecs.hpp>  // for imencode
-#include <opencv2/videoio.hpp>    // for VideoCapture, CV_CAP_PRO...
-#include <string>                 // for string, operator+, char_...
-#include <thread>                 // for thread
-#include <vector>                 // for vector
+#include <cstddef>              // for size_t
+#include <cstdint>              // for int32_t, uint64_t
+#include <memory>               // for allocator, unique_ptr
+#include <opencv2/core.hpp>     // for bitwise_not, Mat
+#include <string>               // for string, operator+, char_...
+#include <thread>               // for thread
+#include <utility>              // for move
+#include <vector>               // for vector
 
 #include "amdinfer/batching/batcher.hpp"        // for Batch, BatchPtrQueue
 #include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_TRACING
+#include "amdinfer/core/bytes_tensor.hpp"       // for BytesView
 #include "amdinfer/core/data_types.hpp"         // for DataType, DataType::Bytes
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
 #include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"          // for ParameterMap
 #include "amdinfer/declarations.hpp"         // for BufferPtr, InferenceRes...
 #include "amdinfer/observation/logging.hpp"  // for Logger
 #include "amdinfer/observation/tracing.hpp"  // for startFollowSpan, SpanPtr
-#include "amdinfer/util/base64.hpp"          // for base64_encode
 #include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/workers/worker.hpp"       // for Worker
+#include "amdinfer/workers/video_stream.hpp"  // for VideoStream
+#include "amdinfer/workers/worker.hpp"        // for Worker
 
 namespace amdinfer {
 
-std::string constructMessage(const std::string& key, const std::string& data) {
-  const std::string labels = R"([])";
-  return R"({"key": ")" + key + R"(", "data": {"img": ")" + data +
-         R"(", "labels": )" + labels + "}}";
-}
-
 namespace workers {
 
 /**
  * @brief The InvertVideo worker is a simple worker that accepts an path to a
  * video and sends the inverted frames back to the client over a websocket.
+ * Frames are decoded, inverted and encoded in a pipeline (see VideoStream).
  *
  */
 class InvertVideo : public SingleThreadedWorker {
@@ -67,16 +63,22 @@ class InvertVideo : public SingleThreadedWorker {
   BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
   void doRelease() override;
   void doDestroy() override;
+
+  /// Stream one video to the client
+  void stream(InferenceRequest* req, const InferenceRequestInput* input) const;
+
+  VideoStreamOptions options_;
 };
 
 std::vector<MemoryAllocators> InvertVideo::getAllocators() const {
   return {MemoryAllocators::Cpu};
 }
 
-void InvertVideo::doInit([[maybe_unused]] ParameterMap* parameters) {
+void InvertVideo::doInit(ParameterMap* parameters) {
   constexpr auto kBatchSize = 1;
 
   this->batch_size_ = kBatchSize;
+  options_ = getVideoStreamOptions(*parameters);
 }
 
 // Support up to Full HD
@@ -99,90 +101,73 @@ void InvertVideo::doAcquire(ParameterMap* parameters) {
 
 BatchPtr InvertVideo::doRun(Batch* batch,
                             [[maybe_unused]] const MemoryPool* pool) {
-#ifdef AMDINFER_ENABLE_LOGGING
-  const auto& logger = this->getLogger();
-#endif
-
+  // each video is decoded in its own pipeline so the videos of a batch are
+  // streamed concurrently
+  std::vector<std::thread> streams;
   for (unsigned int j = 0; j < batch->size(); j++) {
     const auto& req = batch->getRequest(j);
-    auto inputs = req->getInputs();
-    auto outputs = req->getOutputs();
-    auto key = req->getParameters().get<std::string>("key");
-    for (auto& input : inputs) {
-      auto* input_buffer = input.getData();
-
-      // TODO(varunsh): should strings have null terminators embedded?
-      const auto* idata = static_cast<char*>(input_buffer);
-      std::string data{idata, input.getSize()};
-
-      cv::VideoCapture cap(data);  // open the video file
-      if (!cap.isOpened()) {       // check if we succeeded
-        const char* error = "Cannot open video file";
-        AMDINFER_LOG_ERROR(logger, error);
-        req->runCallbackError(error);
-        continue;
-      }
-
-      InferenceResponse resp;
-      resp.setID(req->getID());
-      resp.setModel("invert_video");
-
-      // contains the number of frames in the video;
-      auto count = static_cast<int32_t>(
-        cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_COUNT));
-      if (input.getParameters().has("count")) {
-        count = input.getParameters().get<int32_t>("count");
-      }
-      double fps = cap.get(cv::VideoCaptureProperties::CAP_PROP_FPS);
-
-      InferenceResponseOutput output;
-      output.setName("key");
-      output.setDatatype(DataType::Bytes);
-      auto message = constructMessage(key, std::to_string(fps));
-      std::vector<std::byte> buffer;
-      buffer.resize(message.size());
-      memcpy(buffer.data(), message.data(), message.size());
-      output.setData(std::move(buffer));
-      output.setShape({static_cast<int64_t>(message.size())});
-      resp.addOutput(output);
-      req->runCallback(resp);
-      for (int num_frames = 0; num_frames < count; num_frames++) {
-        cv::Mat frame;
-        cap >> frame;  // get the next frame from video
-        if (frame.empty()) {
-          num_frames--;
-          continue;
-        }
-        cv::bitwise_not(frame, frame);
-        std::vector<unsigned char> buf;
-        cv::imencode(".jpg", frame, buf);
-        const auto* enc_msg = reinterpret_cast<const char*>(buf.data());
-        std::string encoded =
-          "data:image/jpg;base64," + util::base64Encode(enc_msg, buf.size());
-
-        InferenceResponse resp;
-        resp.setID(req->getID());
-        resp.setModel("invert_video");
-
-        InferenceResponseOutput output;
-        output.setName("image");
-        output.setDatatype(DataType::Bytes);
-        message = constructMessage(key, encoded);
-        std::vector<std::byte> buffer;
-        buffer.resize(message.size());
-        memcpy(buffer.data(), message.data(), message.size());
-        output.setData(std::move(buffer));
-        output.setShape({static_cast<int64_t>(message.size())});
-        resp.addOutput(output);
-        req->runCallback(resp);
-      }
+    for (const auto& input : req->getInputs()) {
+      streams.emplace_back(&InvertVideo::stream, this, req.get(), &input);
     }
   }
+  for (auto& stream : streams) {
+    stream.join();
+  }
 
   // okay because ensembles disabled for this worker
   return nullptr;
 }
 
+void InvertVideo::stream(InferenceRequest* req,
+                         const InferenceRequestInput* input) const {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+  util::setThreadName("InvertVideo");
+  auto key = req->getParameters().get<std::string>("key");
+
+  // the first element is the path or URL of the video
+  const BytesView elements{input->getData(), input->getSize()};
+  std::string data{elements.empty() ? std::string_view{} : elements[0]};
+
+  auto options = options_;
+  try {
+    options.encoding = getFrameEncoding(req->getParameters());
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger, e.what());
+    req->runCallbackError(e.what());
+    return;
+  }
+  const auto encoding = options.encoding;
+  options.filter = [](cv::Mat* frame) { cv::bitwise_not(*frame, *frame); };
+  VideoStream video{data, std::move(options)};
+  if (!video.isOpened()) {
+    const char* error = "Cannot open video file";
+    AMDINFER_LOG_ERROR(logger, error);
+    req->runCallbackError(error);
+    return;
+  }
+
+  // contains the number of frames in the video;
+  auto count = video.count();
+  if (input->getParameters().has("count")) {
+    count = input->getParameters().get<int32_t>("count");
+  }
+
+  const std::string model = "invert_video";
+  sendMessage(req, model, "key",
+              makeMetadataMessage(key, encoding, video.fps(), "[]"), encoding);
+
+  video.start(count);
+  uint64_t index = 0;
+  while (auto* frame = video.next()) {
+    auto message = makeFrameMessage(key, index++, encoding, frame->encoded,
+                                    frame->image.size(), "[]");
+    video.release(frame);
+    sendFrame(req, model, message, encoding);
+  }
+}
+
 void InvertVideo::doRelease() {}
 void InvertVideo::doDestroy() {}
 
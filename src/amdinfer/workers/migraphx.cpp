@@ -17,20 +17,32 @@
  * @brief Implements the Migraphx worker.
  */
 
-#include <migraphx/migraphx.h>  // for migraphx_shape_datatype_t
-
-#include <algorithm>              // for max
+#include <hip/hip_runtime_api.h>  // for hipMemcpy, hipDeviceSynchronize
+#include <migraphx/migraphx.h>    // for migraphx_shape_datatype_t
+#include <rocm_smi/rocm_smi.h>    // for rsmi_dev_busy_percent_get
+
+#include <algorithm>              // for max, sort
+#include <array>                  // for array
+#include <cassert>                // for assert
+#include <cstdint>                // for int32_t, int64_t
 #include <cstddef>                // for byte, size_t
-#include <cstring>                // for memcpy
+#include <cstring>                // for memcpy, strlen
 #include <exception>              // for exception
 #include <filesystem>             // for path
 #include <fstream>                // for ifstream, operator<<
+#include <functional>             // for greater
+#include <iterator>               // for istreambuf_iterator, next, prev
 #include <map>                    // for map
-#include <memory>                 // for allocator, unique_ptr
+#include <memory>                 // for allocator, unique_ptr, shared_ptr
+#include <mutex>                  // for mutex, unique_lock, call_once
 #include <migraphx/migraphx.hpp>  // for shape, program, progra...
+#include <migraphx/version.h>      // for MIGRAPHX_VERSION_MAJOR
+#include <optional>               // for optional
 #include <ratio>                  // for micro
+#include <sstream>                // for stringstream
 #include <stdexcept>              // for invalid_argument, runt...
 #include <string>                 // for string, operator+, to_...
+#include <string_view>            // for string_view
 #include <thread>                 // for thread
 #include <utility>                // for move
 #include <vector>                 // for vector
@@ -43,15 +55,17 @@
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"          // for ParameterMap
 #include "amdinfer/declarations.hpp"             // for InferenceResponseOutput
-#include "amdinfer/observation/logging.hpp"  // for AMDINFER_LOG_INFO, AMD...
-#include "amdinfer/observation/metrics.hpp"  // for Metrics, MetricCounterIDs
-#include "amdinfer/util/containers.hpp"      // for containerProduct
-#include "amdinfer/util/memory.hpp"          // for copy
-#include "amdinfer/util/queue.hpp"           // for BufferPtrsQueue
-#include "amdinfer/util/string.hpp"          // for contains
-#include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/util/timer.hpp"           // for Timer
-#include "amdinfer/workers/worker.hpp"       // for Worker, kNumBufferAuto
+#include "amdinfer/observation/logging.hpp"    // for AMDINFER_LOG_INFO, AMD...
+#include "amdinfer/observation/metrics.hpp"    // for Metrics, MetricCounterIDs
+#include "amdinfer/observation/profiling.hpp"  // for profileEvent, profileNow
+#include "amdinfer/util/artifact_cache.hpp"     // for ArtifactKey
+#include "amdinfer/util/containers.hpp"        // for containerProduct
+#include "amdinfer/util/memory.hpp"            // for copy
+#include "amdinfer/util/queue.hpp"             // for BufferPtrsQueue
+#include "amdinfer/util/string.hpp"            // for contains, split
+#include "amdinfer/util/thread.hpp"            // for setThreadName
+#include "amdinfer/util/timestamps.hpp"        // for Timestamps
+#include "amdinfer/workers/worker.hpp"         // for Worker, kNumBufferAuto
 
 namespace amdinfer::workers {
 
@@ -59,39 +73,480 @@ namespace amdinfer::workers {
  * @brief The Migraphx worker accepts the name of an migraphx model file as an
  * argument and compiles and evaluates it.
  *
+ * By default, each batch is evaluated synchronously. With the streams load
+ * parameter, programs that take device pointers are run asynchronously
+ * instead: each batch in flight has its own HIP stream so copying the inputs
+ * of the next batch and the outputs of the previous one overlap the compute
+ * of the current batch. A separate thread waits for the batches in order and
+ * builds their output batches. Multiplexed workers always run synchronously
+ * on their multiplexer's thread.
+ *
+ * With the hip_graphs load parameter, each program's launches are captured
+ * into a HIP graph the first time it runs and replayed after that so small
+ * models don't pay for launching each kernel. A graph always reads and writes
+ * the buffers it was captured with so each batch's inputs and outputs are
+ * copied in and out of them on the device.
  */
-class MIGraphXWorker : public SingleThreadedWorker {
+class MIGraphXWorker : public Worker {
  public:
-  using SingleThreadedWorker::SingleThreadedWorker;
+  using Worker::Worker;
   [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+  void run(BatchPtrQueue* input_queue, const MemoryPool* pool) override;
+  void runBatch(BatchPtr batch, const MemoryPool* pool) override;
+  [[nodiscard]] bool isMultiplexable() const override { return true; }
 
  private:
+  struct Program;
+
+  /// A batch in flight on a stream
+  struct Job {
+    Batch* batch = nullptr;
+    const Program* program = nullptr;
+    hipStream_t stream = nullptr;
+    /// Recorded on the stream when the batch's compute is done
+    hipEvent_t computed = nullptr;
+    // device memory used only while evaluating this batch
+    std::vector<BufferPtr> staged_buffers;
+    // the buffers bound to the outputs, in device memory or, if they're
+    // written to the host, page-locked memory
+    std::vector<BufferPtr> device_outputs;
+    /// The outputs each request asked for
+    std::vector<std::vector<size_t>> selected;
+    /// Index of each output's buffer in next_buffers, if any request wants it
+    std::vector<int> slots;
+    /// The requested outputs for the next worker
+    BufferPtrs next_buffers;
+    /// The endpoint's turn on the GPU if it shares it with other endpoints
+    std::shared_ptr<void> turn;
+  };
+
   void doInit(ParameterMap* parameters) override;
   void doAcquire(ParameterMap* parameters) override;
   BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
   void doRelease() override;
   void doDestroy() override;
+  /// Warm up each of the compiled programs
+  [[nodiscard]] std::vector<size_t> getWarmupBatchSizes() const override;
+#ifdef AMDINFER_ENABLE_METRICS
+  /// Watch the GPU's utilization and memory with ROCm SMI
+  void watchDevice(ModelMetrics* metrics) override;
+#endif
 
-  void compile(const std::string& onnx_path, const std::string& compiled_path);
+  /**
+   * @brief Find the outputs each request in the batch asked for so only those
+   * are copied out
+   *
+   * @param batch the batch
+   * @param selected the outputs each request asked for
+   * @param slots the index of each output among the requested ones, or -1 if
+   * no request asked for it
+   */
+  void selectBatchOutputs(const Batch& batch,
+                          std::vector<std::vector<size_t>>* selected,
+                          std::vector<int>* slots) const;
+  /**
+   * @brief Allocate the buffer an output of a program batch is written to
+   *
+   * @param index index of the output
+   * @param shape the output's shape in the program
+   * @param write_to_host if true, a requested output is written straight to
+   * page-locked host memory. Otherwise, it's written to device memory
+   * @param pool pool to allocate the buffer from
+   * @param slots the index of each output among the requested ones, or -1 if
+   * no request asked for it
+   * @param buffers the buffers of the outputs to add the buffer to
+   * @return void* the address the program writes the output to
+   */
+  void* bindOutput(size_t index, const migraphx::shape& shape,
+                   bool write_to_host, const MemoryPool* pool,
+                   const std::vector<int>& slots,
+                   std::vector<BufferPtr>* buffers) const;
+  /// Queue a batch's copies and compute on its job's stream
+  bool submit(Batch* batch, const MemoryPool* pool, Job* job);
+  /**
+   * @brief Capture a program's launches into a HIP graph. If it can't be
+   * captured, it's logged and the program is launched directly instead
+   *
+   * @param program the program to capture
+   * @param pool pool to allocate the buffers the graph uses from
+   * @param stream stream to capture on. Nothing may be queued on it during
+   * the capture
+   */
+  void capture(Program* program, const MemoryPool* pool, hipStream_t stream);
+  /**
+   * @brief Queue a program's compute on a stream, replaying its graph if it
+   * has one
+   *
+   * @param program the program to run
+   * @param params the program's parameters, bound to the batch's buffers
+   * @param inputs the batch's inputs, in the order of input_names_
+   * @param outputs the batch's outputs, in the order of output_names_
+   * @param stream stream to queue the work on
+   */
+  void launch(const Program& program,
+              const migraphx::program_parameters& params,
+              const std::vector<void*>& inputs,
+              const std::vector<void*>& outputs, hipStream_t stream) const;
+  /// Wait for a job's stream and build the output batch
+  BatchPtr complete(Job* job);
+  /// Complete jobs in submission order until a null job arrives
+  void completeJobs(BlockingQueue<Job*>* in_flight,
+                    BlockingQueue<Job*>* free_jobs,
+                    BlockingQueue<BatchPtr>* batches);
+  /// Send a batch's outputs to the next worker and release the batch
+  void forward(Batch* batch, BatchPtr new_batch);
+
+  /**
+   * @brief Compile the program that turns uint8 NHWC images into the model's
+   * first input
+   *
+   * @param input_shape shape of the model's first input
+   */
+  migraphx::program compilePreprocess(const migraphx::shape& input_shape) const;
+  /**
+   * @brief Queue the preprocessing of a program batch of images on the GPU
+   *
+   * @param program the program the batch is evaluated with
+   * @param images the batch's images in device memory
+   * @param pool pool to allocate the preprocessed input from
+   * @param staged device memory used only while evaluating the batch
+   * @param stream stream to queue the work on or nullptr to run it
+   * synchronously
+   * @return void* the preprocessed input in device memory
+   */
+  void* preprocess(const Program& program, void* images, const MemoryPool* pool,
+                   std::vector<BufferPtr>* staged, hipStream_t stream) const;
+
+  /**
+   * @brief Compile the ONNX model for a batch size and save the program
+   *
+   * @param onnx_path path to the ONNX model
+   * @param compiled_path path to save the compiled program to. If it's empty,
+   * the program isn't saved
+   * @param batch_size the batch size to compile for
+   * @return migraphx::program
+   */
+  migraphx::program compile(const std::string& onnx_path,
+                            const std::filesystem::path& compiled_path,
+                            size_t batch_size);
+  migraphx::program load(size_t batch_size);
+  /**
+   * @brief Get the path to the program compiled from the ONNX model for a
+   * batch size in the artifact cache. Its key covers everything the program
+   * depends on: the model, the calibration samples, the MIGraphX version, the
+   * GPU's architecture and the compile options
+   *
+   * @param onnx_path path to the ONNX model
+   * @param batch_size the batch size to compile for
+   * @return std::filesystem::path the path or an empty path if the cache is
+   * off or the model doesn't exist
+   */
+  std::filesystem::path getCachedPath(const std::filesystem::path& onnx_path,
+                                      size_t batch_size) const;
+  /**
+   * @brief Quantize a parsed program to int8, calibrating the scales by
+   * evaluating it on the samples in the calibration file
+   *
+   * @param prog the parsed program
+   * @param target the target the program is compiled for
+   * @param batch_size the batch size the program was parsed with
+   */
+  void quantizeInt8(migraphx::program* prog, const migraphx::target& target,
+                    size_t batch_size) const;
 
   // the model file to be loaded.  Supported types are *.onnx and *.mxr
   std::filesystem::path input_file_;
-  // The prog_ is populated by reading the model file and contains most of
+  // precision to compile the model at: native, fp16 or int8
+  std::string precision_;
+  // raw input samples, one request's inputs after another, to calibrate int8
+  std::filesystem::path calibration_file_;
+  // directory of the compiled artifact cache or empty if it's off
+  std::filesystem::path cache_dir_;
+  struct Preprocess {
+    migraphx::program program;
+    // shape of the batch of uint8 images it takes
+    migraphx::shape image_shape;
+    // name and shape of the parameter that holds the model's first input
+    std::string output_name;
+    migraphx::shape output_shape;
+  };
+  /// A program's launches captured into a HIP graph and the device buffers
+  /// that they read and write
+  struct Graph {
+    hipGraphExec_t exec = nullptr;
+    std::vector<BufferPtr> inputs;
+    std::vector<BufferPtr> outputs;
+  };
+  struct Program {
+    migraphx::program program;
+    // shapes of the program's inputs, in the order of input_names_
+    std::vector<migraphx::shape> input_shapes;
+    // shapes of the parameters that hold the outputs, if device_io_
+    std::vector<migraphx::shape> output_shapes;
+    // preprocessing for the first input, if enabled
+    std::optional<Preprocess> preprocess;
+    // the captured launches, if hip_graphs and it's run yet
+    std::optional<Graph> graph;
+    // true if the program couldn't be captured so it's launched directly
+    bool capture_failed = false;
+  };
+  // The programs are populated by reading the model file and contain most of
   // the worker's important info such as number, data types and sizes of
-  // input and output buffers
-  migraphx::program prog_;
+  // input and output buffers. There's one program for each compiled batch
+  // size and each batch is evaluated with the smallest program it fits in.
+  std::map<size_t, Program> programs_;
+  /// The compiled programs that the instances on a device share. MIGraphX
+  /// programs are handles so each instance's copies use the same code, weights
+  /// and scratch memory while the streams, jobs and graphs stay per instance
+  struct SharedPrograms {
+    SharedPrograms() = default;
+    SharedPrograms(const SharedPrograms&) = delete;
+    SharedPrograms& operator=(const SharedPrograms&) = delete;
+    SharedPrograms(SharedPrograms&&) = delete;
+    SharedPrograms& operator=(SharedPrograms&&) = delete;
+    ~SharedPrograms() {
+      if (computed != nullptr) {
+        hipEventDestroy(computed);
+      }
+    }
+
+    // held while the programs are loaded and while work is queued on them
+    // since a program can't be run from many threads at once
+    std::mutex mutex;
+    std::map<size_t, migraphx::program> programs;
+    std::map<size_t, migraphx::program> preprocess;
+    // recorded after the last queued compute. The scratch memory is shared so
+    // computes on different streams must not overlap
+    hipEvent_t computed = nullptr;
+  };
+  /**
+   * @brief Get the programs shared by the instances that load the same model
+   * with the same options on the same device. They're empty if this is the
+   * first such instance
+   *
+   * @param batch_sizes the batch sizes to compile for
+   * @return std::shared_ptr<SharedPrograms>
+   */
+  std::shared_ptr<SharedPrograms> getSharedPrograms(
+    const std::vector<size_t>& batch_sizes) const;
+  std::shared_ptr<SharedPrograms> shared_;
+  /// Get the smallest program that fits the whole batch
+  std::map<size_t, Program>::iterator getProgram(size_t batch_size);
+#ifdef AMDINFER_ENABLE_METRICS
+  /// Record how many unused samples the program runs to fit the batch
+  void recordPadding(const Batch& batch, size_t program_batch_size) const;
+#endif
 
   // flag to pad out a batch with dummy data.  Sending a batch of requests
   // with uninitialized data may crash MIGraphX, for certain models.
   // If pad_batch_ is true, this worker will pad any unused request slots
   // in a batch with dummy copies of the first request.
   bool pad_batch_ = true;
-  // Calculated sizes in bytes for each input tensor, by input name
-  std::map<std::string, size_t, std::less<>> input_sizes_;
+  // Names of the inputs, in the order requests are bound to them
+  std::vector<std::string> input_names_;
+  // Calculated sizes in bytes for each input tensor of a single request
+  std::vector<size_t> input_sizes_;
+  // Names of the parameters that hold the outputs, if device_io_
+  std::vector<std::string> output_names_;
+  // Calculated sizes in bytes for each output tensor of a single request
+  std::vector<size_t> output_sizes_;
+  // Names the outputs are published and requested by
+  std::vector<std::string> output_tensor_names_;
+  // If true, the programs were compiled without offload copy so they take
+  // device pointers for their inputs and outputs
+  bool device_io_ = false;
+  // GPU the worker was placed on or -1 to use the loading thread's device
+  int device_ = -1;
+  // One job per stream if the programs run asynchronously
+  std::vector<std::unique_ptr<Job>> jobs_;
+  // If true, the programs are captured into HIP graphs that are replayed
+  bool hip_graphs_ = false;
+  // If true, outputs that go to the host are written by the programs straight
+  // into page-locked memory that's passed on instead of copied from the device
+  bool pinned_outputs_ = false;
+
+  // If true, the first input is sent as images that are preprocessed on the
+  // GPU. The other members describe the images and the preprocessing
+  bool preprocess_ = false;
+  // size of the images or 0 to use the size of the model's input
+  int64_t image_height_ = 0;
+  int64_t image_width_ = 0;
+  // if true, the images are RGB and the model expects BGR
+  bool swap_channels_ = false;
+  float scale_ = 1.0F / 255;
+  std::array<float, 3> mean_{0, 0, 0};
+  std::array<float, 3> std_{1, 1, 1};
+};
+
+namespace {
+
+/// The points in running a batch that are timed
+enum class RunEvent { BatchStart, EvalStart, EvalEnd, BatchStop, Count };
+
+constexpr auto kOutputParameter = "#output_";
+constexpr auto kNativePrecision = "native";
+// name of the images parameter of the preprocessing programs
+constexpr auto kImageParameter = "image";
+constexpr auto kChannels = 3;
+
+/// Get the names of the program's inputs
+std::vector<std::string> getInputNames(migraphx::program& prog) {
+  std::vector<std::string> names;
+  auto shapes = prog.get_parameter_shapes();
+  for (const auto* name : shapes.names()) {
+    if (!util::contains(name, kOutputParameter)) {
+      names.emplace_back(name);
+    }
+  }
+  return names;
+}
+
+/**
+ * @brief Get the names of the parameters that hold the program's outputs, in
+ * order. Programs compiled without offload copy have these parameters and the
+ * caller provides the device memory for the outputs.
+ *
+ * @param prog program to check
+ * @return std::vector<std::string>
+ */
+std::vector<std::string> getOutputNames(migraphx::program& prog) {
+  std::vector<std::pair<size_t, std::string>> outputs;
+  auto shapes = prog.get_parameter_shapes();
+  for (const auto* name : shapes.names()) {
+    std::string_view view{name};
+    if (auto pos = view.find(kOutputParameter); pos != std::string::npos) {
+      auto index = std::stoul(
+        std::string{view.substr(pos + std::strlen(kOutputParameter))});
+      outputs.emplace_back(index, name);
+    }
+  }
+  std::sort(outputs.begin(), outputs.end());
+
+  std::vector<std::string> names;
+  names.reserve(outputs.size());
+  for (auto& [index, name] : outputs) {
+    names.push_back(std::move(name));
+  }
+  return names;
+}
+
+/// Copy memory between any combination of host and device memory
+void copyMemory(void* dst, const void* src, size_t size) {
+  if (hipMemcpy(dst, src, size, hipMemcpyDefault) != hipSuccess) {
+    throw runtime_error("MIGraphX worker failed to copy memory");
+  }
+}
+
+/// Queue a copy between any combination of host and device memory
+void copyMemoryAsync(void* dst, const void* src, size_t size,
+                     hipStream_t stream) {
+  if (hipMemcpyAsync(dst, src, size, hipMemcpyDefault, stream) != hipSuccess) {
+    throw runtime_error("MIGraphX worker failed to copy memory");
+  }
+}
+
+void checkHip(hipError_t status, const std::string& what) {
+  if (status != hipSuccess) {
+    throw runtime_error("MIGraphX worker failed to " + what + ": " +
+                        hipGetErrorString(status));
+  }
+}
+
+/// Get the address that kernels write page-locked host memory through
+void* getDevicePointer(void* host) {
+  void* device = nullptr;
+  checkHip(hipHostGetDevicePointer(&device, host, 0),
+           "map the output to the device");
+  return device;
+}
+
+/// Make a device current while the guard is alive and then restore the last
+class DeviceGuard {
+ public:
+  /**
+   * @brief Construct a new DeviceGuard object
+   *
+   * @param device the device to use or -1 to keep the current one
+   */
+  explicit DeviceGuard(int device) {
+    if (device >= 0) {
+      checkHip(hipGetDevice(&previous_), "get the current device");
+      checkHip(hipSetDevice(device), "set the device");
+    }
+  }
+  ~DeviceGuard() {
+    if (previous_ >= 0) {
+      hipSetDevice(previous_);
+    }
+  }
+  DeviceGuard(DeviceGuard const&) = delete;
+  DeviceGuard& operator=(const DeviceGuard&) = delete;
+  DeviceGuard(DeviceGuard&& other) = delete;
+  DeviceGuard& operator=(DeviceGuard&& other) = delete;
+
+ private:
+  int previous_ = -1;
 };
 
+/// Parse a comma-separated list of one value per channel
+std::array<float, kChannels> parseChannels(const std::string& values,
+                                           const std::string& name) {
+  const auto items = util::split(values, ",");
+  if (items.size() != kChannels) {
+    throw invalid_argument(name + " must have " + std::to_string(kChannels) +
+                           " comma-separated values");
+  }
+  std::array<float, kChannels> parsed;
+  try {
+    for (auto i = 0; i < kChannels; ++i) {
+      parsed[i] = std::stof(items[i]);
+    }
+  } catch (const std::exception&) {
+    throw invalid_argument(name + " must be a list of numbers");
+  }
+  return parsed;
+}
+
+}  // namespace
+
 std::vector<MemoryAllocators> MIGraphXWorker::getAllocators() const {
-  return {MemoryAllocators::Cpu};
+  // batch directly into device memory if the programs take device pointers.
+  // Otherwise, use page-locked memory so it can be copied to the GPU directly.
+  // Batchers allocate on the default device so workers placed on a device
+  // batch in host memory and copy it to their own
+  if (device_io_ && device_ < 0) {
+    return {MemoryAllocators::HipDevice, MemoryAllocators::CpuPinned,
+            MemoryAllocators::Cpu};
+  }
+  return {MemoryAllocators::CpuPinned, MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> MIGraphXWorker::getReservations() const {
+  auto toTensor = [](const std::string& name, size_t size) {
+    return Tensor{name, {static_cast<int64_t>(size)}, DataType::Uint8};
+  };
+
+  std::vector<Tensor> inputs;
+  for (auto i = 0U; i < input_names_.size(); ++i) {
+    inputs.push_back(toTensor(input_names_[i], input_sizes_[i]));
+  }
+  std::vector<Tensor> outputs;
+  for (const auto& size : output_sizes_) {
+    outputs.push_back(toTensor("", size));
+  }
+  return this->reserveBatches(inputs, outputs);
+}
+
+std::vector<size_t> MIGraphXWorker::getWarmupBatchSizes() const {
+  std::vector<size_t> batch_sizes;
+  batch_sizes.reserve(programs_.size());
+  for (const auto& [batch_size, _] : programs_) {
+    batch_sizes.push_back(batch_size);
+  }
+  return batch_sizes;
 }
 
 /**
@@ -133,8 +588,9 @@ DataType toDataType(migraphx_shape_datatype_t in) {
   }
 }
 
-void MIGraphXWorker::compile(const std::string& onnx_path,
-                             const std::string& compiled_path) {
+migraphx::program MIGraphXWorker::compile(
+  const std::string& onnx_path, const std::filesystem::path& compiled_path,
+  size_t batch_size) {
 #ifdef AMDINFER_ENABLE_LOGGING
   const auto& logger = this->getLogger();
 #endif
@@ -158,18 +614,18 @@ void MIGraphXWorker::compile(const std::string& onnx_path,
     std::string("migraphx worker loading ONNX model file ") + onnx_path);
 
   migraphx::onnx_options onnx_opts;
-  onnx_opts.set_default_dim_value(static_cast<unsigned int>(batch_size_));
-  this->prog_ = migraphx::parse_onnx(onnx_path.c_str(), onnx_opts);
-
-  auto param_shapes =
-    prog_.get_parameter_shapes();  // program_parameter_shapes struct
+  onnx_opts.set_default_dim_value(static_cast<unsigned int>(batch_size));
+  auto prog = this->timeLoadPhase(LoadPhase::ReadModel, [&]() {
+    return migraphx::parse_onnx(onnx_path.c_str(), onnx_opts);
+  });
 
   AMDINFER_LOG_INFO(logger,
                     "migraphx worker loaded ONNX model file " + onnx_path);
 
-  // Compile the model.  Hard-coded choices of offload_copy and gpu target
+  // Compile the model for the gpu target without offload copy so inputs and
+  // outputs can stay in device memory between stages
   migraphx::compile_options comp_opts;
-  comp_opts.set_offload_copy();
+  comp_opts.set_offload_copy(false);
 
   // migraphx can support a reference (cpu) target as a fallback if GPU is
   // not found; not implemented here
@@ -179,7 +635,17 @@ void MIGraphXWorker::compile(const std::string& onnx_path,
   // The hip library will throw a cryptic error if unable to connect with
   // a GPU at this point.
   try {
-    prog_.compile(migraphx::target("gpu"), comp_opts);
+    this->timeLoadPhase(LoadPhase::Compile, [&]() {
+      // quantizing rewrites the parsed program so it happens before compiling
+      if (precision_ == "fp16") {
+        migraphx::quantize_fp16(prog);
+      } else if (precision_ == "int8") {
+        this->quantizeInt8(&prog, targ, batch_size);
+      }
+      prog.compile(targ, comp_opts);
+    });
+  } catch (const invalid_argument&) {
+    throw;
   } catch (const std::exception& e) {
     std::string error = e.what();
     if (util::contains(error, "Failed to call function")) {
@@ -189,15 +655,324 @@ void MIGraphXWorker::compile(const std::string& onnx_path,
     throw external_error(error);
   }
 
-  // Save the compiled program as a MessagePack (*.mxr) file
-  f = std::ifstream(compiled_path.c_str());
-  if (!f.good()) {
+  // Save the compiled program as a MessagePack (*.mxr) file. It's written
+  // under a temporary name so other servers sharing the cache never load it
+  // half-written
+  if (!compiled_path.empty()) {
     migraphx::file_options options;
     options.set_file_format("msgpack");
 
-    migraphx::save(this->prog_, compiled_path.c_str(), options);
-    AMDINFER_LOG_INFO(logger, " Saved compiled model file " + compiled_path);
+    const auto temporary = util::getTemporaryPath(compiled_path);
+    try {
+      migraphx::save(prog, temporary.c_str(), options);
+      if (util::publishArtifact(temporary, compiled_path)) {
+        AMDINFER_LOG_INFO(
+          logger, "Saved compiled model file " + compiled_path.string());
+      }
+    } catch (const std::exception& e) {
+      std::filesystem::remove(temporary);
+      AMDINFER_LOG_WARN(logger, "Could not save compiled model file " +
+                                  compiled_path.string() + ": " + e.what());
+    }
   }
+  return prog;
+}
+
+void MIGraphXWorker::quantizeInt8(migraphx::program* prog,
+                                  const migraphx::target& target,
+                                  size_t batch_size) const {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  std::ifstream file{calibration_file_, std::ios::binary};
+  if (!file.good()) {
+    throw invalid_argument("calibration file " + calibration_file_.string() +
+                           " not found or can't be opened");
+  }
+  const std::vector<char> samples{std::istreambuf_iterator<char>{file},
+                                  std::istreambuf_iterator<char>{}};
+
+  auto shapes = prog->get_parameter_shapes();
+  const auto names = getInputNames(*prog);
+  size_t sample_size = 0;
+  for (const auto& name : names) {
+    sample_size += shapes[name.c_str()].bytes() / batch_size;
+  }
+  const auto num_samples = samples.size() / sample_size;
+  if (num_samples == 0) {
+    throw invalid_argument("calibration file " + calibration_file_.string() +
+                           " has no complete input samples of " +
+                           std::to_string(sample_size) + " bytes");
+  }
+
+  // each calibration batch is filled with consecutive samples, wrapping
+  // around to the first ones to fill the last batch
+  const auto num_batches = (num_samples + batch_size - 1) / batch_size;
+  std::vector<std::vector<char>> buffers;
+  buffers.reserve(num_batches * names.size());
+  migraphx::quantize_int8_options options;
+  for (auto i = 0U; i < num_batches; ++i) {
+    migraphx::program_parameters parameters;
+    size_t offset = 0;
+    for (const auto& name : names) {
+      const auto shape = shapes[name.c_str()];
+      const auto size = shape.bytes() / batch_size;
+      auto& buffer = buffers.emplace_back(shape.bytes());
+      for (auto j = 0U; j < batch_size; ++j) {
+        const auto sample = ((i * batch_size) + j) % num_samples;
+        std::memcpy(buffer.data() + (j * size),
+                    samples.data() + (sample * sample_size) + offset, size);
+      }
+      parameters.add(name.c_str(), migraphx::argument(shape, buffer.data()));
+      offset += size;
+    }
+    options.add_calibration_data(parameters);
+  }
+
+  AMDINFER_LOG_INFO(logger, "migraphx worker calibrating int8 with " +
+                              std::to_string(num_samples) + " samples");
+  migraphx::quantize_int8(*prog, target, options);
+}
+
+migraphx::program MIGraphXWorker::compilePreprocess(
+  const migraphx::shape& input_shape) const {
+  const auto lengths = input_shape.lengths();
+  if (lengths.size() != 4) {
+    throw invalid_argument(
+      "preprocess needs the model's first input to be a batch of images");
+  }
+  const bool nchw = lengths[1] == kChannels;
+  if (!nchw && lengths[3] != kChannels) {
+    throw invalid_argument("preprocess needs the model's first input to be " +
+                           std::to_string(kChannels) + " channel NCHW or NHWC");
+  }
+  const auto batch_size = lengths[0];
+  const auto height = nchw ? lengths[2] : lengths[1];
+  const auto width = nchw ? lengths[3] : lengths[2];
+  const auto image_height =
+    image_height_ > 0 ? static_cast<size_t>(image_height_) : height;
+  const auto image_width =
+    image_width_ > 0 ? static_cast<size_t>(image_width_) : width;
+
+  migraphx::program prog;
+  auto module = prog.get_main_module();
+  auto image = module.add_parameter(
+    kImageParameter,
+    migraphx::shape{migraphx_shape_uint8_type,
+                    {batch_size, image_height, image_width, kChannels}});
+  auto x = module.add_instruction(
+    migraphx::operation("convert", "{target_type: %i}",
+                        migraphx_shape_float_type),
+    {image});
+
+  if (swap_channels_) {
+    const std::array<int32_t, kChannels> order{2, 1, 0};
+    auto indices = module.add_literal(
+      migraphx::shape{migraphx_shape_int32_type, {kChannels}},
+      reinterpret_cast<const char*>(order.data()));
+    x = module.add_instruction(migraphx::operation("gather", "{axis: 3}"),
+                               {x, indices});
+  }
+  if (image_height != height || image_width != width) {
+    x = module.add_instruction(
+      migraphx::operation("resize",
+                          "{sizes: [%zu, %zu, %zu, %zu], mode: \"linear\", "
+                          "coordinate_transformation_mode: \"half_pixel\"}",
+                          batch_size, height, width, size_t{kChannels}),
+      {x});
+  }
+
+  // (x * scale - mean) / std is folded into one multiply and add per channel
+  std::array<float, kChannels> factor;
+  std::array<float, kChannels> offset;
+  for (auto i = 0; i < kChannels; ++i) {
+    factor[i] = scale_ / std_[i];
+    offset[i] = -mean_[i] / std_[i];
+  }
+  const migraphx::shape channels{migraphx_shape_float_type, {kChannels}};
+  const auto broadcast = migraphx::operation(
+    "multibroadcast", "{out_lens: [%zu, %zu, %zu, %zu]}", batch_size, height,
+    width, size_t{kChannels});
+  auto factors = module.add_instruction(
+    broadcast, {module.add_literal(
+                 channels, reinterpret_cast<const char*>(factor.data()))});
+  auto offsets = module.add_instruction(
+    broadcast, {module.add_literal(
+                 channels, reinterpret_cast<const char*>(offset.data()))});
+  x = module.add_instruction(migraphx::operation("mul"), {x, factors});
+  x = module.add_instruction(migraphx::operation("add"), {x, offsets});
+
+  if (nchw) {
+    x = module.add_instruction(
+      migraphx::operation("transpose", "{permutation: [0, 3, 1, 2]}"), {x});
+  }
+  if (input_shape.type() != migraphx_shape_float_type) {
+    x = module.add_instruction(
+      migraphx::operation("convert", "{target_type: %i}", input_shape.type()),
+      {x});
+  }
+  module.add_return({x});
+
+  migraphx::compile_options options;
+  options.set_offload_copy(false);
+  try {
+    prog.compile(migraphx::target{"gpu"}, options);
+  } catch (const std::exception& e) {
+    throw external_error(std::string("Failed to compile preprocessing: ") +
+                         e.what());
+  }
+  return prog;
+}
+
+void* MIGraphXWorker::preprocess(const Program& program, void* images,
+                                 const MemoryPool* pool,
+                                 std::vector<BufferPtr>* staged,
+                                 hipStream_t stream) const {
+  const auto& pre = program.preprocess.value();
+  Tensor tensor{
+    "", {static_cast<int64_t>(pre.output_shape.bytes())}, DataType::Uint8};
+  auto& output =
+    staged->emplace_back(pool->get({MemoryAllocators::HipDevice}, tensor, 1));
+
+  migraphx::program_parameters params;
+  params.add(kImageParameter, migraphx::argument(pre.image_shape, images));
+  params.add(pre.output_name.c_str(),
+             migraphx::argument(pre.output_shape, output->data(0)));
+  if (stream == nullptr) {
+    pre.program.eval(params);
+    checkHip(hipDeviceSynchronize(), "preprocess the images");
+  } else {
+    pre.program.run_async(params, stream);
+  }
+  return output->data(0);
+}
+
+migraphx::program MIGraphXWorker::load(size_t batch_size) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  std::filesystem::path compiled_path(this->input_file_);
+  std::filesystem::path onnx_path(this->input_file_);
+
+  // Filename processing.
+  // Take the root of the given model file name and look for either an *.mxr
+  // or *.onnx extension. A *.mxr file next to the model should have its
+  // baked-in batch size tacked onto its name, eg. resnet50-v2-7_b64.mxr,
+  // followed by its precision if it's quantized, eg. resnet50-v2-7_b64_fp16.mxr
+  // Otherwise, the *.onnx file is compiled and the program is saved in the
+  // artifact cache for future use
+  compiled_path.replace_extension();
+  compiled_path += (std::string("_b") + std::to_string(batch_size));
+  if (precision_ != kNativePrecision) {
+    compiled_path += "_" + precision_;
+  }
+  compiled_path += ".mxr";
+  onnx_path.replace_extension(".onnx");
+
+  // Is there an mxr file next to the model or in the cache?
+  std::ifstream f(compiled_path.c_str());
+  if (!f.good()) {
+    compiled_path = this->getCachedPath(onnx_path, batch_size);
+    f = std::ifstream(compiled_path.c_str());
+    if (compiled_path.empty() || !f.good()) {
+      return compile(onnx_path, compiled_path, batch_size);
+    }
+  }
+
+  // Load the compiled MessagePack (*.mxr) file
+  AMDINFER_LOG_INFO(
+    logger, std::string("migraphx worker loading compiled model file ") +
+              compiled_path.c_str());
+  migraphx::file_options options;
+  options.set_file_format("msgpack");
+
+  // The hip library will throw a cryptic error if unable to connect with a
+  // GPU at this point.
+  try {
+    // the program does not need to be compiled.
+    return this->timeLoadPhase(LoadPhase::Compile, [&]() {
+      return migraphx::load(compiled_path.c_str(), options);
+    });
+  } catch (const std::exception& e) {
+    std::string emsg = e.what();
+    if (emsg.find("Failed to call function") != std::string::npos) {
+      emsg = emsg + ".  Server could not connect to a GPU.";
+    }
+    AMDINFER_LOG_ERROR(logger, emsg);
+    throw std::runtime_error(emsg);
+  }
+}
+
+std::filesystem::path MIGraphXWorker::getCachedPath(
+  const std::filesystem::path& onnx_path, size_t batch_size) const {
+  if (cache_dir_.empty() || !std::filesystem::exists(onnx_path)) {
+    return {};
+  }
+
+  util::ArtifactKey key{"migraphx"};
+  key.addFile(onnx_path);
+  if (precision_ == "int8") {
+    key.addFile(calibration_file_);
+  }
+  key.add("version", std::to_string(MIGRAPHX_VERSION_MAJOR) + "." +
+                       std::to_string(MIGRAPHX_VERSION_MINOR) + "." +
+                       std::to_string(MIGRAPHX_VERSION_PATCH));
+
+  // the loading thread is already on the worker's device
+  int device = 0;
+  checkHip(hipGetDevice(&device), "get the current device");
+  hipDeviceProp_t properties;
+  checkHip(hipGetDeviceProperties(&properties, device),
+           "get the device's properties");
+  key.add("target", properties.gcnArchName);
+
+  key.add("precision", precision_);
+  key.add("batch_size", std::to_string(batch_size));
+  key.add("offload_copy", "false");
+  return key.getPath(cache_dir_, ".mxr");
+}
+
+std::shared_ptr<MIGraphXWorker::SharedPrograms>
+MIGraphXWorker::getSharedPrograms(const std::vector<size_t>& batch_sizes) const {
+  // the programs are dropped when the last instance using them is destroyed
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<SharedPrograms>> registry;
+
+  int device = device_;
+  if (device < 0) {
+    checkHip(hipGetDevice(&device), "get the current device");
+  }
+  // the key covers everything the programs depend on
+  std::stringstream key;
+  key << device << '|' << input_file_.string() << '|' << precision_ << '|'
+      << calibration_file_.string() << '|';
+  for (auto size : batch_sizes) {
+    key << size << ',';
+  }
+  if (preprocess_) {
+    key << '|' << image_height_ << 'x' << image_width_ << '|' << swap_channels_
+        << '|' << scale_;
+    for (auto value : mean_) {
+      key << ',' << value;
+    }
+    for (auto value : std_) {
+      key << ',' << value;
+    }
+  }
+
+  const std::lock_guard lock{mutex};
+  for (auto it = registry.begin(); it != registry.end();) {
+    it = it->second.expired() ? registry.erase(it) : std::next(it);
+  }
+  auto& entry = registry[key.str()];
+  auto shared = entry.lock();
+  if (shared == nullptr) {
+    shared = std::make_shared<SharedPrograms>();
+    entry = shared;
+  }
+  return shared;
 }
 
 void MIGraphXWorker::doInit(ParameterMap* parameters) {
@@ -231,79 +1006,723 @@ void MIGraphXWorker::doInit(ParameterMap* parameters) {
   if (parameters->has("pad_batch")) {
     this->pad_batch_ = parameters->get<bool>("pad_batch");
   }
+  if (parameters->has("device")) {
+    device_ = parameters->get<int32_t>("device");
+    int count = 0;
+    checkHip(hipGetDeviceCount(&count), "count the devices");
+    if (device_ < 0 || device_ >= count) {
+      throw invalid_argument("Device " + std::to_string(device_) +
+                             " not found. There are " + std::to_string(count) +
+                             " devices");
+    }
+  }
+  precision_ = kNativePrecision;
+  if (parameters->has("precision")) {
+    precision_ = parameters->get<std::string>("precision");
+  }
+  if (precision_ != kNativePrecision && precision_ != "fp16" &&
+      precision_ != "int8") {
+    throw invalid_argument("Unknown precision " + precision_ +
+                           ". Use native, fp16 or int8");
+  }
+  if (parameters->has("calibration")) {
+    calibration_file_ = parameters->get<std::string>("calibration");
+  } else if (precision_ == "int8") {
+    throw invalid_argument("int8 precision needs a calibration file");
+  }
+  cache_dir_ = getArtifactCache(*parameters);
+
+  // By default, compile programs for the powers of two up to the batch size
+  // so small batches don't pay for evaluating the full batch.
+  std::vector<size_t> batch_sizes;
+  if (parameters->has("batch_sizes")) {
+    auto sizes = util::split(parameters->get<std::string>("batch_sizes"), ",");
+    for (const auto& size : sizes) {
+      batch_sizes.push_back(std::stoul(size));
+    }
+  } else {
+    for (size_t size = 1; size < batch_size_; size *= 2) {
+      batch_sizes.push_back(size);
+    }
+    batch_sizes.push_back(batch_size_);
+  }
+  if (batch_sizes.empty()) {
+    throw invalid_argument("batch_sizes must list at least one batch size");
+  }
+  std::sort(batch_sizes.begin(), batch_sizes.end(), std::greater<>());
+
+  if (parameters->has("preprocess")) {
+    preprocess_ = parameters->get<bool>("preprocess");
+  }
+  if (parameters->has("image_height")) {
+    image_height_ = parameters->get<int32_t>("image_height");
+  }
+  if (parameters->has("image_width")) {
+    image_width_ = parameters->get<int32_t>("image_width");
+  }
+  if (image_height_ < 0 || image_width_ < 0) {
+    throw invalid_argument("The image size can't be negative");
+  }
+  std::string color = "RGB";
+  if (parameters->has("color")) {
+    color = parameters->get<std::string>("color");
+  }
+  if (color != "RGB" && color != "BGR") {
+    throw invalid_argument("Unknown color " + color + ". Use RGB or BGR");
+  }
+  swap_channels_ = color == "BGR";
+  if (parameters->has("scale")) {
+    scale_ = static_cast<float>(parameters->get<double>("scale"));
+  }
+  if (parameters->has("mean")) {
+    mean_ = parseChannels(parameters->get<std::string>("mean"), "mean");
+  }
+  if (parameters->has("std")) {
+    std_ = parseChannels(parameters->get<std::string>("std"), "std");
+  }
+  for (auto value : std_) {
+    if (value == 0) {
+      throw invalid_argument("std can't be zero");
+    }
+  }
+
+  // compile for and allocate on the worker's device
+  const DeviceGuard guard{device_};
 
   // Only load/compile the model once during the lifetime of the worker.
   // This worker does not deallocate or release resources until it's destroyed;
-  // if you want to change them, request a new worker.
+  // if you want to change them, request a new worker. Other instances on the
+  // same device reuse the programs instead of loading their own copies.
   //
   //                        Load the model.
   //
-  std::filesystem::path filepath(this->input_file_);
-  std::filesystem::path compiled_path(this->input_file_);
-  std::filesystem::path onnx_path(this->input_file_);
+  shared_ = this->getSharedPrograms(batch_sizes);
+  const std::lock_guard lock{shared_->mutex};
+  if (!shared_->programs.empty()) {
+    AMDINFER_LOG_INFO(logger, "Sharing the programs of another instance");
+  }
+  for (auto requested_size : batch_sizes) {
+    if (!shared_->programs.empty()) {
+      break;
+    }
+    auto prog = this->load(requested_size);
+
+    // Fetch the expected dimensions of the input from the parsed model.
+    migraphx::program_parameter_shapes input_shapes =
+      prog.get_parameter_shapes();
+    const auto input_name = getInputNames(prog).front();
+    auto length = input_shapes[input_name.c_str()].lengths();
+    size_t compiled_size = length[0];
+    programs_.try_emplace(compiled_size,
+                          Program{std::move(prog), {}, {}, std::nullopt});
+
+    // models with a fixed batch size always compile to the same size
+    if (compiled_size != requested_size) {
+      AMDINFER_LOG_INFO(logger, "migraphx model has a fixed batch size of " +
+                                  std::to_string(compiled_size));
+      break;
+    }
+  }
+  if (shared_->programs.empty()) {
+    for (const auto& [size, program] : programs_) {
+      shared_->programs.try_emplace(size, program.program);
+    }
+  } else {
+    for (const auto& [size, prog] : shared_->programs) {
+      programs_.try_emplace(size, Program{prog, {}, {}, std::nullopt});
+    }
+  }
+  if (shared_->computed == nullptr) {
+    checkHip(hipEventCreateWithFlags(&shared_->computed, hipEventDisableTiming),
+             "create an event");
+  }
+  auto& prog = programs_.rbegin()->second.program;
+  this->batch_size_ = programs_.rbegin()->first;
+  input_names_ = getInputNames(prog);
+  output_names_ = getOutputNames(prog);
+  // models compiled by older versions of the server use offload copy
+  this->device_io_ = !output_names_.empty();
+
+  // look up the parameters by name once so batches can index them
+  for (auto& [_, program] : programs_) {
+    auto shapes = program.program.get_parameter_shapes();
+    for (const auto& name : input_names_) {
+      program.input_shapes.push_back(shapes[name.c_str()]);
+    }
+    for (const auto& name : output_names_) {
+      program.output_shapes.push_back(shapes[name.c_str()]);
+    }
+  }
 
-  // Filename processing.
-  // Take the root of the given model file name and look for either an *.mxr
-  // or *.onnx extension (after loading and compiling an *.onnx file, this
-  // worker saves it as an *.mxr file for future use)
-  // A *.mxr file should also have its baked-in batch size
-  // tacked onto its name, eg. resnet50-v2-7_b64.mxr
-  compiled_path.replace_extension();
-  compiled_path += (std::string("_b") + std::to_string(batch_size_) + ".mxr");
-  onnx_path.replace_extension(".onnx");
+  if (preprocess_) {
+    // the preprocessed input has to stay on the device until it's evaluated
+    if (!device_io_) {
+      throw invalid_argument(
+        "preprocess needs a model compiled without offload copy. Delete the "
+        "saved MXR files to recompile it");
+    }
+    for (auto& [size, program] : programs_) {
+      auto shared = shared_->preprocess.find(size);
+      if (shared == shared_->preprocess.end()) {
+        shared = shared_->preprocess
+                   .try_emplace(size, this->compilePreprocess(
+                                        program.input_shapes.front()))
+                   .first;
+      }
+      auto prog = shared->second;
+      auto shapes = prog.get_parameter_shapes();
+      auto output_name = getOutputNames(prog).front();
+      auto image_shape = shapes[kImageParameter];
+      auto output_shape = shapes[output_name.c_str()];
+      program.preprocess = Preprocess{std::move(prog), image_shape,
+                                      std::move(output_name), output_shape};
+    }
+  }
 
-  // Is there an mxr file?
-  std::ifstream f(compiled_path.c_str());
-  if (f.good()) {
-    // Load the compiled MessagePack (*.mxr) file
-    AMDINFER_LOG_INFO(
-      logger, std::string("migraphx worker loading compiled model file ") +
-                compiled_path.c_str());
-    migraphx::file_options options;
-    options.set_file_format("msgpack");
+  const auto& input_shapes = programs_.rbegin()->second.input_shapes;
+  for (auto i = 0U; i < input_names_.size(); ++i) {
+    // the first input is published as the images that are preprocessed
+    const auto& preprocessing = programs_.rbegin()->second.preprocess;
+    const auto& ashape = i == 0 && preprocessing.has_value()
+                           ? preprocessing->image_shape
+                           : input_shapes[i];
+    const auto lengths = ashape.lengths();
+    // size of a single request input (divide by batch size)
+    input_sizes_.push_back(ashape.bytes() / lengths.front());
+    // publish the shape of a single request's input so requests are bound to
+    // the model's inputs when they arrive
+    this->metadata_.addInputTensor(
+      Tensor{input_names_[i], {lengths.begin() + 1, lengths.end()},
+             toDataType(ashape.type())});
+  }
+
+  auto output_shapes = prog.get_output_shapes();
+  for (auto i = 0U; i < output_shapes.size(); ++i) {
+    const auto& shape = output_shapes[i];
+    const auto lengths = shape.lengths();
+    output_sizes_.push_back(shape.bytes() / lengths.front());
+    // compiled programs don't keep the names of their outputs
+    const auto& name =
+      output_tensor_names_.emplace_back("output_" + std::to_string(i));
+    this->metadata_.addOutputTensor(Tensor{
+      name, {lengths.begin() + 1, lengths.end()}, toDataType(shape.type())});
+  }
+}
+
+void MIGraphXWorker::selectBatchOutputs(
+  const Batch& batch, std::vector<std::vector<size_t>>* selected,
+  std::vector<int>* slots) const {
+  selected->clear();
+  slots->assign(output_tensor_names_.size(), -1);
+  for (const auto& request : batch.getRequests()) {
+    const auto& outputs =
+      selected->emplace_back(selectOutputs(*request, output_tensor_names_));
+    for (auto i : outputs) {
+      (*slots)[i] = 0;
+    }
+  }
+  int slot = 0;
+  for (auto& index : *slots) {
+    if (index == 0) {
+      index = slot++;
+    }
+  }
+}
+
+void MIGraphXWorker::doAcquire(ParameterMap* parameters) {
+  const DeviceGuard guard{device_};
+  int32_t streams = 0;
+  if (parameters->has("streams")) {
+    streams = parameters->get<int32_t>("streams");
+  }
+  if (streams < 0) {
+    throw invalid_argument("The number of streams can't be negative");
+  }
+  hip_graphs_ =
+    parameters->has("hip_graphs") && parameters->get<bool>("hip_graphs");
+  // graphs are replayed on the streams
+  if (hip_graphs_) {
+    streams = std::max(streams, 1);
+  }
+  if (parameters->has("multiplex")) {
+    streams = 0;
+  }
+  // programs using offload copy do their copies synchronously in eval
+  if (streams > 0 && !device_io_) {
+    AMDINFER_LOG_WARN(this->getLogger(),
+                      "MIGraphX model uses offload copy so it's evaluated "
+                      "synchronously. Recompile it to use streams");
+    streams = 0;
+  }
+  if (streams == 0) {
+    hip_graphs_ = false;
+  }
+  pinned_outputs_ = parameters->has("pinned_outputs") &&
+                    parameters->get<bool>("pinned_outputs");
+  if (pinned_outputs_ && !device_io_) {
+    AMDINFER_LOG_WARN(this->getLogger(),
+                      "MIGraphX model uses offload copy so its outputs can't "
+                      "be pinned. Recompile it to use pinned_outputs");
+    pinned_outputs_ = false;
+  }
+
+  this->timeLoadPhase(LoadPhase::CreateRunner, [&]() {
+    for (auto i = 0; i < streams; ++i) {
+      auto job = std::make_unique<Job>();
+      checkHip(hipStreamCreateWithFlags(&job->stream, hipStreamNonBlocking),
+               "create a stream");
+      checkHip(hipEventCreateWithFlags(&job->computed, hipEventDisableTiming),
+               "create an event");
+      jobs_.push_back(std::move(job));
+    }
+  });
+}
+
+void MIGraphXWorker::run(BatchPtrQueue* input_queue, const MemoryPool* pool) {
+  this->status_ = WorkerStatus::Run;
+  const auto& name = this->getName();
+  AMDINFER_IF_LOGGING(const auto logger = this->getLogger());
+  util::setThreadName(name);
+  const DeviceGuard guard{device_};
+
+  // each job holds its batch until it completes and jobs are recycled
+  // between the threads so at most one batch is in flight per stream
+  BlockingQueue<Job*> free_jobs;
+  BlockingQueue<Job*> in_flight;
+  BlockingQueue<BatchPtr> batches;
+  for (const auto& job : jobs_) {
+    free_jobs.enqueue(job.get());
+  }
+  std::thread completer;
+  if (!jobs_.empty()) {
+    completer = std::thread{&MIGraphXWorker::completeJobs, this, &in_flight,
+                            &free_jobs, &batches};
+  }
+
+  while (true) {
+    BatchPtr batch;
+    input_queue->wait_dequeue(batch);
+    if (batch == nullptr) {
+      break;
+    }
+    if (this->dropCancelled(*batch)) {
+      continue;
+    }
+
+#ifdef AMDINFER_ENABLE_TRACING
+    batch->startSpan(name);
+#endif
+
+    AMDINFER_LOG_INFO(logger, "Got request in " + name);
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordDequeue(batch.get());
+#endif
+
+    if (jobs_.empty()) {
+      auto turn = this->takeDeviceTurn();
+      batch->markStage(ServerTiming::Started);
+      auto new_batch = this->doRun(batch.get(), pool);
+      turn.reset();
+      this->forward(batch.get(), std::move(new_batch));
+      continue;
+    }
+
+    Job* job = nullptr;
+    free_jobs.wait_dequeue(job);
+    // the clients may have given up while the batch waited for a free job
+    if (this->dropCancelled(*batch)) {
+      free_jobs.enqueue(job);
+      continue;
+    }
+    // the completer ends the turn once the batch is done on the GPU
+    job->turn = this->takeDeviceTurn();
+    batch->markStage(ServerTiming::Started);
+    if (this->submit(batch.get(), pool, job)) {
+      // the completer takes the batches in the same order as the jobs
+      batches.enqueue(std::move(batch));
+      in_flight.enqueue(job);
+    } else {
+      job->turn.reset();
+      batch->freeInputBuffers();
+      free_jobs.enqueue(job);
+    }
+  }
+
+  if (completer.joinable()) {
+    // the completer finishes the jobs in flight before it sees the null job
+    in_flight.enqueue(nullptr);
+    completer.join();
+  }
+
+  AMDINFER_LOG_INFO(logger, name + " ending");
+
+  status_ = WorkerStatus::Inactive;
+}
+
+void MIGraphXWorker::runBatch(BatchPtr batch, const MemoryPool* pool) {
+  // the multiplexer's thread runs other models too, maybe on other devices
+  const DeviceGuard guard{device_};
+  Worker::runBatch(std::move(batch), pool);
+}
+
+void MIGraphXWorker::completeJobs(BlockingQueue<Job*>* in_flight,
+                                  BlockingQueue<Job*>* free_jobs,
+                                  BlockingQueue<BatchPtr>* batches) {
+  util::setThreadName(this->getName() + "-wait");
+  const DeviceGuard guard{device_};
+  while (true) {
+    Job* job = nullptr;
+    in_flight->wait_dequeue(job);
+    if (job == nullptr) {
+      break;
+    }
+    BatchPtr batch;
+    batches->wait_dequeue(batch);
+
+    auto new_batch = this->complete(job);
+    job->turn.reset();
+    this->forward(batch.get(), std::move(new_batch));
+    free_jobs->enqueue(job);
+  }
+}
+
+void MIGraphXWorker::forward(Batch* batch, BatchPtr new_batch) {
+#ifdef AMDINFER_ENABLE_METRICS
+  this->recordCompute(*batch, new_batch.get());
+#endif
+  if (next_ != nullptr && new_batch != nullptr) {
+    [[maybe_unused]] auto batch_size = batch->size();
+    assert(new_batch->size() == batch_size);
+#ifdef AMDINFER_ENABLE_TRACING
+    batch->endSpan();
+    for (auto i = 0U; i < batch_size; ++i) {
+      new_batch->addTrace(std::move(batch->getTrace(i)));
+    }
+#endif
+    next_->enqueue(std::move(new_batch));
+  }
+
+  batch->freeInputBuffers();
+}
+
+void MIGraphXWorker::capture(Program* program, const MemoryPool* pool,
+                             hipStream_t stream) {
+  Graph graph;
+  migraphx::program_parameters params;
+  auto bind = [&](const std::string& name, const migraphx::shape& shape,
+                  std::vector<BufferPtr>* buffers) {
+    Tensor tensor{"", {static_cast<int64_t>(shape.bytes())}, DataType::Uint8};
+    auto& buffer = buffers->emplace_back(
+      pool->get({MemoryAllocators::HipDevice}, tensor, 1));
+    params.add(name.c_str(), migraphx::argument(shape, buffer->data(0)));
+  };
+  for (auto k = 0U; k < input_names_.size(); ++k) {
+    bind(input_names_[k], program->input_shapes.at(k), &graph.inputs);
+  }
+  for (auto i = 0U; i < output_names_.size(); ++i) {
+    bind(output_names_[i], program->output_shapes.at(i), &graph.outputs);
+  }
 
-    // The hip library will throw a cryptic error if unable to connect with a
-    // GPU at this point.
+  hipGraph_t captured = nullptr;
+  try {
+    checkHip(hipStreamBeginCapture(stream, hipStreamCaptureModeThreadLocal),
+             "begin capturing the program");
     try {
-      this->prog_ = migraphx::load(compiled_path.c_str(), options);
-    } catch (const std::exception& e) {
-      std::string emsg = e.what();
-      if (emsg.find("Failed to call function") != std::string::npos) {
-        emsg = emsg + ".  Server could not connect to a GPU.";
-      }
-      AMDINFER_LOG_ERROR(logger, emsg);
-      throw std::runtime_error(emsg);
-      // prog_ does not need to be compiled.
+      program->program.run_async(params, stream);
+    } catch (const std::exception&) {
+      // end the capture so the stream can be used again
+      hipStreamEndCapture(stream, &captured);
+      throw;
     }
-  } else {
-    compile(onnx_path, compiled_path);
+    checkHip(hipStreamEndCapture(stream, &captured), "capture the program");
+    checkHip(hipGraphInstantiate(&graph.exec, captured, nullptr, nullptr, 0),
+             "instantiate the program's graph");
+    hipGraphDestroy(captured);
+    program->graph = std::move(graph);
+  } catch (const std::exception& e) {
+    if (captured != nullptr) {
+      hipGraphDestroy(captured);
+    }
+    for (const auto& buffer : graph.inputs) {
+      buffer->free();
+    }
+    for (const auto& buffer : graph.outputs) {
+      buffer->free();
+    }
+    AMDINFER_LOG_WARN(this->getLogger(),
+                      std::string{"MIGraphX program can't be captured into a "
+                                  "HIP graph so it's launched directly: "} +
+                        e.what());
+    program->capture_failed = true;
   }
-  //
-  // Fetch the expected dimensions of the input from the parsed model.
-  migraphx::program_parameter_shapes input_shapes =
-    this->prog_.get_parameter_shapes();
-  const auto* input_name = input_shapes.names()[0];
-  auto sh = input_shapes[input_name];
-  auto length = sh.lengths();
-  migraphx::api::shapes output_shapes = prog_.get_output_shapes();
-  this->batch_size_ = length[0];
-
-  for (const auto* aname : input_shapes.names()) {
-    migraphx::shape ashape = input_shapes[aname];
-    auto llen = ashape.lengths();
-    // size of the buffer needed for this input
-    auto asize = ashape.bytes();
-    // size of a single request input (divide by batch size)
-    input_sizes_[aname] = asize / *(ashape.lengths().begin());
+}
+
+void MIGraphXWorker::launch(const Program& program,
+                            const migraphx::program_parameters& params,
+                            const std::vector<void*>& inputs,
+                            const std::vector<void*>& outputs,
+                            hipStream_t stream) const {
+  if (!program.graph.has_value()) {
+    program.program.run_async(params, stream);
+    return;
+  }
+  const auto& graph = program.graph.value();
+  for (auto k = 0U; k < inputs.size(); ++k) {
+    copyMemoryAsync(graph.inputs[k]->data(0), inputs[k],
+                    program.input_shapes[k].bytes(), stream);
+  }
+  checkHip(hipGraphLaunch(graph.exec, stream), "replay the program's graph");
+  for (auto i = 0U; i < outputs.size(); ++i) {
+    copyMemoryAsync(outputs[i], graph.outputs[i]->data(0),
+                    program.output_shapes[i].bytes(), stream);
+  }
+}
+
+std::map<size_t, MIGraphXWorker::Program>::iterator MIGraphXWorker::getProgram(
+  size_t batch_size) {
+  auto program = programs_.lower_bound(batch_size);
+  if (program == programs_.end()) {
+    program = std::prev(programs_.end());
+  }
+  return program;
+}
+
+#ifdef AMDINFER_ENABLE_METRICS
+void MIGraphXWorker::recordPadding(const Batch& batch,
+                                   size_t program_batch_size) const {
+  if (metrics_ != nullptr && program_batch_size > batch.size()) {
+    metrics_->observeHistogram(
+      MetricHistogramIDs::BatchPadding,
+      static_cast<double>(program_batch_size - batch.size()));
+  }
+}
+#endif
+
+void* MIGraphXWorker::bindOutput(size_t index, const migraphx::shape& shape,
+                                 bool write_to_host, const MemoryPool* pool,
+                                 const std::vector<int>& slots,
+                                 std::vector<BufferPtr>* buffers) const {
+  Tensor tensor{"", {static_cast<int64_t>(shape.bytes())}, DataType::Uint8};
+  // the output is sized for the whole program batch so its rows are the
+  // requests' outputs that are passed on as slices of it
+  if (write_to_host && slots.at(index) >= 0) {
+    auto& output = buffers->emplace_back(
+      pool->get({MemoryAllocators::CpuPinned}, tensor, 1));
+    return getDevicePointer(output->data(0));
+  }
+  auto& output =
+    buffers->emplace_back(pool->get({MemoryAllocators::HipDevice}, tensor, 1));
+  return output->data(0);
+}
+
+bool MIGraphXWorker::submit(Batch* batch, const MemoryPool* pool, Job* job) {
+  const auto program = this->getProgram(batch->size());
+  const auto program_batch_size = program->first;
+#ifdef AMDINFER_ENABLE_METRICS
+  this->recordPadding(*batch, program_batch_size);
+#endif
+  auto& prog = program->second;
+  job->batch = batch;
+  job->program = &prog;
+  auto* stream = job->stream;
+  // the programs may be shared with other instances so work is queued on them
+  // by one thread at a time
+  std::unique_lock lock{shared_->mutex, std::defer_lock};
+
+  try {
+    // the batch's inputs are contiguous so the first request's input k is
+    // the address of input k for the whole batch
+    const auto& inputs0 = batch->getRequest(0)->getInputs();
+    const auto& buffers = batch->getInputBuffers();
+    migraphx::program_parameters params;
+    std::vector<void*> inputs;
+    std::vector<void*> outputs;
+    for (auto k = 0U; k < inputs0.size(); ++k) {
+      const auto& aninput = inputs0[k];
+      const auto& modelshape = prog.input_shapes.at(k);
+      const bool preprocessed = k == 0 && prog.preprocess.has_value();
+      const auto& inputshape =
+        preprocessed ? prog.preprocess->image_shape : modelshape;
+      if (toDataType(inputshape.type()) != aninput.getDatatype()) {
+        throw invalid_argument(
+          "Migraph worker model and input data types don't match");
+      }
+
+      const auto input_size = input_sizes_[k];
+      auto* a_data = aninput.getData();
+      const bool on_device =
+        k < buffers.size() &&
+        buffers[k]->getAllocator() == MemoryAllocators::HipDevice;
+      // copy host inputs and partial batches to device memory that fits the
+      // whole program batch
+      if (!on_device || batch->size() < program_batch_size) {
+        Tensor tensor{"", {static_cast<int64_t>(input_size)}, DataType::Uint8};
+        auto& staged = job->staged_buffers.emplace_back(pool->get(
+          {MemoryAllocators::HipDevice}, tensor, program_batch_size));
+        copyMemoryAsync(staged->data(0), a_data, input_size * batch->size(),
+                        stream);
+        a_data = staged->data(0);
+      }
+      if (pad_batch_) {
+        auto* data = static_cast<char*>(a_data);
+        for (auto i = batch->size(); i < program_batch_size; ++i) {
+          copyMemoryAsync(data + (i * input_size), data, input_size, stream);
+        }
+      }
+      if (preprocessed) {
+        // like the programs, the preprocessing's scratch memory is shared
+        // between the streams
+        lock.lock();
+        checkHip(hipStreamWaitEvent(stream, shared_->computed, 0),
+                 "wait for the last batch");
+        a_data =
+          this->preprocess(prog, a_data, pool, &job->staged_buffers, stream);
+      }
+      params.add(input_names_.at(k).c_str(),
+                 migraphx::argument(modelshape, a_data));
+      inputs.push_back(a_data);
+    }
+
+    this->selectBatchOutputs(*batch, &job->selected, &job->slots);
+    // if the next stage is also on the GPU, pass it the outputs in place.
+    // Otherwise, they're written to the host
+    const bool keep_on_device =
+      device_ < 0 && !next_allocators_.empty() &&
+      next_allocators_.front() == MemoryAllocators::HipDevice;
+    const bool write_to_host = pinned_outputs_ && !keep_on_device;
+
+    for (auto i = 0U; i < output_names_.size(); ++i) {
+      const auto& shape = prog.output_shapes[i];
+      outputs.push_back(this->bindOutput(i, shape, write_to_host, pool,
+                                         job->slots, &job->device_outputs));
+      params.add(output_names_[i].c_str(),
+                 migraphx::argument(shape, outputs.back()));
+    }
+
+    if (!lock.owns_lock()) {
+      lock.lock();
+    }
+    // the capture can't wait for other streams so it's made first
+    if (hip_graphs_ && !prog.graph.has_value() && !prog.capture_failed) {
+      this->capture(&prog, pool, stream);
+    }
+    checkHip(hipStreamWaitEvent(stream, shared_->computed, 0),
+             "wait for the last batch");
+    // with a graph, the event also covers the copies out of its buffers so
+    // the next batch doesn't overwrite them early
+    this->launch(prog, params, inputs, outputs, stream);
+    checkHip(hipEventRecord(job->computed, stream), "record an event");
+    checkHip(hipEventRecord(shared_->computed, stream), "record an event");
+    lock.unlock();
+
+    // queue the copies of the outputs that weren't written in place to the
+    // host after the compute
+    const auto batch_size = batch->size();
+    for (auto i = 0U; i < output_names_.size(); ++i) {
+      // unrequested outputs stay on the device and aren't copied
+      if (job->slots[i] < 0) {
+        continue;
+      }
+      if (keep_on_device || write_to_host) {
+        job->next_buffers.push_back(std::move(job->device_outputs[i]));
+        continue;
+      }
+      const auto size = output_sizes_[i];
+      Tensor tensor{"", {static_cast<int64_t>(size)}, DataType::Uint8};
+      auto& buffer = job->next_buffers.emplace_back(
+        pool->get(next_allocators_, tensor, batch_size));
+      copyMemoryAsync(buffer->data(0), job->device_outputs[i]->data(0),
+                      size * batch_size, stream);
+    }
+  } catch (const std::exception& e) {
+    AMDINFER_LOG_ERROR(this->getLogger(), e.what());
+    // let queued work finish before the memory it uses is released
+    hipStreamSynchronize(stream);
+    for (const auto& buffers :
+         {&job->staged_buffers, &job->device_outputs, &job->next_buffers}) {
+      for (const auto& buffer : *buffers) {
+        if (buffer != nullptr) {
+          buffer->free();
+        }
+      }
+      buffers->clear();
+    }
+    for (const auto& req_e : batch->getRequests()) {
+      req_e->runCallbackError(std::string("Migraphx inference error: ") +
+                              e.what());
+    }
+    return false;
   }
+  return true;
 }
 
-void MIGraphXWorker::doAcquire(ParameterMap* parameters) { (void)parameters; }
+BatchPtr MIGraphXWorker::complete(Job* job) {
+  auto* batch = job->batch;
+  BatchPtr new_batch;
+  try {
+    checkHip(hipStreamSynchronize(job->stream), "run the batch");
+
+    new_batch = batch->propagate();
+    const auto batch_size = batch->size();
+    const auto& output_shapes = job->program->output_shapes;
+    // the outputs have the same shape in each request
+    std::vector<Shape> shapes;
+    std::vector<DataType> datatypes;
+    shapes.reserve(output_shapes.size());
+    datatypes.reserve(output_shapes.size());
+    for (const auto& output_shape : output_shapes) {
+      const auto lengths = output_shape.lengths();
+      // erase the leading batch size to get the tensor size
+      shapes.emplace_back(lengths.begin() + 1, lengths.end());
+      datatypes.push_back(toDataType(output_shape.type()));
+    }
+    for (auto j = 0U; j < batch_size; ++j) {
+      auto new_request = batch->getRequest(j)->propagate();
+      for (auto i : job->selected.at(j)) {
+        auto* data_ptr =
+          job->next_buffers.at(job->slots[i])->data(output_sizes_[i] * j);
+        new_request->addInputTensor(InferenceRequestInput{
+          data_ptr, shapes[i], datatypes[i], output_tensor_names_[i]});
+      }
+      new_batch->addRequest(new_request);
+      new_batch->setModel(j, "migraphx");
+    }
+  } catch (const std::exception& e) {
+    AMDINFER_LOG_ERROR(this->getLogger(), e.what());
+    for (const auto& req_e : batch->getRequests()) {
+      req_e->runCallbackError(std::string("Migraphx inference error: ") +
+                              e.what());
+    }
+    new_batch = nullptr;
+  }
+
+  for (const auto& buffers : {&job->staged_buffers, &job->device_outputs}) {
+    for (const auto& buffer : *buffers) {
+      if (buffer != nullptr) {
+        buffer->free();
+      }
+    }
+    buffers->clear();
+  }
+  if (new_batch == nullptr) {
+    for (const auto& buffer : job->next_buffers) {
+      buffer->free();
+    }
+    job->next_buffers.clear();
+  } else {
+    new_batch->setBuffers(std::move(job->next_buffers), {});
+    job->next_buffers.clear();
+  }
+  job->batch = nullptr;
+  return new_batch;
+}
 
 BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
 #ifdef AMDINFER_ENABLE_LOGGING
   const auto& logger = this->getLogger();
 #endif
+  // warm-up batches are run on the loading thread
+  const DeviceGuard guard{device_};
 
   // stringstream used for formatting logger messages
   std::string msg;
@@ -316,8 +1735,8 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
   // client and continue waiting for requests.
   //
 
-  util::Timer timer;
-  timer.add("batch_start");
+  util::Timestamps<RunEvent> timer;
+  timer.mark(RunEvent::BatchStart);
 
   // The MIGraphX operation: run the migraphx eval() method.
   // If migraphx exceptions happen, they will be handled
@@ -327,32 +1746,46 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
   // data for the entire batch. The different input tensors are not required
   // to be contiguous with each other.
   const auto& req0 = batch->getRequest(0);
-  auto inputs0 = req0->getInputs();  // const std::vector<InferenceRequestInput>
+  const auto& inputs0 = req0->getInputs();
 
   BatchPtr new_batch;
   std::vector<amdinfer::BufferPtr> input_buffers;
+  // device memory used only while evaluating this batch
+  std::vector<amdinfer::BufferPtr> staged_buffers;
+  std::vector<amdinfer::BufferPtr> device_outputs;
+
+  // use the smallest program that fits the whole batch
+  auto program = this->getProgram(batch->size());
+  const auto program_batch_size = program->first;
+#ifdef AMDINFER_ENABLE_METRICS
+  this->recordPadding(*batch, program_batch_size);
+#endif
+  auto& prog = program->second.program;
+  const auto& input_shapes = program->second.input_shapes;
+  // the programs may be shared with other instances so they're run by one
+  // thread at a time
+  std::unique_lock lock{shared_->mutex, std::defer_lock};
 
   try {
+    const auto inputs_start = profileNow();
     migraphx::program_parameters params;
 
     // populate the migraphx parameters with shape read from the onnx
-    // model.
-    auto param_shapes = prog_.get_parameter_shapes();
-
-    for (const auto& aninput : inputs0) {  // InferenceRequestInput
-      auto aname = aninput.getName();
-
-      // Look up the shape by name in the model, but if there's only 1 input
-      // then the name in the request isn't required to match.
-      if (inputs0.size() == 1) {
-        aname = param_shapes.names().front();
-      }
-      migraphx::shape modelshape = param_shapes[aname.c_str()];
-
-      if (toDataType(modelshape.type()) != aninput.getDatatype()) {
+    // model. Requests are bound to the model's inputs when they arrive so
+    // the request's input k is the model's input k.
+    for (auto k = 0U; k < inputs0.size(); ++k) {
+      const auto& aninput = inputs0[k];  // InferenceRequestInput
+      const auto& aname = input_names_.at(k);
+      const auto& modelshape = input_shapes.at(k);
+      const auto& preprocessing = program->second.preprocess;
+      const bool preprocessed = k == 0 && preprocessing.has_value();
+      const auto& inputshape =
+        preprocessed ? preprocessing->image_shape : modelshape;
+
+      if (toDataType(inputshape.type()) != aninput.getDatatype()) {
         smsg.str("");
         smsg << "Migraph worker model and input data types don't match:   "
-             << toDataType(modelshape.type()) << " vs "
+             << toDataType(inputshape.type()) << " vs "
              << aninput.getDatatype();
         throw(invalid_argument(smsg.str()));
       }
@@ -380,47 +1813,97 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
       // clang-format on
 
       auto* a_data = aninput.getData();  //  void *
-      params.add(aname.c_str(), migraphx::argument(modelshape, a_data));
-    }
-    // If there were fewer requests in the batch than the stated batch size,
-    // pad the various input tensors with copies of the 0'th request's data.
-
-    if (pad_batch_) {
-      // for each named input channel
-      for (const auto& aninput : inputs0) {
-        auto aname = aninput.getName();
-        // Look up the shape by name in the model, but if there's only 1 input
-        // then the name in the request isn't required to match.
-        if (inputs0.size() == 1) {
-          aname = param_shapes.names().front();
+      if (device_io_) {
+        const auto& buffers = batch->getInputBuffers();
+        const bool on_device =
+          k < buffers.size() &&
+          buffers[k]->getAllocator() == MemoryAllocators::HipDevice;
+        // copy host inputs and partial batches to device memory that fits
+        // the whole program batch
+        if (!on_device || batch->size() < program_batch_size) {
+          const auto input_size = input_sizes_[k];
+          Tensor tensor{
+            "", {static_cast<int64_t>(input_size)}, DataType::Uint8};
+          auto& staged = staged_buffers.emplace_back(pool->get(
+            {MemoryAllocators::HipDevice}, tensor, program_batch_size));
+          staged->write(a_data, 0, input_size * batch->size());
+          a_data = staged->data(0);
         }
-        auto* a_data = static_cast<char*>(aninput.getData());
+      }
+      // If there were fewer requests in the batch than the stated batch size,
+      // pad the input tensor with copies of the 0'th request's data.
+      if (pad_batch_) {
+        auto* data = static_cast<char*>(a_data);
+        const auto input_size = input_sizes_[k];
         // For each empty slot in buffer, i.e. from end of real requests up to
         // batch size
         for (size_t req_idx = batch->getRequests().size();
-             req_idx < batch_size_; req_idx++) {
-          memcpy(a_data + req_idx * input_sizes_[aname], a_data,
-                 input_sizes_[aname]);
+             req_idx < program_batch_size; req_idx++) {
+          auto* dst = data + req_idx * input_size;
+          if (device_io_) {
+            copyMemory(dst, data, input_size);
+          } else {
+            memcpy(dst, data, input_size);
+          }
         }
       }
+      if (preprocessed) {
+        lock.lock();
+        checkHip(hipEventSynchronize(shared_->computed),
+                 "wait for the last batch");
+        a_data = this->preprocess(program->second, a_data, pool,
+                                  &staged_buffers, nullptr);
+      }
+      params.add(aname.c_str(), migraphx::argument(modelshape, a_data));
+    }
+    // unrequested outputs aren't allocated or copied
+    std::vector<std::vector<size_t>> selected;
+    std::vector<int> slots;
+    this->selectBatchOutputs(*batch, &selected, &slots);
+    // if the next stage is also on the GPU, pass it the outputs in place.
+    // Otherwise, they're written or copied to the host
+    const bool keep_on_device =
+      device_io_ && device_ < 0 && !next_allocators_.empty() &&
+      next_allocators_.front() == MemoryAllocators::HipDevice;
+    const bool write_to_host = pinned_outputs_ && !keep_on_device;
+    if (device_io_) {
+      for (auto i = 0U; i < output_names_.size(); ++i) {
+        const auto& shape = program->second.output_shapes[i];
+        auto* output = this->bindOutput(i, shape, write_to_host, pool, slots,
+                                        &device_outputs);
+        params.add(output_names_[i].c_str(), migraphx::argument(shape, output));
+      }
     }
-
     //
     // Run the inference
     //
 
     AMDINFER_LOG_INFO(logger, "Beginning migraphx eval");
-    timer.add("eval_start");
-    migraphx::api::arguments migraphx_output = this->prog_.eval(params);
-    timer.add("eval_end");
-    auto eval_duration_us = timer.count<std::micro>("eval_start", "eval_end");
+    timer.mark(RunEvent::EvalStart);
+    const auto eval_start = profileNow();
+    if (!lock.owns_lock()) {
+      lock.lock();
+      checkHip(hipEventSynchronize(shared_->computed),
+               "wait for the last batch");
+    }
+    migraphx::api::arguments migraphx_output = prog.eval(params);
+    if (device_io_) {
+      hipDeviceSynchronize();
+    }
+    const auto eval_end = profileNow();
+    timer.mark(RunEvent::EvalEnd);
+    profileEvent("inputs", "migraphx", inputs_start, eval_start);
+    profileEvent("eval", "migraphx", eval_start, eval_end);
+    auto eval_duration_us =
+      timer.count<std::micro>(RunEvent::EvalStart, RunEvent::EvalEnd);
     [[maybe_unused]] auto eval_duration_s = eval_duration_us / std::mega::num;
     AMDINFER_LOG_INFO(
       logger,
       std::string("Finished migraphx eval; batch size: ") +
-        std::to_string(batch_size_) +
+        std::to_string(program_batch_size) +
         "  elapsed time: " + std::to_string(eval_duration_us) +
-        " us.  Images/sec: " + std::to_string(batch_size_ / (eval_duration_s)));
+        " us.  Images/sec: " +
+        std::to_string(program_batch_size / (eval_duration_s)));
 
     //
     //           Fetch the results and populate response to each request in
@@ -432,36 +1915,46 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
 
     // Fetch the vector shape, data, etc. for output from the
     // parsed/compiled model
-    migraphx::api::shapes output_shapes = prog_.get_output_shapes();
+    migraphx::api::shapes output_shapes = prog.get_output_shapes();
     std::vector<DataType> datatypes;
     datatypes.reserve(output_shapes.size());
+    // the outputs have the same shape in each request
+    std::vector<Shape> shapes;
+    shapes.reserve(output_shapes.size());
 
     size_t num_output_tensors = migraphx_output.size();
     assert(output_shapes.size() == num_output_tensors);
     input_buffers.reserve(num_output_tensors);
     for (auto i = 0U; i < num_output_tensors; ++i) {
+      datatypes.push_back(toDataType(output_shapes[i].type()));
       auto migraphx_shape = migraphx_output[i].get_shape().lengths();
       // erase the leading batch size to get the tensor size
-      std::vector<int64_t> shape{migraphx_shape.begin() + 1,
-                                 migraphx_shape.end()};
-
-      datatypes.push_back(toDataType(output_shapes[i].type()));
+      const auto& shape =
+        shapes.emplace_back(migraphx_shape.begin() + 1, migraphx_shape.end());
+      if (slots[i] < 0) {
+        continue;
+      }
 
+      if (keep_on_device || write_to_host) {
+        input_buffers.emplace_back(std::move(device_outputs.at(i)));
+        continue;
+      }
       Tensor tensor{"", shape, datatypes.back()};
       input_buffers.emplace_back(
         pool->get(next_allocators_, tensor, batch_size));
+      if (device_io_) {
+        auto size = util::containerProduct(shape) * datatypes.back().size();
+        copyMemory(input_buffers.back()->data(0), migraphx_output[i].data(),
+                   size * batch_size);
+      }
     }
 
     for (unsigned int j = 0; j < batch_size; j++) {
       const auto& req = batch->getRequest(j);
       auto new_request = req->propagate();
 
-      for (auto i = 0U; i < num_output_tensors; ++i) {
-        auto migraphx_shape = migraphx_output[i].get_shape().lengths();
-        // erase the leading batch size to get the tensor size
-        std::vector<int64_t> shape{migraphx_shape.begin() + 1,
-                                   migraphx_shape.end()};
-
+      for (auto i : selected.at(j)) {
+        const auto& shape = shapes.at(i);
         const auto& datatype = datatypes.at(i);
 
         auto size = util::containerProduct(shape) * datatype.size();
@@ -469,11 +1962,13 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
         // [10], which becomes zero after erasing the batch size, resulting in
         // a tensor of size zero. What does this mean?
         // assert(size > 0);
-        auto* data_ptr = input_buffers.at(i)->data(size * j);
-        const char* results = migraphx_output[i].data() + (size * j);
-
-        std::memcpy(data_ptr, results, size);
-        InferenceRequestInput input{data_ptr, shape, datatype, ""};
+        auto* data_ptr = input_buffers.at(slots[i])->data(size * j);
+        if (!device_io_) {
+          const char* results = migraphx_output[i].data() + (size * j);
+          std::memcpy(data_ptr, results, size);
+        }
+        InferenceRequestInput input{data_ptr, shape, datatype,
+                                    output_tensor_names_[i]};
 
         new_request->addInputTensor(std::move(input));
       }
@@ -483,6 +1978,7 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
       new_batch->setModel(j, "migraphx");
 
     }  // end j, request
+    profileEvent("outputs", "migraphx", eval_end);
   } catch (const std::exception& e) {
     // This outer catch block catches exceptions in evaluation of the batch.
     AMDINFER_LOG_ERROR(logger, e.what());
@@ -494,24 +1990,92 @@ BatchPtr MIGraphXWorker::doRun(Batch* batch, const MemoryPool* pool) {
     }
   }
 
+  for (const auto& buffers : {&staged_buffers, &device_outputs}) {
+    for (const auto& buffer : *buffers) {
+      if (buffer != nullptr) {
+        buffer->free();
+      }
+    }
+  }
+
   if (new_batch == nullptr) {
     return new_batch;
   }
 
   new_batch->setBuffers(std::move(input_buffers), {});
 
-  timer.add("batch_stop");
+  timer.mark(RunEvent::BatchStop);
   [[maybe_unused]] auto duration =
-    timer.count<std::micro>("batch_start", "batch_stop");
+    timer.count<std::micro>(RunEvent::BatchStart, RunEvent::BatchStop);
   AMDINFER_LOG_INFO(
     logger, std::string("Finished migraphx batch processing; batch size: ") +
-              std::to_string(batch_size_) +
+              std::to_string(program_batch_size) +
               "  elapsed time: " + std::to_string(duration) + " us");
 
   return new_batch;
 }
 
-void MIGraphXWorker::doRelease() {}
+#ifdef AMDINFER_ENABLE_METRICS
+void MIGraphXWorker::watchDevice(ModelMetrics* metrics) {
+  static std::once_flag init_flag;
+  static rsmi_status_t init_status = RSMI_STATUS_SUCCESS;
+  std::call_once(init_flag, []() { init_status = rsmi_init(0); });
+  if (init_status != RSMI_STATUS_SUCCESS) {
+    [[maybe_unused]] const auto& logger = this->getLogger();
+    AMDINFER_LOG_WARN(logger,
+                      "ROCm SMI could not be initialized so the GPU's "
+                      "utilization isn't reported");
+    return;
+  }
+
+  int device = device_;
+  if (device < 0) {
+    checkHip(hipGetDevice(&device), "get the current device");
+  }
+  // ROCm SMI numbers all the GPUs while HIP only numbers the visible ones so
+  // they only match if HIP_VISIBLE_DEVICES isn't set
+  const auto index = static_cast<uint32_t>(device);
+  metrics->watchGauge(this, MetricGaugeIDs::GpuBusy, [index]() {
+    uint32_t percent = 0;
+    if (rsmi_dev_busy_percent_get(index, &percent) != RSMI_STATUS_SUCCESS) {
+      return 0.0;
+    }
+    constexpr auto kPercent = 100.0;
+    return static_cast<double>(percent) / kPercent;
+  });
+  metrics->watchGauge(this, MetricGaugeIDs::GpuMemoryUsed, [index]() {
+    uint64_t used = 0;
+    if (rsmi_dev_memory_usage_get(index, RSMI_MEM_TYPE_VRAM, &used) !=
+        RSMI_STATUS_SUCCESS) {
+      return 0.0;
+    }
+    return static_cast<double>(used);
+  });
+}
+#endif
+
+void MIGraphXWorker::doRelease() {
+  const DeviceGuard guard{device_};
+  for (const auto& job : jobs_) {
+    hipEventDestroy(job->computed);
+    hipStreamDestroy(job->stream);
+  }
+  jobs_.clear();
+  // the graphs are captured again on the next acquire's streams
+  for (auto& [_, program] : programs_) {
+    if (program.graph.has_value()) {
+      auto& graph = program.graph.value();
+      hipGraphExecDestroy(graph.exec);
+      for (const auto& buffers : {&graph.inputs, &graph.outputs}) {
+        for (const auto& buffer : *buffers) {
+          buffer->free();
+        }
+      }
+      program.graph.reset();
+    }
+    program.capture_failed = false;
+  }
+}
 void MIGraphXWorker::doDestroy() {}
 
 }  // namespace amdinfer::workers
@@ -0,0 +1,562 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the OnnxRuntime worker
+ */
+
+#include <onnxruntime_cxx_api.h>  // for Session, Value, IoBinding
+
+#include <algorithm>     // for any_of, max
+#include <cstddef>       // for size_t, byte
+#include <cstdint>       // for int32_t, int64_t
+#include <exception>     // for exception
+#include <filesystem>    // for path, exists
+#include <memory>        // for unique_ptr, allocator
+#include <string>        // for string, operator+, to_s...
+#include <system_error>  // for error_code
+#include <utility>       // for move
+#include <vector>        // for vector
+
+#include "amdinfer/batching/batch.hpp"   // for Batch, BatchPtr
+#include "amdinfer/build_options.hpp"    // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"  // for DataType
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument, exter...
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+#include "amdinfer/declarations.hpp"            // for BufferPtr
+#include "amdinfer/observation/logging.hpp"  // for Logger, AMDINFER_LOG_INFO
+#include "amdinfer/util/artifact_cache.hpp"  // for ArtifactKey
+#include "amdinfer/util/containers.hpp"      // for containerProduct
+#include "amdinfer/util/memory.hpp"          // for copy
+#include "amdinfer/workers/worker.hpp"       // for MultiThreadedWorker
+
+namespace fs = std::filesystem;
+
+namespace amdinfer::workers {
+
+namespace {
+
+DataType toDataType(ONNXTensorElementDataType type) {
+  switch (type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+      return DataType::Bool;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+      return DataType::Uint8;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+      return DataType::Uint16;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+      return DataType::Uint32;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+      return DataType::Uint64;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+      return DataType::Int8;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+      return DataType::Int16;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+      return DataType::Int32;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+      return DataType::Int64;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+      return DataType::Fp16;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+      return DataType::Bf16;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+      return DataType::Fp32;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+      return DataType::Fp64;
+    default:
+      return DataType::Unknown;
+  }
+}
+
+/// The ONNX Runtime environment is shared by all the workers' sessions
+Ort::Env& getEnv() {
+  static Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "amdinfer"};
+  return env;
+}
+
+bool isStatic(const std::vector<int64_t>& shape) {
+  return std::none_of(shape.begin(), shape.end(),
+                      [](int64_t dim) { return dim <= 0; });
+}
+
+}  // namespace
+
+/**
+ * @brief The OnnxRuntime worker runs ONNX models with ONNX Runtime on the
+ * CPU or on a GPU with the ROCm or MIGraphX execution providers. The batch's
+ * buffers are bound to the model's inputs and outputs in place so the runtime
+ * reads and writes the pooled memory directly.
+ *
+ */
+class OnnxRuntime : public MultiThreadedWorker {
+ public:
+  using MultiThreadedWorker::MultiThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// Models with a fixed batch size are only run with full batches
+  [[nodiscard]] std::vector<size_t> getWarmupBatchSizes() const override {
+    if (fixed_batch_) {
+      return {batch_size_};
+    }
+    return MultiThreadedWorker::getWarmupBatchSizes();
+  }
+
+  /// One of the model's input or output tensors
+  struct Binding {
+    std::string name;
+    /// The shape of one request's tensor. Dynamic dimensions are negative
+    std::vector<int64_t> shape;
+    DataType datatype;
+    ONNXTensorElementDataType type;
+  };
+
+  /**
+   * @brief Get the shape to run an input with for the batch. Dynamic
+   * dimensions take the size of the first request's input.
+   *
+   * @param batch the batch
+   * @param index the index of the input
+   * @param batch_size the batch size to run with
+   * @return std::vector<int64_t>
+   */
+  [[nodiscard]] std::vector<int64_t> getRunShape(Batch* batch, size_t index,
+                                                 size_t batch_size) const;
+
+  std::string provider_ = "cpu";
+  int32_t device_ = 0;
+  int32_t intra_op_threads_ = 0;
+  int32_t inter_op_threads_ = 0;
+  int32_t threads_ = 1;
+  // CPUs the worker is pinned to, which also size its intra-op thread pool
+  std::vector<int> cpus_;
+  // set if the model's batch dimension isn't dynamic
+  bool fixed_batch_ = false;
+  // directory of the compiled artifact cache or empty if it's off
+  fs::path cache_dir_;
+
+  std::unique_ptr<Ort::Session> session_;
+  Ort::MemoryInfo memory_info_{nullptr};
+  std::vector<Binding> inputs_;
+  std::vector<Binding> outputs_;
+  std::vector<std::string> output_names_;
+};
+
+std::vector<MemoryAllocators> OnnxRuntime::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> OnnxRuntime::getReservations() const {
+  std::vector<Tensor> inputs;
+  std::vector<Tensor> outputs;
+  for (const auto& [bindings, tensors] :
+       {std::pair{&inputs_, &inputs}, std::pair{&outputs_, &outputs}}) {
+    for (const auto& binding : *bindings) {
+      // tensors that vary in size are allocated as they arrive
+      if (!isStatic(binding.shape)) {
+        return {};
+      }
+      tensors->emplace_back(binding.name, binding.shape, binding.datatype);
+    }
+  }
+  return this->reserveBatches(inputs, outputs);
+}
+
+void OnnxRuntime::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  if (parameters->has("execution_provider")) {
+    provider_ = parameters->get<std::string>("execution_provider");
+  }
+  if (provider_ != "cpu" && provider_ != "rocm" && provider_ != "migraphx") {
+    throw invalid_argument("Unknown execution_provider " + provider_ +
+                           ". Use cpu, rocm or migraphx");
+  }
+  if (parameters->has("device")) {
+    device_ = parameters->get<int32_t>("device");
+  }
+
+  if (parameters->has("intra_op_threads")) {
+    intra_op_threads_ = parameters->get<int32_t>("intra_op_threads");
+  }
+  if (parameters->has("inter_op_threads")) {
+    inter_op_threads_ = parameters->get<int32_t>("inter_op_threads");
+  }
+  if (parameters->has("threads")) {
+    threads_ = parameters->get<int32_t>("threads");
+  }
+  if (intra_op_threads_ < 0 || inter_op_threads_ < 0 || threads_ < 1) {
+    throw invalid_argument(
+      "The thread counts can't be negative and there must be one thread");
+  }
+
+  cpus_ = getPinnedCpus(*parameters);
+  // by default, the batches running at once share the pinned CPUs
+  if (intra_op_threads_ == 0 && !cpus_.empty()) {
+    intra_op_threads_ =
+      std::max(static_cast<int32_t>(cpus_.size()) / threads_, 1);
+  }
+  cache_dir_ = getArtifactCache(*parameters);
+}
+
+void OnnxRuntime::doAcquire(ParameterMap* parameters) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  if (!parameters->has("model")) {
+    throw invalid_argument("Model not provided in load-time parameters");
+  }
+  fs::path path = parameters->get<std::string>("model");
+  if (!path.has_extension()) {
+    path.replace_extension(".onnx");
+  }
+  if (!fs::exists(path)) {
+    throw file_not_found_error("Model " + path.string() + " does not exist");
+  }
+
+  // the graph optimized by an earlier load on a CPU with the same target is
+  // read from the artifact cache so it's not optimized again. The GPU
+  // providers compile parts of the graph, which can't be saved
+  fs::path cached;
+  if (provider_ == "cpu" && !cache_dir_.empty()) {
+    util::ArtifactKey key{"onnxruntime"};
+    key.addFile(path);
+    key.add("version", OrtGetApiBase()->GetVersionString());
+    key.add("target", util::getCpuTarget());
+    key.add("optimization", "all");
+    cached = key.getPath(cache_dir_, ".onnx");
+  }
+  const auto use_cached = !cached.empty() && fs::exists(cached);
+  fs::path temporary;
+
+  try {
+    Ort::SessionOptions options;
+    if (use_cached) {
+      AMDINFER_LOG_INFO(logger, "Loading optimized model " + cached.string());
+      options.SetGraphOptimizationLevel(
+        GraphOptimizationLevel::ORT_DISABLE_ALL);
+    } else {
+      options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+      if (!cached.empty()) {
+        temporary = util::getTemporaryPath(cached);
+        options.SetOptimizedModelFilePath(temporary.c_str());
+      }
+    }
+    options.SetIntraOpNumThreads(intra_op_threads_);
+    if (inter_op_threads_ > 0) {
+      options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+      options.SetInterOpNumThreads(inter_op_threads_);
+    }
+
+    if (provider_ == "rocm") {
+      OrtROCMProviderOptions rocm_options;
+      rocm_options.device_id = device_;
+      options.AppendExecutionProvider_ROCM(rocm_options);
+    } else if (provider_ == "migraphx") {
+      OrtMIGraphXProviderOptions migraphx_options{};
+      migraphx_options.device_id = device_;
+      options.AppendExecutionProvider_MIGraphX(migraphx_options);
+    }
+
+    // the session reads, optimizes and partitions the graph for the providers
+    const auto& model = use_cached ? cached : path;
+    session_ = this->timeLoadPhase(LoadPhase::Compile, [&]() {
+      return std::make_unique<Ort::Session>(getEnv(), model.c_str(), options);
+    });
+    if (!temporary.empty() && util::publishArtifact(temporary, cached)) {
+      AMDINFER_LOG_INFO(logger, "Saved optimized model " + cached.string());
+    }
+    memory_info_ =
+      Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    const auto describe = [](Ort::TypeInfo info, std::string name) {
+      if (info.GetONNXType() != ONNX_TYPE_TENSOR) {
+        throw invalid_argument("Model tensor " + name + " is not a tensor");
+      }
+      auto tensor_info = info.GetTensorTypeAndShapeInfo();
+      const auto type = tensor_info.GetElementType();
+      const auto datatype = toDataType(type);
+      if (datatype == DataType::Unknown) {
+        throw invalid_argument("Model tensor " + name +
+                               " has an unsupported datatype");
+      }
+      return Binding{std::move(name), tensor_info.GetShape(), datatype, type};
+    };
+    for (auto i = 0U; i < session_->GetInputCount(); ++i) {
+      inputs_.push_back(describe(session_->GetInputTypeInfo(i),
+                                 session_->GetInputNameAllocated(i, allocator)
+                                   .get()));
+    }
+    for (auto i = 0U; i < session_->GetOutputCount(); ++i) {
+      outputs_.push_back(describe(session_->GetOutputTypeInfo(i),
+                                  session_->GetOutputNameAllocated(i, allocator)
+                                    .get()));
+    }
+  } catch (const Ort::Exception& e) {
+    if (!temporary.empty()) {
+      std::error_code error;
+      fs::remove(temporary, error);
+    }
+    AMDINFER_LOG_ERROR(logger, e.what());
+    throw external_error("Could not load model with ONNX Runtime: " +
+                         std::string{e.what()});
+  }
+
+  // the leading dimension of every tensor is the batch size
+  for (auto* bindings : {&inputs_, &outputs_}) {
+    for (auto& binding : *bindings) {
+      auto& shape = binding.shape;
+      if (shape.empty()) {
+        throw invalid_argument("Model tensor " + binding.name +
+                               " has no batch dimension");
+      }
+      if (shape.front() > 0) {
+        fixed_batch_ = true;
+        this->batch_size_ = static_cast<size_t>(shape.front());
+      }
+      shape.erase(shape.begin());
+    }
+  }
+  if (fixed_batch_) {
+    AMDINFER_LOG_INFO(logger, "ONNX model has a fixed batch size of " +
+                                std::to_string(this->batch_size_));
+  }
+
+  for (const auto& input : inputs_) {
+    this->metadata_.addInputTensor(input.name, input.shape, input.datatype);
+  }
+  for (const auto& output : outputs_) {
+    this->metadata_.addOutputTensor(output.name, output.shape,
+                                    output.datatype);
+    output_names_.push_back(output.name);
+  }
+  this->metadata_.setName("OnnxRuntime");
+
+  this->createThreadPool(threads_, cpus_);
+  AMDINFER_LOG_INFO(logger, "Model loaded with the " + provider_ +
+                              " execution provider");
+}
+
+std::vector<int64_t> OnnxRuntime::getRunShape(Batch* batch, size_t index,
+                                              size_t batch_size) const {
+  const auto& binding = inputs_[index];
+  const auto& input0 = batch->getRequest(0)->getInputs()[index];
+  std::vector<int64_t> shape{static_cast<int64_t>(batch_size)};
+  shape.insert(shape.end(), binding.shape.begin(), binding.shape.end());
+  if (!isStatic(binding.shape)) {
+    const auto& request_shape = input0.getShape();
+    if (request_shape.size() != binding.shape.size()) {
+      throw invalid_argument("Input " + binding.name + " must have " +
+                             std::to_string(binding.shape.size()) +
+                             " dimensions");
+    }
+    for (auto i = 0U; i < request_shape.size(); ++i) {
+      if (binding.shape[i] <= 0) {
+        shape[i + 1] = request_shape[i];
+      }
+    }
+  }
+  // the batch is one tensor so its requests must all be the same size
+  for (const auto& request : *batch) {
+    if (request->getInputs()[index].getSize() != input0.getSize()) {
+      throw invalid_argument("The requests of a batch must have the same "
+                             "shape for input " + binding.name);
+    }
+  }
+  return shape;
+}
+
+BatchPtr OnnxRuntime::doRun(Batch* batch, const MemoryPool* pool) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  const auto batch_size = batch->size();
+  // models with a fixed batch size run partial batches padded with whatever
+  // is in the rest of the buffers, which the batcher sizes for a full batch
+  const auto run_batch_size = fixed_batch_ ? batch_size_ : batch_size;
+
+  // inputs copied to fit the run batch size and the model outputs
+  std::vector<BufferPtr> staged_buffers;
+  std::vector<BufferPtr> input_buffers;
+  BatchPtr new_batch;
+  try {
+    Ort::IoBinding binding{*session_};
+    const auto& buffers = batch->getInputBuffers();
+    for (auto k = 0U; k < inputs_.size(); ++k) {
+      const auto& input = inputs_[k];
+      const auto& input0 = batch->getRequest(0)->getInputs().at(k);
+      if (input0.getDatatype() != input.datatype) {
+        throw invalid_argument("ONNX model and input data types don't match "
+                               "for input " + input.name);
+      }
+      const auto shape = this->getRunShape(batch, k, run_batch_size);
+      const auto request_bytes =
+        input0.getSize() * input.datatype.size();
+
+      // the batcher packs the inputs of the batch into one buffer, which is
+      // bound in place
+      void* data = input0.getData();
+      if (batch->isScatterGather() || buffers.size() <= k) {
+        Tensor tensor{input.name, input0.getShape(), input.datatype};
+        auto& staged = staged_buffers.emplace_back(
+          pool->get(this->getAllocators(), tensor, run_batch_size));
+        auto* staged_data = static_cast<std::byte*>(staged->data(0));
+        for (const auto& request : *batch) {
+          staged_data = util::copy(request->getInputs()[k].getData(),
+                                   staged_data, request_bytes);
+        }
+        data = staged->data(0);
+      }
+      binding.BindInput(
+        input.name.c_str(),
+        Ort::Value::CreateTensor(memory_info_, data,
+                                 request_bytes * run_batch_size, shape.data(),
+                                 shape.size(), input.type));
+    }
+
+    // only the outputs that some request asks for are bound and computed
+    std::vector<std::vector<size_t>> selected;
+    selected.reserve(batch_size);
+    std::vector<int> slots(outputs_.size(), -1);
+    for (const auto& request : *batch) {
+      for (auto i : selected.emplace_back(selectOutputs(*request,
+                                                        output_names_))) {
+        slots[i] = 0;
+      }
+    }
+    int slot = 0;
+    for (auto i = 0U; i < outputs_.size(); ++i) {
+      if (slots[i] < 0) {
+        continue;
+      }
+      slots[i] = slot++;
+      const auto& output = outputs_[i];
+      // outputs that vary in size are allocated by the runtime and copied
+      if (!isStatic(output.shape)) {
+        binding.BindOutput(output.name.c_str(), memory_info_);
+        input_buffers.emplace_back();
+        continue;
+      }
+      Tensor tensor{output.name, output.shape, output.datatype};
+      auto& buffer = input_buffers.emplace_back(
+        pool->get(next_allocators_, tensor, run_batch_size));
+      Shape shape{static_cast<int64_t>(run_batch_size)};
+      for (const auto dim : output.shape) {
+        shape.push_back(dim);
+      }
+      binding.BindOutput(
+        output.name.c_str(),
+        Ort::Value::CreateTensor(
+          memory_info_, buffer->data(0),
+          tensor.getSize() * output.datatype.size() * run_batch_size,
+          shape.data(), shape.size(), output.type));
+    }
+
+    session_->Run(Ort::RunOptions{nullptr}, binding);
+
+    // the shape of one response's tensor for each output
+    std::vector<Shape> output_shapes(outputs_.size());
+    auto values = binding.GetOutputValues();
+    for (auto i = 0U; i < outputs_.size(); ++i) {
+      if (slots[i] < 0) {
+        continue;
+      }
+      const auto& output = outputs_[i];
+      auto& buffer = input_buffers[slots[i]];
+      auto& value = values[slots[i]];
+      auto shape = value.GetTensorTypeAndShapeInfo().GetShape();
+      shape.erase(shape.begin());
+      if (buffer == nullptr) {
+        Tensor tensor{output.name, shape, output.datatype};
+        buffer = pool->get(next_allocators_, tensor, batch_size);
+        util::copy(value.GetTensorData<std::byte>(),
+                   static_cast<std::byte*>(buffer->data(0)),
+                   tensor.getSize() * output.datatype.size() * batch_size);
+      }
+      output_shapes[i] = std::move(shape);
+    }
+
+    new_batch = batch->propagate();
+    for (auto j = 0U; j < batch_size; ++j) {
+      auto new_request = batch->getRequest(j)->propagate();
+      for (auto i : selected[j]) {
+        const auto& output = outputs_[i];
+        const auto& shape = output_shapes[i];
+        const auto bytes =
+          util::containerProduct(shape) * output.datatype.size();
+        auto* data_ptr = input_buffers[slots[i]]->data(j * bytes);
+        new_request->addInputTensor(
+          InferenceRequestInput{data_ptr, shape, output.datatype, output.name});
+      }
+      new_batch->addRequest(new_request);
+      new_batch->setModel(j, "onnxruntime");
+    }
+  } catch (const std::exception& e) {
+    AMDINFER_LOG_ERROR(logger, e.what());
+    for (const auto& request : *batch) {
+      request->runCallbackError(std::string("ONNX Runtime inference error: ") +
+                                e.what());
+    }
+    for (const auto& buffer : input_buffers) {
+      if (buffer != nullptr) {
+        buffer->free();
+      }
+    }
+    input_buffers.clear();
+    new_batch = nullptr;
+  }
+
+  for (const auto& buffer : staged_buffers) {
+    buffer->free();
+  }
+  if (new_batch != nullptr) {
+    new_batch->setBuffers(std::move(input_buffers), {});
+  }
+  return new_batch;
+}
+
+void OnnxRuntime::doRelease() { this->destroyThreadPool(); }
+
+void OnnxRuntime::doDestroy() { session_.reset(); }
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::OnnxRuntime("OnnxRuntime", "CPU", true);
+}
+}  // extern C
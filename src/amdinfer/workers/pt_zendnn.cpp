@@ -17,18 +17,21 @@
  * @brief Implements the PtZendnn worker
  */
 
-#include <algorithm>   // for copy
-#include <cstddef>     // for size_t, byte
-#include <cstdint>     // for int32_t, uint64_t
-#include <cstring>     // for memcpy
-#include <exception>   // for exception
-#include <filesystem>  // for path, exists, filesystem
-#include <memory>      // for unique_ptr, allocator
-#include <ratio>       // for milli, micro
-#include <string>      // for string, operator+, to_s...
-#include <thread>      // for thread
-#include <utility>     // for move
-#include <vector>      // for vector
+#include <algorithm>     // for copy, min, any_of, find
+#include <cstddef>       // for size_t, byte
+#include <cstdint>       // for int32_t, uint64_t
+#include <cstring>       // for memcpy
+#include <exception>     // for exception
+#include <filesystem>    // for path, exists, filesystem
+#include <map>           // for map
+#include <memory>        // for unique_ptr, make_shared, shared_ptr
+#include <mutex>         // for mutex, lock_guard
+#include <ratio>         // for milli, micro
+#include <string>        // for string, operator+, to_s...
+#include <system_error>  // for error_code
+#include <thread>        // for thread
+#include <utility>       // for move
+#include <vector>        // for vector
 
 #include "amdinfer/batching/hard.hpp"    // for Batch, BatchPtrQueue
 #include "amdinfer/build_options.hpp"    // for AMDINFER_ENABLE_LOGGING
@@ -40,12 +43,20 @@
 #include "amdinfer/declarations.hpp"             // for InferenceResponseOutput
 #include "amdinfer/observation/logging.hpp"  // for Logger, AMDINFER_LOG_INFO
 #include "amdinfer/observation/metrics.hpp"  // for Metrics, MetricCounterIDs
+#include "amdinfer/util/artifact_cache.hpp"  // for ArtifactKey
 #include "amdinfer/util/containers.hpp"      // for containerProduct
+#include "amdinfer/util/filesystem.hpp"      // for MappedFile
 #include "amdinfer/util/memory.hpp"          // for copy
+#include "amdinfer/util/numa.hpp"            // for getNumaNodes
+#include "amdinfer/util/string.hpp"          // for split
 #include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/util/timer.hpp"           // for Timer
+#include "amdinfer/util/timestamps.hpp"      // for elapsed, now
 #include "amdinfer/workers/worker.hpp"       // for Worker, kNumBufferAuto
+#include "ATen/Parallel.h"                   // for set_num_threads
+#include "ATen/autocast_mode.h"              // for set_cpu_enabled
+#include "caffe2/serialize/read_adapter_interface.h"  // for ReadAdapterInt...
 #include "torch/script.h"                    // for IValue, Tensor, Device
+#include "torch/version.h"                   // for TORCH_VERSION
 
 namespace fs = std::filesystem;
 
@@ -55,6 +66,81 @@ const int kResNetImageSize = 224;
 const int kResNetImageChannels = 3;
 const int kResNetOutputClasses = 1000;
 
+/**
+ * @brief Reads a TorchScript archive from a mapped file so torch copies the
+ * tensors straight out of the page cache instead of reading the file through
+ * its own buffers
+ */
+class MappedReadAdapter : public caffe2::serialize::ReadAdapterInterface {
+ public:
+  explicit MappedReadAdapter(const fs::path& path) : file_(path) {}
+
+  [[nodiscard]] size_t size() const override { return file_.size(); }
+  size_t read(uint64_t pos, void* buf, size_t n,
+              [[maybe_unused]] const char* what) const override {
+    if (pos >= file_.size()) {
+      return 0;
+    }
+    n = std::min(n, static_cast<size_t>(file_.size() - pos));
+    std::memcpy(buf, file_.data() + pos, n);
+    return n;
+  }
+
+ private:
+  util::MappedFile file_;
+};
+
+/// Load a TorchScript module from a mapped file onto the CPU
+torch::jit::Module loadMapped(const fs::path& path) {
+  return torch::jit::load(std::make_shared<MappedReadAdapter>(path),
+                          torch::kCPU);
+}
+
+/// Get the NUMA nodes of the CPUs as a node list or "all" if there are none
+std::string getCpuNodes(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return "all";
+  }
+  std::vector<int> nodes;
+  for (auto node : util::getNumaNodes()) {
+    const auto node_cpus = util::getNumaNodeCpus(node);
+    if (std::any_of(cpus.begin(), cpus.end(), [&](int cpu) {
+          return std::find(node_cpus.begin(), node_cpus.end(), cpu) !=
+                 node_cpus.end();
+        })) {
+      nodes.push_back(node);
+    }
+  }
+  return util::formatIdList(nodes);
+}
+
+/**
+ * @brief Runs the ops of the calling thread in bf16 where autocast allows it
+ * while the guard is in scope. Ops that need the range of fp32 stay in fp32.
+ */
+class Bf16Autocast {
+ public:
+  explicit Bf16Autocast(bool enabled) : enabled_(enabled) {
+    if (enabled_) {
+      at::autocast::set_autocast_cpu_dtype(at::kBFloat16);
+      at::autocast::set_cpu_enabled(true);
+    }
+  }
+  Bf16Autocast(const Bf16Autocast&) = delete;
+  Bf16Autocast& operator=(const Bf16Autocast&) = delete;
+  Bf16Autocast(Bf16Autocast&&) = delete;
+  Bf16Autocast& operator=(Bf16Autocast&&) = delete;
+  ~Bf16Autocast() {
+    if (enabled_) {
+      at::autocast::set_cpu_enabled(false);
+      at::autocast::clear_cache();
+    }
+  }
+
+ private:
+  bool enabled_;
+};
+
 /**
  * @brief The PtZendnn worker is a simple worker that accepts a single uint32_t
  * argument and adds 1 to it and returns. It accepts multiple input tensors and
@@ -65,6 +151,8 @@ class PtZendnn : public SingleThreadedWorker {
  public:
   using SingleThreadedWorker::SingleThreadedWorker;
   [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
 
  private:
   void doInit(ParameterMap* parameters) override;
@@ -73,6 +161,11 @@ class PtZendnn : public SingleThreadedWorker {
   void doRelease() override;
   void doDestroy() override;
 
+  /// The metadata's input shapes include the batch size
+  [[nodiscard]] std::vector<Tensor> getWarmupInputs() const override {
+    return dropBatchDimension(metadata_.getInputs());
+  }
+
   // workers define what batcher implementation should be used for them.
   // if not explicitly defined here, a default value is used from worker.hpp.
   // using Worker::makeBatcher;
@@ -81,15 +174,35 @@ class PtZendnn : public SingleThreadedWorker {
   //   return this->makeBatcher<HardBatcher>(num, parameters);
   // };
 
-  // Load the model here
-  torch::jit::script::Module model_;
+  // Load the model here. Instances on the same NUMA nodes share it
+  std::shared_ptr<torch::jit::script::Module> model_;
+
+  /**
+   * @brief Wrap the batch's inputs in a tensor with the model's input shape.
+   * Contiguous batches are wrapped in place and scatter-gather batches are
+   * copied into a new tensor.
+   *
+   * @param batch the batch
+   * @return torch::Tensor
+   */
+  torch::Tensor wrapInputs(Batch* batch) const;
 
   // Image properties
   unsigned int image_width_ = kResNetImageSize;
   unsigned int image_height_ = kResNetImageSize;
   unsigned int image_channels_ = kResNetImageChannels;
-  unsigned int image_size_ = image_width_ * image_height_ * image_channels_;
   unsigned int output_classes_ = kResNetOutputClasses;
+  // shape of one request's input as the model sees it
+  std::vector<int64_t> input_shape_;
+  // number of elements in one request's input
+  size_t input_size_ = 0;
+  // CPUs the worker is pinned to, which also size its intra-op thread pool
+  std::vector<int> cpus_;
+  bool threads_set_ = false;
+  // directory of the compiled artifact cache or empty if it's off
+  fs::path cache_dir_;
+  // precision to run the model at: native, bf16 or int8
+  std::string precision_;
 
   DataType input_dt_ = DataType::FP32;
 };
@@ -98,6 +211,12 @@ std::vector<MemoryAllocators> PtZendnn::getAllocators() const {
   return {MemoryAllocators::Cpu};
 }
 
+std::vector<MemoryReservation> PtZendnn::getReservations() const {
+  Tensor input{"input", input_shape_, input_dt_};
+  Tensor output{"output", {output_classes_}, DataType::FP32};
+  return this->reserveBatches({input}, {output});
+}
+
 void PtZendnn::doInit(ParameterMap* parameters) {
   constexpr auto kBatchSize = 1;
 
@@ -113,10 +232,26 @@ void PtZendnn::doInit(ParameterMap* parameters) {
   }
 
   if (parameters->has("image_channels")) {
-    image_channels_ = parameters->get<int32_t>("image_channels_");
+    image_channels_ = parameters->get<int32_t>("image_channels");
+  }
+
+  // images are passed to the model as CHW
+  input_shape_ = {image_channels_, image_height_, image_width_};
+  if (parameters->has("input_shape")) {
+    input_shape_.clear();
+    for (const auto& dim :
+         util::split(parameters->get<std::string>("input_shape"), ",")) {
+      input_shape_.push_back(std::stoll(dim));
+    }
+    if (input_shape_.empty()) {
+      throw invalid_argument("input_shape must have at least one dimension");
+    }
   }
+  input_size_ = util::containerProduct(input_shape_);
 
-  image_size_ = image_height_ * image_width_ * image_channels_;
+  cpus_ = getPinnedCpus(*parameters);
+  cache_dir_ = getArtifactCache(*parameters);
+  precision_ = getCpuPrecision(*parameters);
 
   if (parameters->has("output_classes")) {
     output_classes_ = parameters->get<int32_t>("output_classes");
@@ -135,43 +270,143 @@ void PtZendnn::doAcquire(ParameterMap* parameters) {
   if (!path.has_extension()) {
     path.replace_extension(".pt");
   }
+  // int8 models are quantized and calibrated ahead of time with PyTorch's
+  // quantization tools
+  if (precision_ == "int8") {
+    path = getQuantizedModel(path, precision_);
+  }
 
   if (!fs::exists(path)) {
     throw file_not_found_error("Model " + path.string() + " does not exist");
   }
 
-  // Load the model
-  torch::jit::Module torch_module;
-  try {
-    torch_module = torch::jit::load(path, torch::kCPU);
-  } catch (const c10::Error& e) {
-    AMDINFER_LOG_ERROR(logger, e.what());
-    throw file_read_error("Could not load model with torch");
+  // the module optimized by an earlier load on a CPU with the same target is
+  // read from the artifact cache so it's not optimized again
+  fs::path cached;
+  if (!cache_dir_.empty()) {
+    util::ArtifactKey key{"pytorch"};
+    key.addFile(path);
+    key.add("version", TORCH_VERSION);
+    key.add("target", util::getCpuTarget());
+    key.add("precision", precision_);
+    cached = key.getPath(cache_dir_, ".pt");
   }
 
-  AMDINFER_LOG_INFO(logger, "Model loaded");
-
-  // Some online optimizations for the model
-  torch_module.eval();
-  try {
-    torch_module = torch::jit::optimize_for_inference(torch_module);
-  } catch (const std::exception& e) {
-    AMDINFER_LOG_ERROR(logger, e.what());
-    throw external_error("Unable to perform optimizations");
+  // instances on the same NUMA nodes share one module instead of each holding
+  // a copy of the weights. The optimized module is frozen so running it
+  // doesn't change it and instances can run it from their threads at once
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<torch::jit::Module>> modules;
+  const std::lock_guard lock{mutex};
+  auto& shared =
+    modules[path.string() + "|" + precision_ + "|" + getCpuNodes(cpus_)];
+  this->model_ = shared.lock();
+  bool loaded = this->model_ != nullptr;
+  if (loaded) {
+    AMDINFER_LOG_INFO(logger, "Sharing the model of another instance");
+  }
+  if (!loaded && !cached.empty() && fs::exists(cached)) {
+    // a bad copy in the cache is replaced by optimizing the model again
+    try {
+      this->model_ = this->timeLoadPhase(LoadPhase::ReadModel, [&]() {
+        return std::make_shared<torch::jit::Module>(loadMapped(cached));
+      });
+      loaded = true;
+      AMDINFER_LOG_INFO(logger, "Loaded optimized model " + cached.string());
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_WARN(logger, "Could not load optimized model " +
+                                  cached.string() + ": " + e.what());
+    }
   }
-  AMDINFER_LOG_INFO(logger, "Model Optimized, Ready for prediction");
+  if (!loaded) {
+    // Load the model
+    torch::jit::Module torch_module;
+    try {
+      torch_module = this->timeLoadPhase(LoadPhase::ReadModel, [&]() {
+        return loadMapped(path);
+      });
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_ERROR(logger, e.what());
+      throw file_read_error("Could not load model with torch");
+    }
 
-  this->model_ = torch_module;
+    AMDINFER_LOG_INFO(logger, "Model loaded");
+
+    // Some online optimizations for the model. Optimizing for inference
+    // replaces convolutions with MKLDNN ops that autocast and the quantized
+    // ops don't use so other precisions are only frozen
+    torch_module.eval();
+    try {
+      torch_module = this->timeLoadPhase(LoadPhase::Compile, [&]() {
+        if (precision_ != "native") {
+          return torch::jit::freeze(torch_module);
+        }
+        return torch::jit::optimize_for_inference(torch_module);
+      });
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_ERROR(logger, e.what());
+      throw external_error("Unable to perform optimizations");
+    }
+    AMDINFER_LOG_INFO(logger, "Model Optimized, Ready for prediction");
+
+    // some optimized modules hold tensors that can't be serialized, such as
+    // MKLDNN ones, and are optimized on every load
+    if (!cached.empty()) {
+      const auto temporary = util::getTemporaryPath(cached);
+      try {
+        torch_module.save(temporary);
+        if (util::publishArtifact(temporary, cached)) {
+          AMDINFER_LOG_INFO(logger,
+                            "Saved optimized model " + cached.string());
+        }
+      } catch (const c10::Error& e) {
+        std::error_code error;
+        fs::remove(temporary, error);
+        AMDINFER_LOG_WARN(logger, "Could not save optimized model " +
+                                    cached.string() + ": " + e.what());
+      }
+    }
+
+    this->model_ = std::make_shared<torch::jit::Module>(torch_module);
+  }
+  shared = this->model_;
 
   // Adding metadata for input and output
-  this->metadata_.addInputTensor("input",
-                                 {static_cast<int64_t>(batch_size_),
-                                  image_height_, image_width_, image_channels_},
-                                 input_dt_);
+  std::vector<int64_t> batch_shape{static_cast<int64_t>(batch_size_)};
+  if (parameters->has("input_shape")) {
+    batch_shape.insert(batch_shape.end(), input_shape_.begin(),
+                       input_shape_.end());
+  } else {
+    // requests send images as HWC
+    batch_shape.insert(batch_shape.end(),
+                       {image_height_, image_width_, image_channels_});
+  }
+  this->metadata_.addInputTensor("input", batch_shape, input_dt_);
   this->metadata_.addOutputTensor("output", {0}, DataType::FP32);
   this->metadata_.setName("PtZendnn");
 }
 
+torch::Tensor PtZendnn::wrapInputs(Batch* batch) const {
+  std::vector<int64_t> shape{static_cast<int64_t>(batch->size())};
+  shape.insert(shape.end(), input_shape_.begin(), input_shape_.end());
+
+  // the batcher already packed the first input of every request into one
+  // buffer so the model can read it in place
+  if (!batch->isScatterGather()) {
+    return torch::from_blob(batch->getInputBuffers().front()->data(0), shape,
+                            torch::kF32);
+  }
+
+  torch::Tensor tensor = torch::empty(shape, torch::kF32);
+  auto* data = static_cast<std::byte*>(tensor.data_ptr());
+  const auto request_bytes = input_size_ * input_dt_.size();
+  for (const auto& request : *batch) {
+    data = util::copy(request->getInputs().front().getData(), data,
+                      request_bytes);
+  }
+  return tensor;
+}
+
 BatchPtr PtZendnn::doRun(Batch* batch, const MemoryPool* pool) {
 #ifdef AMDINFER_ENABLE_LOGGING
   const auto& logger = this->getLogger();
@@ -181,59 +416,51 @@ BatchPtr PtZendnn::doRun(Batch* batch, const MemoryPool* pool) {
   torch::NoGradGuard no_grad;
   c10::InferenceMode guard;
 
-  size_t input_size = 0;
-  std::vector<torch::jit::IValue> input_vec;
-  auto tensors = static_cast<int>(batch->size());
-
-  // Initialize a PT tensor with required shape
-  torch::Tensor input_tensor = torch::empty(
-    {tensors, image_channels_, image_height_, image_width_}, torch::kF32);
+  // the intra-op threads are started by this thread so they inherit its CPUs.
+  // Limit them to one per CPU so pinned workers don't oversubscribe them
+  if (!cpus_.empty() && !threads_set_) {
+    at::set_num_threads(static_cast<int>(cpus_.size()));
+    threads_set_ = true;
+  }
 
 #ifdef AMDINFER_ENABLE_METRICS
-  Metrics::getInstance().incrementCounter(
-    MetricCounterIDs::PipelineIngressWorker);
+  if (metrics_ != nullptr) {
+    metrics_->incrementCounter(MetricCounterIDs::PipelineIngressWorker);
+  }
 #endif
-  size_t vec_size = 0;
-  util::Timer timer{true};
-  for (unsigned int j = 0; j < batch->size(); j++) {
-    const auto& req = batch->getRequest(j);
-
-    auto inputs = req->getInputs();
-    auto outputs = req->getOutputs();
-    AMDINFER_LOG_DEBUG(logger,
-                       "Size of input: " + std::to_string(inputs.size()));
-
-    // Get all the inputs from the requests and copy to the PT tensor
-    for (const auto& input : inputs) {
-      auto* input_buffer = input.getData();
-      const auto& input_shape = input.getShape();
-      input_size = util::containerProduct(input_shape);
-
-      auto* float_buffer = static_cast<float*>(input_buffer);
-      std::copy(float_buffer, float_buffer + input_size,
-                input_tensor.data_ptr<float>() + vec_size);
-      vec_size = vec_size + input_size;
+  // every request must fill exactly one slot of the batch's input tensor
+  for (const auto& request : *batch) {
+    const auto& inputs = request->getInputs();
+    if (inputs.empty() || inputs.front().getSize() != input_size_) {
+      const auto error =
+        "Input size doesn't match the model's input shape of " +
+        std::to_string(input_size_) + " elements";
+      AMDINFER_LOG_ERROR(logger, error);
+      for (const auto& req : *batch) {
+        req->runCallbackError(error);
+      }
+      return nullptr;
     }
   }
 
-  // Create the inputs and output tensor
-  input_vec.emplace_back(input_tensor);
+  std::vector<torch::jit::IValue> input_vec;
+  input_vec.emplace_back(this->wrapInputs(batch));
   c10::IValue prediction;
 
   // Run through the model to get the predictions
-  timer.add("infer_start");
+  const auto infer_start = util::now();
   try {
-    prediction = this->model_.forward(input_vec);
+    const Bf16Autocast autocast{precision_ == "bf16"};
+    prediction = this->model_->forward(input_vec);
   } catch (const c10::Error& e) {
     AMDINFER_LOG_ERROR(logger, "Model not suported/Issue with the model");
     for (const auto& req : *batch) {
       req->runCallbackError("Something went wrong");
     }
+    return nullptr;
   }
-  timer.add("infer_stop");
   {
-    [[maybe_unused]] auto duration =
-      timer.count<std::milli>("infer_start", "infer_stop");
+    [[maybe_unused]] auto duration = util::elapsed<std::milli>(infer_start);
     AMDINFER_LOG_INFO(logger, "Time (ms) taken for " +
                                 std::to_string(batch->size()) +
                                 " images: " + std::to_string(duration));
@@ -246,9 +473,10 @@ BatchPtr PtZendnn::doRun(Batch* batch, const MemoryPool* pool) {
     output_tensor = prediction.toTuple()->elements()[0].toTensor();
   }
 
-  // Copy the output from the model to the response object
-  size_t response_size = output_classes_;
-  std::vector<int64_t> new_shape = {static_cast<int64_t>(response_size)};
+  // erase the leading batch size to get the shape of each response
+  const auto sizes = output_tensor.sizes();
+  Shape new_shape(sizes.begin() + 1, sizes.end());
+  const auto response_size = util::containerProduct(new_shape);
 
   auto new_batch = batch->propagate();
   std::vector<BufferPtr> input_buffers;
@@ -256,6 +484,12 @@ BatchPtr PtZendnn::doRun(Batch* batch, const MemoryPool* pool) {
                                     Tensor{"name", new_shape, DataType::Fp32},
                                     batch->size()));
 
+  // the model allocates its own output so it's written once into the next
+  // stage's buffer, which also makes it contiguous and fp32 if the model ran
+  // in bf16
+  torch::from_blob(input_buffers.at(0)->data(0), sizes, torch::kF32)
+    .copy_(output_tensor);
+
   for (unsigned int k = 0; k < batch->size(); k++) {
     const auto& req = batch->getRequest(k);
 
@@ -264,9 +498,6 @@ BatchPtr PtZendnn::doRun(Batch* batch, const MemoryPool* pool) {
       input_buffers.at(0)->data(k * response_size * DataType("Fp32").size());
     new_request->addInputTensor(
       InferenceRequestInput{data_ptr, new_shape, DataType::Fp32, ""});
-    util::copy(output_tensor[0].data_ptr<float>() + (k * response_size),
-               static_cast<std::byte*>(data_ptr),
-               response_size * sizeof(float));
 
     new_batch->addRequest(new_request);
 
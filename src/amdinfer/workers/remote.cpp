@@ -0,0 +1,580 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the Remote worker
+ */
+
+#include <algorithm>           // for max
+#include <atomic>              // for atomic
+#include <chrono>              // for milliseconds, steady_clock
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t, byte
+#include <cstdint>             // for int32_t
+#include <cstring>             // for memcpy
+#include <exception>           // for exception
+#include <map>                 // for map
+#include <memory>              // for shared_ptr, unique_ptr
+#include <mutex>               // for mutex, lock_guard, unique_lock
+#include <queue>               // for queue
+#include <ratio>               // for micro
+#include <string>              // for string
+#include <thread>              // for thread
+#include <utility>             // for move
+#include <vector>              // for vector
+
+#include <unistd.h>  // for gethostname, getpid
+
+#include "amdinfer/batching/batch.hpp"           // for Batch
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_TRACING
+#include "amdinfer/clients/grpc.hpp"             // for GrpcClient, GrpcStream
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/rdma.hpp"                // for RdmaSession
+#include "amdinfer/core/shared_memory.hpp"       // for useSharedMemory
+#include "amdinfer/declarations.hpp"             // for BatchPtr
+#include "amdinfer/observation/logging.hpp"      // for AMDINFER_LOG_INFO
+#include "amdinfer/observation/metrics.hpp"      // for Metrics
+#include "amdinfer/observation/tracing.hpp"      // for Trace
+#include "amdinfer/util/string.hpp"              // for split
+#include "amdinfer/util/thread.hpp"              // for setThreadName
+#include "amdinfer/util/timestamps.hpp"          // for Timestamp, elapsed
+#include "amdinfer/workers/worker.hpp"           // for SingleThreadedWorker
+
+namespace amdinfer::workers {
+
+/**
+ * @brief The Remote worker forwards its requests to a model on one or more
+ * peer inference servers over gRPC. Each request is sent on the connection
+ * with the fewest requests waiting for responses and, if hedging is enabled,
+ * resent to another peer if it hasn't responded in time. The first response
+ * is sent back to the client.
+ *
+ * With the rdma load-time parameter, the peers read the inputs over RDMA
+ * from memory registered with each of them instead of receiving them in the
+ * gRPC messages. The memory is rdma_buffer_size MiB and requests that don't
+ * fit while it's full send their inputs over gRPC as usual. The outputs
+ * always come back over gRPC.
+ */
+class Remote : public SingleThreadedWorker {
+ public:
+  using SingleThreadedWorker::SingleThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// One stream to a peer
+  struct Connection {
+    Connection(size_t peer, GrpcStream stream)
+      : peer(peer), stream(std::move(stream)) {}
+
+    size_t peer;
+    GrpcStream stream;
+    /// The number of requests sent on the stream waiting for responses
+    std::atomic<size_t> outstanding = 0;
+  };
+
+  /// One client request while it waits for a response
+  struct Call {
+    InferenceRequestPtr client;
+    std::string id;
+    std::string model;
+    /// The request sent to the peers. Its inputs view inputs when hedging
+    InferenceRequest remote;
+    std::vector<std::vector<std::byte>> inputs;
+    /// The inputs' block of the staging memory, which is freed with the call
+    std::shared_ptr<std::byte> staged;
+    StringMap context;
+    util::Timestamp start_time;
+    /// The connection of the first attempt so a hedge goes elsewhere
+    size_t peer = 0;
+    /// The number of attempts waiting for responses
+    std::atomic<size_t> attempts = 0;
+    std::atomic<bool> done = false;
+  };
+  using CallPtr = std::shared_ptr<Call>;
+
+  /**
+   * @brief Get the connection with the fewest outstanding requests
+   *
+   * @param skip a peer to avoid if another one is connected
+   * @return Connection*
+   */
+  Connection* pick(const size_t* skip);
+  /// Send the call on a connection
+  void send(const CallPtr& call, Connection* connection);
+  /// Handle the response to one attempt of a call
+  void respond(const CallPtr& call, const InferenceResponse& response);
+  /// Resend calls that haven't responded within the hedge delay
+  void hedge();
+#ifdef AMDINFER_ENABLE_RDMA
+  /// Register the staging memory with each peer over its own session
+  void connectRdma();
+  /**
+   * @brief Allocate a block of the staging memory
+   *
+   * @param size size of the block in bytes
+   * @return std::shared_ptr<std::byte> the block, which is freed when it's
+   * destroyed, or nullptr if there's no room
+   */
+  std::shared_ptr<std::byte> stage(size_t size);
+  /// Free a block of the staging memory
+  void unstage(size_t offset, size_t size);
+  /// Get the offset of a block in the staging memory
+  size_t offsetOf(const std::byte* block) const;
+#endif
+
+  std::string model_;
+  std::string version_;
+  std::vector<std::string> peers_;
+  size_t connections_per_peer_ = 1;
+  std::chrono::milliseconds hedge_delay_{0};
+
+  std::vector<std::unique_ptr<GrpcClient>> clients_;
+  std::vector<std::unique_ptr<Connection>> connections_;
+  std::atomic<size_t> next_id_ = 0;
+
+  std::thread hedger_;
+  std::mutex hedge_mutex_;
+  std::condition_variable hedge_cv_;
+  /// Calls in the order they were sent with the time to hedge them
+  std::queue<std::pair<std::chrono::steady_clock::time_point, CallPtr>>
+    hedges_;
+  bool stopping_ = false;
+
+#ifdef AMDINFER_ENABLE_RDMA
+  bool rdma_ = false;
+  size_t staging_size_ = 0;
+  /// The name of the session and the region on each peer
+  std::string region_;
+  std::unique_ptr<std::byte[]> staging_;
+  std::unique_ptr<RdmaMemory> staging_memory_;
+  std::vector<std::shared_ptr<RdmaSession>> sessions_;
+  std::mutex staging_mutex_;
+  /// Free blocks of the staging memory by offset with their sizes
+  std::map<size_t, size_t> free_;
+#endif
+};
+
+std::vector<MemoryAllocators> Remote::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+void Remote::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  if (!parameters->has("peers")) {
+    throw invalid_argument("Peers not provided in load-time parameters");
+  }
+  for (auto& peer : util::split(parameters->get<std::string>("peers"), ",")) {
+    if (!peer.empty()) {
+      peers_.push_back(std::move(peer));
+    }
+  }
+  if (peers_.empty()) {
+    throw invalid_argument("No peers provided in load-time parameters");
+  }
+
+  if (!parameters->has("model")) {
+    throw invalid_argument("Model not provided in load-time parameters");
+  }
+  model_ = parameters->get<std::string>("model");
+  if (parameters->has("version")) {
+    version_ = parameters->get<std::string>("version");
+  }
+
+  if (parameters->has("connections")) {
+    connections_per_peer_ =
+      std::max(parameters->get<int32_t>("connections"), 1);
+  }
+  if (parameters->has("hedge_delay")) {
+    hedge_delay_ = std::chrono::milliseconds{
+      std::max(parameters->get<int32_t>("hedge_delay"), 0)};
+  }
+
+  if (parameters->has("rdma") && parameters->get<bool>("rdma")) {
+#ifdef AMDINFER_ENABLE_RDMA
+    constexpr auto kStagingSize = 256;  // MiB
+    auto staging_size = kStagingSize;
+    if (parameters->has("rdma_buffer_size")) {
+      staging_size = std::max(parameters->get<int32_t>("rdma_buffer_size"), 1);
+    }
+    rdma_ = true;
+    staging_size_ = static_cast<size_t>(staging_size) << 20;
+#else
+    throw invalid_argument("RDMA is not enabled in this build");
+#endif
+  }
+}
+
+void Remote::doAcquire([[maybe_unused]] ParameterMap* parameters) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  // each stream gets its own client so requests are spread over channels
+  clients_.reserve(peers_.size() * connections_per_peer_);
+  for (const auto& peer : peers_) {
+    for (auto j = 0U; j < connections_per_peer_; ++j) {
+      clients_.push_back(std::make_unique<GrpcClient>(peer));
+    }
+  }
+
+  // the model's metadata is taken from the first peer that has it
+  bool found = false;
+  for (auto i = 0U; i < peers_.size() && !found; ++i) {
+    try {
+      const auto metadata =
+        clients_[i * connections_per_peer_]->modelMetadata(model_);
+      for (const auto& input : metadata.getInputs()) {
+        this->metadata_.addInputTensor(input);
+      }
+      for (const auto& output : metadata.getOutputs()) {
+        this->metadata_.addOutputTensor(output);
+      }
+      found = true;
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_WARN(logger, "Could not get the metadata of " + model_ +
+                                  " from " + peers_[i] + ": " + e.what());
+    }
+  }
+  if (!found) {
+    throw connection_error("No peer has the model " + model_);
+  }
+
+#ifdef AMDINFER_ENABLE_RDMA
+  if (rdma_) {
+    this->connectRdma();
+  }
+#endif
+
+  for (auto i = 0U; i < clients_.size(); ++i) {
+    connections_.push_back(std::make_unique<Connection>(
+      i / connections_per_peer_,
+      clients_[i]->modelInferStream(model_, version_)));
+  }
+
+  if (hedge_delay_.count() > 0) {
+    hedger_ = std::thread{&Remote::hedge, this};
+  }
+
+  AMDINFER_LOG_INFO(logger, "Forwarding to " + model_ + " on " +
+                              std::to_string(peers_.size()) + " peer(s)");
+}
+
+#ifdef AMDINFER_ENABLE_RDMA
+void Remote::connectRdma() {
+  // the name must be unique among the peers' clients
+  static std::atomic<size_t> counter = 0;
+  constexpr auto kMaxHostname = 256;
+  std::string host(kMaxHostname, '\0');
+  gethostname(host.data(), host.size());
+  host.resize(host.find('\0'));
+  region_ = "remote-" + host + "-" + std::to_string(getpid()) + "-" +
+            std::to_string(counter++);
+
+  staging_ = std::make_unique<std::byte[]>(staging_size_);
+  staging_memory_ =
+    std::make_unique<RdmaMemory>(staging_.get(), staging_size_);
+  free_ = {{0, staging_size_}};
+
+  for (auto i = 0U; i < peers_.size(); ++i) {
+    const auto& client = clients_[i * connections_per_peer_];
+    auto session = std::make_shared<RdmaSession>();
+    const auto peer = RdmaEndpoint::parse(
+      client->rdmaConnect(region_, session->getEndpoint().serialize()));
+    session->connect(peer);
+    client->registerRdma(region_, region_, staging_memory_->address(),
+                         staging_memory_->key(), staging_size_);
+    sessions_.push_back(std::move(session));
+  }
+}
+
+std::shared_ptr<std::byte> Remote::stage(size_t size) {
+  // blocks are aligned so the peers' reads start on cache lines
+  constexpr size_t kAlignment = 64;
+  size = (std::max(size, size_t{1}) + kAlignment - 1) / kAlignment;
+  size *= kAlignment;
+
+  const std::lock_guard lock{staging_mutex_};
+  auto found = std::find_if(free_.begin(), free_.end(), [size](auto& block) {
+    return block.second >= size;
+  });
+  if (found == free_.end()) {
+    return nullptr;
+  }
+  const auto offset = found->first;
+  const auto remaining = found->second - size;
+  free_.erase(found);
+  if (remaining > 0) {
+    free_.emplace(offset + size, remaining);
+  }
+  return {staging_.get() + offset,
+          [this, offset, size](const std::byte*) { unstage(offset, size); }};
+}
+
+void Remote::unstage(size_t offset, size_t size) {
+  const std::lock_guard lock{staging_mutex_};
+  auto [block, _] = free_.emplace(offset, size);
+  // the block is merged with its free neighbours
+  if (auto next = std::next(block);
+      next != free_.end() && offset + size == next->first) {
+    block->second += next->second;
+    free_.erase(next);
+  }
+  if (block != free_.begin()) {
+    if (auto previous = std::prev(block);
+        previous->first + previous->second == offset) {
+      previous->second += block->second;
+      free_.erase(block);
+    }
+  }
+}
+
+size_t Remote::offsetOf(const std::byte* block) const {
+  return static_cast<size_t>(block - staging_.get());
+}
+#endif
+
+Remote::Connection* Remote::pick(const size_t* skip) {
+  Connection* best = nullptr;
+  for (const auto& connection : connections_) {
+    if (skip != nullptr && connection->peer == *skip) {
+      continue;
+    }
+    if (best == nullptr || connection->outstanding < best->outstanding) {
+      best = connection.get();
+    }
+  }
+  return best;
+}
+
+void Remote::send(const CallPtr& call, Connection* connection) {
+  connection->outstanding++;
+  call->attempts++;
+  try {
+    connection->stream.modelInfer(
+      call->remote,
+      [this, call, connection](const InferenceResponse& response) {
+        // partial responses from sequence models on the peer aren't forwarded
+        if (!response.isFinal()) {
+          return;
+        }
+        connection->outstanding--;
+        this->respond(call, response);
+      });
+  } catch (const std::exception& e) {
+    connection->outstanding--;
+    this->respond(call, InferenceResponse{e.what()});
+  }
+}
+
+void Remote::respond(const CallPtr& call, const InferenceResponse& response) {
+  const auto remaining = --call->attempts;
+  // an error doesn't end the call if another attempt may still succeed
+  if (response.isError() && remaining > 0) {
+    return;
+  }
+  if (call->done.exchange(true)) {
+    return;
+  }
+
+  if (response.isError()) {
+    call->client->runCallbackError(response.getError());
+    return;
+  }
+
+  InferenceResponse resp{response};
+  resp.setID(call->id);
+  resp.setModel(call->model);
+#ifdef AMDINFER_ENABLE_TRACING
+  resp.setContext(std::move(call->context));
+#endif
+  call->client->runCallbackOnce(resp);
+#ifdef AMDINFER_ENABLE_METRICS
+  if (metrics_ != nullptr) {
+    metrics_->incrementCounter(MetricCounterIDs::PipelineEgressWorker);
+    metrics_->observeHistogram(MetricHistogramIDs::RequestLatency,
+                               util::elapsed<std::micro>(call->start_time));
+  }
+#endif
+}
+
+BatchPtr Remote::doRun(Batch* batch, [[maybe_unused]] const MemoryPool* pool) {
+  const auto hedging = hedge_delay_.count() > 0;
+  for (auto j = 0U; j < batch->size(); ++j) {
+    const auto& req = batch->getRequest(j);
+
+    auto call = std::make_shared<Call>();
+    call->client = req;
+    call->id = req->getID();
+    call->model = batch->getModel(j);
+    call->remote.setID(std::to_string(next_id_++));
+    call->remote.setParameters(req->getParameters());
+#ifdef AMDINFER_ENABLE_TRACING
+    if (const auto& trace = batch->getTrace(j); trace != nullptr) {
+      call->context = trace->propagate();
+    }
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+    call->start_time = batch->getTime(j);
+#endif
+
+    const auto& inputs = req->getInputs();
+#ifdef AMDINFER_ENABLE_RDMA
+    if (rdma_) {
+      size_t total = 0;
+      for (const auto& input : inputs) {
+        total += input.getSize() * input.getDatatype().size();
+      }
+      call->staged = this->stage(total);
+    }
+    if (call->staged != nullptr) {
+      // the peers read the inputs from the staging memory, which outlives
+      // every attempt of the call
+      auto offset = this->offsetOf(call->staged.get());
+      for (const auto& input : inputs) {
+        const auto size = input.getSize() * input.getDatatype().size();
+        std::memcpy(staging_.get() + offset, input.getData(), size);
+        InferenceRequestInput remote{nullptr, input.getShape(),
+                                     input.getDatatype(), input.getName()};
+        useSharedMemory(&remote, region_, offset);
+        call->remote.addInputTensor(std::move(remote));
+        offset += size;
+      }
+    }
+#endif
+
+    if (call->staged == nullptr) {
+      // the batch's memory is freed after this returns so a request that may
+      // be resent later keeps its own copy of the inputs
+      call->inputs.reserve(hedging ? inputs.size() : 0);
+      for (const auto& input : inputs) {
+        auto* data = input.getData();
+        if (hedging) {
+          const auto size = input.getSize() * input.getDatatype().size();
+          auto& copy = call->inputs.emplace_back(size);
+          std::memcpy(copy.data(), data, size);
+          data = copy.data();
+        }
+        call->remote.addInputTensor(data, input.getShape(),
+                                    input.getDatatype(), input.getName());
+      }
+    }
+
+    auto* connection = this->pick(nullptr);
+    call->peer = connection->peer;
+    this->send(call, connection);
+
+    if (hedging) {
+      const std::lock_guard lock{hedge_mutex_};
+      hedges_.emplace(std::chrono::steady_clock::now() + hedge_delay_,
+                      std::move(call));
+      hedge_cv_.notify_one();
+    }
+  }
+
+  // okay because ensembles disabled for this worker
+  return nullptr;
+}
+
+void Remote::hedge() {
+  util::setThreadName("RemoteHedge");
+
+  std::unique_lock lock{hedge_mutex_};
+  while (true) {
+    hedge_cv_.wait(lock, [this] { return stopping_ || !hedges_.empty(); });
+    if (stopping_) {
+      break;
+    }
+    // calls are queued in the order they were sent so the front is the next
+    // one to hedge
+    const auto deadline = hedges_.front().first;
+    if (hedge_cv_.wait_until(lock, deadline, [this] { return stopping_; })) {
+      break;
+    }
+    auto call = std::move(hedges_.front().second);
+    hedges_.pop();
+    if (call->done) {
+      continue;
+    }
+
+    lock.unlock();
+    auto* connection = this->pick(&call->peer);
+    if (connection != nullptr && connection->peer != call->peer) {
+      this->send(call, connection);
+    }
+    lock.lock();
+  }
+}
+
+void Remote::doRelease() {
+  {
+    const std::lock_guard lock{hedge_mutex_};
+    stopping_ = true;
+  }
+  hedge_cv_.notify_one();
+  if (hedger_.joinable()) {
+    hedger_.join();
+  }
+  hedges_ = {};
+
+  // closing waits for the responses to the requests already sent
+  for (const auto& connection : connections_) {
+    connection->stream.close();
+  }
+  connections_.clear();
+
+#ifdef AMDINFER_ENABLE_RDMA
+  for (auto i = 0U; i < sessions_.size(); ++i) {
+    try {
+      clients_[i * connections_per_peer_]->unregisterSystemSharedMemory(
+        region_);
+    } catch (const std::exception&) {
+      // the peer may be gone, which drops the region anyway
+    }
+  }
+  sessions_.clear();
+  staging_memory_.reset();
+  staging_.reset();
+  free_.clear();
+#endif
+  clients_.clear();
+}
+
+void Remote::doDestroy() {}
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::Remote("remote", "CPU", false);
+}
+}  // extern C
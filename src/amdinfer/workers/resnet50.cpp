@@ -137,13 +137,13 @@ BatchPtr ResNet50::doRun(Batch* batch, const MemoryPool* pool) {
   size_t tensor_count = 0;
   for (unsigned int j = 0; j < batch->size(); j++) {
     const auto& req = batch->getRequest(j);
-    auto inputs = req->getInputs();
+    const auto& inputs = req->getInputs();
 
     uint64_t input_size = 0;
-    for (auto& input : inputs) {
+    for (const auto& input : inputs) {
       auto* input_buffer = input.getData();
 
-      auto input_shape = input.getShape();
+      const auto& input_shape = input.getShape();
 
       input_size = util::containerProduct(input_shape);
 
@@ -173,7 +173,7 @@ BatchPtr ResNet50::doRun(Batch* batch, const MemoryPool* pool) {
   auto shape = out_data_descriptor[0]->get_tensor()->get_shape();
 
   int response_size = 0;
-  std::vector<int64_t> new_shape;
+  Shape new_shape;
   if (shape.size() > 1) {  // [batch, a, b, c]
     response_size = util::containerProduct(shape.begin() + 1, shape.end());
     // We exclude the batch size from the returned shape
@@ -28,10 +28,7 @@
 #include <ext/alloc_traits.h>      // for __alloc_traits<>::value...
 #include <future>                  // for future, future_status
 #include <memory>                  // for allocator, unique_ptr
-#include <opencv2/core.hpp>        // for Mat, Size
-#include <opencv2/imgcodecs.hpp>   // for imencode
-#include <opencv2/imgproc.hpp>     // for resize
-#include <opencv2/videoio.hpp>     // for VideoCapture, VideoCapt...
+#include <opencv2/core.hpp>        // for Mat
 #include <queue>                   // for queue
 #include <string>                  // for string, operator+, char...
 #include <thread>                  // for thread
@@ -43,31 +40,25 @@
 
 #include "amdinfer/batching/batcher.hpp"        // for BatchPtr, BatchPtrQueue
 #include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/bytes_tensor.hpp"       // for BytesView
 #include "amdinfer/core/data_types.hpp"         // for DataType, DataType::Bytes
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
 #include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "amdinfer/core/parameters.hpp"          // for ParameterMap
 #include "amdinfer/declarations.hpp"         // for BufferPtrs, InferenceRe...
 #include "amdinfer/observation/logging.hpp"  // for Logger
-#include "amdinfer/util/base64.hpp"          // for base64_encode
 #include "amdinfer/util/parse_env.hpp"       // for autoExpandEnvironmentVa...
 #include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/workers/worker.hpp"       // for Worker, kNumBufferAuto
+#include "amdinfer/workers/video_stream.hpp"  // for VideoStream
+#include "amdinfer/workers/worker.hpp"        // for Worker, kNumBufferAuto
 
 namespace AKS {  // NOLINT(readability-identifier-naming)
 class AIGraph;
 }  // namespace AKS
 
-using VidProps = cv::VideoCaptureProperties;
-
 namespace amdinfer {
 
-std::string constructMessage(const std::string& key, const std::string& data,
-                             const std::string& labels) {
-  return R"({"key": ")" + key + R"(", "data": {"img": ")" + data +
-         R"(", "labels": )" + labels + "}}";
-}
-
 namespace workers {
 
 /**
@@ -87,6 +78,10 @@ class ResNet50Stream : public SingleThreadedWorker {
   void doRelease() override;
   void doDestroy() override;
 
+  /// Stream one video to the client
+  void stream(InferenceRequest* req, const InferenceRequestInput* input) const;
+
+  VideoStreamOptions options_;
   AKS::SysManagerExt* sys_manager_ = nullptr;
   std::string graph_name_;
   AKS::AIGraph* graph_ = nullptr;
@@ -98,7 +93,7 @@ std::vector<MemoryAllocators> ResNet50Stream::getAllocators() const {
 
 void ResNet50Stream::doInit(ParameterMap* parameters) {
   constexpr auto kBatchSize = 4;
-  (void)parameters;  // suppress unused variable warning
+  options_ = getVideoStreamOptions(*parameters);
 
   /// Get AKS System Manager instance
   this->sys_manager_ = AKS::SysManagerExt::getGlobal();
@@ -144,174 +139,144 @@ void ResNet50Stream::doAcquire(ParameterMap* parameters) {
 
 BatchPtr ResNet50Stream::doRun(Batch* batch,
                                [[maybe_unused]] const MemoryPool* pool) {
-  std::shared_ptr<InferenceRequest> req;
+  // each video is decoded in its own pipeline so the videos of a batch are
+  // streamed concurrently
+  std::vector<std::thread> streams;
+  for (const auto& req : *batch) {
+    for (const auto& input : req->getInputs()) {
+      streams.emplace_back(&ResNet50Stream::stream, this, req.get(), &input);
+    }
+  }
+  for (auto& stream : streams) {
+    stream.join();
+  }
+
+  // okay because ensembles disabled for this worker
+  return nullptr;
+}
+
+void ResNet50Stream::stream(InferenceRequest* req,
+                            const InferenceRequestInput* input) const {
 #ifdef AMDINFER_ENABLE_LOGGING
   const auto& logger = this->getLogger();
 #endif
+  util::setThreadName("ResNet50Stream");
+  auto key = req->getParameters().get<std::string>("key");
+
+  // the first element is the path or URL of the video
+  const BytesView elements{input->getData(), input->getSize()};
+  std::string data{elements.empty() ? std::string_view{} : elements[0]};
+
+  // frames are downscaled to the model's input as they're decoded
+  auto options = options_;
+  try {
+    options.encoding = getFrameEncoding(req->getParameters());
+  } catch (const invalid_argument& e) {
+    AMDINFER_LOG_INFO(logger, e.what());
+    req->runCallbackError(e.what());
+    return;
+  }
+  const auto encoding = options.encoding;
+  options.width = kImageWidth;
+  options.height = kImageHeight;
+  VideoStream video{data, std::move(options)};
+  if (!video.isOpened()) {
+    const char* error = "Cannot open video file";
+    AMDINFER_LOG_ERROR(logger, error);
+    req->runCallbackError(error);
+    return;
+  }
 
-  for (const auto& req : *batch) {
-    auto inputs = req->getInputs();
-    auto outputs = req->getOutputs();
-    auto key = req->getParameters().get<std::string>("key");
-    for (auto& input : inputs) {
-      auto* input_buffer = input.getData();
-
-      const auto* idata = static_cast<char*>(input_buffer);
-      std::string data{idata, input.getSize()};
-
-      cv::VideoCapture cap(data);  // open the video file
-      if (!cap.isOpened()) {       // check if we succeeded
-        const char* error = "Cannot open video file";
-        AMDINFER_LOG_ERROR(logger, error);
-        req->runCallbackError(error);
-        continue;
-      }
-
-      InferenceResponse resp;
-      resp.setID(req->getID());
-      resp.setModel("aks_detect_stream");
+  // contains the number of frames in the video;
+  auto count = video.count();
+  if (input->getParameters().has("count")) {
+    auto requested_count = input->getParameters().get<int32_t>("count");
+    count = std::min(count, static_cast<size_t>(requested_count));
+  }
 
-      // contains the number of frames in the video;
-      auto count = static_cast<size_t>(cap.get(VidProps::CAP_PROP_FRAME_COUNT));
-      if (input.getParameters().has("count")) {
-        auto requested_count = input.getParameters().get<int32_t>("count");
-        count = std::min(count, static_cast<size_t>(requested_count));
+  std::string metadata = "[" + std::to_string(video.width()) + "," +
+                         std::to_string(video.height()) + "]";
+  const std::string model = "invert_video";
+  sendMessage(req, model, "key",
+              makeMetadataMessage(key, encoding, video.fps(), metadata),
+              encoding);
+
+  // round to nearest multiple of batch size
+  video.start(count - (count % this->batch_size_));
+
+  std::queue<std::future<std::vector<std::unique_ptr<vart::TensorBuffer>>>>
+    futures;
+  std::queue<std::string> frames;
+  uint64_t index = 0;
+  // send the labels of the oldest batch. A batch cut short by the end of the
+  // video has fewer frames than the batch size
+  auto send = [&]() {
+    auto out_data_descriptor = futures.front().get();
+    futures.pop();
+    const auto* top_k_data =
+      reinterpret_cast<int*>(out_data_descriptor[0]->data().first);
+    for (unsigned int i = 0; i < this->batch_size_ && !frames.empty(); i++) {
+      std::string labels = "[";
+      for (unsigned int j = 0; j < kResnetClassifications; j++) {
+        auto y = std::to_string(j * kBoxHeight);
+        auto label =
+          std::to_string(top_k_data[(i * kResnetClassifications) + j]);
+        labels.append(R"({"fill": true, "box": [0,)");
+        labels.append(y + ",");
+        labels.append(kImageWidthStr + ",");
+        labels.append(kBoxHeightStr + R"(], "label": ")");
+        labels.append(label + "\"},");
       }
-      double fps = cap.get(VidProps::CAP_PROP_FPS);
-      auto video_width = cap.get(VidProps::CAP_PROP_FRAME_WIDTH);
-      auto video_height = cap.get(VidProps::CAP_PROP_FRAME_HEIGHT);
-
-      InferenceResponseOutput output;
-      output.setName("key");
-      output.setDatatype(DataType::Bytes);
-      std::string metadata = "[" + std::to_string(video_width) + "," +
-                             std::to_string(video_height) + "]";
-      auto message = constructMessage(key, std::to_string(fps), metadata);
-      std::vector<std::byte> buffer;
-      buffer.resize(message.size());
-      memcpy(buffer.data(), message.data(), message.size());
-      output.setData(std::move(buffer));
-      output.setShape({static_cast<int64_t>(message.size())});
-      resp.addOutput(output);
-      req->runCallback(resp);
-      // round to nearest multiple of batch size
-      auto count_adjusted = count - (count % this->batch_size_);
-      std::queue<std::future<std::vector<std::unique_ptr<vart::TensorBuffer>>>>
-        futures;
-      std::queue<std::string> frames;
-      for (unsigned int num_frames = 0; num_frames < count_adjusted;
-           num_frames += this->batch_size_) {
-        std::vector<std::unique_ptr<vart::TensorBuffer>> v;
-        v.reserve(1);
-        v.emplace_back(std::make_unique<AKS::AksTensorBuffer>(
-          xir::Tensor::create("resnet-stream",
-                              {static_cast<int>(this->batch_size_),
-                               kImageHeight, kImageWidth, kImageChannels},
-                              xir::create_data_type<unsigned char>())));
-
-        for (size_t i = 0; i < this->batch_size_; i++) {
-          cv::Mat frame;
-          cap >> frame;  // get the next frame from video
-          // if (frame.empty()) {
-          //   continue;
-          // }
-          cv::resize(frame, frame, cv::Size(kImageWidth, kImageHeight));
-
-          memcpy(
-            reinterpret_cast<uint8_t*>(v[0]->data().first) + (i * kImageSize),
-            frame.data, kImageSize);
-
-          std::vector<unsigned char> buf;
-          cv::imencode(".jpg", frame, buf);
-          const auto* enc_msg = reinterpret_cast<const char*>(buf.data());
-          std::string encoded = util::base64Encode(enc_msg, buf.size());
-          frames.push("data:image/jpg;base64," + encoded);
-        }
-        futures.push(this->sys_manager_->enqueueJob(this->graph_, "",
-                                                    std::move(v), nullptr));
-        auto status = futures.front().wait_for(std::chrono::seconds(0));
-        if (status == std::future_status::ready) {
-          std::vector<std::unique_ptr<vart::TensorBuffer>> out_data_descriptor =
-            futures.front().get();
-          futures.pop();
-          int* top_k_data =
-            reinterpret_cast<int*>(out_data_descriptor[0]->data().first);
-          for (unsigned int i = 0; i < this->batch_size_; i++) {
-            std::string labels = "[";
-            for (unsigned int j = 0; j < kResnetClassifications; j++) {
-              auto y = std::to_string(j * kBoxHeight);
-              auto label =
-                std::to_string(top_k_data[(i * kResnetClassifications) + j]);
-              labels.append(R"({"fill": true, "box": [0,)");
-              labels.append(y + ",");
-              labels.append(kImageWidthStr + ",");
-              labels.append(kBoxHeightStr + R"(], "label": ")");
-              labels.append(label + "\"},");
-            }
-            labels.pop_back();  // trim trailing comma
-            labels += "]";
-            InferenceResponse resp;
-            resp.setID(req->getID());
-            resp.setModel("invert_video");
-
-            InferenceResponseOutput output;
-            output.setName("image");
-            output.setDatatype(DataType::Bytes);
-            auto message = constructMessage(key, frames.front(), labels);
-            std::vector<std::byte> buffer;
-            buffer.resize(message.size());
-            memcpy(buffer.data(), message.data(), message.size());
-            output.setData(std::move(buffer));
-            output.setShape({static_cast<int64_t>(message.size())});
-            resp.addOutput(output);
-            req->runCallback(resp);
-            frames.pop();
-          }
-        }
+      labels.pop_back();  // trim trailing comma
+      labels += "]";
+      auto message = makeFrameMessage(key, index++, encoding, frames.front(),
+                                      {kImageWidth, kImageHeight}, labels);
+      sendFrame(req, model, message, encoding);
+      frames.pop();
+    }
+  };
+
+  bool finished = false;
+  while (!finished) {
+    std::vector<std::unique_ptr<vart::TensorBuffer>> v;
+    v.reserve(1);
+    v.emplace_back(std::make_unique<AKS::AksTensorBuffer>(
+      xir::Tensor::create("resnet-stream",
+                          {static_cast<int>(this->batch_size_), kImageHeight,
+                           kImageWidth, kImageChannels},
+                          xir::create_data_type<unsigned char>())));
+
+    size_t frames_in_batch = 0;
+    for (; frames_in_batch < this->batch_size_; frames_in_batch++) {
+      auto* frame = video.next();
+      if (frame == nullptr) {
+        finished = true;
+        break;
       }
-      while (!futures.empty()) {
-        std::vector<std::unique_ptr<vart::TensorBuffer>> out_data_descriptor =
-          futures.front().get();
-        futures.pop();
-        int* top_k_data =
-          reinterpret_cast<int*>(out_data_descriptor[0]->data().first);
-        for (unsigned int i = 0; i < this->batch_size_; i++) {
-          std::string labels = "[";
-          for (unsigned int j = 0; j < kResnetClassifications; j++) {
-            auto y = std::to_string(j * kBoxHeight);
-            auto label =
-              std::to_string(top_k_data[(i * kResnetClassifications) + j]);
-            labels.append(R"({"fill": true, "box": [0,)");
-            labels.append(y + ",");
-            labels.append(kImageWidthStr + ",");
-            labels.append(kBoxHeightStr + R"(], "label": ")");
-            labels.append(label + "\"},");
-          }
-          labels.pop_back();  // trim trailing comma
-          labels += "]";
-          InferenceResponse resp;
-          resp.setID(req->getID());
-          resp.setModel("invert_video");
-
-          InferenceResponseOutput output;
-          output.setName("image");
-          output.setDatatype(DataType::Bytes);
-          auto message = constructMessage(key, frames.front(), labels);
-          std::vector<std::byte> buffer;
-          buffer.resize(message.size());
-          memcpy(buffer.data(), message.data(), message.size());
-          output.setData(std::move(buffer));
-          output.setShape({static_cast<int64_t>(message.size())});
-          resp.addOutput(output);
-          req->runCallback(resp);
-          frames.pop();
-        }
+      memcpy(reinterpret_cast<uint8_t*>(v[0]->data().first) +
+               (frames_in_batch * kImageSize),
+             frame->image.data, kImageSize);
+      frames.push(std::move(frame->encoded));
+      video.release(frame);
+    }
+    if (frames_in_batch == 0) {
+      break;
+    }
+
+    futures.push(
+      this->sys_manager_->enqueueJob(this->graph_, "", std::move(v), nullptr));
+    // send the labels of the batches that are done without waiting
+    while (futures.front().wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready) {
+      send();
+      if (futures.empty()) {
+        break;
       }
     }
   }
-
-  // okay because ensembles disabled for this worker
-  return nullptr;
+  while (!futures.empty()) {
+    send();
+  }
 }
 
 void ResNet50Stream::doRelease() {}
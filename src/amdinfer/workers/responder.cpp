@@ -21,7 +21,6 @@
 #include <cassert>  // for assert
 #include <cstddef>  // for size_t, byte
 #include <cstdint>  // for uint32_t, int32_t
-#include <cstring>  // for memcpy
 #include <memory>   // for unique_ptr, allocator
 #include <ratio>    // for micro
 #include <string>   // for string
@@ -31,6 +30,7 @@
 
 #include "amdinfer/batching/hard.hpp"    // for HardBatcher
 #include "amdinfer/build_options.hpp"    // for AMDINFER_ENABLE_TRACING
+#include "amdinfer/core/completion_router.hpp"  // for CompletionRouter
 #include "amdinfer/core/data_types.hpp"  // for DataType, DataType::Uint32
 #include "amdinfer/core/inference_request.hpp"  // for InferenceRequest, Infe...
 #include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
@@ -42,7 +42,7 @@
 #include "amdinfer/util/containers.hpp"      // for containerSum
 #include "amdinfer/util/queue.hpp"           // for BufferPtrsQueue
 #include "amdinfer/util/thread.hpp"          // for setThreadName
-#include "amdinfer/util/timer.hpp"           // for Timer
+#include "amdinfer/util/timestamps.hpp"      // for elapsed, now
 #include "amdinfer/workers/worker.hpp"       // for Worker
 
 namespace amdinfer::workers {
@@ -55,6 +55,8 @@ class Responder : public SingleThreadedWorker {
  public:
   using SingleThreadedWorker::SingleThreadedWorker;
   [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  // responding only views the inputs so it's cheaper than a thread hop
+  [[nodiscard]] bool isInlineSafe() const override { return true; }
 
  private:
   void doInit(ParameterMap* parameters) override;
@@ -97,14 +99,19 @@ void Responder::doAcquire([[maybe_unused]] ParameterMap* parameters) {
 BatchPtr Responder::doRun(Batch* batch,
                           [[maybe_unused]] const MemoryPool* pool) {
   const auto batch_size = batch->size();
+  // the outputs view the inputs' memory instead of copying it. The memory is
+  // returned to the pool after every response has been sent
+  const auto inputs_owner = batch->shareInputBuffers();
+  // the responses are serialized on the threads that received the requests
+  CompletionRouter router;
   for (unsigned int j = 0; j < batch_size; j++) {
     const auto& req = batch->getRequest(j);
 
     InferenceResponse resp;
     resp.setID(req->getID());
     resp.setModel(batch->getModel(j));
-    auto inputs = req->getInputs();
-    auto outputs = req->getOutputs();
+    const auto& inputs = req->getInputs();
+    const auto& outputs = req->getOutputs();
     for (unsigned int i = 0; i < inputs.size(); i++) {
       const auto& input = inputs[i];
       const auto* input_buffer = input.getData();
@@ -122,32 +129,34 @@ BatchPtr Responder::doRun(Batch* batch,
         output.setName(output_name);
       }
       output.setShape(input.getShape());
-      std::vector<std::byte> buffer;
       const auto size = input.getSize() * input.getDatatype().size();
-      buffer.resize(size);
-      memcpy(buffer.data(), input_buffer, size);
-      output.setData(std::move(buffer));
-      resp.addOutput(output);
+      output.setData(input_buffer, size, inputs_owner);
+      resp.addOutput(std::move(output));
     }
 
 #ifdef AMDINFER_ENABLE_TRACING
-    const auto& trace = batch->getTrace(j);
-    auto context = trace->propagate();
-    resp.setContext(std::move(context));
+    if (const auto& trace = batch->getTrace(j); trace != nullptr) {
+      resp.setContext(trace->propagate());
+    }
 #endif
 
     // respond back to the client
-    req->runCallbackOnce(resp);
 #ifdef AMDINFER_ENABLE_METRICS
-    Metrics::getInstance().incrementCounter(
-      MetricCounterIDs::PipelineEgressWorker);
-    util::Timer timer{batch->getTime(j)};
-    timer.stop();
-    auto duration = timer.count<std::micro>();
-    Metrics::getInstance().observeSummary(MetricSummaryIDs::RequestLatency,
-                                          duration);
+    const auto respond_start = util::now();
+#endif
+    router.add(req.get(), std::move(resp));
+#ifdef AMDINFER_ENABLE_METRICS
+    // count the request for the endpoint that batched it
+    if (auto* metrics = batch->getMetrics(); metrics != nullptr) {
+      metrics->observeDuration(MetricHistogramIDs::StageRespond,
+                               util::now() - respond_start);
+      metrics->incrementCounter(MetricCounterIDs::PipelineEgressWorker);
+      metrics->observeHistogram(MetricHistogramIDs::RequestLatency,
+                                util::elapsed<std::micro>(batch->getTime(j)));
+    }
 #endif
   }
+  router.flush();
   // okay because ensembles disabled for this worker
   return nullptr;
 }
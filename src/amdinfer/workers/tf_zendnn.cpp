@@ -19,29 +19,34 @@
 
 #include <dlfcn.h>               // for dlerror, dlopen, dlsym, RTLD...
 #include <tensorflow/c/c_api.h>  // for TF_Version
+#include <tensorflow/core/framework/allocation_description.pb.h>  // for All...
+#include <tensorflow/core/framework/allocator.h>  // for Allocator
 #include <tensorflow/core/framework/graph.pb.h>         // for GraphDef
 #include <tensorflow/core/framework/tensor.h>           // for Tensor
 #include <tensorflow/core/framework/tensor_shape.h>     // for TensorShape
 #include <tensorflow/core/framework/tensor_shape.pb.h>  // for tensorflow
 #include <tensorflow/core/framework/tensor_types.h>     // for TTypes<>::Flat
 #include <tensorflow/core/framework/types.pb.h>         // for DT_FLOAT
-#include <tensorflow/core/platform/env.h>               // for ReadBinaryProto
 #include <tensorflow/core/platform/status.h>            // for Status
 #include <tensorflow/core/protobuf/config.pb.h>         // for ConfigProto
+#include <tensorflow/core/protobuf/rewriter_config.pb.h>  // for RewriterCo...
 #include <tensorflow/core/public/session.h>             // for NewSession
 #include <tensorflow/core/public/session_options.h>     // for SessionOptions
 
-#include <algorithm>  // for copy, max
-#include <cassert>    // for assert
-#include <cstddef>    // for size_t, byte
-#include <cstdint>    // for int32_t, uint...
-#include <cstring>    // for memcpy
-#include <memory>     // for allocator
-#include <ratio>      // for micro, milli
-#include <string>     // for string, opera...
-#include <thread>     // for thread
-#include <utility>    // for pair, move
-#include <vector>     // for vector
+#include <algorithm>   // for copy, max
+#include <cassert>     // for assert
+#include <cstddef>     // for size_t, byte
+#include <cstdint>     // for int32_t, uintptr_t
+#include <cstring>     // for memcpy
+#include <filesystem>  // for path
+#include <limits>      // for numeric_limits
+#include <memory>      // for allocator
+#include <ratio>       // for micro, milli
+#include <string>      // for string, opera...
+#include <thread>      // for thread
+#include <tuple>       // for ignore
+#include <utility>     // for pair, move
+#include <vector>      // for vector
 
 #include "amdinfer/batching/hard.hpp"            // for Batch, BatchP...
 #include "amdinfer/build_options.hpp"            // for AMDINFER_ENABL...
@@ -53,9 +58,11 @@
 #include "amdinfer/declarations.hpp"             // for InferenceResp...
 #include "amdinfer/observation/logging.hpp"      // for Logger, PROTE...
 #include "amdinfer/observation/metrics.hpp"      // for Metrics, Metr...
+#include "amdinfer/util/filesystem.hpp"          // for MappedFile
 #include "amdinfer/util/memory.hpp"              // for copy
+#include "amdinfer/util/numa.hpp"                // for bindThreadToCpus
 #include "amdinfer/util/thread.hpp"              // for setThreadName
-#include "amdinfer/util/timer.hpp"               // for Timer
+#include "amdinfer/util/timestamps.hpp"          // for elapsed, now
 #include "amdinfer/workers/worker.hpp"           // for Worker, kNumB...
 
 namespace tf = ::tensorflow;
@@ -87,6 +94,8 @@ class TfZendnn : public SingleThreadedWorker {
            bool allow_next);
   // using SingleThreadedWorker::SingleThreadedWorker;
   [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
   ~TfZendnn() override;
 
  private:
@@ -96,6 +105,20 @@ class TfZendnn : public SingleThreadedWorker {
   void doRelease() override;
   void doDestroy() override;
 
+  /// The metadata's input shapes include the batch size
+  [[nodiscard]] std::vector<Tensor> getWarmupInputs() const override {
+    return dropBatchDimension(metadata_.getInputs());
+  }
+
+  /**
+   * @brief Get the batch's inputs as a TF tensor. Contiguous batches are used
+   * in place if they're aligned for TF and copied into a new tensor otherwise.
+   *
+   * @param batch the batch
+   * @return tf::Tensor
+   */
+  tf::Tensor wrapInputs(Batch* batch) const;
+
   // handles must be the first member variable so the TF libraries can be loaded
   // and saved before attempting to create the other members
   std::vector<void*> handles_;
@@ -104,6 +127,10 @@ class TfZendnn : public SingleThreadedWorker {
   tf::Session* session_ = nullptr;
   tf::GraphDef graph_def_;
   tf::Status status_;
+  // the input node is fed and the output node fetched by this callable, which
+  // is made once at load so runs don't resolve the names again
+  tf::Session::CallableHandle callable_ = 0;
+  bool has_callable_ = false;
 
   // Image properties
   unsigned int output_classes_ = kResNetOutputClasses;
@@ -116,6 +143,30 @@ class TfZendnn : public SingleThreadedWorker {
   std::string input_node_{"input"};
   std::string output_node_{"predict"};
   DataType input_dt_ = DataType::Fp32;
+  // precision to run the model at: native, bf16 or int8
+  std::string precision_;
+};
+
+/**
+ * @brief Lends memory owned by someone else to a TF tensor. The owner must keep
+ * it alive while the tensor is used.
+ */
+class BorrowedBuffer : public tf::TensorBuffer {
+ public:
+  BorrowedBuffer(void* data, size_t size)
+    : tf::TensorBuffer(data), size_(size) {}
+
+  [[nodiscard]] size_t size() const override { return size_; }
+  tf::TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(
+    tf::AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64_t>(size_));
+    proto->set_allocator_name("amdinfer");
+  }
+  [[nodiscard]] bool OwnsMemory() const override { return false; }
+
+ private:
+  size_t size_;
 };
 
 std::vector<void*> saveHandles() {
@@ -152,6 +203,13 @@ std::vector<MemoryAllocators> TfZendnn::getAllocators() const {
   return {MemoryAllocators::Cpu};
 }
 
+std::vector<MemoryReservation> TfZendnn::getReservations() const {
+  Tensor input{
+    "input", {image_height_, image_width_, image_channels_}, input_dt_};
+  Tensor output{"output", {output_classes_}, DataType::Fp32};
+  return this->reserveBatches({input}, {output});
+}
+
 void TfZendnn::doInit(ParameterMap* parameters) {
   const auto default_batch_size = 1;
 
@@ -183,6 +241,8 @@ void TfZendnn::doInit(ParameterMap* parameters) {
     output_node_ = parameters->get<std::string>("output_node");
   }
 
+  precision_ = getCpuPrecision(*parameters);
+
   std::string logmsg =
     "TensorFlow C/C++ library version: " + std::string(TF_Version());
 #ifdef AMDINFER_ENABLE_LOGGING
@@ -209,39 +269,93 @@ void TfZendnn::doAcquire(ParameterMap* parameters) {
   if (parameters->has("inter_op")) {
     inter_op = parameters->get<int>("inter_op");
   }
-  auto intra_op = default_intra_op;
+  // pinned workers get their own thread pools on their CPUs with one
+  // intra-op thread per CPU by default
+  const auto cpus = getPinnedCpus(*parameters);
+  if (!cpus.empty()) {
+    config.set_use_per_session_threads(true);
+  }
+  auto intra_op = cpus.empty() ? default_intra_op
+                               : static_cast<unsigned int>(cpus.size());
   if (parameters->has("intra_op")) {
-    inter_op = parameters->get<int>("intra_op");
+    intra_op = parameters->get<int>("intra_op");
   }
   config.set_intra_op_parallelism_threads(intra_op);
   config.set_inter_op_parallelism_threads(inter_op);
 
-  // Start a new session
-  status_ = tf::NewSession(options, &(this->session_));
+  // fold constants and simplify the graph once when the callable is made
+  auto* graph_options = config.mutable_graph_options();
+  graph_options->mutable_optimizer_options()->set_opt_level(
+    tf::OptimizerOptions::L1);
+  auto* rewrite_options = graph_options->mutable_rewrite_options();
+  rewrite_options->set_constant_folding(tf::RewriterConfig::ON);
+  rewrite_options->set_arithmetic_optimization(tf::RewriterConfig::ON);
+  rewrite_options->set_remapping(tf::RewriterConfig::ON);
+  // rewrite the ops that oneDNN supports in bf16 to run in bf16
+  if (precision_ == "bf16") {
+    rewrite_options->set_auto_mixed_precision_onednn_bfloat16(
+      tf::RewriterConfig::ON);
+  }
+
+  // Start a new session. Its threads are started here so they inherit the
+  // CPUs of this thread
+  const auto loading_cpus = util::getThreadCpus();
+  util::bindThreadToCpus(cpus);
+  status_ = this->timeLoadPhase(LoadPhase::CreateRunner, [&]() {
+    return tf::NewSession(options, &(this->session_));
+  });
+  util::bindThreadToCpus(loading_cpus);
   if (!status_.ok()) {
     throw external_error("Could not initialize a tensorflow session");
   }
   AMDINFER_LOG_INFO(logger, "New TF Session Initiated");
 
   // Load the model
-  std::string path;
+  std::filesystem::path path;
   if (parameters->has("model")) {
     path = parameters->get<std::string>("model");
   } else {
     throw invalid_argument("Model not provided in load-time parameters");
   }
+  // int8 graphs are quantized and calibrated ahead of time with the ZenDNN
+  // quantization tools
+  if (precision_ == "int8") {
+    path = getQuantizedModel(path, precision_);
+  }
 
-  status_ = tf::ReadBinaryProto(tf::Env::Default(), path, &graph_def_);
-  if (!status_.ok()) {
+  // the graph is parsed straight from the mapped file instead of being read
+  // through a stream. Protobuf can't parse messages of 2 GB or more
+  const auto parsed = this->timeLoadPhase(LoadPhase::ReadModel, [&]() {
+    const util::MappedFile file{path};
+    const auto size = file.size();
+    return size <= static_cast<size_t>(std::numeric_limits<int>::max()) &&
+           graph_def_.ParseFromArray(file.data(), static_cast<int>(size));
+  });
+  if (!parsed) {
     throw external_error("Could not load model with tensorflow");
   }
   AMDINFER_LOG_INFO(logger, "Reading Model");
 
   // Add the graph to the session
-  status_ = this->session_->Create(graph_def_);
+  status_ = this->timeLoadPhase(LoadPhase::Compile, [&]() {
+    return this->session_->Create(graph_def_);
+  });
   if (!status_.ok()) {
     throw external_error("Could not load the model to session");
   }
+
+  tf::CallableOptions callable_options;
+  callable_options.add_feed(input_node_);
+  callable_options.add_fetch(output_node_);
+  // the graph is optimized when the callable is made
+  status_ = this->timeLoadPhase(LoadPhase::Compile, [&]() {
+    return this->session_->MakeCallable(callable_options, &callable_);
+  });
+  if (!status_.ok()) {
+    throw external_error("Could not bind the input and output nodes: " +
+                         status_.ToString());
+  }
+  has_callable_ = true;
   AMDINFER_LOG_INFO(logger, "TF Session Created, Ready for prediction");
 
   // Adding metadata for input and output
@@ -253,63 +367,74 @@ void TfZendnn::doAcquire(ParameterMap* parameters) {
   this->metadata_.setName("TfZendnn");
 }
 
+tf::Tensor TfZendnn::wrapInputs(Batch* batch) const {
+  const tf::TensorShape shape(
+    {static_cast<int64_t>(batch->size()), image_height_, image_width_,
+     image_channels_});
+  const auto request_bytes = image_size_ * input_dt_.size();
+
+  // the batcher already packed the inputs into one buffer, which TF can use in
+  // place if it's aligned for its kernels
+  if (!batch->isScatterGather()) {
+    auto* data = batch->getInputBuffers().front()->data(0);
+    const auto address = reinterpret_cast<uintptr_t>(data);
+    if (address % tf::Allocator::kAllocatorAlignment == 0) {
+      auto* buffer = new BorrowedBuffer(data, request_bytes * batch->size());
+      tf::Tensor tensor(tf::DT_FLOAT, shape, buffer);
+      // the tensor holds its own reference to the buffer
+      buffer->Unref();
+      return tensor;
+    }
+  }
+
+  tf::Tensor tensor(tf::DT_FLOAT, shape);
+  auto* data = static_cast<std::byte*>(tensor.data());
+  for (const auto& request : *batch) {
+    data = util::copy(request->getInputs().front().getData(), data,
+                      request_bytes);
+  }
+  return tensor;
+}
+
 BatchPtr TfZendnn::doRun(Batch* batch, const MemoryPool* pool) {
 #ifdef AMDINFER_ENABLE_LOGGING
   const auto& logger = this->getLogger();
 #endif
 
-  util::Timer timer{true};
-
-  // Find total number of images to initialize for TF tensor
   auto tensor_count = static_cast<int>(batch->size());
 
-  // Initialize a TensorFlow tensor with required shape
-  tf::Tensor input_tensor(
-    tf::DT_FLOAT, tf::TensorShape({tensor_count, image_height_, image_width_,
-                                   image_channels_}));
-
-  uint64_t input_size = image_height_ * image_width_ * image_channels_;
-  size_t vec_size = 0;
-
-  for (unsigned int j = 0; j < batch->size(); j++) {
-    const auto& req = batch->getRequest(j);
-
-    auto inputs = req->getInputs();
-    auto outputs = req->getOutputs();
-    AMDINFER_LOG_DEBUG(logger,
-                       "Size of input: " + std::to_string(inputs.size()));
-
-    // Get all the inputs from the requests and copy to the TensorFlow tensor
-    for (auto& input : inputs) {
-      auto* input_buffer = input.getData();
-      const auto* float_buffer = static_cast<float*>(input_buffer);
-      std::copy(float_buffer, float_buffer + input_size,
-                input_tensor.flat<float>().data() + vec_size);
-      vec_size = vec_size + input_size;
+  // every request must fill exactly one slot of the batch's input tensor
+  for (const auto& request : *batch) {
+    const auto& inputs = request->getInputs();
+    if (inputs.empty() || inputs.front().getSize() != image_size_) {
+      const auto error = "Input size doesn't match the model's input of " +
+                         std::to_string(image_size_) + " elements";
+      AMDINFER_LOG_ERROR(logger, error);
+      for (const auto& req : *batch) {
+        req->runCallbackError(error);
+      }
+      return nullptr;
     }
   }
 
-  AMDINFER_LOG_DEBUG(logger, input_tensor.DebugString());
-
-  // Create the inputs and output tensor
-  std::vector<std::pair<std::string, tf::Tensor>> input_pair = {
-    {input_node_, input_tensor}};
-  std::vector<tensorflow::Tensor> output_tensor;
+  std::vector<tf::Tensor> feeds{this->wrapInputs(batch)};
+  AMDINFER_LOG_DEBUG(logger, feeds[0].DebugString());
+  std::vector<tf::Tensor> output_tensor;
 
   // Run the session to get the predictions
-  timer.add("infer_start");
-  status_ = this->session_->Run(input_pair, {output_node_}, {}, &output_tensor);
-  timer.add("infer_stop");
-  [[maybe_unused]] auto duration =
-    timer.count<std::milli>("infer_start", "infer_stop");
+  const auto infer_start = util::now();
+  auto status =
+    this->session_->RunCallable(callable_, feeds, &output_tensor, nullptr);
+  [[maybe_unused]] auto duration = util::elapsed<std::milli>(infer_start);
   AMDINFER_LOG_INFO(logger, "Time taken for " + std::to_string(tensor_count) +
                               " images: " + std::to_string(duration));
 
-  if (!status_.ok()) {
-    AMDINFER_LOG_ERROR(logger, status_.ToString());
+  if (!status.ok()) {
+    AMDINFER_LOG_ERROR(logger, status.ToString());
     for (const auto& req : *batch) {
       req->runCallbackError("Issue with prediction");
     }
+    return nullptr;
   }
   AMDINFER_LOG_DEBUG(logger, output_tensor[0].DebugString());
 
@@ -323,6 +448,12 @@ BatchPtr TfZendnn::doRun(Batch* batch, const MemoryPool* pool) {
                                     Tensor{"name", new_shape, DataType::Fp32},
                                     batch->size()));
 
+  // TF allocates the outputs of a callable so they're copied once into the
+  // next stage's buffer
+  util::copy(output_tensor[0].flat<float>().data(),
+             static_cast<std::byte*>(input_buffers.at(0)->data(0)),
+             batch->size() * response_size * sizeof(float));
+
   for (unsigned int k = 0; k < batch->size(); k++) {
     const auto& req = batch->getRequest(k);
 
@@ -331,9 +462,6 @@ BatchPtr TfZendnn::doRun(Batch* batch, const MemoryPool* pool) {
       input_buffers.at(0)->data(k * response_size * DataType("Fp32").size());
     new_request->addInputTensor(
       InferenceRequestInput{data_ptr, new_shape, DataType::Fp32, ""});
-    util::copy(output_tensor[0].flat<float>().data() + (k * response_size),
-               static_cast<std::byte*>(data_ptr),
-               response_size * sizeof(float));
 
     new_batch->addRequest(new_request);
 
@@ -345,6 +473,10 @@ BatchPtr TfZendnn::doRun(Batch* batch, const MemoryPool* pool) {
 }
 
 void TfZendnn::doRelease() {
+  if (has_callable_) {
+    std::ignore = this->session_->ReleaseCallable(callable_);
+    has_callable_ = false;
+  }
   auto retval = this->session_->Close();
   assert(retval.ok());
 }
@@ -0,0 +1,353 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the Tokenizer worker
+ */
+
+#include <algorithm>    // for max, min, sort, lower_bound, fill_n
+#include <cstddef>      // for size_t, byte
+#include <cstdint>      // for int32_t, int64_t
+#include <exception>    // for exception
+#include <memory>       // for unique_ptr, make_unique
+#include <optional>     // for optional
+#include <string>       // for string, stoi
+#include <string_view>  // for string_view
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/bytes_tensor.hpp"        // for BytesView
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/declarations.hpp"             // for BufferPtr
+#include "amdinfer/observation/logging.hpp"      // for Logger
+#include "amdinfer/pre_post/tokenize.hpp"        // for Tokenizer, Vocabulary
+#include "amdinfer/util/filesystem.hpp"          // for MappedFile
+#include "amdinfer/util/string.hpp"              // for split
+#include "amdinfer/workers/worker.hpp"           // for MultiThreadedWorker
+
+namespace amdinfer::workers {
+
+namespace {
+
+std::string_view getText(const util::MappedFile& file) {
+  return {reinterpret_cast<const char*>(file.data()), file.size()};
+}
+
+/// Parse a comma-separated list of sequence lengths into ascending order
+std::vector<int64_t> parseLengths(const std::string& values) {
+  std::vector<int64_t> lengths;
+  for (const auto& item : util::split(values, ",")) {
+    try {
+      lengths.push_back(std::stoi(item));
+    } catch (const std::exception&) {
+      throw invalid_argument("Invalid sequence length: " + item);
+    }
+  }
+  std::sort(lengths.begin(), lengths.end());
+  return lengths;
+}
+
+/// Write the tokens of one sequence and its padding as the given type
+template <typename T>
+void writeSequence(const std::vector<int32_t>& ids, int32_t pad, bool segments,
+                   size_t length, std::vector<void*>* outputs, size_t index) {
+  const auto used = std::min(ids.size(), length);
+  auto* input_ids = static_cast<T*>(outputs->at(0)) + index * length;
+  auto* mask = static_cast<T*>(outputs->at(1)) + index * length;
+  for (size_t i = 0; i < length; ++i) {
+    input_ids[i] = i < used ? ids[i] : pad;
+    mask[i] = i < used ? 1 : 0;
+  }
+  if (segments) {
+    std::fill_n(static_cast<T*>(outputs->at(2)) + index * length, length, 0);
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief The Tokenizer worker turns text sent as BYTES tensors into the token
+ * IDs and attention masks of text models like BERT with the WordPiece or BPE
+ * algorithms. It's meant to be chained in front of the model with the "next"
+ * load-time parameter so clients send text instead of tokens. The vocabulary
+ * is memory-mapped once and the tokens are written straight into the pooled
+ * buffers of the next worker's batch, padded to a fixed length or to the
+ * shortest allowed length that fits the batch.
+ *
+ */
+class Tokenizer : public MultiThreadedWorker {
+ public:
+  using MultiThreadedWorker::MultiThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// Get the tensors of one request's outputs padded to a length
+  [[nodiscard]] std::vector<Tensor> getOutputTensors(int64_t length) const;
+  /// Get the length to pad a batch to from its longest sequence
+  [[nodiscard]] int64_t getLength(size_t longest) const;
+
+  // the tokenizers view the mapped files so they're declared first
+  std::optional<util::MappedFile> vocabulary_file_;
+  std::optional<util::MappedFile> merges_file_;
+  pre_post::Vocabulary vocabulary_;
+  std::unique_ptr<pre_post::Tokenizer> tokenizer_;
+
+  // the allowed lengths of the outputs in ascending order
+  std::vector<int64_t> lengths_{kSequenceLength};
+  std::vector<std::string> output_names_{"input_ids", "attention_mask"};
+  DataType datatype_ = DataType::Int64;
+  // IDs of the special tokens or -1 to not add them
+  int32_t start_id_ = -1;
+  int32_t end_id_ = -1;
+  int32_t pad_id_ = 0;
+  int32_t threads_ = 1;
+  // CPUs the worker is pinned to
+  std::vector<int> cpus_;
+
+  static constexpr int64_t kSequenceLength = 128;
+};
+
+std::vector<MemoryAllocators> Tokenizer::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> Tokenizer::getReservations() const {
+  // the text varies in size so only the longest outputs are reserved
+  return this->reserveBatches({}, this->getOutputTensors(lengths_.back()));
+}
+
+std::vector<Tensor> Tokenizer::getOutputTensors(int64_t length) const {
+  std::vector<Tensor> tensors;
+  tensors.reserve(output_names_.size());
+  for (const auto& name : output_names_) {
+    tensors.emplace_back(name, std::vector<int64_t>{length}, datatype_);
+  }
+  return tensors;
+}
+
+int64_t Tokenizer::getLength(size_t longest) const {
+  const auto it = std::lower_bound(lengths_.begin(), lengths_.end(),
+                                   static_cast<int64_t>(longest));
+  // longer sequences are cut to the longest length
+  return it == lengths_.end() ? lengths_.back() : *it;
+}
+
+void Tokenizer::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  if (!parameters->has("vocab")) {
+    throw invalid_argument("Tokenizer needs the path to a vocab file");
+  }
+  vocabulary_file_.emplace(parameters->get<std::string>("vocab"));
+  vocabulary_ = pre_post::Vocabulary{getText(*vocabulary_file_)};
+
+  // WordPiece is used unless merges are given for BPE
+  const auto bpe = parameters->has("merges");
+  auto get = [parameters](const std::string& key, std::string value) {
+    if (parameters->has(key)) {
+      value = parameters->get<std::string>(key);
+    }
+    return value;
+  };
+  auto lower = !bpe;
+  if (parameters->has("lower_case")) {
+    lower = parameters->get<bool>("lower_case");
+  }
+  const auto unknown = get("unknown_token", bpe ? "<unk>" : "[UNK]");
+  if (bpe) {
+    merges_file_.emplace(parameters->get<std::string>("merges"));
+    tokenizer_ = std::make_unique<pre_post::BpeTokenizer>(
+      &vocabulary_, getText(*merges_file_), unknown, lower, get("suffix", ""));
+  } else {
+    tokenizer_ = std::make_unique<pre_post::WordPieceTokenizer>(
+      &vocabulary_, unknown, lower, get("prefix", "##"));
+  }
+
+  const auto start = get("start_token", bpe ? "" : "[CLS]");
+  start_id_ = start.empty() ? -1 : vocabulary_.at(start);
+  const auto end = get("end_token", bpe ? "" : "[SEP]");
+  end_id_ = end.empty() ? -1 : vocabulary_.at(end);
+  // models that mask the padding out don't need a padding token
+  const auto pad = get("pad_token", bpe ? "<pad>" : "[PAD]");
+  pad_id_ = std::max(vocabulary_.find(pad), 0);
+
+  if (parameters->has("sequence_length")) {
+    lengths_ = {parameters->get<int32_t>("sequence_length")};
+  }
+  if (parameters->has("lengths")) {
+    lengths_ = parseLengths(parameters->get<std::string>("lengths"));
+  }
+  if (lengths_.empty() || lengths_.front() < 2) {
+    throw invalid_argument("Sequence lengths must be at least 2");
+  }
+
+  if (parameters->has("outputs")) {
+    output_names_ = util::split(parameters->get<std::string>("outputs"), ",");
+  }
+  if (output_names_.size() != 2 && output_names_.size() != 3) {
+    throw invalid_argument(
+      "outputs must name the token IDs, the attention mask and optionally the "
+      "segment IDs");
+  }
+
+  if (parameters->has("datatype")) {
+    datatype_ = DataType(parameters->get<std::string>("datatype").c_str());
+  }
+  if (datatype_ != DataType::Int64 && datatype_ != DataType::Int32) {
+    throw invalid_argument("The datatype must be INT64 or INT32");
+  }
+
+  if (parameters->has("threads")) {
+    threads_ = parameters->get<int32_t>("threads");
+  }
+  if (threads_ < 1) {
+    throw invalid_argument("There must be at least one thread");
+  }
+  cpus_ = getPinnedCpus(*parameters);
+}
+
+void Tokenizer::doAcquire([[maybe_unused]] ParameterMap* parameters) {
+  this->metadata_.addInputTensor(Tensor{"input", {-1}, DataType::Bytes});
+  for (const auto& tensor : this->getOutputTensors(lengths_.back())) {
+    this->metadata_.addOutputTensor(tensor);
+  }
+  this->metadata_.setName("Tokenizer");
+
+  this->createThreadPool(threads_, cpus_);
+}
+
+BatchPtr Tokenizer::doRun(Batch* batch, const MemoryPool* pool) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  const auto batch_size = batch->size();
+
+  // the whole batch is tokenized first to find the length to pad it to.
+  // Requests with bad inputs are failed and get no tokens
+  pre_post::Tokenizer::State state;
+  std::vector<std::vector<int32_t>> sequences(batch_size);
+  std::vector<bool> failed(batch_size, false);
+  size_t longest = 0;
+  for (auto j = 0U; j < batch_size; ++j) {
+    const auto& request = batch->getRequest(j);
+    try {
+      const auto& inputs = request->getInputs();
+      if (inputs.size() != 1 || inputs[0].getDatatype() != DataType::Bytes) {
+        throw invalid_argument("Tokenizer takes one BYTES input tensor");
+      }
+      const BytesView elements{inputs[0].getData(), inputs[0].getSize()};
+      if (elements.size() != 1) {
+        throw invalid_argument("Tokenizer takes one string per request");
+      }
+
+      auto& ids = sequences[j];
+      if (start_id_ >= 0) {
+        ids.push_back(start_id_);
+      }
+      tokenizer_->encode(elements[0], &state, &ids);
+      const auto limit = static_cast<size_t>(lengths_.back());
+      if (end_id_ >= 0) {
+        // truncated sequences keep their end token
+        ids.resize(std::min(ids.size(), limit - 1));
+        ids.push_back(end_id_);
+      }
+      longest = std::max(longest, ids.size());
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger, e.what());
+      request->runCallbackError(e.what());
+      failed[j] = true;
+    }
+  }
+
+  const auto length = this->getLength(longest);
+  const auto tensors = this->getOutputTensors(length);
+  std::vector<BufferPtr> input_buffers;
+  std::vector<void*> outputs;
+  for (const auto& tensor : tensors) {
+    input_buffers.push_back(pool->get(next_allocators_, tensor, batch_size));
+    outputs.push_back(input_buffers.back()->data(0));
+  }
+
+  const auto segments = tensors.size() == 3;
+  const auto size = static_cast<size_t>(length);
+  auto new_batch = batch->propagate();
+  for (auto j = 0U; j < batch_size; ++j) {
+    if (datatype_ == DataType::Int64) {
+      writeSequence<int64_t>(sequences[j], pad_id_, segments, size, &outputs,
+                             j);
+    } else {
+      writeSequence<int32_t>(sequences[j], pad_id_, segments, size, &outputs,
+                             j);
+    }
+
+    auto new_request = batch->getRequest(j)->propagate();
+    if (failed[j]) {
+      // the slot stays in the batch to keep it aligned with the requests so
+      // later stages run it without responding again
+      new_request->setCallback([](const InferenceResponse&) {});
+    }
+    const auto offset = j * size * datatype_.size();
+    for (auto i = 0U; i < tensors.size(); ++i) {
+      const auto& tensor = tensors[i];
+      new_request->addInputTensor(InferenceRequestInput{
+        static_cast<std::byte*>(outputs[i]) + offset, tensor.getShape(),
+        datatype_, tensor.getName()});
+    }
+    new_batch->addRequest(new_request);
+    new_batch->setModel(j, "Tokenizer");
+  }
+  new_batch->setBuffers(std::move(input_buffers), {});
+
+  return new_batch;
+}
+
+void Tokenizer::doRelease() { this->destroyThreadPool(); }
+
+void Tokenizer::doDestroy() {
+  tokenizer_.reset();
+  vocabulary_ = pre_post::Vocabulary{};
+  merges_file_.reset();
+  vocabulary_file_.reset();
+}
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::Tokenizer("Tokenizer", "CPU", true);
+}
+}  // extern C
@@ -0,0 +1,241 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the TopK worker
+ */
+
+#include <algorithm>  // for fill_n
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int32_t, int64_t
+#include <exception>  // for exception
+#include <memory>     // for allocator
+#include <string>     // for string, to_string
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/declarations.hpp"             // for BufferPtr
+#include "amdinfer/observation/logging.hpp"      // for Logger
+#include "amdinfer/pre_post/get_top_k.hpp"       // for getTopK
+#include "amdinfer/util/vector_kernels.hpp"      // for softmax
+#include "amdinfer/workers/worker.hpp"           // for MultiThreadedWorker
+
+namespace amdinfer::workers {
+
+/**
+ * @brief The TopK worker turns the scores of a classification model into the
+ * indices and probabilities of its top k classes. It's meant to be chained
+ * after the model with the "next" load-time parameter so clients receive k
+ * values per request instead of the scores of every class. Softmax and top-k
+ * run over the whole batch at once when the scores are contiguous.
+ *
+ */
+class TopK : public MultiThreadedWorker {
+ public:
+  using MultiThreadedWorker::MultiThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// Get the tensors of one request's outputs
+  [[nodiscard]] std::vector<Tensor> getOutputTensors() const;
+
+  size_t k_ = 1;
+  // if false, the scores are reported as they are
+  bool softmax_ = true;
+  int32_t threads_ = 1;
+  // CPUs the worker is pinned to
+  std::vector<int> cpus_;
+};
+
+std::vector<MemoryAllocators> TopK::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> TopK::getReservations() const {
+  // the number of classes isn't known until the scores arrive so only the
+  // outputs are reserved
+  return this->reserveBatches({}, this->getOutputTensors());
+}
+
+std::vector<Tensor> TopK::getOutputTensors() const {
+  const std::vector<int64_t> shape{static_cast<int64_t>(k_)};
+  return {Tensor{"indices", shape, DataType::Int32},
+          Tensor{"probabilities", shape, DataType::Fp32}};
+}
+
+void TopK::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+  constexpr auto kTopK = 5;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  auto k = kTopK;
+  if (parameters->has("k")) {
+    k = parameters->get<int32_t>("k");
+  }
+  if (k < 1) {
+    throw invalid_argument("k must be positive");
+  }
+  k_ = static_cast<size_t>(k);
+
+  if (parameters->has("softmax")) {
+    softmax_ = parameters->get<bool>("softmax");
+  }
+
+  if (parameters->has("threads")) {
+    threads_ = parameters->get<int32_t>("threads");
+  }
+  if (threads_ < 1) {
+    throw invalid_argument("There must be at least one thread");
+  }
+  cpus_ = getPinnedCpus(*parameters);
+}
+
+void TopK::doAcquire([[maybe_unused]] ParameterMap* parameters) {
+  this->metadata_.addInputTensor(Tensor{"input", {-1}, DataType::Fp32});
+  for (const auto& tensor : this->getOutputTensors()) {
+    this->metadata_.addOutputTensor(tensor);
+  }
+  this->metadata_.setName("TopK");
+
+  this->createThreadPool(threads_, cpus_);
+}
+
+BatchPtr TopK::doRun(Batch* batch, const MemoryPool* pool) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  const auto batch_size = batch->size();
+  const auto tensors = this->getOutputTensors();
+
+  std::vector<BufferPtr> input_buffers;
+  for (const auto& tensor : tensors) {
+    input_buffers.push_back(pool->get(next_allocators_, tensor, batch_size));
+  }
+  auto* indices = static_cast<int32_t*>(input_buffers[0]->data(0));
+  auto* probabilities = static_cast<float*>(input_buffers[1]->data(0));
+
+  // find the scores of each request. Requests with bad inputs are failed and
+  // get no scores
+  std::vector<const float*> scores(batch_size, nullptr);
+  size_t classes = 0;
+  for (auto j = 0U; j < batch_size; ++j) {
+    const auto& request = batch->getRequest(j);
+    try {
+      const auto& inputs = request->getInputs();
+      if (inputs.size() != 1 || inputs[0].getDatatype() != DataType::Fp32) {
+        throw invalid_argument("TopK takes one FP32 input tensor");
+      }
+      const auto size = inputs[0].getSize();
+      if (classes == 0) {
+        classes = size;
+      }
+      if (size != classes || size < k_) {
+        throw invalid_argument("TopK needs " + std::to_string(classes) +
+                               " scores and at least k but got " +
+                               std::to_string(size));
+      }
+      scores[j] = static_cast<const float*>(inputs[0].getData());
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger, e.what());
+      request->runCallbackError(e.what());
+    }
+  }
+
+  // rows of scores that are contiguous in memory are processed as one batch
+  std::vector<float> softmax;
+  for (auto j = 0U; j < batch_size;) {
+    if (scores[j] == nullptr) {
+      std::fill_n(indices + j * k_, k_, 0);
+      std::fill_n(probabilities + j * k_, k_, 0.0F);
+      ++j;
+      continue;
+    }
+    auto rows = 1U;
+    while (j + rows < batch_size &&
+           scores[j + rows] == scores[j] + rows * classes) {
+      ++rows;
+    }
+
+    const auto* data = scores[j];
+    if (softmax_) {
+      softmax.resize(rows * classes);
+      util::softmax(data, rows, classes, softmax.data());
+      data = softmax.data();
+    }
+    pre_post::getTopK(data, rows, classes, k_, indices + j * k_);
+    for (auto row = 0U; row < rows; ++row) {
+      for (auto i = 0U; i < k_; ++i) {
+        const auto index = (j + row) * k_ + i;
+        probabilities[index] = data[row * classes + indices[index]];
+      }
+    }
+    j += rows;
+  }
+
+  auto new_batch = batch->propagate();
+  for (auto j = 0U; j < batch_size; ++j) {
+    auto new_request = batch->getRequest(j)->propagate();
+    if (scores[j] == nullptr) {
+      // the slot stays in the batch to keep it aligned with the requests so
+      // later stages run it without responding again
+      new_request->setCallback([](const InferenceResponse&) {});
+    }
+    new_request->addInputTensor(
+      InferenceRequestInput{indices + j * k_, tensors[0].getShape(),
+                            DataType::Int32, tensors[0].getName()});
+    new_request->addInputTensor(
+      InferenceRequestInput{probabilities + j * k_, tensors[1].getShape(),
+                            DataType::Fp32, tensors[1].getName()});
+    new_batch->addRequest(new_request);
+    new_batch->setModel(j, "TopK");
+  }
+  new_batch->setBuffers(std::move(input_buffers), {});
+
+  return new_batch;
+}
+
+void TopK::doRelease() { this->destroyThreadPool(); }
+
+void TopK::doDestroy() {}
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::TopK("TopK", "CPU", true);
+}
+}  // extern C
@@ -0,0 +1,469 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines a pipelined video decoder shared by the streaming workers
+ */
+
+#ifndef GUARD_AMDINFER_WORKERS_VIDEO_STREAM
+#define GUARD_AMDINFER_WORKERS_VIDEO_STREAM
+
+#include <atomic>                 // for atomic_bool
+#include <cstddef>                // for byte, size_t
+#include <cstdint>                // for int32_t, int64_t, uint64_t
+#include <cstring>                // for memcpy
+#include <functional>             // for function
+#include <opencv2/core.hpp>       // for Mat, Size
+#include <opencv2/imgcodecs.hpp>  // for imencode
+#include <opencv2/imgproc.hpp>    // for resize, INTER_AREA
+#include <opencv2/videoio.hpp>    // for VideoCapture
+#include <string>                 // for string
+#include <thread>                 // for thread
+#include <utility>                // for move
+#include <vector>                 // for vector
+
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/stream_frame.hpp"        // for StreamFrame
+#include "amdinfer/util/base64.hpp"              // for base64Encode
+#include "amdinfer/util/queue.hpp"               // for BlockingQueue
+#include "amdinfer/util/thread.hpp"              // for setThreadName
+
+#define AMDINFER_OPENCV_VERSION \
+  (CV_VERSION_MAJOR * 10000 + CV_VERSION_MINOR * 100 + CV_VERSION_REVISION)
+
+namespace amdinfer::workers {
+
+/// How a VideoStream encodes frames for the client
+enum class FrameEncoding {
+  /// frames aren't encoded
+  None,
+  /// a base64 JPEG data URL to embed in JSON text messages
+  DataUrl,
+  /// JPEG bytes to send in binary messages
+  Jpeg,
+  /// the raw BGR pixels to send in binary messages
+  Raw
+};
+
+/// A frame from a VideoStream. Frames are pooled so their buffers are reused
+struct VideoFrame {
+  /// the frame, downscaled if the stream has a size
+  cv::Mat image;
+  /// the frame encoded for the client, depending on the stream's encoding
+  std::string encoded;
+
+  // scratch buffers reused across frames
+  cv::Mat decoded;
+  std::vector<unsigned char> jpeg;
+};
+
+struct VideoStreamOptions {
+  /// width to downscale the frames to. Frames keep their size if it's 0
+  int width = 0;
+  /// height to downscale the frames to. Frames keep their size if it's 0
+  int height = 0;
+  /// number of frames in the pool, which bounds the frames in flight between
+  /// the stages and the consumer
+  size_t frames = 8;
+  /// request hardware-accelerated decoding (e.g. VA-API) if OpenCV supports it
+  bool hardware = true;
+  /// number of decoder threads. The decoder chooses if it's 0
+  int threads = 0;
+  /// how each frame is encoded for display
+  FrameEncoding encoding = FrameEncoding::DataUrl;
+  /// applied in place to each frame before it's encoded
+  std::function<void(cv::Mat*)> filter;
+};
+
+/**
+ * @brief Get the stream options from a worker's load-time parameters:
+ * "video_frames" sets the size of the frame pool, "hardware_decode" toggles
+ * hardware decoding and "decode_threads" sets the decoder threads
+ *
+ * @param parameters load-time parameters
+ * @return VideoStreamOptions
+ */
+inline VideoStreamOptions getVideoStreamOptions(const ParameterMap& parameters) {
+  VideoStreamOptions options;
+  if (parameters.has("video_frames")) {
+    const auto frames = parameters.get<int32_t>("video_frames");
+    if (frames < 1) {
+      throw invalid_argument("video_frames must be positive");
+    }
+    options.frames = static_cast<size_t>(frames);
+  }
+  if (parameters.has("hardware_decode")) {
+    options.hardware = parameters.get<bool>("hardware_decode");
+  }
+  if (parameters.has("decode_threads")) {
+    options.threads = parameters.get<int32_t>("decode_threads");
+    if (options.threads < 0) {
+      throw invalid_argument("decode_threads cannot be negative");
+    }
+  }
+  return options;
+}
+
+/**
+ * @brief Get the encoding of the frames that a request asks for. Frames are
+ * sent as JSON text with a data URL unless the "binary" parameter is true, in
+ * which case the "format" parameter picks "jpeg" (the default) or "raw"
+ *
+ * @param parameters the request's parameters
+ * @return FrameEncoding
+ */
+inline FrameEncoding getFrameEncoding(const ParameterMap& parameters) {
+  if (!parameters.has("binary") || !parameters.get<bool>("binary")) {
+    return FrameEncoding::DataUrl;
+  }
+  if (!parameters.has("format")) {
+    return FrameEncoding::Jpeg;
+  }
+  const auto format = parameters.get<std::string>("format");
+  if (format == "jpeg") {
+    return FrameEncoding::Jpeg;
+  }
+  if (format == "raw") {
+    return FrameEncoding::Raw;
+  }
+  throw invalid_argument("Unknown frame format " + format +
+                         ". It must be jpeg or raw");
+}
+
+namespace detail {
+
+inline bool isBinary(FrameEncoding encoding) {
+  return encoding == FrameEncoding::Jpeg || encoding == FrameEncoding::Raw;
+}
+
+inline std::string makeJsonMessage(const std::string& key,
+                                   const std::string& data,
+                                   const std::string& labels) {
+  return R"({"key": ")" + key + R"(", "data": {"img": ")" + data +
+         R"(", "labels": )" + labels + "}}";
+}
+
+}  // namespace detail
+
+/**
+ * @brief Build the first message of a stream, which has the video's frame rate
+ * and any other metadata but no image
+ *
+ * @param key the key of the stream
+ * @param encoding how the frames of the stream are encoded
+ * @param fps frame rate of the video
+ * @param metadata other metadata as JSON
+ * @return std::string
+ */
+inline std::string makeMetadataMessage(const std::string& key,
+                                       FrameEncoding encoding, double fps,
+                                       const std::string& metadata) {
+  if (detail::isBinary(encoding)) {
+    StreamFrame frame;
+    frame.key = key;
+    frame.results = R"({"fps": )" + std::to_string(fps) +
+                    R"(, "metadata": )" + metadata + "}";
+    return serializeStreamFrame(frame);
+  }
+  return detail::makeJsonMessage(key, std::to_string(fps), metadata);
+}
+
+/**
+ * @brief Build the message for one frame of a stream. In binary streams, the
+ * encoded frame is sent as is after a compact header. Otherwise, it's a JSON
+ * object with the frame as a data URL
+ *
+ * @param key the key of the stream
+ * @param index index of the frame in the stream
+ * @param encoding how the frame is encoded
+ * @param image the encoded frame
+ * @param size width and height of the frame
+ * @param labels the results for the frame as JSON
+ * @return std::string
+ */
+inline std::string makeFrameMessage(const std::string& key, uint64_t index,
+                                    FrameEncoding encoding,
+                                    const std::string& image, cv::Size size,
+                                    const std::string& labels) {
+  if (!detail::isBinary(encoding)) {
+    return detail::makeJsonMessage(key, image, labels);
+  }
+  StreamFrame frame;
+  frame.key = key;
+  frame.index = index;
+  frame.results = labels;
+  if (encoding == FrameEncoding::Jpeg) {
+    frame.format = StreamFrameFormat::Jpeg;
+  } else {
+    frame.format = StreamFrameFormat::Bgr;
+    frame.width = static_cast<uint16_t>(size.width);
+    frame.height = static_cast<uint16_t>(size.height);
+  }
+  return serializeStreamFrame(frame, image);
+}
+
+/**
+ * @brief Send one message of a stream to the client. Binary messages are
+ * marked with the "binary" parameter so the websocket server sends them as
+ * binary websocket messages
+ *
+ * @param request the request for the stream
+ * @param model name of the model to respond as
+ * @param name name of the output
+ * @param message the message
+ * @param encoding how the frames of the stream are encoded
+ */
+inline void sendMessage(InferenceRequest* request, const std::string& model,
+                        const std::string& name, const std::string& message,
+                        FrameEncoding encoding) {
+  InferenceResponse resp;
+  resp.setID(request->getID());
+  resp.setModel(model);
+
+  InferenceResponseOutput output;
+  output.setName(name);
+  output.setDatatype(DataType::Bytes);
+  std::vector<std::byte> buffer(message.size());
+  memcpy(buffer.data(), message.data(), message.size());
+  output.setData(std::move(buffer));
+  output.setShape({static_cast<int64_t>(message.size())});
+  if (detail::isBinary(encoding)) {
+    ParameterMap parameters;
+    parameters.put("binary", true);
+    output.setParameters(std::move(parameters));
+  }
+  resp.addOutput(std::move(output));
+  request->runCallback(resp);
+}
+
+/**
+ * @brief Send a frame of a stream to the client once the stream has a credit
+ * for it. A client that's falling behind either holds the stream up here or
+ * misses the frame, depending on the policy of its stream
+ *
+ * @param request the request for the stream
+ * @param model name of the model to respond as
+ * @param message the frame's message
+ * @param encoding how the frames of the stream are encoded
+ * @return bool true if the frame was sent, false if it was dropped
+ */
+inline bool sendFrame(InferenceRequest* request, const std::string& model,
+                      const std::string& message, FrameEncoding encoding) {
+  if (!request->acquireStreamCredit()) {
+    return false;
+  }
+  sendMessage(request, model, "image", message, encoding);
+  return true;
+}
+
+/**
+ * @brief Decodes a video in a pipeline so decoding, downscaling and JPEG
+ * encoding of later frames overlap with the consumer's inference on earlier
+ * ones. One thread decodes and downscales frames and another filters and
+ * encodes them, passing them through queues. Frames come from a fixed pool
+ * that the consumer returns them to so the stages block instead of running
+ * ahead and no buffers are allocated once the pool has warmed up.
+ */
+class VideoStream {
+ public:
+  VideoStream(const std::string& path, VideoStreamOptions options)
+    : options_(std::move(options)), frames_(options_.frames) {
+    this->open(path);
+  }
+  VideoStream(const VideoStream&) = delete;
+  VideoStream& operator=(const VideoStream&) = delete;
+  VideoStream(VideoStream&&) = delete;
+  VideoStream& operator=(VideoStream&&) = delete;
+
+  ~VideoStream() {
+    stop_ = true;
+    if (decoder_.joinable()) {
+      decoder_.join();
+    }
+    if (encoder_.joinable()) {
+      encoder_.join();
+    }
+  }
+
+  [[nodiscard]] bool isOpened() const { return capture_.isOpened(); }
+  [[nodiscard]] double fps() const {
+    return capture_.get(cv::CAP_PROP_FPS);
+  }
+  [[nodiscard]] double width() const {
+    return capture_.get(cv::CAP_PROP_FRAME_WIDTH);
+  }
+  [[nodiscard]] double height() const {
+    return capture_.get(cv::CAP_PROP_FRAME_HEIGHT);
+  }
+  /// Get the number of frames in the video, as reported by its container
+  [[nodiscard]] size_t count() const {
+    return static_cast<size_t>(capture_.get(cv::CAP_PROP_FRAME_COUNT));
+  }
+
+  /**
+   * @brief Start decoding in the background. The stream ends after the given
+   * number of frames or at the end of the video, whichever is first
+   *
+   * @param count maximum number of frames to decode
+   */
+  void start(size_t count) {
+    for (auto& frame : frames_) {
+      free_.enqueue(&frame);
+    }
+    decoder_ = std::thread{&VideoStream::decode, this, count};
+    encoder_ = std::thread{&VideoStream::encode, this};
+  }
+
+  /**
+   * @brief Block until the next frame is ready. The frame must be given back
+   * with release() once the consumer is done with it
+   *
+   * @return VideoFrame* the next frame or nullptr at the end of the stream
+   */
+  VideoFrame* next() {
+    if (finished_) {
+      return nullptr;
+    }
+    VideoFrame* frame = nullptr;
+    ready_.wait_dequeue(frame);
+    finished_ = frame == nullptr;
+    return frame;
+  }
+
+  /// Return a frame to the pool so the decoder can reuse it
+  void release(VideoFrame* frame) { free_.enqueue(frame); }
+
+ private:
+  void open(const std::string& path) {
+    // hardware decoding and thread counts can only be requested on open with
+    // newer OpenCV. Fall back to the default backend if they're rejected
+#if AMDINFER_OPENCV_VERSION >= 40502
+    std::vector<int> params;
+    if (options_.hardware) {
+      params.push_back(cv::CAP_PROP_HW_ACCELERATION);
+      params.push_back(cv::VIDEO_ACCELERATION_ANY);
+    }
+#if AMDINFER_OPENCV_VERSION >= 40600
+    params.push_back(cv::CAP_PROP_N_THREADS);
+    params.push_back(options_.threads);
+#endif
+    if (capture_.open(path, cv::CAP_FFMPEG, params)) {
+      return;
+    }
+#endif
+    capture_.open(path);
+  }
+
+  // block until a frame is free, checking periodically if the stream stopped
+  bool acquire(VideoFrame** frame) {
+    const int64_t timeout_us = 100'000;
+    while (!stop_) {
+      if (free_.wait_dequeue_timed(*frame, timeout_us)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void decode(size_t count) {
+    util::setThreadName("VideoDecode");
+    const bool resize = options_.width > 0 && options_.height > 0;
+    const cv::Size size{options_.width, options_.height};
+
+    for (size_t i = 0; i < count; ++i) {
+      VideoFrame* frame = nullptr;
+      if (!this->acquire(&frame)) {
+        break;
+      }
+      auto& target = resize ? frame->decoded : frame->image;
+      if (!capture_.read(target)) {
+        this->release(frame);
+        break;
+      }
+      // area interpolation averages the source pixels when shrinking so large
+      // downscales don't alias
+      if (resize) {
+        cv::resize(frame->decoded, frame->image, size, 0, 0, cv::INTER_AREA);
+      }
+      decoded_.enqueue(frame);
+    }
+    decoded_.enqueue(nullptr);
+  }
+
+  void encode() {
+    util::setThreadName("VideoEncode");
+    VideoFrame* frame = nullptr;
+    do {
+      decoded_.wait_dequeue(frame);
+      if (frame != nullptr) {
+        if (options_.filter) {
+          options_.filter(&frame->image);
+        }
+        this->encodeFrame(frame);
+      }
+      ready_.enqueue(frame);
+    } while (frame != nullptr);
+  }
+
+  void encodeFrame(VideoFrame* frame) const {
+    const auto encoding = options_.encoding;
+    if (encoding == FrameEncoding::None) {
+      return;
+    }
+    const auto& image = frame->image;
+    if (encoding == FrameEncoding::Raw) {
+      const auto* data = reinterpret_cast<const char*>(image.data);
+      if (image.isContinuous()) {
+        frame->encoded.assign(data, image.total() * image.elemSize());
+      } else {
+        frame->encoded.clear();
+        const auto row = static_cast<size_t>(image.cols) * image.elemSize();
+        for (auto i = 0; i < image.rows; ++i) {
+          frame->encoded.append(image.ptr<char>(i), row);
+        }
+      }
+      return;
+    }
+
+    cv::imencode(".jpg", image, frame->jpeg);
+    const auto* data = reinterpret_cast<const char*>(frame->jpeg.data());
+    if (encoding == FrameEncoding::Jpeg) {
+      frame->encoded.assign(data, frame->jpeg.size());
+    } else {
+      frame->encoded = util::base64Encode({data, frame->jpeg.size()},
+                                          "data:image/jpg;base64,");
+    }
+  }
+
+  VideoStreamOptions options_;
+  cv::VideoCapture capture_;
+  std::vector<VideoFrame> frames_;
+
+  BlockingQueue<VideoFrame*> free_;
+  BlockingQueue<VideoFrame*> decoded_;
+  BlockingQueue<VideoFrame*> ready_;
+  std::thread decoder_;
+  std::thread encoder_;
+  std::atomic_bool stop_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace amdinfer::workers
+
+#endif  // GUARD_AMDINFER_WORKERS_VIDEO_STREAM
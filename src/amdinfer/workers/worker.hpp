@@ -21,30 +21,180 @@
 #ifndef GUARD_AMDINFER_WORKERS_WORKER
 #define GUARD_AMDINFER_WORKERS_WORKER
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "amdinfer/batching/bucket.hpp"
+#include "amdinfer/batching/sequence.hpp"
 #include "amdinfer/batching/soft.hpp"
 #include "amdinfer/buffers/buffer.hpp"
 #include "amdinfer/build_options.hpp"
+#include "amdinfer/core/device_scheduler.hpp"
+#include "amdinfer/core/exceptions.hpp"
+#include "amdinfer/core/inference_request.hpp"
+#include "amdinfer/core/inference_response.hpp"
 #include "amdinfer/core/memory_pool/pool.hpp"
 #include "amdinfer/core/model_metadata.hpp"
+#include "amdinfer/core/request_container.hpp"
+#include "amdinfer/core/request_usage.hpp"
+#include "amdinfer/observation/load_times.hpp"
 #include "amdinfer/observation/logging.hpp"
 #include "amdinfer/observation/metrics.hpp"
-#include "amdinfer/util/ctpl.hpp"    // for ThreadPool
-#include "amdinfer/util/thread.hpp"  // for setThreadName
+#include "amdinfer/observation/profiling.hpp"
+#include "amdinfer/observation/tracing.hpp"
+#include "amdinfer/util/artifact_cache.hpp"  // for getArtifactCacheDirectory
+#include "amdinfer/util/ctpl.hpp"            // for ThreadPool
+#include "amdinfer/util/numa.hpp"            // for parseIdList, getNumaNodeCpus
+#include "amdinfer/util/scheduler.hpp"       // for Scheduler
+#include "amdinfer/util/thread.hpp"          // for setThreadName
+#include "amdinfer/util/timestamps.hpp"      // for Timestamp, elapsed
 
 namespace amdinfer {
 
 constexpr auto kNumBufferAuto = -1;
+/// Batches in flight by default: one being filled and one being run
+constexpr auto kDefaultReservedBatches = 2;
 
 namespace workers {
 
+/**
+ * @brief Get the indices of the model outputs that a request asks for, in the
+ * order it asks for them, so workers only copy out those outputs. Requests
+ * that don't name any of the outputs get all of them.
+ *
+ * @param request the request
+ * @param names names of the model's outputs
+ * @return std::vector<size_t>
+ */
+inline std::vector<size_t> selectOutputs(
+  const InferenceRequest& request, const std::vector<std::string>& names) {
+  std::vector<size_t> selected;
+  for (const auto& output : request.getOutputs()) {
+    auto found = std::find(names.begin(), names.end(), output.getName());
+    if (found != names.end()) {
+      selected.push_back(static_cast<size_t>(found - names.begin()));
+    }
+  }
+  if (selected.empty()) {
+    selected.resize(names.size());
+    std::iota(selected.begin(), selected.end(), 0);
+  }
+  return selected;
+}
+
+/**
+ * @brief Drop the leading batch dimension from tensors whose shapes include it
+ * to get the shapes of a single request's tensors
+ *
+ * @param tensors the tensors
+ * @return std::vector<Tensor>
+ */
+inline std::vector<Tensor> dropBatchDimension(
+  const std::vector<Tensor>& tensors) {
+  std::vector<Tensor> dropped;
+  dropped.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    const auto& shape = tensor.getShape();
+    Shape request_shape;
+    if (!shape.empty()) {
+      request_shape.assign(shape.begin() + 1, shape.end());
+    }
+    dropped.emplace_back(tensor.getName(), std::move(request_shape),
+                         tensor.getDatatype());
+  }
+  return dropped;
+}
+
+/**
+ * @brief Get the CPUs a worker is pinned to with the "cpus" or "numa_node"
+ * load-time parameters so it can size and place its own thread pools
+ *
+ * @param parameters the worker's load-time parameters
+ * @return std::vector<int> the CPUs or an empty list if it's not pinned
+ */
+inline std::vector<int> getPinnedCpus(const ParameterMap& parameters) {
+  if (parameters.has("cpus")) {
+    return util::parseIdList(parameters.get<std::string>("cpus"));
+  }
+  if (parameters.has("numa_node")) {
+    return util::getNumaNodeCpus(parameters.get<int32_t>("numa_node"));
+  }
+  return {};
+}
+
+/**
+ * @brief Get the directory of the compiled artifact cache for a worker. It's
+ * the "artifact_cache" load-time parameter if it's set and the server's
+ * default otherwise. An empty parameter turns the cache off
+ *
+ * @param parameters the worker's load-time parameters
+ * @return std::filesystem::path the directory or an empty path if it's off
+ */
+inline std::filesystem::path getArtifactCache(const ParameterMap& parameters) {
+  if (parameters.has("artifact_cache")) {
+    return parameters.get<std::string>("artifact_cache");
+  }
+  return util::getArtifactCacheDirectory();
+}
+
+/**
+ * @brief Get the precision a CPU worker runs its model at from the "precision"
+ * load-time parameter: native, bf16 or int8. Models run at their own
+ * precision by default
+ *
+ * @param parameters the worker's load-time parameters
+ * @return std::string
+ */
+inline std::string getCpuPrecision(const ParameterMap& parameters) {
+  if (!parameters.has("precision")) {
+    return "native";
+  }
+  auto precision = parameters.get<std::string>("precision");
+  if (precision != "native" && precision != "bf16" && precision != "int8") {
+    throw invalid_argument("Unknown precision " + precision +
+                           ". Use native, bf16 or int8");
+  }
+  return precision;
+}
+
+/**
+ * @brief Get the path of a model quantized ahead of time. It's saved next to
+ * the model it was calibrated from with the precision after its name, such as
+ * resnet50_int8.pt
+ *
+ * @param model path to the model
+ * @param precision the precision the model was quantized to
+ * @return std::filesystem::path
+ */
+inline std::filesystem::path getQuantizedModel(
+  const std::filesystem::path& model, const std::string& precision) {
+  auto path = model;
+  path.replace_filename(model.stem().string() + "_" + precision +
+                        model.extension().string());
+  return path;
+}
+
 enum class WorkerStatus {
   New,
   Init,
@@ -67,20 +217,68 @@ class Worker {
     : metadata_(name, platform), allow_next_(allow_next) {
     this->status_ = WorkerStatus::New;
   }
-  virtual ~Worker() = default;  ///< Destroy the Worker object
+  /// Destroy the Worker object
+  virtual ~Worker() {
+#ifdef AMDINFER_ENABLE_METRICS
+    if (metrics_ != nullptr) {
+      metrics_->unwatchGauges(this);
+    }
+#endif
+  }
 
   /// Get the memory allocators supported by this worker
   [[nodiscard]] virtual std::vector<MemoryAllocators> getAllocators() const = 0;
 
+  /**
+   * @brief Get the memory this worker needs in steady state. It's reserved in
+   * the memory pool when the worker is loaded so the first requests don't pay
+   * for growing the pool. By default, nothing is reserved.
+   *
+   * @return std::vector<MemoryReservation>
+   */
+  [[nodiscard]] virtual std::vector<MemoryReservation> getReservations() const {
+    return {};
+  }
+
   /// Perform low-cost initialization of the worker
   void init(ParameterMap* parameters) {
     this->status_ = WorkerStatus::Init;
+    if (parameters != nullptr && parameters->has("reserve_batches")) {
+      this->reserved_batches_ =
+        std::max(parameters->get<int32_t>("reserve_batches"), 0);
+    }
+    if (parameters != nullptr && parameters->has("warmup_file")) {
+      this->warmup_file_ = parameters->get<std::string>("warmup_file");
+      this->warmup_batches_ = 1;
+    }
+    if (parameters != nullptr && parameters->has("warmup")) {
+      this->warmup_batches_ = std::max(parameters->get<int32_t>("warmup"), 0);
+    }
+    if (parameters != nullptr && parameters->has("spin_us")) {
+      this->spin_ = std::chrono::microseconds(
+        std::max(parameters->get<int32_t>("spin_us"), 0));
+    }
     this->doInit(parameters);
   }
   /// Acquire any hardware resources or perform high-cost initialization
   void acquire(ParameterMap* parameters) {
     this->status_ = WorkerStatus::Acquire;
     this->doAcquire(parameters);
+  }
+  /**
+   * @brief Run the batches set by the "warmup" load-time parameter at each of
+   * the worker's batch sizes and then mark the worker ready. This moves lazy
+   * initialization, such as compiling kernels and first touching memory, out
+   * of the first requests. The inputs are zeros or, if the "warmup_file"
+   * load-time parameter is set, the raw data of one request's inputs in order
+   * read from that file.
+   *
+   * @param pool the memory pool to allocate the batches from
+   */
+  void warmup(const MemoryPool* pool) {
+    if (this->warmup_batches_ > 0) {
+      this->runWarmup(pool);
+    }
     this->metadata_.setReady(true);
   }
   /**
@@ -89,6 +287,67 @@ class Worker {
    * @param input_queue queue that receives incoming requests
    */
   virtual void run(BatchPtrQueue* input_queue, const MemoryPool* pool) = 0;
+  /**
+   * @brief Run one batch on the calling thread and forward its results. Workers
+   * loaded with the "multiplex" load-time parameter don't run their own thread
+   * and a Multiplexer calls this for each of their batches instead
+   *
+   * @param batch the batch
+   * @param pool the memory pool
+   */
+  virtual void runBatch(BatchPtr batch, const MemoryPool* pool) {
+    [[maybe_unused]] const auto& name = this->getName();
+    AMDINFER_IF_LOGGING(const auto logger = this->getLogger();)
+    if (this->dropCancelled(*batch)) {
+      return;
+    }
+    batch->markStage(ServerTiming::Started);
+
+    [[maybe_unused]] auto batch_size = batch->size();
+
+#ifdef AMDINFER_ENABLE_TRACING
+    batch->startSpan(name);
+#endif
+
+    AMDINFER_LOG_INFO(logger, "Got request in " + name);
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordDequeue(batch.get());
+#endif
+
+    auto turn = this->takeDeviceTurn();
+    const UsageMeter meter{batch->hasUsage()};
+    const auto start = std::chrono::steady_clock::now();
+    auto new_batch = this->doRun(batch.get(), pool);
+    const auto end = std::chrono::steady_clock::now();
+    turn.reset();
+    batch->addUsage(RequestUsage::Compute, meter);
+    this->addBusyTime(end - start);
+    profileEvent("doRun", "worker", start, end);
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordCompute(*batch, new_batch.get());
+#endif
+
+    if (next_ != nullptr && new_batch != nullptr) {
+      assert(new_batch->size() == batch_size);
+#ifdef AMDINFER_ENABLE_TRACING
+      batch->endSpan();
+      for (auto i = 0U; i < batch_size; ++i) {
+        new_batch->addTrace(std::move(batch->getTrace(i)));
+      }
+#endif
+      this->forward(std::move(new_batch), pool);
+    }
+
+    batch->freeInputBuffers();
+  }
+  /// Check if the worker's batches can be run with runBatch
+  [[nodiscard]] virtual bool isMultiplexable() const { return false; }
+  /**
+   * @brief Check if the worker is cheap enough to run batches of one with
+   * runBatch on the threads that receive the requests and safe to do so from
+   * many of them at once. Its batcher then skips the worker's thread
+   */
+  [[nodiscard]] virtual bool isInlineSafe() const { return false; }
   /// Release any hardware resources
   void release() {
     status_ = WorkerStatus::Release;
@@ -104,9 +363,26 @@ class Worker {
 
   [[nodiscard]] size_t getBatchSize() const { return this->batch_size_; }
   [[nodiscard]] WorkerStatus getStatus() const { return this->status_; }
+  /// Get the total time this worker has spent running batches
+  [[nodiscard]] std::chrono::nanoseconds getBusyTime() const {
+    return std::chrono::nanoseconds{busy_time_.load()};
+  }
+  /**
+   * @brief Get the time spent in the phases of init() and acquire() that the
+   * worker timed itself with timeLoadPhase()
+   *
+   * @return const LoadTimes&
+   */
+  [[nodiscard]] const LoadTimes& getLoadTimes() const {
+    return this->load_times_;
+  }
 
   virtual std::vector<std::unique_ptr<Batcher>> makeBatcher(
     int num, ParameterMap* parameters, MemoryPool* pool) {
+    // bucket requests by shape if the worker is configured with buckets
+    if (parameters != nullptr && parameters->has("buckets")) {
+      return this->makeBatcher<BucketBatcher>(num, parameters, pool);
+    }
     return this->makeBatcher<SoftBatcher>(num, parameters, pool);
   }
 
@@ -135,25 +411,311 @@ class Worker {
   void setNextAllocators(const std::vector<MemoryAllocators>& allocators) {
     next_allocators_ = allocators;
   }
+  /**
+   * @brief Send the requests of finished batches to the next worker's batcher
+   * instead of handing the batches to the next worker directly. This is used
+   * when the next worker's batches are smaller than this worker's.
+   *
+   * @param batcher the next worker's batcher
+   */
+  void setNextBatcher(const Batcher* batcher) {
+    if (allow_next_) {
+      next_batcher_ = batcher;
+    }
+  }
+  /**
+   * @brief Take turns on the worker's device with the other endpoints that
+   * share it. Each batch waits for a turn before it runs
+   *
+   * @param share the endpoint's share of the device
+   */
+  void setDeviceShare(std::shared_ptr<DeviceScheduler::Share> share) {
+    device_share_ = std::move(share);
+  }
+#ifdef AMDINFER_ENABLE_METRICS
+  /// Set the metrics of the worker's endpoint. They must outlive the worker
+  void setMetrics(ModelMetrics* metrics) {
+    if (metrics_ != nullptr) {
+      metrics_->unwatchGauges(this);
+    }
+    metrics_ = metrics;
+    if (metrics_ == nullptr) {
+      return;
+    }
+    // the fraction of the time since the last scrape spent running batches
+    metrics_->watchGauge(
+      this, MetricGaugeIDs::WorkersBusy,
+      [this, last_time = std::chrono::steady_clock::now(),
+       last_busy = this->getBusyTime()]() mutable {
+        const auto now = std::chrono::steady_clock::now();
+        const auto busy = this->getBusyTime();
+        const std::chrono::duration<double> elapsed = now - last_time;
+        const std::chrono::duration<double> busy_elapsed = busy - last_busy;
+        last_time = now;
+        last_busy = busy;
+        if (elapsed.count() <= 0) {
+          return 0.0;
+        }
+        return std::min(busy_elapsed / elapsed, 1.0);
+      });
+    this->watchDevice(metrics_);
+  }
+#endif
 
  protected:
 #ifdef AMDINFER_ENABLE_LOGGING
   [[nodiscard]] const Logger& getLogger() const { return logger_; };
 #endif
 
+  /**
+   * @brief Get the shapes of one request's inputs to warm up with. By default,
+   * the inputs in the metadata are used as is.
+   *
+   * @return std::vector<Tensor>
+   */
+  [[nodiscard]] virtual std::vector<Tensor> getWarmupInputs() const {
+    return metadata_.getInputs();
+  }
+  /// Get the batch sizes to warm up. By default, full and single batches
+  [[nodiscard]] virtual std::vector<size_t> getWarmupBatchSizes() const {
+    if (batch_size_ > 1) {
+      return {batch_size_, 1};
+    }
+    return {batch_size_};
+  }
+
+  /**
+   * @brief Reserve memory for the inputs and outputs of each batch that may be
+   * in flight. The number of batches is set by the reserve_batches load-time
+   * parameter.
+   *
+   * @param inputs the input tensors of one request
+   * @param outputs the output tensors of one request
+   * @return std::vector<MemoryReservation>
+   */
+  [[nodiscard]] std::vector<MemoryReservation> reserveBatches(
+    const std::vector<Tensor>& inputs,
+    const std::vector<Tensor>& outputs) const {
+    std::vector<MemoryReservation> reservations;
+    const auto count = static_cast<size_t>(reserved_batches_);
+    if (count == 0) {
+      return reservations;
+    }
+    for (const auto& input : inputs) {
+      reservations.push_back({getAllocators(), input, batch_size_, count});
+    }
+    // the outputs are allocated for the next worker in the chain
+    if (!next_allocators_.empty()) {
+      for (const auto& output : outputs) {
+        reservations.push_back({next_allocators_, output, batch_size_, count});
+      }
+    }
+    return reservations;
+  }
+
+  /**
+   * @brief Send a finished batch to the next worker. By default, the batch is
+   * handed to the next worker as is so it runs on the same buffers without
+   * being copied or batched again. If the next worker has a batcher set with
+   * setNextBatcher, each request is copied out of the batch and batched again.
+   *
+   * @param batch the finished batch
+   * @param pool the memory pool to copy the requests' tensors into
+   */
+  void forward(BatchPtr batch, const MemoryPool* pool) const {
+    if (next_batcher_ == nullptr) {
+      next_->enqueue(std::move(batch));
+      return;
+    }
+
+    for (auto i = 0U; i < batch->size(); ++i) {
+      const auto& request = batch->getRequest(i);
+      const auto& inputs = request->getInputs();
+      // the batcher returns the memory of its requests to the pool after
+      // batching them so each tensor gets its own copy
+      for (auto j = 0U; j < inputs.size(); ++j) {
+        const auto& input = inputs[j];
+        auto buffer = pool->get({MemoryAllocators::Cpu}, input, 1);
+        buffer->write(input.getData(), 0,
+                      input.getSize() * input.getDatatype().size());
+        request->setInputTensorData(j, buffer->data(0));
+      }
+
+      auto container = makeRequestContainer();
+      container->request = request;
+#ifdef AMDINFER_ENABLE_TRACING
+      container->trace = std::move(batch->getTrace(i));
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+      container->start_time = batch->getTime(i);
+#endif
+      next_batcher_->enqueue(std::move(container));
+    }
+    batch->freeInputBuffers();
+  }
+
+  /**
+   * @brief Run a step of loading the model, such as reading or compiling it,
+   * and add its time to a phase of the load. The rest of init() and acquire()
+   * is counted as LoadPhase::Init and LoadPhase::Acquire
+   *
+   * @param phase the phase to add the time to
+   * @param f the step to run
+   * @return what f returns
+   */
+  template <typename F>
+  decltype(auto) timeLoadPhase(LoadPhase phase, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto add = [&]() {
+      load_times_.at(static_cast<size_t>(phase)) +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start);
+    };
+    if constexpr (std::is_void_v<std::invoke_result_t<F>>) {
+      std::forward<F>(f)();
+      add();
+    } else {
+      auto result = std::forward<F>(f)();
+      add();
+      return result;
+    }
+  }
+
+  /// Add to the time spent running batches, which is used for autoscaling
+  void addBusyTime(std::chrono::nanoseconds time) {
+    busy_time_ += time.count();
+#ifdef AMDINFER_ENABLE_METRICS
+    if (metrics_ != nullptr) {
+      metrics_->incrementCounter(
+        MetricCounterIDs::WorkerBusyTime,
+        std::chrono::duration_cast<std::chrono::microseconds>(time).count());
+    }
+#endif
+  }
+
+  /// Add to the time spent waiting for batches
+  void addIdleTime([[maybe_unused]] std::chrono::nanoseconds time) {
+#ifdef AMDINFER_ENABLE_METRICS
+    if (metrics_ != nullptr) {
+      metrics_->incrementCounter(
+        MetricCounterIDs::WorkerIdleTime,
+        std::chrono::duration_cast<std::chrono::microseconds>(time).count());
+    }
+#endif
+  }
+
+#ifdef AMDINFER_ENABLE_METRICS
+  /**
+   * @brief Watch gauges of the worker's devices with the worker as their
+   * owner. They're unwatched with the worker's own gauges. By default, there
+   * are none.
+   *
+   * @param metrics the metrics of the worker's endpoint
+   */
+  virtual void watchDevice([[maybe_unused]] ModelMetrics* metrics) {}
+#endif
+
+  /**
+   * @brief Fail the requests of a batch instead of running it if their
+   * clients have all cancelled them. Batches with some live requests are run
+   * since their tensors are already assembled.
+   *
+   * @param batch the batch
+   * @return bool - true if the batch was dropped and its inputs freed
+   */
+  bool dropCancelled(const Batch& batch) const {
+    if (!batch.isCancelled()) {
+      return false;
+    }
+    for (const auto& request : batch.getRequests()) {
+      request->runCallbackError("Request cancelled");
+    }
+#ifdef AMDINFER_ENABLE_METRICS
+    if (metrics_ != nullptr) {
+      metrics_->incrementCounter(MetricCounterIDs::WorkerCancelled,
+                                 batch.size());
+    }
+#endif
+    batch.freeInputBuffers();
+    return true;
+  }
+
+#ifdef AMDINFER_ENABLE_METRICS
+  /**
+   * @brief Count a batch the worker took and record how long it waited for
+   * the worker since it was sent. The batch is timed from now.
+   *
+   * @param batch the batch
+   */
+  void recordDequeue(Batch* batch) const {
+    const auto now = util::now();
+    if (metrics_ != nullptr) {
+      metrics_->incrementCounter(MetricCounterIDs::PipelineIngressWorker);
+      metrics_->observeDuration(MetricHistogramIDs::StageQueue,
+                                now - batch->getStageTime());
+    }
+    batch->setStageTime(now);
+  }
+  /**
+   * @brief Record how long the worker took to run a batch since it took it.
+   * The finished batch is timed from now as it's sent on.
+   *
+   * @param batch the batch the worker ran
+   * @param new_batch the finished batch or nullptr
+   */
+  void recordCompute(const Batch& batch, Batch* new_batch) const {
+    const auto now = util::now();
+    if (metrics_ != nullptr) {
+      metrics_->observeDuration(MetricHistogramIDs::StageCompute,
+                                now - batch.getStageTime());
+    }
+    if (new_batch != nullptr) {
+      new_batch->setStageTime(now);
+    }
+  }
+#endif
+
   size_t batch_size_ = 1;
   ModelMetadata metadata_;
   std::vector<MemoryAllocators> next_allocators_;
   BatchPtrQueue* next_ = nullptr;
+  const Batcher* next_batcher_ = nullptr;
   WorkerStatus status_;
+#ifdef AMDINFER_ENABLE_METRICS
+  ModelMetrics* metrics_ = nullptr;
+#endif
 
   /**
    * @brief The main body of the worker executes the work
    *
    * @param input_queue queue that receives incoming requests
    */
-  virtual std::unique_ptr<Batch> doRun(Batch* batch,
-                                       const MemoryPool* pool) = 0;
+  virtual BatchPtr doRun(Batch* batch, const MemoryPool* pool) = 0;
+
+  /**
+   * @brief Poll an empty queue for up to spin_us before the caller blocks on
+   * it so a worker on its own CPUs picks up the next batch without waiting
+   * for the kernel to wake it
+   *
+   * @param queue the queue that the caller is about to block on
+   */
+  void spinForBatch(const BatchPtrQueue& queue) const {
+    util::spinUntilReady(queue, spin_);
+  }
+
+  /**
+   * @brief Wait for the endpoint's turn on the device if it shares the device
+   * with other endpoints. The turn lasts until the returned pointer is dropped
+   * so workers that finish batches on another thread can hold it until then
+   *
+   * @return std::shared_ptr<void> the turn or nullptr if it isn't shared
+   */
+  [[nodiscard]] std::shared_ptr<void> takeDeviceTurn() const {
+    if (device_share_ == nullptr) {
+      return nullptr;
+    }
+    return device_share_->take();
+  }
 
  private:
   /// Perform low-cost initialization of the worker
@@ -165,10 +727,105 @@ class Worker {
   /// Perform any final operations before the worker's run thread is joined
   virtual void doDestroy() = 0;
 
+  /// Get the raw data of one request's inputs to warm up with
+  [[nodiscard]] std::vector<std::byte> readWarmupSample(size_t size) const {
+    std::vector<std::byte> sample(size);
+    if (warmup_file_.empty()) {
+      return sample;
+    }
+    std::ifstream file{warmup_file_, std::ios::binary | std::ios::ate};
+    if (!file) {
+      throw invalid_argument("Could not open warmup_file " + warmup_file_);
+    }
+    if (static_cast<size_t>(file.tellg()) != size) {
+      throw invalid_argument("warmup_file must have " + std::to_string(size) +
+                             " bytes for the model's inputs");
+    }
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(sample.data()),
+              static_cast<std::streamsize>(size));
+    return sample;
+  }
+
+  /// Run the warm-up batches through doRun and drop their outputs
+  void runWarmup(const MemoryPool* pool) {
+    const auto inputs = this->getWarmupInputs();
+    size_t request_size = 0;
+    for (const auto& input : inputs) {
+      const auto& shape = input.getShape();
+      if (std::any_of(shape.begin(), shape.end(),
+                      [](int64_t dim) { return dim <= 0; })) {
+        AMDINFER_LOG_WARN(logger_, "Skipping warm-up for " + getName() +
+                                     " because its input shapes vary");
+        return;
+      }
+      request_size += input.getSize() * input.getDatatype().size();
+    }
+    if (inputs.empty()) {
+      AMDINFER_LOG_WARN(logger_, "Skipping warm-up for " + getName() +
+                                   " because it has no input metadata");
+      return;
+    }
+
+    auto sample = this->readWarmupSample(request_size);
+    const auto allocators = this->getAllocators();
+    for (auto batch_size : this->getWarmupBatchSizes()) {
+      for (auto i = 0; i < warmup_batches_; ++i) {
+        auto batch = Batch::create(batch_size);
+        BufferPtrs buffers;
+        buffers.reserve(inputs.size());
+        for (const auto& input : inputs) {
+          buffers.push_back(pool->get(allocators, input, batch_size));
+        }
+
+        std::vector<size_t> offsets(inputs.size(), 0);
+        for (auto j = 0U; j < batch_size; ++j) {
+          auto request = std::make_shared<InferenceRequest>();
+          size_t position = 0;
+          for (auto k = 0U; k < inputs.size(); ++k) {
+            const auto& input = inputs[k];
+            const auto size = input.getSize() * input.getDatatype().size();
+            auto* data = buffers[k]->data(offsets[k]);
+            offsets[k] =
+              buffers[k]->write(sample.data() + position, offsets[k], size);
+            request->addInputTensor(data, input.getShape(),
+                                    input.getDatatype(), input.getName());
+            position += size;
+          }
+          request->setCallback([](const InferenceResponse&) {});
+          batch->addRequest(std::move(request));
+          batch->addModel("");
+#ifdef AMDINFER_ENABLE_TRACING
+          batch->addTrace(startTrace("warmup"));
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+          batch->addTime(util::now());
+#endif
+        }
+        batch->setBuffers(std::move(buffers), {});
+
+        auto new_batch = this->doRun(batch.get(), pool);
+        if (new_batch != nullptr) {
+          new_batch->freeInputBuffers();
+        }
+        batch->freeInputBuffers();
+      }
+    }
+    AMDINFER_LOG_INFO(logger_, "Warmed up " + getName());
+  }
+
 #ifdef AMDINFER_ENABLE_LOGGING
   Logger logger_{Loggers::Server};
 #endif
   bool allow_next_ = true;
+  int32_t reserved_batches_ = kDefaultReservedBatches;
+  int32_t warmup_batches_ = 0;
+  std::string warmup_file_;
+  // how long to poll an empty input queue before blocking on it
+  std::chrono::microseconds spin_{0};
+  std::shared_ptr<DeviceScheduler::Share> device_share_;
+  std::atomic<int64_t> busy_time_ = 0;
+  LoadTimes load_times_{};
 };
 
 class SingleThreadedWorker : public Worker {
@@ -187,44 +844,16 @@ class SingleThreadedWorker : public Worker {
 
     while (true) {
       BatchPtr batch;
+      const auto waiting = std::chrono::steady_clock::now();
+      this->spinForBatch(*input_queue);
       input_queue->wait_dequeue(batch);
+      const auto dequeued = std::chrono::steady_clock::now();
+      this->addIdleTime(dequeued - waiting);
+      profileEvent("queue wait", "worker", waiting, dequeued);
       if (batch == nullptr) {
         break;
       }
-
-      [[maybe_unused]] auto batch_size = batch->size();
-
-#ifdef AMDINFER_ENABLE_TRACING
-      for (auto i = 0U; i < batch_size; ++i) {
-        const auto& trace = batch->getTrace(i);
-        trace->startSpan(name.c_str());
-      }
-#endif
-
-      AMDINFER_LOG_INFO(logger, "Got request in " + name);
-#ifdef AMDINFER_ENABLE_METRICS
-      Metrics::getInstance().incrementCounter(
-        MetricCounterIDs::PipelineIngressWorker);
-#endif
-
-      auto new_batch = this->doRun(batch.get(), pool);
-
-      if (next_ != nullptr && new_batch != nullptr) {
-        assert(new_batch->size() == batch_size);
-#ifdef AMDINFER_ENABLE_TRACING
-        for (auto i = 0U; i < batch_size; ++i) {
-          auto& trace = batch->getTrace(i);
-          trace->endSpan();
-          new_batch->addTrace(std::move(trace));
-        }
-#endif
-        next_->enqueue(std::move(new_batch));
-      }
-
-      const auto& buffers = batch->getInputBuffers();
-      for (const auto& buffer : buffers) {
-        buffer->free();
-      }
+      this->runBatch(std::move(batch), pool);
     }
 
     AMDINFER_LOG_INFO(logger, name + " ending");
@@ -232,16 +861,23 @@ class SingleThreadedWorker : public Worker {
     status_ = WorkerStatus::Inactive;
   }
 
+  [[nodiscard]] bool isMultiplexable() const override { return true; }
+
  private:
-  using Worker::next_;
   using Worker::status_;
 };
 
+/// How often idle threads of a MultiThreadedWorker check if it's stopping
+constexpr auto kStopPollInterval = std::chrono::milliseconds(100);
+
 class MultiThreadedWorker : public Worker {
  public:
   using Worker::Worker;
   /**
-   * @brief The main body of the worker executes the work
+   * @brief The main body of the worker executes the work. Every thread in the
+   * pool pulls batches from the input queue itself so a batch is only taken
+   * when a thread is free to run it. Batches that no thread can take yet stay
+   * queued where other workers in the group can take them.
    *
    * @param input_queue queue that receives incoming requests
    */
@@ -250,71 +886,194 @@ class MultiThreadedWorker : public Worker {
     const auto& name = this->getName();
     AMDINFER_IF_LOGGING(const auto logger = this->getLogger());
     util::setThreadName(name);
-    std::atomic_int32_t outstanding_batches = 0;
-    // 4 is arbitrary
-    const int max_outstanding_batches = thread_pool_.getSize() * 4;
-    // 10 is arbitrary
-    const auto thread_pool_delay = std::chrono::milliseconds(10);
-
-    while (true) {
-      BatchPtr batch;
-      input_queue->wait_dequeue(batch);
-      if (batch == nullptr) {
-        break;
-      }
 
-      [[maybe_unused]] auto batch_size = batch->size();
-
-#ifdef AMDINFER_ENABLE_TRACING
-      for (auto i = 0U; i < batch_size; ++i) {
-        const auto& trace = batch->getTrace(i);
-        trace->startSpan(name.c_str());
-      }
-#endif
+    // this thread pulls batches too so one pool thread is left idle
+    std::atomic_bool stop = false;
+    const auto threads = std::max(thread_pool_.getSize(), 1);
+    moodycamel::LightweightSemaphore finished;
+    std::vector<util::ThreadPool::Task> tasks;
+    tasks.reserve(threads - 1);
+    for (auto i = 1; i < threads; ++i) {
+      tasks.emplace_back(
+        [this, input_queue, pool, &stop, &finished]([[maybe_unused]] int id) {
+          this->pullBatches(input_queue, pool, &stop);
+          finished.signal();
+        });
+    }
+    thread_pool_.pushBulk(std::move(tasks));
+    this->pullBatches(input_queue, pool, &stop);
+    for (auto i = 1; i < threads; ++i) {
+      finished.wait();
+    }
 
-      AMDINFER_LOG_INFO(logger, "Got request in " + name);
-#ifdef AMDINFER_ENABLE_METRICS
-      Metrics::getInstance().incrementCounter(
-        MetricCounterIDs::PipelineIngressWorker);
-#endif
+    AMDINFER_LOG_INFO(logger, name + " ending");
 
-      outstanding_batches++;
-      if (outstanding_batches > max_outstanding_batches) {
-        std::this_thread::sleep_for(thread_pool_delay);
-      }
+    status_ = WorkerStatus::Inactive;
+  }
 
-      thread_pool_.push([this, batch = std::move(batch), &outstanding_batches,
-                         pool]([[maybe_unused]] int id) {
-        [[maybe_unused]] auto batch_size = batch->size();
-        auto new_batch = this->doRun(batch.get(), pool);
+  [[nodiscard]] bool isMultiplexable() const override { return true; }
+
+ protected:
+  /**
+   * @brief Start the worker's threads
+   *
+   * @param threads number of threads
+   * @param cpus CPUs to pin the threads to, one each, or empty to not pin them
+   */
+  void createThreadPool(int threads, std::vector<int> cpus = {}) {
+    thread_pool_.setCpus(std::move(cpus));
+    thread_pool_.resize(threads);
+  }
+
+  void destroyThreadPool() { thread_pool_.stop(true); }
+
+ private:
+  /**
+   * @brief Run batches from the input queue until the worker is stopped. The
+   * thread that dequeues the worker's nullptr stops the others, which notice
+   * it after their current batch or within kStopPollInterval.
+   *
+   * @param input_queue queue that receives incoming batches
+   * @param pool the memory pool
+   * @param stop flag that's set when the worker is stopping
+   */
+  void pullBatches(BatchPtrQueue* input_queue, const MemoryPool* pool,
+                   std::atomic_bool* stop) {
+    const auto& name = this->getName();
+    AMDINFER_IF_LOGGING(const auto logger = this->getLogger());
+
+    auto waiting = std::chrono::steady_clock::now();
+    while (!stop->load()) {
+      BatchPtr batch;
+      this->spinForBatch(*input_queue);
+      if (!input_queue->wait_dequeue_timed(batch, kStopPollInterval)) {
+        continue;
+      }
+      const auto dequeued = std::chrono::steady_clock::now();
+      // like the busy time, the idle time is shared by the threads
+      this->addIdleTime((dequeued - waiting) /
+                        std::max(thread_pool_.getSize(), 1));
+      profileEvent("queue wait", "worker", waiting, dequeued);
+      if (batch == nullptr) {
+        stop->store(true);
+        break;
+      }
+      if (this->dropCancelled(*batch)) {
+        waiting = std::chrono::steady_clock::now();
+        continue;
+      }
+      batch->markStage(ServerTiming::Started);
+
+      [[maybe_unused]] auto batch_size = batch->size();
 
-        if (next_ != nullptr) {
-          assert(new_batch != nullptr);
-          assert(new_batch->size() == batch_size);
 #ifdef AMDINFER_ENABLE_TRACING
-          for (auto i = 0U; i < batch_size; ++i) {
-            auto& trace = batch->getTrace(i);
-            trace->endSpan();
-            new_batch->addTrace(std::move(trace));
-          }
+      batch->startSpan(name);
 #endif
 
+      AMDINFER_LOG_INFO(logger, "Got request in " + name);
 #ifdef AMDINFER_ENABLE_METRICS
-          for (auto i = 0U; i < batch_size; ++i) {
-            new_batch->addTime(batch->getTime(i));
-          }
+      this->recordDequeue(batch.get());
+#endif
+
+      // the threads share the worker's busy time so it's at most the wall time
+      auto turn = this->takeDeviceTurn();
+      const UsageMeter meter{batch->hasUsage()};
+      const auto start = std::chrono::steady_clock::now();
+      auto new_batch = this->doRun(batch.get(), pool);
+      const auto end = std::chrono::steady_clock::now();
+      turn.reset();
+      batch->addUsage(RequestUsage::Compute, meter);
+      this->addBusyTime((end - start) / std::max(thread_pool_.getSize(), 1));
+      profileEvent("doRun", "worker", start, end);
+#ifdef AMDINFER_ENABLE_METRICS
+      this->recordCompute(*batch, new_batch.get());
 #endif
 
-          next_->enqueue(std::move(new_batch));
+      if (next_ != nullptr) {
+        assert(new_batch != nullptr);
+        assert(new_batch->size() == batch_size);
+#ifdef AMDINFER_ENABLE_TRACING
+        batch->endSpan();
+        for (auto i = 0U; i < batch_size; ++i) {
+          new_batch->addTrace(std::move(batch->getTrace(i)));
         }
+#endif
 
-        const auto& buffers = batch->getInputBuffers();
-        for (const auto& buffer : buffers) {
-          buffer->free();
+#ifdef AMDINFER_ENABLE_METRICS
+        for (auto i = 0U; i < batch_size; ++i) {
+          new_batch->addTime(batch->getTime(i));
         }
+#endif
 
-        outstanding_batches--;
-      });
+        this->forward(std::move(new_batch), pool);
+      }
+
+      batch->freeInputBuffers();
+      waiting = std::chrono::steady_clock::now();
+    }
+  }
+
+  using Worker::next_;
+  using Worker::status_;
+  util::ThreadPool thread_pool_;
+};
+
+/// Batches an AsyncWorker runs at once unless it sets another limit
+constexpr size_t kDefaultAsyncBatches = 4;
+/// How often an AsyncWorker checks the work it awaits when nothing wakes it
+constexpr auto kAwaitPollInterval = std::chrono::microseconds(50);
+
+/**
+ * @brief An AsyncWorker runs many batches at once on its one thread. Instead
+ * of blocking until a batch is done, doStart() starts it, awaits the device's
+ * completions on the worker's scheduler and calls the batch's done function
+ * from its last continuation. Between batches, the thread checks the awaited
+ * work and runs the continuations that are ready so one thread can keep many
+ * batches in flight on one or more devices without a thread pool.
+ */
+class AsyncWorker : public Worker {
+ public:
+  using Worker::Worker;
+  /// Called with the batch for the next worker, if any, once a batch is done
+  using Done = std::function<void(BatchPtr new_batch)>;
+
+  /**
+   * @brief The main body of the worker takes batches while it has room for
+   * them and otherwise runs the continuations of the batches in flight. It
+   * only blocks for a batch if nothing is in flight. Once it's stopped, it
+   * finishes the batches in flight before it returns.
+   *
+   * @param input_queue queue that receives incoming requests
+   */
+  void run(BatchPtrQueue* input_queue, const MemoryPool* pool) override {
+    this->status_ = WorkerStatus::Run;
+    const auto& name = this->getName();
+    AMDINFER_IF_LOGGING(const auto logger = this->getLogger();)
+    util::setThreadName(name);
+
+    bool stop = false;
+    while (!stop || !in_flight_.empty()) {
+      while (!stop && in_flight_.size() < max_in_flight_) {
+        BatchPtr batch;
+        if (in_flight_.empty() && scheduler_.idle()) {
+          const auto waiting = std::chrono::steady_clock::now();
+          this->spinForBatch(*input_queue);
+          input_queue->wait_dequeue(batch);
+          const auto dequeued = std::chrono::steady_clock::now();
+          this->addIdleTime(dequeued - waiting);
+          profileEvent("queue wait", "worker", waiting, dequeued);
+        } else if (!input_queue->wait_dequeue_timed(batch, 0)) {
+          break;
+        }
+        if (batch == nullptr) {
+          stop = true;
+          break;
+        }
+        this->start(std::move(batch), pool);
+      }
+      if (scheduler_.poll() == 0 && !scheduler_.idle()) {
+        scheduler_.wait(kAwaitPollInterval);
+      }
     }
 
     AMDINFER_LOG_INFO(logger, name + " ending");
@@ -323,14 +1082,732 @@ class MultiThreadedWorker : public Worker {
   }
 
  protected:
-  void createThreadPool(int threads) { thread_pool_.resize(threads); }
-
-  void destroyThreadPool() { thread_pool_.stop(true); }
+  /// Get the scheduler that the worker's continuations run on
+  util::Scheduler& getScheduler() { return scheduler_; }
+  /**
+   * @brief Set how many batches the worker runs at once. Batches past this
+   * stay queued where other workers in the group can take them
+   *
+   * @param batches the number of batches
+   */
+  void setMaxInFlight(size_t batches) {
+    max_in_flight_ = std::max<size_t>(batches, 1);
+  }
 
  private:
+  /**
+   * @brief Start running a batch. It must not block on the device: it awaits
+   * the device's completions on the scheduler and calls done once, from any
+   * continuation, when the batch is finished. The batch stays valid until then.
+   * If it throws, the batch's requests get the error so it must not have
+   * awaited anything for the batch
+   *
+   * @param batch the batch
+   * @param pool the memory pool
+   * @param done called with the batch for the next worker or nullptr
+   */
+  virtual void doStart(Batch* batch, const MemoryPool* pool, Done done) = 0;
+
+  /**
+   * @brief Run a batch until it's done by polling the scheduler. This is used
+   * by warm-up and the multiplexer since batches from the batcher are run by
+   * run()
+   *
+   * @param batch the batch
+   * @param pool the memory pool
+   * @return BatchPtr - the batch for the next worker or nullptr
+   */
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) final {
+    bool finished = false;
+    BatchPtr result;
+    this->doStart(batch, pool, [&finished, &result](BatchPtr new_batch) {
+      result = std::move(new_batch);
+      finished = true;
+    });
+    while (!finished) {
+      if (scheduler_.poll() == 0) {
+        scheduler_.wait(kAwaitPollInterval);
+      }
+    }
+    return result;
+  }
+
+  /// Take a batch from the queue and start it
+  void start(BatchPtr batch, const MemoryPool* pool) {
+    [[maybe_unused]] const auto& name = this->getName();
+    AMDINFER_IF_LOGGING(const auto logger = this->getLogger();)
+    if (this->dropCancelled(*batch)) {
+      return;
+    }
+    batch->markStage(ServerTiming::Started);
+#ifdef AMDINFER_ENABLE_TRACING
+    batch->startSpan(name);
+#endif
+
+    AMDINFER_LOG_INFO(logger, "Got request in " + name);
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordDequeue(batch.get());
+#endif
+
+    // the worker is busy while any batch is in flight
+    if (in_flight_.empty()) {
+      busy_since_ = std::chrono::steady_clock::now();
+    }
+    auto* key = batch.get();
+    in_flight_.emplace(key, std::move(batch));
+    try {
+      this->doStart(key, pool, [this, key, pool](BatchPtr new_batch) {
+        this->finish(key, std::move(new_batch), pool);
+      });
+    } catch (const std::exception& e) {
+      // the batch may have been finished before the error
+      if (in_flight_.find(key) == in_flight_.end()) {
+        return;
+      }
+      AMDINFER_LOG_ERROR(logger, name + " failed to start a batch: " +
+                                   std::string{e.what()});
+      for (const auto& request : key->getRequests()) {
+        request->runCallbackError(e.what());
+      }
+      this->finish(key, nullptr, nullptr);
+    }
+  }
+
+  /// Send a finished batch on and free its inputs
+  void finish(const Batch* key, BatchPtr new_batch, const MemoryPool* pool) {
+    auto node = in_flight_.extract(key);
+    assert(!node.empty());
+    auto batch = std::move(node.mapped());
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordCompute(*batch, new_batch.get());
+#endif
+
+    if (next_ != nullptr && new_batch != nullptr) {
+      [[maybe_unused]] const auto batch_size = batch->size();
+      assert(new_batch->size() == batch_size);
+#ifdef AMDINFER_ENABLE_TRACING
+      batch->endSpan();
+      for (auto i = 0U; i < batch_size; ++i) {
+        new_batch->addTrace(std::move(batch->getTrace(i)));
+      }
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+      for (auto i = 0U; i < batch_size; ++i) {
+        new_batch->addTime(batch->getTime(i));
+      }
+#endif
+      this->forward(std::move(new_batch), pool);
+    }
+
+    batch->freeInputBuffers();
+    if (in_flight_.empty()) {
+      this->addBusyTime(std::chrono::steady_clock::now() - busy_since_);
+    }
+  }
+
   using Worker::next_;
   using Worker::status_;
-  util::ThreadPool thread_pool_;
+  util::Scheduler scheduler_;
+  size_t max_in_flight_ = kDefaultAsyncBatches;
+  std::unordered_map<const Batch*, BatchPtr> in_flight_;
+  std::chrono::steady_clock::time_point busy_since_;
+};
+
+/**
+ * @brief A sequence running in one of a SequenceWorker's slots. The worker
+ * keeps each sequence's state between its requests, indexed by the slot.
+ */
+struct Sequence {
+  /// ID shared by the sequence's requests. It's empty for one-shot requests
+  std::string id;
+  /// Index of the slot running the sequence, less than the batch size
+  size_t slot = 0;
+  /// The request being run or nullptr between the sequence's requests
+  InferenceRequestPtr request;
+  /// Model to set in the request's responses
+  std::string model;
+  /// Number of steps run for the current request
+  size_t iteration = 0;
+  /// True if the current request starts a new sequence
+  bool starting = true;
+  /// True if the current request is the last one of the sequence
+  bool ending = true;
+  /// True if the client wants partial responses for the current request
+  bool stream = false;
+  /// True once the current request has been sent its final response
+  bool done = false;
+  /// Raised if the sequence's client goes away so an idle sequence can end
+  std::shared_ptr<const std::atomic_bool> cancelled;
+  // returns the current request's input memory to the pool when it's done
+  std::shared_ptr<const void> inputs;
+#ifdef AMDINFER_ENABLE_TRACING
+  TracePtr trace;
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+  util::Timestamp start_time;
+#endif
+};
+
+class SequenceWorker;
+
+/**
+ * @brief Keeps each sequence on the SequenceWorker instance that holds its
+ * state. The instances of an endpoint share one queue of batches so any of
+ * them may dequeue a sequence's next request. The first instance to take a
+ * sequence owns it until the sequence ends and the others hand its requests
+ * over to the owner.
+ */
+class SequenceRouter {
+ public:
+  /// Get the router shared by the instances that read from a queue
+  static std::shared_ptr<SequenceRouter> get(const BatchPtrQueue* queue) {
+    static std::mutex mutex;
+    static std::unordered_map<const BatchPtrQueue*,
+                              std::weak_ptr<SequenceRouter>>
+      routers;
+    std::lock_guard lock{mutex};
+    auto& router = routers[queue];
+    auto shared = router.lock();
+    if (shared == nullptr) {
+      shared = std::make_shared<SequenceRouter>();
+      router = shared;
+    }
+    return shared;
+  }
+
+  /**
+   * @brief Claim a sequence for an instance if no other instance owns it
+   *
+   * @param id the sequence's ID
+   * @param instance the instance that has the sequence's request
+   * @return const SequenceWorker* the instance that owns the sequence
+   */
+  const SequenceWorker* claim(const std::string& id,
+                              const SequenceWorker* instance) {
+    std::lock_guard lock{mutex_};
+    return owners_.try_emplace(id, instance).first->second;
+  }
+
+  /// Hand a request over to the instance that owns its sequence
+  void handOver(const SequenceWorker* owner, Sequence sequence) {
+    std::lock_guard lock{mutex_};
+    handed_over_[owner].push_back(std::move(sequence));
+  }
+
+  /// Take the requests handed over to an instance, in order
+  std::deque<Sequence> take(const SequenceWorker* instance) {
+    std::lock_guard lock{mutex_};
+    std::deque<Sequence> sequences;
+    if (auto found = handed_over_.find(instance);
+        found != handed_over_.end()) {
+      sequences.swap(found->second);
+    }
+    return sequences;
+  }
+
+  /// Check if an instance owns any sequences that may get requests
+  bool owns(const SequenceWorker* instance) const {
+    std::lock_guard lock{mutex_};
+    return std::any_of(owners_.begin(), owners_.end(), [&](const auto& owner) {
+      return owner.second == instance;
+    });
+  }
+
+  /// Release an instance's sequence once it ends
+  void release(const std::string& id, const SequenceWorker* instance) {
+    std::lock_guard lock{mutex_};
+    if (auto found = owners_.find(id);
+        found != owners_.end() && found->second == instance) {
+      owners_.erase(found);
+    }
+  }
+
+  /**
+   * @brief Release all the sequences of an instance that's stopping
+   *
+   * @param instance the instance
+   * @return std::deque<Sequence> the requests handed over to it that it
+   * didn't take
+   */
+  std::deque<Sequence> leave(const SequenceWorker* instance) {
+    std::lock_guard lock{mutex_};
+    for (auto it = owners_.begin(); it != owners_.end();) {
+      it = it->second == instance ? owners_.erase(it) : std::next(it);
+    }
+    std::deque<Sequence> sequences;
+    if (auto found = handed_over_.find(instance);
+        found != handed_over_.end()) {
+      sequences.swap(found->second);
+      handed_over_.erase(found);
+    }
+    return sequences;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, const SequenceWorker*> owners_;
+  std::unordered_map<const SequenceWorker*, std::deque<Sequence>> handed_over_;
+};
+
+/**
+ * @brief A SequenceWorker runs stateful models, such as decoders generating
+ * tokens, with continuous batching. Instead of running each batch to
+ * completion, it runs one step of every active sequence per iteration. New
+ * requests join at the next iteration boundary and finished sequences leave
+ * immediately so their slots are reused without waiting for the rest of the
+ * batch. There are batch size slots.
+ *
+ * Requests belong to a sequence by their "sequence_id" parameter (a string or
+ * an integer) and mark its first and last requests with the boolean
+ * "sequence_start" and "sequence_end" parameters. A sequence's requests run in
+ * order and its slot, and the state the worker keeps for it, is held between
+ * them until its last request is done. Requests without a sequence ID are
+ * sequences of one request. If a request sets the "stream" parameter, partial
+ * responses sent before its final one are passed to its callback. With many
+ * instances, a sequence's requests all run on the instance that started it
+ * (see SequenceRouter) and a sequence whose client goes away is ended even if
+ * it's idle.
+ */
+class SequenceWorker : public Worker {
+ public:
+  using Worker::Worker;
+
+  std::vector<std::unique_ptr<Batcher>> makeBatcher(
+    int num, ParameterMap* parameters, MemoryPool* pool) override {
+    return Worker::makeBatcher<SequenceBatcher>(num, parameters, pool);
+  }
+
+  /**
+   * @brief The main body of the worker runs iterations until it's stopped. It
+   * only blocks for new batches when no sequence has work to do.
+   *
+   * @param input_queue queue that receives incoming requests
+   */
+  void run(BatchPtrQueue* input_queue, const MemoryPool* pool) override {
+    this->status_ = WorkerStatus::Run;
+    const auto& name = this->getName();
+    AMDINFER_IF_LOGGING(const auto logger = this->getLogger();)
+    util::setThreadName(name);
+
+    slots_.clear();
+    slots_.resize(batch_size_);
+    router_ = SequenceRouter::get(input_queue);
+    bool stop = false;
+    while (true) {
+      // requests that arrived during the last iteration join this one. Ones
+      // handed over by other instances are older so they go first
+      for (auto& sequence : router_->take(this)) {
+        this->route(std::move(sequence));
+      }
+      BatchPtr batch;
+      while (!stop && input_queue->wait_dequeue_timed(batch, 0)) {
+        stop = !this->take(std::move(batch));
+      }
+      this->admit();
+
+      auto active = this->getActive();
+      this->dropCancelled(&active);
+      if (active.empty()) {
+        if (stop) {
+          break;
+        }
+        const auto waiting = std::chrono::steady_clock::now();
+        // other instances may hand over requests of this instance's idle
+        // sequences so check for them periodically instead of blocking
+        bool dequeued_batch = true;
+        this->spinForBatch(*input_queue);
+        if (router_->owns(this)) {
+          dequeued_batch =
+            input_queue->wait_dequeue_timed(batch, kHandOverWait);
+        } else {
+          input_queue->wait_dequeue(batch);
+        }
+        const auto dequeued = std::chrono::steady_clock::now();
+        this->addIdleTime(dequeued - waiting);
+        if (dequeued_batch) {
+          profileEvent("queue wait", "worker", waiting, dequeued);
+          stop = !this->take(std::move(batch));
+        }
+        continue;
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      this->step(active, pool);
+      this->addBusyTime(std::chrono::steady_clock::now() - start);
+
+      for (auto* sequence : active) {
+        if (sequence->done) {
+          this->retire(sequence);
+        }
+      }
+    }
+
+    for (auto& sequence : router_->leave(this)) {
+      waiting_.push_back(std::move(sequence));
+    }
+    for (auto& sequence : waiting_) {
+      sequence.request->runCallbackError("The worker " + name + " stopped");
+    }
+    waiting_.clear();
+    for (auto& sequence : slots_) {
+      if (sequence != nullptr) {
+        this->doEndSequence(sequence.get());
+      }
+    }
+    slots_.clear();
+    ids_.clear();
+    router_.reset();
+
+    AMDINFER_LOG_INFO(logger, name + " ending");
+
+    status_ = WorkerStatus::Inactive;
+  }
+
+ protected:
+  /**
+   * @brief Send a response to the sequence's current request. Partial
+   * responses are dropped unless the request asked for them with the "stream"
+   * parameter. The request is done after its final response.
+   *
+   * @param sequence the sequence
+   * @param response the response
+   * @param final true if this is the request's last response
+   */
+  void respond(Sequence* sequence, InferenceResponse response, bool final) {
+    if (sequence->done || (!final && !sequence->stream)) {
+      return;
+    }
+    const auto& request = sequence->request;
+    response.setID(request->getID());
+    response.setModel(sequence->model);
+    response.setFinal(final);
+#ifdef AMDINFER_ENABLE_TRACING
+    if (sequence->trace != nullptr) {
+      response.setContext(sequence->trace->propagate());
+    }
+#endif
+    request->runCallback(response);
+    sequence->done = final;
+  }
+
+ private:
+  /**
+   * @brief Prepare the state for a new sequence. By default, nothing is done
+   *
+   * @param sequence the sequence. Its first request is set
+   */
+  virtual void doStartSequence([[maybe_unused]] Sequence* sequence) {}
+  /**
+   * @brief Run one iteration of the active sequences. Each sequence gets at
+   * most one step and a sequence's request is done once it's sent its final
+   * response with respond().
+   *
+   * @param sequences the sequences whose current requests aren't done
+   * @param pool the memory pool
+   */
+  virtual void doStep(const std::vector<Sequence*>& sequences,
+                      const MemoryPool* pool) = 0;
+  /**
+   * @brief Drop the state of a sequence that ended. By default, nothing is
+   * done
+   *
+   * @param sequence the sequence
+   */
+  virtual void doEndSequence([[maybe_unused]] Sequence* sequence) {}
+
+  /**
+   * @brief Run a batch as one-shot sequences until all of them are done. This
+   * is used by warm-up since batches from the batcher are run by run()
+   *
+   * @param batch the batch
+   * @param pool the memory pool
+   * @return BatchPtr - nullptr since sequence workers can't be chained
+   */
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) final {
+    std::vector<Sequence> sequences(batch->size());
+    std::vector<Sequence*> active;
+    for (auto i = 0U; i < batch->size(); ++i) {
+      auto& sequence = sequences[i];
+      sequence.slot = i;
+      sequence.request = batch->getRequest(i);
+      sequence.model = batch->getModel(i);
+      this->doStartSequence(&sequence);
+      active.push_back(&sequence);
+    }
+    while (!active.empty()) {
+      this->step(active, pool);
+      active.erase(std::remove_if(active.begin(), active.end(),
+                                  [](const Sequence* sequence) {
+                                    return sequence->done;
+                                  }),
+                   active.end());
+    }
+    for (auto& sequence : sequences) {
+      this->doEndSequence(&sequence);
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Queue a batch's requests to join the running sequences
+   *
+   * @param batch the batch
+   * @return bool - false if the batch is the nullptr that stops the worker
+   */
+  bool take(BatchPtr batch) {
+    if (batch == nullptr) {
+      return false;
+    }
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordDequeue(batch.get());
+#endif
+    batch->markStage(ServerTiming::Started);
+    for (auto i = 0U; i < batch->size(); ++i) {
+      Sequence sequence;
+      sequence.request = batch->getRequest(i);
+      sequence.model = batch->getModel(i);
+      // requests leave at different iterations so each one owns its memory
+      sequence.inputs = batch->shareRequestBuffers(i);
+#ifdef AMDINFER_ENABLE_TRACING
+      sequence.trace = std::move(batch->getTrace(i));
+      if (sequence.trace != nullptr) {
+        sequence.trace->startSpan(this->getName().c_str());
+      }
+#endif
+#ifdef AMDINFER_ENABLE_METRICS
+      sequence.start_time = batch->getTime(i);
+#endif
+
+      const auto& parameters = sequence.request->getParameters();
+      try {
+        sequence.id = getSequenceId(parameters);
+      } catch (const std::exception&) {
+        sequence.request->runCallbackError(
+          "sequence_id must be a string or an integer");
+        continue;
+      }
+      if (!sequence.id.empty()) {
+        sequence.starting = getFlag(parameters, "sequence_start");
+        sequence.ending = getFlag(parameters, "sequence_end");
+      }
+      sequence.stream = getFlag(parameters, "stream");
+      sequence.cancelled = sequence.request->getCancellation();
+      this->route(std::move(sequence));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Queue a request to join the running sequences if this instance
+   * owns its sequence or hand it over to the instance that does
+   *
+   * @param sequence the request's sequence
+   */
+  void route(Sequence sequence) {
+    if (!sequence.id.empty()) {
+      const auto* owner = router_->claim(sequence.id, this);
+      if (owner != this) {
+        router_->handOver(owner, std::move(sequence));
+        return;
+      }
+    }
+    waiting_.push_back(std::move(sequence));
+  }
+
+  /**
+   * @brief Move waiting requests into slots. A request continues its
+   * sequence's slot once the sequence's previous request is done or starts a
+   * new sequence in a free slot. Requests of the same sequence keep their
+   * order.
+   */
+  void admit() {
+    std::unordered_set<std::string> blocked;
+    auto free = slots_.begin();
+    for (auto it = waiting_.begin(); it != waiting_.end();) {
+      auto& sequence = *it;
+      if (!sequence.id.empty() && blocked.count(sequence.id) != 0) {
+        ++it;
+        continue;
+      }
+
+      std::unique_ptr<Sequence>* slot = nullptr;
+      const auto found =
+        sequence.id.empty() ? ids_.end() : ids_.find(sequence.id);
+      if (found != ids_.end()) {
+        auto& running = slots_[found->second];
+        if (running->request == nullptr) {
+          slot = &running;
+          if (sequence.starting) {
+            // the client restarted the sequence without ending it
+            this->doEndSequence(running.get());
+          }
+        }
+      } else {
+        free = std::find(free, slots_.end(), nullptr);
+        if (free != slots_.end()) {
+          slot = &(*free);
+          // a request for a sequence that isn't running starts it
+          sequence.starting = true;
+        }
+      }
+      if (slot == nullptr) {
+        blocked.insert(sequence.id);
+        ++it;
+        continue;
+      }
+
+      sequence.slot = static_cast<size_t>(slot - slots_.data());
+      *slot = std::make_unique<Sequence>(std::move(sequence));
+      it = waiting_.erase(it);
+      this->start(slot->get());
+    }
+  }
+
+  /**
+   * @brief Start running a request that was just put in its slot
+   *
+   * @param sequence the sequence in the slot
+   */
+  void start(Sequence* sequence) {
+    if (!sequence->id.empty()) {
+      ids_[sequence->id] = sequence->slot;
+    }
+    if (!sequence->starting) {
+      return;
+    }
+    try {
+      this->doStartSequence(sequence);
+    } catch (const std::exception& e) {
+      this->respond(sequence, InferenceResponse{e.what()}, true);
+      sequence->ending = true;
+      this->retire(sequence);
+    }
+  }
+
+  /// Run one step of the sequences and fail them all if it throws
+  void step(const std::vector<Sequence*>& sequences, const MemoryPool* pool) {
+    ProfileScope scope{"doStep", "worker"};
+    try {
+      this->doStep(sequences, pool);
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_ERROR(this->getLogger(), e.what());
+      for (auto* sequence : sequences) {
+        this->respond(sequence, InferenceResponse{e.what()}, true);
+        sequence->ending = true;
+      }
+    }
+    for (auto* sequence : sequences) {
+      sequence->iteration++;
+    }
+  }
+
+  /**
+   * @brief Release a finished request and free its sequence's slot if it was
+   * the sequence's last request
+   *
+   * @param sequence the sequence in the slot
+   */
+  void retire(Sequence* sequence) {
+#ifdef AMDINFER_ENABLE_METRICS
+    if (metrics_ != nullptr) {
+      metrics_->incrementCounter(MetricCounterIDs::PipelineEgressWorker);
+      metrics_->observeHistogram(
+        MetricHistogramIDs::RequestLatency,
+        util::elapsed<std::micro>(sequence->start_time));
+    }
+#endif
+#ifdef AMDINFER_ENABLE_TRACING
+    if (sequence->trace != nullptr) {
+      sequence->trace->endSpan();
+      sequence->trace.reset();
+    }
+#endif
+    sequence->request.reset();
+    sequence->inputs.reset();
+    sequence->iteration = 0;
+    sequence->done = false;
+    if (!sequence->ending) {
+      return;
+    }
+
+    this->doEndSequence(sequence);
+    if (!sequence->id.empty()) {
+      ids_.erase(sequence->id);
+      router_->release(sequence->id, this);
+    }
+    slots_[sequence->slot].reset();
+  }
+
+  /**
+   * @brief Fail and retire the active sequences whose requests were cancelled
+   * so they don't take another step. Their sequences end since their clients
+   * are gone.
+   *
+   * @param active the active sequences. The cancelled ones are removed
+   */
+  void dropCancelled(std::vector<Sequence*>* active) {
+    const auto cancelled = std::stable_partition(
+      active->begin(), active->end(), [](const Sequence* sequence) {
+        return !sequence->request->isCancelled();
+      });
+    for (auto it = cancelled; it != active->end(); ++it) {
+      this->respond(*it, InferenceResponse{"Request cancelled"}, true);
+      (*it)->ending = true;
+      this->retire(*it);
+    }
+    active->erase(cancelled, active->end());
+
+    // idle sequences whose clients went away won't get their last request
+    for (auto& sequence : slots_) {
+      if (sequence != nullptr && sequence->request == nullptr &&
+          sequence->cancelled != nullptr && sequence->cancelled->load()) {
+        this->doEndSequence(sequence.get());
+        ids_.erase(sequence->id);
+        router_->release(sequence->id, this);
+        sequence.reset();
+      }
+    }
+  }
+
+  /// Get the sequences whose current requests aren't done
+  std::vector<Sequence*> getActive() const {
+    std::vector<Sequence*> active;
+    for (const auto& sequence : slots_) {
+      if (sequence != nullptr && sequence->request != nullptr) {
+        active.push_back(sequence.get());
+      }
+    }
+    return active;
+  }
+
+  static std::string getSequenceId(const ParameterMap& parameters) {
+    if (!parameters.has("sequence_id")) {
+      return "";
+    }
+    try {
+      return parameters.get<std::string>("sequence_id");
+    } catch (const std::bad_variant_access&) {
+      return std::to_string(parameters.get<int32_t>("sequence_id"));
+    }
+  }
+
+  static bool getFlag(const ParameterMap& parameters, std::string_view key) {
+    return parameters.has(key) && parameters.get<bool>(key);
+  }
+
+  /// How long, in microseconds, an idle instance waits for batches before
+  /// checking for requests handed over by other instances
+  static constexpr int64_t kHandOverWait = 1000;
+
+  using Worker::status_;
+  // the sequences running in each slot or nullptr for free slots
+  std::vector<std::unique_ptr<Sequence>> slots_;
+  // the slot running each sequence by ID
+  std::unordered_map<std::string, size_t> ids_;
+  // requests waiting for their sequence's slot or a free one, in order
+  std::deque<Sequence> waiting_;
+  // shared with the other instances of the endpoint
+  std::shared_ptr<SequenceRouter> router_;
 };
 
 }  // namespace workers
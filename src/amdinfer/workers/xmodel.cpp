@@ -20,15 +20,16 @@
 
 #include <cxxabi.h>  // for __forced_unwind
 
-#include <algorithm>                    // for copy, copy_backward
+#include <algorithm>                    // for max
 #include <atomic>                       // for atomic_int32_t
+#include <cassert>                      // for assert
+#include <chrono>                       // for duration, seconds
 #include <cstddef>                      // for size_t, byte
 #include <cstdint>                      // for uint64_t, uint32_t
 #include <cstdlib>                      // for getenv
 #include <cstring>                      // for memcpy
 #include <ext/alloc_traits.h>           // for __alloc_traits<>::...
 #include <memory>                       // for unique_ptr, allocator
-#include <queue>                        // for queue
 #include <ratio>                        // for micro
 #include <string>                       // for string, operator!=
 #include <thread>                       // for thread, sleep_for
@@ -57,10 +58,10 @@
 #include "amdinfer/util/containers.hpp"           // for containerProduct
 #include "amdinfer/util/memory.hpp"               // for copy
 #include "amdinfer/util/parse_env.hpp"            // for autoExpandEnvironm...
-#include "amdinfer/util/queue.hpp"                // for BufferPtrsQueue
+#include "amdinfer/util/queue.hpp"                // for BlockingQueue
 #include "amdinfer/util/thread.hpp"               // for setThreadName
-#include "amdinfer/util/timer.hpp"                // for Timer
-#include "amdinfer/workers/worker.hpp"            // for Worker, kNumBuffer...
+#include "amdinfer/util/timestamps.hpp"           // for Timestamp, now
+#include "amdinfer/workers/worker.hpp"            // for Worker
 
 namespace amdinfer::workers {
 
@@ -69,35 +70,112 @@ namespace amdinfer::workers {
  * the DPU subgraph associated with the XModel. The incoming requests are sent
  * to the FPGA using the Vitis AI runtime libraries.
  *
+ * The worker can create several runners, such as one per DPU core, and sends
+ * each batch to the runner with the fewest jobs in flight. Batches are
+ * pipelined through the runners: one thread prepares and submits jobs while
+ * a thread per runner waits for its jobs in order and copies out their
+ * outputs so preparing, executing and copying out batches overlap. The
+ * runners write their outputs to host memory so if the next worker runs on the
+ * CPU, the output buffers are handed to it and it frees them instead.
  */
-class XModel : public MultiThreadedWorker {
+class XModel : public Worker {
  public:
-  using MultiThreadedWorker::MultiThreadedWorker;
+  using Worker::Worker;
   [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
 
+  void run(BatchPtrQueue* input_queue, const MemoryPool* pool) override;
+
  private:
+  struct Instance;
+
+  /// A batch submitted to a runner
+  struct Job {
+    /// Held while the job is in flight when the batch is pipelined
+    BatchPtr batch;
+    Instance* instance = nullptr;
+    std::pair<uint32_t, int> id;
+    BufferPtrs output_buffers;
+    std::vector<vart::TensorBuffer*> outputs;
+    /// The outputs each request asked for
+    std::vector<std::vector<size_t>> selected;
+    /// Index of each output's buffer in next_buffers, if any request wants it
+    std::vector<int> slots;
+    /// Buffers for the next worker holding only the requested outputs
+    BufferPtrs next_buffers;
+    /// If true, the requested output buffers are handed to the next worker
+    /// instead of being copied into next_buffers
+    bool hand_off = false;
+    /// The endpoint's turn on the DPU if it shares it with other endpoints
+    std::shared_ptr<void> turn;
+#ifdef AMDINFER_ENABLE_METRICS
+    util::Timestamp submitted;
+#endif
+  };
+  using JobPtr = std::unique_ptr<Job>;
+
+  /// One runner and the jobs in flight on it
+  struct Instance {
+    std::unique_ptr<vart::Runner> runner;
+    BlockingQueue<JobPtr> in_flight;
+    std::atomic_int32_t jobs = 0;
+#ifdef AMDINFER_ENABLE_METRICS
+    std::atomic<double> utilization = 0;
+#endif
+  };
+
   void doInit(ParameterMap* parameters) override;
   void doAcquire(ParameterMap* parameters) override;
   BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
   void doRelease() override;
   void doDestroy() override;
 
-  vart::RunnerExt* getRunner();
+  /// The metadata's input shapes include the batch size
+  [[nodiscard]] std::vector<Tensor> getWarmupInputs() const override {
+    return dropBatchDimension(metadata_.getInputs());
+  }
+
+  static vart::RunnerExt* getRunner(const Instance& instance);
+  /// Get the runner with the fewest jobs in flight
+  Instance* leastLoaded();
+
+  /// Prepare and submit a batch, responding with errors if it fails
+  bool submit(Batch* batch, const MemoryPool* pool, Job* job);
+  /// Wait for a job and copy out its outputs into a batch for the next worker
+  BatchPtr complete(Batch* batch, Job* job);
+  /// Complete a runner's jobs in submission order until a null job arrives
+  void completeJobs(Instance* instance, BlockingQueue<JobPtr>* free_jobs);
 
   std::unique_ptr<xir::Graph> graph_;
   const xir::Subgraph* subgraph_ = nullptr;
   std::string kernel_;
-  std::unique_ptr<vart::Runner> runner_;
+  std::vector<std::unique_ptr<Instance>> instances_;
+  std::vector<const xir::Tensor*> output_tensors_;
+  std::vector<std::string> output_names_;
   std::vector<DataType> output_type_;
   std::vector<uint32_t> output_size_;
+  /// Most jobs to keep in flight on each runner
+  int jobs_ = 0;
+#ifdef AMDINFER_ENABLE_METRICS
+  std::atomic_int32_t jobs_in_flight_ = 0;
+#endif
 };
 
 std::vector<MemoryAllocators> XModel::getAllocators() const {
   return {MemoryAllocators::VartTensor};
 }
 
-vart::RunnerExt* XModel::getRunner() {
-  return dynamic_cast<vart::RunnerExt*>(this->runner_.get());
+vart::RunnerExt* XModel::getRunner(const Instance& instance) {
+  return dynamic_cast<vart::RunnerExt*>(instance.runner.get());
+}
+
+XModel::Instance* XModel::leastLoaded() {
+  auto* least = instances_.front().get();
+  for (const auto& instance : instances_) {
+    if (instance->jobs < least->jobs) {
+      least = instance.get();
+    }
+  }
+  return least;
 }
 
 void XModel::doInit(ParameterMap* parameters) {
@@ -114,7 +192,8 @@ void XModel::doInit(ParameterMap* parameters) {
     path = parameters->get<std::string>("model");
   }
   util::autoExpandEnvironmentVariables(path);
-  graph_ = xir::Graph::deserialize(path);
+  graph_ = this->timeLoadPhase(LoadPhase::ReadModel,
+                               [&]() { return xir::Graph::deserialize(path); });
 
   auto subgraphs = graph_->get_root_subgraph()->children_topological_sort();
   std::vector<const xir::Subgraph*> dpu_graphs;
@@ -142,16 +221,39 @@ void XModel::doInit(ParameterMap* parameters) {
 }
 
 void XModel::doAcquire(ParameterMap* parameters) {
-  constexpr auto kThreads = 3;
+  constexpr auto kJobs = 3;
+  constexpr auto kRunners = 1;
+
+  jobs_ = kJobs;
+  if (parameters->has("jobs")) {
+    jobs_ = parameters->get<int32_t>("jobs");
+  } else if (parameters->has("threads")) {
+    // each thread used to keep one job in flight
+    jobs_ = parameters->get<int32_t>("threads");
+  }
+  if (jobs_ < 1) {
+    throw invalid_argument("The XModel worker needs at least one job");
+  }
 
-  auto threads = kThreads;
-  if (parameters->has("threads")) {
-    threads = parameters->get<int32_t>("threads");
+  // runners are assigned to the DPU cores as they're created so making one
+  // per core spreads the batches over all of them
+  auto runners = kRunners;
+  if (parameters->has("runners")) {
+    runners = parameters->get<int32_t>("runners");
   }
-  this->createThreadPool(threads);
+  if (runners < 1) {
+    throw invalid_argument("The XModel worker needs at least one runner");
+  }
+  this->timeLoadPhase(LoadPhase::CreateRunner, [&]() {
+    for (auto i = 0; i < runners; ++i) {
+      auto instance = std::make_unique<Instance>();
+      instance->runner = vart::Runner::create_runner(this->subgraph_, "run");
+      instances_.push_back(std::move(instance));
+    }
+  });
 
-  runner_ = vart::Runner::create_runner(this->subgraph_, "run");
-  auto input_tensors = runner_->get_input_tensors();
+  const auto& runner = instances_.front()->runner;
+  auto input_tensors = runner->get_input_tensors();
   // populate the tensor metadata
   for (const auto* tensor : input_tensors) {
     auto input_shape = tensor->get_shape();
@@ -160,9 +262,10 @@ void XModel::doAcquire(ParameterMap* parameters) {
     this->metadata_.addInputTensor(tensor->get_name(), input_shape, input_type);
   }
 
-  auto output_tensors = runner_->get_output_tensors();
-  for (const auto* tensor : output_tensors) {
+  output_tensors_ = runner->get_output_tensors();
+  for (const auto* tensor : output_tensors_) {
     auto output_shape = tensor->get_shape();
+    output_names_.push_back(tensor->get_name());
     output_type_.emplace_back(mapXirToType(tensor->get_data_type()));
     // +1 to skip the batch size
     output_size_.emplace_back(
@@ -173,58 +276,217 @@ void XModel::doAcquire(ParameterMap* parameters) {
   }
 }
 
+void XModel::run(BatchPtrQueue* input_queue, const MemoryPool* pool) {
+  this->status_ = WorkerStatus::Run;
+  const auto& name = this->getName();
+  AMDINFER_IF_LOGGING(const auto logger = this->getLogger());
+  util::setThreadName(name);
+
+  // jobs are recycled between the threads so, since each batch goes to the
+  // least loaded runner, at most jobs_ are in flight on each runner
+  BlockingQueue<JobPtr> free_jobs;
+  const auto total_jobs = jobs_ * static_cast<int>(instances_.size());
+  for (auto i = 0; i < total_jobs; ++i) {
+    free_jobs.enqueue(std::make_unique<Job>());
+  }
+  std::vector<std::thread> completers;
+  completers.reserve(instances_.size());
+  for (const auto& instance : instances_) {
+    completers.emplace_back(&XModel::completeJobs, this, instance.get(),
+                            &free_jobs);
+  }
+
+  while (true) {
+    BatchPtr batch;
+    input_queue->wait_dequeue(batch);
+    if (batch == nullptr) {
+      break;
+    }
+    if (this->dropCancelled(*batch)) {
+      continue;
+    }
+
+#ifdef AMDINFER_ENABLE_TRACING
+    batch->startSpan(name);
+#endif
+
+    AMDINFER_LOG_INFO(logger, "Got request in " + name);
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordDequeue(batch.get());
+#endif
+
+    JobPtr job;
+    free_jobs.wait_dequeue(job);
+    // the clients may have given up while the batch waited for a free job
+    if (this->dropCancelled(*batch)) {
+      free_jobs.enqueue(std::move(job));
+      continue;
+    }
+    // the completer ends the turn once the batch is done on the DPU
+    job->turn = this->takeDeviceTurn();
+    batch->markStage(ServerTiming::Started);
+    if (this->submit(batch.get(), pool, job.get())) {
+      job->batch = std::move(batch);
+      job->instance->in_flight.enqueue(std::move(job));
+    } else {
+      job->turn.reset();
+      batch->freeInputBuffers();
+      free_jobs.enqueue(std::move(job));
+    }
+  }
+
+  // the completers finish the jobs in flight before they see the null job
+  for (const auto& instance : instances_) {
+    instance->in_flight.enqueue(nullptr);
+  }
+  for (auto& completer : completers) {
+    completer.join();
+  }
+
+  AMDINFER_LOG_INFO(logger, name + " ending");
+
+  status_ = WorkerStatus::Inactive;
+}
+
+void XModel::completeJobs(Instance* instance,
+                          BlockingQueue<JobPtr>* free_jobs) {
+  util::setThreadName(this->getName() + "-wait");
+#ifdef AMDINFER_ENABLE_METRICS
+  // the runner is busy when it has any job in flight. Jobs complete in the
+  // order they're submitted so the busy intervals are merged as they finish
+  constexpr std::chrono::seconds kUtilizationWindow{1};
+  auto window_start = util::now();
+  auto last_done = window_start;
+  std::chrono::duration<double> busy{0};
+#endif
+
+  while (true) {
+    JobPtr job;
+    instance->in_flight.wait_dequeue(job);
+    if (job == nullptr) {
+      break;
+    }
+
+    auto* batch = job->batch.get();
+    [[maybe_unused]] auto batch_size = batch->size();
+    auto new_batch = this->complete(batch, job.get());
+    job->turn.reset();
+
+#ifdef AMDINFER_ENABLE_METRICS
+    this->recordCompute(*batch, new_batch.get());
+    const auto done = util::now();
+    busy += done - std::max(job->submitted, last_done);
+    last_done = done;
+    if (const auto window = done - window_start; window >= kUtilizationWindow) {
+      instance->utilization = busy / std::chrono::duration<double>{window};
+      // report the mean over the runners
+      double utilization = 0;
+      for (const auto& other : instances_) {
+        utilization += other->utilization;
+      }
+      if (metrics_ != nullptr) {
+        metrics_->setGauge(
+          MetricGaugeIDs::XmodelUtilization,
+          utilization / static_cast<double>(instances_.size()));
+      }
+      window_start = done;
+      busy = busy.zero();
+    }
+#endif
+
+    if (next_ != nullptr && new_batch != nullptr) {
+      assert(new_batch->size() == batch_size);
+#ifdef AMDINFER_ENABLE_TRACING
+      batch->endSpan();
+      for (auto i = 0U; i < batch_size; ++i) {
+        new_batch->addTrace(std::move(batch->getTrace(i)));
+      }
+#endif
+
+#ifdef AMDINFER_ENABLE_METRICS
+      for (auto i = 0U; i < batch_size; ++i) {
+        new_batch->addTime(batch->getTime(i));
+      }
+#endif
+
+      next_->enqueue(std::move(new_batch));
+    }
+
+    batch->freeInputBuffers();
+    job->batch.reset();
+    free_jobs->enqueue(std::move(job));
+  }
+}
+
 BatchPtr XModel::doRun(Batch* batch, const MemoryPool* pool) {
+  // the unpipelined path: submit the batch and wait for it
+  Job job;
+  if (!this->submit(batch, pool, &job)) {
+    return nullptr;
+  }
+  return this->complete(batch, &job);
+}
+
+bool XModel::submit(Batch* batch, const MemoryPool* pool, Job* job) {
   const auto& input_buffers = batch->getInputBuffers();
-  // const auto& output_buffers = batch->getOutputBuffers();
 
 #ifdef AMDINFER_ENABLE_LOGGING
   for (const auto& buffer : input_buffers) {
     logTraceBuffer(getLogger(), buffer->data(0));
   }
 #endif  // AMDINFER_ENABLE_LOGGING
-  BatchPtr new_batch = nullptr;
-  BufferPtrs output_buffers;
-  BufferPtrs new_input_buffers;
   try {
+    // requests are bound to the model's input tensors when they arrive so
+    // input buffer i is for the runner's input tensor i
     std::vector<vart::TensorBuffer*> inputs_ptr;
-    for (unsigned i = 0; i < input_buffers.size(); i++) {
-      const auto& buffer = input_buffers[i];
+    inputs_ptr.reserve(input_buffers.size());
+    for (const auto& buffer : input_buffers) {
       auto* vart = dynamic_cast<VartTensorBuffer*>(buffer.get());
-      // Check if model tensor name equals input tensor name
-      const auto* runner_buffer = runner_->get_input_tensors()[i];
-      if (vart->getTensorBuffer()->get_tensor()->get_name() !=
-          runner_buffer->get_name()) {
-        throw std::runtime_error(
-          "input tensor name ('" +
-          vart->getTensorBuffer()->get_tensor()->get_name() +
-          "') does not equal model tensor name ('" + runner_buffer->get_name() +
-          "')!");
-      }
       inputs_ptr.emplace_back(vart->getTensorBuffer());
     }
 
-    auto output_tensors = this->getRunner()->get_output_tensors();
+    job->output_buffers.clear();
+    job->next_buffers.clear();
+    job->outputs.clear();
+    job->selected.clear();
+    job->slots.assign(output_tensors_.size(), -1);
+    job->hand_off = !next_allocators_.empty() &&
+                    (next_allocators_.front() == MemoryAllocators::Cpu ||
+                     next_allocators_.front() == MemoryAllocators::VartTensor);
+    std::vector<bool> requested(output_tensors_.size(), false);
+    for (const auto& request : batch->getRequests()) {
+      for (auto i : job->selected.emplace_back(
+             selectOutputs(*request, output_names_))) {
+        requested[i] = true;
+      }
+    }
 
-    for (const auto* tensor : output_tensors) {
+    int next_buffers = 0;
+    for (auto i = 0U; i < output_tensors_.size(); ++i) {
+      const auto* tensor = output_tensors_[i];
       auto xir_shape = tensor->get_shape();
-      std::vector<int64_t> shape{xir_shape.begin(), xir_shape.end()};
+      Shape shape(xir_shape.begin(), xir_shape.end());
       auto xir_type = tensor->get_data_type();
       auto type = mapXirToType(xir_type);
       InferenceRequestInput input(nullptr, shape, type, tensor->get_name());
       // the shape includes the batch size so use external batch size 1
-      output_buffers.push_back(
+      job->output_buffers.push_back(
         pool->get({MemoryAllocators::VartTensor}, input, 1));
-      new_input_buffers.push_back(pool->get(next_allocators_, input, 1));
+      // the runner writes every output but only the requested ones are
+      // passed to the next worker
+      if (requested[i]) {
+        job->slots[i] = next_buffers++;
+        if (!job->hand_off) {
+          job->next_buffers.push_back(pool->get(next_allocators_, input, 1));
+        }
+      }
     }
 
-    std::vector<vart::TensorBuffer*> outputs_ptr;
-    for (const auto& buffer : output_buffers) {
+    for (const auto& buffer : job->output_buffers) {
       auto* vart = dynamic_cast<VartTensorBuffer*>(buffer.get());
-      outputs_ptr.emplace_back(vart->getTensorBuffer());
+      job->outputs.emplace_back(vart->getTensorBuffer());
     }
 
-    // auto outputs_ptr = this->getRunner()->get_outputs();
-
     for (auto* input : inputs_ptr) {
       const auto* tensor = input->get_tensor();
       auto num = tensor->get_element_num();
@@ -232,16 +494,48 @@ BatchPtr XModel::doRun(Batch* batch, const MemoryPool* pool) {
       input->sync_for_write(0, num / batches);
     }
 
-    std::queue<std::pair<uint32_t, int>> futures;
-    futures.push(getRunner()->execute_async(inputs_ptr, outputs_ptr));
-
-    while (!futures.empty()) {
-      auto job_id = futures.front();
-      futures.pop();
-      getRunner()->wait(job_id.first, -1);
+    job->instance = this->leastLoaded();
+    job->id =
+      getRunner(*job->instance)->execute_async(inputs_ptr, job->outputs);
+    job->instance->jobs++;
+#ifdef AMDINFER_ENABLE_METRICS
+    job->submitted = util::now();
+    const auto jobs = ++jobs_in_flight_;
+    if (metrics_ != nullptr) {
+      metrics_->setGauge(MetricGaugeIDs::XmodelJobs, jobs);
+    }
+#endif
+  } catch (const std::exception& e) {
+    // This outer catch block catches exceptions in evaluation of the batch.
+    AMDINFER_LOG_ERROR(getLogger(), e.what());
+    for (const auto& buffer : job->output_buffers) {
+      buffer->free();
+    }
+    for (const auto& buffer : job->next_buffers) {
+      buffer->free();
     }
+    // Pass error message back as reply for each request in the batch
+    const auto& requests = batch->getRequests();
+    for (const auto& req_e : requests) {
+      req_e->runCallbackError(std::string("Xmodel inference error: ") +
+                              e.what());
+    }
+    return false;
+  }
+  return true;
+}
 
-    for (auto* output : outputs_ptr) {
+BatchPtr XModel::complete(Batch* batch, Job* job) {
+  BatchPtr new_batch = nullptr;
+  const auto& outputs_ptr = job->outputs;
+  try {
+    getRunner(*job->instance)->wait(job->id.first, -1);
+
+    for (auto i = 0U; i < outputs_ptr.size(); ++i) {
+      if (job->slots[i] < 0) {
+        continue;
+      }
+      auto* output = outputs_ptr[i];
       const auto* tensor = output->get_tensor();
       output->sync_for_read(
         0, tensor->get_element_num() / (tensor->get_shape())[0]);
@@ -254,34 +548,33 @@ BatchPtr XModel::doRun(Batch* batch, const MemoryPool* pool) {
 
       auto new_request = req->propagate();
 
-      const auto num_outputs = outputs_ptr.size();
-      for (unsigned int i = 0; i < num_outputs; i++) {
-        auto output_shape = output_tensors[i]->get_shape();
-        std::vector<int64_t> new_shape;
+      for (auto i : job->selected.at(k)) {
+        auto output_shape = output_tensors_[i]->get_shape();
+        Shape new_shape;
         new_shape.reserve(output_shape.size() - 1);
         for (auto j = 1U; j < output_shape.size(); j++) {
           new_shape.push_back(output_shape[j]);
         }
+        const auto size = output_size_[i] * output_type_[i].size();
         auto* output_index =
-          reinterpret_cast<void*>(outputs_ptr.at(i)->data().first);
-
-        auto* data_ptr = new_input_buffers.at(i)->data(
-          k * output_size_[i] * (output_type_[i]).size());
-        new_request->addInputTensor(
-          InferenceRequestInput{data_ptr, new_shape, output_type_[i], ""});
-        util::copy(
-          reinterpret_cast<int8_t*>(output_index) + (i * output_size_[i]),
-          static_cast<std::byte*>(data_ptr),
-          output_size_[i] * output_type_[i].size());
+          reinterpret_cast<std::byte*>(outputs_ptr.at(i)->data().first) +
+          (k * size);
+        if (job->hand_off) {
+          new_request->addInputTensor(InferenceRequestInput{
+            output_index, new_shape, output_type_[i], output_names_[i]});
+          continue;
+        }
+
+        auto* data_ptr = job->next_buffers.at(job->slots[i])->data(k * size);
+        new_request->addInputTensor(InferenceRequestInput{
+          data_ptr, new_shape, output_type_[i], output_names_[i]});
+        util::copy(output_index, static_cast<std::byte*>(data_ptr), size);
       }
 
       new_batch->addRequest(new_request);
 
       new_batch->setModel(k, "xmodel");
     }
-    for (const auto& buffer : output_buffers) {
-      buffer->free();
-    }
   } catch (const std::exception& e) {
     // This outer catch block catches exceptions in evaluation of the batch.
     AMDINFER_LOG_ERROR(getLogger(), e.what());
@@ -291,18 +584,42 @@ BatchPtr XModel::doRun(Batch* batch, const MemoryPool* pool) {
       req_e->runCallbackError(std::string("Xmodel inference error: ") +
                               e.what());
     }
+    new_batch = nullptr;
+  }
+  job->instance->jobs--;
+#ifdef AMDINFER_ENABLE_METRICS
+  const auto jobs = --jobs_in_flight_;
+  if (metrics_ != nullptr) {
+    metrics_->setGauge(MetricGaugeIDs::XmodelJobs, jobs);
+  }
+#endif
+
+  // the requested outputs are freed by the next worker if they're handed off
+  for (auto i = 0U; i < job->output_buffers.size(); ++i) {
+    auto& buffer = job->output_buffers[i];
+    if (new_batch != nullptr && job->hand_off && job->slots[i] >= 0) {
+      job->next_buffers.push_back(std::move(buffer));
+    } else {
+      buffer->free();
+    }
   }
+  job->output_buffers.clear();
+  job->outputs.clear();
 
   if (new_batch == nullptr) {
+    for (const auto& buffer : job->next_buffers) {
+      buffer->free();
+    }
+    job->next_buffers.clear();
     return new_batch;
   }
 
-  new_batch->setBuffers(std::move(new_input_buffers), {});
+  new_batch->setBuffers(std::move(job->next_buffers), {});
 
   return new_batch;
 }
 
-void XModel::doRelease() { this->destroyThreadPool(); }
+void XModel::doRelease() { instances_.clear(); }
 void XModel::doDestroy() {}
 
 }  // namespace amdinfer::workers
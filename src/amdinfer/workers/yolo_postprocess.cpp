@@ -0,0 +1,352 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Implements the YoloPostprocess worker
+ */
+
+#include <algorithm>  // for min, max, stable_sort
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int32_t, int64_t
+#include <exception>  // for exception
+#include <memory>     // for allocator
+#include <numeric>    // for iota
+#include <string>     // for string, to_string, stof
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/build_options.hpp"              // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"            // for DataType
+#include "amdinfer/core/exceptions.hpp"            // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"     // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"    // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"            // for ParameterMap
+#include "amdinfer/declarations.hpp"               // for BufferPtr
+#include "amdinfer/observation/logging.hpp"        // for Logger
+#include "amdinfer/pre_post/yolo_postprocess.hpp"  // for decodeYolo
+#include "amdinfer/util/string.hpp"                // for split
+#include "amdinfer/workers/worker.hpp"             // for MultiThreadedWorker
+
+namespace amdinfer::workers {
+
+namespace {
+
+/// Parse a comma-separated list of numbers
+std::vector<float> parseFloats(const std::string& values,
+                               const std::string& name) {
+  std::vector<float> parsed;
+  try {
+    for (const auto& item : util::split(values, ",")) {
+      parsed.push_back(std::stof(item));
+    }
+  } catch (const std::exception&) {
+    throw invalid_argument(name + " must be a list of numbers");
+  }
+  return parsed;
+}
+
+// each box is x1, y1, x2, y2, score and label
+constexpr auto kBoxSize = 6;
+
+}  // namespace
+
+/**
+ * @brief The YoloPostprocess worker turns the outputs of a YOLO model into
+ * the boxes of the detected objects. It's meant to be chained after the model
+ * with the "next" load-time parameter so detection runs on the server and
+ * clients receive a few boxes per image instead of every grid cell.
+ *
+ */
+class YoloPostprocess : public MultiThreadedWorker {
+ public:
+  using MultiThreadedWorker::MultiThreadedWorker;
+  [[nodiscard]] std::vector<MemoryAllocators> getAllocators() const override;
+  [[nodiscard]] std::vector<MemoryReservation> getReservations()
+    const override;
+
+ private:
+  void doInit(ParameterMap* parameters) override;
+  void doAcquire(ParameterMap* parameters) override;
+  BatchPtr doRun(Batch* batch, const MemoryPool* pool) override;
+  void doRelease() override;
+  void doDestroy() override;
+
+  /// Get the tensors of one request's outputs
+  [[nodiscard]] std::vector<Tensor> getOutputTensors() const;
+
+  /// Detect the boxes in one request's outputs
+  size_t detect(const InferenceRequest& request, float* boxes) const;
+
+  pre_post::YoloOptions options_;
+  // at most this many boxes are returned per request
+  size_t max_boxes_ = 100;
+  int32_t threads_ = 1;
+  // CPUs the worker is pinned to
+  std::vector<int> cpus_;
+};
+
+std::vector<MemoryAllocators> YoloPostprocess::getAllocators() const {
+  return {MemoryAllocators::Cpu};
+}
+
+std::vector<MemoryReservation> YoloPostprocess::getReservations() const {
+  // the shapes of the model's outputs aren't known until they arrive so only
+  // the outputs are reserved
+  return this->reserveBatches({}, this->getOutputTensors());
+}
+
+std::vector<Tensor> YoloPostprocess::getOutputTensors() const {
+  return {Tensor{"boxes",
+                 {static_cast<int64_t>(max_boxes_), kBoxSize},
+                 DataType::Fp32}};
+}
+
+void YoloPostprocess::doInit(ParameterMap* parameters) {
+  constexpr auto kBatchSize = 1;
+  constexpr auto kMaxBoxes = 100;
+
+  auto batch_size = kBatchSize;
+  if (parameters->has("batch_size")) {
+    batch_size = parameters->get<int32_t>("batch_size");
+  }
+  this->batch_size_ = batch_size;
+
+  if (parameters->has("classes")) {
+    options_.classes = parameters->get<int32_t>("classes");
+  }
+  if (parameters->has("anchors")) {
+    options_.anchors = parameters->get<int32_t>("anchors");
+  }
+  if (options_.classes < 1 || options_.anchors < 1) {
+    throw invalid_argument("classes and anchors must be positive");
+  }
+  if (!parameters->has("biases")) {
+    throw invalid_argument("The biases of the anchors must be provided");
+  }
+  options_.biases =
+    parseFloats(parameters->get<std::string>("biases"), "biases");
+  if (options_.biases.empty() ||
+      options_.biases.size() % (2 * options_.anchors) != 0) {
+    throw invalid_argument(
+      "biases must have a width and height for each anchor of each output");
+  }
+  if (parameters->has("scale_xy")) {
+    options_.scale_xy =
+      parseFloats(parameters->get<std::string>("scale_xy"), "scale_xy");
+  }
+
+  if (parameters->has("net_height")) {
+    options_.net_height = parameters->get<int32_t>("net_height");
+  }
+  if (parameters->has("net_width")) {
+    options_.net_width = parameters->get<int32_t>("net_width");
+  }
+  if (parameters->has("conf_threshold")) {
+    options_.conf_threshold =
+      static_cast<float>(parameters->get<double>("conf_threshold"));
+  }
+  if (parameters->has("iou_threshold")) {
+    options_.iou_threshold =
+      static_cast<float>(parameters->get<double>("iou_threshold"));
+  }
+
+  if (parameters->has("scores")) {
+    const auto scores = parameters->get<std::string>("scores");
+    if (scores == "sigmoid") {
+      options_.scores = pre_post::YoloScores::Sigmoid;
+    } else if (scores == "softmax") {
+      options_.scores = pre_post::YoloScores::Softmax;
+    } else if (scores == "probabilities") {
+      options_.scores = pre_post::YoloScores::Probabilities;
+    } else {
+      throw invalid_argument("Unknown scores: " + scores);
+    }
+  }
+  if (parameters->has("layout")) {
+    const auto layout = parameters->get<std::string>("layout");
+    if (layout == "NCHW") {
+      options_.layout = pre_post::YoloLayout::NCHW;
+    } else if (layout == "NHWC") {
+      options_.layout = pre_post::YoloLayout::NHWC;
+    } else {
+      throw invalid_argument("Unknown layout: " + layout);
+    }
+  }
+
+  auto max_boxes = kMaxBoxes;
+  if (parameters->has("max_boxes")) {
+    max_boxes = parameters->get<int32_t>("max_boxes");
+  }
+  if (max_boxes < 1) {
+    throw invalid_argument("max_boxes must be positive");
+  }
+  max_boxes_ = static_cast<size_t>(max_boxes);
+
+  if (parameters->has("threads")) {
+    threads_ = parameters->get<int32_t>("threads");
+  }
+  if (threads_ < 1) {
+    throw invalid_argument("There must be at least one thread");
+  }
+  cpus_ = getPinnedCpus(*parameters);
+}
+
+void YoloPostprocess::doAcquire([[maybe_unused]] ParameterMap* parameters) {
+  this->metadata_.addInputTensor(Tensor{"input", {-1}, DataType::Fp32});
+  for (const auto& tensor : this->getOutputTensors()) {
+    this->metadata_.addOutputTensor(tensor);
+  }
+  this->metadata_.setName("YoloPostprocess");
+
+  this->createThreadPool(threads_, cpus_);
+}
+
+size_t YoloPostprocess::detect(const InferenceRequest& request,
+                               float* boxes) const {
+  const auto& inputs = request.getInputs();
+  const auto outputs = options_.biases.size() / (2 * options_.anchors);
+  if (inputs.size() != outputs) {
+    throw invalid_argument("YoloPostprocess expects " +
+                           std::to_string(outputs) + " input tensors but got " +
+                           std::to_string(inputs.size()));
+  }
+
+  const bool nchw = options_.layout == pre_post::YoloLayout::NCHW;
+  const auto values =
+    static_cast<size_t>(options_.anchors) * (5 + options_.classes);
+  std::vector<std::pair<int, int>> grids;
+  for (const auto& input : inputs) {
+    if (input.getDatatype() != DataType::Fp32) {
+      throw invalid_argument("YoloPostprocess takes FP32 input tensors");
+    }
+    // the grid is the last two dimensions in NCHW and the two before the
+    // values of each cell, which may be split by anchor, in NHWC
+    const auto& shape = input.getShape();
+    auto end = shape.size();
+    if (!nchw) {
+      int64_t cell = 1;
+      while (end > 0 && cell < static_cast<int64_t>(values)) {
+        cell *= shape[--end];
+      }
+    }
+    if (end < 2) {
+      throw invalid_argument("YoloPostprocess inputs must have a grid");
+    }
+    const auto height = shape[end - 2];
+    const auto width = shape[end - 1];
+    if (input.getSize() != static_cast<size_t>(height * width) * values) {
+      throw invalid_argument("YoloPostprocess inputs must have " +
+                             std::to_string(values) + " values per cell");
+    }
+    grids.emplace_back(static_cast<int>(height), static_cast<int>(width));
+  }
+
+  // the anchors of each output are in order of decreasing grid size
+  std::vector<size_t> order(inputs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return grids[a].second > grids[b].second;
+  });
+
+  pre_post::YoloBoxes candidates;
+  for (auto i = 0U; i < order.size(); ++i) {
+    const auto index = order[i];
+    pre_post::decodeYolo(static_cast<const float*>(inputs[index].getData()),
+                         grids[index].first, grids[index].second, i, options_,
+                         &candidates);
+  }
+
+  // boxes are mapped back to the image if the client sent its size
+  const auto& parameters = request.getParameters();
+  if (parameters.has("image_height") && parameters.has("image_width")) {
+    pre_post::correctLetterbox(
+      &candidates, parameters.get<int32_t>("image_height"),
+      parameters.get<int32_t>("image_width"), options_.net_height,
+      options_.net_width);
+  }
+
+  const auto kept =
+    pre_post::nonMaximumSuppression(candidates, options_.iou_threshold);
+  const auto count = std::min(kept.size(), max_boxes_);
+  for (auto i = 0U; i < count; ++i) {
+    const auto index = kept[i];
+    auto* box = boxes + i * kBoxSize;
+    box[0] = std::max(candidates.x1[index], 0.0F);
+    box[1] = std::max(candidates.y1[index], 0.0F);
+    box[2] = std::min(candidates.x2[index], 1.0F);
+    box[3] = std::min(candidates.y2[index], 1.0F);
+    box[4] = candidates.score[index];
+    box[5] = static_cast<float>(candidates.label[index]);
+  }
+  return count;
+}
+
+BatchPtr YoloPostprocess::doRun(Batch* batch, const MemoryPool* pool) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  const auto& logger = this->getLogger();
+#endif
+
+  const auto batch_size = batch->size();
+  const auto tensors = this->getOutputTensors();
+
+  std::vector<BufferPtr> input_buffers;
+  input_buffers.push_back(pool->get(next_allocators_, tensors[0], batch_size));
+  auto* boxes = static_cast<float*>(input_buffers[0]->data(0));
+  const auto stride = max_boxes_ * kBoxSize;
+
+  auto new_batch = batch->propagate();
+  for (auto j = 0U; j < batch_size; ++j) {
+    const auto& request = batch->getRequest(j);
+    auto* request_boxes = boxes + j * stride;
+    size_t count = 0;
+    bool failed = false;
+    try {
+      count = this->detect(*request, request_boxes);
+    } catch (const std::exception& e) {
+      AMDINFER_LOG_INFO(logger, e.what());
+      request->runCallbackError(e.what());
+      failed = true;
+    }
+
+    auto new_request = request->propagate();
+    if (failed) {
+      // the slot stays in the batch to keep it aligned with the requests so
+      // later stages run it without responding again
+      new_request->setCallback([](const InferenceResponse&) {});
+    }
+    new_request->addInputTensor(InferenceRequestInput{
+      request_boxes, {static_cast<int64_t>(count), kBoxSize}, DataType::Fp32,
+      tensors[0].getName()});
+    new_batch->addRequest(new_request);
+    new_batch->setModel(j, "YoloPostprocess");
+  }
+  new_batch->setBuffers(std::move(input_buffers), {});
+
+  return new_batch;
+}
+
+void YoloPostprocess::doRelease() { this->destroyThreadPool(); }
+
+void YoloPostprocess::doDestroy() {}
+
+}  // namespace amdinfer::workers
+
+extern "C" {
+// using smart pointer here may cause problems inside shared object so managing
+// manually
+amdinfer::workers::Worker* getWorker() {
+  return new amdinfer::workers::YoloPostprocess("YoloPostprocess", "CPU", true);
+}
+}  // extern C
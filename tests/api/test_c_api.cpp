@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>    // for array
+#include <cstdint>  // for uint32_t, int64_t
+#include <cstring>  // for strlen
+#include <future>   // for promise
+
+#include "amdinfer/amdinfer.h"  // for amdinfer_server, amdinfer_client, ...
+#include "gtest/gtest.h"        // for Test, EXPECT_EQ, ...
+
+namespace {
+
+/// Check a response from the echo model to an input of 1
+void checkResponse(const amdinfer_response* response) {
+  EXPECT_EQ(amdinfer_response_error(response), nullptr);
+  EXPECT_STREQ(amdinfer_response_id(response), "c");
+  ASSERT_EQ(amdinfer_response_output_count(response), 1);
+  amdinfer_tensor output{};
+  ASSERT_EQ(amdinfer_response_output(response, 0, &output), AMDINFER_OK);
+  EXPECT_STREQ(output.datatype, "UINT32");
+  ASSERT_EQ(output.dims, 1);
+  EXPECT_EQ(output.shape[0], 1);
+  EXPECT_EQ(output.size, sizeof(uint32_t));
+  EXPECT_EQ(*static_cast<const uint32_t*>(output.data), 2);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(CApi, ModelInfer) {
+  EXPECT_EQ(amdinfer_api_version(), AMDINFER_C_API_VERSION);
+
+  amdinfer_server* server = nullptr;
+  ASSERT_EQ(amdinfer_server_create(&server), AMDINFER_OK);
+  amdinfer_client* client = nullptr;
+  ASSERT_EQ(amdinfer_client_create(server, &client), AMDINFER_OK);
+
+  amdinfer_parameters* parameters = nullptr;
+  ASSERT_EQ(amdinfer_parameters_create(&parameters), AMDINFER_OK);
+  ASSERT_EQ(amdinfer_parameters_put_string(parameters, "model", "echo"),
+            AMDINFER_OK);
+  std::array<char, 64> endpoint{};
+  ASSERT_EQ(amdinfer_worker_load(client, "cplusplus", parameters,
+                                 endpoint.data(), endpoint.size()),
+            AMDINFER_OK);
+  EXPECT_STREQ(endpoint.data(), "cplusplus");
+  amdinfer_parameters_destroy(parameters);
+
+  uint32_t input = 1;
+  const std::array<int64_t, 1> shape{1};
+  amdinfer_request* request = nullptr;
+  ASSERT_EQ(amdinfer_request_create(&request), AMDINFER_OK);
+  ASSERT_EQ(amdinfer_request_set_id(request, "c"), AMDINFER_OK);
+  ASSERT_EQ(amdinfer_request_add_input(request, "input", shape.data(),
+                                       shape.size(), "UINT32", &input),
+            AMDINFER_OK);
+  EXPECT_EQ(amdinfer_request_add_input(request, "input", shape.data(),
+                                       shape.size(), "NOPE", &input),
+            AMDINFER_INVALID_ARGUMENT);
+  EXPECT_NE(std::strlen(amdinfer_last_error()), 0);
+
+  amdinfer_response* response = nullptr;
+  ASSERT_EQ(amdinfer_infer(client, endpoint.data(), nullptr, request,
+                           &response),
+            AMDINFER_OK);
+  checkResponse(response);
+  amdinfer_response_destroy(response);
+
+  std::promise<void> done;
+  ASSERT_EQ(amdinfer_infer_async(
+              client, endpoint.data(), "", request,
+              [](const amdinfer_response* async_response, void* user_data) {
+                checkResponse(async_response);
+                static_cast<std::promise<void>*>(user_data)->set_value();
+              },
+              &done),
+            AMDINFER_OK);
+  done.get_future().wait();
+
+  EXPECT_EQ(amdinfer_infer(client, "missing", nullptr, request, &response),
+            AMDINFER_INVALID_ARGUMENT);
+  EXPECT_EQ(amdinfer_infer(nullptr, endpoint.data(), nullptr, request,
+                           &response),
+            AMDINFER_INVALID_ARGUMENT);
+
+  amdinfer_request_destroy(request);
+  EXPECT_EQ(amdinfer_worker_unload(client, endpoint.data()), AMDINFER_OK);
+  amdinfer_client_destroy(client);
+  amdinfer_server_destroy(server);
+}
@@ -0,0 +1,65 @@
+// Copyright 2022 Xilinx, Inc.
+// Copyright 2022 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>  // for getpid
+
+#include <cstdint>     // for uint32_t
+#include <filesystem>  // for path, exists, temp_directory_path
+#include <string>      // for string, to_string
+#include <vector>      // for vector
+
+#include "amdinfer/amdinfer.hpp"                // for GrpcClient, Inferen...
+#include "amdinfer/testing/gtest_fixtures.hpp"  // for BaseFixture
+
+#ifdef AMDINFER_ENABLE_GRPC
+
+namespace fs = std::filesystem;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(BaseFixture, GrpcSocket) {
+  const auto socket = fs::temp_directory_path() /
+                      ("amdinfer-grpc-" + std::to_string(::getpid()) + ".sock");
+  // port 0 lets the OS pick a free one so the test doesn't clash with a server
+  // already running on the default port. The client only uses the socket
+  server_.startGrpc(0, socket.string());
+  EXPECT_TRUE(fs::exists(socket));
+
+  {
+    amdinfer::GrpcClient client{"unix:" + socket.string()};
+    amdinfer::waitUntilServerReady(&client);
+    EXPECT_TRUE(client.serverLive());
+
+    auto endpoint =
+      client.workerLoad("cplusplus", {{"model"}, {std::string{"echo"}}});
+
+    std::vector<uint32_t> data{1};
+    amdinfer::InferenceRequest request;
+    request.addInputTensor(static_cast<void*>(data.data()), {1},
+                           amdinfer::DataType::Uint32);
+
+    auto response = client.modelInfer(endpoint, request);
+    EXPECT_FALSE(response.isError());
+    auto outputs = response.getOutputs();
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_EQ(static_cast<uint32_t*>(outputs[0].getData())[0], 2);
+
+    client.workerUnload(endpoint);
+  }
+
+  server_.stopGrpc();
+  EXPECT_FALSE(fs::exists(socket));
+}
+
+#endif
@@ -15,6 +15,7 @@
 
 #include <cstdint>  // for uint8_t, uint64_t, uin...
 #include <memory>   // for allocator, unique_ptr
+#include <string>   // for to_string
 #include <vector>   // for vector
 
 #include "amdinfer/amdinfer.hpp"                // for InferenceResponse, Grp...
@@ -53,9 +54,24 @@ void test(const Client* client) {
   client->workerUnload(endpoint);
 }
 
+CompressionOptions compressEverything(CompressionAlgorithm algorithm) {
+  CompressionOptions compression;
+  compression.algorithm = algorithm;
+  compression.threshold = 0;
+  return compression;
+}
+
 #ifdef AMDINFER_ENABLE_GRPC
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST_F(GrpcFixture, ModelInfer) { test(client_.get()); }
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(GrpcFixture, ModelInferCompressed) {
+  GrpcClientOptions options;
+  options.compression = compressEverything(CompressionAlgorithm::Gzip);
+  GrpcClient client{"localhost:" + std::to_string(kDefaultGrpcPort), options};
+  test(&client);
+}
 #endif
 
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
@@ -67,6 +83,18 @@ TEST_F(BaseFixture, ModelInfer) {
 #ifdef AMDINFER_ENABLE_HTTP
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST_F(HttpFixture, ModelInfer) { test(client_.get()); }
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(HttpFixture, ModelInferCompressed) {
+  for (const auto algorithm :
+       {CompressionAlgorithm::Deflate, CompressionAlgorithm::Gzip,
+        CompressionAlgorithm::Zstd}) {
+    HttpClient client{"http://127.0.0.1:" + std::to_string(kDefaultHttpPort),
+                      {}, HttpClient::kDefaultParallelism,
+                      compressEverything(algorithm)};
+    test(&client);
+  }
+}
 #endif
 
 }  // namespace amdinfer
@@ -14,9 +14,10 @@
 // limitations under the License.
 
 #include <cstdint>  // for uint8_t, uint64_t, uin...
-#include <future>   // for future
+#include <future>   // for future, promise
 #include <memory>   // for allocator, unique_ptr
 #include <queue>    // for queue
+#include <string>   // for to_string
 #include <vector>   // for vector
 
 #include "amdinfer/amdinfer.hpp"                // for InferenceResponse, Grp...
@@ -68,6 +69,43 @@ void test(const Client* client) {
 #ifdef AMDINFER_ENABLE_GRPC
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST_F(GrpcFixture, ModelInfer) { test(client_.get()); }
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(GrpcFixture, ModelInferCallback) {
+  GrpcClientOptions options;
+  options.channels = 2;
+  GrpcClient client{"localhost:" + std::to_string(kDefaultGrpcPort), options};
+  auto endpoint =
+    client.workerLoad("cplusplus", {{"model"}, {std::string{"echo"}}});
+
+  std::vector<uint32_t> data{1};
+  InferenceRequest request;
+  request.addInputTensor(static_cast<void*>(data.data()), {1L},
+                         DataType::Uint32);
+
+  const auto num_requests = 16;
+  std::vector<std::promise<uint32_t>> promises(num_requests);
+  for (auto& promise : promises) {
+    client.modelInferAsync(
+      endpoint, request, [&promise](const InferenceResponse& response) {
+        if (response.isError()) {
+          promise.set_value(0);
+          return;
+        }
+        const auto outputs = response.getOutputs();
+        promise.set_value(*static_cast<uint32_t*>(outputs[0].getData()));
+      });
+  }
+  for (auto& promise : promises) {
+    EXPECT_EQ(promise.get_future().get(), 2);
+  }
+
+  // a client with the same options shares the channels
+  GrpcClient other{"localhost:" + std::to_string(kDefaultGrpcPort), options};
+  EXPECT_TRUE(other.serverLive());
+
+  client.workerUnload(endpoint);
+}
 #endif
 
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
@@ -76,6 +114,38 @@ TEST_F(BaseFixture, ModelInfer) {
   test(&client);
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(BaseFixture, ModelInferBorrowed) {
+  NativeClient client(&server_);
+  auto endpoint =
+    client.workerLoad("cplusplus", {{"model"}, {std::string{"echo"}}});
+
+  // each request reads its input from this memory without a copy
+  const auto num_requests = 16;
+  std::vector<uint32_t> data(num_requests);
+  std::queue<InferenceResponseFuture> q;
+  for (auto i = 0; i < num_requests; ++i) {
+    data[i] = i;
+    InferenceRequest request;
+    request.addInputTensor(static_cast<void*>(&data[i]), {1L},
+                           DataType::Uint32);
+    q.push(client.modelInferAsyncBorrowed(endpoint, request));
+  }
+
+  for (auto i = 0; i < num_requests; ++i) {
+    auto response = q.front().get();
+    q.pop();
+
+    ASSERT_FALSE(response.isError());
+    auto outputs = response.getOutputs();
+    ASSERT_EQ(outputs.size(), 1);
+    const auto* output = static_cast<uint32_t*>(outputs[0].getData());
+    EXPECT_EQ(output[0], i + 1);
+  }
+
+  client.workerUnload(endpoint);
+}
+
 #ifdef AMDINFER_ENABLE_HTTP
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST_F(HttpFixture, ModelInfer) { test(client_.get()); }
@@ -0,0 +1,68 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>  // for uint32_t
+#include <future>   // for future
+#include <string>   // for string, to_string
+#include <vector>   // for vector
+
+#include "amdinfer/amdinfer.hpp"                // for GrpcClient, GrpcStream
+#include "amdinfer/testing/gtest_fixtures.hpp"  // for GrpcFixture
+
+namespace amdinfer {
+
+#ifdef AMDINFER_ENABLE_GRPC
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(GrpcFixture, ModelInferStream) {
+  auto endpoint =
+    client_->workerLoad("cplusplus", {{"model"}, {std::string{"echo"}}});
+  EXPECT_EQ(endpoint, "cplusplus");
+
+  const auto num_requests = 16;
+  std::vector<uint32_t> data(num_requests);
+  std::vector<InferenceResponseFuture> futures;
+  {
+    auto stream = client_->modelInferStream(endpoint);
+    for (auto i = 0; i < num_requests; ++i) {
+      data[i] = i;
+      InferenceRequest request;
+      request.setID(std::to_string(i));
+      InferenceRequestInput input{&(data[i]), {1}, DataType::Uint32};
+      if (i % 2 == 0) {
+        // send some of the requests as raw input contents
+        ParameterMap parameters;
+        parameters.put("binary_data", true);
+        input.setParameters(parameters);
+      }
+      request.addInputTensor(input);
+      futures.push_back(stream.modelInfer(request));
+    }
+
+    stream.close();
+  }
+
+  for (auto i = 0; i < num_requests; ++i) {
+    auto response = futures[i].get();
+    EXPECT_EQ(response.getID(), std::to_string(i));
+    const auto& outputs = response.getOutputs();
+    ASSERT_EQ(outputs.size(), 1);
+    const auto* output = static_cast<uint32_t*>(outputs[0].getData());
+    EXPECT_EQ(output[0], i + 1);
+  }
+
+  client_->workerUnload(endpoint);
+}
+#endif
+
+}  // namespace amdinfer
@@ -54,6 +54,24 @@ void testWithVersion(const Client* client, const std::string& version) {
   waitUntilModelNotReady(client, model, version);
 }
 
+void testSwap(const Client* client, const std::string& version) {
+  prerequisites(client);
+
+  const auto model = getModel();
+  client->modelLoad(model, {});
+  ParameterMap parameters;
+  parameters.put("swap", true);
+  client->modelLoad(model, parameters, version);
+  // the model's name stays ready while it's swapped to the version
+  EXPECT_TRUE(client->modelReady(model));
+  EXPECT_TRUE(client->modelReady(model, version));
+
+  // unloading the model's name unloads the version serving it
+  client->modelUnload(model);
+  waitUntilModelNotReady(client, model);
+  waitUntilModelNotReady(client, model, version);
+}
+
 #ifdef AMDINFER_ENABLE_GRPC
 // @pytest.mark.extensions(["tfzendnn"])
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
@@ -62,6 +80,10 @@ TEST_F(GrpcFixture, modelLoad) { testWithoutVersion(client_.get()); }
 // @pytest.mark.extensions(["tfzendnn"])
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST_F(GrpcFixture, modelLoadVersioned) { testWithVersion(client_.get(), "1"); }
+
+// @pytest.mark.extensions(["tfzendnn"])
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(GrpcFixture, modelLoadSwap) { testSwap(client_.get(), "1"); }
 #endif
 
 // @pytest.mark.extensions(["tfzendnn"])
@@ -78,6 +100,13 @@ TEST_F(BaseFixture, modelLoadVersioned) {
   testWithVersion(&client, "1");
 }
 
+// @pytest.mark.extensions(["tfzendnn"])
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(BaseFixture, modelLoadSwap) {
+  amdinfer::NativeClient client(&server_);
+  testSwap(&client, "1");
+}
+
 #ifdef AMDINFER_ENABLE_HTTP
 // @pytest.mark.extensions(["tfzendnn"])
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
@@ -86,6 +115,10 @@ TEST_F(HttpFixture, modelLoad) { testWithoutVersion(client_.get()); }
 // @pytest.mark.extensions(["tfzendnn"])
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST_F(HttpFixture, modelLoadVersioned) { testWithVersion(client_.get(), "1"); }
+
+// @pytest.mark.extensions(["tfzendnn"])
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(HttpFixture, modelLoadSwap) { testSwap(client_.get(), "1"); }
 #endif
 
 }  // namespace amdinfer
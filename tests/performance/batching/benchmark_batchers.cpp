@@ -0,0 +1,271 @@
+// Copyright 2021 Xilinx, Inc.
+// Copyright 2022 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Measures how the batchers form batches. Producer threads enqueue
+ * requests at a fixed rate, each with one tensor of a fixed size or of a mix of
+ * sizes, and a consumer takes the batches and holds each for a fixed service
+ * time as a worker would. Each benchmark reports the achieved batch size and
+ * the time from enqueueing a request to the consumer getting its batch.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>    // for sort, max
+#include <array>        // for array
+#include <chrono>       // for steady_clock, microseconds
+#include <cmath>        // for ceil
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int64_t, uint8_t
+#include <cstring>      // for memset
+#include <memory>       // for make_shared
+#include <random>       // for mt19937, uniform_int_distribution
+#include <string>       // for string, to_string, stoul
+#include <thread>       // for thread, sleep_until
+#include <type_traits>  // for is_same_v
+#include <utility>      // for move
+#include <vector>       // for vector
+
+#include "amdinfer/batching/bucket.hpp"         // for BucketBatcher
+#include "amdinfer/batching/hard.hpp"           // for HardBatcher
+#include "amdinfer/batching/soft.hpp"           // for SoftBatcher
+#include "amdinfer/buffers/buffer.hpp"          // for Buffer
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"         // for DataType
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+#include "amdinfer/core/request_container.hpp"  // for makeRequestContainer
+#include "amdinfer/core/tensor.hpp"             // for Tensor
+#include "amdinfer/observation/logging.hpp"     // for LogOptions, initLogger
+#include "amdinfer/testing/perf_counters.hpp"   // for PerfCounters
+
+namespace amdinfer {
+
+using Clock = std::chrono::steady_clock;
+
+// requests sent in each iteration
+constexpr auto kRequests = 1024;
+// time between the requests of each producer
+constexpr std::chrono::microseconds kArrivalGap{50};
+// size in bytes of the tensor when the sizes aren't mixed
+constexpr size_t kFixedSize = 4096;
+constexpr auto kSeed = 42;
+
+/**
+ * @brief Get the size of a request's tensor. The mixed sizes are a scalar, a
+ * short text, a sentence embedding and an image
+ *
+ * @param mixed whether to pick from the mix of sizes
+ * @param engine source of randomness for the mix
+ * @return size_t
+ */
+size_t getSize(bool mixed, std::mt19937& engine) {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  constexpr std::array<size_t, 4> kSizes{64, 1024, 16'384, 150'528};
+  if (!mixed) {
+    return kFixedSize;
+  }
+  std::uniform_int_distribution<size_t> pick{0, kSizes.size() - 1};
+  return kSizes.at(pick(engine));
+}
+
+/**
+ * @brief Enqueue requests at a fixed rate. Each request's ID is its index so
+ * the consumer can find when it was sent
+ *
+ * @param batcher the batcher to enqueue to
+ * @param pool the pool to allocate the requests' tensors from
+ * @param first index of the first request to send
+ * @param stride number of producers. This one sends every stride-th request
+ * @param mixed whether the tensors are of mixed sizes
+ * @param sent when each request was sent
+ */
+void produce(const Batcher* batcher, const MemoryPool* pool, int first,
+             int stride, bool mixed, std::vector<Clock::time_point>* sent) {
+  std::mt19937 engine{static_cast<unsigned>(kSeed + first)};
+  auto next = Clock::now();
+  for (auto i = first; i < kRequests; i += stride) {
+    std::this_thread::sleep_until(next);
+    next += kArrivalGap;
+
+    const auto size = getSize(mixed, engine);
+    const Tensor tensor{"input", {static_cast<int64_t>(size)},
+                        DataType::Uint8};
+    auto buffer = pool->get(MemoryAllocators::Cpu, tensor, 1);
+    std::memset(buffer->data(0), 1, size);
+
+    auto request = std::make_shared<InferenceRequest>();
+    request->setID(std::to_string(i));
+    request->addInputTensor(buffer->data(0), tensor.getShape(),
+                            DataType::Uint8);
+    auto container = makeRequestContainer();
+    container->request = std::move(request);
+    (*sent)[i] = Clock::now();
+    batcher->enqueue(std::move(container));
+  }
+}
+
+/**
+ * @brief Wait for a fixed time as a worker running the batch would. It spins
+ * because sleeping can't wait for short times accurately
+ *
+ * @param service_time how long to wait
+ */
+void serve(std::chrono::microseconds service_time) {
+  const auto end = Clock::now() + service_time;
+  while (Clock::now() < end) {
+  }
+}
+
+/**
+ * @brief Get a percentile of sorted values with the nearest-rank method
+ *
+ * @param sorted the values in increasing order
+ * @param percentile the percentile, from 0 to 1
+ * @return double
+ */
+double getPercentile(const std::vector<double>& sorted, double percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const auto rank = static_cast<size_t>(
+    std::ceil(percentile * static_cast<double>(sorted.size())));
+  return sorted.at(std::max(rank, size_t{1}) - 1);
+}
+
+/**
+ * @brief Run requests through a batcher. The arguments are the batch size, the
+ * number of producers, whether the tensor sizes are mixed, the batcher's
+ * timeout in milliseconds and the consumer's service time per batch in
+ * microseconds
+ *
+ * @tparam BatcherType the batcher to measure
+ * @param state the benchmark state
+ */
+template <typename BatcherType>
+void batching(benchmark::State& state) {
+  const auto batch_size = static_cast<int>(state.range(0));
+  const auto producers = static_cast<int>(state.range(1));
+  const auto mixed = state.range(2) != 0;
+  const auto timeout = static_cast<int>(state.range(3));
+  const std::chrono::microseconds service_time{state.range(4)};
+
+#ifdef AMDINFER_ENABLE_LOGGING
+  LogOptions options;
+  options.logger_name = "server";
+  options.console_enable = true;
+  options.file_enable = false;
+  initLogger(options);
+#endif
+
+  MemoryPool pool;
+  ParameterMap parameters;
+  parameters.put("batch_size", batch_size);
+  if (timeout > 0) {
+    parameters.put("timeout", timeout);
+  }
+  // a contiguous batch is sized by its first request so batchers that don't
+  // group requests by shape gather mixed sizes in place instead
+  if (mixed && !std::is_same_v<BatcherType, BucketBatcher>) {
+    parameters.put("batch_layout", std::string{"scatter_gather"});
+  }
+  BatcherType batcher{&pool, &parameters};
+  batcher.setName("benchmark");
+  batcher.setBatchSize(batch_size);
+  batcher.start({MemoryAllocators::Cpu});
+
+  std::vector<Clock::time_point> sent(kRequests);
+  std::vector<double> latencies;
+  int64_t batches = 0;
+
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    std::vector<std::thread> threads;
+    threads.reserve(producers);
+    for (auto i = 0; i < producers; ++i) {
+      threads.emplace_back(produce, &batcher, &pool, i, producers, mixed,
+                           &sent);
+    }
+
+    for (auto received = 0; received < kRequests;) {
+      BatchPtr batch;
+      batcher.getOutputQueue()->wait_dequeue(batch);
+      const auto now = Clock::now();
+      for (const auto& request : *batch) {
+        const auto index = std::stoul(request->getID());
+        latencies.push_back(
+          std::chrono::duration<double, std::micro>(now - sent[index])
+            .count());
+      }
+      received += static_cast<int>(batch->size());
+      ++batches;
+      serve(service_time);
+      batch->freeInputBuffers();
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+
+  std::sort(latencies.begin(), latencies.end());
+  state.SetItemsProcessed(state.iterations() * kRequests);
+  state.counters["batch_size"] =
+    static_cast<double>(state.iterations() * kRequests) /
+    static_cast<double>(std::max(batches, int64_t{1}));
+  state.counters["formation_p50_us"] = getPercentile(latencies, 0.5);
+  state.counters["formation_p99_us"] = getPercentile(latencies, 0.99);
+}
+
+const std::vector<int64_t> kBatchSizes{1, 4, 16};
+const std::vector<int64_t> kProducers{1, 4};
+const std::vector<int64_t> kMixed{0, 1};
+// batcher timeouts in milliseconds
+const std::vector<int64_t> kTimeouts{1, 10};
+// time the consumer spends on each batch in microseconds
+const std::vector<int64_t> kServiceTimes{0, 100, 1000};
+
+void setArgs(benchmark::internal::Benchmark* benchmark,
+             const std::vector<int64_t>& timeouts) {
+  benchmark->ArgNames(
+    {"batch_size", "producers", "mixed", "timeout_ms", "service_us"});
+  benchmark->ArgsProduct(
+    {kBatchSizes, kProducers, kMixed, timeouts, kServiceTimes});
+  benchmark->Unit(benchmark::kMillisecond);
+  benchmark->UseRealTime();
+}
+
+void batcherArgs(benchmark::internal::Benchmark* benchmark) {
+  setArgs(benchmark, kTimeouts);
+}
+
+/// Batchers that wait for full batches don't have a timeout to sweep
+void blockingBatcherArgs(benchmark::internal::Benchmark* benchmark) {
+  setArgs(benchmark, {0});
+}
+
+// add new batchers here
+// NOLINTBEGIN(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK_TEMPLATE(batching, SoftBatcher)->Apply(batcherArgs);
+BENCHMARK_TEMPLATE(batching, BucketBatcher)->Apply(batcherArgs);
+BENCHMARK_TEMPLATE(batching, HardBatcher)->Apply(blockingBatcherArgs);
+// NOLINTEND(cert-err58-cpp, cppcoreguidelines-owning-memory)
+
+}  // namespace amdinfer
@@ -0,0 +1,130 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Compares making and parsing gRPC inference responses with many
+ * outputs in heap-allocated messages and in messages on an arena
+ */
+
+#include <benchmark/benchmark.h>
+#include <google/protobuf/arena.h>  // for Arena, ArenaOptions
+
+#include <array>    // for array
+#include <cstddef>  // for byte
+#include <cstdint>  // for int64_t
+#include <string>   // for string, to_string
+#include <vector>   // for vector
+
+#include "amdinfer/clients/grpc_internal.hpp"    // for mapResponseToProto
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/observation/observer.hpp"     // for Observer
+#include "inference.pb.h"                        // for ModelInferResponse
+
+namespace amdinfer {
+
+constexpr auto kElements = 64;
+constexpr auto kArenaBlockSize = 4096;
+
+InferenceResponse makeResponse(int64_t outputs) {
+  InferenceResponse response;
+  response.setModel("benchmark");
+  for (auto i = 0; i < outputs; ++i) {
+    InferenceResponseOutput output;
+    output.setName("output_" + std::to_string(i));
+    output.setDatatype(DataType::Fp32);
+    output.setShape({kElements});
+    output.setData(std::vector<std::byte>(kElements * sizeof(float)));
+    response.addOutput(output);
+  }
+  return response;
+}
+
+// the server side: map the response to proto and serialize it
+void serializeHeap(benchmark::State& state) {
+  const auto response = makeResponse(state.range(0));
+  std::string serialized;
+  for ([[maybe_unused]] auto _ : state) {
+    inference::ModelInferResponse reply;
+    mapResponseToProto(response, reply);
+    reply.SerializeToString(&serialized);
+    benchmark::DoNotOptimize(serialized);
+  }
+}
+
+void serializeArena(benchmark::State& state) {
+  const auto response = makeResponse(state.range(0));
+  std::string serialized;
+  std::array<char, kArenaBlockSize> block{};
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block.data();
+  options.initial_block_size = block.size();
+  google::protobuf::Arena arena{options};
+  for ([[maybe_unused]] auto _ : state) {
+    auto* reply =
+      google::protobuf::Arena::CreateMessage<inference::ModelInferResponse>(
+        &arena);
+    mapResponseToProto(response, *reply);
+    reply->SerializeToString(&serialized);
+    benchmark::DoNotOptimize(serialized);
+    arena.Reset();
+  }
+}
+
+// the client side: parse the response and map it back
+void parseHeap(benchmark::State& state) {
+  inference::ModelInferResponse proto;
+  mapResponseToProto(makeResponse(state.range(0)), proto);
+  const auto serialized = proto.SerializeAsString();
+  const Observer observer;
+  for ([[maybe_unused]] auto _ : state) {
+    inference::ModelInferResponse reply;
+    reply.ParseFromString(serialized);
+    InferenceResponse response;
+    mapProtoToResponse(reply, response, observer);
+    benchmark::DoNotOptimize(response);
+  }
+}
+
+void parseArena(benchmark::State& state) {
+  inference::ModelInferResponse proto;
+  mapResponseToProto(makeResponse(state.range(0)), proto);
+  const auto serialized = proto.SerializeAsString();
+  const Observer observer;
+  for ([[maybe_unused]] auto _ : state) {
+    google::protobuf::Arena arena;
+    auto* reply =
+      google::protobuf::Arena::CreateMessage<inference::ModelInferResponse>(
+        &arena);
+    reply->ParseFromString(serialized);
+    InferenceResponse response;
+    mapProtoToResponse(*reply, response, observer);
+    benchmark::DoNotOptimize(response);
+  }
+}
+
+const auto kMinOutputs = 1;
+const auto kMaxOutputs = 256;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(serializeHeap)->RangeMultiplier(4)->Range(kMinOutputs, kMaxOutputs);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(serializeArena)->RangeMultiplier(4)->Range(kMinOutputs, kMaxOutputs);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(parseHeap)->RangeMultiplier(4)->Range(kMinOutputs, kMaxOutputs);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(parseArena)->RangeMultiplier(4)->Range(kMinOutputs, kMaxOutputs);
+
+}  // namespace amdinfer
@@ -0,0 +1,297 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Measures getting and putting memory from the CPU allocator and the
+ * memory pool for fixed sizes, a mix of request sizes, many threads and long
+ * runs that fragment the memory
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>    // for exp, log
+#include <cstddef>  // for size_t
+#include <cstdint>  // for int64_t
+#include <cstdlib>  // for malloc, free
+#include <memory>   // for unique_ptr, make_unique
+#include <random>   // for mt19937, uniform_real_distribution, discrete_...
+#include <vector>   // for vector
+
+#include "amdinfer/buffers/buffer.hpp"                  // for Buffer
+#include "amdinfer/core/data_types.hpp"                 // for DataType
+#include "amdinfer/core/memory_pool/cpu_allocator.hpp"  // for CpuAllocator
+#include "amdinfer/core/memory_pool/pool.hpp"           // for MemoryPool
+#include "amdinfer/core/tensor.hpp"                     // for Tensor
+#include "amdinfer/testing/perf_counters.hpp"           // for PerfCounters
+
+namespace amdinfer {
+
+// the pool's default block size
+constexpr size_t kBlockSize = 1'048'576;
+constexpr auto kSeed = 42;
+// number of sizes each thread cycles through in the mixed benchmarks
+constexpr size_t kMixSize = 4096;
+
+Tensor makeTensor(size_t size) {
+  return {"input", {static_cast<int64_t>(size)}, DataType::Uint8};
+}
+
+/**
+ * @brief Make a mix of tensor sizes like the ones requests carry: mostly small
+ * tensors such as text and scalars, some images and a few large batches.
+ * Sizes are log-uniform within each class.
+ *
+ * @param count number of sizes
+ * @param seed seed for the sizes so each thread gets its own sequence
+ * @return std::vector<Tensor>
+ */
+std::vector<Tensor> makeMix(size_t count, unsigned seed) {
+  struct SizeClass {
+    double weight;
+    double min;
+    double max;
+  };
+  // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+  const std::vector<SizeClass> classes{{0.6, 64, 16'384},
+                                       {0.3, 65'536, 1'048'576},
+                                       {0.1, 2'097'152, 16'777'216}};
+  // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+  std::vector<double> weights;
+  weights.reserve(classes.size());
+  for (const auto& size_class : classes) {
+    weights.push_back(size_class.weight);
+  }
+  std::mt19937 engine{seed};
+  std::discrete_distribution<size_t> pick{weights.begin(), weights.end()};
+  std::uniform_real_distribution<double> uniform{0, 1};
+
+  std::vector<Tensor> tensors;
+  tensors.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const auto& size_class = classes[pick(engine)];
+    const auto log_min = std::log(size_class.min);
+    const auto log_max = std::log(size_class.max);
+    const auto size = std::exp(log_min + (log_max - log_min) * uniform(engine));
+    tensors.push_back(makeTensor(static_cast<size_t>(size)));
+  }
+  return tensors;
+}
+
+void setCounters(benchmark::State& state, CpuAllocator& allocator) {
+  const auto stats = allocator.getStats(false);
+  constexpr auto kMiB = 1'048'576.0;
+  state.counters["reserved_MiB"] = static_cast<double>(stats.reserved) / kMiB;
+  state.counters["fragmentation"] = stats.fragmentation();
+  state.counters["free_chunks"] = static_cast<double>(stats.free_chunks);
+}
+
+/// Get and put one size so each get after the first is served from the cache
+void cpuGetPut(benchmark::State& state) {
+  CpuAllocator allocator{kBlockSize};
+  const auto tensor = makeTensor(state.range(0));
+
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    auto buffer = allocator.get(tensor, 1);
+    benchmark::DoNotOptimize(buffer->data(0));
+    allocator.put(buffer->data(0));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// The same as cpuGetPut with malloc as a baseline
+void mallocGetPut(benchmark::State& state) {
+  const auto size = static_cast<size_t>(state.range(0));
+
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    auto* memory = std::malloc(size);
+    benchmark::DoNotOptimize(memory);
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(memory);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Keep a window of live allocations from the mix of sizes and replace a
+ * random one each iteration, like requests that finish out of order. The
+ * counters show how fragmented the memory is after the run so running it for
+ * longer (e.g. with --benchmark_min_time) shows how it fragments over time.
+ */
+void cpuChurn(benchmark::State& state) {
+  CpuAllocator allocator{kBlockSize};
+  const auto tensors = makeMix(kMixSize, kSeed);
+  const auto live = static_cast<size_t>(state.range(0));
+
+  std::vector<BufferPtr> buffers;
+  buffers.reserve(live);
+  for (size_t i = 0; i < live; ++i) {
+    buffers.push_back(allocator.get(tensors[i % tensors.size()], 1));
+  }
+  std::mt19937 engine{kSeed};
+  std::uniform_int_distribution<size_t> victim{0, live - 1};
+
+  size_t next = live;
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    auto& buffer = buffers[victim(engine)];
+    allocator.put(buffer->data(0));
+    buffer = allocator.get(tensors[next++ % tensors.size()], 1);
+    benchmark::DoNotOptimize(buffer->data(0));
+  }
+  state.SetItemsProcessed(state.iterations());
+  setCounters(state, allocator);
+
+  for (const auto& buffer : buffers) {
+    allocator.put(buffer->data(0));
+  }
+}
+
+// shared by the threads of the multi-threaded benchmarks. They're made before
+// and destroyed after the threads run
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::unique_ptr<CpuAllocator> shared_allocator;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::unique_ptr<MemoryPool> shared_pool;
+
+void makeShared([[maybe_unused]] const benchmark::State& state) {
+  shared_allocator = std::make_unique<CpuAllocator>(kBlockSize);
+  shared_pool = std::make_unique<MemoryPool>();
+}
+
+void destroyShared([[maybe_unused]] const benchmark::State& state) {
+  shared_allocator.reset();
+  shared_pool.reset();
+}
+
+/**
+ * @brief Each thread gets and puts from the mix of sizes with a few buffers
+ * live at a time, as a worker does with a batch's inputs, on one allocator
+ */
+void cpuContention(benchmark::State& state) {
+  const auto tensors = makeMix(kMixSize, kSeed + state.thread_index());
+  const auto live = static_cast<size_t>(state.range(0));
+  std::vector<BufferPtr> buffers(live);
+
+  size_t next = 0;
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    auto& buffer = buffers[next % live];
+    if (buffer != nullptr) {
+      shared_allocator->put(buffer->data(0));
+    }
+    buffer = shared_allocator->get(tensors[next++ % tensors.size()], 1);
+    benchmark::DoNotOptimize(buffer->data(0));
+  }
+  for (const auto& buffer : buffers) {
+    if (buffer != nullptr) {
+      shared_allocator->put(buffer->data(0));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// The same as cpuContention through the pool, which picks the NUMA arena
+void poolContention(benchmark::State& state) {
+  const auto tensors = makeMix(kMixSize, kSeed + state.thread_index());
+  const auto live = static_cast<size_t>(state.range(0));
+  std::vector<BufferPtr> buffers(live);
+
+  size_t next = 0;
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    auto& buffer = buffers[next % live];
+    if (buffer != nullptr) {
+      shared_pool->put(MemoryAllocators::Cpu, buffer->data(0));
+    }
+    buffer = shared_pool->get(MemoryAllocators::Cpu,
+                              tensors[next++ % tensors.size()], 1);
+    benchmark::DoNotOptimize(buffer->data(0));
+  }
+  for (const auto& buffer : buffers) {
+    if (buffer != nullptr) {
+      shared_pool->put(MemoryAllocators::Cpu, buffer->data(0));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// The same as cpuContention with malloc as a baseline
+void mallocContention(benchmark::State& state) {
+  const auto tensors = makeMix(kMixSize, kSeed + state.thread_index());
+  const auto live = static_cast<size_t>(state.range(0));
+  std::vector<void*> buffers(live, nullptr);
+
+  size_t next = 0;
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    auto*& buffer = buffers[next % live];
+    // NOLINTBEGIN(cppcoreguidelines-no-malloc)
+    std::free(buffer);
+    buffer = std::malloc(tensors[next++ % tensors.size()].getSize());
+    // NOLINTEND(cppcoreguidelines-no-malloc)
+    benchmark::DoNotOptimize(buffer);
+  }
+  for (auto* buffer : buffers) {
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+const auto kMinSize = 64;
+const auto kMaxSize = 16'777'216;
+const auto kSizeMultiplier = 8;
+// live buffers in the churn benchmark
+const auto kMinLive = 16;
+const auto kMaxLive = 1024;
+// live buffers per thread in the contention benchmarks
+const auto kThreadLive = 4;
+const auto kMaxThreads = 64;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(cpuGetPut)->RangeMultiplier(kSizeMultiplier)->Range(kMinSize,
+                                                              kMaxSize);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(mallocGetPut)
+  ->RangeMultiplier(kSizeMultiplier)
+  ->Range(kMinSize, kMaxSize);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(cpuChurn)->RangeMultiplier(kSizeMultiplier)->Range(kMinLive,
+                                                             kMaxLive);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(cpuContention)
+  ->Setup(makeShared)
+  ->Teardown(destroyShared)
+  ->Arg(kThreadLive)
+  ->ThreadRange(1, kMaxThreads)
+  ->UseRealTime();
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(poolContention)
+  ->Setup(makeShared)
+  ->Teardown(destroyShared)
+  ->Arg(kThreadLive)
+  ->ThreadRange(1, kMaxThreads)
+  ->UseRealTime();
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(mallocContention)
+  ->Arg(kThreadLive)
+  ->ThreadRange(1, kMaxThreads)
+  ->UseRealTime();
+
+}  // namespace amdinfer
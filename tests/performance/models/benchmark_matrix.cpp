@@ -0,0 +1,267 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Runs ResNet50 on each enabled backend for a range of batch sizes
+ * through the client of the protocol this executable is built for. Each
+ * benchmark reports the throughput, the latency percentiles, how busy the
+ * CPU was and the predicted class of its image so the results can be saved
+ * with --benchmark_out and checked against a baseline with
+ * tools/check_baseline.py.
+ */
+
+#include <benchmark/benchmark.h>
+#include <sys/resource.h>  // for getrusage, rusage, RUSAGE_SELF
+
+#include <algorithm>  // for max, max_element, sort
+#include <chrono>     // for steady_clock, duration
+#include <cmath>      // for ceil
+#include <cstddef>    // for size_t
+#include <cstdint>    // for int64_t
+#include <deque>      // for deque
+#include <future>     // for future_status
+#include <memory>     // for unique_ptr
+#include <string>     // for string, to_string
+#include <thread>     // for hardware_concurrency
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/amdinfer.hpp"                   // for InferenceRequest
+#include "amdinfer/testing/get_path_to_asset.hpp"  // for getPathToAsset
+#include "resnet50_backends.hpp"                   // for Backend, Config
+
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+#if defined(PROTOCOL_HTTP)
+const auto* const kProtocol = "http";
+#elif defined(PROTOCOL_GRPC)
+const auto* const kProtocol = "grpc";
+#else
+const auto* const kProtocol = "native";
+#endif
+
+// requests sent in each iteration of a benchmark
+const auto kRequests = 256;
+// requests sent before measuring to load the model and fill the caches
+const auto kWarmupRequests = 16;
+
+/// Get the CPU time used by all the threads of this process
+Clock::duration getProcessCpuTime() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  auto toDuration = [](const timeval& time) {
+    return std::chrono::seconds(time.tv_sec) +
+           std::chrono::microseconds(time.tv_usec);
+  };
+  return std::chrono::duration_cast<Clock::duration>(
+    toDuration(usage.ru_utime) + toDuration(usage.ru_stime));
+}
+
+/**
+ * @brief Get a percentile of sorted values with the nearest-rank method
+ *
+ * @param sorted the values in increasing order
+ * @param percentile the percentile, from 0 to 1
+ * @return double
+ */
+double getPercentile(const std::vector<double>& sorted, double percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const auto rank = static_cast<size_t>(
+    std::ceil(percentile * static_cast<double>(sorted.size())));
+  return sorted.at(std::max(rank, size_t{1}) - 1);
+}
+
+/// A request that was sent and when
+struct InFlight {
+  amdinfer::InferenceResponseFuture future;
+  Clock::time_point sent;
+};
+
+/**
+ * @brief Send the requests keeping a fixed number in flight and collect the
+ * latency of each. The oldest request is waited on and then any others that
+ * are done are collected too so a response that arrives out of order is
+ * counted late by at most the time the oldest one takes.
+ *
+ * @param client the client to send the requests with
+ * @param endpoint the endpoint to send the requests to
+ * @param request the request to send
+ * @param count number of requests to send
+ * @param in_flight number of requests to keep in flight
+ * @param latencies the latencies in milliseconds are appended to this
+ * @return bool true if all the responses succeeded
+ */
+bool sendClosedLoop(const amdinfer::Client* client, const std::string& endpoint,
+                    const amdinfer::InferenceRequest& request, int count,
+                    int in_flight, std::vector<double>* latencies) {
+  std::deque<InFlight> pending;
+  bool succeeded = true;
+  auto collect = [&](InFlight& sent) {
+    succeeded &= !sent.future.get().isError();
+    latencies->push_back(Milliseconds(Clock::now() - sent.sent).count());
+  };
+
+  for (auto sent = 0; sent < count || !pending.empty();) {
+    while (sent < count && static_cast<int>(pending.size()) < in_flight) {
+      pending.push_back(
+        {client->modelInferAsync(endpoint, request), Clock::now()});
+      ++sent;
+    }
+    collect(pending.front());
+    pending.pop_front();
+    for (auto it = pending.begin(); it != pending.end();) {
+      if (it->future.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+        collect(*it);
+        it = pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  return succeeded;
+}
+
+// the benchmark function cannot be part of a namespace
+
+void matrix(benchmark::State& st, const amdinfer::Client* client,
+            Backend* backend) {
+  const auto extension = backend->extension();
+  if (!amdinfer::serverHasExtension(client, extension)) {
+    std::string error = extension + " support required but not found";
+    st.SkipWithError(error.c_str());
+    return;
+  }
+
+  Config config{static_cast<int>(st.range(0)), kRequests, 1};
+  backend->updateConfig(config);
+  st.SetLabel(config.toString());
+
+  backend->put("batch_size", config.batchSize());
+  backend->put("share", false);
+  const auto& request = backend->request();
+  // variants such as quantized models may not have their models available
+  std::string endpoint;
+  try {
+    endpoint = client->workerLoad(backend->name(), backend->parameters());
+  } catch (const amdinfer::runtime_error& e) {
+    st.SkipWithError(e.what());
+    return;
+  }
+  amdinfer::waitUntilModelReady(client, endpoint);
+
+  // report the predicted class to compare the accuracy of the variants
+  const auto response = client->modelInfer(endpoint, request);
+  if (!response.isError()) {
+    const auto& output = response.getOutputs().front();
+    if (output.getDatatype() == amdinfer::DataType::Fp32) {
+      const auto* scores = static_cast<const float*>(output.getData());
+      st.counters["top1"] = static_cast<double>(
+        std::max_element(scores, scores + output.getSize()) - scores);
+    }
+  }
+
+  // twice the batch size keeps the next batch filling while one runs
+  const auto in_flight = 2 * config.batchSize();
+  std::vector<double> latencies;
+  if (!sendClosedLoop(client, endpoint, request, kWarmupRequests, in_flight,
+                      &latencies)) {
+    st.SkipWithError("Error response from the server");
+    client->workerUnload(endpoint);
+    return;
+  }
+  latencies.clear();
+
+  bool succeeded = true;
+  const auto cpu_start = getProcessCpuTime();
+  const auto start = Clock::now();
+  for ([[maybe_unused]] auto _ : st) {
+    succeeded &= sendClosedLoop(client, endpoint, request, kRequests,
+                                in_flight, &latencies);
+  }
+  const auto wall = Clock::now() - start;
+  const auto cpu = getProcessCpuTime() - cpu_start;
+
+  client->workerUnload(endpoint);
+  amdinfer::waitUntilModelNotReady(client, endpoint);
+  if (!succeeded) {
+    st.SkipWithError("Error response from the server");
+    return;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  st.SetItemsProcessed(st.iterations() * kRequests);
+  st.counters["p50_ms"] = getPercentile(latencies, 0.5);
+  st.counters["p90_ms"] = getPercentile(latencies, 0.9);
+  st.counters["p99_ms"] = getPercentile(latencies, 0.99);
+  // the server runs in this process so this counts the client and the server
+  // as a percentage of all the cores
+  const auto cores = std::max(std::thread::hardware_concurrency(), 1U);
+  st.counters["cpu_utilization"] =
+    100 * std::chrono::duration<double>(cpu).count() /
+    (std::chrono::duration<double>(wall).count() * cores);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp)
+const std::vector<int64_t> kBatchSizes{1, 4, 16, 64};
+
+int main(int argc, char* argv[]) {
+  const amdinfer::Server server;
+
+#if defined(PROTOCOL_HTTP)
+  const auto default_http_port = 8998;
+  server.startHttp(default_http_port);
+  amdinfer::HttpClient client{"http://127.0.0.1:" +
+                              std::to_string(default_http_port)};
+#elif defined(PROTOCOL_GRPC)
+  const auto default_grpc_port = 50051;
+  server.startGrpc(default_grpc_port);
+  amdinfer::GrpcClient client{"127.0.0.1:" + std::to_string(default_grpc_port)};
+#else
+  amdinfer::NativeClient client{&server};
+#endif
+
+  std::vector<std::unique_ptr<Backend>> backends;
+  backends.reserve(kNumBackends);
+  const auto image_location =
+    amdinfer::getPathToAsset("asset_dog-3619020_640.jpg");
+
+  for (auto i = 0; i < kNumBackends; ++i) {
+    backends.push_back(getBackend(static_cast<Backends>(i)));
+    auto* backend = backends.back().get();
+    backend->preprocess(image_location);
+
+    // names are Matrix/<protocol>/<backend> so results from the executables
+    // of each protocol can be merged and compared
+    auto name = std::string{"Matrix/"} + kProtocol + "/" + backend->label();
+    auto* benchmark =
+      benchmark::RegisterBenchmark(name.c_str(), matrix, &client, backend);
+    for (const auto batch_size : kBatchSizes) {
+      benchmark->Arg(batch_size);
+    }
+    benchmark->ArgName("batch_size");
+    benchmark->Unit(benchmark::kMillisecond);
+    benchmark->UseRealTime();
+  }
+
+  amdinfer::waitUntilServerReady(&client);
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
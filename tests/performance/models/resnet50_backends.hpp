@@ -0,0 +1,425 @@
+// Copyright 2022 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Defines the ResNet50 backends that the model benchmarks run
+ */
+
+#ifndef GUARD_TESTS_PERFORMANCE_MODELS_RESNET50_BACKENDS
+#define GUARD_TESTS_PERFORMANCE_MODELS_RESNET50_BACKENDS
+
+#include <array>                // for array
+#include <cstdint>              // for int8_t
+#include <filesystem>           // for path, operator/
+#include <fstream>              // for ofstream
+#include <iostream>             // for operator<<, basic_...
+#include <memory>               // for unique_ptr, make_unique
+#include <opencv2/core.hpp>     // for CV_32FC3
+#include <opencv2/imgproc.hpp>  // for COLOR_BGR2RGB
+#include <string>               // for string, to_string
+#include <utility>              // for pair, move
+#include <vector>               // for vector
+
+#include "amdinfer/amdinfer.hpp"                   // for InferenceRequest
+#include "amdinfer/pre_post/image_preprocess.hpp"  // for ImagePreprocessOpt...
+#include "amdinfer/testing/get_path_to_asset.hpp"  // for getPathToAsset
+
+using InferenceRequest = amdinfer::InferenceRequest;
+using ParameterMap = amdinfer::ParameterMap;
+
+/**
+ * @brief This class wraps the different parameters used by these benchmarks.
+ * The benchmark library works by parameterizing numbers so if you want to pass
+ * other kinds of data to the tests, you need to wrap it in a class.
+ */
+class Config {
+ public:
+  Config(int batch_size, int requests, int workers)
+    : batch_size_({batch_size, batch_size}),
+      requests_(requests),
+      workers_(workers) {}
+
+  [[nodiscard]] int requests() const { return requests_; }
+  [[nodiscard]] int batchSize() const { return batch_size_.first; }
+  void batchSize(int batch_size) { batch_size_.second = batch_size; }
+  [[nodiscard]] int workers() const { return workers_; }
+
+  [[nodiscard]] std::string toString() const {
+    return "batch_size:" + std::to_string(batch_size_.second) + "(" +
+           std::to_string(batch_size_.first) +
+           ")/requests:" + std::to_string(requests_) +
+           "/workers:" + std::to_string(workers_);
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const Config& self) {
+    os << self.toString();
+    return os;
+  }
+
+ private:
+  // This is a pair representing the <requested, actual> value of the batch
+  // size. A particular backend may not support the requested batch size and
+  // use a different value
+  std::pair<int, int> batch_size_;
+  int requests_;
+  int workers_;
+};
+
+class Backend {
+ public:
+  virtual ~Backend() = default;
+
+  virtual void preprocess(const std::string& input_path) = 0;
+
+  [[nodiscard]] virtual std::string extension() const = 0;
+  [[nodiscard]] virtual std::string name() const = 0;
+  /// Get the name of the benchmark, which distinguishes variants of a backend
+  [[nodiscard]] virtual std::string label() const { return this->name(); }
+  virtual void updateConfig(Config& config) = 0;
+
+  void request(InferenceRequest request) { request_ = std::move(request); }
+  [[nodiscard]] const InferenceRequest& request() const { return request_; }
+
+  [[nodiscard]] const auto& parameters() const { return parameters_; }
+  void put(const std::string& key, const amdinfer::Parameter& value) {
+    parameters_.put(key, value);
+  }
+
+ private:
+  InferenceRequest request_;
+  ParameterMap parameters_;
+};
+
+const auto kImageHeight = 224;
+const auto kImageWidth = 224;
+const auto kImageChannels = 3;
+// for ImageNet dataset, 1000 output classes
+const auto kOutputClasses = 1000;
+
+#ifdef AMDINFER_ENABLE_PTZENDNN
+class Ptzendnn : public Backend {
+ public:
+  explicit Ptzendnn(std::string precision = "native")
+    : precision_(std::move(precision)) {
+    auto model = amdinfer::getPathToAsset("pt_resnet50");
+
+    this->put("model", model);
+    this->put("precision", precision_);
+  }
+
+  [[nodiscard]] std::string name() const override { return "ptzendnn"; }
+  [[nodiscard]] std::string label() const override {
+    return precision_ == "native" ? name() : name() + "_" + precision_;
+  }
+  [[nodiscard]] std::string extension() const override { return "ptzendnn"; }
+  void updateConfig([[maybe_unused]] Config& config) override {
+    // no update necessary
+  }
+
+  void preprocess(const std::string& input_path) override {
+    const std::array<float, 3> mean{0.485F, 0.456F, 0.406F};
+    const std::array<float, 3> std{4.367F, 4.464F, 4.444F};
+    const auto convert_scale = 1 / 255.0;
+
+    amdinfer::pre_post::ImagePreprocessOptions<float, 3> options;
+    options.normalize = true;
+    options.order = amdinfer::pre_post::ImageOrder::NCHW;
+    options.mean = mean;
+    options.std = std;
+    options.convert_color = true;
+    options.color_code = cv::COLOR_BGR2RGB;
+    options.convert_type = true;
+    options.type = CV_32FC3;
+    options.convert_scale = convert_scale;
+
+    images_ = amdinfer::pre_post::imagePreprocess({input_path}, options);
+
+    InferenceRequest request;
+    request.addInputTensor(images_[0].data(),
+                           {kImageChannels, kImageHeight, kImageWidth},
+                           amdinfer::DataType::Fp32);
+    this->request(std::move(request));
+  }
+
+ private:
+  std::string precision_;
+  std::vector<std::vector<float>> images_;
+};
+#endif  // AMDINFER_ENABLE_PTZENDNN
+
+#ifdef AMDINFER_ENABLE_TFZENDNN
+class Tfzendnn : public Backend {
+ public:
+  explicit Tfzendnn(std::string precision = "native")
+    : precision_(std::move(precision)) {
+    // arbitrarily set to 64
+    const int inter_op = 64;
+
+    auto model = amdinfer::getPathToAsset("tf_resnet50");
+
+    put("model", model);
+    put("input_node", std::string{"input"});
+    put("output_node", std::string{"resnet_v1_50/predictions/Reshape_1"});
+    put("input_size", kImageHeight);
+    put("output_classes", kOutputClasses);
+    put("inter_op", inter_op);
+    put("intra_op", 1);
+    put("precision", precision_);
+  }
+
+  [[nodiscard]] std::string name() const override { return "tfzendnn"; }
+  [[nodiscard]] std::string label() const override {
+    return precision_ == "native" ? name() : name() + "_" + precision_;
+  }
+  [[nodiscard]] std::string extension() const override { return "tfzendnn"; }
+  void updateConfig([[maybe_unused]] Config& config) override {
+    // no update necessary
+  }
+
+  void preprocess(const std::string& input_path) override {
+    amdinfer::pre_post::ImagePreprocessOptions<float, 3> options;
+    options.convert_color = true;
+    options.color_code = cv::COLOR_BGR2RGB;
+    options.assign = true;
+
+    images_ = amdinfer::pre_post::imagePreprocess({input_path}, options);
+
+    InferenceRequest request;
+    request.addInputTensor(images_[0].data(),
+                           {kImageChannels, kImageHeight, kImageWidth},
+                           amdinfer::DataType::Fp32);
+    this->request(std::move(request));
+  }
+
+ private:
+  std::string precision_;
+  std::vector<std::vector<float>> images_;
+};
+#endif  // AMDINFER_ENABLE_TFZENDNN
+
+#ifdef AMDINFER_ENABLE_VITIS
+class Vitis : public Backend {
+ public:
+  Vitis() {
+    auto model = amdinfer::getPathToAsset("u250_resnet50");
+    put("model", model);
+  }
+
+  [[nodiscard]] std::string name() const override { return "xmodel"; }
+  [[nodiscard]] std::string extension() const override { return "vitis"; }
+  void updateConfig(Config& config) override {
+    const int batch_size = 4;
+    config.batchSize(batch_size);
+  }
+
+  void preprocess(const std::string& input_path) override {
+    const std::array<int8_t, 3> mean{123, 107, 104};
+    const std::array<int8_t, 3> std{1, 1, 1};
+
+    amdinfer::pre_post::ImagePreprocessOptions<int8_t, 3> options;
+    options.order = amdinfer::pre_post::ImageOrder::NHWC;
+    options.mean = mean;
+    options.std = std;
+    options.normalize = true;
+    images_ = amdinfer::pre_post::imagePreprocess({input_path}, options);
+
+    InferenceRequest request;
+    request.addInputTensor(images_[0].data(),
+                           {kImageHeight, kImageWidth, kImageChannels},
+                           amdinfer::DataType::Int8);
+    this->request(std::move(request));
+  }
+
+ private:
+  std::vector<std::vector<int8_t>> images_;
+};
+#endif  // AMDINFER_ENABLE_VITIS
+
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+class Migraphx : public Backend {
+ public:
+  explicit Migraphx(std::string precision = "native")
+    : precision_(std::move(precision)) {
+    auto model = amdinfer::getPathToAsset("onnx_resnet50");
+    put("model", model);
+    put("precision", precision_);
+  }
+
+  [[nodiscard]] std::string name() const override { return "migraphx"; }
+  [[nodiscard]] std::string label() const override {
+    return precision_ == "native" ? name() : name() + "_" + precision_;
+  }
+  [[nodiscard]] std::string extension() const override { return "migraphx"; }
+  void updateConfig([[maybe_unused]] Config& config) override {
+    // no update necessary
+  }
+
+  void preprocess(const std::string& input_path) override {
+    const std::array<float, 3> mean{0.485F, 0.456F, 0.406F};
+    const std::array<float, 3> std{4.367F, 4.464F, 4.444F};
+    const auto image_size = 224;
+    const auto convert_scale = 1 / 255.0;
+
+    amdinfer::pre_post::ImagePreprocessOptions<float, kImageChannels> options;
+    options.order = amdinfer::pre_post::ImageOrder::NCHW;
+    options.height = image_size;
+    options.width = image_size;
+    options.mean = mean;
+    options.std = std;
+    options.normalize = true;
+    options.convert_color = true;
+    options.color_code = cv::COLOR_BGR2RGB;
+    options.convert_type = true;
+    options.type = CV_32FC3;
+    options.convert_scale = convert_scale;
+    images_ = amdinfer::pre_post::imagePreprocess({input_path}, options);
+
+    InferenceRequest request;
+    request.addInputTensor(images_[0].data(),
+                           {kImageHeight, kImageWidth, kImageChannels},
+                           amdinfer::DataType::Fp32);
+    this->request(std::move(request));
+
+    if (precision_ == "int8") {
+      // calibrate with the benchmarked image
+      const auto path = std::filesystem::temp_directory_path() /
+                        "amdinfer_resnet50_calibration.bin";
+      std::ofstream file{path, std::ios::binary};
+      file.write(reinterpret_cast<const char*>(images_[0].data()),
+                 static_cast<std::streamsize>(images_[0].size() *
+                                              sizeof(float)));
+      put("calibration", path.string());
+    }
+  }
+
+ private:
+  std::string precision_;
+  std::vector<std::vector<float>> images_;
+};
+#endif  // AMDINFER_ENABLE_MIGRAPHX
+
+#ifdef AMDINFER_ENABLE_ONNXRUNTIME
+class Onnx : public Backend {
+ public:
+  Onnx() {
+    auto model = amdinfer::getPathToAsset("onnx_resnet50");
+    put("model", model);
+  }
+
+  [[nodiscard]] std::string name() const override { return "onnxruntime"; }
+  [[nodiscard]] std::string extension() const override {
+    return "onnxruntime";
+  }
+  void updateConfig([[maybe_unused]] Config& config) override {
+    // no update necessary
+  }
+
+  void preprocess(const std::string& input_path) override {
+    const std::array<float, 3> mean{0.485F, 0.456F, 0.406F};
+    const std::array<float, 3> std{4.367F, 4.464F, 4.444F};
+    const auto convert_scale = 1 / 255.0;
+
+    amdinfer::pre_post::ImagePreprocessOptions<float, kImageChannels> options;
+    options.order = amdinfer::pre_post::ImageOrder::NCHW;
+    options.mean = mean;
+    options.std = std;
+    options.normalize = true;
+    options.convert_color = true;
+    options.color_code = cv::COLOR_BGR2RGB;
+    options.convert_type = true;
+    options.type = CV_32FC3;
+    options.convert_scale = convert_scale;
+    images_ = amdinfer::pre_post::imagePreprocess({input_path}, options);
+
+    InferenceRequest request;
+    request.addInputTensor(images_[0].data(),
+                           {kImageChannels, kImageHeight, kImageWidth},
+                           amdinfer::DataType::Fp32);
+    this->request(std::move(request));
+  }
+
+ private:
+  std::vector<std::vector<float>> images_;
+};
+#endif  // AMDINFER_ENABLE_ONNXRUNTIME
+
+enum class Backends {
+#ifdef AMDINFER_ENABLE_TFZENDNN
+  Tfzendnn,
+  TfzendnnBf16,
+  TfzendnnInt8,
+#endif
+#ifdef AMDINFER_ENABLE_PTZENDNN
+  Ptzendnn,
+  PtzendnnBf16,
+  PtzendnnInt8,
+#endif
+#ifdef AMDINFER_ENABLE_VITIS
+  Vitis,
+#endif
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+  Migraphx,
+  MigraphxFp16,
+  MigraphxInt8,
+#endif
+#ifdef AMDINFER_ENABLE_ONNXRUNTIME
+  Onnx,
+#endif
+  // this is used find the number of backends enabled. It is NOT a backend. This
+  // must be the last enum value
+  Count
+};
+const auto kNumBackends = static_cast<int>(Backends::Count);
+
+inline std::unique_ptr<Backend> getBackend(Backends index) {
+  switch (index) {
+#ifdef AMDINFER_ENABLE_TFZENDNN
+    case Backends::Tfzendnn:
+      return std::make_unique<Tfzendnn>();
+    case Backends::TfzendnnBf16:
+      return std::make_unique<Tfzendnn>("bf16");
+    case Backends::TfzendnnInt8:
+      return std::make_unique<Tfzendnn>("int8");
+#endif
+#ifdef AMDINFER_ENABLE_PTZENDNN
+    case Backends::Ptzendnn:
+      return std::make_unique<Ptzendnn>();
+    case Backends::PtzendnnBf16:
+      return std::make_unique<Ptzendnn>("bf16");
+    case Backends::PtzendnnInt8:
+      return std::make_unique<Ptzendnn>("int8");
+#endif
+#ifdef AMDINFER_ENABLE_VITIS
+    case Backends::Vitis:
+      return std::make_unique<Vitis>();
+#endif
+#ifdef AMDINFER_ENABLE_MIGRAPHX
+    case Backends::Migraphx:
+      return std::make_unique<Migraphx>();
+    case Backends::MigraphxFp16:
+      return std::make_unique<Migraphx>("fp16");
+    case Backends::MigraphxInt8:
+      return std::make_unique<Migraphx>("int8");
+#endif
+#ifdef AMDINFER_ENABLE_ONNXRUNTIME
+    case Backends::Onnx:
+      return std::make_unique<Onnx>();
+#endif
+    default:
+      throw amdinfer::invalid_argument("Unknown argument");
+  }
+}
+
+#endif  // GUARD_TESTS_PERFORMANCE_MODELS_RESNET50_BACKENDS
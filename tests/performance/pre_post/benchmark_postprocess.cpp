@@ -0,0 +1,160 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for int64_t
+#include <random>   // for mt19937, normal_distribution
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/pre_post/get_top_k.hpp"             // for getTopK
+#include "amdinfer/pre_post/resnet50_postprocess.hpp"  // for resnet50Post...
+#include "amdinfer/pre_post/softmax.hpp"               // for calcSoftmax
+#include "amdinfer/pre_post/yolo_postprocess.hpp"      // for decodeYolo
+
+// the benchmark functions cannot be part of a namespace
+
+namespace {
+
+constexpr size_t kTopK = 5;
+
+/// Make a batch of random logits
+std::vector<float> makeLogits(size_t batch, size_t classes) {
+  std::mt19937 generator{1};
+  std::normal_distribution<float> distribution{0, 4};
+  std::vector<float> data(batch * classes);
+  for (auto& value : data) {
+    value = distribution(generator);
+  }
+  return data;
+}
+
+/// Make the three NCHW outputs of YOLOv3 for a 416x416 input. Objectness is
+/// biased low so most cells are empty as in real images
+std::vector<std::vector<float>> makeYoloOutputs(
+  const amdinfer::pre_post::YoloOptions& options) {
+  std::mt19937 generator{1};
+  std::normal_distribution<float> distribution{0, 2};
+  std::normal_distribution<float> objectness{-6, 2};
+  const auto attributes = static_cast<size_t>(5 + options.classes);
+
+  std::vector<std::vector<float>> outputs;
+  for (auto grid : {52, 26, 13}) {
+    const auto cells = static_cast<size_t>(grid) * grid;
+    std::vector<float> data(cells * attributes * options.anchors);
+    for (auto i = 0U; i < data.size(); ++i) {
+      const auto attribute = (i / cells) % attributes;
+      data[i] = attribute == 4 ? objectness(generator) : distribution(generator);
+    }
+    outputs.push_back(std::move(data));
+  }
+  return outputs;
+}
+
+}  // namespace
+
+/// The scalar double precision softmax and top-k of one row at a time
+void scalarPostprocess(benchmark::State& st) {
+  const auto batch = static_cast<size_t>(st.range(0));
+  const auto classes = static_cast<size_t>(st.range(1));
+  const auto data = makeLogits(batch, classes);
+  std::vector<double> softmax(classes);
+
+  for ([[maybe_unused]] auto _ : st) {
+    for (auto row = 0U; row < batch; ++row) {
+      amdinfer::pre_post::calcSoftmax(data.data() + row * classes, classes,
+                                      softmax.data());
+      benchmark::DoNotOptimize(
+        amdinfer::pre_post::getTopK(softmax.data(), classes, kTopK));
+    }
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * batch));
+}
+
+/// The vectorized softmax and the heap-based top-k over the whole batch
+void batchPostprocess(benchmark::State& st) {
+  const auto batch = static_cast<size_t>(st.range(0));
+  const auto classes = static_cast<size_t>(st.range(1));
+  const auto data = makeLogits(batch, classes);
+  std::vector<float> softmax(data.size());
+  std::vector<int> indices(batch * kTopK);
+
+  for ([[maybe_unused]] auto _ : st) {
+    amdinfer::pre_post::calcSoftmax(data.data(), batch, classes,
+                                    softmax.data());
+    amdinfer::pre_post::getTopK(softmax.data(), batch, classes, kTopK,
+                                indices.data());
+    benchmark::DoNotOptimize(indices.data());
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * batch));
+}
+
+/// The top-k of each row as the ResNet50 examples get their labels
+void resnet50Postprocess(benchmark::State& st) {
+  const auto batch = static_cast<size_t>(st.range(0));
+  const auto classes = static_cast<size_t>(st.range(1));
+  const auto data = makeLogits(batch, classes);
+
+  for ([[maybe_unused]] auto _ : st) {
+    for (auto row = 0U; row < batch; ++row) {
+      benchmark::DoNotOptimize(amdinfer::pre_post::resnet50Postprocess(
+        data.data() + row * classes, classes, kTopK));
+    }
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * batch));
+}
+
+/// Decode and suppress the boxes of one YOLOv3 image
+void yoloPostprocess(benchmark::State& st) {
+  amdinfer::pre_post::YoloOptions options;
+  options.biases = {10, 13,  16,  30,  33, 23,  30,  61,  62,
+                    45, 59,  119, 116, 90, 156, 198, 373, 326};
+  const auto outputs = makeYoloOutputs(options);
+  const std::vector<int> grids{52, 26, 13};
+
+  for ([[maybe_unused]] auto _ : st) {
+    amdinfer::pre_post::YoloBoxes boxes;
+    for (auto i = 0U; i < outputs.size(); ++i) {
+      amdinfer::pre_post::decodeYolo(outputs[i].data(), grids[i], grids[i], i,
+                                     options, &boxes);
+    }
+    benchmark::DoNotOptimize(amdinfer::pre_post::nonMaximumSuppression(
+      boxes, options.iou_threshold));
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations()));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp)
+const std::initializer_list<std::vector<int64_t>> kRange{
+  {1, 64},        // batch size
+  {1000, 21843}  // classes
+};
+
+// each thread postprocesses its own batch, as the workers of a model do
+void postprocessArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgsProduct(kRange);
+  benchmark->Threads(1);
+  benchmark->Threads(4);
+  benchmark->Unit(benchmark::kMicrosecond);
+  benchmark->UseRealTime();
+}
+
+// NOLINTBEGIN(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(scalarPostprocess)->Apply(postprocessArgs);
+BENCHMARK(batchPostprocess)->Apply(postprocessArgs);
+BENCHMARK(resnet50Postprocess)->Apply(postprocessArgs);
+BENCHMARK(yoloPostprocess)->Unit(benchmark::kMicrosecond);
+// NOLINTEND(cert-err58-cpp, cppcoreguidelines-owning-memory)
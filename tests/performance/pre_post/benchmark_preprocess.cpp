@@ -0,0 +1,171 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Measures preprocessing the test images for ResNet50 with the fused
+ * path, the step by step OpenCV reference and a center crop. The images are
+ * scaled to a range of source resolutions and preprocessed in batches by one
+ * or more threads at once so a new implementation can be compared against
+ * these for the cases the servers see.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>                // for size_t
+#include <cstdint>                // for int64_t
+#include <map>                    // for map
+#include <opencv2/core.hpp>       // for Mat, Size, CV_32FC3
+#include <opencv2/imgcodecs.hpp>  // for imread
+#include <opencv2/imgproc.hpp>    // for resize, COLOR_BGR2RGB, INTER_AREA
+#include <stdexcept>              // for invalid_argument
+#include <string>                 // for string
+#include <vector>                 // for vector
+
+#include "amdinfer/pre_post/center_crop.hpp"       // for centerCrop
+#include "amdinfer/pre_post/image_preprocess.hpp"  // for imagePreprocess
+#include "amdinfer/testing/get_path_to_asset.hpp"  // for getPathToAsset
+
+// the benchmark functions cannot be part of a namespace
+
+namespace {
+
+using Options = amdinfer::pre_post::ImagePreprocessOptions<float, 3>;
+
+constexpr auto kChannels = 3;
+// widths of the source images. The assets are 640 wide and are scaled up to
+// the common camera resolutions keeping their aspect ratio
+const std::vector<int64_t> kWidths{640, 1280, 1920};
+
+/// Get the decoded test images scaled to each of the widths
+const std::map<int64_t, std::vector<cv::Mat>>& getImages() {
+  // a function static is built once even if several threads call this
+  static const auto images = []() {
+    const std::vector<std::string> assets{"asset_dog-3619020_640.jpg",
+                                          "asset_bicycle-384566_640.jpg",
+                                          "asset_girl-1867092_640.jpg"};
+    std::map<int64_t, std::vector<cv::Mat>> scaled;
+    for (const auto& asset : assets) {
+      const auto path = amdinfer::getPathToAsset(asset);
+      auto img = cv::imread(path);
+      if (img.empty()) {
+        throw std::invalid_argument("Unable to load image " + path);
+      }
+      for (const auto width : kWidths) {
+        const auto height =
+          static_cast<int>(img.rows * width / static_cast<int64_t>(img.cols));
+        cv::Mat resized;
+        cv::resize(img, resized, cv::Size(static_cast<int>(width), height), 0,
+                   0, cv::INTER_LINEAR);
+        scaled[width].push_back(resized);
+      }
+    }
+    return scaled;
+  }();
+  return images;
+}
+
+/// The ResNet50 preprocessing used by the examples. The fused path takes it
+Options getOptions() {
+  const auto kScale = 1.0 / 255;
+  Options options;
+  options.convert_color = true;
+  options.color_code = cv::COLOR_BGR2RGB;
+  options.convert_type = true;
+  options.type = CV_32FC3;
+  options.convert_scale = kScale;
+  options.normalize = true;
+  options.order = amdinfer::pre_post::ImageOrder::NCHW;
+  options.mean = {0.485F, 0.456F, 0.406F};
+  options.std = {4.367F, 4.464F, 4.444F};
+  return options;
+}
+
+/**
+ * @brief Preprocess batches of the images. Each benchmark thread fills its
+ * own batch so the threads only share the source images. The arguments are
+ * the width of the source images and the batch size
+ *
+ * @param st the benchmark state
+ * @param options the preprocessing options
+ * @param run preprocess one image into the output
+ */
+template <typename F>
+void preprocessBatch(benchmark::State& st, const Options& options, F run) {
+  const auto& images = getImages().at(st.range(0));
+  const auto batch = static_cast<size_t>(st.range(1));
+  const auto image_size =
+    static_cast<size_t>(options.height) * options.width * kChannels;
+  std::vector<float> output(batch * image_size);
+
+  int64_t bytes = 0;
+  for ([[maybe_unused]] auto _ : st) {
+    for (auto i = 0U; i < batch; ++i) {
+      const auto& img = images[i % images.size()];
+      run(img, options, output.data() + i * image_size);
+      bytes += static_cast<int64_t>(img.total() * img.elemSize());
+    }
+    benchmark::ClobberMemory();
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * batch));
+  st.SetBytesProcessed(bytes);
+}
+
+}  // namespace
+
+/// The fused path that imagePreprocess takes for these options
+void fusedPreprocess(benchmark::State& st) {
+  preprocessBatch(st, getOptions(),
+                  [](const cv::Mat& img, const Options& options, float* out) {
+                    amdinfer::pre_post::imagePreprocess(img, options, out);
+                  });
+}
+
+/// The same preprocessing step by step with OpenCV
+void referencePreprocess(benchmark::State& st) {
+  preprocessBatch(st, getOptions(),
+                  [](const cv::Mat& img, const Options& options, float* out) {
+                    amdinfer::pre_post::detail::preprocessReference(
+                      img, options, out);
+                  });
+}
+
+/// Crop the center of the image instead of resizing it. The crop is a view so
+/// this measures copying it out of the larger image
+void centerCropPreprocess(benchmark::State& st) {
+  auto options = getOptions();
+  options.resize_algorithm = amdinfer::pre_post::ResizeAlgorithm::CenterCrop;
+  preprocessBatch(st, options,
+                  [](const cv::Mat& img, const Options& options, float* out) {
+                    amdinfer::pre_post::imagePreprocess(img, options, out);
+                  });
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp)
+const std::vector<int64_t> kBatchSizes{1, 8, 32};
+
+void preprocessArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"width", "batch_size"});
+  benchmark->ArgsProduct({kWidths, kBatchSizes});
+  benchmark->Threads(1);
+  benchmark->Threads(4);
+  benchmark->Unit(benchmark::kMillisecond);
+  benchmark->UseRealTime();
+}
+
+// NOLINTBEGIN(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(fusedPreprocess)->Apply(preprocessArgs);
+BENCHMARK(referencePreprocess)->Apply(preprocessArgs);
+BENCHMARK(centerCropPreprocess)->Apply(preprocessArgs);
+// NOLINTEND(cert-err58-cpp, cppcoreguidelines-owning-memory)
@@ -0,0 +1,108 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Compares parsing JSON inference requests through jsoncpp with the
+ * fast parser used by the REST server
+ */
+
+#include <benchmark/benchmark.h>
+#include <json/reader.h>  // for CharReaderBuilder
+#include <json/value.h>   // for Value
+
+#include <cstdint>  // for int64_t
+#include <memory>   // for make_shared, unique_ptr
+#include <string>   // for string, to_string
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/servers/http_server.hpp"     // for getRequest
+#include "amdinfer/servers/json_request.hpp"    // for parseJsonRequest
+
+namespace amdinfer {
+
+void release(const MemoryPool& pool, const InferenceRequestPtr& request) {
+  for (const auto& input : request->getInputs()) {
+    pool.put(MemoryAllocators::Cpu, input.getData());
+  }
+}
+
+std::string makeRequest(int64_t elements, const std::string& datatype) {
+  std::string json = R"({"id": "benchmark", "inputs": [{"name": "input", )";
+  json += R"("datatype": ")" + datatype + R"(", )";
+  json += R"("shape": [)" + std::to_string(elements) + R"(], "data": [)";
+  for (auto i = 0; i < elements; ++i) {
+    if (i != 0) {
+      json += ", ";
+    }
+    json += datatype == "FP32" ? std::to_string(i * 0.5) : std::to_string(i);
+  }
+  json += "]}]}";
+  return json;
+}
+
+// the current path: build a jsoncpp DOM and then walk it to make the request
+void jsoncpp(benchmark::State& state, const std::string& datatype) {
+  MemoryPool pool;
+  const auto json = makeRequest(state.range(0), datatype);
+
+  Json::CharReaderBuilder builder;
+  for ([[maybe_unused]] auto _ : state) {
+    std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+    auto root = std::make_shared<Json::Value>();
+    std::string errors;
+    reader->parse(json.data(), json.data() + json.size(), root.get(), &errors);
+    auto request = getRequest(root, &pool);
+    benchmark::DoNotOptimize(request);
+    release(pool, request);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(json.size()));
+}
+
+void fast(benchmark::State& state, const std::string& datatype) {
+  MemoryPool pool;
+  const auto json = makeRequest(state.range(0), datatype);
+
+  for ([[maybe_unused]] auto _ : state) {
+    auto request = parseJsonRequest(json, &pool);
+    benchmark::DoNotOptimize(request);
+    release(pool, request);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(json.size()));
+}
+
+const auto kMinElements = 1 << 4;
+const auto kMaxElements = 1 << 16;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK_CAPTURE(jsoncpp, Int32, std::string{"INT32"})
+  ->RangeMultiplier(16)
+  ->Range(kMinElements, kMaxElements);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK_CAPTURE(fast, Int32, std::string{"INT32"})
+  ->RangeMultiplier(16)
+  ->Range(kMinElements, kMaxElements);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK_CAPTURE(jsoncpp, Fp32, std::string{"FP32"})
+  ->RangeMultiplier(16)
+  ->Range(kMinElements, kMaxElements);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK_CAPTURE(fast, Fp32, std::string{"FP32"})
+  ->RangeMultiplier(16)
+  ->Range(kMinElements, kMaxElements);
+
+}  // namespace amdinfer
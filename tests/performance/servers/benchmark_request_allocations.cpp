@@ -0,0 +1,127 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Counts the heap allocations made to build one inference request from
+ * a JSON body
+ */
+
+#include <benchmark/benchmark.h>
+#include <json/reader.h>  // for CharReaderBuilder
+#include <json/value.h>   // for Value
+
+#include <atomic>   // for atomic
+#include <cstdint>  // for int64_t
+#include <cstdlib>  // for malloc, free
+#include <memory>   // for make_shared, unique_ptr
+#include <new>      // for bad_alloc
+#include <string>   // for string, to_string
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/servers/http_server.hpp"     // for getRequest
+#include "amdinfer/servers/json_request.hpp"    // for parseJsonRequest
+
+namespace {
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<int64_t> allocations{0};
+
+}  // namespace
+
+// count every allocation in the program, including those made in libamdinfer
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  if (void* memory = std::malloc(size); memory != nullptr) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+namespace amdinfer {
+
+void release(const MemoryPool& pool, const InferenceRequestPtr& request) {
+  for (const auto& input : request->getInputs()) {
+    pool.put(MemoryAllocators::Cpu, input.getData());
+  }
+}
+
+std::string makeRequest(int64_t inputs) {
+  std::string json = R"({"id": "benchmark", "parameters": {"a": 1}, )";
+  json += R"("inputs": [)";
+  for (auto i = 0; i < inputs; ++i) {
+    if (i != 0) {
+      json += ", ";
+    }
+    json += R"({"name": "input_)" + std::to_string(i) + R"(", )";
+    json += R"("datatype": "INT32", "shape": [1, 4], "data": [1, 2, 3, 4]})";
+  }
+  json += R"(], "outputs": [{"name": "output"}]})";
+  return json;
+}
+
+template <typename F>
+void countAllocations(benchmark::State& state, F&& parse) {
+  MemoryPool pool;
+  const auto json = makeRequest(state.range(0));
+
+  // the first request warms up the pool
+  release(pool, parse(json, &pool));
+
+  int64_t total = 0;
+  for ([[maybe_unused]] auto _ : state) {
+    const auto before = allocations.load(std::memory_order_relaxed);
+    auto request = parse(json, &pool);
+    total += allocations.load(std::memory_order_relaxed) - before;
+    benchmark::DoNotOptimize(request);
+    release(pool, request);
+  }
+  state.counters["allocations"] = benchmark::Counter(
+    static_cast<double>(total), benchmark::Counter::kAvgIterations);
+}
+
+void jsoncpp(benchmark::State& state) {
+  countAllocations(state, [](const std::string& json, const MemoryPool* pool) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+    auto root = std::make_shared<Json::Value>();
+    std::string errors;
+    reader->parse(json.data(), json.data() + json.size(), root.get(), &errors);
+    return getRequest(root, pool);
+  });
+}
+
+void fast(benchmark::State& state) {
+  countAllocations(state, [](const std::string& json, const MemoryPool* pool) {
+    return parseJsonRequest(json, pool);
+  });
+}
+
+const auto kMinInputs = 1;
+const auto kMaxInputs = 8;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(jsoncpp)->RangeMultiplier(2)->Range(kMinInputs, kMaxInputs);
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK(fast)->RangeMultiplier(2)->Range(kMinInputs, kMaxInputs);
+
+}  // namespace amdinfer
@@ -0,0 +1,328 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Measures the layers that convert requests and responses to and from
+ * JSON for REST and to and from proto for gRPC on both the server and the
+ * client. Each benchmark reports the bytes of the serialized message
+ * processed per second and the heap allocations made per call.
+ */
+
+#include <benchmark/benchmark.h>
+#include <json/reader.h>  // for CharReaderBuilder
+#include <json/value.h>   // for Value
+#include <json/writer.h>  // for StreamWriterBuilder, writeString
+
+#include <atomic>       // for atomic
+#include <cstddef>      // for byte, size_t
+#include <cstdint>      // for int64_t
+#include <cstdlib>      // for malloc, free
+#include <memory>       // for make_shared, unique_ptr
+#include <new>          // for bad_alloc
+#include <string>       // for string, to_string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_GRPC
+#include "amdinfer/clients/http_internal.hpp"    // for mapRequestToJson
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/servers/http_server.hpp"      // for getRequest
+#include "amdinfer/servers/json_request.hpp"     // for parseJsonRequest
+#include "amdinfer/servers/json_response.hpp"    // for serializeJsonResp...
+#include "amdinfer/testing/perf_counters.hpp"    // for PerfCounters
+
+#ifdef AMDINFER_ENABLE_GRPC
+#include "amdinfer/clients/grpc_internal.hpp"  // for mapRequestToProto
+#include "amdinfer/observation/observer.hpp"   // for Observer
+#include "inference.pb.h"                      // for ModelInferRequest
+#endif
+
+namespace {
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<int64_t> allocations{0};
+
+}  // namespace
+
+// count every allocation in the program, including those made in libamdinfer
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  if (void* memory = std::malloc(size); memory != nullptr) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+namespace amdinfer {
+
+/**
+ * @brief Make data for a tensor that looks like real data of its type: pixel
+ * values for FP32, token IDs for INT64 and text for BYTES
+ *
+ * @param type datatype of the tensor
+ * @param elements number of elements
+ * @return std::vector<std::byte>
+ */
+std::vector<std::byte> makeData(DataType type, int64_t elements) {
+  const auto size = static_cast<size_t>(elements) * type.size();
+  std::vector<std::byte> data(size);
+  // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+  for (auto i = 0; i < elements; ++i) {
+    if (type == DataType::Fp32) {
+      reinterpret_cast<float*>(data.data())[i] = static_cast<float>(i % 256) /
+                                                 255.0F;
+    } else if (type == DataType::Int64) {
+      reinterpret_cast<int64_t*>(data.data())[i] = (i * 7919) % 50'000;
+    } else {
+      data[i] = static_cast<std::byte>('a' + i % 26);
+    }
+  }
+  // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+  return data;
+}
+
+/// A request and response with one tensor of the given type and size
+struct Messages {
+  Messages(DataType type, int64_t elements)
+    : data(makeData(type, elements)) {
+    request.setID("benchmark");
+    request.addInputTensor(data.data(), {elements}, type, "input");
+
+    response.setID("benchmark");
+    response.setModel("benchmark");
+    InferenceResponseOutput output;
+    output.setName("output");
+    output.setDatatype(type);
+    output.setShape({elements});
+    output.setData(std::vector<std::byte>{data});
+    response.addOutput(output);
+  }
+
+  std::vector<std::byte> data;
+  InferenceRequest request;
+  InferenceResponse response;
+};
+
+/**
+ * @brief Run a benchmark and report the bytes processed and the allocations
+ * made per iteration
+ *
+ * @param state the benchmark state
+ * @param bytes size of the serialized message each iteration processes
+ * @param run the code to measure
+ */
+template <typename F>
+void measure(benchmark::State& state, size_t bytes, F&& run) {
+  int64_t total = 0;
+  const PerfCounters counters{state};
+  for ([[maybe_unused]] auto _ : state) {
+    const auto before = allocations.load(std::memory_order_relaxed);
+    run();
+    total += allocations.load(std::memory_order_relaxed) - before;
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+  state.counters["allocations"] = benchmark::Counter(
+    static_cast<double>(total), benchmark::Counter::kAvgIterations);
+}
+
+std::string toString(const Json::Value& json) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, json);
+}
+
+void release(const MemoryPool& pool, const InferenceRequestPtr& request) {
+  for (const auto& input : request->getInputs()) {
+    pool.put(MemoryAllocators::Cpu, input.getData());
+  }
+}
+
+// the REST server: parse the body to a jsoncpp DOM and build the request
+void httpGetRequest(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  const auto body = toString(mapRequestToJson(messages.request));
+  MemoryPool pool;
+  Json::CharReaderBuilder builder;
+
+  measure(state, body.size(), [&]() {
+    std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+    auto root = std::make_shared<Json::Value>();
+    std::string errors;
+    reader->parse(body.data(), body.data() + body.size(), root.get(), &errors);
+    auto request = getRequest(root, &pool);
+    benchmark::DoNotOptimize(request);
+    release(pool, request);
+  });
+}
+
+// the REST server: build the request straight from the body
+void httpParseJsonRequest(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  const auto body = toString(mapRequestToJson(messages.request));
+  MemoryPool pool;
+
+  measure(state, body.size(), [&]() {
+    auto request = parseJsonRequest(body, &pool);
+    benchmark::DoNotOptimize(request);
+    release(pool, request);
+  });
+}
+
+// the REST server: write the response body
+void httpSerializeResponse(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  size_t header_length = 0;
+  const auto size =
+    serializeJsonResponse(messages.response, {}, &header_length).size();
+
+  measure(state, size, [&]() {
+    auto body = serializeJsonResponse(messages.response, {}, &header_length);
+    benchmark::DoNotOptimize(body);
+  });
+}
+
+// the REST client: write the request body
+void httpMapRequestToJson(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  const auto size = toString(mapRequestToJson(messages.request)).size();
+
+  measure(state, size, [&]() {
+    auto body = toString(mapRequestToJson(messages.request));
+    benchmark::DoNotOptimize(body);
+  });
+}
+
+// the REST client: parse the response body and build the response
+void httpMapJsonToResponse(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  size_t header_length = 0;
+  const auto body =
+    serializeJsonResponse(messages.response, {}, &header_length);
+  const auto length = std::to_string(body.size());
+
+  measure(state, body.size(), [&]() {
+    std::string_view binary;
+    auto json = parseBinaryBody(body, length, &binary);
+    auto response = mapJsonToResponse(json.get(), binary);
+    benchmark::DoNotOptimize(response);
+  });
+}
+
+#ifdef AMDINFER_ENABLE_GRPC
+
+// the gRPC client: map the request to proto and serialize it
+void grpcMapRequestToProto(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  const Observer observer;
+  std::string serialized;
+  {
+    inference::ModelInferRequest proto;
+    mapRequestToProto(messages.request, proto, observer);
+    proto.SerializeToString(&serialized);
+  }
+
+  measure(state, serialized.size(), [&]() {
+    inference::ModelInferRequest proto;
+    mapRequestToProto(messages.request, proto, observer);
+    proto.SerializeToString(&serialized);
+    benchmark::DoNotOptimize(serialized);
+  });
+}
+
+// the gRPC server: map the response to proto and serialize it
+void grpcMapResponseToProto(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  std::string serialized;
+  {
+    inference::ModelInferResponse proto;
+    mapResponseToProto(messages.response, proto);
+    proto.SerializeToString(&serialized);
+  }
+
+  measure(state, serialized.size(), [&]() {
+    inference::ModelInferResponse proto;
+    mapResponseToProto(messages.response, proto);
+    proto.SerializeToString(&serialized);
+    benchmark::DoNotOptimize(serialized);
+  });
+}
+
+// the gRPC client: parse the response and map it back
+void grpcMapProtoToResponse(benchmark::State& state, DataType type) {
+  const Messages messages{type, state.range(0)};
+  const Observer observer;
+  std::string serialized;
+  {
+    inference::ModelInferResponse proto;
+    mapResponseToProto(messages.response, proto);
+    proto.SerializeToString(&serialized);
+  }
+
+  measure(state, serialized.size(), [&]() {
+    inference::ModelInferResponse proto;
+    proto.ParseFromString(serialized);
+    InferenceResponse response;
+    mapProtoToResponse(proto, response, observer);
+    benchmark::DoNotOptimize(response);
+  });
+}
+
+#endif
+
+// a classification output and a 224x224 RGB image
+const auto kFp32Small = 1000;
+const auto kFp32Image = 224 * 224 * 3;
+// a short prompt and a long context of token IDs
+const auto kInt64Short = 128;
+const auto kInt64Long = 4096;
+// a sentence and a document
+const auto kBytesShort = 64;
+const auto kBytesLong = 65'536;
+
+// NOLINTBEGIN(cert-err58-cpp, cppcoreguidelines-owning-memory)
+#define SERIALIZATION_BENCHMARK(name)                        \
+  BENCHMARK_CAPTURE(name, Fp32, DataType{DataType::Fp32})    \
+    ->Arg(kFp32Small)                                        \
+    ->Arg(kFp32Image);                                       \
+  BENCHMARK_CAPTURE(name, Int64, DataType{DataType::Int64})  \
+    ->Arg(kInt64Short)                                       \
+    ->Arg(kInt64Long);                                       \
+  BENCHMARK_CAPTURE(name, Bytes, DataType{DataType::Bytes})  \
+    ->Arg(kBytesShort)                                       \
+    ->Arg(kBytesLong)
+
+SERIALIZATION_BENCHMARK(httpGetRequest);
+SERIALIZATION_BENCHMARK(httpParseJsonRequest);
+SERIALIZATION_BENCHMARK(httpSerializeResponse);
+SERIALIZATION_BENCHMARK(httpMapRequestToJson);
+SERIALIZATION_BENCHMARK(httpMapJsonToResponse);
+#ifdef AMDINFER_ENABLE_GRPC
+SERIALIZATION_BENCHMARK(grpcMapRequestToProto);
+SERIALIZATION_BENCHMARK(grpcMapResponseToProto);
+SERIALIZATION_BENCHMARK(grpcMapProtoToResponse);
+#endif
+// NOLINTEND(cert-err58-cpp, cppcoreguidelines-owning-memory)
+
+}  // namespace amdinfer
@@ -0,0 +1,235 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Measures how long a fresh server takes to become ready: constructing
+ * the Server, loading all the models in a repository and loading each model
+ * on its own. Each load is broken down into the phases the server reports in
+ * the amdinfer_model_load_seconds metric, such as opening the worker's library
+ * and compiling the model, so the results saved with --benchmark_out show
+ * where the time goes.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>      // for steady_clock, duration
+#include <cstdlib>     // for getenv
+#include <filesystem>  // for path, directory_iterator
+#include <map>         // for map
+#include <memory>      // for make_unique
+#include <set>         // for set
+#include <sstream>     // for istringstream
+#include <string>      // for string, getline, stod
+#include <vector>      // for vector
+
+#include "amdinfer/amdinfer.hpp"                // for Server, NativeClient
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_METRICS
+#include "amdinfer/core/exceptions.hpp"         // for environment_not_set...
+#include "amdinfer/observation/load_times.hpp"  // for LoadPhase
+#include "amdinfer/observation/metrics.hpp"     // for Metrics
+
+namespace fs = std::filesystem;
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+/**
+ * @brief Get the model repository to load. It's AMDINFER_REPOSITORY if it's
+ * set and the repository used by the tests otherwise
+ *
+ * @return fs::path
+ */
+fs::path getRepository() {
+  if (const auto* repository = std::getenv("AMDINFER_REPOSITORY");
+      repository != nullptr) {
+    return repository;
+  }
+  const auto* root = std::getenv("AMDINFER_ROOT");
+  if (root == nullptr) {
+    throw amdinfer::environment_not_set_error(
+      "AMDINFER_ROOT or AMDINFER_REPOSITORY must be set");
+  }
+  return fs::path{root} / "external/artifacts/repository";
+}
+
+/// Series of the load time metric mapped to their value in seconds
+using LoadSeries = std::map<std::string, double>;
+
+/**
+ * @brief Get the series of the load time metric from the server's metrics.
+ * They're empty if the server is built without metrics
+ *
+ * @return LoadSeries
+ */
+LoadSeries getLoadSeries() {
+  LoadSeries series;
+#ifdef AMDINFER_ENABLE_METRICS
+  const std::string metric = "amdinfer_model_load_seconds{";
+  std::istringstream metrics{amdinfer::Metrics::getInstance().getMetrics()};
+  std::string line;
+  while (std::getline(metrics, line)) {
+    const auto end = line.rfind(' ');
+    if (line.rfind(metric, 0) == 0 && end != std::string::npos) {
+      series[line.substr(0, end)] = std::stod(line.substr(end + 1));
+    }
+  }
+#endif
+  return series;
+}
+
+/**
+ * @brief Add the time of each phase of the loads that happened since the
+ * previous series were read. A model with many stages adds up the phases of
+ * all of them
+ *
+ * @param before the series before the loads
+ * @param after the series after the loads
+ * @param totals the seconds spent in each phase, by its name
+ */
+void addLoadTimes(const LoadSeries& before, const LoadSeries& after,
+                  std::map<std::string, double>* totals) {
+  for (const auto& [labels, seconds] : after) {
+    if (before.find(labels) != before.end()) {
+      continue;
+    }
+    for (auto i = 0; i < static_cast<int>(amdinfer::LoadPhase::Count); ++i) {
+      const std::string phase =
+        amdinfer::getLoadPhaseName(static_cast<amdinfer::LoadPhase>(i));
+      if (labels.find("phase=\"" + phase + "\"") != std::string::npos) {
+        (*totals)[phase] += seconds;
+      }
+    }
+  }
+}
+
+/// Report the average time of each phase per iteration in milliseconds
+void setLoadCounters(benchmark::State& st,
+                     const std::map<std::string, double>& totals) {
+  const auto kMilliseconds = 1000.0;
+  for (const auto& [phase, seconds] : totals) {
+    st.counters[phase + "_ms"] = benchmark::Counter(
+      seconds * kMilliseconds, benchmark::Counter::kAvgIterations);
+  }
+}
+
+/// Unload the models a test loaded, leaving the server's own workers
+void unloadAll(const amdinfer::NativeClient& client,
+               const std::set<std::string>& keep) {
+  for (const auto& model : client.modelList()) {
+    if (keep.find(model) == keep.end()) {
+      client.modelUnload(model);
+      amdinfer::waitUntilModelNotReady(&client, model);
+    }
+  }
+}
+
+// the benchmark functions cannot be part of a namespace
+
+/// Construct a server until it's ready to accept requests
+void serverConstruction(benchmark::State& st) {
+  for ([[maybe_unused]] auto _ : st) {
+    const auto start = Clock::now();
+    auto server = std::make_unique<amdinfer::Server>();
+    const amdinfer::NativeClient client{server.get()};
+    amdinfer::waitUntilServerReady(&client);
+    st.SetIterationTime(Seconds(Clock::now() - start).count());
+
+    server.reset();
+  }
+}
+
+/// Set the repository with load_existing so all its models are loaded
+void repositoryLoad(benchmark::State& st, const fs::path& repository) {
+  std::map<std::string, double> totals;
+  size_t models = 0;
+  for ([[maybe_unused]] auto _ : st) {
+    amdinfer::Server server;
+    const amdinfer::NativeClient client{&server};
+    const auto list = client.modelList();
+    const std::set<std::string> keep{list.begin(), list.end()};
+
+    const auto before = getLoadSeries();
+    const auto start = Clock::now();
+    server.setModelRepository(repository, true);
+    st.SetIterationTime(Seconds(Clock::now() - start).count());
+    addLoadTimes(before, getLoadSeries(), &totals);
+
+    models = client.modelList().size() - keep.size();
+    unloadAll(client, keep);
+  }
+  st.counters["models"] = static_cast<double>(models);
+  setLoadCounters(st, totals);
+}
+
+/// Load one model from the repository until it's ready
+void modelLoad(benchmark::State& st, const fs::path& repository,
+               const std::string& model) {
+  amdinfer::Server server;
+  const amdinfer::NativeClient client{&server};
+  server.setModelRepository(repository, false);
+  const auto list = client.modelList();
+  const std::set<std::string> keep{list.begin(), list.end()};
+
+  std::map<std::string, double> totals;
+  for ([[maybe_unused]] auto _ : st) {
+    const auto before = getLoadSeries();
+    const auto start = Clock::now();
+    try {
+      client.modelLoad(model, {});
+    } catch (const amdinfer::runtime_error& e) {
+      st.SkipWithError(e.what());
+      break;
+    }
+    amdinfer::waitUntilModelReady(&client, model);
+    st.SetIterationTime(Seconds(Clock::now() - start).count());
+    addLoadTimes(before, getLoadSeries(), &totals);
+
+    unloadAll(client, keep);
+  }
+  setLoadCounters(st, totals);
+}
+
+int main(int argc, char* argv[]) {
+  const auto repository = getRepository();
+
+  // every iteration starts the server or loads the models from scratch so
+  // a few are enough
+  const auto kIterations = 5;
+
+  benchmark::RegisterBenchmark("Startup/server", serverConstruction)
+    ->Iterations(kIterations)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark("Startup/repository", repositoryLoad,
+                               repository)
+    ->Iterations(kIterations)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+  for (const auto& path : fs::directory_iterator(repository)) {
+    if (!path.is_directory()) {
+      continue;
+    }
+    const auto model = path.path().filename().string();
+    const auto name = "Startup/load/" + model;
+    benchmark::RegisterBenchmark(name.c_str(), modelLoad, repository, model)
+      ->Iterations(kIterations)
+      ->UseManualTime()
+      ->Unit(benchmark::kMillisecond);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
@@ -35,10 +35,14 @@
 
 namespace amdinfer {
 
-WorkerInfo::WorkerInfo(const std::string& name, ParameterMap* parameters,
+WorkerInfo::WorkerInfo([[maybe_unused]] const std::string& endpoint,
+                       const std::string& name, ParameterMap* parameters,
                        MemoryPool* pool, BatchPtrQueue* next,
-                       std::vector<MemoryAllocators> next_allocators)
-  : next_(next), next_allocators_(std::move(next_allocators)) {
+                       std::vector<MemoryAllocators> next_allocators,
+                       const Batcher* next_batcher)
+  : next_(next),
+    next_allocators_(std::move(next_allocators)),
+    next_batcher_(next_batcher) {
   this->batch_size_ = 1;
 
   this->addAndStartWorker(name, parameters, pool);
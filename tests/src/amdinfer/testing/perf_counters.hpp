@@ -0,0 +1,164 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief Counts hardware and software events with perf_event_open while a
+ * benchmark runs and reports them as benchmark counters
+ */
+
+#ifndef GUARD_SRC_AMDINFER_TESTING_PERF_COUNTERS
+#define GUARD_SRC_AMDINFER_TESTING_PERF_COUNTERS
+
+#include <benchmark/benchmark.h>
+#include <linux/perf_event.h>  // for perf_event_attr, PERF_COUNT_HW_CPU_...
+#include <sys/ioctl.h>         // for ioctl
+#include <sys/syscall.h>       // for SYS_perf_event_open
+#include <unistd.h>            // for close, read, syscall
+
+#include <array>    // for array
+#include <cstdint>  // for uint64_t, uint32_t
+#include <cstdlib>  // for getenv
+#include <string>   // for string
+#include <vector>   // for vector
+
+namespace amdinfer {
+
+/**
+ * @brief Counts cycles, instructions, last level cache misses, branch misses
+ * and context switches on the calling thread, and on the threads it starts
+ * while counting, between its construction and destruction. The counts are
+ * then reported per iteration as counters of the benchmark. Counting is off
+ * unless AMDINFER_PERF_COUNTERS is set in the environment and events that
+ * can't be opened, e.g. in a VM or with a strict perf_event_paranoid, are
+ * skipped.
+ *
+ * Construct it just before the benchmark loop:
+ *
+ *   PerfCounters counters{state};
+ *   for (auto _ : state) { ... }
+ */
+class PerfCounters {
+ public:
+  explicit PerfCounters(benchmark::State& state) : state_(state) {
+    if (std::getenv("AMDINFER_PERF_COUNTERS") == nullptr) {
+      return;
+    }
+    for (const auto& event : kEvents) {
+      const auto fd = open(event.type, event.config);
+      if (fd >= 0) {
+        counters_.push_back({event.name, fd});
+      }
+    }
+    for (const auto& counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  PerfCounters(PerfCounters const&) = delete;  ///< Copy constructor
+  /// Copy assignment constructor
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  PerfCounters(PerfCounters&& other) = delete;  ///< Move constructor
+  /// Move assignment constructor
+  PerfCounters& operator=(PerfCounters&& other) = delete;
+
+  /// Stop counting and report the counts per iteration
+  ~PerfCounters() {
+    for (const auto& counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    double cycles = 0;
+    double instructions = 0;
+    for (const auto& counter : counters_) {
+      const auto value = read(counter.fd);
+      close(counter.fd);
+      state_.counters[counter.name] =
+        benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+      const std::string name{counter.name};
+      if (name == "cycles") {
+        cycles = value;
+      } else if (name == "instructions") {
+        instructions = value;
+      }
+    }
+    if (cycles > 0 && instructions > 0) {
+      state_.counters["IPC"] = instructions / cycles;
+    }
+  }
+
+ private:
+  struct Event {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+  };
+
+  struct Counter {
+    const char* name;
+    int fd;
+  };
+
+  static constexpr std::array<Event, 5> kEvents{
+    {{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+     {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+     // the kernel maps this to last level cache misses on most CPUs
+     {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+     {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+     {"context_switches", PERF_TYPE_SOFTWARE,
+      PERF_COUNT_SW_CONTEXT_SWITCHES}}};
+
+  static int open(uint32_t type, uint64_t config) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    // context switches happen in the kernel so they can't exclude it
+    attr.exclude_kernel = type == PERF_TYPE_HARDWARE ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // count the calling thread on any CPU
+    const pid_t pid = 0;
+    const int cpu = -1;
+    const int group = -1;
+    return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, pid, cpu, group, 0UL));
+  }
+
+  /// Read a count, scaled up if the kernel multiplexed the counter
+  static double read(int fd) {
+    // value, time enabled and time running
+    std::array<uint64_t, 3> values{};
+    if (::read(fd, values.data(), sizeof(values)) !=
+        static_cast<ssize_t>(sizeof(values))) {
+      return 0;
+    }
+    const auto [value, enabled, running] = values;
+    if (running == 0) {
+      return 0;
+    }
+    return static_cast<double>(value) * static_cast<double>(enabled) /
+           static_cast<double>(running);
+  }
+
+  benchmark::State& state_;
+  std::vector<Counter> counters_;
+};
+
+}  // namespace amdinfer
+
+#endif  // GUARD_SRC_AMDINFER_TESTING_PERF_COUNTERS
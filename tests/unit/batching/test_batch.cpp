@@ -0,0 +1,80 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for byte
+#include <memory>   // for make_unique, make_shared
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/batching/batch.hpp"           // for Batch
+#include "amdinfer/buffers/cpu.hpp"              // for CpuBuffer
+#include "amdinfer/core/exceptions.hpp"          // for runtime_error
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse...
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBatch, ShareInputBuffers) {
+  MemoryPool pool;
+  std::vector<int> memory(4);
+  // borrowed memory can be put back once so it shows when it's freed
+  pool.borrow(memory.data());
+
+  Batch batch;
+  BufferPtrs buffers;
+  buffers.push_back(
+    std::make_unique<CpuBuffer>(memory.data(), MemoryAllocators::Cpu));
+  buffers.back()->setPool(&pool);
+  batch.addRequestBuffers(std::move(buffers));
+
+  auto owner = batch.shareInputBuffers();
+  EXPECT_TRUE(batch.isScatterGather());
+  // the batch doesn't free the shared buffers
+  batch.freeInputBuffers();
+
+  auto output = std::make_unique<InferenceResponseOutput>();
+  output->setData(memory.data(), memory.size() * sizeof(int), owner);
+  EXPECT_EQ(output->getData(), memory.data());
+  owner.reset();
+
+  // copies of the output keep the memory alive too
+  auto copy = *output;
+  output.reset();
+  EXPECT_EQ(copy.getData(), memory.data());
+
+  copy.setData(std::vector<std::byte>{});
+  EXPECT_THROW(pool.put(MemoryAllocators::Cpu, memory.data()), runtime_error);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBatch, Recycle) {
+  const size_t capacity = 4;
+  auto batch = Batch::create(capacity);
+  EXPECT_GE(batch->getRequests().capacity(), capacity);
+  batch->addRequest(std::make_shared<InferenceRequest>());
+  batch->addModel("model");
+  const auto* address = batch.get();
+  batch.reset();
+
+  // the released batch is reused, emptied, with its capacity kept
+  batch = Batch::create();
+  EXPECT_EQ(batch.get(), address);
+  EXPECT_TRUE(batch->empty());
+  EXPECT_GE(batch->getRequests().capacity(), capacity);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,162 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>   // for uint8_t, int64_t
+#include <future>    // for promise
+#include <memory>    // for make_unique, make_shared
+#include <optional>  // for optional
+#include <utility>   // for move
+#include <vector>    // for vector
+
+#include "amdinfer/batching/bucket.hpp"         // for BucketBatcher
+#include "amdinfer/buffers/buffer.hpp"          // for Buffer
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"         // for DataType
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/request_container.hpp"   // for RequestContainer
+#include "amdinfer/core/worker_info.hpp"         // for WorkerInfo
+#include "amdinfer/observation/logging.hpp"      // for initLogger, LogLevel
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ
+
+namespace amdinfer {
+
+// timeout in ms for the batcher
+constexpr auto kTimeoutMs = 100;
+// timeout in us with a safety factor of 10 to read from the batcher
+constexpr auto kTimeoutUs = kTimeoutMs * 1000 * 10;
+
+class UnitBucketBatcherFixture : public testing::Test {
+ protected:
+  void SetUp() override {
+#ifdef AMDINFER_ENABLE_LOGGING
+    LogOptions options{
+      "server",         // logger_name
+      "",               // log directory
+      false,            // enable file logging
+      LogLevel::Debug,  // file log level
+      true,             // enable console logging
+      LogLevel::Warn    // console log level
+    };
+    initLogger(options);
+#endif
+
+    ParameterMap parameters;
+    parameters.put("timeout", kTimeoutMs);
+    parameters.put("buckets", "8,4");
+
+    this->batcher_.emplace(&pool_, &parameters);
+    this->batcher_->setName("test");
+    this->batcher_->setBatchSize(2);
+
+    std::vector<MemoryAllocators> next;
+    this->worker_.emplace("test", "", &parameters, &pool_, nullptr, next);
+
+    this->batcher_->start({MemoryAllocators::Cpu});
+  }
+
+  void TearDown() override {
+    batcher_->enqueue(nullptr);
+    batcher_->end();
+  }
+
+  // enqueue a request whose data counts up from zero
+  InferenceRequestPtr enqueue(const std::vector<int64_t>& shape) {
+    InferenceRequestInput input{nullptr, shape, DataType::Uint8};
+    auto buffer = pool_.get({MemoryAllocators::Cpu}, input, 1);
+    auto* data = static_cast<uint8_t*>(buffer->data(0));
+    for (auto i = 0U; i < input.getSize(); ++i) {
+      data[i] = static_cast<uint8_t>(i);
+    }
+
+    auto request = std::make_shared<InferenceRequest>();
+    request->addInputTensor(data, shape, DataType::Uint8);
+    auto req = std::make_unique<RequestContainer>();
+    req->request = request;
+    batcher_->enqueue(std::move(req));
+    return request;
+  }
+
+  BatchPtr dequeue() {
+    BatchPtr batch;
+    EXPECT_TRUE(
+      batcher_->getOutputQueue()->wait_dequeue_timed(batch, kTimeoutUs));
+    return batch;
+  }
+
+  std::optional<BucketBatcher> batcher_;
+
+ private:
+  std::optional<WorkerInfo> worker_;
+  MemoryPool pool_;
+};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitBucketBatcherFixture, PadsToBucket) {
+  EXPECT_EQ(batcher_->getBuckets(), (std::vector<int64_t>{4, 8}));
+
+  auto first = this->enqueue({2, 3});
+  this->enqueue({2, 7});
+  this->enqueue({2, 2});
+
+  // the first and third requests share a bucket and fill a batch
+  auto batch = this->dequeue();
+  ASSERT_NE(batch, nullptr);
+  EXPECT_EQ(batch->size(), 2);
+  EXPECT_EQ(first->getInputs()[0].getShape(), (std::vector<int64_t>{2, 4}));
+
+  const std::vector<uint8_t> golden{0, 1, 2, 0, 3, 4, 5, 0, 0, 1, 0, 0, 2, 3};
+  auto* data = static_cast<uint8_t*>(batch->getInputBuffers()[0]->data(0));
+  for (auto i = 0U; i < golden.size(); ++i) {
+    EXPECT_EQ(data[i], golden[i]);
+  }
+
+  // the second request is sent on its own after the timeout
+  batch = this->dequeue();
+  ASSERT_NE(batch, nullptr);
+  EXPECT_EQ(batch->size(), 1);
+  EXPECT_EQ(batch->getRequest(0)->getInputs()[0].getShape(),
+            (std::vector<int64_t>{2, 8}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitBucketBatcherFixture, RejectsOversized) {
+  std::promise<InferenceResponse> promise;
+  auto future = promise.get_future();
+
+  InferenceRequestInput input{nullptr, {1, 9}, DataType::Uint8};
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(input);
+  request->setCallback([&promise](const InferenceResponse& response) {
+    promise.set_value(response);
+  });
+  auto req = std::make_unique<RequestContainer>();
+  req->request = request;
+  batcher_->enqueue(std::move(req));
+
+  EXPECT_TRUE(future.get().isError());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBucketBatcher, InvalidBuckets) {
+  MemoryPool pool;
+  ParameterMap parameters;
+  parameters.put("buckets", "4,abc");
+  EXPECT_THROW(BucketBatcher(&pool, &parameters), invalid_argument);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,286 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>   // for milliseconds
+#include <cstdint>  // for uint8_t
+#include <memory>   // for make_shared, make_unique
+#include <ratio>    // for kilo, micro
+#include <vector>   // for vector
+
+#include "amdinfer/batching/hard.hpp"            // for HardBatcher
+#include "amdinfer/buffers/buffer.hpp"           // for Buffer
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "amdinfer/core/request_container.hpp"   // for InferenceRequestInput
+#include "amdinfer/core/worker_info.hpp"         // for WorkerInfo
+#include "amdinfer/util/timer.hpp"               // for Timer
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, TEST
+
+namespace amdinfer {
+
+namespace {
+
+RequestContainerPtr makeRequest(const MemoryPool& pool, uint8_t value) {
+  InferenceRequestInput input{nullptr, {2}, DataType::Uint8};
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+  std::vector<uint8_t> data{value, value};
+  buffer->write(data.data(), 0, data.size());
+
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(buffer->data(0), {2}, DataType::Uint8);
+  auto req = std::make_unique<RequestContainer>();
+  req->request = request;
+  return req;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitHardBatcher, MaxWait) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto max_wait_ms = 20;
+  const auto timeout_ms = 1000;
+  ParameterMap parameters;
+  parameters.put("max_wait", max_wait_ms);
+  HardBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(4);
+  batcher.start({MemoryAllocators::Cpu});
+
+  // a full batch is sent as soon as it forms
+  for (auto i = 0; i < 4; ++i) {
+    batcher.enqueue(makeRequest(pool, 1));
+  }
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  EXPECT_EQ(batch->size(), 4);
+  batch->freeInputBuffers();
+
+  // a partial batch is sent once the wait passes, padded to the batch size
+  util::Timer timer{true};
+  batcher.enqueue(makeRequest(pool, 2));
+  batcher.enqueue(makeRequest(pool, 3));
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  timer.stop();
+  EXPECT_EQ(batch->size(), 2);
+  EXPECT_GE(timer.count<std::milli>(), max_wait_ms / 2);
+  EXPECT_LT(timer.count<std::milli>(), timeout_ms / 2);
+
+  const auto* data =
+    static_cast<uint8_t*>(batch->getInputBuffers().at(0)->data(0));
+  EXPECT_EQ(std::vector<uint8_t>(data, data + 8),
+            (std::vector<uint8_t>{2, 2, 3, 3, 0, 0, 0, 0}));
+  batch->freeInputBuffers();
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitHardBatcher, UnboundSamples) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto timeout_ms = 1000;
+  ParameterMap parameters;
+  parameters.put("max_wait", 10);
+  HardBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(4);
+  batcher.start({MemoryAllocators::Cpu});
+
+  // requests kept whole by endpoints without bound inputs count as the
+  // samples along their leading dimension, here two of one byte each
+  for (const uint8_t value : {1, 2, 3}) {
+    auto request = makeRequest(pool, value);
+    request->samples = 2;
+    batcher.enqueue(std::move(request));
+  }
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  EXPECT_EQ(batch->size(), 2);
+  batch->freeInputBuffers();
+
+  // the partial batch is padded by samples rather than requests
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  EXPECT_EQ(batch->size(), 1);
+  const auto* data =
+    static_cast<uint8_t*>(batch->getInputBuffers().at(0)->data(0));
+  EXPECT_EQ(std::vector<uint8_t>(data, data + 4),
+            (std::vector<uint8_t>{3, 3, 0, 0}));
+  batch->freeInputBuffers();
+
+  // a request with more samples than the batch is sent alone and isn't padded
+  auto oversized = makeRequest(pool, 4);
+  oversized->samples = 6;
+  batcher.enqueue(std::move(oversized));
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  EXPECT_EQ(batch->size(), 1);
+  batch->freeInputBuffers();
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitHardBatcher, SetBatchSize) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto timeout_ms = 1000;
+  ParameterMap parameters;
+  HardBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(4);
+  batcher.start({MemoryAllocators::Cpu});
+
+  for (auto i = 0; i < 4; ++i) {
+    batcher.enqueue(makeRequest(pool, 1));
+  }
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  EXPECT_EQ(batch->size(), 4);
+  batch->freeInputBuffers();
+
+  // the batch that's already open may keep the old size but the ones after it
+  // use the new one
+  batcher.setBatchSize(2);
+  EXPECT_EQ(batcher.getBatchSize(), 2);
+  for (auto i = 0; i < 8; ++i) {
+    batcher.enqueue(makeRequest(pool, 2));
+  }
+  std::vector<size_t> sizes;
+  for (size_t count = 0; count < 8; count += sizes.back()) {
+    ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+      batch, timeout_ms * std::kilo::num));
+    sizes.push_back(batch->size());
+    batch->freeInputBuffers();
+  }
+  ASSERT_GE(sizes.size(), 3);
+  for (auto i = 1U; i < sizes.size(); ++i) {
+    EXPECT_EQ(sizes.at(i), 2);
+  }
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitHardBatcher, Direct) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  ParameterMap parameters;
+  HardBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(1);
+  batcher.start({MemoryAllocators::Cpu});
+
+  // a batch of one is sent by the enqueueing thread and takes the request's
+  // memory instead of copying it
+  auto request = makeRequest(pool, 1);
+  auto* data = request->request->getInputs().at(0).getData();
+  batcher.enqueue(std::move(request));
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->try_dequeue(batch));
+  EXPECT_EQ(batch->size(), 1);
+  EXPECT_EQ(batch->getInputBuffers().at(0)->data(0), data);
+  batch->freeInputBuffers();
+
+  // inline batches skip the output queue
+  size_t ran = 0;
+  batcher.setInline([&ran](BatchPtr batch) {
+    ran += batch->size();
+    batch->freeInputBuffers();
+  });
+  batcher.enqueue(makeRequest(pool, 2));
+  EXPECT_EQ(ran, 1);
+  EXPECT_FALSE(batcher.getOutputQueue()->try_dequeue(batch));
+
+  batcher.setInline(nullptr);
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitHardBatcher, Layout) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto timeout_ms = 1000;
+  ParameterMap parameters;
+  parameters.put("input_layout", "CW");
+  parameters.put("batch_datatype", "FP32");
+  HardBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(1);
+  batcher.start({MemoryAllocators::Cpu});
+
+  // a 3x2 input in the WC layout is transposed and cast as it's batched
+  InferenceRequestInput input{nullptr, {3, 2}, DataType::Uint8};
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+  std::vector<uint8_t> values{0, 1, 2, 3, 4, 5};
+  buffer->write(values.data(), 0, values.size());
+  input.setData(buffer->data(0));
+  ParameterMap input_parameters;
+  input_parameters.put("layout", "WC");
+  input.setParameters(input_parameters);
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(input);
+  auto req = std::make_unique<RequestContainer>();
+  req->request = request;
+  batcher.enqueue(std::move(req));
+
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  const auto& batched = batch->getRequest(0)->getInputs().at(0);
+  EXPECT_EQ(batched.getShape(), (Shape{2, 3}));
+  EXPECT_EQ(batched.getDatatype(), DataType::Fp32);
+  const auto* data =
+    static_cast<float*>(batch->getInputBuffers().at(0)->data(0));
+  EXPECT_EQ(std::vector<float>(data, data + 6),
+            (std::vector<float>{0, 2, 4, 1, 3, 5}));
+  batch->freeInputBuffers();
+
+  // layouts that don't match the endpoint's are rejected
+  bool failed = false;
+  input_parameters.put("layout", "WH");
+  input.setParameters(input_parameters);
+  request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(input);
+  request->setCallback([&failed](const InferenceResponse& response) {
+    failed = response.isError();
+  });
+  req = std::make_unique<RequestContainer>();
+  req->request = request;
+  batcher.enqueue(std::move(req));
+  EXPECT_TRUE(failed);
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,93 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // for milliseconds
+#include <memory>  // for allocator
+
+#include "amdinfer/batching/sequence.hpp"       // for SequenceBatcher
+#include "amdinfer/buffers/buffer.hpp"          // for Buffer
+#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"         // for DataType
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/core/request_container.hpp"  // for RequestContainer
+#include "amdinfer/core/worker_info.hpp"        // for WorkerInfo
+#include "amdinfer/observation/logging.hpp"  // for initLogger, LogLevel, Log...
+#include "gtest/gtest.h"                     // for Test, SuiteApiResolver, TEST
+
+namespace amdinfer {
+
+namespace {
+
+RequestContainerPtr makeRequest(const MemoryPool& pool) {
+  InferenceRequestInput input{nullptr, {1}, DataType::Uint8};
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(buffer->data(0), {1}, DataType::Uint8);
+
+  auto req = std::make_unique<RequestContainer>();
+  req->request = request;
+  return req;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSequenceBatcher, PassesWaitingRequests) {
+#ifdef AMDINFER_ENABLE_LOGGING
+  LogOptions options{
+    "server",         // logger_name
+    "",               // log directory
+    false,            // enable file logging
+    LogLevel::Debug,  // file log level
+    true,             // enable console logging
+    LogLevel::Warn    // console log level
+  };
+  initLogger(options);
+#endif
+
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  SequenceBatcher batcher(&pool);
+  batcher.setName("test");
+  batcher.setBatchSize(4);
+
+  // requests that are already waiting are passed on together, up to the batch
+  // size, in place
+  const auto waiting = 3;
+  for (auto i = 0; i < waiting; ++i) {
+    batcher.enqueue(makeRequest(pool));
+  }
+  batcher.start({MemoryAllocators::Cpu});
+
+  const auto timeout = std::chrono::milliseconds(1000);
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(batch, timeout));
+  EXPECT_EQ(batch->size(), waiting);
+  EXPECT_TRUE(batch->isScatterGather());
+  batch->freeInputBuffers();
+
+  // a lone request isn't held back to fill the batch
+  batcher.enqueue(makeRequest(pool));
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(batch, timeout));
+  EXPECT_EQ(batch->size(), 1);
+  batch->freeInputBuffers();
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+}  // namespace amdinfer
@@ -13,18 +13,78 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <memory>  // for allocator
+#include <atomic>   // for atomic_bool
+#include <chrono>   // for milliseconds, seconds
+#include <cstddef>  // for byte
+#include <cstdint>  // for int64_t, uint8_t
+#include <future>   // for promise, future_status
+#include <memory>   // for allocator, make_shared
+#include <string>   // for string, to_string
+#include <vector>   // for vector
 
-#include "amdinfer/batching/soft.hpp"           // for SoftBatcher
-#include "amdinfer/build_options.hpp"           // for AMDINFER_ENABLE_LOGGING
-#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
-#include "amdinfer/core/request_container.hpp"  // for InferenceRequestInput
-#include "amdinfer/core/worker_info.hpp"        // for WorkerInfo
+#include "amdinfer/batching/batcher.hpp"         // for Batcher
+#include "amdinfer/batching/soft.hpp"            // for SoftBatcher
+#include "amdinfer/buffers/buffer.hpp"           // for Buffer
+#include "amdinfer/build_options.hpp"            // for AMDINFER_ENABLE_LOGGING
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"    // for MemoryPool
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap, Parameter
+#include "amdinfer/core/request_container.hpp"   // for InferenceRequestInput
+#include "amdinfer/core/worker_info.hpp"         // for WorkerInfo
 #include "amdinfer/observation/logging.hpp"  // for initLogger, LogLevel, Log...
+#include "amdinfer/util/timer.hpp"           // for Timer
 #include "gtest/gtest.h"                     // for Test, SuiteApiResolver, TEST
 
 namespace amdinfer {
 
+namespace {
+
+RequestContainerPtr makeRequest(const MemoryPool& pool, const std::string& key,
+                                const Parameter& value) {
+  InferenceRequestInput input{nullptr, {1}, DataType::Uint8};
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(buffer->data(0), {1}, DataType::Uint8);
+  ParameterMap parameters;
+  parameters.put(key, value);
+  request->setParameters(parameters);
+
+  auto req = std::make_unique<RequestContainer>();
+  req->request = request;
+  return req;
+}
+
+/// Makes a request to an endpoint without bound inputs that is kept whole
+RequestContainerPtr makeSamples(const MemoryPool& pool, int64_t samples) {
+  InferenceRequestInput input{nullptr, {samples}, DataType::Uint8};
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(buffer->data(0), {samples}, DataType::Uint8);
+  auto req = std::make_unique<RequestContainer>();
+  req->request = request;
+  req->samples = static_cast<size_t>(samples);
+  return req;
+}
+
+/// Checks if the batcher fails the request as soon as it's enqueued
+bool isRejected(const Batcher& batcher, RequestContainerPtr request) {
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  request->request->setCallback(
+    [&promise](const InferenceResponse& response) {
+      promise.set_value(response.isError());
+    });
+  batcher.enqueue(std::move(request));
+  const auto status = future.wait_for(std::chrono::seconds(0));
+  return status == std::future_status::ready && future.get();
+}
+
+}  // namespace
+
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST(UnitSoftBatcher, ConstructAndStart) {
 #ifdef AMDINFER_ENABLE_LOGGING
@@ -44,9 +104,317 @@ TEST(UnitSoftBatcher, ConstructAndStart) {
   SoftBatcher batcher(&pool);
   batcher.setName("test");
 
-  WorkerInfo fake("", nullptr, &pool, nullptr, {});
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+  batcher.start({MemoryAllocators::Cpu});
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, Deadlines) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto timeout_ms = 1000;
+  ParameterMap parameters;
+  parameters.put("timeout", timeout_ms);
+  SoftBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(4);
+  batcher.start({MemoryAllocators::Cpu});
+
+  // a request that has already expired is rejected
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  auto expired = makeRequest(pool, "deadline", 0);
+  expired->request->setCallback([&promise](const InferenceResponse& response) {
+    promise.set_value(response.isError());
+  });
+  batcher.enqueue(std::move(expired));
+  EXPECT_TRUE(future.get());
+
+  // a partial batch is sent by its tightest deadline instead of the timeout
+  const auto deadline_ms = 50;
+  util::Timer timer{true};
+  batcher.enqueue(makeRequest(pool, "deadline", deadline_ms));
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  timer.stop();
+  EXPECT_EQ(batch->size(), 1);
+  EXPECT_LT(timer.count<std::milli>(), timeout_ms / 2);
+
+  // JSON holds fractional and negative deadlines as doubles. Fractional ones
+  // are kept and negative ones, like those that aren't numbers, are rejected
+  EXPECT_TRUE(isRejected(batcher, makeRequest(pool, "deadline", -1.0)));
+  EXPECT_TRUE(
+    isRejected(batcher, makeRequest(pool, "deadline", std::string{"soon"})));
+  const auto fractional_ms = 12.5;
+  util::Timer fractional_timer{true};
+  batcher.enqueue(makeRequest(pool, "deadline", fractional_ms));
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  fractional_timer.stop();
+  EXPECT_EQ(batch->size(), 1);
+  EXPECT_LT(fractional_timer.count<std::milli>(), timeout_ms / 2);
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, Priorities) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  ParameterMap parameters;
+  parameters.put("timeout", 10);
+  SoftBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(3);
+
+  // JSON holds negative and fractional numbers as doubles. Negative ones are
+  // clamped to the highest priority and fractional ones are rounded down
+  const std::vector<Parameter> priorities{2, 1.5, -1.0};
+  for (auto i = 0U; i < priorities.size(); ++i) {
+    auto request = makeRequest(pool, "priority", priorities[i]);
+    request->request->setID(std::to_string(i));
+    batcher.enqueue(std::move(request));
+  }
+  EXPECT_TRUE(
+    isRejected(batcher, makeRequest(pool, "priority", std::string{"high"})));
+
+  // the queued requests are taken in order of their priority once it starts
+  batcher.start({MemoryAllocators::Cpu});
+  BatchPtr batch;
+  ASSERT_TRUE(
+    batcher.getOutputQueue()->wait_dequeue_timed(batch, std::micro::den));
+  ASSERT_EQ(batch->size(), priorities.size());
+  EXPECT_EQ(batch->getRequest(0)->getID(), "2");
+  EXPECT_EQ(batch->getRequest(1)->getID(), "1");
+  EXPECT_EQ(batch->getRequest(2)->getID(), "0");
+  batch->freeInputBuffers();
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, UnboundSamples) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto timeout_ms = 1000;
+  ParameterMap parameters;
+  parameters.put("timeout", 10);
+  SoftBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(4);
+
+  // requests are counted by their samples so the next one starts a new batch
+  // if it doesn't fit. One with more samples than the batch is sent alone
+  for (const auto samples : {3, 2, 8}) {
+    batcher.enqueue(makeSamples(pool, samples));
+  }
+  batcher.start({MemoryAllocators::Cpu});
+
+  for (const auto samples : {3, 2, 8}) {
+    BatchPtr batch;
+    ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+      batch, timeout_ms * std::kilo::num));
+    ASSERT_EQ(batch->size(), 1);
+    EXPECT_EQ(batch->getRequest(0)->getInputs()[0].getShape()[0], samples);
+    batch->freeInputBuffers();
+  }
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, UnboundBatchOfOne) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  const auto timeout_ms = 1000;
+  SoftBatcher batcher(&pool);
+  batcher.setName("test");
+  batcher.setBatchSize(1);
+
+  // an unbatched input, e.g. an image of shape [H, W, 3], to an endpoint that
+  // publishes no inputs isn't rejected for its leading dimension, whether the
+  // batcher's thread or the enqueueing thread makes its batch
+  const auto samples = 5;
+  batcher.enqueue(makeSamples(pool, samples));
+  batcher.start({MemoryAllocators::Cpu});
+  batcher.enqueue(makeSamples(pool, samples));
+
+  for (auto i = 0; i < 2; ++i) {
+    BatchPtr batch;
+    ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+      batch, timeout_ms * std::kilo::num));
+    ASSERT_EQ(batch->size(), 1);
+    EXPECT_EQ(batch->getRequest(0)->getInputs()[0].getShape()[0], samples);
+    batch->freeInputBuffers();
+  }
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, Cancellation) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  ParameterMap parameters;
+  parameters.put("timeout", 10);
+  SoftBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(2);
+  batcher.start({MemoryAllocators::Cpu});
+
+  const auto timeout_ms = 1000;
+  auto cancelled = std::make_shared<std::atomic_bool>(true);
+
+  // a cancelled request is dropped with an error instead of being batched
+  std::promise<std::string> promise;
+  auto future = promise.get_future();
+  auto request = makeRequest(pool, "deadline", timeout_ms);
+  request->request->setCancellation(cancelled);
+  request->request->setCallback(
+    [&promise](const InferenceResponse& response) {
+      promise.set_value(response.getError());
+    });
+  batcher.enqueue(std::move(request));
+  EXPECT_EQ(future.get(), "Request cancelled");
+
+  // requests are only dropped once they're cancelled
+  cancelled = std::make_shared<std::atomic_bool>(false);
+  request = makeRequest(pool, "deadline", timeout_ms);
+  request->request->setCancellation(cancelled);
+  batcher.enqueue(std::move(request));
+  BatchPtr batch;
+  ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+    batch, timeout_ms * std::kilo::num));
+  EXPECT_EQ(batch->size(), 1);
+  EXPECT_FALSE(batch->isCancelled());
+  cancelled->store(true);
+  EXPECT_TRUE(batch->isCancelled());
+  batch->freeInputBuffers();
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, Split) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  ParameterMap parameters;
+  parameters.put("timeout", 10);
+  SoftBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(2);
+  batcher.start({MemoryAllocators::Cpu});
+
+  // three samples of two bytes each
+  std::vector<uint8_t> data{0, 1, 2, 3, 4, 5};
+  InferenceRequestInput input{nullptr, {3, 2}, DataType::Uint8};
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+  buffer->write(data.data(), 0, data.size());
+
+  auto request = std::make_shared<InferenceRequest>();
+  request->addInputTensor(buffer->data(0), {3, 2}, DataType::Uint8);
+  request->setID("split");
+  std::promise<InferenceResponse> promise;
+  auto future = promise.get_future();
+  request->setCallback([&promise](const InferenceResponse& response) {
+    promise.set_value(response);
+  });
+  auto container = std::make_unique<RequestContainer>();
+  container->request = request;
+  batcher.split(std::move(container), 3);
+
+  // echo each sample back as the worker would
+  size_t responded = 0;
+  while (responded < 3) {
+    BatchPtr batch;
+    ASSERT_TRUE(batcher.getOutputQueue()->wait_dequeue_timed(
+      batch, std::micro::den));
+    EXPECT_LE(batch->size(), 2);
+    for (const auto& sample : *batch) {
+      const auto& sample_input = sample->getInputs()[0];
+      ASSERT_EQ(sample_input.getShape(), std::vector<int64_t>{2});
+      const auto* bytes = static_cast<std::byte*>(sample_input.getData());
+      InferenceResponseOutput output;
+      output.setName("output");
+      output.setDatatype(DataType::Uint8);
+      output.setShape({2});
+      output.setData(std::vector<std::byte>(bytes, bytes + 2));
+      InferenceResponse response;
+      response.addOutput(std::move(output));
+      sample->runCallbackOnce(response);
+      responded++;
+    }
+    batch->freeInputBuffers();
+  }
+
+  // the samples' outputs are stacked in order in one response
+  const auto response = future.get();
+  ASSERT_FALSE(response.isError());
+  EXPECT_EQ(response.getID(), "split");
+  const auto& outputs = response.getOutputs();
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[0].getShape(), (std::vector<int64_t>{3, 2}));
+  const auto* stacked = static_cast<uint8_t*>(outputs[0].getData());
+  EXPECT_EQ(std::vector<uint8_t>(stacked, stacked + data.size()), data);
+
+  batcher.enqueue(nullptr);
+  batcher.end();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftBatcher, BatchDatatype) {
+  MemoryPool pool;
+  WorkerInfo fake("", "", nullptr, &pool, nullptr, {});
+
+  ParameterMap parameters;
+  parameters.put("timeout", 10);
+  parameters.put("batch_datatype", "FP16");
+  SoftBatcher batcher(&pool, &parameters);
+  batcher.setName("test");
+  batcher.setBatchSize(2);
   batcher.start({MemoryAllocators::Cpu});
 
+  // FP32 inputs are cast to FP16 as they're copied into the batch
+  const std::vector<std::vector<float>> data{{1.0F, -2.5F}, {3.0F, 0.5F}};
+  for (auto values : data) {
+    InferenceRequestInput input{nullptr, {2}, DataType::Fp32};
+    auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+    buffer->write(values.data(), 0, values.size() * sizeof(float));
+    auto request = std::make_shared<InferenceRequest>();
+    request->addInputTensor(buffer->data(0), {2}, DataType::Fp32);
+    auto container = std::make_unique<RequestContainer>();
+    container->request = request;
+    batcher.enqueue(std::move(container));
+  }
+
+  BatchPtr batch;
+  ASSERT_TRUE(
+    batcher.getOutputQueue()->wait_dequeue_timed(batch, std::micro::den));
+  ASSERT_EQ(batch->size(), 2);
+  for (auto i = 0U; i < batch->size(); ++i) {
+    const auto& input = batch->getRequest(i)->getInputs()[0];
+    EXPECT_EQ(input.getDatatype(), DataType::Fp16);
+    const auto* values = static_cast<fp16*>(input.getData());
+    EXPECT_FLOAT_EQ(values[0], data[i][0]);
+    EXPECT_FLOAT_EQ(values[1], data[i][1]);
+  }
+  batch->freeInputBuffers();
+
   batcher.enqueue(nullptr);
   batcher.end();
 }
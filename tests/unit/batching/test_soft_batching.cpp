@@ -16,6 +16,7 @@
 #include <array>             // for array
 #include <cstddef>           // for size_t
 #include <cstdint>           // for uint8_t, uint64_t
+#include <cstring>           // for memcpy
 #include <initializer_list>  // for initializer_list
 #include <memory>            // for allocator, make_unique
 #include <optional>          // for optional
@@ -47,9 +48,13 @@ struct BatchConfig {
   int batch_size;
   std::initializer_list<int> requests;
   std::initializer_list<int> golden;
+  const char* timeout_policy = "static";
+  const char* batch_layout = "contiguous";
 
   friend std::ostream& operator<<(std::ostream& os, const BatchConfig& self) {
     os << "Batch Size: " << self.batch_size << ", ";
+    os << "Timeout Policy: " << self.timeout_policy << ", ";
+    os << "Batch Layout: " << self.batch_layout << ", ";
     os << "Requests: {";
     for (const auto& i : self.requests) {
       os << i << ",";
@@ -91,13 +96,15 @@ class UnitSoftBatcherFixture : public testing::TestWithParam<BatchConfig> {
     ParameterMap parameters;
     parameters.put("timeout", kTimeoutMs);
     parameters.put("batch_size", batch_size);
+    parameters.put("timeout_policy", batch_config.timeout_policy);
+    parameters.put("batch_layout", batch_config.batch_layout);
 
     this->batcher_.emplace(&pool_, &parameters);
     this->batcher_->setName("test");
     this->batcher_->setBatchSize(batch_size);
 
     std::vector<MemoryAllocators> next;
-    this->worker_.emplace("", &parameters, &pool_, nullptr, next);
+    this->worker_.emplace("test", "", &parameters, &pool_, nullptr, next);
     // for (size_t i = 0; i < buffer_num; i++) {
     //   BufferPtrs vec;
     //   vec.emplace_back(std::make_unique<VectorBuffer>(batch_size * data_size,
@@ -157,6 +164,16 @@ class UnitSoftBatcherFixture : public testing::TestWithParam<BatchConfig> {
       tensor_index += i;
 
       const auto& buffers = batch->getInputBuffers();
+      if (batch->isScatterGather()) {
+        EXPECT_TRUE(buffers.empty());
+        const auto& request_buffers = batch->getRequestBuffers();
+        EXPECT_EQ(request_buffers.size(), i);
+        for (const auto& request_buffer : request_buffers) {
+          EXPECT_EQ(request_buffer.size(), 1);
+          compareData(request_buffer.at(0).get(), 0);
+        }
+        continue;
+      }
       EXPECT_EQ(buffers.size(), 1);
       for (const auto& buffer : buffers) {
         for (auto j = 0; j < num_tensors; j++) {
@@ -171,15 +188,21 @@ class UnitSoftBatcherFixture : public testing::TestWithParam<BatchConfig> {
   }
 
   InferenceRequestPtr createRequest() {
+    // each request needs its own memory since the batcher returns it to the
+    // pool after copying it
+    InferenceRequestInput input{nullptr, data_shape_, DataType::Uint8};
+    auto buffer = pool_.get({MemoryAllocators::Cpu}, input, 1);
+    std::memcpy(buffer->data(0), buffer_->data(0), data_size_);
+
     auto request = std::make_shared<InferenceRequest>();
-    request->addInputTensor(buffer_->data(0), data_shape_, DataType::Uint8);
+    request->addInputTensor(buffer->data(0), data_shape_, DataType::Uint8);
     return request;
   }
 
  private:
   int data_size_ = 0;
   BufferPtr buffer_;
-  std::initializer_list<int64_t> data_shape_;
+  std::vector<int64_t> data_shape_;
   InferenceRequestPtr request_;
   std::optional<WorkerInfo> worker_;
   std::optional<SoftBatcher> batcher_;
@@ -213,12 +236,20 @@ TEST_P(UnitSoftBatcherFixture, BasicBatching) {  // NOLINT
  * c: this array defines that batch x will have cx requests with all
  *    corresponding tensors associated with them from b
  *
+ * An optional fourth value sets the batcher's timeout policy and a fifth sets
+ * its batch layout.
+ *
  */
 const std::array kConfigs{
   BatchConfig{1, {1}, {1}},          BatchConfig{1, {1, 1}, {1, 1}},
   BatchConfig{2, {1}, {1}},          BatchConfig{2, {1, 1}, {2}},
   BatchConfig{2, {1, 1, 1}, {2, 1}}, BatchConfig{4, {1, 1, 1, 1, 1}, {4, 1}},
   BatchConfig{4, {1, 1, 1, 1}, {4}},
+  BatchConfig{1, {1, 1}, {1, 1}, "adaptive"},
+  BatchConfig{2, {1, 1, 1}, {2, 1}, "adaptive"},
+  BatchConfig{4, {1, 1, 1, 1, 1}, {4, 1}, "adaptive"},
+  BatchConfig{2, {1, 1, 1}, {2, 1}, "static", "scatter_gather"},
+  BatchConfig{4, {1, 1, 1, 1}, {4}, "static", "scatter_gather"},
 };
 
 // NOLINTNEXTLINE(cert-err58-cpp)
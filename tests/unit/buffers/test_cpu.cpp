@@ -78,13 +78,14 @@ TEST_P(UnitVectorBufferFixture, TestFixtureState) {  // NOLINT
 
 // Excluding BYTES as it doesn't have a defined size to pre-allocate
 // NOLINTNEXTLINE(cert-err58-cpp)
-const std::array<DataType, 12> kDataTypes{
+const std::array<DataType, 13> kDataTypes{
   amdinfer::DataType::Bool,   amdinfer::DataType::Uint8,
   amdinfer::DataType::Uint16, amdinfer::DataType::Uint32,
   amdinfer::DataType::Uint64, amdinfer::DataType::Int8,
   amdinfer::DataType::Int16,  amdinfer::DataType::Int32,
   amdinfer::DataType::Int64,  amdinfer::DataType::Fp16,
-  amdinfer::DataType::Fp32,   amdinfer::DataType::Fp64};
+  amdinfer::DataType::Bf16,   amdinfer::DataType::Fp32,
+  amdinfer::DataType::Fp64};
 
 // NOLINTNEXTLINE(cert-err58-cpp)
 INSTANTIATE_TEST_SUITE_P(DataTypes, UnitVectorBufferFixture,
@@ -0,0 +1,249 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>   // for atomic
+#include <chrono>   // for milliseconds
+#include <cstdint>  // for int64_t, int32_t
+#include <cstring>  // for memcpy
+#include <deque>    // for deque
+#include <future>   // for async, future
+#include <string>   // for string, to_string
+#include <thread>   // for sleep_for
+#include <vector>   // for vector
+
+#include "amdinfer/clients/batching.hpp"         // for BatchingClient
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+/// Responds to inference requests by echoing the inputs as outputs and counts
+/// the requests and samples it receives
+class EchoClient : public Client {
+ public:
+  [[nodiscard]] ServerMetadata serverMetadata() const override { return {}; }
+  [[nodiscard]] bool serverLive() const override { return true; }
+  [[nodiscard]] bool serverReady() const override { return true; }
+  [[nodiscard]] std::vector<std::string> modelList() const override {
+    return {};
+  }
+  std::string workerLoad(const std::string& worker,
+                         [[maybe_unused]] const ParameterMap& parameters)
+    const override {
+    return worker;
+  }
+  void workerUnload([[maybe_unused]] const std::string& worker)
+    const override {}
+  [[nodiscard]] bool hasHardware([[maybe_unused]] const std::string& name,
+                                 [[maybe_unused]] int num) const override {
+    return true;
+  }
+
+  [[nodiscard]] int requests() const { return requests_; }
+  [[nodiscard]] int64_t maxSamples() const { return max_samples_; }
+
+ protected:
+  [[nodiscard]] bool modelReadyImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {
+    return true;
+  }
+  [[nodiscard]] ModelMetadata modelMetadataImpl(
+    const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {
+    return ModelMetadata{model, ""};
+  }
+  void modelLoadImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const ParameterMap& parameters,
+    [[maybe_unused]] const std::string& version) const override {}
+  void modelUnloadImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {}
+  [[nodiscard]] InferenceResponse modelInferImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override {
+    return modelInferAsyncImpl(model, request, version).get();
+  }
+  [[nodiscard]] InferenceResponseFuture modelInferAsyncImpl(
+    const std::string& model, const InferenceRequest& request,
+    [[maybe_unused]] const std::string& version) const override {
+    ++requests_;
+    InferenceResponse response;
+    response.setID(request.getID());
+    response.setModel(model);
+    for (const auto& input : request.getInputs()) {
+      const auto samples = input.getShape()[0];
+      auto max = max_samples_.load();
+      while (samples > max &&
+             !max_samples_.compare_exchange_weak(max, samples)) {
+      }
+
+      InferenceResponseOutput output;
+      output.setName(input.getName());
+      output.setDatatype(input.getDatatype());
+      output.setShape(input.getShape());
+      const auto size = input.getSize() * input.getDatatype().size();
+      std::vector<std::byte> data(size);
+      std::memcpy(data.data(), input.getData(), size);
+      output.setData(std::move(data));
+      response.addOutput(output);
+    }
+
+    return std::async(std::launch::async, [response]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      return response;
+    });
+  }
+
+ private:
+  mutable std::atomic<int> requests_ = 0;
+  mutable std::atomic<int64_t> max_samples_ = 0;
+};
+
+class UnitBatchingClient : public ::testing::Test {
+ protected:
+  /// Make a request with the given number of samples where each value is its
+  /// row number plus the offset
+  InferenceRequest makeRequest(int samples, int offset) {
+    auto& data = data_.emplace_back();
+    for (auto i = 0; i < samples; ++i) {
+      data.push_back(i + offset);
+      data.push_back(i + offset);
+    }
+    InferenceRequest request;
+    request.setID(std::to_string(offset));
+    request.addInputTensor(data.data(), {samples, 2}, DataType::Int32,
+                           "input");
+    return request;
+  }
+
+  static void checkResponse(const InferenceResponse& response, int samples,
+                            int offset) {
+    ASSERT_FALSE(response.isError());
+    EXPECT_EQ(response.getID(), std::to_string(offset));
+    EXPECT_EQ(response.getModel(), "model");
+    const auto& outputs = response.getOutputs();
+    ASSERT_EQ(outputs.size(), 1);
+    const auto& output = outputs[0];
+    EXPECT_EQ(output.getName(), "input");
+    ASSERT_EQ(output.getShape(), std::vector<int64_t>({samples, 2}));
+    const auto* data = static_cast<const int32_t*>(output.getData());
+    for (auto i = 0; i < samples; ++i) {
+      EXPECT_EQ(data[2 * i], i + offset);
+      EXPECT_EQ(data[(2 * i) + 1], i + offset);
+    }
+  }
+
+  std::deque<std::vector<int32_t>> data_;
+};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitBatchingClient, MergeAndSplit) {
+  EchoClient echo;
+  ClientBatchingOptions options;
+  options.max_batch_size = 8;
+  options.timeout = std::chrono::milliseconds(100);
+
+  std::vector<InferenceResponseFuture> futures;
+  std::vector<int> samples{1, 3, 2, 2, 4, 1};
+  {
+    BatchingClient client{&echo, options};
+    auto offset = 0;
+    for (const auto& count : samples) {
+      futures.push_back(
+        client.modelInferAsync("model", makeRequest(count, offset)));
+      offset += count;
+    }
+  }
+
+  // the first four requests fill one batch and the last two wait for the
+  // timeout or the destructor
+  EXPECT_EQ(echo.requests(), 2);
+  EXPECT_EQ(echo.maxSamples(), 8);
+  auto offset = 0;
+  for (auto i = 0U; i < samples.size(); ++i) {
+    checkResponse(futures[i].get(), samples[i], offset);
+    offset += samples[i];
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitBatchingClient, Unmergeable) {
+  EchoClient echo;
+  ClientBatchingOptions options;
+  options.max_batch_size = 4;
+  BatchingClient client{&echo, options};
+
+  // requests as large as a batch are sent on their own
+  checkResponse(client.modelInfer("model", makeRequest(4, 0)), 4, 0);
+  EXPECT_EQ(echo.requests(), 1);
+
+  // requests with parameters are sent on their own
+  auto request = makeRequest(1, 0);
+  ParameterMap parameters;
+  parameters.put("key", 1);
+  request.setParameters(parameters);
+  checkResponse(client.modelInfer("model", request), 1, 0);
+  EXPECT_EQ(echo.requests(), 2);
+
+  // requests with different shapes aren't merged
+  std::vector<int32_t> data(3);
+  InferenceRequest other;
+  other.setID("1");
+  other.addInputTensor(data.data(), {1, 3}, DataType::Int32, "input");
+  auto first = client.modelInferAsync("model", makeRequest(1, 0));
+  auto second = client.modelInferAsync("model", other);
+  checkResponse(first.get(), 1, 0);
+  EXPECT_EQ(second.get().getOutputs()[0].getShape(),
+            std::vector<int64_t>({1, 3}));
+  EXPECT_EQ(echo.requests(), 4);
+  EXPECT_EQ(echo.maxSamples(), 4);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitBatchingClient, Threads) {
+  EchoClient echo;
+  ClientBatchingOptions options;
+  options.max_batch_size = 16;
+  BatchingClient client{&echo, options};
+
+  const auto threads = 8;
+  const auto requests = 50;
+  std::vector<std::future<void>> workers;
+  for (auto i = 0; i < threads; ++i) {
+    auto thread_requests = std::vector<InferenceRequest>();
+    for (auto j = 0; j < requests; ++j) {
+      thread_requests.push_back(makeRequest(2, (i * requests + j) * 2));
+    }
+    workers.push_back(std::async(
+      std::launch::async, [&client, i, thread_requests = std::move(
+                                         thread_requests)]() {
+        for (auto j = 0; j < requests; ++j) {
+          checkResponse(client.modelInfer("model", thread_requests[j]), 2,
+                        (i * requests + j) * 2);
+        }
+      }));
+  }
+  for (auto& worker : workers) {
+    worker.get();
+  }
+  EXPECT_LT(echo.requests(), threads * requests);
+  EXPECT_LE(echo.maxSamples(), 16);
+}
+
+}  // namespace amdinfer
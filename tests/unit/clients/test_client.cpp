@@ -0,0 +1,161 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>  // for max
+#include <atomic>     // for atomic
+#include <chrono>     // for milliseconds, microseconds
+#include <future>     // for async, future
+#include <string>     // for string, to_string
+#include <thread>     // for sleep_for
+#include <vector>     // for vector
+
+#include "amdinfer/clients/client.hpp"           // for inferAsyncOrdered...
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+/// Responds to inference requests asynchronously, with later requests
+/// finishing first, and counts the requests in flight
+class FakeClient : public Client {
+ public:
+  [[nodiscard]] ServerMetadata serverMetadata() const override { return {}; }
+  [[nodiscard]] bool serverLive() const override { return true; }
+  [[nodiscard]] bool serverReady() const override { return true; }
+  [[nodiscard]] std::vector<std::string> modelList() const override {
+    return {};
+  }
+  std::string workerLoad(const std::string& worker,
+                         [[maybe_unused]] const ParameterMap& parameters)
+    const override {
+    return worker;
+  }
+  void workerUnload([[maybe_unused]] const std::string& worker)
+    const override {}
+  [[nodiscard]] bool hasHardware([[maybe_unused]] const std::string& name,
+                                 [[maybe_unused]] int num) const override {
+    return true;
+  }
+
+  [[nodiscard]] int maxInFlight() const { return max_in_flight_; }
+
+ protected:
+  [[nodiscard]] bool modelReadyImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {
+    return true;
+  }
+  [[nodiscard]] ModelMetadata modelMetadataImpl(
+    const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {
+    return ModelMetadata{model, ""};
+  }
+  void modelLoadImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const ParameterMap& parameters,
+    [[maybe_unused]] const std::string& version) const override {}
+  void modelUnloadImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {}
+  [[nodiscard]] InferenceResponse modelInferImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override {
+    return modelInferAsyncImpl(model, request, version).get();
+  }
+  [[nodiscard]] InferenceResponseFuture modelInferAsyncImpl(
+    [[maybe_unused]] const std::string& model, const InferenceRequest& request,
+    [[maybe_unused]] const std::string& version) const override {
+    const auto in_flight = ++in_flight_;
+    auto max = max_in_flight_.load();
+    while (in_flight > max &&
+           !max_in_flight_.compare_exchange_weak(max, in_flight)) {
+    }
+    const auto delay = std::chrono::milliseconds(5 - (sent_++ % 5));
+
+    return std::async(std::launch::async, [this, delay, id = request.getID()]() {
+      std::this_thread::sleep_for(delay);
+      InferenceResponse response;
+      response.setID(id);
+      --in_flight_;
+      return response;
+    });
+  }
+
+ private:
+  mutable std::atomic<int> in_flight_ = 0;
+  mutable std::atomic<int> max_in_flight_ = 0;
+  mutable std::atomic<int> sent_ = 0;
+};
+
+std::vector<InferenceRequest> makeRequests(int count) {
+  std::vector<InferenceRequest> requests(count);
+  for (auto i = 0; i < count; ++i) {
+    requests[i].setID(std::to_string(i));
+  }
+  return requests;
+}
+
+void checkOrder(const std::vector<InferenceResponse>& responses) {
+  for (auto i = 0U; i < responses.size(); ++i) {
+    EXPECT_EQ(responses[i].getID(), std::to_string(i));
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitClient, InferAsyncOrderedWindowed) {
+  FakeClient client;
+  const auto requests = makeRequests(23);
+
+  InferWindow window;
+  window.max_in_flight = 4;
+  auto responses =
+    inferAsyncOrderedWindowed(&client, "model", requests, window);
+  ASSERT_EQ(responses.size(), requests.size());
+  checkOrder(responses);
+  EXPECT_EQ(client.maxInFlight(), 4);
+
+  FakeClient batched;
+  const auto batch_size = 5;
+  responses = inferAsyncOrderedBatched(&batched, "model", requests, batch_size);
+  ASSERT_EQ(responses.size(), requests.size());
+  checkOrder(responses);
+  EXPECT_EQ(batched.maxInFlight(), batch_size);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitClient, InferAsyncOrderedAdaptive) {
+  const auto requests = makeRequests(40);
+  InferWindow window;
+  window.max_in_flight = 8;
+  window.adaptive = true;
+
+  // every response is slower than the target so the window stays at one
+  FakeClient slow;
+  window.target_latency = std::chrono::microseconds(1);
+  auto responses = inferAsyncOrderedWindowed(&slow, "model", requests, window);
+  checkOrder(responses);
+  EXPECT_EQ(slow.maxInFlight(), 1);
+
+  // every response is fast enough so the window grows
+  FakeClient fast;
+  window.target_latency = std::chrono::seconds(1);
+  responses = inferAsyncOrderedWindowed(&fast, "model", requests, window);
+  checkOrder(responses);
+  EXPECT_GT(fast.maxInFlight(), 1);
+  EXPECT_LE(fast.maxInFlight(), 8);
+}
+
+}  // namespace amdinfer
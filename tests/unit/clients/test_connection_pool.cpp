@@ -0,0 +1,170 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>   // for atomic
+#include <chrono>   // for milliseconds
+#include <cstddef>  // for size_t
+#include <memory>   // for make_shared, shared_ptr
+#include <thread>   // for thread, sleep_for
+#include <vector>   // for vector
+
+#include "amdinfer/clients/connection_pool.hpp"  // for ConnectionPool
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+struct FakeConnection {
+  size_t index;
+  int generation;
+};
+
+class UnitConnectionPool : public ::testing::Test {
+ protected:
+  using Pool = ConnectionPool<FakeConnection>;
+
+  Pool::Factory factory() {
+    return [this](size_t index) {
+      return std::make_shared<FakeConnection>(
+        FakeConnection{index, connections_++});
+    };
+  }
+
+  int connections_ = 0;
+};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitConnectionPool, LeastOutstanding) {
+  Pool::Options options;
+  options.min_size = 3;
+  options.max_size = 3;
+  Pool pool{factory(), options};
+  EXPECT_EQ(connections_, 3);
+
+  // idle connections are used before busy ones
+  auto first = pool.acquire();
+  auto second = pool.acquire();
+  auto third = pool.acquire();
+  EXPECT_NE(first.index, second.index);
+  EXPECT_NE(first.index, third.index);
+  EXPECT_NE(second.index, third.index);
+  EXPECT_EQ(first.connection->index, first.index);
+
+  pool.release(second, true);
+  auto fourth = pool.acquire();
+  EXPECT_EQ(fourth.index, second.index);
+
+  const auto stats = pool.stats();
+  ASSERT_EQ(stats.size(), 3);
+  EXPECT_EQ(stats[first.index].in_flight, 1);
+  EXPECT_EQ(stats[second.index].in_flight, 1);
+  EXPECT_EQ(stats[second.index].requests, 1);
+  EXPECT_TRUE(stats[second.index].healthy);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitConnectionPool, GrowAndShrink) {
+  Pool::Options options;
+  options.min_size = 1;
+  options.max_size = 3;
+  options.idle_timeout = std::chrono::nanoseconds(0);
+  Pool pool{factory(), options};
+  EXPECT_EQ(pool.size(), 1);
+
+  std::vector<Pool::Ticket> tickets;
+  for (auto i = 0; i < 4; ++i) {
+    tickets.push_back(pool.acquire());
+  }
+  // the pool grows until it's full and then shares the connections
+  EXPECT_EQ(pool.size(), 3);
+  EXPECT_EQ(tickets[1].index, 1);
+  EXPECT_EQ(tickets[2].index, 2);
+
+  pool.maintain();
+  EXPECT_EQ(pool.size(), 3);
+
+  for (const auto& ticket : tickets) {
+    pool.release(ticket, true);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  pool.maintain();
+  EXPECT_EQ(pool.size(), 2);
+  pool.maintain();
+  pool.maintain();
+  EXPECT_EQ(pool.size(), 1);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitConnectionPool, Reconnect) {
+  Pool::Options options;
+  options.min_size = 2;
+  options.max_size = 2;
+  options.stall_timeout = std::chrono::milliseconds(1);
+  Pool pool{factory(), options};
+
+  auto failed = pool.acquire();
+  pool.release(failed, false);
+  EXPECT_FALSE(pool.stats()[failed.index].healthy);
+  EXPECT_EQ(pool.stats()[failed.index].failures, 1);
+  // new requests avoid the failed connection even if the other one is busy
+  auto busy = pool.acquire();
+  EXPECT_NE(busy.index, failed.index);
+  EXPECT_NE(pool.acquire().index, failed.index);
+
+  // the busy connection stalls and both are replaced
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_FALSE(pool.stats()[busy.index].healthy);
+  pool.maintain();
+  EXPECT_EQ(connections_, 4);
+  for (const auto& stat : pool.stats()) {
+    EXPECT_TRUE(stat.healthy);
+    EXPECT_EQ(stat.in_flight, 0);
+  }
+
+  // a request on the old connection doesn't affect the new one
+  pool.release(busy, false);
+  EXPECT_TRUE(pool.stats()[busy.index].healthy);
+  EXPECT_GE(pool.acquire().connection->generation, 2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitConnectionPool, Threads) {
+  Pool::Options options;
+  options.min_size = 1;
+  options.max_size = 4;
+  Pool pool{factory(), options};
+
+  const auto threads = 8;
+  const auto requests = 1000;
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (auto i = 0; i < threads; ++i) {
+    workers.emplace_back([&]() {
+      for (auto j = 0; j < requests; ++j) {
+        pool.release(pool.acquire(), true);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  uint64_t finished = 0;
+  for (const auto& stat : pool.stats()) {
+    EXPECT_EQ(stat.in_flight, 0);
+    finished += stat.requests;
+  }
+  EXPECT_EQ(finished, threads * requests);
+}
+
+}  // namespace amdinfer
@@ -15,13 +15,18 @@
 #include <array>    // for array
 #include <cstddef>  // for byte
 #include <cstdint>  // for int16_t, int32_t
+#include <cstring>  // for memcmp, memcpy
 #include <iomanip>  // for operator<<
 #include <memory>   // for allocator
+#include <utility>  // for move
+#include <vector>   // for vector
 
 #include "amdinfer/clients/grpc_internal.hpp"    // for mapRequestToProto
 #include "amdinfer/core/data_types.hpp"          // for DataType, switchOver...
 #include "amdinfer/core/exceptions.hpp"          // for invalid_argument
 #include "amdinfer/core/inference_request.hpp"   // for InferenceRequestInput
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
 #include "amdinfer/observation/observer.hpp"     // for Logger, Observer
 #include "amdinfer/testing/observation.hpp"      // for initializeTestLogging
 #include "google/protobuf/repeated_ptr_field.h"  // for RepeatedPtrField
@@ -40,6 +45,7 @@ const int16_t kInt16Value = -2;
 const int32_t kInt32Value = -3;
 const int64_t kInt64Value = -4;
 const fp16 kFp16Value{1.4F};  // NOLINT(cert-err58-cpp)
+const bf16 kBf16Value{1.4F};  // NOLINT(cert-err58-cpp)
 const float kFloatValue = 2.7F;
 const double kDoubleValue = 3.6;
 const char kCharValue = 'x';
@@ -68,6 +74,8 @@ struct AssignData {
       data_cast[0] = kInt64Value;
     } else if constexpr (std::is_same_v<T, fp16>) {
       data_cast[0] = kFp16Value;
+    } else if constexpr (std::is_same_v<T, bf16>) {
+      data_cast[0] = kBf16Value;
     } else if constexpr (std::is_same_v<T, float>) {
       data_cast[0] = kFloatValue;
     } else if constexpr (std::is_same_v<T, double>) {
@@ -105,6 +113,8 @@ struct CheckData {
       EXPECT_EQ(*contents, kInt64Value);
     } else if constexpr (std::is_same_v<T, fp16>) {
       EXPECT_FLOAT_EQ(*contents, kFp16Value);
+    } else if constexpr (std::is_same_v<T, bf16>) {
+      EXPECT_FLOAT_EQ(*contents, kBf16Value);
     } else if constexpr (std::is_same_v<T, float>) {
       EXPECT_FLOAT_EQ(*contents, kFloatValue);
     } else if constexpr (std::is_same_v<T, double>) {
@@ -146,13 +156,56 @@ TEST_P(Fixture, TestRequestToProto) {  // NOLINT
 
 // we exclude BYTES as it doesn't have a defined size we can pre-allocate
 // NOLINTNEXTLINE(cert-err58-cpp)
-const std::array<DataType, 12> kDataTypes{
+const std::array<DataType, 13> kDataTypes{
   DataType::Bool,   DataType::Uint8, DataType::Uint16, DataType::Uint32,
   DataType::Uint64, DataType::Int8,  DataType::Int16,  DataType::Int32,
-  DataType::Int64,  DataType::Fp16,  DataType::Fp32,   DataType::Fp64};
+  DataType::Int64,  DataType::Fp16,  DataType::Bf16,   DataType::Fp32,
+  DataType::Fp64};
 
 // NOLINTNEXTLINE(cert-err58-cpp)
 INSTANTIATE_TEST_SUITE_P(UnitClientsGrpcInternal, Fixture,
                          testing::ValuesIn(kDataTypes));
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitClientsGrpcInternal, Raw) {
+  Observer observer;
+  AMDINFER_IF_LOGGING(observer.logger = Logger{Loggers::Test});
+
+  std::array<int32_t, 3> data{1, -2, 3};
+  InferenceRequest request;
+  InferenceRequestInput input{data.data(), {3}, DataType::Int32};
+  ParameterMap parameters;
+  parameters.put(kRawInput, true);
+  input.setParameters(parameters);
+  request.addInputTensor(input);
+
+  inference::ModelInferRequest proto_request;
+  mapRequestToProto(request, proto_request, observer);
+  ASSERT_EQ(proto_request.raw_input_contents_size(), 1);
+  EXPECT_EQ(proto_request.inputs(0).contents().int_contents_size(), 0);
+  const auto& raw = proto_request.raw_input_contents(0);
+  ASSERT_EQ(raw.size(), sizeof(data));
+  EXPECT_EQ(std::memcmp(raw.data(), data.data(), raw.size()), 0);
+
+  InferenceResponse response;
+  InferenceResponseOutput output;
+  output.setName("output");
+  output.setDatatype(DataType::Int32);
+  output.setShape({3});
+  std::vector<std::byte> output_data(sizeof(data));
+  std::memcpy(output_data.data(), data.data(), sizeof(data));
+  output.setData(std::move(output_data));
+  response.addOutput(output);
+
+  inference::ModelInferResponse reply;
+  mapResponseToProto(response, reply, true);
+  ASSERT_EQ(reply.raw_output_contents_size(), 1);
+
+  InferenceResponse parsed;
+  mapProtoToResponse(reply, parsed, observer);
+  const auto& outputs = parsed.getOutputs();
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(std::memcmp(outputs[0].getData(), data.data(), sizeof(data)), 0);
+}
+
 }  // namespace amdinfer
@@ -0,0 +1,217 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>     // for atomic
+#include <chrono>     // for milliseconds
+#include <future>     // for async
+#include <stdexcept>  // for runtime_error
+#include <string>     // for string, to_string
+#include <thread>     // for sleep_for
+#include <tuple>      // for ignore
+#include <vector>     // for vector
+
+#include "amdinfer/clients/load_balancing.hpp"   // for LoadBalancingClient
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+/// Responds to inference requests after a delay and counts them. It can be
+/// made to fail or to report that it's not ready
+class FakeBackend : public Client {
+ public:
+  [[nodiscard]] ServerMetadata serverMetadata() const override { return {}; }
+  [[nodiscard]] bool serverLive() const override { return true; }
+  [[nodiscard]] bool serverReady() const override { return true; }
+  [[nodiscard]] std::vector<std::string> modelList() const override {
+    return {};
+  }
+  std::string workerLoad(const std::string& worker,
+                         [[maybe_unused]] const ParameterMap& parameters)
+    const override {
+    ++loads_;
+    return worker;
+  }
+  void workerUnload([[maybe_unused]] const std::string& worker)
+    const override {}
+  [[nodiscard]] bool hasHardware([[maybe_unused]] const std::string& name,
+                                 [[maybe_unused]] int num) const override {
+    return true;
+  }
+
+  [[nodiscard]] int requests() const { return requests_; }
+  [[nodiscard]] int loads() const { return loads_; }
+  void setReady(bool ready) { ready_ = ready; }
+  void setFailing(bool failing) { failing_ = failing; }
+  void setDelay(std::chrono::milliseconds delay) { delay_ = delay; }
+
+ protected:
+  [[nodiscard]] bool modelReadyImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {
+    return ready_;
+  }
+  [[nodiscard]] ModelMetadata modelMetadataImpl(
+    const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {
+    return ModelMetadata{model, ""};
+  }
+  void modelLoadImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const ParameterMap& parameters,
+    [[maybe_unused]] const std::string& version) const override {}
+  void modelUnloadImpl(
+    [[maybe_unused]] const std::string& model,
+    [[maybe_unused]] const std::string& version) const override {}
+  [[nodiscard]] InferenceResponse modelInferImpl(
+    const std::string& model, const InferenceRequest& request,
+    const std::string& version) const override {
+    return modelInferAsyncImpl(model, request, version).get();
+  }
+  [[nodiscard]] InferenceResponseFuture modelInferAsyncImpl(
+    [[maybe_unused]] const std::string& model, const InferenceRequest& request,
+    [[maybe_unused]] const std::string& version) const override {
+    ++requests_;
+    return std::async(std::launch::async, [delay = delay_.load(),
+                                           failing = failing_.load(),
+                                           id = request.getID()]() {
+      std::this_thread::sleep_for(delay);
+      if (failing) {
+        throw std::runtime_error("Connection failed");
+      }
+      InferenceResponse response;
+      response.setID(id);
+      return response;
+    });
+  }
+
+ private:
+  mutable std::atomic<int> requests_ = 0;
+  mutable std::atomic<int> loads_ = 0;
+  std::atomic<bool> ready_ = true;
+  std::atomic<bool> failing_ = false;
+  std::atomic<std::chrono::milliseconds> delay_{std::chrono::milliseconds(1)};
+};
+
+InferenceRequest makeRequest(int id) {
+  InferenceRequest request;
+  request.setID(std::to_string(id));
+  return request;
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadBalancingClient, Balance) {
+  std::vector<FakeBackend> backends(3);
+  LoadBalancingClient client{{&backends[0], &backends[1], &backends[2]}};
+
+  const auto requests = 60;
+  std::vector<InferenceResponseFuture> futures;
+  for (auto i = 0; i < requests; ++i) {
+    futures.push_back(client.modelInferAsync("model", makeRequest(i)));
+  }
+  for (auto i = 0; i < requests; ++i) {
+    EXPECT_EQ(futures[i].get().getID(), std::to_string(i));
+  }
+
+  // requests are spread over the backends
+  for (const auto& backend : backends) {
+    EXPECT_GT(backend.requests(), 0);
+    EXPECT_LT(backend.requests(), requests);
+  }
+  // loading applies to all the backends
+  EXPECT_EQ(client.workerLoad("worker", {}), "worker");
+  for (const auto& backend : backends) {
+    EXPECT_EQ(backend.loads(), 1);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadBalancingClient, Failover) {
+  std::vector<FakeBackend> backends(2);
+  backends[0].setFailing(true);
+  LoadBalancingOptions options;
+  options.health_interval = std::chrono::minutes(1);
+  LoadBalancingClient client{{&backends[0], &backends[1]}, options};
+
+  // requests that fail on the first backend are sent to the second one and
+  // the first one isn't used again
+  for (auto i = 0; i < 20; ++i) {
+    EXPECT_EQ(client.modelInfer("model", makeRequest(i)).getID(),
+              std::to_string(i));
+  }
+  EXPECT_LE(backends[0].requests(), 1);
+  const auto stats = client.backendStats();
+  EXPECT_EQ(stats[0].failures, backends[0].requests());
+  EXPECT_EQ(stats[1].requests, 20);
+  EXPECT_EQ(stats[1].in_flight, 0);
+
+  // if every backend fails, so does the request
+  backends[1].setFailing(true);
+  EXPECT_THROW(std::ignore = client.modelInfer("model", makeRequest(0)),
+               std::runtime_error);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadBalancingClient, Eject) {
+  std::vector<FakeBackend> backends(2);
+  LoadBalancingOptions options;
+  options.health_interval = std::chrono::milliseconds(5);
+  LoadBalancingClient client{{&backends[0], &backends[1]}, options};
+
+  // make a request so the model is checked
+  std::ignore = client.modelInfer("model", makeRequest(0));
+  backends[1].setReady(false);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  const auto before = backends[1].requests();
+  for (auto i = 0; i < 20; ++i) {
+    std::ignore = client.modelInfer("model", makeRequest(i));
+  }
+  EXPECT_EQ(backends[1].requests(), before);
+  EXPECT_TRUE(client.modelReady("model"));
+
+  backends[1].setReady(true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (auto i = 0; i < 20; ++i) {
+    std::ignore = client.modelInfer("model", makeRequest(i));
+  }
+  EXPECT_GT(backends[1].requests(), before);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadBalancingClient, Hedge) {
+  std::vector<FakeBackend> backends(2);
+  LoadBalancingOptions options;
+  options.hedge_percentile = 0.5;
+  options.hedge_min_samples = 20;
+  LoadBalancingClient client{{&backends[0], &backends[1]}, options};
+
+  for (auto i = 0; i < 20; ++i) {
+    std::ignore = client.modelInfer("model", makeRequest(i));
+  }
+
+  // requests to the slow backend are also sent to the fast one
+  const auto slow = std::chrono::milliseconds(200);
+  backends[1].setDelay(slow);
+  for (auto i = 0; i < 10; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(client.modelInfer("model", makeRequest(i)).getID(),
+              std::to_string(i));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, slow / 2);
+  }
+}
+
+}  // namespace amdinfer
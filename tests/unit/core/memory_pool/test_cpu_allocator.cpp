@@ -21,6 +21,9 @@
 // #include <cstddef>  // for byte, size_t
 // #include <string>   // for string, basic_string, alloc...
 // #include <vector>   // for vector
+#include <algorithm>  // for find
+#include <thread>     // for thread
+#include <vector>     // for vector
 
 #include "amdinfer/buffers/buffer.hpp"  // for BufferPtr
 #include "amdinfer/core/exceptions.hpp"
@@ -74,6 +77,111 @@ TEST(UnitCpuAllocator, Correctness) {
   ASSERT_EQ(address_0, address_3);
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, Coalescing) {
+  const auto chunks = 8;
+  CpuAllocator allocator{sizeof(int) * chunks, sizeof(int) * chunks};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  std::vector<const void*> addresses;
+  for (auto i = 0; i < chunks; ++i) {
+    addresses.push_back(allocator.get(input, 1)->data(0));
+  }
+  const auto* base = addresses.front();
+
+  // free out of order so chunks are merged with both lower and upper buddies
+  for (auto i : {3, 0, 6, 1, 7, 2, 4, 5}) {
+    allocator.put(addresses.at(i));
+  }
+
+  const auto buffer = allocator.get(input, chunks);
+  EXPECT_EQ(buffer->data(0), base);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, ThreadCache) {
+  CpuAllocator allocator{sizeof(int) * 4};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  const auto* address_0 = allocator.get(input, 1)->data(0);
+  allocator.put(address_0);
+
+  // the chunk is cached by this thread so another thread can't use it
+  const void* address_1 = nullptr;
+  std::thread other{[&]() {
+    address_1 = allocator.get(input, 1)->data(0);
+    allocator.put(address_1);
+  }};
+  other.join();
+  EXPECT_NE(address_0, address_1);
+
+  const auto buffer = allocator.get(input, 1);
+  EXPECT_EQ(buffer->data(0), address_0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, Depot) {
+  // enough chunks to overflow a thread cache, which holds 32 of each size
+  const auto chunks = 33;
+  CpuAllocator allocator{sizeof(int) * 64};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  std::vector<const void*> addresses;
+  for (auto i = 0; i < chunks; ++i) {
+    addresses.push_back(allocator.get(input, 1)->data(0));
+  }
+
+  // chunks got on this thread are put by another one whose full cache moves
+  // half its chunks to the depot instead of the shared allocator
+  std::thread other{[&]() {
+    for (const auto* address : addresses) {
+      allocator.put(address);
+    }
+  }};
+  other.join();
+  auto stats = allocator.getStats(false);
+  EXPECT_EQ(stats.used, sizeof(int) * chunks);
+  EXPECT_EQ(stats.cached, sizeof(int) * chunks);
+
+  // this thread's cache is refilled from the depot
+  const auto buffer = allocator.get(input, 1);
+  EXPECT_NE(std::find(addresses.begin(), addresses.end(), buffer->data(0)),
+            addresses.end());
+  stats = allocator.getStats(false);
+  EXPECT_EQ(stats.used, sizeof(int) * chunks);
+  EXPECT_EQ(stats.cached, sizeof(int) * (chunks - 1));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, HugePages) {
+  // if no huge pages are reserved, this falls back to regular pages
+  const size_t page_size = 2 * 1024 * 1024;
+  CpuAllocator allocator{sizeof(int), static_cast<size_t>(-1), {page_size, 0}};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  const auto buffer = allocator.get(input, 1);
+  auto* address = static_cast<int*>(buffer->data(0));
+  *address = 1;
+  EXPECT_EQ(*address, 1);
+  allocator.put(address);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, Reserve) {
+  CpuAllocator allocator{sizeof(int) * 4, sizeof(int) * 4};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  allocator.reserve(input, 1, 2);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW_CHECK(allocator.reserve(input, 1, 5);
+                     , EXPECT_STREQ(e.what(), "Too much requested");
+                     , runtime_error);
+
+  // the reserved memory is returned so the whole block can still be used
+  const auto buffer = allocator.get(input, 4);
+  EXPECT_NE(buffer->data(0), nullptr);
+}
+
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST(UnitCpuAllocator, ExceedingMax) {
   CpuAllocator allocator{sizeof(int), sizeof(int)};
@@ -86,6 +194,37 @@ TEST(UnitCpuAllocator, ExceedingMax) {
                      , runtime_error);
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, Stats) {
+  const auto chunks = 4;
+  CpuAllocator allocator{sizeof(int) * chunks, sizeof(int) * chunks};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  const auto buffer = allocator.get(input, 1);
+  auto stats = allocator.getStats(true);
+  EXPECT_EQ(stats.reserved, sizeof(int) * chunks);
+  EXPECT_EQ(stats.used, sizeof(int));
+  EXPECT_EQ(stats.cached, 0);
+  // the block is split into one free chunk of each smaller order
+  EXPECT_EQ(stats.free_chunks, 2);
+  EXPECT_EQ(stats.largest_free, sizeof(int) * 2);
+  EXPECT_DOUBLE_EQ(stats.fragmentation(), 1.0 / 3);
+  ASSERT_EQ(stats.blocks.size(), 1);
+  ASSERT_EQ(stats.blocks.front().free.size(), 2);
+  EXPECT_EQ(stats.blocks.front().free.front().offset, sizeof(int));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW(std::ignore = allocator.get(input, chunks), runtime_error);
+  EXPECT_EQ(allocator.getStats(false).failures, 1);
+
+  // freed chunks smaller than a block are cached by the thread
+  allocator.put(buffer->data(0));
+  stats = allocator.getStats(false);
+  EXPECT_EQ(stats.used, sizeof(int));
+  EXPECT_EQ(stats.cached, sizeof(int));
+  EXPECT_TRUE(stats.blocks.empty());
+}
+
 // NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
 TEST(UnitCpuAllocator, BadFree) {
   CpuAllocator allocator{sizeof(int)};
@@ -100,4 +239,24 @@ TEST(UnitCpuAllocator, BadFree) {
                      , runtime_error);
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCpuAllocator, DoubleFree) {
+  CpuAllocator allocator{sizeof(int) * 4};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  const auto* address = allocator.get(input, 1)->data(0);
+  allocator.put(address);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW_CHECK(allocator.put(address);
+                     , EXPECT_STREQ(e.what(), "Address already freed");
+                     , runtime_error);
+
+  // the cached chunk is only handed out once and can be put again after
+  const auto buffer_0 = allocator.get(input, 1);
+  const auto buffer_1 = allocator.get(input, 1);
+  EXPECT_EQ(buffer_0->data(0), address);
+  EXPECT_NE(buffer_1->data(0), address);
+  EXPECT_NO_THROW(allocator.put(address));
+}
+
 }  // namespace amdinfer
@@ -18,6 +18,7 @@
  */
 
 #include <tuple>
+#include <vector>
 
 #include "amdinfer/buffers/buffer.hpp"  // for BufferPtr
 #include "amdinfer/core/exceptions.hpp"
@@ -37,4 +38,55 @@ TEST(UnitPool, Basic) {
   buffer->free();
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitPool, Reserve) {
+  MemoryPool pool;
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  pool.reserve({{MemoryAllocators::Cpu}, input, 1, 2});
+
+  auto buffer = pool.get({MemoryAllocators::Cpu}, input, 1);
+  buffer->free();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitPool, Borrow) {
+  MemoryPool pool;
+  std::vector<int> external(4);
+
+  EXPECT_THROW(pool.put(MemoryAllocators::Cpu, external.data()),
+               runtime_error);
+  pool.borrow(external.data());
+  EXPECT_NO_THROW(pool.put(MemoryAllocators::Cpu, external.data()));
+  // the loan ends when the memory is put back
+  EXPECT_THROW(pool.put(MemoryAllocators::Cpu, external.data()),
+               runtime_error);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitPool, Slabs) {
+  MemoryPool pool;
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  auto slabs = pool.addSlabs({sizeof(int)}, 1);
+  auto buffer_0 = pool.get({MemoryAllocators::Cpu}, input, 1);
+  // the slot is in use so this comes from the arena
+  auto buffer_1 = pool.get({MemoryAllocators::Cpu}, input, 1);
+  auto* slot = buffer_0->data(0);
+  EXPECT_NE(slot, buffer_1->data(0));
+  buffer_1->free();
+
+  // the slabs are kept until their slot is put back
+  slabs.reset();
+  buffer_0->free();
+  auto buffer_2 = pool.get({MemoryAllocators::Cpu}, input, 1);
+  buffer_2->free();
+
+  bool found = false;
+  for (const auto& stats : pool.getStats()) {
+    found = found || stats.allocator == "cpu_slab";
+  }
+  EXPECT_FALSE(found);
+}
+
 }  // namespace amdinfer
@@ -0,0 +1,120 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file
+ * @brief
+ */
+
+#include <set>     // for set
+#include <thread>  // for thread
+#include <tuple>   // for ignore
+#include <vector>  // for vector
+
+#include "amdinfer/buffers/buffer.hpp"  // for BufferPtr
+#include "amdinfer/core/exceptions.hpp"
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequestInput
+#include "amdinfer/core/memory_pool/slab_allocator.hpp"  // for SlabAllocator
+#include "amdinfer/testing/gtest.hpp"  // for AssertionResult,...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSlabAllocator, Basic) {
+  SlabAllocator allocator{{sizeof(int), sizeof(int) * 4}, 2};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  const auto buffer_0 = allocator.get(input, 1);
+  const auto buffer_1 = allocator.get(input, 1);
+  const auto buffer_2 = allocator.get(input, 4);
+  EXPECT_NE(buffer_0->data(0), buffer_1->data(0));
+  EXPECT_TRUE(allocator.contains(buffer_2->data(0)));
+  EXPECT_TRUE(allocator.inUse());
+
+  // the slots of a size are used up and other sizes have none
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW_CHECK(std::ignore = allocator.get(input, 1);
+                     , EXPECT_STREQ(e.what(), "No free slot of this size");
+                     , runtime_error);
+  EXPECT_EQ(allocator.take(sizeof(int) * 2), nullptr);
+
+  // the last slot put back is the next one taken
+  allocator.put(buffer_1->data(0));
+  const auto buffer_3 = allocator.get(input, 1);
+  EXPECT_EQ(buffer_3->data(0), buffer_1->data(0));
+
+  allocator.put(buffer_0->data(0));
+  allocator.put(buffer_2->data(0));
+  allocator.put(buffer_3->data(0));
+  EXPECT_FALSE(allocator.inUse());
+
+  std::vector<int> external(1);
+  EXPECT_FALSE(allocator.contains(external.data()));
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW(allocator.put(external.data()), runtime_error);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSlabAllocator, Stats) {
+  const auto slots = 4;
+  SlabAllocator allocator{{sizeof(int)}, slots};
+  InferenceRequestInput input{nullptr, {1}, DataType::Int32};
+
+  const auto buffer = allocator.get(input, 1);
+  const auto stats = allocator.getStats(false);
+  EXPECT_GT(stats.reserved, sizeof(int) * slots);
+  EXPECT_EQ(stats.used, sizeof(int));
+  EXPECT_EQ(stats.free_chunks, slots - 1);
+  EXPECT_EQ(stats.largest_free, sizeof(int));
+  allocator.put(buffer->data(0));
+  EXPECT_EQ(allocator.getStats(false).used, 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSlabAllocator, Threads) {
+  const auto slots = 8;
+  const auto rounds = 10000;
+  SlabAllocator allocator{{sizeof(int)}, slots};
+
+  // every thread holds at most two slots so none of them run out
+  std::vector<std::thread> threads;
+  threads.reserve(slots / 2);
+  for (auto i = 0; i < slots / 2; ++i) {
+    threads.emplace_back([&allocator]() {
+      for (auto j = 0; j < rounds; ++j) {
+        auto* slot_0 = allocator.take(sizeof(int));
+        auto* slot_1 = allocator.take(sizeof(int));
+        ASSERT_NE(slot_0, nullptr);
+        ASSERT_NE(slot_1, nullptr);
+        ASSERT_NE(slot_0, slot_1);
+        allocator.put(slot_0);
+        allocator.put(slot_1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(allocator.inUse());
+
+  // no slot was lost or handed out twice
+  std::set<std::byte*> taken;
+  for (auto i = 0; i < slots; ++i) {
+    taken.insert(allocator.take(sizeof(int)));
+  }
+  EXPECT_EQ(taken.size(), slots);
+  EXPECT_EQ(taken.count(nullptr), 0);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,96 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for size_t
+#include <memory>   // for shared_ptr
+
+#include "amdinfer/core/admission.hpp"           // for AdmissionControl
+#include "amdinfer/core/exceptions.hpp"          // for resource_exhausted...
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitAdmission, Parse) {
+  ParameterMap parameters;
+  parameters.put("batch_size", 4);
+  EXPECT_FALSE(AdmissionControl::parse(&parameters).has_value());
+
+  parameters.put("max_inflight", 2);
+  parameters.put("memory_quota_mib", 3);
+  const auto options = AdmissionControl::parse(&parameters);
+  ASSERT_TRUE(options.has_value());
+  EXPECT_EQ(options->max_inflight, 2);
+  EXPECT_EQ(options->memory_quota, 3 * 1024 * 1024);
+  // only the admission parameters are removed
+  EXPECT_EQ(parameters.size(), 1);
+
+  parameters.put("max_inflight", -1);
+  EXPECT_THROW(AdmissionControl::parse(&parameters), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitAdmission, Admit) {
+  AdmissionOptions options;
+  options.max_inflight = 2;
+  options.memory_quota = 100;
+  auto control = std::make_shared<AdmissionControl>(options);
+
+  auto first = control->admit(60);
+  EXPECT_EQ(control->getInflight(), 1);
+  EXPECT_EQ(control->getBytes(), 60);
+  // the fullest limit is the load
+  EXPECT_DOUBLE_EQ(control->getLoad(), 0.6);
+  // a refused request doesn't count
+  EXPECT_THROW(control->admit(50), resource_exhausted_error);
+  EXPECT_EQ(control->getInflight(), 1);
+  EXPECT_EQ(control->getBytes(), 60);
+
+  auto second = control->admit(40);
+  EXPECT_THROW(control->admit(0), resource_exhausted_error);
+
+  first.reset();
+  EXPECT_EQ(control->getInflight(), 1);
+  EXPECT_EQ(control->getBytes(), 40);
+  second.reset();
+  EXPECT_EQ(control->getInflight(), 0);
+  EXPECT_EQ(control->getBytes(), 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitAdmission, HoldTicket) {
+  AdmissionOptions options;
+  options.max_inflight = 1;
+  auto control = std::make_shared<AdmissionControl>(options);
+
+  size_t responses = 0;
+  InferenceRequest request;
+  request.setCallback([&responses](const InferenceResponse&) { responses++; });
+  holdTicket(&request, control->admit(1));
+  EXPECT_EQ(control->getInflight(), 1);
+
+  // the ticket is released with the final response
+  InferenceResponse partial;
+  partial.setFinal(false);
+  request.runCallback(partial);
+  EXPECT_EQ(control->getInflight(), 1);
+  request.runCallback(InferenceResponse{});
+  EXPECT_EQ(control->getInflight(), 0);
+  EXPECT_EQ(responses, 2);
+}
+
+}  // namespace amdinfer
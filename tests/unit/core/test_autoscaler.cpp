@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for size_t
+
+#include "amdinfer/core/autoscaler.hpp"  // for Autoscaler, AutoscalerOptions
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/core/parameters.hpp"  // for ParameterMap
+#include "gtest/gtest.h"                 // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitAutoscaler, Parse) {
+  ParameterMap parameters;
+  parameters.put("batch_size", 4);
+  EXPECT_FALSE(Autoscaler::parse(&parameters).has_value());
+
+  parameters.put("min_workers", 2);
+  parameters.put("max_workers", 4);
+  parameters.put("scale_up_depth", 3);
+  parameters.put("scale_down_busy", 0.25);
+  const auto options = Autoscaler::parse(&parameters);
+  ASSERT_TRUE(options.has_value());
+  EXPECT_EQ(options->min_workers, 2);
+  EXPECT_EQ(options->max_workers, 4);
+  EXPECT_DOUBLE_EQ(options->scale_up_depth, 3);
+  EXPECT_DOUBLE_EQ(options->scale_down_busy, 0.25);
+  // only the autoscaling parameters are removed
+  EXPECT_EQ(parameters.size(), 1);
+
+  parameters.put("min_workers", 3);
+  parameters.put("max_workers", 2);
+  EXPECT_THROW(Autoscaler::parse(&parameters), invalid_argument);
+  parameters.put("min_workers", -1);
+  EXPECT_THROW(Autoscaler::parse(&parameters), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitAutoscaler, ScaleUp) {
+  AutoscalerOptions options;
+  options.max_workers = 2;
+  Autoscaler autoscaler{options};
+
+  // a dip below the depth starts the count over
+  EXPECT_EQ(autoscaler.update(4, 1, 1), 0);
+  EXPECT_EQ(autoscaler.update(4, 1, 1), 0);
+  EXPECT_EQ(autoscaler.update(1, 1, 1), 0);
+  for (auto i = 1U; i < options.patience; ++i) {
+    EXPECT_EQ(autoscaler.update(4, 1, 1), 0);
+  }
+  EXPECT_EQ(autoscaler.update(4, 1, 1), 1);
+
+  // the depth is per worker and the group doesn't grow past the maximum
+  for (auto i = 0U; i < options.patience; ++i) {
+    EXPECT_EQ(autoscaler.update(3, 1, 2), 0);
+  }
+  for (auto i = 0U; i < options.patience; ++i) {
+    EXPECT_EQ(autoscaler.update(8, 1, 2), 0);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitAutoscaler, ScaleDown) {
+  AutoscalerOptions options;
+  options.min_workers = 1;
+  options.max_workers = 3;
+  Autoscaler autoscaler{options};
+
+  // removing one of two workers that are each 30% busy leaves one at 60%
+  const size_t patience = 4 * options.patience;
+  for (auto i = 0U; i < patience; ++i) {
+    EXPECT_EQ(autoscaler.update(0, 0.3, 2), 0);
+  }
+
+  for (auto i = 1U; i < patience; ++i) {
+    EXPECT_EQ(autoscaler.update(0, 0.1, 2), 0);
+  }
+  EXPECT_EQ(autoscaler.update(0, 0.1, 2), -1);
+
+  // the group doesn't shrink past the minimum
+  for (auto i = 0U; i < patience; ++i) {
+    EXPECT_EQ(autoscaler.update(0, 0, 1), 0);
+  }
+
+  // groups outside the bounds are changed right away
+  EXPECT_EQ(autoscaler.update(0, 0, 0), 1);
+  EXPECT_EQ(autoscaler.update(0, 0, 4), -1);
+}
+
+}  // namespace amdinfer
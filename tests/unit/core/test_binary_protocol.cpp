@@ -0,0 +1,132 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>      // for byte
+#include <cstdint>      // for int32_t, uint8_t
+#include <cstring>      // for memcmp
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/core/binary_protocol.hpp"  // for parseBinaryPrefix, ...
+#include "amdinfer/core/data_types.hpp"       // for DataType
+#include "amdinfer/core/exceptions.hpp"       // for invalid_argument
+#include "gtest/gtest.h"                      // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBinaryProtocol, Request) {
+  std::vector<uint8_t> data{0, 1, 2, 3, 4, 5};
+  InferenceRequest request;
+  request.setID("id");
+  ParameterMap parameters;
+  parameters.put("priority", 1);
+  request.setParameters(parameters);
+  request.addInputTensor(data.data(), {2, 3}, DataType::Uint8, "input");
+  InferenceRequestOutput output;
+  output.setName("output");
+  request.addOutputTensor(output);
+
+  const auto message = serializeBinaryRequest("model", "2", request);
+  const std::string_view view{message};
+  const auto prefix = parseBinaryPrefix(view);
+  EXPECT_EQ(prefix.kind, BinaryMessageKind::Request);
+  EXPECT_EQ(prefix.data_size, data.size());
+  ASSERT_EQ(message.size(),
+            kBinaryPrefixSize + prefix.header_size + prefix.data_size);
+
+  const auto parsed = parseBinaryRequestHeader(
+    view.substr(kBinaryPrefixSize, prefix.header_size), prefix.data_size);
+  EXPECT_EQ(parsed.model, "model");
+  EXPECT_EQ(parsed.version, "2");
+  EXPECT_EQ(parsed.request.getID(), "id");
+  EXPECT_EQ(parsed.request.getParameters().get<int32_t>("priority"), 1);
+  ASSERT_EQ(parsed.request.getInputSize(), 1);
+  const auto& input = parsed.request.getInputs()[0];
+  EXPECT_EQ(input.getName(), "input");
+  EXPECT_EQ(input.getShape(), (Shape{2, 3}));
+  EXPECT_EQ(input.getDatatype(), DataType::Uint8);
+  ASSERT_EQ(parsed.request.getOutputs().size(), 1);
+  EXPECT_EQ(parsed.request.getOutputs()[0].getName(), "output");
+
+  const auto payload = view.substr(kBinaryPrefixSize + prefix.header_size);
+  EXPECT_EQ(std::memcmp(payload.data(), data.data(), data.size()), 0);
+
+  // the data must match the inputs' shapes
+  EXPECT_THROW(
+    (void)parseBinaryRequestHeader(
+      view.substr(kBinaryPrefixSize, prefix.header_size), prefix.data_size - 1),
+    invalid_argument);
+  EXPECT_THROW((void)parseBinaryRequestHeader(
+                 view.substr(kBinaryPrefixSize, prefix.header_size - 1),
+                 prefix.data_size),
+               invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBinaryProtocol, Response) {
+  InferenceResponse response;
+  response.setID("id");
+  response.setModel("model");
+  response.setFinal(false);
+  InferenceResponseOutput output;
+  output.setName("output");
+  output.setDatatype(DataType::Fp32);
+  output.setShape({2});
+  const std::vector<float> values{1.5F, -2.0F};
+  std::vector<std::byte> buffer(sizeof(float) * values.size());
+  std::memcpy(buffer.data(), values.data(), buffer.size());
+  output.setData(std::move(buffer));
+  response.addOutput(output);
+
+  auto message = serializeBinaryResponseHeader(response);
+  const auto prefix = parseBinaryPrefix(message);
+  EXPECT_EQ(prefix.kind, BinaryMessageKind::Response);
+  EXPECT_EQ(prefix.data_size, sizeof(float) * values.size());
+  EXPECT_EQ(message.size(), kBinaryPrefixSize + prefix.header_size);
+  message.append(static_cast<const char*>(output.getData()),
+                 prefix.data_size);
+
+  const auto parsed = parseBinaryResponse(message);
+  EXPECT_EQ(parsed.getID(), "id");
+  EXPECT_EQ(parsed.getModel(), "model");
+  EXPECT_FALSE(parsed.isError());
+  EXPECT_FALSE(parsed.isFinal());
+  ASSERT_EQ(parsed.getOutputs().size(), 1);
+  const auto& parsed_output = parsed.getOutputs()[0];
+  EXPECT_EQ(parsed_output.getName(), "output");
+  EXPECT_EQ(parsed_output.getDatatype(), DataType::Fp32);
+  EXPECT_EQ(parsed_output.getShape(), (Shape{2}));
+  EXPECT_EQ(std::memcmp(parsed_output.getData(), values.data(),
+                        prefix.data_size),
+            0);
+
+  const auto error =
+    parseBinaryResponse(serializeBinaryResponseHeader(InferenceResponse{"x"}));
+  EXPECT_TRUE(error.isError());
+  EXPECT_EQ(error.getError(), "x");
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBinaryProtocol, BadPrefix) {
+  EXPECT_THROW((void)parseBinaryPrefix("AMDB"), invalid_argument);
+  std::string message(kBinaryPrefixSize, '\0');
+  EXPECT_THROW((void)parseBinaryPrefix(message), invalid_argument);
+  message = serializeBinaryResponseHeader(InferenceResponse{});
+  message[4] = 2;
+  EXPECT_THROW((void)parseBinaryPrefix(message), invalid_argument);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,145 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <cstddef>     // for byte
+#include <cstdint>     // for uint64_t
+#include <cstring>     // for memcpy
+#include <filesystem>  // for path, temp_directory_path, remove_all
+#include <fstream>     // for ofstream, ifstream
+#include <iterator>    // for istreambuf_iterator
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/bulk_dataset.hpp"        // for BulkDataset, BulkOu...
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+namespace {
+
+void writeFile(const fs::path& path, const std::string& data) {
+  std::ofstream file{path, std::ios::binary};
+  file << data;
+}
+
+std::string readFile(const fs::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+std::vector<uint64_t> readIndex(const fs::path& path) {
+  const auto data = readFile(path);
+  std::vector<uint64_t> offsets(data.size() / sizeof(uint64_t));
+  std::memcpy(offsets.data(), data.data(), data.size());
+  return offsets;
+}
+
+InferenceResponse makeResponse(std::vector<float> values) {
+  InferenceResponseOutput output;
+  output.setName("scores");
+  output.setDatatype(DataType::Fp32);
+  output.setShape({static_cast<int64_t>(values.size())});
+  std::vector<std::byte> buffer(values.size() * sizeof(float));
+  std::memcpy(buffer.data(), values.data(), buffer.size());
+  output.setData(std::move(buffer));
+  InferenceResponse response;
+  response.addOutput(output);
+  return response;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBulkDataset, Tensors) {
+  const auto path = fs::temp_directory_path() / "amdinfer_test_dataset.bin";
+  writeFile(path, "abcdef");
+
+  BulkDataset dataset{path, 2};
+  EXPECT_FALSE(dataset.images());
+  ASSERT_EQ(dataset.size(), 3);
+  EXPECT_EQ(dataset.bytes(1), 2);
+  EXPECT_EQ(static_cast<char>(*dataset.data(2)), 'e');
+  std::vector<std::byte> sample(2);
+  dataset.read(1, sample.data());
+  EXPECT_EQ(static_cast<char>(sample[0]), 'c');
+
+  // the file must be a whole number of samples
+  EXPECT_THROW(BulkDataset(path, 4), invalid_argument);
+  EXPECT_THROW(BulkDataset(path, 0), invalid_argument);
+  fs::remove(path);
+  EXPECT_THROW(BulkDataset(path, 2), file_not_found_error);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBulkDataset, Images) {
+  const auto directory = fs::temp_directory_path() / "amdinfer_test_images";
+  fs::create_directories(directory);
+  writeFile(directory / "b.jpg", "second");
+  writeFile(directory / "a.jpg", "first");
+
+  // the images are in the order of their names
+  BulkDataset dataset{directory, 0};
+  EXPECT_TRUE(dataset.images());
+  ASSERT_EQ(dataset.size(), 2);
+  EXPECT_EQ(dataset.getFiles()[0].filename(), "a.jpg");
+  EXPECT_EQ(dataset.data(0), nullptr);
+  ASSERT_EQ(dataset.bytes(1), 6);
+  std::string image(6, '\0');
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  dataset.read(1, reinterpret_cast<std::byte*>(image.data()));
+  EXPECT_EQ(image, "second");
+  fs::remove_all(directory);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBulkDataset, Columns) {
+  const auto directory = fs::temp_directory_path() / "amdinfer_test_outputs";
+  fs::remove_all(directory);
+  {
+    BulkOutputWriter writer{directory};
+    // samples before an output first appears and errors are empty
+    writer.write(InferenceResponse{"failed"});
+    writer.write(makeResponse({1, 2}));
+    writer.write(makeResponse({3, 4}));
+    EXPECT_EQ(writer.size(), 3);
+    auto columns = writer.getColumns();
+    ASSERT_EQ(columns.size(), 1);
+    EXPECT_EQ(columns[0].name, "scores");
+    EXPECT_EQ(columns[0].datatype, DataType::Fp32);
+    EXPECT_EQ(columns[0].shape, (std::vector<int64_t>{2}));
+    EXPECT_TRUE(columns[0].fixed);
+
+    writer.write(makeResponse({5}));
+    EXPECT_FALSE(writer.getColumns()[0].fixed);
+    writer.flush();
+  }
+
+  EXPECT_EQ(readIndex(directory / "scores.index"),
+            (std::vector<uint64_t>{0, 0, 8, 16, 20}));
+  const auto data = readFile(directory / "scores.bin");
+  ASSERT_EQ(data.size(), 20);
+  std::vector<float> values(5);
+  std::memcpy(values.data(), data.data(), data.size());
+  EXPECT_EQ(values, (std::vector<float>{1, 2, 3, 4, 5}));
+  fs::remove_all(directory);
+}
+
+}  // namespace amdinfer
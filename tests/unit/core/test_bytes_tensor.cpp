@@ -0,0 +1,66 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/core/bytes_tensor.hpp"  // for BytesView, packBytes
+#include "gtest/gtest.h"                   // for Test, EXPECT_EQ, ASSERT_EQ
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBytesTensor, View) {
+  using namespace std::string_literals;
+  const auto data = "hello\0\0world\0\0\0"s;
+  const BytesView view{data.data(), data.size()};
+  ASSERT_EQ(view.size(), 3);
+  EXPECT_EQ(view[0], "hello");
+  EXPECT_EQ(view[1], "");
+  EXPECT_EQ(view[2], "world");
+  const std::vector<size_t> offsets{0, 6, 7, 13};
+  EXPECT_EQ(view.offsets(), offsets);
+
+  // the last element doesn't need a terminator
+  const std::string unterminated = "a";
+  const BytesView single{unterminated.data(), unterminated.size()};
+  ASSERT_EQ(single.size(), 1);
+  EXPECT_EQ(single[0], "a");
+
+  const BytesView empty{data.data(), 0};
+  EXPECT_TRUE(empty.empty());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitBytesTensor, Pack) {
+  const std::vector<std::string> elements{"abc", "", "de"};
+  const auto data = packBytes(elements);
+  ASSERT_EQ(data.size(), 8);
+  const BytesView view{data.data(), data.size()};
+  ASSERT_EQ(view.size(), 3);
+  for (auto i = 0U; i < elements.size(); ++i) {
+    EXPECT_EQ(view[i], elements[i]);
+  }
+
+  // the rest of a larger buffer is zeroed and one too small is cut short
+  std::string buffer(10, 'x');
+  EXPECT_EQ(packBytes(elements, buffer.data(), buffer.size()), 8);
+  EXPECT_EQ(BytesView(buffer.data(), buffer.size()).size(), 3);
+  EXPECT_EQ(buffer.substr(8), std::string(2, '\0'));
+  EXPECT_EQ(packBytes(elements, buffer.data(), 2), 2);
+  EXPECT_EQ(buffer.substr(0, 2), "ab");
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,122 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>     // for make_shared, shared_ptr
+#include <stdexcept>  // for runtime_error
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include "amdinfer/core/completion_router.hpp"   // for CompletionRouter
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+namespace {
+
+/// Holds the completions posted to it until they're run
+class FakeExecutor : public CompletionExecutor {
+ public:
+  void post(std::vector<Completion> completions) override {
+    posts_.push_back(std::move(completions));
+  }
+
+  [[nodiscard]] size_t posts() const { return posts_.size(); }
+
+  void run() {
+    for (auto& completions : posts_) {
+      runCompletions(&completions);
+    }
+    posts_.clear();
+  }
+
+ private:
+  std::vector<std::vector<Completion>> posts_;
+};
+
+InferenceRequest makeRequest(const std::string& id,
+                             std::vector<std::string>* responses) {
+  InferenceRequest request;
+  request.setID(id);
+  request.setCallback([responses](const InferenceResponse& response) {
+    responses->push_back(response.getID());
+  });
+  return request;
+}
+
+InferenceResponse makeResponse(const std::string& id) {
+  InferenceResponse response;
+  response.setID(id);
+  return response;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCompletionRouter, Group) {
+  auto first = std::make_shared<FakeExecutor>();
+  auto second = std::make_shared<FakeExecutor>();
+  std::vector<std::string> responses;
+
+  std::vector<InferenceRequest> requests;
+  for (const auto* id : {"a", "b", "c", "d"}) {
+    requests.push_back(makeRequest(id, &responses));
+  }
+  requests[0].setExecutor(first);
+  requests[1].setExecutor(second);
+  requests[2].setExecutor(first);
+
+  CompletionRouter router;
+  for (auto& request : requests) {
+    router.add(&request, makeResponse(request.getID()));
+  }
+  // requests without an executor are responded to right away
+  EXPECT_EQ(responses, std::vector<std::string>{"d"});
+  EXPECT_EQ(first->posts(), 0);
+
+  router.flush();
+  EXPECT_EQ(first->posts(), 1);
+  EXPECT_EQ(second->posts(), 1);
+
+  first->run();
+  second->run();
+  EXPECT_EQ(responses, (std::vector<std::string>{"d", "a", "c", "b"}));
+
+  // each request is only responded to once
+  router.add(requests.data(), makeResponse("a"));
+  router.flush();
+  first->run();
+  EXPECT_EQ(responses.size(), 4);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitCompletionRouter, Errors) {
+  std::vector<std::string> responses;
+  std::vector<Completion> completions;
+  completions.push_back(
+    Completion{[](const InferenceResponse&) { throw std::runtime_error("a"); },
+               makeResponse("a")});
+  completions.push_back(
+    Completion{[&responses](const InferenceResponse& response) {
+                 responses.push_back(response.getID());
+               },
+               makeResponse("b")});
+
+  // one failed callback doesn't stop the rest
+  runCompletions(&completions);
+  EXPECT_EQ(responses, std::vector<std::string>{"b"});
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,112 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>  // for atomic_bool
+#include <chrono>  // for milliseconds
+#include <memory>  // for make_shared
+#include <thread>  // for thread
+#include <vector>  // for vector
+
+#include "amdinfer/core/device_scheduler.hpp"  // for DeviceScheduler
+#include "amdinfer/core/exceptions.hpp"        // for invalid_argument
+#include "gtest/gtest.h"                       // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+using std::chrono::milliseconds;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitDeviceScheduler, Slots) {
+  auto scheduler = std::make_shared<DeviceScheduler>("0");
+  EXPECT_THROW((void)scheduler->join("a", 0), invalid_argument);
+  auto share = scheduler->join("a", 1);
+  auto turn = share->take();
+
+  // the second turn waits for the first with one slot
+  std::atomic_bool taken = false;
+  std::thread other{[&]() {
+    auto second = share->take();
+    taken = true;
+  }};
+  std::this_thread::sleep_for(milliseconds{20});
+  EXPECT_FALSE(taken);
+  turn.reset();
+  other.join();
+  EXPECT_TRUE(taken);
+  EXPECT_GT(scheduler->getBusyTime("a").count(), 0);
+
+  // but not with two
+  scheduler->setSlots(2);
+  auto first = share->take();
+  auto second = share->take();
+  EXPECT_EQ(scheduler->getSlots(), 2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitDeviceScheduler, Get) {
+  auto scheduler = DeviceScheduler::get("0");
+  EXPECT_EQ(scheduler, DeviceScheduler::get("0"));
+  EXPECT_NE(scheduler, DeviceScheduler::get("1"));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitDeviceScheduler, Weights) {
+  const auto quantum = milliseconds{1};
+  auto scheduler = std::make_shared<DeviceScheduler>("0", quantum);
+  auto heavy = scheduler->join("heavy", 3);
+  auto light = scheduler->join("light", 1);
+
+  // both endpoints keep the device busy with batches of the same length from
+  // two workers each so they always have a batch waiting
+  std::atomic_bool stop = false;
+  const auto run = [&](DeviceScheduler::Share* share) {
+    while (!stop) {
+      auto turn = share->take();
+      std::this_thread::sleep_for(milliseconds{1});
+    }
+  };
+  std::vector<std::thread> workers;
+  for (auto i = 0; i < 2; ++i) {
+    workers.emplace_back(run, heavy.get());
+    workers.emplace_back(run, light.get());
+  }
+  std::this_thread::sleep_for(milliseconds{400});
+  stop = true;
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  const auto heavy_time = scheduler->getBusyTime("heavy");
+  const auto light_time = scheduler->getBusyTime("light");
+  ASSERT_GT(light_time.count(), 0);
+  const auto ratio = static_cast<double>(heavy_time.count()) /
+                     static_cast<double>(light_time.count());
+  EXPECT_GT(ratio, 2);
+  EXPECT_LT(ratio, 4.5);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitDeviceScheduler, Leave) {
+  auto scheduler = std::make_shared<DeviceScheduler>("0");
+  auto share = scheduler->join("a", 1);
+  auto other = scheduler->join("a", 2);
+  share->take().reset();
+  share.reset();
+  // the endpoint stays while it has a share
+  EXPECT_GT(scheduler->getBusyTime("a").count(), 0);
+  other.reset();
+  EXPECT_EQ(scheduler->getBusyTime("a").count(), 0);
+}
+
+}  // namespace amdinfer
@@ -15,13 +15,16 @@
 
 #include <algorithm>  // for max
 #include <cstddef>    // for byte
-#include <cstdint>    // for uint64_t
+#include <cstdint>    // for int32_t, uint64_t
+#include <memory>     // for make_unique
 #include <string>     // for allocator, string
 #include <utility>    // for move
 #include <vector>     // for vector
 
-#include "amdinfer/core/data_types.hpp"         // for DataType, DataType::Uint8
-#include "amdinfer/core/inference_request.hpp"  // for InferenceRequestInput
+#include "amdinfer/core/data_types.hpp"          // for DataType, DataType::...
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequestInput
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
 #include "gtest/gtest.h"  // for Message, TestPartResult, Test
 
 namespace amdinfer {
@@ -66,4 +69,103 @@ TEST(UnitInferenceRequestInput, SerDes) {
   EXPECT_EQ(req.getSize(), new_req.getSize());
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitInferenceRequestInput, Views) {
+  // a 3x4 matrix of 0..11
+  std::vector<int32_t> data(12);
+  for (auto i = 0U; i < data.size(); ++i) {
+    data[i] = static_cast<int32_t>(i);
+  }
+  InferenceRequestInput input(data.data(), {3, 4}, DataType::Int32,
+                              "test");
+  EXPECT_TRUE(input.isContiguous());
+
+  // rows are contiguous
+  auto rows = input;
+  rows.slice(0, 1, 3);
+  EXPECT_FALSE(rows.isContiguous());
+  EXPECT_EQ(rows.getData(), data.data());
+  EXPECT_EQ(rows.getOffset(), 4);
+  std::vector<int32_t> dense(rows.getSize());
+  rows.copyData(dense.data());
+  EXPECT_EQ(dense, (std::vector<int32_t>{4, 5, 6, 7, 8, 9, 10, 11}));
+
+  // a crop of both dimensions
+  auto crop = input;
+  crop.slice(0, 1, 3);
+  crop.slice(1, 1, 3);
+  EXPECT_EQ(crop.getShape(), (Shape{2, 2}));
+  dense.resize(crop.getSize());
+  crop.copyData(dense.data());
+  EXPECT_EQ(dense, (std::vector<int32_t>{5, 6, 9, 10}));
+
+  auto transposed = input;
+  transposed.transpose({1, 0});
+  EXPECT_EQ(transposed.getShape(), (Shape{4, 3}));
+  EXPECT_EQ(transposed.getStrides(), (Strides{1, 4}));
+  dense.resize(transposed.getSize());
+  transposed.copyData(dense.data());
+  EXPECT_EQ(dense,
+            (std::vector<int32_t>{0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11}));
+
+  // serializing copies the view densely
+  std::vector<std::byte> serial_data(crop.serializeSize());
+  crop.serialize(serial_data.data());
+  std::vector<int32_t> new_data(crop.getSize());
+  InferenceRequestInput new_input;
+  new_input.setData(new_data.data());
+  new_input.deserialize(serial_data.data());
+  EXPECT_TRUE(new_input.isContiguous());
+  EXPECT_EQ(new_data, (std::vector<int32_t>{5, 6, 9, 10}));
+
+  // setting the data makes the input dense
+  InferenceRequest request;
+  request.addInputTensor(crop);
+  request.setInputTensorData(0, new_data.data());
+  EXPECT_TRUE(request.getInputs()[0].isContiguous());
+
+  EXPECT_THROW(input.slice(2, 0, 1), invalid_argument);
+  EXPECT_THROW(input.slice(0, 2, 4), invalid_argument);
+  EXPECT_THROW(input.transpose({0, 0}), invalid_argument);
+  EXPECT_THROW(input.setStrides({1}), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitInferenceRequest, MoveOutTensors) {
+  InferenceRequest request;
+  request.addInputTensor(nullptr, {1, 2}, DataType::Uint8, "input");
+  InferenceRequestOutput output;
+  output.setName("output");
+  request.addOutputTensor(output);
+
+  // lvalues are only viewed
+  const auto& inputs = request.getInputs();
+  EXPECT_EQ(&inputs, &request.getInputs());
+  EXPECT_EQ(request.getOutputs().at(0).getName(), "output");
+
+  auto moved_inputs = std::move(request).getInputs();
+  ASSERT_EQ(moved_inputs.size(), 1);
+  EXPECT_EQ(moved_inputs[0].getName(), "input");
+  EXPECT_EQ(moved_inputs[0].getShape().size(), 2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitInferenceRequest, Callback) {
+  InferenceRequest request;
+  request.setID("id");
+  int calls = 0;
+  // callbacks can hold move-only objects
+  request.setCallback([&calls, owned = std::make_unique<int>()](
+                        const InferenceResponse&) { calls++; });
+
+  // copies don't respond to the request's client
+  auto copy = request;
+  EXPECT_EQ(copy.getID(), "id");
+  EXPECT_TRUE(copy.getCallback() == nullptr);
+
+  request.runCallbackOnce(InferenceResponse{});
+  request.runCallbackOnce(InferenceResponse{});
+  EXPECT_EQ(calls, 1);
+}
+
 }  // namespace amdinfer
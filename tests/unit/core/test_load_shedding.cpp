@@ -0,0 +1,96 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // for milliseconds
+#include <memory>  // for make_shared
+
+#include "amdinfer/core/exceptions.hpp"     // for resource_exhausted_error
+#include "amdinfer/core/load_shedding.hpp"  // for LoadShedder, RateLimiter
+#include "gtest/gtest.h"                    // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+using std::chrono::milliseconds;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadShedding, MaxInflight) {
+  auto shedder = std::make_shared<LoadShedder>(milliseconds{0}, 2);
+  auto first = shedder->admit();
+  auto second = shedder->admit();
+  EXPECT_THROW(shedder->admit(), resource_exhausted_error);
+  EXPECT_EQ(shedder->getInflight(), 2);
+  EXPECT_DOUBLE_EQ(shedder->getLoad(), 1);
+
+  first.reset();
+  EXPECT_EQ(shedder->getInflight(), 1);
+  EXPECT_DOUBLE_EQ(shedder->getLoad(), 0.5);
+  EXPECT_NE(shedder->admit(), nullptr);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadShedding, Latency) {
+  const milliseconds target{10};
+  const milliseconds interval{100};
+  auto shedder = std::make_shared<LoadShedder>(target, 0, interval);
+  const auto start = LoadShedder::Clock::now();
+
+  // a burst of slow requests shorter than the interval isn't shed
+  shedder->observe(milliseconds{50}, start);
+  shedder->observe(milliseconds{50}, start + milliseconds{50});
+  EXPECT_FALSE(shedder->isShedding(start + milliseconds{50}));
+  // its ticket would report its latency when it's destroyed
+  const auto ticket = shedder->admit(start + milliseconds{50});
+
+  // but slow requests for a whole interval are
+  auto now = start + interval;
+  shedder->observe(milliseconds{50}, now);
+  EXPECT_TRUE(shedder->isShedding(now));
+  EXPECT_DOUBLE_EQ(shedder->getLoad(now), 1);
+  EXPECT_THROW(shedder->admit(now), resource_exhausted_error);
+  // only the request that was admitted is in flight
+  EXPECT_EQ(shedder->getInflight(), 1);
+
+  // until a request is served in time
+  shedder->observe(milliseconds{5}, now);
+  EXPECT_FALSE(shedder->isShedding(now));
+  EXPECT_NE(shedder->admit(now), nullptr);
+
+  // or nothing slow is seen for an interval
+  shedder->observe(milliseconds{50}, now);
+  now += interval;
+  shedder->observe(milliseconds{50}, now);
+  EXPECT_TRUE(shedder->isShedding(now));
+  EXPECT_FALSE(shedder->isShedding(now + interval));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitLoadShedding, RateLimit) {
+  RateLimiter limiter{10, 2};
+  const auto start = RateLimiter::Clock::now();
+
+  limiter.take("a", start);
+  limiter.take("a", start);
+  EXPECT_THROW(limiter.take("a", start), resource_exhausted_error);
+  // each tenant has its own bucket
+  limiter.take("b", start);
+
+  // the bucket refills at the rate
+  EXPECT_THROW(limiter.take("a", start + milliseconds{50}),
+               resource_exhausted_error);
+  limiter.take("a", start + milliseconds{100});
+  EXPECT_THROW(limiter.take("a", start + milliseconds{100}),
+               resource_exhausted_error);
+}
+
+}  // namespace amdinfer
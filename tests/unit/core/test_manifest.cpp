@@ -0,0 +1,127 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>     // for size_t
+#include <cstdint>     // for int32_t
+#include <filesystem>  // for path, temp_directory_path, remove
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/core/manifest.hpp"    // for Manifest, ManifestEntry
+#include "gtest/gtest.h"                 // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+namespace {
+
+ManifestEntry makeWorker(const std::string& name, const std::string& endpoint,
+                         const std::string& next = "") {
+  ManifestEntry entry;
+  entry.name = name;
+  entry.endpoint = endpoint;
+  if (!next.empty()) {
+    entry.parameters.put("next", next);
+  }
+  return entry;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitManifest, RoundTrip) {
+  std::vector<ManifestEntry> entries;
+  entries.push_back(makeWorker("echo", "echo"));
+  entries.back().parameters.put("batch_size", 4);
+  entries.back().parameters.put("timeout", 1.0);
+  entries.back().parameters.put("share", false);
+  ManifestEntry model;
+  model.kind = ManifestKind::Model;
+  model.name = "resnet";
+  model.version = "2";
+  model.endpoint = "resnet_2";
+  model.parameters.put("swap", true);
+  entries.push_back(model);
+
+  const auto parsed = parseManifest(serializeManifest(entries));
+  ASSERT_EQ(parsed.size(), 2);
+  EXPECT_EQ(parsed[0].kind, ManifestKind::Worker);
+  EXPECT_EQ(parsed[0].name, "echo");
+  EXPECT_EQ(parsed[0].parameters.get<int32_t>("batch_size"), 4);
+  // integral doubles stay doubles
+  EXPECT_EQ(parsed[0].parameters.get<double>("timeout"), 1.0);
+  EXPECT_FALSE(parsed[0].parameters.get<bool>("share"));
+  EXPECT_EQ(parsed[1].kind, ManifestKind::Model);
+  EXPECT_EQ(parsed[1].version, "2");
+  EXPECT_EQ(parsed[1].endpoint, "resnet_2");
+  EXPECT_TRUE(parsed[1].parameters.get<bool>("swap"));
+
+  EXPECT_THROW(parseManifest("{"), invalid_argument);
+  EXPECT_THROW(parseManifest(R"({"version": 0})"), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitManifest, RestoreStages) {
+  // a chain loaded from its end and an unrelated worker loaded twice
+  std::vector<ManifestEntry> entries;
+  entries.push_back(makeWorker("post", "post"));
+  entries.push_back(makeWorker("echo", "echo"));
+  entries.push_back(makeWorker("model", "model", "post"));
+  entries.push_back(makeWorker("echo", "echo-0"));
+  entries.push_back(makeWorker("pre", "pre", "model"));
+
+  const auto stages = getRestoreStages(entries);
+  const std::vector<std::vector<size_t>> expected{{0, 1}, {2, 3}, {4}};
+  EXPECT_EQ(stages, expected);
+  EXPECT_TRUE(getRestoreStages({}).empty());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitManifest, Record) {
+  const auto path =
+    std::filesystem::temp_directory_path() / "amdinfer_test_manifest.json";
+  std::filesystem::remove(path);
+
+  Manifest manifest{path};
+  manifest.add(makeWorker("echo", "echo"));
+  // loading the same endpoint again doesn't add it twice
+  manifest.add(makeWorker("echo", "echo"));
+  manifest.add(makeWorker("echo", "echo-0"));
+  ManifestEntry model;
+  model.kind = ManifestKind::Model;
+  model.name = "resnet";
+  model.version = "1";
+  model.endpoint = "resnet_1";
+  manifest.add(model);
+  EXPECT_EQ(readManifest(path).size(), 3);
+
+  // swapping replaces the model's other versions
+  model.version = "2";
+  model.endpoint = "resnet_2";
+  model.parameters.put("swap", true);
+  manifest.add(model);
+  manifest.removeWorker("echo");
+  auto entries = readManifest(path);
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].endpoint, "echo-0");
+  EXPECT_EQ(entries[1].endpoint, "resnet_2");
+
+  manifest.removeModel("resnet", "2");
+  EXPECT_EQ(readManifest(path).size(), 1);
+
+  std::filesystem::remove(path);
+  EXPECT_TRUE(readManifest(path).empty());
+}
+
+}  // namespace amdinfer
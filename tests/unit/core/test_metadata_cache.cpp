@@ -0,0 +1,49 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>  // for make_shared
+#include <string>  // for string
+
+#include "amdinfer/core/metadata_cache.hpp"  // for MetadataCache
+#include "amdinfer/core/model_metadata.hpp"  // for ModelMetadata
+#include "gtest/gtest.h"                     // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitMetadataCache, Reuse) {
+  MetadataCache<std::string> cache;
+  auto calls = 0;
+  const auto make = [&calls](const ModelMetadata& metadata) {
+    calls++;
+    return metadata.getName();
+  };
+
+  auto metadata = std::make_shared<const ModelMetadata>("a", "platform");
+  auto value = cache.get("a", metadata, make);
+  EXPECT_EQ(*value, "a");
+  EXPECT_EQ(cache.get("a", metadata, make), value);
+  EXPECT_EQ(calls, 1);
+
+  // newly published metadata replaces the cached value
+  metadata = std::make_shared<const ModelMetadata>("b", "platform");
+  EXPECT_EQ(*cache.get("a", metadata, make), "b");
+  EXPECT_EQ(calls, 2);
+
+  // endpoints are cached separately
+  EXPECT_EQ(*cache.get("c", metadata, make), "b");
+  EXPECT_EQ(calls, 3);
+}
+
+}  // namespace amdinfer
@@ -16,6 +16,7 @@
 
 #include <iostream>
 
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
 #include "amdinfer/core/model_config.hpp"        // for ModelConfig
 #include "amdinfer/core/versioned_endpoint.hpp"  // for getVersionedEndpoint
 #include "gtest/gtest.h"  // for Message, TestPartResult, Test
@@ -151,6 +152,223 @@ TEST(UnitModelConfig, Chain) {
     ASSERT_EQ(parameters.get<std::string>("worker"), "cplusplus");
     index++;
   }
+  ASSERT_TRUE(config.isChain());
+  ASSERT_EQ(config.get(0).second.get<std::string>("next"),
+            getVersionedEndpoint("execute", version));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitModelConfig, Dag) {
+  constexpr std::string_view kTomlStr = R"(
+    [[models]]
+    name = "detect"
+    platform = "amdinfer_cpp"
+    id = "detect.so"
+
+    [[models.inputs]]
+    name = "image"
+    datatype = "FP32"
+    shape = [224, 224, 3]
+    id = ""
+
+    [[models.outputs]]
+    name = "boxes"
+    datatype = "FP32"
+    shape = [10, 4]
+    id = "boxes"
+
+    [[models]]
+    name = "classify"
+    platform = "amdinfer_cpp"
+    id = "classify.so"
+
+    [[models.inputs]]
+    name = "boxes"
+    datatype = "FP32"
+    shape = [10, 4]
+    id = "boxes"
+
+    [[models.outputs]]
+    name = "classes"
+    datatype = "FP32"
+    shape = [10]
+    id = "classes"
+
+    [[models]]
+    name = "embed"
+    platform = "amdinfer_cpp"
+    id = "embed.so"
+
+    [[models.inputs]]
+    name = "boxes"
+    datatype = "FP32"
+    shape = [10, 4]
+    id = "boxes"
+
+    [[models.inputs]]
+    name = "image"
+    datatype = "FP32"
+    shape = [224, 224, 3]
+    id = ""
+
+    [[models.outputs]]
+    name = "embeddings"
+    datatype = "FP32"
+    shape = [10, 128]
+    id = "embeddings"
+
+    [[models]]
+    name = "merge"
+    platform = "amdinfer_cpp"
+    id = "merge.so"
+
+    [[models.inputs]]
+    name = "classes"
+    datatype = "FP32"
+    shape = [10]
+    id = "classes"
+
+    [[models.inputs]]
+    name = "embeddings"
+    datatype = "FP32"
+    shape = [10, 128]
+    id = "embeddings"
+
+    [[models.outputs]]
+    name = "results"
+    datatype = "FP32"
+    shape = [10, 129]
+    id = ""
+  )"sv;
+
+  const auto toml = toml::parse(kTomlStr);
+  ModelConfig config{toml, ""};
+
+  ASSERT_EQ(config.size(), 4);
+  ASSERT_FALSE(config.isChain());
+  EXPECT_TRUE(config.getParents(0).empty());
+  EXPECT_EQ(config.getParents(1), std::vector<size_t>{0});
+  EXPECT_EQ(config.getParents(2), std::vector<size_t>{0});
+  EXPECT_EQ(config.getParents(3), (std::vector<size_t>{1, 2}));
+  // the models of a DAG aren't wired to each other
+  for (const auto& [model, parameters] : config) {
+    EXPECT_FALSE(parameters.has("next"));
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitModelConfig, Cycle) {
+  constexpr std::string_view kTomlStr = R"(
+    [[models]]
+    name = "a"
+    platform = "amdinfer_cpp"
+    id = "a.so"
+
+    [[models.inputs]]
+    name = "input"
+    datatype = "FP32"
+    shape = [1]
+    id = "b_out"
+
+    [[models.outputs]]
+    name = "output"
+    datatype = "FP32"
+    shape = [1]
+    id = "a_out"
+
+    [[models]]
+    name = "b"
+    platform = "amdinfer_cpp"
+    id = "b.so"
+
+    [[models.inputs]]
+    name = "input"
+    datatype = "FP32"
+    shape = [1]
+    id = "a_out"
+
+    [[models.outputs]]
+    name = "output"
+    datatype = "FP32"
+    shape = [1]
+    id = "b_out"
+  )"sv;
+
+  const auto toml = toml::parse(kTomlStr);
+  EXPECT_THROW((ModelConfig{toml, ""}), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitModelConfig, Sections) {
+  constexpr std::string_view kTomlStr = R"(
+    name = "resnet50"
+    platform = "onnx_onnxv1"
+
+    [[inputs]]
+    name = "input"
+    datatype = "FP32"
+    shape = [224, 224, 3]
+
+    [[outputs]]
+    name = "output"
+    datatype = "FP32"
+    shape = [1000]
+
+    [instance_group]
+    count = 2
+    devices = [0, 1]
+
+    [dynamic_batching]
+    max_batch_size = 8
+    preferred_batch_sizes = [4]
+    max_queue_delay_ms = 5
+    priority_levels = 2
+
+    [memory]
+    reserve_batches = 3
+    slab_slots = 4
+
+    [parameters]
+    timeout = 10
+    precision = "fp16"
+  )"sv;
+
+  const auto toml = toml::parse(kTomlStr);
+  ModelConfig config{toml, ""};
+
+  const auto parameters = config.get(0).second;
+  EXPECT_EQ(parameters.get<std::string>("worker"), "migraphx");
+  EXPECT_EQ(parameters.get<int32_t>("min_workers"), 2);
+  EXPECT_EQ(parameters.get<std::string>("devices"), "0,1");
+  // MIGraphX calls the batch size "batch" and compiles the preferred sizes
+  EXPECT_FALSE(parameters.has("batch_size"));
+  EXPECT_EQ(parameters.get<int32_t>("batch"), 8);
+  EXPECT_EQ(parameters.get<std::string>("batch_sizes"), "4,8");
+  // the sections take precedence over the free-form parameters
+  EXPECT_EQ(parameters.get<int32_t>("timeout"), 5);
+  EXPECT_EQ(parameters.get<int32_t>("priority_levels"), 2);
+  EXPECT_EQ(parameters.get<int32_t>("reserve_batches"), 3);
+  EXPECT_EQ(parameters.get<int32_t>("slab_slots"), 4);
+  EXPECT_EQ(parameters.get<std::string>("precision"), "fp16");
+
+  constexpr std::string_view kUnknownStr = R"(
+    name = "resnet50"
+    platform = "onnx_onnxv1"
+
+    [[inputs]]
+    name = "input"
+    datatype = "FP32"
+    shape = [224, 224, 3]
+
+    [[outputs]]
+    name = "output"
+    datatype = "FP32"
+    shape = [1000]
+
+    [dynamic_batching]
+    max_batch = 8
+  )"sv;
+  EXPECT_THROW((ModelConfig{toml::parse(kUnknownStr), ""}), invalid_argument);
 }
 
 }  // namespace amdinfer
@@ -0,0 +1,157 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for byte
+#include <cstdint>  // for int32_t
+#include <cstring>  // for memcpy
+#include <string>   // for string
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"          // for DataType, fp16
+#include "amdinfer/core/exceptions.hpp"          // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/output_transforms.hpp"   // for OutputTransform
+#include "amdinfer/core/parameters.hpp"          // for ParameterMap
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ
+
+namespace amdinfer {
+
+namespace {
+
+InferenceRequestOutput makeOutput(const std::string& name,
+                                  ParameterMap parameters) {
+  InferenceRequestOutput output;
+  output.setName(name);
+  output.setParameters(std::move(parameters));
+  return output;
+}
+
+/// Two rows of four scores and an output that isn't transformed
+InferenceResponse makeResponse() {
+  std::vector<float> scores{0.1F, 0.7F, 0.2F, 0.0F, 0.5F, 0.1F, 0.1F, 0.3F};
+  InferenceResponse response;
+  InferenceResponseOutput output;
+  output.setName("scores");
+  output.setDatatype(DataType::Fp32);
+  output.setShape({2, 4});
+  std::vector<std::byte> buffer(scores.size() * sizeof(float));
+  std::memcpy(buffer.data(), scores.data(), buffer.size());
+  output.setData(std::move(buffer));
+  response.addOutput(output);
+  output.setName("other");
+  response.addOutput(output);
+  return response;
+}
+
+template <typename T>
+std::vector<T> getData(const InferenceResponseOutput& output) {
+  const auto* data = static_cast<const T*>(output.getData());
+  return {data, data + output.getSize()};
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitOutputTransforms, Parameters) {
+  InferenceRequest request;
+  ParameterMap parameters;
+  request.addOutputTensor(makeOutput("plain", parameters));
+  parameters.put(kOutputTopK, 2);
+  parameters.put(kOutputCast, "fp16");
+  request.addOutputTensor(makeOutput("scores", parameters));
+
+  const auto transforms = getOutputTransforms(request);
+  ASSERT_EQ(transforms.size(), 1);
+  EXPECT_EQ(transforms[0].name, "scores");
+  EXPECT_EQ(transforms[0].top_k, 2);
+  EXPECT_EQ(transforms[0].cast, DataType::Fp16);
+
+  // the index of argmax can't be cast or combined with top_k
+  parameters.put(kOutputArgmax, true);
+  InferenceRequest invalid;
+  invalid.addOutputTensor(makeOutput("scores", parameters));
+  EXPECT_THROW((void)getOutputTransforms(invalid), invalid_argument);
+
+  ParameterMap wrong_type;
+  wrong_type.put(kOutputTopK, "2");
+  InferenceRequest wrong;
+  wrong.addOutputTensor(makeOutput("scores", wrong_type));
+  EXPECT_THROW((void)getOutputTransforms(wrong), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitOutputTransforms, TopK) {
+  OutputTransform transform;
+  transform.name = "scores";
+  transform.top_k = 2;
+  const auto response = transformOutputs(makeResponse(), {transform});
+
+  const auto& outputs = response.getOutputs();
+  ASSERT_EQ(outputs.size(), 3);
+  EXPECT_EQ(outputs[0].getName(), "scores");
+  EXPECT_EQ(outputs[0].getShape(), (std::vector<int64_t>{2, 2}));
+  EXPECT_EQ(getData<float>(outputs[0]),
+            (std::vector<float>{0.7F, 0.2F, 0.5F, 0.3F}));
+  EXPECT_EQ(outputs[1].getName(), "scores_indices");
+  EXPECT_EQ(outputs[1].getDatatype(), DataType::Int32);
+  EXPECT_EQ(getData<int32_t>(outputs[1]),
+            (std::vector<int32_t>{1, 2, 0, 3}));
+  // outputs without a transform are kept
+  EXPECT_EQ(outputs[2].getName(), "other");
+  EXPECT_EQ(outputs[2].getSize(), 8);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitOutputTransforms, ArgmaxAndCast) {
+  OutputTransform argmax;
+  argmax.name = "scores";
+  argmax.argmax = true;
+  OutputTransform cast;
+  cast.name = "other";
+  cast.cast = DataType::Fp16;
+  const auto response = transformOutputs(makeResponse(), {argmax, cast});
+
+  const auto& outputs = response.getOutputs();
+  ASSERT_EQ(outputs.size(), 2);
+  EXPECT_EQ(outputs[0].getShape(), (std::vector<int64_t>{2}));
+  EXPECT_EQ(getData<int32_t>(outputs[0]), (std::vector<int32_t>{1, 0}));
+  EXPECT_EQ(outputs[1].getDatatype(), DataType::Fp16);
+  EXPECT_EQ(outputs[1].getShape(), (std::vector<int64_t>{2, 4}));
+  EXPECT_FLOAT_EQ(static_cast<float>(getData<fp16>(outputs[1]).at(4)), 0.5F);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitOutputTransforms, Callback) {
+  InferenceRequest request;
+  ParameterMap parameters;
+  parameters.put(kOutputArgmax, true);
+  request.addOutputTensor(makeOutput("scores", parameters));
+  InferenceResponse received;
+  request.setCallback(
+    [&received](const InferenceResponse& response) { received = response; });
+  holdOutputTransforms(&request);
+
+  request.runCallback(makeResponse());
+  ASSERT_EQ(received.getOutputs().size(), 2);
+  EXPECT_EQ(received.getOutputs()[0].getDatatype(), DataType::Int32);
+
+  // errors are passed on as they are
+  request.runCallbackError("failed");
+  EXPECT_TRUE(received.isError());
+  EXPECT_EQ(received.getError(), "failed");
+}
+
+}  // namespace amdinfer
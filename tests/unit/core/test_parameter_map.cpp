@@ -13,10 +13,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <array>    // for array
-#include <cstddef>  // for byte, size_t
-#include <string>   // for string, basic_string, alloc...
-#include <vector>   // for vector
+#include <array>       // for array
+#include <cstddef>     // for byte, size_t
+#include <cstdint>     // for int32_t
+#include <functional>  // for less
+#include <stdexcept>   // for out_of_range
+#include <string>      // for string, basic_string, alloc...
+#include <vector>      // for vector
 
 #include "amdinfer/core/parameters.hpp"  // for ParameterMap
 #include "amdinfer/testing/gtest.hpp"    // for EXPECT_THROW_CHECK
@@ -98,4 +101,40 @@ TEST(UnitParameterMap, InitializingConstructorConstChar) {
   EXPECT_EQ(model, "echo");
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitParameterMap, Sorted) {
+  ParameterMap params;
+  params.put("c", 3);
+  params.put("a", 1);
+  params.put("b", 2);
+  params.put("a", 4);
+  ASSERT_EQ(params.size(), 3);
+
+  std::string keys;
+  for (const auto& [key, value] : params) {
+    keys += key;
+  }
+  EXPECT_EQ(keys, "abc");
+  EXPECT_EQ(params.get<int32_t>("a"), 4);
+  EXPECT_THROW(params.get<int32_t>("d"), std::out_of_range);
+
+  params.rename("a", "d");
+  EXPECT_FALSE(params.has("a"));
+  EXPECT_EQ(params.get<int32_t>("d"), 4);
+  // renaming to an existing key keeps that key's value
+  params.rename("b", "c");
+  EXPECT_FALSE(params.has("b"));
+  EXPECT_EQ(params.get<int32_t>("c"), 3);
+
+  params.erase("c");
+  params.erase("missing");
+  EXPECT_EQ(params.size(), 1);
+
+  ParameterMap copy = params;
+  std::less<ParameterMap> less;
+  EXPECT_FALSE(less(params, copy));
+  copy.put("d", 5);
+  EXPECT_TRUE(less(params, copy));
+}
+
 }  // namespace amdinfer
@@ -0,0 +1,50 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>  // for uint8_t
+#include <string>   // for string
+
+#include "amdinfer/core/exceptions.hpp"  // for invalid_argument
+#include "amdinfer/core/rdma.hpp"        // for RdmaEndpoint
+#include "gtest/gtest.h"                 // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitRdma, EndpointRoundTrip) {
+  RdmaEndpoint endpoint;
+  endpoint.lid = 7;
+  endpoint.qpn = 0x123456;
+  endpoint.psn = 0xABCDEF;
+  for (auto i = 0U; i < endpoint.gid.size(); ++i) {
+    endpoint.gid.at(i) = static_cast<uint8_t>(i * 3);
+  }
+
+  const auto parsed = RdmaEndpoint::parse(endpoint.serialize());
+  EXPECT_EQ(parsed.lid, endpoint.lid);
+  EXPECT_EQ(parsed.qpn, endpoint.qpn);
+  EXPECT_EQ(parsed.psn, endpoint.psn);
+  EXPECT_EQ(parsed.gid, endpoint.gid);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitRdma, MalformedEndpoint) {
+  const auto bytes = RdmaEndpoint{}.serialize();
+  EXPECT_THROW(RdmaEndpoint::parse(bytes.substr(0, bytes.size() - 1)),
+               invalid_argument);
+  EXPECT_THROW(RdmaEndpoint::parse(bytes + "x"), invalid_argument);
+  EXPECT_THROW(RdmaEndpoint::parse(""), invalid_argument);
+}
+
+}  // namespace amdinfer
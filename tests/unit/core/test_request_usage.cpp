@@ -0,0 +1,86 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <chrono>  // for milliseconds, nanoseconds
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/request_usage.hpp"      // for RequestUsage
+#include "gtest/gtest.h"                        // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitRequestUsage, Meter) {
+  const UsageMeter meter;
+  countCopy(100);
+  countCopy(28);
+  EXPECT_EQ(meter.getCopiedBytes(), 128U);
+
+  // spin until the thread has used some CPU time
+  const auto start = getThreadCpuTime();
+  while (getThreadCpuTime() - start < milliseconds{1}) {
+  }
+  EXPECT_GE(meter.getCpuTime(), milliseconds{1});
+
+  const UsageMeter disabled{false};
+  countCopy(64);
+  EXPECT_FALSE(disabled.enabled());
+  EXPECT_EQ(disabled.getCopiedBytes(), 0U);
+  EXPECT_EQ(disabled.getCpuTime(), nanoseconds{0});
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitRequestUsage, Scope) {
+  RequestUsage usage{"model", "tenant"};
+  {
+    const UsageScope scope{&usage, RequestUsage::Batch};
+    countCopy(64);
+  }
+  EXPECT_EQ(usage.getCopiedBytes(RequestUsage::Batch), 64U);
+  EXPECT_EQ(usage.getCopiedBytes(RequestUsage::Decode), 0U);
+  EXPECT_EQ(usage.getCpuTime(RequestUsage::Decode), nanoseconds{0});
+
+  usage.add(RequestUsage::Compute, milliseconds{2}, 8);
+  usage.add(RequestUsage::Compute, milliseconds{1}, 8);
+  EXPECT_EQ(usage.getCpuTime(RequestUsage::Compute), milliseconds{3});
+  EXPECT_EQ(usage.getCopiedBytes(RequestUsage::Compute), 16U);
+
+  // scopes without usage measure nothing
+  const UsageScope scope{nullptr, RequestUsage::Encode};
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitRequestUsage, Start) {
+  InferenceRequest request;
+  EXPECT_EQ(startRequestUsage(&request, UsageMeter{false}, "model", ""),
+            nullptr);
+  EXPECT_EQ(request.getUsage(), nullptr);
+
+  const UsageMeter decoding;
+  countCopy(32);
+  auto usage = startRequestUsage(&request, decoding, "model", "");
+  ASSERT_NE(usage, nullptr);
+  EXPECT_EQ(request.getUsage(), usage.get());
+  EXPECT_EQ(usage->getCopiedBytes(RequestUsage::Decode), 32U);
+
+  // requests made for the next stage of a chain keep accounting to it
+  EXPECT_EQ(request.propagate()->getUsage(), usage.get());
+  InferenceRequest copy;
+  copy = request;
+  EXPECT_EQ(copy.getUsage(), nullptr);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,131 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for byte, size_t
+#include <cstdint>  // for int64_t
+#include <cstring>  // for memcpy, memcmp
+#include <limits>   // for numeric_limits
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/response_cache.hpp"      // for ResponseCache
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+namespace {
+
+InferenceRequest makeRequest(std::vector<float>* data) {
+  InferenceRequest request;
+  request.addInputTensor(data->data(), {static_cast<int64_t>(data->size())},
+                         DataType::Fp32, "input");
+  return request;
+}
+
+InferenceResponse makeResponse(const std::vector<float>& values) {
+  InferenceResponseOutput output;
+  output.setName("output");
+  output.setDatatype(DataType::Fp32);
+  output.setShape({static_cast<int64_t>(values.size())});
+  std::vector<std::byte> data(values.size() * sizeof(float));
+  std::memcpy(data.data(), values.data(), data.size());
+  output.setData(std::move(data));
+
+  InferenceResponse response;
+  response.setModel("model");
+  response.addOutput(std::move(output));
+  return response;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitResponseCache, Key) {
+  std::vector<float> data{1, 2, 3};
+  const auto key = ResponseCache::key(makeRequest(&data));
+  EXPECT_EQ(key, ResponseCache::key(makeRequest(&data)));
+
+  data[2] = 4;
+  EXPECT_NE(key, ResponseCache::key(makeRequest(&data)));
+  data[2] = 3;
+
+  auto request = makeRequest(&data);
+  request.addOutputTensor(InferenceRequestOutput{});
+  EXPECT_NE(key, ResponseCache::key(request));
+
+  request = makeRequest(&data);
+  request.setID("id");
+  EXPECT_EQ(key, ResponseCache::key(request));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitResponseCache, Hit) {
+  ResponseCache cache{1024};
+  EXPECT_FALSE(cache.lookup(1).has_value());
+
+  const std::vector<float> values{0.5F, 1.5F};
+  cache.insert(1, makeResponse(values));
+  cache.insert(2, InferenceResponse{"error"});
+  EXPECT_FALSE(cache.lookup(2).has_value());
+
+  auto response = cache.lookup(1);
+  ASSERT_TRUE(response.has_value());
+  EXPECT_EQ(response->getModel(), "model");
+  const auto& outputs = response->getOutputs();
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[0].getName(), "output");
+  EXPECT_EQ(outputs[0].getShape(), std::vector<int64_t>{2});
+  EXPECT_EQ(std::memcmp(outputs[0].getData(), values.data(),
+                        values.size() * sizeof(float)),
+            0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitResponseCache, Evict) {
+  const std::vector<float> values(16);
+  ResponseCache probe{std::numeric_limits<size_t>::max()};
+  probe.insert(0, makeResponse(values));
+  const auto item_size = probe.size();
+
+  // room for two items
+  ResponseCache cache{(2 * item_size) + 1};
+  cache.insert(1, makeResponse(values));
+  cache.insert(2, makeResponse(values));
+  // using the first item makes the second the least recently used
+  auto hit = cache.lookup(1);
+  ASSERT_TRUE(hit.has_value());
+  cache.insert(3, makeResponse(values));
+  EXPECT_EQ(cache.size(), 2 * item_size);
+  EXPECT_TRUE(cache.lookup(1).has_value());
+  EXPECT_FALSE(cache.lookup(2).has_value());
+  EXPECT_TRUE(cache.lookup(3).has_value());
+
+  // a hit's data stays valid after its item is evicted
+  cache.insert(4, makeResponse(values));
+  cache.insert(5, makeResponse(values));
+  EXPECT_FALSE(cache.lookup(1).has_value());
+  EXPECT_EQ(std::memcmp(hit->getOutputs()[0].getData(), values.data(),
+                        values.size() * sizeof(float)),
+            0);
+
+  // items larger than the budget aren't cached
+  ResponseCache small{item_size - 1};
+  small.insert(1, makeResponse(values));
+  EXPECT_EQ(small.size(), 0);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,83 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // for milliseconds
+#include <string>  // for string
+
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/parameters.hpp"         // for ParameterMap
+#include "amdinfer/core/server_timing.hpp"      // for ServerTiming
+#include "amdinfer/util/timestamps.hpp"         // for Timestamp, now
+#include "gtest/gtest.h"                        // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+using std::chrono::milliseconds;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitServerTiming, Stages) {
+  const util::Timestamp start{milliseconds{1000}};
+  ServerTiming timing;
+  timing.mark(ServerTiming::Received, start);
+  timing.mark(ServerTiming::Decoded, start + milliseconds{1});
+  timing.mark(ServerTiming::Batched, start + milliseconds{3});
+  timing.mark(ServerTiming::Dispatched, start + milliseconds{7});
+  timing.mark(ServerTiming::Started, start + milliseconds{8});
+  timing.mark(ServerTiming::Responded, start + milliseconds{18});
+  EXPECT_EQ(timing.str(),
+            "decode;dur=1.000, queue;dur=3.000, batch;dur=4.000, "
+            "compute;dur=10.000");
+
+  timing.mark(ServerTiming::Serialized, start + milliseconds{20});
+  EXPECT_EQ(timing.str(),
+            "decode;dur=1.000, queue;dur=3.000, batch;dur=4.000, "
+            "compute;dur=10.000, serialize;dur=2.000");
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitServerTiming, SkippedStages) {
+  // a cached response is never batched or computed
+  const util::Timestamp start{milliseconds{1000}};
+  ServerTiming timing;
+  timing.mark(ServerTiming::Received, start);
+  timing.mark(ServerTiming::Decoded, start + milliseconds{1});
+  timing.mark(ServerTiming::Responded, start + milliseconds{2});
+  timing.mark(ServerTiming::Serialized, start + milliseconds{4});
+  EXPECT_EQ(timing.str(), "decode;dur=1.000, serialize;dur=2.000");
+
+  EXPECT_EQ(ServerTiming{}.str(), "");
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitServerTiming, Start) {
+  const auto received = util::now();
+
+  InferenceRequest request;
+  EXPECT_EQ(startServerTiming(&request, received), nullptr);
+  EXPECT_EQ(request.getServerTiming(), nullptr);
+
+  ParameterMap parameters;
+  parameters.put("server_timing", false);
+  request.setParameters(parameters);
+  EXPECT_EQ(startServerTiming(&request, received), nullptr);
+
+  parameters.put("server_timing", true);
+  request.setParameters(parameters);
+  auto timing = startServerTiming(&request, received);
+  ASSERT_NE(timing, nullptr);
+  EXPECT_EQ(request.getServerTiming(), timing.get());
+  EXPECT_EQ(timing->str().rfind("decode;dur=", 0), 0U);
+}
+
+}  // namespace amdinfer
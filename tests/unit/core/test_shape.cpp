@@ -0,0 +1,86 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>    // for byte
+#include <cstdint>    // for int64_t
+#include <stdexcept>  // for out_of_range
+#include <utility>    // for move
+#include <vector>     // for vector
+
+#include "amdinfer/core/data_types.hpp"  // for DataType
+#include "amdinfer/core/shape.hpp"       // for Shape
+#include "amdinfer/core/tensor.hpp"      // for Tensor
+#include "gtest/gtest.h"                 // for Test, EXPECT_EQ, EXPECT_TRUE
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitShape, Inline) {
+  Shape shape{2, 3};
+  EXPECT_EQ(shape.size(), 2);
+  EXPECT_EQ(shape, (std::vector<int64_t>{2, 3}));
+
+  shape.push_back(4);
+  shape.back() = 5;
+  EXPECT_EQ(shape, (Shape{2, 3, 5}));
+  EXPECT_NE(shape, (Shape{2, 3}));
+
+  const std::vector<int64_t> vector = shape;
+  EXPECT_EQ(vector, (std::vector<int64_t>{2, 3, 5}));
+
+  Shape copy = shape;
+  copy[0] = 1;
+  EXPECT_EQ(shape[0], 2);
+  EXPECT_EQ(Shape(shape.begin() + 1, shape.end()), (Shape{3, 5}));
+  EXPECT_THROW(static_cast<void>(shape.at(3)), std::out_of_range);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitShape, Heap) {
+  Shape shape;
+  for (auto i = 0; i < 10; ++i) {
+    shape.push_back(i);
+  }
+  EXPECT_EQ(shape.size(), 10);
+  EXPECT_EQ(shape[9], 9);
+
+  // moving a shape empties it
+  auto moved = std::move(shape);
+  EXPECT_EQ(moved.size(), 10);
+  EXPECT_TRUE(shape.empty());  // NOLINT(bugprone-use-after-move)
+
+  // shrinking it keeps the leading dimensions
+  moved.resize(3);
+  EXPECT_EQ(moved, (Shape{0, 1, 2}));
+  moved.resize(Shape::kInlineDims + 1, 7);
+  EXPECT_EQ(moved[2], 2);
+  EXPECT_EQ(moved.back(), 7);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitShape, Tensor) {
+  Tensor tensor{"tensor", {2, 3}, DataType::Fp32};
+  EXPECT_EQ(tensor.getSize(), 6);
+
+  tensor.setShape(std::vector<int64_t>{4, 5});
+  EXPECT_EQ(tensor.getShape(), (std::vector<int64_t>{4, 5}));
+
+  std::vector<std::byte> data(tensor.serializeSize());
+  tensor.serialize(data.data());
+  Tensor copy{"", {}, DataType::Unknown};
+  copy.deserialize(data.data());
+  EXPECT_EQ(copy.getShape(), tensor.getShape());
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,179 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>  // for getpid
+
+#include <cstddef>  // for byte
+#include <cstring>  // for memcpy
+#include <string>   // for string, to_string
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"             // for DataType
+#include "amdinfer/core/exceptions.hpp"             // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"      // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"     // for InferenceResponse
+#include "amdinfer/core/memory_pool/pool.hpp"       // for MemoryPool
+#include "amdinfer/core/parameters.hpp"             // for ParameterMap
+#include "amdinfer/core/shared_memory.hpp"          // for SystemSharedMemory
+#include "amdinfer/core/shared_memory_regions.hpp"  // for SharedMemoryRegions
+#include "gtest/gtest.h"                            // for Test, EXPECT_EQ
+
+namespace amdinfer {
+
+namespace {
+
+std::string getKey(const std::string& name) {
+  // tests may run in parallel so the keys are unique to the process
+  return "/amdinfer_test_" + name + "_" + std::to_string(getpid());
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSharedMemory, Parameters) {
+  ParameterMap parameters;
+  EXPECT_FALSE(isInSharedMemory(parameters));
+  EXPECT_EQ(getSharedMemorySize(parameters, kSharedMemoryOffset), 0);
+
+  parameters.put(kSharedMemoryRegion, "input");
+  EXPECT_TRUE(isInSharedMemory(parameters));
+  setSharedMemorySize(&parameters, kSharedMemoryOffset, 64);
+  EXPECT_EQ(getSharedMemorySize(parameters, kSharedMemoryOffset), 64);
+  // values that don't fit in the integer parameters are kept exactly
+  const size_t large = (size_t{1} << 40) + 8;
+  setSharedMemorySize(&parameters, kSharedMemoryByteSize, large);
+  EXPECT_EQ(getSharedMemorySize(parameters, kSharedMemoryByteSize), large);
+
+  parameters.put(kSharedMemoryOffset, -1);
+  EXPECT_THROW((void)getSharedMemorySize(parameters, kSharedMemoryOffset),
+               invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSharedMemory, Regions) {
+  const auto key = getKey("regions");
+  const size_t size = 4096;
+  SystemSharedMemory memory{key, size};
+
+  SharedMemoryRegions regions;
+  regions.add("input", key, 0, size / 2);
+  regions.add("output", key, size / 2, size / 2);
+  EXPECT_THROW(regions.add("input", key, 0, size), invalid_argument);
+  // the region must fit in the object
+  EXPECT_THROW(regions.add("large", key, 0, size * 2), invalid_argument);
+  EXPECT_THROW(regions.add("missing", getKey("missing"), 0, size),
+               invalid_argument);
+
+  EXPECT_EQ(regions.status("").size(), 2);
+  const auto status = regions.status("output");
+  ASSERT_EQ(status.size(), 1);
+  EXPECT_EQ(status[0].key, key);
+  EXPECT_EQ(status[0].offset, size / 2);
+  EXPECT_EQ(status[0].byte_size, size / 2);
+
+  regions.remove("input");
+  EXPECT_THROW((void)regions.status("input"), invalid_argument);
+  EXPECT_THROW(regions.remove("input"), invalid_argument);
+  regions.remove("");
+  EXPECT_TRUE(regions.status("").empty());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSharedMemory, Infer) {
+  const auto key = getKey("infer");
+  const size_t size = 4096;
+  const size_t half = size / 2;
+  SystemSharedMemory memory{key, size};
+  const std::vector<float> values{1, 2, 3, 4};
+  std::memcpy(memory.data(), values.data(), values.size() * sizeof(float));
+
+  SharedMemoryRegions regions;
+  regions.add("input", key, 0, half);
+  regions.add("output", key, half, half);
+  MemoryPool pool;
+
+  InferenceRequest request;
+  InferenceRequestInput input;
+  input.setName("input");
+  input.setShape({4});
+  input.setDatatype(DataType::Fp32);
+  useSharedMemory(&input, "input");
+  request.addInputTensor(input);
+  InferenceRequestOutput output;
+  output.setName("output");
+  useSharedMemory(&output, "output", half);
+  request.addOutputTensor(output);
+
+  InferenceResponse written;
+  request.setCallback(
+    [&written](const InferenceResponse& response) { written = response; });
+  auto tensors = regions.map(&request, &pool);
+  ASSERT_EQ(tensors.inputs.size(), 1);
+  ASSERT_EQ(tensors.outputs.size(), 1);
+  const auto* data = static_cast<float*>(request.getInputs()[0].getData());
+  EXPECT_EQ(data[3], 4);
+  holdSharedMemory(&request, std::move(tensors));
+
+  // the mapping outlives unregistering the regions
+  regions.remove("");
+  InferenceResponse response;
+  InferenceResponseOutput result;
+  result.setName("output");
+  result.setShape({4});
+  result.setDatatype(DataType::Fp32);
+  std::vector<std::byte> bytes(values.size() * sizeof(float));
+  std::memcpy(bytes.data(), values.data(), bytes.size());
+  result.setData(std::move(bytes));
+  response.addOutput(result);
+  request.runCallbackOnce(response);
+
+  ASSERT_EQ(written.getOutputs().size(), 1);
+  const auto& placeholder = written.getOutputs()[0];
+  EXPECT_TRUE(isInSharedMemory(placeholder.getParameters()));
+  EXPECT_EQ(getSharedMemorySize(placeholder.getParameters(),
+                                kSharedMemoryByteSize),
+            values.size() * sizeof(float));
+  const auto* output_data =
+    reinterpret_cast<const float*>(memory.data() + half);
+  EXPECT_EQ(output_data[2], 3);
+  pool.put(MemoryAllocators::Cpu, request.getInputs()[0].getData());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSharedMemory, Invalid) {
+  const auto key = getKey("invalid");
+  SystemSharedMemory memory{key, 64};
+  SharedMemoryRegions regions;
+  regions.add("small", key, 0, 8);
+  MemoryPool pool;
+
+  InferenceRequest request;
+  InferenceRequestInput input;
+  input.setName("input");
+  input.setShape({4});
+  input.setDatatype(DataType::Fp32);
+  useSharedMemory(&input, "small");
+  request.addInputTensor(input);
+  // 16 bytes don't fit in the region and the request is left alone
+  EXPECT_THROW((void)regions.map(&request, &pool), invalid_argument);
+  EXPECT_EQ(request.getInputs()[0].getData(), nullptr);
+
+  useSharedMemory(&input, "missing");
+  InferenceRequest other;
+  other.addInputTensor(input);
+  EXPECT_THROW((void)regions.map(&other, &pool), invalid_argument);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,90 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>  // for string
+#include <vector>  // for vector
+
+#include "amdinfer/core/inference_request.hpp"   // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/core/single_flight.hpp"       // for SingleFlight
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+namespace {
+
+InferenceRequest makeRequest(const std::string& id,
+                             std::vector<std::string>* responses) {
+  InferenceRequest request;
+  request.setID(id);
+  request.setCallback([responses](const InferenceResponse& response) {
+    responses->push_back(response.getID() + ":" + response.getModel());
+  });
+  return request;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSingleFlight, Coalesce) {
+  SingleFlight flight;
+  std::vector<std::string> responses;
+
+  auto leader = makeRequest("a", &responses);
+  EXPECT_FALSE(flight.join(1, &leader));
+  auto follower = makeRequest("b", &responses);
+  EXPECT_TRUE(flight.join(1, &follower));
+  auto other = makeRequest("c", &responses);
+  EXPECT_TRUE(flight.join(1, &other));
+  // a different key leads its own flight
+  auto different = makeRequest("d", &responses);
+  EXPECT_FALSE(flight.join(2, &different));
+  EXPECT_EQ(flight.size(), 2);
+
+  InferenceResponse response;
+  response.setID("a");
+  response.setModel("model");
+  flight.land(1, response);
+  EXPECT_EQ(responses, (std::vector<std::string>{"b:model", "c:model"}));
+  EXPECT_EQ(flight.size(), 1);
+
+  // once a flight lands, the next identical request leads a new one
+  auto next = makeRequest("e", &responses);
+  EXPECT_FALSE(flight.join(1, &next));
+  flight.land(1, response);
+  flight.land(2, response);
+  EXPECT_EQ(responses.size(), 2);
+  EXPECT_EQ(flight.size(), 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSingleFlight, Error) {
+  SingleFlight flight;
+  std::vector<std::string> errors;
+
+  InferenceRequest leader;
+  EXPECT_FALSE(flight.join(1, &leader));
+  InferenceRequest follower;
+  follower.setCallback([&errors](const InferenceResponse& response) {
+    if (response.isError()) {
+      errors.push_back(response.getError());
+    }
+  });
+  EXPECT_TRUE(flight.join(1, &follower));
+
+  flight.land(1, InferenceResponse{"failed"});
+  EXPECT_EQ(errors, std::vector<std::string>{"failed"});
+}
+
+}  // namespace amdinfer
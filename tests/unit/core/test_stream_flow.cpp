@@ -0,0 +1,74 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>  // for atomic_bool
+#include <chrono>  // for milliseconds
+#include <thread>  // for thread, sleep_for
+
+#include "amdinfer/core/stream_flow.hpp"  // for StreamFlow
+#include "gtest/gtest.h"                  // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFlow, Drop) {
+  StreamFlow flow{2, StreamFlowPolicy::Drop};
+  EXPECT_TRUE(flow.acquire());
+  EXPECT_TRUE(flow.acquire());
+  EXPECT_FALSE(flow.acquire());
+  EXPECT_EQ(flow.getDropped(), 1);
+
+  // queueing the responses keeps their credits until they're written
+  flow.queue();
+  flow.queue();
+  EXPECT_FALSE(flow.acquire());
+  flow.release();
+  EXPECT_TRUE(flow.acquire());
+  EXPECT_EQ(flow.getDropped(), 2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFlow, Block) {
+  StreamFlow flow{1, StreamFlowPolicy::Block};
+  // responses queued without credits, like errors, count too
+  flow.queue();
+
+  std::atomic_bool acquired = false;
+  std::thread worker{[&] { acquired = flow.acquire(); }};
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(acquired);
+  flow.release();
+  worker.join();
+  EXPECT_TRUE(acquired);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFlow, Close) {
+  StreamFlow flow{1, StreamFlowPolicy::Block};
+  ASSERT_TRUE(flow.acquire());
+
+  std::thread worker{[&] { EXPECT_FALSE(flow.acquire()); }};
+  flow.close();
+  worker.join();
+  EXPECT_FALSE(flow.acquire());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFlow, Policy) {
+  EXPECT_EQ(parseStreamFlowPolicy("block"), StreamFlowPolicy::Block);
+  EXPECT_EQ(parseStreamFlowPolicy("drop"), StreamFlowPolicy::Drop);
+  EXPECT_FALSE(parseStreamFlowPolicy("wait").has_value());
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,91 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>  // for string
+
+#include "amdinfer/core/exceptions.hpp"    // for invalid_argument
+#include "amdinfer/core/stream_frame.hpp"  // for StreamFrame
+#include "amdinfer/testing/gtest.hpp"      // for EXPECT_THROW_CHECK
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFrame, RoundTrip) {
+  StreamFrame frame;
+  frame.key = "stream";
+  frame.index = 0x1'0000'0002;
+  frame.results = R"([{"label": "1"}])";
+  frame.format = StreamFrameFormat::Jpeg;
+  // JPEG data with a null byte and bytes above 0x7F
+  frame.data = std::string{"\xFF\xD8\x00\xFF\xD9", 5};
+
+  const auto message = serializeStreamFrame(frame);
+  // the header is followed by the variable-length fields
+  EXPECT_EQ(message.size(),
+            24 + frame.key.size() + frame.results.size() + frame.data.size());
+  EXPECT_EQ(message.substr(0, 4), "AMDF");
+
+  const auto parsed = parseStreamFrame(message);
+  EXPECT_EQ(parsed.key, frame.key);
+  EXPECT_EQ(parsed.index, frame.index);
+  EXPECT_EQ(parsed.results, frame.results);
+  EXPECT_EQ(parsed.format, frame.format);
+  EXPECT_EQ(parsed.data, frame.data);
+
+  // the image can be passed separately from the frame
+  StreamFrame header = frame;
+  header.data.clear();
+  EXPECT_EQ(serializeStreamFrame(header, frame.data), message);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFrame, Raw) {
+  StreamFrame frame;
+  frame.format = StreamFrameFormat::Bgr;
+  frame.width = 4;
+  frame.height = 2;
+  frame.data = std::string(4 * 2 * 3, '\x7F');
+
+  const auto parsed = parseStreamFrame(serializeStreamFrame(frame));
+  EXPECT_EQ(parsed.width, 4);
+  EXPECT_EQ(parsed.height, 2);
+  EXPECT_EQ(parsed.data, frame.data);
+
+  frame.data.pop_back();
+  const auto message = serializeStreamFrame(frame);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW_CHECK(
+    parseStreamFrame(message);
+    , EXPECT_STREQ(e.what(), "The size of the raw image doesn't match its shape"),
+    invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitStreamFrame, Invalid) {
+  StreamFrame frame;
+  frame.key = "stream";
+  frame.results = "[]";
+  const auto message = serializeStreamFrame(frame);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW_CHECK(parseStreamFrame(R"({"key": "stream"})");
+                     , EXPECT_STREQ(e.what(), "The message is not a stream frame"),
+                     invalid_argument);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto, hicpp-avoid-goto)
+  EXPECT_THROW_CHECK(parseStreamFrame(message.substr(0, message.size() - 1));
+                     , EXPECT_STREQ(e.what(), "The stream frame is truncated"),
+                     invalid_argument);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,128 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>  // for int64_t
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"         // for DataType
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/tensor.hpp"             // for Tensor
+#include "amdinfer/core/tensor_bindings.hpp"    // for TensorBindings
+#include "gtest/gtest.h"                        // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+namespace {
+
+TensorBindings makeBindings() {
+  return TensorBindings{{Tensor{"a", {2}, DataType::Fp32},
+                         Tensor{"b", {-1}, DataType::Uint8}}};
+}
+
+InferenceRequest makeRequest(const std::vector<std::string>& names,
+                             int64_t size = 1) {
+  InferenceRequest request;
+  for (const auto& name : names) {
+    request.addInputTensor(nullptr, {size}, DataType::Fp32, name);
+  }
+  return request;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTensorBindings, Table) {
+  const auto bindings = makeBindings();
+  ASSERT_EQ(bindings.size(), 2);
+  EXPECT_EQ(bindings.find("b"), 1);
+  EXPECT_EQ(bindings.find("c"), bindings.size());
+  EXPECT_EQ(bindings[0].bytes, 2 * sizeof(float));
+  // dynamic shapes have no fixed size
+  EXPECT_EQ(bindings[1].bytes, 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTensorBindings, BindByName) {
+  const auto bindings = makeBindings();
+  auto request = makeRequest({"b", "a"});
+  bindings.bind(&request);
+  const auto& inputs = request.getInputs();
+  EXPECT_EQ(inputs[0].getName(), "a");
+  EXPECT_EQ(inputs[1].getName(), "b");
+
+  auto missing = makeRequest({"b"});
+  EXPECT_THROW(bindings.bind(&missing), invalid_argument);
+  auto repeated = makeRequest({"a", "a"});
+  EXPECT_THROW(bindings.bind(&repeated), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTensorBindings, BindByPosition) {
+  const auto bindings = makeBindings();
+  auto request = makeRequest({"x", "y", "z"});
+  bindings.bind(&request);
+  const auto& inputs = request.getInputs();
+  EXPECT_EQ(inputs[0].getName(), "a");
+  EXPECT_EQ(inputs[1].getName(), "b");
+  // inputs past the model's inputs are left alone
+  EXPECT_EQ(inputs[2].getName(), "z");
+
+  auto large = makeRequest({"x"}, 3);
+  EXPECT_THROW(bindings.bind(&large), invalid_argument);
+
+  // models without inputs in their metadata accept any request
+  TensorBindings empty;
+  auto any = makeRequest({"x"}, 3);
+  EXPECT_NO_THROW(empty.bind(&any));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTensorBindings, Samples) {
+  const auto bindings = makeBindings();
+
+  InferenceRequest request;
+  request.addInputTensor(nullptr, {4, 2}, DataType::Fp32, "a");
+  request.addInputTensor(nullptr, {4, 3}, DataType::Uint8, "b");
+  // each sample is checked against the model's input
+  EXPECT_EQ(bindings.bind(&request), 4);
+
+  // the samples must agree across inputs
+  InferenceRequest mismatched;
+  mismatched.addInputTensor(nullptr, {4, 2}, DataType::Fp32, "a");
+  mismatched.addInputTensor(nullptr, {2, 3}, DataType::Uint8, "b");
+  EXPECT_THROW(bindings.bind(&mismatched), invalid_argument);
+
+  auto single = makeRequest({"a", "b"});
+  EXPECT_EQ(bindings.bind(&single), 1);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTensorBindings, UnboundSamples) {
+  // without the model's inputs, requests can't be split so they're kept
+  // whole and count as the size of their leading dimension
+  TensorBindings empty;
+  auto request = makeRequest({"x", "y"}, 8);
+  EXPECT_EQ(empty.bind(&request), 1);
+  EXPECT_EQ(empty.unboundSamples(request), 8);
+  EXPECT_EQ(empty.unboundSamples(makeRequest({"x"})), 1);
+  EXPECT_EQ(empty.unboundSamples(InferenceRequest{}), 1);
+
+  // bound requests are split by bind instead
+  const auto bindings = makeBindings();
+  EXPECT_EQ(bindings.unboundSamples(request), 1);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,132 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>      // for milliseconds
+#include <cstdint>     // for int32_t, uint8_t
+#include <filesystem>  // for path, temp_directory_path, remove
+#include <fstream>     // for ofstream
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "amdinfer/core/data_types.hpp"         // for DataType
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/traffic_trace.hpp"      // for TraceWriter, TraceR...
+#include "gtest/gtest.h"                        // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+namespace {
+
+InferenceRequest makeRequest(std::vector<uint8_t>* data) {
+  InferenceRequest request;
+  request.setID("id");
+  ParameterMap parameters;
+  parameters.put("priority", 1);
+  parameters.put("tenant", "a");
+  parameters.put("binary", true);
+  parameters.put("scale", 0.5);
+  request.setParameters(parameters);
+  request.addInputTensor(data->data(), {2, 3}, DataType::Uint8, "input");
+  InferenceRequestOutput output;
+  output.setName("output");
+  request.addOutputTensor(output);
+  return request;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTrafficTrace, RoundTrip) {
+  const auto path =
+    std::filesystem::temp_directory_path() / "amdinfer_test_trace.bin";
+  std::vector<uint8_t> data{0, 1, 2, 3, 4, 5};
+  auto request = makeRequest(&data);
+  {
+    TraceWriter writer{path, true};
+    writer.write(std::chrono::milliseconds(5), "model", "2", request);
+    // strided inputs are written densely
+    request.transposeInputTensor(0, {1, 0});
+    writer.write(std::chrono::milliseconds(7), "echo", "", request);
+  }
+
+  TraceReader reader{path};
+  TraceRecord record;
+  ASSERT_TRUE(reader.read(&record));
+  EXPECT_EQ(record.time, std::chrono::milliseconds(5));
+  EXPECT_EQ(record.model, "model");
+  EXPECT_EQ(record.version, "2");
+  EXPECT_TRUE(record.payload);
+  EXPECT_EQ(record.request.getID(), "id");
+  const auto& parameters = record.request.getParameters();
+  EXPECT_EQ(parameters.get<int32_t>("priority"), 1);
+  EXPECT_EQ(parameters.get<std::string>("tenant"), "a");
+  EXPECT_TRUE(parameters.get<bool>("binary"));
+  EXPECT_EQ(parameters.get<double>("scale"), 0.5);
+  ASSERT_EQ(record.request.getInputSize(), 1);
+  const auto& input = record.request.getInputs()[0];
+  EXPECT_EQ(input.getName(), "input");
+  EXPECT_EQ(input.getShape(), (Shape{2, 3}));
+  EXPECT_EQ(input.getDatatype(), DataType::Uint8);
+  const auto* values = static_cast<uint8_t*>(input.getData());
+  EXPECT_EQ(std::vector<uint8_t>(values, values + 6), data);
+  ASSERT_EQ(record.request.getOutputs().size(), 1);
+  EXPECT_EQ(record.request.getOutputs()[0].getName(), "output");
+
+  ASSERT_TRUE(reader.read(&record));
+  EXPECT_EQ(record.model, "echo");
+  EXPECT_TRUE(record.version.empty());
+  const auto& transposed = record.request.getInputs()[0];
+  EXPECT_EQ(transposed.getShape(), (Shape{3, 2}));
+  values = static_cast<uint8_t*>(transposed.getData());
+  EXPECT_EQ(std::vector<uint8_t>(values, values + 6),
+            (std::vector<uint8_t>{0, 3, 1, 4, 2, 5}));
+  EXPECT_FALSE(reader.read(&record));
+
+  std::filesystem::remove(path);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTrafficTrace, Shapes) {
+  const auto path =
+    std::filesystem::temp_directory_path() / "amdinfer_test_trace.bin";
+  std::vector<uint8_t> data{0, 1, 2, 3, 4, 5};
+  {
+    TraceWriter writer{path, false};
+    writer.write(std::chrono::milliseconds(1), "model", "", makeRequest(&data));
+  }
+
+  // inputs captured without their data are replayed with zeros
+  TraceReader reader{path};
+  TraceRecord record;
+  ASSERT_TRUE(reader.read(&record));
+  EXPECT_FALSE(record.payload);
+  const auto& input = record.request.getInputs()[0];
+  EXPECT_EQ(input.getShape(), (Shape{2, 3}));
+  const auto* values = static_cast<uint8_t*>(input.getData());
+  EXPECT_EQ(std::vector<uint8_t>(values, values + 6),
+            std::vector<uint8_t>(6, 0));
+  EXPECT_FALSE(reader.read(&record));
+
+  // a truncated record is an error
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  TraceReader truncated{path};
+  EXPECT_THROW(truncated.read(&record), invalid_argument);
+
+  std::ofstream{path} << "not a trace";
+  EXPECT_THROW(TraceReader{path}, invalid_argument);
+  std::filesystem::remove(path);
+}
+
+}  // namespace amdinfer
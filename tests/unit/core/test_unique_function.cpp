@@ -0,0 +1,65 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>    // for array
+#include <memory>   // for unique_ptr, make_unique, shared_ptr
+#include <utility>  // for move
+
+#include "amdinfer/core/unique_function.hpp"  // for UniqueFunction
+#include "gtest/gtest.h"                      // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUniqueFunction, MoveOnly) {
+  UniqueFunction<int(int)> empty = nullptr;
+  EXPECT_TRUE(empty == nullptr);
+
+  auto value = std::make_unique<int>(2);
+  UniqueFunction<int(int)> function = [value = std::move(value)](int x) {
+    return *value * x;
+  };
+  EXPECT_TRUE(function != nullptr);
+  EXPECT_EQ(function(3), 6);
+
+  auto moved = std::move(function);
+  EXPECT_TRUE(function == nullptr);  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(moved(4), 8);
+
+  moved = nullptr;
+  EXPECT_FALSE(moved);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUniqueFunction, Storage) {
+  using Function = UniqueFunction<void(), 16>;
+  auto small = [ptr = std::shared_ptr<int>()] {};
+  auto large = [array = std::array<char, 64>{}] {};
+  EXPECT_TRUE(Function::storedInline<decltype(small)>());
+  EXPECT_FALSE(Function::storedInline<decltype(large)>());
+
+  // callables are destroyed once whether they're stored inline or not
+  auto counter = std::make_shared<int>();
+  {
+    Function inline_function = [counter] {};
+    Function heap_function = [counter, array = std::array<char, 64>{}] {};
+    EXPECT_EQ(counter.use_count(), 3);
+    auto moved_inline = std::move(inline_function);
+    auto moved_heap = std::move(heap_function);
+    EXPECT_EQ(counter.use_count(), 3);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,126 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>    // for milliseconds
+#include <cstddef>   // for size_t
+#include <limits>    // for numeric_limits
+#include <optional>  // for optional
+#include <string>    // for string
+#include <thread>    // for thread
+#include <vector>    // for vector
+
+#include "amdinfer/observation/metrics.hpp"  // for ModelMetrics, Metrics
+#include "gtest/gtest.h"                     // for Test, EXPECT_NE, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitMetrics, ModelLabels) {
+  auto& metrics = Metrics::getInstance();
+  {
+    std::optional<ModelMetrics> model;
+    model.emplace("metrics_test", "1", "echo");
+    model->incrementCounter(MetricCounterIDs::PipelineIngressWorker, 2);
+    model->observeHistogram(MetricHistogramIDs::RequestLatency, 1);
+    model->observeDuration(MetricHistogramIDs::StageCompute,
+                           std::chrono::milliseconds(2));
+    // metrics that aren't tracked per model are ignored
+    model->incrementCounter(MetricCounterIDs::RestGet);
+
+    // series with the same labels are shared until neither model uses them
+    ModelMetrics other{"metrics_test", "1", "echo"};
+    model.reset();
+
+    const auto text = metrics.getMetrics();
+    // labels are printed in alphabetical order
+    EXPECT_NE(text.find(R"(amdinfer_pipeline_ingress_total{)"
+                        R"(model="metrics_test",stage="worker",version="1",)"
+                        R"(worker="echo"} 2)"),
+              std::string::npos);
+    EXPECT_NE(text.find(R"(amdinfer_request_latency_count{)"
+                        R"(model="metrics_test",version="1",worker="echo"} 1)"),
+              std::string::npos);
+    // stages are recorded in microseconds
+    EXPECT_NE(text.find(R"(amdinfer_stage_latency_sum{)"
+                        R"(model="metrics_test",stage="compute",version="1",)"
+                        R"(worker="echo"} 2000)"),
+              std::string::npos);
+  }
+
+  // the series are removed with the last model that uses them
+  EXPECT_EQ(metrics.getMetrics().find(R"(model="metrics_test")"),
+            std::string::npos);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitMetrics, Histogram) {
+  const auto bounds = exponentialBuckets(1, 2, 3);
+  ASSERT_EQ(bounds, std::vector<double>({1, 2, 4}));
+  Histogram histogram{&bounds};
+
+  // observations from many threads land in different shards
+  const auto threads = 2 * kHistogramShards;
+  std::vector<std::thread> observers;
+  for (auto i = 0U; i < threads; ++i) {
+    observers.emplace_back([&histogram]() {
+      for (const auto value : {0.5, 1.0, 3.0, 8.0}) {
+        histogram.observe(value);
+      }
+    });
+  }
+  for (auto& observer : observers) {
+    observer.join();
+  }
+
+  const auto collected = histogram.collect();
+  EXPECT_EQ(collected.sample_count, 4 * threads);
+  EXPECT_DOUBLE_EQ(collected.sample_sum, 12.5 * threads);
+  ASSERT_EQ(collected.bucket.size(), 4);
+  const std::vector<size_t> counts{2, 2, 3, 4};
+  for (auto i = 0U; i < counts.size(); ++i) {
+    EXPECT_EQ(collected.bucket[i].cumulative_count, counts[i] * threads);
+  }
+  EXPECT_EQ(collected.bucket[3].upper_bound,
+            std::numeric_limits<double>::infinity());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitMetrics, Counter) {
+  Counter counter;
+
+  // increments from many threads land in different shards
+  const auto threads = 2 * kCounterShards;
+  const auto increments = 1000;
+  std::vector<std::thread> incrementers;
+  for (auto i = 0U; i < threads; ++i) {
+    incrementers.emplace_back([&counter]() {
+      for (auto j = 0; j < increments; ++j) {
+        counter.increment();
+      }
+      counter.increment(2);
+    });
+  }
+  for (auto& incrementer : incrementers) {
+    incrementer.join();
+  }
+
+  EXPECT_EQ(counter.value(), (increments + 2) * threads);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitMetrics, LinearBuckets) {
+  EXPECT_EQ(linearBuckets(1, 2, 3), std::vector<double>({1, 3, 5}));
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,79 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for size_t
+#include <string>   // for string
+#include <thread>   // for thread
+#include <tuple>    // for ignore
+
+#include "amdinfer/core/exceptions.hpp"        // for invalid_argument
+#include "amdinfer/observation/profiling.hpp"  // for startProfiling, ...
+#include "amdinfer/util/thread.hpp"            // for setThreadName
+#include "gtest/gtest.h"                       // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+size_t countOf(const std::string& str, const std::string& substr) {
+  size_t count = 0;
+  for (auto pos = str.find(substr); pos != std::string::npos;
+       pos = str.find(substr, pos + substr.size())) {
+    ++count;
+  }
+  return count;
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitProfiling, Events) {
+  // events aren't recorded unless profiling is on
+  { ProfileScope scope{"before", "test"}; }
+
+  startProfiling();
+  EXPECT_THROW(startProfiling(), invalid_argument);
+  std::thread thread{[]() {
+    util::setThreadName("profiled");
+    ProfileScope scope{"thread", "test"};
+  }};
+  thread.join();
+  { ProfileScope scope{"main", "test"}; }
+  const auto json = stopProfiling();
+  EXPECT_THROW(std::ignore = stopProfiling(), invalid_argument);
+
+  EXPECT_EQ(countOf(json, R"("name":"before")"), 0);
+  EXPECT_EQ(countOf(json, R"("name":"main")"), 1);
+  EXPECT_EQ(countOf(json, R"("name":"thread")"), 1);
+  EXPECT_EQ(countOf(json, R"("args":{"name":"profiled"})"), 1);
+  EXPECT_EQ(json.rfind(R"({"displayTimeUnit":"ms","traceEvents":[)", 0), 0);
+
+  // events from a previous profile aren't kept
+  startProfiling();
+  EXPECT_EQ(countOf(stopProfiling(), R"("name":"main")"), 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitProfiling, Wrap) {
+  startProfiling();
+  const auto extra = 10;
+  const auto start = ProfileClock::now();
+  profileEvent("oldest", "test", start, start);
+  for (auto i = 0U; i < kProfileEventsPerThread + extra; ++i) {
+    profileEvent("event", "test", start, start);
+  }
+  const auto json = stopProfiling();
+
+  // the oldest events are replaced once the ring buffer is full
+  EXPECT_EQ(countOf(json, R"("name":"oldest")"), 0);
+  EXPECT_EQ(countOf(json, R"("name":"event")"), kProfileEventsPerThread);
+}
+
+}  // namespace amdinfer
@@ -12,8 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
 #include <optional>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "amdinfer/observation/tracing.hpp"  // for tracing
 #include "gtest/gtest.h"                     // for Message, TestPartResult, ...
@@ -150,6 +153,63 @@ TEST(UnitTracing, AutoDestroy) {
 
   stopTracer();
 }
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTracing, Sampling) {
+  std::stringstream ss;
+
+  startOStreamTracer(ss);
+
+  // unsampled requests have no trace
+  setTraceSampling(0);
+  EXPECT_EQ(startTrace("test"), nullptr);
+  EXPECT_EQ(startBatchSpan("batch", {}), nullptr);
+
+  setTraceSampling(1);
+  std::vector<TracePtr> traces;
+  traces.push_back(startTrace("first"));
+  traces.push_back(nullptr);
+  traces.push_back(startTrace("second"));
+  ASSERT_NE(traces[0], nullptr);
+
+  // one span is made for the batch
+  auto span = startBatchSpan("batch", traces);
+  ASSERT_NE(span, nullptr);
+  span->End();
+  auto maybe_span = readStream(ss);
+  ASSERT_TRUE(maybe_span);
+  EXPECT_EQ(maybe_span.value().name, "batch");
+
+  stopTracer();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTracing, Batched) {
+  std::stringstream ss;
+
+  TraceExportOptions options;
+  options.max_queue_size = 2;
+  options.flush_interval = std::chrono::minutes{1};
+  startOStreamTracer(ss, options);
+
+  // spans wait in the queue and the ones that don't fit are dropped
+  const auto dropped = getDroppedSpans();
+  for (auto i = 0; i < 5; ++i) {
+    startTrace("test")->endTrace();
+  }
+  EXPECT_EQ(getDroppedSpans() - dropped, 3U);
+  EXPECT_TRUE(ss.str().empty());
+
+  // stopping exports the queued spans
+  stopTracer();
+  const auto output = ss.str();
+  size_t spans = 0;
+  for (auto i = output.find("trace_id"); i != std::string::npos;
+       i = output.find("trace_id", i + 1)) {
+    spans++;
+  }
+  EXPECT_EQ(spans, 2U);
+}
 #endif
 
 }  // namespace amdinfer
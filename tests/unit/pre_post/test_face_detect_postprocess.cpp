@@ -0,0 +1,142 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>    // for exp
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t
+#include <random>   // for mt19937, normal_distribution
+#include <vector>   // for vector
+
+#include "amdinfer/pre_post/face_detect_postprocess.hpp"  // for decodeFace...
+#include "gtest/gtest.h"  // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer::pre_post {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitFaceDetectPostprocess, DecodeMatchesReference) {
+  FaceDetectOptions options;
+  options.box_scale = 0.5F;
+  const int height = 12;
+  const int width = 20;
+  const auto cells = height * width;
+  const auto net_height = static_cast<float>(height * options.step);
+  const auto net_width = static_cast<float>(width * options.step);
+
+  std::mt19937 generator{1};
+  std::normal_distribution<float> distribution{0, 2};
+  std::vector<float> scores(static_cast<size_t>(cells) * 2);
+  std::vector<float> offsets(static_cast<size_t>(cells) * 4);
+  for (auto* values : {&scores, &offsets}) {
+    for (auto& value : *values) {
+      value = distribution(generator);
+    }
+  }
+
+  std::vector<uint32_t> buffer;
+  YoloBoxes boxes;
+  decodeFaceDetect(scores.data(), offsets.data(), height, width, options,
+                   &buffer, &boxes);
+
+  // the face probability is the softmax of the two logits of each cell
+  YoloBoxes gold;
+  for (auto cell = 0; cell < cells; ++cell) {
+    const auto background = std::exp(scores[2 * cell]);
+    const auto face = std::exp(scores[2 * cell + 1]);
+    const auto probability = face / (background + face);
+    if (probability > options.conf_threshold) {
+      const auto x = static_cast<float>(cell % width * options.step);
+      const auto y = static_cast<float>(cell / width * options.step);
+      const auto* offset = offsets.data() + 4 * cell;
+      gold.addCorners((offset[0] * options.box_scale + x) / net_width,
+                      (offset[1] * options.box_scale + y) / net_height,
+                      (offset[2] * options.box_scale + x) / net_width,
+                      (offset[3] * options.box_scale + y) / net_height,
+                      probability, 0);
+    }
+  }
+
+  ASSERT_GT(gold.size(), 0);
+  ASSERT_EQ(boxes.size(), gold.size());
+  for (auto i = 0U; i < gold.size(); ++i) {
+    EXPECT_FLOAT_EQ(boxes.score[i], gold.score[i]);
+    EXPECT_FLOAT_EQ(boxes.x1[i], gold.x1[i]);
+    EXPECT_FLOAT_EQ(boxes.y1[i], gold.y1[i]);
+    EXPECT_FLOAT_EQ(boxes.x2[i], gold.x2[i]);
+    EXPECT_FLOAT_EQ(boxes.y2[i], gold.y2[i]);
+  }
+
+  // the same values in NCHW give the same boxes
+  auto nchw_options = options;
+  nchw_options.layout = YoloLayout::NCHW;
+  std::vector<float> nchw_scores(scores.size());
+  std::vector<float> nchw_offsets(offsets.size());
+  for (auto cell = 0; cell < cells; ++cell) {
+    for (auto k = 0; k < 2; ++k) {
+      nchw_scores[k * cells + cell] = scores[2 * cell + k];
+    }
+    for (auto k = 0; k < 4; ++k) {
+      nchw_offsets[k * cells + cell] = offsets[4 * cell + k];
+    }
+  }
+  YoloBoxes nchw_boxes;
+  decodeFaceDetect(nchw_scores.data(), nchw_offsets.data(), height, width,
+                   nchw_options, &buffer, &nchw_boxes);
+  EXPECT_EQ(nchw_boxes.score, boxes.score);
+  EXPECT_EQ(nchw_boxes.x1, boxes.x1);
+  EXPECT_EQ(nchw_boxes.y2, boxes.y2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitFaceDetectPostprocess, Crowd) {
+  FaceDetectOptions options;
+  const int height = 8;
+  const int width = 8;
+  const auto cells = height * width;
+  std::vector<float> scores(static_cast<size_t>(cells) * 2, 0.0F);
+  std::vector<float> offsets(static_cast<size_t>(cells) * 4, 0.0F);
+
+  // a face centered on each of two cells that neighbouring cells also find
+  const auto add = [&](int row, int column, float logit) {
+    for (auto dy = -1; dy <= 1; ++dy) {
+      for (auto dx = -1; dx <= 1; ++dx) {
+        const auto cell = (row + dy) * width + column + dx;
+        const auto distance = static_cast<float>(dx * dx + dy * dy);
+        scores[2 * cell + 1] = logit - 2 * distance;
+        // each cell points to the same box
+        offsets[4 * cell] = static_cast<float>(-dx * options.step - 6);
+        offsets[4 * cell + 1] = static_cast<float>(-dy * options.step - 6);
+        offsets[4 * cell + 2] = static_cast<float>(-dx * options.step + 6);
+        offsets[4 * cell + 3] = static_cast<float>(-dy * options.step + 6);
+      }
+    }
+  };
+  add(2, 2, 5);
+  add(5, 5, 2.5F);
+
+  std::vector<uint32_t> buffer;
+  YoloBoxes boxes;
+  decodeFaceDetect(scores.data(), offsets.data(), height, width, options,
+                   &buffer, &boxes);
+  // logits over about 0.85 pass the default threshold: all the cells of the
+  // first face and the center of the second
+  EXPECT_EQ(boxes.size(), 10);
+
+  const auto kept = nonMaximumSuppression(boxes, options.iou_threshold);
+  ASSERT_EQ(kept.size(), 2);
+  EXPECT_GT(boxes.score[kept[0]], boxes.score[kept[1]]);
+  EXPECT_FLOAT_EQ(boxes.x1[kept[0]], 2.0F / 32);
+  EXPECT_FLOAT_EQ(boxes.x1[kept[1]], 14.0F / 32);
+}
+
+}  // namespace amdinfer::pre_post
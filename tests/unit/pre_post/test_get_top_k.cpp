@@ -0,0 +1,63 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>  // for stable_sort
+#include <cstddef>    // for size_t
+#include <numeric>    // for iota
+#include <random>     // for mt19937, uniform_int_distribution
+#include <vector>     // for vector
+
+#include "amdinfer/pre_post/get_top_k.hpp"  // for getTopK
+#include "gtest/gtest.h"                    // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer::pre_post {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitGetTopK, BatchMatchesSort) {
+  const size_t batch = 4;
+  const size_t size = 1000;
+  const size_t k = 5;
+
+  // a small range of values so there are many ties
+  std::mt19937 generator{1};
+  std::uniform_int_distribution<int> distribution{0, 100};
+  std::vector<float> data(batch * size);
+  for (auto& value : data) {
+    value = static_cast<float>(distribution(generator));
+  }
+
+  std::vector<int> indices(batch * k);
+  getTopK(data.data(), batch, size, k, indices.data());
+
+  for (auto row = 0U; row < batch; ++row) {
+    const auto* values = data.data() + row * size;
+    std::vector<int> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return values[a] > values[b]; });
+    for (auto i = 0U; i < k; ++i) {
+      EXPECT_EQ(indices[row * k + i], order[i]);
+    }
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitGetTopK, KLargerThanSize) {
+  const std::vector<double> data{0.1, 0.7, 0.2};
+  const std::vector<int> gold{1, 2, 0};
+  EXPECT_EQ(getTopK(data.data(), data.size(), 5), gold);
+  EXPECT_TRUE(getTopK(data.data(), data.size(), 0).empty());
+}
+
+}  // namespace amdinfer::pre_post
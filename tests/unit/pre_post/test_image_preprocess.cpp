@@ -0,0 +1,120 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>              // for max_element
+#include <cstddef>                // for size_t
+#include <opencv2/core.hpp>       // for Mat, randu, CV_8UC3, CV_32FC3
+#include <opencv2/imgproc.hpp>    // for COLOR_BGR2RGB
+#include <tuple>                  // for tuple
+#include <vector>                 // for vector
+
+#include "amdinfer/pre_post/image_preprocess.hpp"  // for imagePreprocess
+#include "amdinfer/pre_post/yolo_postprocess.hpp"  // for correctLetterbox
+#include "gtest/gtest.h"                        // for TestWithParam, ValuesIn
+
+namespace amdinfer::pre_post {
+
+// source height, source width, output height, output width, layout, swap
+using Params = std::tuple<int, int, int, int, ImageOrder, bool>;
+
+class UnitImagePreprocess : public testing::TestWithParam<Params> {};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_P(UnitImagePreprocess, FusedMatchesReference) {
+  const auto [src_height, src_width, height, width, order, swap] = GetParam();
+
+  cv::Mat img{src_height, src_width, CV_8UC3};
+  cv::randu(img, 0, 256);
+
+  const auto kScale = 1.0 / 255;
+  ImagePreprocessOptions<float, 3> options;
+  options.height = height;
+  options.width = width;
+  options.convert_color = swap;
+  options.color_code = cv::COLOR_BGR2RGB;
+  options.convert_type = true;
+  options.type = CV_32FC3;
+  options.convert_scale = kScale;
+  options.normalize = true;
+  options.order = order;
+  options.mean = {0.485F, 0.456F, 0.406F};
+  options.std = {4.367F, 4.464F, 4.444F};
+  ASSERT_TRUE(detail::canFuse(img, options));
+
+  const auto size = static_cast<size_t>(height) * width * 3;
+  std::vector<float> fused(size);
+  std::vector<float> reference(size);
+  imagePreprocess(img, options, fused.data());
+  detail::preprocessReference(img, options, reference.data());
+
+  // the reference rounds the resized image to 8 bits, the fused path doesn't
+  const auto* max_std = std::max_element(options.std.begin(), options.std.end());
+  const auto tolerance = static_cast<float>(kScale) * *max_std;
+  for (auto i = 0U; i < size; ++i) {
+    EXPECT_NEAR(fused[i], reference[i], tolerance) << "at index " << i;
+  }
+}
+
+const std::vector<Params> kParams{
+  {37, 53, 224, 224, ImageOrder::NCHW, true},
+  {37, 53, 224, 224, ImageOrder::NHWC, false},
+  {300, 400, 224, 224, ImageOrder::NCHW, false},
+  {300, 400, 224, 224, ImageOrder::NHWC, true},
+  {5, 7, 3, 2, ImageOrder::NCHW, true},
+};
+
+INSTANTIATE_TEST_SUITE_P(Shapes, UnitImagePreprocess,
+                         testing::ValuesIn(kParams));
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitImagePreprocessLetterbox, MatchesCorrectLetterbox) {
+  const cv::Mat img{100, 200, CV_8UC3, cv::Scalar::all(255)};
+  const auto kSize = 64;
+  const auto kPad = 128;
+
+  ImagePreprocessOptions<float, 3> options;
+  options.height = kSize;
+  options.width = kSize;
+  options.resize_algorithm = ResizeAlgorithm::LetterBoxCrop;
+  options.pad_value = kPad;
+  options.convert_type = true;
+  options.type = CV_32FC3;
+  options.convert_scale = 1.0;
+  options.normalize = true;
+  options.order = ImageOrder::NCHW;
+  options.mean = {0, 0, 0};
+  options.std = {1, 1, 1};
+
+  std::vector<float> output(kSize * kSize * 3);
+  imagePreprocess(img, options, output.data());
+  // the image is scaled to 64x32 and centered between 16 rows of padding
+  const auto top = 16;
+  const auto bottom = 48;
+  for (auto y = 0; y < kSize; ++y) {
+    const auto expected = y >= top && y < bottom ? 255.0F : kPad;
+    EXPECT_FLOAT_EQ(output[y * kSize + kSize / 2], expected) << "at row " << y;
+  }
+
+  // a box around the image in the network input covers the whole image
+  YoloBoxes boxes;
+  boxes.add(0.5F, 0.5F, 1.0F, static_cast<float>(bottom - top) / kSize, 1.0F,
+            0);
+  correctLetterbox(&boxes, img.rows, img.cols, kSize, kSize);
+  EXPECT_FLOAT_EQ(boxes.x1[0], 0.0F);
+  EXPECT_FLOAT_EQ(boxes.y1[0], 0.0F);
+  EXPECT_FLOAT_EQ(boxes.x2[0], 1.0F);
+  EXPECT_FLOAT_EQ(boxes.y2[0], 1.0F);
+}
+
+}  // namespace amdinfer::pre_post
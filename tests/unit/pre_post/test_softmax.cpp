@@ -0,0 +1,88 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for int8_t
+#include <limits>   // for numeric_limits
+#include <random>   // for mt19937, normal_distribution
+#include <vector>   // for vector
+
+#include "amdinfer/pre_post/softmax.hpp"  // for calcSoftmax
+#include "gtest/gtest.h"                  // for Test, EXPECT_NEAR, TestWi...
+
+namespace amdinfer::pre_post {
+
+class UnitSoftmax : public testing::TestWithParam<size_t> {};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_P(UnitSoftmax, BatchMatchesReference) {
+  const auto size = GetParam();
+  const size_t batch = 3;
+  const auto kStd = 4.0F;
+
+  std::mt19937 generator{1};
+  std::normal_distribution<float> distribution{0, kStd};
+  std::vector<float> data(batch * size);
+  for (auto& value : data) {
+    value = distribution(generator);
+  }
+
+  std::vector<float> result(data.size());
+  calcSoftmax(data.data(), batch, size, result.data());
+
+  std::vector<double> reference(size);
+  for (auto row = 0U; row < batch; ++row) {
+    calcSoftmax(data.data() + row * size, size, reference.data());
+    for (auto i = 0U; i < size; ++i) {
+      EXPECT_NEAR(result[row * size + i], reference[i], reference[i] * 1e-5);
+    }
+  }
+}
+
+const std::vector<size_t> kSizes{1, 15, 1000, 21843};
+
+// NOLINTNEXTLINE(cert-err58-cpp)
+INSTANTIATE_TEST_SUITE_P(Sizes, UnitSoftmax, testing::ValuesIn(kSizes));
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftmax, InPlace) {
+  std::vector<float> data{1, 2, 3, 4};
+  std::vector<double> reference(data.size());
+  calcSoftmax(data.data(), data.size(), reference.data());
+
+  calcSoftmax(data.data(), 1, data.size(), data.data());
+  for (auto i = 0U; i < data.size(); ++i) {
+    EXPECT_NEAR(data[i], reference[i], reference[i] * 1e-5);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSoftmax, ExtremeValues) {
+  const std::vector<int8_t> data{-128, 127, 0};
+  std::vector<float> result(data.size());
+  calcSoftmax(data.data(), 1, data.size(), result.data());
+  // differences below -87 are clamped so the results stay normal floats
+  const auto kTiny = 1e-37F;
+  EXPECT_FLOAT_EQ(result[1], 1.0F);
+  EXPECT_LT(result[0], kTiny);
+  EXPECT_LT(result[2], kTiny);
+
+  const std::vector<float> infinite{-std::numeric_limits<float>::infinity(),
+                                    0};
+  calcSoftmax(infinite.data(), 1, infinite.size(), result.data());
+  EXPECT_FLOAT_EQ(result[1], 1.0F);
+  EXPECT_LT(result[0], kTiny);
+}
+
+}  // namespace amdinfer::pre_post
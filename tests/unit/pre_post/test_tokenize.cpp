@@ -0,0 +1,82 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>      // for int32_t
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/core/exceptions.hpp"     // for invalid_argument
+#include "amdinfer/pre_post/tokenize.hpp"  // for WordPieceTokenizer
+#include "gtest/gtest.h"                    // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer::pre_post {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTokenize, Vocabulary) {
+  const Vocabulary vocabulary{"[PAD]\r\n[UNK]\nhello\nhello\nworld"};
+  EXPECT_EQ(vocabulary.size(), 5);
+  EXPECT_EQ(vocabulary.find("[UNK]"), 1);
+  EXPECT_EQ(vocabulary.find("hello"), 2);
+  EXPECT_EQ(vocabulary.find("world"), 4);
+  EXPECT_EQ(vocabulary.find("missing"), -1);
+  EXPECT_THROW((void)vocabulary.at("missing"), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTokenize, WordPiece) {
+  const Vocabulary vocabulary{
+    "[PAD]\n[UNK]\nthe\nun\n##aff\n##able\n,\n!\n\xC3\xA9t\xC3\xA9\n"};
+  const WordPieceTokenizer tokenizer{&vocabulary, "[UNK]", true};
+  EXPECT_EQ(tokenizer.getUnknownId(), 1);
+
+  Tokenizer::State state;
+  std::vector<int32_t> ids;
+  tokenizer.encode("The unaffable,  unknown!", &state, &ids);
+  EXPECT_EQ(ids, (std::vector<int32_t>{2, 3, 4, 5, 6, 1, 7}));
+
+  // multi-byte characters are kept whole and aren't lower-cased
+  ids.clear();
+  tokenizer.encode("\xC3\xA9t\xC3\xA9 \xC3\x89t\xC3\xA9", &state, &ids);
+  EXPECT_EQ(ids, (std::vector<int32_t>{8, 1}));
+
+  const WordPieceTokenizer cased{&vocabulary, "[UNK]", false};
+  ids.clear();
+  cased.encode("The the", &state, &ids);
+  EXPECT_EQ(ids, (std::vector<int32_t>{1, 2}));
+
+  EXPECT_THROW(WordPieceTokenizer(&vocabulary, "<unk>", true),
+               invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitTokenize, Bpe) {
+  const Vocabulary vocabulary{"<unk>\nl\no\nw</w>\nlo\nlow</w>\ner</w>\nr</w>"};
+  const std::string_view merges{"#version: 0.2\nl o\nlo w</w>\ne r</w>\n"};
+  const BpeTokenizer tokenizer{&vocabulary, merges, "<unk>", false, "</w>"};
+
+  Tokenizer::State state;
+  std::vector<int32_t> ids;
+  tokenizer.encode("low lower", &state, &ids);
+  // "lower" ends up as "lo w e r</w>" and then "lo w er</w>"
+  EXPECT_EQ(ids, (std::vector<int32_t>{5, 4, 0, 6}));
+
+  ids.clear();
+  tokenizer.encode("r", &state, &ids);
+  EXPECT_EQ(ids, (std::vector<int32_t>{7}));
+
+  EXPECT_THROW(BpeTokenizer(&vocabulary, "lo", "<unk>", false),
+               invalid_argument);
+}
+
+}  // namespace amdinfer::pre_post
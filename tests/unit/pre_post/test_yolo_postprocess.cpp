@@ -0,0 +1,181 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>  // for max, min, stable_sort
+#include <cmath>      // for exp
+#include <cstddef>    // for size_t
+#include <numeric>    // for iota
+#include <random>     // for mt19937, normal_distribution
+#include <vector>     // for vector
+
+#include "amdinfer/pre_post/yolo_postprocess.hpp"  // for decodeYolo
+#include "gtest/gtest.h"  // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer::pre_post {
+
+namespace {
+
+float sigmoid(float x) { return 1.0F / (1.0F + std::exp(-x)); }
+
+YoloOptions getOptions() {
+  YoloOptions options;
+  options.classes = 4;
+  options.anchors = 2;
+  options.biases = {10, 14, 23, 27};
+  options.net_height = 64;
+  options.net_width = 64;
+  options.conf_threshold = 0.3F;
+  return options;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitYoloPostprocess, DecodeMatchesReference) {
+  const auto options = getOptions();
+  const int height = 8;
+  const int width = 8;
+  const auto cells = height * width;
+  const auto attributes = 5 + options.classes;
+
+  std::mt19937 generator{1};
+  std::normal_distribution<float> distribution{0, 2};
+  std::vector<float> data(static_cast<size_t>(cells) * attributes *
+                          options.anchors);
+  for (auto& value : data) {
+    value = distribution(generator);
+  }
+
+  YoloBoxes boxes;
+  decodeYolo(data.data(), height, width, 0, options, &boxes);
+
+  YoloBoxes gold;
+  for (auto anchor = 0; anchor < options.anchors; ++anchor) {
+    const auto* values = data.data() + anchor * attributes * cells;
+    for (auto cell = 0; cell < cells; ++cell) {
+      const auto obj = sigmoid(values[4 * cells + cell]);
+      const auto x = (cell % width + sigmoid(values[cell])) / width;
+      const auto y = (cell / width + sigmoid(values[cells + cell])) / height;
+      const auto w = std::exp(values[2 * cells + cell]) *
+                     options.biases[2 * anchor] / options.net_width;
+      const auto h = std::exp(values[3 * cells + cell]) *
+                     options.biases[2 * anchor + 1] / options.net_height;
+      for (auto i = 0; i < options.classes; ++i) {
+        const auto probability = obj * sigmoid(values[(5 + i) * cells + cell]);
+        if (probability > options.conf_threshold) {
+          gold.add(x, y, w, h, probability, i);
+        }
+      }
+    }
+  }
+
+  ASSERT_GT(gold.size(), 0);
+  ASSERT_EQ(boxes.size(), gold.size());
+  for (auto i = 0U; i < gold.size(); ++i) {
+    EXPECT_EQ(boxes.label[i], gold.label[i]);
+    EXPECT_FLOAT_EQ(boxes.score[i], gold.score[i]);
+    EXPECT_FLOAT_EQ(boxes.x1[i], gold.x1[i]);
+    EXPECT_FLOAT_EQ(boxes.y2[i], gold.y2[i]);
+  }
+
+  // the same values in NHWC give the same boxes
+  auto nhwc_options = options;
+  nhwc_options.layout = YoloLayout::NHWC;
+  std::vector<float> nhwc(data.size());
+  for (auto anchor = 0; anchor < options.anchors; ++anchor) {
+    for (auto k = 0; k < attributes; ++k) {
+      for (auto cell = 0; cell < cells; ++cell) {
+        nhwc[(cell * options.anchors + anchor) * attributes + k] =
+          data[(anchor * attributes + k) * cells + cell];
+      }
+    }
+  }
+  YoloBoxes nhwc_boxes;
+  decodeYolo(nhwc.data(), height, width, 0, nhwc_options, &nhwc_boxes);
+  ASSERT_EQ(nhwc_boxes.size(), boxes.size());
+  // the boxes are decoded in a different order
+  auto sorted = [](const YoloBoxes& unsorted) {
+    std::vector<float> scores = unsorted.score;
+    std::sort(scores.begin(), scores.end());
+    return scores;
+  };
+  EXPECT_EQ(sorted(nhwc_boxes), sorted(boxes));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitYoloPostprocess, NmsMatchesReference) {
+  const float threshold = 0.45F;
+  std::mt19937 generator{2};
+  std::uniform_real_distribution<float> position{0, 1};
+  std::uniform_real_distribution<float> size{0.05F, 0.3F};
+  std::uniform_int_distribution<int> label{0, 2};
+
+  YoloBoxes boxes;
+  for (auto i = 0; i < 500; ++i) {
+    boxes.add(position(generator), position(generator), size(generator),
+              size(generator), position(generator), label(generator));
+  }
+
+  const auto kept = nonMaximumSuppression(boxes, threshold);
+
+  // pairwise suppression of the boxes of each class from the best
+  std::vector<size_t> order(boxes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return boxes.score[a] > boxes.score[b];
+  });
+  auto iou = [&](size_t a, size_t b) {
+    const auto w = std::min(boxes.x2[a], boxes.x2[b]) -
+                   std::max(boxes.x1[a], boxes.x1[b]);
+    const auto h = std::min(boxes.y2[a], boxes.y2[b]) -
+                   std::max(boxes.y1[a], boxes.y1[b]);
+    if (w <= 0 || h <= 0) {
+      return 0.0F;
+    }
+    const auto area = [&](size_t i) {
+      return (boxes.x2[i] - boxes.x1[i]) * (boxes.y2[i] - boxes.y1[i]);
+    };
+    return w * h / (area(a) + area(b) - w * h);
+  };
+  std::vector<size_t> gold;
+  for (auto index : order) {
+    const bool suppressed =
+      std::any_of(gold.begin(), gold.end(), [&](size_t better) {
+        return boxes.label[better] == boxes.label[index] &&
+               iou(better, index) >= threshold;
+      });
+    if (!suppressed) {
+      gold.push_back(index);
+    }
+  }
+
+  EXPECT_LT(kept.size(), boxes.size());
+  EXPECT_EQ(kept, gold);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitYoloPostprocess, Letterbox) {
+  YoloBoxes boxes;
+  // a box covering the middle half of a 64x64 input
+  boxes.add(0.5F, 0.5F, 0.5F, 0.5F, 1.0F, 0);
+
+  // a 128x64 image fills the width and is padded by 16 rows on each side
+  correctLetterbox(&boxes, 64, 128, 64, 64);
+  EXPECT_FLOAT_EQ(boxes.x1[0], 0.25F);
+  EXPECT_FLOAT_EQ(boxes.x2[0], 0.75F);
+  EXPECT_FLOAT_EQ(boxes.y1[0], 0.0F);
+  EXPECT_FLOAT_EQ(boxes.y2[0], 1.0F);
+}
+
+}  // namespace amdinfer::pre_post
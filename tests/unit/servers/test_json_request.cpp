@@ -0,0 +1,137 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>        // for array
+#include <cstdint>      // for int32_t, uint8_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "amdinfer/core/data_types.hpp"         // for DataType
+#include "amdinfer/core/exceptions.hpp"         // for invalid_argument
+#include "amdinfer/core/inference_request.hpp"  // for InferenceRequest
+#include "amdinfer/core/memory_pool/pool.hpp"   // for MemoryPool
+#include "amdinfer/servers/json_request.hpp"    // for parseJsonRequest, ...
+#include "gtest/gtest.h"                        // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitJsonRequest, Parse) {
+  MemoryPool pool;
+  const std::string json = R"({
+    "id": "abc",
+    "parameters": {"timeout": 10, "flag": true},
+    "inputs": [
+      {"name": "a", "shape": [2, 2], "datatype": "INT32",
+       "data": [[1, -2], [3, 4]]},
+      {"data": [0.5, 1e1], "name": "b", "datatype": "FP32", "shape": [2]},
+      {"name": "c", "shape": [5], "datatype": "BYTES", "data": ["hi\n"]}
+    ],
+    "outputs": [{"name": "out", "parameters": {"binary_data": true}}]
+  })";
+
+  auto request = parseJsonRequest(json, &pool);
+  EXPECT_EQ(request->getID(), "abc");
+  EXPECT_EQ(request->getParameters().get<int32_t>("timeout"), 10);
+  EXPECT_TRUE(request->getParameters().get<bool>("flag"));
+
+  const auto& inputs = request->getInputs();
+  ASSERT_EQ(inputs.size(), 3);
+  EXPECT_EQ(inputs[0].getDatatype(), DataType::Int32);
+  const auto* a = static_cast<int32_t*>(inputs[0].getData());
+  EXPECT_EQ(a[0], 1);
+  EXPECT_EQ(a[1], -2);
+  EXPECT_EQ(a[3], 4);
+  const auto* b = static_cast<float*>(inputs[1].getData());
+  EXPECT_FLOAT_EQ(b[0], 0.5F);
+  EXPECT_FLOAT_EQ(b[1], 10.0F);
+  const auto* c = static_cast<char*>(inputs[2].getData());
+  EXPECT_EQ(std::string_view(c, 3), "hi\n");
+
+  const auto& outputs = request->getOutputs();
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[0].getName(), "out");
+  EXPECT_TRUE(outputs[0].getParameters().get<bool>("binary_data"));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitJsonRequest, Binary) {
+  MemoryPool pool;
+  const std::string json = R"({"inputs": [{"name": "a", "shape": [3],
+    "datatype": "UINT8", "parameters": {"binary_data_size": 3}}]})";
+  const std::array<char, 3> binary{1, 2, 3};
+
+  auto request = parseJsonRequest(json, &pool, {binary.data(), binary.size()});
+  const auto* a = static_cast<uint8_t*>(request->getInputs()[0].getData());
+  EXPECT_EQ(a[0], 1);
+  EXPECT_EQ(a[2], 3);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitJsonRequest, Invalid) {
+  MemoryPool pool;
+  const auto input = [](const std::string& data) {
+    return R"({"inputs": [{"name": "a", "shape": [2], "datatype": "UINT8",
+      "data": )" +
+           data + "}]}";
+  };
+
+  EXPECT_NO_THROW(parseJsonRequest(input("[1, 2]"), &pool));
+  // wrong number of elements
+  EXPECT_THROW(parseJsonRequest(input("[1]"), &pool), invalid_argument);
+  EXPECT_THROW(parseJsonRequest(input("[1, 2, 3]"), &pool), invalid_argument);
+  // out of range for the datatype
+  EXPECT_THROW(parseJsonRequest(input("[1, 256]"), &pool), invalid_argument);
+  EXPECT_THROW(parseJsonRequest(input("[1, -1]"), &pool), invalid_argument);
+  // malformed JSON
+  EXPECT_THROW(parseJsonRequest(input("[1, 2"), &pool), invalid_argument);
+  EXPECT_THROW(parseJsonRequest(R"({"id": "a"})", &pool), invalid_argument);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitJsonRequest, ParseMany) {
+  MemoryPool pool;
+  const std::string json = R"({"requests": [
+    {"model_name": "a", "id": "1", "inputs": [{"name": "x", "shape": [1],
+      "datatype": "UINT8", "parameters": {"binary_data_size": 1}}]},
+    {"model_name": "b", "model_version": "2", "inputs": [{"name": "y",
+      "shape": [2], "datatype": "UINT8", "data": [4, 5]}]}
+  ]})";
+  const std::array<char, 1> binary{3};
+
+  const auto requests =
+    parseJsonRequests(json, &pool, {binary.data(), binary.size()});
+  ASSERT_EQ(requests.size(), 2);
+  EXPECT_EQ(requests[0].model, "a");
+  EXPECT_EQ(requests[0].version, "");
+  EXPECT_EQ(requests[0].request->getID(), "1");
+  const auto* x =
+    static_cast<uint8_t*>(requests[0].request->getInputs()[0].getData());
+  EXPECT_EQ(x[0], 3);
+  EXPECT_EQ(requests[1].model, "b");
+  EXPECT_EQ(requests[1].version, "2");
+  const auto* y =
+    static_cast<uint8_t*>(requests[1].request->getInputs()[0].getData());
+  EXPECT_EQ(y[1], 5);
+  EXPECT_GT(requests[1].bytes, 0);
+
+  EXPECT_TRUE(parseJsonRequests(R"({"requests": []})", &pool).empty());
+  // every request needs a model
+  EXPECT_THROW(parseJsonRequests(R"({"requests": [{"inputs": []}]})", &pool),
+               invalid_argument);
+  EXPECT_THROW(parseJsonRequests(R"({"inputs": []})", &pool),
+               invalid_argument);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,125 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <json/reader.h>  // for CharReaderBuilder
+#include <json/value.h>   // for Value
+
+#include <cstddef>  // for byte, size_t
+#include <cstdint>  // for int32_t
+#include <cstring>  // for memcpy
+#include <limits>   // for numeric_limits
+#include <memory>   // for unique_ptr
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"          // for DataType
+#include "amdinfer/core/inference_response.hpp"  // for InferenceResponse
+#include "amdinfer/servers/json_response.hpp"    // for serializeJsonResponse
+#include "gtest/gtest.h"                         // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+template <typename T>
+InferenceResponseOutput makeOutput(const std::string& name,
+                                   const std::vector<T>& values,
+                                   DataType datatype) {
+  InferenceResponseOutput output;
+  output.setName(name);
+  output.setDatatype(datatype);
+  output.setShape({static_cast<int64_t>(values.size())});
+  std::vector<std::byte> data(values.size() * sizeof(T));
+  std::memcpy(data.data(), values.data(), data.size());
+  output.setData(std::move(data));
+  return output;
+}
+
+Json::Value parse(const std::string& body, size_t length) {
+  Json::Value root;
+  std::string errors;
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
+  EXPECT_TRUE(
+    reader->parse(body.data(), body.data() + length, &root, &errors));
+  return root;
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitJsonResponse, Serialize) {
+  InferenceResponse response;
+  response.setModel("model");
+  response.setID("\"id\"\n");
+  const std::vector<float> floats{0.1F, -2.5F,
+                                  std::numeric_limits<float>::max()};
+  response.addOutput(makeOutput("floats", floats, DataType::Fp32));
+  const std::vector<int32_t> ints{-1, 0, std::numeric_limits<int32_t>::max()};
+  response.addOutput(makeOutput("ints", ints, DataType::Int32));
+  const std::string str = "hello";
+  response.addOutput(makeOutput(
+    "str", std::vector<char>{str.begin(), str.end()}, DataType::Bytes));
+
+  size_t length = 0;
+  const auto body = serializeJsonResponse(response, {}, &length);
+  EXPECT_EQ(length, body.size());
+
+  auto json = parse(body, length);
+  EXPECT_EQ(json["model_name"].asString(), "model");
+  EXPECT_EQ(json["id"].asString(), "\"id\"\n");
+  const auto& outputs = json["outputs"];
+  ASSERT_EQ(outputs.size(), 3);
+  EXPECT_EQ(outputs[0]["name"].asString(), "floats");
+  EXPECT_EQ(outputs[0]["datatype"].asString(), "FP32");
+  EXPECT_EQ(outputs[0]["shape"][0].asInt(), 3);
+  for (auto i = 0U; i < floats.size(); ++i) {
+    EXPECT_EQ(outputs[0]["data"][i].asFloat(), floats[i]);
+  }
+  for (auto i = 0U; i < ints.size(); ++i) {
+    EXPECT_EQ(outputs[1]["data"][i].asInt(), ints[i]);
+  }
+  EXPECT_EQ(outputs[2]["data"][0].asString(), str);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitJsonResponse, Binary) {
+  InferenceResponse response;
+  const std::vector<int32_t> ints{1, 2, 3};
+  response.addOutput(makeOutput("a", ints, DataType::Int32));
+  response.addOutput(makeOutput("b", ints, DataType::Int32));
+
+  BinaryOutputs binary_outputs;
+  binary_outputs.names.insert("b");
+  size_t length = 0;
+  const auto body = serializeJsonResponse(response, binary_outputs, &length);
+  const auto size = ints.size() * sizeof(int32_t);
+  ASSERT_EQ(body.size(), length + size);
+
+  auto json = parse(body, length);
+  EXPECT_EQ(json["outputs"][0]["data"].size(), ints.size());
+  EXPECT_FALSE(json["outputs"][1].isMember("data"));
+  EXPECT_EQ(json["outputs"][1]["parameters"]["binary_data_size"].asUInt(),
+            size);
+  EXPECT_EQ(std::memcmp(body.data() + length, ints.data(), size), 0);
+
+  // with binary_data_output, every output is sent as raw bytes in order
+  binary_outputs.all = true;
+  const auto all = serializeJsonResponse(response, binary_outputs, &length);
+  ASSERT_EQ(all.size(), length + (2 * size));
+  json = parse(all, length);
+  for (const auto& output : json["outputs"]) {
+    EXPECT_FALSE(output.isMember("data"));
+    EXPECT_EQ(output["parameters"]["binary_data_size"].asUInt(), size);
+  }
+  EXPECT_EQ(std::memcmp(all.data() + length + size, ints.data(), size), 0);
+}
+
+}  // namespace amdinfer
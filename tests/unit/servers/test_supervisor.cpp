@@ -0,0 +1,79 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>  // for string
+#include <vector>  // for vector
+
+#include "amdinfer/servers/supervisor.hpp"  // for getShare, mergeMetrics
+#include "gtest/gtest.h"                    // for Test, EXPECT_EQ, TEST
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSupervisor, Share) {
+  const std::vector<int> cpus{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  EXPECT_EQ(getShare(cpus, 0, 3), (std::vector{0, 1, 2, 3}));
+  EXPECT_EQ(getShare(cpus, 1, 3), (std::vector{4, 5, 6}));
+  EXPECT_EQ(getShare(cpus, 2, 3), (std::vector{7, 8, 9}));
+  EXPECT_EQ(getShare(cpus, 0, 1), cpus);
+
+  // with fewer IDs than shards, the shards share them
+  const std::vector<int> gpus{0, 1};
+  EXPECT_EQ(getShare(gpus, 2, 4), std::vector{0});
+  EXPECT_EQ(getShare(gpus, 3, 4), std::vector{1});
+  EXPECT_TRUE(getShare({}, 0, 2).empty());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitSupervisor, MergeMetrics) {
+  const std::string first =
+    "# HELP requests_total Number of requests\n"
+    "# TYPE requests_total counter\n"
+    "requests_total{type=\"rest\"} 2\n"
+    "requests_total{type=\"grpc\"} 1\n"
+    "# HELP latency Latency\n"
+    "# TYPE latency summary\n"
+    "latency_count{model=\"a b}\"} 3\n"
+    "latency{model=\"a b}\",quantile=\"0.5\"} 10\n"
+    "latency{model=\"a b}\",quantile=\"0.9\"} NaN\n";
+  const std::string second =
+    "# HELP requests_total Number of requests\n"
+    "# TYPE requests_total counter\n"
+    "requests_total{type=\"rest\"} 5 1700000000000\n"
+    "# HELP latency Latency\n"
+    "# TYPE latency summary\n"
+    "latency_count{model=\"a b}\"} 1\n"
+    "latency{model=\"a b}\",quantile=\"0.5\"} 4\n"
+    "latency{model=\"a b}\",quantile=\"0.9\"} 20.5\n"
+    "# HELP queue Queued requests\n"
+    "# TYPE queue gauge\n"
+    "queue 1.5\n";
+
+  EXPECT_EQ(mergeMetrics({first, second}),
+            "# HELP requests_total Number of requests\n"
+            "# TYPE requests_total counter\n"
+            "requests_total{type=\"rest\"} 7\n"
+            "requests_total{type=\"grpc\"} 1\n"
+            "# HELP latency Latency\n"
+            "# TYPE latency summary\n"
+            "latency_count{model=\"a b}\"} 4\n"
+            "latency{model=\"a b}\",quantile=\"0.5\"} 10\n"
+            "latency{model=\"a b}\",quantile=\"0.9\"} 20.5\n"
+            "# HELP queue Queued requests\n"
+            "# TYPE queue gauge\n"
+            "queue 1.5\n");
+  EXPECT_EQ(mergeMetrics({first}), mergeMetrics({first, ""}));
+}
+
+}  // namespace amdinfer
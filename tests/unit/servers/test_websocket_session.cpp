@@ -0,0 +1,148 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>      // for byte
+#include <cstring>      // for memcpy
+#include <memory>       // for make_shared
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "amdinfer/core/exceptions.hpp"            // for runtime_error
+#include "amdinfer/core/inference_request.hpp"     // for InferenceRequest
+#include "amdinfer/core/inference_response.hpp"    // for InferenceResponse
+#include "amdinfer/core/request_container.hpp"     // for makeRequestContainer
+#include "amdinfer/core/stream_flow.hpp"           // for StreamFlow
+#include "amdinfer/servers/websocket_session.hpp"  // for WebsocketSession
+#include "gtest/gtest.h"                           // for Test, EXPECT_EQ
+
+namespace amdinfer::http {
+
+class UnitWebsocketSession : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    session_ = std::make_shared<WebsocketSession>(
+      [this](std::string_view message, bool binary) {
+        EXPECT_FALSE(binary);
+        sent_.emplace_back(message);
+      },
+      2);
+  }
+
+  /// Submit a request and keep it, as the model would, once it's dispatched
+  InferenceRequestPtr submit() {
+    auto container = makeRequestContainer();
+    container->request = std::make_shared<InferenceRequest>();
+    auto request = container->request;
+    session_->submit(std::move(container),
+                     [this](RequestContainerPtr dispatched) {
+                       dispatched_.push_back(dispatched->request);
+                     });
+    return request;
+  }
+
+  static InferenceResponse makeResponse(const std::string& message) {
+    InferenceResponseOutput output;
+    std::vector<std::byte> data(message.size());
+    std::memcpy(data.data(), message.data(), message.size());
+    output.setData(std::move(data));
+    output.setShape({static_cast<int64_t>(message.size())});
+    InferenceResponse response;
+    response.addOutput(output);
+    return response;
+  }
+
+  std::shared_ptr<WebsocketSession> session_;
+  std::vector<std::string> sent_;
+  std::vector<InferenceRequestPtr> dispatched_;
+};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitWebsocketSession, Sequence) {
+  const auto first = this->submit();
+  const auto second = this->submit();
+  const auto& parameters = first->getParameters();
+  EXPECT_EQ(parameters.get<std::string>("sequence_id"), session_->getId());
+  EXPECT_TRUE(parameters.get<bool>("sequence_start"));
+  EXPECT_FALSE(second->getParameters().has("sequence_start"));
+  EXPECT_FALSE(first->isCancelled());
+
+  session_->close();
+  EXPECT_TRUE(first->isCancelled());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitWebsocketSession, Window) {
+  for (auto i = 0; i < 3; ++i) {
+    this->submit();
+  }
+  // the third request waits for room in the window
+  ASSERT_EQ(dispatched_.size(), 2);
+
+  // responses are sent in the order of their requests
+  dispatched_[1]->runCallback(makeResponse("b"));
+  EXPECT_TRUE(sent_.empty());
+  EXPECT_EQ(dispatched_.size(), 2);
+  dispatched_[0]->runCallback(makeResponse("a"));
+  EXPECT_EQ(sent_, (std::vector<std::string>{"a", "b"}));
+  ASSERT_EQ(dispatched_.size(), 3);
+
+  dispatched_[2]->runCallbackError("error");
+  EXPECT_EQ(sent_.back(), "error");
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitWebsocketSession, Refused) {
+  auto container = makeRequestContainer();
+  container->request = std::make_shared<InferenceRequest>();
+  session_->submit(std::move(container), [](RequestContainerPtr) {
+    throw runtime_error("refused");
+  });
+  EXPECT_EQ(sent_, std::vector<std::string>{"refused"});
+
+  // the refused request doesn't hold a place in the window
+  this->submit();
+  this->submit();
+  EXPECT_EQ(dispatched_.size(), 2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitWebsocketSession, Credits) {
+  session_ = std::make_shared<WebsocketSession>(
+    [this](std::string_view message, bool) { sent_.emplace_back(message); },
+    2, std::make_shared<StreamFlow>(2, StreamFlowPolicy::Drop));
+  const auto request = this->submit();
+  ASSERT_EQ(dispatched_.size(), 1);
+
+  // a streaming worker sends frames while the client has credits
+  for (const auto* frame : {"a", "b", "c"}) {
+    if (request->acquireStreamCredit()) {
+      request->runCallback(makeResponse(frame));
+    }
+  }
+  EXPECT_EQ(sent_, (std::vector<std::string>{"a", "b"}));
+
+  session_->grant(1);
+  ASSERT_TRUE(request->acquireStreamCredit());
+  request->runCallback(makeResponse("d"));
+  EXPECT_EQ(sent_.back(), "d");
+  EXPECT_FALSE(request->acquireStreamCredit());
+
+  // workers stop waiting for credits once the client is gone
+  session_->close();
+  session_->grant(2);
+  EXPECT_FALSE(request->acquireStreamCredit());
+}
+
+}  // namespace amdinfer::http
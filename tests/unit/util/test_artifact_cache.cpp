@@ -0,0 +1,100 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <filesystem>  // for path, temp_directory_path, remove_all
+#include <fstream>     // for ofstream
+#include <string>      // for string
+
+#include "amdinfer/core/exceptions.hpp"      // for file_read_error
+#include "amdinfer/util/artifact_cache.hpp"  // for ArtifactKey
+#include "gtest/gtest.h"                     // for Test, EXPECT_EQ, EXPECT_NE
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+class UnitUtilArtifactCache : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = util::getTemporaryPath(fs::temp_directory_path() /
+                                        "amdinfer_artifact_cache");
+    fs::create_directories(directory_);
+  }
+
+  void TearDown() override { fs::remove_all(directory_); }
+
+  [[nodiscard]] fs::path write(const std::string& name,
+                               const std::string& contents) const {
+    auto path = directory_ / name;
+    std::ofstream{path, std::ios::binary} << contents;
+    return path;
+  }
+
+  [[nodiscard]] static std::string getKey(const fs::path& model,
+                                          const std::string& target) {
+    util::ArtifactKey key{"backend"};
+    key.addFile(model);
+    key.add("target", target);
+    return key.str();
+  }
+
+  fs::path directory_;
+};
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitUtilArtifactCache, Keys) {
+  const auto model = this->write("model.onnx", "weights");
+  const auto copy = this->write("copy.onnx", "weights");
+  const auto other = this->write("other.onnx", "other weights");
+
+  // the key depends on the contents and not on where the model is
+  EXPECT_EQ(getKey(model, "gfx90a"), getKey(copy, "gfx90a"));
+  EXPECT_EQ(getKey(model, "gfx90a").size(), 16U);
+  EXPECT_NE(getKey(model, "gfx90a"), getKey(other, "gfx90a"));
+  EXPECT_NE(getKey(model, "gfx90a"), getKey(model, "gfx1100"));
+
+  util::ArtifactKey key{"other_backend"};
+  key.addFile(model);
+  key.add("target", "gfx90a");
+  EXPECT_NE(key.str(), getKey(model, "gfx90a"));
+
+  EXPECT_THROW(getKey(directory_ / "missing.onnx", "gfx90a"), file_read_error);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST_F(UnitUtilArtifactCache, Publish) {
+  const auto model = this->write("model.onnx", "weights");
+  util::ArtifactKey key{"backend"};
+  key.addFile(model);
+
+  const auto cache = directory_ / "cache";
+  const auto path = key.getPath(cache, ".mxr");
+  EXPECT_EQ(path.parent_path(), cache / "backend");
+  EXPECT_EQ(path.extension(), ".mxr");
+  EXPECT_TRUE(fs::is_directory(cache / "backend"));
+
+  const auto temporary = util::getTemporaryPath(path);
+  EXPECT_NE(temporary, util::getTemporaryPath(path));
+  std::ofstream{temporary} << "compiled";
+  EXPECT_FALSE(fs::exists(path));
+  EXPECT_TRUE(util::publishArtifact(temporary, path));
+  EXPECT_TRUE(fs::exists(path));
+  EXPECT_FALSE(fs::exists(temporary));
+
+  // a missing temporary file leaves the artifact alone
+  EXPECT_FALSE(util::publishArtifact(temporary, path));
+  EXPECT_TRUE(fs::exists(path));
+}
+
+}  // namespace amdinfer
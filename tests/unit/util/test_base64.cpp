@@ -0,0 +1,74 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>    // for array
+#include <cstddef>  // for size_t
+#include <random>   // for mt19937, uniform_int_distribution
+#include <string>   // for string
+#include <utility>  // for pair
+
+#include "amdinfer/util/base64.hpp"  // for base64Decode, base64Encode
+#include "gtest/gtest.h"             // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilBase64, KnownValues) {
+  // test vectors from RFC 4648
+  const std::array<std::pair<std::string, std::string>, 7> values{
+    {{"", ""},
+     {"f", "Zg=="},
+     {"fo", "Zm8="},
+     {"foo", "Zm9v"},
+     {"foob", "Zm9vYg=="},
+     {"fooba", "Zm9vYmE="},
+     {"foobar", "Zm9vYmFy"}}};
+
+  for (const auto& [decoded, encoded] : values) {
+    EXPECT_EQ(util::base64Encode(decoded), encoded);
+    EXPECT_EQ(util::base64Decode(encoded), decoded);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilBase64, RoundTrip) {
+  std::mt19937 generator{1};
+  std::uniform_int_distribution<int> distribution{0, 255};
+
+  for (auto length = 0U; length < 100; ++length) {
+    std::string data(length, '\0');
+    for (auto& c : data) {
+      c = static_cast<char>(distribution(generator));
+    }
+    const auto encoded = util::base64Encode(data);
+    EXPECT_EQ(encoded.size(), util::base64EncodedLength(length));
+    EXPECT_EQ(util::base64Decode(encoded), data);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilBase64, SkipsInvalidCharacters) {
+  // line breaks and other characters outside the alphabet are ignored
+  EXPECT_EQ(util::base64Decode("Zm9v\nYmFy\r\n"), "foobar");
+  EXPECT_EQ(util::base64Decode("Zm 9vYm E="), "fooba");
+  EXPECT_EQ(util::base64Decode("Zm9vYg"), "foob");
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilBase64, Prefix) {
+  EXPECT_EQ(util::base64Encode("foo", "data:text/plain;base64,"),
+            "data:text/plain;base64,Zm9v");
+}
+
+}  //  namespace amdinfer
@@ -14,7 +14,9 @@
 
 #include <array>   // for array
 #include <memory>  // for allocator
+#include <string>  // for string
 
+#include "amdinfer/core/exceptions.hpp"   // for invalid_argument
 #include "amdinfer/util/compression.hpp"  // for zDecompress
 #include "gtest/gtest.h"                  // for Test, SuiteApiResolver, EXP...
 
@@ -34,4 +36,59 @@ TEST(UnitUtilCompression, Decompression) {
   EXPECT_EQ(decompressed_str, "amdinfer");
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilCompression, RoundTrip) {
+  std::string data;
+  for (auto i = 0; i < 100'000; ++i) {
+    data += std::to_string(i % 1000);
+  }
+  constexpr auto kMaxSize = 1'000'000;
+
+  for (auto encoding : {util::Encoding::Identity, util::Encoding::Deflate,
+                        util::Encoding::Gzip, util::Encoding::Zstd}) {
+    const auto compressed = util::compress(encoding, data.data(), data.size());
+    if (encoding != util::Encoding::Identity) {
+      EXPECT_LT(compressed.size(), data.size());
+      EXPECT_EQ(util::sniffEncoding(compressed.data(), compressed.size()),
+                encoding);
+    }
+    EXPECT_EQ(util::decompress(encoding, compressed.data(), compressed.size(),
+                               kMaxSize),
+              data);
+
+    // corrupt, truncated or oversized data is rejected
+    if (encoding != util::Encoding::Identity) {
+      EXPECT_THROW(util::decompress(encoding, compressed.data(),
+                                    compressed.size() / 2, kMaxSize),
+                   invalid_argument);
+      EXPECT_THROW(util::decompress(encoding, data.data(), data.size(),
+                                    kMaxSize),
+                   invalid_argument);
+    }
+    EXPECT_THROW(util::decompress(encoding, compressed.data(),
+                                  compressed.size(), data.size() - 1),
+                 invalid_argument);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilCompression, Headers) {
+  EXPECT_EQ(util::parseEncoding(""), util::Encoding::Identity);
+  EXPECT_EQ(util::parseEncoding(" GZIP "), util::Encoding::Gzip);
+  EXPECT_EQ(util::parseEncoding("zstd"), util::Encoding::Zstd);
+  EXPECT_THROW(util::parseEncoding("br"), invalid_argument);
+
+  EXPECT_EQ(util::negotiateEncoding(""), util::Encoding::Identity);
+  EXPECT_EQ(util::negotiateEncoding("gzip, deflate, br"), util::Encoding::Gzip);
+  EXPECT_EQ(util::negotiateEncoding("deflate, zstd;q=0.5"),
+            util::Encoding::Zstd);
+  EXPECT_EQ(util::negotiateEncoding("zstd;q=0, deflate"),
+            util::Encoding::Deflate);
+  EXPECT_EQ(util::negotiateEncoding("*"), util::Encoding::Zstd);
+
+  const std::string json = R"({"inputs": []})";
+  EXPECT_EQ(util::sniffEncoding(json.data(), json.size()),
+            util::Encoding::Identity);
+}
+
 }  //  namespace amdinfer
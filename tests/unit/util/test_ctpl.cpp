@@ -0,0 +1,101 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>   // for atomic
+#include <future>   // for future
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/util/ctpl.hpp"  // for ThreadPool
+#include "gtest/gtest.h"           // for Test, EXPECT_EQ, ...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilThreadPool, Push) {
+  util::ThreadPool pool{4};
+  EXPECT_EQ(pool.getSize(), 4);
+
+  std::vector<std::future<int>> futures;
+  for (auto i = 0; i < 100; ++i) {
+    futures.push_back(pool.push([i](int) { return i * 2; }));
+  }
+  for (auto i = 0; i < 100; ++i) {
+    EXPECT_EQ(futures[i].get(), i * 2);
+  }
+
+  auto sum = pool.push([](int, int a, int b) { return a + b; }, 1, 2);
+  EXPECT_EQ(sum.get(), 3);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilThreadPool, PushBulk) {
+  std::atomic<int> count = 0;
+  {
+    util::ThreadPool pool{3};
+    std::vector<util::ThreadPool::Task> tasks;
+    for (auto i = 0; i < 50; ++i) {
+      tasks.emplace_back([&count](int) { count++; });
+    }
+    pool.pushBulk(std::move(tasks));
+    // the functions in the queues are run before the pool stops
+  }
+  EXPECT_EQ(count, 50);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilThreadPool, Steal) {
+  util::ThreadPool pool{2};
+
+  // functions pushed from a thread in the pool go to its own queue so the
+  // other thread can only run them by stealing them
+  auto ids = pool.push([&pool](int id) {
+    std::vector<std::future<int>> futures;
+    for (auto i = 0; i < 4; ++i) {
+      futures.push_back(pool.push([](int other) { return other; }));
+    }
+    std::vector<int> ids;
+    for (auto& future : futures) {
+      ids.push_back(future.get());
+    }
+    ids.push_back(id);
+    return ids;
+  });
+
+  auto result = ids.get();
+  const auto owner = result.back();
+  result.pop_back();
+  for (auto id : result) {
+    EXPECT_NE(id, owner);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilThreadPool, Resize) {
+  util::ThreadPool pool;
+  auto queued = pool.push([](int id) { return id; });
+  pool.resize(1);
+  EXPECT_EQ(queued.get(), 0);
+
+  pool.resize(3);
+  EXPECT_EQ(pool.getSize(), 3);
+  pool.resize(1);
+  EXPECT_EQ(pool.getSize(), 1);
+  EXPECT_EQ(pool.push([](int) { return 1; }).get(), 1);
+
+  pool.stop(true);
+  EXPECT_EQ(pool.getSize(), 0);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,56 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <filesystem>  // for path, temp_directory_path
+#include <fstream>     // for ofstream
+#include <string>      // for string
+#include <utility>     // for move
+
+#include "amdinfer/core/exceptions.hpp"  // for file_not_found_error
+#include "amdinfer/util/filesystem.hpp"  // for MappedFile
+#include "gtest/gtest.h"                 // for Test, EXPECT_EQ, EXPECT_THROW
+
+namespace fs = std::filesystem;
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilFilesystem, MappedFile) {
+  const auto path = fs::temp_directory_path() / "amdinfer_mapped_file.bin";
+  const std::string contents = "model weights";
+  std::ofstream{path, std::ios::binary} << contents;
+
+  util::MappedFile file{path};
+  ASSERT_EQ(file.size(), contents.size());
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(file.data()),
+                        file.size()),
+            contents);
+
+  // the mapping outlives the file's name and moves with the object
+  fs::remove(path);
+  const auto moved = std::move(file);
+  EXPECT_EQ(file.data(), nullptr);  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(moved.data()),
+                        moved.size()),
+            contents);
+
+  EXPECT_THROW(util::MappedFile{path}, file_not_found_error);
+
+  std::ofstream{path};
+  const util::MappedFile empty{path};
+  EXPECT_EQ(empty.size(), 0U);
+  fs::remove(path);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,102 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>    // for isnan
+#include <cstdint>  // for int32_t, uint16_t
+#include <limits>   // for numeric_limits
+#include <random>   // for mt19937, uniform_real_distribution
+#include <vector>   // for vector
+
+#include "amdinfer/core/data_types.hpp"     // for bf16, fp16, DataType
+#include "amdinfer/core/exceptions.hpp"     // for invalid_argument
+#include "amdinfer/util/float_convert.hpp"  // for convertDatatype, ...
+#include "gtest/gtest.h"                    // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilFloatConvert, Bf16Rounding) {
+  // 1 + 2^-8 is halfway between two bf16 values and rounds to the even one
+  EXPECT_EQ(bf16{1.00390625F}.bits(), 0x3F80);
+  EXPECT_EQ(bf16{1.01171875F}.bits(), 0x3F82);
+  EXPECT_EQ(bf16{-2.0F}.bits(), 0xC000);
+  EXPECT_FLOAT_EQ(bf16::fromBits(0x4049), 3.140625F);
+
+  const auto infinity = std::numeric_limits<float>::infinity();
+  EXPECT_EQ(bf16{infinity}.bits(), 0x7F80);
+  // the largest float rounds up to infinity
+  EXPECT_EQ(bf16{std::numeric_limits<float>::max()}.bits(), 0x7F80);
+  EXPECT_TRUE(std::isnan(static_cast<float>(
+    bf16{std::numeric_limits<float>::quiet_NaN()})));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilFloatConvert, MatchesScalar) {
+  std::mt19937 generator{1};
+  std::uniform_real_distribution<float> distribution{-1000.0F, 1000.0F};
+
+  // sizes that aren't a multiple of the vector width exercise the tails
+  for (auto size : {0U, 1U, 7U, 8U, 17U, 100U}) {
+    std::vector<float> values(size);
+    for (auto& value : values) {
+      value = distribution(generator);
+    }
+
+    std::vector<fp16> halves(size);
+    util::convertFp32ToFp16(values.data(), halves.data(), size);
+    std::vector<bf16> brains(size);
+    util::convertFp32ToBf16(values.data(), brains.data(), size);
+    for (auto i = 0U; i < size; ++i) {
+      EXPECT_EQ(static_cast<float>(halves[i]),
+                static_cast<float>(fp16{values[i]}));
+      EXPECT_EQ(brains[i].bits(), bf16{values[i]}.bits());
+    }
+
+    std::vector<float> floats(size);
+    util::convertFp16ToFp32(halves.data(), floats.data(), size);
+    for (auto i = 0U; i < size; ++i) {
+      EXPECT_EQ(floats[i], static_cast<float>(halves[i]));
+    }
+    util::convertBf16ToFp32(brains.data(), floats.data(), size);
+    for (auto i = 0U; i < size; ++i) {
+      EXPECT_EQ(floats[i], static_cast<float>(brains[i]));
+    }
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilFloatConvert, Datatypes) {
+  const std::vector<float> values{1.0F, -2.5F, 3.0F};
+  std::vector<bf16> brains(values.size());
+  util::convertDatatype(values.data(), DataType::Fp32, brains.data(),
+                        DataType::Bf16, values.size());
+
+  std::vector<int32_t> ints(values.size());
+  util::convertDatatype(brains.data(), DataType::Bf16, ints.data(),
+                        DataType::Int32, values.size());
+  EXPECT_EQ(ints, (std::vector<int32_t>{1, -2, 3}));
+
+  std::vector<fp16> halves(values.size());
+  util::convertDatatype(ints.data(), DataType::Int32, halves.data(),
+                        DataType::Fp16, values.size());
+  EXPECT_FLOAT_EQ(halves[1], -2.0F);
+
+  std::vector<char> bytes(values.size());
+  EXPECT_THROW(util::convertDatatype(values.data(), DataType::Fp32,
+                                     bytes.data(), DataType::Bytes,
+                                     values.size()),
+               invalid_argument);
+}
+
+}  //  namespace amdinfer
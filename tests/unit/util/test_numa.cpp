@@ -0,0 +1,69 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>  // for find
+#include <thread>     // for thread
+#include <vector>     // for vector
+
+#include "amdinfer/util/numa.hpp"  // for parseIdList, formatIdList
+#include "gtest/gtest.h"           // for Test, SuiteApiResolver, AssertionR...
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilNuma, ParseIdList) {
+  EXPECT_EQ(util::parseIdList("0"), std::vector{0});
+  EXPECT_EQ(util::parseIdList("0-3,8,10-11"),
+            (std::vector{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_TRUE(util::parseIdList("").empty());
+  EXPECT_EQ(util::parseIdList("1,x,3"), (std::vector{1, 3}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilNuma, FormatIdList) {
+  EXPECT_EQ(util::formatIdList({0}), "0");
+  EXPECT_EQ(util::formatIdList({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+  EXPECT_EQ(util::formatIdList({}), "");
+  EXPECT_EQ(util::parseIdList(util::formatIdList({2, 4, 5})),
+            (std::vector{2, 4, 5}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilNuma, CurrentNode) {
+  const auto nodes = util::getNumaNodes();
+  ASSERT_FALSE(nodes.empty());
+  const auto node = util::getNumaNode();
+  EXPECT_NE(std::find(nodes.begin(), nodes.end(), node), nodes.end());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilNuma, BindCpus) {
+  const auto cpus = util::getThreadCpus();
+  ASSERT_FALSE(cpus.empty());
+
+  // threads started by a bound thread inherit its CPUs
+  std::vector<int> inherited;
+  std::thread thread{[&cpus, &inherited]() {
+    util::bindThreadToCpus({cpus.front()});
+    std::thread child{[&inherited]() { inherited = util::getThreadCpus(); }};
+    child.join();
+  }};
+  thread.join();
+  EXPECT_EQ(inherited, std::vector{cpus.front()});
+
+  // the test thread keeps its own CPUs
+  EXPECT_EQ(util::getThreadCpus(), cpus);
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,119 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>   // for array
+#include <chrono>  // for microseconds
+#include <thread>  // for thread
+
+#include "amdinfer/util/queue.hpp"  // for PriorityBlockingQueue
+#include "gtest/gtest.h"            // for Test, SuiteApiResolver, AssertionR...
+
+namespace amdinfer {
+
+using TestQueue = PriorityBlockingQueue<int, 3>;
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilQueue, PriorityOrder) {
+  TestQueue queue;
+  queue.enqueue(2, 2);
+  queue.enqueue(1, 1);
+  queue.enqueue(0, 0);
+  EXPECT_EQ(queue.size_approx(), 3);
+  EXPECT_EQ(queue.size_approx(0), 1);
+
+  int item = -1;
+  for (auto i = 0; i < 3; ++i) {
+    queue.wait_dequeue(item);
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_EQ(queue.size_approx(), 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilQueue, OutOfRangeLane) {
+  TestQueue queue;
+  queue.enqueue(1, 10);
+  EXPECT_EQ(queue.size_approx(2), 1);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilQueue, Starvation) {
+  const uint32_t limit = 2;
+  TestQueue queue{limit};
+  const int low = -1;
+  queue.enqueue(low, 2);
+  for (auto i = 0; i < 5; ++i) {
+    queue.enqueue(i, 0);
+  }
+
+  // the low priority item is served after being skipped limit times
+  int item = 0;
+  for (auto i = 0U; i < limit; ++i) {
+    queue.wait_dequeue(item);
+    EXPECT_EQ(item, i);
+  }
+  queue.wait_dequeue(item);
+  EXPECT_EQ(item, low);
+  queue.wait_dequeue(item);
+  EXPECT_EQ(item, limit);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilQueue, TimedDequeue) {
+  TestQueue queue;
+  int item = 0;
+  const int64_t timeout_us = 1000;
+  EXPECT_FALSE(queue.wait_dequeue_timed(item, timeout_us));
+
+  std::thread producer{[&queue]() { queue.enqueue(1, 1); }};
+  queue.wait_dequeue(item);
+  producer.join();
+  EXPECT_EQ(item, 1);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilQueue, BulkDequeue) {
+  TestQueue queue;
+  queue.enqueue(3, 2);
+  queue.enqueue(1, 0);
+  queue.enqueue(2, 1);
+  queue.enqueue(0, 0);
+
+  std::array<int, 3> items{};
+  const int64_t timeout_us = 1000;
+  ASSERT_EQ(queue.wait_dequeue_bulk_timed(items.data(), items.size(), 0), 3);
+  EXPECT_EQ(items, (std::array<int, 3>{1, 0, 2}));
+  ASSERT_EQ(queue.wait_dequeue_bulk_timed(items.data(), items.size(), -1), 1);
+  EXPECT_EQ(items[0], 3);
+  EXPECT_EQ(
+    queue.wait_dequeue_bulk_timed(items.data(), items.size(), timeout_us), 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilQueue, Spin) {
+  TestQueue queue;
+  const auto spin = std::chrono::microseconds(100);
+  EXPECT_FALSE(util::spinUntilReady(queue, spin));
+  EXPECT_FALSE(util::spinUntilReady(queue, std::chrono::microseconds(0)));
+
+  std::thread producer{[&queue]() { queue.enqueue(1, 0); }};
+  EXPECT_TRUE(util::spinUntilReady(queue, std::chrono::seconds(10)));
+  producer.join();
+  EXPECT_TRUE(util::spinUntilReady(queue, spin));
+  int item = 0;
+  queue.wait_dequeue(item);
+  EXPECT_EQ(item, 1);
+}
+
+}  //  namespace amdinfer
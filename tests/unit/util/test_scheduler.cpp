@@ -0,0 +1,113 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>   // for seconds
+#include <future>   // for promise, shared_future
+#include <thread>   // for thread
+#include <utility>  // for move
+#include <vector>   // for vector
+
+#include "amdinfer/util/queue.hpp"      // for BlockingQueue
+#include "amdinfer/util/scheduler.hpp"  // for Scheduler
+#include "gtest/gtest.h"                // for Test, EXPECT_EQ, TEST
+
+namespace amdinfer {
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilScheduler, Await) {
+  util::Scheduler scheduler;
+  EXPECT_TRUE(scheduler.idle());
+
+  // continuations run in the order their checks pass
+  std::vector<int> order;
+  bool first = false;
+  bool second = false;
+  scheduler.await([&first]() { return first; },
+                  [&order]() { order.push_back(1); });
+  scheduler.await([&second]() { return second; },
+                  [&order]() { order.push_back(2); });
+  EXPECT_EQ(scheduler.poll(), 0);
+  EXPECT_EQ(scheduler.waiting(), 2);
+
+  second = true;
+  EXPECT_EQ(scheduler.poll(), 1);
+  first = true;
+  EXPECT_EQ(scheduler.poll(), 1);
+  EXPECT_EQ(order, (std::vector<int>{2, 1}));
+  EXPECT_TRUE(scheduler.idle());
+
+  // a continuation can await again, which is checked from the next poll
+  int steps = 0;
+  scheduler.await([]() { return true; },
+                  [&]() {
+                    steps++;
+                    scheduler.await([]() { return true; },
+                                    [&steps]() { steps++; });
+                  });
+  EXPECT_EQ(scheduler.poll(), 1);
+  EXPECT_EQ(steps, 1);
+  EXPECT_EQ(scheduler.poll(), 1);
+  EXPECT_EQ(steps, 2);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilScheduler, Future) {
+  util::Scheduler scheduler;
+  std::promise<int> promise;
+  std::shared_future<int> future = promise.get_future().share();
+  int result = 0;
+  scheduler.await(future, [&]() { result = future.get(); });
+  EXPECT_EQ(scheduler.poll(), 0);
+
+  promise.set_value(3);
+  EXPECT_EQ(scheduler.poll(), 1);
+  EXPECT_EQ(result, 3);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilScheduler, Dequeue) {
+  util::Scheduler scheduler;
+  BlockingQueue<int> queue;
+  std::vector<int> items;
+  for (auto i = 0; i < 2; ++i) {
+    scheduler.awaitDequeue<int>(&queue,
+                                [&items](int item) { items.push_back(item); });
+  }
+  EXPECT_EQ(scheduler.poll(), 0);
+
+  queue.enqueue(4);
+  queue.enqueue(5);
+  EXPECT_EQ(scheduler.poll(), 2);
+  EXPECT_EQ(items, (std::vector<int>{4, 5}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilScheduler, Post) {
+  util::Scheduler scheduler;
+  int count = 0;
+  std::thread thread{[&]() {
+    for (auto i = 0; i < 10; ++i) {
+      scheduler.post([&count]() { count++; });
+    }
+  }};
+  thread.join();
+  EXPECT_FALSE(scheduler.idle());
+  // waiting returns at once since tasks were posted
+  scheduler.wait(std::chrono::seconds(1));
+  EXPECT_EQ(scheduler.poll(), 10);
+  EXPECT_EQ(count, 10);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+}  // namespace amdinfer
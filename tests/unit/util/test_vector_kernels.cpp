@@ -0,0 +1,116 @@
+// Copyright 2023 Advanced Micro Devices, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t
+#include <random>   // for mt19937, normal_distribution, uniform_re...
+#include <vector>   // for vector
+
+#include "amdinfer/pre_post/softmax.hpp"     // for calcSoftmax
+#include "amdinfer/util/cpu_features.hpp"    // for selectKernel, CpuIsa
+#include "amdinfer/util/vector_kernels.hpp"  // for softmax, selectMargins
+#include "gtest/gtest.h"                     // for Test, EXPECT_EQ, TestInfo
+
+namespace amdinfer {
+
+namespace {
+
+int scalarKernel() { return 0; }
+int avx2Kernel() { return 2; }
+int avx512Kernel() { return 3; }
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilVectorKernels, SelectKernel) {
+  using util::CpuIsa;
+  const util::IsaKernels<int (*)()> all{scalarKernel, avx2Kernel,
+                                        avx512Kernel};
+  EXPECT_EQ(util::selectKernel(all, CpuIsa::Scalar)(), 0);
+  EXPECT_EQ(util::selectKernel(all, CpuIsa::Avx2)(), 2);
+  EXPECT_EQ(util::selectKernel(all, CpuIsa::Avx512)(), 3);
+
+  // missing variants fall back to the next best one
+  const util::IsaKernels<int (*)()> some{scalarKernel, avx2Kernel};
+  EXPECT_EQ(util::selectKernel(some, CpuIsa::Avx512)(), 2);
+  const util::IsaKernels<int (*)()> one{scalarKernel};
+  EXPECT_EQ(util::selectKernel(one, CpuIsa::Avx512)(), 0);
+
+  const auto& features = util::getCpuFeatures();
+  if (util::getCpuIsa() >= CpuIsa::Avx2) {
+    EXPECT_TRUE(features.avx2 && features.fma && features.f16c);
+  }
+  EXPECT_EQ(util::toString(CpuIsa::Avx512), "avx512");
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilVectorKernels, Softmax) {
+  std::mt19937 generator{1};
+  std::uniform_real_distribution<float> distribution{-20.0F, 20.0F};
+
+  // sizes that aren't a multiple of the vector width exercise the tails
+  const size_t rows = 3;
+  for (auto size : {1U, 7U, 16U, 33U, 1000U}) {
+    std::vector<float> values(rows * size);
+    for (auto& value : values) {
+      value = distribution(generator);
+    }
+
+    std::vector<float> expected(values.size());
+    pre_post::calcSoftmax(values.data(), rows, size, expected.data());
+    std::vector<float> actual(values.size());
+    util::softmax(values.data(), rows, size, actual.data());
+    for (auto i = 0U; i < values.size(); ++i) {
+      EXPECT_NEAR(actual[i], expected[i], 1e-6);
+    }
+
+    // in place
+    util::softmax(values.data(), rows, size, values.data());
+    EXPECT_EQ(values, actual);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp, cppcoreguidelines-owning-memory)
+TEST(UnitUtilVectorKernels, SelectMargins) {
+  std::mt19937 generator{2};
+  std::normal_distribution<float> distribution{0.0F, 2.0F};
+  const float margin = 3.0F;
+
+  // sizes that aren't a multiple of the block exercise the tails and each
+  // stride takes its own path
+  for (auto stride : {1U, 2U, 3U}) {
+    for (auto count : {1U, 63U, 64U, 1000U}) {
+      std::vector<float> values(count * stride + 1);
+      for (auto& value : values) {
+        value = distribution(generator);
+      }
+      const auto* negative = values.data();
+      const auto* positive = values.data() + 1;
+
+      std::vector<uint32_t> expected;
+      for (auto i = 0U; i < count; ++i) {
+        if (positive[i * stride] - negative[i * stride] > margin) {
+          expected.push_back(i);
+        }
+      }
+      std::vector<uint32_t> actual(count);
+      actual.resize(util::selectMargins(positive, negative, count, stride,
+                                        margin, actual.data()));
+      EXPECT_EQ(actual, expected);
+    }
+  }
+}
+
+}  // namespace amdinfer
@@ -0,0 +1,156 @@
+# Copyright 2023 Advanced Micro Devices, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Compare the JSON output of C++ benchmarks (--benchmark_out) against a baseline
+and exit with an error if any metric regressed by more than the threshold
+"""
+
+import argparse
+import json
+import statistics
+import sys
+
+# metrics to compare and whether a higher value is better
+METRICS = {
+    "items_per_second": True,
+    "p50_ms": False,
+    "p90_ms": False,
+    "p99_ms": False,
+    "cpu_utilization": False,
+}
+
+
+def read_results(paths):
+    """
+    Read the metrics of each benchmark from one or more result files. With
+    repetitions, the median is used
+    """
+    runs = {}
+    medians = {}
+    for path in paths:
+        with open(path, "r") as f:
+            json_data = json.load(f)
+        for benchmark in json_data["benchmarks"]:
+            if "error_occurred" in benchmark and benchmark["error_occurred"]:
+                continue
+            name = benchmark.get("run_name", benchmark["name"])
+            metrics = {
+                metric: benchmark[metric]
+                for metric in METRICS
+                if metric in benchmark
+            }
+            run_type = benchmark.get("run_type", "iteration")
+            if run_type == "aggregate":
+                if benchmark.get("aggregate_name") == "median":
+                    medians[name] = metrics
+            else:
+                runs.setdefault(name, []).append(metrics)
+
+    results = {}
+    for name, samples in runs.items():
+        results[name] = {
+            metric: statistics.median([x[metric] for x in samples if metric in x])
+            for metric in METRICS
+            if any(metric in x for x in samples)
+        }
+    results.update(medians)
+    return results
+
+
+def compare(baseline, results, threshold):
+    """
+    Print how each benchmark compares to the baseline and return the number of
+    regressions
+    """
+    regressions = 0
+    for name, metrics in sorted(results.items()):
+        if name not in baseline:
+            print(f"NEW   {name}")
+            continue
+        for metric, value in metrics.items():
+            if metric not in baseline[name] or baseline[name][metric] == 0:
+                continue
+            expected = baseline[name][metric]
+            # positive changes are improvements
+            if METRICS[metric]:
+                change = (value - expected) / expected
+            else:
+                change = (expected - value) / expected
+            status = "OK   "
+            if change < -threshold:
+                status = "WORSE"
+                regressions += 1
+            elif change > threshold:
+                status = "BETTER"
+            print(
+                f"{status} {name} {metric}: {value:.3f} vs {expected:.3f} "
+                f"({change:+.1%})"
+            )
+    for name in sorted(set(baseline) - set(results)):
+        print(f"MISSING {name}")
+    return regressions
+
+
+def main(args: argparse.Namespace):
+    results = read_results(args.results)
+
+    if args.update:
+        with open(args.baseline, "r") as f:
+            json_data = json.load(f)
+        json_data["benchmarks"].update(results)
+        with open(args.baseline, "w") as f:
+            json.dump(json_data, f, indent=4, sort_keys=True)
+            f.write("\n")
+        print(f"Updated {len(results)} benchmarks in {args.baseline}")
+        return
+
+    with open(args.baseline, "r") as f:
+        baseline = json.load(f)["benchmarks"]
+
+    regressions = compare(baseline, results, args.threshold)
+    if regressions > 0:
+        print(
+            f"{regressions} metrics regressed by more than "
+            f"{args.threshold:.0%} from the baseline"
+        )
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Compare benchmark results against a baseline"
+    )
+    parser.add_argument(
+        "results", nargs="+", help="JSON output from one or more benchmarks"
+    )
+    parser.add_argument(
+        "--baseline",
+        default="tests/performance/models/baseline.json",
+        help="the baseline to compare against",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.1,
+        help="the fraction a metric may be worse than the baseline",
+    )
+    parser.add_argument(
+        "--update",
+        action="store_true",
+        help="add the results to the baseline instead of comparing",
+    )
+    args = parser.parse_args()
+
+    main(args)